@@ -0,0 +1,294 @@
+#include "BenchmarkRunner.hpp"
+
+#include <algorithm>
+
+#include "content/Content.hpp"
+#include "content/PacksManager.hpp"
+#include "data/dv_util.hpp"
+#include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
+#include "engine.hpp"
+#include "frontend/screens/LevelScreen.hpp"
+#include "logic/BlocksController.hpp"
+#include "logic/EngineController.hpp"
+#include "logic/LevelController.hpp"
+#include "objects/Player.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunks.hpp"
+#include "world/Level.hpp"
+
+using namespace benchmark;
+
+static debug::Logger logger("benchmark");
+
+/// @brief Histograms written to phase statistics as values count and
+/// average (microseconds) since the phase start
+static const struct {
+    std::string name;
+    std::string countKey;
+    std::string avgKey;
+} HISTOGRAMS[] {
+    {"chunks.generate", "chunks-generated", "chunk-generate-avg"},
+    {"chunks.load", "chunks-loaded", "chunk-load-avg"},
+    {"lighting.chunks-build", "lights-built", "light-build-avg"},
+    {"chunks.mesh-build", "meshes-built", "mesh-build-avg"},
+};
+
+Scenario Scenario::parse(const dv::value& root) {
+    Scenario scenario;
+    root.at("name").get(scenario.name);
+    root.at("world").get(scenario.world);
+    root.at("seed").get(scenario.seed);
+    root.at("generator").get(scenario.generator);
+    root.at("warmup").get(scenario.warmup);
+    if (root.has("packs")) {
+        for (const auto& pack : root["packs"]) {
+            scenario.packs.push_back(pack.asString());
+        }
+    }
+    for (const auto& map : root["phases"]) {
+        Phase phase;
+        phase.name = map["name"].asString();
+        map.at("duration").get(phase.duration);
+        dv::get_vec(map, "from", phase.from);
+        phase.to = phase.from;
+        dv::get_vec(map, "to", phase.to);
+        dv::get_vec(map, "look", phase.look);
+        map.at("action").get(phase.action);
+        dv::get_vec(map, "offset", phase.offset);
+        map.at("radius").get(phase.radius);
+        map.at("block").get(phase.block);
+        map.at("count").get(phase.count);
+        scenario.phases.push_back(std::move(phase));
+    }
+    if (scenario.phases.empty()) {
+        throw std::runtime_error("scenario has no phases");
+    }
+    return scenario;
+}
+
+BenchmarkRunner::BenchmarkRunner(Engine& engine, Scenario scenario)
+    : engine(engine), scenario(std::move(scenario)), results(dv::object()) {
+    results["scenario"] = this->scenario.name;
+    results.object("phases");
+}
+
+LevelController* BenchmarkRunner::getLevelController() const {
+    auto screen = dynamic_cast<LevelScreen*>(engine.getScreen().get());
+    return screen ? screen->getLevelController() : nullptr;
+}
+
+void BenchmarkRunner::openWorld() {
+    auto folder = engine.getPaths()->getWorldsFolder() /
+                  fs::u8path(scenario.world);
+    // the world is generated again every run to be the same
+    if (fs::exists(folder)) {
+        logger.info() << "removing previous world " << folder.u8string();
+        fs::remove_all(folder);
+    }
+    auto manager = engine.createPacksManager(fs::path(""));
+    manager.scan();
+    auto names = engine.getBasePacks();
+    names.insert(names.end(), scenario.packs.begin(), scenario.packs.end());
+    engine.getContentPacks() = manager.getAll(manager.assembly(names));
+
+    auto generator = scenario.generator;
+    if (generator.empty()) {
+        generator = engine.getResPaths()->readCombinedObject(
+            EnginePaths::CONFIG_DEFAULTS.u8string()
+        )["generator"].asString();
+    }
+    engine.getController()->createWorld(
+        scenario.world, scenario.seed, generator
+    );
+}
+
+void BenchmarkRunner::startPhase() {
+    const auto& phase = scenario.phases[phaseIndex];
+    logger.info() << "phase " << phase.name;
+    state = State::PHASE;
+    timer = 0.0f;
+    explosions = 0;
+    frameTimes.clear();
+    maxMeshesMemory = 0;
+    maxChunksCount = 0;
+
+    auto& metrics = debug::Metrics::getInstance();
+    for (const auto& entry : HISTOGRAMS) {
+        const auto& histogram = metrics.histogram(entry.name);
+        marks[entry.name] = {histogram.getCount(), histogram.getSum()};
+    }
+}
+
+void BenchmarkRunner::update() {
+    if (state == State::START) {
+        openWorld();
+        state = State::WARMUP;
+        timer = 0.0f;
+        return;
+    }
+    auto controller = getLevelController();
+    if (controller == nullptr || state == State::FINISHED) {
+        return;
+    }
+    float delta = engine.getDelta();
+    if (state == State::WARMUP) {
+        const auto& phase = scenario.phases[0];
+        auto player = controller->getPlayer();
+        player->setFlight(true);
+        player->setNoclip(true);
+        player->teleport(phase.from);
+        player->cam = glm::vec3(phase.look, 0.0f);
+        timer += delta;
+        if (timer >= scenario.warmup) {
+            startPhase();
+        }
+        return;
+    }
+    updatePhase(*controller, delta);
+}
+
+void BenchmarkRunner::updatePhase(LevelController& controller, float delta) {
+    const auto& phase = scenario.phases[phaseIndex];
+    timer += delta;
+    frameTimes.push_back(delta);
+
+    float t = std::min(timer / std::max(phase.duration, 1e-3f), 1.0f);
+    auto player = controller.getPlayer();
+    player->teleport(glm::mix(phase.from, phase.to, t));
+    player->cam = glm::vec3(phase.look, 0.0f);
+
+    if (phase.action == "explode") {
+        // explosions at t = 0, 1/count, 2/count...
+        while (explosions < phase.count &&
+               explosions <= static_cast<int>(t * phase.count)) {
+            performAction(controller, phase);
+            explosions++;
+        }
+    } else if (!phase.action.empty()) {
+        performAction(controller, phase);
+    }
+
+    auto& metrics = debug::Metrics::getInstance();
+    maxMeshesMemory = std::max(
+        maxMeshesMemory, metrics.gauge("chunks.meshes-memory").get()
+    );
+    maxChunksCount = std::max(
+        maxChunksCount, controller.getLevel()->chunks->getChunksCount()
+    );
+    if (timer >= phase.duration) {
+        finishPhase();
+    }
+}
+
+void BenchmarkRunner::performAction(
+    LevelController& controller, const Phase& phase
+) {
+    blockid_t id = BLOCK_AIR;
+    if (phase.action == "build") {
+        id = engine.getContent()->blocks.require(phase.block).rt.id;
+    } else if (phase.action != "dig" && phase.action != "explode") {
+        throw std::runtime_error("unknown action " + phase.action);
+    }
+    auto center = glm::ivec3(
+        glm::floor(controller.getPlayer()->getPosition() + phase.offset)
+    );
+    int r = phase.radius;
+    std::vector<BlockEdit> edits;
+    for (int y = -r; y <= r; y++) {
+        for (int z = -r; z <= r; z++) {
+            for (int x = -r; x <= r; x++) {
+                if (x * x + y * y + z * z <= r * r) {
+                    edits.push_back({center + glm::ivec3(x, y, z), id});
+                }
+            }
+        }
+    }
+    controller.getBlocksController()->setBlocks(edits);
+}
+
+void BenchmarkRunner::finishPhase() {
+    const auto& phase = scenario.phases[phaseIndex];
+    auto& stats = results["phases"].object(phase.name);
+
+    auto frames = frameTimes;
+    std::sort(frames.begin(), frames.end());
+    double total = 0.0;
+    for (float time : frames) {
+        total += time;
+    }
+    size_t count = frames.size();
+    stats["frames"] = static_cast<int64_t>(count);
+    stats["frame-avg"] = count ? total / count * 1000.0 : 0.0;
+    stats["frame-p50"] = count ? frames[count / 2] * 1000.0 : 0.0;
+    stats["frame-p99"] = count ? frames[count * 99 / 100] * 1000.0 : 0.0;
+    stats["frame-max"] = count ? frames.back() * 1000.0 : 0.0;
+
+    auto& metrics = debug::Metrics::getInstance();
+    for (const auto& entry : HISTOGRAMS) {
+        const auto& histogram = metrics.histogram(entry.name);
+        const auto& mark = marks[entry.name];
+        int64_t values = histogram.getCount() - mark.count;
+        int64_t sum = histogram.getSum() - mark.sum;
+        stats[entry.countKey] = values;
+        stats[entry.avgKey] =
+            values ? static_cast<double>(sum) / values : 0.0;
+    }
+    stats["meshes-per-second"] =
+        total > 0.0 ? stats["meshes-built"].asInteger() / total : 0.0;
+
+    stats["meshes-memory"] = maxMeshesMemory;
+    stats["chunks-count"] = static_cast<int64_t>(maxChunksCount);
+
+    logger.info() << "phase " << phase.name << " finished: " << count
+                  << " frames, avg " << stats["frame-avg"].asNumber()
+                  << " ms, p99 " << stats["frame-p99"].asNumber() << " ms";
+
+    if (++phaseIndex < scenario.phases.size()) {
+        startPhase();
+    } else {
+        state = State::FINISHED;
+        engine.quit();
+    }
+}
+
+/// @brief Compared values. Positive direction means greater is worse
+static const std::pair<std::string, int> COMPARED[] {
+    {"frame-avg", 1},
+    {"frame-p99", 1},
+    {"chunk-load-avg", 1},
+    {"chunk-generate-avg", 1},
+    {"mesh-build-avg", 1},
+    {"meshes-memory", 1},
+    {"meshes-per-second", -1},
+};
+
+std::vector<std::string> benchmark::compare(
+    const dv::value& results, const dv::value& baseline, double tolerance
+) {
+    std::vector<std::string> regressions;
+    const auto& phases = results["phases"];
+    for (const auto& [name, basePhase] : baseline["phases"].asObject()) {
+        if (!phases.has(name)) {
+            regressions.push_back(name + ": phase is missing");
+            continue;
+        }
+        const auto& phase = phases[name];
+        for (const auto& [key, direction] : COMPARED) {
+            if (!phase.has(key) || !basePhase.has(key)) {
+                continue;
+            }
+            double base = basePhase[key].asNumber();
+            double value = phase[key].asNumber();
+            bool regressed = direction > 0 ? value > base * (1.0 + tolerance)
+                                           : value < base * (1.0 - tolerance);
+            if (regressed) {
+                regressions.push_back(
+                    name + ": " + key + " " + std::to_string(value) +
+                    " (baseline " + std::to_string(base) + ")"
+                );
+            }
+        }
+    }
+    return regressions;
+}
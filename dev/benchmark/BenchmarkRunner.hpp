@@ -0,0 +1,109 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "data/dv.hpp"
+
+class Engine;
+class LevelController;
+
+namespace benchmark {
+    /// @brief Scripted part of a benchmark scenario: the player flies
+    /// from one point to another performing an action along the path
+    struct Phase {
+        std::string name;
+        /// @brief Phase duration in seconds
+        float duration = 10.0f;
+        glm::vec3 from {};
+        glm::vec3 to {};
+        /// @brief Camera yaw and pitch in degrees
+        glm::vec2 look {};
+        /// @brief One of: '' (fly only), 'dig', 'build', 'explode'
+        std::string action;
+        /// @brief Action target offset from the player position
+        glm::vec3 offset {};
+        /// @brief Action sphere radius in blocks
+        int radius = 2;
+        /// @brief Block placed by 'build' action
+        std::string block = "base:stone";
+        /// @brief Number of explosions evenly distributed over the phase
+        int count = 1;
+    };
+
+    struct Scenario {
+        std::string name;
+        std::string world = "benchmark";
+        std::string seed = "0";
+        /// @brief Generator id, default generator if empty
+        std::string generator;
+        /// @brief Content packs in addition to the base packs
+        std::vector<std::string> packs;
+        /// @brief Time in seconds given to load the world at the first
+        /// phase start point before measurements begin
+        float warmup = 5.0f;
+        std::vector<Phase> phases;
+
+        static Scenario parse(const dv::value& root);
+    };
+
+    /// @brief Drives the engine through scenario phases (called every frame
+    /// via Engine::setFrameHandler) collecting per phase statistics:
+    /// frame times, chunk load latencies, mesh throughput and memory
+    class BenchmarkRunner {
+        Engine& engine;
+        Scenario scenario;
+        dv::value results;
+
+        enum class State { START, WARMUP, PHASE, FINISHED };
+        State state = State::START;
+        size_t phaseIndex = 0;
+        float timer = 0.0f;
+        int explosions = 0;
+
+        /// @brief Histogram count and sum at the phase start
+        struct HistogramMark {
+            int64_t count;
+            int64_t sum;
+        };
+
+        std::vector<float> frameTimes;
+        std::unordered_map<std::string, HistogramMark> marks;
+        int64_t maxMeshesMemory = 0;
+        size_t maxChunksCount = 0;
+
+        LevelController* getLevelController() const;
+
+        void openWorld();
+        void startPhase();
+        void updatePhase(LevelController& controller, float delta);
+        void finishPhase();
+        void performAction(LevelController& controller, const Phase& phase);
+    public:
+        BenchmarkRunner(Engine& engine, Scenario scenario);
+
+        void update();
+
+        bool isFinished() const {
+            return state == State::FINISHED;
+        }
+
+        /// @brief Get results: object with 'scenario' name and 'phases'
+        /// object containing statistics by phase name
+        const dv::value& getResults() const {
+            return results;
+        }
+    };
+
+    /// @brief Compare results with baseline results. Timing and memory
+    /// values greater than baseline * (1 + tolerance) and throughput
+    /// values less than baseline * (1 - tolerance) are regressions
+    /// @return list of regression descriptions
+    std::vector<std::string> compare(
+        const dv::value& results, const dv::value& baseline, double tolerance
+    );
+}
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "BenchmarkRunner.hpp"
+#include "coders/json.hpp"
+#include "debug/Logger.hpp"
+#include "engine.hpp"
+#include "files/engine_paths.hpp"
+#include "files/files.hpp"
+#include "settings.hpp"
+#include "files/settings_io.hpp"
+#include "util/platform.hpp"
+
+namespace fs = std::filesystem;
+
+static debug::Logger logger("benchmark");
+
+static constexpr int EXIT_REGRESSION = 2;
+
+struct BenchmarkParameters {
+    fs::path scenario;
+    fs::path output = "benchmark.json";
+    fs::path baseline;
+    /// @brief Allowed relative difference with the baseline
+    double tolerance = 0.1;
+};
+
+static void print_help() {
+    std::cout << "VoxelEngineBenchmark [scenario.json] arguments:" << std::endl;
+    std::cout << " --res [path] - set resources directory" << std::endl;
+    std::cout << " --dir [path] - set userfiles directory" << std::endl;
+    std::cout << " --output [path] - results file (benchmark.json)"
+              << std::endl;
+    std::cout << " --baseline [path] - compare results with the baseline "
+                 "results file" << std::endl;
+    std::cout << " --tolerance [number] - allowed relative difference with "
+                 "the baseline (0.1)" << std::endl;
+}
+
+static bool parse_args(
+    int argc, char** argv, EnginePaths& paths, BenchmarkParameters& params
+) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            print_help();
+            return false;
+        }
+        if (arg[0] != '-') {
+            params.scenario = fs::u8path(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::runtime_error("unexpected end");
+        }
+        std::string value = argv[++i];
+        if (arg == "--res") {
+            paths.setResourcesFolder(fs::u8path(value));
+        } else if (arg == "--dir") {
+            fs::create_directories(fs::u8path(value));
+            paths.setUserFilesFolder(fs::u8path(value));
+        } else if (arg == "--output") {
+            params.output = fs::u8path(value);
+        } else if (arg == "--baseline") {
+            params.baseline = fs::u8path(value);
+        } else if (arg == "--tolerance") {
+            params.tolerance = std::stod(value);
+        } else {
+            throw std::runtime_error("unknown argument " + arg);
+        }
+    }
+    if (params.scenario.empty()) {
+        print_help();
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    debug::Logger::init("benchmark.log");
+
+    EnginePaths paths;
+    BenchmarkParameters params;
+    try {
+        if (!parse_args(argc, argv, paths, params)) {
+            return EXIT_SUCCESS;
+        }
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    platform::configure_encoding();
+    dv::value results;
+    try {
+        auto scenario = benchmark::Scenario::parse(
+            files::read_json(params.scenario)
+        );
+        EngineSettings settings;
+        SettingsHandler handler(settings);
+
+        Engine engine(settings, handler, &paths);
+
+        benchmark::BenchmarkRunner runner(engine, std::move(scenario));
+        engine.setFrameHandler([&runner]() { runner.update(); });
+        engine.mainloop();
+        engine.setFrameHandler(nullptr);
+
+        if (!runner.isFinished()) {
+            logger.error() << "benchmark interrupted";
+            return EXIT_FAILURE;
+        }
+        results = runner.getResults();
+    } catch (const initialize_error& err) {
+        logger.error() << "could not to initialize engine\n" << err.what();
+        return EXIT_FAILURE;
+    } catch (const std::exception& err) {
+        logger.error() << "benchmark failed: " << err.what();
+        return EXIT_FAILURE;
+    }
+    files::write_string(params.output, json::stringify(results, true));
+    logger.info() << "results written to " << params.output.u8string();
+
+    if (!params.baseline.empty()) {
+        auto baseline = files::read_json(params.baseline);
+        auto regressions =
+            benchmark::compare(results, baseline, params.tolerance);
+        for (const auto& regression : regressions) {
+            logger.error() << "regression: " << regression;
+        }
+        if (!regressions.empty()) {
+            return EXIT_REGRESSION;
+        }
+        logger.info() << "no regressions found";
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+
+#include "coders/binary_json.hpp"
+#include "coders/compression.hpp"
+#include "coders/json.hpp"
+#include "voxels/Chunk.hpp"
+
+using compression::Method;
+
+/// @brief Encoded chunk with a few layers and a noise stripe, so every
+/// method has both long runs and incompressible bytes
+static std::vector<ubyte> chunk_bytes() {
+    Chunk chunk(0, 0);
+    uint seed = 1;
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        uint y = i / (CHUNK_W * CHUNK_D);
+        if (y < 40) {
+            chunk.voxels[i].id = 1;
+        } else if (y < 48) {
+            seed = seed * 1103515245 + 12345;
+            chunk.voxels[i].id = (seed >> 16) % 8;
+        }
+    }
+    auto bytes = chunk.encode();
+    return std::vector<ubyte>(bytes.get(), bytes.get() + CHUNK_DATA_LEN);
+}
+
+static void BM_Compress(benchmark::State& state, Method method) {
+    auto src = chunk_bytes();
+    size_t len = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            compression::compress(src.data(), src.size(), len, method)
+        );
+    }
+    state.SetBytesProcessed(state.iterations() * src.size());
+    state.counters["ratio"] = static_cast<double>(src.size()) / len;
+}
+BENCHMARK_CAPTURE(BM_Compress, extrle8, Method::EXTRLE8);
+BENCHMARK_CAPTURE(BM_Compress, extrle16, Method::EXTRLE16);
+BENCHMARK_CAPTURE(BM_Compress, gzip, Method::GZIP);
+
+static void BM_Decompress(benchmark::State& state, Method method) {
+    auto src = chunk_bytes();
+    size_t len = 0;
+    auto compressed =
+        compression::compress(src.data(), src.size(), len, method);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(compression::decompress(
+            compressed.get(), len, src.size(), method
+        ));
+    }
+    state.SetBytesProcessed(state.iterations() * src.size());
+}
+BENCHMARK_CAPTURE(BM_Decompress, extrle8, Method::EXTRLE8);
+BENCHMARK_CAPTURE(BM_Decompress, extrle16, Method::EXTRLE16);
+BENCHMARK_CAPTURE(BM_Decompress, gzip, Method::GZIP);
+
+/// @brief Entities-like document: list of objects with nested vectors
+static dv::value make_document(int count) {
+    auto root = dv::object();
+    auto& list = root.list("entities");
+    for (int i = 0; i < count; i++) {
+        auto& entity = list.object();
+        entity["id"] = i;
+        entity["def"] = "base:drop";
+        entity["pos"] = dv::list({i * 0.5, 64.25, -i * 1.5});
+        entity["vel"] = dv::list({0.0, -9.8, 0.0});
+        entity["visible"] = i % 2 == 0;
+        auto& components = entity.object("components");
+        components["base:drop"] = "item " + std::to_string(i);
+    }
+    return root;
+}
+
+static void BM_JsonParse(benchmark::State& state) {
+    auto source = json::stringify(make_document(state.range(0)), true);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(json::parse(source));
+    }
+    state.SetBytesProcessed(state.iterations() * source.length());
+}
+BENCHMARK(BM_JsonParse)->Arg(1000)->Arg(20000);
+
+static void BM_JsonStringify(benchmark::State& state) {
+    auto document = make_document(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(json::stringify(document, false));
+    }
+}
+BENCHMARK(BM_JsonStringify)->Arg(1000)->Arg(20000);
+
+static void BM_BinaryJsonDecode(benchmark::State& state) {
+    auto bytes = json::to_binary(make_document(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            json::from_binary(bytes.data(), bytes.size())
+        );
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_BinaryJsonDecode)->Arg(1000)->Arg(20000);
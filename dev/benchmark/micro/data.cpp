@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+
+#include <unordered_map>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include "data/dv.hpp"
+#include "util/FlatHashMap.hpp"
+
+static void BM_ValueObject(benchmark::State& state) {
+    int count = state.range(0);
+    for (auto _ : state) {
+        auto map = dv::object();
+        for (int i = 0; i < count; i++) {
+            map["key" + std::to_string(i)] = i;
+        }
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ValueObject)->Arg(16)->Arg(1024);
+
+static void BM_ValueList(benchmark::State& state) {
+    int count = state.range(0);
+    for (auto _ : state) {
+        auto list = dv::list();
+        for (int i = 0; i < count; i++) {
+            list.add(i * 0.5);
+        }
+        benchmark::DoNotOptimize(list);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ValueList)->Arg(16)->Arg(1024);
+
+static void BM_ValueStrings(benchmark::State& state) {
+    int count = state.range(0);
+    for (auto _ : state) {
+        auto list = dv::list();
+        for (int i = 0; i < count; i++) {
+            list.add("string value that does not fit small buffer");
+        }
+        benchmark::DoNotOptimize(list);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ValueStrings)->Arg(1024);
+
+/// @brief Lookups and iteration over a chunks area
+template <typename Map>
+static void BM_ChunksAreaMap(benchmark::State& state) {
+    int radius = state.range(0);
+    Map map;
+    for (int z = -radius; z < radius; z++) {
+        for (int x = -radius; x < radius; x++) {
+            map[{x, z}] = x + z;
+        }
+    }
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (int z = -radius; z < radius; z++) {
+            for (int x = -radius; x < radius; x++) {
+                sum += map.find(glm::ivec2(x, z))->second;
+            }
+        }
+        for (const auto& [key, value] : map) {
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * map.size() * 2);
+}
+BENCHMARK(BM_ChunksAreaMap<std::unordered_map<glm::ivec2, int>>)->Arg(32);
+BENCHMARK(BM_ChunksAreaMap<util::FlatHashMap<glm::ivec2, int>>)->Arg(32);
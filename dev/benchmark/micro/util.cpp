@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+
+#include "util/ThreadPool.hpp"
+
+using namespace util;
+
+/// @brief Produces buffers of the chunk mesh data size
+class BufferWorker : public Worker<int, std::vector<float>> {
+public:
+    std::vector<float> operator()(const int& size) override {
+        return std::vector<float>(size, 1.0f);
+    }
+};
+
+static void BM_ThreadPoolResults(benchmark::State& state) {
+    TaskScheduler scheduler(4);
+    size_t consumed = 0;
+    ThreadPool<int, std::vector<float>> pool(
+        "pool",
+        []() { return std::make_shared<BufferWorker>(); },
+        [&consumed](std::vector<float>& result) {
+            auto buffer = std::move(result);
+            consumed += buffer.size();
+        },
+        ThreadPool<int, std::vector<float>>::UNLIMITED,
+        scheduler
+    );
+    int size = state.range(0);
+    for (auto _ : state) {
+        for (int i = 0; i < 64; i++) {
+            pool.enqueueJob(size);
+        }
+        pool.waitForJobs();
+    }
+    benchmark::DoNotOptimize(consumed);
+    state.SetItemsProcessed(state.iterations() * 64);
+    state.SetBytesProcessed(state.iterations() * 64 * size * sizeof(float));
+}
+BENCHMARK(BM_ThreadPoolResults)->Arg(1 << 10)->Arg(1 << 18);
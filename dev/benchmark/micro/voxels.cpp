@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "lighting/Lightmap.hpp"
+#include "voxels/Chunk.hpp"
+
+/// @brief Fill chunk with layered terrain: stone, dirt, grass, air and
+/// randomly scattered ores (compresses like generated chunks)
+static void fill_terrain(Chunk& chunk) {
+    std::mt19937 random(1000);
+    for (int y = 0; y < CHUNK_H; y++) {
+        for (int z = 0; z < CHUNK_D; z++) {
+            for (int x = 0; x < CHUNK_W; x++) {
+                auto& vox = chunk.voxels[vox_index(x, y, z)];
+                if (y < 60) {
+                    vox.id = random() % 64 == 0 ? 5 : 1;
+                } else if (y < 64) {
+                    vox.id = 2;
+                } else if (y == 64) {
+                    vox.id = 3;
+                } else {
+                    vox.id = 0;
+                }
+            }
+        }
+    }
+}
+
+static void BM_ChunkEncode(benchmark::State& state) {
+    Chunk chunk(0, 0);
+    fill_terrain(chunk);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(chunk.encode());
+    }
+    state.SetBytesProcessed(state.iterations() * CHUNK_DATA_LEN);
+}
+BENCHMARK(BM_ChunkEncode);
+
+static void BM_ChunkDecode(benchmark::State& state) {
+    Chunk chunk(0, 0);
+    fill_terrain(chunk);
+    auto bytes = chunk.encode();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(chunk.decode(bytes.get()));
+    }
+    state.SetBytesProcessed(state.iterations() * CHUNK_DATA_LEN);
+}
+BENCHMARK(BM_ChunkDecode);
+
+static void BM_LightmapEncode(benchmark::State& state) {
+    Lightmap lightmap;
+    for (int y = 0; y < CHUNK_H; y++) {
+        for (int z = 0; z < CHUNK_D; z++) {
+            for (int x = 0; x < CHUNK_W; x++) {
+                // full sky light above the ground, torches below
+                int sky = y > 64 ? 15 : std::max(0, 15 - (64 - y));
+                lightmap.set(x, y, z, 3, sky);
+                lightmap.set(x, y, z, 0, (x + y + z) % 16 == 0 ? 12 : 0);
+            }
+        }
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lightmap.encode());
+    }
+    state.SetBytesProcessed(state.iterations() * LIGHTMAP_DATA_LEN);
+}
+BENCHMARK(BM_LightmapEncode);
@@ -76,6 +76,10 @@ function generate_heightmap(x, y, w, h, s, inputs)
     return map
 end
 
+-- the heightmap depends on coordinates and inputs only, so areas of
+-- multiple chunks are generated the same way
+generate_heightmap_tile = generate_heightmap
+
 function generate_biome_parameters(x, y, w, h, s)
     local tempmap = Heightmap(w, h)
     tempmap.noiseSeed = SEED + 5324
@@ -1,9 +1,11 @@
-function on_random_update(x, y, z)
-    local dirtid = block.index('base:dirt');
+local function random_update(x, y, z, dirtid, grassblockid)
+    -- the block may be changed by previous updates of the batch
+    if block.get(x, y, z) ~= grassblockid then
+        return
+    end
     if block.is_solid_at(x, y+1, z) then
         block.set(x, y, z, dirtid, 0)
     else
-        local grassblockid = block.index('base:grass_block')
         for lx=-1,1 do
             for ly=-1,1 do
                 for lz=-1,1 do
@@ -18,3 +20,14 @@ function on_random_update(x, y, z)
         end
     end
 end
+
+function on_random_update_batch(positions, count)
+    local dirtid = block.index('base:dirt')
+    local grassblockid = block.index('base:grass_block')
+    for i=0,count-1 do
+        random_update(
+            positions[i*3+1], positions[i*3+2], positions[i*3+3],
+            dirtid, grassblockid
+        )
+    end
+end
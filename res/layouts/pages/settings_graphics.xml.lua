@@ -39,7 +39,13 @@ function on_open()
     create_setting("chunks.load-distance", "Load Distance", 1)
     create_setting("chunks.load-speed", "Load Speed", 1)
     create_setting("graphics.fog-curve", "Fog Curve", 0.1)
+    create_setting("graphics.lod-distance", "LOD Distance", 1, "", "graphics.lod-distance.tooltip")
+    create_setting("graphics.horizon-distance", "Horizon Distance", 1, "", "graphics.horizon-distance.tooltip")
+    create_setting("graphics.impostors-distance", "Impostors Distance", 1, "", "graphics.impostors-distance.tooltip")
     create_setting("graphics.gamma", "Gamma", 0.05, "", "graphics.gamma.tooltip")
     create_checkbox("graphics.backlight", "Backlight", "graphics.backlight.tooltip")
     create_checkbox("graphics.dense-render", "Dense blocks render", "graphics.dense-render.tooltip")
+    create_checkbox("graphics.greedy-meshing", "Greedy meshing", "graphics.greedy-meshing.tooltip")
+    create_checkbox("graphics.shadows", "Shadows", "graphics.shadows.tooltip")
+    create_checkbox("graphics.light-textures", "Light textures", "graphics.light-textures.tooltip")
 end
@@ -1,8 +1,9 @@
-function on_progress(done, total)
+function on_progress(done, total, status)
     local progress = done / total
     document.progress_label.text = string.format(
         "%s/%s (%s%%)", done, total, math.floor(progress*100)
     )
+    document.status_label.text = status or ""
 end
 
 function on_open(title)
@@ -90,36 +90,6 @@ return {
             entities[eid] = nil;
         end
     end,
-    update = function(tps, parts, part)
-        for uid, entity in pairs(entities) do
-            if uid % parts ~= part then
-                goto continue
-            end
-            for _, component in pairs(entity.components) do
-                local callback = component.on_update
-                if callback then
-                    local result, err = pcall(callback, tps)
-                    if err then
-                        debug.error(err)
-                    end
-                end
-            end
-            ::continue::
-        end
-    end,
-    render = function(delta)
-        for _,entity in pairs(entities) do
-            for _, component in pairs(entity.components) do
-                local callback = component.on_render
-                if callback then
-                    local result, err = pcall(callback, delta)
-                    if err then
-                        debug.error(err)
-                    end
-                end
-            end
-        end
-    end,
     get_all = function(uids)
         if uids == nil then
             return entities
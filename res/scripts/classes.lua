@@ -39,6 +39,8 @@ end
 local Socket = {__index={
     send=function(self, ...) return network.__send(self.id, ...) end,
     recv=function(self, ...) return network.__recv(self.id, ...) end,
+    send_message=function(self, ...) return network.__send_message(self.id, ...) end,
+    recv_message=function(self, ...) return network.__recv_message(self.id, ...) end,
     close=function(self) return network.__close(self.id) end,
     is_alive=function(self) return network.__is_alive(self.id) end,
     is_connected=function(self) return network.__is_connected(self.id) end,
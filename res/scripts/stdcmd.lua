@@ -224,6 +224,84 @@ console.add_command(
     end
 )
 
+console.add_command(
+    "generator.benchmark size:int=16 seed:int=0 name:str=''",
+    "Generate area twice measuring generator performance and determinism",
+    function(args, kwargs)
+        local size = args[1]
+        local seed = args[2]
+        local name = args[3]
+        if #name == 0 then
+            name = world.get_generator()
+        end
+        local result = generation.benchmark(name, seed, size)
+        local str = string.format(
+            "%s: %s chunks in %.1f ms (%.1f chunks/s)",
+            name, result.chunks, result.time, result.chunks_per_second
+        )
+        for _, stage in ipairs({
+            "wide_structs", "biomes", "heightmap", "structures"
+        }) do
+            str = str..string.format(
+                "\n  %s: %.1f ms", stage, result.stages[stage]
+            )
+        end
+        for _, stage in ipairs({"land", "placements", "plants"}) do
+            str = str..string.format("\n  %s: %.1f ms", stage, result[stage])
+        end
+        str = str.."\nhash: "..result.hash
+        if result.mismatches > 0 then
+            str = str..string.format(
+                "\nnon-deterministic: %s chunks differ in reverse order",
+                result.mismatches
+            )
+        end
+        return str
+    end
+)
+
+console.add_command(
+    "world.pregen radius:int x:num~pos.x z:num~pos.z shape:str='square'",
+    "Generate and save an area of chunks around the position",
+    function(args, kwargs)
+        local radius, x, z, shape = unpack(args)
+        world.pregenerate(x, z, radius, shape)
+        return string.format(
+            "pre-generating %s area with radius %s chunks, "..
+            "see world.pregen.status", shape, radius
+        )
+    end
+)
+
+console.add_command(
+    "world.pregen.status",
+    "Show the area pre-generation progress",
+    function(args, kwargs)
+        local progress = world.get_pregeneration()
+        if progress == nil then
+            return "pre-generation is not running"
+        end
+        local eta = "unknown"
+        if progress.eta >= 0 then
+            eta = string.format("%.0f s", progress.eta)
+        end
+        return string.format(
+            "%s/%s chunks (%.1f%%), %.0f s elapsed, %s left",
+            progress.done, progress.total,
+            progress.done * 100 / math.max(1, progress.total),
+            progress.elapsed, eta
+        )
+    end
+)
+
+console.add_command(
+    "world.pregen.stop",
+    "Stop the area pre-generation",
+    function(args, kwargs)
+        world.stop_pregeneration()
+    end
+)
+
 console.add_command(
     "rule.set name:str value:bool",
     "Set rule value",
@@ -268,8 +346,32 @@ console.cheats = {
     "blocks.fill",
     "tp",
     "fragment.place",
+    "world.pregen",
     "time.set",
     "time.daycycle",
     "entity.despawn",
     "player.respawn"
 }
+
+console.add_command(
+    "scripts.slowest count:int=10 reset:bool=false",
+    "Show event handlers with the greatest total execution time",
+    function(args, kwargs)
+        local count, reset = unpack(args)
+        local timings = core.get_handler_timings(count)
+        if reset then
+            core.reset_handler_timings()
+        end
+        if #timings == 0 then
+            return "no handlers called"
+        end
+        local str = "handler: calls, total ms, max ms, slow calls, skipped"
+        for _, t in ipairs(timings) do
+            str = str..string.format(
+                "\n  %s: %s, %.1f, %.2f, %s, %s",
+                t.name, t.calls, t.total, t.max, t.slow_calls, t.skipped
+            )
+        end
+        return str
+    end
+)
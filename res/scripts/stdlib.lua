@@ -116,6 +116,131 @@ menu = _MENU
 
 local __post_runnables = {}
 
+------------------------------------------------
+-------------------- Async ---------------------
+------------------------------------------------
+async = {}
+
+-- yielded by async.await: the coroutine is resumed by the task callback
+local AWAIT = {}
+-- coroutines resumed in the next __process_async call: {co, args}
+local __async_ready = {}
+local __async_coroutines = {}
+
+local function async_resume(co, args)
+    if not __async_coroutines[co] then
+        return -- cancelled
+    end
+    local ok, result = coroutine.resume(co, unpack(args, 1, args.n))
+    if not ok then
+        debug.error(result)
+    end
+    if coroutine.status(co) == "dead" then
+        __async_coroutines[co] = nil
+    elseif result ~= AWAIT then
+        table.insert(__async_ready, {co, {n=0}})
+    end
+end
+
+local function __process_async()
+    local ready = __async_ready
+    __async_ready = {}
+    for _, entry in ipairs(ready) do
+        async_resume(entry[1], entry[2])
+    end
+    -- awaited tasks may call resolve immediately
+    for _, entry in ipairs(ready) do
+        local starter = __async_coroutines[entry[1]]
+        if type(starter) == "function" then
+            __async_coroutines[entry[1]] = true
+            starter()
+        end
+    end
+end
+
+function async.run(func, ...)
+    local co = coroutine.create(func)
+    __async_coroutines[co] = true
+    table.insert(__async_ready, {co, {n=select('#', ...), ...}})
+    return co
+end
+
+function async.cancel(co)
+    __async_coroutines[co] = nil
+end
+
+function async.is_running(co)
+    return __async_coroutines[co] ~= nil
+end
+
+function async.await(start)
+    local co = coroutine.running()
+    if not __async_coroutines[co] then
+        error("async.await called outside of async.run coroutine")
+    end
+    local resolved = false
+    local function resolve(...)
+        if resolved then
+            return
+        end
+        resolved = true
+        table.insert(__async_ready, {co, {n=select('#', ...), ...}})
+    end
+    -- the task is started outside of the coroutine by the scheduler
+    __async_coroutines[co] = function()
+        local ok, err = pcall(start, resolve)
+        if not ok then
+            resolve(nil, err)
+        end
+    end
+    return coroutine.yield(AWAIT)
+end
+
+function async.yield()
+    coroutine.yield()
+end
+
+function async.wait_until(predicate, timeout)
+    local start = time.uptime()
+    while not predicate() do
+        if timeout and time.uptime() - start >= timeout then
+            return false
+        end
+        coroutine.yield()
+    end
+    return true
+end
+
+function file.read_async(path)
+    return async.await(function(resolve)
+        file.__read_async(path, resolve)
+    end)
+end
+
+function file.read_bytes_async(path)
+    return async.await(function(resolve)
+        file.__read_bytes_async(path, resolve)
+    end)
+end
+
+function core.screenshot_async()
+    return async.await(function(resolve)
+        core.screenshot(resolve)
+    end)
+end
+
+function network.get_async(url)
+    return async.await(function(resolve)
+        network.get(url, resolve)
+    end)
+end
+
+function network.get_binary_async(url)
+    return async.await(function(resolve)
+        network.get_binary(url, resolve)
+    end)
+end
+
 function __process_post_runnables()
     if #__post_runnables then
         for _, func in ipairs(__post_runnables) do
@@ -123,6 +248,7 @@ function __process_post_runnables()
         end
         __post_runnables = {}
     end
+    __process_async()
 end
 
 function time.post_runnable(runnable)
@@ -0,0 +1,36 @@
+#ifndef ANIMATION_GLSL_
+#define ANIMATION_GLSL_
+
+#include <world>
+
+#define MAX_ANIMATIONS 128
+#define MAX_ANIMATION_FRAMES 1024
+
+// blocks texture animations played by the timer, see ContentGfxCache
+layout (std140) uniform AnimationUniforms {
+    // x: first frame index, y: frames count, z: cycle duration in seconds
+    vec4 u_animations[MAX_ANIMATIONS];
+    // two frames per element: texture array layer, frame end time
+    // in the cycle
+    vec4 u_animationFrames[MAX_ANIMATION_FRAMES / 2];
+};
+
+// get texture array layer of the animation current frame
+int animation_layer(int index) {
+    vec4 animation = u_animations[index];
+    int first = int(animation.x);
+    int count = int(animation.y);
+    float time = mod(u_timer, animation.z);
+    vec2 frame = vec2(0.0);
+    for (int i = 0; i < count; i++) {
+        int frameIndex = first + i;
+        vec4 pair = u_animationFrames[frameIndex / 2];
+        frame = (frameIndex % 2 == 0) ? pair.xy : pair.zw;
+        if (time < frame.y) {
+            break;
+        }
+    }
+    return int(frame.x);
+}
+
+#endif // ANIMATION_GLSL_
@@ -11,6 +11,18 @@
 #define SKY_LIGHT_MUL 2.9
 #define SKY_LIGHT_TINT vec3(0.9, 0.8, 1.0)
 #define MIN_SKY_LIGHT vec3(0.2, 0.25, 0.33)
+// faces shading direction, see BlocksRenderer::SUN_VECTOR
+#define SUN_VECTOR vec3(0.411934, 0.863868, -0.279161)
+// vertex light channels of not shaded faces are above
+#define UNSHADED_LIGHT 0.99
+
+// shadows, see ShadowMaps
+#define SHADOW_CASCADES 3
+// sky light multiplier in the full strength shadow
+#define SHADOW_DARKNESS 0.5
+// cascade map border not used to avoid sampling outside of the map
+#define SHADOW_MARGIN 0.01
+#define SHADOW_BIAS 0.0004
 
 // fog
 #define FOG_POS_SCALE vec3(1.0, 0.2, 1.0)
@@ -0,0 +1,42 @@
+#ifndef LIGHTS_GLSL_
+#define LIGHTS_GLSL_
+
+#include <constants>
+#include <world>
+
+uniform bool u_lightTextures;
+// chunks lights ring texture (x, z, y), see LightTextures
+uniform sampler3D u_lightsMap;
+// area of the stored chunks: min x, min z, max x, max z
+uniform vec4 u_lightsArea;
+
+// light of the face fragment at the world position picked from the lights
+// texture (channels order as of the vertex light). The vertex light is used
+// if the position is out of the area or the face is not shaded
+vec4 pick_light(vec3 pos, vec4 vertexLight) {
+    if (!u_lightTextures) {
+        return vertexLight;
+    }
+    // derivatives are taken before the branches depending on the position
+    vec3 normal = normalize(cross(dFdx(pos), dFdy(pos)));
+    if (dot(normal, u_cameraPos - pos) < 0.0) {
+        normal = -normal;
+    }
+    // not shaded faces have the full light in all channels
+    if (all(greaterThan(vertexLight, vec4(UNSHADED_LIGHT)))) {
+        return vertexLight;
+    }
+    // the voxel in front of the face, filtered with its neighbours
+    // gives the same corner lights the vertices have
+    vec3 coord = pos + normal * 0.5;
+    if (coord.x < u_lightsArea.x || coord.z < u_lightsArea.y ||
+        coord.x > u_lightsArea.z || coord.z > u_lightsArea.w) {
+        return vertexLight;
+    }
+    vec4 light =
+        texture(u_lightsMap, coord.xzy / vec3(textureSize(u_lightsMap, 0)));
+    float shade = 0.8 + dot(normal, SUN_VECTOR) * 0.2;
+    return light * shade;
+}
+
+#endif // LIGHTS_GLSL_
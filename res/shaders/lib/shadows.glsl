@@ -0,0 +1,43 @@
+#ifndef SHADOWS_GLSL_
+#define SHADOWS_GLSL_
+
+#include <constants>
+
+uniform bool u_shadows;
+uniform float u_shadowsStrength;
+uniform float u_shadowTexel;
+uniform sampler2DArrayShadow u_shadowMap;
+uniform mat4 u_shadowMatrices[SHADOW_CASCADES];
+
+// sky light multiplier at the world position: 1.0 if lit by the sun,
+// the nearest cascade covering the position is used
+float sun_visibility(vec3 pos) {
+    if (!u_shadows) {
+        return 1.0;
+    }
+    for (int i = 0; i < SHADOW_CASCADES; i++) {
+        vec4 lightPos = u_shadowMatrices[i] * vec4(pos, 1.0);
+        vec3 coord = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+        if (any(lessThan(coord.xy, vec2(SHADOW_MARGIN))) ||
+            any(greaterThan(coord.xy, vec2(1.0 - SHADOW_MARGIN))) ||
+            coord.z > 1.0) {
+            continue;
+        }
+        // farther cascades have larger texels
+        float ref = coord.z - SHADOW_BIAS * float(i + 1);
+        float lit = 0.0;
+        for (int y = -1; y <= 1; y += 2) {
+            for (int x = -1; x <= 1; x += 2) {
+                vec2 offset = vec2(x, y) * (u_shadowTexel * 0.5);
+                lit += texture(
+                    u_shadowMap, vec4(coord.xy + offset, float(i), ref)
+                );
+            }
+        }
+        return 1.0 - (1.0 - lit * 0.25) * (1.0 - SHADOW_DARKNESS) *
+                     u_shadowsStrength;
+    }
+    return 1.0;
+}
+
+#endif // SHADOWS_GLSL_
@@ -0,0 +1,18 @@
+#ifndef WORLD_GLSL_
+#define WORLD_GLSL_
+
+// per-frame world state shared by world shaders, see WorldRenderer
+layout (std140) uniform WorldUniforms {
+    mat4 u_proj;
+    mat4 u_view;
+    vec3 u_cameraPos;
+    float u_gamma;
+    vec3 u_torchlightColor;
+    float u_torchlightDistance;
+    float u_fogFactor;
+    float u_fogCurve;
+    float u_timer;
+    float u_dayTime;
+};
+
+#endif // WORLD_GLSL_
@@ -1,8 +1,37 @@
 #include "Assets.hpp"
 
+#include "graphics/core/Atlas.hpp"
+#include "graphics/core/Texture.hpp"
+
+/// @brief Texture size estimation: RGBA8 texels and a third for mipmaps
+static size_t texture_memory(const Texture& texture) {
+    size_t size = static_cast<size_t>(texture.getWidth()) *
+                  texture.getHeight() * 4;
+    return size + size / 3;
+}
+
+Assets::Assets()
+    : memorySource([this](debug::MemoryBreakdown& breakdown) {
+          size_t total = 0;
+          if (auto textures = getMap<Texture>()) {
+              for (const auto& [_, texture] : **textures) {
+                  auto ptr = static_cast<Texture*>(texture.get());
+                  total += texture_memory(*ptr);
+              }
+          }
+          if (auto atlases = getMap<Atlas>()) {
+              for (const auto& [_, atlas] : **atlases) {
+                  auto texture = static_cast<Atlas*>(atlas.get())->getTexture();
+                  total += texture ? texture_memory(*texture) : 0;
+              }
+          }
+          breakdown["assets.textures"] += total;
+      }) {
+}
+
 Assets::~Assets() = default;
 
-const std::vector<TextureAnimation>& Assets::getAnimations() {
+const std::vector<TextureAnimation>& Assets::getAnimations() const {
     return animations;
 }
 
@@ -11,6 +11,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "debug/MemoryUsage.hpp"
 #include "util/stringutil.hpp"
 #include "graphics/core/TextureAnimation.hpp"
 
@@ -20,7 +21,28 @@ enum class AssetType { TEXTURE, SHADER, FONT, ATLAS, LAYOUT, SOUND, MODEL };
 
 namespace assetload {
     /// @brief final work to do in the main thread
-    using postfunc = std::function<void(Assets*)>;
+    class postfunc {
+        std::function<void(Assets*)> func;
+        size_t uploadSize = 0;
+    public:
+        postfunc() = default;
+
+        /// @param func asset finalization (GPU upload, storing)
+        /// @param uploadSize approximate size of data uploaded to GPU
+        /// by func in bytes
+        template <class F>
+        postfunc(F func, size_t uploadSize = 0)
+            : func(std::move(func)), uploadSize(uploadSize) {
+        }
+
+        void operator()(Assets* assets) const {
+            func(assets);
+        }
+
+        size_t getUploadSize() const {
+            return uploadSize;
+        }
+    };
 
     using setupfunc = std::function<void(const Assets*)>;
 
@@ -59,17 +81,28 @@ class Assets {
     using assets_map = std::unordered_map<std::string, std::shared_ptr<void>>;
     std::unordered_map<std::type_index, assets_map> assets;
     std::vector<assetload::setupfunc> setupFuncs;
+    /// @brief Incremented on every store call
+    size_t version = 0;
+    /// @brief Reports textures and atlases as "assets.textures"
+    debug::MemorySource memorySource;
 public:
-    Assets() = default;
+    Assets();
     Assets(const Assets&) = delete;
     ~Assets();
 
-    const std::vector<TextureAnimation>& getAnimations();
+    const std::vector<TextureAnimation>& getAnimations() const;
     void store(const TextureAnimation& animation);
 
     template <class T>
     void store(std::unique_ptr<T> asset, const std::string& name) {
         assets[typeid(T)][name].reset(asset.release());
+        version++;
+    }
+
+    /// @brief Get assets version, changed when any asset is stored or
+    /// replaced. Used to drop caches holding assets pointers
+    size_t getVersion() const {
+        return version;
     }
 
     template <class T>
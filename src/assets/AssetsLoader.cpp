@@ -1,7 +1,9 @@
 #include "AssetsLoader.hpp"
 
+#include <chrono>
 #include <iostream>
 #include <memory>
+#include <thread>
 #include <utility>
 
 #include "coders/imageio.hpp"
@@ -146,10 +148,20 @@ void AssetsLoader::processPreload(
     switch (tag) {
         case AssetType::SOUND: {
             bool keepPCM = false;
-            add(tag,
-                path,
-                name,
-                std::make_shared<SoundCfg>(map.at("keep-pcm").get(keepPCM)));
+            map.at("keep-pcm").get(keepPCM);
+            std::string loadingName = "cached";
+            map.at("load").get(loadingName);
+            auto loading = audio::SoundLoading::cached;
+            if (loadingName == "decoded") {
+                loading = audio::SoundLoading::decoded;
+            } else if (loadingName == "streamed") {
+                loading = audio::SoundLoading::streamed;
+            } else if (loadingName != "cached") {
+                throw std::runtime_error(
+                    "invalid sound loading mode '" + loadingName + "'"
+                );
+            }
+            add(tag, path, name, std::make_shared<SoundCfg>(keepPCM, loading));
             break;
         }
         case AssetType::ATLAS: {
@@ -317,18 +329,117 @@ public:
     }
 };
 
-std::shared_ptr<Task> AssetsLoader::startTask(runnable onDone) {
-    auto pool =
-        std::make_shared<util::ThreadPool<aloader_entry, assetload::postfunc>>(
+/// @brief Assets loading split into stages: decoding done by the pool
+/// workers and GPU uploads done in update() within the upload budget
+class AssetsLoaderTask : public Task {
+    using Pool = util::ThreadPool<aloader_entry, assetload::postfunc>;
+
+    Assets* assets;
+    size_t uploadBudget;
+    runnable onDone;
+    std::shared_ptr<Pool> pool;
+    /// @brief Decoded assets waiting for upload
+    std::queue<assetload::postfunc> uploads;
+    uint total = 0;
+    uint done = 0;
+    bool decoded = false;
+    bool active = true;
+public:
+    AssetsLoaderTask(
+        AssetsLoader* loader,
+        Assets* assets,
+        size_t uploadBudget,
+        runnable onDone
+    )
+        : assets(assets),
+          uploadBudget(uploadBudget),
+          onDone(std::move(onDone)) {
+        pool = std::make_shared<Pool>(
             "assets-loader-pool",
-            [=]() { return std::make_shared<LoaderWorker>(this); },
-            [=](const assetload::postfunc& func) { func(assets); }
+            [=]() { return std::make_shared<LoaderWorker>(loader); },
+            [this](const assetload::postfunc& func) { uploads.push(func); }
         );
-    pool->setOnComplete(std::move(onDone));
+        pool->setOnComplete([this]() { decoded = true; });
+    }
+
+    void enqueue(aloader_entry entry) {
+        total++;
+        pool->enqueueJob(std::move(entry));
+    }
+
+    bool isActive() const override {
+        return active;
+    }
+
+    uint getWorkTotal() const override {
+        return total;
+    }
+
+    uint getWorkDone() const override {
+        return done;
+    }
+
+    void update() override {
+        if (!active) {
+            return;
+        }
+        pool->update();
+
+        size_t uploaded = 0;
+        while (!uploads.empty()) {
+            auto func = std::move(uploads.front());
+            uploads.pop();
+            try {
+                func(assets);
+            } catch (const std::exception& err) {
+                logger.error() << err.what();
+                terminate();
+                throw;
+            }
+            done++;
+            // the rest is uploaded in the next updates
+            uploaded += func.getUploadSize();
+            if (uploadBudget > 0 && uploaded >= uploadBudget) {
+                break;
+            }
+        }
+        if (decoded && uploads.empty()) {
+            active = false;
+            if (onDone) {
+                onDone();
+            }
+        }
+    }
+
+    void waitForEnd() override {
+        using namespace std::chrono_literals;
+        while (active) {
+            if (uploads.empty()) {
+                std::this_thread::sleep_for(2ms);
+            }
+            update();
+        }
+    }
+
+    void terminate() override {
+        active = false;
+        pool->terminate();
+        uploads = {};
+    }
+};
+
+std::shared_ptr<Task> AssetsLoader::startTask(runnable onDone) {
+    auto task = std::make_shared<AssetsLoaderTask>(
+        this, assets, uploadBudget, std::move(onDone)
+    );
     while (!entries.empty()) {
         aloader_entry entry = std::move(entries.front());
         entries.pop();
-        pool->enqueueJob(std::move(entry));
+        task->enqueue(std::move(entry));
     }
-    return pool;
+    return task;
+}
+
+void AssetsLoader::setUploadBudget(size_t bytes) {
+    uploadBudget = bytes;
 }
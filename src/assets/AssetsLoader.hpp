@@ -9,6 +9,7 @@
 #include <string>
 #include <utility>
 
+#include "audio/audio.hpp"
 #include "delegates.hpp"
 #include "interfaces/Task.hpp"
 #include "typedefs.hpp"
@@ -33,8 +34,13 @@ struct LayoutCfg : AssetCfg {
 
 struct SoundCfg : AssetCfg {
     bool keepPCM;
+    audio::SoundLoading loading;
 
-    SoundCfg(bool keepPCM) : keepPCM(keepPCM) {
+    SoundCfg(
+        bool keepPCM,
+        audio::SoundLoading loading = audio::SoundLoading::cached
+    )
+        : keepPCM(keepPCM), loading(loading) {
     }
 };
 
@@ -61,11 +67,15 @@ struct aloader_entry {
 };
 
 class AssetsLoader {
+    /// @brief Default GPU upload budget of loading task update
+    static constexpr size_t DEFAULT_UPLOAD_BUDGET = 16 * 1024 * 1024;
+
     Assets* assets;
     std::map<AssetType, aloader_func> loaders;
     std::queue<aloader_entry> entries;
     std::set<std::pair<AssetType, std::string>> enqueued;
     const ResPaths* paths;
+    size_t uploadBudget = DEFAULT_UPLOAD_BUDGET;
 
     void tryAddSound(const std::string& name);
 
@@ -96,8 +106,16 @@ public:
     /// @throws assetload::error
     void loadNext();
 
+    /// @brief Start loading task. Assets are decoded by worker threads,
+    /// decoded data is uploaded to GPU in the task update() within
+    /// the upload budget
     std::shared_ptr<Task> startTask(runnable onDone);
 
+    /// @brief Limit data uploaded to GPU per loading task update.
+    /// At least one asset is uploaded per update
+    /// @param bytes max upload size in bytes, 0 is unlimited
+    void setUploadBudget(size_t bytes);
+
     const ResPaths* getPaths() const;
     aloader_func getLoader(AssetType tag);
 
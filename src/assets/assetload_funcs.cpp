@@ -1,11 +1,16 @@
 #include "assetload_funcs.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <stdexcept>
 
 #include "audio/audio.hpp"
 #include "coders/GLSLExtension.hpp"
+#include "coders/byte_utils.hpp"
 #include "coders/commons.hpp"
 #include "coders/imageio.hpp"
 #include "coders/json.hpp"
@@ -20,11 +25,15 @@
 #include "graphics/core/Font.hpp"
 #include "graphics/core/ImageData.hpp"
 #include "graphics/core/Shader.hpp"
+#include "graphics/core/StreamedTexture.hpp"
 #include "graphics/core/Texture.hpp"
+#include "graphics/core/TextureCompression.hpp"
 #include "graphics/core/TextureAnimation.hpp"
 #include "graphics/commons/Model.hpp"
 #include "objects/rigging.hpp"
+#include "util/data_io.hpp"
 #include "util/stringutil.hpp"
+#include "util/ThreadPool.hpp"
 #include "Assets.hpp"
 #include "AssetsLoader.hpp"
 
@@ -41,6 +50,12 @@ static bool load_animation(
     Atlas* dstAtlas
 );
 
+/// @return image data size uploaded to GPU in bytes
+static size_t upload_size(const ImageData& image) {
+    size_t pixel = image.getFormat() == ImageFormat::rgba8888 ? 4 : 3;
+    return static_cast<size_t>(image.getWidth()) * image.getHeight() * pixel;
+}
+
 assetload::postfunc assetload::texture(
     AssetsLoader*,
     const ResPaths* paths,
@@ -53,39 +68,108 @@ assetload::postfunc assetload::texture(
         std::shared_ptr<ImageData> image(
             imageio::read(fs::u8path(actualFile)).release()
         );
-        return [name, image, actualFile](auto assets) {
-            assets->store(Texture::from(image.get()), name);
-        };
+        return assetload::postfunc(
+            [name, image, actualFile](auto assets) {
+                assets->store(Texture::from(image.get()), name);
+            },
+            upload_size(*image)
+        );
     } catch (const std::runtime_error& err) {
         logger.error() << actualFile << ": " << err.what();
         return [](auto) {};
     }
 }
 
-assetload::postfunc assetload::shader(
-    AssetsLoader*,
+/// @brief Read PNG image size from the IHDR chunk
+/// @return false if the file is not a PNG image
+static bool read_png_size(const fs::path& file, uint& width, uint& height) {
+    static const ubyte signature[] {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+    ubyte header[24];
+    std::ifstream stream(file, std::ios::binary);
+    if (!stream.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        return false;
+    }
+    if (!std::equal(std::begin(signature), std::end(signature), header)) {
+        return false;
+    }
+    width = dataio::read_int32_big(header, 16);
+    height = dataio::read_int32_big(header, 20);
+    return true;
+}
+
+assetload::postfunc assetload::streamed_texture(
+    AssetsLoader* loader,
     const ResPaths* paths,
     const std::string& filename,
     const std::string& name,
-    const std::shared_ptr<AssetCfg>&
+    const std::shared_ptr<AssetCfg>& settings
 ) {
-    fs::path vertexFile = paths->find(filename + ".glslv");
-    fs::path fragmentFile = paths->find(filename + ".glslf");
+    auto actualFile = paths->find(filename + ".png");
+    uint width, height;
+    if (!read_png_size(actualFile, width, height)) {
+        return texture(loader, paths, filename, name, settings);
+    }
+    return [=](auto assets) {
+        // transparent placeholder shared by streamed textures
+        static std::weak_ptr<Texture> sharedPlaceholder;
+        auto placeholder = sharedPlaceholder.lock();
+        if (placeholder == nullptr) {
+            const ubyte pixels[] {0, 0, 0, 0};
+            ImageData image(ImageFormat::rgba8888, 1, 1, pixels);
+            placeholder = Texture::from(&image);
+            sharedPlaceholder = placeholder;
+        }
+        StreamedTexture::decoder decode = [actualFile]() {
+            return imageio::read(actualFile);
+        };
+        assets->store(
+            std::unique_ptr<Texture>(std::make_unique<StreamedTexture>(
+                width, height, std::move(decode), std::move(placeholder)
+            )),
+            name
+        );
+    };
+}
 
-    std::string vertexSource = files::read_string(vertexFile);
-    std::string fragmentSource = files::read_string(fragmentFile);
+struct ShaderSources {
+    fs::path vertexFile;
+    fs::path fragmentFile;
+    /// @brief Preprocessed sources
+    std::string vertexSource;
+    std::string fragmentSource;
+};
 
-    vertexSource = Shader::preprocessor->process(vertexFile, vertexSource);
-    fragmentSource =
-        Shader::preprocessor->process(fragmentFile, fragmentSource);
+static ShaderSources read_shader_sources(
+    const ResPaths* paths, const std::string& filename
+) {
+    ShaderSources sources;
+    sources.vertexFile = paths->find(filename + ".glslv");
+    sources.fragmentFile = paths->find(filename + ".glslf");
+
+    sources.vertexSource = Shader::preprocessor->process(
+        sources.vertexFile, files::read_string(sources.vertexFile)
+    );
+    sources.fragmentSource = Shader::preprocessor->process(
+        sources.fragmentFile, files::read_string(sources.fragmentFile)
+    );
+    return sources;
+}
 
+assetload::postfunc assetload::shader(
+    AssetsLoader*,
+    const ResPaths* paths,
+    const std::string& filename,
+    const std::string& name,
+    const std::shared_ptr<AssetCfg>&
+) {
+    auto sources = read_shader_sources(paths, filename);
     return [=](auto assets) {
         assets->store(
             Shader::create(
-                vertexFile.u8string(),
-                fragmentFile.u8string(),
-                vertexSource,
-                fragmentSource
+                sources.vertexFile.u8string(),
+                sources.fragmentFile.u8string(),
+                sources.vertexSource,
+                sources.fragmentSource
             ),
             name
         );
@@ -104,12 +188,275 @@ static bool append_atlas(AtlasBuilder& atlas, const fs::path& file) {
     return true;
 }
 
+/// @brief Atlas textures extrusion pixels
+static constexpr uint ATLAS_EXTRUSION = Atlas::EXTRUSION;
+/// @brief Raster atlases cache file format version
+static constexpr int RASTER_ATLAS_CACHE_VERSION = 1;
+static const char RASTER_ATLAS_CACHE_MAGIC[] = "VERATLS";
+
+/// @brief FNV-1a hash
+static uint64_t hash_bytes(
+    const ubyte* data, size_t size, uint64_t hash = 14695981039346656037ULL
+) {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+struct AtlasSource {
+    std::string name;
+    fs::path file;
+    /// @brief Source file content hash
+    uint64_t hash;
+    /// @brief Decoded image, nullptr if not decoded yet
+    std::shared_ptr<ImageData> image;
+};
+
+/// @brief List atlas source images skipping duplicates
+static std::vector<AtlasSource> list_atlas_sources(
+    const ResPaths* paths, const std::string& directory
+) {
+    std::vector<AtlasSource> sources;
+    std::set<std::string> names;
+    for (const auto& file : paths->listdir(directory)) {
+        if (!imageio::is_read_supported(file.extension().u8string())) {
+            continue;
+        }
+        std::string name = file.stem().string();
+        if (!names.insert(name).second) {
+            continue;
+        }
+        auto bytes = files::read_bytes(file);
+        uint64_t hash = hash_bytes(bytes.data(), bytes.size());
+        sources.push_back(AtlasSource {std::move(name), file, hash, nullptr});
+    }
+    return sources;
+}
+
+class AtlasSourceDecoder
+    : public util::Worker<AtlasSource*, std::shared_ptr<ImageData>> {
+public:
+    std::shared_ptr<ImageData> operator()(AtlasSource* const& source
+    ) override {
+        std::shared_ptr<ImageData> image(
+            imageio::read(source->file).release()
+        );
+        image->fixAlphaColor();
+        // sources are not shared between jobs
+        source->image = image;
+        return image;
+    }
+};
+
+/// @brief Decode not yet decoded sources in parallel
+static void decode_atlas_sources(const std::vector<AtlasSource*>& sources) {
+    util::ThreadPool<AtlasSource*, std::shared_ptr<ImageData>> pool(
+        "atlas-decoding",
+        []() { return std::make_shared<AtlasSourceDecoder>(); },
+        [](auto&) {}
+    );
+    pool.setPriority(util::TaskScheduler::Priority::HIGH);
+    for (auto source : sources) {
+        if (source->image == nullptr) {
+            pool.enqueueJob(source);
+        }
+    }
+    pool.waitForJobs();
+}
+
+static fs::path atlas_cache_file(
+    const fs::path& cacheFolder,
+    const std::string& name,
+    const std::string& extension
+) {
+    std::string fileName = name;
+    for (char& c : fileName) {
+        if (!std::isalnum(static_cast<unsigned char>(c))) {
+            c = '_';
+        }
+    }
+    return cacheFolder / fs::u8path(fileName + extension);
+}
+
+/// @brief Raster atlas cache: canvas and source images placement
+struct RasterAtlasCache {
+    struct Entry {
+        uint64_t hash;
+        uint x, y, width, height;
+    };
+    std::unique_ptr<ImageData> image;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+static std::unique_ptr<RasterAtlasCache> read_raster_atlas_cache(
+    const fs::path& file
+) {
+    if (!fs::is_regular_file(file)) {
+        return nullptr;
+    }
+    try {
+        auto bytes = files::read_bytes(file);
+        ByteReader reader(bytes.data(), bytes.size());
+        reader.checkMagic(
+            RASTER_ATLAS_CACHE_MAGIC, sizeof(RASTER_ATLAS_CACHE_MAGIC)
+        );
+        if (reader.getInt32() != RASTER_ATLAS_CACHE_VERSION ||
+            reader.getInt32() != static_cast<int>(ATLAS_EXTRUSION)) {
+            return nullptr;
+        }
+        uint width = reader.getInt32();
+        uint height = reader.getInt32();
+        if (width > Texture::MAX_RESOLUTION ||
+            height > Texture::MAX_RESOLUTION) {
+            return nullptr;
+        }
+        auto cache = std::make_unique<RasterAtlasCache>();
+        int entriesCount = reader.getInt32();
+        for (int i = 0; i < entriesCount; i++) {
+            auto name = reader.getString();
+            auto& entry = cache->entries[name];
+            entry.hash = reader.getInt64();
+            entry.x = reader.getInt32();
+            entry.y = reader.getInt32();
+            entry.width = reader.getInt32();
+            entry.height = reader.getInt32();
+        }
+        size_t size = static_cast<size_t>(width) * height * 4;
+        if (size > reader.remaining()) {
+            throw std::runtime_error("unexpected end of file");
+        }
+        cache->image = std::make_unique<ImageData>(
+            ImageFormat::rgba8888, width, height, reader.pointer()
+        );
+        return cache;
+    } catch (const std::runtime_error& err) {
+        logger.error() << "invalid atlas cache " << file.u8string() << ": "
+                       << err.what();
+        return nullptr;
+    }
+}
+
+static void write_raster_atlas_cache(
+    const fs::path& file,
+    const Atlas& atlas,
+    const std::vector<AtlasSource>& sources
+) {
+    const auto& image = *atlas.getImage();
+    uint width = image.getWidth();
+    uint height = image.getHeight();
+
+    ByteBuilder builder;
+    builder.put(
+        reinterpret_cast<const ubyte*>(RASTER_ATLAS_CACHE_MAGIC),
+        sizeof(RASTER_ATLAS_CACHE_MAGIC)
+    );
+    builder.putInt32(RASTER_ATLAS_CACHE_VERSION);
+    builder.putInt32(ATLAS_EXTRUSION);
+    builder.putInt32(width);
+    builder.putInt32(height);
+    builder.putInt32(sources.size());
+    for (const auto& source : sources) {
+        const auto& region = atlas.get(source.name);
+        builder.put(source.name);
+        builder.putInt64(source.hash);
+        builder.putInt32(std::round(region.u1 * width));
+        builder.putInt32(std::round(region.v1 * height));
+        builder.putInt32(std::round(region.getWidth() * width));
+        builder.putInt32(std::round(region.getHeight() * height));
+    }
+    builder.put(image.getData(), static_cast<size_t>(width) * height * 4);
+    try {
+        fs::create_directories(file.parent_path());
+        files::write_bytes(file, builder.data(), builder.size());
+    } catch (const std::exception& err) {
+        logger.error() << "could not write atlas cache: " << err.what();
+    }
+}
+
+/// @brief Update cached atlas canvas with the changed source images
+/// keeping the cached placement
+/// @param updated set to true if any source image is changed
+/// @return nullptr if placement can not be reused (images are added,
+/// removed or resized)
+static std::unique_ptr<Atlas> update_cached_atlas(
+    RasterAtlasCache& cache, std::vector<AtlasSource>& sources, bool& updated
+) {
+    if (cache.entries.size() != sources.size()) {
+        return nullptr;
+    }
+    std::vector<AtlasSource*> changed;
+    for (auto& source : sources) {
+        auto found = cache.entries.find(source.name);
+        if (found == cache.entries.end()) {
+            return nullptr;
+        }
+        if (found->second.hash != source.hash) {
+            changed.push_back(&source);
+        }
+    }
+    decode_atlas_sources(changed);
+    for (auto source : changed) {
+        const auto& entry = cache.entries.at(source->name);
+        if (source->image->getWidth() != entry.width ||
+            source->image->getHeight() != entry.height) {
+            return nullptr;
+        }
+    }
+    auto& canvas = *cache.image;
+    for (auto source : changed) {
+        const auto& entry = cache.entries.at(source->name);
+        blit_atlas_entry(
+            canvas, *source->image, entry.x, entry.y, ATLAS_EXTRUSION
+        );
+    }
+    float unitX = 1.0f / canvas.getWidth();
+    float unitY = 1.0f / canvas.getHeight();
+    std::unordered_map<std::string, UVRegion> regions;
+    for (const auto& [name, entry] : cache.entries) {
+        regions[name] = UVRegion(
+            unitX * entry.x,
+            unitY * entry.y,
+            unitX * (entry.x + entry.width),
+            unitY * (entry.y + entry.height)
+        );
+    }
+    updated = !changed.empty();
+    return std::make_unique<Atlas>(std::move(cache.image), regions, false);
+}
+
+/// @brief Build atlas of all sources decoding them in parallel
+static std::unique_ptr<Atlas> build_atlas(std::vector<AtlasSource>& sources) {
+    std::vector<AtlasSource*> pointers;
+    for (auto& source : sources) {
+        pointers.push_back(&source);
+    }
+    decode_atlas_sources(pointers);
+
+    AtlasBuilder builder;
+    for (const auto& source : sources) {
+        builder.add(source.name, source.image);
+    }
+    return builder.build(ATLAS_EXTRUSION, false);
+}
+
 assetload::postfunc assetload::atlas(
     AssetsLoader* loader,
     const ResPaths* paths,
     const std::string& directory,
     const std::string& name,
     const std::shared_ptr<AssetCfg>& config
+) {
+    return cached_atlas(loader, paths, directory, name, config, fs::path());
+}
+
+assetload::postfunc assetload::cached_atlas(
+    AssetsLoader* loader,
+    const ResPaths* paths,
+    const std::string& directory,
+    const std::string& name,
+    const std::shared_ptr<AssetCfg>& config,
+    const fs::path& cacheFolder
 ) {
     auto atlasConfig = std::dynamic_pointer_cast<AtlasCfg>(config);
     if (atlasConfig && atlasConfig->type == AtlasType::SEPARATE) {
@@ -124,19 +471,322 @@ assetload::postfunc assetload::atlas(
         }
         return [](auto){};
     }
-    AtlasBuilder builder;
+    auto sources = list_atlas_sources(paths, directory);
+    std::set<std::string> names;
+    for (const auto& source : sources) {
+        names.insert(source.name);
+    }
+    fs::path cacheFile;
+    std::unique_ptr<Atlas> built;
+    bool updated = true;
+    if (!cacheFolder.empty()) {
+        cacheFile = atlas_cache_file(cacheFolder, name, ".atlas");
+        if (auto cache = read_raster_atlas_cache(cacheFile)) {
+            built = update_cached_atlas(*cache, sources, updated);
+        }
+    }
+    if (built == nullptr) {
+        built = build_atlas(sources);
+        updated = true;
+    }
+    if (!cacheFile.empty() && updated) {
+        write_raster_atlas_cache(cacheFile, *built, sources);
+    }
+    Atlas* atlas = built.release();
+    return assetload::postfunc(
+        [=](auto assets) {
+            atlas->prepare();
+            assets->store(std::unique_ptr<Atlas>(atlas), name);
+            for (const auto& file : names) {
+                load_animation(assets, paths, name, directory, file, atlas);
+            }
+        },
+        upload_size(*atlas->getImage())
+    );
+}
+
+/// @brief Compressed atlases cache file format version
+static constexpr int ATLAS_CACHE_VERSION = 1;
+static const char ATLAS_CACHE_MAGIC[] = "VEATLAS";
+
+struct CachedAtlas {
+    texture_compression::CompressedImage image;
+    std::unordered_map<std::string, UVRegion> regions;
+};
+
+/// @brief FNV-1a hash of the source images and compression format
+static uint64_t hash_atlas_sources(
+    const std::vector<fs::path>& files, uint format
+) {
+    uint64_t hash = hash_bytes(
+        reinterpret_cast<const ubyte*>(&format), sizeof(format)
+    );
+    for (const auto& file : files) {
+        auto name = file.filename().u8string();
+        hash = hash_bytes(
+            reinterpret_cast<const ubyte*>(name.data()), name.size(), hash
+        );
+        auto bytes = files::read_bytes(file);
+        hash = hash_bytes(bytes.data(), bytes.size(), hash);
+    }
+    return hash;
+}
+
+static std::shared_ptr<CachedAtlas> read_atlas_cache(
+    const fs::path& file, uint64_t key
+) {
+    if (!fs::is_regular_file(file)) {
+        return nullptr;
+    }
+    try {
+        auto bytes = files::read_bytes(file);
+        ByteReader reader(bytes.data(), bytes.size());
+        reader.checkMagic(ATLAS_CACHE_MAGIC, sizeof(ATLAS_CACHE_MAGIC));
+        if (reader.getInt32() != ATLAS_CACHE_VERSION ||
+            static_cast<uint64_t>(reader.getInt64()) != key) {
+            return nullptr;
+        }
+        auto atlas = std::make_shared<CachedAtlas>();
+        auto& image = atlas->image;
+        image.format = reader.getInt32();
+        image.width = reader.getInt32();
+        image.height = reader.getInt32();
+        int regionsCount = reader.getInt32();
+        for (int i = 0; i < regionsCount; i++) {
+            auto name = reader.getString();
+            float u1 = reader.getFloat32();
+            float v1 = reader.getFloat32();
+            float u2 = reader.getFloat32();
+            float v2 = reader.getFloat32();
+            atlas->regions[name] = UVRegion(u1, v1, u2, v2);
+        }
+        int levelsCount = reader.getInt32();
+        for (int i = 0; i < levelsCount; i++) {
+            size_t size = reader.getInt32();
+            if (size > reader.remaining()) {
+                throw std::runtime_error("unexpected end of file");
+            }
+            image.levels.emplace_back(
+                reader.pointer(), reader.pointer() + size
+            );
+            reader.skip(size);
+        }
+        return atlas;
+    } catch (const std::runtime_error& err) {
+        logger.error() << "invalid atlas cache " << file.u8string() << ": "
+                       << err.what();
+        return nullptr;
+    }
+}
+
+static void write_atlas_cache(
+    const fs::path& file, uint64_t key, const CachedAtlas& atlas
+) {
+    ByteBuilder builder;
+    builder.put(
+        reinterpret_cast<const ubyte*>(ATLAS_CACHE_MAGIC),
+        sizeof(ATLAS_CACHE_MAGIC)
+    );
+    builder.putInt32(ATLAS_CACHE_VERSION);
+    builder.putInt64(key);
+    const auto& image = atlas.image;
+    builder.putInt32(image.format);
+    builder.putInt32(image.width);
+    builder.putInt32(image.height);
+    builder.putInt32(atlas.regions.size());
+    for (const auto& [name, region] : atlas.regions) {
+        builder.put(name);
+        builder.putFloat32(region.u1);
+        builder.putFloat32(region.v1);
+        builder.putFloat32(region.u2);
+        builder.putFloat32(region.v2);
+    }
+    builder.putInt32(image.levels.size());
+    for (const auto& level : image.levels) {
+        builder.putInt32(level.size());
+        builder.put(level.data(), level.size());
+    }
+    try {
+        fs::create_directories(file.parent_path());
+        files::write_bytes(file, builder.data(), builder.size());
+    } catch (const std::exception& err) {
+        logger.error() << "could not write atlas cache: " << err.what();
+    }
+}
+
+assetload::postfunc assetload::compressed_atlas(
+    AssetsLoader* loader,
+    const ResPaths* paths,
+    const std::string& directory,
+    const std::string& name,
+    const std::shared_ptr<AssetCfg>& config,
+    const fs::path& cacheFolder
+) {
+    auto atlasConfig = std::dynamic_pointer_cast<AtlasCfg>(config);
+    uint format = texture_compression::select_format();
+    // compressed textures can not be animations blitting destination
+    bool animated = !paths->listdir(directory + "/animation").empty();
+    if ((atlasConfig && atlasConfig->type == AtlasType::SEPARATE) ||
+        format == 0 || animated) {
+        return cached_atlas(
+            loader, paths, directory, name, config, cacheFolder
+        );
+    }
+    std::vector<fs::path> files;
     for (const auto& file : paths->listdir(directory)) {
-        if (!imageio::is_read_supported(file.extension().u8string())) continue;
-        if (!append_atlas(builder, file)) continue;
+        if (imageio::is_read_supported(file.extension().u8string())) {
+            files.push_back(file);
+        }
+    }
+    uint64_t key = hash_atlas_sources(files, format);
+    auto cacheFile = atlas_cache_file(cacheFolder, name, ".bin");
+
+    if (auto cached = read_atlas_cache(cacheFile, key)) {
+        size_t size = 0;
+        for (const auto& level : cached->image.levels) {
+            size += level.size();
+        }
+        return assetload::postfunc(
+            [=](auto assets) {
+                assets->store(
+                    std::make_unique<Atlas>(
+                        texture_compression::upload(cached->image),
+                        cached->regions
+                    ),
+                    name
+                );
+            },
+            size
+        );
+    }
+    auto sources = list_atlas_sources(paths, directory);
+    std::shared_ptr<Atlas> atlas = build_atlas(sources);
+    return assetload::postfunc(
+        [=](auto assets) {
+            CachedAtlas cached {{}, atlas->getRegions()};
+            auto texture = texture_compression::compress(
+                *atlas->getImage(), format, cached.image
+            );
+            write_atlas_cache(cacheFile, key, cached);
+            assets->store(
+                std::make_unique<Atlas>(
+                    std::move(texture), atlas->getRegions()
+                ),
+                name
+            );
+        },
+        upload_size(*atlas->getImage())
+    );
+}
+
+/// @brief Shader program binaries cache file format version
+static constexpr int SHADER_CACHE_VERSION = 1;
+static const char SHADER_CACHE_MAGIC[] = "VESHADR";
+
+struct CachedShader {
+    /// @brief Driver the binary is produced by, see Shader::getDriverName
+    std::string driver;
+    uint format;
+    std::vector<ubyte> binary;
+};
+
+static std::shared_ptr<CachedShader> read_shader_cache(
+    const fs::path& file, uint64_t key
+) {
+    if (!fs::is_regular_file(file)) {
+        return nullptr;
+    }
+    try {
+        auto bytes = files::read_bytes(file);
+        ByteReader reader(bytes.data(), bytes.size());
+        reader.checkMagic(SHADER_CACHE_MAGIC, sizeof(SHADER_CACHE_MAGIC));
+        if (reader.getInt32() != SHADER_CACHE_VERSION ||
+            static_cast<uint64_t>(reader.getInt64()) != key) {
+            return nullptr;
+        }
+        auto shader = std::make_shared<CachedShader>();
+        shader->driver = reader.getString();
+        shader->format = reader.getInt32();
+        size_t size = reader.getInt32();
+        if (size > reader.remaining()) {
+            throw std::runtime_error("unexpected end of file");
+        }
+        shader->binary.assign(reader.pointer(), reader.pointer() + size);
+        return shader;
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not read shader cache " << file.u8string()
+                       << ": " << err.what();
+        return nullptr;
+    }
+}
+
+static void write_shader_cache(
+    const fs::path& file, uint64_t key, const Shader& shader
+) {
+    uint format;
+    std::vector<ubyte> binary;
+    if (!shader.getBinary(format, binary)) {
+        return;
     }
-    std::set<std::string> names = builder.getNames();
-    Atlas* atlas = builder.build(2, false).release();
+    ByteBuilder builder;
+    builder.put(
+        reinterpret_cast<const ubyte*>(SHADER_CACHE_MAGIC),
+        sizeof(SHADER_CACHE_MAGIC)
+    );
+    builder.putInt32(SHADER_CACHE_VERSION);
+    builder.putInt64(key);
+    builder.put(Shader::getDriverName());
+    builder.putInt32(format);
+    builder.putInt32(binary.size());
+    builder.put(binary.data(), binary.size());
+    try {
+        fs::create_directories(file.parent_path());
+        files::write_bytes(file, builder.data(), builder.size());
+    } catch (const std::exception& err) {
+        logger.error() << "could not write shader cache: " << err.what();
+    }
+}
+
+assetload::postfunc assetload::cached_shader(
+    AssetsLoader*,
+    const ResPaths* paths,
+    const std::string& filename,
+    const std::string& name,
+    const std::shared_ptr<AssetCfg>&,
+    const fs::path& cacheFolder
+) {
+    auto sources = read_shader_sources(paths, filename);
+    const auto& vertex = sources.vertexSource;
+    const auto& fragment = sources.fragmentSource;
+    uint64_t key = hash_bytes(
+        reinterpret_cast<const ubyte*>(vertex.data()), vertex.size()
+    );
+    key = hash_bytes(
+        reinterpret_cast<const ubyte*>(fragment.data()),
+        fragment.size() + 1, // including the terminator as a separator
+        key
+    );
+    auto cacheFile = atlas_cache_file(cacheFolder, name, ".bin");
+    auto cached = read_shader_cache(cacheFile, key);
+
     return [=](auto assets) {
-        atlas->prepare();
-        assets->store(std::unique_ptr<Atlas>(atlas), name);
-        for (const auto& file : names) {
-            load_animation(assets, paths, name, directory, file, atlas);
+        std::unique_ptr<Shader> shader;
+        if (cached && Shader::isBinarySupported() &&
+            cached->driver == Shader::getDriverName()) {
+            shader = Shader::createFromBinary(
+                cached->format, cached->binary.data(), cached->binary.size()
+            );
         }
+        if (shader == nullptr) {
+            shader = Shader::create(
+                sources.vertexFile.u8string(),
+                sources.fragmentFile.u8string(),
+                vertex,
+                fragment
+            );
+            write_shader_cache(cacheFile, key, *shader);
+        }
+        assets->store(std::move(shader), name);
     };
 }
 
@@ -159,22 +809,21 @@ assetload::postfunc assetload::font(
             pages->push_back(nullptr);
         }
     }
-    return [=](auto assets) {
-        int res = pages->at(0)->getHeight() / 16;
-        std::vector<std::unique_ptr<Texture>> textures;
-        for (auto& page : *pages) {
-            if (page == nullptr) {
-                textures.emplace_back(nullptr);
-            } else {
-                auto texture = Texture::from(page.get());
-                texture->setMipMapping(false);
-                textures.emplace_back(std::move(texture));
-            }
+    size_t size = 0;
+    for (const auto& page : *pages) {
+        if (page) {
+            size += upload_size(*page);
         }
-        assets->store(
-            std::make_unique<Font>(std::move(textures), res, 4), name
-        );
-    };
+    }
+    return assetload::postfunc(
+        [=](auto assets) {
+            int res = pages->at(0)->getHeight() / 16;
+            assets->store(
+                std::make_unique<Font>(std::move(*pages), res, 4), name
+            );
+        },
+        size
+    );
 }
 
 assetload::postfunc assetload::layout(
@@ -214,6 +863,7 @@ assetload::postfunc assetload::sound(
 ) {
     auto cfg = std::dynamic_pointer_cast<SoundCfg>(config);
     bool keepPCM = cfg ? cfg->keepPCM : false;
+    auto loading = cfg ? cfg->loading : audio::SoundLoading::cached;
 
     std::unique_ptr<audio::Sound> baseSound = nullptr;
     static std::vector<std::string> extensions {".ogg", ".wav"};
@@ -223,13 +873,13 @@ assetload::postfunc assetload::sound(
         // looking for 'sound_name' as base sound
         auto soundFile = paths->find(file + extension);
         if (fs::exists(soundFile)) {
-            baseSound = audio::load_sound(soundFile, keepPCM);
+            baseSound = audio::load_sound(soundFile, keepPCM, loading);
             break;
         }
         // looking for 'sound_name_0' as base sound
         auto variantFile = paths->find(file + "_0" + extension);
         if (fs::exists(variantFile)) {
-            baseSound = audio::load_sound(variantFile, keepPCM);
+            baseSound = audio::load_sound(variantFile, keepPCM, loading);
             break;
         }
     }
@@ -244,7 +894,9 @@ assetload::postfunc assetload::sound(
         if (!fs::exists(variantFile)) {
             break;
         }
-        baseSound->variants.emplace_back(audio::load_sound(variantFile, keepPCM));
+        baseSound->variants.emplace_back(
+            audio::load_sound(variantFile, keepPCM, loading)
+        );
     }
 
     auto sound = baseSound.release();
@@ -305,6 +957,124 @@ assetload::postfunc assetload::model(
     }
 }
 
+/// @brief Binary models cache file format version
+static constexpr int MODEL_CACHE_VERSION = 1;
+static const char MODEL_CACHE_MAGIC[] = "VEMODEL";
+
+static_assert(
+    sizeof(model::Vertex) == 8 * sizeof(float),
+    "model vertices are stored as flat float arrays"
+);
+
+/// @brief Decode the models cache: meshes with vertices stored as flat
+/// arrays copied at once
+static std::unique_ptr<model::Model> decode_model_cache(
+    const ubyte* bytes, size_t size, uint64_t key
+) {
+    ByteReader reader(bytes, size);
+    reader.checkMagic(MODEL_CACHE_MAGIC, sizeof(MODEL_CACHE_MAGIC));
+    if (reader.getInt32() != MODEL_CACHE_VERSION ||
+        static_cast<uint64_t>(reader.getInt64()) != key) {
+        return nullptr;
+    }
+    auto model = std::make_unique<model::Model>();
+    size_t meshesCount = reader.getInt32();
+    model->meshes.reserve(meshesCount);
+    for (size_t i = 0; i < meshesCount; i++) {
+        auto& mesh = model->addMesh(reader.getString());
+        mesh.lighting = reader.get();
+        size_t verticesCount = reader.getInt32();
+        size_t length = verticesCount * sizeof(model::Vertex);
+        if (length > reader.remaining()) {
+            throw std::runtime_error("unexpected end of file");
+        }
+        mesh.vertices.resize(verticesCount);
+        reader.get(reinterpret_cast<char*>(mesh.vertices.data()), length);
+    }
+    return model;
+}
+
+static std::unique_ptr<model::Model> read_model_cache(
+    const fs::path& file, uint64_t key
+) {
+    if (!fs::is_regular_file(file)) {
+        return nullptr;
+    }
+    try {
+        if (files::mmfile::is_supported()) {
+            files::mmfile mapped(file);
+            return decode_model_cache(mapped.data(), mapped.length(), key);
+        }
+        auto bytes = files::read_bytes(file);
+        return decode_model_cache(bytes.data(), bytes.size(), key);
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not read model cache " << file.u8string()
+                       << ": " << err.what();
+        return nullptr;
+    }
+}
+
+static void write_model_cache(
+    const fs::path& file, uint64_t key, const model::Model& model
+) {
+    ByteBuilder builder;
+    builder.put(
+        reinterpret_cast<const ubyte*>(MODEL_CACHE_MAGIC),
+        sizeof(MODEL_CACHE_MAGIC)
+    );
+    builder.putInt32(MODEL_CACHE_VERSION);
+    builder.putInt64(key);
+    builder.putInt32(model.meshes.size());
+    for (const auto& mesh : model.meshes) {
+        builder.put(mesh.texture);
+        builder.put(static_cast<ubyte>(mesh.lighting));
+        builder.putInt32(mesh.vertices.size());
+        builder.put(
+            reinterpret_cast<const ubyte*>(mesh.vertices.data()),
+            mesh.vertices.size() * sizeof(model::Vertex)
+        );
+    }
+    try {
+        fs::create_directories(file.parent_path());
+        files::write_bytes(file, builder.data(), builder.size());
+    } catch (const std::exception& err) {
+        logger.error() << "could not write model cache: " << err.what();
+    }
+}
+
+assetload::postfunc assetload::cached_model(
+    AssetsLoader* loader,
+    const ResPaths* paths,
+    const std::string& file,
+    const std::string& name,
+    const std::shared_ptr<AssetCfg>& settings,
+    const fs::path& cacheFolder
+) {
+    auto path = paths->find(file + ".obj");
+    if (!fs::exists(path) || fs::exists(paths->find(file + ".vec3"))) {
+        return model(loader, paths, file, name, settings);
+    }
+    auto text = files::read_string(path);
+    uint64_t key = hash_bytes(
+        reinterpret_cast<const ubyte*>(text.data()), text.size()
+    );
+    auto cacheFile = atlas_cache_file(cacheFolder, name, ".bin");
+    std::shared_ptr<model::Model> model = read_model_cache(cacheFile, key);
+    if (model == nullptr) {
+        try {
+            model = obj::parse(path.u8string(), text);
+        } catch (const parsing_error& err) {
+            std::cerr << err.errorLog() << std::endl;
+            throw;
+        }
+        write_model_cache(cacheFile, key, *model);
+    }
+    return [=](Assets* assets) {
+        request_textures(loader, *model);
+        assets->store(std::make_unique<model::Model>(std::move(*model)), name);
+    };
+}
+
 static void read_anim_file(
     const std::string& animFile,
     std::vector<std::pair<std::string, int>>& frameList
@@ -339,6 +1109,9 @@ static TextureAnimation create_animation(
     UVRegion region = dstAtlas->get(name);
 
     TextureAnimation animation(srcTex, dstTex);
+    animation.srcAtlas = srcAtlas;
+    animation.dstAtlas = dstAtlas;
+    animation.dstRegion = name;
     Frame frame;
 
     uint dstWidth = dstTex->getWidth();
@@ -363,6 +1136,7 @@ static TextureAnimation create_animation(
         if (elem.second > 0) {
             frame.duration = static_cast<float>(elem.second) / 1000.0f;
         }
+        frame.region = region;
         frame.srcPos = glm::ivec2(
             region.u1 * srcWidth, srcHeight - region.v2 * srcHeight
         ) - extension;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <filesystem>
 #include <memory>
 #include <string>
 
@@ -20,6 +21,15 @@ namespace assetload {
         const std::string& name,
         const std::shared_ptr<AssetCfg>& settings
     );
+    /// @brief Texture loader decoding images on the first use
+    /// (see StreamedTexture). Only the image header is read at load
+    postfunc streamed_texture(
+        AssetsLoader*,
+        const ResPaths* paths,
+        const std::string& filename,
+        const std::string& name,
+        const std::shared_ptr<AssetCfg>& settings
+    );
     postfunc shader(
         AssetsLoader*,
         const ResPaths* paths,
@@ -27,6 +37,17 @@ namespace assetload {
         const std::string& name,
         const std::shared_ptr<AssetCfg>& settings
     );
+    /// @brief Shader loader caching linked program binaries in the cache
+    /// folder keyed by the preprocessed sources hash. Binaries of another
+    /// driver or rejected by the driver are replaced by compiled ones
+    postfunc cached_shader(
+        AssetsLoader*,
+        const ResPaths* paths,
+        const std::string& filename,
+        const std::string& name,
+        const std::shared_ptr<AssetCfg>& settings,
+        const std::filesystem::path& cacheFolder
+    );
     postfunc atlas(
         AssetsLoader*,
         const ResPaths* paths,
@@ -34,6 +55,30 @@ namespace assetload {
         const std::string& name,
         const std::shared_ptr<AssetCfg>& settings
     );
+    /// @brief Atlas loader caching the packed atlas in the cache folder.
+    /// Changed source images of the same size are blitted to the cached
+    /// atlas keeping its layout. Atlas is packed again only if images are
+    /// added, removed or resized
+    postfunc cached_atlas(
+        AssetsLoader*,
+        const ResPaths* paths,
+        const std::string& directory,
+        const std::string& name,
+        const std::shared_ptr<AssetCfg>& settings,
+        const std::filesystem::path& cacheFolder
+    );
+    /// @brief Atlas loader compressing the atlas texture
+    /// (see texture_compression). Compressed texture is cached in the
+    /// cache folder keyed by the source images hash, so the next loads
+    /// skip packing and compression
+    postfunc compressed_atlas(
+        AssetsLoader*,
+        const ResPaths* paths,
+        const std::string& directory,
+        const std::string& name,
+        const std::shared_ptr<AssetCfg>& settings,
+        const std::filesystem::path& cacheFolder
+    );
     postfunc font(
         AssetsLoader*,
         const ResPaths* paths,
@@ -62,4 +107,15 @@ namespace assetload {
         const std::string& name,
         const std::shared_ptr<AssetCfg>& settings
     );
+    /// @brief Model loader keeping parsed OBJ models in the cache folder
+    /// as flat binary meshes keyed by the source text hash. VEC3 models
+    /// are loaded as usual
+    postfunc cached_model(
+        AssetsLoader*,
+        const ResPaths* paths,
+        const std::string& file,
+        const std::string& name,
+        const std::shared_ptr<AssetCfg>& settings,
+        const std::filesystem::path& cacheFolder
+    );
 }
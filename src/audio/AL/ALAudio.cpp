@@ -3,6 +3,7 @@
 #include <string>
 #include <utility>
 
+#include "audio/StreamPrefetcher.hpp"
 #include "debug/Logger.hpp"
 #include "alutil.hpp"
 
@@ -40,11 +41,16 @@ std::unique_ptr<Speaker> ALSound::newInstance(int priority, int channel) const {
 ALStream::ALStream(
     ALAudio* al, std::shared_ptr<PCMStream> source, bool keepSource
 )
-    : al(al), source(std::move(source)), keepSource(keepSource) {
+    : al(al),
+      source(std::move(source)),
+      prefetch(std::make_shared<PrefetchedStream>(this->source, BUFFER_SIZE)),
+      keepSource(keepSource) {
+    al->getPrefetcher().add(prefetch);
 }
 
 ALStream::~ALStream() {
     bindSpeaker(0);
+    prefetch = nullptr;
     source = nullptr;
 
     while (!unusedBuffers.empty()) {
@@ -61,13 +67,20 @@ std::shared_ptr<PCMStream> ALStream::getSource() const {
     }
 }
 
-bool ALStream::preloadBuffer(uint buffer, bool loop) {
-    size_t read = source->readFully(this->buffer, BUFFER_SIZE, loop);
-    if (!read) return false;
+bool ALStream::preloadBuffer(uint buffer, bool loop, bool wait) {
+    prefetch->setLoop(loop);
+    if (!prefetch->pop(this->buffer, wait)) {
+        return false;
+    }
+    al->getPrefetcher().notify();
     ALenum format =
         AL::to_al_format(source->getChannels(), source->getBitsPerSample());
     AL_CHECK(alBufferData(
-        buffer, format, this->buffer, read, source->getSampleRate()
+        buffer,
+        format,
+        this->buffer.data(),
+        this->buffer.size(),
+        source->getSampleRate()
     ));
     return true;
 }
@@ -80,8 +93,10 @@ std::unique_ptr<Speaker> ALStream::createSpeaker(bool loop, int channel) {
     }
     for (uint i = 0; i < ALStream::STREAM_BUFFERS; i++) {
         uint free_buffer = al->getFreeBuffer();
-        if (!preloadBuffer(free_buffer, loop)) {
-            break;
+        // waiting for the first chunk only, the rest are queued on update
+        if (!preloadBuffer(free_buffer, loop, i == 0)) {
+            unusedBuffers.push(free_buffer);
+            continue;
         }
         AL_CHECK(alSourceQueueBuffers(free_source, 1, &free_buffer));
     }
@@ -127,11 +142,11 @@ void ALStream::unqueueBuffers(uint alsource) {
     }
 }
 
-uint ALStream::enqueueBuffers(uint alsource) {
+uint ALStream::enqueueBuffers(uint alsource, bool wait) {
     uint preloaded = 0;
     if (!unusedBuffers.empty()) {
         uint first_buffer = unusedBuffers.front();
-        if (preloadBuffer(first_buffer, loop)) {
+        if (preloadBuffer(first_buffer, loop, wait)) {
             preloaded++;
             unusedBuffers.pop();
             AL_CHECK(alSourceQueueBuffers(alsource, 1, &first_buffer));
@@ -159,15 +174,16 @@ void ALStream::update(double delta) {
     uint alsource = alspeaker->source;
 
     unqueueBuffers(alsource);
-    uint preloaded = enqueueBuffers(alsource);
+    uint preloaded = enqueueBuffers(alsource, false);
 
     // alspeaker->stopped is assigned to false at ALSpeaker::play(...)
     if (p_speaker->isStopped() && !alspeaker->stopped) { //TODO: -V560 false-positive?
         if (preloaded) {
             p_speaker->play();
-        } else {
+        } else if (prefetch->isEnd()) {
             p_speaker->stop();
         }
+        // otherwise waiting for the prefetcher (buffers underrun)
     }
 }
 
@@ -189,7 +205,7 @@ duration_t ALStream::getTime() const {
 void ALStream::setTime(duration_t time) {
     if (!source->isSeekable()) return;
     uint sample = time * source->getSampleRate();
-    source->seek(sample);
+    prefetch->seek(sample);
     auto alspeaker =
         dynamic_cast<ALSpeaker*>(audio::get_speaker(this->speaker));
     if (alspeaker) {
@@ -197,7 +213,7 @@ void ALStream::setTime(duration_t time) {
         AL_CHECK(alSourceStop(alspeaker->source));
         unqueueBuffers(alspeaker->source);
         totalPlayedSamples = sample;
-        enqueueBuffers(alspeaker->source);
+        enqueueBuffers(alspeaker->source, true);
         AL_CHECK(alSourcePlay(alspeaker->source));
         if (paused) {
             AL_CHECK(alSourcePause(alspeaker->source));
@@ -354,7 +370,9 @@ int ALSpeaker::getPriority() const {
 }
 
 ALAudio::ALAudio(ALCdevice* device, ALCcontext* context)
-    : device(device), context(context) {
+    : device(device),
+      context(context),
+      prefetcher(std::make_unique<StreamPrefetcher>()) {
     ALCint size;
     alcGetIntegerv(device, ALC_ATTRIBUTES_SIZE, 1, &size);
     std::vector<ALCint> attrs(size);
@@ -499,3 +517,7 @@ void ALAudio::setListener(
 
 void ALAudio::update(double) {
 }
+
+StreamPrefetcher& ALAudio::getPrefetcher() {
+    return *prefetcher;
+}
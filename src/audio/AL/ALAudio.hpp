@@ -19,6 +19,8 @@
 
 namespace audio {
     struct ALBuffer;
+    class PrefetchedStream;
+    class StreamPrefetcher;
     class ALAudio;
     class PCMStream;
 
@@ -53,15 +55,18 @@ namespace audio {
 
         ALAudio* al;
         std::shared_ptr<PCMStream> source;
+        /// @brief Source decoded on the prefetcher thread
+        std::shared_ptr<PrefetchedStream> prefetch;
         std::queue<uint> unusedBuffers;
         speakerid_t speaker = 0;
         bool keepSource;
-        char buffer[BUFFER_SIZE];
+        std::vector<char> buffer;
         bool loop = false;
 
-        bool preloadBuffer(uint buffer, bool loop);
+        /// @param wait wait for the chunk to be decoded
+        bool preloadBuffer(uint buffer, bool loop, bool wait);
         void unqueueBuffers(uint alsource);
-        uint enqueueBuffers(uint alsource);
+        uint enqueueBuffers(uint alsource, bool wait);
     public:
         size_t totalPlayedSamples = 0;
 
@@ -143,6 +148,8 @@ namespace audio {
         std::vector<uint> freebuffers;
 
         uint maxSources = 256;
+
+        std::unique_ptr<StreamPrefetcher> prefetcher;
     public:
         ALAudio(ALCdevice* device, ALCcontext* context);
         ~ALAudio();
@@ -152,6 +159,8 @@ namespace audio {
         void freeSource(uint source);
         void freeBuffer(uint buffer);
 
+        StreamPrefetcher& getPrefetcher();
+
         std::vector<std::string> getAvailableDevices() const;
 
         std::unique_ptr<Sound> createSound(
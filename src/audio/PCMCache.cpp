@@ -0,0 +1,71 @@
+#include "PCMCache.hpp"
+
+using namespace audio;
+
+PCMCache::PCMCache(size_t budget, size_t maxEntrySize)
+    : budget(budget), maxEntrySize(maxEntrySize) {
+}
+
+void PCMCache::evict() {
+    while (usedMemory > budget && !entries.empty()) {
+        auto oldest = entries.begin();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse) {
+                oldest = it;
+            }
+        }
+        usedMemory -= oldest->second.pcm->data.size();
+        entries.erase(oldest);
+    }
+}
+
+std::shared_ptr<PCM> PCMCache::get(
+    const std::string& key,
+    int64_t version,
+    const std::function<std::shared_ptr<PCM>()>& loader
+) {
+    {
+        std::lock_guard lock(mutex);
+        auto found = entries.find(key);
+        if (found != entries.end()) {
+            auto& entry = found->second;
+            if (entry.version == version) {
+                entry.lastUse = ++useCounter;
+                return entry.pcm;
+            }
+            usedMemory -= entry.pcm->data.size();
+            entries.erase(found);
+        }
+    }
+    auto pcm = loader();
+    size_t size = pcm->data.size();
+    if (size > maxEntrySize) {
+        return pcm;
+    }
+    std::lock_guard lock(mutex);
+    auto [it, inserted] =
+        entries.try_emplace(key, Entry {pcm, version, ++useCounter});
+    if (!inserted) {
+        // loaded concurrently by another thread
+        return it->second.pcm;
+    }
+    usedMemory += size;
+    evict();
+    return pcm;
+}
+
+void PCMCache::clear() {
+    std::lock_guard lock(mutex);
+    entries.clear();
+    usedMemory = 0;
+}
+
+size_t PCMCache::getUsedMemory() {
+    std::lock_guard lock(mutex);
+    return usedMemory;
+}
+
+size_t PCMCache::size() {
+    std::lock_guard lock(mutex);
+    return entries.size();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "audio.hpp"
+
+namespace audio {
+    /// @brief Thread-safe cache of decoded PCM data shared between sounds.
+    /// Least recently used entries are released when total size of cached
+    /// data exceeds the memory budget. Released data stays alive while
+    /// it's referenced by someone else
+    class PCMCache {
+        struct Entry {
+            std::shared_ptr<PCM> pcm;
+            /// @brief Source version (e.g. file modification time),
+            /// entry is reloaded if version is changed
+            int64_t version;
+            uint64_t lastUse;
+        };
+        std::unordered_map<std::string, Entry> entries;
+        size_t budget;
+        size_t maxEntrySize;
+        size_t usedMemory = 0;
+        uint64_t useCounter = 0;
+        std::mutex mutex;
+
+        void evict();
+    public:
+        /// @param budget max total size of cached PCM data in bytes
+        /// @param maxEntrySize max size of cached PCM data in bytes,
+        /// larger ones are not cached
+        PCMCache(size_t budget, size_t maxEntrySize);
+
+        /// @brief Get cached PCM data or load it
+        /// @param key source identifier (e.g. file path)
+        /// @param version source version
+        /// @param loader called to load PCM on cache miss (without the cache
+        /// lock held, so the same source may be loaded twice concurrently)
+        std::shared_ptr<PCM> get(
+            const std::string& key,
+            int64_t version,
+            const std::function<std::shared_ptr<PCM>()>& loader
+        );
+
+        void clear();
+
+        /// @brief Get total size of cached PCM data in bytes
+        size_t getUsedMemory();
+
+        size_t size();
+    };
+}
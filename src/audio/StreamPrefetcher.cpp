@@ -0,0 +1,164 @@
+#include "StreamPrefetcher.hpp"
+
+#include <chrono>
+
+#include "audio.hpp"
+
+using namespace audio;
+
+/// @brief Thread checks streams at least with this interval
+static constexpr auto PREFETCH_INTERVAL = std::chrono::milliseconds(10);
+
+PrefetchedStream::PrefetchedStream(
+    std::shared_ptr<PCMStream> source, size_t chunkSize
+)
+    : source(std::move(source)), chunkSize(chunkSize) {
+}
+
+bool PrefetchedStream::needsDecoding() {
+    std::lock_guard lock(mutex);
+    return !end && decoded.size() < StreamPrefetcher::PREFETCH_CHUNKS;
+}
+
+void PrefetchedStream::decodeNext() {
+    std::vector<char> chunk;
+    bool loop;
+    uint64_t generation;
+    {
+        std::lock_guard lock(mutex);
+        if (!spare.empty()) {
+            chunk = std::move(spare.back());
+            spare.pop_back();
+        }
+        loop = this->loop;
+        generation = this->generation;
+    }
+    chunk.resize(chunkSize);
+    size_t read;
+    {
+        std::lock_guard lock(sourceMutex);
+        read = source->readFully(chunk.data(), chunkSize, loop);
+    }
+    chunk.resize(read);
+    {
+        std::lock_guard lock(mutex);
+        if (generation != this->generation) {
+            // seeked while decoding
+            return;
+        }
+        if (read == 0) {
+            end = true;
+        } else {
+            decoded.push_back(std::move(chunk));
+        }
+    }
+    decodedCondition.notify_all();
+}
+
+bool PrefetchedStream::pop(std::vector<char>& dst, bool wait) {
+    std::unique_lock lock(mutex);
+    if (wait) {
+        decodedCondition.wait(lock, [this]() {
+            return !decoded.empty() || end;
+        });
+    }
+    if (decoded.empty()) {
+        return false;
+    }
+    if (dst.capacity()) {
+        spare.push_back(std::move(dst));
+    }
+    dst = std::move(decoded.front());
+    decoded.pop_front();
+    return true;
+}
+
+bool PrefetchedStream::isEnd() {
+    std::lock_guard lock(mutex);
+    return end && decoded.empty();
+}
+
+void PrefetchedStream::setLoop(bool loop) {
+    std::lock_guard lock(mutex);
+    if (this->loop != loop) {
+        this->loop = loop;
+        // end of the stream is not the end anymore
+        end = end && !loop;
+    }
+}
+
+void PrefetchedStream::seek(size_t position) {
+    std::lock_guard sourceLock(sourceMutex);
+    source->seek(position);
+
+    std::lock_guard lock(mutex);
+    generation++;
+    end = false;
+    for (auto& chunk : decoded) {
+        spare.push_back(std::move(chunk));
+    }
+    decoded.clear();
+}
+
+StreamPrefetcher::StreamPrefetcher() : thread([this]() { loop(); }) {
+}
+
+StreamPrefetcher::~StreamPrefetcher() {
+    {
+        std::lock_guard lock(mutex);
+        running = false;
+    }
+    condition.notify_one();
+    thread.join();
+}
+
+void StreamPrefetcher::add(const std::shared_ptr<PrefetchedStream>& stream) {
+    {
+        std::lock_guard lock(mutex);
+        streams.push_back(stream);
+        notified = true;
+    }
+    condition.notify_one();
+}
+
+void StreamPrefetcher::notify() {
+    {
+        std::lock_guard lock(mutex);
+        notified = true;
+    }
+    condition.notify_one();
+}
+
+void StreamPrefetcher::loop() {
+    std::vector<std::shared_ptr<PrefetchedStream>> active;
+    while (running) {
+        active.clear();
+        {
+            std::lock_guard lock(mutex);
+            for (size_t i = 0; i < streams.size();) {
+                if (auto stream = streams[i].lock()) {
+                    active.push_back(std::move(stream));
+                    i++;
+                } else {
+                    streams[i] = std::move(streams.back());
+                    streams.pop_back();
+                }
+            }
+        }
+        bool decoded = false;
+        for (const auto& stream : active) {
+            if (stream->needsDecoding()) {
+                stream->decodeNext();
+                decoded = true;
+            }
+        }
+        active.clear();
+        if (!decoded) {
+            std::unique_lock lock(mutex);
+            condition.wait_for(lock, PREFETCH_INTERVAL, [this]() {
+                return !running || notified;
+            });
+            notified = false;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "typedefs.hpp"
+
+namespace audio {
+    class PCMStream;
+
+    /// @brief PCM stream decoded ahead of time by the StreamPrefetcher
+    /// thread. Source must not be read by anything else while prefetched
+    class PrefetchedStream {
+        friend class StreamPrefetcher;
+
+        std::shared_ptr<PCMStream> source;
+        size_t chunkSize;
+
+        /// @brief Guards decoded chunks and the stream state
+        std::mutex mutex;
+        std::condition_variable decodedCondition;
+        std::deque<std::vector<char>> decoded;
+        /// @brief Consumed chunks buffers reused by the decoder
+        std::vector<std::vector<char>> spare;
+        bool loop = false;
+        bool end = false;
+        /// @brief Incremented on seek to drop chunks decoded before
+        uint64_t generation = 0;
+
+        /// @brief Guards the source reading and seeking
+        std::mutex sourceMutex;
+
+        /// @return true if more chunks should be decoded
+        bool needsDecoding();
+        /// @brief Decode the next chunk (called from the prefetcher thread)
+        void decodeNext();
+    public:
+        /// @param source decoded stream
+        /// @param chunkSize size of decoded chunks (bytes)
+        PrefetchedStream(std::shared_ptr<PCMStream> source, size_t chunkSize);
+
+        /// @brief Take the next decoded chunk
+        /// @param dst destination, previous buffer is reused by the decoder
+        /// @param wait wait until the chunk is decoded
+        /// @return false if the chunk is not decoded yet or the stream ended
+        bool pop(std::vector<char>& dst, bool wait);
+
+        /// @return true if the stream ended and all chunks are taken
+        bool isEnd();
+
+        void setLoop(bool loop);
+
+        /// @brief Seek the source dropping already decoded chunks
+        void seek(size_t position);
+    };
+
+    /// @brief Thread decoding registered streams, keeping up to
+    /// PREFETCH_CHUNKS decoded chunks for each
+    class StreamPrefetcher {
+        std::vector<std::weak_ptr<PrefetchedStream>> streams;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool notified = false;
+        std::atomic<bool> running = true;
+        std::thread thread;
+
+        void loop();
+    public:
+        static inline constexpr size_t PREFETCH_CHUNKS = 4;
+
+        StreamPrefetcher();
+        ~StreamPrefetcher();
+
+        /// @brief Start prefetching the stream until it is destroyed
+        void add(const std::shared_ptr<PrefetchedStream>& stream);
+
+        /// @brief Wake up the thread (e.g. after chunks are taken)
+        void notify();
+    };
+}
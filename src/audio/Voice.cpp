@@ -0,0 +1,219 @@
+#include "Voice.hpp"
+
+#include <cmath>
+
+using namespace audio;
+
+Voice::Voice(const Sound* sound, int priority, int channel)
+    : sound(sound), priority(priority), channel(channel) {
+}
+
+Voice::~Voice() {
+    stop();
+}
+
+float Voice::getAudibility(glm::vec3 listener, const Channel* channel) const {
+    float distance = glm::length(relative ? position : position - listener);
+    float gain = volume / std::max(distance, 1.0f);
+    if (channel) {
+        gain *= channel->getVolume();
+    }
+    if (auto master = get_channel(0)) {
+        gain *= master->getVolume();
+    }
+    return gain;
+}
+
+bool Voice::realize() {
+    if (speaker || sound == nullptr) {
+        return speaker != nullptr;
+    }
+    speaker = sound->newInstance(priority, channel);
+    if (speaker == nullptr) {
+        return false;
+    }
+    speaker->setPosition(position);
+    speaker->setVelocity(velocity);
+    speaker->setVolume(volume);
+    speaker->setPitch(pitch);
+    speaker->setLoop(loop);
+    speaker->setRelative(relative);
+    if (state != State::stopped) {
+        speaker->play();
+        speaker->setTime(time);
+        if (state == State::paused) {
+            speaker->pause();
+        }
+    }
+    return true;
+}
+
+void Voice::virtualize() {
+    if (speaker == nullptr) {
+        return;
+    }
+    time = speaker->getTime();
+    if (state == State::playing && speaker->isStopped()) {
+        state = State::stopped;
+    }
+    speaker->stop();
+    speaker = nullptr;
+}
+
+void Voice::advance(double delta) {
+    if (speaker || state != State::playing || channelPaused) {
+        return;
+    }
+    time += delta * pitch;
+    duration_t duration = getDuration();
+    if (time < duration) {
+        return;
+    }
+    if (loop && duration > 0.0) {
+        time = std::fmod(time, duration);
+    } else {
+        state = State::stopped;
+    }
+}
+
+void Voice::update(const Channel* channel) {
+    channelPaused = channel->isPaused();
+    if (speaker) {
+        speaker->update(channel);
+    }
+}
+
+int Voice::getChannel() const {
+    return channel;
+}
+
+State Voice::getState() const {
+    if (speaker) {
+        return speaker->getState();
+    }
+    if (state == State::playing && channelPaused) {
+        return State::paused;
+    }
+    return state;
+}
+
+float Voice::getVolume() const {
+    return volume;
+}
+
+void Voice::setVolume(float volume) {
+    this->volume = volume;
+    if (speaker) {
+        speaker->setVolume(volume);
+    }
+}
+
+float Voice::getPitch() const {
+    return pitch;
+}
+
+void Voice::setPitch(float pitch) {
+    this->pitch = pitch;
+    if (speaker) {
+        speaker->setPitch(pitch);
+    }
+}
+
+bool Voice::isLoop() const {
+    return loop;
+}
+
+void Voice::setLoop(bool loop) {
+    this->loop = loop;
+    if (speaker) {
+        speaker->setLoop(loop);
+    }
+}
+
+void Voice::play() {
+    if (sound == nullptr) {
+        return;
+    }
+    if (state == State::stopped) {
+        time = 0.0;
+    }
+    state = State::playing;
+    if (speaker) {
+        speaker->play();
+    }
+}
+
+void Voice::pause() {
+    if (state != State::playing) {
+        return;
+    }
+    state = State::paused;
+    if (speaker) {
+        speaker->pause();
+    }
+}
+
+void Voice::stop() {
+    state = State::stopped;
+    // stopped speaker is not supposed to be reused
+    sound = nullptr;
+    if (speaker) {
+        speaker->stop();
+        speaker = nullptr;
+    }
+}
+
+duration_t Voice::getTime() const {
+    if (speaker) {
+        return speaker->getTime();
+    }
+    return time;
+}
+
+duration_t Voice::getDuration() const {
+    return sound ? sound->getDuration() : 0.0;
+}
+
+void Voice::setTime(duration_t time) {
+    this->time = time;
+    if (speaker) {
+        speaker->setTime(time);
+    }
+}
+
+void Voice::setPosition(glm::vec3 pos) {
+    position = pos;
+    if (speaker) {
+        speaker->setPosition(pos);
+    }
+}
+
+glm::vec3 Voice::getPosition() const {
+    return position;
+}
+
+void Voice::setVelocity(glm::vec3 vel) {
+    velocity = vel;
+    if (speaker) {
+        speaker->setVelocity(vel);
+    }
+}
+
+glm::vec3 Voice::getVelocity() const {
+    return velocity;
+}
+
+int Voice::getPriority() const {
+    return priority;
+}
+
+void Voice::setRelative(bool relative) {
+    this->relative = relative;
+    if (speaker) {
+        speaker->setRelative(relative);
+    }
+}
+
+bool Voice::isRelative() const {
+    return relative;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "audio.hpp"
+
+namespace audio {
+    /// @brief Sound instance which may be virtual: inaudible or exceeding
+    /// voices limit instance keeps its state and playhead but does not
+    /// occupy a backend source. Voices are realized/virtualized by
+    /// audio::update
+    class Voice : public Speaker {
+        const Sound* sound;
+        /// @brief Backend speaker, nullptr if the voice is virtual
+        std::unique_ptr<Speaker> speaker;
+        int priority;
+        int channel;
+        float volume = 1.0f;
+        float pitch = 1.0f;
+        bool loop = false;
+        bool relative = false;
+        bool channelPaused = false;
+        glm::vec3 position {};
+        glm::vec3 velocity {};
+        State state = State::stopped;
+        /// @brief Playhead of the virtual voice
+        duration_t time = 0.0;
+    public:
+        Voice(const Sound* sound, int priority, int channel);
+        ~Voice();
+
+        const Sound* getSound() const {
+            return sound;
+        }
+
+        bool isVirtual() const {
+            return speaker == nullptr;
+        }
+
+        /// @brief Estimate gain of the voice heard by the listener
+        /// (inverse distance clamped model with reference distance 1)
+        /// @param listener listener position
+        /// @param channel voice channel
+        float getAudibility(glm::vec3 listener, const Channel* channel) const;
+
+        /// @brief Create backend speaker restoring the voice state
+        /// @return false if no backend sources available
+        bool realize();
+
+        /// @brief Release backend speaker keeping the voice state
+        void virtualize();
+
+        /// @brief Move playhead of the virtual voice
+        /// @param delta time elapsed since the last update (seconds)
+        void advance(double delta);
+
+        void update(const Channel* channel) override;
+        int getChannel() const override;
+
+        State getState() const override;
+
+        float getVolume() const override;
+        void setVolume(float volume) override;
+
+        float getPitch() const override;
+        void setPitch(float pitch) override;
+
+        bool isLoop() const override;
+        void setLoop(bool loop) override;
+
+        void play() override;
+        void pause() override;
+        void stop() override;
+
+        duration_t getTime() const override;
+        duration_t getDuration() const override;
+        void setTime(duration_t time) override;
+
+        void setPosition(glm::vec3 pos) override;
+        glm::vec3 getPosition() const override;
+
+        void setVelocity(glm::vec3 vel) override;
+        glm::vec3 getVelocity() const override;
+
+        int getPriority() const override;
+
+        void setRelative(bool relative) override;
+        bool isRelative() const override;
+    };
+}
@@ -1,5 +1,6 @@
 #include "audio.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <utility>
@@ -8,13 +9,34 @@
 #include "coders/wav.hpp"
 #include "AL/ALAudio.hpp"
 #include "NoAudio.hpp"
+#include "PCMCache.hpp"
+#include "Voice.hpp"
+
+/// @brief Hard limit of sound instances (including virtual ones)
+static constexpr size_t MAX_VOICES = 256;
+/// @brief Max number of sound instances using backend sources at once,
+/// the rest sources are left for streams
+static constexpr size_t MAX_REAL_VOICES = 64;
+/// @brief Voices with lower estimated gain are virtualized
+static constexpr float AUDIBLE_GAIN = 0.005f;
+/// @brief Virtual voice must be this times louder than AUDIBLE_GAIN to be
+/// realized again, prevents voices flapping at the audibility border
+static constexpr float REALIZE_HYSTERESIS = 1.5f;
+/// @brief Max total size of decoded PCM data kept in the shared cache
+static constexpr size_t PCM_CACHE_BUDGET = 32 * 1024 * 1024;
+/// @brief Larger decoded sounds are not cached
+static constexpr size_t MAX_CACHED_PCM_SIZE = 2 * 1024 * 1024;
 
 namespace audio {
     static speakerid_t nextId = 1;
     static Backend* backend;
     static std::unordered_map<speakerid_t, std::unique_ptr<Speaker>> speakers;
     static std::unordered_map<speakerid_t, std::shared_ptr<Stream>> streams;
+    /// @brief Sound instances subset of speakers
+    static std::unordered_map<speakerid_t, Voice*> voices;
     static std::vector<std::unique_ptr<Channel>> channels;
+    static glm::vec3 listenerPosition {};
+    static PCMCache pcmCache(PCM_CACHE_BUDGET, MAX_CACHED_PCM_SIZE);
 }
 
 using namespace audio;
@@ -169,13 +191,53 @@ std::unique_ptr<PCM> audio::load_PCM(const fs::path& file, bool headerOnly) {
     throw std::runtime_error("unsupported audio format");
 }
 
-std::unique_ptr<Sound> audio::load_sound(const fs::path& file, bool keepPCM) {
-    std::shared_ptr<PCM> pcm(
-        load_PCM(file, !keepPCM && backend->isDummy()).release()
-    );
+/// @brief Sound without audio data loaded, streamed from Sound::streamFile
+class StreamedSound : public Sound {
+    duration_t duration;
+public:
+    StreamedSound(const fs::path& file, duration_t duration)
+        : duration(duration) {
+        streamFile = file;
+    }
+
+    duration_t getDuration() const override {
+        return duration;
+    }
+
+    std::shared_ptr<PCM> getPCM() const override {
+        return nullptr;
+    }
+
+    std::unique_ptr<Speaker> newInstance(int, int) const override {
+        return nullptr;
+    }
+};
+
+std::unique_ptr<Sound> audio::load_sound(
+    const fs::path& file, bool keepPCM, SoundLoading loading
+) {
+    bool headerOnly = !keepPCM && backend->isDummy();
+    if (loading == SoundLoading::streamed) {
+        auto header = load_PCM(file, true);
+        return std::make_unique<StreamedSound>(file, header->getDuration());
+    }
+    std::shared_ptr<PCM> pcm;
+    if (loading == SoundLoading::cached && !headerOnly) {
+        int64_t version =
+            fs::last_write_time(file).time_since_epoch().count();
+        pcm = pcmCache.get(file.u8string(), version, [&file]() {
+            return std::shared_ptr<PCM>(load_PCM(file, false));
+        });
+    } else {
+        pcm = load_PCM(file, headerOnly);
+    }
     return create_sound(pcm, keepPCM);
 }
 
+void audio::clear_pcm_cache() {
+    pcmCache.clear();
+}
+
 std::unique_ptr<Sound> audio::create_sound(
     std::shared_ptr<PCM> pcm, bool keepPCM
 ) {
@@ -216,28 +278,140 @@ std::unique_ptr<Stream> audio::open_stream(
     return backend->openStream(std::move(stream), keepSource);
 }
 
+Sound::~Sound() {
+    for (const auto& [_, voice] : voices) {
+        if (voice->getSound() == this) {
+            voice->stop();
+        }
+    }
+}
+
 void audio::set_listener(
     glm::vec3 position, glm::vec3 velocity, glm::vec3 lookAt, glm::vec3 up
 ) {
+    listenerPosition = position;
     backend->setListener(position, velocity, lookAt, up);
 }
 
-void remove_lower_priority_speaker(int priority) {
-    for (auto it = speakers.begin(); it != speakers.end();) {
-        if (it->second->getPriority() < priority && it->second->isPaused()) {
-            it->second->stop();
-            it = speakers.erase(it);
-            return;
+static float get_audibility(const Voice* voice) {
+    return voice->getAudibility(
+        listenerPosition, get_channel(voice->getChannel())
+    );
+}
+
+/// @brief Voices order of importance: priority, playing before paused, gain
+static bool is_more_important(
+    const Voice* a, float aGain, const Voice* b, float bGain
+) {
+    if (a->getPriority() != b->getPriority()) {
+        return a->getPriority() > b->getPriority();
+    }
+    if (a->isPaused() != b->isPaused()) {
+        return !a->isPaused();
+    }
+    return aGain > bGain;
+}
+
+/// @brief Release source of the least important real voice
+/// having priority lower than specified
+static bool virtualize_lower_priority_voice(int priority) {
+    Voice* victim = nullptr;
+    float victimGain = 0.0f;
+    for (const auto& [_, voice] : voices) {
+        if (voice->isVirtual() || voice->getPriority() >= priority) {
+            continue;
+        }
+        float gain = get_audibility(voice);
+        if (victim == nullptr ||
+            is_more_important(victim, victimGain, voice, gain)) {
+            victim = voice;
+            victimGain = gain;
         }
-        it++;
     }
-    for (auto it = speakers.begin(); it != speakers.end();) {
-        if (it->second->getPriority() < priority) {
-            it->second->stop();
-            it = speakers.erase(it);
-            return;
+    if (victim == nullptr) {
+        return false;
+    }
+    victim->virtualize();
+    return true;
+}
+
+/// @brief Free a place for a new voice if the voices limit is reached
+/// @return false if all voices are more important than the new one
+static bool make_room_for_voice(const Voice& voice) {
+    if (voices.size() < MAX_VOICES) {
+        return true;
+    }
+    float gain = get_audibility(&voice);
+    auto victim = voices.end();
+    float victimGain = 0.0f;
+    for (auto it = voices.begin(); it != voices.end(); ++it) {
+        float itGain = get_audibility(it->second);
+        if (victim == voices.end() ||
+            is_more_important(victim->second, victimGain, it->second, itGain)) {
+            victim = it;
+            victimGain = itGain;
         }
-        it++;
+    }
+    if (!is_more_important(&voice, gain, victim->second, victimGain)) {
+        return false;
+    }
+    speakerid_t id = victim->first;
+    voices.erase(victim);
+    speakers.erase(id);
+    return true;
+}
+
+static size_t count_real_voices() {
+    size_t count = 0;
+    for (const auto& [_, voice] : voices) {
+        count += !voice->isVirtual();
+    }
+    return count;
+}
+
+/// @brief Give backend sources to the most important audible voices,
+/// virtualize the rest
+static void update_voices(double delta) {
+    struct Entry {
+        Voice* voice;
+        float gain;
+    };
+    static std::vector<Entry> entries;
+    entries.clear();
+    for (const auto& [_, voice] : voices) {
+        voice->advance(delta);
+        if (!voice->isStopped()) {
+            entries.push_back({voice, get_audibility(voice)});
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return is_more_important(a.voice, a.gain, b.voice, b.gain);
+    });
+    size_t realCount = 0;
+    // virtualizing first to make sources free
+    for (auto& entry : entries) {
+        bool audible = entry.gain >= AUDIBLE_GAIN;
+        if (!entry.voice->isVirtual()) {
+            if (audible && realCount < MAX_REAL_VOICES) {
+                realCount++;
+            } else {
+                entry.voice->virtualize();
+            }
+        }
+    }
+    for (auto& entry : entries) {
+        if (realCount >= MAX_REAL_VOICES) {
+            break;
+        }
+        auto voice = entry.voice;
+        if (!voice->isVirtual() || voice->isPaused() ||
+            entry.gain < AUDIBLE_GAIN * REALIZE_HYSTERESIS) {
+            continue;
+        }
+        if (!voice->realize()) {
+            break;
+        }
+        realCount++;
     }
 }
 
@@ -260,23 +434,34 @@ speakerid_t audio::play(
             sound = sound->variants[index].get();
         }
     }
-    auto speaker_ptr = sound->newInstance(priority, channel);
-    if (speaker_ptr == nullptr) {
-        remove_lower_priority_speaker(priority);
-        speaker_ptr = sound->newInstance(priority, channel);
+    if (!sound->streamFile.empty()) {
+        return play_stream(
+            sound->streamFile, position, relative, volume, pitch, loop, channel
+        );
     }
-    if (speaker_ptr == nullptr) {
+    if (backend->isDummy()) {
         return 0;
     }
-    auto speaker = speaker_ptr.get();
+    auto voice_ptr = std::make_unique<Voice>(sound, priority, channel);
+    auto voice = voice_ptr.get();
+    voice->setPosition(position);
+    voice->setVolume(volume);
+    voice->setPitch(pitch);
+    voice->setLoop(loop);
+    voice->setRelative(relative);
+    if (!make_room_for_voice(*voice)) {
+        return 0;
+    }
+    voice->play();
+    if (get_audibility(voice) >= AUDIBLE_GAIN &&
+        count_real_voices() < MAX_REAL_VOICES) {
+        if (!voice->realize() && virtualize_lower_priority_voice(priority)) {
+            voice->realize();
+        }
+    }
     speakerid_t id = nextId++;
-    speakers.try_emplace(id, std::move(speaker_ptr));
-    speaker->setPosition(position);
-    speaker->setVolume(volume);
-    speaker->setPitch(pitch);
-    speaker->setLoop(loop);
-    speaker->setRelative(relative);
-    speaker->play();
+    voices.try_emplace(id, voice);
+    speakers.try_emplace(id, std::move(voice_ptr));
     return id;
 }
 
@@ -290,8 +475,8 @@ speakerid_t audio::play(
     int channel
 ) {
     auto speaker_ptr = stream->createSpeaker(loop, channel);
-    if (speaker_ptr == nullptr) {
-        remove_lower_priority_speaker(PRIORITY_HIGH);
+    if (speaker_ptr == nullptr &&
+        virtualize_lower_priority_voice(PRIORITY_HIGH)) {
         speaker_ptr = stream->createSpeaker(loop, channel);
     }
     if (speaker_ptr == nullptr) {
@@ -376,6 +561,10 @@ size_t audio::count_speakers() {
     return speakers.size();
 }
 
+size_t audio::count_virtual_voices() {
+    return voices.size() - count_real_voices();
+}
+
 size_t audio::count_streams() {
     return streams.size();
 }
@@ -386,6 +575,7 @@ void audio::update(double delta) {
     for (auto& entry : streams) {
         entry.second->update(delta);
     }
+    update_voices(delta);
 
     for (auto it = speakers.begin(); it != speakers.end();) {
         auto speaker = it->second.get();
@@ -396,6 +586,7 @@ void audio::update(double delta) {
         }
         if (speaker->isStopped()) {
             streams.erase(it->first);
+            voices.erase(it->first);
             it = speakers.erase(it);
         } else {
             it++;
@@ -421,6 +612,7 @@ void audio::reset_channel(int index) {
         int speakerChannel = speaker->getChannel();
         if (speakerChannel == index) {
             streams.erase(it->first);
+            voices.erase(it->first);
             it = speakers.erase(it);
         } else {
             it++;
@@ -432,6 +624,8 @@ void audio::reset_channel(int index) {
 }
 
 void audio::close() {
+    pcmCache.clear();
+    voices.clear();
     speakers.clear();
     delete backend;
     backend = nullptr;
@@ -30,6 +30,19 @@ namespace audio {
     /// @brief Audio speaker states
     enum class State { playing, paused, stopped };
 
+    /// @brief Sound data loading modes
+    enum class SoundLoading {
+        /// @brief decode and keep decoded PCM in the shared cache, so
+        /// the next loading of the file will not decode it again
+        /// (frequently used short sounds)
+        cached,
+        /// @brief decode on each loading
+        decoded,
+        /// @brief do not load audio data, stream the file on each play
+        /// (rarely used long sounds)
+        streamed
+    };
+
     /// @brief Mixer channel controls speakers volume and effects
     /// There is main channel 'master' and sub-channels like 'regular', 'music',
     /// 'ambient'...
@@ -206,8 +219,12 @@ namespace audio {
         /// @brief Sound variants will be chosen randomly to play
         std::vector<std::shared_ptr<Sound>> variants;
 
-        virtual ~Sound() {
-        }
+        /// @brief File streamed on play if the sound audio data is not
+        /// loaded (see SoundLoading::streamed), otherwise empty
+        fs::path streamFile;
+
+        /// @brief Stops all voices of the sound
+        virtual ~Sound();
 
         /// @brief Get sound duration
         /// @return duration in seconds (>= 0.0)
@@ -369,10 +386,15 @@ namespace audio {
     /// @brief Load sound from file
     /// @param file audio file path
     /// @param keepPCM store PCM data in sound to make it accessible with
-    /// Sound::getPCM
+    /// Sound::getPCM (ignored for streamed sounds)
+    /// @param loading sound data loading mode
     /// @throws std::runtime_error if I/O error ocurred or format is unknown
     /// @return new Sound instance
-    std::unique_ptr<Sound> load_sound(const fs::path& file, bool keepPCM);
+    std::unique_ptr<Sound> load_sound(
+        const fs::path& file,
+        bool keepPCM,
+        SoundLoading loading = SoundLoading::decoded
+    );
 
     /// @brief Create new sound from PCM data
     /// @param pcm PCM data
@@ -381,6 +403,9 @@ namespace audio {
     /// @return new Sound instance
     std::unique_ptr<Sound> create_sound(std::shared_ptr<PCM> pcm, bool keepPCM);
 
+    /// @brief Release decoded PCM data kept by the shared cache
+    void clear_pcm_cache();
+
     /// @brief Open new PCM stream from file
     /// @param file audio file path
     /// @throws std::runtime_error if I/O error ocurred or format is unknown
@@ -503,9 +528,13 @@ namespace audio {
     /// @return stream or nullptr
     std::shared_ptr<Stream> get_associated_stream(speakerid_t id);
 
-    /// @brief Get alive speakers number (including paused)
+    /// @brief Get alive speakers number (including paused and virtual)
     size_t count_speakers();
 
+    /// @brief Get number of virtual (inaudible or exceeding the voices
+    /// limit) sound instances
+    size_t count_virtual_voices();
+
     /// @brief Get playing streams number (including paused)
     size_t count_streams();
 
@@ -1,6 +1,7 @@
 #include "GLSLExtension.hpp"
 
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <utility>
@@ -14,6 +15,12 @@ namespace fs = std::filesystem;
 
 void GLSLExtension::setVersion(std::string version) {
     this->version = std::move(version);
+    clearProcessed();
+}
+
+void GLSLExtension::clearProcessed() {
+    std::lock_guard lock(processedMutex);
+    processed.clear();
 }
 
 void GLSLExtension::setPaths(const ResPaths* paths) {
@@ -29,10 +36,12 @@ void GLSLExtension::loadHeader(const std::string& name) {
 
 void GLSLExtension::addHeader(const std::string& name, std::string source) {
     headers[name] = std::move(source);
+    clearProcessed();
 }
 
 void GLSLExtension::define(const std::string& name, std::string value) {
     defines[name] = std::move(value);
+    clearProcessed();
 }
 
 const std::string& GLSLExtension::getHeader(const std::string& name) const {
@@ -62,6 +71,7 @@ bool GLSLExtension::hasHeader(const std::string& name) const {
 void GLSLExtension::undefine(const std::string& name) {
     if (hasDefine(name)) {
         defines.erase(name);
+        clearProcessed();
     }
 }
 
@@ -88,6 +98,26 @@ inline void source_line(std::stringstream& ss, uint linenum) {
 
 std::string GLSLExtension::process(
     const fs::path& file, const std::string& source, bool header
+) {
+    if (header) {
+        return processSource(file, source, header);
+    }
+    std::string key = file.u8string() + '\0' + source;
+    {
+        std::lock_guard lock(processedMutex);
+        auto found = processed.find(key);
+        if (found != processed.end()) {
+            return found->second;
+        }
+    }
+    auto result = processSource(file, source, header);
+    std::lock_guard lock(processedMutex);
+    processed[std::move(key)] = result;
+    return result;
+}
+
+std::string GLSLExtension::processSource(
+    const fs::path& file, const std::string& source, bool header
 ) {
     std::stringstream ss;
     size_t pos = 0;
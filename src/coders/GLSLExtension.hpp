@@ -1,6 +1,7 @@
 #pragma once
 
 #include <filesystem>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -12,8 +13,21 @@ class GLSLExtension {
     std::unordered_map<std::string, std::string> defines;
     std::string version = "330 core";
 
+    /// @brief Processed sources by file name and source, so shaders loaded
+    /// again (content reload) skip includes expansion. Cleared when
+    /// headers, defines or version are changed
+    std::unordered_map<std::string, std::string> processed;
+    std::mutex processedMutex;
+
     const ResPaths* paths = nullptr;
     void loadHeader(const std::string& name);
+    void clearProcessed();
+
+    std::string processSource(
+        const std::filesystem::path& file,
+        const std::string& source,
+        bool header
+    );
 public:
     void setPaths(const ResPaths* paths);
     void setVersion(std::string version);
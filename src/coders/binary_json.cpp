@@ -9,19 +9,21 @@
 
 using namespace json;
 
-static void to_binary(ByteBuilder& builder, const dv::value& value) {
+/// @brief Thread scratch buffers larger than this are released after
+/// compression instead of being kept for the next call
+static constexpr size_t MAX_POOLED_BUFFER_SIZE = 4 * 1024 * 1024;
+
+static void value_to_binary(ByteBuilder& builder, const dv::value& value) {
     switch (value.getType()) {
         case dv::value_type::none:
             throw std::runtime_error("none value is not implemented");
-        case dv::value_type::object: {
-            const auto bytes = json::to_binary(value);
-            builder.put(bytes.data(), bytes.size());
+        case dv::value_type::object:
+            json::to_binary(value, builder);
             break;
-        }
         case dv::value_type::list:
             builder.put(BJSON_TYPE_LIST);
             for (const auto& element : value) {
-                to_binary(builder, element);
+                value_to_binary(builder, element);
             }
             builder.put(BJSON_END);
             break;
@@ -63,12 +65,8 @@ static void to_binary(ByteBuilder& builder, const dv::value& value) {
     }
 }
 
-std::vector<ubyte> json::to_binary(const dv::value& object, bool compress) {
-    if (compress) {
-        auto bytes = to_binary(object, false);
-        return gzip::compress(bytes.data(), bytes.size());
-    }
-    ByteBuilder builder;
+void json::to_binary(const dv::value& object, ByteBuilder& builder) {
+    size_t start = builder.size();
     // type byte
     builder.put(BJSON_TYPE_DOCUMENT);
     // document size
@@ -77,14 +75,30 @@ std::vector<ubyte> json::to_binary(const dv::value& object, bool compress) {
     // writing entries
     for (const auto& [key, value] : object.asObject()) {
         builder.putCStr(key.c_str());
-        to_binary(builder, value);
+        value_to_binary(builder, value);
     }
     // terminating byte
     builder.put(BJSON_END);
 
     // updating document size
-    builder.setInt32(1, builder.size());
-    return builder.build();
+    builder.setInt32(start + 1, builder.size() - start);
+}
+
+std::vector<ubyte> json::to_binary(const dv::value& object, bool compress) {
+    if (compress) {
+        // uncompressed bytes are only needed until compressed
+        thread_local ByteBuilder scratch;
+        scratch.clear();
+        to_binary(object, scratch);
+        auto bytes = gzip::compress(scratch.data(), scratch.size());
+        if (scratch.size() > MAX_POOLED_BUFFER_SIZE) {
+            scratch = ByteBuilder();
+        }
+        return bytes;
+    }
+    ByteBuilder builder;
+    to_binary(object, builder);
+    return builder.release();
 }
 
 static dv::value list_from_binary(ByteReader& reader);
@@ -167,3 +181,139 @@ dv::value json::from_binary(const ubyte* src, size_t size) {
         return value_from_binary(reader);
     }
 }
+
+/// @brief Move the reader to the end of the value without decoding it
+static void skip_value(ByteReader& reader) {
+    ubyte typecode = reader.get();
+    size_t length;
+    switch (typecode) {
+        case BJSON_TYPE_DOCUMENT: {
+            int32_t size = reader.getInt32();
+            // size includes the type code and the size itself
+            if (size < 5) {
+                throw std::runtime_error(
+                    "invalid document size " + std::to_string(size));
+            }
+            length = size - 5;
+            break;
+        }
+        case BJSON_TYPE_LIST:
+            while (reader.peek() != BJSON_END) {
+                skip_value(reader);
+            }
+            reader.get();
+            return;
+        case BJSON_TYPE_BYTE:
+            length = 1;
+            break;
+        case BJSON_TYPE_INT16:
+            length = 2;
+            break;
+        case BJSON_TYPE_INT32:
+            length = 4;
+            break;
+        case BJSON_TYPE_INT64:
+        case BJSON_TYPE_NUMBER:
+            length = 8;
+            break;
+        case BJSON_TYPE_FALSE:
+        case BJSON_TYPE_TRUE:
+        case BJSON_TYPE_NULL:
+            return;
+        case BJSON_TYPE_STRING:
+        case BJSON_TYPE_BYTES:
+            length = static_cast<uint32_t>(reader.getInt32());
+            break;
+        default:
+            throw std::runtime_error(
+                "type support not implemented for <" +
+                std::to_string(typecode) + ">");
+    }
+    if (length > reader.remaining()) {
+        throw std::runtime_error("buffer underflow");
+    }
+    reader.skip(length);
+}
+
+BinaryView::BinaryView(const ubyte* data, size_t size)
+    : data(data), size(size) {
+    if (size >= 2 && data[0] == gzip::MAGIC[0] && data[1] == gzip::MAGIC[1]) {
+        throw std::runtime_error("compressed data must be decompressed first");
+    }
+}
+
+int BinaryView::getType() const {
+    if (size == 0) {
+        throw std::runtime_error("buffer underflow");
+    }
+    return data[0];
+}
+
+std::optional<BinaryView> BinaryView::find(std::string_view key) const {
+    ByteReader reader(data, size);
+    if (reader.get() != BJSON_TYPE_DOCUMENT) {
+        throw std::runtime_error("document expected");
+    }
+    reader.getInt32();
+    while (reader.peek() != BJSON_END) {
+        if (key == reader.getCString()) {
+            return BinaryView(reader.pointer(), reader.remaining());
+        }
+        skip_value(reader);
+    }
+    return std::nullopt;
+}
+
+std::optional<BinaryView> BinaryView::at(size_t index) const {
+    ByteReader reader(data, size);
+    if (reader.get() != BJSON_TYPE_LIST) {
+        throw std::runtime_error("list expected");
+    }
+    for (size_t i = 0; reader.peek() != BJSON_END; i++) {
+        if (i == index) {
+            return BinaryView(reader.pointer(), reader.remaining());
+        }
+        skip_value(reader);
+    }
+    return std::nullopt;
+}
+
+size_t BinaryView::length() const {
+    ByteReader reader(data, size);
+    ubyte typecode = reader.get();
+    if (typecode == BJSON_TYPE_DOCUMENT) {
+        reader.getInt32();
+    } else if (typecode != BJSON_TYPE_LIST) {
+        throw std::runtime_error("document or list expected");
+    }
+    size_t count = 0;
+    while (reader.peek() != BJSON_END) {
+        if (typecode == BJSON_TYPE_DOCUMENT) {
+            reader.getCString();
+        }
+        skip_value(reader);
+        count++;
+    }
+    return count;
+}
+
+dv::integer_t BinaryView::asInteger() const {
+    return decode().asInteger();
+}
+
+dv::number_t BinaryView::asNumber() const {
+    return decode().asNumber();
+}
+
+bool BinaryView::asBoolean() const {
+    return decode().asBoolean();
+}
+
+std::string BinaryView::asString() const {
+    return decode().asString();
+}
+
+dv::value BinaryView::decode() const {
+    ByteReader reader(data, size);
+    return value_from_binary(reader);
+}
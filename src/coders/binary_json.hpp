@@ -1,12 +1,16 @@
 #pragma once
 
 #include <memory>
+#include <optional>
+#include <string_view>
 #include <vector>
 
 #include "data/dv.hpp"
 
 #include "typedefs.hpp"
 
+class ByteBuilder;
+
 namespace json {
     inline constexpr int BJSON_END = 0x0;
     inline constexpr int BJSON_TYPE_DOCUMENT = 0x1;
@@ -24,6 +28,47 @@ namespace json {
     inline constexpr int BJSON_TYPE_CDOCUMENT = 0x1F;
 
     std::vector<ubyte> to_binary(const dv::value& obj, bool compress = false);
+
+    /// @brief Append uncompressed document to the builder. Nested documents
+    /// are written in place, so the builder buffer may be reused between
+    /// calls to avoid allocations
+    void to_binary(const dv::value& obj, ByteBuilder& dst);
     
     dv::value from_binary(const ubyte* src, size_t size);
+
+    /// @brief Lazy read-only view of an uncompressed binary json value.
+    /// Nothing is decoded until requested: object entries and list elements
+    /// are found by skipping other values (nested documents are skipped
+    /// using their size without reading).
+    /// Does not own the data, so it must outlive the view
+    class BinaryView {
+        const ubyte* data;
+        size_t size;
+    public:
+        /// @param data encoded value starting with the type code
+        /// @param size max size of the value
+        BinaryView(const ubyte* data, size_t size);
+
+        /// @return BJSON_TYPE_* code of the value
+        int getType() const;
+
+        /// @brief Find object entry. Throws if the value is not a document
+        /// @return entry value view or std::nullopt if not found
+        std::optional<BinaryView> find(std::string_view key) const;
+
+        /// @brief Get list element. Throws if the value is not a list
+        /// @return element value view or std::nullopt if out of range
+        std::optional<BinaryView> at(size_t index) const;
+
+        /// @brief Number of object entries or list elements
+        size_t length() const;
+
+        dv::integer_t asInteger() const;
+        dv::number_t asNumber() const;
+        bool asBoolean() const;
+        std::string asString() const;
+
+        /// @brief Decode the value with all nested values
+        dv::value decode() const;
+    };
 }
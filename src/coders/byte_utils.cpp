@@ -6,6 +6,10 @@
 
 #include "util/data_io.hpp"
 
+ByteBuilder::ByteBuilder(std::vector<ubyte> buffer)
+    : buffer(std::move(buffer)) {
+}
+
 void ByteBuilder::put(ubyte b) {
     buffer.push_back(b);
 }
@@ -25,10 +29,7 @@ void ByteBuilder::put(const std::string& s) {
 }
 
 void ByteBuilder::put(const ubyte* arr, size_t size) {
-    buffer.reserve(buffer.size() + size);
-    for (size_t i = 0; i < size; i++) {
-        buffer.push_back(arr[i]);
-    }
+    buffer.insert(buffer.end(), arr, arr + size);
 }
 
 void ByteBuilder::putInt16(int16_t val) {
@@ -83,10 +84,18 @@ void ByteBuilder::setInt64(size_t position, int64_t val) {
     std::memcpy(buffer.data()+position, &val, sizeof(int64_t));
 }
 
+void ByteBuilder::clear() {
+    buffer.clear();
+}
+
 std::vector<ubyte> ByteBuilder::build() {
     return buffer;
 }
 
+std::vector<ubyte> ByteBuilder::release() {
+    return std::move(buffer);
+}
+
 ByteReader::ByteReader(const ubyte* data, size_t size)
     : data(data), size(size), pos(0) {
 }
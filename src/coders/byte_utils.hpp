@@ -8,6 +8,11 @@
 class ByteBuilder {
     std::vector<ubyte> buffer;
 public:
+    ByteBuilder() = default;
+    /// @brief Continue writing to the end of the buffer (its capacity is
+    /// reused, so a pooled buffer may be passed)
+    ByteBuilder(std::vector<ubyte> buffer);
+
     /// @brief Write one byte (8 bit unsigned integer)
     void put(ubyte b);
     /// @brief Write c-string (bytes array terminated with '\00')
@@ -40,7 +45,12 @@ public:
         return buffer.data();
     }
 
+    /// @brief Remove written bytes keeping the allocated capacity
+    void clear();
+
     std::vector<ubyte> build();
+    /// @brief Move the buffer out of the builder leaving it empty
+    std::vector<ubyte> release();
 };
 
 class ByteReader {
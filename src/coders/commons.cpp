@@ -367,38 +367,48 @@ dv::value BasicParser::parseNumber(int sign) {
 }
 
 std::string BasicParser::parseString(char quote, bool closeRequired) {
-    std::stringstream ss;
+    std::string result;
     while (hasNext()) {
+        // plain characters run is appended at once
+        size_t start = pos;
+        while (pos < source.length() && source[pos] != quote &&
+               source[pos] != '\\' && source[pos] != '\n') {
+            pos++;
+        }
+        result.append(source.data() + start, pos - start);
+        if (!hasNext()) {
+            break;
+        }
         char c = source[pos];
         if (c == quote) {
             pos++;
-            return ss.str();
+            return result;
         }
         if (c == '\\') {
             pos++;
             c = nextChar();
             if (c >= '0' && c <= '7') {
                 pos--;
-                ss << (char)parseSimpleInt(8);
+                result += static_cast<char>(parseSimpleInt(8));
                 continue;
             }
             if (c == 'u') {
                 int codepoint = parseSimpleInt(16);
                 ubyte bytes[4];
                 int size = util::encode_utf8(codepoint, bytes);
-                ss.write(reinterpret_cast<char*>(bytes), size);
+                result.append(reinterpret_cast<char*>(bytes), size);
                 continue;
             }
             switch (c) {
-                case 'n': ss << '\n'; break;
-                case 'r': ss << '\r'; break;
-                case 'b': ss << '\b'; break;
-                case 't': ss << '\t'; break;
-                case 'f': ss << '\f'; break;
-                case '\'': ss << '\''; break;
-                case '"': ss << '"'; break;
-                case '\\': ss << '\\'; break;
-                case '/': ss << '/'; break;
+                case 'n': result += '\n'; break;
+                case 'r': result += '\r'; break;
+                case 'b': result += '\b'; break;
+                case 't': result += '\t'; break;
+                case 'f': result += '\f'; break;
+                case '\'': result += '\''; break;
+                case '"': result += '"'; break;
+                case '\\': result += '\\'; break;
+                case '/': result += '/'; break;
                 case '\n': continue;
                 default:
                     throw error(
@@ -410,13 +420,13 @@ std::string BasicParser::parseString(char quote, bool closeRequired) {
         if (c == '\n' && closeRequired) {
             throw error("non-closed string literal");
         }
-        ss << c;
+        result += c;
         pos++;
     }
     if (closeRequired) {
         throw error("unexpected end");
     }
-    return ss.str();
+    return result;
 }
 
 parsing_error BasicParser::error(const std::string& message) {
@@ -1,5 +1,9 @@
 #include "compression.hpp"
 
+#include <lz4.h>
+#include <zstd.h>
+
+#include <climits>
 #include <string>
 #include <cstring>
 #include <stdexcept>
@@ -11,6 +15,8 @@
 using namespace compression;
 
 inline constexpr float BUFFER_NOCROP_THRESOLD = 0.9;
+/// @brief zstd level of cold data, decompression speed does not depend on it
+inline constexpr int ZSTD_LEVEL = 9;
 
 static util::BufferPool<ubyte> buffer_pools[] {
     {255},
@@ -27,6 +33,17 @@ static std::shared_ptr<ubyte[]> get_buffer(size_t minSize) {
     return nullptr;
 }
 
+static std::unique_ptr<ubyte[]> crop_buffer(
+    std::unique_ptr<ubyte[]> buffer, size_t bufferSize, size_t len
+) {
+    if (len < bufferSize * BUFFER_NOCROP_THRESOLD) {
+        auto cropped = std::make_unique<ubyte[]>(len);
+        std::memcpy(cropped.get(), buffer.get(), len);
+        return cropped;
+    }
+    return buffer;
+}
+
 static auto compress_rle(
     const ubyte* src,
     size_t srclen,
@@ -43,18 +60,91 @@ static auto compress_rle(
     }
     len = encodefunc(src, srclen, bytes);
     if (uptr) {
-        if (len < bufferSize * BUFFER_NOCROP_THRESOLD) {
-            auto cropped = std::make_unique<ubyte[]>(len);
-            std::memcpy(cropped.get(), uptr.get(), len);
-            return cropped;
-        }
-        return uptr;
+        return crop_buffer(std::move(uptr), bufferSize, len);
     }
     auto data = std::make_unique<ubyte[]>(len);
     std::memcpy(data.get(), bytes, len);
     return data;
 }
 
+static std::unique_ptr<ubyte[]> compress_lz4(
+    const ubyte* src, size_t srclen, size_t& len
+) {
+    if (srclen > LZ4_MAX_INPUT_SIZE) {
+        throw std::invalid_argument("too large data for LZ4");
+    }
+    int bound = LZ4_compressBound(static_cast<int>(srclen));
+    auto buffer = std::make_unique<ubyte[]>(bound);
+    int size = LZ4_compress_default(
+        reinterpret_cast<const char*>(src),
+        reinterpret_cast<char*>(buffer.get()),
+        static_cast<int>(srclen),
+        bound
+    );
+    if (size <= 0) {
+        throw std::runtime_error("LZ4 compression failed");
+    }
+    len = size;
+    return crop_buffer(std::move(buffer), bound, len);
+}
+
+static std::unique_ptr<ubyte[]> decompress_lz4(
+    const ubyte* src, size_t srclen, size_t dstlen
+) {
+    if (srclen > INT_MAX || dstlen > INT_MAX) {
+        throw std::runtime_error("too large LZ4 data");
+    }
+    auto decompressed = std::make_unique<ubyte[]>(dstlen);
+    int size = LZ4_decompress_safe(
+        reinterpret_cast<const char*>(src),
+        reinterpret_cast<char*>(decompressed.get()),
+        static_cast<int>(srclen),
+        static_cast<int>(dstlen)
+    );
+    if (size < 0) {
+        throw std::runtime_error("invalid LZ4 data");
+    }
+    if (static_cast<size_t>(size) != dstlen) {
+        throw std::runtime_error(
+            "expected decompressed size " + std::to_string(dstlen) +
+            " got " + std::to_string(size));
+    }
+    return decompressed;
+}
+
+static std::unique_ptr<ubyte[]> compress_zstd(
+    const ubyte* src, size_t srclen, size_t& len
+) {
+    size_t bound = ZSTD_compressBound(srclen);
+    auto buffer = std::make_unique<ubyte[]>(bound);
+    size_t size = ZSTD_compress(buffer.get(), bound, src, srclen, ZSTD_LEVEL);
+    if (ZSTD_isError(size)) {
+        throw std::runtime_error(
+            std::string("zstd compression failed: ") + ZSTD_getErrorName(size)
+        );
+    }
+    len = size;
+    return crop_buffer(std::move(buffer), bound, len);
+}
+
+static std::unique_ptr<ubyte[]> decompress_zstd(
+    const ubyte* src, size_t srclen, size_t dstlen
+) {
+    auto decompressed = std::make_unique<ubyte[]>(dstlen);
+    size_t size = ZSTD_decompress(decompressed.get(), dstlen, src, srclen);
+    if (ZSTD_isError(size)) {
+        throw std::runtime_error(
+            std::string("invalid zstd data: ") + ZSTD_getErrorName(size)
+        );
+    }
+    if (size != dstlen) {
+        throw std::runtime_error(
+            "expected decompressed size " + std::to_string(dstlen) +
+            " got " + std::to_string(size));
+    }
+    return decompressed;
+}
+
 std::unique_ptr<ubyte[]> compression::compress(
     const ubyte* src, size_t srclen, size_t& len, Method method
 ) {
@@ -72,6 +162,10 @@ std::unique_ptr<ubyte[]> compression::compress(
             len = buffer.size();
             return data;
         }
+        case Method::LZ4:
+            return compress_lz4(src, srclen, len);
+        case Method::ZSTD:
+            return compress_zstd(src, srclen, len);
         default:
             throw std::runtime_error("not implemented");
     }
@@ -85,12 +179,14 @@ std::unique_ptr<ubyte[]> compression::decompress(
             throw std::invalid_argument("compression method is NONE");
         case Method::EXTRLE8: {
             auto decompressed = std::make_unique<ubyte[]>(dstlen);
-            extrle::decode(src, srclen, decompressed.get());
+            extrle::decode_checked(src, srclen, decompressed.get(), dstlen);
             return decompressed;
         }
         case Method::EXTRLE16: {
             auto decompressed = std::make_unique<ubyte[]>(dstlen);
-            size_t decoded = extrle::decode16(src, srclen, decompressed.get());
+            size_t decoded = extrle::decode16_checked(
+                src, srclen, decompressed.get(), dstlen
+            );
             if (decoded != dstlen) {
                 throw std::runtime_error(
                     "expected decompressed size " + std::to_string(dstlen) +
@@ -109,6 +205,10 @@ std::unique_ptr<ubyte[]> compression::decompress(
             std::memcpy(decompressed.get(), buffer.data(), buffer.size());
             return decompressed;
         }
+        case Method::LZ4:
+            return decompress_lz4(src, srclen, dstlen);
+        case Method::ZSTD:
+            return decompress_zstd(src, srclen, dstlen);
         default:
             throw std::runtime_error("not implemented");
     }
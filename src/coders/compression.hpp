@@ -5,8 +5,9 @@
 #include "typedefs.hpp"
 
 namespace compression {
+    /// @brief Compression methods. Values are stored in region files
     enum class Method {
-        NONE, EXTRLE8, EXTRLE16, GZIP
+        NONE, EXTRLE8, EXTRLE16, GZIP, LZ4, ZSTD
     };
 
     /// @brief Compress buffer
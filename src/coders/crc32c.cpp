@@ -0,0 +1,127 @@
+#include "crc32c.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CRC32C_SSE42
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__ARM_FEATURE_CRC32)
+#define CRC32C_ARM
+#include <arm_acle.h>
+#endif
+
+#if defined(CRC32C_SSE42) && !defined(_MSC_VER)
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#else
+#define CRC32C_TARGET
+#endif
+
+/// @brief Reversed Castagnoli polynomial
+static constexpr uint32_t POLYNOMIAL = 0x82F63B78;
+
+using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+/// @brief Slicing-by-8 tables
+static constexpr Tables make_tables() {
+    Tables tables {};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (POLYNOMIAL & (0U - (crc & 1)));
+        }
+        tables[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (size_t t = 1; t < tables.size(); t++) {
+            uint32_t prev = tables[t - 1][i];
+            tables[t][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+        }
+    }
+    return tables;
+}
+
+static constexpr Tables tables = make_tables();
+
+static uint32_t update_table(uint32_t crc, const ubyte* data, size_t size) {
+    for (; size >= 8; size -= 8, data += 8) {
+        uint32_t lo = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) |
+                             (static_cast<uint32_t>(data[3]) << 24));
+        crc = tables[7][lo & 0xFF] ^ tables[6][(lo >> 8) & 0xFF] ^
+              tables[5][(lo >> 16) & 0xFF] ^ tables[4][lo >> 24] ^
+              tables[3][data[4]] ^ tables[2][data[5]] ^
+              tables[1][data[6]] ^ tables[0][data[7]];
+    }
+    for (; size; size--, data++) {
+        crc = (crc >> 8) ^ tables[0][(crc ^ *data) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(CRC32C_SSE42)
+CRC32C_TARGET static uint32_t update_hw(
+    uint32_t crc, const ubyte* data, size_t size
+) {
+    uint64_t crc64 = crc;
+    for (; size >= 8; size -= 8, data += 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<uint32_t>(crc64);
+    for (; size; size--, data++) {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+
+static bool is_hw_supported() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] >> 20) & 1;
+#else
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#elif defined(CRC32C_ARM)
+static uint32_t update_hw(uint32_t crc, const ubyte* data, size_t size) {
+    for (; size >= 8; size -= 8, data += 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        crc = __crc32cd(crc, word);
+    }
+    for (; size; size--, data++) {
+        crc = __crc32cb(crc, *data);
+    }
+    return crc;
+}
+
+static bool is_hw_supported() {
+    return true;
+}
+#endif
+
+using update_func = uint32_t (*)(uint32_t, const ubyte*, size_t);
+
+static update_func select_update() {
+#if defined(CRC32C_SSE42) || defined(CRC32C_ARM)
+    if (is_hw_supported()) {
+        return update_hw;
+    }
+#endif
+    return update_table;
+}
+
+static const update_func update_impl = select_update();
+
+uint32_t crc32c::update(uint32_t crc, const ubyte* data, size_t size) {
+    return ~update_impl(~crc, data, size);
+}
+
+bool crc32c::is_accelerated() {
+    return update_impl != update_table;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "typedefs.hpp"
+
+/// @brief CRC32C (Castagnoli) checksums. Uses SSE4.2 or ARMv8 CRC
+/// instructions if available, falls back to the table implementation
+namespace crc32c {
+    /// @brief Continue checksum calculation
+    /// @param crc checksum of the previous data (0 at start)
+    /// @param data next data block
+    /// @param size data block size
+    /// @return checksum of all the data
+    uint32_t update(uint32_t crc, const ubyte* data, size_t size);
+
+    inline uint32_t compute(const ubyte* data, size_t size) {
+        return update(0, data, size);
+    }
+
+    /// @brief Check if hardware instructions are used
+    bool is_accelerated();
+}
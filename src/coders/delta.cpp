@@ -0,0 +1,67 @@
+#include "delta.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "rle.hpp"
+#include "util/Buffer.hpp"
+#include "util/data_io.hpp"
+
+std::vector<ubyte> delta::encode(
+    const ubyte* prev, const ubyte* next, size_t length
+) {
+    util::Buffer<ubyte> diff(length);
+    for (size_t i = 0; i < length; i++) {
+        diff[i] = prev[i] ^ next[i];
+    }
+    uint32_t header = dataio::h2le(static_cast<uint32_t>(length));
+    // extrle encoded size is at most twice as large as the source
+    std::vector<ubyte> dst(sizeof(header) + length * 2);
+    std::memcpy(dst.data(), &header, sizeof(header));
+    size_t size = extrle::encode(
+        diff.data(), length, dst.data() + sizeof(header)
+    );
+    dst.resize(sizeof(header) + size);
+    return dst;
+}
+
+void delta::apply(
+    ubyte* data, size_t length, const ubyte* delta, size_t deltaSize
+) {
+    uint32_t header;
+    if (deltaSize < sizeof(header)) {
+        throw std::runtime_error("invalid delta");
+    }
+    std::memcpy(&header, delta, sizeof(header));
+    if (dataio::le2h(header) != length) {
+        throw std::runtime_error(
+            "delta length mismatch: " + std::to_string(dataio::le2h(header)) +
+            " != " + std::to_string(length)
+        );
+    }
+    // extrle decoding with bounds checks, XOR-ing runs into the data
+    size_t offset = 0;
+    for (size_t i = sizeof(header); i < deltaSize;) {
+        uint run = delta[i++];
+        if (run & 0x80) {
+            if (i >= deltaSize) {
+                throw std::runtime_error("invalid delta");
+            }
+            run = (run & 0x7F) | (static_cast<uint>(delta[i++]) << 7);
+        }
+        run++;
+        if (i >= deltaSize || offset + run > length) {
+            throw std::runtime_error("invalid delta");
+        }
+        ubyte value = delta[i++];
+        if (value) {
+            for (uint j = 0; j < run; j++) {
+                data[offset + j] ^= value;
+            }
+        }
+        offset += run;
+    }
+    if (offset != length) {
+        throw std::runtime_error("invalid delta");
+    }
+}
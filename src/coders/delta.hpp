@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+
+#include "typedefs.hpp"
+
+/// @brief Compact difference between two versions of equal size data:
+/// uint32 little-endian data length followed by extrle-encoded XOR of
+/// the versions (unchanged bytes turn into long zero runs)
+namespace delta {
+    /// @brief Encode difference between two versions of data
+    /// @param prev previous version
+    /// @param next new version
+    /// @param length length of both versions
+    std::vector<ubyte> encode(
+        const ubyte* prev, const ubyte* next, size_t length
+    );
+
+    /// @brief Turn the previous version of data into the new one
+    /// @param data previous version to be modified
+    /// @param length data length
+    /// @throws std::runtime_error - delta is invalid or was encoded for
+    /// data of different length
+    void apply(
+        ubyte* data, size_t length, const ubyte* delta, size_t deltaSize
+    );
+}
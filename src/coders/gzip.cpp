@@ -1,14 +1,29 @@
 #include "gzip.hpp"
 
 #include "byte_utils.hpp"
+#include "util/TaskScheduler.hpp"
 
 #define ZLIB_CONST
 #include <math.h>
 #include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 
-std::vector<ubyte> gzip::compress(const ubyte* src, size_t size) {
+/// @brief Input size from which data is split into blocks deflated
+/// in parallel, smaller inputs are compressed by a single zlib stream
+static constexpr size_t PARALLEL_MIN_SIZE = 512 * 1024;
+/// @brief Input block size of the parallel compression
+static constexpr size_t PARALLEL_BLOCK_SIZE = 128 * 1024;
+/// @brief Block tail used as the next block dictionary (deflate window)
+static constexpr size_t DICTIONARY_SIZE = 32 * 1024;
+
+static std::vector<ubyte> compress_stream(const ubyte* src, size_t size) {
     size_t buffer_size = 23 + size * 1.01;
     std::vector<ubyte> buffer;
     buffer.resize(buffer_size);
@@ -40,10 +55,166 @@ std::vector<ubyte> gzip::compress(const ubyte* src, size_t size) {
     return buffer;
 }
 
-std::vector<ubyte> gzip::decompress(const ubyte* src, size_t size) {
+namespace {
+    /// @brief Raw deflate block of the parallel compression and its CRC-32
+    struct DeflateBlock {
+        std::vector<ubyte> data;
+        uLong crc;
+    };
+
+    /// @brief Blocks shared by the calling thread and the helper tasks
+    struct ParallelDeflate {
+        const ubyte* src;
+        size_t size;
+        std::vector<DeflateBlock> blocks;
+        /// @brief Index of the next block to be taken
+        std::atomic<size_t> next = 0;
+        /// @brief Number of finished blocks
+        size_t done = 0;
+        std::mutex mutex;
+        std::condition_variable condition;
+
+        ParallelDeflate(const ubyte* src, size_t size, size_t count)
+            : src(src), size(size), blocks(count) {
+        }
+
+        /// @brief Deflate the block, so the block ends at byte boundary
+        /// and is continued by the next block in the stream. Previous
+        /// input bytes are used as the dictionary, so ratio stays close
+        /// to a single stream
+        void deflateBlock(size_t index) {
+            size_t offset = index * PARALLEL_BLOCK_SIZE;
+            size_t length = std::min(PARALLEL_BLOCK_SIZE, size - offset);
+            bool last = index + 1 == blocks.size();
+
+            z_stream stream {};
+            deflateInit2(
+                &stream,
+                Z_DEFAULT_COMPRESSION,
+                Z_DEFLATED,
+                -MAX_WBITS,
+                8,
+                Z_DEFAULT_STRATEGY
+            );
+            if (index > 0) {
+                size_t dictionary = std::min(DICTIONARY_SIZE, offset);
+                deflateSetDictionary(
+                    &stream, src + offset - dictionary, dictionary
+                );
+            }
+            auto& block = blocks[index];
+            // sync flush marker is not included to the bound
+            block.data.resize(deflateBound(&stream, length) + 16);
+            stream.next_in = src + offset;
+            stream.avail_in = length;
+            stream.next_out = block.data.data();
+            stream.avail_out = block.data.size();
+            deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+            block.data.resize(stream.next_out - block.data.data());
+            deflateEnd(&stream);
+            block.crc = crc32(0, src + offset, length);
+        }
+
+        /// @brief Deflate blocks until all of them are taken
+        void run() {
+            size_t index;
+            while ((index = next++) < blocks.size()) {
+                deflateBlock(index);
+                std::lock_guard lock(mutex);
+                if (++done == blocks.size()) {
+                    condition.notify_all();
+                }
+            }
+        }
+    };
+}
+
+/// @brief pigz-like compression: the calling thread and scheduler tasks
+/// deflate input blocks joined into a single gzip member, readable by
+/// standard gzip decoders
+static std::vector<ubyte> compress_parallel(
+    const ubyte* src, size_t size, uint threads
+) {
+    size_t count = (size + PARALLEL_BLOCK_SIZE - 1) / PARALLEL_BLOCK_SIZE;
+    auto state = std::make_shared<ParallelDeflate>(src, size, count);
+    auto& scheduler = util::TaskScheduler::getDefault();
+    size_t helpers = std::min<size_t>(threads, count - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        // helpers started after all blocks are taken exit immediately
+        scheduler.submit(
+            [state]() { state->run(); },
+            util::TaskScheduler::Priority::NORMAL
+        );
+    }
+    // the caller takes blocks too, so it never waits for queued tasks
+    // (may be called from a scheduler thread)
+    state->run();
+    {
+        std::unique_lock lock(state->mutex);
+        state->condition.wait(lock, [&state]() {
+            return state->done == state->blocks.size();
+        });
+    }
+
+    static const ubyte HEADER[] {
+        0x1F, 0x8B, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 3
+    };
+    size_t total = sizeof(HEADER) + 8;
+    for (const auto& block : state->blocks) {
+        total += block.data.size();
+    }
+    std::vector<ubyte> buffer;
+    buffer.reserve(total);
+    buffer.insert(buffer.end(), std::begin(HEADER), std::end(HEADER));
+    uLong crc = crc32(0, Z_NULL, 0);
+    size_t offset = 0;
+    for (const auto& block : state->blocks) {
+        buffer.insert(buffer.end(), block.data.begin(), block.data.end());
+        size_t length = std::min(PARALLEL_BLOCK_SIZE, size - offset);
+        crc = crc32_combine(crc, block.crc, length);
+        offset += length;
+    }
+    // trailer: CRC-32 and input size modulo 2^32, little-endian
+    uint32_t trailer[] {
+        static_cast<uint32_t>(crc), static_cast<uint32_t>(size)
+    };
+    for (uint32_t value : trailer) {
+        for (int i = 0; i < 4; i++) {
+            buffer.push_back((value >> (i * 8)) & 0xFF);
+        }
+    }
+    return buffer;
+}
+
+std::vector<ubyte> gzip::compress(const ubyte* src, size_t size) {
+    if (size < PARALLEL_MIN_SIZE) {
+        return compress_stream(src, size);
+    }
+    return compress_parallel(
+        src, size, util::TaskScheduler::getDefault().getThreadsCount()
+    );
+}
+
+/// @brief Gzip header and footer length
+static constexpr size_t MIN_GZIP_SIZE = 18;
+
+std::vector<ubyte> gzip::decompress(
+    const ubyte* src, size_t size, size_t maxSize
+) {
+    if (size < MIN_GZIP_SIZE) {
+        throw std::runtime_error("invalid gzip data");
+    }
     // getting uncompressed data length from gzip footer
-    size_t decompressed_size =
-        *reinterpret_cast<const uint32_t*>(src + size - 4);
+    const ubyte* footer = src + size - 4;
+    size_t decompressed_size = footer[0] | (footer[1] << 8) |
+                               (footer[2] << 16) |
+                               (static_cast<uint32_t>(footer[3]) << 24);
+    if (decompressed_size > maxSize) {
+        throw std::runtime_error(
+            "gzip data is too large (" + std::to_string(decompressed_size) +
+            " bytes)"
+        );
+    }
     std::vector<ubyte> buffer;
     buffer.resize(decompressed_size);
 
@@ -57,9 +228,14 @@ std::vector<ubyte> gzip::decompress(const ubyte* src, size_t size) {
     infstream.avail_out = decompressed_size;
     infstream.next_out = buffer.data();
 
-    inflateInit2(&infstream, 16 + MAX_WBITS);
-    inflate(&infstream, Z_NO_FLUSH);
+    if (inflateInit2(&infstream, 16 + MAX_WBITS) != Z_OK) {
+        throw std::runtime_error("inflateInit2 failed");
+    }
+    int status = inflate(&infstream, Z_FINISH);
+    size_t written = infstream.next_out - buffer.data();
     inflateEnd(&infstream);
-
+    if (status != Z_STREAM_END || written != decompressed_size) {
+        throw std::runtime_error("invalid gzip data");
+    }
     return buffer;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include "typedefs.hpp"
@@ -7,13 +8,18 @@
 namespace gzip {
     const unsigned char MAGIC[] = "\x1F\x8B";
 
-    /* Compress bytes array to GZIP format
+    /* Compress bytes array to GZIP format. Large arrays are split into
+     blocks deflated in parallel by the default tasks scheduler threads
      @param src source bytes array
      @param size length of source bytes array */
     std::vector<ubyte> compress(const ubyte* src, size_t size);
 
     /* Decompress bytes array from GZIP
      @param src GZIP data
-     @param size length of GZIP data */
-    std::vector<ubyte> decompress(const ubyte* src, size_t size);
+     @param size length of GZIP data
+     @param maxSize max decompressed data length (untrusted input)
+     @throws std::runtime_error on invalid data or too large output */
+    std::vector<ubyte> decompress(
+        const ubyte* src, size_t size, size_t maxSize = SIZE_MAX
+    );
 }
@@ -41,14 +41,23 @@ std::unique_ptr<ImageData> imageio::read(const fs::path& filename) {
             "file format is not supported (read): " + filename.u8string()
         );
     }
-    auto bytes = files::read_bytes_buffer(filename);
-    try {
-        return std::unique_ptr<ImageData>(found->second(bytes.data(), bytes.size()));
-    } catch (const std::runtime_error& err) {
-        throw std::runtime_error(
-            "could not to load image " + filename.u8string() + ": " + err.what()
-        );
+    auto decode = [&](const ubyte* bytes, size_t size) {
+        try {
+            return found->second(bytes, size);
+        } catch (const std::runtime_error& err) {
+            throw std::runtime_error(
+                "could not to load image " + filename.u8string() + ": " +
+                err.what()
+            );
+        }
+    };
+    // decoding directly from the mapped file, without reading it to memory
+    if (files::mmfile::is_supported() && fs::file_size(filename) > 0) {
+        files::mmfile file(filename);
+        return decode(file.data(), file.length());
     }
+    auto bytes = files::read_bytes_buffer(filename);
+    return decode(bytes.data(), bytes.size());
 }
 
 void imageio::write(const std::string& filename, const ImageData* image) {
@@ -187,7 +187,7 @@ dv::value Parser::parseObject() {
             throw error("':' expected");
         }
         pos++;
-        object[key] = parseValue();
+        object[std::move(key)] = parseValue();
         next = peek();
         if (next == ',') {
             pos++;
@@ -3,10 +3,13 @@
 #include <vorbis/codec.h>
 #include <vorbis/vorbisfile.h>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "audio/audio.hpp"
 #include "debug/Logger.hpp"
+#include "files/files.hpp"
 #include "typedefs.hpp"
 
 static debug::Logger logger("ogg");
@@ -42,12 +45,67 @@ static inline std::string vorbis_error_message(int code) {
     }
 }
 
+/// @brief Vorbis data source reading a memory-mapped file
+struct MappedSource {
+    files::mmfile file;
+    size_t offset = 0;
+
+    MappedSource(const fs::path& path) : file(path) {
+    }
+};
+
+static size_t mapped_read(void* dst, size_t size, size_t count, void* ptr) {
+    auto& source = *reinterpret_cast<MappedSource*>(ptr);
+    size_t available = source.file.length() - source.offset;
+    size_t bytes = std::min(size * count, available);
+    std::memcpy(dst, source.file.data() + source.offset, bytes);
+    source.offset += bytes;
+    return size ? bytes / size : 0;
+}
+
+static int mapped_seek(void* ptr, ogg_int64_t offset, int whence) {
+    auto& source = *reinterpret_cast<MappedSource*>(ptr);
+    ogg_int64_t position;
+    switch (whence) {
+        case SEEK_SET: position = offset; break;
+        case SEEK_CUR: position = source.offset + offset; break;
+        case SEEK_END: position = source.file.length() + offset; break;
+        default: return -1;
+    }
+    if (position < 0 ||
+        position > static_cast<ogg_int64_t>(source.file.length())) {
+        return -1;
+    }
+    source.offset = position;
+    return 0;
+}
+
+static long mapped_tell(void* ptr) {
+    return reinterpret_cast<MappedSource*>(ptr)->offset;
+}
+
+/// @brief Open file memory-mapped if supported
+/// @param source mapped source, must outlive vf
+static int open_vorbis(
+    const fs::path& file,
+    OggVorbis_File& vf,
+    std::unique_ptr<MappedSource>& source
+) {
+    if (!files::mmfile::is_supported() || fs::file_size(file) == 0) {
+        return ov_fopen(file.u8string().c_str(), &vf);
+    }
+    source = std::make_unique<MappedSource>(file);
+    ov_callbacks callbacks {mapped_read, mapped_seek, nullptr, mapped_tell};
+    return ov_open_callbacks(source.get(), &vf, nullptr, 0, callbacks);
+}
+
 std::unique_ptr<audio::PCM> ogg::load_pcm(
     const fs::path& file, bool headerOnly
 ) {
     OggVorbis_File vf;
+    std::unique_ptr<MappedSource> source;
     int code;
-    if ((code = ov_fopen(file.u8string().c_str(), &vf))) {
+    if ((code = open_vorbis(file, vf, source))) {
         throw std::runtime_error("vorbis: " + vorbis_error_message(code));
     }
     std::vector<char> data;
@@ -59,24 +117,36 @@ std::unique_ptr<audio::PCM> ogg::load_pcm(
     size_t totalSamples = seekable ? ov_pcm_total(&vf, -1) : 0;
 
     if (!headerOnly) {
-        const int bufferSize = 4096;
+        const size_t chunkSize = 4096;
         int section = 0;
-        char buffer[bufferSize];
+        size_t size = 0;
+        // the final size is known for seekable sources, so samples are
+        // decoded directly to the result buffer without reallocations
+        size_t expected = seekable ? totalSamples * channels * 2 : 0;
+        data.resize(expected ? expected : chunkSize);
 
         bool eof = false;
         while (!eof) {
-            long ret = ov_read(&vf, buffer, bufferSize, 0, 2, true, &section);
+            if (size == data.size()) {
+                if (size == expected) {
+                    break;
+                }
+                data.resize(size * 2);
+            }
+            int toread = std::min(chunkSize, data.size() - size);
+            long ret = ov_read(
+                &vf, data.data() + size, toread, 0, 2, true, &section
+            );
             if (ret == 0) {
                 eof = true;
             } else if (ret < 0) {
                 logger.error()
                     << "ogg::load_pcm: " << vorbis_error_message(ret);
             } else {
-                data.insert(
-                    data.end(), std::begin(buffer), std::begin(buffer) + ret
-                );
+                size += ret;
             }
         }
+        data.resize(size);
         totalSamples = data.size() / channels / 2;
     }
     ov_clear(&vf);
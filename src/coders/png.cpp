@@ -1,95 +1,291 @@
 #include "png.hpp"
 
 #include <png.h>
+#include <zlib.h>
 #include <GL/glew.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "debug/Logger.hpp"
 #include "files/files.hpp"
 #include "graphics/core/GLTexture.hpp"
 #include "graphics/core/ImageData.hpp"
+#include "util/data_io.hpp"
 
 static debug::Logger logger("png-coder");
 
-// returns 0 if all-right, 1 otherwise
-static int png_write(
-    const char* filename, uint width, uint height, const ubyte* data, bool alpha
+/// @brief Min size of filtered rows compressed by one thread
+static constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+/// @brief Deflate window size. Every chunk is compressed with the previous
+/// chunk tail as a dictionary, so chunks compress almost as well as
+/// a single stream
+static constexpr size_t DICTIONARY_SIZE = 32768;
+/// @brief Max IDAT chunk data size
+static constexpr size_t MAX_IDAT_SIZE = 1024 * 1024;
+
+static constexpr ubyte PNG_SIGNATURE[] {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+/// @brief Call func(index) for indices in [0, count) on worker threads
+/// (the calling thread too). The first exception is rethrown
+template <typename Func>
+static void parallel_for(size_t count, uint threads, const Func& func) {
+    std::atomic<size_t> next = 0;
+    std::mutex mutex;
+    std::exception_ptr error;
+    auto worker = [&]() {
+        try {
+            size_t index;
+            while ((index = next++) < count) {
+                func(index);
+            }
+        } catch (...) {
+            std::lock_guard lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next = count;
+        }
+    };
+    std::vector<std::thread> workers;
+    for (uint i = 1; i < std::min<size_t>(threads, count); i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+static inline int paeth_predictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+/// @brief Filter image row choosing the filter type with the least sum
+/// of absolute differences (the libpng heuristic)
+/// @param prev previous row or nullptr for the first row
+/// @param dst filter type byte and rowBytes filtered bytes
+static void filter_row(
+    const ubyte* row, const ubyte* prev, uint rowBytes, uint pixsize, ubyte* dst
 ) {
-    uint pixsize = alpha ? 4 : 3;
+    static thread_local std::vector<ubyte> candidates;
+    candidates.resize(rowBytes * 5);
+    uint bestSum = UINT32_MAX;
+    int best = 0;
+    for (int type = 0; type < 5; type++) {
+        ubyte* out = candidates.data() + type * rowBytes;
+        uint sum = 0;
+        for (uint i = 0; i < rowBytes; i++) {
+            int a = i >= pixsize ? row[i - pixsize] : 0;
+            int b = prev ? prev[i] : 0;
+            int c = prev && i >= pixsize ? prev[i - pixsize] : 0;
+            int predicted;
+            switch (type) {
+                case 1: predicted = a; break;
+                case 2: predicted = b; break;
+                case 3: predicted = (a + b) / 2; break;
+                case 4: predicted = paeth_predictor(a, b, c); break;
+                default: predicted = 0; break;
+            }
+            ubyte value = row[i] - predicted;
+            out[i] = value;
+            sum += value < 128 ? value : 256 - value;
+        }
+        if (sum < bestSum) {
+            bestSum = sum;
+            best = type;
+        }
+    }
+    dst[0] = best;
+    std::copy(
+        candidates.data() + best * rowBytes,
+        candidates.data() + (best + 1) * rowBytes,
+        dst + 1
+    );
+}
 
-    // Open file for writing (binary mode)
-    FILE* fp = fopen(filename, "wb");
-    if (fp == nullptr) {
-        logger.error() << "could not open file " << filename << " for writing";
-        return 1;
+/// @brief Compress data as raw deflate blocks. Not last chunks are ended
+/// with a sync flush so the outputs may be concatenated
+static std::vector<ubyte> deflate_chunk(
+    const ubyte* data,
+    size_t size,
+    const ubyte* dictionary,
+    size_t dictionarySize,
+    bool last
+) {
+    z_stream stream {};
+    if (deflateInit2(
+            &stream,
+            Z_DEFAULT_COMPRESSION,
+            Z_DEFLATED,
+            -MAX_WBITS,
+            8,
+            Z_DEFAULT_STRATEGY
+        ) != Z_OK) {
+        throw std::runtime_error("could not initialize deflate");
+    }
+    if (dictionarySize) {
+        deflateSetDictionary(&stream, dictionary, dictionarySize);
     }
+    std::vector<ubyte> output(deflateBound(&stream, size) + 16);
+    stream.next_in = const_cast<ubyte*>(data);
+    stream.avail_in = size;
+    stream.next_out = output.data();
+    stream.avail_out = output.size();
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    while (true) {
+        int status = deflate(&stream, flush);
+        if (status == Z_STREAM_ERROR) {
+            deflateEnd(&stream);
+            throw std::runtime_error("deflate failed");
+        }
+        if (last ? status == Z_STREAM_END
+                 : stream.avail_in == 0 && stream.avail_out > 0) {
+            break;
+        }
+        size_t written = output.size() - stream.avail_out;
+        output.resize(output.size() * 2);
+        stream.next_out = output.data() + written;
+        stream.avail_out = output.size() - written;
+    }
+    output.resize(output.size() - stream.avail_out);
+    deflateEnd(&stream);
+    return output;
+}
 
-    // Initialize write structure
-    png_structp png_ptr = png_create_write_struct(
-        PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr
+static void put_chunk(
+    std::vector<ubyte>& dst, const char* type, const ubyte* data, size_t size
+) {
+    size_t offset = dst.size();
+    dst.resize(offset + size + 12);
+    dataio::write_int32_big(size, dst.data(), offset);
+    std::memcpy(dst.data() + offset + 4, type, 4);
+    if (size) {
+        std::memcpy(dst.data() + offset + 8, data, size);
+    }
+    uLong crc = crc32(0L, dst.data() + offset + 4, size + 4);
+    dataio::write_int32_big(crc, dst.data(), offset + 8 + size);
+}
+
+std::vector<ubyte> png::encode_image(const ImageData& image, uint threads) {
+    if (image.getFormat() != ImageFormat::rgb888 &&
+        image.getFormat() != ImageFormat::rgba8888) {
+        throw std::runtime_error("unsupported image format");
+    }
+    bool alpha = image.getFormat() == ImageFormat::rgba8888;
+    uint pixsize = alpha ? 4 : 3;
+    uint width = image.getWidth();
+    uint height = image.getHeight();
+    uint rowBytes = width * pixsize;
+    const ubyte* data = image.getData();
+
+    size_t filteredRow = rowBytes + 1;
+    uint chunkRows = std::max<size_t>(
+        1, (MIN_CHUNK_SIZE + filteredRow - 1) / filteredRow
     );
-    if (png_ptr == nullptr) {
-        logger.error() << "could not allocate write struct";
-        fclose(fp);
-        return 1;
-    }
-
-    // Initialize info structure
-    png_infop info_ptr = png_create_info_struct(png_ptr);
-    if (info_ptr == nullptr) {
-        logger.error() << "could not allocate info struct";
-        fclose(fp);
-        png_free_data(png_ptr, info_ptr, PNG_FREE_ALL, -1);
-        png_destroy_write_struct(&png_ptr, (png_infopp) nullptr);
-        return 1;
-    }
-
-    // Setup Exception handling
-    if (setjmp(png_jmpbuf(png_ptr))) {
-        logger.error() << "error during png creation";
-        fclose(fp);
-        png_free_data(png_ptr, info_ptr, PNG_FREE_ALL, -1);
-        png_destroy_write_struct(&png_ptr, &info_ptr);
-        return 1;
-    }
-
-    png_init_io(png_ptr, fp);
-
-    // Write header (8 bit colour depth)
-    png_set_IHDR(
-        png_ptr,
-        info_ptr,
-        width,
-        height,
-        8,
-        alpha ? PNG_COLOR_TYPE_RGBA : PNG_COLOR_TYPE_RGB,
-        PNG_INTERLACE_NONE,
-        PNG_COMPRESSION_TYPE_BASE,
-        PNG_FILTER_TYPE_BASE
+    chunkRows = std::max(
+        chunkRows, (height + std::max(threads, 1U) - 1) / std::max(threads, 1U)
     );
+    size_t chunksCount = (height + chunkRows - 1) / chunkRows;
 
-    png_write_info(png_ptr, info_ptr);
+    // filtered bytes range of the chunk
+    auto range = [=](size_t index) {
+        return std::make_pair(
+            index * chunkRows * filteredRow,
+            std::min<size_t>(height, (index + 1) * chunkRows) * filteredRow
+        );
+    };
 
-    auto row = std::make_unique<png_byte[]>(pixsize * width);
-    // Write image data
-    for (uint y = 0; y < height; y++) {
-        for (uint x = 0; x < width; x++) {
-            for (uint i = 0; i < pixsize; i++) {
-                row[x * pixsize + i] =
-                    (png_byte)data[(y * width + x) * pixsize + i];
-            }
+    std::vector<ubyte> filtered(filteredRow * height);
+    std::vector<std::vector<ubyte>> compressed(
+        std::max<size_t>(chunksCount, 1)
+    );
+    std::vector<uLong> checksums(compressed.size(), adler32(0L, nullptr, 0));
+    parallel_for(chunksCount, threads, [&](size_t index) {
+        uint begin = index * chunkRows;
+        uint end = std::min(height, begin + chunkRows);
+        for (uint y = begin; y < end; y++) {
+            filter_row(
+                data + y * rowBytes,
+                y ? data + (y - 1) * rowBytes : nullptr,
+                rowBytes,
+                pixsize,
+                filtered.data() + y * filteredRow
+            );
         }
-        png_write_row(png_ptr, row.get());
+    });
+    parallel_for(chunksCount, threads, [&](size_t index) {
+        auto [begin, end] = range(index);
+        size_t dictionarySize = std::min(begin, DICTIONARY_SIZE);
+        compressed[index] = deflate_chunk(
+            filtered.data() + begin,
+            end - begin,
+            filtered.data() + begin - dictionarySize,
+            dictionarySize,
+            index + 1 == chunksCount
+        );
+        checksums[index] = adler32(
+            checksums[index], filtered.data() + begin, end - begin
+        );
+    });
+    if (chunksCount == 0) {
+        compressed[0] = deflate_chunk(nullptr, 0, nullptr, 0, true);
     }
 
-    // End write
-    png_write_end(png_ptr, nullptr);
+    // zlib stream: header, deflate blocks, big-endian adler32
+    std::vector<ubyte> stream {0x78, 0x9C};
+    uLong checksum = checksums[0];
+    for (size_t i = 0; i < compressed.size(); i++) {
+        stream.insert(stream.end(), compressed[i].begin(), compressed[i].end());
+        if (i > 0) {
+            auto [begin, end] = range(i);
+            checksum = adler32_combine(checksum, checksums[i], end - begin);
+        }
+    }
+    size_t checksumOffset = stream.size();
+    stream.resize(checksumOffset + 4);
+    dataio::write_int32_big(checksum, stream.data(), checksumOffset);
 
-    fclose(fp);
-    png_free_data(png_ptr, info_ptr, PNG_FREE_ALL, -1);
-    png_destroy_write_struct(&png_ptr, &info_ptr);
-    return 0;
+    std::vector<ubyte> bytes(
+        std::begin(PNG_SIGNATURE), std::end(PNG_SIGNATURE)
+    );
+    ubyte header[13];
+    dataio::write_int32_big(width, header, 0);
+    dataio::write_int32_big(height, header, 4);
+    header[8] = 8;  // bit depth
+    header[9] = alpha ? 6 : 2;  // RGBA or RGB color type
+    header[10] = 0;  // compression method
+    header[11] = 0;  // filter method
+    header[12] = 0;  // interlace method
+    put_chunk(bytes, "IHDR", header, sizeof(header));
+    for (size_t offset = 0; offset < stream.size(); offset += MAX_IDAT_SIZE) {
+        put_chunk(
+            bytes,
+            "IDAT",
+            stream.data() + offset,
+            std::min(MAX_IDAT_SIZE, stream.size() - offset)
+        );
+    }
+    put_chunk(bytes, "IEND", nullptr, 0);
+    return bytes;
 }
 
 struct InMemoryReader {
@@ -223,11 +419,15 @@ std::unique_ptr<Texture> png::load_texture(const std::string& filename) {
 }
 
 void png::write_image(const std::string& filename, const ImageData* image) {
-    png_write(
-        filename.c_str(),
-        image->getWidth(),
-        image->getHeight(),
-        (const ubyte*)image->getData(),
-        image->getFormat() == ImageFormat::rgba8888
-    );
+    try {
+        auto bytes = encode_image(*image, 1);
+        auto file = fs::u8path(filename);
+        if (!files::write_bytes(file, bytes.data(), bytes.size())) {
+            logger.error() << "could not open file " << filename
+                           << " for writing";
+        }
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not encode " << filename << ": "
+                       << err.what();
+    }
 }
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "typedefs.hpp"
 
@@ -11,6 +12,12 @@ class ImageData;
 namespace png {
     std::unique_ptr<ImageData> load_image(const ubyte* bytes, size_t size);
     void write_image(const std::string& filename, const ImageData* image);
+
+    /// @brief Encode RGB or RGBA image rows as is (first row is written
+    /// first). Rows are filtered and deflated in parts by worker threads
+    /// @param threads number of encoding threads, including the calling one
+    /// @throws std::runtime_error if the image format is not supported
+    std::vector<ubyte> encode_image(const ImageData& image, uint threads);
     std::unique_ptr<Texture> load_texture(const ubyte* bytes, size_t size);
     std::unique_ptr<Texture> load_texture(const std::string& filename);
 }
@@ -1,39 +1,114 @@
 #include "rle.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
 #include "util/data_io.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RLE_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define RLE_NEON
+#include <arm_neon.h>
+#endif
+
+/// @brief Count leading elements equal to the first one
+/// @param src source array
+/// @param length max count of elements to check (must be > 0)
+/// @return run length (at least 1)
+static size_t count_run(const ubyte* src, size_t length) {
+    const ubyte c = src[0];
+    size_t i = 1;
+#if defined(RLE_SSE2)
+    const __m128i pattern = _mm_set1_epi8(static_cast<char>(c));
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern)) != 0xFFFF) {
+            break;
+        }
+    }
+#elif defined(RLE_NEON)
+    const uint8x16_t pattern = vdupq_n_u8(c);
+    for (; i + 16 <= length; i += 16) {
+        if (vminvq_u8(vceqq_u8(vld1q_u8(src + i), pattern)) != 0xFF) {
+            break;
+        }
+    }
+#else
+    const uint64_t pattern = 0x0101010101010101ULL * c;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t chunk;
+        std::memcpy(&chunk, src + i, 8);
+        if (chunk != pattern) {
+            break;
+        }
+    }
+#endif
+    // finishing the run (mismatch is somewhere in the next block)
+    for (; i < length && src[i] == c; i++);
+    return i;
+}
+
+/// @brief Count leading elements equal to the first one
+/// @param src source array
+/// @param length max count of elements to check (must be > 0)
+/// @return run length (at least 1)
+static size_t count_run(const uint16_t* src, size_t length) {
+    const uint16_t c = src[0];
+    size_t i = 1;
+#if defined(RLE_SSE2)
+    const __m128i pattern = _mm_set1_epi16(static_cast<short>(c));
+    for (; i + 8 <= length; i += 8) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(chunk, pattern)) != 0xFFFF) {
+            break;
+        }
+    }
+#elif defined(RLE_NEON)
+    const uint16x8_t pattern = vdupq_n_u16(c);
+    for (; i + 8 <= length; i += 8) {
+        if (vminvq_u16(vceqq_u16(vld1q_u16(src + i), pattern)) != 0xFFFF) {
+            break;
+        }
+    }
+#else
+    const uint64_t pattern = 0x0001000100010001ULL * c;
+    for (; i + 4 <= length; i += 4) {
+        uint64_t chunk;
+        std::memcpy(&chunk, src + i, 8);
+        if (chunk != pattern) {
+            break;
+        }
+    }
+#endif
+    for (; i < length && src[i] == c; i++);
+    return i;
+}
+
 size_t rle::decode(const ubyte* src, size_t srclen, ubyte* dst) {
     size_t offset = 0;
     for (size_t i = 0; i < srclen;) {
         ubyte len = src[i++];
         ubyte c = src[i++];
-        for (size_t j = 0; j <= len; j++) {
-            dst[offset++] = c;
-        }
+        std::memset(dst + offset, c, len + 1);
+        offset += len + 1;
     }
     return offset;
 }
 
 size_t rle::encode(const ubyte* src, size_t srclen, ubyte* dst) {
-    if (srclen == 0) {
-        return 0;
-    }
     size_t offset = 0;
-    ubyte counter = 0;
-    ubyte c = src[0];
-    for (size_t i = 1; i < srclen; i++) {
-        ubyte cnext = src[i];
-        if (cnext != c || counter == 255) {
-            dst[offset++] = counter;
-            dst[offset++] = c;
-            c = cnext;
-            counter = 0;
-        } else {
-            counter++;
-        }
+    for (size_t i = 0; i < srclen;) {
+        size_t run = count_run(src + i, std::min<size_t>(srclen - i, 256));
+        dst[offset++] = run - 1;
+        dst[offset++] = src[i];
+        i += run;
     }
-    dst[offset++] = counter;
-    dst[offset++] = c;
     return offset;
 }
 
@@ -44,35 +119,23 @@ size_t rle::decode16(const ubyte* src, size_t srclen, ubyte* dst) {
     for (size_t i = 0; i < srclen / 2;) {
         uint16_t len = dataio::le2h(src16[i++]);
         uint16_t c = dataio::le2h(src16[i++]);
-        for (size_t j = 0; j <= len; j++) {
-            dst16[offset++] = c;
-        }
+        std::fill_n(dst16 + offset, len + 1, c);
+        offset += len + 1;
     }
     return offset * 2;
 }
 
 size_t rle::encode16(const ubyte* src, size_t srclen, ubyte* dst) {
-    if (srclen == 0) {
-        return 0;
-    }
     auto src16 = reinterpret_cast<const uint16_t*>(src);
     auto dst16 = reinterpret_cast<uint16_t*>(dst);
+    size_t length = srclen / 2;
     size_t offset = 0;
-    uint16_t counter = 0;
-    uint16_t c = src16[0];
-    for (size_t i = 1; i < srclen / 2; i++) {
-        uint16_t cnext = src16[i];
-        if (cnext != c || counter == 0xFFFF) {
-            dst16[offset++] = dataio::h2le(counter);
-            dst16[offset++] = dataio::h2le(c);
-            c = cnext;
-            counter = 0;
-        } else {
-            counter++;
-        }
+    for (size_t i = 0; i < length;) {
+        size_t run = count_run(src16 + i, std::min<size_t>(length - i, 0x10000));
+        dst16[offset++] = dataio::h2le(static_cast<uint16_t>(run - 1));
+        dst16[offset++] = dataio::h2le(src16[i]);
+        i += run;
     }
-    dst16[offset++] = dataio::h2le(counter);
-    dst16[offset++] = dataio::h2le(c);
     return offset * 2;
 }
 
@@ -85,52 +148,90 @@ size_t extrle::decode(const ubyte* src, size_t srclen, ubyte* dst) {
             len |= (static_cast<uint>(src[i++])) << 7;
         }
         ubyte c = src[i++];
-        for (size_t j = 0; j <= len; j++) {
-            dst[offset++] = c;
-        }
+        std::memset(dst + offset, c, len + 1);
+        offset += len + 1;
     }
     return offset;
 }
 
 size_t extrle::encode(const ubyte* src, size_t srclen, ubyte* dst) {
-    if (srclen == 0) {
-        return 0;
+    size_t offset = 0;
+    for (size_t i = 0; i < srclen;) {
+        size_t run = count_run(
+            src + i, std::min<size_t>(srclen - i, max_sequence + 1)
+        );
+        uint counter = run - 1;
+        if (counter >= 0x80) {
+            dst[offset++] = 0x80 | (counter & 0x7F);
+            dst[offset++] = counter >> 7;
+        } else {
+            dst[offset++] = counter;
+        }
+        dst[offset++] = src[i];
+        i += run;
     }
+    return offset;
+}
+
+size_t extrle::decode16(const ubyte* src, size_t srclen, ubyte* dst8) {
+    auto dst = reinterpret_cast<uint16_t*>(dst8);
     size_t offset = 0;
-    uint counter = 0;
-    ubyte c = src[0];
-    for (size_t i = 1; i < srclen; i++) {
-        ubyte cnext = src[i];
-        if (cnext != c || counter == max_sequence) {
-            if (counter >= 0x80) {
-                dst[offset++] = 0x80 | (counter & 0x7F);
-                dst[offset++] = counter >> 7;
-            } else {
-                dst[offset++] = counter;
-            }
-            dst[offset++] = c;
-            c = cnext;
-            counter = 0;
+    for (size_t i = 0; i < srclen;) {
+        uint len = src[i++];
+        bool widechar = len & 0x40;
+        if (len & 0x80) {
+            len &= 0x3F;
+            len |= (static_cast<uint>(src[i++])) << 6;
         } else {
-            counter++;
+            len &= 0x3F;
         }
+        uint16_t c = src[i++];
+        if (widechar) {
+            c |= ((static_cast<uint>(src[i++])) << 8);
+        }
+        std::fill_n(dst + offset, len + 1, c);
+        offset += len + 1;
     }
-    if (counter >= 0x80) {
-        dst[offset++] = 0x80 | (counter & 0x7F);
-        dst[offset++] = counter >> 7;
-    } else {
-        dst[offset++] = counter;
+    return offset * 2;
+}
+
+size_t extrle::decode_checked(
+    const ubyte* src, size_t srclen, ubyte* dst, size_t dstlen
+) {
+    size_t offset = 0;
+    for (size_t i = 0; i < srclen;) {
+        uint len = src[i++];
+        size_t extra = 1 + ((len & 0x80) != 0);
+        if (extra > srclen - i) {
+            throw std::runtime_error("truncated rle data");
+        }
+        if (len & 0x80) {
+            len &= 0x7F;
+            len |= (static_cast<uint>(src[i++])) << 7;
+        }
+        ubyte c = src[i++];
+        if (len + 1 > dstlen - offset) {
+            throw std::runtime_error("rle data does not fit the buffer");
+        }
+        std::memset(dst + offset, c, len + 1);
+        offset += len + 1;
     }
-    dst[offset++] = c;
     return offset;
 }
 
-size_t extrle::decode16(const ubyte* src, size_t srclen, ubyte* dst8) {
+size_t extrle::decode16_checked(
+    const ubyte* src, size_t srclen, ubyte* dst8, size_t dstlen
+) {
     auto dst = reinterpret_cast<uint16_t*>(dst8);
+    size_t capacity = dstlen / 2;
     size_t offset = 0;
     for (size_t i = 0; i < srclen;) {
         uint len = src[i++];
         bool widechar = len & 0x40;
+        size_t extra = 1 + ((len & 0x80) != 0) + widechar;
+        if (extra > srclen - i) {
+            throw std::runtime_error("truncated rle data");
+        }
         if (len & 0x80) {
             len &= 0x3F;
             len |= (static_cast<uint>(src[i++])) << 6;
@@ -141,53 +242,38 @@ size_t extrle::decode16(const ubyte* src, size_t srclen, ubyte* dst8) {
         if (widechar) {
             c |= ((static_cast<uint>(src[i++])) << 8);
         }
-        for (size_t j = 0; j <= len; j++) {
-            dst[offset++] = c;
+        if (len + 1 > capacity - offset) {
+            throw std::runtime_error("rle data does not fit the buffer");
         }
+        std::fill_n(dst + offset, len + 1, c);
+        offset += len + 1;
     }
     return offset * 2;
 }
 
 size_t extrle::encode16(const ubyte* src8, size_t srclen, ubyte* dst) {
-    if (srclen == 0) {
-        return 0;
-    }
     auto src = reinterpret_cast<const uint16_t*>(src8);
+    size_t length = srclen / 2;
     size_t offset = 0;
-    uint counter = 0;
-    uint16_t c = src[0];
-    for (size_t i = 1; i < srclen/2; i++) {
-        uint16_t cnext = src[i];
-        if (cnext != c || counter == max_sequence16) {
-            if (counter >= 0x40) {
-                dst[offset++] = 0x80 | ((c > 255) << 6) | (counter & 0x3F);
-                dst[offset++] = counter >> 6;
-            } else {
-                dst[offset++] = counter | ((c > 255) << 6);
-            }
-            if (c > 255) {
-                dst[offset++] = c & 0xFF;
-                dst[offset++] = c >> 8;
-            } else {
-                dst[offset++] = c;
-            }
-            c = cnext;
-            counter = 0;
+    for (size_t i = 0; i < length;) {
+        size_t run = count_run(
+            src + i, std::min<size_t>(length - i, max_sequence16 + 1)
+        );
+        uint counter = run - 1;
+        uint16_t c = src[i];
+        if (counter >= 0x40) {
+            dst[offset++] = 0x80 | ((c > 255) << 6) | (counter & 0x3F);
+            dst[offset++] = counter >> 6;
         } else {
-            counter++;
+            dst[offset++] = counter | ((c > 255) << 6);
         }
-    }
-    if (counter >= 0x40) {
-        dst[offset++] = 0x80 | ((c > 255) << 6) | (counter & 0x3F);
-        dst[offset++] = counter >> 6;
-    } else {
-        dst[offset++] = counter | ((c > 255) << 6);
-    }
-    if (c > 255) {
-        dst[offset++] = c & 0xFF;
-        dst[offset++] = c >> 8;
-    } else {
-        dst[offset++] = c;
+        if (c > 255) {
+            dst[offset++] = c & 0xFF;
+            dst[offset++] = c >> 8;
+        } else {
+            dst[offset++] = c;
+        }
+        i += run;
     }
     return offset;
 }
@@ -18,4 +18,15 @@ namespace extrle {
     constexpr uint max_sequence16 = 0x3FFF;
     size_t encode16(const ubyte* src, size_t length, ubyte* dst);
     size_t decode16(const ubyte* src, size_t length, ubyte* dst);
+
+    /// @brief Decode untrusted data
+    /// @param dstlen destination buffer size
+    /// @throws std::runtime_error if data is truncated or does not fit
+    /// the destination
+    size_t decode_checked(
+        const ubyte* src, size_t length, ubyte* dst, size_t dstlen
+    );
+    size_t decode16_checked(
+        const ubyte* src, size_t length, ubyte* dst, size_t dstlen
+    );
 }
@@ -17,19 +17,38 @@ inline constexpr bool ENGINE_DEBUG_BUILD = true;
 inline const std::string ENGINE_VERSION_STRING = "0.26";
 
 /// @brief world regions format version
-inline constexpr uint REGION_FORMAT_VERSION = 3;
+inline constexpr uint REGION_FORMAT_VERSION = 5;
+
+/// @brief oldest world regions format version read without conversion
+/// (older region files are rewritten in the current format when modified)
+inline constexpr uint REGION_FORMAT_MIN_VERSION = 3;
 
 /// @brief max simultaneously open world region files
 inline constexpr uint MAX_OPEN_REGION_FILES = 32;
 
+/// @brief number of independently locked open region files table shards
+/// (each one holds up to MAX_OPEN_REGION_FILES / REGION_FILES_STRIPES files)
+inline constexpr uint REGION_FILES_STRIPES = 8;
+
+/// @brief region file gets fully rewritten when unreachable chunks data
+/// takes more than the given fraction of the file
+inline constexpr float REGION_COMPACTION_THRESHOLD = 0.5f;
+
 inline constexpr blockid_t BLOCK_AIR = 0;
 inline constexpr blockid_t BLOCK_OBSTACLE = 1;
 inline constexpr blockid_t BLOCK_STRUCT_AIR = 2;
 inline constexpr itemid_t ITEM_EMPTY = 0;
 inline constexpr entityid_t ENTITY_NONE = 0;
 
+// chunk height is picked at build time (VOXELENGINE_CHUNK_HEIGHT CMake
+// option), so indexing stays constexpr. Worlds of other height are not
+// loaded (see WorldInfo::chunkHeight)
+#ifndef VOXELENGINE_CHUNK_HEIGHT
+#define VOXELENGINE_CHUNK_HEIGHT 256
+#endif
+
 inline constexpr int CHUNK_W = 16;
-inline constexpr int CHUNK_H = 256;
+inline constexpr int CHUNK_H = VOXELENGINE_CHUNK_HEIGHT;
 inline constexpr int CHUNK_D = 16;
 
 inline constexpr uint VOXEL_USER_BITS = 8;
@@ -38,6 +57,18 @@ inline constexpr uint VOXEL_USER_BITS_OFFSET = sizeof(blockstate_t)*8-VOXEL_USER
 /// @brief chunk volume (count of voxels per Chunk)
 inline constexpr int CHUNK_VOL = (CHUNK_W * CHUNK_H * CHUNK_D);
 
+/// @brief chunk section height (section is a horizontal slice of chunk)
+inline constexpr int CHUNK_SECTION_H = 16;
+/// @brief count of sections per Chunk
+inline constexpr int CHUNK_SECTIONS = CHUNK_H / CHUNK_SECTION_H;
+/// @brief section volume (count of voxels per section)
+inline constexpr int CHUNK_SECTION_VOL = CHUNK_W * CHUNK_SECTION_H * CHUNK_D;
+
+static_assert(
+    CHUNK_H >= CHUNK_SECTION_H && CHUNK_H % CHUNK_SECTION_H == 0,
+    "chunk height must be a multiple of the section height"
+);
+
 /// @brief block id used to mark non-existing voxel (voxel of missing chunk)
 inline constexpr blockid_t BLOCK_VOID = std::numeric_limits<blockid_t>::max();
 /// @brief item id used to mark non-existing item (error)
@@ -53,7 +84,9 @@ inline constexpr uint vox_index(uint x, uint y, uint z, uint w=CHUNK_W, uint d=C
 /// @brief pixel size of an item inventory icon
 inline constexpr int ITEM_ICON_SIZE = 48;
 
-inline constexpr int TRANSLUCENT_BLOCKS_SORT_INTERVAL = 8;
+/// @brief min camera movement (blocks) making translucent faces of
+/// a chunk to be sorted again
+inline constexpr float TRANSLUCENT_BLOCKS_SORT_DISTANCE = 0.5f;
 
 inline const std::string SHADERS_FOLDER = "shaders";
 inline const std::string TEXTURES_FOLDER = "textures";
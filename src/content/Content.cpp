@@ -1,5 +1,6 @@
 #include "Content.hpp"
 
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <memory>
 #include <stdexcept>
@@ -22,6 +23,62 @@ ContentIndices::ContentIndices(
     : blocks(std::move(blocks)),
       items(std::move(items)),
       entities(std::move(entities)) {
+    size_t count = this->blocks.count();
+    lightPassing.resize(count);
+    skyLightPassing.resize(count);
+    blocksProps.obstacle = BlocksBitset(count);
+    blocksProps.solid = BlocksBitset(count);
+    blocksProps.emissive = BlocksBitset(count);
+    blocksProps.randomUpdate = BlocksBitset(count);
+    blocksProps.fluid = BlocksBitset(count);
+    blocksProps.drawGroup.resize(count);
+    blocksProps.emission.resize(count);
+    const auto* defs = this->blocks.getDefs();
+    // FNV-1a
+    lightsFingerprint = 0xCBF29CE484222325ULL;
+    auto hash = [this](const void* data, size_t size) {
+        auto bytes = static_cast<const ubyte*>(data);
+        for (size_t i = 0; i < size; i++) {
+            lightsFingerprint ^= bytes[i];
+            lightsFingerprint *= 0x100000001B3ULL;
+        }
+    };
+    for (size_t id = 0; id < count; id++) {
+        const auto& def = *defs[id];
+        updateBlock(def);
+        hash(def.name.c_str(), def.name.length() + 1);
+        hash(&lightPassing[id], 1);
+        hash(&skyLightPassing[id], 1);
+    }
+}
+
+void ContentIndices::updateBlock(const Block& def) {
+    blockid_t id = def.rt.id;
+    lightPassing[id] = def.lightPassing ? 0xFF : 0;
+    skyLightPassing[id] = def.skyLightPassing ? 0xFF : 0;
+    blocksProps.obstacle.set(id, def.obstacle);
+    blocksProps.solid.set(id, def.rt.solid);
+    blocksProps.emissive.set(id, def.rt.emissive);
+    blocksProps.fluid.set(id, def.fluidSpread);
+    blocksProps.fluids |= def.fluidSpread != 0;
+    blocksProps.drawGroup[id] = def.drawGroup;
+    std::copy(
+        def.emission, def.emission + 4, blocksProps.emission[id].begin()
+    );
+}
+
+void ContentIndices::updateScriptsFlags() {
+    const auto* defs = blocks.getDefs();
+    tickedBlocks.clear();
+    for (size_t id = 0; id < blocks.count(); id++) {
+        const auto& funcsset = defs[id]->rt.funcsset;
+        blocksProps.randomUpdate.set(
+            id, funcsset.randupdate || funcsset.randupdatebatch
+        );
+        if (funcsset.onblockstick) {
+            tickedBlocks.push_back(id);
+        }
+    }
 }
 
 Content::Content(
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <set>
@@ -85,6 +87,50 @@ public:
     }
 };
 
+/// @brief Bit set of a block flag indexed by block id
+class BlocksBitset {
+    std::vector<uint64_t> words;
+public:
+    BlocksBitset() = default;
+
+    BlocksBitset(size_t count) : words((count + 63) / 64) {
+    }
+
+    inline bool operator[](blockid_t id) const {
+        return (words[id >> 6] >> (id & 63)) & 1;
+    }
+
+    inline void set(blockid_t id, bool flag) {
+        uint64_t bit = uint64_t(1) << (id & 63);
+        if (flag) {
+            words[id >> 6] |= bit;
+        } else {
+            words[id >> 6] &= ~bit;
+        }
+    }
+};
+
+/// @brief Blocks properties packed by block id for hot loops touching
+/// many voxels, where access to a large Block definition is a cache miss
+/// per voxel
+struct BlocksProperties {
+    BlocksBitset obstacle;
+    /// @brief Block::rt.solid
+    BlocksBitset solid;
+    /// @brief Block::rt.emissive
+    BlocksBitset emissive;
+    /// @brief Block has on_random_update or on_random_update_batch event.
+    /// Set by ContentIndices::updateScriptsFlags
+    BlocksBitset randomUpdate;
+    /// @brief Block::fluidSpread is not zero
+    BlocksBitset fluid;
+    /// @brief Content has fluid blocks
+    bool fluids = false;
+    std::vector<ubyte> drawGroup;
+    /// @brief Block::emission (R, G, B, S)
+    std::vector<std::array<ubyte, 4>> emission;
+};
+
 /// @brief Runtime defs cache: indices
 class ContentIndices {
 public:
@@ -92,11 +138,32 @@ public:
     ContentUnitIndices<ItemDef> items;
     ContentUnitIndices<EntityDef> entities;
 
+    /// @brief Blocks lightPassing flags by block id (0xFF or 0) for bulk
+    /// lighting loops avoiding definitions access
+    std::vector<ubyte> lightPassing;
+    /// @brief Blocks skyLightPassing flags by block id (0xFF or 0)
+    std::vector<ubyte> skyLightPassing;
+    /// @brief Hash of blocks names and light passing flags. Sky lights
+    /// cached in world files are valid for the same fingerprint only
+    uint64_t lightsFingerprint;
+    BlocksProperties blocksProps;
+    /// @brief Ids of blocks having on_blocks_tick event.
+    /// Set by updateScriptsFlags
+    std::vector<blockid_t> tickedBlocks;
+
     ContentIndices(
         ContentUnitIndices<Block> blocks,
         ContentUnitIndices<ItemDef> items,
         ContentUnitIndices<EntityDef> entities
     );
+
+    /// @brief Update cached properties of the block. Lights fingerprint
+    /// is not changed (see Block::lightPassing)
+    void updateBlock(const Block& def);
+
+    /// @brief Update blocks properties depending on content scripts
+    /// (called after scripts are loaded)
+    void updateScriptsFlags();
 };
 
 template <class T>
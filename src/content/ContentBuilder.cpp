@@ -19,6 +19,35 @@ BlockMaterial& ContentBuilder::createBlockMaterial(const std::string& id) {
     return material;
 }
 
+void ContentBuilder::prepareBlock(Block& def) {
+    def.rt.emissive = *reinterpret_cast<uint32_t*>(def.emission);
+    def.rt.solid = def.model == BlockModel::block;
+    def.rt.extended = def.size.x > 1 || def.size.y > 1 || def.size.z > 1;
+    def.rt.decorative = def.particles != nullptr;
+
+    const float EPSILON = 0.01f;
+    if (def.rt.extended &&
+        glm::i8vec3(def.hitboxes[0].size() + EPSILON) == def.size) {
+        def.rt.solid = true;
+    }
+
+    for (auto& hitboxes : def.rt.hitboxes) {
+        hitboxes.clear();
+    }
+    if (def.rotatable) {
+        for (uint i = 0; i < BlockRotProfile::MAX_COUNT; i++) {
+            def.rt.hitboxes[i].reserve(def.hitboxes.size());
+            for (AABB aabb : def.hitboxes) {
+                def.rotations.variants[i].transform(aabb);
+                aabb.fix();
+                def.rt.hitboxes[i].push_back(aabb);
+            }
+        }
+    } else {
+        def.rt.hitboxes->emplace_back(AABB(glm::vec3(1.0f)));
+    }
+}
+
 std::unique_ptr<Content> ContentBuilder::build() {
     std::vector<Block*> blockDefsIndices;
     auto groups = std::make_unique<DrawGroups>();
@@ -27,27 +56,7 @@ std::unique_ptr<Content> ContentBuilder::build() {
 
         // Generating runtime info
         def.rt.id = blockDefsIndices.size();
-        def.rt.emissive = *reinterpret_cast<uint32_t*>(def.emission);
-        def.rt.solid = def.model == BlockModel::block;
-        def.rt.extended = def.size.x > 1 || def.size.y > 1 || def.size.z > 1;
-
-        const float EPSILON = 0.01f;
-        if (def.rt.extended && glm::i8vec3(def.hitboxes[0].size() + EPSILON) == def.size) {
-            def.rt.solid = true;
-        }
-
-        if (def.rotatable) {
-            for (uint i = 0; i < BlockRotProfile::MAX_COUNT; i++) {
-                def.rt.hitboxes[i].reserve(def.hitboxes.size());
-                for (AABB aabb : def.hitboxes) {
-                    def.rotations.variants[i].transform(aabb);
-                    aabb.fix();
-                    def.rt.hitboxes[i].push_back(aabb);
-                }
-            }
-        } else {
-            def.rt.hitboxes->emplace_back(AABB(glm::vec3(1.0f)));
-        }
+        prepareBlock(def);
 
         blockDefsIndices.push_back(&def);
         groups->insert(def.drawGroup);
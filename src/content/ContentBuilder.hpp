@@ -80,4 +80,8 @@ public:
     BlockMaterial& createBlockMaterial(const std::string& id);
 
     std::unique_ptr<Content> build();
+
+    /// @brief Generate block runtime info except of the id and
+    /// foreign keys
+    static void prepareBlock(Block& def);
 };
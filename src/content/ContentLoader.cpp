@@ -1,6 +1,7 @@
 #include "ContentLoader.hpp"
 
 #include <algorithm>
+#include <functional>
 #include <glm/glm.hpp>
 #include <iostream>
 #include <memory>
@@ -17,6 +18,7 @@
 #include "logic/scripting/scripting.hpp"
 #include "objects/rigging.hpp"
 #include "typedefs.hpp"
+#include "util/ThreadPool.hpp"
 #include "util/listutil.hpp"
 #include "util/stringutil.hpp"
 #include "voxels/Block.hpp"
@@ -30,9 +32,12 @@ using namespace data;
 static debug::Logger logger("content-loader");
 
 ContentLoader::ContentLoader(
-    ContentPack* pack, ContentBuilder& builder, const ResPaths& paths
+    ContentPack* pack,
+    ContentBuilder& builder,
+    const ResPaths& paths,
+    const ParsedDefinitions* parsed
 )
-    : pack(pack), builder(builder), paths(paths) {
+    : pack(pack), builder(builder), paths(paths), parsed(parsed) {
     auto runtime = std::make_unique<ContentPackRuntime>(
         *pack, scripting::create_pack_environment(*pack)
     );
@@ -42,10 +47,174 @@ ContentLoader::ContentLoader(
     builder.add(std::move(runtime));
 }
 
+static std::string definition_key(const fs::path& file) {
+    return file.lexically_normal().u8string();
+}
+
+/// @brief Parsed definitions cache format version
+static constexpr int DEFINITIONS_CACHE_VERSION = 1;
+
+namespace {
+    struct DefinitionFile {
+        fs::path path;
+        int64_t size;
+        int64_t time;
+    };
+
+    struct ParsedDefinition {
+        const DefinitionFile* file;
+        dv::value root;
+    };
+
+    class DefinitionsParser
+        : public util::Worker<const DefinitionFile*, ParsedDefinition> {
+    public:
+        ParsedDefinition operator()(const DefinitionFile* const& file
+        ) override {
+            try {
+                return {file, files::read_object(file->path)};
+            } catch (const std::exception&) {
+                // error will be reported when the file is read on loading
+                return {file, nullptr};
+            }
+        }
+    };
+}
+
+static void list_definition_files(
+    const fs::path& folder, std::vector<DefinitionFile>& dst
+) {
+    if (!fs::is_directory(folder)) {
+        return;
+    }
+    for (const auto& entry : fs::directory_iterator(folder)) {
+        const auto& file = entry.path();
+        if (fs::is_regular_file(file) && files::is_data_file(file)) {
+            dst.push_back(DefinitionFile {
+                file,
+                static_cast<int64_t>(fs::file_size(file)),
+                static_cast<int64_t>(
+                    fs::last_write_time(file).time_since_epoch().count()
+                )});
+        } else if (fs::is_directory(file) &&
+                   file.extension() != fs::u8path(".files")) {
+            list_definition_files(file, dst);
+        }
+    }
+}
+
+static dv::value read_definitions_cache(const fs::path& file) {
+    if (!fs::is_regular_file(file)) {
+        return nullptr;
+    }
+    try {
+        auto root = files::read_binary_json(file);
+        if (root["version"].asInteger(0) == DEFINITIONS_CACHE_VERSION) {
+            return root;
+        }
+    } catch (const std::exception& err) {
+        logger.warning() << "could not read content cache: " << err.what();
+    }
+    return nullptr;
+}
+
+ParsedDefinitions ContentLoader::parseDefinitions(
+    const std::vector<const ContentPack*>& packs,
+    const fs::path& cacheFolder
+) {
+    std::vector<DefinitionFile> definitions;
+    std::string packsKey;
+    for (const auto& pack : packs) {
+        for (const auto& folder :
+             {ContentPack::BLOCKS_FOLDER,
+              ContentPack::ITEMS_FOLDER,
+              ContentPack::ENTITIES_FOLDER}) {
+            list_definition_files(pack->folder / folder, definitions);
+        }
+        packsKey += pack->id + ";" + pack->folder.u8string() + ";";
+    }
+    fs::path cacheFile;
+    dv::value cached = nullptr;
+    if (!cacheFolder.empty()) {
+        // separate cache per pack set
+        cacheFile = cacheFolder / fs::u8path(
+            "content-" + std::to_string(std::hash<std::string>()(packsKey)) +
+            ".bjson"
+        );
+        cached = read_definitions_cache(cacheFile);
+    }
+    ParsedDefinitions parsed;
+    auto cache = dv::object();
+    cache["version"] = DEFINITIONS_CACHE_VERSION;
+    auto& cacheFiles = cache.object("files");
+
+    std::vector<const DefinitionFile*> changed;
+    for (const auto& file : definitions) {
+        auto key = definition_key(file.path);
+        if (cached != nullptr && cached["files"].has(key)) {
+            const auto& entry = cached["files"][key];
+            if (entry["size"].asInteger() == file.size &&
+                entry["time"].asInteger() == file.time) {
+                parsed[key] = entry["root"];
+                cacheFiles[key] = entry;
+                continue;
+            }
+        }
+        changed.push_back(&file);
+    }
+    if (!changed.empty()) {
+        util::ThreadPool<const DefinitionFile*, ParsedDefinition> pool(
+            "content-parsing",
+            []() { return std::make_shared<DefinitionsParser>(); },
+            [&parsed, &cacheFiles](ParsedDefinition& definition) {
+                if (definition.root == nullptr) {
+                    return;
+                }
+                auto key = definition_key(definition.file->path);
+                auto& entry = cacheFiles.object(key);
+                entry["size"] = definition.file->size;
+                entry["time"] = definition.file->time;
+                entry["root"] = definition.root;
+                parsed[key] = std::move(definition.root);
+            }
+        );
+        pool.setPriority(util::TaskScheduler::Priority::HIGH);
+        for (const auto& file : changed) {
+            pool.enqueueJob(file);
+        }
+        pool.waitForJobs();
+    }
+    logger.info() << "parsed " << changed.size() << " definition files, "
+                  << (definitions.size() - changed.size()) << " cached";
+
+    bool outdated =
+        cached == nullptr || cached["files"].size() != cacheFiles.size();
+    if (!cacheFile.empty() && (!changed.empty() || outdated)) {
+        try {
+            files::write_binary_json(cacheFile, cache, true);
+        } catch (const std::exception& err) {
+            logger.warning() << "could not write content cache: "
+                             << err.what();
+        }
+    }
+    return parsed;
+}
+
+dv::value ContentLoader::readDefinition(const fs::path& file) const {
+    if (parsed) {
+        const auto& found = parsed->find(definition_key(file));
+        if (found != parsed->end()) {
+            return found->second;
+        }
+    }
+    return files::read_json(file);
+}
+
 static void detect_defs(
     const fs::path& folder,
     const std::string& prefix,
-    std::vector<std::string>& detected
+    std::vector<std::string>& detected,
+    const ParsedDefinitions* parsed
 ) {
     if (fs::is_directory(folder)) {
         for (const auto& entry : fs::directory_iterator(folder)) {
@@ -55,12 +224,16 @@ static void detect_defs(
                 continue;
             }
             if (fs::is_regular_file(file) && files::is_data_file(file)) {
-                auto map = files::read_object(file);
+                // file is validated if not parsed already
+                if (parsed == nullptr ||
+                    parsed->find(definition_key(file)) == parsed->end()) {
+                    files::read_object(file);
+                }
                 std::string id = prefix.empty() ? name : prefix + ":" + name;
                 detected.emplace_back(id);
             } else if (fs::is_directory(file) && 
                        file.extension() != fs::u8path(".files")) {
-                detect_defs(file, name, detected);
+                detect_defs(file, name, detected, parsed);
             }
         }
     }
@@ -108,10 +281,11 @@ std::vector<std::tuple<std::string, std::string>> ContentLoader::scanContent(
 bool ContentLoader::fixPackIndices(
     const fs::path& folder,
     dv::value& indicesRoot,
-    const std::string& contentSection
+    const std::string& contentSection,
+    const ParsedDefinitions* parsed
 ) {
     std::vector<std::string> detected;
-    detect_defs(folder, "", detected);
+    detect_defs(folder, "", detected, parsed);
 
     std::vector<std::string> indexed;
     bool modified = false;
@@ -153,9 +327,9 @@ void ContentLoader::fixPackIndices() {
     }
 
     bool modified = false;
-    modified |= fixPackIndices(blocksFolder, root, "blocks");
-    modified |= fixPackIndices(itemsFolder, root, "items");
-    modified |= fixPackIndices(entitiesFolder, root, "entities");
+    modified |= fixPackIndices(blocksFolder, root, "blocks", parsed);
+    modified |= fixPackIndices(itemsFolder, root, "items", parsed);
+    modified |= fixPackIndices(entitiesFolder, root, "entities", parsed);
 
     if (modified) {
         // rewrite modified json
@@ -187,15 +361,18 @@ static void perform_user_block_fields(
     layout = StructLayout::create(fields);
 }
 
-void ContentLoader::loadBlock(
-    Block& def, const std::string& name, const fs::path& file
+/// @param findParent get parent block definition, nullptr if not found
+static void load_block_def(
+    Block& def,
+    const std::string& name,
+    const dv::value& root,
+    const std::function<const Block*(const std::string&)>& findParent
 ) {
-    auto root = files::read_json(file);
     def.properties = root;
 
     if (root.has("parent")) {
         const auto& parentName = root["parent"].asString();
-        auto parentDef = this->builder.blocks.get(parentName);
+        auto parentDef = findParent(parentName);
         if (parentDef == nullptr) {
             throw std::runtime_error(
                 "Failed to find parent(" + parentName + ") for " + name
@@ -339,6 +516,7 @@ void ContentLoader::loadBlock(
     root.at("ui-layout").get(def.uiLayout);
     root.at("inventory-size").get(def.inventorySize);
     root.at("tick-interval").get(def.tickInterval);
+    root.at("fluid-spread").get(def.fluidSpread);
     root.at("overlay-texture").get(def.overlayTexture);
     root.at("translucent").get(def.translucent);
 
@@ -363,10 +541,45 @@ void ContentLoader::loadBlock(
     }
 }
 
+void ContentLoader::loadBlock(
+    Block& def, const std::string& name, const fs::path& file
+) {
+    load_block_def(
+        def,
+        name,
+        readDefinition(file),
+        [this](const std::string& parentName) -> const Block* {
+            return builder.blocks.get(parentName);
+        }
+    );
+}
+
+void ContentLoader::reloadBlock(
+    const Content& content, Block& def, const fs::path& file
+) {
+    Block loaded(def.name);
+    load_block_def(
+        loaded,
+        def.name,
+        files::read_json(file),
+        [&content](const std::string& parentName) {
+            return content.blocks.find(parentName);
+        }
+    );
+    def.particles = nullptr;
+    loaded.cloneTo(def);
+    def.properties = loaded.properties;
+    ContentBuilder::prepareBlock(def);
+    def.rt.pickingItem = content.items.require(def.pickingItem).rt.id;
+    def.rt.surfaceReplacement =
+        content.blocks.require(def.surfaceReplacement).rt.id;
+    content.getIndices()->updateBlock(def);
+}
+
 void ContentLoader::loadItem(
     ItemDef& def, const std::string& name, const fs::path& file
 ) {
-    auto root = files::read_json(file);
+    auto root = readDefinition(file);
     def.properties = root;
 
     if (root.has("parent")) {
@@ -410,7 +623,7 @@ void ContentLoader::loadItem(
 void ContentLoader::loadEntity(
     EntityDef& def, const std::string& name, const fs::path& file
 ) {
-    auto root = files::read_json(file);
+    auto root = readDefinition(file);
 
     if (root.has("parent")) {
         const auto& parentName = root["parent"].asString();
@@ -541,7 +754,7 @@ void ContentLoader::loadContent(const dv::value& root) {
             auto configFile = pack->folder / fs::path(prefix + "/" + name + ".json");
             std::string parent;
             if (fs::exists(configFile)) {
-                auto root = files::read_json(configFile);
+                auto root = readDefinition(configFile);
                 root.at("parent").get(parent);
             }
             return parent;
@@ -792,6 +1005,7 @@ void ContentLoader::load() {
 template <class T>
 static void load_scripts(Content& content, ContentUnitDefs<T>& units) {
     for (const auto& [name, def] : units.getDefs()) {
+        scripting::load_content_events(name, def->rt.events);
         size_t pos = name.find(':');
         if (pos == std::string::npos) {
             throw std::runtime_error("invalid content unit name");
@@ -815,6 +1029,7 @@ static void load_scripts(Content& content, ContentUnitDefs<T>& units) {
 void ContentLoader::loadScripts(Content& content) {
     load_scripts(content, content.blocks);
     load_scripts(content, content.items);
+    content.getIndices()->updateScriptsFlags();
 
     for (const auto& [packid, runtime] : content.getPacks()) {
         const auto& pack = runtime->getInfo();
@@ -3,6 +3,8 @@
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "content_fwd.hpp"
 #include "data/dv.hpp"
@@ -22,6 +24,9 @@ class ContentBuilder;
 class ContentPackRuntime;
 struct ContentPackStats;
 
+/// @brief Definition files parsed ahead of loading by normalized path
+using ParsedDefinitions = std::unordered_map<std::string, dv::value>;
+
 class ContentLoader {
     const ContentPack* pack;
     ContentPackRuntime* runtime;
@@ -29,6 +34,10 @@ class ContentLoader {
     ContentBuilder& builder;
     ContentPackStats* stats;
     const ResPaths& paths;
+    const ParsedDefinitions* parsed;
+
+    /// @brief Get parsed definition file or read it if not parsed
+    dv::value readDefinition(const fs::path& file) const;
 
     void loadBlock(
         Block& def, const std::string& full, const std::string& name
@@ -58,17 +67,31 @@ class ContentLoader {
 
     void loadContent(const dv::value& map);
 public:
+    /// @param parsed definition files parsed ahead (optional)
     ContentLoader(
         ContentPack* pack,
         ContentBuilder& builder,
-        const ResPaths& paths
+        const ResPaths& paths,
+        const ParsedDefinitions* parsed = nullptr
+    );
+
+    /// @brief Read and parse blocks, items and entities definition files
+    /// of the packs in worker threads. Files failed to parse are not
+    /// included: errors are reported on loading
+    /// @param cacheFolder folder of the parsed files cache of the pack set
+    /// (files with unchanged size and modification time are not parsed
+    /// again). Empty path disables the cache
+    static ParsedDefinitions parseDefinitions(
+        const std::vector<const ContentPack*>& packs,
+        const fs::path& cacheFolder = {}
     );
 
     // Refresh pack content.json
     static bool fixPackIndices(
         const fs::path& folder,
         dv::value& indicesRoot,
-        const std::string& contentSection
+        const std::string& contentSection,
+        const ParsedDefinitions* parsed = nullptr
     );
 
     static std::vector<std::tuple<std::string, std::string>> scanContent(
@@ -79,4 +102,11 @@ public:
     void load();
 
     static void loadScripts(Content& content);
+
+    /// @brief Load the block definition file again into the existing
+    /// definition keeping its id and scripts. Content units the block
+    /// refers to must exist
+    static void reloadBlock(
+        const Content& content, Block& def, const fs::path& file
+    );
 };
@@ -101,6 +101,9 @@ struct world_funcs_set {
     bool onblockbroken : 1;
     bool onblockinteract : 1;
     bool onplayertick : 1;
+    bool onchunksloaded : 1;
+    bool onchunksunloaded : 1;
+    bool onchunksmodified : 1;
 };
 
 class ContentPackRuntime {
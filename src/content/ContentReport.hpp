@@ -157,7 +157,7 @@ public:
         return blocks.hasMissingContent() || items.hasMissingContent();
     }
     inline bool isUpgradeRequired() const {
-        return regionsVersion < REGION_FORMAT_VERSION;
+        return regionsVersion < REGION_FORMAT_MIN_VERSION;
     }
     inline bool hasDataLoss() const {
         return !dataLoss.empty();
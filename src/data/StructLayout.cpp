@@ -95,47 +95,12 @@ static inline FieldIncapatibilityType checkIncapatibility(
 
 static inline integer_t clamp_value(integer_t value, FieldType type) {
     auto typesize = sizeof_type(type) * CHAR_BIT;
-    integer_t minval = -(1 << (typesize-1));
-    integer_t maxval = (1 << (typesize-1))-1;
-    return std::min(maxval, std::max(minval, value));
-}
-
-static void reset_integer(
-    const StructLayout& srcLayout,
-    const StructLayout& dstLayout,
-    const Field& field,
-    const Field& dstField,
-    const ubyte* src, 
-    ubyte* dst
-) {
-    int elements = std::min(field.elements, dstField.elements);
-    for (int i = 0; i < elements; i++) {
-        auto value = srcLayout.getInteger(src, field.name, i);
-        auto clamped = clamp_value(value, dstField.type);
-        if (dstField.convertStrategy == FieldConvertStrategy::CLAMP) {
-            value = clamped;
-        } else {
-            if (clamped != value) {
-                value = 0;
-            }
-        }
-        dstLayout.setInteger(dst, value, field.name, i);
-    }
-}
-
-static void reset_number(
-    const StructLayout& srcLayout,
-    const StructLayout& dstLayout,
-    const Field& field,
-    const Field& dstField,
-    const ubyte* src, 
-    ubyte* dst
-) {
-    int elements = std::min(field.elements, dstField.elements);
-    for (int i = 0; i < elements; i++) {
-        auto value = srcLayout.getNumber(src, field.name, i);
-        dstLayout.setNumber(dst, value, field.name, i);
+    if (typesize >= 64) {
+        return value;
     }
+    integer_t minval = -(static_cast<integer_t>(1) << (typesize-1));
+    integer_t maxval = (static_cast<integer_t>(1) << (typesize-1))-1;
+    return std::min(maxval, std::max(minval, value));
 }
 
 void StructLayout::convert(
@@ -144,9 +109,15 @@ void StructLayout::convert(
     ubyte* dst,
     bool allowDataLoss
 ) const {
-    std::memset(dst, 0, totalSize);
-    for (const Field& field : srcLayout.fields) {
-        auto dstField = getField(field.name);
+    StructConverter(*this, srcLayout).convert(src, dst);
+}
+
+StructConverter::StructConverter(
+    const StructLayout& dstLayout, const StructLayout& srcLayout
+)
+    : dstLayout(dstLayout), srcLayout(srcLayout) {
+    for (const Field& field : srcLayout) {
+        auto dstField = dstLayout.getField(field.name);
         if (dstField == nullptr) {
             continue;
         }
@@ -154,13 +125,69 @@ void StructLayout::convert(
         if (type == FieldIncapatibilityType::TYPE_ERROR) {
             continue;
         }
+        int elements = std::min(field.elements, dstField->elements);
+        if (field.type == dstField->type) {
+            copies.push_back(CopyRange {
+                field.offset,
+                dstField->offset,
+                elements * sizeof_type(field.type)});
+            continue;
+        }
         // can't just memcpy, because field type may be changed without data loss
-        if (is_integer_type(field.type) ||
-                (is_floating_point_type(field.type) && 
-                    is_integer_type(dstField->type))) {
-            reset_integer(srcLayout, *this, field, *dstField, src, dst);
+        if (is_integer_type(field.type) || is_integer_type(dstField->type)) {
+            conversions.push_back({&field, dstField, elements, true});
         } else if (is_floating_point_type(dstField->type)) {
-            reset_number(srcLayout, *this, field, *dstField, src, dst);
+            conversions.push_back({&field, dstField, elements, false});
+        }
+    }
+    std::sort(copies.begin(), copies.end(), [](const auto& a, const auto& b) {
+        return a.srcOffset < b.srcOffset;
+    });
+    // merging adjacent ranges (fields order is usually kept by layouts)
+    std::vector<CopyRange> merged;
+    for (const auto& range : copies) {
+        if (!merged.empty()) {
+            auto& last = merged.back();
+            if (last.srcOffset + last.size == range.srcOffset &&
+                last.dstOffset + last.size == range.dstOffset) {
+                last.size += range.size;
+                continue;
+            }
+        }
+        merged.push_back(range);
+    }
+    copies = std::move(merged);
+}
+
+void StructConverter::convert(const ubyte* src, ubyte* dst) const {
+    std::memset(dst, 0, dstLayout.size());
+    for (const auto& range : copies) {
+        std::memcpy(dst + range.dstOffset, src + range.srcOffset, range.size);
+    }
+    for (const auto& conversion : conversions) {
+        const auto& srcField = *conversion.srcField;
+        const auto& dstField = *conversion.dstField;
+        for (int i = 0; i < conversion.elements; i++) {
+            if (!conversion.integer) {
+                auto value = srcLayout.getNumber(src, srcField, i);
+                dstLayout.setNumber(dst, value, dstField, i);
+                continue;
+            }
+            integer_t value;
+            if (is_integer_type(srcField.type)) {
+                value = srcLayout.getInteger(src, srcField, i);
+            } else {
+                value = static_cast<integer_t>(
+                    srcLayout.getNumber(src, srcField, i)
+                );
+            }
+            auto clamped = clamp_value(value, dstField.type);
+            if (dstField.convertStrategy == FieldConvertStrategy::CLAMP) {
+                value = clamped;
+            } else if (clamped != value) {
+                value = 0;
+            }
+            dstLayout.setInteger(dst, value, dstField, i);
         }
     }
 }
@@ -277,4 +277,41 @@ namespace data {
         dv::value serialize() const override;
         void deserialize(const dv::value& src) override;
     };
+
+    /// @brief Conversion from one layout to another with fields matched
+    /// once. Used to convert many structures of the same layout.
+    /// Fields of the same type are copied as raw bytes (adjacent ones are
+    /// merged into a single copy), other fields are converted element by
+    /// element. Both layouts must outlive the converter
+    class StructConverter {
+        struct CopyRange {
+            int srcOffset;
+            int dstOffset;
+            int size;
+        };
+        struct FieldConversion {
+            const Field* srcField;
+            const Field* dstField;
+            int elements;
+            /// @brief true if value is converted as integer
+            bool integer;
+        };
+        const StructLayout& dstLayout;
+        const StructLayout& srcLayout;
+        std::vector<CopyRange> copies;
+        std::vector<FieldConversion> conversions;
+    public:
+        /// @param dstLayout destination structure layout
+        /// @param srcLayout source structure layout
+        StructConverter(
+            const StructLayout& dstLayout, const StructLayout& srcLayout
+        );
+
+        /// @brief Convert structure data. Fields with incompatible types
+        /// and fields missing in the destination layout are dropped
+        /// @param src source data
+        /// @param dst destination buffer
+        /// (size must be enough to store converted structure)
+        void convert(const ubyte* src, ubyte* dst) const;
+    };
 }
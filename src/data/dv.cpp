@@ -9,6 +9,10 @@ namespace dv {
         check_type(type, value_type::object);
         return (*val.object)[key];
     }
+    value& value::operator[](key_t&& key) {
+        check_type(type, value_type::object);
+        return (*val.object)[std::move(key)];
+    }
     const value& value::operator[](const key_t& key) const {
         check_type(type, value_type::object);
         return (*val.object)[key];
@@ -46,13 +50,13 @@ namespace dv {
 
     value& value::object() {
         check_type(type, value_type::list);
-        val.list->push_back(std::make_shared<objects::Object>());
+        val.list->push_back(dv::make_shared<objects::Object>());
         return val.list->operator[](val.list->size()-1);
     }
 
     value& value::list() {
         check_type(type, value_type::list);
-        val.list->push_back(std::make_shared<objects::List>());
+        val.list->push_back(dv::make_shared<objects::List>());
         return val.list->operator[](val.list->size()-1);
     }
 
@@ -0,0 +1,49 @@
+#include "dv_arena.hpp"
+
+using namespace dv;
+
+static thread_local std::shared_ptr<Arena> scope_arena = nullptr;
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    allocated += size;
+    if (size > CHUNK_SIZE / 4) {
+        auto& chunk = chunks.emplace_back(
+            std::make_unique<std::byte[]>(size + alignment)
+        );
+        void* ptr = chunk.get();
+        size_t space = size + alignment;
+        return std::align(alignment, size, ptr, space);
+    }
+    void* ptr = current;
+    if (current == nullptr ||
+        std::align(alignment, size, ptr, available) == nullptr) {
+        auto& chunk = chunks.emplace_back(
+            std::make_unique<std::byte[]>(CHUNK_SIZE)
+        );
+        ptr = chunk.get();
+        available = CHUNK_SIZE;
+        std::align(alignment, size, ptr, available);
+    }
+    current = static_cast<std::byte*>(ptr) + size;
+    available -= size;
+    return ptr;
+}
+
+size_t Arena::getAllocated() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return allocated;
+}
+
+const std::shared_ptr<Arena>& dv::current_arena() {
+    return scope_arena;
+}
+
+ArenaScope::ArenaScope(std::shared_ptr<Arena> arena)
+    : previous(std::move(scope_arena)) {
+    scope_arena = std::move(arena);
+}
+
+ArenaScope::~ArenaScope() {
+    scope_arena = std::move(previous);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace dv {
+    /// @brief Bump allocator for dv trees. Memory is not reused and
+    /// released at once when the arena and all containers allocated
+    /// in it are destroyed, so it's suitable for short-lived documents
+    class Arena {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<std::byte[]>> chunks;
+        std::byte* current = nullptr;
+        size_t available = 0;
+        size_t allocated = 0;
+    public:
+        /// @brief Allocations greater than quarter of the chunk get
+        /// own chunks
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+        Arena() = default;
+        Arena(const Arena&) = delete;
+
+        void* allocate(size_t size, size_t alignment);
+
+        /// @return total allocated bytes
+        size_t getAllocated();
+    };
+
+    /// @return arena used by dv containers created in the current thread
+    /// or nullptr if containers are allocated in the heap
+    const std::shared_ptr<Arena>& current_arena();
+
+    /// @brief Allocate dv containers created in the current thread in the
+    /// arena while the scope is alive. Containers keep the arena alive,
+    /// so they may outlive the scope
+    class ArenaScope {
+        std::shared_ptr<Arena> previous;
+    public:
+        ArenaScope(std::shared_ptr<Arena> arena = std::make_shared<Arena>());
+        ArenaScope(const ArenaScope&) = delete;
+        ~ArenaScope();
+    };
+
+    /// @brief dv containers allocator. Uses the arena being current on
+    /// construction or the heap
+    template <class T>
+    class Allocator {
+        template <class U>
+        friend class Allocator;
+
+        std::shared_ptr<Arena> arena;
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        Allocator() noexcept : arena(current_arena()) {
+        }
+
+        template <class U>
+        Allocator(const Allocator<U>& other) noexcept : arena(other.arena) {
+        }
+
+        T* allocate(size_t n) {
+            if (arena == nullptr) {
+                return std::allocator<T>().allocate(n);
+            }
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* ptr, size_t n) noexcept {
+            // arena memory is released with the arena
+            if (arena == nullptr) {
+                std::allocator<T>().deallocate(ptr, n);
+            }
+        }
+
+        template <class U>
+        bool operator==(const Allocator<U>& other) const noexcept {
+            return arena == other.arena;
+        }
+
+        template <class U>
+        bool operator!=(const Allocator<U>& other) const noexcept {
+            return arena != other.arena;
+        }
+    };
+
+    /// @brief Create shared container using the current arena
+    template <class T, class... Args>
+    inline std::shared_ptr<T> make_shared(Args&&... args) {
+        return std::allocate_shared<T>(
+            Allocator<T>(), std::forward<Args>(args)...
+        );
+    }
+}
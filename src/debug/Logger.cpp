@@ -1,11 +1,16 @@
 #include "Logger.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <thread>
 #include <utility>
 
+#include "util/MPSCRing.hpp"
+
 using namespace debug;
 
 std::ofstream Logger::file;
@@ -13,6 +18,55 @@ std::mutex Logger::mutex;
 std::string Logger::utcOffset = "";
 unsigned Logger::moduleLen = 20;
 
+using clock_type = std::chrono::system_clock;
+
+/// @brief Max number of messages waiting to be written
+static constexpr size_t QUEUE_CAPACITY = 8192;
+/// @brief Max number of same messages written from a thread per
+/// REPEATS_WINDOW, the rest are suppressed
+static constexpr int REPEATS_LIMIT = 16;
+static constexpr auto REPEATS_WINDOW = std::chrono::seconds(1);
+/// @brief Writer thread wakes up at least with this interval
+static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(50);
+
+namespace {
+    struct LogRecord {
+        LogLevel level;
+        std::string name;
+        std::string message;
+        clock_type::time_point time;
+    };
+
+    /// @brief Last message of a thread used to suppress repeats
+    struct RepeatState {
+        size_t hash = 0;
+        int count = 0;
+        size_t suppressed = 0;
+        std::string name;
+        clock_type::time_point windowStart;
+    };
+}
+
+static util::MPSCRing<LogRecord> queue(QUEUE_CAPACITY);
+/// @brief Dropped messages not reported yet
+static std::atomic<size_t> dropped = 0;
+static std::atomic<size_t> droppedTotal = 0;
+
+static std::atomic<bool> running = false;
+static std::thread writer;
+static std::mutex wakeMutex;
+static std::condition_variable wakeCondition;
+
+/// @brief Stops the writer thread at exit writing the rest messages
+static struct WriterGuard {
+    ~WriterGuard() {
+        if (running.exchange(false)) {
+            wakeCondition.notify_one();
+            writer.join();
+        }
+    }
+} writerGuard;
+
 LogMessage::~LogMessage() {
     logger->log(level, ss.str());
 }
@@ -20,17 +74,14 @@ LogMessage::~LogMessage() {
 Logger::Logger(std::string name) : name(std::move(name)) {
 }
 
-void Logger::log(
-    LogLevel level, const std::string& name, const std::string& message
+static std::string format(
+    const LogRecord& record, const std::string& utcOffset, unsigned moduleLen
 ) {
     using namespace std::chrono;
 
     std::stringstream ss;
-    switch (level) {
+    switch (record.level) {
         case LogLevel::debug:
-#ifdef NDEBUG
-            return;
-#endif
             ss << "[D]";
             break;
         case LogLevel::info:
@@ -43,23 +94,113 @@ void Logger::log(
             ss << "[E]";
             break;
     }
-    time_t tm = std::time(nullptr);
+    time_t tm = clock_type::to_time_t(record.time);
     auto ms =
-        duration_cast<milliseconds>(system_clock::now().time_since_epoch()) %
-        1000;
+        duration_cast<milliseconds>(record.time.time_since_epoch()) % 1000;
     ss << " " << std::put_time(std::localtime(&tm), "%Y/%m/%d %T");
     ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    ss << utcOffset << " [" << std::setfill(' ') << std::setw(moduleLen) << name
-       << "] ";
-    ss << message;
-    {
-        std::lock_guard<std::mutex> lock(mutex);
-        auto string = ss.str();
+    ss << utcOffset << " [" << std::setfill(' ') << std::setw(moduleLen)
+       << record.name << "] ";
+    ss << record.message;
+    return ss.str();
+}
+
+/// @brief Push record to the queue or count it as dropped
+static void enqueue(LogRecord&& record) {
+    if (!queue.push(std::move(record))) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        droppedTotal.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/// @brief Write queued messages. Must be called with Logger::mutex locked
+static void write_queued(
+    std::ofstream& file, const std::string& utcOffset, unsigned moduleLen
+);
+
+void Logger::log(
+    LogLevel level, const std::string& name, std::string message
+) {
+#ifdef NDEBUG
+    if (level == LogLevel::debug) {
+        return;
+    }
+#endif
+    auto now = clock_type::now();
+
+    thread_local RepeatState repeats;
+    size_t hash = std::hash<std::string>()(message) ^
+                  (std::hash<std::string>()(name) * 31);
+    bool repeated =
+        hash == repeats.hash && now - repeats.windowStart < REPEATS_WINDOW;
+    if (repeated && ++repeats.count > REPEATS_LIMIT) {
+        repeats.suppressed++;
+        return;
+    }
+
+    // errors are written at once, so they are not lost on a crash
+    bool sync = level == LogLevel::error ||
+                !running.load(std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (sync) {
+        lock.lock();
+        // queued messages are older
+        write_queued(file, utcOffset, moduleLen);
+    }
+    auto submit = [sync](LogRecord&& record) {
+        if (!sync) {
+            enqueue(std::move(record));
+            return;
+        }
+        auto string = format(record, utcOffset, moduleLen);
         if (file.good()) {
             file << string << '\n';
             file.flush();
         }
         std::cout << string << std::endl;
+    };
+    if (!repeated) {
+        // the run of repeats is over, report it before the new message
+        if (repeats.suppressed) {
+            submit(LogRecord {
+                LogLevel::warning,
+                repeats.name,
+                "previous message repeated " +
+                    std::to_string(repeats.suppressed) +
+                    " more times (suppressed)",
+                now});
+        }
+        repeats = RepeatState {hash, 1, 0, name, now};
+    }
+    submit(LogRecord {level, name, std::move(message), now});
+}
+
+static void write_queued(
+    std::ofstream& file, const std::string& utcOffset, unsigned moduleLen
+) {
+    bool written = false;
+    auto write = [&](const LogRecord& record) {
+        auto string = format(record, utcOffset, moduleLen);
+        if (file.good()) {
+            file << string << '\n';
+        }
+        std::cout << string << '\n';
+        written = true;
+    };
+    LogRecord record;
+    while (queue.pop(record)) {
+        write(record);
+    }
+    if (size_t count = dropped.exchange(0)) {
+        write(LogRecord {
+            LogLevel::warning,
+            "logger",
+            std::to_string(count) + " messages dropped (queue is full)",
+            clock_type::now()});
+    }
+    if (written) {
+        file.flush();
+        std::cout.flush();
     }
 }
 
@@ -70,11 +211,29 @@ void Logger::init(const std::string& filename) {
     std::stringstream ss;
     ss << std::put_time(std::localtime(&tm), "%z");
     utcOffset = ss.str();
+
+    if (running.exchange(true)) {
+        return;
+    }
+    writer = std::thread([]() {
+        while (running.load()) {
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wakeCondition.wait_for(lock, FLUSH_INTERVAL);
+            }
+            flush();
+        }
+        flush();
+    });
 }
 
 void Logger::flush() {
     std::lock_guard<std::mutex> lock(mutex);
-    file.flush();
+    write_queued(file, utcOffset, moduleLen);
+}
+
+size_t Logger::getDroppedCount() {
+    return droppedTotal.load(std::memory_order_relaxed);
 }
 
 void Logger::log(LogLevel level, std::string message) {
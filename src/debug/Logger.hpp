@@ -26,7 +26,13 @@ namespace debug {
         }
     };
 
+    /// @brief Messages are queued to a bounded lock-free queue and written
+    /// by the background thread started with init(). Messages are dropped
+    /// when the queue is full. Same messages repeated by a thread too often
+    /// are suppressed, their count is written before the next other message.
+    /// Errors and messages before init() are written synchronously
     class Logger {
+        /// @brief Guards the file and console output
         static std::mutex mutex;
         static std::string utcOffset;
         static std::ofstream file;
@@ -35,12 +41,19 @@ namespace debug {
         std::string name;
 
         static void log(
-            LogLevel level, const std::string& name, const std::string& message
+            LogLevel level, const std::string& name, std::string message
         );
     public:
+        /// @brief Open log file and start the writer thread
         static void init(const std::string& filename);
+
+        /// @brief Write all queued messages
         static void flush();
 
+        /// @brief Get number of messages dropped because of the queue
+        /// overflow since start
+        static size_t getDroppedCount();
+
         Logger(std::string name);
 
         void log(LogLevel level, std::string message);
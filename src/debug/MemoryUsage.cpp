@@ -0,0 +1,37 @@
+#include "MemoryUsage.hpp"
+
+using namespace debug;
+
+size_t MemoryUsage::addSource(Source source) {
+    std::lock_guard lock(mutex);
+    size_t id = nextId++;
+    sources[id] = std::move(source);
+    return id;
+}
+
+void MemoryUsage::removeSource(size_t id) {
+    std::lock_guard lock(mutex);
+    sources.erase(id);
+}
+
+MemoryBreakdown MemoryUsage::collect() {
+    std::lock_guard lock(mutex);
+    MemoryBreakdown breakdown;
+    for (const auto& [_, source] : sources) {
+        source(breakdown);
+    }
+    return breakdown;
+}
+
+dv::value MemoryUsage::toValue() {
+    auto map = dv::object();
+    for (const auto& [tag, bytes] : collect()) {
+        map[tag] = static_cast<int64_t>(bytes);
+    }
+    return map;
+}
+
+MemoryUsage& MemoryUsage::getInstance() {
+    static MemoryUsage usage;
+    return usage;
+}
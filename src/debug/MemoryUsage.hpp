@@ -0,0 +1,61 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "data/dv.hpp"
+
+namespace debug {
+    /// @brief Memory used by subsystems in bytes by tag ("chunks.voxels")
+    using MemoryBreakdown = std::map<std::string, size_t>;
+
+    /// @brief Registry of subsystems memory usage sources. Sources are
+    /// polled by collect() from the main thread and add bytes used by
+    /// their subsystem to the breakdown. Values are estimations made
+    /// of buffers sizes, allocator overheads are not included
+    class MemoryUsage {
+    public:
+        using Source = std::function<void(MemoryBreakdown&)>;
+    private:
+        std::mutex mutex;
+        std::unordered_map<size_t, Source> sources;
+        size_t nextId = 1;
+    public:
+        MemoryUsage() = default;
+
+        MemoryUsage(const MemoryUsage&) = delete;
+
+        /// @return source id used to remove it
+        size_t addSource(Source source);
+
+        void removeSource(size_t id);
+
+        /// @brief Poll all sources. Sources must not add or remove sources
+        MemoryBreakdown collect();
+
+        /// @brief Get breakdown as an object: tag -> bytes
+        dv::value toValue();
+
+        static MemoryUsage& getInstance();
+    };
+
+    /// @brief Memory usage source registered while the object exists.
+    /// Should be declared as the last member of the owner, so is removed
+    /// before the measured data is destroyed
+    class MemorySource {
+        size_t id;
+    public:
+        MemorySource(MemoryUsage::Source source)
+            : id(MemoryUsage::getInstance().addSource(std::move(source))) {
+        }
+
+        ~MemorySource() {
+            MemoryUsage::getInstance().removeSource(id);
+        }
+
+        MemorySource(const MemorySource&) = delete;
+    };
+}
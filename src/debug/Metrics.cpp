@@ -0,0 +1,106 @@
+#include "Metrics.hpp"
+
+#include <algorithm>
+
+#include "coders/json.hpp"
+#include "files/files.hpp"
+
+using namespace debug;
+
+static size_t bucket_of(int64_t value) {
+    size_t bucket = 0;
+    while (value > 0 && bucket + 1 < Histogram::BUCKETS) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void Histogram::record(int64_t value) {
+    value = std::max<int64_t>(0, value);
+    buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    int64_t prev = max.load(std::memory_order_relaxed);
+    while (prev < value && !max.compare_exchange_weak(
+                               prev, value, std::memory_order_relaxed
+                           )) {
+    }
+}
+
+int64_t Histogram::quantile(double q) const {
+    int64_t total = getCount();
+    if (total == 0) {
+        return 0;
+    }
+    auto target = static_cast<int64_t>(q * total);
+    int64_t passed = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        passed += buckets[i].load(std::memory_order_relaxed);
+        if (passed > target) {
+            int64_t bound = i == 0 ? 0 : (int64_t(1) << i) - 1;
+            return std::min(bound, getMax());
+        }
+    }
+    return getMax();
+}
+
+template <class T>
+static T& get_metric(
+    std::mutex& mutex,
+    std::unordered_map<std::string, std::unique_ptr<T>>& map,
+    const std::string& name
+) {
+    std::lock_guard lock(mutex);
+    auto& metric = map[name];
+    if (metric == nullptr) {
+        metric = std::make_unique<T>();
+    }
+    return *metric;
+}
+
+Counter& Metrics::counter(const std::string& name) {
+    return get_metric(mutex, counters, name);
+}
+
+Gauge& Metrics::gauge(const std::string& name) {
+    return get_metric(mutex, gauges, name);
+}
+
+Histogram& Metrics::histogram(const std::string& name) {
+    return get_metric(mutex, histograms, name);
+}
+
+dv::value Metrics::toValue() const {
+    std::lock_guard lock(mutex);
+    auto root = dv::object();
+    auto& countersMap = root.object("counters");
+    for (const auto& [name, counter] : counters) {
+        countersMap[name] = counter->get();
+    }
+    auto& gaugesMap = root.object("gauges");
+    for (const auto& [name, gauge] : gauges) {
+        gaugesMap[name] = gauge->get();
+    }
+    auto& histogramsMap = root.object("histograms");
+    for (const auto& [name, histogram] : histograms) {
+        auto& map = histogramsMap.object(name);
+        map["count"] = histogram->getCount();
+        map["sum"] = histogram->getSum();
+        map["max"] = histogram->getMax();
+        map["p50"] = histogram->quantile(0.5);
+        map["p90"] = histogram->quantile(0.9);
+        map["p99"] = histogram->quantile(0.99);
+    }
+    return root;
+}
+
+void Metrics::write(const std::filesystem::path& file) const {
+    files::write_string(file, json::stringify(toValue(), true));
+}
+
+Metrics& Metrics::getInstance() {
+    static Metrics metrics;
+    return metrics;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "data/dv.hpp"
+#include "util/timeutil.hpp"
+
+namespace debug {
+    /// @brief Monotonic counter (events, bytes)
+    class Counter {
+        std::atomic<int64_t> value = 0;
+    public:
+        void add(int64_t n = 1) {
+            value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        int64_t get() const {
+            return value.load(std::memory_order_relaxed);
+        }
+    };
+
+    /// @brief Current value of something (queue size, entities count)
+    class Gauge {
+        std::atomic<int64_t> value = 0;
+    public:
+        void set(int64_t n) {
+            value.store(n, std::memory_order_relaxed);
+        }
+
+        void add(int64_t n) {
+            value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        int64_t get() const {
+            return value.load(std::memory_order_relaxed);
+        }
+    };
+
+    /// @brief Distribution of non-negative values (latencies in
+    /// microseconds) with power of two buckets: bucket i counts values
+    /// in range [2^(i-1), 2^i)
+    class Histogram {
+    public:
+        static constexpr size_t BUCKETS = 40;
+    private:
+        std::array<std::atomic<int64_t>, BUCKETS> buckets {};
+        std::atomic<int64_t> count = 0;
+        std::atomic<int64_t> sum = 0;
+        std::atomic<int64_t> max = 0;
+    public:
+        void record(int64_t value);
+
+        int64_t getCount() const {
+            return count.load(std::memory_order_relaxed);
+        }
+
+        int64_t getSum() const {
+            return sum.load(std::memory_order_relaxed);
+        }
+
+        int64_t getMax() const {
+            return max.load(std::memory_order_relaxed);
+        }
+
+        /// @brief Get approximate quantile (upper bound of the bucket)
+        /// @param q quantile in range [0, 1]
+        int64_t quantile(double q) const;
+    };
+
+    /// @brief Named metrics registry. Metrics are created on first access
+    /// and never removed, so references may be stored (in function-local
+    /// static variables, for example). Metrics are thread-safe.
+    class Metrics {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::unique_ptr<Counter>> counters;
+        std::unordered_map<std::string, std::unique_ptr<Gauge>> gauges;
+        std::unordered_map<std::string, std::unique_ptr<Histogram>> histograms;
+    public:
+        Metrics() = default;
+
+        Metrics(const Metrics&) = delete;
+
+        Counter& counter(const std::string& name);
+        Gauge& gauge(const std::string& name);
+        Histogram& histogram(const std::string& name);
+
+        /// @brief Get metrics snapshot: object with 'counters', 'gauges'
+        /// and 'histograms' objects. Histograms are represented as objects
+        /// with keys: count, sum, max, p50, p90, p99
+        dv::value toValue() const;
+
+        /// @brief Write metrics snapshot as JSON file
+        void write(const std::filesystem::path& file) const;
+
+        static Metrics& getInstance();
+    };
+
+    /// @brief Records the scope time (microseconds) to the histogram
+    class MetricTimer {
+        Histogram& histogram;
+        timeutil::Timer timer;
+    public:
+        MetricTimer(Histogram& histogram) : histogram(histogram) {
+        }
+
+        ~MetricTimer() {
+            histogram.record(timer.stop());
+        }
+
+        MetricTimer(const MetricTimer&) = delete;
+    };
+}
@@ -0,0 +1,254 @@
+#include "Profiler.hpp"
+
+#include <GL/glew.h>
+
+#include "coders/json.hpp"
+#include "files/files.hpp"
+
+using namespace debug;
+
+/// @brief Pass times are smoothed as average of ~1/k last frames
+static constexpr float TIME_SMOOTHING = 0.05f;
+
+static std::atomic<uint> threadsCount = 0;
+/// @brief Number of the current thread in other threads zones, 0 - not
+/// assigned yet
+static thread_local uint threadNumber = 0;
+
+// queries left are released with GL context (may be destroyed already)
+Profiler::~Profiler() = default;
+
+int64_t Profiler::now() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        clock::now() - startTime
+    ).count();
+}
+
+void Profiler::setEnabled(bool enabled, bool gpuTiming) {
+    if (!enabled && frameOpen) {
+        endFrame();
+    }
+    if (!enabled || !gpuTiming) {
+        for (auto& frame : frames) {
+            // not read back frames are dropped
+            frame.events.clear();
+            frame.usedQueries = 0;
+            frame.pending = false;
+            if (!frame.queries.empty()) {
+                glDeleteQueries(frame.queries.size(), frame.queries.data());
+                frame.queries.clear();
+            }
+        }
+    }
+    if (!enabled) {
+        ThreadZone zone;
+        while (threadZones.pop(zone)) {
+        }
+    }
+    mainThread = std::this_thread::get_id();
+    this->enabled = enabled;
+    this->gpuTiming = gpuTiming;
+}
+
+uint Profiler::timestamp(Frame& frame) {
+    if (!gpuTiming) {
+        return 0;
+    }
+    if (frame.usedQueries == frame.queries.size()) {
+        uint query;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+    }
+    uint query = frame.queries[frame.usedQueries++];
+    glQueryCounter(query, GL_TIMESTAMP);
+    return query;
+}
+
+size_t Profiler::findPass(const char* name) {
+    std::string path = name;
+    int depth = stack.size();
+    if (!stack.empty()) {
+        const auto& frame = frames[frameIndex % FRAMES_LATENCY];
+        const auto& parent = passes[frame.events[stack.back()].pass];
+        path = parent.path + "/" + path;
+    }
+    const auto& found = passIndices.find(path);
+    if (found != passIndices.end()) {
+        return found->second;
+    }
+    size_t index = passes.size();
+    passes.push_back(PassStats {name, path, depth});
+    passIndices[path] = index;
+    return index;
+}
+
+void Profiler::push(const char* name, bool gpu) {
+    if (!frameOpen) {
+        return;
+    }
+    size_t pass = findPass(name);
+    auto& frame = frames[frameIndex % FRAMES_LATENCY];
+    stack.push_back(frame.events.size());
+    auto& event = frame.events.emplace_back(Event {pass, now()});
+    if (gpu) {
+        event.gpuStart = timestamp(frame);
+    }
+}
+
+void Profiler::pop() {
+    if (!frameOpen || stack.empty()) {
+        return;
+    }
+    auto& frame = frames[frameIndex % FRAMES_LATENCY];
+    auto& event = frame.events[stack.back()];
+    stack.pop_back();
+    event.cpuEnd = now();
+    if (event.gpuStart) {
+        event.gpuEnd = timestamp(frame);
+    }
+}
+
+static int64_t query_nanoseconds(uint query) {
+    GLuint64 value = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &value);
+    return static_cast<int64_t>(value);
+}
+
+void Profiler::resolve(Frame& frame) {
+    for (const auto& event : frame.events) {
+        auto& stats = passes[event.pass];
+        TraceEvent trace {
+            event.pass, event.cpuStart, event.cpuEnd - event.cpuStart, -1, 0};
+        if (event.gpuStart && event.gpuEnd) {
+            int64_t start = query_nanoseconds(event.gpuStart);
+            int64_t end = query_nanoseconds(event.gpuEnd);
+            if (gpuTimeBase < 0) {
+                gpuTimeBase = start;
+                gpuCpuOffset = event.cpuStart;
+            }
+            trace.gpuStart = (start - gpuTimeBase) / 1000 + gpuCpuOffset;
+            trace.gpuDuration = (end - start) / 1000;
+            stats.gpuTime +=
+                ((end - start) / 1e6f - stats.gpuTime) * TIME_SMOOTHING;
+        }
+        stats.cpuTime +=
+            (trace.cpuDuration / 1e3f - stats.cpuTime) * TIME_SMOOTHING;
+        history.push_back(trace);
+    }
+    while (history.size() > MAX_HISTORY) {
+        history.pop_front();
+    }
+    frame.events.clear();
+    frame.usedQueries = 0;
+    frame.pending = false;
+}
+
+void Profiler::beginFrame() {
+    if (!enabled) {
+        return;
+    }
+    if (frameOpen) {
+        endFrame();
+    }
+    auto& frame = frames[frameIndex % FRAMES_LATENCY];
+    if (frame.pending) {
+        resolve(frame);
+    }
+    frameOpen = true;
+    push("frame");
+}
+
+void Profiler::endFrame() {
+    if (!frameOpen) {
+        return;
+    }
+    while (!stack.empty()) {
+        pop();
+    }
+    frames[frameIndex % FRAMES_LATENCY].pending = true;
+    frameOpen = false;
+    frameIndex++;
+
+    ThreadZone zone;
+    while (threadZones.pop(zone)) {
+        threadHistory.push_back(zone);
+    }
+    while (threadHistory.size() > MAX_HISTORY) {
+        threadHistory.pop_front();
+    }
+}
+
+const Profiler::PassStats* Profiler::getPass(const std::string& path) const {
+    const auto& found = passIndices.find(path);
+    if (found == passIndices.end()) {
+        return nullptr;
+    }
+    return &passes[found->second];
+}
+
+static void add_trace_event(
+    dv::value& events,
+    const std::string& name,
+    int tid,
+    int64_t start,
+    int64_t duration
+) {
+    auto& event = events.object();
+    event["name"] = name;
+    event["ph"] = "X";
+    event["pid"] = 0;
+    event["tid"] = tid;
+    event["ts"] = start;
+    event["dur"] = duration;
+}
+
+dv::value Profiler::toChromeTrace() const {
+    auto root = dv::object();
+    auto& events = root.list("traceEvents");
+    for (const auto& trace : history) {
+        const auto& name = passes[trace.pass].name;
+        add_trace_event(events, name, 0, trace.cpuStart, trace.cpuDuration);
+        if (trace.gpuStart >= 0) {
+            add_trace_event(
+                events, name, 1, trace.gpuStart, trace.gpuDuration
+            );
+        }
+    }
+    for (const auto& zone : threadHistory) {
+        add_trace_event(
+            events, zone.name, 1 + zone.thread, zone.start, zone.duration
+        );
+    }
+    root["displayTimeUnit"] = "ms";
+    return root;
+}
+
+void Profiler::writeChromeTrace(const std::filesystem::path& file) const {
+    files::write_string(file, json::stringify(toChromeTrace(), false));
+}
+
+void ProfileZone::begin() {
+    if (std::this_thread::get_id() == profiler.mainThread.load()) {
+        profiler.push(name, false);
+    } else {
+        start = profiler.now();
+    }
+}
+
+void ProfileZone::end() {
+    if (start < 0) {
+        profiler.pop();
+        return;
+    }
+    if (threadNumber == 0) {
+        threadNumber = ++threadsCount;
+    }
+    // dropped if the main thread does not drain zones (no frames)
+    profiler.threadZones.push(Profiler::ThreadZone {
+        name, threadNumber, start, profiler.now() - start});
+}
+
+Profiler& Profiler::getInstance() {
+    static Profiler profiler;
+    return profiler;
+}
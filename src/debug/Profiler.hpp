@@ -0,0 +1,216 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "data/dv.hpp"
+#include "typedefs.hpp"
+#include "util/MPSCRing.hpp"
+
+namespace debug {
+    /// @brief Frame passes profiler measuring CPU time and GPU time of
+    /// nested passes (see ProfileScope). GPU time is measured with GL
+    /// timestamp queries read back a few frames later.
+    /// CPU-only zones (see ProfileZone) may be used in any thread: zones of
+    /// other threads are queued to the main thread and available in the
+    /// trace export only.
+    /// @attention methods except isEnabled and ProfileZone are main (GL)
+    /// thread only
+    class Profiler {
+    public:
+        struct PassStats {
+            std::string name;
+            /// @brief Names of parent passes and the pass separated by '/'
+            std::string path;
+            /// @brief Nesting depth, 0 - the whole frame
+            int depth;
+            /// @brief Smoothed pass CPU time (milliseconds)
+            float cpuTime = 0.0f;
+            /// @brief Smoothed pass GPU time (milliseconds)
+            float gpuTime = 0.0f;
+        };
+        /// @brief Number of frames recorded before results are read back
+        static constexpr size_t FRAMES_LATENCY = 3;
+        /// @brief Max number of passes kept for the trace export
+        static constexpr size_t MAX_HISTORY = 1 << 16;
+        /// @brief Max number of other threads zones queued between frames,
+        /// zones over the limit are dropped
+        static constexpr size_t THREAD_ZONES_CAPACITY = 1 << 12;
+    private:
+        friend class ProfileZone;
+        using clock = std::chrono::steady_clock;
+
+        struct Event {
+            size_t pass;
+            /// @brief CPU start and end (microseconds)
+            int64_t cpuStart;
+            int64_t cpuEnd = 0;
+            /// @brief GPU timestamp queries, 0 if GPU timing is disabled
+            uint gpuStart = 0;
+            uint gpuEnd = 0;
+        };
+        struct Frame {
+            std::vector<Event> events;
+            /// @brief Timestamp queries pool
+            std::vector<uint> queries;
+            size_t usedQueries = 0;
+            bool pending = false;
+        };
+        /// @brief Resolved pass times for the trace export
+        struct TraceEvent {
+            size_t pass;
+            int64_t cpuStart;
+            int64_t cpuDuration;
+            /// @brief GPU start and duration (microseconds), negative
+            /// start if GPU time is not measured
+            int64_t gpuStart;
+            int64_t gpuDuration;
+        };
+        /// @brief Zone finished in other than main thread
+        struct ThreadZone {
+            /// @brief Zone name, must be a string literal
+            const char* name;
+            /// @brief Thread number starting from 1
+            uint thread;
+            int64_t start;
+            int64_t duration;
+        };
+
+        std::atomic<bool> enabled = false;
+        std::atomic<std::thread::id> mainThread;
+        bool gpuTiming = false;
+        bool frameOpen = false;
+        clock::time_point startTime = clock::now();
+        /// @brief First GPU timestamp (nanoseconds) aligned to CPU time
+        int64_t gpuTimeBase = -1;
+        int64_t gpuCpuOffset = 0;
+
+        std::array<Frame, FRAMES_LATENCY> frames;
+        size_t frameIndex = 0;
+        /// @brief Indices of the current frame open events
+        std::vector<size_t> stack;
+
+        std::vector<PassStats> passes;
+        /// @brief Pass indices by paths
+        std::unordered_map<std::string, size_t> passIndices;
+        std::deque<TraceEvent> history;
+        util::MPSCRing<ThreadZone> threadZones {THREAD_ZONES_CAPACITY};
+        std::deque<ThreadZone> threadHistory;
+
+        int64_t now() const;
+        uint timestamp(Frame& frame);
+        void resolve(Frame& frame);
+        size_t findPass(const char* name);
+    public:
+        Profiler() = default;
+        ~Profiler();
+
+        Profiler(const Profiler&) = delete;
+
+        /// @param enabled enable profiling, disabled profiler has the cost
+        /// of a branch per pass
+        /// @param gpuTiming measure GPU time (requires GL context)
+        void setEnabled(bool enabled, bool gpuTiming = true);
+
+        bool isEnabled() const {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /// @brief Start the frame pass, results of the frame recorded
+        /// FRAMES_LATENCY frames ago are read back
+        void beginFrame();
+
+        /// @brief Finish the frame pass, passes left open are closed
+        void endFrame();
+
+        /// @brief Begin nested pass
+        /// @param name pass name, passes are identified by names of the
+        /// pass and parent passes
+        /// @param gpu measure GPU time of the pass
+        void push(const char* name, bool gpu = true);
+
+        /// @brief End the last begun pass
+        void pop();
+
+        /// @brief Get passes stats in the first occurrence order
+        const std::vector<PassStats>& getPasses() const {
+            return passes;
+        }
+
+        /// @brief Get pass stats by path like "frame/world"
+        /// @return nullptr if the pass never run
+        const PassStats* getPass(const std::string& path) const;
+
+        /// @brief Build Chrome trace events (chrome://tracing, Perfetto)
+        /// of the recorded passes: tid 0 - CPU, tid 1 - GPU, tid 2 and
+        /// greater - zones of other threads
+        dv::value toChromeTrace() const;
+
+        /// @brief Write Chrome trace JSON file
+        void writeChromeTrace(const std::filesystem::path& file) const;
+
+        static Profiler& getInstance();
+    };
+
+    /// @brief Profile pass in the scope
+    class ProfileScope {
+        Profiler& profiler;
+        bool active;
+    public:
+        ProfileScope(
+            const char* name, Profiler& profiler = Profiler::getInstance()
+        )
+            : profiler(profiler), active(profiler.isEnabled()) {
+            if (active) {
+                profiler.push(name);
+            }
+        }
+
+        ~ProfileScope() {
+            if (active) {
+                profiler.pop();
+            }
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+    };
+
+    /// @brief Profile CPU time of the scope, may be used in any thread.
+    /// Zones of the main thread are nested passes with GPU time not
+    /// measured, so they are cheaper than ProfileScope
+    class ProfileZone {
+        Profiler& profiler;
+        const char* name;
+        /// @brief Start time of other thread zone, -1 if not started
+        int64_t start = -1;
+        bool active;
+
+        void begin();
+        void end();
+    public:
+        /// @param name zone name, must be a string literal
+        ProfileZone(
+            const char* name, Profiler& profiler = Profiler::getInstance()
+        )
+            : profiler(profiler), name(name), active(profiler.isEnabled()) {
+            if (active) {
+                begin();
+            }
+        }
+
+        ~ProfileZone() {
+            if (active) {
+                end();
+            }
+        }
+
+        ProfileZone(const ProfileZone&) = delete;
+    };
+}
@@ -1,16 +1,15 @@
 #include "syntax_highlighting.hpp"
 
+#include <algorithm>
+
 #include "coders/commons.hpp"
 #include "coders/lua_parsing.hpp"
 #include "graphics/core/Font.hpp"
 
 using namespace devtools;
 
-static std::unique_ptr<FontStylesScheme> build_styles(
-    const std::vector<devtools::Token>& tokens
-) {
-    using devtools::TokenTag;
-    FontStylesScheme styles {
+static FontStylesScheme make_styles() {
+    return FontStylesScheme {
         {
             {false, false, false, false, glm::vec4(0.8f, 0.8f, 0.8f, 1)}, // default
             {true, false, false, false, glm::vec4(0.9, 0.6f, 0.4f, 1)},   // keyword
@@ -20,34 +19,38 @@ static std::unique_ptr<FontStylesScheme> build_styles(
         }, 
         {}
     };
+}
+
+/// @return style index of the token or -1 if the token is not highlighted
+static int style_of(devtools::TokenTag tag) {
+    using devtools::TokenTag;
+    switch (tag) {
+        case TokenTag::KEYWORD: return SyntaxStyles::KEYWORD;
+        case TokenTag::STRING:
+        case TokenTag::INTEGER:
+        case TokenTag::NUMBER: return SyntaxStyles::LITERAL;
+        case TokenTag::COMMENT: return SyntaxStyles::COMMENT;
+        case TokenTag::UNEXPECTED: return SyntaxStyles::ERROR;
+        default:
+            return -1;
+    }
+}
+
+static std::unique_ptr<FontStylesScheme> build_styles(
+    const std::vector<devtools::Token>& tokens
+) {
+    auto styles = make_styles();
     size_t offset = 0;
     for (int i = 0; i < tokens.size(); i++) {
         const auto& token = tokens.at(i);
-        if (token.tag != TokenTag::KEYWORD &&
-            token.tag != TokenTag::STRING &&
-            token.tag != TokenTag::INTEGER &&
-            token.tag != TokenTag::NUMBER &&
-            token.tag != TokenTag::COMMENT &&
-            token.tag != TokenTag::UNEXPECTED) {
+        int styleIndex = style_of(token.tag);
+        if (styleIndex == -1) {
             continue;
         }
         if (token.start.pos > offset) {
-            int n = token.start.pos - offset;
             styles.map.insert(styles.map.end(), token.start.pos - offset, 0);
         }
         offset = token.end.pos;
-        int styleIndex;
-        switch (token.tag) {
-            case TokenTag::KEYWORD: styleIndex = SyntaxStyles::KEYWORD; break;
-            case TokenTag::STRING:
-            case TokenTag::INTEGER:
-            case TokenTag::NUMBER: styleIndex = SyntaxStyles::LITERAL; break;
-            case TokenTag::COMMENT: styleIndex = SyntaxStyles::COMMENT; break;
-            case TokenTag::UNEXPECTED: styleIndex = SyntaxStyles::ERROR; break;
-            default:
-                styleIndex = 0;
-                break;
-        }
         styles.map.insert(
             styles.map.end(), token.end.pos - token.start.pos, styleIndex
         );
@@ -70,3 +73,162 @@ std::unique_ptr<FontStylesScheme> devtools::syntax_highlight(
         return nullptr;
     }
 }
+
+SyntaxHighlighter::SyntaxHighlighter(std::string lang)
+    : lang(std::move(lang)) {
+}
+
+bool SyntaxHighlighter::tokenize(
+    std::string_view part,
+    std::vector<ubyte>& dstMap,
+    std::vector<Span>& dstSpans
+) const {
+    std::vector<Token> tokens;
+    try {
+        tokens = lua::tokenize("<string>", part);
+    } catch (const parsing_error& err) {
+        return false;
+    }
+    dstMap.assign(part.size(), SyntaxStyles::DEFAULT);
+    dstSpans.clear();
+    dstSpans.reserve(tokens.size());
+    for (const auto& token : tokens) {
+        int start = std::min<int>(token.start.pos, part.size());
+        int end = std::min<int>(token.end.pos, part.size());
+        dstSpans.push_back(Span {start, end});
+        int styleIndex = style_of(token.tag);
+        if (styleIndex != -1) {
+            std::fill(
+                dstMap.begin() + start, dstMap.begin() + end, styleIndex
+            );
+        }
+    }
+    return true;
+}
+
+bool SyntaxHighlighter::rebuild(std::string_view source) {
+    this->source = source;
+    valid = tokenize(source, map, spans);
+    return valid;
+}
+
+const SyntaxHighlighter::Span* SyntaxHighlighter::findSpan(int pos) const {
+    auto found = std::upper_bound(
+        spans.begin(), spans.end(), pos, [](int pos, const Span& span) {
+            return pos < span.start;
+        }
+    );
+    if (found == spans.begin()) {
+        return nullptr;
+    }
+    --found;
+    if (found->start < pos && pos < found->end) {
+        return &*found;
+    }
+    return nullptr;
+}
+
+std::unique_ptr<FontStylesScheme> SyntaxHighlighter::update(
+    std::string_view newSource
+) {
+    if (lang != "lua") {
+        return nullptr;
+    }
+    if (!valid) {
+        if (!rebuild(newSource)) {
+            return nullptr;
+        }
+    } else if (newSource != source) {
+        int oldLength = source.size();
+        int newLength = newSource.size();
+        int prefix = std::mismatch(
+            source.begin(), source.end(), newSource.begin(), newSource.end()
+        ).first - source.begin();
+        int suffix = 0;
+        int maxSuffix = std::min(oldLength, newLength) - prefix;
+        while (suffix < maxSuffix &&
+               source[oldLength - 1 - suffix] ==
+                   newSource[newLength - 1 - suffix]) {
+            suffix++;
+        }
+        int delta = newLength - oldLength;
+
+        // restart at the changed line start, out of previous tokens
+        int start = prefix;
+        while (start > 0 && newSource[start - 1] != '\n') {
+            start--;
+        }
+        if (auto span = findSpan(start)) {
+            start = span->start;
+        }
+        // token reaching the source end may be not terminated
+        if (!spans.empty() && spans.back().end >= oldLength &&
+            spans.back().start < start) {
+            start = spans.back().start;
+        }
+        // stop after a line end where previous tokenization is not inside
+        // of a token, so the rest tokens are the same
+        int end = newLength - suffix;
+        while (true) {
+            auto lineEnd = newSource.find('\n', end);
+            if (lineEnd == std::string_view::npos) {
+                end = newLength;
+                break;
+            }
+            end = lineEnd + 1;
+            if (auto span = findSpan(end - delta)) {
+                end = span->end + delta;
+                continue;
+            }
+            break;
+        }
+        std::vector<ubyte> partMap;
+        std::vector<Span> partSpans;
+        auto part = newSource.substr(start, end - start);
+        bool tokenized = tokenize(part, partMap, partSpans);
+        // the part end must not cut a token (multiline string)
+        bool cut = end < newLength && !partSpans.empty() &&
+                   partSpans.back().end >= static_cast<int>(part.size());
+        if (!tokenized || cut) {
+            if (!rebuild(newSource)) {
+                return nullptr;
+            }
+        } else {
+            int oldEnd = end - delta;
+            std::vector<ubyte> newMap;
+            newMap.reserve(newLength);
+            newMap.insert(newMap.end(), map.begin(), map.begin() + start);
+            newMap.insert(newMap.end(), partMap.begin(), partMap.end());
+            newMap.insert(newMap.end(), map.begin() + oldEnd, map.end());
+
+            std::vector<Span> newSpans;
+            newSpans.reserve(spans.size() + partSpans.size());
+            for (const auto& span : spans) {
+                if (span.start >= start) {
+                    break;
+                }
+                newSpans.push_back(span);
+            }
+            for (const auto& span : partSpans) {
+                newSpans.push_back(Span {span.start + start, span.end + start});
+            }
+            auto found = std::lower_bound(
+                spans.begin(), spans.end(), oldEnd,
+                [](const Span& span, int pos) { return span.start < pos; }
+            );
+            for (; found != spans.end(); ++found) {
+                newSpans.push_back(
+                    Span {found->start + delta, found->end + delta}
+                );
+            }
+            map = std::move(newMap);
+            spans = std::move(newSpans);
+            source = newSource;
+        }
+    }
+    auto styles = std::make_unique<FontStylesScheme>(make_styles());
+    styles->map.reserve(map.size() + 1);
+    styles->map.assign(map.begin(), map.end());
+    styles->map.push_back(0);
+    return styles;
+}
@@ -2,6 +2,9 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+
+#include "typedefs.hpp"
 
 struct FontStylesScheme;
 
@@ -13,4 +16,41 @@ namespace devtools {
     std::unique_ptr<FontStylesScheme> syntax_highlight(
         const std::string& lang, std::string_view source
     );
+
+    /// @brief Syntax highlighter keeping tokens of the previous source
+    /// version. On update only lines from the first changed line up to
+    /// the line where tokenization matches the previous one again are
+    /// re-tokenized
+    class SyntaxHighlighter {
+        struct Span {
+            int start;
+            int end;
+        };
+        std::string lang;
+        std::string source;
+        /// @brief Style index of every source character
+        std::vector<ubyte> map;
+        /// @brief Tokens positions sorted by start
+        std::vector<Span> spans;
+        bool valid = false;
+
+        /// @brief Tokenize source part, write styles and spans
+        /// (positions relative to the part)
+        /// @return false if tokenization failed
+        bool tokenize(
+            std::string_view part,
+            std::vector<ubyte>& dstMap,
+            std::vector<Span>& dstSpans
+        ) const;
+        bool rebuild(std::string_view source);
+        /// @return span containing the position (not at start) or nullptr
+        const Span* findSpan(int pos) const;
+    public:
+        SyntaxHighlighter(std::string lang);
+
+        /// @brief Highlight new version of the source
+        /// @return styles or nullptr if the language is not supported or
+        /// the source can not be tokenized
+        std::unique_ptr<FontStylesScheme> update(std::string_view source);
+    };
 }
@@ -3,10 +3,14 @@
 #define GLEW_STATIC
 
 #include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
+#include "debug/Profiler.hpp"
 #include "assets/AssetsLoader.hpp"
+#include "assets/assetload_funcs.hpp"
 #include "audio/audio.hpp"
 #include "coders/GLSLExtension.hpp"
 #include "coders/imageio.hpp"
+#include "coders/png.hpp"
 #include "coders/json.hpp"
 #include "coders/toml.hpp"
 #include "coders/commons.hpp"
@@ -21,26 +25,41 @@
 #include "frontend/screens/Screen.hpp"
 #include "frontend/screens/MenuScreen.hpp"
 #include "graphics/render/ModelsGenerator.hpp"
+#include "graphics/render/commons.hpp"
 #include "graphics/core/Batch2D.hpp"
 #include "graphics/core/DrawContext.hpp"
+#include "graphics/core/GlyphAtlas.hpp"
 #include "graphics/core/ImageData.hpp"
+#include "graphics/core/Mesh.hpp"
+#include "graphics/core/ReadbackBuffer.hpp"
 #include "graphics/core/Shader.hpp"
 #include "graphics/ui/GUI.hpp"
+#include "graphics/ui/gui_xml.hpp"
+#include "files/WorldFiles.hpp"
 #include "objects/rigging.hpp"
 #include "logic/EngineController.hpp"
 #include "logic/CommandsInterpreter.hpp"
+#include "logic/LevelController.hpp"
 #include "logic/scripting/scripting.hpp"
 #include "network/Network.hpp"
+#include "util/LinearAllocator.hpp"
 #include "util/listutil.hpp"
 #include "util/platform.hpp"
+#include "util/TaskScheduler.hpp"
 #include "window/Camera.hpp"
 #include "window/Events.hpp"
 #include "window/input.hpp"
 #include "window/Window.hpp"
+#include "world/Level.hpp"
+#include "world/World.hpp"
 #include "settings.hpp"
 
 #include <iostream>
+#include <algorithm>
 #include <assert.h>
+#include <chrono>
+#include <csignal>
+#include <thread>
 #include <glm/glm.hpp>
 #include <unordered_set>
 #include <functional>
@@ -48,6 +67,10 @@
 
 static debug::Logger logger("engine");
 
+/// @brief Target framerate if the framerate is not limited or
+/// synchronized with the display
+inline constexpr int DEFAULT_TARGET_FRAMERATE = 60;
+
 namespace fs = std::filesystem;
 
 static void create_channel(Engine* engine, std::string name, NumberSetting& setting) {
@@ -71,8 +94,16 @@ static std::unique_ptr<ImageData> load_icon(const fs::path& resdir) {
     return nullptr;
 }
 
-Engine::Engine(EngineSettings& settings, SettingsHandler& settingsHandler, EnginePaths* paths) 
-    : settings(settings), settingsHandler(settingsHandler), paths(paths),
+Engine::Engine(
+    EngineSettings& settings,
+    SettingsHandler& settingsHandler,
+    EnginePaths* paths,
+    CoreParameters params
+)
+    : params(std::move(params)),
+      settings(settings),
+      settingsHandler(settingsHandler),
+      paths(paths),
       interpreter(std::make_unique<cmd::CommandsInterpreter>()),
       network(network::Network::create(settings.network))
 {
@@ -82,15 +113,20 @@ Engine::Engine(EngineSettings& settings, SettingsHandler& settingsHandler, Engin
     auto resdir = paths->getResourcesFolder();
 
     controller = std::make_unique<EngineController>(this);
-    if (Window::initialize(&this->settings.display)){
-        throw initialize_error("could not initialize window");
-    }
-    if (auto icon = load_icon(resdir)) {
-        icon->flipY();
-        Window::setIcon(icon.get());
+    if (isHeadless()) {
+        // GL assets are not loaded
+        assets = std::make_unique<Assets>();
+    } else {
+        if (Window::initialize(&this->settings.display)){
+            throw initialize_error("could not initialize window");
+        }
+        if (auto icon = load_icon(resdir)) {
+            icon->flipY();
+            Window::setIcon(icon.get());
+        }
     }
     loadControls();
-    audio::initialize(settings.audio.enabled.get());
+    audio::initialize(settings.audio.enabled.get() && !isHeadless());
     create_channel(this, "master", settings.audio.volumeMaster);
     create_channel(this, "regular", settings.audio.volumeRegular);
     create_channel(this, "music", settings.audio.volumeMusic);
@@ -159,15 +195,73 @@ void Engine::updateHotkeys() {
     }
 }
 
-void Engine::saveScreenshot() {
-    auto image = Window::takeScreenshot();
-    image->flipY();
-    fs::path filename = paths->getNewScreenshotFile("png");
-    imageio::write(filename.string(), image.get());
-    logger.info() << "saved screenshot as " << filename.u8string();
+void Engine::saveScreenshot(screenshot_callback callback) {
+    screenshots.push_back({nullptr, std::move(callback)});
+}
+
+void Engine::updateScreenshots() {
+    for (auto it = screenshots.begin(); it != screenshots.end();) {
+        auto& readback = it->readback;
+        if (readback == nullptr) {
+            readback = std::make_unique<ReadbackBuffer>();
+            readback->read(Window::width, Window::height);
+            ++it;
+            continue;
+        }
+        if (!readback->isReady()) {
+            ++it;
+            continue;
+        }
+        std::shared_ptr<ImageData> image = readback->getImage();
+        auto callback = std::move(it->callback);
+        it = screenshots.erase(it);
+
+        fs::path file = paths->getNewScreenshotFile("png");
+        // reserving the file name for the next screenshots
+        files::write_bytes(file, nullptr, 0);
+        auto& scheduler = util::TaskScheduler::getDefault();
+        // tasks without callback do not refer to the engine
+        auto engine = callback ? this : nullptr;
+        scheduler.submit(
+            [engine, image, file, callback = std::move(callback)]() mutable {
+                std::string error;
+                try {
+                    image->flipY();
+                    auto bytes = png::encode_image(
+                        *image,
+                        util::TaskScheduler::getDefault().getThreadsCount()
+                    );
+                    const ubyte* data = bytes.data();
+                    if (!files::write_bytes(file, data, bytes.size())) {
+                        error = "could not write " + file.u8string();
+                    }
+                } catch (const std::exception& err) {
+                    error = err.what();
+                }
+                if (error.empty()) {
+                    logger.info() << "saved screenshot as " << file.u8string();
+                } else {
+                    logger.error() << "screenshot failed: " << error;
+                }
+                if (engine) {
+                    // the callback must be released in the main thread
+                    engine->postRunnable(
+                        [callback = std::move(callback), file, error]() {
+                            callback(file, error);
+                        }
+                    );
+                }
+            },
+            util::TaskScheduler::Priority::LOW
+        );
+    }
 }
 
 void Engine::mainloop() {
+    if (isHeadless()) {
+        runHeadless();
+        return;
+    }
     logger.info() << "starting menu screen";
     setScreen(std::make_shared<MenuScreen>(this));
 
@@ -175,38 +269,184 @@ void Engine::mainloop() {
     lastTime = Window::time();
     
     logger.info() << "engine started";
+    auto& profiler = debug::Profiler::getInstance();
     while (!Window::isShouldClose()){
         assert(screen != nullptr);
+        profiler.beginFrame();
         updateTimers();
         updateHotkeys();
-        audio::update(delta);
-
-        gui->act(delta, Viewport(Window::width, Window::height));
-        screen->update(delta);
+        {
+            debug::ProfileZone zone("audio");
+            audio::update(delta);
+        }
+        {
+            debug::ProfileZone zone("gui-act");
+            gui->act(delta, Viewport(Window::width, Window::height));
+        }
+        {
+            debug::ProfileZone zone("update");
+            screen->update(delta);
+            if (frameHandler) {
+                frameHandler();
+            }
+        }
 
         if (!Window::isIconified()) {
+            debug::ProfileScope scope("render");
             renderFrame(batch);
         }
+        updateScreenshots();
         Window::setFramerate(
             Window::isIconified() && settings.display.limitFpsIconified.get()
                 ? 20
                 : settings.display.framerate.get()
         );
 
+        {
+            debug::ProfileZone zone("network");
+            network->update();
+        }
+        {
+            debug::ProfileZone zone("post-runnables");
+            processPostRunnables();
+        }
+        workTime = static_cast<int64_t>((Window::time() - lastTime) * 1e6);
+        int framerate = settings.display.framerate.get();
+        targetFrameTime =
+            1'000'000 / (framerate > 0 ? framerate : DEFAULT_TARGET_FRAMERATE);
+        {
+            debug::ProfileZone zone("swap");
+            Window::swapBuffers();
+        }
+        profiler.endFrame();
+        GlyphAtlas::nextFrame();
+        Events::pollEvents();
+    }
+}
+
+/// @brief Set by SIGINT and SIGTERM in headless mode
+static volatile std::sig_atomic_t interrupted = 0;
+
+static void on_interrupt(int) {
+    interrupted = 1;
+}
+
+void Engine::runHeadless() {
+    if (params.world.empty()) {
+        throw initialize_error("headless mode requires a world name");
+    }
+    auto folder = paths->getWorldsFolder() / fs::u8path(params.world);
+    std::unique_ptr<Level> level;
+    if (fs::is_directory(folder)) {
+        logger.info() << "loading world " << folder.u8string();
+        loadWorldContent(folder);
+        auto worldFiles = std::make_shared<WorldFiles>(folder, settings.debug);
+        if (auto report = World::checkIndices(worldFiles, content.get())) {
+            throw initialize_error(
+                "world content does not match installed content, "
+                "the world must be opened in the game first"
+            );
+        }
+        level = World::load(worldFiles, settings, content.get(), contentPacks);
+    } else {
+        logger.info() << "creating world " << folder.u8string();
+        resetContent();
+        loadContent();
+        paths->setCurrentWorldFolder(folder);
+        auto generator = params.generator;
+        if (generator.empty()) {
+            generator = resPaths->readCombinedObject(
+                EnginePaths::CONFIG_DEFAULTS.u8string()
+            )["generator"].asString();
+        }
+        level = World::create(
+            params.world,
+            generator,
+            folder,
+            params.seed,
+            settings,
+            content.get(),
+            contentPacks
+        );
+    }
+    auto world = level->getWorld();
+    LevelController levelController(this, std::move(level));
+
+    std::signal(SIGINT, on_interrupt);
+    std::signal(SIGTERM, on_interrupt);
+
+    using clock = std::chrono::steady_clock;
+    uint tps = std::max(1U, params.tps);
+    // every update is a single simulation tick
+    levelController.setTickRate(tps);
+    auto interval = std::chrono::microseconds(1'000'000 / tps);
+    targetFrameTime = interval.count();
+    float tickDelta = 1.0f / tps;
+    auto nextTick = clock::now();
+    int64_t totalTime = 0;
+    int64_t maxTime = 0;
+    uint64_t tick = 0;
+
+    logger.info() << "headless simulation started";
+    while (!interrupted && !quitSignal &&
+           (params.ticks == 0 || tick < params.ticks)) {
+        auto start = clock::now();
+        delta = tickDelta;
+        frame++;
+        world->updateTimers(tickDelta);
+        levelController.update(tickDelta, false, false);
         network->update();
         processPostRunnables();
-
-        Window::swapBuffers();
-        Events::pollEvents();
+        tick++;
+
+        auto end = clock::now();
+        int64_t mcs = std::chrono::duration_cast<std::chrono::microseconds>(
+            end - start
+        ).count();
+        workTime = mcs;
+        totalTime += mcs;
+        maxTime = std::max(maxTime, mcs);
+        if (!params.benchmark) {
+            // late ticks are not caught up
+            nextTick = std::max(nextTick + interval, end);
+            std::this_thread::sleep_until(nextTick);
+        }
     }
+    logger.info() << "headless simulation finished after " << tick << " ticks";
+    if (params.benchmark && tick > 0) {
+        std::cout << "ticks: " << tick
+                  << " avg: " << totalTime / 1000.0 / tick << " ms"
+                  << " max: " << maxTime / 1000.0 << " ms" << std::endl;
+    }
+    levelController.saveWorld();
+    levelController.onWorldQuit();
+    paths->setCurrentWorldFolder(fs::path());
 }
 
 void Engine::renderFrame(Batch2D& batch) {
+    static auto& scratchGauge =
+        debug::Metrics::getInstance().gauge("render.frame-scratch");
+    auto& scratch = util::LinearAllocator::getFrame();
+    scratchGauge.set(scratch.getUsed());
+    scratch.reset();
     screen->draw(delta);
+    {
+        debug::ProfileScope scope("ui");
+        Viewport viewport(Window::width, Window::height);
+        DrawContext ctx(nullptr, viewport, &batch);
+        gui->draw(ctx, *assets);
+    }
+}
+
+void Engine::quit() {
+    quitSignal = true;
+    if (!isHeadless()) {
+        Window::setShouldClose(true);
+    }
+}
 
-    Viewport viewport(Window::width, Window::height);
-    DrawContext ctx(nullptr, viewport, &batch);
-    gui->draw(ctx, *assets);
+void Engine::setFrameHandler(runnable handler) {
+    frameHandler = std::move(handler);
 }
 
 void Engine::processPostRunnables() {
@@ -216,6 +456,7 @@ void Engine::processPostRunnables() {
         postRunnables.pop();
     }
     scripting::process_post_runnables();
+    scripting::update();
 }
 
 void Engine::saveSettings() {
@@ -232,7 +473,9 @@ Engine::~Engine() {
         screen->onEngineShutdown();
         screen.reset();
     }
+    screenshots.clear();
     content.reset();
+    retainedContent.reset();
     assets.reset();
     interpreter.reset();
     gui.reset();
@@ -241,7 +484,9 @@ Engine::~Engine() {
     network.reset();
     scripting::close();
     logger.info() << "scripting finished";
-    Window::terminate();
+    if (!isHeadless()) {
+        Window::terminate();
+    }
     logger.info() << "engine finished";
 }
 
@@ -266,9 +511,78 @@ PacksManager Engine::createPacksManager(const fs::path& worldFolder) {
 void Engine::loadAssets() {
     logger.info() << "loading assets";
     Shader::preprocessor->setPaths(resPaths.get());
+    gui::UiXmlReader::clearCache();
+    Shader::preprocessor->define(
+        "CHUNK_POS_SCALE", std::to_string(CHUNK_VERTEX_POS_SCALE)
+    );
 
     auto new_assets = std::make_unique<Assets>();
     AssetsLoader loader(new_assets.get(), resPaths.get());
+    if (settings.graphics.textureStreaming.get()) {
+        loader.addLoader(AssetType::TEXTURE, assetload::streamed_texture);
+    }
+    auto cacheFolder = paths->getCacheFolder() / "atlases";
+    if (settings.graphics.compressedAtlases.get()) {
+        loader.addLoader(
+            AssetType::ATLAS,
+            [cacheFolder](
+                AssetsLoader* loader,
+                const ResPaths* paths,
+                const std::string& directory,
+                const std::string& name,
+                std::shared_ptr<AssetCfg> config
+            ) {
+                return assetload::compressed_atlas(
+                    loader, paths, directory, name, config, cacheFolder
+                );
+            }
+        );
+    } else {
+        loader.addLoader(
+            AssetType::ATLAS,
+            [cacheFolder](
+                AssetsLoader* loader,
+                const ResPaths* paths,
+                const std::string& directory,
+                const std::string& name,
+                std::shared_ptr<AssetCfg> config
+            ) {
+                return assetload::cached_atlas(
+                    loader, paths, directory, name, config, cacheFolder
+                );
+            }
+        );
+    }
+    auto shadersCacheFolder = paths->getCacheFolder() / "shaders";
+    loader.addLoader(
+        AssetType::SHADER,
+        [shadersCacheFolder](
+            AssetsLoader* loader,
+            const ResPaths* paths,
+            const std::string& filename,
+            const std::string& name,
+            std::shared_ptr<AssetCfg> config
+        ) {
+            return assetload::cached_shader(
+                loader, paths, filename, name, config, shadersCacheFolder
+            );
+        }
+    );
+    auto modelsCacheFolder = paths->getCacheFolder() / "models";
+    loader.addLoader(
+        AssetType::MODEL,
+        [modelsCacheFolder](
+            AssetsLoader* loader,
+            const ResPaths* paths,
+            const std::string& filename,
+            const std::string& name,
+            std::shared_ptr<AssetCfg> config
+        ) {
+            return assetload::cached_model(
+                loader, paths, filename, name, config, modelsCacheFolder
+            );
+        }
+    );
     AssetsLoader::addDefaults(loader, content.get());
 
     // no need
@@ -326,9 +640,80 @@ static void load_configs(const fs::path& root) {
     }
 }
 
-void Engine::loadContent() {
+/// @brief Hash of the packs list and their files sizes and modification
+/// times. Assets loading settings are included as reused content keeps
+/// the loaded assets
+static uint64_t content_signature(
+    const std::vector<ContentPack>& packs, const EngineSettings& settings
+) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto put = [&hash](const void* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ static_cast<const ubyte*>(data)[i]) *
+                   1099511628211ULL;
+        }
+    };
+    auto putString = [&put](const std::string& str) {
+        put(str.data(), str.size() + 1);
+    };
+    bool flags[] {
+        settings.graphics.textureStreaming.get(),
+        settings.graphics.compressedAtlases.get()
+    };
+    put(flags, sizeof(flags));
+    for (const auto& pack : packs) {
+        putString(pack.id);
+        putString(pack.folder.u8string());
+        if (!fs::is_directory(pack.folder)) {
+            continue;
+        }
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(pack.folder, ec), end;
+             it != end;
+             it.increment(ec)) {
+            if (!it->is_regular_file(ec)) {
+                continue;
+            }
+            auto size = static_cast<uint64_t>(it->file_size(ec));
+            auto time = static_cast<int64_t>(
+                it->last_write_time(ec).time_since_epoch().count()
+            );
+            putString(it->path().u8string());
+            put(&size, sizeof(size));
+            put(&time, sizeof(time));
+        }
+    }
+    return hash;
+}
+
+static bool has_packs(
+    const std::vector<ContentPack>& packs,
+    const std::vector<std::string>& names
+) {
+    for (const auto& name : names) {
+        auto found = std::find_if(
+            packs.begin(),
+            packs.end(),
+            [&name](const auto& pack) { return pack.id == name; }
+        );
+        if (found == packs.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Engine::releaseRetainedContent() {
+    if (retainedContent == nullptr) {
+        return;
+    }
+    std::swap(contentPacks, retainedContent->packs);
     scripting::cleanup();
+    std::swap(contentPacks, retainedContent->packs);
+    retainedContent.reset();
+}
 
+void Engine::loadContent() {
     auto resdir = paths->getResourcesFolder();
 
     std::vector<std::string> names;
@@ -347,6 +732,24 @@ void Engine::loadContent() {
 
     auto corePack = ContentPack::createCore(paths);
 
+    std::vector<ContentPack> signaturePacks {corePack};
+    signaturePacks.insert(
+        signaturePacks.end(), contentPacks.begin(), contentPacks.end()
+    );
+    uint64_t signature = content_signature(signaturePacks, settings);
+    if (retainedContent && retainedContent->signature == signature) {
+        logger.info() << "reusing loaded content";
+        content = std::move(retainedContent->content);
+        retainedContent.reset();
+        interpreter->reset();
+        scripting::on_content_load(content.get());
+        langs::setup(resdir, langs::current->getId(), contentPacks);
+        return;
+    }
+    releaseRetainedContent();
+    scripting::cleanup();
+    contentSignature = signature;
+
     // Setup filesystem entry points
     std::vector<PathsRoot> resRoots {
         {"core", corePack.folder}
@@ -356,13 +759,20 @@ void Engine::loadContent() {
     }
     resPaths = std::make_unique<ResPaths>(resdir, resRoots);
 
-    // Load content
+    // Load content. Definition files are parsed in parallel, content units
+    // are created in the packs order
+    std::vector<const ContentPack*> packs {&corePack};
+    for (const auto& pack : contentPacks) {
+        packs.push_back(&pack);
+    }
+    auto parsed =
+        ContentLoader::parseDefinitions(packs, paths->getCacheFolder());
     {
-        ContentLoader(&corePack, contentBuilder, *resPaths).load();
+        ContentLoader(&corePack, contentBuilder, *resPaths, &parsed).load();
         load_configs(corePack.folder);
     }
     for (auto& pack : contentPacks) {
-        ContentLoader(&pack, contentBuilder, *resPaths).load();
+        ContentLoader(&pack, contentBuilder, *resPaths, &parsed).load();
         load_configs(pack.folder);
     }
     content = contentBuilder.build();
@@ -372,21 +782,36 @@ void Engine::loadContent() {
     ContentLoader::loadScripts(*content);
 
     langs::setup(resdir, langs::current->getId(), contentPacks);
-    loadAssets();
-    onAssetsLoaded();
+    if (!isHeadless()) {
+        loadAssets();
+        onAssetsLoaded();
+    }
 }
 
 void Engine::resetContent() {
-    scripting::cleanup();
     auto resdir = paths->getResourcesFolder();
+    auto manager = createPacksManager(fs::path());
+    manager.scan();
+    if (content && has_packs(contentPacks, basePacks)) {
+        // loaded assets cover the menu, resource paths are kept
+        // as assets may refer to them
+        releaseRetainedContent();
+        retainedContent = std::make_unique<RetainedContent>(RetainedContent {
+            std::move(contentPacks), std::move(content), contentSignature
+        });
+        load_configs(ContentPack::createCore(paths).folder);
+        langs::setup(resdir, langs::current->getId(), {});
+        contentPacks = manager.getAll(basePacks);
+        return;
+    }
+    releaseRetainedContent();
+    scripting::cleanup();
     std::vector<PathsRoot> resRoots;
     {
         auto pack = ContentPack::createCore(paths);
         resRoots.push_back({"core", pack.folder});
         load_configs(pack.folder);
     }
-    auto manager = createPacksManager(fs::path());
-    manager.scan();
     for (const auto& pack : manager.getAll(basePacks)) {
         resRoots.push_back({pack.id, pack.folder});
     }
@@ -395,8 +820,10 @@ void Engine::resetContent() {
     content.reset();
 
     langs::setup(resdir, langs::current->getId(), contentPacks);
-    loadAssets();
-    onAssetsLoaded();
+    if (!isHeadless()) {
+        loadAssets();
+        onAssetsLoaded();
+    }
 
     contentPacks = manager.getAll(basePacks);
 }
@@ -427,6 +854,14 @@ double Engine::getDelta() const {
     return delta;
 }
 
+int64_t Engine::getWorkTime() const {
+    return workTime;
+}
+
+int64_t Engine::getTargetFrameTime() const {
+    return targetFrameTime;
+}
+
 void Engine::setScreen(std::shared_ptr<Screen> screen) {
     // reset audio channels (stop all sources)
     audio::reset_channel(audio::get_channel_index("regular"));
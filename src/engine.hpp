@@ -20,6 +20,7 @@
 
 class Screen;
 class EnginePaths;
+class ReadbackBuffer;
 class ResPaths;
 class Batch2D;
 class EngineController;
@@ -40,12 +41,49 @@ namespace network {
     class Network;
 }
 
+/// @brief Engine run parameters set from the command line
+struct CoreParameters {
+    /// @brief Run the world simulation without window, rendering and audio
+    bool headless = false;
+    /// @brief Name of the world simulated in headless mode. The world is
+    /// created if not exists
+    std::string world;
+    /// @brief Seed of created world
+    uint64_t seed = 0;
+    /// @brief Generator of created world, default generator if empty
+    std::string generator;
+    /// @brief Number of world ticks before quit, 0 - until interrupted
+    uint64_t ticks = 0;
+    /// @brief World ticks per second
+    uint tps = 20;
+    /// @brief Do not wait between ticks and print ticks timing on quit
+    bool benchmark = false;
+    /// @brief Name of the world which region files are checked for
+    /// corruption instead of running the engine
+    std::string verifyWorld;
+    /// @brief Name of the world packed into archiveFile instead of
+    /// running the engine
+    std::string exportWorld;
+    /// @brief Name of the world unpacked from archiveFile instead of
+    /// running the engine
+    std::string importWorld;
+    /// @brief World archive file (see world_archive)
+    std::string archiveFile;
+};
+
+/// @brief Called in the main thread when a screenshot is saved
+/// @param file screenshot file
+/// @param error error message, empty if saved successfully
+using screenshot_callback =
+    std::function<void(const fs::path& file, const std::string& error)>;
+
 class initialize_error : public std::runtime_error {
 public:
     initialize_error(const std::string& message) : std::runtime_error(message) {}
 };
 
 class Engine : public util::ObjectsKeeper {
+    CoreParameters params;
     EngineSettings& settings;
     SettingsHandler& settingsHandler;
     EnginePaths* paths;
@@ -56,15 +94,42 @@ class Engine : public util::ObjectsKeeper {
     std::unique_ptr<Content> content;
     std::unique_ptr<ResPaths> resPaths;
     std::queue<runnable> postRunnables;
+    runnable frameHandler;
     std::recursive_mutex postRunnablesMutex;
     std::unique_ptr<EngineController> controller;
     std::unique_ptr<cmd::CommandsInterpreter> interpreter;
     std::unique_ptr<network::Network> network;
     std::vector<std::string> basePacks;
 
+    /// @brief World content kept loaded after leaving the world. Reused
+    /// with the assets and scripts by the next loadContent if packs and
+    /// their files are not changed
+    struct RetainedContent {
+        std::vector<ContentPack> packs;
+        std::unique_ptr<Content> content;
+        uint64_t signature;
+    };
+    std::unique_ptr<RetainedContent> retainedContent;
+    /// @brief Loaded packs and files signature, see content_signature
+    uint64_t contentSignature = 0;
+
+    struct Screenshot {
+        /// @brief Pixels read after the frame is rendered,
+        /// nullptr until then
+        std::unique_ptr<ReadbackBuffer> readback;
+        screenshot_callback callback;
+    };
+    std::vector<Screenshot> screenshots;
+
     uint64_t frame = 0;
     double lastTime = 0.0;
     double delta = 0.0;
+    /// @brief Main thread work time of the last frame excluding buffers
+    /// swap and framerate limiting (microseconds)
+    int64_t workTime = 0;
+    /// @brief Frame time the engine aims to fit (microseconds)
+    int64_t targetFrameTime = 0;
+    bool quitSignal = false;
 
     std::unique_ptr<gui::GUI> gui;
     
@@ -74,16 +139,33 @@ class Engine : public util::ObjectsKeeper {
     void updateTimers();
     void updateHotkeys();
     void renderFrame(Batch2D& batch);
+    void updateScreenshots();
     void processPostRunnables();
     void loadAssets();
+    void runHeadless();
+    /// @brief Unload scripts of the retained content and release it
+    void releaseRetainedContent();
 public:
-    Engine(EngineSettings& settings, SettingsHandler& settingsHandler, EnginePaths* paths);
+    Engine(
+        EngineSettings& settings,
+        SettingsHandler& settingsHandler,
+        EnginePaths* paths,
+        CoreParameters params = {}
+    );
     ~Engine();
  
     /// @brief Start main engine input/update/render loop. 
-    /// Automatically sets MenuScreen
+    /// Automatically sets MenuScreen.
+    /// In headless mode runs the world simulation loop instead
     void mainloop();
 
+    /// @brief Stop the main loop after the current frame
+    void quit();
+
+    bool isHeadless() const {
+        return params.headless;
+    }
+
     /// @brief Called after assets loading when all engine systems are initialized
     void onAssetsLoaded();
     
@@ -97,9 +179,14 @@ public:
     /// @param locale isolanguage_ISOCOUNTRY (example: en_US)
     void setLanguage(std::string locale);
 
-    /// @brief Load all selected content-packs and reload assets
+    /// @brief Load all selected content-packs and reload assets.
+    /// Retained content (see resetContent) is reused if the packs
+    /// and their files are the same
     void loadContent();
 
+    /// @brief Switch to the base packs used by the menu. Content of the
+    /// world left is kept with assets and scripts if it covers the base
+    /// packs, so the same world content is not loaded again
     void resetContent();
     
     /// @brief Collect world content-packs and load content
@@ -113,6 +200,14 @@ public:
     /// @brief Get current frame delta-time
     double getDelta() const;
 
+    /// @brief Get main thread work time of the last frame excluding
+    /// buffers swap and framerate limiting (microseconds)
+    int64_t getWorkTime() const;
+
+    /// @brief Get frame time the engine aims to fit: framerate limit or
+    /// simulation tick interval in headless mode (microseconds)
+    int64_t getTargetFrameTime() const;
+
     /// @brief Get active assets storage instance
     Assets* getAssets();
     
@@ -144,7 +239,15 @@ public:
     /// @brief Enqueue function call to the end of current frame in draw thread
     void postRunnable(const runnable& callback);
 
-    void saveScreenshot();
+    /// @brief Set function called every frame after the screen update
+    /// (used by tools driving the engine, like benchmarks)
+    /// @param handler nullable handler
+    void setFrameHandler(runnable handler);
+
+    /// @brief Save screenshot of the next rendered frame. Pixels are read
+    /// asynchronously, PNG is encoded and written by worker threads
+    /// @param callback nullable completion callback
+    void saveScreenshot(screenshot_callback callback = nullptr);
 
     EngineController* getController();
     cmd::CommandsInterpreter* getCommandsInterpreter();
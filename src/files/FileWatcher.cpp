@@ -0,0 +1,54 @@
+#include "FileWatcher.hpp"
+
+FileWatcher::FileWatcher(std::vector<fs::path> folders)
+    : folders(std::move(folders)) {
+    files = scan();
+}
+
+std::unordered_map<std::string, FileWatcher::FileState> FileWatcher::scan(
+) const {
+    std::unordered_map<std::string, FileState> states;
+    for (const auto& folder : folders) {
+        std::error_code ec;
+        if (!fs::is_directory(folder, ec)) {
+            continue;
+        }
+        // files may be changed while scanning, errors are skipped
+        for (fs::recursive_directory_iterator it(folder, ec), end;
+             it != end;
+             it.increment(ec)) {
+            if (!it->is_regular_file(ec)) {
+                continue;
+            }
+            auto size = it->file_size(ec);
+            auto time = it->last_write_time(ec).time_since_epoch().count();
+            if (ec) {
+                continue;
+            }
+            states[it->path().u8string()] = {
+                size, static_cast<int64_t>(time)};
+        }
+    }
+    return states;
+}
+
+std::vector<fs::path> FileWatcher::poll(std::vector<fs::path>* removed) {
+    auto states = scan();
+    std::vector<fs::path> changed;
+    for (const auto& [path, state] : states) {
+        const auto& found = files.find(path);
+        if (found == files.end() || found->second.size != state.size ||
+            found->second.time != state.time) {
+            changed.push_back(fs::u8path(path));
+        }
+    }
+    if (removed) {
+        for (const auto& [path, _] : files) {
+            if (states.find(path) == states.end()) {
+                removed->push_back(fs::u8path(path));
+            }
+        }
+    }
+    files = std::move(states);
+    return changed;
+}
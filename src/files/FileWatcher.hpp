@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/// @brief Polling watcher of files in folders (including subfolders).
+/// Changes are detected by files sizes and modification times, so it works
+/// the same on all platforms without system notifications
+class FileWatcher {
+    struct FileState {
+        uintmax_t size;
+        int64_t time;
+    };
+    std::vector<fs::path> folders;
+    std::unordered_map<std::string, FileState> files;
+
+    std::unordered_map<std::string, FileState> scan() const;
+public:
+    /// @param folders watched folders, missing ones are skipped
+    FileWatcher(std::vector<fs::path> folders);
+
+    /// @brief Get files changed or added since the last call
+    /// (or construction)
+    /// @param removed destination of the removed files (optional)
+    std::vector<fs::path> poll(std::vector<fs::path>* removed = nullptr);
+};
@@ -1,35 +1,142 @@
 #include "WorldRegions.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <limits>
 
+#include "constants.hpp"
+#include "coders/crc32c.hpp"
+#include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
 #include "util/data_io.hpp"
 
 #define REGION_FORMAT_MAGIC ".VOXREG"
 
+static debug::Logger logger("regions-layer");
+
+/// @brief Max size of prefetched and not read chunks data of a layer
+static constexpr size_t PREFETCH_MEMORY_BUDGET = 8 * 1024 * 1024;
+
+static auto& reads = debug::Metrics::getInstance().counter("regions.reads");
+static auto& readBytes =
+    debug::Metrics::getInstance().counter("regions.read-bytes");
+static auto& writes = debug::Metrics::getInstance().counter("regions.writes");
+static auto& writtenBytes =
+    debug::Metrics::getInstance().counter("regions.written-bytes");
+static auto& corruptedChunks =
+    debug::Metrics::getInstance().counter("regions.corrupted-chunks");
+
+/// @brief Position of the table offset in the region file header
+static constexpr size_t TABLE_OFFSET_POSITION = 10;
+
+/// @brief Size of the region file header: magic number, version,
+/// compression method and the table offset (since
+/// REGION_TABLE_OFFSET_VERSION)
+static size_t get_header_size(int version) {
+    return static_cast<uint>(version) >= REGION_TABLE_OFFSET_VERSION
+               ? REGION_HEADER_SIZE
+               : TABLE_OFFSET_POSITION;
+}
+
+/// @brief Size of the region file table: chunks entries checksums
+/// (since REGION_CHECKSUMS_VERSION) followed by offsets
+static size_t get_table_size(int version) {
+    return REGION_CHUNKS_COUNT *
+           (static_cast<uint>(version) >= REGION_CHECKSUMS_VERSION ? 8 : 4);
+}
+
+/// @brief Get position of the chunks offsets in the region file
+static size_t get_offsets_position(const regfile& file) {
+    return file.tableOffset + get_table_size(file.version) -
+           REGION_CHUNKS_COUNT * 4;
+}
+
+/// @brief Checksum of chunk entry: compressed and source sizes
+/// followed by compressed data
+static uint32_t entry_checksum(
+    uint32_t size, uint32_t srcSize, const ubyte* data
+) {
+    uint32_t header[2] {dataio::h2le(size), dataio::h2le(srcSize)};
+    uint32_t crc =
+        crc32c::compute(reinterpret_cast<const ubyte*>(header), sizeof(header));
+    return crc32c::update(crc, data, size);
+}
+
+static void report_corrupted(const fs::path& filename, int index) {
+    corruptedChunks.add();
+    logger.error() << "local chunk " << index % REGION_SIZE << ", "
+                   << index / REGION_SIZE << " data in region file "
+                   << filename.u8string()
+                   << " is corrupted (checksum mismatch), chunk is skipped";
+}
+
 static fs::path get_region_filename(int x, int z) {
     return fs::path(std::to_string(x) + "_" + std::to_string(z) + ".bin");
 }
 
-/// @brief Read missing chunks data (null pointers) from region file
-static void fetch_chunks(WorldRegion* region, int x, int z, regfile* file) {
+/// @brief Read missing chunks data (null pointers) from region file.
+/// Removed chunks are not restored.
+static void fetch_chunks(
+    RegionsLayer& layer, WorldRegion* region, int x, int z, regfile* file
+) {
     auto* chunks = region->getChunks();
     auto sizes = region->getSizes();
 
     for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
         int chunk_x = (i % REGION_SIZE) + x * REGION_SIZE;
         int chunk_z = (i / REGION_SIZE) + z * REGION_SIZE;
-        if (chunks[i] == nullptr) {
-            chunks[i] = RegionsLayer::readChunkData(
+        if (chunks[i] == nullptr && !region->isModified(i)) {
+            chunks[i] = layer.readChunkData(
                     chunk_x, chunk_z, sizes[i][0], sizes[i][1], file);
         }
     }
 }
 
-regfile::regfile(fs::path filename) : file(std::move(filename)) {
-    if (file.length() < REGION_HEADER_SIZE)
+/// @brief Convert chunk data compressed with one method to another
+static std::unique_ptr<ubyte[]> transcode(
+    std::unique_ptr<ubyte[]> data,
+    uint32_t& size,
+    uint32_t srcSize,
+    compression::Method srcMethod,
+    compression::Method dstMethod
+) {
+    if (data == nullptr || srcMethod == dstMethod) {
+        return data;
+    }
+    if (srcMethod != compression::Method::NONE) {
+        data = compression::decompress(data.get(), size, srcSize, srcMethod);
+    }
+    size = srcSize;
+    if (dstMethod == compression::Method::NONE) {
+        return data;
+    }
+    size_t compressedSize;
+    data = compression::compress(data.get(), srcSize, compressedSize, dstMethod);
+    size = compressedSize;
+    return data;
+}
+
+regfile::regfile(const fs::path& filename, bool mapped) : filename(filename) {
+    if (mapped && files::mmfile::is_supported()) {
+        try {
+            mapping = std::make_unique<files::mmfile>(filename);
+        } catch (const std::runtime_error&) {
+            // falling back to the stream reading
+            mapping = nullptr;
+        }
+    }
+    if (mapping == nullptr) {
+        file = std::make_unique<files::rafile>(filename);
+    }
+    size_t length = mapping ? mapping->length() : file->length();
+    if (length < TABLE_OFFSET_POSITION + REGION_CHUNKS_COUNT * 4)
         throw std::runtime_error("incomplete region file header");
-    char header[REGION_HEADER_SIZE];
-    file.read(header, REGION_HEADER_SIZE);
+    char header[REGION_HEADER_SIZE] {};
+    if (mapping) {
+        std::memcpy(header, mapping->data(), REGION_HEADER_SIZE);
+    } else {
+        file->read(header, REGION_HEADER_SIZE);
+    }
 
     // avoid of use strcmp_s
     if (std::string(header, std::strlen(REGION_FORMAT_MAGIC)) !=
@@ -42,95 +149,304 @@ regfile::regfile(fs::path filename) : file(std::move(filename)) {
             "region format " + std::to_string(version) + " is not supported"
         );
     }
+    size_t headerSize = get_header_size(version);
+    size_t tableSize = get_table_size(version);
+    if (length < headerSize + tableSize) {
+        throw std::runtime_error("incomplete region file header");
+    }
+    if (static_cast<uint>(version) >= REGION_TABLE_OFFSET_VERSION) {
+        // bytes after the table are left by an interrupted append
+        uint32_t offset;
+        std::memcpy(&offset, header + TABLE_OFFSET_POSITION, 4);
+        tableOffset = dataio::le2h(offset);
+        if (tableOffset < headerSize || tableOffset > length - tableSize) {
+            throw std::runtime_error("invalid region file table offset");
+        }
+    } else {
+        tableOffset = length - tableSize;
+    }
+    auto method = static_cast<ubyte>(header[9]);
+    if (method > static_cast<ubyte>(compression::Method::ZSTD)) {
+        throw illegal_region_format(
+            "unknown region compression method " + std::to_string(method)
+        );
+    }
+    compression = static_cast<compression::Method>(method);
 }
 
-std::unique_ptr<ubyte[]> regfile::read(int index, uint32_t& size, uint32_t& srcSize) {
-    size_t file_size = file.length();
-    size_t table_offset = file_size - REGION_CHUNKS_COUNT * 4;
+bool regfile::hasChecksums() const {
+    return static_cast<uint>(version) >= REGION_CHECKSUMS_VERSION;
+}
 
+/// @brief Read little-endian uint32 from the file
+static uint32_t read_uint32(
+    const files::mmfile* mapping, files::rafile* file, size_t offset
+) {
     uint32_t buff32;
-    file.seekg(table_offset + index * 4);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
+    if (mapping) {
+        std::memcpy(&buff32, mapping->data() + offset, 4);
+    } else {
+        file->seekg(offset);
+        file->read(reinterpret_cast<char*>(&buff32), 4);
+    }
+    return dataio::le2h(buff32);
+}
+
+uint32_t regfile::readChecksum(int index) const {
+    return read_uint32(mapping.get(), file.get(), tableOffset + index * 4);
+}
+
+const ubyte* regfile::viewEntry(
+    int index, uint32_t& size, uint32_t& srcSize, bool& valid
+) const {
+    const ubyte* bytes = mapping->data();
+    size_t data_end = tableOffset;
+    size_t offsets_position = get_offsets_position(*this);
+
+    uint32_t buff32;
+    std::memcpy(&buff32, bytes + offsets_position + index * 4, 4);
     uint32_t offset = dataio::le2h(buff32);
     if (offset == 0) {
         return nullptr;
     }
+    if (offset + 8 > data_end) {
+        throw std::runtime_error("corrupted region file");
+    }
+    std::memcpy(&buff32, bytes + offset, 4);
+    size = dataio::le2h(buff32);
+    std::memcpy(&buff32, bytes + offset + 4, 4);
+    srcSize = dataio::le2h(buff32);
+    if (offset + 8 + static_cast<size_t>(size) > data_end) {
+        throw std::runtime_error("corrupted region file");
+    }
+    valid = !hasChecksums() ||
+            crc32c::compute(bytes + offset, size + 8) == readChecksum(index);
+    return bytes + offset + 8;
+}
+
+std::unique_ptr<ubyte[]> regfile::readEntry(
+    int index, uint32_t& size, uint32_t& srcSize, bool& valid
+) {
+    size_t data_end = tableOffset;
+    size_t offsets_position = get_offsets_position(*this);
 
-    file.seekg(offset);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
+    uint32_t offset =
+        read_uint32(nullptr, file.get(), offsets_position + index * 4);
+    if (offset == 0) {
+        return nullptr;
+    }
+    if (offset + 8 > data_end) {
+        throw std::runtime_error("corrupted region file");
+    }
+    ubyte header[8];
+    file->seekg(offset);
+    file->read(reinterpret_cast<char*>(header), 8);
+    uint32_t buff32;
+    std::memcpy(&buff32, header, 4);
     size = dataio::le2h(buff32);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
+    std::memcpy(&buff32, header + 4, 4);
     srcSize = dataio::le2h(buff32);
+    if (offset + 8 + static_cast<size_t>(size) > data_end) {
+        throw std::runtime_error("corrupted region file");
+    }
 
     auto data = std::make_unique<ubyte[]>(size);
-    file.read(reinterpret_cast<char*>(data.get()), size);
+    file->read(reinterpret_cast<char*>(data.get()), size);
+    valid = !hasChecksums() ||
+            crc32c::update(crc32c::compute(header, 8), data.get(), size) ==
+                readChecksum(index);
     return data;
 }
 
+const ubyte* regfile::view(int index, uint32_t& size, uint32_t& srcSize) const {
+    bool valid;
+    auto data = viewEntry(index, size, srcSize, valid);
+    if (data == nullptr) {
+        return nullptr;
+    }
+    if (!valid) {
+        report_corrupted(filename, index);
+        return nullptr;
+    }
+    reads.add();
+    readBytes.add(size + 8);
+    return data;
+}
 
-void RegionsLayer::closeRegFile(glm::ivec2 coord) {
-    openRegFiles.erase(coord);
-    regFilesCv.notify_one();
+size_t regfile::readTable(
+    uint32_t* offsets, uint32_t* sizes, uint32_t* checksums
+) {
+    size_t offsets_position = get_offsets_position(*this);
+    size_t data_end = tableOffset;
+
+    if (mapping) {
+        std::memcpy(offsets, mapping->data() + offsets_position,
+                    REGION_CHUNKS_COUNT * 4);
+    } else {
+        file->seekg(offsets_position);
+        file->read(reinterpret_cast<char*>(offsets), REGION_CHUNKS_COUNT * 4);
+    }
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        offsets[i] = dataio::le2h(offsets[i]);
+        if (checksums) {
+            checksums[i] = offsets[i] && hasChecksums() ? readChecksum(i) : 0;
+        }
+        if (offsets[i] == 0) {
+            sizes[i] = 0;
+            continue;
+        }
+        if (offsets[i] + 8 > data_end) {
+            throw std::runtime_error("corrupted region file");
+        }
+        sizes[i] = read_uint32(mapping.get(), file.get(), offsets[i]);
+    }
+    return data_end;
 }
 
-regfile_ptr RegionsLayer::useRegFile(glm::ivec2 coord) {
-    auto* file = openRegFiles[coord].get();
-    file->inUse = true;
-    return regfile_ptr(file, &regFilesCv);
+std::unique_ptr<ubyte[]> regfile::read(int index, uint32_t& size, uint32_t& srcSize) {
+    if (mapping) {
+        const ubyte* src = view(index, size, srcSize);
+        if (src == nullptr) {
+            return nullptr;
+        }
+        auto data = std::make_unique<ubyte[]>(size);
+        std::memcpy(data.get(), src, size);
+        return data;
+    }
+    bool valid;
+    auto data = readEntry(index, size, srcSize, valid);
+    if (data == nullptr) {
+        return nullptr;
+    }
+    if (!valid) {
+        report_corrupted(filename, index);
+        return nullptr;
+    }
+    reads.add();
+    readBytes.add(size + 8);
+    return data;
 }
 
-// Marks regfile as used and unmarks when shared_ptr dies
-regfile_ptr RegionsLayer::getRegFile(glm::ivec2 coord, bool create) {
-    {
-        std::lock_guard lock(regFilesMutex);
-        const auto found = openRegFiles.find(coord);
-        if (found != openRegFiles.end()) {
-            if (found->second->inUse) {
-                throw std::runtime_error("regfile is currently in use");
-            }
-            return useRegFile(found->first);
+ChunkIntegrity regfile::check(int index) {
+    uint32_t size, srcSize;
+    bool valid;
+    try {
+        bool present = mapping
+            ? viewEntry(index, size, srcSize, valid) != nullptr
+            : readEntry(index, size, srcSize, valid) != nullptr;
+        if (!present) {
+            return ChunkIntegrity::ABSENT;
         }
+    } catch (const std::runtime_error&) {
+        return ChunkIntegrity::CORRUPTED;
     }
-    if (create) {
-        return createRegFile(coord);
+    if (!valid) {
+        return ChunkIntegrity::CORRUPTED;
     }
-    return nullptr;
+    return hasChecksums() ? ChunkIntegrity::VALID : ChunkIntegrity::UNCHECKED;
 }
 
-regfile_ptr RegionsLayer::createRegFile(glm::ivec2 coord) {
-    auto file =  folder / get_region_filename(coord[0], coord[1]);
-    if (!fs::exists(file)) {
-        return nullptr;
+
+RegFilesStripe& RegionsLayer::getRegFilesStripe(glm::ivec2 coord) {
+    return regFiles[std::hash<glm::ivec2>()(coord) % regFiles.size()];
+}
+
+void RegionsLayer::closeRegFile(glm::ivec2 coord) {
+    auto& stripe = getRegFilesStripe(coord);
+    std::unique_lock lock(stripe.mutex);
+    while (true) {
+        const auto found = stripe.files.find(coord);
+        if (found == stripe.files.end()) {
+            return;
+        }
+        if (!found->second.file->inUse) {
+            stripe.lru.erase(found->second.lruPosition);
+            stripe.files.erase(found);
+            break;
+        }
+        stripe.cv.wait(lock);
     }
-    if (openRegFiles.size() == MAX_OPEN_REGION_FILES) {
-        std::unique_lock lock(regFilesMutex);
-        while (true) {
-            bool closed = false;
-            // FIXME: bad choosing algorithm
-            for (auto& entry : openRegFiles) {
-                if (!entry.second->inUse) {
-                    closeRegFile(entry.first);
-                    closed = true;
-                    break;
-                }
+    lock.unlock();
+    stripe.cv.notify_all();
+}
+
+/// @brief Close the least recently used file not in use if the stripe is full
+/// @return true if stripe has a free slot
+static bool free_stripe_slot(RegFilesStripe& stripe, size_t capacity) {
+    if (stripe.files.size() < capacity) {
+        return true;
+    }
+    for (const auto& coord : stripe.lru) {
+        const auto found = stripe.files.find(coord);
+        if (!found->second.file->inUse) {
+            stripe.lru.erase(found->second.lruPosition);
+            stripe.files.erase(found);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Marks regfile as used and unmarks when regfile_ptr dies
+regfile_ptr RegionsLayer::getRegFile(glm::ivec2 coord, bool create) {
+    constexpr size_t capacity =
+        std::max(1u, MAX_OPEN_REGION_FILES / REGION_FILES_STRIPES);
+
+    auto& stripe = getRegFilesStripe(coord);
+    std::unique_lock lock(stripe.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        regFilesCounters.contentions++;
+        lock.lock();
+    }
+    while (true) {
+        const auto found = stripe.files.find(coord);
+        if (found != stripe.files.end()) {
+            auto& entry = found->second;
+            if (!entry.file->inUse) {
+                regFilesCounters.hits++;
+                stripe.lru.splice(stripe.lru.end(), stripe.lru, entry.lruPosition);
+                entry.file->inUse = true;
+                return regfile_ptr(entry.file.get(), &stripe);
             }
-            if (closed) {
-                break;
+        } else if (!create) {
+            return nullptr;
+        } else {
+            auto file = folder / get_region_filename(coord.x, coord.y);
+            if (!fs::exists(file)) {
+                return nullptr;
+            }
+            size_t count = stripe.files.size();
+            if (free_stripe_slot(stripe, capacity)) {
+                if (stripe.files.size() < count) {
+                    regFilesCounters.evictions++;
+                }
+                auto opened = std::make_unique<regfile>(file, mappedFiles);
+                opened->inUse = true;
+                auto ptr = opened.get();
+                stripe.lru.push_back(coord);
+                stripe.files[coord] = {std::move(opened), --stripe.lru.end()};
+                regFilesCounters.opens++;
+                return regfile_ptr(ptr, &stripe);
             }
-            // notified when any regfile gets out of use or closed
-            regFilesCv.wait(lock);
         }
-        openRegFiles[coord] = std::make_unique<regfile>(file);
-        return useRegFile(coord);
-    } else {
-        std::lock_guard lock(regFilesMutex);
-        openRegFiles[coord] = std::make_unique<regfile>(file);
-        return useRegFile(coord);
+        // notified when any stripe file gets out of use or closed
+        regFilesCounters.waits++;
+        stripe.cv.wait(lock);
     }
 }
 
+RegFilesStats RegionsLayer::getRegFilesStats() const {
+    RegFilesStats stats {};
+    stats.hits = regFilesCounters.hits;
+    stats.opens = regFilesCounters.opens;
+    stats.evictions = regFilesCounters.evictions;
+    stats.contentions = regFilesCounters.contentions;
+    stats.waits = regFilesCounters.waits;
+    return stats;
+}
+
 WorldRegion* RegionsLayer::getRegion(int x, int z) {
-    std::lock_guard lock(mapMutex);
+    std::shared_lock lock(mapMutex);
     auto found = regions.find({x, z});
     if (found == regions.end()) {
         return nullptr;
@@ -138,67 +454,396 @@ WorldRegion* RegionsLayer::getRegion(int x, int z) {
     return found->second.get();
 }
 
+std::unique_ptr<WorldRegion> RegionsLayer::releaseRegion(int x, int z) {
+    std::lock_guard lock(mapMutex);
+    auto found = regions.find({x, z});
+    if (found == regions.end()) {
+        return nullptr;
+    }
+    auto region = std::move(found->second);
+    regions.erase(found);
+    return region;
+}
+
+size_t RegionsLayer::evictRegion(int x, int z) {
+    auto region = releaseRegion(x, z);
+    if (region == nullptr) {
+        return 0;
+    }
+    if (region->isUnsaved()) {
+        fs::create_directories(folder);
+        std::unique_lock lock(filesMutex);
+        if (!appendRegion(x, z, region.get())) {
+            writeRegion(x, z, region.get());
+        }
+    }
+    return region->getMemoryUsage();
+}
+
+std::vector<glm::ivec2> RegionsLayer::getRegionsCoords() {
+    std::shared_lock lock(mapMutex);
+    std::vector<glm::ivec2> coords;
+    coords.reserve(regions.size());
+    for (const auto& [coord, _] : regions) {
+        coords.push_back(coord);
+    }
+    return coords;
+}
+
+size_t RegionsLayer::getMemoryUsage() {
+    std::shared_lock lock(mapMutex);
+    std::lock_guard dataLock(dataMutex);
+    size_t total = 0;
+    for (const auto& [_, region] : regions) {
+        total += region->getMemoryUsage();
+    }
+    return total;
+}
+
 fs::path RegionsLayer::getRegionFilePath(int x, int z) const {
     return folder / get_region_filename(x, z);
 }
 
 WorldRegion* RegionsLayer::getOrCreateRegion(int x, int z) {
-    if (auto region = getRegion(x, z)) {
-        return region;
+    {
+        std::shared_lock lock(mapMutex);
+        const auto found = regions.find({x, z});
+        if (found != regions.end()) {
+            return found->second.get();
+        }
     }
     std::lock_guard lock(mapMutex);
-    auto region_ptr = std::make_unique<WorldRegion>();
-    auto region = region_ptr.get();
-    regions[{x, z}] = std::move(region_ptr);
-    return region;
+    auto& region = regions[{x, z}];
+    if (region == nullptr) {
+        region = std::make_unique<WorldRegion>();
+    }
+    return region.get();
 }
 
-ubyte* RegionsLayer::getData(int x, int z, uint32_t& size, uint32_t& srcSize) {
+void RegionsLayer::put(
+    int x, int z, std::unique_ptr<ubyte[]> data, uint32_t srcSize
+) {
+    uint32_t size = srcSize;
+    if (data == nullptr) {
+        size = srcSize = 0;
+    } else if (compression != compression::Method::NONE) {
+        size_t compressedSize;
+        data = compression::compress(
+            data.get(), srcSize, compressedSize, compression
+        );
+        size = compressedSize;
+    }
+    store(x, z, std::move(data), size, srcSize);
+}
+
+void RegionsLayer::store(
+    int x, int z, std::unique_ptr<ubyte[]> data, uint32_t size, uint32_t srcSize
+) {
     int regionX, regionZ, localX, localZ;
     calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
 
     WorldRegion* region = getOrCreateRegion(regionX, regionZ);
-    ubyte* data = region->getChunkData(localX, localZ);
-    if (data == nullptr) {
+    std::lock_guard lock(dataMutex);
+    region->setUnsaved(true);
+    region->setModified(localX, localZ);
+    region->put(localX, localZ, std::move(data), size, srcSize);
+}
+
+void RegionsLayer::putPending(
+    int x, int z, std::unique_ptr<ubyte[]> data, uint32_t srcSize
+) {
+    std::lock_guard lock(pendingMutex);
+    pending[{x, z}] = PendingChunkData {std::move(data), srcSize};
+}
+
+void RegionsLayer::flushPending() {
+    while (true) {
+        {
+            std::lock_guard lock(pendingMutex);
+            if (pending.empty()) {
+                break;
+            }
+            auto node = pending.extract(pending.begin());
+            inflight = {node.key(), std::move(node.mapped())};
+        }
+        // inflight data stays readable by other threads until it is stored
+        const auto& [coord, chunk] = *inflight;
+        std::unique_ptr<ubyte[]> data;
+        uint32_t size = chunk.srcSize;
+        uint32_t srcSize = chunk.srcSize;
+        if (chunk.data == nullptr) {
+            size = srcSize = 0;
+        } else if (compression != compression::Method::NONE) {
+            size_t compressedSize;
+            data = compression::compress(
+                chunk.data.get(), chunk.srcSize, compressedSize, compression
+            );
+            size = compressedSize;
+        } else {
+            data = std::make_unique<ubyte[]>(size);
+            std::memcpy(data.get(), chunk.data.get(), size);
+        }
+        store(coord.x, coord.y, std::move(data), size, srcSize);
+
+        std::lock_guard lock(pendingMutex);
+        inflight.reset();
+    }
+}
+
+bool RegionsLayer::loadData(int x, int z) {
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+
+    WorldRegion* region = getOrCreateRegion(regionX, regionZ);
+    {
+        std::lock_guard lock(dataMutex);
+        if (region->getChunkData(localX, localZ)) {
+            return true;
+        }
+    }
+    std::shared_lock filesLock(filesMutex);
+    auto regfile = getRegFile({regionX, regionZ});
+    if (regfile == nullptr) {
+        return false;
+    }
+    uint32_t size, srcSize;
+    auto dataptr = readChunkData(x, z, size, srcSize, regfile.get());
+    if (dataptr == nullptr) {
+        return false;
+    }
+    std::lock_guard lock(dataMutex);
+    // chunk may be loaded by another reader meanwhile
+    if (region->getChunkData(localX, localZ) == nullptr) {
+        region->put(localX, localZ, std::move(dataptr), size, srcSize);
+    }
+    return true;
+}
+
+void RegionsLayer::prefetch(int x, int z) {
+    // chunk data loaded otherwise is not tracked
+    if (isInMemory(x, z) || !loadData(x, z)) {
+        return;
+    }
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+    auto region = getRegion(regionX, regionZ);
+    if (region == nullptr) {
+        return;
+    }
+    std::vector<glm::ivec2> released;
+    {
+        std::lock_guard lock(dataMutex);
+        uint32_t size = region->getChunkDataSize(localX, localZ)[0];
+        if (region->getChunkData(localX, localZ) == nullptr ||
+            !prefetched.emplace(glm::ivec2(x, z), size).second) {
+            return;
+        }
+        prefetchQueue.emplace_back(x, z);
+        prefetchedBytes += size;
+        while (prefetchedBytes > PREFETCH_MEMORY_BUDGET) {
+            auto coord = prefetchQueue.front();
+            prefetchQueue.pop_front();
+            auto found = prefetched.find(coord);
+            if (found == prefetched.end()) {
+                continue;
+            }
+            prefetchedBytes -= found->second;
+            prefetched.erase(found);
+            released.push_back(coord);
+        }
+    }
+    for (const auto& coord : released) {
+        releaseChunkData(coord.x, coord.y);
+    }
+}
+
+void RegionsLayer::consumePrefetched(int x, int z, WorldRegion& region) {
+    auto found = prefetched.find({x, z});
+    if (found == prefetched.end()) {
+        return;
+    }
+    prefetchedBytes -= found->second;
+    prefetched.erase(found);
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+    if (!region.isModified(localZ * REGION_SIZE + localX)) {
+        region.put(localX, localZ, nullptr, 0, 0);
+    }
+}
+
+void RegionsLayer::releaseChunkData(int x, int z) {
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+    if (auto region = getRegion(regionX, regionZ)) {
+        std::lock_guard lock(dataMutex);
+        if (!region->isModified(localZ * REGION_SIZE + localX)) {
+            region->put(localX, localZ, nullptr, 0, 0);
+        }
+    }
+}
+
+bool RegionsLayer::isInMemory(int x, int z) {
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+    {
+        std::lock_guard lock(pendingMutex);
+        if ((inflight && inflight->first == glm::ivec2(x, z)) ||
+            pending.find({x, z}) != pending.end()) {
+            return true;
+        }
+    }
+    if (auto region = getRegion(regionX, regionZ)) {
+        std::lock_guard lock(dataMutex);
+        return region->getChunkData(localX, localZ) != nullptr;
+    }
+    return false;
+}
+
+bool RegionsLayer::readData(int x, int z, const ChunkDataProc& func) {
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+    {
+        std::lock_guard lock(pendingMutex);
+        const PendingChunkData* chunk = nullptr;
+        if (inflight && inflight->first == glm::ivec2(x, z)) {
+            chunk = &inflight->second;
+        }
+        auto found = pending.find({x, z});
+        if (found != pending.end()) {
+            chunk = &found->second;
+        }
+        if (chunk) {
+            if (chunk->data == nullptr) {
+                return false;
+            }
+            if (compression == compression::Method::NONE) {
+                func(chunk->data.get(), chunk->srcSize, chunk->srcSize);
+                return true;
+            }
+            if (inflight && inflight->first == glm::ivec2(x, z)) {
+                // the writer thread stores inflight data later, so pending
+                // data is kept to replace it
+                size_t size;
+                auto data = compression::compress(
+                    chunk->data.get(), chunk->srcSize, size, compression
+                );
+                func(data.get(), size, chunk->srcSize);
+                return true;
+            }
+            // compressed once instead of every read, stored data is read
+            // from the in-memory region below
+            auto node = pending.extract(found);
+            auto& [data, srcSize] = node.mapped();
+            put(x, z, std::move(data), srcSize);
+        }
+    }
+    if (auto region = getRegion(regionX, regionZ)) {
+        std::lock_guard lock(dataMutex);
+        if (auto data = region->getChunkData(localX, localZ)) {
+            auto sizevec = region->getChunkDataSize(localX, localZ);
+            func(data, sizevec[0], sizevec[1]);
+            consumePrefetched(x, z, *region);
+            return true;
+        }
+    }
+    {
+        std::shared_lock lock(filesMutex);
         auto regfile = getRegFile({regionX, regionZ});
-        if (regfile != nullptr) {
-            auto dataptr = readChunkData(x, z, size, srcSize, regfile.get());
-            if (dataptr) {
-                data = dataptr.get();
-                region->put(localX, localZ, std::move(dataptr), size, srcSize);
+        if (regfile == nullptr) {
+            return false;
+        }
+        if (regfile.get()->isMapped() &&
+            regfile.get()->compression == compression) {
+            uint32_t size, srcSize;
+            int chunkIndex = localZ * REGION_SIZE + localX;
+            auto data = regfile.get()->view(chunkIndex, size, srcSize);
+            if (data == nullptr) {
+                return false;
             }
+            func(data, size, srcSize);
+            return true;
         }
     }
-    if (data != nullptr) {
-        auto sizevec = region->getChunkDataSize(localX, localZ);
-        size = sizevec[0];
-        srcSize = sizevec[1];
-        return data;
+    if (!loadData(x, z)) {
+        return false;
+    }
+    auto region = getRegion(regionX, regionZ);
+    std::lock_guard lock(dataMutex);
+    auto data = region ? region->getChunkData(localX, localZ) : nullptr;
+    if (data == nullptr) {
+        return false;
+    }
+    auto sizevec = region->getChunkDataSize(localX, localZ);
+    func(data, sizevec[0], sizevec[1]);
+    return true;
+}
+
+/// @brief Write the table closing the region file
+static void write_table(
+    std::ostream& file, const uint32_t* offsets, const uint32_t* checksums
+) {
+    uint32_t table[REGION_CHUNKS_COUNT * 2];
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        table[i] = dataio::h2le(checksums[i]);
+        table[REGION_CHUNKS_COUNT + i] = dataio::h2le(offsets[i]);
     }
-    return nullptr;
+    file.write(reinterpret_cast<const char*>(table), sizeof(table));
+}
+
+/// @brief Point the region file header to the written table
+static void write_table_offset(std::ostream& file, uint32_t offset) {
+    uint32_t intbuf = dataio::h2le(offset);
+    file.seekp(TABLE_OFFSET_POSITION);
+    file.write(reinterpret_cast<const char*>(&intbuf), 4);
+}
+
+/// @brief Get temporary file the region file is written to. It replaces
+/// the region file when written, so an interrupted write (crash or power
+/// loss) keeps the previous region file valid
+static fs::path get_temp_filename(const fs::path& filename) {
+    fs::path tempfile = filename;
+    tempfile += ".tmp";
+    return tempfile;
+}
+
+/// @brief Close the written temporary file and replace the region file
+template <class Stream>
+static void commit_region_file(
+    Stream& file, const fs::path& tempfile, const fs::path& filename
+) {
+    file.close();
+    if (!file) {
+        throw std::runtime_error("could not write " + tempfile.u8string());
+    }
+    fs::rename(tempfile, filename);
 }
 
 void RegionsLayer::writeRegion(int x, int z, WorldRegion* entry) {
     fs::path filename = folder / get_region_filename(x, z);
+    fs::path tempfile = get_temp_filename(filename);
 
     glm::ivec2 regcoord(x, z);
-    if (auto regfile = getRegFile(regcoord, false)) {
-        fetch_chunks(entry, x, z, regfile.get());
+    if (auto regfile = getRegFile(regcoord)) {
+        fetch_chunks(*this, entry, x, z, regfile.get());
 
-        std::lock_guard lock(regFilesMutex);
         regfile.reset();
         closeRegFile(regcoord);
     }
 
+    // the table offset is written after the table
     char header[REGION_HEADER_SIZE] = REGION_FORMAT_MAGIC;
     header[8] = REGION_FORMAT_VERSION;
-    header[9] = static_cast<ubyte>(compression); // FIXME
-    std::ofstream file(filename, std::ios::out | std::ios::binary);
+    header[9] = static_cast<ubyte>(compression);
+    std::ofstream file(tempfile, std::ios::out | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("could not open " + tempfile.u8string());
+    }
     file.write(header, REGION_HEADER_SIZE);
 
     size_t offset = REGION_HEADER_SIZE;
     uint32_t intbuf;
     uint offsets[REGION_CHUNKS_COUNT] {};
+    uint32_t checksums[REGION_CHUNKS_COUNT] {};
 
     auto region = entry->getChunks();
     auto sizes = entry->getSizes();
@@ -213,7 +858,8 @@ void RegionsLayer::writeRegion(int x, int z, WorldRegion* entry) {
         auto sizevec = sizes[i];
         uint32_t compressedSize = sizevec[0];
         uint32_t srcSize = sizevec[1];
-        
+        checksums[i] = entry_checksum(compressedSize, srcSize, chunk);
+
         intbuf = dataio::h2le(compressedSize);
         file.write(reinterpret_cast<const char*>(&intbuf), 4);
         offset += 4;
@@ -225,10 +871,112 @@ void RegionsLayer::writeRegion(int x, int z, WorldRegion* entry) {
         file.write(reinterpret_cast<const char*>(chunk), compressedSize);
         offset += compressedSize;
     }
+    write_table(file, offsets, checksums);
+    write_table_offset(file, offset);
+    commit_region_file(file, tempfile, filename);
+    writes.add();
+    writtenBytes.add(offset + get_table_size(REGION_FORMAT_VERSION));
+}
+
+bool RegionsLayer::appendRegion(int x, int z, WorldRegion* entry) {
+    glm::ivec2 regcoord(x, z);
+    uint32_t offsets[REGION_CHUNKS_COUNT] {};
+    uint32_t prevSizes[REGION_CHUNKS_COUNT] {};
+    uint32_t checksums[REGION_CHUNKS_COUNT] {};
+    size_t tableSize = get_table_size(REGION_FORMAT_VERSION);
+    // end of the current table, new entries and table are written after
+    size_t appendOffset;
+
+    auto sizes = entry->getSizes();
+    auto region = entry->getChunks();
+    {
+        auto regfile = getRegFile(regcoord);
+        if (regfile == nullptr ||
+            static_cast<uint>(regfile.get()->version) != REGION_FORMAT_VERSION ||
+            regfile.get()->compression != compression) {
+            return false;
+        }
+        appendOffset =
+            regfile.get()->readTable(offsets, prevSizes, checksums) + tableSize;
+
+        size_t liveBytes = 0;
+        size_t appendBytes = 0;
+        for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            if (!entry->isModified(i)) {
+                liveBytes += offsets[i] ? prevSizes[i] + 8 : 0;
+            } else if (region[i]) {
+                liveBytes += sizes[i][0] + 8;
+                appendBytes += sizes[i][0] + 8;
+            }
+        }
+        // previous tables are unreachable data too
+        size_t totalBytes = appendOffset - REGION_HEADER_SIZE + appendBytes;
+        if (appendOffset + appendBytes + tableSize >
+            std::numeric_limits<uint32_t>::max()) {
+            return false;
+        }
+        // unreachable chunks data is cleaned up by full rewrite
+        if (totalBytes - liveBytes > totalBytes * REGION_COMPACTION_THRESHOLD) {
+            return false;
+        }
+        regfile.reset();
+        closeRegFile(regcoord);
+    }
+
+    fs::path filename = folder / get_region_filename(x, z);
+    std::fstream file(
+        filename, std::ios::in | std::ios::out | std::ios::binary
+    );
+    if (!file) {
+        throw std::runtime_error("could not open " + filename.u8string());
+    }
+    // the header points to the current table until the new one is written,
+    // so an interrupted append keeps the region file valid
+    file.seekp(appendOffset);
+
+    size_t offset = appendOffset;
+    uint32_t intbuf;
     for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        intbuf = dataio::h2le(offsets[i]);
+        if (!entry->isModified(i)) {
+            continue;
+        }
+        ubyte* chunk = region[i].get();
+        if (chunk == nullptr) {
+            offsets[i] = 0;
+            checksums[i] = 0;
+            continue;
+        }
+        offsets[i] = offset;
+
+        uint32_t compressedSize = sizes[i][0];
+        uint32_t srcSize = sizes[i][1];
+        checksums[i] = entry_checksum(compressedSize, srcSize, chunk);
+
+        intbuf = dataio::h2le(compressedSize);
+        file.write(reinterpret_cast<const char*>(&intbuf), 4);
+        intbuf = dataio::h2le(srcSize);
         file.write(reinterpret_cast<const char*>(&intbuf), 4);
+        file.write(reinterpret_cast<const char*>(chunk), compressedSize);
+        offset += compressedSize + 8;
+    }
+    write_table(file, offsets, checksums);
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("could not write " + filename.u8string());
+    }
+    write_table_offset(file, offset);
+    file.close();
+    if (!file) {
+        throw std::runtime_error("could not write " + filename.u8string());
+    }
+    // dropping bytes left by an interrupted append
+    size_t end = offset + tableSize;
+    if (fs::file_size(filename) > end) {
+        fs::resize_file(filename, end);
     }
+    writes.add();
+    writtenBytes.add(offset - appendOffset + tableSize + 4);
+    return true;
 }
 
 std::unique_ptr<ubyte[]> RegionsLayer::readChunkData(
@@ -237,5 +985,8 @@ std::unique_ptr<ubyte[]> RegionsLayer::readChunkData(
     int regionX, regionZ, localX, localZ;
     calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
     int chunkIndex = localZ * REGION_SIZE + localX;
-    return rfile->read(chunkIndex, size, srcSize);
+    auto data = rfile->read(chunkIndex, size, srcSize);
+    return transcode(
+        std::move(data), size, srcSize, rfile->compression, compression
+    );
 }
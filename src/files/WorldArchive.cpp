@@ -0,0 +1,407 @@
+#include "WorldArchive.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#include "coders/byte_utils.hpp"
+#include "coders/crc32c.hpp"
+#include "coders/gzip.hpp"
+#include "debug/Logger.hpp"
+#include "WorldRegions.hpp"
+#include "files.hpp"
+
+static debug::Logger logger("world-archive");
+
+#define ARCHIVE_MAGIC ".VOXARC"
+
+static constexpr size_t MAGIC_SIZE = 8;
+static constexpr uint32_t ARCHIVE_FORMAT_VERSION = 1;
+static constexpr size_t HEADER_SIZE = MAGIC_SIZE + 4;
+static constexpr size_t FOOTER_SIZE = 8 + MAGIC_SIZE;
+/// @brief Entries processed ahead of the ordered output per thread,
+/// bounds memory used by compressed entries waiting to be written
+static constexpr size_t ENTRIES_AHEAD_PER_THREAD = 4;
+/// @brief Header and footer of the smallest gzip member
+static constexpr size_t MIN_GZIP_SIZE = 18;
+/// @brief Max original size of an archived file. Gzip stores the size
+/// modulo 2^32, larger world files are not expected either
+static constexpr uint64_t MAX_ENTRY_SIZE = 1024ULL * 1024 * 1024;
+
+using namespace world_archive;
+
+/// @brief Interleave bits of region coordinates (Z-order curve index)
+static uint64_t zorder(int x, int z) {
+    // shifting signed range to keep negative coordinates ordered
+    uint64_t ux = static_cast<uint32_t>(x) ^ 0x80000000U;
+    uint64_t uz = static_cast<uint32_t>(z) ^ 0x80000000U;
+    uint64_t index = 0;
+    for (int bit = 0; bit < 32; bit++) {
+        index |= ((ux >> bit) & 1) << (bit * 2);
+        index |= ((uz >> bit) & 1) << (bit * 2 + 1);
+    }
+    return index;
+}
+
+namespace {
+    struct SourceFile {
+        std::string path;
+        bool region;
+        uint64_t order;
+    };
+
+    struct PackedEntry {
+        std::vector<ubyte> data;
+        uint64_t srcSize = 0;
+        uint32_t checksum = 0;
+    };
+}
+
+/// @brief List world files: other files first, then region files of
+/// all layers grouped by region in Z-order
+static std::vector<SourceFile> list_files(const fs::path& folder) {
+    std::vector<SourceFile> files;
+    for (const auto& entry : fs::recursive_directory_iterator(folder)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        const auto& path = entry.path();
+        int x, z;
+        bool region = path.extension() == ".bin" &&
+                      WorldRegions::parseRegionFilename(
+                          path.stem().string(), x, z
+                      );
+        files.push_back(
+            {fs::relative(path, folder).generic_u8string(),
+             region,
+             region ? zorder(x, z) : 0}
+        );
+    }
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
+        if (a.region != b.region) {
+            return !a.region;
+        }
+        if (a.order != b.order) {
+            return a.order < b.order;
+        }
+        return a.path < b.path;
+    });
+    return files;
+}
+
+/// @brief Run jobs on worker threads passing results to the consumer in
+/// jobs order on the calling thread. Jobs are started at most `ahead`
+/// jobs before the consumer. The first exception stops processing and is
+/// rethrown
+template <typename T, typename Job, typename Consumer>
+static void run_ordered(
+    size_t count,
+    uint threads,
+    size_t ahead,
+    const Job& job,
+    const Consumer& consume
+) {
+    std::vector<std::optional<T>> results(count);
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t next = 0;
+    size_t consumed = 0;
+    bool stopped = false;
+    std::exception_ptr error;
+
+    auto fail = [&]() {
+        std::lock_guard lock(mutex);
+        if (!error) {
+            error = std::current_exception();
+        }
+        stopped = true;
+    };
+    auto worker = [&]() {
+        while (true) {
+            size_t index;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [&]() {
+                    return stopped || next >= count || next < consumed + ahead;
+                });
+                if (stopped || next >= count) {
+                    return;
+                }
+                index = next++;
+            }
+            try {
+                T result = job(index);
+                std::lock_guard lock(mutex);
+                results[index] = std::move(result);
+            } catch (...) {
+                fail();
+            }
+            cv.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (uint i = 0; i < std::max(1U, threads); i++) {
+        workers.emplace_back(worker);
+    }
+    try {
+        for (size_t i = 0; i < count; i++) {
+            T result;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [&]() {
+                    return stopped || results[i].has_value();
+                });
+                if (stopped) {
+                    break;
+                }
+                result = std::move(*results[i]);
+                results[i].reset();
+                consumed++;
+            }
+            cv.notify_all();
+            consume(i, result);
+        }
+    } catch (...) {
+        fail();
+    }
+    {
+        std::lock_guard lock(mutex);
+        stopped = true;
+    }
+    cv.notify_all();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+Stats world_archive::export_world(
+    const fs::path& folder, const fs::path& file, uint threads
+) {
+    if (!fs::is_directory(folder)) {
+        throw std::runtime_error(
+            "world folder " + folder.u8string() + " not found"
+        );
+    }
+    auto sources = list_files(folder);
+
+    std::ofstream output(file, std::ios::binary);
+    if (!output) {
+        throw std::runtime_error("could not open " + file.u8string());
+    }
+    ByteBuilder header;
+    header.putCStr(ARCHIVE_MAGIC);
+    header.putInt32(ARCHIVE_FORMAT_VERSION);
+    output.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+    Stats stats {};
+    std::vector<Entry> entries;
+    entries.reserve(sources.size());
+    uint64_t offset = header.size();
+    run_ordered<PackedEntry>(
+        sources.size(),
+        threads,
+        std::max(1U, threads) * ENTRIES_AHEAD_PER_THREAD,
+        [&](size_t index) {
+            auto path = folder / fs::u8path(sources[index].path);
+            auto bytes = files::read_bytes(path);
+            if (bytes.size() > MAX_ENTRY_SIZE) {
+                throw std::runtime_error(
+                    "file is too large to be archived " + path.u8string()
+                );
+            }
+            PackedEntry entry;
+            entry.srcSize = bytes.size();
+            entry.checksum = crc32c::compute(bytes.data(), bytes.size());
+            entry.data = gzip::compress(bytes.data(), bytes.size());
+            return entry;
+        },
+        [&](size_t index, const PackedEntry& packed) {
+            output.write(
+                reinterpret_cast<const char*>(packed.data.data()),
+                packed.data.size()
+            );
+            if (!output) {
+                throw std::runtime_error("could not write " + file.u8string());
+            }
+            entries.push_back(
+                {sources[index].path,
+                 offset,
+                 packed.data.size(),
+                 packed.srcSize,
+                 packed.checksum}
+            );
+            offset += packed.data.size();
+            stats.files++;
+            stats.bytes += packed.srcSize;
+            stats.compressedBytes += packed.data.size();
+        }
+    );
+
+    ByteBuilder index;
+    index.putInt32(entries.size());
+    for (const auto& entry : entries) {
+        index.put(entry.path);
+        index.putInt64(entry.offset);
+        index.putInt64(entry.size);
+        index.putInt64(entry.srcSize);
+        index.putInt32(entry.checksum);
+    }
+    index.putCStr(ARCHIVE_MAGIC);
+    index.putInt64(offset);
+    output.write(reinterpret_cast<const char*>(index.data()), index.size());
+    output.close();
+    if (!output) {
+        throw std::runtime_error("could not write " + file.u8string());
+    }
+    logger.info() << "exported " << stats.files << " files ("
+                  << stats.bytes << " -> " << stats.compressedBytes
+                  << " bytes) to " << file.u8string();
+    return stats;
+}
+
+std::vector<Entry> world_archive::read_index(const fs::path& file) {
+    files::rafile input(file);
+    size_t length = input.length();
+    if (length < HEADER_SIZE + 4 + FOOTER_SIZE) {
+        throw std::runtime_error("invalid world archive: too short");
+    }
+    ubyte header[HEADER_SIZE];
+    input.seekg(0);
+    input.read(reinterpret_cast<char*>(header), HEADER_SIZE);
+    ByteReader headerReader(header, HEADER_SIZE);
+    headerReader.checkMagic(ARCHIVE_MAGIC, MAGIC_SIZE);
+    uint32_t version = headerReader.getInt32();
+    if (version > ARCHIVE_FORMAT_VERSION) {
+        throw std::runtime_error(
+            "world archive format " + std::to_string(version) +
+            " is not supported"
+        );
+    }
+
+    ubyte footer[FOOTER_SIZE];
+    input.seekg(length - FOOTER_SIZE);
+    input.read(reinterpret_cast<char*>(footer), FOOTER_SIZE);
+    ByteReader footerReader(footer, FOOTER_SIZE);
+    footerReader.checkMagic(ARCHIVE_MAGIC, MAGIC_SIZE);
+    uint64_t indexOffset = footerReader.getInt64();
+    if (indexOffset < HEADER_SIZE || indexOffset > length - FOOTER_SIZE) {
+        throw std::runtime_error("invalid world archive index offset");
+    }
+
+    std::vector<ubyte> indexBytes(length - FOOTER_SIZE - indexOffset);
+    input.seekg(indexOffset);
+    input.read(reinterpret_cast<char*>(indexBytes.data()), indexBytes.size());
+    ByteReader reader(indexBytes.data(), indexBytes.size());
+    size_t count = static_cast<uint32_t>(reader.getInt32());
+    std::vector<Entry> entries;
+    for (size_t i = 0; i < count; i++) {
+        Entry entry {};
+        entry.path = reader.getString();
+        entry.offset = reader.getInt64();
+        entry.size = reader.getInt64();
+        entry.srcSize = reader.getInt64();
+        entry.checksum = reader.getInt32();
+        if (entry.offset < HEADER_SIZE || entry.size > indexOffset ||
+            entry.offset > indexOffset - entry.size ||
+            entry.srcSize > MAX_ENTRY_SIZE) {
+            throw std::runtime_error(
+                "invalid world archive entry " + entry.path
+            );
+        }
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+/// @brief Get entry destination path refusing paths leading out of
+/// the world folder
+static fs::path entry_path(const fs::path& folder, const std::string& name) {
+    auto path = fs::u8path(name);
+    if (path.empty() || path.has_root_name() || path.has_root_directory()) {
+        throw std::runtime_error("invalid world archive entry path " + name);
+    }
+    for (const auto& part : path) {
+        if (part == "..") {
+            throw std::runtime_error(
+                "invalid world archive entry path " + name
+            );
+        }
+    }
+    return folder / path;
+}
+
+Stats world_archive::import_world(
+    const fs::path& file, const fs::path& folder, uint threads
+) {
+    if (fs::exists(folder) && !fs::is_empty(folder)) {
+        throw std::runtime_error(
+            "world folder " + folder.u8string() + " is not empty"
+        );
+    }
+    auto entries = read_index(file);
+
+    std::vector<fs::path> paths;
+    std::set<fs::path> directories {folder};
+    for (const auto& entry : entries) {
+        paths.push_back(entry_path(folder, entry.path));
+        directories.insert(paths.back().parent_path());
+    }
+    for (const auto& directory : directories) {
+        fs::create_directories(directory);
+    }
+
+    Stats stats {};
+    run_ordered<size_t>(
+        entries.size(),
+        threads,
+        std::max(1U, threads) * ENTRIES_AHEAD_PER_THREAD,
+        [&](size_t index) -> size_t {
+            const auto& entry = entries[index];
+            std::vector<ubyte> data(entry.size);
+            {
+                files::rafile input(file);
+                input.seekg(entry.offset);
+                input.read(reinterpret_cast<char*>(data.data()), data.size());
+            }
+            if (data.size() < MIN_GZIP_SIZE) {
+                throw std::runtime_error(
+                    "corrupted world archive entry " + entry.path
+                );
+            }
+            // output is limited by the indexed size before inflating
+            auto bytes = gzip::decompress(
+                data.data(), data.size(), entry.srcSize
+            );
+            if (bytes.size() != entry.srcSize ||
+                crc32c::compute(bytes.data(), bytes.size()) != entry.checksum) {
+                throw std::runtime_error(
+                    "corrupted world archive entry " + entry.path
+                );
+            }
+            if (!files::write_bytes(paths[index], bytes.data(), bytes.size())) {
+                throw std::runtime_error(
+                    "could not write " + paths[index].u8string()
+                );
+            }
+            return bytes.size();
+        },
+        [&](size_t index, size_t srcSize) {
+            stats.files++;
+            stats.bytes += srcSize;
+            stats.compressedBytes += entries[index].size;
+        }
+    );
+    logger.info() << "imported " << stats.files << " files ("
+                  << stats.bytes << " bytes) to " << folder.u8string();
+    return stats;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "typedefs.hpp"
+
+namespace fs = std::filesystem;
+
+/// @brief Single-file world archive used for backups and transfers.
+///
+/// Layout (little-endian integers):
+/// - header: ".VOXARC\0" magic, uint32 format version;
+/// - entries: gzip-compressed world files. Files of all region layers
+///   of a region are placed together, regions are ordered along
+///   the Z-order curve, so nearby regions are stored nearby;
+/// - index: uint32 entries count, then per entry: relative path
+///   (uint32 length + UTF-8), int64 offset, int64 compressed size,
+///   int64 source size, uint32 source CRC32C;
+/// - footer: ".VOXARC\0" magic, int64 index offset.
+namespace world_archive {
+    struct Entry {
+        /// @brief Path relative to the world folder ('/' separated)
+        std::string path;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t srcSize;
+        uint32_t checksum;
+    };
+
+    struct Stats {
+        size_t files = 0;
+        /// @brief Total size of world files
+        size_t bytes = 0;
+        /// @brief Total size of compressed entries
+        size_t compressedBytes = 0;
+    };
+
+    /// @brief Pack world folder into archive. Files are read and
+    /// compressed by worker threads while written in order
+    /// @param folder world folder
+    /// @param file archive file (overwritten)
+    /// @param threads number of compressing threads
+    /// @throws std::runtime_error on I/O errors
+    Stats export_world(
+        const fs::path& folder, const fs::path& file, uint threads
+    );
+
+    /// @brief Read archive entries index
+    /// @throws std::runtime_error if file is not a valid archive
+    std::vector<Entry> read_index(const fs::path& file);
+
+    /// @brief Unpack archive into new world folder. Entries are read in
+    /// order, decompressed, verified and written by worker threads
+    /// @param file archive file
+    /// @param folder world folder (must not exist or be empty)
+    /// @param threads number of decompressing threads
+    /// @throws std::runtime_error if archive is corrupted, folder is not
+    /// empty or on I/O errors
+    Stats import_world(
+        const fs::path& file, const fs::path& folder, uint threads
+    );
+}
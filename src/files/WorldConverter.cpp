@@ -1,16 +1,21 @@
 #include "WorldConverter.hpp"
 
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <unordered_map>
 #include <utility>
 
 #include "content/ContentReport.hpp"
+#include "data/StructLayout.hpp"
 #include "files/compatibility.hpp"
 #include "debug/Logger.hpp"
 #include "files/files.hpp"
 #include "objects/Player.hpp"
 #include "util/ThreadPool.hpp"
+#include "util/data_io.hpp"
+#include "util/stringutil.hpp"
 #include "voxels/Chunk.hpp"
 #include "items/Inventory.hpp"
 #include "voxels/Block.hpp"
@@ -127,7 +132,8 @@ WorldConverter::WorldConverter(
     : wfile(worldFiles),
       report(std::move(reportPtr)),
       content(content),
-      mode(mode)
+      mode(mode),
+      startTime(std::chrono::steady_clock::now())
 {
     switch (mode) {
         case ConvertMode::UPGRADE:
@@ -146,15 +152,10 @@ WorldConverter::~WorldConverter() {
 }
 
 std::shared_ptr<Task> WorldConverter::startTask(
-    const std::shared_ptr<WorldFiles>& worldFiles,
-    const Content* content,
-    const std::shared_ptr<ContentReport>& report,
+    const std::shared_ptr<WorldConverter>& converter,
     const runnable& onDone,
-    ConvertMode mode,
     bool multithreading
 ) {
-    auto converter = std::make_shared<WorldConverter>(
-        worldFiles, content, report, mode);
     if (!multithreading) {
         converter->setOnComplete([=]() {
             converter->write();
@@ -167,12 +168,12 @@ std::shared_ptr<Task> WorldConverter::startTask(
         [=]() { return std::make_shared<ConverterWorker>(converter); },
         [=](int&) {}
     );
+    pool->setPriority(util::TaskScheduler::Priority::LOW);
     auto& converterTasks = converter->tasks;
     while (!converterTasks.empty()) {
         ConvertTask task = std::move(converterTasks.front());
         converterTasks.pop();
         pool->enqueueJob(std::move(task));
-        
     }
     pool->setOnComplete([=]() {
         converter->write();
@@ -181,27 +182,40 @@ std::shared_ptr<Task> WorldConverter::startTask(
     return pool;
 }
 
-void WorldConverter::upgradeRegion(
+uint WorldConverter::upgradeRegion(
     const fs::path& file, int x, int z, RegionLayerIndex layer
 ) const {
     auto path = wfile->getRegions().getRegionFilePath(layer, x, z);
     auto bytes = files::read_bytes_buffer(path);
     auto buffer = compatibility::convert_region_2to3(bytes, layer);
     files::write_bytes(path, buffer.data(), buffer.size());
+
+    // non-zero offsets in the table at the end of the file
+    uint chunks = 0;
+    const ubyte* table =
+        buffer.data() + buffer.size() - REGION_CHUNKS_COUNT * sizeof(uint32_t);
+    for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        uint32_t offset;
+        std::memcpy(&offset, table + i * sizeof(uint32_t), sizeof(uint32_t));
+        chunks += dataio::le2h(offset) != 0;
+    }
+    return chunks;
 }
 
-void WorldConverter::convertVoxels(const fs::path& file, int x, int z) const {
+uint WorldConverter::convertVoxels(const fs::path& file, int x, int z) const {
     logger.info() << "converting voxels region " << x << "_" << z;
-    wfile->getRegions().processRegion(x, z, REGION_LAYER_VOXELS,
+    return wfile->getRegions().processRegion(x, z, REGION_LAYER_VOXELS,
     [=](std::unique_ptr<ubyte[]> data, uint32_t*) {
         Chunk::convert(data.get(), report.get());
         return data;
     });
 }
 
-void WorldConverter::convertInventories(const fs::path& file, int x, int z) const {
+uint WorldConverter::convertInventories(
+    const fs::path& file, int x, int z
+) const {
     logger.info() << "converting inventories region " << x << "_" << z;
-    wfile->getRegions().processInventories(x, z, [=](Inventory* inventory) {
+    return wfile->getRegions().processInventories(x, z, [=](Inventory* inventory) {
         inventory->convert(report.get());
     });
 }
@@ -213,54 +227,68 @@ void WorldConverter::convertPlayer(const fs::path& file) const {
     files::write_json(file, map);
 }
 
-void WorldConverter::convertBlocksData(int x, int z, const ContentReport& report) const {
+uint WorldConverter::convertBlocksData(
+    int x, int z, const ContentReport& report
+) const {
     logger.info() << "converting blocks data";
-    wfile->getRegions().processBlocksData(x, z, 
+    return wfile->getRegions().processBlocksData(x, z, 
     [=](BlocksMetadata* heap, std::unique_ptr<ubyte[]> voxelsData) {
         Chunk chunk(0, 0);
         chunk.decode(voxelsData.get());
 
         const auto& indices = content->getIndices()->blocks;
 
+        // fields are matched once per block type
+        std::unordered_map<blockid_t, data::StructConverter> converters;
         BlocksMetadata newHeap;
         for (const auto& entry : *heap) {
             size_t index = entry.index;
-            const auto& def = indices.require(chunk.voxels[index].id);
+            blockid_t id = chunk.voxels[index].id;
+            const auto& def = indices.require(id);
             const auto& newStruct = *def.dataStruct;
-            const auto& found = report.blocksDataLayouts.find(def.name);
-            if (found == report.blocksDataLayouts.end()) {
-                logger.error() << "no previous fields layout found for block" 
-                    << def.name << " - discard";
-                continue; 
+            auto converter = converters.find(id);
+            if (converter == converters.end()) {
+                const auto& found = report.blocksDataLayouts.find(def.name);
+                if (found == report.blocksDataLayouts.end()) {
+                    logger.error() << "no previous fields layout found for block" 
+                        << def.name << " - discard";
+                    continue; 
+                }
+                converter = converters.try_emplace(
+                    id, newStruct, found->second
+                ).first;
             }
-            const auto& prevStruct = found->second;
             uint8_t* dst = newHeap.allocate(index, newStruct.size());
-            newStruct.convert(prevStruct, entry.data(), dst, true);
+            converter->second.convert(entry.data(), dst);
         }
         *heap = std::move(newHeap);
     });
 }
 
-void WorldConverter::convert(const ConvertTask& task) const {
+void WorldConverter::convert(const ConvertTask& task) {
     if (!fs::is_regular_file(task.file)) return;
 
+    size_t bytes = fs::file_size(task.file);
+    uint chunks = 0;
     switch (task.type) {
         case ConvertTaskType::UPGRADE_REGION:
-            upgradeRegion(task.file, task.x, task.z, task.layer);
+            chunks = upgradeRegion(task.file, task.x, task.z, task.layer);
             break;
         case ConvertTaskType::VOXELS:
-            convertVoxels(task.file, task.x, task.z);
+            chunks = convertVoxels(task.file, task.x, task.z);
             break;
         case ConvertTaskType::INVENTORIES:
-            convertInventories(task.file, task.x, task.z);
+            chunks = convertInventories(task.file, task.x, task.z);
             break;
         case ConvertTaskType::PLAYER:
             convertPlayer(task.file);
             break;
         case ConvertTaskType::CONVERT_BLOCKS_DATA:
-            convertBlocksData(task.x, task.z, *report);
+            chunks = convertBlocksData(task.x, task.z, *report);
             break;
     }
+    bytesDone += bytes;
+    chunksDone += chunks;
 }
 
 void WorldConverter::convertNext() {
@@ -294,6 +322,10 @@ bool WorldConverter::isActive() const {
 }
 
 void WorldConverter::write() {
+    auto stats = getStats();
+    logger.info() << "converted " << stats.chunks << " chunks ("
+                  << util::format_data_size(stats.bytes) << ") in "
+                  << stats.seconds << "s";
     logger.info() << "applying changes";
 
     auto patch = dv::object();
@@ -325,3 +357,9 @@ uint WorldConverter::getWorkTotal() const {
 uint WorldConverter::getWorkDone() const {
     return tasksDone;
 }
+
+ConvertStats WorldConverter::getStats() const {
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - startTime;
+    return ConvertStats {bytesDone, chunksDone, elapsed.count()};
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <memory>
 #include <queue>
@@ -37,6 +39,24 @@ struct ConvertTask {
     RegionLayerIndex layer;
 };
 
+/// @brief World conversion throughput
+struct ConvertStats {
+    /// @brief Processed region files size
+    size_t bytes;
+    /// @brief Processed chunks count
+    size_t chunks;
+    /// @brief Time since conversion start in seconds
+    double seconds;
+
+    double bytesPerSecond() const {
+        return seconds > 0.0 ? bytes / seconds : 0.0;
+    }
+
+    double chunksPerSecond() const {
+        return seconds > 0.0 ? chunks / seconds : 0.0;
+    }
+};
+
 enum class ConvertMode {
     UPGRADE,
     REINDEX,
@@ -51,13 +71,17 @@ class WorldConverter : public Task {
     runnable onComplete;
     uint tasksDone = 0;
     ConvertMode mode;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<size_t> bytesDone = 0;
+    std::atomic<size_t> chunksDone = 0;
 
-    void upgradeRegion(
+    /// @return number of processed chunks
+    uint upgradeRegion(
         const fs::path& file, int x, int z, RegionLayerIndex layer) const;
     void convertPlayer(const fs::path& file) const;
-    void convertVoxels(const fs::path& file, int x, int z) const;
-    void convertInventories(const fs::path& file, int x, int z) const;
-    void convertBlocksData(int x, int z, const ContentReport& report) const;
+    uint convertVoxels(const fs::path& file, int x, int z) const;
+    uint convertInventories(const fs::path& file, int x, int z) const;
+    uint convertBlocksData(int x, int z, const ContentReport& report) const;
 
     void addRegionsTasks(
         RegionLayerIndex layerid,
@@ -76,7 +100,7 @@ public:
     );
     ~WorldConverter();
 
-    void convert(const ConvertTask& task) const;
+    void convert(const ConvertTask& task);
     void convertNext();
     void setOnComplete(runnable callback);
     void write();
@@ -88,12 +112,13 @@ public:
     uint getWorkTotal() const override;
     uint getWorkDone() const override;
 
+    ConvertStats getStats() const;
+
+    /// @brief Start converter task. Regions are converted and written
+    /// in parallel by the pool workers if multithreading is enabled
     static std::shared_ptr<Task> startTask(
-        const std::shared_ptr<WorldFiles>& worldFiles,
-        const Content* content,
-        const std::shared_ptr<ContentReport>& report,
+        const std::shared_ptr<WorldConverter>& converter,
         const runnable& onDone,
-        ConvertMode mode,
         bool multithreading
     );
 };
@@ -46,6 +46,7 @@ WorldFiles::WorldFiles(const fs::path& directory, const DebugSettings& settings)
     doWriteLights = settings.doWriteLights.get();
     regions.generatorTestMode = generatorTestMode;
     regions.doWriteLights = doWriteLights;
+    regions.doWritePrototypes = settings.doWritePrototypes.get();
 }
 
 WorldFiles::~WorldFiles() = default;
@@ -76,7 +77,7 @@ fs::path WorldFiles::getPacksFile() const {
 }
 
 void WorldFiles::write(
-    const World* world, const Content* content
+    const World* world, const Content* content, bool background
 ) {
     if (world) {
         writeWorldInfo(world->getInfo());
@@ -90,7 +91,11 @@ void WorldFiles::write(
     if (content) {
         writeIndices(content->getIndices());
     }
-    regions.writeAll();
+    if (background) {
+        regions.writeAllAsync();
+    } else {
+        regions.writeAll();
+    }
 }
 
 void WorldFiles::writePacks(const std::vector<ContentPack>& packs) {
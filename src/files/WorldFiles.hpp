@@ -63,7 +63,10 @@ public:
     /// @brief Write all unsaved data to world files
     /// @param world target world
     /// @param content world content
-    void write(const World* world, const Content* content);
+    /// @param background write regions in the regions writer thread
+    void write(
+        const World* world, const Content* content, bool background = false
+    );
 
     void writePacks(const std::vector<ContentPack>& packs);
 
@@ -1,10 +1,15 @@
 #include "WorldRegions.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
 #include "coders/json.hpp"
 #include "coders/byte_utils.hpp"
 #include "coders/rle.hpp"
@@ -28,6 +33,9 @@ WorldRegion::~WorldRegion() = default;
 
 void WorldRegion::setUnsaved(bool unsaved) {
     this->unsaved = unsaved;
+    if (!unsaved) {
+        modified.reset();
+    }
 }
 bool WorldRegion::isUnsaved() const {
     return unsaved;
@@ -45,6 +53,12 @@ void WorldRegion::put(
     uint x, uint z, std::unique_ptr<ubyte[]> data, uint32_t size, uint32_t srcSize
 ) {
     size_t chunk_index = z * REGION_SIZE + x;
+    if (chunksData[chunk_index]) {
+        memoryUsage -= sizes[chunk_index][0];
+    }
+    if (data) {
+        memoryUsage += size;
+    }
     chunksData[chunk_index] = std::move(data);
     sizes[chunk_index] = glm::u32vec2(size, srcSize);
 }
@@ -57,36 +71,101 @@ glm::u32vec2 WorldRegion::getChunkDataSize(uint x, uint z) {
     return sizes[z * REGION_SIZE + x];
 }
 
-WorldRegions::WorldRegions(const fs::path& directory) : directory(directory) {
+void WorldRegion::setModified(uint x, uint z) {
+    modified.set(z * REGION_SIZE + x);
+}
+
+bool WorldRegion::isModified(size_t index) const {
+    return modified.test(index);
+}
+
+WorldRegions::WorldRegions(const fs::path& directory)
+    : directory(directory),
+      memorySource([this](debug::MemoryBreakdown& breakdown) {
+          for (auto& layer : layers) {
+              if (layer.folder.empty()) {
+                  continue;
+              }
+              auto tag = "regions." + layer.folder.filename().u8string();
+              breakdown[tag] += layer.getMemoryUsage();
+          }
+      }) {
     for (size_t i = 0; i < REGION_LAYERS_COUNT; i++) {
         layers[i].layer = static_cast<RegionLayerIndex>(i);
     }
     auto& voxels = layers[REGION_LAYER_VOXELS];
     voxels.folder = directory / fs::path("regions");
-    voxels.compression = compression::Method::EXTRLE16;
+    // hot layers use LZ4 for fast chunks loading
+    voxels.compression = compression::Method::LZ4;
 
     auto& lights = layers[REGION_LAYER_LIGHTS];
     lights.folder = directory / fs::path("lights");
-    lights.compression = compression::Method::EXTRLE8;
+    lights.compression = compression::Method::LZ4;
 
     layers[REGION_LAYER_INVENTORIES].folder =
         directory / fs::path("inventories");
     layers[REGION_LAYER_ENTITIES].folder = directory / fs::path("entities");
 
+    // entities and inventories are already stored as compressed binary json
     auto& blocksData = layers[REGION_LAYER_BLOCKS_DATA];
     blocksData.folder = directory / fs::path("blocksdata");
+    blocksData.compression = compression::Method::ZSTD;
+
+    auto& prototypes = layers[REGION_LAYER_PROTOTYPES];
+    prototypes.folder = directory / fs::path("prototypes");
+    prototypes.compression = compression::Method::ZSTD;
+
+    auto& blockUpdates = layers[REGION_LAYER_BLOCK_UPDATES];
+    blockUpdates.folder = directory / fs::path("blockupdates");
+    blockUpdates.compression = compression::Method::ZSTD;
+
+    // summaries are too small to be compressed
+    layers[REGION_LAYER_SUMMARIES].folder = directory / fs::path("summaries");
 }
 
-WorldRegions::~WorldRegions() = default;
+WorldRegions::~WorldRegions() {
+    setBackgroundWriting(false);
+}
 
-void RegionsLayer::writeAll() {
-    for (auto& it : regions) {
-        WorldRegion* region = it.second.get();
-        if (region->getChunks() == nullptr || !region->isUnsaved()) {
+std::unique_ptr<WorldRegion> WorldRegion::snapshot() const {
+    auto region = std::make_unique<WorldRegion>();
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (!modified.test(i)) {
             continue;
         }
-        const auto& key = it.first;
-        writeRegion(key[0], key[1], region);
+        region->modified.set(i);
+        region->sizes[i] = sizes[i];
+        if (const auto& src = chunksData[i]) {
+            region->memoryUsage += sizes[i][0];
+            auto data = std::make_unique<ubyte[]>(sizes[i][0]);
+            std::memcpy(data.get(), src.get(), sizes[i][0]);
+            region->chunksData[i] = std::move(data);
+        }
+    }
+    region->unsaved = unsaved;
+    return region;
+}
+
+void RegionsLayer::writeAll() {
+    flushPending();
+    fs::create_directories(folder);
+
+    std::vector<std::pair<glm::ivec2, std::unique_ptr<WorldRegion>>> snapshots;
+    {
+        std::scoped_lock lock(mapMutex, dataMutex);
+        for (auto& [key, region] : regions) {
+            if (region->getChunks() == nullptr || !region->isUnsaved()) {
+                continue;
+            }
+            snapshots.emplace_back(key, region->snapshot());
+            region->setUnsaved(false);
+        }
+    }
+    std::unique_lock lock(filesMutex);
+    for (auto& [key, region] : snapshots) {
+        if (!appendRegion(key[0], key[1], region.get())) {
+            writeRegion(key[0], key[1], region.get());
+        }
     }
 }
 
@@ -97,24 +176,29 @@ void WorldRegions::put(
     std::unique_ptr<ubyte[]> data,
     size_t srcSize
 ) {
-    size_t size = srcSize;
     auto& layer = layers[layerid];
-    int regionX, regionZ, localX, localZ;
-    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
-
-    WorldRegion* region = layer.getOrCreateRegion(regionX, regionZ);
-    region->setUnsaved(true);
-    
-    if (data == nullptr) {
-        region->put(localX, localZ, nullptr, 0, 0);
-        return;
+    if (isBackgroundWriting()) {
+        layer.putPending(x, z, std::move(data), srcSize);
+        std::lock_guard lock(writerMutex);
+        flushRequested = true;
+        writerCv.notify_one();
+    } else {
+        layer.put(x, z, std::move(data), srcSize);
     }
+}
 
-    if (layer.compression != compression::Method::NONE) {
-        data = compression::compress(
-            data.get(), size, size, layer.compression);
+/// @brief Lights layer data length: encoded lightmap and checksum
+static inline constexpr uint LIGHTS_DATA_LEN = LIGHTMAP_DATA_LEN + 8;
+
+/// @brief Checksum of chunk blocks ids affecting cached lights
+static uint64_t lights_checksum(const Chunk& chunk, uint64_t fingerprint) {
+    const voxel* voxels = chunk.voxels.data();
+    // FNV-1a over ids
+    uint64_t hash = 0xCBF29CE484222325ULL ^ fingerprint;
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        hash = (hash ^ voxels[i].id) * 0x100000001B3ULL;
     }
-    region->put(localX, localZ, std::move(data), size, srcSize);
+    return hash;
 }
 
 static std::unique_ptr<ubyte[]> write_inventories(
@@ -124,8 +208,8 @@ static std::unique_ptr<ubyte[]> write_inventories(
     builder.putInt32(inventories.size());
     for (auto& entry : inventories) {
         builder.putInt32(entry.first);
-        auto map = entry.second->serialize();
-        auto bytes = json::to_binary(map, true);
+        // unchanged inventories are not encoded again
+        const auto& bytes = entry.second->encode();
         builder.putInt32(bytes.size());
         builder.put(bytes.data(), bytes.size());
     }
@@ -143,51 +227,100 @@ static ChunkInventoriesMap load_inventories(const ubyte* src, uint32_t size) {
     for (int i = 0; i < count; i++) {
         uint index = reader.getInt32();
         uint size = reader.getInt32();
-        auto map = json::from_binary(reader.pointer(), size);
-        reader.skip(size);
         auto inv = std::make_shared<Inventory>(0, 0);
-        inv->deserialize(map);
+        inv->decode(reader.pointer(), size);
+        reader.skip(size);
         inventories[index] = std::move(inv);
     }
     return inventories;
 }
 
-void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
-    if (generatorTestMode) {
-        return;
+static std::unique_ptr<ubyte[]> write_scheduled_updates(
+    const std::vector<ScheduledBlockUpdate>& updates, uint32_t& datasize
+) {
+    ByteBuilder builder;
+    builder.putInt32(updates.size());
+    for (const auto& update : updates) {
+        builder.putInt32(update.index);
+        builder.putInt64(update.tick);
     }
-    assert(chunk != nullptr);
-    if (!chunk->flags.lighted) {
-        return;
+    datasize = builder.size();
+    auto data = std::make_unique<ubyte[]>(datasize);
+    std::memcpy(data.get(), builder.data(), datasize);
+    return data;
+}
+
+static std::vector<ScheduledBlockUpdate> load_scheduled_updates(
+    const ubyte* src, uint32_t size
+) {
+    std::vector<ScheduledBlockUpdate> updates;
+    ByteReader reader(src, size);
+    auto count = reader.getInt32();
+    for (int i = 0; i < count; i++) {
+        ScheduledBlockUpdate update {};
+        update.index = reader.getInt32();
+        update.tick = reader.getInt64();
+        if (update.index < CHUNK_VOL) {
+            updates.push_back(update);
+        }
     }
-    bool lightsUnsaved = !chunk->flags.loadedLights && doWriteLights;
-    if (!chunk->flags.unsaved && !lightsUnsaved && !chunk->flags.entities) {
+    return updates;
+}
+
+void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
+    assert(chunk != nullptr);
+    if (!isPutNeeded(*chunk)) {
         return;
     }
+    encode(*chunk, std::move(entitiesData));
+    chunk->flags.unsaved = false;
+    chunk->flags.generated = false;
+}
 
-    int regionX, regionZ, localX, localZ;
-    calc_reg_coords(chunk->x, chunk->z, regionX, regionZ, localX, localZ);
+bool WorldRegions::isPutNeeded(const Chunk& chunk) const {
+    if (generatorTestMode || !chunk.flags.lighted) {
+        return false;
+    }
+    bool lightsUnsaved = !chunk.flags.loadedLights && doWriteLights;
+    return chunk.flags.unsaved || lightsUnsaved || chunk.flags.entities;
+}
 
-    put(chunk->x,
-        chunk->z,
+void WorldRegions::encode(
+    const Chunk& chunk, std::vector<ubyte> entitiesData
+) {
+    put(chunk.x,
+        chunk.z,
         REGION_LAYER_VOXELS,
-        chunk->encode(),
+        chunk.encode(),
         CHUNK_DATA_LEN);
 
+    // generator prototype is not needed anymore
+    if (chunk.flags.generated && doWritePrototypes) {
+        put(chunk.x, chunk.z, REGION_LAYER_PROTOTYPES, nullptr, 0);
+    }
+
     // Writing lights cache
-    if (doWriteLights && chunk->flags.lighted) {
-        put(chunk->x,
-            chunk->z,
+    if (doWriteLights && chunk.flags.lighted) {
+        auto lights = chunk.lightmap.encode();
+        auto data = std::make_unique<ubyte[]>(LIGHTS_DATA_LEN);
+        std::memcpy(data.get(), lights.get(), LIGHTMAP_DATA_LEN);
+        dataio::write_int64_big(
+            lights_checksum(chunk, lightsFingerprint),
+            data.get(),
+            LIGHTMAP_DATA_LEN
+        );
+        put(chunk.x,
+            chunk.z,
             REGION_LAYER_LIGHTS,
-            chunk->lightmap.encode(),
-            LIGHTMAP_DATA_LEN);
+            std::move(data),
+            LIGHTS_DATA_LEN);
     }
     // Writing block inventories
-    if (!chunk->inventories.empty()) {
+    if (!chunk.inventories.empty()) {
         uint datasize;
-        auto data = write_inventories(chunk->inventories, datasize);
-        put(chunk->x,
-            chunk->z,
+        auto data = write_inventories(chunk.inventories, datasize);
+        put(chunk.x,
+            chunk.z,
             REGION_LAYER_INVENTORIES,
             std::move(data),
             datasize);
@@ -198,74 +331,178 @@ void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
         for (size_t i = 0; i < entitiesData.size(); i++) {
             data[i] = entitiesData[i];
         }
-        put(chunk->x,
-            chunk->z,
+        put(chunk.x,
+            chunk.z,
             REGION_LAYER_ENTITIES,
             std::move(data),
             entitiesData.size());
     }
     // Writing blocks data
-    if (chunk->flags.blocksData) {
-        auto bytes = chunk->blocksMetadata.serialize();
-        put(chunk->x,
-            chunk->z,
+    if (chunk.flags.blocksData) {
+        auto bytes = chunk.blocksMetadata.serialize();
+        put(chunk.x,
+            chunk.z,
             REGION_LAYER_BLOCKS_DATA,
             bytes.release(),
             bytes.size());
     }
+    // Writing surface summary
+    {
+        auto voxels = chunk.voxels.read();
+        put(chunk.x,
+            chunk.z,
+            REGION_LAYER_SUMMARIES,
+            ChunkSummary::build(voxels.get()).encode(),
+            ChunkSummary::DATA_LEN);
+    }
+    // Writing scheduled block updates
+    if (chunk.flags.scheduledUpdates) {
+        uint32_t datasize;
+        auto data = write_scheduled_updates(chunk.scheduledUpdates, datasize);
+        put(chunk.x,
+            chunk.z,
+            REGION_LAYER_BLOCK_UPDATES,
+            std::move(data),
+            datasize);
+    }
+}
+
+void WorldRegions::prefetch(int x, int z) {
+    if (generatorTestMode) {
+        return;
+    }
+    for (auto& layer : layers) {
+        layer.prefetch(x, z);
+    }
 }
 
 std::unique_ptr<ubyte[]> WorldRegions::getVoxels(int x, int z) {
-    uint32_t size;
-    uint32_t srcSize;
     auto& layer = layers[REGION_LAYER_VOXELS];
-    auto* data = layer.getData(x, z, size, srcSize);
-    if (data == nullptr) {
-        return nullptr;
-    }
-    assert(srcSize == CHUNK_DATA_LEN);
-    return compression::decompress(data, size, srcSize, layer.compression);
+    std::unique_ptr<ubyte[]> voxels;
+    layer.readData(x, z, [&](const ubyte* data, uint32_t size, uint32_t srcSize) {
+        assert(srcSize == CHUNK_DATA_LEN);
+        voxels = compression::decompress(data, size, srcSize, layer.compression);
+    });
+    return voxels;
 }
 
-std::unique_ptr<light_t[]> WorldRegions::getLights(int x, int z) {
-    uint32_t size;
-    uint32_t srcSize;
+std::unique_ptr<light_t[]> WorldRegions::getLights(const Chunk& chunk) {
     auto& layer = layers[REGION_LAYER_LIGHTS];
-    auto* bytes = layer.getData(x, z, size, srcSize);
-    if (bytes == nullptr) {
-        return nullptr;
+    std::unique_ptr<light_t[]> lights;
+    layer.readData(chunk.x, chunk.z, [&](const ubyte* bytes, uint32_t size, uint32_t srcSize) {
+        if (srcSize != LIGHTMAP_DATA_LEN && srcSize != LIGHTS_DATA_LEN) {
+            logger.warning() << "invalid lights data size " << srcSize
+                             << " of chunk " << chunk.x << ", " << chunk.z;
+            return;
+        }
+        auto data = compression::decompress(
+            bytes, size, srcSize, layer.compression
+        );
+        if (srcSize == LIGHTS_DATA_LEN) {
+            auto checksum = static_cast<uint64_t>(
+                dataio::read_int64_big(data.get(), LIGHTMAP_DATA_LEN)
+            );
+            if (checksum != lights_checksum(chunk, lightsFingerprint)) {
+                return;
+            }
+        }
+        lights = Lightmap::decode(data.get());
+    });
+    return lights;
+}
+
+ChunkInventoriesMap WorldRegions::fetchInventories(int x, int z) {
+    ChunkInventoriesMap inventories;
+    layers[REGION_LAYER_INVENTORIES].readData(
+        x, z, [&](const ubyte* bytes, uint32_t bytesSize, uint32_t) {
+            inventories = load_inventories(bytes, bytesSize);
+        }
+    );
+    return inventories;
+}
+
+BlocksMetadata WorldRegions::getBlocksData(int x, int z) {
+    auto& layer = layers[REGION_LAYER_BLOCKS_DATA];
+    BlocksMetadata heap;
+    layer.readData(
+        x, z, [&](const ubyte* bytes, uint32_t bytesSize, uint32_t srcSize) {
+            if (layer.compression == compression::Method::NONE) {
+                heap.deserialize(bytes, bytesSize);
+                return;
+            }
+            auto data = compression::decompress(
+                bytes, bytesSize, srcSize, layer.compression
+            );
+            heap.deserialize(data.get(), srcSize);
+        }
+    );
+    return heap;
+}
+
+std::vector<ScheduledBlockUpdate> WorldRegions::getScheduledUpdates(
+    int x, int z
+) {
+    auto& layer = layers[REGION_LAYER_BLOCK_UPDATES];
+    std::vector<ScheduledBlockUpdate> updates;
+    layer.readData(
+        x, z, [&](const ubyte* bytes, uint32_t bytesSize, uint32_t srcSize) {
+            auto data = compression::decompress(
+                bytes, bytesSize, srcSize, layer.compression
+            );
+            updates = load_scheduled_updates(data.get(), srcSize);
+        }
+    );
+    return updates;
+}
+
+std::optional<ChunkSummary> WorldRegions::fetchSummary(int x, int z) {
+    if (generatorTestMode) {
+        return std::nullopt;
     }
-    auto data = compression::decompress(
-        bytes, size, srcSize, layer.compression
+    std::optional<ChunkSummary> summary;
+    layers[REGION_LAYER_SUMMARIES].readData(
+        x, z, [&](const ubyte* bytes, uint32_t, uint32_t srcSize) {
+            if (srcSize == ChunkSummary::DATA_LEN) {
+                summary = ChunkSummary();
+                summary->decode(bytes);
+            }
+        }
     );
-    assert(srcSize == LIGHTMAP_DATA_LEN);
-    return Lightmap::decode(data.get());
+    return summary;
 }
 
-ChunkInventoriesMap WorldRegions::fetchInventories(int x, int z) {
-    uint32_t bytesSize;
-    uint32_t srcSize;
-    auto bytes = layers[REGION_LAYER_INVENTORIES].getData(x, z, bytesSize, srcSize);
-    if (bytes == nullptr) {
-        return {};
+void WorldRegions::putPrototype(
+    int x, int z, const std::vector<ubyte>& data
+) {
+    if (generatorTestMode || !doWritePrototypes || data.empty()) {
+        return;
     }
-    return load_inventories(bytes, bytesSize);
+    auto bytes = std::make_unique<ubyte[]>(data.size());
+    std::memcpy(bytes.get(), data.data(), data.size());
+    put(x, z, REGION_LAYER_PROTOTYPES, std::move(bytes), data.size());
 }
 
-BlocksMetadata WorldRegions::getBlocksData(int x, int z) {
-    uint32_t bytesSize;
-    uint32_t srcSize;
-    auto bytes = layers[REGION_LAYER_BLOCKS_DATA].getData(x, z, bytesSize, srcSize);
-    if (bytes == nullptr) {
+std::vector<ubyte> WorldRegions::fetchPrototype(int x, int z) {
+    if (generatorTestMode || !doWritePrototypes) {
         return {};
     }
-    BlocksMetadata heap;
-    heap.deserialize(bytes, bytesSize);
-    return heap;
+    auto& layer = layers[REGION_LAYER_PROTOTYPES];
+    std::vector<ubyte> prototype;
+    layer.readData(
+        x, z, [&](const ubyte* bytes, uint32_t bytesSize, uint32_t srcSize) {
+            auto data = compression::decompress(
+                bytes, bytesSize, srcSize, layer.compression
+            );
+            prototype.assign(data.get(), data.get() + srcSize);
+        }
+    );
+    return prototype;
 }
 
-void WorldRegions::processInventories(int x, int z, const InventoryProc& func) {
-    processRegion(x, z, REGION_LAYER_INVENTORIES,
+uint WorldRegions::processInventories(
+    int x, int z, const InventoryProc& func
+) {
+    return processRegion(x, z, REGION_LAYER_INVENTORIES,
     [=](std::unique_ptr<ubyte[]> data, uint32_t* size) {
         auto inventories = load_inventories(data.get(), *size);
         for (const auto& [_, inventory] : inventories) {
@@ -275,7 +512,9 @@ void WorldRegions::processInventories(int x, int z, const InventoryProc& func) {
     });
 }
 
-void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
+uint WorldRegions::processBlocksData(
+    int x, int z, const BlockDataProc& func
+) {
     auto& voxLayer = layers[REGION_LAYER_VOXELS];
     auto& datLayer = layers[REGION_LAYER_BLOCKS_DATA];
     if (voxLayer.getRegion(x, z) || datLayer.getRegion(x, z)) {
@@ -289,9 +528,11 @@ void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
     if (voxRegfile == nullptr) {
         logger.warning() << "missing voxels region - discard blocks data for "
             << x << "_" << z;
+        datRegfile.reset();
         deleteRegion(REGION_LAYER_BLOCKS_DATA, x, z);
-        return;
+        return 0;
     }
+    uint processed = 0;
     for (uint cz = 0; cz < REGION_SIZE; cz++) {
         for (uint cx = 0; cx < REGION_SIZE; cx++) {
             int gx = cx + x * REGION_SIZE;
@@ -299,15 +540,21 @@ void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
 
             uint32_t datLength;
             uint32_t datSrcSize;
-            auto datData = RegionsLayer::readChunkData(
+            auto datData = datLayer.readChunkData(
                 gx, gz, datLength, datSrcSize, datRegfile.get()
             );
             if (datData == nullptr) {
                 continue;
             }
+            if (datLayer.compression != compression::Method::NONE) {
+                datData = compression::decompress(
+                    datData.get(), datLength, datSrcSize, datLayer.compression
+                );
+                datLength = datSrcSize;
+            }
             uint32_t voxLength;
             uint32_t voxSrcSize;
-            auto voxData = RegionsLayer::readChunkData(
+            auto voxData = voxLayer.readChunkData(
                 gx, gz, voxLength, voxSrcSize, voxRegfile.get()
             );
             if (voxData == nullptr) {
@@ -331,28 +578,32 @@ void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
             }
             auto bytes = blocksData.serialize();
             put(gx, gz, REGION_LAYER_BLOCKS_DATA, bytes.release(), bytes.size());
+            processed++;
         }
     }
+    datRegfile.reset();
+    voxRegfile.reset();
+    flushRegion(REGION_LAYER_BLOCKS_DATA, x, z);
+    return processed;
 }
 
 dv::value WorldRegions::fetchEntities(int x, int z) {
     if (generatorTestMode) {
         return nullptr;
     }
-    uint32_t bytesSize;
-    uint32_t srcSize;
-    const ubyte* data = layers[REGION_LAYER_ENTITIES].getData(x, z, bytesSize, srcSize);
-    if (data == nullptr) {
-        return nullptr;
-    }
-    auto map = json::from_binary(data, bytesSize);
-    if (map.empty()) {
+    dv::value map = nullptr;
+    layers[REGION_LAYER_ENTITIES].readData(
+        x, z, [&](const ubyte* data, uint32_t bytesSize, uint32_t) {
+            map = json::from_binary(data, bytesSize);
+        }
+    );
+    if (map == nullptr || map.empty()) {
         return nullptr;
     }
     return map;
 }
 
-void WorldRegions::processRegion(
+uint WorldRegions::processRegion(
     int x, int z, RegionLayerIndex layerid, const RegionProc& func
 ) {
     auto& layer = layers[layerid];
@@ -363,29 +614,339 @@ void WorldRegions::processRegion(
     if (regfile == nullptr) {
         throw std::runtime_error("could not open region file");
     }
+    uint processed = 0;
     for (uint cz = 0; cz < REGION_SIZE; cz++) {
         for (uint cx = 0; cx < REGION_SIZE; cx++) {
             int gx = cx + x * REGION_SIZE;
             int gz = cz + z * REGION_SIZE;
             uint32_t length;
             uint32_t srcSize;
-            auto data =
-                RegionsLayer::readChunkData(gx, gz, length, srcSize, regfile.get());
-            if (data == nullptr) {
-                continue;
-            }
-            if (layer.compression != compression::Method::NONE) {
+            std::unique_ptr<ubyte[]> data;
+            if (regfile.get()->isMapped() &&
+                regfile.get()->compression == layer.compression &&
+                layer.compression != compression::Method::NONE) {
+                // decompress right from the mapped file
+                int index = cz * REGION_SIZE + cx;
+                auto view = regfile.get()->view(index, length, srcSize);
+                if (view == nullptr) {
+                    continue;
+                }
                 data = compression::decompress(
-                    data.get(), length, srcSize, layer.compression
+                    view, length, srcSize, layer.compression
                 );
             } else {
+                data = layer.readChunkData(
+                    gx, gz, length, srcSize, regfile.get()
+                );
+                if (data == nullptr) {
+                    continue;
+                }
+                if (layer.compression != compression::Method::NONE) {
+                    data = compression::decompress(
+                        data.get(), length, srcSize, layer.compression
+                    );
+                }
+            }
+            if (layer.compression == compression::Method::NONE) {
                 srcSize = length;
             }
             if (auto writeData = func(std::move(data), &srcSize)) {
                 put(gx, gz, layerid, std::move(writeData), srcSize);
             }
+            processed++;
+        }
+    }
+    regfile.reset();
+    flushRegion(layerid, x, z);
+    return processed;
+}
+
+void WorldRegions::flushRegion(RegionLayerIndex layerid, int x, int z) {
+    auto& layer = layers[layerid];
+    if (auto region = layer.releaseRegion(x, z)) {
+        std::unique_lock lock(layer.filesMutex);
+        layer.writeRegion(x, z, region.get());
+    }
+}
+
+RegionsVerifyReport WorldRegions::verify(uint threads) const {
+    struct RegionFile {
+        RegionLayerIndex layer;
+        int x;
+        int z;
+        fs::path path;
+    };
+    std::vector<RegionFile> files;
+    for (const auto& layer : layers) {
+        if (!fs::is_directory(layer.folder)) {
+            continue;
+        }
+        for (const auto& file : fs::directory_iterator(layer.folder)) {
+            int x, z;
+            std::string name = file.path().stem().string();
+            if (file.path().extension() == ".bin" &&
+                parseRegionFilename(name, x, z)) {
+                files.push_back({layer.layer, x, z, file.path()});
+            }
+        }
+    }
+
+    RegionsVerifyReport report {};
+    report.files = files.size();
+    std::mutex reportMutex;
+    std::atomic<size_t> next = 0;
+    auto worker = [&]() {
+        RegionsVerifyReport local {};
+        for (size_t i = next++; i < files.size(); i = next++) {
+            const auto& entry = files[i];
+            std::unique_ptr<regfile> file;
+            try {
+                file = std::make_unique<regfile>(entry.path, true);
+            } catch (const std::runtime_error& err) {
+                logger.error() << "could not open region file "
+                               << entry.path.u8string() << ": " << err.what();
+                local.invalidFiles.push_back(entry.path);
+                continue;
+            }
+            for (uint index = 0; index < REGION_CHUNKS_COUNT; index++) {
+                switch (file->check(index)) {
+                    case ChunkIntegrity::ABSENT:
+                        break;
+                    case ChunkIntegrity::VALID:
+                        local.validChunks++;
+                        break;
+                    case ChunkIntegrity::UNCHECKED:
+                        local.uncheckedChunks++;
+                        break;
+                    case ChunkIntegrity::CORRUPTED: {
+                        int size = REGION_SIZE;
+                        local.corruptedChunks.push_back(
+                            {entry.layer,
+                             entry.x * size + static_cast<int>(index) % size,
+                             entry.z * size + static_cast<int>(index) / size}
+                        );
+                        break;
+                    }
+                }
+            }
+        }
+        std::lock_guard lock(reportMutex);
+        report.validChunks += local.validChunks;
+        report.uncheckedChunks += local.uncheckedChunks;
+        report.corruptedChunks.insert(
+            report.corruptedChunks.end(),
+            local.corruptedChunks.begin(),
+            local.corruptedChunks.end()
+        );
+        report.invalidFiles.insert(
+            report.invalidFiles.end(),
+            local.invalidFiles.begin(),
+            local.invalidFiles.end()
+        );
+    };
+    std::vector<std::thread> workers;
+    for (uint i = 1; i < std::max(1u, threads); i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    return report;
+}
+
+/// @brief Layers decoded into Chunk by WorldRegions::scan
+static constexpr RegionLayerIndex SCANNED_LAYERS[] {
+    REGION_LAYER_VOXELS,
+    REGION_LAYER_LIGHTS,
+    REGION_LAYER_INVENTORIES,
+    REGION_LAYER_BLOCKS_DATA,
+};
+
+/// @brief Decode chunk entry of the layer into the chunk
+/// @return false if the entry is not valid
+static bool decode_scanned(
+    Chunk& chunk,
+    RegionLayerIndex layer,
+    const ubyte* bytes,
+    uint32_t size,
+    uint32_t srcSize,
+    compression::Method method
+) {
+    std::unique_ptr<ubyte[]> decompressed;
+    if (method != compression::Method::NONE) {
+        decompressed = compression::decompress(bytes, size, srcSize, method);
+        bytes = decompressed.get();
+        size = srcSize;
+    }
+    switch (layer) {
+        case REGION_LAYER_VOXELS:
+            if (size != CHUNK_DATA_LEN) {
+                return false;
+            }
+            chunk.decode(bytes);
+            return true;
+        case REGION_LAYER_LIGHTS: {
+            if (size != LIGHTMAP_DATA_LEN && size != LIGHTS_DATA_LEN) {
+                return false;
+            }
+            auto lights = Lightmap::decode(bytes);
+            chunk.lightmap.set(lights.get());
+            return true;
+        }
+        case REGION_LAYER_INVENTORIES:
+            chunk.setBlockInventories(load_inventories(bytes, size));
+            return true;
+        case REGION_LAYER_BLOCKS_DATA:
+            chunk.blocksMetadata.deserialize(bytes, size);
+            return true;
+        default:
+            return false;
+    }
+}
+
+RegionsScanStats WorldRegions::scan(
+    uint layersMask, uint threads, const ChunkScanProc& func
+) const {
+    // region files are not rewritten by the writer thread meanwhile
+    std::lock_guard writeLock(writeMutex);
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<RegionLayerIndex> scanned;
+    std::unordered_set<glm::ivec2> coordsSet;
+    for (auto layer : SCANNED_LAYERS) {
+        if (!(layersMask & (1U << layer))) {
+            continue;
+        }
+        scanned.push_back(layer);
+        const auto& folder = layers[layer].folder;
+        if (!fs::is_directory(folder)) {
+            continue;
+        }
+        for (const auto& file : fs::directory_iterator(folder)) {
+            int x, z;
+            std::string name = file.path().stem().string();
+            if (file.path().extension() == ".bin" &&
+                parseRegionFilename(name, x, z)) {
+                coordsSet.insert({x, z});
+            }
+        }
+    }
+    std::vector<glm::ivec2> coords(coordsSet.begin(), coordsSet.end());
+
+    static auto& chunksCounter =
+        debug::Metrics::getInstance().counter("regions.scanned-chunks");
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> chunksDone = 0;
+    std::atomic<size_t> bytesDone = 0;
+    std::atomic<bool> stopped = false;
+    // the first error is rethrown when all threads are done
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto setError = [&](std::exception_ptr ptr) {
+        std::lock_guard lock(errorMutex);
+        if (error == nullptr) {
+            error = std::move(ptr);
+        }
+        stopped = true;
+    };
+    auto scanRegions = [&]() {
+        Chunk chunk(0, 0);
+        std::vector<std::unique_ptr<regfile>> files(scanned.size());
+        for (size_t i = next++; i < coords.size() && !stopped; i = next++) {
+            const auto& coord = coords[i];
+            for (size_t l = 0; l < scanned.size(); l++) {
+                files[l] = nullptr;
+                auto path = layers[scanned[l]].getRegionFilePath(
+                    coord.x, coord.y
+                );
+                if (!fs::is_regular_file(path)) {
+                    continue;
+                }
+                try {
+                    files[l] = std::make_unique<regfile>(path, true);
+                } catch (const std::runtime_error& err) {
+                    logger.error() << "could not open region file "
+                                   << path.u8string() << ": " << err.what();
+                }
+            }
+            for (uint index = 0; index < REGION_CHUNKS_COUNT; index++) {
+                int x = coord.x * REGION_SIZE + index % REGION_SIZE;
+                int z = coord.y * REGION_SIZE + index / REGION_SIZE;
+                bool present = false;
+                for (size_t l = 0; l < scanned.size(); l++) {
+                    auto& file = files[l];
+                    if (file == nullptr) {
+                        continue;
+                    }
+                    uint32_t size, srcSize;
+                    std::unique_ptr<ubyte[]> bytes;
+                    try {
+                        bytes = file->read(index, size, srcSize);
+                    } catch (const std::runtime_error& err) {
+                        logger.error() << "could not read chunk " << x
+                                       << ", " << z << ": " << err.what();
+                    }
+                    if (bytes == nullptr) {
+                        continue;
+                    }
+                    if (!present) {
+                        chunk.reset(x, z);
+                        present = true;
+                    }
+                    bytesDone += size;
+                    bool valid = false;
+                    try {
+                        valid = decode_scanned(
+                            chunk,
+                            scanned[l],
+                            bytes.get(),
+                            size,
+                            srcSize,
+                            file->compression
+                        );
+                    } catch (const std::runtime_error&) {
+                    }
+                    if (!valid) {
+                        logger.error() << "invalid chunk " << x << ", " << z
+                                       << " data in "
+                                       << file->filename.u8string();
+                    }
+                }
+                if (!present) {
+                    continue;
+                }
+                chunksDone++;
+                chunksCounter.add();
+                if (!func(chunk)) {
+                    stopped = true;
+                    break;
+                }
+            }
+        }
+    };
+    auto worker = [&]() {
+        try {
+            scanRegions();
+        } catch (...) {
+            setError(std::current_exception());
         }
+    };
+    std::vector<std::thread> workers;
+    for (uint i = 1; i < std::max(1u, threads); i++) {
+        workers.emplace_back(worker);
     }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - startTime;
+    return RegionsScanStats {
+        coords.size(), chunksDone, bytesDone, elapsed.count()
+    };
 }
 
 const fs::path& WorldRegions::getRegionsFolder(RegionLayerIndex layerid) const {
@@ -396,18 +957,140 @@ fs::path WorldRegions::getRegionFilePath(RegionLayerIndex layerid, int x, int z)
     return layers[layerid].getRegionFilePath(x, z);
 }
 
+void WorldRegions::setMappedFiles(bool flag) {
+    for (auto& layer : layers) {
+        layer.mappedFiles = flag;
+    }
+}
+
+void WorldRegions::writeAllAsync() {
+    if (!isBackgroundWriting()) {
+        writeAll();
+        return;
+    }
+    std::lock_guard lock(writerMutex);
+    writeRequested = true;
+    writerCv.notify_one();
+}
+
+void WorldRegions::setBackgroundWriting(bool flag) {
+    if (flag == isBackgroundWriting()) {
+        return;
+    }
+    if (flag) {
+        stopWriter = false;
+        writerThread = std::thread([this]() { runWriter(); });
+        return;
+    }
+    {
+        std::lock_guard lock(writerMutex);
+        stopWriter = true;
+        writerCv.notify_one();
+    }
+    writerThread.join();
+}
+
+bool WorldRegions::isBackgroundWriting() const {
+    return writerThread.joinable();
+}
+
+bool WorldRegions::isWriting() const {
+    return writing;
+}
+
+RegFilesStats WorldRegions::getRegFilesStats() const {
+    RegFilesStats stats {};
+    for (const auto& layer : layers) {
+        stats += layer.getRegFilesStats();
+    }
+    return stats;
+}
+
+bool WorldRegions::isChunkInMemory(int x, int z) {
+    return layers[REGION_LAYER_VOXELS].isInMemory(x, z);
+}
+
+size_t WorldRegions::getMemoryUsage() {
+    size_t total = 0;
+    for (auto& layer : layers) {
+        total += layer.getMemoryUsage();
+    }
+    return total;
+}
+
+size_t WorldRegions::evictRegion(int centerX, int centerZ, int keepDistance) {
+    std::unique_lock lock(writeMutex, std::try_to_lock);
+    if (!lock.owns_lock() || writing) {
+        return 0;
+    }
+    glm::ivec2 center(
+        floordiv(centerX, REGION_SIZE), floordiv(centerZ, REGION_SIZE)
+    );
+    int keepRegions = ceildiv(keepDistance, REGION_SIZE);
+    std::optional<glm::ivec2> farthest;
+    int maxDistance = keepRegions;
+    for (auto& layer : layers) {
+        for (const auto& coord : layer.getRegionsCoords()) {
+            auto delta = glm::abs(coord - center);
+            int distance = std::max(delta.x, delta.y);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                farthest = coord;
+            }
+        }
+    }
+    if (!farthest) {
+        return 0;
+    }
+    size_t freed = 0;
+    for (auto& layer : layers) {
+        // pending data is stored after the region file written
+        freed += layer.evictRegion(farthest->x, farthest->y);
+    }
+    return freed;
+}
+
+void WorldRegions::runWriter() {
+    std::unique_lock lock(writerMutex);
+    while (true) {
+        writerCv.wait(lock, [this]() {
+            return writeRequested || flushRequested || stopWriter;
+        });
+        if (!writeRequested && !flushRequested) {
+            break;
+        }
+        bool write = writeRequested;
+        writeRequested = flushRequested = false;
+        lock.unlock();
+        try {
+            std::lock_guard writeLock(writeMutex);
+            writing = write;
+            for (auto& layer : layers) {
+                if (write) {
+                    layer.writeAll();
+                } else {
+                    layer.flushPending();
+                }
+            }
+        } catch (const std::exception& err) {
+            logger.error() << "background regions writing failed: "
+                           << err.what();
+        }
+        writing = false;
+        lock.lock();
+    }
+}
+
 void WorldRegions::writeAll() {
+    std::lock_guard lock(writeMutex);
     for (auto& layer : layers) {
-        fs::create_directories(layer.folder);
         layer.writeAll();
     }
 }
 
 void WorldRegions::deleteRegion(RegionLayerIndex layerid, int x, int z) {
     auto& layer = layers[layerid];
-    if (layer.getRegFile({x, z}, false)) {
-        throw std::runtime_error("region file is currently in use");
-    }
+    layer.closeRegFile({x, z});
     auto file = layer.getRegionFilePath(x, z);
     if (fs::exists(file)) {
         logger.info() << "remove region file " << file.u8string();
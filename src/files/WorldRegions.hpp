@@ -1,16 +1,28 @@
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <filesystem>
 #include <functional>
 #include <glm/glm.hpp>
+#include <list>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "typedefs.hpp"
+#include "debug/MemoryUsage.hpp"
 #include "util/BufferPool.hpp"
+#include "util/FlatHashMap.hpp"
 #include "voxels/Chunk.hpp"
+#include "voxels/ChunkSummary.hpp"
 #include "maths/voxmaths.hpp"
 #include "coders/compression.hpp"
 #include "files.hpp"
@@ -21,7 +33,13 @@
 
 namespace fs = std::filesystem;
 
-inline constexpr uint REGION_HEADER_SIZE = 10;
+inline constexpr uint REGION_HEADER_SIZE = 14;
+/// @brief Region files of this and later versions store chunks entries
+/// CRC32C checksums verified on read
+inline constexpr uint REGION_CHECKSUMS_VERSION = 4;
+/// @brief Region files of this and later versions store the table
+/// position in the header. Older files end with the table
+inline constexpr uint REGION_TABLE_OFFSET_VERSION = 5;
 
 inline constexpr uint REGION_SIZE_BIT = 5;
 inline constexpr uint REGION_SIZE = (1 << (REGION_SIZE_BIT));
@@ -37,7 +55,11 @@ public:
 class WorldRegion {
     std::unique_ptr<std::unique_ptr<ubyte[]>[]> chunksData;
     std::unique_ptr<glm::u32vec2[]> sizes;
+    /// @brief Chunks changed since the region was written
+    std::bitset<REGION_CHUNKS_COUNT> modified;
     bool unsaved = false;
+    /// @brief Total size of chunks data in bytes
+    size_t memoryUsage = 0;
 public:
     WorldRegion();
     ~WorldRegion();
@@ -46,41 +68,164 @@ public:
     ubyte* getChunkData(uint x, uint z);
     glm::u32vec2 getChunkDataSize(uint x, uint z);
 
+    void setModified(uint x, uint z);
+    bool isModified(size_t index) const;
+
     void setUnsaved(bool unsaved);
     bool isUnsaved() const;
 
     std::unique_ptr<ubyte[]>* getChunks() const;
     glm::u32vec2* getSizes() const;
+
+    /// @brief Create region copy containing modified chunks only
+    std::unique_ptr<WorldRegion> snapshot() const;
+
+    size_t getMemoryUsage() const {
+        return memoryUsage;
+    }
+};
+
+enum class ChunkIntegrity {
+    /// @brief chunk is not present in region file
+    ABSENT,
+    /// @brief chunk entry checksum matches
+    VALID,
+    /// @brief chunk entry is well-formed, but region file has no checksums
+    UNCHECKED,
+    CORRUPTED
 };
 
 struct regfile {
-    files::rafile file;
+    fs::path filename;
+    /// @brief Stream used if file is not memory-mapped
+    std::unique_ptr<files::rafile> file;
+    std::unique_ptr<files::mmfile> mapping;
     int version;
+    /// @brief Chunks data compression method used in the file
+    compression::Method compression = compression::Method::NONE;
+    /// @brief Position of the chunks table (end of chunks data)
+    size_t tableOffset;
+    /// @brief Modified under the open files table stripe lock only
     bool inUse = false;
 
-    regfile(fs::path filename);
+    /// @param mapped try to map file into memory
+    regfile(const fs::path& filename, bool mapped = false);
     regfile(const regfile&) = delete;
 
+    bool isMapped() const {
+        return mapping != nullptr;
+    }
+
+    bool hasChecksums() const;
+
     std::unique_ptr<ubyte[]> read(int index, uint32_t& size, uint32_t& srcSize);
+
+    /// @brief Get chunk data view into the mapped file. Stays valid while
+    /// the region file is open
+    /// @param index chunk index in region
+    /// @param size [out] compressed chunk data length
+    /// @param srcSize [out] source chunk data length
+    /// @return nullptr if chunk is not present in region file or its
+    /// data is corrupted
+    const ubyte* view(int index, uint32_t& size, uint32_t& srcSize) const;
+
+    /// @brief Read chunks offsets table and compressed data sizes
+    /// @param offsets [out] chunk entries offsets (0 if chunk is not present)
+    /// @param sizes [out] chunk entries compressed data sizes
+    /// @param checksums [out] chunk entries checksums (0 if file has no
+    /// checksums), may be nullptr
+    /// @return table position (end of chunks data)
+    size_t readTable(
+        uint32_t* offsets, uint32_t* sizes, uint32_t* checksums = nullptr
+    );
+
+    /// @brief Check chunk entry without reporting errors
+    /// @param index chunk index in region
+    ChunkIntegrity check(int index);
+private:
+    uint32_t readChecksum(int index) const;
+
+    /// @brief Get bounds-checked chunk entry from the mapped file
+    /// @param valid [out] false if checksum does not match
+    /// @throws std::runtime_error - entry is out of the file bounds
+    const ubyte* viewEntry(
+        int index, uint32_t& size, uint32_t& srcSize, bool& valid
+    ) const;
+
+    /// @brief Read bounds-checked chunk entry from the file stream
+    /// @param valid [out] false if checksum does not match
+    /// @throws std::runtime_error - entry is out of the file bounds
+    std::unique_ptr<ubyte[]> readEntry(
+        int index, uint32_t& size, uint32_t& srcSize, bool& valid
+    );
+};
+
+/// @brief Uncompressed chunk data waiting to be compressed by the regions
+/// writer thread
+struct PendingChunkData {
+    /// @brief nullptr if chunk data is removed
+    std::unique_ptr<ubyte[]> data;
+    uint32_t srcSize;
 };
 
-using RegionsMap = std::unordered_map<glm::ivec2, std::unique_ptr<WorldRegion>>;
+using RegionsMap =
+    util::FlatHashMap<glm::ivec2, std::unique_ptr<WorldRegion>>;
+using ChunkDataProc =
+    std::function<void(const ubyte* data, uint32_t size, uint32_t srcSize)>;
 using RegionProc = std::function<std::unique_ptr<ubyte[]>(std::unique_ptr<ubyte[]>,uint32_t*)>;
 using InventoryProc = std::function<void(Inventory*)>;
 using BlockDataProc = std::function<void(BlocksMetadata*, std::unique_ptr<ubyte[]>)>;
 
+/// @brief Open region files table shard locked independently from others
+struct RegFilesStripe {
+    struct Entry {
+        std::unique_ptr<regfile> file;
+        /// @brief Entry position in the lru list
+        std::list<glm::ivec2>::iterator lruPosition;
+    };
+    std::mutex mutex;
+    /// @brief Notified when any stripe file gets out of use or closed
+    std::condition_variable cv;
+    /// @brief Open files coords from least to most recently used
+    std::list<glm::ivec2> lru;
+    util::FlatHashMap<glm::ivec2, Entry> files;
+};
+
+/// @brief Open region files table counters
+struct RegFilesStats {
+    /// @brief Requested file was open already
+    size_t hits = 0;
+    /// @brief Region files opened
+    size_t opens = 0;
+    /// @brief Files closed to free a slot for another one
+    size_t evictions = 0;
+    /// @brief Stripe lock acquisitions blocked by another thread
+    size_t contentions = 0;
+    /// @brief Waits for a region file to get out of use
+    size_t waits = 0;
+
+    RegFilesStats& operator+=(const RegFilesStats& other) {
+        hits += other.hits;
+        opens += other.opens;
+        evictions += other.evictions;
+        contentions += other.contentions;
+        waits += other.waits;
+        return *this;
+    }
+};
+
 /// @brief Region file pointer keeping inUse flag on until destroyed
 class regfile_ptr {
     regfile* file;
-    std::condition_variable* cv;
+    RegFilesStripe* stripe;
 public:
-    regfile_ptr(regfile* file, std::condition_variable* cv)
-        : file(file), cv(cv) {
+    regfile_ptr(regfile* file, RegFilesStripe* stripe)
+        : file(file), stripe(stripe) {
     }
 
     regfile_ptr(const regfile_ptr&) = delete;
 
-    regfile_ptr(std::nullptr_t) : file(nullptr), cv(nullptr) {
+    regfile_ptr(std::nullptr_t) : file(nullptr), stripe(nullptr) {
     }
 
     bool operator==(std::nullptr_t) const {
@@ -100,8 +245,11 @@ public:
     }
     void reset() {
         if (file) {
-            file->inUse = false;
-            cv->notify_one();
+            {
+                std::lock_guard lock(stripe->mutex);
+                file->inUse = false;
+            }
+            stripe->cv.notify_all();
             file = nullptr;
         }
     }
@@ -125,65 +273,242 @@ struct RegionsLayer {
 
     compression::Method compression = compression::Method::NONE;
 
+    /// @brief Map region files into memory when reading
+    bool mappedFiles = true;
+
     /// @brief In-memory regions data
     RegionsMap regions;
 
-    /// @brief In-memory regions map mutex
-    std::mutex mapMutex;
+    /// @brief In-memory regions map mutex. Shared for lookups
+    std::shared_mutex mapMutex;
+
+    /// @brief In-memory regions chunks data mutex
+    std::mutex dataMutex;
+
+    /// @brief Chunks data put in background writing mode
+    std::unordered_map<glm::ivec2, PendingChunkData> pending;
+
+    /// @brief Pending chunk data being compressed by the writer thread
+    std::optional<std::pair<glm::ivec2, PendingChunkData>> inflight;
+
+    /// @brief Pending chunks data mutex
+    std::mutex pendingMutex;
+
+    /// @brief Sizes of prefetched chunks data not read yet. Guarded by
+    /// dataMutex
+    std::unordered_map<glm::ivec2, uint32_t> prefetched;
+    /// @brief Prefetched chunks positions, oldest first. May contain
+    /// positions of already read chunks
+    std::deque<glm::ivec2> prefetchQueue;
+    size_t prefetchedBytes = 0;
 
-    /// @brief Open region files map
-    std::unordered_map<glm::ivec2, std::unique_ptr<regfile>> openRegFiles;
+    /// @brief Forget prefetched chunk when its data is read, dropping the
+    /// data if not modified. dataMutex must be locked
+    void consumePrefetched(int x, int z, WorldRegion& region);
 
-    /// @brief Open region files map mutex
-    std::mutex regFilesMutex;
-    std::condition_variable regFilesCv;
+    /// @brief Drop unmodified in-memory chunk data (it is stored in file)
+    void releaseChunkData(int x, int z);
 
+    /// @brief Region files mutex. Shared for reading, exclusive for writing
+    std::shared_mutex filesMutex;
+
+    /// @brief Open region files table
+    std::array<RegFilesStripe, REGION_FILES_STRIPES> regFiles;
+
+    struct {
+        std::atomic<size_t> hits {0};
+        std::atomic<size_t> opens {0};
+        std::atomic<size_t> evictions {0};
+        std::atomic<size_t> contentions {0};
+        std::atomic<size_t> waits {0};
+    } regFilesCounters;
+
+    RegFilesStripe& getRegFilesStripe(glm::ivec2 coord);
+
+    /// @brief Get open region file or open it, closing the least recently
+    /// used one if the stripe is full. Waits if the file is in use
+    /// @param coord region coords
+    /// @param create open file if it is not open yet
+    /// @return nullptr if the region file does not exist or is not open
+    /// and create is false
     [[nodiscard]] regfile_ptr getRegFile(glm::ivec2 coord, bool create = true);
-    [[nodiscard]] regfile_ptr useRegFile(glm::ivec2 coord);
-    regfile_ptr createRegFile(glm::ivec2 coord);
+
+    /// @brief Close region file, waiting until it gets out of use
     void closeRegFile(glm::ivec2 coord);
 
+    RegFilesStats getRegFilesStats() const;
+
     WorldRegion* getRegion(int x, int z);
     WorldRegion* getOrCreateRegion(int x, int z);
 
+    /// @brief Remove in-memory region from the map. Region must not be
+    /// accessed by other threads
+    /// @return nullptr if region is not loaded
+    std::unique_ptr<WorldRegion> releaseRegion(int x, int z);
+
+    /// @brief Write in-memory region if unsaved and remove it from memory.
+    /// Region must not be accessed by other threads
+    /// @return number of freed bytes
+    size_t evictRegion(int x, int z);
+
+    /// @return coords of in-memory regions
+    std::vector<glm::ivec2> getRegionsCoords();
+
+    /// @return total size of in-memory regions chunks data in bytes
+    size_t getMemoryUsage();
+
     fs::path getRegionFilePath(int x, int z) const;
 
-    /// @brief Get chunk data. Read from file if not loaded yet.
+    /// @brief Compress and store chunk data to the in-memory region
     /// @param x chunk x coord
     /// @param z chunk z coord
-    /// @param size [out] compressed chunk data length
-    /// @param size [out] source chunk data length
-    /// @return nullptr if no saved chunk data found
-    [[nodiscard]] ubyte* getData(int x, int z, uint32_t& size, uint32_t& srcSize);
+    /// @param data uncompressed chunk data or nullptr to remove chunk
+    /// @param srcSize uncompressed data size
+    void put(int x, int z, std::unique_ptr<ubyte[]> data, uint32_t srcSize);
+
+    /// @brief Store compressed chunk data to the in-memory region
+    void store(
+        int x,
+        int z,
+        std::unique_ptr<ubyte[]> data,
+        uint32_t size,
+        uint32_t srcSize
+    );
+
+    /// @brief Store uncompressed chunk data to compress it later
+    /// in flushPending
+    void putPending(int x, int z, std::unique_ptr<ubyte[]> data, uint32_t srcSize);
 
-    /// @brief Write or rewrite region file
+    /// @brief Compress pending chunks data and store it to in-memory regions
+    void flushPending();
+
+    /// @brief Read chunk data from file to the in-memory region if not
+    /// loaded yet. In-memory data may be replaced by the writer thread,
+    /// so it is accessed under dataMutex only (see readData)
+    /// @param x chunk x coord
+    /// @param z chunk z coord
+    /// @return false if no saved chunk data found
+    bool loadData(int x, int z);
+
+    /// @brief Load chunk data to memory ahead of reading. Prefetched data
+    /// is dropped when read or when prefetched data exceeds the memory
+    /// budget, oldest first
+    void prefetch(int x, int z);
+
+    /// @brief Pass chunk data to the callback. Data from a memory-mapped
+    /// region file is passed without copying and is not kept in memory.
+    /// Pending data is compressed once and moved to the in-memory region.
+    /// @param x chunk x coord
+    /// @param z chunk z coord
+    /// @param func data consumer called only if saved chunk data found
+    /// @return false if no saved chunk data found
+    bool readData(int x, int z, const ChunkDataProc& func);
+
+    /// @brief Check if chunk data is kept in memory (in-memory region or
+    /// pending data)
+    bool isInMemory(int x, int z);
+
+    /// @brief Write or rewrite region file. The file is written to
+    /// a temporary file replacing it when finished
     /// @param x region X
     /// @param z region Z
     void writeRegion(int x, int y, WorldRegion* entry);
 
-    /// @brief Write all unsaved regions to files
+    /// @brief Append modified chunks and an updated table after the table
+    /// of the existing region file, then point the header to the new
+    /// table, so the previous table is never overwritten in place
+    /// @param x region X
+    /// @param z region Z
+    /// @return false if region file must be fully rewritten
+    bool appendRegion(int x, int z, WorldRegion* entry);
+
+    /// @brief Write all unsaved regions to files. Regions data is copied so
+    /// it may be accessed by other threads while writing.
     void writeAll();
 
-    /// @brief Read chunk data from region file
+    /// @brief Read chunk data from region file. Data compressed with other
+    /// method than the layer uses gets recompressed.
     /// @param x chunk x coord
     /// @param z chunk z coord
     /// @param size [out] compressed chunk data length
     /// @param srcSize [out] source chunk data length
     /// @param rfile region file
     /// @return nullptr if chunk is not present in region file
-    [[nodiscard]] static std::unique_ptr<ubyte[]> readChunkData(
+    [[nodiscard]] std::unique_ptr<ubyte[]> readChunkData(
         int x, int z, uint32_t& size, uint32_t& srcSize, regfile* rfile
     );
 };
 
+/// @brief Result of the region files integrity check
+struct RegionsVerifyReport {
+    struct Chunk {
+        RegionLayerIndex layer;
+        int x;
+        int z;
+    };
+    size_t files = 0;
+    /// @brief Number of chunks with matching checksums
+    size_t validChunks = 0;
+    /// @brief Number of chunks in region files with no checksums
+    size_t uncheckedChunks = 0;
+    std::vector<Chunk> corruptedChunks;
+    /// @brief Region files could not be opened
+    std::vector<fs::path> invalidFiles;
+
+    bool isOk() const {
+        return corruptedChunks.empty() && invalidFiles.empty();
+    }
+};
+
+/// @brief Region files scan throughput
+struct RegionsScanStats {
+    size_t regions = 0;
+    size_t chunks = 0;
+    /// @brief Size of read chunks entries (compressed)
+    size_t bytes = 0;
+    /// @brief Scan duration in seconds
+    double seconds = 0.0;
+
+    double chunksPerSecond() const {
+        return seconds > 0.0 ? chunks / seconds : 0.0;
+    }
+};
+
+/// @brief Saved chunk consumer of WorldRegions::scan called by the scan
+/// threads. Returns false to stop the scan
+using ChunkScanProc = std::function<bool(const Chunk& chunk)>;
+
 class WorldRegions {
     /// @brief World directory
     fs::path directory;
 
     RegionsLayer layers[REGION_LAYERS_COUNT] {};
+
+    /// @brief Regions writing pass mutex, also held by scan
+    mutable std::mutex writeMutex;
+
+    std::thread writerThread;
+    std::mutex writerMutex;
+    std::condition_variable writerCv;
+    bool writeRequested = false;
+    bool flushRequested = false;
+    bool stopWriter = false;
+    std::atomic<bool> writing = false;
+    /// @brief Reports in-memory regions of layers as "regions.<folder>"
+    debug::MemorySource memorySource;
+
+    void runWriter();
+
+    /// @brief Write in-memory region to file and unload it
+    void flushRegion(RegionLayerIndex layerid, int x, int z);
 public:
     bool generatorTestMode = false;
     bool doWriteLights = true;
+    /// @brief Store generator prototypes (see putPrototype)
+    bool doWritePrototypes = true;
+    /// @brief Content lights fingerprint (ContentIndices::lightsFingerprint)
+    /// included to checksums of written lights
+    uint64_t lightsFingerprint = 0;
 
     WorldRegions(const fs::path& directory);
     WorldRegions(const WorldRegions&) = delete;
@@ -192,6 +517,15 @@ public:
     /// @brief Put all chunk data to regions
     void put(Chunk* chunk, std::vector<ubyte> entitiesData);
 
+    /// @brief Check if put stores the chunk data (the chunk is unsaved
+    /// or has lights or entities to be written)
+    bool isPutNeeded(const Chunk& chunk) const;
+
+    /// @brief Encode all chunk data to regions not checking and changing
+    /// the chunk flags (see put). Safe to call from other threads if the
+    /// chunk is not modified meanwhile
+    void encode(const Chunk& chunk, std::vector<ubyte> entitiesData);
+
     /// @brief Store data in specified region
     /// @param x chunk.x
     /// @param z chunk.z
@@ -206,19 +540,50 @@ public:
         size_t size
     );
 
+    /// @brief Read saved chunk data of all layers into memory, so the chunk
+    /// loading does not access region files. Thread-safe. Prefetched data
+    /// is kept until read within a memory budget (see RegionsLayer)
+    /// @param x chunk.x
+    /// @param z chunk.z
+    void prefetch(int x, int z);
+
     /// @brief Get chunk voxels data
     /// @param x chunk.x
     /// @param z chunk.z
     /// @return voxels data buffer or nullptr
     std::unique_ptr<ubyte[]> getVoxels(int x, int z);
 
-    /// @brief Get cached lights for chunk at x,z
-    /// @return lights data or nullptr
-    std::unique_ptr<light_t[]> getLights(int x, int z);
+    /// @brief Get cached lights of the chunk. Lights are checked to be
+    /// written for the same chunk voxels and content lights fingerprint
+    /// (lights written by old versions have no checksum and are trusted)
+    /// @param chunk chunk with voxels loaded
+    /// @return lights data or nullptr if missing or not valid
+    std::unique_ptr<light_t[]> getLights(const Chunk& chunk);
     
     ChunkInventoriesMap fetchInventories(int x, int z);
 
     BlocksMetadata getBlocksData(int x, int z);
+
+    std::vector<ScheduledBlockUpdate> getScheduledUpdates(int x, int z);
+
+    /// @brief Load the chunk surface summary written when the chunk was
+    /// saved. Thread-safe
+    /// @return summary or nullopt if not stored
+    std::optional<ChunkSummary> fetchSummary(int x, int z);
+
+    /// @brief Store generated chunk prototype data. Prototypes are
+    /// a generator cache of not saved chunks: the prototype is removed
+    /// when the generated chunk is saved (see Chunk::flags.generated)
+    /// @param x chunk.x
+    /// @param z chunk.z
+    /// @param data prototype data encoded by the world generator
+    void putPrototype(int x, int z, const std::vector<ubyte>& data);
+
+    /// @brief Load stored chunk prototype data
+    /// @param x chunk.x
+    /// @param z chunk.z
+    /// @return prototype data or empty vector if not stored
+    std::vector<ubyte> fetchPrototype(int x, int z);
     
     /// @brief Load saved entities data for chunk
     /// @param x chunk.x
@@ -226,17 +591,38 @@ public:
     /// @return map with entities list as "data"
     dv::value fetchEntities(int x, int z);
 
-    /// @brief Load, process and save processed region chunks data
+    /// @brief Load, process and save processed region chunks data.
+    /// Region file is rewritten right after processing
     /// @param x region X
     /// @param z region Z
     /// @param layerid regions layer index
     /// @param func processing callback
-    void processRegion(
+    /// @return number of processed chunks
+    uint processRegion(
         int x, int z, RegionLayerIndex layerid, const RegionProc& func);
 
-    void processInventories(int x, int z, const InventoryProc& func);
-
-    void processBlocksData(int x, int z, const BlockDataProc& func);
+    /// @brief Check chunks data checksums of all region files without
+    /// loading chunks. Region files must not be modified meanwhile
+    /// @param threads number of threads checking files
+    RegionsVerifyReport verify(uint threads) const;
+
+    /// @brief Decode every chunk stored in region files in parallel without
+    /// loading it. Only the requested layers are read: voxels, lights,
+    /// inventories and blocks data (other layers are ignored), data of
+    /// not requested or not stored layers is left empty. Reads files only
+    /// (not written in-memory data is not visible), regions writing waits
+    /// until the scan is finished, so func must not write regions
+    /// @param layersMask bit mask of layers (1 << RegionLayerIndex)
+    /// @param threads number of threads reading files
+    /// @param func chunks consumer, called in parallel with a chunk owned
+    /// by the calling thread (valid until the call returns)
+    RegionsScanStats scan(
+        uint layersMask, uint threads, const ChunkScanProc& func
+    ) const;
+
+    uint processInventories(int x, int z, const InventoryProc& func);
+
+    uint processBlocksData(int x, int z, const BlockDataProc& func);
 
     /// @brief Get regions directory by layer index
     /// @param layerid layer index
@@ -248,6 +634,44 @@ public:
     /// @brief Write all region layers
     void writeAll();
 
+    /// @brief Write all region layers in the writer thread.
+    /// Same as writeAll if background writing is disabled.
+    void writeAllAsync();
+
+    /// @brief Enable or disable background writing mode. Data put in the
+    /// mode gets compressed and written by the writer thread.
+    /// Disabling waits for the writer thread to finish.
+    void setBackgroundWriting(bool flag);
+
+    bool isBackgroundWriting() const;
+
+    /// @brief Check if the writer thread is writing region files
+    bool isWriting() const;
+
+    /// @brief Get open region files tables counters summed over all layers
+    RegFilesStats getRegFilesStats() const;
+
+    /// @return total size of in-memory regions data of all layers in bytes
+    size_t getMemoryUsage();
+
+    /// @brief Check if chunk voxels data is available without reading
+    /// region files
+    bool isChunkInMemory(int x, int z);
+
+    /// @brief Write the farthest in-memory region out of the given distance
+    /// to files (if unsaved) and remove it from memory. Does nothing while
+    /// regions are being written
+    /// @param centerX center chunk x
+    /// @param centerZ center chunk z
+    /// @param keepDistance distance to the center in chunks regions
+    /// intersecting are kept in memory
+    /// @return number of freed bytes, 0 if there is no region to evict
+    size_t evictRegion(int centerX, int centerZ, int keepDistance);
+
+    /// @brief Enable or disable memory-mapped region files reading.
+    /// Affects region files opened after the call.
+    void setMappedFiles(bool flag);
+
     void deleteRegion(RegionLayerIndex layerid, int x, int z);
 
     /// @brief Extract X and Z from 'X_Z.bin' region file name.
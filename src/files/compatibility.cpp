@@ -93,7 +93,10 @@ util::Buffer<ubyte> compatibility::convert_region_2to3(
                 break;
             case REGION_LAYER_ENTITIES:
             case REGION_LAYER_INVENTORIES:
-            case REGION_LAYER_BLOCKS_DATA: {
+            case REGION_LAYER_BLOCKS_DATA:
+            case REGION_LAYER_PROTOTYPES:
+            case REGION_LAYER_BLOCK_UPDATES:
+            case REGION_LAYER_SUMMARIES: {
                 builder.putInt32(size);
                 builder.putInt32(size);
                 builder.put(data, size);
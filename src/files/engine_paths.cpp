@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cctype>
 #include <filesystem>
 #include <sstream>
 #include <stack>
@@ -19,6 +20,7 @@ static inline auto CONTENT_FOLDER = std::filesystem::u8path("content");
 static inline auto WORLDS_FOLDER = std::filesystem::u8path("worlds");
 static inline auto CONFIG_FOLDER = std::filesystem::u8path("config");
 static inline auto EXPORT_FOLDER = std::filesystem::u8path("export");
+static inline auto CACHE_FOLDER = std::filesystem::u8path("cache");
 static inline auto CONTROLS_FILE = std::filesystem::u8path("controls.toml");
 static inline auto SETTINGS_FILE = std::filesystem::u8path("settings.toml");
 
@@ -60,6 +62,10 @@ void EnginePaths::prepare() {
     if (!fs::is_directory(configFolder)) {
         fs::create_directories(configFolder);
     }
+    auto cacheFolder = userFilesFolder / CACHE_FOLDER;
+    if (!fs::is_directory(cacheFolder)) {
+        fs::create_directories(cacheFolder);
+    }
 }
 
 std::filesystem::path EnginePaths::getUserFilesFolder() const {
@@ -104,6 +110,10 @@ std::filesystem::path EnginePaths::getConfigFolder() const {
     return userFilesFolder / CONFIG_FOLDER;
 }
 
+std::filesystem::path EnginePaths::getCacheFolder() const {
+    return userFilesFolder / CACHE_FOLDER;
+}
+
 std::filesystem::path EnginePaths::getCurrentWorldFolder() {
     return currentWorldFolder;
 }
@@ -213,39 +223,131 @@ std::filesystem::path EnginePaths::resolve(
     return std::filesystem::path(filename);
 }
 
+/// @brief Get index key: normalized relative path, '/' separated
+/// (lower-cased on Windows as its filesystem is case-insensitive)
+static std::optional<std::string> index_key(const std::string& filename) {
+    auto path = fs::u8path(filename);
+    if (path.has_root_path()) {
+        return std::nullopt;
+    }
+    auto key = path.lexically_normal().generic_u8string();
+    if (key == ".") {
+        key.clear();
+    }
+    while (!key.empty() && key.back() == '/') {
+        key.pop_back();
+    }
+    if (key.rfind("..", 0) == 0) {
+        return std::nullopt;
+    }
+#ifdef _WIN32
+    for (char& c : key) {
+        c = std::tolower(static_cast<unsigned char>(c));
+    }
+#endif
+    return key;
+}
+
 ResPaths::ResPaths(std::filesystem::path mainRoot, std::vector<PathsRoot> roots)
     : mainRoot(std::move(mainRoot)), roots(std::move(roots)) {
+    refresh();
+}
+
+void ResPaths::refresh() {
+    indices.assign(roots.size(), {});
+    for (size_t i = 0; i < roots.size(); i++) {
+        const auto& folder = roots[i].path;
+        auto& index = indices[i];
+        std::error_code ec;
+        if (!fs::is_directory(folder, ec)) {
+            continue;
+        }
+        index.entries.insert("");
+        index.folders[""];
+        auto options = fs::directory_options::follow_directory_symlink;
+        for (fs::recursive_directory_iterator it(folder, options, ec), end;
+             it != end;
+             it.increment(ec)) {
+            auto relative =
+                it->path().lexically_relative(folder).generic_u8string();
+            auto key = index_key(relative);
+            if (!key) {
+                continue;
+            }
+            size_t pos = key->rfind('/');
+            auto parent = pos == std::string::npos ? "" : key->substr(0, pos);
+            index.folders[parent].push_back(
+                it->path().filename().u8string()
+            );
+            if (it->is_directory(ec)) {
+                index.folders[*key];
+            }
+            index.entries.insert(std::move(*key));
+        }
+    }
+}
+
+bool ResPaths::exists(
+    size_t root,
+    const std::string& filename,
+    const std::optional<std::string>& key
+) const {
+    if (!key) {
+        return fs::exists(roots[root].path / fs::u8path(filename));
+    }
+    const auto& entries = indices[root].entries;
+    return entries.find(*key) != entries.end();
 }
 
 std::filesystem::path ResPaths::find(const std::string& filename) const {
+    auto key = index_key(filename);
     for (int i = roots.size() - 1; i >= 0; i--) {
-        auto& root = roots[i];
-        auto file = root.path / fs::u8path(filename);
-        if (fs::exists(file)) {
-            return file;
+        if (exists(i, filename, key)) {
+            return roots[i].path / fs::u8path(filename);
         }
     }
     return mainRoot / fs::u8path(filename);
 }
 
 std::string ResPaths::findRaw(const std::string& filename) const {
+    auto key = index_key(filename);
     for (int i = roots.size() - 1; i >= 0; i--) {
-        auto& root = roots[i];
-        if (fs::exists(root.path / std::filesystem::path(filename))) {
-            return root.name + ":" + filename;
+        if (exists(i, filename, key)) {
+            return roots[i].name + ":" + filename;
         }
     }
     throw std::runtime_error("could not to find file " + util::quote(filename));
 }
 
+/// @brief Get names of the folder entries
+static std::vector<std::string> list_folder(
+    const fs::path& folder,
+    const std::optional<std::string>& key,
+    const std::unordered_map<std::string, std::vector<std::string>>& folders
+) {
+    if (key) {
+        const auto& found = folders.find(*key);
+        if (found == folders.end()) {
+            return {};
+        }
+        return found->second;
+    }
+    std::vector<std::string> names;
+    if (fs::is_directory(folder)) {
+        for (const auto& entry : fs::directory_iterator(folder)) {
+            names.push_back(entry.path().filename().u8string());
+        }
+    }
+    return names;
+}
+
 std::vector<std::string> ResPaths::listdirRaw(const std::string& folderName) const {
     std::vector<std::string> entries;
+    auto key = index_key(folderName);
     for (int i = roots.size() - 1; i >= 0; i--) {
         auto& root = roots[i];
         auto folder = root.path / fs::u8path(folderName);
-        if (!fs::is_directory(folder)) continue;
-        for (const auto& entry : fs::directory_iterator(folder)) {
-            auto name = entry.path().filename().u8string();
+        for (const auto& name : list_folder(folder, key, indices[i].folders)) {
             entries.emplace_back(root.name + ":" + folderName + "/" + name);
         }
     }
@@ -256,12 +358,12 @@ std::vector<std::filesystem::path> ResPaths::listdir(
     const std::string& folderName
 ) const {
     std::vector<std::filesystem::path> entries;
+    auto key = index_key(folderName);
     for (int i = roots.size() - 1; i >= 0; i--) {
         auto& root = roots[i];
         std::filesystem::path folder = root.path / fs::u8path(folderName);
-        if (!fs::is_directory(folder)) continue;
-        for (const auto& entry : fs::directory_iterator(folder)) {
-            entries.push_back(entry.path());
+        for (const auto& name : list_folder(folder, key, indices[i].folders)) {
+            entries.push_back(folder / fs::u8path(name));
         }
     }
     return entries;
@@ -269,11 +371,13 @@ std::vector<std::filesystem::path> ResPaths::listdir(
 
 dv::value ResPaths::readCombinedList(const std::string& filename) const {
     dv::value list = dv::list();
-    for (const auto& root : roots) {
-        auto path = root.path / fs::u8path(filename);
-        if (!fs::exists(path)) {
+    auto key = index_key(filename);
+    for (size_t i = 0; i < roots.size(); i++) {
+        const auto& root = roots[i];
+        if (!exists(i, filename, key)) {
             continue;
         }
+        auto path = root.path / fs::u8path(filename);
         try {
             auto value = files::read_object(path);
             if (!value.isList()) {
@@ -294,11 +398,13 @@ dv::value ResPaths::readCombinedList(const std::string& filename) const {
 
 dv::value ResPaths::readCombinedObject(const std::string& filename) const {
     dv::value object = dv::object();
-    for (const auto& root : roots) {
-        auto path = root.path / fs::u8path(filename);
-        if (!fs::exists(path)) {
+    auto key = index_key(filename);
+    for (size_t i = 0; i < roots.size(); i++) {
+        const auto& root = roots[i];
+        if (!exists(i, filename, key)) {
             continue;
         }
+        auto path = root.path / fs::u8path(filename);
         try {
             auto value = files::read_object(path);
             if (!value.isObject()) {
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <filesystem>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <tuple>
 
@@ -29,6 +32,8 @@ public:
     std::filesystem::path getWorldFolderByName(const std::string& name);
     std::filesystem::path getWorldsFolder() const;
     std::filesystem::path getConfigFolder() const;
+    /// @brief Get folder of data which may be deleted any time
+    std::filesystem::path getCacheFolder() const;
 
     void setCurrentWorldFolder(std::filesystem::path folder);
     std::filesystem::path getCurrentWorldFolder();
@@ -59,10 +64,17 @@ struct PathsRoot {
     std::filesystem::path path;
 };
 
+/// @brief Resources lookup through the packs roots (the last ones override
+/// the first ones). Files of the roots are indexed at construction, so
+/// lookups and listings do not touch the filesystem
 class ResPaths {
 public:
     ResPaths(std::filesystem::path mainRoot, std::vector<PathsRoot> roots);
 
+    /// @brief Index roots files again after files are added or removed.
+    /// Must not be called while other threads use the paths
+    void refresh();
+
     std::filesystem::path find(const std::string& filename) const;
     std::string findRaw(const std::string& filename) const;
     std::vector<std::filesystem::path> listdir(const std::string& folder) const;
@@ -78,6 +90,22 @@ public:
     const std::filesystem::path& getMainRoot() const;
 
 private:
+    struct Index {
+        /// @brief Files and folders keys (see index_key)
+        std::unordered_set<std::string> entries;
+        /// @brief Entries names by folder key ("" is the root folder)
+        std::unordered_map<std::string, std::vector<std::string>> folders;
+    };
     std::filesystem::path mainRoot;
     std::vector<PathsRoot> roots;
+    /// @brief Index of every root
+    std::vector<Index> indices;
+
+    /// @param key index key of the filename, std::nullopt if the path is
+    /// not indexed (absolute or outside of the roots)
+    bool exists(
+        size_t root,
+        const std::string& filename,
+        const std::optional<std::string>& key
+    ) const;
 };
@@ -13,6 +13,19 @@
 #include "coders/toml.hpp"
 #include "util/stringutil.hpp"
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define VC_MMAP_SUPPORTED
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace fs = std::filesystem;
 
 files::rafile::rafile(const fs::path& filename)
@@ -36,6 +49,100 @@ void files::rafile::read(char* buffer, std::streamsize size) {
     file.read(buffer, size);
 }
 
+#ifdef _WIN32
+files::mmfile::mmfile(const fs::path& filename) {
+    HANDLE file = CreateFileW(
+        filename.wstring().c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("could not to open file " + filename.string());
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        throw std::runtime_error("could not to map file " + filename.string());
+    }
+    HANDLE mapping =
+        CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        throw std::runtime_error("could not to map file " + filename.string());
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("could not to map file " + filename.string());
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    bytes = static_cast<const ubyte*>(view);
+    filelength = static_cast<size_t>(size.QuadPart);
+}
+
+files::mmfile::~mmfile() {
+    UnmapViewOfFile(bytes);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+}
+
+bool files::mmfile::is_supported() {
+    return true;
+}
+#elif defined(VC_MMAP_SUPPORTED)
+files::mmfile::mmfile(const fs::path& filename) {
+    int fd = open(filename.u8string().c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("could not to open file " + filename.string());
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("could not to map file " + filename.string());
+    }
+    void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mapping stays valid after the descriptor is closed
+    close(fd);
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("could not to map file " + filename.string());
+    }
+    bytes = static_cast<const ubyte*>(view);
+    filelength = static_cast<size_t>(st.st_size);
+}
+
+files::mmfile::~mmfile() {
+    munmap(const_cast<ubyte*>(bytes), filelength);
+}
+
+bool files::mmfile::is_supported() {
+    return true;
+}
+#else
+files::mmfile::mmfile(const fs::path& filename) {
+    throw std::runtime_error("memory-mapped files are not supported");
+}
+
+files::mmfile::~mmfile() = default;
+
+bool files::mmfile::is_supported() {
+    return false;
+}
+#endif
+
+const ubyte* files::mmfile::data() const {
+    return bytes;
+}
+
+size_t files::mmfile::length() const {
+    return filelength;
+}
+
 bool files::write_bytes(
     const fs::path& filename, const ubyte* data, size_t size
 ) {
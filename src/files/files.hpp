@@ -25,6 +25,27 @@ namespace files {
         size_t length() const;
     };
 
+    /// @brief Read-only memory-mapped file
+    class mmfile {
+        const ubyte* bytes = nullptr;
+        size_t filelength = 0;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    public:
+        /// @throws std::runtime_error if file could not be mapped
+        mmfile(const fs::path& filename);
+        mmfile(const mmfile&) = delete;
+        ~mmfile();
+
+        const ubyte* data() const;
+        size_t length() const;
+
+        /// @brief Check if memory-mapped files are supported on the platform
+        static bool is_supported();
+    };
+
     /// @brief Write bytes array to the file without any extra data
     /// @param file target file
     /// @param data data bytes array
@@ -64,17 +64,48 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.add("load-distance", &settings.chunks.loadDistance);
     builder.add("load-speed", &settings.chunks.loadSpeed);
     builder.add("padding", &settings.chunks.padding);
+    builder.add("autosave-interval", &settings.chunks.autosaveInterval);
+    builder.add("compact-distance", &settings.chunks.compactDistance);
+    builder.add("memory-budget", &settings.chunks.memoryBudget);
+    builder.add("cache-size", &settings.chunks.cacheSize);
+
+    builder.section("simulation");
+    builder.add("tick-rate", &settings.simulation.tickRate);
 
     builder.section("graphics");
     builder.add("fog-curve", &settings.graphics.fogCurve);
     builder.add("backlight", &settings.graphics.backlight);
     builder.add("dense-render", &settings.graphics.denseRender);
+    builder.add("greedy-meshing", &settings.graphics.greedyMeshing);
     builder.add("gamma", &settings.graphics.gamma);
     builder.add("frustum-culling", &settings.graphics.frustumCulling);
+    builder.add("lod-distance", &settings.graphics.lodDistance);
+    builder.add("horizon-distance", &settings.graphics.horizonDistance);
+    builder.add("impostors-distance", &settings.graphics.impostorsDistance);
+    builder.add("shadows", &settings.graphics.shadows);
+    builder.add("shadows-resolution", &settings.graphics.shadowsResolution);
+    builder.add("light-textures", &settings.graphics.lightTextures);
+    builder.add("occlusion-culling", &settings.graphics.occlusionCulling);
+    builder.add("multi-draw-indirect", &settings.graphics.multiDrawIndirect);
+    builder.add("texture-arrays", &settings.graphics.textureArrays);
+    builder.add("texture-streaming", &settings.graphics.textureStreaming);
+    builder.add("compressed-atlases", &settings.graphics.compressedAtlases);
+    builder.add("dynamic-resolution", &settings.graphics.dynamicResolution);
+    builder.add(
+        "dynamic-resolution-fps", &settings.graphics.dynamicResolutionFps
+    );
     builder.add("skybox-resolution", &settings.graphics.skyboxResolution);
     builder.add("chunk-max-vertices", &settings.graphics.chunkMaxVertices);
     builder.add("chunk-max-renderers", &settings.graphics.chunkMaxRenderers);
 
+    builder.section("scripting");
+    builder.add("gc-pause", &settings.scripting.gcPause);
+    builder.add("gc-step-mul", &settings.scripting.gcStepMul);
+    builder.add("gc-frame-steps", &settings.scripting.gcFrameSteps);
+    builder.add("handler-budget", &settings.scripting.handlerBudget);
+    builder.add("throttle-handlers", &settings.scripting.throttleHandlers);
+    builder.add("bytecode-cache", &settings.scripting.bytecodeCache);
+
     builder.section("ui");
     builder.add("language", &settings.ui.language);
     builder.add("world-preview-size", &settings.ui.worldPreviewSize);
@@ -82,6 +113,8 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.section("debug");
     builder.add("generator-test-mode", &settings.debug.generatorTestMode);
     builder.add("do-write-lights", &settings.debug.doWriteLights);
+    builder.add("do-write-prototypes", &settings.debug.doWritePrototypes);
+    builder.add("hot-reload", &settings.debug.hotReload);
 }
 
 dv::value SettingsHandler::getValue(const std::string& name) const {
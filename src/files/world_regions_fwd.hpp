@@ -8,6 +8,13 @@ enum RegionLayerIndex : uint {
     REGION_LAYER_INVENTORIES,
     REGION_LAYER_ENTITIES,
     REGION_LAYER_BLOCKS_DATA,
+    /// @brief Generated chunk prototypes cache (see WorldGenerator)
+    REGION_LAYER_PROTOTYPES,
+    /// @brief Pending scheduled block updates (see BlocksController)
+    REGION_LAYER_BLOCK_UPDATES,
+    /// @brief Chunks surface summaries drawn as far terrain
+    /// (see ChunkSummary)
+    REGION_LAYER_SUMMARIES,
     
     REGION_LAYERS_COUNT
 };
@@ -1,5 +1,7 @@
 #include "ContentGfxCache.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 
 #include "UiDocument.hpp"
@@ -7,11 +9,55 @@
 #include "content/Content.hpp"
 #include "content/ContentPack.hpp"
 #include "graphics/core/Atlas.hpp"
+#include "graphics/core/ImageData.hpp"
+#include "graphics/core/Texture.hpp"
+#include "graphics/core/TextureAnimation.hpp"
+#include "graphics/core/TextureArray.hpp"
+#include "graphics/core/UniformBuffer.hpp"
+#include "debug/Logger.hpp"
 #include "maths/UVRegion.hpp"
 #include "voxels/Block.hpp"
 #include "core_defs.hpp"
 #include "settings.hpp"
 
+static debug::Logger logger("content-gfx-cache");
+
+static_assert(ContentGfxCache::MAX_ROTATIONS == BlockRotProfile::MAX_COUNT);
+
+/// @brief AnimationUniforms block data, see shaders/lib/animation.glsl
+struct AnimationUniforms {
+    /// @brief First frame index, frames count, cycle duration in seconds
+    glm::vec4 animations[ContentGfxCache::MAX_ANIMATIONS];
+    /// @brief Two frames per element: layer, frame end time in the cycle
+    glm::vec4 frames[ContentGfxCache::MAX_ANIMATION_FRAMES / 2];
+};
+static_assert(sizeof(AnimationUniforms) == 10240, "std140 layout expected");
+
+/// @brief Copy atlas region pixels to a new image
+static std::unique_ptr<ImageData> crop_region(
+    const ImageData& atlas, const UVRegion& region
+) {
+    uint atlasWidth = atlas.getWidth();
+    uint atlasHeight = atlas.getHeight();
+    uint x = std::round(region.u1 * atlasWidth);
+    uint y = std::round(region.v1 * atlasHeight);
+    uint width = std::max(1.0f, std::round(region.getWidth() * atlasWidth));
+    uint height = std::max(1.0f, std::round(region.getHeight() * atlasHeight));
+
+    auto image = std::make_unique<ImageData>(
+        ImageFormat::rgba8888, width, height
+    );
+    const ubyte* src = atlas.getData();
+    ubyte* dst = image->getData();
+    for (uint row = 0; row < height; row++) {
+        std::copy(
+            src + ((y + row) * atlasWidth + x) * 4,
+            src + ((y + row) * atlasWidth + x + width) * 4,
+            dst + row * width * 4
+        );
+    }
+    return image;
+}
 
 ContentGfxCache::ContentGfxCache(
     const Content& content,
@@ -29,36 +75,298 @@ void ContentGfxCache::refresh(const Block& def, const Atlas& atlas) {
             !settings.denseRender.get() && atlas.has(tex + "_opaque")) {
             tex = tex + "_opaque";
         }
+        if (!atlas.has(tex)) {
+            tex = TEXTURE_NOTFOUND;
+        }
         if (atlas.has(tex)) {
             sideregions[def.rt.id * 6 + side] = atlas.get(tex);
-        } else if (atlas.has(TEXTURE_NOTFOUND)) {
-            sideregions[def.rt.id * 6 + side] = atlas.get(TEXTURE_NOTFOUND);
+            sideRegionIndices[def.rt.id * 6 + side] = atlasIndices.at(tex);
         }
     }
     if (def.model == BlockModel::custom) {
         auto model = assets.require<model::Model>(def.modelName);
+        auto& indices = modelRegionIndices[def.rt.id];
+        indices.assign(model.meshes.size(), 0);
         // temporary dirty fix tbh
         if (def.modelName.find(':') == std::string::npos) {
-            for (auto& mesh : model.meshes) {
+            for (size_t i = 0; i < model.meshes.size(); i++) {
+                auto& mesh = model.meshes[i];
                 size_t pos = mesh.texture.find(':');
                 if (pos == std::string::npos) {
                     continue;
                 }
-                if (auto region = atlas.getIf(mesh.texture.substr(pos+1))) {
+                auto name = mesh.texture.substr(pos+1);
+                if (auto region = atlas.getIf(name)) {
                     for (auto& vertex : mesh.vertices) {
                         vertex.uv = region->apply(vertex.uv);
                     }
+                    indices[i] = atlasIndices.at(name);
                 }
             }
         }
         models[def.rt.id] = std::move(model);
+        bakeModel(def);
+    } else if (def.model == BlockModel::aabb) {
+        bakeBox(def);
+    }
+}
+
+/// @brief Get rotation variant axes (identity if block is not rotatable)
+static CoordSystem get_orient(const Block& def, uint rotation) {
+    if (def.rotatable) {
+        return def.rotations.variants[rotation];
+    }
+    return CoordSystem({1, 0, 0}, {0, 1, 0}, {0, 0, 1});
+}
+
+void ContentGfxCache::bakeModel(const Block& def) {
+    const auto& model = models.at(def.rt.id);
+    for (uint rotation = 0; rotation < MAX_ROTATIONS; rotation++) {
+        auto orient = get_orient(def, rotation);
+        glm::vec3 X(orient.axisX);
+        glm::vec3 Y(orient.axisY);
+        glm::vec3 Z(orient.axisZ);
+
+        auto& vertices = bakedModels[def.rt.id * MAX_ROTATIONS + rotation];
+        vertices.clear();
+        for (size_t meshIndex = 0; meshIndex < model.meshes.size();
+             meshIndex++) {
+            const auto& mesh = model.meshes[meshIndex];
+            uint region = getModelRegionIndex(def.rt.id, meshIndex);
+            // model uvs are atlas-space, vertices store region-local ones
+            const auto& uvRegion = atlasRegions.at(region);
+            glm::vec2 uvOffset(uvRegion.u1, uvRegion.v1);
+            glm::vec2 uvScale(uvRegion.getWidth(), uvRegion.getHeight());
+            for (size_t triangle = 0; triangle < mesh.vertices.size() / 3;
+                 triangle++) {
+                auto r = mesh.vertices[triangle * 3 + (triangle % 2) * 2].coord -
+                         mesh.vertices[triangle * 3 + 1].coord;
+                r = glm::normalize(r);
+                for (int i = 0; i < 3; i++) {
+                    const auto& vertex = mesh.vertices[triangle * 3 + i];
+                    auto n = vertex.normal.x * X + vertex.normal.y * Y +
+                             vertex.normal.z * Z;
+                    auto vcoord = vertex.coord - 0.5f;
+                    auto position = vcoord.x * X + vcoord.y * Y + vcoord.z * Z;
+                    auto right = glm::cross(r, n);
+                    vertices.push_back(BakedModelVertex {
+                        position,
+                        (vertex.uv - uvOffset) / uvScale,
+                        region,
+                        n,
+                        position + n * 0.5f + (right + r) * 0.5f,
+                        glm::ivec3(right),
+                        glm::ivec3(r)});
+                }
+            }
+        }
+    }
+}
+
+void ContentGfxCache::bakeBox(const Block& def) {
+    for (uint rotation = 0; rotation < MAX_ROTATIONS; rotation++) {
+        auto& box = bakedBoxes[def.rt.id * MAX_ROTATIONS + rotation];
+        box = {};
+        if (def.hitboxes.empty()) {
+            continue;
+        }
+        AABB hitbox = def.hitboxes[0];
+        for (const auto& part : def.hitboxes) {
+            hitbox.a = glm::min(hitbox.a, part.a);
+            hitbox.b = glm::max(hitbox.b, part.b);
+        }
+        auto size = hitbox.size();
+        auto orient = get_orient(def, rotation);
+        if (def.rotatable) {
+            orient.transform(hitbox);
+        }
+        glm::vec3 X = glm::vec3(orient.axisX) * size.x;
+        glm::vec3 Y = glm::vec3(orient.axisY) * size.y;
+        glm::vec3 Z = glm::vec3(orient.axisZ) * size.z;
+        box.offset = hitbox.center() - glm::vec3(0.5f);
+        box.faces[0] = {X, Y, Z, 5};     // north
+        box.faces[1] = {-X, Y, -Z, 4};   // south
+        box.faces[2] = {X, -Z, Y, 3};    // top
+        box.faces[3] = {-X, -Z, -Y, 2};  // bottom
+        box.faces[4] = {-Z, Y, X, 1};    // west
+        box.faces[5] = {Z, Y, -X, 0};    // east
+        box.visible = true;
+    }
+}
+
+void ContentGfxCache::buildRegionsTable(const Atlas& atlas) {
+    atlasRegions.clear();
+    atlasIndices.clear();
+    atlasRegions.emplace_back();
+
+    std::vector<std::string> names;
+    for (const auto& [name, _] : atlas.getRegions()) {
+        names.push_back(name);
+    }
+    std::sort(names.begin(), names.end());
+    if (names.size() >= MAX_ATLAS_REGIONS) {
+        logger.error() << "too many atlas regions: " << names.size()
+                       << ", the last ones will not be rendered correctly";
+    }
+    for (const auto& name : names) {
+        if (atlasRegions.size() < MAX_ATLAS_REGIONS) {
+            atlasIndices[name] = atlasRegions.size();
+            atlasRegions.push_back(atlas.get(name));
+        } else {
+            atlasIndices[name] = 0;
+        }
+    }
+    regionAnimations.assign(atlasRegions.size(), 0);
+}
+
+void ContentGfxCache::buildRegionsTexture(const Atlas& atlas) {
+    const uint regionsPerRow = 128;
+    uint width = regionsPerRow * 3;
+    uint height = (atlasRegions.size() + regionsPerRow - 1) / regionsPerRow;
+    ImageData image(ImageFormat::rgba8888, width, height);
+    ubyte* data = image.getData();
+    std::fill(data, data + width * height * 4, 0);
+
+    const auto& texture = *atlas.getTexture();
+    float atlasWidth = texture.getWidth();
+    float atlasHeight = texture.getHeight();
+    for (size_t i = 0; i < atlasRegions.size(); i++) {
+        const auto& region = atlasRegions[i];
+        const uint values[6] {
+            static_cast<uint>(std::round(region.u1 * atlasWidth)),
+            static_cast<uint>(std::round(region.v1 * atlasHeight)),
+            static_cast<uint>(std::round(region.getWidth() * atlasWidth)),
+            static_cast<uint>(std::round(region.getHeight() * atlasHeight)),
+            regionAnimations[i],
+            0,
+        };
+        ubyte* dst = data + i * 12;
+        for (uint value : values) {
+            *(dst++) = (value >> 8) & 0xFF;
+            *(dst++) = value & 0xFF;
+        }
     }
+    regionsTexture = Texture::from(&image);
+    regionsTexture->setMipMapping(false);
+}
+
+void ContentGfxCache::buildTextureArray(const Atlas& atlas) {
+    textureArray = nullptr;
+    if (!settings.textureArrays.get()) {
+        return;
+    }
+    if (atlas.getImage() == nullptr) {
+        logger.error() << "texture arrays require uncompressed blocks atlas";
+        return;
+    }
+    const auto& atlasImage = *atlas.getImage();
+
+    // frames of animations are appended after the regions layers
+    std::vector<const TextureAnimation*> animations;
+    size_t framesCount = 0;
+    for (const auto& animation : assets.getAnimations()) {
+        if (animation.dstAtlas != &atlas || animation.srcAtlas == nullptr ||
+            animation.frames.empty()) {
+            continue;
+        }
+        const auto& found = atlasIndices.find(animation.dstRegion);
+        if (found == atlasIndices.end() || found->second == 0) {
+            continue;
+        }
+        if (animation.srcAtlas->getImage() == nullptr) {
+            logger.error() << "texture arrays require uncompressed "
+                           << "animation frames atlas, the atlas is used";
+            return;
+        }
+        if (animations.size() >= MAX_ANIMATIONS ||
+            framesCount + animation.frames.size() > MAX_ANIMATION_FRAMES) {
+            // the atlas is animated by TextureAnimator without limits
+            logger.error() << "too many blocks texture animations for "
+                           << "a texture array, the atlas is used";
+            return;
+        }
+        animations.push_back(&animation);
+        framesCount += animation.frames.size();
+    }
+    size_t layersCount = atlasRegions.size() + framesCount;
+    if (layersCount > TextureArray::MAX_LAYERS) {
+        logger.error() << "too many atlas regions for a texture array: "
+                       << layersCount << ", the atlas is used";
+        return;
+    }
+    uint atlasWidth = atlasImage.getWidth();
+    uint atlasHeight = atlasImage.getHeight();
+    // layers take the largest region size, smaller regions are upscaled
+    uint layerWidth = 1;
+    uint layerHeight = 1;
+    for (size_t i = 1; i < atlasRegions.size(); i++) {
+        const auto& region = atlasRegions[i];
+        layerWidth = std::max(layerWidth, static_cast<uint>(
+            std::round(region.getWidth() * atlasWidth)));
+        layerHeight = std::max(layerHeight, static_cast<uint>(
+            std::round(region.getHeight() * atlasHeight)));
+    }
+    textureArray = std::make_unique<TextureArray>(
+        layerWidth, layerHeight, layersCount
+    );
+    for (size_t i = 1; i < atlasRegions.size(); i++) {
+        textureArray->setLayer(i, *crop_region(atlasImage, atlasRegions[i]));
+    }
+
+    auto data = std::make_unique<AnimationUniforms>();
+    uint layer = atlasRegions.size();
+    for (size_t i = 0; i < animations.size(); i++) {
+        const auto& animation = *animations[i];
+        const auto& srcImage = *animation.srcAtlas->getImage();
+        uint firstFrame = layer - atlasRegions.size();
+        float time = 0.0f;
+        for (const auto& frame : animation.frames) {
+            textureArray->setLayer(layer, *crop_region(srcImage, frame.region));
+            time += frame.duration;
+            uint index = layer - atlasRegions.size();
+            auto& pair = data->frames[index / 2];
+            if (index % 2 == 0) {
+                pair.x = layer;
+                pair.y = time;
+            } else {
+                pair.z = layer;
+                pair.w = time;
+            }
+            layer++;
+        }
+        if (time <= 0.0f) {
+            continue;
+        }
+        data->animations[i] = glm::vec4(
+            firstFrame, animation.frames.size(), time, 0.0f
+        );
+        regionAnimations[atlasIndices.at(animation.dstRegion)] = i + 1;
+    }
+    animationsBuffer->update(data.get());
+
+    textureArray->generateMipmaps();
+    logger.info() << "blocks texture array: " << layersCount
+                  << " layers " << layerWidth << "x" << layerHeight << ", "
+                  << animations.size() << " animations";
 }
 
 void ContentGfxCache::refresh() {
     auto indices = content.getIndices();
     sideregions = std::make_unique<UVRegion[]>(indices->blocks.count() * 6);
+    sideRegionIndices = std::make_unique<uint[]>(indices->blocks.count() * 6);
+    bakedModels.assign(indices->blocks.count() * MAX_ROTATIONS, {});
+    bakedBoxes = std::make_unique<BakedBox[]>(
+        indices->blocks.count() * MAX_ROTATIONS
+    );
     const auto& atlas = assets.require<Atlas>("blocks");
+    animationsBuffer = std::make_unique<UniformBuffer>(
+        sizeof(AnimationUniforms)
+    );
+    auto animationsData = std::make_unique<AnimationUniforms>();
+    animationsBuffer->update(animationsData.get());
+    buildRegionsTable(atlas);
+    buildTextureArray(atlas);
+    buildRegionsTexture(atlas);
 
     const auto& blocks = indices->blocks.getIterable();
     for (blockid_t i = 0; i < blocks.size(); i++) {
@@ -67,12 +375,47 @@ void ContentGfxCache::refresh() {
     }
 }
 
+void ContentGfxCache::refreshRegion(
+    const Atlas& atlas, const std::string& name
+) {
+    const auto& found = atlasIndices.find(name);
+    if (textureArray == nullptr || atlas.getImage() == nullptr ||
+        found == atlasIndices.end() || found->second == 0) {
+        return;
+    }
+    uint index = found->second;
+    textureArray->setLayer(
+        index, *crop_region(*atlas.getImage(), atlasRegions[index])
+    );
+    textureArray->generateMipmaps();
+}
+
 ContentGfxCache::~ContentGfxCache() = default;
 
 const Content* ContentGfxCache::getContent() const {
     return &content;
 }
 
+uint ContentGfxCache::getModelRegionIndex(blockid_t id, size_t mesh) const {
+    const auto& found = modelRegionIndices.find(id);
+    if (found == modelRegionIndices.end() || mesh >= found->second.size()) {
+        return 0;
+    }
+    return found->second[mesh];
+}
+
+const Texture* ContentGfxCache::getRegionsTexture() const {
+    return regionsTexture.get();
+}
+
+const TextureArray* ContentGfxCache::getTextureArray() const {
+    return textureArray.get();
+}
+
+const UniformBuffer* ContentGfxCache::getAnimationsBuffer() const {
+    return animationsBuffer.get();
+}
+
 const model::Model& ContentGfxCache::getModel(blockid_t id) const {
     const auto& found = models.find(id);
     if (found == models.end()) {
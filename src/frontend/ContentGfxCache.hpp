@@ -3,8 +3,10 @@
 #include "typedefs.hpp"
 
 #include <memory>
+#include <string>
 #include <stdexcept>
 #include <unordered_map>
+#include <vector>
 
 #include "graphics/commons/Model.hpp"
 
@@ -12,6 +14,9 @@ class Content;
 class Assets;
 class Atlas;
 class Block;
+class Texture;
+class TextureArray;
+class UniformBuffer;
 struct UVRegion;
 struct GraphicsSettings;
 
@@ -19,6 +24,35 @@ namespace model {
     struct Model;
 }
 
+/// @brief Custom model vertex baked for a block rotation variant
+struct BakedModelVertex {
+    /// @brief Position relative to the block position
+    glm::vec3 position;
+    /// @brief Texture coordinates local to the atlas region
+    glm::vec2 uv;
+    uint region;
+    glm::vec3 normal;
+    /// @brief Soft light sampling point relative to the block position
+    glm::vec3 lightPoint;
+    glm::ivec3 lightRight;
+    glm::ivec3 lightUp;
+};
+
+/// @brief AABB block faces baked for a block rotation variant
+struct BakedBox {
+    struct Face {
+        /// @brief Face sides and normal scaled by the box size
+        glm::vec3 X, Y, Z;
+        /// @brief Texture side index
+        uint side;
+    };
+    /// @brief Box center offset from the block center
+    glm::vec3 offset;
+    Face faces[6];
+    /// @brief False if the block has no hitboxes
+    bool visible = false;
+};
+
 class ContentGfxCache {
     const Content& content;
     const Assets& assets;
@@ -26,8 +60,50 @@ class ContentGfxCache {
 
     // array of block sides uv regions (6 per block)
     std::unique_ptr<UVRegion[]> sideregions;
+    // array of block sides atlas regions indices (6 per block)
+    std::unique_ptr<uint[]> sideRegionIndices;
     std::unordered_map<blockid_t, model::Model> models;
+    // atlas regions indices of custom models meshes
+    std::unordered_map<blockid_t, std::vector<uint>> modelRegionIndices;
+
+    /// @brief Blocks atlas regions table. Index 0 is the whole atlas
+    std::vector<UVRegion> atlasRegions;
+    std::unordered_map<std::string, uint> atlasIndices;
+    /// @brief Atlas regions table texture used by chunks shader
+    std::unique_ptr<Texture> regionsTexture;
+
+    /// @brief Atlas regions copied to layers of the same index,
+    /// nullptr if texture arrays are disabled
+    std::unique_ptr<TextureArray> textureArray;
+    /// @brief Animation index + 1 of every atlas region, zero if the region
+    /// is not animated by the chunks shader
+    std::vector<uint> regionAnimations;
+    /// @brief Texture animations played by the chunks shader
+    std::unique_ptr<UniformBuffer> animationsBuffer;
+
+    /// @brief Custom models vertices for every block rotation variant
+    /// (MAX_ROTATIONS per block)
+    std::vector<std::vector<BakedModelVertex>> bakedModels;
+    /// @brief AABB blocks faces for every block rotation variant
+    /// (MAX_ROTATIONS per block)
+    std::unique_ptr<BakedBox[]> bakedBoxes;
+
+    void buildRegionsTable(const Atlas& atlas);
+    void buildRegionsTexture(const Atlas& atlas);
+    void buildTextureArray(const Atlas& atlas);
+    void bakeModel(const Block& def);
+    void bakeBox(const Block& def);
 public:
+    /// @brief Max number of atlas regions referenced by chunk meshes
+    static constexpr uint MAX_ATLAS_REGIONS = 4096;
+    /// @brief Max number of texture animations played by the chunks shader
+    static constexpr uint MAX_ANIMATIONS = 128;
+    /// @brief Max total number of frames of the shader texture animations
+    static constexpr uint MAX_ANIMATION_FRAMES = 1024;
+    /// @brief Number of baked rotation variants per block
+    /// (BlockRotProfile::MAX_COUNT)
+    static constexpr uint MAX_ROTATIONS = 8;
+
     ContentGfxCache(
         const Content& content,
         const Assets& assets,
@@ -39,11 +115,57 @@ public:
         return sideregions[id * 6 + side];
     }
 
+    inline uint getRegionIndex(blockid_t id, int side) const {
+        return sideRegionIndices[id * 6 + side];
+    }
+
+    inline const UVRegion& getAtlasRegion(uint index) const {
+        return atlasRegions[index];
+    }
+
+    /// @return atlas region index of the custom model mesh texture
+    uint getModelRegionIndex(blockid_t id, size_t mesh) const;
+
+    /// @brief Get atlas regions table texture.
+    /// Every region takes three RGBA texels: x, y and width, height in atlas
+    /// pixels, animation index + 1 (zero if not animated) and zero,
+    /// as 16 bit big-endian values
+    const Texture* getRegionsTexture() const;
+
+    /// @brief Get blocks texture array. Layer of every atlas region has
+    /// the region index, layer 0 is unused as the region 0 is the whole atlas.
+    /// Frames of animated regions follow the regions layers
+    /// @return nullptr if texture arrays are disabled or not supported
+    const TextureArray* getTextureArray() const;
+
+    /// @brief Get AnimationUniforms block buffer (see
+    /// shaders/lib/animation.glsl). Animations are played by the chunks
+    /// shader with texture arrays only, the atlas is animated by
+    /// TextureAnimator
+    const UniformBuffer* getAnimationsBuffer() const;
+
     const model::Model& getModel(blockid_t id) const;
 
+    /// @brief Get custom model vertices of the block rotation variant
+    /// (3 per triangle)
+    inline const std::vector<BakedModelVertex>& getBakedModel(
+        blockid_t id, uint rotation
+    ) const {
+        return bakedModels[id * MAX_ROTATIONS + rotation % MAX_ROTATIONS];
+    }
+
+    /// @brief Get AABB block faces of the rotation variant
+    inline const BakedBox& getBakedBox(blockid_t id, uint rotation) const {
+        return bakedBoxes[id * MAX_ROTATIONS + rotation % MAX_ROTATIONS];
+    }
+
     const Content* getContent() const;
 
     void refresh(const Block& block, const Atlas& atlas);
 
+    /// @brief Update the texture array layer of the atlas region changed
+    /// in place (see Atlas::replace)
+    void refreshRegion(const Atlas& atlas, const std::string& name);
+
     void refresh();
 };
@@ -0,0 +1,205 @@
+#include "HotReloader.hpp"
+
+#include "assets/Assets.hpp"
+#include "coders/imageio.hpp"
+#include "content/Content.hpp"
+#include "content/ContentLoader.hpp"
+#include "content/ContentPack.hpp"
+#include "debug/Logger.hpp"
+#include "files/FileWatcher.hpp"
+#include "files/engine_paths.hpp"
+#include "graphics/core/Atlas.hpp"
+#include "graphics/core/ImageData.hpp"
+#include "items/ItemDef.hpp"
+#include "logic/scripting/scripting.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "world/Level.hpp"
+#include "ContentGfxCache.hpp"
+#include "LevelFrontend.hpp"
+
+static debug::Logger logger("hot-reload");
+
+/// @brief Watched files checks per second
+static constexpr int CHECKS_RATE = 1;
+
+HotReloader::HotReloader(
+    Level& level,
+    const Content& content,
+    LevelFrontend& frontend,
+    Assets& assets,
+    ResPaths& paths
+)
+    : level(level),
+      content(content),
+      frontend(frontend),
+      assets(assets),
+      paths(paths),
+      clock(CHECKS_RATE, 1) {
+    std::vector<fs::path> folders;
+    for (const auto& [_, pack] : content.getPacks()) {
+        folders.push_back(pack->getInfo().folder);
+    }
+    watcher = std::make_unique<FileWatcher>(std::move(folders));
+}
+
+HotReloader::~HotReloader() = default;
+
+void HotReloader::update(float delta) {
+    if (!clock.update(delta)) {
+        return;
+    }
+    std::vector<fs::path> removed;
+    auto changed = watcher->poll(&removed);
+    if (!changed.empty() || !removed.empty()) {
+        // files index is rebuilt as files may be added or removed
+        paths.refresh();
+    }
+    for (const auto& file : changed) {
+        try {
+            reload(file);
+        } catch (const std::exception& err) {
+            logger.error() << file.u8string() << ": " << err.what();
+        }
+    }
+}
+
+ContentPackRuntime* HotReloader::findPack(
+    const fs::path& file, std::string& relative
+) const {
+    ContentPackRuntime* found = nullptr;
+    for (const auto& [_, pack] : content.getPacks()) {
+        auto path = file.lexically_relative(pack->getInfo().folder);
+        auto str = path.generic_u8string();
+        if (path.empty() || str.rfind("..", 0) == 0) {
+            continue;
+        }
+        // pack folders may be nested (core pack contains others)
+        if (found == nullptr || str.length() < relative.length()) {
+            found = pack.get();
+            relative = std::move(str);
+        }
+    }
+    return found;
+}
+
+void HotReloader::reload(const fs::path& file) {
+    std::string relative;
+    auto pack = findPack(file, relative);
+    if (pack == nullptr) {
+        return;
+    }
+    const auto& info = pack->getInfo();
+    auto extension = file.extension().u8string();
+    size_t separator = relative.find('/');
+    if (separator == std::string::npos) {
+        return;
+    }
+    auto folder = relative.substr(0, separator);
+    // path inside of the folder without extension
+    auto name = relative.substr(
+        separator + 1, relative.length() - separator - 1 - extension.length()
+    );
+    if (folder == "textures" && extension == ".png") {
+        size_t pos = name.find('/');
+        if (pos != std::string::npos) {
+            reloadTexture(file, name.substr(0, pos), name.substr(pos + 1));
+        }
+    } else if (folder == ContentPack::BLOCKS_FOLDER.u8string() &&
+               extension == ".json") {
+        const auto& defs = content.blocks.getDefs();
+        const auto& found = defs.find(info.id + ":" + name);
+        if (found != defs.end()) {
+            reloadBlock(*found->second, file);
+        }
+    } else if (folder == "scripts" && extension == ".lua") {
+        reloadScript(*pack, file, name);
+    }
+}
+
+void HotReloader::reloadTexture(
+    const fs::path& file,
+    const std::string& atlasName,
+    const std::string& name
+) {
+    auto atlas = assets.get<Atlas>(atlasName);
+    if (atlas == nullptr || !atlas->has(name)) {
+        return;
+    }
+    auto image = imageio::read(file);
+    image->fixAlphaColor();
+    if (!atlas->replace(name, *image, Atlas::EXTRUSION)) {
+        logger.warning() << atlasName << ":" << name
+                         << " can not be replaced in place (size or "
+                            "format changed), reopen the world to apply";
+        return;
+    }
+    if (atlasName == "blocks") {
+        frontend.getContentGfxCache().refreshRegion(*atlas, name);
+    }
+    logger.info() << "reloaded texture " << atlasName << ":" << name;
+}
+
+void HotReloader::reloadBlock(Block& def, const fs::path& file) {
+    ContentLoader::reloadBlock(content, def, file);
+    frontend.getContentGfxCache().refresh(
+        def, assets.require<Atlas>("blocks")
+    );
+    remesh(def);
+    logger.info() << "reloaded block " << def.name;
+}
+
+void HotReloader::reloadScript(
+    ContentPackRuntime& pack,
+    const fs::path& file,
+    const std::string& scriptName
+) {
+    const auto& info = pack.getInfo();
+    auto fileName = info.id + ":scripts/" + scriptName + ".lua";
+    if (scriptName == "world") {
+        scripting::load_world_script(
+            pack.getEnvironment(), info.id, file, fileName, pack.worldfuncsset
+        );
+        logger.info() << "reloaded " << fileName;
+        return;
+    }
+    auto prefix = info.id + ":";
+    bool reloaded = false;
+    for (const auto& [name, def] : content.blocks.getDefs()) {
+        if (name.rfind(prefix, 0) == 0 && def->scriptName == scriptName) {
+            scripting::load_content_script(
+                pack.getEnvironment(), name, file, fileName, def->rt.funcsset
+            );
+            reloaded = true;
+        }
+    }
+    for (const auto& [name, def] : content.items.getDefs()) {
+        if (name.rfind(prefix, 0) == 0 && def->scriptName == scriptName) {
+            scripting::load_content_script(
+                pack.getEnvironment(), name, file, fileName, def->rt.funcsset
+            );
+            reloaded = true;
+        }
+    }
+    if (reloaded) {
+        content.getIndices()->updateScriptsFlags();
+        logger.info() << "reloaded " << fileName;
+    }
+}
+
+void HotReloader::remesh(const Block& def) {
+    blockid_t id = def.rt.id;
+    for (const auto& chunk : level.chunks->getChunks()) {
+        if (chunk == nullptr) {
+            continue;
+        }
+        auto voxels = chunk->voxels.read();
+        for (uint i = 0; i < CHUNK_VOL; i++) {
+            if (voxels[i].id == id) {
+                chunk->setModified();
+                break;
+            }
+        }
+    }
+}
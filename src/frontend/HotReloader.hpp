@@ -0,0 +1,65 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "util/Clock.hpp"
+
+class Assets;
+class Block;
+class Content;
+class ContentPackRuntime;
+class FileWatcher;
+class Level;
+class LevelFrontend;
+class ResPaths;
+
+namespace fs = std::filesystem;
+
+/// @brief Applies changes of content packs files while playing.
+/// Atlas textures replace their regions in place, block definitions are
+/// loaded into the existing blocks remeshing chunks containing them,
+/// block, item and world scripts are executed again in the pack
+/// environment. Other changes take effect after the world is opened again
+class HotReloader {
+    Level& level;
+    const Content& content;
+    LevelFrontend& frontend;
+    Assets& assets;
+    ResPaths& paths;
+    std::unique_ptr<FileWatcher> watcher;
+    util::Clock clock;
+
+    /// @brief Get pack the file belongs to (the innermost pack folder)
+    /// @param relative destination path relative to the pack folder
+    ContentPackRuntime* findPack(
+        const fs::path& file, std::string& relative
+    ) const;
+
+    void reload(const fs::path& file);
+    void reloadTexture(
+        const fs::path& file,
+        const std::string& atlasName,
+        const std::string& name
+    );
+    void reloadBlock(Block& def, const fs::path& file);
+    void reloadScript(
+        ContentPackRuntime& pack,
+        const fs::path& file,
+        const std::string& scriptName
+    );
+    /// @brief Mark loaded chunks containing the block modified
+    void remesh(const Block& def);
+public:
+    HotReloader(
+        Level& level,
+        const Content& content,
+        LevelFrontend& frontend,
+        Assets& assets,
+        ResPaths& paths
+    );
+    ~HotReloader();
+
+    void update(float delta);
+};
@@ -17,7 +17,8 @@ LevelFrontend::LevelFrontend(
     Player* currentPlayer,
     LevelController* controller,
     Assets& assets,
-    const EngineSettings& settings
+    const EngineSettings& settings,
+    const std::filesystem::path& cacheFolder
 )
     : level(*controller->getLevel()),
       controller(controller),
@@ -27,7 +28,7 @@ LevelFrontend::LevelFrontend(
       )) {
     assets.store(
         BlocksPreview::build(
-            *contentCache, assets, *level.content->getIndices()
+            *contentCache, assets, *level.content->getIndices(), cacheFolder
         ),
         "block-previews"
     );
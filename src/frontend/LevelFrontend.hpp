@@ -1,5 +1,6 @@
 #pragma once
 
+#include <filesystem>
 #include <memory>
 
 class Level;
@@ -19,7 +20,8 @@ public:
         Player* currentPlayer,
         LevelController* controller,
         Assets& assets,
-        const EngineSettings& settings
+        const EngineSettings& settings,
+        const std::filesystem::path& cacheFolder
     );
     ~LevelFrontend();
 
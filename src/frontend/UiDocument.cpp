@@ -60,7 +60,7 @@ std::unique_ptr<UiDocument> UiDocument::read(
     const std::string& fileName
 ) {
     const std::string text = files::read_string(file);
-    auto xmldoc = xml::parse(file.u8string(), text);
+    auto xmldoc = gui::UiXmlReader::parse(file.u8string(), text);
 
     auto env = penv == nullptr 
         ? scripting::create_doc_environment(scripting::get_root_environment(), name)
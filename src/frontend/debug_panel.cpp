@@ -4,11 +4,18 @@
 #include "settings.hpp"
 #include "hud.hpp"
 #include "content/Content.hpp"
+#include "debug/MemoryUsage.hpp"
+#include "debug/Metrics.hpp"
+#include "debug/Profiler.hpp"
+#include "files/WorldFiles.hpp"
+#include "files/engine_paths.hpp"
 #include "graphics/core/Mesh.hpp"
+#include "graphics/ui/elements/Button.hpp"
 #include "graphics/ui/elements/CheckBox.hpp"
 #include "graphics/ui/elements/TextBox.hpp"
 #include "graphics/ui/elements/TrackBar.hpp"
 #include "graphics/ui/elements/InputBindBox.hpp"
+#include "graphics/ui/elements/Plotter.hpp"
 #include "graphics/render/WorldRenderer.hpp"
 #include "graphics/render/ParticlesRenderer.hpp"
 #include "graphics/render/ChunksRenderer.hpp"
@@ -21,6 +28,7 @@
 #include "voxels/Block.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
+#include "voxels/ChunksStorage.hpp"
 #include "world/Level.hpp"
 #include "world/World.hpp"
 
@@ -78,6 +86,7 @@ std::shared_ptr<UINode> create_debug_panel(
     }));
     panel->add(create_label([]() {
         return L"speakers: " + std::to_wstring(audio::count_speakers())+
+               L" virtual: " + std::to_wstring(audio::count_virtual_voices()) +
                L" streams: " + std::to_wstring(audio::count_streams());
     }));
     panel->add(create_label([]() {
@@ -96,12 +105,62 @@ std::shared_ptr<UINode> create_debug_panel(
     }));
     panel->add(create_label([&]() {
         return L"chunks: "+std::to_wstring(level.chunks->getChunksCount())+
-               L" visible: "+std::to_wstring(ChunksRenderer::visibleChunks);
+               L" visible: "+std::to_wstring(ChunksRenderer::visibleChunks)+
+               L" occluded: "+std::to_wstring(ChunksRenderer::occludedChunks);
+    }));
+    panel->add(create_label([]() {
+        return L"chunks-vertices: " +
+               std::to_wstring(ChunksRenderer::visibleVertices);
+    }));
+    panel->add(create_label([&]() {
+        auto stats = level.chunksStorage->getMemoryStats();
+        auto& regions = level.getWorld()->wfile->getRegions();
+        return L"chunks-memory (MiB): voxels " +
+               std::to_wstring(stats.voxels >> 20) + L" lights " +
+               std::to_wstring(stats.lightmaps >> 20) + L" meshes " +
+               std::to_wstring(ChunksRenderer::meshesMemory >> 20) +
+               L" regions " + std::to_wstring(regions.getMemoryUsage() >> 20);
+    }));
+    panel->add(create_label([]() {
+        // spent / budget microseconds of chunks loading stages
+        auto& metrics = debug::Metrics::getInstance();
+        auto stage = [&metrics](const std::string& name) {
+            auto spent = metrics.gauge("chunks.spent." + name).get();
+            auto budget = metrics.gauge("chunks.budget." + name).get();
+            return std::to_wstring(spent) + L"/" + std::to_wstring(budget);
+        };
+        return L"chunks-budget (mcs): generate " + stage("generate") +
+               L" lights " + stage("lights") + L" mesh " + stage("mesh");
+    }));
+    panel->add(create_label([&]() {
+        auto stats = level.chunksStorage->getPoolStats();
+        return L"chunks-pool: hits " + std::to_wstring(stats.hits) +
+               L" misses " + std::to_wstring(stats.misses) +
+               L" free " + std::to_wstring(stats.free);
+    }));
+    panel->add(create_label([&]() {
+        auto stats = level.chunksStorage->getCache().getStats();
+        return L"chunks-cache: " + std::to_wstring(stats.entries) + L" (" +
+               std::to_wstring(stats.bytes >> 10) + L" KiB) hits " +
+               std::to_wstring(stats.hits) + L" misses " +
+               std::to_wstring(stats.misses);
+    }));
+    panel->add(create_label([&]() {
+        auto stats = level.getWorld()->wfile->getRegions().getRegFilesStats();
+        return L"region-files: opens " + std::to_wstring(stats.opens) +
+               L" evicted " + std::to_wstring(stats.evictions) +
+               L" contended " + std::to_wstring(stats.contentions);
     }));
     panel->add(create_label([&]() {
         return L"entities: "+std::to_wstring(level.entities->size())+L" next: "+
                std::to_wstring(level.entities->peekNextID());
     }));
+    panel->add(create_label([&]() {
+        const auto& stats = level.entities->getPhysicsStats();
+        return L"physics: simulated " + std::to_wstring(stats.simulated) +
+               L" sleeping " + std::to_wstring(stats.sleeping) +
+               L" skipped " + std::to_wstring(stats.skipped);
+    }));
     panel->add(create_label([&]() -> std::wstring {
         const auto& vox = player.selection.vox;
         std::wstringstream stream;
@@ -147,6 +206,62 @@ std::shared_ptr<UINode> create_debug_panel(
     panel->add(create_label([&](){
         return L"seed: "+std::to_wstring(level.getWorld()->getSeed());
     }));
+    {
+        auto label = create_label([]() {
+            const auto& profiler = debug::Profiler::getInstance();
+            std::wstringstream ss;
+            ss << L"passes (cpu / gpu ms):";
+            for (const auto& pass : profiler.getPasses()) {
+                ss << L"\n" << std::wstring(pass.depth * 2, L' ')
+                   << util::str2wstr_utf8(pass.name) << L": "
+                   << util::to_wstring(pass.cpuTime, 2) << L" / "
+                   << util::to_wstring(pass.gpuTime, 2);
+            }
+            return ss.str();
+        });
+        label->setMultiline(true);
+        panel->add(label);
+
+        // sources walk chunks and assets, so polled once per second
+        static std::wstring memoryString = L"memory (MiB):";
+        panel->listenInterval(1.0f, []() {
+            std::wstringstream ss;
+            ss << L"memory (MiB):";
+            for (const auto& [tag, bytes] :
+                 debug::MemoryUsage::getInstance().collect()) {
+                ss << L"\n  " << util::str2wstr_utf8(tag) << L": "
+                   << util::to_wstring(bytes / 1048576.0, 1);
+            }
+            memoryString = ss.str();
+        });
+        auto memoryLabel = create_label([]() { return memoryString; });
+        memoryLabel->setMultiline(true);
+        panel->add(memoryLabel);
+
+        auto plotter = std::make_shared<Plotter>(350, 100, 2000, 16);
+        plotter->setInteractive(false);
+        plotter->setSupplier([]() {
+            const auto& profiler = debug::Profiler::getInstance();
+            auto frame = profiler.getPass("frame");
+            return frame ? frame->gpuTime / 1000.0f : 0.0f;
+        });
+        panel->add(plotter);
+
+        panel->add(std::make_shared<Button>(
+            L"Export Chrome Trace", glm::vec4(4.0f), [engine](GUI*) {
+                auto file = engine->getPaths()->getUserFilesFolder() /
+                            "profile-trace.json";
+                debug::Profiler::getInstance().writeChromeTrace(file);
+            }
+        ));
+        panel->add(std::make_shared<Button>(
+            L"Export Metrics", glm::vec4(4.0f), [engine](GUI*) {
+                auto file =
+                    engine->getPaths()->getUserFilesFolder() / "metrics.json";
+                debug::Metrics::getInstance().write(file);
+            }
+        ));
+    }
 
     for (int ax = 0; ax < 3; ax++) {
         auto sub = std::make_shared<Container>(glm::vec2(250, 27));
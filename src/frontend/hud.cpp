@@ -7,6 +7,7 @@
 #include "assets/Assets.hpp"
 #include "content/Content.hpp"
 #include "core_defs.hpp"
+#include "debug/Profiler.hpp"
 #include "delegates.hpp"
 #include "engine.hpp"
 #include "graphics/core/Atlas.hpp"
@@ -14,6 +15,7 @@
 #include "graphics/core/Batch3D.hpp"
 #include "graphics/core/DrawContext.hpp"
 #include "graphics/core/Font.hpp"
+#include "graphics/core/GLTexture.hpp"
 #include "graphics/core/Mesh.hpp"
 #include "graphics/core/Shader.hpp"
 #include "graphics/core/Texture.hpp"
@@ -49,7 +51,9 @@
 #include "world/World.hpp"
 #include "debug/Logger.hpp"
 
+#include <algorithm>
 #include <assert.h>
+#include <cstring>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -127,7 +131,15 @@ std::shared_ptr<InventoryView> Hud::createContentAccess() {
     });
 
     InventoryBuilder builder;
-    builder.addGrid(8, itemsCount-1, glm::vec2(), glm::vec4(8, 8, 12, 8), true, slotLayout);
+    builder.addGrid(
+        8,
+        itemsCount - 1,
+        glm::vec2(),
+        glm::vec4(8, 8, 12, 8),
+        true,
+        slotLayout,
+        true
+    );
     auto view = builder.build();
     view->bind(accessInventory, content);
     view->setMargin(glm::vec4());
@@ -286,36 +298,56 @@ void Hud::updateWorldGenDebugVisualization() {
     int areaWidth = debugInfo.areaWidth;
     int areaHeight = debugInfo.areaHeight;
 
+    // bounds of changed pixels, only they are uploaded
+    int x1 = width, y1 = height, x2 = 0, y2 = 0;
     for (int z = 0; z < height; z++) {
         for (int x = 0; x < width; x++) {
-            int cx = x + ox;
-            int cz = z + oz;
             int flippedZ = height - z - 1;
 
             int ax = x - (width - areaWidth) / 2;
             int az = z - (height - areaHeight) / 2;
 
-            data[(flippedZ * width + x) * 4 + 1] = 
-                level.chunks->getChunk(ax + ox, az + oz) ? 255 : 0;
-            data[(flippedZ * width + x) * 4 + 0] = 
-                level.chunksStorage->get(ax + ox, az + oz) ? 255 : 0;
-
+            ubyte pixel[4];
+            pixel[0] = level.chunksStorage->get(ax + ox, az + oz) ? 255 : 0;
+            pixel[1] = level.chunks->getChunk(ax + ox, az + oz) ? 255 : 0;
             if (ax < 0 || az < 0 || 
                 ax >= areaWidth || az >= areaHeight) {
-                data[(flippedZ * width + x) * 4 + 2] = 0;
-                data[(flippedZ * width + x) * 4 + 3] = 0;
-                data[(flippedZ * width + x) * 4 + 3] = 100;
+                pixel[2] = 0;
+                pixel[3] = 100;
+            } else {
+                // Chunk is already generated
+                pixel[2] = debugInfo.areaLevels[az * areaWidth + ax] * 25;
+                pixel[3] = 150;
+            }
+            ubyte* dst = data + (flippedZ * width + x) * 4;
+            if (std::memcmp(dst, pixel, sizeof(pixel)) == 0) {
                 continue;
             }
-            auto value = debugInfo.areaLevels[az * areaWidth + ax] * 25;
-
-            // Chunk is already generated
-            data[(flippedZ * width + x) * 4 + 2] = value;
-            data[(flippedZ * width + x) * 4 + 3] = 150;
+            std::memcpy(dst, pixel, sizeof(pixel));
+            x1 = std::min(x1, x);
+            y1 = std::min(y1, flippedZ);
+            x2 = std::max(x2, x + 1);
+            y2 = std::max(y2, flippedZ + 1);
         }
     }
-    auto texture = assets->get<Texture>(DEBUG_WORLDGEN_IMAGE);
-    texture->reload(*debugImgWorldGen);
+    if (x1 >= x2) {
+        return;
+    }
+    auto texture = dynamic_cast<GLTexture*>(
+        assets->get<Texture>(DEBUG_WORLDGEN_IMAGE)
+    );
+    if (texture == nullptr) {
+        return;
+    }
+    ImageData area(ImageFormat::rgba8888, x2 - x1, y2 - y1);
+    for (int row = y1; row < y2; row++) {
+        std::copy(
+            data + (row * width + x1) * 4,
+            data + (row * width + x2) * 4,
+            area.getData() + (row - y1) * area.getWidth() * 4
+        );
+    }
+    texture->reloadRegion(area, x1, y1);
 }
 
 void Hud::update(bool visible) {
@@ -324,6 +356,11 @@ void Hud::update(bool visible) {
 
     debugPanel->setVisible(player->debug && visible);
 
+    auto& profiler = debug::Profiler::getInstance();
+    if (profiler.isEnabled() != debugPanel->isVisible()) {
+        profiler.setEnabled(debugPanel->isVisible());
+    }
+
     if (!visible && inventoryOpen) {
         closeInventory();
     }
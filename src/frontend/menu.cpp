@@ -123,7 +123,12 @@ UiDocument* menus::show(Engine* engine, const std::string& name, std::vector<dv:
     return document;
 }
 
-void menus::show_process_panel(Engine* engine, const std::shared_ptr<Task>& task, const std::wstring& text) {
+void menus::show_process_panel(
+    Engine* engine,
+    const std::shared_ptr<Task>& task,
+    const std::wstring& text,
+    const wstringsupplier& statusSupplier
+) {
     uint initialWork = task->getWorkTotal();
 
     auto menu = engine->getGUI()->getMenu();
@@ -135,6 +140,7 @@ void menus::show_process_panel(Engine* engine, const std::shared_ptr<Task>& task
         task->update();
 
         uint tasksDone = task->getWorkDone();
-        scripting::on_ui_progress(doc, tasksDone, initialWork);
+        std::wstring status = statusSupplier ? statusSupplier() : L"";
+        scripting::on_ui_progress(doc, tasksDone, initialWork, status);
     });
 }
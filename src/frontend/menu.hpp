@@ -1,6 +1,7 @@
 #pragma once
 
 #include "data/dv.hpp"
+#include "delegates.hpp"
 #include "graphics/ui/elements/Menu.hpp"
 
 #include <string>
@@ -24,7 +25,14 @@ namespace menus {
         std::vector<dv::value> args
     );
 
-    void show_process_panel(Engine* engine, const std::shared_ptr<Task>& task, const std::wstring& text=L"");
+    /// @brief Show task progress panel
+    /// @param statusSupplier optional task status text supplier
+    void show_process_panel(
+        Engine* engine,
+        const std::shared_ptr<Task>& task,
+        const std::wstring& text = L"",
+        const wstringsupplier& statusSupplier = nullptr
+    );
 
     bool call(Engine* engine, runnable func);
 }
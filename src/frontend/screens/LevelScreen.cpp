@@ -2,11 +2,14 @@
 
 #include "core_defs.hpp"
 #include "frontend/hud.hpp"
+#include "frontend/HotReloader.hpp"
 #include "frontend/LevelFrontend.hpp"
 #include "audio/audio.hpp"
 #include "coders/imageio.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
 #include "engine.hpp"
+#include "files/engine_paths.hpp"
 #include "files/files.hpp"
 #include "content/Content.hpp"
 #include "graphics/core/DrawContext.hpp"
@@ -17,6 +20,7 @@
 #include "graphics/render/Decorator.hpp"
 #include "graphics/ui/elements/Menu.hpp"
 #include "graphics/ui/GUI.hpp"
+#include "lighting/Lighting.hpp"
 #include "frontend/ContentGfxCache.hpp"
 #include "logic/LevelController.hpp"
 #include "logic/scripting/scripting_hud.hpp"
@@ -43,7 +47,11 @@ LevelScreen::LevelScreen(Engine* engine, std::unique_ptr<Level> levelPtr)
 
     controller = std::make_unique<LevelController>(engine, std::move(levelPtr));
     frontend = std::make_unique<LevelFrontend>(
-        controller->getPlayer(), controller.get(), assets, settings
+        controller->getPlayer(),
+        controller.get(),
+        assets,
+        settings,
+        engine->getPaths()->getCacheFolder()
     );
     worldRenderer = std::make_unique<WorldRenderer>(
         engine, *frontend, controller->getPlayer()
@@ -63,6 +71,12 @@ LevelScreen::LevelScreen(Engine* engine, std::unique_ptr<Level> levelPtr)
         worldRenderer->clear();
         frontend->getContentGfxCache().refresh();
     }));
+    keepAlive(settings.graphics.textureArrays.observe([=](bool) {
+        frontend->getContentGfxCache().refresh();
+    }));
+    keepAlive(settings.graphics.greedyMeshing.observe([=](bool) {
+        worldRenderer->clear();
+    }));
     keepAlive(settings.camera.fov.observe([=](double value) {
         controller->getPlayer()->fpCamera->setFov(glm::radians(value));
     }));
@@ -74,6 +88,16 @@ LevelScreen::LevelScreen(Engine* engine, std::unique_ptr<Level> levelPtr)
     animator = std::make_unique<TextureAnimator>();
     animator->addAnimations(assets.getAnimations());
 
+    if (settings.debug.hotReload.get()) {
+        hotReloader = std::make_unique<HotReloader>(
+            *level,
+            *level->content,
+            *frontend,
+            assets,
+            *engine->getResPaths()
+        );
+    }
+
     initializeContent();
 }
 
@@ -177,8 +201,13 @@ void LevelScreen::update(float delta) {
         controller->getLevel()->getWorld()->updateTimers(delta);
         animator->update(delta);
     }
+    if (hotReloader) {
+        hotReloader->update(delta);
+    }
     controller->update(glm::min(delta, 0.2f), !inputLocked, hud->isPause());
     hud->update(hudVisible);
+    // blocks may be set by hud scripts
+    controller->getLevel()->lighting->flushUpdates();
     decorator->update(delta, *camera);
 }
 
@@ -193,6 +222,7 @@ void LevelScreen::draw(float delta) {
     );
 
     if (hudVisible) {
+        debug::ProfileScope scope("hud");
         hud->draw(ctx);
     }
 }
@@ -14,6 +14,7 @@ class PostProcessing;
 class ContentPackRuntime;
 class Decorator;
 class Level;
+class HotReloader;
 
 class LevelScreen : public Screen {
     std::unique_ptr<LevelFrontend> frontend;
@@ -23,6 +24,8 @@ class LevelScreen : public Screen {
     std::unique_ptr<PostProcessing> postProcessing;
     std::unique_ptr<Decorator> decorator;
     std::unique_ptr<Hud> hud;
+    /// @brief nullptr if debug.hot-reload is disabled
+    std::unique_ptr<HotReloader> hotReloader;
 
     void saveWorldPreview();
 
@@ -1,9 +1,11 @@
 #include "Atlas.hpp"
 
-#include "Texture.hpp"
+#include "GLTexture.hpp"
 #include "ImageData.hpp"
 #include "maths/LMPacker.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 Atlas::Atlas(
@@ -19,6 +21,15 @@ Atlas::Atlas(
     }
 }
 
+Atlas::Atlas(
+    std::unique_ptr<Texture> texture,
+    std::unordered_map<std::string, UVRegion> regions
+) : texture(std::move(texture)),
+    image(nullptr),
+    regions(std::move(regions))
+{
+}
+
 Atlas::~Atlas() = default;
 
 void Atlas::prepare() {
@@ -49,8 +60,63 @@ ImageData* Atlas::getImage() const {
     return image.get();
 }
 
+bool Atlas::replace(
+    const std::string& name, const ImageData& src, uint extrusion
+) {
+    const auto& found = regions.find(name);
+    auto glTexture = dynamic_cast<GLTexture*>(texture.get());
+    if (found == regions.end() || image == nullptr || glTexture == nullptr ||
+        image->getFormat() != ImageFormat::rgba8888 ||
+        src.getFormat() != ImageFormat::rgba8888) {
+        return false;
+    }
+    const auto& region = found->second;
+    uint width = image->getWidth();
+    uint height = image->getHeight();
+    uint x = std::round(region.u1 * width);
+    uint y = std::round(region.v1 * height);
+    if (src.getWidth() != std::round(region.getWidth() * width) ||
+        src.getHeight() != std::round(region.getHeight() * height)) {
+        return false;
+    }
+    blit_atlas_entry(*image, src, x, y, extrusion);
+
+    // extruded borders are uploaded too
+    uint x1 = x - std::min(x, extrusion);
+    uint y1 = y - std::min(y, extrusion);
+    uint x2 = std::min(width, x + src.getWidth() + extrusion);
+    uint y2 = std::min(height, y + src.getHeight() + extrusion);
+    ImageData area(ImageFormat::rgba8888, x2 - x1, y2 - y1);
+    const ubyte* pixels = image->getData();
+    for (uint row = y1; row < y2; row++) {
+        std::copy(
+            pixels + (row * width + x1) * 4,
+            pixels + (row * width + x2) * 4,
+            area.getData() + (row - y1) * area.getWidth() * 4
+        );
+    }
+    glTexture->reloadRegion(area, x1, y1);
+    glTexture->generateMipmaps();
+    return true;
+}
+
+void blit_atlas_entry(
+    ImageData& canvas, const ImageData& image, uint x, uint y, uint extrusion
+) {
+    canvas.blit(&image, x, y);
+    uint w = image.getWidth();
+    uint h = image.getHeight();
+    for (uint j = 0; j < extrusion; j++) {
+        canvas.extrude(x - j, y - j, w + j*2, h + j*2);
+    }
+}
+
 void AtlasBuilder::add(const std::string& name, std::unique_ptr<ImageData> image) {
-    entries.push_back(atlasentry{name, std::shared_ptr<ImageData>(image.release())});
+    add(name, std::shared_ptr<ImageData>(image.release()));
+}
+
+void AtlasBuilder::add(const std::string& name, std::shared_ptr<ImageData> image) {
+    entries.push_back(atlasentry{name, std::move(image)});
     names.insert(name);
 }
 
@@ -97,10 +163,7 @@ std::unique_ptr<Atlas> AtlasBuilder::build(uint extrusion, bool prepare, uint ma
         uint y = rect.y;
         uint w = rect.width;
         uint h = rect.height;
-        canvas->blit(entry.image.get(), rect.x, rect.y);
-        for (uint j = 0; j < extrusion; j++) {
-            canvas->extrude(x - j, y - j, w + j*2, h + j*2);
-        }
+        blit_atlas_entry(*canvas, *entry.image, x, y, extrusion);
         float unitX = 1.0f / width;
         float unitY = 1.0f / height;
         regions[entry.name] = UVRegion(
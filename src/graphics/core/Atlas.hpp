@@ -18,6 +18,10 @@ class Atlas {
     std::unique_ptr<ImageData> image;
     std::unordered_map<std::string, UVRegion> regions;
 public:
+    /// @brief Textures extrusion pixels of the atlases built by the assets
+    /// loader (greater is less mip-mapping artifacts)
+    static constexpr uint EXTRUSION = 2;
+
     /// @param image atlas raster
     /// @param regions atlas regions
     /// @param prepare generate texture (.prepare())
@@ -26,6 +30,12 @@ public:
         std::unordered_map<std::string, UVRegion> regions, 
         bool prepare
     );
+    /// @brief Create atlas of a ready texture without CPU-side raster
+    /// (getImage() returns nullptr)
+    Atlas(
+        std::unique_ptr<Texture> texture,
+        std::unordered_map<std::string, UVRegion> regions
+    );
     ~Atlas();
 
     void prepare();
@@ -36,6 +46,19 @@ public:
 
     Texture* getTexture() const;
     ImageData* getImage() const;
+
+    /// @brief Replace the region image in the raster and the texture
+    /// @param image RGBA8888 image of the region size
+    /// @param extrusion extruded pixels around the region
+    /// @return false if there is no such region, the image size differs
+    /// or the atlas has no raster (compressed atlases)
+    bool replace(
+        const std::string& name, const ImageData& image, uint extrusion
+    );
+
+    const std::unordered_map<std::string, UVRegion>& getRegions() const {
+        return regions;
+    }
 };
 
 struct atlasentry {
@@ -43,12 +66,20 @@ struct atlasentry {
     std::shared_ptr<ImageData> image;
 };
 
+/// @brief Blit image to the atlas canvas extruding its borders
+/// @param extrusion extruded pixels, the space must be reserved
+/// around the image
+void blit_atlas_entry(
+    ImageData& canvas, const ImageData& image, uint x, uint y, uint extrusion
+);
+
 class AtlasBuilder {
     std::vector<atlasentry> entries;
     std::set<std::string> names;
 public:
     AtlasBuilder() = default;
     void add(const std::string& name, std::unique_ptr<ImageData> image);
+    void add(const std::string& name, std::shared_ptr<ImageData> image);
     bool has(const std::string& name) const;
     const std::set<std::string>& getNames() { return names; };
 
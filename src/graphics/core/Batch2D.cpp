@@ -3,10 +3,14 @@
 #include "Texture.hpp"
 #include "gl_util.hpp"
 #include "maths/UVRegion.hpp"
+#include "window/Window.hpp"
 
 #include <GL/glew.h>
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <stdexcept>
 
 inline constexpr uint B2D_VERTEX_SIZE = 8;
 
@@ -16,6 +20,7 @@ Batch2D::Batch2D(size_t capacity) : capacity(capacity), color(1.0f){
     };
 
     buffer = std::make_unique<float[]>(capacity * B2D_VERTEX_SIZE);
+    sorted = std::make_unique<float[]>(capacity * B2D_VERTEX_SIZE);
     mesh = std::make_unique<Mesh>(buffer.get(), 0, attrs);
     index = 0;
 
@@ -34,16 +39,43 @@ void Batch2D::setPrimitive(DrawPrimitive primitive) {
     if (primitive == this->primitive) {
         return;
     }
-    flush();
     this->primitive = primitive;
+    stateChanged = true;
 }
 
 void Batch2D::begin(){
     currentTexture = nullptr;
-    blank->bind();
     region = blank->getUVRegion();
     color = glm::vec4(1.0f);
     primitive = DrawPrimitive::triangle;
+    scissor = Scissor {Window::isScissorEnabled(), Window::getScissorArea()};
+    stateChanged = true;
+}
+
+bool Batch2D::isFull(size_t vertices) const {
+    return index + vertices * B2D_VERTEX_SIZE >= capacity * B2D_VERTEX_SIZE;
+}
+
+bool Batch2D::DrawCommand::overlaps(const DrawCommand& o) const {
+    // lines and points may be wider than their bounds
+    if (primitive != DrawPrimitive::triangle ||
+        o.primitive != DrawPrimitive::triangle) {
+        return true;
+    }
+    return bounds.x < o.bounds.z && o.bounds.x < bounds.z &&
+           bounds.y < o.bounds.w && o.bounds.y < bounds.w;
+}
+
+void Batch2D::beginCommand() {
+    stateChanged = false;
+    commands.push_back(DrawCommand {
+        currentTexture,
+        primitive,
+        scissor,
+        index,
+        0,
+        glm::vec4(INFINITY, INFINITY, -INFINITY, -INFINITY),
+        0});
 }
 
 void Batch2D::vertex(
@@ -51,6 +83,14 @@ void Batch2D::vertex(
     float u, float v,
     float r, float g, float b, float a
 ) {
+    if (stateChanged) {
+        beginCommand();
+    }
+    auto& bounds = commands.back().bounds;
+    bounds = glm::vec4(
+        glm::min(glm::vec2(bounds), glm::vec2(x, y)),
+        glm::max(glm::vec2(bounds.z, bounds.w), glm::vec2(x, y))
+    );
     buffer[index++] = x;
     buffer[index++] = y;
     buffer[index++] = u * region.getWidth() + region.u1;
@@ -65,6 +105,14 @@ void Batch2D::vertex(
     glm::vec2 uvpoint,
     float r, float g, float b, float a
 ) {
+    if (stateChanged) {
+        beginCommand();
+    }
+    auto& bounds = commands.back().bounds;
+    bounds = glm::vec4(
+        glm::min(glm::vec2(bounds), glm::vec2(point.x, point.y)),
+        glm::max(glm::vec2(bounds.z, bounds.w), glm::vec2(point.x, point.y))
+    );
     buffer[index++] = point.x;
     buffer[index++] = point.y;
     buffer[index++] = uvpoint.x * region.getWidth() + region.u1;
@@ -79,13 +127,11 @@ void Batch2D::texture(const Texture* new_texture){
     if (currentTexture == new_texture) {
         return;
     }
-    flush();
     currentTexture = new_texture;
+    stateChanged = true;
     if (new_texture == nullptr) {
-        blank->bind();
         region = blank->getUVRegion();
     } else {
-        new_texture->bind();
         region = currentTexture->getUVRegion();
     }
 }
@@ -99,14 +145,14 @@ void Batch2D::setRegion(UVRegion region) {
 }
 
 void Batch2D::point(float x, float y, float r, float g, float b, float a){
-    if (index + 6*B2D_VERTEX_SIZE >= capacity)
+    if (isFull(6))
         flush();
     setPrimitive(DrawPrimitive::point);
     vertex(x, y, 0, 0, r,g,b,a);
 }
 
 void Batch2D::line(float x1, float y1, float x2, float y2, float r, float g, float b, float a){
-    if (index + 6*B2D_VERTEX_SIZE >= capacity) {
+    if (isFull(6)) {
         flush();
     }
     setPrimitive(DrawPrimitive::line);
@@ -119,7 +165,7 @@ void Batch2D::rect(float x, float y, float w, float h){
     const float g = color.g;
     const float b = color.b;
     const float a = color.a;
-    if (index + 6*B2D_VERTEX_SIZE >= capacity) {
+    if (isFull(6)) {
         flush();
     }
     setPrimitive(DrawPrimitive::triangle);
@@ -142,7 +188,7 @@ void Batch2D::rect(
     bool flippedY,
     glm::vec4 tint
 ) {
-    if (index + 6*B2D_VERTEX_SIZE >= capacity) {
+    if (isFull(6)) {
         flush();
     }
     setPrimitive(DrawPrimitive::triangle);
@@ -248,7 +294,7 @@ void Batch2D::rect(
     float u, float v, float tx, float ty,
     float r, float g, float b, float a
 ){
-    if (index + 6*B2D_VERTEX_SIZE >= capacity) {
+    if (isFull(6)) {
         flush();
     }
     setPrimitive(DrawPrimitive::triangle);
@@ -266,7 +312,7 @@ void Batch2D::parallelogram(
     float u, float v, float tx, float ty,
     float r, float g, float b, float a
 ){
-    if (index + 6*B2D_VERTEX_SIZE >= capacity) {
+    if (isFull(6)) {
         flush();
     }
     setPrimitive(DrawPrimitive::triangle);
@@ -287,7 +333,7 @@ void Batch2D::rect(
     float r3, float g3, float b3,
     float r4, float g4, float b4, int sh
 ){
-    if (index + 30*B2D_VERTEX_SIZE >= capacity) {
+    if (isFull(30)) {
         flush();
     }
     setPrimitive(DrawPrimitive::triangle);
@@ -370,14 +416,182 @@ void Batch2D::sprite(
     parallelogram(x, y, w, h, skew, u, v, scale, scale, tint.r, tint.g, tint.b, tint.a);
 }
 
+void Batch2D::setScissor(bool enabled, const glm::vec4& area) {
+    Scissor newScissor {enabled, area};
+    if (newScissor == scissor) {
+        return;
+    }
+    scissor = newScissor;
+    stateChanged = true;
+}
+
+void Batch2D::updateSizes() {
+    if (commands.empty()) {
+        return;
+    }
+    commands.back().size = index - commands.back().offset;
+    for (size_t i = 0; i + 1 < commands.size(); i++) {
+        commands[i].size = commands[i + 1].offset - commands[i].offset;
+    }
+}
+
+void Batch2D::capture(Capture& capture) {
+    auto& recording = *capture.recording;
+    for (size_t i = capture.command; i < commands.size(); i++) {
+        auto command = commands[i];
+        command.offset = recording.vertices.size() +
+                         (command.offset - capture.index);
+        recording.commands.push_back(command);
+    }
+    recording.vertices.insert(
+        recording.vertices.end(),
+        buffer.get() + capture.index,
+        buffer.get() + index
+    );
+    capture.index = index;
+    capture.command = commands.size();
+}
+
+void Batch2D::beginRecording() {
+    auto recording = std::make_unique<Recording>();
+    recording->scissor = scissor;
+    captures.push_back(Capture {std::move(recording), index, commands.size()});
+    // recorded vertices must not continue a command started before
+    stateChanged = true;
+}
+
+std::unique_ptr<Batch2D::Recording> Batch2D::endRecording() {
+    if (captures.empty()) {
+        throw std::runtime_error("Batch2D recording is not started");
+    }
+    updateSizes();
+    auto capture = std::move(captures.back());
+    captures.pop_back();
+    if (capture.broken) {
+        return nullptr;
+    }
+    this->capture(capture);
+    // next vertices must not continue the last recorded command
+    stateChanged = true;
+
+    auto& recording = *capture.recording;
+    recording.texture = currentTexture;
+    recording.primitive = primitive;
+    recording.color = color;
+    recording.region = region;
+    return std::move(capture.recording);
+}
+
+bool Batch2D::replay(const Recording& recording) {
+    if (!(recording.scissor == scissor)) {
+        return false;
+    }
+    for (const auto& command : recording.commands) {
+        if (isFull(command.size / B2D_VERTEX_SIZE)) {
+            flush();
+        }
+        std::memcpy(
+            buffer.get() + index,
+            recording.vertices.data() + command.offset,
+            command.size * sizeof(float)
+        );
+        auto& added = commands.emplace_back(command);
+        added.offset = index;
+        index += command.size;
+    }
+    currentTexture = recording.texture;
+    primitive = recording.primitive;
+    color = recording.color;
+    region = recording.region;
+    stateChanged = true;
+    return true;
+}
+
 void Batch2D::flush() {
     if (index == 0)
         return;
-    mesh->reload(buffer.get(), index / B2D_VERTEX_SIZE);
-    mesh->draw(gl::to_glenum(primitive));
+    updateSizes();
+    for (auto& capture : captures) {
+        this->capture(capture);
+        capture.index = 0;
+        capture.command = 0;
+    }
+
+    // merge commands to groups moving them back over groups not overlapped
+    groups.clear();
+    for (auto& command : commands) {
+        size_t target = groups.size();
+        size_t depth = std::min(groups.size(), MAX_MERGE_DEPTH);
+        for (size_t i = 0; i < depth; i++) {
+            auto& group = groups[groups.size() - 1 - i];
+            if (group.sameState(command)) {
+                target = groups.size() - 1 - i;
+                break;
+            }
+            if (group.overlaps(command)) {
+                break;
+            }
+        }
+        if (target == groups.size()) {
+            groups.push_back(command);
+            groups.back().size = 0;
+        } else {
+            auto& bounds = groups[target].bounds;
+            bounds = glm::vec4(
+                glm::min(glm::vec2(bounds), glm::vec2(command.bounds)),
+                glm::max(
+                    glm::vec2(bounds.z, bounds.w),
+                    glm::vec2(command.bounds.z, command.bounds.w)
+                )
+            );
+        }
+        command.group = target;
+        groups[target].size += command.size;
+    }
+
+    size_t offset = 0;
+    for (auto& group : groups) {
+        group.offset = offset;
+        offset += group.size;
+    }
+    for (const auto& command : commands) {
+        auto& group = groups[command.group];
+        std::memcpy(
+            sorted.get() + group.offset,
+            buffer.get() + command.offset,
+            command.size * sizeof(float)
+        );
+        group.offset += command.size;
+    }
+    mesh->reload(sorted.get(), index / B2D_VERTEX_SIZE);
+
+    for (const auto& group : groups) {
+        Window::applyScissor(group.scissor.enabled, group.scissor.area);
+        if (group.texture) {
+            group.texture->bind();
+        } else {
+            blank->bind();
+        }
+        size_t first = group.offset - group.size;
+        mesh->draw(
+            gl::to_glenum(group.primitive),
+            first / B2D_VERTEX_SIZE,
+            group.size / B2D_VERTEX_SIZE
+        );
+    }
+    Window::applyScissor(
+        Window::isScissorEnabled(), Window::getScissorArea()
+    );
+    commands.clear();
     index = 0;
+    stateChanged = true;
 }
 
 void Batch2D::lineWidth(float width) {
+    // recorded lines use the width set at flush
+    flush();
     glLineWidth(width);
+    for (auto& capture : captures) {
+        capture.broken = true;
+    }
 }
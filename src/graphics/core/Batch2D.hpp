@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <stdlib.h>
+#include <vector>
 #include <glm/glm.hpp>
 
 #include "commons.hpp"
@@ -10,8 +11,71 @@
 class Mesh;
 class Texture;
 
+/// @brief 2D primitives batch.
+/// Texture, primitive and scissor changes do not flush the batch: vertices
+/// are recorded as commands with these states. On flush, commands are
+/// merged into groups with the same state, if the command does not overlap
+/// commands it is moved over, so drawing order is visually preserved.
+/// All groups are uploaded at once and drawn with one call per group.
 class Batch2D : public Flushable {
+    struct Scissor {
+        bool enabled = false;
+        glm::vec4 area {};
+
+        bool operator==(const Scissor& o) const {
+            return enabled == o.enabled && (!enabled || area == o.area);
+        }
+    };
+    struct DrawCommand {
+        const Texture* texture;
+        DrawPrimitive primitive;
+        Scissor scissor;
+        /// @brief Offset of the first vertex value in the buffer
+        size_t offset;
+        /// @brief Number of vertex values
+        size_t size;
+        /// @brief Geometry bounds (min x, min y, max x, max y)
+        glm::vec4 bounds;
+        /// @brief Index of the group the command is merged to
+        size_t group;
+
+        bool sameState(const DrawCommand& o) const {
+            return texture == o.texture && primitive == o.primitive &&
+                   scissor == o.scissor;
+        }
+
+        bool overlaps(const DrawCommand& o) const;
+    };
+public:
+    /// @brief Draw commands recorded with beginRecording/endRecording
+    class Recording {
+        friend class Batch2D;
+        /// @brief Scissor state the recording was made with
+        Scissor scissor;
+        std::vector<float> vertices;
+        std::vector<DrawCommand> commands;
+        // batch state after the recorded draws
+        const Texture* texture = nullptr;
+        DrawPrimitive primitive = DrawPrimitive::triangle;
+        glm::vec4 color {1.0f};
+        UVRegion region;
+    };
+private:
+    struct Capture {
+        std::unique_ptr<Recording> recording;
+        /// @brief Buffer index where not yet captured vertices start
+        size_t index;
+        /// @brief Index of the first not yet captured command
+        size_t command;
+        /// @brief Recording is incomplete (GL state changed while recording)
+        bool broken = false;
+    };
+    /// @brief Max number of groups checked back for a merge
+    static constexpr size_t MAX_MERGE_DEPTH = 64;
+
     std::unique_ptr<float[]> buffer;
+    /// @brief Buffer for vertices sorted by groups on flush
+    std::unique_ptr<float[]> sorted;
     size_t capacity;
     std::unique_ptr<Mesh> mesh;
     std::unique_ptr<Texture> blank;
@@ -19,10 +83,27 @@ class Batch2D : public Flushable {
     glm::vec4 color;
     const Texture* currentTexture;
     DrawPrimitive primitive = DrawPrimitive::triangle;
+    Scissor scissor;
     UVRegion region {0.0f, 0.0f, 1.0f, 1.0f};
+    std::vector<DrawCommand> commands;
+    std::vector<DrawCommand> groups;
+    std::vector<Capture> captures;
+    /// @brief Next vertex starts a new command
+    bool stateChanged = true;
 
     void setPrimitive(DrawPrimitive primitive);
 
+    void beginCommand();
+
+    /// @return true if the buffer has no space for the vertices
+    bool isFull(size_t vertices) const;
+
+    /// @brief Calculate sizes of pending commands
+    void updateSizes();
+
+    /// @brief Move pending vertices and commands to the capture recording
+    void capture(Capture& capture);
+
     void vertex(
         float x, float y,
         float u, float v,
@@ -95,6 +176,25 @@ public:
         float r4, float g4, float b4, int sh
     );
 
+    /// @brief Set scissor state used by next primitives.
+    /// Called by DrawContext on scissors stack change
+    void setScissor(bool enabled, const glm::vec4& area);
+
+    /// @brief Start recording next draws. Recordings may be nested.
+    /// Draws are performed as usual while recording
+    void beginRecording();
+
+    /// @brief Finish the last started recording
+    /// @return recording or nullptr if it can not be replayed
+    /// (line width changed while recording)
+    std::unique_ptr<Recording> endRecording();
+
+    /// @brief Append recorded draws to the batch and restore batch state
+    /// left by them
+    /// @return false if current scissor state differs from the recorded one,
+    /// nothing is drawn in this case
+    bool replay(const Recording& recording);
+
     void flush() override;
 
     void lineWidth(float width);
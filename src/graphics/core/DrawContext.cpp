@@ -38,8 +38,15 @@ DrawContext::~DrawContext() {
         flushable->flush();
     }
 
-    while (scissorsCount--) {
-        Window::popScissor();
+    if (scissorsCount > 0) {
+        while (scissorsCount--) {
+            Window::popScissor();
+        }
+        if (g2d) {
+            g2d->setScissor(
+                Window::isScissorEnabled(), Window::getScissorArea()
+            );
+        }
     }
 
     if (parent == nullptr)
@@ -152,6 +159,9 @@ void DrawContext::setBlendMode(BlendMode mode) {
 void DrawContext::setScissors(const glm::vec4& area) {
     Window::pushScissor(area);
     scissorsCount++;
+    if (g2d) {
+        g2d->setScissor(Window::isScissorEnabled(), Window::getScissorArea());
+    }
 }
 
 void DrawContext::setLineWidth(float width) {
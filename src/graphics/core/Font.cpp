@@ -5,14 +5,21 @@
 #include "Texture.hpp"
 #include "Batch2D.hpp"
 #include "Batch3D.hpp"
+#include "GlyphAtlas.hpp"
 #include "window/Camera.hpp"
 
 inline constexpr uint GLYPH_SIZE = 16;
-inline constexpr uint MAX_CODEPAGES = 10000; // idk ho many codepages unicode has
 inline constexpr glm::vec4 SHADOW_TINT(0.0f, 0.0f, 0.0f, 1.0f);
 
-Font::Font(std::vector<std::unique_ptr<Texture>> pages, int lineHeight, int yoffset) 
-    : lineHeight(lineHeight), yoffset(yoffset), pages(std::move(pages)) {
+Font::Font(
+    std::vector<std::unique_ptr<ImageData>> pages, int lineHeight, int yoffset
+)
+    : lineHeight(lineHeight),
+      yoffset(yoffset),
+      pages(std::move(pages)),
+      atlas(std::make_unique<GlyphAtlas>(
+          this->pages, this->pages.at(0)->getHeight() / GLYPH_SIZE
+      )) {
 }
 
 Font::~Font() = default;
@@ -50,31 +57,100 @@ static inline void draw_glyph(
     Batch2D& batch, 
     const glm::vec3& pos, 
     const glm::vec2& offset, 
-    uint c, 
+    const UVRegion& region,
     const glm::vec3& right,
     const glm::vec3& up,
     float glyphInterval,
     const FontStyle& style
 ) {
+    glm::vec4 tint = batch.getColor() * style.color;
     for (int i = 0; i <= style.bold; i++) {
-        batch.sprite(
+        batch.parallelogram(
             pos.x + (offset.x + i / (right.x/glyphInterval/2.0f)) * right.x,
             pos.y + offset.y * right.y,
             right.x / glyphInterval,
             up.y,
             -0.15f * style.italic,
-            16,
-            c,
-            batch.getColor() * style.color
+            region.u1,
+            region.v1,
+            region.getWidth(),
+            region.getHeight(),
+            tint.r, tint.g, tint.b, tint.a
         );
     }
 }
 
+/// @brief Batch3D-like glyphs vertices collector
+class MeshDataBatch {
+    FontMeshData& dst;
+    std::vector<float>* vertices = nullptr;
+    const Texture* currentTexture = nullptr;
+    glm::vec4 color;
+
+    void vertex(const glm::vec3& pos, float u, float v, const glm::vec4& c) {
+        vertices->insert(
+            vertices->end(), {pos.x, pos.y, pos.z, u, v, c.r, c.g, c.b, c.a}
+        );
+    }
+public:
+    MeshDataBatch(FontMeshData& dst, const glm::vec4& color)
+        : dst(dst), color(color) {
+    }
+
+    void texture(const Texture* texture) {
+        if (texture == currentTexture && vertices) {
+            return;
+        }
+        currentTexture = texture;
+        for (auto& page : dst.pages) {
+            if (page.texture == texture) {
+                vertices = &page.vertices;
+                return;
+            }
+        }
+        dst.pages.push_back({texture, {}});
+        vertices = &dst.pages.back().vertices;
+    }
+
+    const glm::vec4& getColor() const {
+        return color;
+    }
+
+    /// @brief Mesh data built before a glyph replacement is rebuilt
+    /// by the glyph evictions count check
+    void flush() {
+    }
+
+    void sprite(
+        const glm::vec3& pos,
+        const glm::vec3& up,
+        const glm::vec3& right,
+        float w,
+        float h,
+        const UVRegion& region,
+        const glm::vec4& tint
+    ) {
+        float u1 = region.u1;
+        float v1 = region.v1;
+        float u2 = region.u2;
+        float v2 = region.v2;
+        glm::vec3 rw = right * w;
+        glm::vec3 uh = up * h;
+        vertex(pos - rw - uh, u1, v1, tint);
+        vertex(pos + rw + uh, u2, v2, tint);
+        vertex(pos - rw + uh, u1, v2, tint);
+        vertex(pos - rw - uh, u1, v1, tint);
+        vertex(pos + rw - uh, u2, v1, tint);
+        vertex(pos + rw + uh, u2, v2, tint);
+    }
+};
+
+template <class Batch>
 static inline void draw_glyph(
-    Batch3D& batch, 
+    Batch& batch, 
     const glm::vec3& pos, 
     const glm::vec2& offset, 
-    uint c, 
+    const UVRegion& region,
     const glm::vec3& right,
     const glm::vec3& up,
     float glyphInterval,
@@ -86,13 +162,22 @@ static inline void draw_glyph(
             up, right / glyphInterval,
             0.5f,
             0.5f,
-            16,
-            c,
+            region,
             batch.getColor() * style.color
         );
     }
 }
 
+/// @brief Get glyph region flushing the batch first if the glyph loading
+/// replaces or moves glyphs used by not drawn vertices
+template <class Batch>
+static inline UVRegion get_glyph(const Font& font, Batch& batch, uint c) {
+    if (font.isGlyphChanging(c)) {
+        batch.flush();
+    }
+    return font.getGlyph(c);
+}
+
 template <class Batch>
 static inline void draw_text(
     const Font& font,
@@ -111,47 +196,41 @@ static inline void draw_text(
         styles = &defStyles;
     }
     
-    uint page = 0;
-    uint next = MAX_CODEPAGES;
     int x = 0;
     int y = 0;
     bool hasLines = false;
 
-    do {
-        for (size_t i = 0; i < text.length(); i++) {
-            uint c = text[i];
-            size_t styleIndex = styles->map.at(
-                std::min(styles->map.size() - 1, i + styleMapOffset)
-            );
-            const FontStyle& style = styles->palette.at(styleIndex);
-            hasLines |= style.strikethrough;
-            hasLines |= style.underline;
+    batch.texture(font.getTexture());
+    for (size_t i = 0; i < text.length(); i++) {
+        uint c = text[i];
+        size_t styleIndex = styles->map.at(
+            std::min(styles->map.size() - 1, i + styleMapOffset)
+        );
+        const FontStyle& style = styles->palette.at(styleIndex);
+        hasLines |= style.strikethrough;
+        hasLines |= style.underline;
 
-            if (!font.isPrintableChar(c)) {
-                x++;
-                continue;
-            }
-            uint charpage = c >> 8;
-            if (charpage == page){
-                batch.texture(font.getPage(charpage));
-                draw_glyph(
-                    batch, pos, glm::vec2(x, y), c, right, up, interval, style
-                );
-            }
-            else if (charpage > page && charpage < next){
-                next = charpage;
-            }
-            x++;
+        if (font.isPrintableChar(c)) {
+            draw_glyph(
+                batch,
+                pos,
+                glm::vec2(x, y),
+                get_glyph(font, batch, c),
+                right,
+                up,
+                interval,
+                style
+            );
         }
-        page = next;
-        next = MAX_CODEPAGES;
-        x = 0;
-    } while (page < MAX_CODEPAGES);
+        x++;
+    }
 
     if (!hasLines) {
         return;
     }
-    batch.texture(font.getPage(0));
+    x = 0;
+    const UVRegion strikethrough = get_glyph(font, batch, '-');
+    const UVRegion underline = get_glyph(font, batch, '_');
     for (size_t i = 0; i < text.length(); i++) {
         uint c = text[i];
         size_t styleIndex = styles->map.at(
@@ -162,27 +241,42 @@ static inline void draw_text(
         lineStyle.bold = true;
         if (style.strikethrough) {
             draw_glyph(
-                batch, pos, glm::vec2(x, y), '-', right, up, interval, lineStyle
+                batch,
+                pos,
+                glm::vec2(x, y),
+                strikethrough,
+                right,
+                up,
+                interval,
+                lineStyle
             );
         }
         if (style.underline) {
             draw_glyph(
-                batch, pos, glm::vec2(x, y), '_', right, up, interval, lineStyle
+                batch,
+                pos,
+                glm::vec2(x, y),
+                underline,
+                right,
+                up,
+                interval,
+                lineStyle
             );
         }
         x++;
     }
 }
 
-const Texture* Font::getPage(int charpage) const {
-    Texture* texture = nullptr;
-    if (charpage < pages.size()) {
-        texture = pages[charpage].get();
-    }
-    if (texture == nullptr){
-        texture = pages[0].get();
-    }
-    return texture;
+const Texture* Font::getTexture() const {
+    return atlas->getTexture();
+}
+
+UVRegion Font::getGlyph(uint codepoint) const {
+    return atlas->get(codepoint);
+}
+
+bool Font::isGlyphChanging(uint codepoint) const {
+    return atlas->isChanging(codepoint);
 }
 
 void Font::draw(
@@ -223,3 +317,24 @@ void Font::draw(
         styleMapOffset
     );
 }
+
+void Font::build(
+    FontMeshData& dst,
+    std::wstring_view text,
+    const FontStylesScheme* styles,
+    size_t styleMapOffset,
+    const glm::vec4& color,
+    const glm::vec3& pos,
+    const glm::vec3& right,
+    const glm::vec3& up
+) const {
+    MeshDataBatch batch(dst, color);
+    draw_text(
+        *this, batch, text, pos,
+        right * static_cast<float>(glyphInterval),
+        up * static_cast<float>(lineHeight),
+        glyphInterval/static_cast<float>(lineHeight),
+        styles,
+        styleMapOffset
+    );
+}
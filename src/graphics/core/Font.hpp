@@ -5,8 +5,11 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include "typedefs.hpp"
+#include "maths/UVRegion.hpp"
 
 class Texture;
+class ImageData;
+class GlyphAtlas;
 class Batch2D;
 class Batch3D;
 class Camera;
@@ -40,13 +43,32 @@ struct FontStylesScheme {
     std::vector<ubyte> map;
 };
 
+/// @brief Text glyphs vertices grouped by textures.
+/// Vertex format matches Batch3D: xyz, uv, rgba
+struct FontMeshData {
+    struct Page {
+        const Texture* texture;
+        std::vector<float> vertices;
+    };
+    std::vector<Page> pages;
+};
+
 class Font {
     int lineHeight;
     int yoffset;
     int glyphInterval = 8;
-    std::vector<std::unique_ptr<Texture>> pages;
+    /// @brief Pages images (256 glyphs each) glyphs are taken from
+    std::vector<std::unique_ptr<ImageData>> pages;
+    /// @brief Texture with used glyphs only
+    std::unique_ptr<GlyphAtlas> atlas;
 public:
-    Font(std::vector<std::unique_ptr<Texture>> pages, int lineHeight, int yoffset);
+    /// @param pages pages images, missing pages are nullptr.
+    /// Page 0 must be present
+    Font(
+        std::vector<std::unique_ptr<ImageData>> pages,
+        int lineHeight,
+        int yoffset
+    );
     ~Font();
 
     int getLineHeight() const;
@@ -89,5 +111,25 @@ public:
         const glm::vec3& up={0, 1, 0}
     ) const;
 
-    const Texture* getPage(int page) const;
+    /// @brief Generate text glyphs vertices like Batch3D draw does,
+    /// used to cache meshes of rarely changed texts
+    void build(
+        FontMeshData& dst,
+        std::wstring_view text,
+        const FontStylesScheme* styles,
+        size_t styleMapOffset,
+        const glm::vec4& color,
+        const glm::vec3& pos,
+        const glm::vec3& right={1, 0, 0},
+        const glm::vec3& up={0, 1, 0}
+    ) const;
+
+    /// @brief Get texture containing all glyphs returned by getGlyph
+    const Texture* getTexture() const;
+
+    /// @brief Get glyph region in the font texture, loading it on demand
+    UVRegion getGlyph(uint codepoint) const;
+
+    /// @brief Check if loading the glyph changes regions of other glyphs
+    bool isGlyphChanging(uint codepoint) const;
 };
@@ -7,6 +7,10 @@
 
 uint Texture::MAX_RESOLUTION = 1024; // Window.initialize overrides it
 
+/// @brief Images of this size (bytes) and larger are uploaded through
+/// a pixel buffer object, so the transfer does not stall the main thread
+static constexpr size_t PBO_UPLOAD_THRESHOLD = 256 * 1024;
+
 GLTexture::GLTexture(uint id, uint width, uint height) 
     : Texture(width, height), id(id) {
 }
@@ -18,10 +22,25 @@ GLTexture::GLTexture(const ubyte* data, uint width, uint height, ImageFormat ima
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
     GLenum format = gl::to_glenum(imageFormat);
+    size_t size = static_cast<size_t>(width) * height *
+                  (imageFormat == ImageFormat::rgba8888 ? 4 : 3);
+    GLuint pbo = 0;
+    if (data && size >= PBO_UPLOAD_THRESHOLD && GLEW_ARB_pixel_buffer_object) {
+        glGenBuffers(1, &pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, data, GL_STREAM_DRAW);
+        // pixels are read from the bound buffer at offset 0
+        data = nullptr;
+    }
     glTexImage2D(
         GL_TEXTURE_2D, 0, format, width, height, 0,
         format, GL_UNSIGNED_BYTE, static_cast<const GLvoid*>(data)
     );
+    if (pbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        // actually released by the driver when the transfer is done
+        glDeleteBuffers(1, &pbo);
+    }
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glGenerateMipmap(GL_TEXTURE_2D);
@@ -54,6 +73,23 @@ void GLTexture::reload(const ubyte* data) {
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+void GLTexture::reloadRegion(const ImageData& image, uint x, uint y) {
+    glBindTexture(GL_TEXTURE_2D, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLenum format = gl::to_glenum(image.getFormat());
+    glTexSubImage2D(
+        GL_TEXTURE_2D, 0, x, y, image.getWidth(), image.getHeight(),
+        format, GL_UNSIGNED_BYTE, static_cast<const GLvoid*>(image.getData())
+    );
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GLTexture::generateMipmaps() {
+    glBindTexture(GL_TEXTURE_2D, id);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 std::unique_ptr<ImageData> GLTexture::readData() {
     auto data = std::make_unique<ubyte[]>(width * height * 4);
     glBindTexture(GL_TEXTURE_2D, id);
@@ -14,6 +14,15 @@ public:
     virtual void unbind() const override;
     virtual void reload(const ubyte* data);
 
+    /// @brief Update part of the texture
+    /// @param image RGBA8888 image data
+    /// @param x destination x offset in pixels
+    /// @param y destination y offset in pixels
+    void reloadRegion(const ImageData& image, uint x, uint y);
+
+    /// @brief Generate mip levels again after the texture is updated
+    void generateMipmaps();
+
     void setNearestFilter();
 
     virtual void reload(const ImageData& image) override;
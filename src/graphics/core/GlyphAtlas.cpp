@@ -0,0 +1,163 @@
+#include "GlyphAtlas.hpp"
+
+#include <cstring>
+
+#include "GLTexture.hpp"
+
+/// @brief Number of glyphs in a font page row and column
+inline constexpr uint PAGE_GLYPHS = 16;
+/// @brief Max atlas texture height in pixels
+inline constexpr uint MAX_ATLAS_HEIGHT = 4096;
+/// @brief Number of frames a used glyph is not replaced while the atlas
+/// can grow, so glyphs of the frequently drawn texts are not thrashed
+inline constexpr size_t RECENT_FRAMES = 60;
+
+size_t GlyphAtlas::evictions = 0;
+size_t GlyphAtlas::frame = 0;
+
+GlyphAtlas::GlyphAtlas(
+    const std::vector<std::unique_ptr<ImageData>>& pages, uint glyphSize
+)
+    : pages(pages),
+      glyphSize(glyphSize),
+      glyphImage(ImageFormat::rgba8888, glyphSize, glyphSize) {
+    uint size = COLUMNS * glyphSize;
+    auto empty = std::make_unique<ubyte[]>(size * size * 4);
+    texture = std::make_unique<GLTexture>(
+        empty.get(), size, size, ImageFormat::rgba8888
+    );
+    texture->setMipMapping(false);
+    cells.reserve(getCapacity());
+    indices.reserve(getCapacity());
+}
+
+GlyphAtlas::~GlyphAtlas() = default;
+
+bool GlyphAtlas::grow() {
+    if (rows * 2 * glyphSize > MAX_ATLAS_HEIGHT) {
+        return false;
+    }
+    rows *= 2;
+    // the texture object is kept, so batches refer the resized one
+    texture->reload(ImageData(
+        ImageFormat::rgba8888, COLUMNS * glyphSize, rows * glyphSize
+    ));
+    for (uint index = 0; index < cells.size(); index++) {
+        load(index, cells[index].codepoint);
+    }
+    // vertical texture coordinates of all glyphs are changed
+    evictions++;
+    return true;
+}
+
+void GlyphAtlas::unlink(uint index) {
+    auto& cell = cells[index];
+    if (cell.prev != NONE) {
+        cells[cell.prev].next = cell.next;
+    } else {
+        head = cell.next;
+    }
+    if (cell.next != NONE) {
+        cells[cell.next].prev = cell.prev;
+    } else {
+        tail = cell.prev;
+    }
+}
+
+void GlyphAtlas::pushFront(uint index) {
+    auto& cell = cells[index];
+    cell.prev = NONE;
+    cell.next = head;
+    if (head != NONE) {
+        cells[head].prev = index;
+    }
+    head = index;
+    if (tail == NONE) {
+        tail = index;
+    }
+}
+
+void GlyphAtlas::load(uint index, uint codepoint) {
+    uint pageIndex = codepoint / (PAGE_GLYPHS * PAGE_GLYPHS);
+    const ImageData* page = nullptr;
+    if (pageIndex < pages.size()) {
+        page = pages[pageIndex].get();
+    }
+    if (page == nullptr) {
+        page = pages.at(0).get();
+    }
+    uint glyph = codepoint % (PAGE_GLYPHS * PAGE_GLYPHS);
+    // page images rows are stored bottom to top
+    uint srcX = (glyph % PAGE_GLYPHS) * glyphSize;
+    uint srcY = page->getHeight() - (glyph / PAGE_GLYPHS + 1) * glyphSize;
+    uint channels = page->getFormat() == ImageFormat::rgba8888 ? 4 : 3;
+
+    const ubyte* src = page->getData();
+    ubyte* dst = glyphImage.getData();
+    for (uint y = 0; y < glyphSize; y++) {
+        for (uint x = 0; x < glyphSize; x++) {
+            size_t srcIndex =
+                ((srcY + y) * page->getWidth() + srcX + x) * channels;
+            size_t dstIndex = (y * glyphSize + x) * 4;
+            std::memcpy(dst + dstIndex, src + srcIndex, channels);
+            if (channels == 3) {
+                dst[dstIndex + 3] = 255;
+            }
+        }
+    }
+    texture->reloadRegion(
+        glyphImage,
+        (index % COLUMNS) * glyphSize,
+        (index / COLUMNS) * glyphSize
+    );
+}
+
+UVRegion GlyphAtlas::getRegion(uint index) const {
+    float scaleU = 1.0f / COLUMNS;
+    float scaleV = 1.0f / rows;
+    float u = (index % COLUMNS) * scaleU;
+    float v = (index / COLUMNS) * scaleV;
+    return UVRegion(u, v, u + scaleU, v + scaleV);
+}
+
+UVRegion GlyphAtlas::get(uint codepoint) {
+    auto found = indices.find(codepoint);
+    if (found != indices.end()) {
+        uint index = found->second;
+        cells[index].frame = frame;
+        if (index != head) {
+            unlink(index);
+            pushFront(index);
+        }
+        return getRegion(index);
+    }
+    if (cells.size() == getCapacity() &&
+        cells[tail].frame + RECENT_FRAMES > frame) {
+        grow();
+    }
+    uint index;
+    if (cells.size() < getCapacity()) {
+        index = cells.size();
+        cells.push_back(Cell {codepoint, NONE, NONE, frame});
+    } else {
+        index = tail;
+        unlink(index);
+        indices.erase(cells[index].codepoint);
+        cells[index].codepoint = codepoint;
+        cells[index].frame = frame;
+        evictions++;
+    }
+    indices[codepoint] = index;
+    pushFront(index);
+    load(index, codepoint);
+    return getRegion(index);
+}
+
+bool GlyphAtlas::isChanging(uint codepoint) const {
+    return cells.size() == getCapacity() &&
+           indices.find(codepoint) == indices.end();
+}
+
+const Texture* GlyphAtlas::getTexture() const {
+    return texture.get();
+}
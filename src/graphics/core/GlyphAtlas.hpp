@@ -0,0 +1,88 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "typedefs.hpp"
+#include "ImageData.hpp"
+#include "maths/UVRegion.hpp"
+#include "util/FlatHashMap.hpp"
+
+class Texture;
+class GLTexture;
+
+/// @brief Single texture filled with font glyphs on demand.
+/// A glyph is copied from its font page image into a free cell when first
+/// requested. When all cells are taken the least recently used glyph is
+/// replaced. If it was used recently (it may be still referenced by not
+/// flushed batches) the atlas grows instead until the size limit
+class GlyphAtlas {
+    struct Cell {
+        uint codepoint;
+        /// @brief More recently used cell
+        uint prev;
+        /// @brief Less recently used cell
+        uint next;
+        /// @brief Frame the glyph was used last time
+        size_t frame;
+    };
+    static constexpr uint COLUMNS = 32;
+    static constexpr uint NONE = ~0U;
+
+    const std::vector<std::unique_ptr<ImageData>>& pages;
+    uint glyphSize;
+    uint rows = COLUMNS;
+    std::unique_ptr<GLTexture> texture;
+    std::vector<Cell> cells;
+    util::FlatHashMap<uint, uint> indices;
+    /// @brief Most recently used cell
+    uint head = NONE;
+    /// @brief Least recently used cell
+    uint tail = NONE;
+    ImageData glyphImage;
+
+    static size_t evictions;
+    static size_t frame;
+
+    /// @brief Double the atlas height reloading glyphs
+    /// @return false if the atlas reached the size limit
+    bool grow();
+    void unlink(uint index);
+    void pushFront(uint index);
+    void load(uint index, uint codepoint);
+    UVRegion getRegion(uint index) const;
+public:
+    /// @param pages font pages images of 16x16 glyphs, missing pages are
+    /// nullptr. Page 0 must be present
+    /// @param glyphSize glyph cell size in pixels
+    GlyphAtlas(
+        const std::vector<std::unique_ptr<ImageData>>& pages, uint glyphSize
+    );
+    ~GlyphAtlas();
+
+    /// @brief Get glyph texture region, loading the glyph if needed.
+    /// Glyphs of missing pages are taken from page 0
+    UVRegion get(uint codepoint);
+
+    /// @brief Check if get(codepoint) replaces or moves stored glyphs, so
+    /// not drawn vertices using the atlas must be flushed before
+    bool isChanging(uint codepoint) const;
+
+    const Texture* getTexture() const;
+
+    uint getCapacity() const {
+        return COLUMNS * rows;
+    }
+
+    /// @brief Get number of glyphs replaced or moved by growth in all
+    /// atlases. Texture regions of glyphs cached before may be invalid
+    static size_t getEvictionsCount() {
+        return evictions;
+    }
+
+    /// @brief Called when a frame is finished, glyphs used in the current
+    /// and the recent frames are not replaced while the atlas can grow
+    static void nextFrame() {
+        frame++;
+    }
+};
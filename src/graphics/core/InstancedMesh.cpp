@@ -0,0 +1,88 @@
+#include "InstancedMesh.hpp"
+
+#include <GL/glew.h>
+
+#include "Mesh.hpp"
+
+static size_t setup_attributes(
+    const VertexAttribute* attrs, uint location, uint divisor
+) {
+    size_t size = 0;
+    for (int i = 0; attrs[i].size; i++) {
+        size += attrs[i].size;
+    }
+    size_t offset = 0;
+    for (int i = 0; attrs[i].size; i++) {
+        glVertexAttribPointer(
+            location + i,
+            attrs[i].size,
+            GL_FLOAT,
+            GL_FALSE,
+            size * sizeof(float),
+            reinterpret_cast<GLvoid*>(offset * sizeof(float))
+        );
+        glEnableVertexAttribArray(location + i);
+        glVertexAttribDivisor(location + i, divisor);
+        offset += attrs[i].size;
+    }
+    return size;
+}
+
+InstancedMesh::InstancedMesh(
+    const VertexAttribute* attrs,
+    const VertexAttribute* instanceAttrs,
+    uint instanceLocation
+) {
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &instancesVbo);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    vertexSize = setup_attributes(attrs, 0, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, instancesVbo);
+    instanceSize = setup_attributes(instanceAttrs, instanceLocation, 1);
+    glBindVertexArray(0);
+}
+
+InstancedMesh::~InstancedMesh() {
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &instancesVbo);
+}
+
+void InstancedMesh::reload(const float* vertexBuffer, size_t vertices) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        sizeof(float) * vertexSize * vertices,
+        vertexBuffer,
+        GL_STREAM_DRAW
+    );
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    this->vertices = vertices;
+}
+
+void InstancedMesh::reloadInstances(
+    const float* instanceBuffer, size_t instances
+) {
+    glBindBuffer(GL_ARRAY_BUFFER, instancesVbo);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        sizeof(float) * instanceSize * instances,
+        instanceBuffer,
+        GL_STREAM_DRAW
+    );
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    this->instances = instances;
+}
+
+void InstancedMesh::draw() const {
+    if (vertices == 0 || instances == 0) {
+        return;
+    }
+    Mesh::drawCalls++;
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, vertices, instances);
+    glBindVertexArray(0);
+}
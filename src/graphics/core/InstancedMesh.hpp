@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdlib.h>
+
+#include "typedefs.hpp"
+#include "MeshData.hpp"
+
+/// @brief Mesh drawn as a number of instances with per-instance attributes
+/// taken from a separate buffer (glVertexAttribDivisor)
+class InstancedMesh {
+    unsigned int vao;
+    unsigned int vbo;
+    unsigned int instancesVbo;
+    size_t vertices = 0;
+    size_t instances = 0;
+    size_t vertexSize = 0;
+    size_t instanceSize = 0;
+public:
+    /// @param attrs vertex attributes (null-terminated)
+    /// @param instanceAttrs per-instance attributes (null-terminated),
+    /// at most 4 values each (matrices take an attribute per column)
+    /// @param instanceLocation location of the first instance attribute
+    InstancedMesh(
+        const VertexAttribute* attrs,
+        const VertexAttribute* instanceAttrs,
+        uint instanceLocation
+    );
+    ~InstancedMesh();
+
+    InstancedMesh(const InstancedMesh&) = delete;
+
+    /// @brief Update vertices shared by all instances
+    void reload(const float* vertexBuffer, size_t vertices);
+
+    /// @brief Update per-instance attributes
+    void reloadInstances(const float* instanceBuffer, size_t instances);
+
+    /// @brief Draw all instances as triangles
+    void draw() const;
+
+    size_t getInstanceSize() const {
+        return instanceSize;
+    }
+};
@@ -69,11 +69,22 @@ void Mesh::reload(const float* vertexBuffer, size_t vertices, const int* indexBu
     }
     else if (ibo != 0) {
         glDeleteBuffers(1, &ibo);
+        ibo = 0;
     }
     this->vertices = vertices;
     this->indices = indices;
 }
 
+void Mesh::reloadIndices(const int* indexBuffer, size_t indices) {
+    glBindVertexArray(vao);
+    if (ibo == 0) glGenBuffers(1, &ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    // re-specifying the storage orphans the buffer still used by draws
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * indices, indexBuffer, GL_STREAM_DRAW);
+    glBindVertexArray(0);
+    this->indices = indices;
+}
+
 void Mesh::draw(unsigned int primitive) const {
     drawCalls++;
     glBindVertexArray(vao);
@@ -86,6 +97,13 @@ void Mesh::draw(unsigned int primitive) const {
     glBindVertexArray(0);
 }
 
+void Mesh::draw(unsigned int primitive, size_t first, size_t count) const {
+    drawCalls++;
+    glBindVertexArray(vao);
+    glDrawArrays(primitive, first, count);
+    glBindVertexArray(0);
+}
+
 void Mesh::draw() const {
     draw(GL_TRIANGLES);
 }
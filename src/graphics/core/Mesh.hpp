@@ -25,11 +25,27 @@ public:
     /// @param indexBuffer indices buffer
     /// @param indices number of values in indices buffer
     void reload(const float* vertexBuffer, size_t vertices, const int* indexBuffer = nullptr, size_t indices = 0);
+
+    /// @brief Update GL index buffer data keeping vertices.
+    /// Indices count must not be changed to zero
+    /// @param indexBuffer indices buffer
+    /// @param indices number of values in indices buffer
+    void reloadIndices(const int* indexBuffer, size_t indices);
     
+    size_t getVerticesCount() const {
+        return vertices;
+    }
+
     /// @brief Draw mesh with specified primitives type
     /// @param primitive primitives type
     void draw(unsigned int primitive) const;
 
+    /// @brief Draw range of vertices (mesh without indices only)
+    /// @param primitive primitives type
+    /// @param first index of the first vertex
+    /// @param count number of vertices
+    void draw(unsigned int primitive, size_t first, size_t count) const;
+
     /// @brief Draw mesh as triangles
     void draw() const;
 
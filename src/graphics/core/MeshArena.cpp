@@ -0,0 +1,323 @@
+#include "MeshArena.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
+
+#include "Mesh.hpp"
+#include "debug/Logger.hpp"
+
+static debug::Logger logger("mesh-arena");
+
+static constexpr GLbitfield PERSISTENT_MAP_FLAGS =
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+MeshArena::Buffer::Buffer(size_t elementSize, size_t capacity)
+    : elementSize(elementSize),
+      capacity(capacity),
+      allocator(capacity) {
+}
+
+MeshArena::MeshArena(
+    const VertexAttribute* attrs,
+    size_t vertexCapacity,
+    size_t indexCapacity,
+    const VertexAttribute* drawAttrs
+)
+    : attrs(attrs),
+      drawAttrs(drawAttrs),
+      vertexSize(0),
+      persistent(GLEW_ARB_buffer_storage),
+      multiDraw(
+          drawAttrs && GLEW_ARB_draw_indirect &&
+          GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance
+      ),
+      vertices(0, std::max<size_t>(vertexCapacity, 1)),
+      indices(sizeof(int), std::max<size_t>(indexCapacity, 1)) {
+    for (int i = 0; attrs[i].size; i++) {
+        vertexSize += attrs[i].size;
+    }
+    vertices.elementSize = vertexSize * sizeof(float);
+    for (int i = 0; drawAttrs && drawAttrs[i].size; i++) {
+        drawAttrsSize += drawAttrs[i].size;
+    }
+
+    glGenVertexArrays(1, &vao);
+    if (multiDraw) {
+        glGenBuffers(1, &commandsBuffer);
+        glGenBuffers(1, &drawDataBuffer);
+    }
+    create(vertices);
+    create(indices);
+    setupAttributes();
+    logger.info() << "created arena of " << getCapacity() / 1024
+                  << " KiB (persistent mapping: "
+                  << (persistent ? "yes" : "no") << ", multi-draw: "
+                  << (multiDraw ? "yes" : "no") << ")";
+}
+
+MeshArena::~MeshArena() {
+    for (const auto& entry : pending) {
+        glDeleteSync(static_cast<GLsync>(entry.fence));
+    }
+    for (auto buffer : {&vertices, &indices}) {
+        if (buffer->mapped) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer->id);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        glDeleteBuffers(1, &buffer->id);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (multiDraw) {
+        glDeleteBuffers(1, &commandsBuffer);
+        glDeleteBuffers(1, &drawDataBuffer);
+    }
+    glDeleteVertexArrays(1, &vao);
+}
+
+void MeshArena::create(Buffer& buffer) {
+    GLsizeiptr size = buffer.capacity * buffer.elementSize;
+    glGenBuffers(1, &buffer.id);
+    // GL_COPY_WRITE_BUFFER does not affect VAO state
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+    if (persistent) {
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr,
+                        PERSISTENT_MAP_FLAGS);
+        buffer.mapped = static_cast<ubyte*>(glMapBufferRange(
+            GL_COPY_WRITE_BUFFER, 0, size, PERSISTENT_MAP_FLAGS
+        ));
+    } else {
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+        buffer.mapped = nullptr;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void MeshArena::grow(Buffer& buffer, size_t minCapacity) {
+    size_t newCapacity = std::max(buffer.capacity * 2, minCapacity);
+    uint oldId = buffer.id;
+    size_t oldSize = buffer.capacity * buffer.elementSize;
+    bool wasMapped = buffer.mapped != nullptr;
+
+    buffer.capacity = newCapacity;
+    create(buffer);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, oldId);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+    glCopyBufferSubData(
+        GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize
+    );
+    if (wasMapped) {
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &oldId);
+
+    buffer.allocator.grow(newCapacity);
+    setupAttributes();
+    logger.info() << "arena buffer grown to "
+                  << newCapacity * buffer.elementSize / 1024 << " KiB";
+}
+
+size_t MeshArena::allocate(Buffer& buffer, size_t count) {
+    if (auto offset = buffer.allocator.allocate(count)) {
+        return *offset;
+    }
+    grow(buffer, buffer.capacity + count);
+    return buffer.allocator.allocate(count).value();
+}
+
+void MeshArena::write(
+    Buffer& buffer, size_t offset, const void* data, size_t count
+) {
+    size_t byteOffset = offset * buffer.elementSize;
+    size_t size = count * buffer.elementSize;
+    if (buffer.mapped) {
+        std::memcpy(buffer.mapped + byteOffset, data, size);
+        return;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, byteOffset, size, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void MeshArena::setupAttributes() {
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vertices.id);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices.id);
+    int offset = 0;
+    for (int i = 0; attrs[i].size; i++) {
+        int size = attrs[i].size;
+        glVertexAttribPointer(
+            i,
+            size,
+            GL_FLOAT,
+            GL_FALSE,
+            vertexSize * sizeof(float),
+            (GLvoid*)(offset * sizeof(float))
+        );
+        glEnableVertexAttribArray(i);
+        offset += size;
+    }
+    if (multiDraw) {
+        // per-draw attributes are fetched by baseInstance of the draw
+        // command and stay disabled (zero) outside of drawMulti
+        glBindBuffer(GL_ARRAY_BUFFER, drawDataBuffer);
+        uint location = 0;
+        for (; attrs[location].size; location++);
+        offset = 0;
+        for (int i = 0; drawAttrs[i].size; i++, location++) {
+            int size = drawAttrs[i].size;
+            glVertexAttribPointer(
+                location,
+                size,
+                GL_FLOAT,
+                GL_FALSE,
+                drawAttrsSize * sizeof(float),
+                (GLvoid*)(offset * sizeof(float))
+            );
+            glVertexAttribDivisor(location, 1);
+            offset += size;
+        }
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshArena::setDrawAttributesEnabled(bool flag) {
+    uint location = 0;
+    for (; attrs[location].size; location++);
+    for (int i = 0; drawAttrs[i].size; i++, location++) {
+        if (flag) {
+            glEnableVertexAttribArray(location);
+        } else {
+            glDisableVertexAttribArray(location);
+        }
+    }
+}
+
+ArenaMesh MeshArena::allocate(const MeshData& data) {
+    ArenaMesh mesh {};
+    mesh.vertexCount = data.vertices.size() / vertexSize;
+    mesh.indexCount = data.indices.size();
+    if (mesh.vertexCount == 0 || mesh.indexCount == 0) {
+        return ArenaMesh {};
+    }
+    mesh.vertexOffset = allocate(vertices, mesh.vertexCount);
+    mesh.indexOffset = allocate(indices, mesh.indexCount);
+    write(vertices, mesh.vertexOffset, data.vertices.data(), mesh.vertexCount);
+    write(indices, mesh.indexOffset, data.indices.data(), mesh.indexCount);
+    return mesh;
+}
+
+void MeshArena::release(const ArenaMesh& mesh) {
+    vertices.allocator.free(mesh.vertexOffset, mesh.vertexCount);
+    indices.allocator.free(mesh.indexOffset, mesh.indexCount);
+}
+
+void MeshArena::free(const ArenaMesh& mesh) {
+    if (!mesh.empty()) {
+        freed.push_back(mesh);
+    }
+}
+
+void MeshArena::update() {
+    if (!freed.empty()) {
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        pending.push_back(PendingFree {fence, std::move(freed)});
+        freed.clear();
+    }
+    size_t done = 0;
+    for (; done < pending.size(); done++) {
+        auto fence = static_cast<GLsync>(pending[done].fence);
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED &&
+            status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        glDeleteSync(fence);
+        for (const auto& mesh : pending[done].meshes) {
+            release(mesh);
+        }
+    }
+    pending.erase(pending.begin(), pending.begin() + done);
+}
+
+void MeshArena::bind() const {
+    glBindVertexArray(vao);
+}
+
+void MeshArena::unbind() const {
+    glBindVertexArray(0);
+}
+
+void MeshArena::draw(const ArenaMesh& mesh) const {
+    if (mesh.empty()) {
+        return;
+    }
+    Mesh::drawCalls++;
+    bind();
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES,
+        mesh.indexCount,
+        GL_UNSIGNED_INT,
+        (GLvoid*)(mesh.indexOffset * sizeof(int)),
+        mesh.vertexOffset
+    );
+}
+
+void MeshArena::drawMulti(
+    const std::vector<ArenaMesh>& meshes, const std::vector<float>& drawData
+) {
+    commands.clear();
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const auto& mesh = meshes[i];
+        if (mesh.empty()) {
+            continue;
+        }
+        commands.push_back(DrawCommand {
+            static_cast<uint32_t>(mesh.indexCount),
+            1,
+            static_cast<uint32_t>(mesh.indexOffset),
+            static_cast<int32_t>(mesh.vertexOffset),
+            static_cast<uint32_t>(i),
+        });
+    }
+    if (commands.empty()) {
+        return;
+    }
+    Mesh::drawCalls++;
+    glBindBuffer(GL_ARRAY_BUFFER, drawDataBuffer);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        drawData.size() * sizeof(float),
+        drawData.data(),
+        GL_STREAM_DRAW
+    );
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandsBuffer);
+    glBufferData(
+        GL_DRAW_INDIRECT_BUFFER,
+        commands.size() * sizeof(DrawCommand),
+        commands.data(),
+        GL_STREAM_DRAW
+    );
+    bind();
+    setDrawAttributesEnabled(true);
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, commands.size(), 0
+    );
+    setDrawAttributesEnabled(false);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+size_t MeshArena::getCapacity() const {
+    return vertices.capacity * vertices.elementSize +
+           indices.capacity * indices.elementSize;
+}
+
+size_t MeshArena::getUsed() const {
+    return vertices.allocator.getUsed() * vertices.elementSize +
+           indices.allocator.getUsed() * indices.elementSize;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "typedefs.hpp"
+#include "MeshData.hpp"
+#include "util/RangeAllocator.hpp"
+
+/// @brief Mesh stored in MeshArena buffers
+struct ArenaMesh {
+    /// @brief First vertex in the arena vertex buffer
+    size_t vertexOffset = 0;
+    size_t vertexCount = 0;
+    /// @brief First index in the arena index buffer. Indices are relative
+    /// to the first vertex of the mesh
+    size_t indexOffset = 0;
+    size_t indexCount = 0;
+
+    bool empty() const {
+        return indexCount == 0;
+    }
+};
+
+/// @brief Shared vertex and index buffers with meshes sub-allocation.
+/// Uses persistently mapped buffers if ARB_buffer_storage is supported.
+/// Buffers grow when they run out of space.
+class MeshArena {
+    struct Buffer {
+        uint id = 0;
+        size_t elementSize;
+        size_t capacity;
+        /// @brief Persistently mapped memory or nullptr
+        ubyte* mapped = nullptr;
+        util::RangeAllocator allocator;
+
+        Buffer(size_t elementSize, size_t capacity);
+    };
+    /// @brief Layout of glMultiDrawElementsIndirect command
+    struct DrawCommand {
+        uint32_t count;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t baseVertex;
+        uint32_t baseInstance;
+    };
+    struct PendingFree {
+        /// @brief GLsync fence placed after commands using freed meshes
+        void* fence;
+        std::vector<ArenaMesh> meshes;
+    };
+
+    uint vao = 0;
+    const VertexAttribute* attrs;
+    const VertexAttribute* drawAttrs;
+    size_t vertexSize;
+    size_t drawAttrsSize = 0;
+    bool persistent;
+    bool multiDraw;
+    Buffer vertices;
+    Buffer indices;
+    std::vector<ArenaMesh> freed;
+    std::vector<PendingFree> pending;
+
+    uint commandsBuffer = 0;
+    uint drawDataBuffer = 0;
+    std::vector<DrawCommand> commands;
+
+    void create(Buffer& buffer);
+    void grow(Buffer& buffer, size_t minCapacity);
+    size_t allocate(Buffer& buffer, size_t count);
+    void write(Buffer& buffer, size_t offset, const void* data, size_t count);
+    void setupAttributes();
+    void setDrawAttributesEnabled(bool flag);
+    void release(const ArenaMesh& mesh);
+public:
+    /// @param attrs vertex attribute sizes (must be null-terminated),
+    /// must stay alive while the arena is in use
+    /// @param vertexCapacity initial vertex buffer capacity in vertices
+    /// @param indexCapacity initial index buffer capacity in indices
+    /// @param drawAttrs per-draw attribute sizes used by drawMulti
+    /// (null-terminated, nullable). Locations follow vertex attributes
+    MeshArena(
+        const VertexAttribute* attrs,
+        size_t vertexCapacity,
+        size_t indexCapacity,
+        const VertexAttribute* drawAttrs = nullptr
+    );
+    ~MeshArena();
+
+    MeshArena(const MeshArena&) = delete;
+
+    /// @brief Copy mesh data into the arena buffers
+    ArenaMesh allocate(const MeshData& data);
+
+    /// @brief Release mesh. The space is reused when the GPU finishes
+    /// commands issued before the next update() call
+    void free(const ArenaMesh& mesh);
+
+    /// @brief Place a fence for meshes freed since the previous call and
+    /// reclaim space of meshes the GPU is done with. Call once per frame
+    /// after drawing
+    void update();
+
+    void bind() const;
+    void unbind() const;
+
+    /// @brief Draw mesh as triangles. Leaves the arena VAO bound.
+    /// Per-draw attributes are zero
+    void draw(const ArenaMesh& mesh) const;
+
+    /// @brief Draw meshes with a single glMultiDrawElementsIndirect call.
+    /// Requires isMultiDrawSupported()
+    /// @param meshes meshes to draw in order
+    /// @param drawData per-draw attributes values for every mesh
+    void drawMulti(
+        const std::vector<ArenaMesh>& meshes, const std::vector<float>& drawData
+    );
+
+    /// @return true if multi-draw indirect with per-draw attributes
+    /// is supported
+    bool isMultiDrawSupported() const {
+        return multiDraw;
+    }
+
+    bool isPersistent() const {
+        return persistent;
+    }
+
+    /// @return total size of the arena buffers in bytes
+    size_t getCapacity() const;
+
+    /// @return total size of allocated meshes in bytes
+    size_t getUsed() const;
+};
@@ -6,7 +6,20 @@
 #include "Viewport.hpp"
 #include "DrawContext.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
+#include <GL/glew.h>
+
+/// @brief Min main framebuffer resolution scale
+static constexpr float MIN_RENDER_SCALE = 0.5f;
+/// @brief Render scale is changed by steps to not recreate the framebuffer
+/// every frame
+static constexpr float RENDER_SCALE_STEP = 0.05f;
+/// @brief Min number of GPU time samples between render scale changes
+static constexpr int SAMPLES_PER_CHANGE = 15;
+/// @brief Measured time is smoothed as average of ~1/k last samples
+static constexpr float FRAME_TIME_SMOOTHING = 0.1f;
 
 PostProcessing::PostProcessing() {
     // Fullscreen quad mesh bulding
@@ -18,27 +31,113 @@ PostProcessing::PostProcessing() {
     quadMesh = std::make_unique<Mesh>(vertices, 6, attrs);
 }
 
-PostProcessing::~PostProcessing() = default;
+PostProcessing::~PostProcessing() {
+    for (const auto& query : queries) {
+        if (query.id) {
+            glDeleteQueries(1, &query.id);
+        }
+    }
+}
+
+void PostProcessing::setDynamicResolution(bool enabled, float targetFrameTime) {
+    this->targetFrameTime = targetFrameTime;
+    if (dynamicResolution == enabled) {
+        return;
+    }
+    dynamicResolution = enabled;
+    renderScale = 1.0f;
+    gpuFrameTime = -1.0f;
+    samplesSinceChange = 0;
+}
+
+void PostProcessing::addFrameTimeSample(float milliseconds) {
+    if (gpuFrameTime < 0.0f) {
+        gpuFrameTime = milliseconds;
+    } else {
+        gpuFrameTime += (milliseconds - gpuFrameTime) * FRAME_TIME_SMOOTHING;
+    }
+    if (++samplesSinceChange < SAMPLES_PER_CHANGE) {
+        return;
+    }
+    // fragments work is proportional to the pixels count (scale squared)
+    float desired = renderScale * std::sqrt(targetFrameTime / gpuFrameTime);
+    float scale = renderScale;
+    if (desired < renderScale - RENDER_SCALE_STEP * 0.5f) {
+        scale -= RENDER_SCALE_STEP;
+    } else if (desired > renderScale + RENDER_SCALE_STEP) {
+        scale += RENDER_SCALE_STEP;
+    }
+    scale = std::clamp(scale, MIN_RENDER_SCALE, 1.0f);
+    if (scale != renderScale) {
+        renderScale = scale;
+        samplesSinceChange = 0;
+    }
+}
+
+void PostProcessing::collectTimerQueries() {
+    for (auto& query : queries) {
+        if (!query.pending) {
+            continue;
+        }
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanoseconds);
+        query.pending = false;
+        if (dynamicResolution) {
+            addFrameTimeSample(nanoseconds / 1e6f);
+        }
+    }
+}
 
 void PostProcessing::use(DrawContext& context) {
+    collectTimerQueries();
+    if (dynamicResolution) {
+        auto& query = queries[nextQuery];
+        if (!query.pending) {
+            if (query.id == 0) {
+                glGenQueries(1, &query.id);
+            }
+            glBeginQuery(GL_TIME_ELAPSED, query.id);
+            query.pending = true;
+            queryActive = true;
+            nextQuery = (nextQuery + 1) % queries.size();
+        }
+    }
     const auto& vp = context.getViewport();
+    uint width = std::max(1U, static_cast<uint>(vp.getWidth() * renderScale));
+    uint height = 
+        std::max(1U, static_cast<uint>(vp.getHeight() * renderScale));
     if (fbo) {
-        fbo->resize(vp.getWidth(), vp.getHeight());
+        fbo->resize(width, height);
     } else {
-        fbo = std::make_unique<Framebuffer>(vp.getWidth(), vp.getHeight());
+        fbo = std::make_unique<Framebuffer>(width, height);
     }
     context.setFramebuffer(fbo.get());
+    if (renderScale < 1.0f) {
+        context.setViewport(Viewport(width, height));
+    }
 }
 
 void PostProcessing::render(const DrawContext& context, Shader* screenShader) {
     if (fbo == nullptr) {
         throw std::runtime_error("'use(...)' was never called");
     }
-
+    if (queryActive) {
+        glEndQuery(GL_TIME_ELAPSED);
+        queryActive = false;
+    }
     const auto& viewport = context.getViewport();
     screenShader->use();
     screenShader->uniform2i("u_screenSize", viewport.size());
-    fbo->getTexture()->bind();
+    auto texture = fbo->getTexture();
+    texture->bind();
+    GLint filter = renderScale < 1.0f ? GL_LINEAR : GL_NEAREST;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
     quadMesh->draw();
 }
 
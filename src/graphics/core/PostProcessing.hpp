@@ -1,7 +1,10 @@
 #pragma once
 
+#include <array>
 #include <memory>
 
+#include "typedefs.hpp"
+
 class Mesh;
 class Shader;
 class Framebuffer;
@@ -16,16 +19,47 @@ class PostProcessing {
     std::unique_ptr<Framebuffer> fbo;
     /// @brief Fullscreen quad mesh as the post-processing canvas
     std::unique_ptr<Mesh> quadMesh;
+
+    struct TimerQuery {
+        uint id = 0;
+        bool pending = false;
+    };
+    /// @brief GPU timer queries ring, results are read few frames later
+    /// to not stall the pipeline
+    std::array<TimerQuery, 4> queries {};
+    size_t nextQuery = 0;
+    bool queryActive = false;
+
+    bool dynamicResolution = false;
+    /// @brief Target GPU time of the world rendering (milliseconds)
+    float targetFrameTime = 1000.0f / 60.0f;
+    /// @brief Smoothed measured GPU time (milliseconds), negative if unknown
+    float gpuFrameTime = -1.0f;
+    /// @brief Samples since the last render scale change
+    int samplesSinceChange = 0;
+    /// @brief Main framebuffer resolution scale
+    float renderScale = 1.0f;
+
+    void collectTimerQueries();
+    void addFrameTimeSample(float milliseconds);
 public:
     PostProcessing();
     ~PostProcessing();
 
+    /// @brief Enable or disable dynamic resolution scaling
+    /// @param enabled scale main framebuffer resolution by measured
+    /// GPU time
+    /// @param targetFrameTime target GPU time between use(...) and
+    /// render(...) calls (milliseconds)
+    void setDynamicResolution(bool enabled, float targetFrameTime);
+
     /// @brief Prepare and bind framebuffer
-    /// @param context graphics context will be modified
+    /// @param context graphics context will be modified, viewport is
+    /// scaled with dynamic resolution enabled
     void use(DrawContext& context);
 
     /// @brief Render fullscreen quad using the passed shader 
-    /// with framebuffer texture bound
+    /// with framebuffer texture bound (upscaled to the context viewport)
     /// @param context graphics context
     /// @param screenShader shader used for fullscreen quad
     /// @throws std::runtime_error if use(...) wasn't called before
@@ -35,4 +69,8 @@ public:
     std::unique_ptr<ImageData> toImage();
 
     Framebuffer* getFramebuffer() const;
+
+    float getRenderScale() const {
+        return renderScale;
+    }
 };
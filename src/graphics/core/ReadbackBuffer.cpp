@@ -0,0 +1,68 @@
+#include "ReadbackBuffer.hpp"
+
+#include <GL/glew.h>
+#include <cstring>
+
+#include "ImageData.hpp"
+
+ReadbackBuffer::ReadbackBuffer() {
+    glGenBuffers(1, &id);
+}
+
+ReadbackBuffer::~ReadbackBuffer() {
+    if (fence) {
+        glDeleteSync(static_cast<GLsync>(fence));
+    }
+    glDeleteBuffers(1, &id);
+}
+
+void ReadbackBuffer::read(uint width, uint height) {
+    if (fence) {
+        glDeleteSync(static_cast<GLsync>(fence));
+    }
+    this->width = width;
+    this->height = height;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, id);
+    glBufferData(
+        GL_PIXEL_PACK_BUFFER, width * height * 3, nullptr, GL_STREAM_READ
+    );
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    // the buffer is bound, so the data argument is an offset in it
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool ReadbackBuffer::isReady() const {
+    if (fence == nullptr) {
+        return true;
+    }
+    GLenum status = glClientWaitSync(static_cast<GLsync>(fence), 0, 0);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+}
+
+std::unique_ptr<ImageData> ReadbackBuffer::getImage() {
+    if (fence == nullptr) {
+        return nullptr;
+    }
+    auto sync = static_cast<GLsync>(fence);
+    glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(sync);
+    fence = nullptr;
+
+    size_t size = width * height * 3;
+    auto image = std::make_unique<ImageData>(
+        ImageFormat::rgb888, width, height
+    );
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, id);
+    if (size) {
+        const void* data =
+            glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+        if (data) {
+            std::memcpy(image->getData(), data, size);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return image;
+}
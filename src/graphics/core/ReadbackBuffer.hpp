@@ -0,0 +1,34 @@
+#pragma once
+
+#include <memory>
+
+#include "typedefs.hpp"
+
+class ImageData;
+
+/// @brief Pixel pack buffer reading framebuffer pixels without stalling
+/// the frame. Pixels are copied to the buffer by GPU and available
+/// on the CPU side when the fence placed after the copy is passed
+class ReadbackBuffer {
+    uint id;
+    /// @brief GLsync fence, nullptr if no read is pending
+    void* fence = nullptr;
+    uint width = 0;
+    uint height = 0;
+public:
+    ReadbackBuffer();
+    ~ReadbackBuffer();
+
+    ReadbackBuffer(const ReadbackBuffer&) = delete;
+
+    /// @brief Start reading RGB pixels of the bound read framebuffer
+    void read(uint width, uint height);
+
+    /// @brief Check if the pending read is finished, never blocks
+    bool isReady() const;
+
+    /// @brief Get pixels of the finished read (rows are bottom-up).
+    /// Waits for the read to finish if pending
+    /// @return nullptr if no read was started
+    std::unique_ptr<ImageData> getImage();
+};
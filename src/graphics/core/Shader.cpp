@@ -28,48 +28,105 @@ void Shader::use(){
     glUseProgram(id);
 }
 
-uint Shader::getUniformLocation(const std::string& name) {
-    auto found = uniformLocations.find(name);
-    if (found == uniformLocations.end()) {
-        uint location = glGetUniformLocation(id, name.c_str());
-        uniformLocations.try_emplace(name, location);
-        return location;
+/// @brief Interned uniform names, index is the handle index
+static std::vector<std::string>& uniform_names() {
+    static std::vector<std::string> names;
+    return names;
+}
+
+static std::unordered_map<std::string, uint>& uniform_indices() {
+    static std::unordered_map<std::string, uint> indices;
+    return indices;
+}
+
+Shader::Uniform::Uniform(const std::string& name) {
+    auto& indices = uniform_indices();
+    const auto& found = indices.find(name);
+    if (found != indices.end()) {
+        index = found->second;
+        return;
     }
-    return found->second;
+    auto& names = uniform_names();
+    index = names.size();
+    names.push_back(name);
+    indices[name] = index;
+}
+
+int Shader::getUniformLocation(Uniform uniform) {
+    if (uniform.index >= uniformLocations.size()) {
+        uniformLocations.resize(uniform.index + 1, UNKNOWN_LOCATION);
+    }
+    int& location = uniformLocations[uniform.index];
+    if (location == UNKNOWN_LOCATION) {
+        const auto& name = uniform_names()[uniform.index];
+        location = glGetUniformLocation(id, name.c_str());
+    }
+    return location;
 }
 
 void Shader::uniformMatrix(const std::string& name, glm::mat4 matrix){
-    glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(matrix));
+    uniformMatrix(Uniform(name), matrix);
 }
 
 void Shader::uniform1i(const std::string& name, int x){
-    glUniform1i(getUniformLocation(name), x);
+    uniform1i(Uniform(name), x);
 }
 
 void Shader::uniform1f(const std::string& name, float x){
-    glUniform1f(getUniformLocation(name), x);
+    uniform1f(Uniform(name), x);
 }
 
 void Shader::uniform2f(const std::string& name, float x, float y){
-    glUniform2f(getUniformLocation(name), x, y);
+    uniform2f(Uniform(name), glm::vec2(x, y));
 }
 
 void Shader::uniform2f(const std::string& name, glm::vec2 xy){
-    glUniform2f(getUniformLocation(name), xy.x, xy.y);
+    uniform2f(Uniform(name), xy);
 }
 
 void Shader::uniform2i(const std::string& name, glm::ivec2 xy){
-    glUniform2i(getUniformLocation(name), xy.x, xy.y);
+    glUniform2i(getUniformLocation(Uniform(name)), xy.x, xy.y);
 }
 
 void Shader::uniform3f(const std::string& name, float x, float y, float z){
-    glUniform3f(getUniformLocation(name), x,y,z);
+    uniform3f(Uniform(name), glm::vec3(x, y, z));
 }
 
 void Shader::uniform3f(const std::string& name, glm::vec3 xyz){
-    glUniform3f(getUniformLocation(name), xyz.x, xyz.y, xyz.z);
+    uniform3f(Uniform(name), xyz);
+}
+
+void Shader::uniform4f(const std::string& name, glm::vec4 xyzw) {
+    uniform4f(Uniform(name), xyzw);
+}
+
+void Shader::uniformMatrix(Uniform uniform, const glm::mat4& matrix) {
+    glUniformMatrix4fv(
+        getUniformLocation(uniform), 1, GL_FALSE, glm::value_ptr(matrix)
+    );
+}
+
+void Shader::uniform1i(Uniform uniform, int x) {
+    glUniform1i(getUniformLocation(uniform), x);
 }
 
+void Shader::uniform1f(Uniform uniform, float x) {
+    glUniform1f(getUniformLocation(uniform), x);
+}
+
+void Shader::uniform2f(Uniform uniform, glm::vec2 xy) {
+    glUniform2f(getUniformLocation(uniform), xy.x, xy.y);
+}
+
+void Shader::uniform3f(Uniform uniform, glm::vec3 xyz) {
+    glUniform3f(getUniformLocation(uniform), xyz.x, xyz.y, xyz.z);
+}
+
+void Shader::uniform4f(Uniform uniform, glm::vec4 xyzw) {
+    glUniform4f(
+        getUniformLocation(uniform), xyzw.x, xyzw.y, xyzw.z, xyzw.w
+    );
+}
 
 inline auto shader_deleter = [](GLuint* shader) {
     glDeleteShader(*shader);
@@ -98,6 +155,21 @@ glshader compile_shader(GLenum type, const GLchar* source, const std::string& fi
     return glshader(new GLuint(shader), shader_deleter); //-V508
 }
 
+/// @brief Uniform blocks binding is not kept by program binaries,
+/// so it is set for loaded binaries too
+static void bind_uniform_blocks(GLuint id) {
+    GLuint worldBlock = glGetUniformBlockIndex(id, "WorldUniforms");
+    if (worldBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(id, worldBlock, Shader::WORLD_UNIFORMS_BINDING);
+    }
+    GLuint animationBlock = glGetUniformBlockIndex(id, "AnimationUniforms");
+    if (animationBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(
+            id, animationBlock, Shader::ANIMATION_UNIFORMS_BINDING
+        );
+    }
+}
+
 std::unique_ptr<Shader> Shader::create(
     const std::string& vertexFile, 
     const std::string& fragmentFile,
@@ -115,6 +187,9 @@ std::unique_ptr<Shader> Shader::create(
     GLuint id = glCreateProgram();
     glAttachShader(id, *vertex);
     glAttachShader(id, *fragment);
+    if (isBinarySupported()) {
+        glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(id);
 
     glGetProgramiv(id, GL_LINK_STATUS, &success);
@@ -125,5 +200,59 @@ std::unique_ptr<Shader> Shader::create(
             "shader program linking failed:\n"+std::string(infoLog)
         );
     }
+    bind_uniform_blocks(id);
     return std::make_unique<Shader>(id);
 }
+
+std::unique_ptr<Shader> Shader::createFromBinary(
+    uint format, const ubyte* data, size_t size
+) {
+    GLuint id = glCreateProgram();
+    glProgramBinary(id, format, data, size);
+    GLint success;
+    glGetProgramiv(id, GL_LINK_STATUS, &success);
+    if (!success) {
+        // driver or hardware changed, the source will be compiled again
+        glDeleteProgram(id);
+        return nullptr;
+    }
+    bind_uniform_blocks(id);
+    return std::make_unique<Shader>(id);
+}
+
+bool Shader::getBinary(uint& format, std::vector<ubyte>& dst) const {
+    if (!isBinarySupported()) {
+        return false;
+    }
+    GLint length = 0;
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return false;
+    }
+    dst.resize(length);
+    GLenum binaryFormat;
+    glGetProgramBinary(id, length, &length, &binaryFormat, dst.data());
+    dst.resize(length);
+    format = binaryFormat;
+    return length > 0;
+}
+
+bool Shader::isBinarySupported() {
+    static bool supported = [] {
+        if (!GLEW_ARB_get_program_binary) {
+            return false;
+        }
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }();
+    return supported;
+}
+
+std::string Shader::getDriverName() {
+    auto str = [](GLenum name) {
+        auto value = reinterpret_cast<const char*>(glGetString(name));
+        return std::string(value ? value : "");
+    };
+    return str(GL_VENDOR) + ";" + str(GL_RENDERER) + ";" + str(GL_VERSION);
+}
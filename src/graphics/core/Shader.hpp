@@ -5,15 +5,36 @@
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 
 class GLSLExtension;
 
 class Shader {
+public:
+    /// @brief Interned uniform name. Uniform locations are cached in arrays
+    /// indexed by the handle, so hot paths keep static handles instead of
+    /// hashing name strings on every call
+    class Uniform {
+        uint index;
+        friend class Shader;
+    public:
+        explicit Uniform(const std::string& name);
+    };
+
+    /// @brief Uniform block binding point of the per-frame world state
+    /// (WorldUniforms block, see shaders/lib/world.glsl)
+    static inline constexpr uint WORLD_UNIFORMS_BINDING = 0;
+    /// @brief Uniform block binding point of the blocks texture animations
+    /// (AnimationUniforms block, see shaders/lib/animation.glsl)
+    static inline constexpr uint ANIMATION_UNIFORMS_BINDING = 1;
+private:
     uint id;
-    std::unordered_map<std::string, uint> uniformLocations;
-    
-    uint getUniformLocation(const std::string& name);
+    /// @brief Locations by uniform handle index, UNKNOWN if not queried yet
+    std::vector<int> uniformLocations;
+    static inline constexpr int UNKNOWN_LOCATION = -2;
+
+    int getUniformLocation(Uniform uniform);
 public:
     static GLSLExtension* preprocessor;
 
@@ -29,6 +50,14 @@ public:
     void uniform2i(const std::string& name, glm::ivec2 xy);
     void uniform3f(const std::string& name, float x, float y, float z);
     void uniform3f(const std::string& name, glm::vec3 xyz);
+    void uniform4f(const std::string& name, glm::vec4 xyzw);
+
+    void uniformMatrix(Uniform uniform, const glm::mat4& matrix);
+    void uniform1i(Uniform uniform, int x);
+    void uniform1f(Uniform uniform, float x);
+    void uniform2f(Uniform uniform, glm::vec2 xy);
+    void uniform3f(Uniform uniform, glm::vec3 xyz);
+    void uniform4f(Uniform uniform, glm::vec4 xyzw);
 
     /// @brief Create shader program using vertex and fragment shaders source.
     /// @param vertexFile vertex shader file name
@@ -42,4 +71,23 @@ public:
         const std::string& vertexSource, 
         const std::string& fragmentSource
     );
+
+    /// @brief Create shader program from a binary got by getBinary
+    /// @return nullptr if the binary is rejected by the driver
+    static std::unique_ptr<Shader> createFromBinary(
+        uint format, const ubyte* data, size_t size
+    );
+
+    /// @brief Get linked program binary
+    /// @param format destination binary format
+    /// @param dst destination binary
+    /// @return false if program binaries are not supported
+    bool getBinary(uint& format, std::vector<ubyte>& dst) const;
+
+    /// @brief Check if program binaries can be retrieved and loaded
+    static bool isBinarySupported();
+
+    /// @brief Get name of the driver program binaries are compatible with
+    /// (vendor, renderer and version)
+    static std::string getDriverName();
 };
@@ -0,0 +1,114 @@
+#include "StreamedTexture.hpp"
+
+#include "debug/Logger.hpp"
+#include "util/TaskScheduler.hpp"
+
+static debug::Logger logger("streamed-texture");
+
+StreamedTexture::StreamedTexture(
+    uint width,
+    uint height,
+    decoder decode,
+    std::shared_ptr<Texture> placeholder
+)
+    : Texture(width, height),
+      decode(std::move(decode)),
+      placeholder(std::move(placeholder)) {
+}
+
+StreamedTexture::~StreamedTexture() = default;
+
+void StreamedTexture::request() const {
+    requested = true;
+    auto promise = std::make_shared<std::promise<std::shared_ptr<ImageData>>>();
+    image = promise->get_future().share();
+    util::TaskScheduler::getDefault().submit(
+        [decode = decode, promise]() {
+            try {
+                promise->set_value(decode());
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        },
+        util::TaskScheduler::Priority::NORMAL
+    );
+}
+
+void StreamedTexture::upload() const {
+    try {
+        auto decoded = image.get();
+        texture = Texture::from(decoded.get());
+        texture->setMipMapping(mipmapping);
+    } catch (const std::exception& err) {
+        logger.error() << "could not load texture: " << err.what();
+        failed = true;
+    }
+    image = {};
+}
+
+Texture* StreamedTexture::poll() const {
+    if (texture || failed) {
+        return texture.get();
+    }
+    if (!requested) {
+        request();
+    }
+    if (image.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        upload();
+    }
+    return texture.get();
+}
+
+Texture* StreamedTexture::require() const {
+    if (texture || failed) {
+        return texture.get();
+    }
+    if (!requested) {
+        request();
+    }
+    upload();
+    return texture.get();
+}
+
+void StreamedTexture::bind() const {
+    if (auto loaded = poll()) {
+        loaded->bind();
+    } else {
+        placeholder->bind();
+    }
+}
+
+void StreamedTexture::unbind() const {
+    placeholder->unbind();
+}
+
+void StreamedTexture::reload(const ImageData& image) {
+    if (auto loaded = require()) {
+        loaded->reload(image);
+    } else {
+        texture = Texture::from(&image);
+        texture->setMipMapping(mipmapping);
+        failed = false;
+    }
+}
+
+std::unique_ptr<ImageData> StreamedTexture::readData() {
+    if (auto loaded = require()) {
+        return loaded->readData();
+    }
+    return placeholder->readData();
+}
+
+uint StreamedTexture::getId() const {
+    if (auto loaded = require()) {
+        return loaded->getId();
+    }
+    return placeholder->getId();
+}
+
+void StreamedTexture::setMipMapping(bool flag) {
+    mipmapping = flag;
+    if (texture) {
+        texture->setMipMapping(flag);
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+
+#include "Texture.hpp"
+
+/// @brief Texture decoded by a background job on the first use.
+/// Placeholder texture is bound until the image is decoded, then it's
+/// uploaded (with GPU-side mipmaps) in the main thread on the next bind
+class StreamedTexture : public Texture {
+public:
+    using decoder = std::function<std::unique_ptr<ImageData>()>;
+private:
+    decoder decode;
+    std::shared_ptr<Texture> placeholder;
+    bool mipmapping = true;
+    // loading state is changed on bind
+    mutable std::unique_ptr<Texture> texture;
+    mutable std::shared_future<std::shared_ptr<ImageData>> image;
+    mutable bool requested = false;
+    mutable bool failed = false;
+
+    void request() const;
+    void upload() const;
+    /// @return loaded texture or nullptr if not loaded yet
+    Texture* poll() const;
+    /// @brief Load texture waiting for the decoding job
+    /// @return nullptr if decoding failed
+    Texture* require() const;
+public:
+    /// @param width expected image width
+    /// @param height expected image height
+    /// @param decode image decoder called in a worker thread
+    /// @param placeholder texture bound while loading, may be shared
+    /// between textures
+    StreamedTexture(
+        uint width,
+        uint height,
+        decoder decode,
+        std::shared_ptr<Texture> placeholder
+    );
+    ~StreamedTexture();
+
+    /// @brief Bind loaded texture or placeholder. Starts loading on the
+    /// first call
+    void bind() const override;
+    void unbind() const override;
+
+    void reload(const ImageData& image) override;
+
+    /// @brief Read texture data, waits for loading
+    std::unique_ptr<ImageData> readData() override;
+
+    UVRegion getUVRegion() const override {
+        return UVRegion(0.0f, 0.0f, 1.0f, 1.0f);
+    }
+
+    /// @return expected width until loaded
+    uint getWidth() const override {
+        return texture ? texture->getWidth() : width;
+    }
+
+    /// @return expected height until loaded
+    uint getHeight() const override {
+        return texture ? texture->getHeight() : height;
+    }
+
+    /// @brief Get loaded texture id, waits for loading
+    uint getId() const override;
+
+    void setMipMapping(bool flag) override;
+
+    bool isLoaded() const {
+        return texture != nullptr;
+    }
+};
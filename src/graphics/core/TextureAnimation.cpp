@@ -3,7 +3,9 @@
 #include "Framebuffer.hpp"
 
 #include <GL/glew.h>
-#include <unordered_set>
+#include <algorithm>
+
+#include "util/LinearAllocator.hpp"
 
 TextureAnimator::TextureAnimator() {
     glGenFramebuffers(1, &fboR);
@@ -22,7 +24,7 @@ void TextureAnimator::addAnimations(const std::vector<TextureAnimation>& animati
 }
 
 void TextureAnimator::update(float delta) {
-    std::unordered_set<uint> changedTextures;
+    util::FrameVector<uint> changedTextures;
 
     for (auto& elem : animations) {
         elem.timer += delta;
@@ -38,7 +40,7 @@ void TextureAnimator::update(float delta) {
             uint elemDstId = elem.dstTexture->getId();
             uint elemSrcId = elem.srcTexture->getId();
 
-            changedTextures.insert(elemDstId);
+            changedTextures.push_back(elemDstId);
 
             glBindFramebuffer(GL_FRAMEBUFFER, fboD);
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, elemDstId, 0);
@@ -66,6 +68,11 @@ void TextureAnimator::update(float delta) {
         glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    std::sort(changedTextures.begin(), changedTextures.end());
+    changedTextures.erase(
+        std::unique(changedTextures.begin(), changedTextures.end()),
+        changedTextures.end()
+    );
     for (auto& elem : changedTextures) {
         glBindTexture(GL_TEXTURE_2D, elem);
         glGenerateMipmap(GL_TEXTURE_2D);
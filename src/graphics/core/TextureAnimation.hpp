@@ -1,11 +1,14 @@
 #pragma once
 
 #include "typedefs.hpp"
+#include "maths/UVRegion.hpp"
 
 #include <glm/glm.hpp>
+#include <string>
 #include <vector>
 
 class Assets;
+class Atlas;
 class Texture;
 class Framebuffer;
 
@@ -16,6 +19,8 @@ struct Frame {
     glm::ivec2 dstPos;
     glm::ivec2 size;
     float duration = DEFAULT_FRAME_DURATION;
+    /// @brief Frame region in the source atlas
+    UVRegion region;
 };
 
 class TextureAnimation {
@@ -30,6 +35,12 @@ public:
     Texture* srcTexture;
     Texture* dstTexture;
     std::vector<Frame> frames;
+    /// @brief Frames atlas, nullptr if frames are not taken from an atlas
+    const Atlas* srcAtlas = nullptr;
+    /// @brief Animated atlas, nullptr if the destination is not an atlas
+    const Atlas* dstAtlas = nullptr;
+    /// @brief Animated region name in the destination atlas
+    std::string dstRegion;
 };
 
 class TextureAnimator {
@@ -0,0 +1,93 @@
+#include "TextureArray.hpp"
+
+#include <GL/glew.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "ImageData.hpp"
+
+uint TextureArray::MAX_LAYERS = 256; // Window.initialize overrides it
+
+TextureArray::TextureArray(uint width, uint height, uint layers)
+    : width(width), height(height), layers(layers) {
+    if (layers > MAX_LAYERS) {
+        throw std::runtime_error(
+            "too many texture array layers: " + std::to_string(layers)
+        );
+    }
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+    glTexImage3D(
+        GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, width, height, layers, 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, nullptr
+    );
+    glTexParameteri(
+        GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST
+    );
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+TextureArray::~TextureArray() {
+    glDeleteTextures(1, &id);
+}
+
+void TextureArray::bind() const {
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+}
+
+void TextureArray::unbind() const {
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+/// @brief Nearest-neighbour scale of RGBA image
+static std::unique_ptr<ubyte[]> scale_image(
+    const ImageData& image, uint width, uint height
+) {
+    auto dst = std::make_unique<ubyte[]>(width * height * 4);
+    const ubyte* src = image.getData();
+    uint srcWidth = image.getWidth();
+    uint srcHeight = image.getHeight();
+    for (uint y = 0; y < height; y++) {
+        uint sy = y * srcHeight / height;
+        for (uint x = 0; x < width; x++) {
+            uint sx = x * srcWidth / width;
+            for (uint c = 0; c < 4; c++) {
+                dst[(y * width + x) * 4 + c] =
+                    src[(sy * srcWidth + sx) * 4 + c];
+            }
+        }
+    }
+    return dst;
+}
+
+void TextureArray::setLayer(uint layer, const ImageData& image) {
+    if (layer >= layers) {
+        throw std::out_of_range("texture array layer out of range");
+    }
+    if (image.getFormat() != ImageFormat::rgba8888) {
+        throw std::invalid_argument("RGBA image expected");
+    }
+    std::unique_ptr<ubyte[]> scaled;
+    const ubyte* data = image.getData();
+    if (image.getWidth() != width || image.getHeight() != height) {
+        scaled = scale_image(image, width, height);
+        data = scaled.get();
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(
+        GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1,
+        GL_RGBA, GL_UNSIGNED_BYTE, data
+    );
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::generateMipmaps() {
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "typedefs.hpp"
+
+class ImageData;
+
+/// @brief Array of same size 2D textures (GL_TEXTURE_2D_ARRAY).
+/// Layers are wrapped and mip-mapped separately, so unlike atlas regions
+/// they do not need padding and never bleed into each other
+class TextureArray {
+    uint id;
+    uint width;
+    uint height;
+    uint layers;
+public:
+    /// @brief Max number of layers, Window.initialize overrides it
+    static uint MAX_LAYERS;
+
+    TextureArray(uint width, uint height, uint layers);
+    ~TextureArray();
+
+    TextureArray(const TextureArray&) = delete;
+
+    void bind() const;
+    void unbind() const;
+
+    /// @brief Replace layer pixels, mipmaps must be regenerated after
+    /// @param image RGBA image, scaled to the layer size if differs
+    void setLayer(uint layer, const ImageData& image);
+
+    /// @brief Generate mipmaps of all layers
+    void generateMipmaps();
+
+    uint getWidth() const {
+        return width;
+    }
+
+    uint getHeight() const {
+        return height;
+    }
+
+    uint getLayers() const {
+        return layers;
+    }
+
+    uint getId() const {
+        return id;
+    }
+};
@@ -0,0 +1,116 @@
+#include "TextureCompression.hpp"
+
+#include <algorithm>
+#include <GL/glew.h>
+
+#include "GLTexture.hpp"
+#include "ImageData.hpp"
+
+using namespace texture_compression;
+
+/// @brief Mip levels count like uncompressed textures have
+/// (GL_TEXTURE_MAX_LEVEL 1). Compressed formats are not renderable so
+/// glGenerateMipmap can not be used
+static constexpr int MIP_LEVELS = 2;
+
+uint texture_compression::select_format() {
+    if (GLEW_ARB_texture_compression_bptc) {
+        return GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+    }
+    if (GLEW_EXT_texture_compression_s3tc) {
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+    return 0;
+}
+
+/// @brief Downscale rgba8888 image twice with a box filter
+static std::unique_ptr<ImageData> downscale(const ImageData& image) {
+    uint width = std::max(1U, image.getWidth() / 2);
+    uint height = std::max(1U, image.getHeight() / 2);
+    uint srcWidth = image.getWidth();
+    uint srcHeight = image.getHeight();
+    const ubyte* src = image.getData();
+    auto dst = std::make_unique<ImageData>(
+        ImageFormat::rgba8888, width, height
+    );
+    ubyte* data = dst->getData();
+    for (uint y = 0; y < height; y++) {
+        for (uint x = 0; x < width; x++) {
+            for (uint c = 0; c < 4; c++) {
+                uint sum = 0;
+                for (uint dy = 0; dy < 2; dy++) {
+                    for (uint dx = 0; dx < 2; dx++) {
+                        uint sx = std::min(x * 2 + dx, srcWidth - 1);
+                        uint sy = std::min(y * 2 + dy, srcHeight - 1);
+                        sum += src[(sy * srcWidth + sx) * 4 + c];
+                    }
+                }
+                data[(y * width + x) * 4 + c] = sum / 4;
+            }
+        }
+    }
+    return dst;
+}
+
+static void setup_parameters(int levels) {
+    glTexParameteri(
+        GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST
+    );
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+std::unique_ptr<Texture> texture_compression::compress(
+    const ImageData& image, uint format, CompressedImage& dst
+) {
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    dst = CompressedImage {format, image.getWidth(), image.getHeight(), {}};
+    std::unique_ptr<ImageData> level;
+    const ImageData* source = &image;
+    for (int i = 0; i < MIP_LEVELS; i++) {
+        if (i > 0) {
+            level = downscale(*source);
+            source = level.get();
+        }
+        glTexImage2D(
+            GL_TEXTURE_2D, i, format,
+            source->getWidth(), source->getHeight(), 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, source->getData()
+        );
+        GLint size = 0;
+        glGetTexLevelParameteriv(
+            GL_TEXTURE_2D, i, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size
+        );
+        auto& data = dst.levels.emplace_back(size);
+        glGetCompressedTexImage(GL_TEXTURE_2D, i, data.data());
+    }
+    setup_parameters(MIP_LEVELS);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return std::make_unique<GLTexture>(id, image.getWidth(), image.getHeight());
+}
+
+std::unique_ptr<Texture> texture_compression::upload(
+    const CompressedImage& image
+) {
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    uint width = image.width;
+    uint height = image.height;
+    for (size_t i = 0; i < image.levels.size(); i++) {
+        const auto& data = image.levels[i];
+        glCompressedTexImage2D(
+            GL_TEXTURE_2D, i, image.format, width, height, 0,
+            data.size(), data.data()
+        );
+        width = std::max(1U, width / 2);
+        height = std::max(1U, height / 2);
+    }
+    setup_parameters(image.levels.size());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return std::make_unique<GLTexture>(id, image.width, image.height);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "typedefs.hpp"
+
+class ImageData;
+class Texture;
+
+/// @brief GPU textures compression done by the driver on upload.
+/// Compressed data is read back to be cached and uploaded directly later
+namespace texture_compression {
+    struct CompressedImage {
+        /// @brief GL compressed internal format
+        uint format;
+        uint width;
+        uint height;
+        /// @brief Compressed data of mip levels
+        std::vector<std::vector<ubyte>> levels;
+    };
+
+    /// @brief Select the best supported compressed RGBA format:
+    /// BC7 (BPTC), then BC3 (S3TC DXT5)
+    /// @return GL internal format or 0 if not supported
+    uint select_format();
+
+    /// @brief Upload RGBA image with mipmap compressing it to the format
+    /// @param image rgba8888 image
+    /// @param format compressed format (see select_format)
+    /// @param dst compressed levels destination
+    std::unique_ptr<Texture> compress(
+        const ImageData& image, uint format, CompressedImage& dst
+    );
+
+    /// @brief Upload precompressed image
+    std::unique_ptr<Texture> upload(const CompressedImage& image);
+}
@@ -0,0 +1,24 @@
+#include "UniformBuffer.hpp"
+
+#include <GL/glew.h>
+
+UniformBuffer::UniformBuffer(size_t size) : size(size) {
+    glGenBuffers(1, &id);
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformBuffer::~UniformBuffer() {
+    glDeleteBuffers(1, &id);
+}
+
+void UniformBuffer::update(const void* data) {
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::bind(uint binding) const {
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, id);
+}
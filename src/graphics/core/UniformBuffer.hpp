@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdlib.h>
+
+#include "typedefs.hpp"
+
+/// @brief Uniform buffer object shared by shaders declaring the uniform
+/// block bound to the same binding point
+class UniformBuffer {
+    uint id;
+    size_t size;
+public:
+    /// @param size buffer size in bytes
+    UniformBuffer(size_t size);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+
+    /// @brief Replace buffer data
+    /// @param data at least size bytes following the block std140 layout
+    void update(const void* data);
+
+    /// @brief Bind the buffer to the uniform block binding point
+    void bind(uint binding) const;
+};
@@ -1,8 +1,11 @@
 #include "BlocksPreview.hpp"
 
 #include "assets/Assets.hpp"
+#include "coders/byte_utils.hpp"
 #include "constants.hpp"
 #include "content/Content.hpp"
+#include "debug/Logger.hpp"
+#include "files/files.hpp"
 #include "frontend/ContentGfxCache.hpp"
 #include "voxels/Block.hpp"
 #include "window/Camera.hpp"
@@ -11,21 +14,34 @@
 #include "graphics/core/Batch3D.hpp"
 #include "graphics/core/Framebuffer.hpp"
 #include "graphics/core/DrawContext.hpp"
+#include "graphics/core/ImageData.hpp"
 #include "graphics/core/Shader.hpp"
 #include "graphics/core/Texture.hpp"
 #include "graphics/core/Viewport.hpp"
 
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
 #include <glm/ext.hpp>
 
-std::unique_ptr<ImageData> BlocksPreview::draw(
+namespace fs = std::filesystem;
+
+static debug::Logger logger("blocks-preview");
+
+/// @brief Transparent pixels around each icon in the atlas
+static constexpr uint ICON_PADDING = 2;
+/// @brief Icons cache file format version
+static constexpr int PREVIEWS_CACHE_VERSION = 1;
+static const char PREVIEWS_CACHE_MAGIC[] = "VEICONS";
+static const char PREVIEWS_CACHE_FILE[] = "block-previews.bin";
+
+void BlocksPreview::draw(
     const ContentGfxCache& cache,
     Shader& shader,
-    const Framebuffer& fbo,
     Batch3D& batch,
     const Block& def, 
     int size
 ){
-    Window::clear();
     blockid_t id = def.rt.id;
     const UVRegion texfaces[6]{cache.getRegion(id, 0), cache.getRegion(id, 1),
                                cache.getRegion(id, 2), cache.getRegion(id, 3),
@@ -93,27 +109,167 @@ std::unique_ptr<ImageData> BlocksPreview::draw(
             break;
         }
     }
-    return fbo.getTexture()->readData();
+}
+
+/// @brief Hash of everything affecting the icons: blocks models,
+/// texture regions and the blocks atlas raster
+static uint64_t hash_previews_sources(
+    const ContentGfxCache& cache,
+    const Atlas& atlas,
+    const ContentIndices& indices
+) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto feed = [&hash](const void* data, size_t size) {
+        auto bytes = static_cast<const ubyte*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    };
+    int iconSize = ITEM_ICON_SIZE;
+    feed(&iconSize, sizeof(iconSize));
+    for (size_t i = 0; i < indices.blocks.count(); i++) {
+        const auto& def = indices.blocks.require(i);
+        feed(def.name.data(), def.name.size());
+        feed(&def.model, sizeof(def.model));
+        feed(&def.rt.emissive, sizeof(def.rt.emissive));
+        for (const auto& box : def.hitboxes) {
+            auto boxSize = box.size();
+            feed(&boxSize, sizeof(boxSize));
+        }
+        for (int side = 0; side < 6; side++) {
+            const auto& region = cache.getRegion(def.rt.id, side);
+            feed(&region, sizeof(region));
+        }
+        if (def.model == BlockModel::custom) {
+            for (const auto& mesh : cache.getModel(def.rt.id).meshes) {
+                feed(mesh.vertices.data(),
+                     mesh.vertices.size() * sizeof(model::Vertex));
+            }
+        }
+    }
+    const auto& image = *atlas.getImage();
+    const auto words = reinterpret_cast<const uint64_t*>(image.getData());
+    size_t wordsCount = static_cast<size_t>(image.getWidth()) *
+                        image.getHeight() * 4 / sizeof(uint64_t);
+    // word-wise mixing, the raster is large
+    for (size_t i = 0; i < wordsCount; i++) {
+        hash = (hash ^ words[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static std::unique_ptr<ImageData> read_previews_cache(
+    const fs::path& file, uint64_t key, uint width, uint height
+) {
+    if (!fs::is_regular_file(file)) {
+        return nullptr;
+    }
+    try {
+        auto bytes = files::read_bytes(file);
+        ByteReader reader(bytes.data(), bytes.size());
+        reader.checkMagic(PREVIEWS_CACHE_MAGIC, sizeof(PREVIEWS_CACHE_MAGIC));
+        if (reader.getInt32() != PREVIEWS_CACHE_VERSION ||
+            static_cast<uint64_t>(reader.getInt64()) != key ||
+            static_cast<uint>(reader.getInt32()) != width ||
+            static_cast<uint>(reader.getInt32()) != height) {
+            return nullptr;
+        }
+        size_t size = static_cast<size_t>(width) * height * 4;
+        if (size > reader.remaining()) {
+            throw std::runtime_error("unexpected end of file");
+        }
+        return std::make_unique<ImageData>(
+            ImageFormat::rgba8888, width, height, reader.pointer()
+        );
+    } catch (const std::runtime_error& err) {
+        logger.error() << "invalid icons cache " << file.u8string() << ": "
+                       << err.what();
+        return nullptr;
+    }
+}
+
+static void write_previews_cache(
+    const fs::path& file, uint64_t key, const ImageData& image
+) {
+    ByteBuilder builder;
+    builder.put(
+        reinterpret_cast<const ubyte*>(PREVIEWS_CACHE_MAGIC),
+        sizeof(PREVIEWS_CACHE_MAGIC)
+    );
+    builder.putInt32(PREVIEWS_CACHE_VERSION);
+    builder.putInt64(key);
+    builder.putInt32(image.getWidth());
+    builder.putInt32(image.getHeight());
+    builder.put(
+        image.getData(),
+        static_cast<size_t>(image.getWidth()) * image.getHeight() * 4
+    );
+    try {
+        fs::create_directories(file.parent_path());
+        files::write_bytes(file, builder.data(), builder.size());
+    } catch (const std::exception& err) {
+        logger.error() << "could not write icons cache: " << err.what();
+    }
 }
 
 std::unique_ptr<Atlas> BlocksPreview::build(
     const ContentGfxCache& cache,
     const Assets& assets, 
-    const ContentIndices& indices
+    const ContentIndices& indices,
+    const fs::path& cacheFolder
 ) {
     size_t count = indices.blocks.count();
-    size_t iconSize = ITEM_ICON_SIZE;
+    uint iconSize = ITEM_ICON_SIZE;
+
+    // icons are placed in a grid, so all of them are rendered
+    // to the single framebuffer and read back at once
+    uint cellSize = iconSize + ICON_PADDING * 2;
+    uint columns = std::max(1u, static_cast<uint>(std::ceil(std::sqrt(count))));
+    uint rows =
+        std::max(1u, static_cast<uint>((count + columns - 1) / columns));
+    uint width = columns * cellSize;
+    uint height = rows * cellSize;
+    if (width > Texture::MAX_RESOLUTION || height > Texture::MAX_RESOLUTION) {
+        throw std::runtime_error(
+            "max atlas resolution " + std::to_string(Texture::MAX_RESOLUTION) +
+            " exceeded"
+        );
+    }
+    std::unordered_map<std::string, UVRegion> regions;
+    float unitX = 1.0f / width;
+    float unitY = 1.0f / height;
+    for (size_t i = 0; i < count; i++) {
+        uint x = (i % columns) * cellSize + ICON_PADDING;
+        uint y = (i / columns) * cellSize + ICON_PADDING;
+        regions[indices.blocks.require(i).name] = UVRegion(
+            unitX * x,
+            unitY * y,
+            unitX * (x + iconSize),
+            unitY * (y + iconSize)
+        );
+    }
 
     auto& shader = assets.require<Shader>("ui3d");
     const auto& atlas = assets.require<Atlas>("blocks");
 
-    Viewport viewport(iconSize, iconSize);
+    // no raster to hash if the blocks atlas is compressed
+    bool cached = !cacheFolder.empty() && atlas.getImage();
+    uint64_t key = 0;
+    auto cacheFile = cacheFolder / fs::u8path(PREVIEWS_CACHE_FILE);
+    if (cached) {
+        key = hash_previews_sources(cache, atlas, indices);
+        if (auto image = read_previews_cache(cacheFile, key, width, height)) {
+            return std::make_unique<Atlas>(std::move(image), regions, true);
+        }
+    }
+
+    Viewport viewport(width, height);
     DrawContext pctx(nullptr, viewport, nullptr);
     DrawContext ctx = pctx.sub();
     ctx.setCullFace(true);
     ctx.setDepthTest(true);
 
-    Framebuffer fbo(iconSize, iconSize, true);
+    Framebuffer fbo(width, height, true);
     Batch3D batch(1024);
     batch.begin();
 
@@ -125,18 +281,28 @@ std::unique_ptr<Atlas> BlocksPreview::build(
                     glm::vec3(0.0f), 
                     glm::vec3(0, 1, 0)));
 
-    AtlasBuilder builder;
-    Window::viewport(0, 0, iconSize, iconSize);
     Window::setBgColor(glm::vec4(0.0f));
-    
     fbo.bind();
+    Window::viewport(0, 0, width, height);
+    Window::clear();
+    atlas.getTexture()->bind();
     for (size_t i = 0; i < count; i++) {
         auto& def = indices.blocks.require(i);
-        atlas.getTexture()->bind();
-        builder.add(def.name, draw(cache, shader, fbo, batch, def, iconSize));
+        // icon cell is selected with the viewport, icons do not overlap
+        Window::viewport(
+            (i % columns) * cellSize + ICON_PADDING,
+            (i / columns) * cellSize + ICON_PADDING,
+            iconSize,
+            iconSize
+        );
+        draw(cache, shader, batch, def, iconSize);
     }
+    auto image = fbo.getTexture()->readData();
     fbo.unbind();
 
     Window::viewport(0, 0, Window::width, Window::height);
-    return builder.build(2);
+    if (cached) {
+        write_previews_cache(cacheFile, key, *image);
+    }
+    return std::make_unique<Atlas>(std::move(image), regions, true);
 }
@@ -2,6 +2,7 @@
 
 #include "typedefs.hpp"
 
+#include <filesystem>
 #include <glm/glm.hpp>
 #include <memory>
 
@@ -16,18 +17,22 @@ class Shader;
 class ContentGfxCache;
 
 class BlocksPreview {
-    static std::unique_ptr<ImageData> draw(
+    static void draw(
         const ContentGfxCache& cache,
         Shader& shader,
-        const Framebuffer& framebuffer,
         Batch3D& batch,
         const Block& block, 
         int size
     );
 public:
+    /// @brief Render blocks icons atlas. Icons are rendered in a single
+    /// framebuffer pass
+    /// @param cacheFolder folder of the icons cache keyed by blocks models
+    /// and textures hash, empty path disables caching
     static std::unique_ptr<Atlas> build(
         const ContentGfxCache& cache,
         const Assets& assets, 
-        const ContentIndices& indices
+        const ContentIndices& indices,
+        const std::filesystem::path& cacheFolder = {}
     );
 };
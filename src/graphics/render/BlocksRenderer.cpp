@@ -1,28 +1,70 @@
 #include "BlocksRenderer.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include "graphics/core/Mesh.hpp"
 #include "graphics/commons/Model.hpp"
 #include "maths/UVRegion.hpp"
 #include "constants.hpp"
 #include "content/Content.hpp"
-#include "voxels/Chunks.hpp"
+#include "voxels/ChunksSnapshot.hpp"
 #include "lighting/Lightmap.hpp"
 #include "frontend/ContentGfxCache.hpp"
+#include "util/ObjectPool.hpp"
+
+/// @brief Vertices capacity of new buffers
+static constexpr size_t INITIAL_VERTEX_CAPACITY = 4096;
+/// @brief Max vertices capacity of buffers kept in the pool, larger ones
+/// are released to not keep memory taken by rare complex chunks
+static constexpr size_t RETAINED_VERTEX_CAPACITY = 65536;
+/// @brief Max number of unused buffers kept in the pool
+static constexpr size_t MAX_FREE_BUFFERS = 16;
+
+struct MeshBuffers {
+    std::unique_ptr<float[]> vertices;
+    std::unique_ptr<int[]> indices;
+    size_t vertexCapacity = 0;
+    size_t indexCapacity = 0;
+
+    void reset() {
+    }
+};
+
+/// @brief Buffers shared by all renderers, so memory depends on the number
+/// of chunks being built at once and actual meshes sizes
+static util::ObjectPool<MeshBuffers> buffers_pool(MAX_FREE_BUFFERS);
+
+/// @brief Reallocate array keeping first `used` elements
+/// @return new array capacity
+template <typename T>
+static size_t grow_array(
+    std::unique_ptr<T[]>& array, size_t capacity, size_t used, size_t required
+) {
+    if (required <= capacity) {
+        return capacity;
+    }
+    capacity = std::max(capacity * 2, required);
+    auto newArray = std::unique_ptr<T[]>(new T[capacity]);
+    if (used) {
+        std::memcpy(newArray.get(), array.get(), used * sizeof(T));
+    }
+    array = std::move(newArray);
+    return capacity;
+}
 
 const glm::vec3 BlocksRenderer::SUN_VECTOR (0.411934f, 0.863868f, -0.279161f);
 
 BlocksRenderer::BlocksRenderer(
-    size_t capacity,
+    size_t maxVertices,
     const Content& content,
     const ContentGfxCache& cache,
     const EngineSettings& settings
 ) : content(content),
-    vertexBuffer(std::make_unique<float[]>(capacity * CHUNK_VERTEX_SIZE)),
-    indexBuffer(std::make_unique<int[]>(capacity)),
     vertexOffset(0),
     indexOffset(0),
     indexSize(0),
-    capacity(capacity),
+    maxVertices(maxVertices),
     cache(cache),
     settings(settings) 
 {
@@ -31,33 +73,155 @@ BlocksRenderer::BlocksRenderer(
         CHUNK_H, 
         CHUNK_D + voxelBufferPadding*2);
     blockDefsCache = content.getIndices()->blocks.getDefs();
+    blocksProps = &content.getIndices()->blocksProps;
+    blocksCount = content.getIndices()->blocks.count();
+
+    // block hides faces of blocks of the same or of the default draw group
+    const auto& drawGroups = *content.drawGroups;
+    occluders = std::make_unique<uint8_t[]>(drawGroups.size() * blocksCount);
+    ubyte groupIndex = 0;
+    for (ubyte drawGroup : drawGroups) {
+        drawGroupIndices[drawGroup] = groupIndex;
+        uint8_t* table = occluders.get() + groupIndex * blocksCount;
+        for (size_t id = 1; id < blocksCount; id++) {
+            ubyte group = blocksProps->drawGroup[id];
+            table[id] = blocksProps->solid[id] &&
+                        (group == 0 || group == drawGroup);
+        }
+        groupIndex++;
+    }
 }
 
 BlocksRenderer::~BlocksRenderer() {
 }
 
+bool BlocksRenderer::grow(size_t vertices) {
+    if (vertexOffset / CHUNK_VERTEX_SIZE + vertices > maxVertices) {
+        overflow = true;
+        return false;
+    }
+    if (buffers == nullptr) {
+        buffers = buffers_pool.get();
+    }
+    auto& dst = *buffers;
+    size_t minVertices = std::max(INITIAL_VERTEX_CAPACITY, vertices);
+    dst.vertexCapacity = grow_array(
+        dst.vertices,
+        dst.vertexCapacity,
+        vertexOffset,
+        std::max(
+            vertexOffset + vertices * CHUNK_VERTEX_SIZE,
+            minVertices * CHUNK_VERTEX_SIZE
+        )
+    );
+    dst.indexCapacity = grow_array(
+        dst.indices,
+        dst.indexCapacity,
+        indexSize,
+        std::max(indexSize + vertices * 3 / 2, minVertices * 3 / 2)
+    );
+    vertexBuffer = dst.vertices.get();
+    indexBuffer = dst.indices.get();
+    vertexCapacity = dst.vertexCapacity;
+    indexCapacity = dst.indexCapacity;
+    return true;
+}
+
+void BlocksRenderer::releaseBuffers() {
+    if (buffers &&
+        buffers->vertexCapacity > RETAINED_VERTEX_CAPACITY * CHUNK_VERTEX_SIZE) {
+        *buffers = {};
+    }
+    buffers = nullptr;
+    vertexBuffer = nullptr;
+    indexBuffer = nullptr;
+    vertexCapacity = indexCapacity = 0;
+}
+
+union packed_float {
+    float floating;
+    uint32_t integer;
+};
+
+static inline uint32_t compress_channel(float value) {
+    return std::min(static_cast<uint32_t>(std::round(value * 15)), 15U);
+}
+
+/// @brief Pack light to 4 bits per channel
+static inline uint32_t compress_light(const glm::vec4& light) {
+    return (compress_channel(light.r) << 12) |
+           (compress_channel(light.g) << 8) |
+           (compress_channel(light.b) << 4) |
+           compress_channel(light.a);
+}
+
+/// @brief Pack coordinate to 16 bit fixed point
+static inline uint32_t pack_coord(float value) {
+    float packed = std::round(
+        (value + CHUNK_VERTEX_POS_OFFSET) * CHUNK_VERTEX_POS_SCALE
+    );
+    return static_cast<uint32_t>(std::clamp(packed, 0.0f, 65535.0f));
+}
+
+static inline float unpack_coord(uint32_t packed) {
+    return packed / CHUNK_VERTEX_POS_SCALE - CHUNK_VERTEX_POS_OFFSET;
+}
+
+/// @brief Pack region-local texture coordinate to 10 bit fixed point
+static inline uint32_t pack_uv(float value) {
+    float packed = std::round(value * CHUNK_VERTEX_UV_SCALE);
+    return static_cast<uint32_t>(std::clamp(packed, 0.0f, 1023.0f));
+}
+
+/// @brief Get position of the packed vertex
+static inline glm::vec3 unpack_position(const float* vertex) {
+    packed_float xz {vertex[0]};
+    packed_float yl {vertex[1]};
+    return glm::vec3(
+        unpack_coord(xz.integer & 0xFFFF),
+        unpack_coord(yl.integer >> 16),
+        unpack_coord(xz.integer >> 16)
+    );
+}
+
+/// @brief Get side index (FACE_MX..FACE_PZ) of the unit axis direction
+static inline uint face_side(const glm::ivec3& dir) {
+    if (dir.x) {
+        return dir.x > 0 ? FACE_PX : FACE_MX;
+    }
+    if (dir.y) {
+        return dir.y > 0 ? FACE_PY : FACE_MY;
+    }
+    return dir.z > 0 ? FACE_PZ : FACE_MZ;
+}
+
+static inline bool is_open(uint openFaces, const glm::ivec3& dir) {
+    return (openFaces >> face_side(dir)) & 1;
+}
+
 /// Basic vertex add method
 void BlocksRenderer::vertex(
-    const glm::vec3& coord, float u, float v, const glm::vec4& light
+    const glm::vec3& coord, float u, float v, uint32_t light, uint region
 ) {
-    vertexBuffer[vertexOffset++] = coord.x;
-    vertexBuffer[vertexOffset++] = coord.y;
-    vertexBuffer[vertexOffset++] = coord.z;
+    packed_float packed;
+    packed.integer = pack_coord(coord.x) | (pack_coord(coord.z) << 16);
+    vertexBuffer[vertexOffset++] = packed.floating;
 
-    vertexBuffer[vertexOffset++] = u;
-    vertexBuffer[vertexOffset++] = v;
+    packed.integer = (pack_coord(coord.y) << 16) | light;
+    vertexBuffer[vertexOffset++] = packed.floating;
 
-    union {
-        float floating;
-        uint32_t integer;
-    } compressed;
-
-    compressed.integer = (static_cast<uint32_t>(light.r * 255) & 0xff) << 24;
-    compressed.integer |= (static_cast<uint32_t>(light.g * 255) & 0xff) << 16;
-    compressed.integer |= (static_cast<uint32_t>(light.b * 255) & 0xff) << 8;
-    compressed.integer |= (static_cast<uint32_t>(light.a * 255) & 0xff);
+    packed.integer = (region << 20) | (pack_uv(u) << 10) | pack_uv(v);
+    vertexBuffer[vertexOffset++] = packed.floating;
+}
 
-    vertexBuffer[vertexOffset++] = compressed.floating;
+void BlocksRenderer::vertex(
+    const glm::vec3& coord,
+    float u,
+    float v,
+    const glm::vec4& light,
+    uint region
+) {
+    vertex(coord, u, v, compress_light(light), region);
 }
 
 void BlocksRenderer::index(int a, int b, int c, int d, int e, int f) {
@@ -77,28 +241,27 @@ void BlocksRenderer::face(
     const glm::vec3& axisX,
     const glm::vec3& axisY,
     const glm::vec3& axisZ,
-    const UVRegion& region,
+    uint region,
     const glm::vec4(&lights)[4],
     const glm::vec4& tint
 ) {
-    if (vertexOffset + CHUNK_VERTEX_SIZE * 4 > capacity) {
-        overflow = true;
+    if (!reserve(4)) {
         return;
     }
     auto X = axisX * w;
     auto Y = axisY * h;
     auto Z = axisZ * d;
     float s = 0.5f;
-    vertex(coord + (-X - Y + Z) * s, region.u1, region.v1, lights[0] * tint);
-    vertex(coord + ( X - Y + Z) * s, region.u2, region.v1, lights[1] * tint);
-    vertex(coord + ( X + Y + Z) * s, region.u2, region.v2, lights[2] * tint);
-    vertex(coord + (-X + Y + Z) * s, region.u1, region.v2, lights[3] * tint);
+    vertex(coord + (-X - Y + Z) * s, 0.0f, 0.0f, lights[0] * tint, region);
+    vertex(coord + ( X - Y + Z) * s, 1.0f, 0.0f, lights[1] * tint, region);
+    vertex(coord + ( X + Y + Z) * s, 1.0f, 1.0f, lights[2] * tint, region);
+    vertex(coord + (-X + Y + Z) * s, 0.0f, 1.0f, lights[3] * tint, region);
     index(0, 1, 3, 1, 2, 3);
 }
 
 void BlocksRenderer::vertexAO(
     const glm::vec3& coord, 
-    float u, float v,
+    float u, float v, uint region,
     const glm::vec4& tint,
     const glm::vec3& axisX,
     const glm::vec3& axisY,
@@ -110,7 +273,7 @@ void BlocksRenderer::vertexAO(
         axisX,
         axisY
     );
-    vertex(coord, u, v, light * tint);
+    vertex(coord, u, v, light * tint, region);
 }
 
 void BlocksRenderer::faceAO(
@@ -118,11 +281,10 @@ void BlocksRenderer::faceAO(
     const glm::vec3& X,
     const glm::vec3& Y,
     const glm::vec3& Z,
-    const UVRegion& region,
+    uint region,
     bool lights
 ) {
-    if (vertexOffset + CHUNK_VERTEX_SIZE * 4 > capacity) {
-        overflow = true;
+    if (!reserve(4)) {
         return;
     }
 
@@ -136,16 +298,16 @@ void BlocksRenderer::faceAO(
         auto axisZ = glm::normalize(Z);
 
         glm::vec4 tint(d);
-        vertexAO(coord + (-X - Y + Z) * s, region.u1, region.v1, tint, axisX, axisY, axisZ);
-        vertexAO(coord + ( X - Y + Z) * s, region.u2, region.v1, tint, axisX, axisY, axisZ);
-        vertexAO(coord + ( X + Y + Z) * s, region.u2, region.v2, tint, axisX, axisY, axisZ);
-        vertexAO(coord + (-X + Y + Z) * s, region.u1, region.v2, tint, axisX, axisY, axisZ);
+        vertexAO(coord + (-X - Y + Z) * s, 0.0f, 0.0f, region, tint, axisX, axisY, axisZ);
+        vertexAO(coord + ( X - Y + Z) * s, 1.0f, 0.0f, region, tint, axisX, axisY, axisZ);
+        vertexAO(coord + ( X + Y + Z) * s, 1.0f, 1.0f, region, tint, axisX, axisY, axisZ);
+        vertexAO(coord + (-X + Y + Z) * s, 0.0f, 1.0f, region, tint, axisX, axisY, axisZ);
     } else {
         glm::vec4 tint(1.0f);
-        vertex(coord + (-X - Y + Z) * s, region.u1, region.v1, tint);
-        vertex(coord + ( X - Y + Z) * s, region.u2, region.v1, tint);
-        vertex(coord + ( X + Y + Z) * s, region.u2, region.v2, tint);
-        vertex(coord + (-X + Y + Z) * s, region.u1, region.v2, tint);
+        vertex(coord + (-X - Y + Z) * s, 0.0f, 0.0f, tint, region);
+        vertex(coord + ( X - Y + Z) * s, 1.0f, 0.0f, tint, region);
+        vertex(coord + ( X + Y + Z) * s, 1.0f, 1.0f, tint, region);
+        vertex(coord + (-X + Y + Z) * s, 0.0f, 1.0f, tint, region);
     }
     index(0, 1, 2, 0, 2, 3);
 }
@@ -155,12 +317,11 @@ void BlocksRenderer::face(
     const glm::vec3& X,
     const glm::vec3& Y,
     const glm::vec3& Z,
-    const UVRegion& region,
+    uint region,
     glm::vec4 tint,
     bool lights
 ) {
-    if (vertexOffset + CHUNK_VERTEX_SIZE * 4 > capacity) {
-        overflow = true;
+    if (!reserve(4)) {
         return;
     }
 
@@ -170,18 +331,18 @@ void BlocksRenderer::face(
         d = 0.8f + d * 0.2f;
         tint *= d;
     }
-    vertex(coord + (-X - Y + Z) * s, region.u1, region.v1, tint);
-    vertex(coord + ( X - Y + Z) * s, region.u2, region.v1, tint);
-    vertex(coord + ( X + Y + Z) * s, region.u2, region.v2, tint);
-    vertex(coord + (-X + Y + Z) * s, region.u1, region.v2, tint);
+    vertex(coord + (-X - Y + Z) * s, 0.0f, 0.0f, tint, region);
+    vertex(coord + ( X - Y + Z) * s, 1.0f, 0.0f, tint, region);
+    vertex(coord + ( X + Y + Z) * s, 1.0f, 1.0f, tint, region);
+    vertex(coord + (-X + Y + Z) * s, 0.0f, 1.0f, tint, region);
     index(0, 1, 2, 0, 2, 3);
 }
 
 void BlocksRenderer::blockXSprite(
     int x, int y, int z, 
     const glm::vec3& size, 
-    const UVRegion& texface1, 
-    const UVRegion& texface2, 
+    uint texface1, 
+    uint texface2, 
     float spread
 ) {
     glm::vec4 lights[] {
@@ -215,117 +376,74 @@ void BlocksRenderer::blockXSprite(
 /// @brief AABB blocks render method
 void BlocksRenderer::blockAABB(
     const glm::ivec3& icoord,
-    const UVRegion(&texfaces)[6], 
+    const uint(&texfaces)[6], 
     const Block* block, 
     ubyte rotation,
     bool lights,
     bool ao
 ) {
-    if (block->hitboxes.empty()) {
+    const auto& box = cache.getBakedBox(
+        block->rt.id, block->rotatable ? rotation : 0
+    );
+    if (!box.visible) {
         return;
     }
-    AABB hitbox = block->hitboxes[0];
-    for (const auto& box : block->hitboxes) {
-        hitbox.a = glm::min(hitbox.a, box.a);
-        hitbox.b = glm::max(hitbox.b, box.b);
-    }
-    auto size = hitbox.size();
-    glm::vec3 X(1, 0, 0);
-    glm::vec3 Y(0, 1, 0);
-    glm::vec3 Z(0, 0, 1);
-    glm::vec3 coord(icoord);
-    if (block->rotatable) {
-        auto& rotations = block->rotations;
-        auto& orient = rotations.variants[rotation];
-        X = orient.axisX;
-        Y = orient.axisY;
-        Z = orient.axisZ;
-        orient.transform(hitbox);
-    }
-    coord -= glm::vec3(0.5f) - hitbox.center();
-    
+    glm::vec3 coord = glm::vec3(icoord) + box.offset;
     if (ao) {
-        faceAO(coord,  X*size.x,  Y*size.y,  Z*size.z, texfaces[5], lights); // north
-        faceAO(coord, -X*size.x,  Y*size.y, -Z*size.z, texfaces[4], lights); // south
-
-        faceAO(coord,  X*size.x, -Z*size.z,  Y*size.y, texfaces[3], lights); // top
-        faceAO(coord, -X*size.x, -Z*size.z, -Y*size.y, texfaces[2], lights); // bottom
-
-        faceAO(coord, -Z*size.z,  Y*size.y,  X*size.x, texfaces[1], lights); // west
-        faceAO(coord,  Z*size.z,  Y*size.y, -X*size.x, texfaces[0], lights); // east
+        for (const auto& face : box.faces) {
+            faceAO(coord, face.X, face.Y, face.Z, texfaces[face.side], lights);
+        }
     } else {
         auto tint = pickLight(icoord);
-        face(coord,  X*size.x,  Y*size.y,  Z*size.z, texfaces[5], tint, lights); // north
-        face(coord, -X*size.x,  Y*size.y, -Z*size.z, texfaces[4], tint, lights); // south
-
-        face(coord,  X*size.x, -Z*size.z,  Y*size.y, texfaces[3], tint, lights); // top
-        face(coord, -X*size.x, -Z*size.z, -Y*size.y, texfaces[2], tint, lights); // bottom
-
-        face(coord, -Z*size.z,  Y*size.y,  X*size.x, texfaces[1], tint, lights); // west
-        face(coord,  Z*size.z,  Y*size.y, -X*size.x, texfaces[0], tint, lights); // east
+        for (const auto& face : box.faces) {
+            this->face(
+                coord, face.X, face.Y, face.Z, texfaces[face.side], tint, lights
+            );
+        }
     }
 }
 
 void BlocksRenderer::blockCustomModel(
     const glm::ivec3& icoord, const Block* block, ubyte rotation, bool lights, bool ao
 ) {
-    glm::vec3 X(1, 0, 0);
-    glm::vec3 Y(0, 1, 0);
-    glm::vec3 Z(0, 0, 1);
-    CoordSystem orient(X,Y,Z);
-    glm::vec3 coord(icoord);
-    if (block->rotatable) {
-        auto& rotations = block->rotations;
-        orient = rotations.variants[rotation];
-        X = orient.axisX;
-        Y = orient.axisY;
-        Z = orient.axisZ;
+    const auto& vertices = cache.getBakedModel(
+        block->rt.id, block->rotatable ? rotation : 0
+    );
+    if (!reserve(vertices.size())) {
+        return;
     }
-
-    const auto& model = cache.getModel(block->rt.id);
-    for (const auto& mesh : model.meshes) {
-        if (vertexOffset + CHUNK_VERTEX_SIZE * mesh.vertices.size() > capacity) {
-            overflow = true;
-            return;
-        }
-        for (int triangle = 0; triangle < mesh.vertices.size() / 3; triangle++) {
-            auto r = mesh.vertices[triangle * 3 + (triangle % 2) * 2].coord -
-                     mesh.vertices[triangle * 3 + 1].coord;
-            r = glm::normalize(r);
-
-            for (int i = 0; i < 3; i++) {
-                const auto& vertex = mesh.vertices[triangle * 3 + i];
-                auto n = vertex.normal.x * X + vertex.normal.y * Y +
-                         vertex.normal.z * Z;
-                float d = glm::dot(n, SUN_VECTOR);
-                d = 0.8f + d * 0.2f;
-                const auto& vcoord = vertex.coord - 0.5f;
-                vertexAO(
-                    coord + vcoord.x * X + vcoord.y * Y + vcoord.z * Z,
-                    vertex.uv.x,
-                    vertex.uv.y,
-                    glm::vec4(d, d, d, d),
-                    glm::cross(r, n),
-                    r,
-                    n
-                );
-                indexBuffer[indexSize++] = indexOffset++;
-            }
-        }
+    glm::vec3 coord(icoord);
+    for (const auto& baked : vertices) {
+        auto point = coord + baked.lightPoint;
+        auto light = pickSoftLight(
+            glm::ivec3(
+                std::round(point.x), std::round(point.y), std::round(point.z)
+            ),
+            baked.lightRight,
+            baked.lightUp
+        );
+        float d = 0.8f + glm::dot(baked.normal, SUN_VECTOR) * 0.2f;
+        vertex(
+            coord + baked.position,
+            baked.uv.x,
+            baked.uv.y,
+            light * glm::vec4(d),
+            baked.region
+        );
+        indexBuffer[indexSize++] = indexOffset++;
     }
 }
 
 /* Fastest solid shaded blocks render method */
 void BlocksRenderer::blockCube(
     const glm::ivec3& coord, 
-    const UVRegion(&texfaces)[6], 
+    const uint(&texfaces)[6], 
     const Block& block, 
     blockstate states,
     bool lights,
-    bool ao
+    bool ao,
+    uint openFaces
 ) {
-    ubyte group = block.drawGroup;
-
     glm::ivec3 X(1, 0, 0);
     glm::ivec3 Y(0, 1, 0);
     glm::ivec3 Z(0, 0, 1);
@@ -339,46 +457,276 @@ void BlocksRenderer::blockCube(
     }
     
     if (ao) {
-        if (isOpen(coord + Z, block)) {
+        if (is_open(openFaces, Z)) {
             faceAO(coord, X, Y, Z, texfaces[5], lights);
         }
-        if (isOpen(coord - Z, block)) {
+        if (is_open(openFaces, -Z)) {
             faceAO(coord, -X, Y, -Z, texfaces[4], lights);
         }
-        if (isOpen(coord + Y, block)) {
+        if (is_open(openFaces, Y)) {
             faceAO(coord, X, -Z, Y, texfaces[3], lights);
         }
-        if (isOpen(coord - Y, block)) {
+        if (is_open(openFaces, -Y)) {
             faceAO(coord, X, Z, -Y, texfaces[2], lights);
         }
-        if (isOpen(coord + X, block)) {
+        if (is_open(openFaces, X)) {
             faceAO(coord, -Z, Y, X, texfaces[1], lights);
         }
-        if (isOpen(coord - X, block)) {
+        if (is_open(openFaces, -X)) {
             faceAO(coord, Z, Y, -X, texfaces[0], lights);
         }
     } else {
-        if (isOpen(coord + Z, block)) {
+        if (is_open(openFaces, Z)) {
             face(coord, X, Y, Z, texfaces[5], pickLight(coord + Z), lights);
         }
-        if (isOpen(coord - Z, block)) {
+        if (is_open(openFaces, -Z)) {
             face(coord, -X, Y, -Z, texfaces[4], pickLight(coord - Z), lights);
         }
-        if (isOpen(coord + Y, block)) {
+        if (is_open(openFaces, Y)) {
             face(coord, X, -Z, Y, texfaces[3], pickLight(coord + Y), lights);
         }
-        if (isOpen(coord - Y, block)) {
+        if (is_open(openFaces, -Y)) {
             face(coord, X, Z, -Y, texfaces[2], pickLight(coord - Y), lights);
         }
-        if (isOpen(coord + X, block)) {
+        if (is_open(openFaces, X)) {
             face(coord, -Z, Y, X, texfaces[1], pickLight(coord + X), lights);
         }
-        if (isOpen(coord - X, block)) {
+        if (is_open(openFaces, -X)) {
             face(coord, Z, Y, -X, texfaces[0], pickLight(coord - X), lights);
         }
     }
 }
 
+/// @brief Plain cube face axes in blockCube order and texture face index
+struct CubeFace {
+    glm::ivec3 X, Y, Z;
+    int side;
+};
+
+static const CubeFace CUBE_FACES[6] {
+    {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, 5},   // north
+    {{-1, 0, 0}, {0, 1, 0}, {0, 0, -1}, 4}, // south
+    {{1, 0, 0}, {0, 0, -1}, {0, 1, 0}, 3},  // top
+    {{1, 0, 0}, {0, 0, 1}, {0, -1, 0}, 2},  // bottom
+    {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}, 1},  // west
+    {{0, 0, 1}, {0, 1, 0}, {-1, 0, 0}, 0},  // east
+};
+
+static inline int axis_index(const glm::ivec3& axis) {
+    return axis.x ? 0 : (axis.y ? 1 : 2);
+}
+
+bool BlocksRenderer::pickFaceLight(
+    const glm::ivec3& coord,
+    const glm::ivec3& X,
+    const glm::ivec3& Y,
+    const glm::ivec3& Z,
+    bool lights,
+    bool ao,
+    glm::vec4& light
+) const {
+    float d = glm::dot(glm::vec3(Z), SUN_VECTOR);
+    d = 0.8f + d * 0.2f;
+    if (!ao) {
+        light = pickLight(coord + Z) * (lights ? d : 1.0f);
+        return true;
+    }
+    if (!lights) {
+        light = glm::vec4(1.0f);
+        return true;
+    }
+    // same corners as picked by faceAO
+    auto pos = coord + Z;
+    light = pickSoftLight(pos, X, Y) * d;
+    uint32_t compressed = compress_light(light);
+    return compress_light(pickSoftLight(pos + X, X, Y) * d) == compressed &&
+           compress_light(pickSoftLight(pos + X + Y, X, Y) * d) == compressed &&
+           compress_light(pickSoftLight(pos + Y, X, Y) * d) == compressed;
+}
+
+void BlocksRenderer::blockCubeGreedy(
+    const glm::ivec3& coord,
+    const uint(&texfaces)[6],
+    const Block& block,
+    bool lights,
+    bool ao,
+    uint openFaces
+) {
+    size_t index = vox_index(coord.x, coord.y, coord.z) * 6;
+    for (int i = 0; i < 6; i++) {
+        const auto& face = CUBE_FACES[i];
+        if (!is_open(openFaces, face.Z)) {
+            continue;
+        }
+        glm::vec4 light;
+        if (!pickFaceLight(coord, face.X, face.Y, face.Z, lights, ao, light)) {
+            faceAO(coord, face.X, face.Y, face.Z, texfaces[face.side], lights);
+            continue;
+        }
+        greedyFaces[index + i] =
+            (static_cast<uint64_t>(block.rt.id) << 32) | compress_light(light);
+    }
+}
+
+void BlocksRenderer::greedyQuad(
+    int faceIndex, const glm::ivec3& pos, const glm::ivec3& max
+) {
+    const auto& face = CUBE_FACES[faceIndex];
+    int axisA = axis_index(face.X);
+    int axisB = axis_index(face.Y);
+    auto faceAt = [this, faceIndex](const glm::ivec3& pos) -> uint64_t& {
+        return greedyFaces[vox_index(pos.x, pos.y, pos.z) * 6 + faceIndex];
+    };
+    uint64_t key = faceAt(pos);
+
+    glm::ivec3 next = pos;
+    int width = 1;
+    for (next[axisA]++; next[axisA] < max[axisA] && width < CHUNK_MAX_TILES;
+         next[axisA]++) {
+        if (faceAt(next) != key) {
+            break;
+        }
+        width++;
+    }
+    int height = 1;
+    next = pos;
+    for (next[axisB]++; next[axisB] < max[axisB] && height < CHUNK_MAX_TILES;
+         next[axisB]++) {
+        for (next[axisA] = pos[axisA]; next[axisA] < pos[axisA] + width;
+             next[axisA]++) {
+            if (faceAt(next) != key) {
+                break;
+            }
+        }
+        if (next[axisA] < pos[axisA] + width) {
+            break;
+        }
+        height++;
+    }
+    for (next[axisB] = pos[axisB]; next[axisB] < pos[axisB] + height;
+         next[axisB]++) {
+        for (next[axisA] = pos[axisA]; next[axisA] < pos[axisA] + width;
+             next[axisA]++) {
+            faceAt(next) = 0;
+        }
+    }
+    if (!reserve(4)) {
+        return;
+    }
+    // center of the merged faces
+    glm::vec3 coord(pos);
+    coord[axisA] += (width - 1) * 0.5f;
+    coord[axisB] += (height - 1) * 0.5f;
+
+    uint region = cache.getRegionIndex(key >> 32, face.side);
+    uint32_t light = static_cast<uint32_t>(key);
+    float tu = width;
+    float tv = height;
+
+    auto X = glm::vec3(face.X) * tu;
+    auto Y = glm::vec3(face.Y) * tv;
+    auto Z = glm::vec3(face.Z);
+    float s = 0.5f;
+    vertex(coord + (-X - Y + Z) * s, 0.0f, 0.0f, light, region);
+    vertex(coord + ( X - Y + Z) * s, tu, 0.0f, light, region);
+    vertex(coord + ( X + Y + Z) * s, tu, tv, light, region);
+    vertex(coord + (-X + Y + Z) * s, 0.0f, tv, light, region);
+    index(0, 1, 2, 0, 2, 3);
+}
+
+void BlocksRenderer::renderGreedyFaces(int begin, int end) {
+    const glm::ivec3 min(0, begin / (CHUNK_W * CHUNK_D), 0);
+    const glm::ivec3 max(CHUNK_W, end / (CHUNK_W * CHUNK_D), CHUNK_D);
+    for (int i = 0; i < 6; i++) {
+        const auto& face = CUBE_FACES[i];
+        int axisA = axis_index(face.X);
+        int axisB = axis_index(face.Y);
+        int axisN = axis_index(face.Z);
+
+        glm::ivec3 pos;
+        for (pos[axisN] = min[axisN]; pos[axisN] < max[axisN]; pos[axisN]++) {
+            for (pos[axisB] = min[axisB]; pos[axisB] < max[axisB];
+                 pos[axisB]++) {
+                for (pos[axisA] = min[axisA]; pos[axisA] < max[axisA];
+                     pos[axisA]++) {
+                    if (greedyFaces[vox_index(pos.x, pos.y, pos.z) * 6 + i]) {
+                        greedyQuad(i, pos, max);
+                    }
+                    if (overflow) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void BlocksRenderer::fillOccluders(
+    const uint8_t* table, int y, uint32_t(&rows)[CHUNK_D + 2]
+) const {
+    if (y < 0 || y >= CHUNK_H) {
+        // out of the volume is void hiding faces
+        std::fill(std::begin(rows), std::end(rows), ~0U);
+        return;
+    }
+    const voxel* voxels = voxelsBuffer->getVoxels();
+    int w = voxelsBuffer->getW();
+    int d = voxelsBuffer->getD();
+    for (int z = 0; z < CHUNK_D + 2; z++) {
+        const voxel* src = voxels + vox_index(
+            voxelBufferPadding - 1, y, z + voxelBufferPadding - 1, w, d
+        );
+        uint32_t row = 0;
+        for (int x = 0; x < CHUNK_W + 2; x++) {
+            blockid_t id = src[x].id;
+            // void and unknown blocks hide faces too
+            bool occludes = id >= blocksCount || table[id];
+            row |= static_cast<uint32_t>(occludes) << x;
+        }
+        rows[z] = row;
+    }
+}
+
+void BlocksRenderer::updateExposedFaces(const uint8_t* table, int y) {
+    if (y == exposedLayer) {
+        return;
+    }
+    if (y == exposedLayer + 1) {
+        std::memcpy(occluderRows[0], occluderRows[1], sizeof(occluderRows[0]));
+        std::memcpy(occluderRows[1], occluderRows[2], sizeof(occluderRows[0]));
+    } else {
+        fillOccluders(table, y - 1, occluderRows[0]);
+        fillOccluders(table, y, occluderRows[1]);
+    }
+    fillOccluders(table, y + 1, occluderRows[2]);
+    exposedLayer = y;
+
+    const auto& below = occluderRows[0];
+    const auto& layer = occluderRows[1];
+    const auto& above = occluderRows[2];
+    for (int z = 0; z < CHUNK_D; z++) {
+        // bit x + 1 of the padded row is the voxel at x
+        exposedFaces[FACE_MX][z] = ~layer[z + 1];
+        exposedFaces[FACE_PX][z] = ~(layer[z + 1] >> 2);
+        exposedFaces[FACE_MY][z] = ~(below[z + 1] >> 1);
+        exposedFaces[FACE_PY][z] = ~(above[z + 1] >> 1);
+        exposedFaces[FACE_MZ][z] = ~(layer[z] >> 1);
+        exposedFaces[FACE_PZ][z] = ~(layer[z + 2] >> 1);
+    }
+}
+
+uint BlocksRenderer::pickOpenFaces(
+    const glm::ivec3& coord, const Block& def
+) const {
+    uint openFaces = 0;
+    for (uint side = 0; side < 6; side++) {
+        glm::ivec3 dir {};
+        dir[side / 2] = side % 2 ? 1 : -1;
+        openFaces |= static_cast<uint>(isOpen(coord + dir, def)) << side;
+    }
+    return openFaces;
+}
+
 bool BlocksRenderer::isOpenForLight(int x, int y, int z) const {
     blockid_t id = voxelsBuffer->pickBlockId(chunk->x * CHUNK_W + x, 
                                              y, 
@@ -386,8 +734,7 @@ bool BlocksRenderer::isOpenForLight(int x, int y, int z) const {
     if (id == BLOCK_VOID) {
         return false;
     }
-    const Block& block = *blockDefsCache[id];
-    if (block.lightPassing) {
+    if (content.getIndices()->lightPassing[id]) {
         return true;
     }
     return !id;
@@ -432,36 +779,66 @@ glm::vec4 BlocksRenderer::pickSoftLight(
 void BlocksRenderer::render(
     const voxel* voxels, int beginEnds[256][2]
 ) {
+    bool denseRender = settings.graphics.denseRender.get();
     for (const auto drawGroup : *content.drawGroups) {
         int begin = beginEnds[drawGroup][0];
         if (begin == 0) {
             continue;
         }
         int end = beginEnds[drawGroup][1];
+        const uint8_t* table =
+            occluders.get() + drawGroupIndices[drawGroup] * blocksCount;
+        exposedLayer = INT_MIN;
         for (int i = begin-1; i <= end; i++) {
+            if (isHidden(i)) {
+                continue;
+            }
             const voxel& vox = voxels[i];
             blockid_t id = vox.id;
             blockstate state = vox.state;
-            const auto& def = *blockDefsCache[id];
-            if (id == 0 || def.drawGroup != drawGroup || state.segment) {
+            if (id == 0 || blocksProps->drawGroup[id] != drawGroup ||
+                state.segment) {
                 continue;
             }
+            const auto& def = *blockDefsCache[id];
             if (def.translucent) {
                 continue;
             }
-            const UVRegion texfaces[6] {
-                cache.getRegion(id, 0), cache.getRegion(id, 1),
-                cache.getRegion(id, 2), cache.getRegion(id, 3),
-                cache.getRegion(id, 4), cache.getRegion(id, 5)
+            const uint texfaces[6] {
+                cache.getRegionIndex(id, 0), cache.getRegionIndex(id, 1),
+                cache.getRegionIndex(id, 2), cache.getRegionIndex(id, 3),
+                cache.getRegionIndex(id, 4), cache.getRegionIndex(id, 5)
             };
             int x = i % CHUNK_W;
             int y = i / (CHUNK_D * CHUNK_W);
             int z = (i / CHUNK_D) % CHUNK_W;
             switch (def.model) {
-                case BlockModel::block:
+                case BlockModel::block: {
+                    uint openFaces;
+                    // same blocks hide faces of each other, so the culling
+                    // table is enough
+                    if (def.culling == CullingMode::DEFAULT ||
+                        (def.culling == CullingMode::OPTIONAL &&
+                         !denseRender)) {
+                        updateExposedFaces(table, y);
+                        openFaces = 0;
+                        for (uint side = 0; side < 6; side++) {
+                            openFaces |= ((exposedFaces[side][z] >> x) & 1)
+                                         << side;
+                        }
+                    } else {
+                        openFaces = pickOpenFaces({x, y, z}, def);
+                    }
+                    if (greedy && !def.rotatable) {
+                        blockCubeGreedy({x, y, z}, texfaces, def,
+                                        !def.shadeless, def.ambientOcclusion,
+                                        openFaces);
+                        break;
+                    }
                     blockCube({x, y, z}, texfaces, def, vox.state, !def.shadeless,
-                              def.ambientOcclusion);
+                              def.ambientOcclusion, openFaces);
                     break;
+                }
                 case BlockModel::xsprite: {
                     blockXSprite(x, y, z, glm::vec3(1.0f), 
                                 texfaces[FACE_MX], texfaces[FACE_MZ], 1.0f);
@@ -502,20 +879,24 @@ SortingMeshData BlocksRenderer::renderTranslucent(
         }
         int end = beginEnds[drawGroup][1];
         for (int i = begin-1; i <= end; i++) {
+            if (isHidden(i)) {
+                continue;
+            }
             const voxel& vox = voxels[i];
             blockid_t id = vox.id;
             blockstate state = vox.state;
-            const auto& def = *blockDefsCache[id];
-            if (id == 0 || def.drawGroup != drawGroup || state.segment) {
+            if (id == 0 || blocksProps->drawGroup[id] != drawGroup ||
+                state.segment) {
                 continue;
             }
+            const auto& def = *blockDefsCache[id];
             if (!def.translucent) {
                 continue;
             }
-            const UVRegion texfaces[6] {
-                cache.getRegion(id, 0), cache.getRegion(id, 1),
-                cache.getRegion(id, 2), cache.getRegion(id, 3),
-                cache.getRegion(id, 4), cache.getRegion(id, 5)
+            const uint texfaces[6] {
+                cache.getRegionIndex(id, 0), cache.getRegionIndex(id, 1),
+                cache.getRegionIndex(id, 2), cache.getRegionIndex(id, 3),
+                cache.getRegionIndex(id, 4), cache.getRegionIndex(id, 5)
             };
             int x = i % CHUNK_W;
             int y = i / (CHUNK_D * CHUNK_W);
@@ -523,7 +904,8 @@ SortingMeshData BlocksRenderer::renderTranslucent(
             switch (def.model) {
                 case BlockModel::block:
                     blockCube({x, y, z}, texfaces, def, vox.state, !def.shadeless,
-                              def.ambientOcclusion);
+                              def.ambientOcclusion,
+                              pickOpenFaces({x, y, z}, def));
                     break;
                 case BlockModel::xsprite: {
                     blockXSprite(x, y, z, glm::vec3(1.0f), 
@@ -559,22 +941,18 @@ SortingMeshData BlocksRenderer::renderTranslucent(
             for (int j = 0; j < indexSize; j++) {
                 std::memcpy(
                     entry.vertexData.data() + j * CHUNK_VERTEX_SIZE,
-                    vertexBuffer.get() + indexBuffer[j] * CHUNK_VERTEX_SIZE,
+                    vertexBuffer + indexBuffer[j] * CHUNK_VERTEX_SIZE,
                     sizeof(float) * CHUNK_VERTEX_SIZE
                 );
-                float& vx = entry.vertexData[j * CHUNK_VERTEX_SIZE + 0];
-                float& vy = entry.vertexData[j * CHUNK_VERTEX_SIZE + 1];
-                float& vz = entry.vertexData[j * CHUNK_VERTEX_SIZE + 2];
-
+                auto vpos = unpack_position(
+                    entry.vertexData.data() + j * CHUNK_VERTEX_SIZE
+                );
                 if (!aabbInit) {
                     aabbInit = true;
-                    aabb.a = aabb.b = {vx, vy, vz};
+                    aabb.a = aabb.b = vpos;
                 } else {
-                    aabb.addPoint(glm::vec3(vx, vy, vz));
+                    aabb.addPoint(vpos);
                 }
-                vx += chunk->x * CHUNK_W + 0.5f;
-                vy += 0.5f;
-                vz += chunk->z * CHUNK_D + 0.5f;
             }
             sortingMesh.entries.push_back(std::move(entry));
             vertexOffset = 0;
@@ -603,37 +981,85 @@ SortingMeshData BlocksRenderer::renderTranslucent(
     return sortingMesh;
 }
 
-void BlocksRenderer::build(const Chunk* chunk, const Chunks* chunks) {
+void BlocksRenderer::updateSections(const voxel* voxels) {
+    emptySections = 0;
+    sealedSections = 0;
+    bool denseRender = settings.graphics.denseRender.get();
+    for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        if (!chunk->isUniformSection(s)) {
+            continue;
+        }
+        auto id = voxels[s * CHUNK_SECTION_VOL].id;
+        if (id == 0) {
+            emptySections |= 1U << s;
+            continue;
+        }
+        // faces between same solid cubes are culled
+        const auto& def = *blockDefsCache[id];
+        if (def.model == BlockModel::block && def.rt.solid &&
+            (def.culling == CullingMode::DEFAULT ||
+             (def.culling == CullingMode::OPTIONAL && !denseRender))) {
+            sealedSections |= 1U << s;
+        }
+    }
+}
+
+bool BlocksRenderer::isHidden(int index) const {
+    uint section = index / CHUNK_SECTION_VOL;
+    if (emptySections & (1U << section)) {
+        return true;
+    }
+    if (!(sealedSections & (1U << section))) {
+        return false;
+    }
+    int x = index % CHUNK_W;
+    int z = (index / CHUNK_W) % CHUNK_D;
+    int y = (index / (CHUNK_W * CHUNK_D)) % CHUNK_SECTION_H;
+    return x > 0 && x < CHUNK_W - 1 && z > 0 && z < CHUNK_D - 1 && y > 0 &&
+           y < CHUNK_SECTION_H - 1;
+}
+
+std::shared_ptr<const voxel[]> BlocksRenderer::prepare(
+    const Chunk* chunk, const ChunksSnapshot& chunks
+) {
     this->chunk = chunk;
     voxelsBuffer->setPosition(
         chunk->x * CHUNK_W - voxelBufferPadding, 0,
         chunk->z * CHUNK_D - voxelBufferPadding);
-    chunks->getVoxels(voxelsBuffer.get(), settings.graphics.backlight.get());
+    chunks.getVoxels(voxelsBuffer.get(), settings.graphics.backlight.get());
 
     if (voxelsBuffer->pickBlockId(
         chunk->x * CHUNK_W, 0, chunk->z * CHUNK_D
     ) == BLOCK_VOID) {
         cancelled = true;
-        return;
+        return nullptr;
     }
-    const voxel* voxels = chunk->voxels;
-
-    int totalBegin = chunk->bottom * (CHUNK_W * CHUNK_D);
-    int totalEnd = chunk->top * (CHUNK_W * CHUNK_D);
+    // chunk voxels may be compacted by the main thread meanwhile
+    auto voxels = chunk->voxels.read();
+    updateSections(voxels.get());
+    greedy = settings.graphics.greedyMeshing.get();
+    if (greedy && greedyFaces == nullptr) {
+        greedyFaces = std::make_unique<uint64_t[]>(CHUNK_VOL * 6);
+    }
+    cancelled = false;
+    return voxels;
+}
 
+void BlocksRenderer::buildRange(const voxel* voxels, int begin, int end) {
     int beginEnds[256][2] {};
-    for (int i = totalBegin; i < totalEnd; i++) {
+    for (int i = begin; i < end; i++) {
+        uint section = i / CHUNK_SECTION_VOL;
+        if (emptySections & (1U << section)) {
+            i = (section + 1) * CHUNK_SECTION_VOL - 1;
+            continue;
+        }
         const voxel& vox = voxels[i];
-        blockid_t id = vox.id;
-        const auto& def = *blockDefsCache[id];
-    
-        if (beginEnds[def.drawGroup][0] == 0) {
-            beginEnds[def.drawGroup][0] = i+1;
+        ubyte drawGroup = blocksProps->drawGroup[vox.id];
+        if (beginEnds[drawGroup][0] == 0) {
+            beginEnds[drawGroup][0] = i+1;
         }
-        beginEnds[def.drawGroup][1] = i;
+        beginEnds[drawGroup][1] = i;
     }
-    cancelled = false;
-
     overflow = false;
     vertexOffset = 0;
     indexOffset = indexSize = 0;
@@ -644,28 +1070,241 @@ void BlocksRenderer::build(const Chunk* chunk, const Chunks* chunks) {
     vertexOffset = 0;
     indexOffset = indexSize = 0;
     
+    if (greedy && begin < end) {
+        std::fill(
+            greedyFaces.get() + begin * 6, greedyFaces.get() + end * 6, 0
+        );
+    }
     render(voxels, beginEnds);
+    if (greedy && !overflow) {
+        renderGreedyFaces(begin, end);
+    }
+}
+
+void BlocksRenderer::build(const Chunk* chunk, const ChunksSnapshot& chunks) {
+    sections = nullptr;
+    auto voxels = prepare(chunk, chunks);
+    if (voxels == nullptr) {
+        return;
+    }
+    buildRange(
+        voxels.get(),
+        chunk->bottom * (CHUNK_W * CHUNK_D),
+        chunk->top * (CHUNK_W * CHUNK_D)
+    );
+}
+
+void BlocksRenderer::build(
+    const Chunk* chunk,
+    const ChunksSnapshot& chunks,
+    const ChunkSections& previous,
+    uint32_t dirtySections
+) {
+    sections = nullptr;
+    auto voxels = prepare(chunk, chunks);
+    if (voxels == nullptr) {
+        return;
+    }
+    auto built = std::make_shared<ChunkSections>(previous);
+    int totalBegin = chunk->bottom * (CHUNK_W * CHUNK_D);
+    int totalEnd = chunk->top * (CHUNK_W * CHUNK_D);
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        auto& section = (*built)[s];
+        if (section && !(dirtySections & (1U << s))) {
+            continue;
+        }
+        buildRange(
+            voxels.get(),
+            std::max(s * CHUNK_SECTION_VOL, totalBegin),
+            std::min((s + 1) * CHUNK_SECTION_VOL, totalEnd)
+        );
+        section = std::make_shared<ChunkSectionMesh>(ChunkSectionMesh {
+            util::Buffer<float>(vertexBuffer, vertexOffset),
+            util::Buffer<int>(indexBuffer, indexSize),
+            std::move(sortingMesh.entries)});
+    }
+    sections = std::move(built);
+}
+
+void BlocksRenderer::surfaceQuad(
+    const glm::vec3& corner,
+    const glm::vec3& X,
+    const glm::vec3& Y,
+    uint region,
+    uint32_t light
+) {
+    if (!reserve(4)) {
+        return;
+    }
+    float tu = glm::length(X);
+    float tv = glm::length(Y);
+    vertex(corner, 0.0f, 0.0f, light, region);
+    vertex(corner + X, tu, 0.0f, light, region);
+    vertex(corner + X + Y, tu, tv, light, region);
+    vertex(corner + Y, 0.0f, tv, light, region);
+    index(0, 1, 2, 0, 2, 3);
+}
+
+void BlocksRenderer::buildSurface(
+    const Chunk* chunk, const ChunksSnapshot& chunks, int step
+) {
+    sections = nullptr;
+    sortingMesh = {};
+    overflow = false;
+    vertexOffset = 0;
+    indexOffset = indexSize = 0;
+
+    auto voxels = prepare(chunk, chunks);
+    if (voxels == nullptr) {
+        return;
+    }
+    const int cellsX = CHUNK_W / step;
+    const int cellsZ = CHUNK_D / step;
+    // top block y and position of the highest column of every cell
+    std::vector<int> heights(cellsX * cellsZ, -1);
+    std::vector<glm::ivec3> tops(cellsX * cellsZ);
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            int cell = (z / step) * cellsX + x / step;
+            for (int y = chunk->top - 1; y > heights[cell]; y--) {
+                const auto& vox = voxels[vox_index(x, y, z)];
+                const auto& def = *blockDefsCache[vox.id];
+                if (vox.id && def.model != BlockModel::none) {
+                    heights[cell] = y;
+                    tops[cell] = {x, y, z};
+                    break;
+                }
+            }
+        }
+    }
+    auto heightAt = [&](int cx, int cz) {
+        if (cx < 0 || cz < 0 || cx >= cellsX || cz >= cellsZ) {
+            // skirt hiding gaps between surfaces of neighbour chunks
+            return chunk->bottom - 1;
+        }
+        return heights[cz * cellsX + cx];
+    };
+    // side normal, X axis and texture side index
+    const struct {
+        glm::ivec3 normal;
+        glm::vec3 X;
+        int side;
+    } sides[4] {
+        {{1, 0, 0}, {0, 0, -1}, 1},
+        {{-1, 0, 0}, {0, 0, 1}, 0},
+        {{0, 0, 1}, {1, 0, 0}, 5},
+        {{0, 0, -1}, {-1, 0, 0}, 4},
+    };
+    const float sideStep = step;
+    for (int cz = 0; cz < cellsZ; cz++) {
+        for (int cx = 0; cx < cellsX; cx++) {
+            int height = heights[cz * cellsX + cx];
+            if (height < 0) {
+                continue;
+            }
+            const auto& top = tops[cz * cellsX + cx];
+            blockid_t id = voxels[vox_index(top.x, top.y, top.z)].id;
+            glm::vec4 light = pickLight(
+                top.x, std::min(top.y + 1, CHUNK_H - 1), top.z
+            );
+            // cell center in block coordinates
+            glm::vec3 center(
+                cx * step + (step - 1) * 0.5f,
+                height,
+                cz * step + (step - 1) * 0.5f
+            );
+            float half = step * 0.5f;
+            float topShading = 0.8f + SUN_VECTOR.y * 0.2f;
+            surfaceQuad(
+                center + glm::vec3(-half, 0.5f, half),
+                glm::vec3(sideStep, 0, 0),
+                glm::vec3(0, 0, -sideStep),
+                cache.getRegionIndex(id, 3),
+                compress_light(light * topShading)
+            );
+            for (const auto& side : sides) {
+                int bottom = heightAt(cx + side.normal.x, cz + side.normal.z);
+                if (bottom >= height) {
+                    continue;
+                }
+                glm::vec3 normal(side.normal);
+                float d = 0.8f + glm::dot(normal, SUN_VECTOR) * 0.2f;
+                // first vertex is the bottom-left corner looking at the side
+                glm::vec3 corner = center + (normal - side.X) * half;
+                uint region = cache.getRegionIndex(id, side.side);
+                uint32_t sideLight = compress_light(light * d);
+                // split to keep tile coordinates in range
+                for (int y = bottom + 1; y <= height; y += CHUNK_MAX_TILES) {
+                    int segment = std::min(height - y + 1, CHUNK_MAX_TILES);
+                    corner.y = y - 0.5f;
+                    surfaceQuad(
+                        corner,
+                        side.X * sideStep,
+                        glm::vec3(0, segment, 0),
+                        region,
+                        sideLight
+                    );
+                }
+            }
+            if (overflow) {
+                return;
+            }
+        }
+    }
 }
 
 ChunkMeshData BlocksRenderer::createMesh() {
+    util::Buffer<VertexAttribute> attrs(
+        CHUNK_VATTRS, sizeof(CHUNK_VATTRS) / sizeof(VertexAttribute)
+    );
+    if (sections == nullptr) {
+        ChunkMeshData data {
+            MeshData(
+                util::Buffer<float>(vertexBuffer, vertexOffset),
+                util::Buffer<int>(indexBuffer, indexSize),
+                std::move(attrs)
+            ),
+            std::move(sortingMesh)};
+        releaseBuffers();
+        return data;
+    }
+    // sections meshes are copied already
+    releaseBuffers();
+    size_t verticesSize = 0;
+    size_t indicesSize = 0;
+    for (const auto& section : *sections) {
+        verticesSize += section->vertices.size();
+        indicesSize += section->indices.size();
+    }
+    util::Buffer<float> vertices(verticesSize);
+    util::Buffer<int> indices(indicesSize);
+    SortingMeshData sortingData {};
+
+    float* dstVertices = vertices.data();
+    int* dstIndices = indices.data();
+    int baseIndex = 0;
+    for (const auto& section : *sections) {
+        std::memcpy(
+            dstVertices,
+            section->vertices.data(),
+            section->vertices.size() * sizeof(float)
+        );
+        dstVertices += section->vertices.size();
+        for (size_t i = 0; i < section->indices.size(); i++) {
+            *(dstIndices++) = baseIndex + section->indices[i];
+        }
+        baseIndex += section->vertices.size() / CHUNK_VERTEX_SIZE;
+
+        for (const auto& entry : section->sortingEntries) {
+            sortingData.entries.push_back(SortingMeshEntry {
+                entry.position,
+                util::Buffer<float>(entry.vertexData)});
+        }
+    }
     return ChunkMeshData {
-        MeshData(
-            util::Buffer<float>(vertexBuffer.get(), vertexOffset),
-            util::Buffer<int>(indexBuffer.get(), indexSize),
-            util::Buffer<VertexAttribute>(
-                CHUNK_VATTRS, sizeof(CHUNK_VATTRS) / sizeof(VertexAttribute)
-            )
-        ),
-        std::move(sortingMesh)};
-}
-
-ChunkMesh BlocksRenderer::render(const Chunk* chunk, const Chunks* chunks) {
-    build(chunk, chunks);
-
-    size_t vcount = vertexOffset / CHUNK_VERTEX_SIZE;
-    return ChunkMesh{std::make_unique<Mesh>(
-        vertexBuffer.get(), vcount, indexBuffer.get(), indexSize, CHUNK_VATTRS
-    ), std::move(sortingMesh)};
+        MeshData(std::move(vertices), std::move(indices), std::move(attrs)),
+        std::move(sortingData),
+        std::move(sections)};
 }
 
 VoxelsVolume* BlocksRenderer::getVoxelsBuffer() const {
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <stdlib.h>
+#include <climits>
 #include <vector>
 #include <memory>
 #include <glm/glm.hpp>
 #include "voxels/voxel.hpp"
 #include "typedefs.hpp"
 
+#include "content/Content.hpp"
 #include "voxels/Block.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/VoxelsVolume.hpp"
@@ -15,43 +17,106 @@
 #include "commons.hpp"
 #include "settings.hpp"
 
-class Content;
 class Mesh;
 class Block;
 class Chunk;
-class Chunks;
+class ChunksSnapshot;
 class VoxelsVolume;
-class Chunks;
 class ContentGfxCache;
-struct UVRegion;
+struct MeshBuffers;
 
 class BlocksRenderer {
     static const glm::vec3 SUN_VECTOR;
     const Content& content;
-    std::unique_ptr<float[]> vertexBuffer;
-    std::unique_ptr<int[]> indexBuffer;
+    /// @brief Growable vertex and index buffers taken from the shared pool
+    /// for the time of building
+    std::shared_ptr<MeshBuffers> buffers;
+    float* vertexBuffer = nullptr;
+    int* indexBuffer = nullptr;
+    size_t vertexCapacity = 0;
+    size_t indexCapacity = 0;
     size_t vertexOffset;
     size_t indexOffset, indexSize;
-    size_t capacity;
+    /// @brief Max number of vertices of a mesh, the rest geometry is dropped
+    size_t maxVertices;
     int voxelBufferPadding = 2;
     bool overflow = false;
     bool cancelled = false;
     const Chunk* chunk = nullptr;
+    /// @brief Uniform sections of the chunk being built filled with air
+    uint32_t emptySections = 0;
+    /// @brief Uniform sections of the chunk being built where only border
+    /// voxels may have visible faces
+    uint32_t sealedSections = 0;
     std::unique_ptr<VoxelsVolume> voxelsBuffer;
 
     const Block* const* blockDefsCache;
+    const BlocksProperties* blocksProps;
+    size_t blocksCount;
+    /// @brief Face culling table: for each draw group (see drawGroupIndices)
+    /// 1 byte per block id, non-zero if the block hides faces of the group
+    /// blocks behind it
+    std::unique_ptr<uint8_t[]> occluders;
+    ubyte drawGroupIndices[256] {};
+    /// @brief Occluders bitmasks of layers y - 1, y, y + 1 around the layer
+    /// of exposedFaces: bit x + 1 of row z + 1 for x, z in [-1, 16]
+    uint32_t occluderRows[3][CHUNK_D + 2];
+    /// @brief Faces of plain cubes in the layer not hidden by neighbours:
+    /// bit x of row z for each side (FACE_MX..FACE_PZ)
+    uint16_t exposedFaces[6][CHUNK_D];
+    /// @brief Layer of exposedFaces, INT_MIN if not calculated
+    int exposedLayer = INT_MIN;
     const ContentGfxCache& cache;
     const EngineSettings& settings;
     
     util::PseudoRandom randomizer;
 
     SortingMeshData sortingMesh;
+    /// @brief Sections meshes of the chunk being built section by section
+    std::shared_ptr<ChunkSections> sections;
+    /// @brief Greedy meshing is enabled for the chunk being built
+    bool greedy = false;
+    /// @brief Faces collected for greedy meshing, 6 per voxel.
+    /// Block id in high and packed light in low 32 bits, 0 if no face
+    std::unique_ptr<uint64_t[]> greedyFaces;
 
-    void vertex(const glm::vec3& coord, float u, float v, const glm::vec4& light);
+    /// @brief Grow buffers to fit the vertices with their indices
+    /// @return false if the vertices limit is reached (sets overflow)
+    bool grow(size_t vertices);
+
+    /// @brief Make room for the vertices with their indices (up to 6 per
+    /// 4 vertices)
+    /// @return false if the vertices limit is reached (sets overflow)
+    inline bool reserve(size_t vertices) {
+        if (vertexOffset + vertices * CHUNK_VERTEX_SIZE <= vertexCapacity &&
+            indexSize + vertices * 3 / 2 <= indexCapacity) {
+            return true;
+        }
+        return grow(vertices);
+    }
+
+    /// @brief Return buffers to the shared pool
+    void releaseBuffers();
+
+    /// @brief Add packed vertex
+    /// @param u,v texture coordinates local to the atlas region,
+    /// values above 1 tile the region
+    /// @param light packed light
+    /// @param region atlas region index
+    void vertex(
+        const glm::vec3& coord, float u, float v, uint32_t light, uint region
+    );
+    void vertex(
+        const glm::vec3& coord,
+        float u,
+        float v,
+        const glm::vec4& light,
+        uint region
+    );
     void index(int a, int b, int c, int d, int e, int f);
 
     void vertexAO(
-        const glm::vec3& coord, float u, float v, 
+        const glm::vec3& coord, float u, float v, uint region,
         const glm::vec4& brightness,
         const glm::vec3& axisX,
         const glm::vec3& axisY,
@@ -63,7 +128,7 @@ class BlocksRenderer {
         const glm::vec3& axisX,
         const glm::vec3& axisY,
         const glm::vec3& axisZ,
-        const UVRegion& region,
+        uint region,
         const glm::vec4(&lights)[4],
         const glm::vec4& tint
     );
@@ -72,7 +137,7 @@ class BlocksRenderer {
         const glm::vec3& X,
         const glm::vec3& Y,
         const glm::vec3& Z,
-        const UVRegion& region,
+        uint region,
         glm::vec4 tint,
         bool lights
     );
@@ -81,30 +146,71 @@ class BlocksRenderer {
         const glm::vec3& axisX,
         const glm::vec3& axisY,
         const glm::vec3& axisZ,
-        const UVRegion& region,
+        uint region,
         bool lights
     );
+    /// @param openFaces bits of sides (FACE_MX..FACE_PZ) not hidden by
+    /// neighbours
     void blockCube(
         const glm::ivec3& coord,
-        const UVRegion(&faces)[6], 
+        const uint(&faces)[6], 
         const Block& block, 
         blockstate states, 
         bool lights,
-        bool ao
+        bool ao,
+        uint openFaces
     );
     void blockAABB(
         const glm::ivec3& coord,
-        const UVRegion(&faces)[6], 
+        const uint(&faces)[6], 
         const Block* block, 
         ubyte rotation,
         bool lights,
         bool ambientOcclusion
     );
+    /// @brief Collect plain cube faces for greedy meshing
+    void blockCubeGreedy(
+        const glm::ivec3& coord,
+        const uint(&faces)[6],
+        const Block& block,
+        bool lights,
+        bool ao,
+        uint openFaces
+    );
+    /// @brief Calculate light of a plain cube face
+    /// @return false if face corners lights are different
+    bool pickFaceLight(
+        const glm::ivec3& coord,
+        const glm::ivec3& X,
+        const glm::ivec3& Y,
+        const glm::ivec3& Z,
+        bool lights,
+        bool ao,
+        glm::vec4& light
+    ) const;
+    /// @brief Merge collected faces starting from the given position and
+    /// emit the resulting quad
+    void greedyQuad(
+        int faceIndex, const glm::ivec3& pos, const glm::ivec3& max
+    );
+    /// @brief Merge and emit collected faces of voxels in index range
+    /// [begin, end)
+    void renderGreedyFaces(int begin, int end);
+    /// @brief Emit quad of the simplified surface tiled with texture region
+    /// @param corner first vertex position
+    /// @param X, Y quad sides, normal is cross(X, Y)
+    void surfaceQuad(
+        const glm::vec3& corner,
+        const glm::vec3& X,
+        const glm::vec3& Y,
+        uint region,
+        uint32_t light
+    );
     void blockXSprite(
         int x, int y, int z, 
         const glm::vec3& size, 
-        const UVRegion& face1, 
-        const UVRegion& face2, 
+        uint face1, 
+        uint face2, 
         float spread
     );
     void blockCustomModel(
@@ -117,6 +223,17 @@ class BlocksRenderer {
 
     bool isOpenForLight(int x, int y, int z) const;
 
+    /// @brief Fill occluders bitmasks of the layer
+    /// @param table draw group part of the occluders table
+    void fillOccluders(
+        const uint8_t* table, int y, uint32_t(&rows)[CHUNK_D + 2]
+    ) const;
+    /// @brief Calculate exposedFaces of the layer with bitwise ops over
+    /// occluders of the layer and its neighbour layers
+    void updateExposedFaces(const uint8_t* table, int y);
+    /// @brief Get open sides of the block checking neighbours one by one
+    uint pickOpenFaces(const glm::ivec3& coord, const Block& def) const;
+
     // Does block allow to see other blocks sides (is it transparent)
     inline bool isOpen(const glm::ivec3& pos, const Block& def) const {
         auto id = voxelsBuffer->pickBlockId(
@@ -125,8 +242,9 @@ class BlocksRenderer {
         if (id == BLOCK_VOID) {
             return false;
         }
-        const auto& block = *blockDefsCache[id];
-        if (((block.drawGroup != def.drawGroup) && block.drawGroup) || !block.rt.solid) {
+        ubyte drawGroup = blocksProps->drawGroup[id];
+        if ((drawGroup != def.drawGroup && drawGroup) ||
+            !blocksProps->solid[id]) {
             return true;
         }
         if ((def.culling == CullingMode::DISABLED ||
@@ -143,19 +261,52 @@ class BlocksRenderer {
     glm::vec4 pickSoftLight(const glm::ivec3& coord, const glm::ivec3& right, const glm::ivec3& up) const;
     glm::vec4 pickSoftLight(float x, float y, float z, const glm::ivec3& right, const glm::ivec3& up) const;
     
+    /// @brief Find sections to be skipped while building chunk mesh
+    void updateSections(const voxel* voxels);
+    /// @brief Check if voxel has no visible faces known from its section
+    bool isHidden(int index) const;
+
     void render(const voxel* voxels, int beginEnds[256][2]);
     SortingMeshData renderTranslucent(const voxel* voxels, int beginEnds[256][2]);
+
+    /// @brief Fill voxels buffer and find sections to be skipped
+    /// @return chunk voxels or nullptr if build is cancelled
+    std::shared_ptr<const voxel[]> prepare(
+        const Chunk* chunk, const ChunksSnapshot& chunks
+    );
+    /// @brief Build mesh of voxels with indices in range [begin, end)
+    void buildRange(const voxel* voxels, int begin, int end);
 public:
+    /// @param maxVertices max number of vertices of a mesh
     BlocksRenderer(
-        size_t capacity,
+        size_t maxVertices,
         const Content& content,
         const ContentGfxCache& cache,
         const EngineSettings& settings
     );
     virtual ~BlocksRenderer();
 
-    void build(const Chunk* chunk, const Chunks* chunks);
-    ChunkMesh render(const Chunk* chunk, const Chunks* chunks);
+    void build(const Chunk* chunk, const ChunksSnapshot& chunks);
+
+    /// @brief Build chunk mesh section by section keeping sections meshes
+    /// @param previous sections meshes of the previous build, null entries
+    /// are always built
+    /// @param dirtySections bit mask of sections to be rebuilt
+    void build(
+        const Chunk* chunk,
+        const ChunksSnapshot& chunks,
+        const ChunkSections& previous,
+        uint32_t dirtySections
+    );
+
+    /// @brief Build simplified mesh of the chunk surface for distant chunks.
+    /// Surface consists of step x step cells with height of the highest
+    /// column in the cell
+    /// @param step cell size in blocks
+    void buildSurface(
+        const Chunk* chunk, const ChunksSnapshot& chunks, int step
+    );
+
     ChunkMeshData createMesh();
     VoxelsVolume* getVoxelsBuffer() const;
 
@@ -0,0 +1,131 @@
+#include "ChunksOcclusion.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+
+#include "graphics/core/Mesh.hpp"
+#include "graphics/core/Shader.hpp"
+#include "voxels/Chunk.hpp"
+#include "window/Camera.hpp"
+#include "constants.hpp"
+
+/// @brief Distance to chunk box the camera is too close to test the chunk
+static constexpr float CAMERA_MARGIN = 2.0f;
+/// @brief Query box expansion keeping its faces off the coplanar terrain
+/// faces, which would fail the depth test
+static constexpr float QUERY_BOX_MARGIN = 0.05f;
+
+ChunksOcclusion::ChunksOcclusion() {
+    // unit cube triangles
+    const float vertices[] {
+        0, 0, 1,  1, 0, 1,  1, 1, 1,  0, 0, 1,  1, 1, 1,  0, 1, 1,
+        1, 0, 0,  0, 0, 0,  0, 1, 0,  1, 0, 0,  0, 1, 0,  1, 1, 0,
+        0, 0, 0,  0, 0, 1,  0, 1, 1,  0, 0, 0,  0, 1, 1,  0, 1, 0,
+        1, 0, 1,  1, 0, 0,  1, 1, 0,  1, 0, 1,  1, 1, 0,  1, 1, 1,
+        0, 1, 1,  1, 1, 1,  1, 1, 0,  0, 1, 1,  1, 1, 0,  0, 1, 0,
+        0, 0, 0,  1, 0, 0,  1, 0, 1,  0, 0, 0,  1, 0, 1,  0, 0, 1,
+    };
+    VertexAttribute attrs[] {{3}, {0}};
+    box = std::make_unique<Mesh>(vertices, 36, attrs);
+}
+
+ChunksOcclusion::~ChunksOcclusion() {
+    clear();
+}
+
+void ChunksOcclusion::update() {
+    frame++;
+    for (auto& [_, entry] : entries) {
+        if (!entry.pending) {
+            continue;
+        }
+        GLuint available = 0;
+        glGetQueryObjectuiv(entry.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+        GLuint passed = 0;
+        glGetQueryObjectuiv(entry.query, GL_QUERY_RESULT, &passed);
+        entry.visible = passed != 0;
+        entry.pending = false;
+    }
+}
+
+bool ChunksOcclusion::isVisible(const Chunk& chunk) {
+    candidates.push_back(&chunk);
+    const auto& found = entries.find(glm::ivec2(chunk.x, chunk.z));
+    if (found == entries.end()) {
+        return true;
+    }
+    // results for chunks that were out of the frustum are outdated
+    const auto& entry = found->second;
+    return entry.visible || entry.frame + 1 < frame;
+}
+
+void ChunksOcclusion::test(const Camera& camera, Shader& shader) {
+    shader.use();
+    shader.uniformMatrix("u_projview", camera.getProjView());
+
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+
+    for (const auto chunk : candidates) {
+        glm::vec3 min(chunk->x * CHUNK_W, chunk->bottom, chunk->z * CHUNK_D);
+        glm::vec3 max(
+            min.x + CHUNK_W,
+            std::max(chunk->top, chunk->bottom + 1),
+            min.z + CHUNK_D
+        );
+        auto& entry = entries[glm::ivec2(chunk->x, chunk->z)];
+        entry.frame = frame;
+        const auto& pos = camera.position;
+        if (glm::all(glm::greaterThan(pos, min - CAMERA_MARGIN)) &&
+            glm::all(glm::lessThan(pos, max + CAMERA_MARGIN))) {
+            // box faces may be behind the camera
+            entry.visible = true;
+            continue;
+        }
+        if (entry.pending) {
+            continue;
+        }
+        if (entry.query == 0) {
+            glGenQueries(1, &entry.query);
+        }
+        shader.uniform3f("u_boxPos", min - QUERY_BOX_MARGIN);
+        shader.uniform3f("u_boxSize", max - min + QUERY_BOX_MARGIN * 2.0f);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, entry.query);
+        box->draw();
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        entry.pending = true;
+    }
+    candidates.clear();
+
+    if (cullFace) {
+        glEnable(GL_CULL_FACE);
+    }
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void ChunksOcclusion::unload(const glm::ivec2& key) {
+    auto found = entries.find(key);
+    if (found == entries.end()) {
+        return;
+    }
+    if (found->second.query) {
+        glDeleteQueries(1, &found->second.query);
+    }
+    entries.erase(found);
+}
+
+void ChunksOcclusion::clear() {
+    for (auto& [_, entry] : entries) {
+        if (entry.query) {
+            glDeleteQueries(1, &entry.query);
+        }
+    }
+    entries.clear();
+    candidates.clear();
+}
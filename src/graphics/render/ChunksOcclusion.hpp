@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include "typedefs.hpp"
+
+class Mesh;
+class Chunk;
+class Camera;
+class Shader;
+
+/// @brief Chunks occlusion culling with hardware occlusion queries.
+/// Chunk bounding boxes are tested against the depth buffer after opaque
+/// chunks are drawn. Results are read back in the next frames without
+/// stalling, so a chunk becoming visible may appear a frame later.
+class ChunksOcclusion {
+    struct Entry {
+        uint query = 0;
+        bool pending = false;
+        bool visible = true;
+        /// @brief Last frame the chunk passed frustum culling
+        uint frame = 0;
+    };
+    uint frame = 0;
+    std::unordered_map<glm::ivec2, Entry> entries;
+    /// @brief Chunks tested this frame
+    std::vector<const Chunk*> candidates;
+    std::unique_ptr<Mesh> box;
+public:
+    ChunksOcclusion();
+    ~ChunksOcclusion();
+
+    /// @brief Read back available query results
+    void update();
+
+    /// @brief Check if chunk was not occluded by the last finished test
+    /// and add it to the tested chunks
+    /// @param chunk chunk passed frustum culling
+    bool isVisible(const Chunk& chunk);
+
+    /// @brief Issue queries for chunks checked in this frame
+    /// @param shader occlusion boxes shader
+    void test(const Camera& camera, Shader& shader);
+
+    void unload(const glm::ivec2& key);
+    void clear();
+};
@@ -1,24 +1,115 @@
 #include "ChunksRenderer.hpp"
 #include "BlocksRenderer.hpp"
+#include "ChunksOcclusion.hpp"
+#include "LightTextures.hpp"
+#include "frontend/ContentGfxCache.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
 #include "assets/Assets.hpp"
 #include "graphics/core/Mesh.hpp"
 #include "graphics/core/Shader.hpp"
 #include "graphics/core/Texture.hpp"
+#include "graphics/core/TextureArray.hpp"
+#include "graphics/core/UniformBuffer.hpp"
 #include "graphics/core/Atlas.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
 #include "world/Level.hpp"
 #include "window/Camera.hpp"
 #include "maths/FrustumCulling.hpp"
+#include "util/LinearAllocator.hpp"
 #include "util/listutil.hpp"
+#include "util/timeutil.hpp"
 #include "settings.hpp"
 
+#include <GL/glew.h>
+#include <algorithm>
+#include <limits>
+
 static debug::Logger logger("chunks-render");
 
 size_t ChunksRenderer::visibleChunks = 0;
+size_t ChunksRenderer::occludedChunks = 0;
+size_t ChunksRenderer::visibleVertices = 0;
+size_t ChunksRenderer::meshesMemory = 0;
+
+/// @brief Max distance to chunks keeping sections meshes between rebuilds
+static constexpr float KEEP_SECTIONS_DISTANCE = CHUNK_W * 4.0f;
+
+/// @brief Initial capacity of the chunks mesh arena in vertices
+static constexpr size_t ARENA_VERTEX_CAPACITY = 1 << 20;
+/// @brief Initial capacity of the chunks mesh arena in indices
+static constexpr size_t ARENA_INDEX_CAPACITY = ARENA_VERTEX_CAPACITY * 3 / 2;
+
+/// @brief Initial time of built meshes uploading per frame (microseconds)
+static constexpr int64_t MESH_UPLOAD_BUDGET = 2000;
+/// @brief Meshes uploading time budget limits (microseconds)
+static constexpr int64_t MIN_MESH_UPLOAD_BUDGET = 500;
+static constexpr int64_t MAX_MESH_UPLOAD_BUDGET = 8000;
+
+static const Shader::Uniform U_MODEL("u_model");
+
+/// @brief Mesh jobs priority bonus of chunks in the camera frustum
+static constexpr float FRUSTUM_PRIORITY = CHUNK_W * 8.0f;
+/// @brief Mesh jobs priority bonus of chunks modified by players
+static constexpr float EDITED_PRIORITY = CHUNK_W * 16.0f;
+
+/// @brief Translucent faces re-sort distance relative to the camera
+/// distance to the chunk: order of distant faces changes slower
+static constexpr float SORT_DISTANCE_FACTOR = 1.0f / 16.0f;
+
+/// @brief Side of chunks groups culled before the chunks (in chunks)
+static constexpr int CULLING_GROUP_SIZE = 8;
+
+/// @brief Coarsest level of detail of distant chunks meshes
+static constexpr int MAX_LOD = 4;
+/// @brief Level of detail thresholds hysteresis
+static constexpr float LOD_MARGIN = CHUNK_W;
+
+/// @brief Pick level of detail of chunk mesh
+/// @param current level of detail of the current mesh
+/// @param lodDistance distance where simplified meshes start
+static int pick_lod(float distance, int current, float lodDistance) {
+    int lod = 1;
+    for (float threshold = lodDistance; lod < MAX_LOD; threshold *= 2) {
+        // chunks near to a threshold keep the current level
+        float margin = current > lod ? -LOD_MARGIN : LOD_MARGIN;
+        if (distance < threshold + margin) {
+            break;
+        }
+        lod *= 2;
+    }
+    return lod;
+}
 
-class RendererWorker : public util::Worker<std::shared_ptr<Chunk>, RendererResult> {
+/// @brief Check if the chunk center is nearer than the distance to the center
+/// horizontally
+static bool is_near(
+    int chunkX, int chunkZ, const glm::vec3& center, float distance
+) {
+    float dx = (chunkX + 0.5f) * CHUNK_W - center.x;
+    float dz = (chunkZ + 0.5f) * CHUNK_D - center.z;
+    return dx * dx + dz * dz < distance * distance;
+}
+
+static void build_chunk_mesh(
+    BlocksRenderer& renderer,
+    const Chunk* chunk,
+    const ChunksSnapshot& chunks,
+    const ChunkSections* sections,
+    uint32_t dirtySections,
+    int lod
+) {
+    if (lod > 1) {
+        renderer.buildSurface(chunk, chunks, lod);
+    } else if (sections) {
+        renderer.build(chunk, chunks, *sections, dirtySections);
+    } else {
+        renderer.build(chunk, chunks);
+    }
+}
+
+class RendererWorker : public util::Worker<RendererJob, RendererResult> {
     const Level& level;
     BlocksRenderer renderer;
 public:
@@ -31,18 +122,61 @@ public:
                  *level.content, cache, settings)
     {}
 
-    RendererResult operator()(const std::shared_ptr<Chunk>& chunk) override {
-        renderer.build(chunk.get(), level.chunks.get());
+    RendererResult operator()(const RendererJob& job) override {
+        static auto& buildTime =
+            debug::Metrics::getInstance().histogram("chunks.mesh-build");
+        debug::MetricTimer timer(buildTime);
+        const auto& chunk = job.chunk;
+        build_chunk_mesh(
+            renderer,
+            chunk.get(),
+            job.neighbours,
+            job.sections.get(),
+            job.dirtySections,
+            job.lod
+        );
         if (renderer.isCancelled()) {
             return RendererResult {
-                glm::ivec2(chunk->x, chunk->z), true, MeshData()};
+                glm::ivec2(chunk->x, chunk->z), true, ChunkMeshData()};
         }
         auto meshData = renderer.createMesh();
+        meshData.lod = job.lod;
         return RendererResult {
             glm::ivec2(chunk->x, chunk->z), false, std::move(meshData)};
     }
 };
 
+/// @brief Sorts translucent entries back to front writing their vertices
+/// indices to the job buffer
+class SortingWorker : public util::Worker<SortingJob, SortingResult> {
+    /// @brief Entries distances and indices reused between jobs
+    std::vector<std::pair<float, int>> order;
+public:
+    SortingResult operator()(const SortingJob& job) override {
+        const auto& layout = *job.layout;
+        const auto& positions = layout.positions;
+        order.resize(positions.size());
+        for (size_t i = 0; i < positions.size(); i++) {
+            order[i] = {
+                glm::distance2(positions[i], job.cameraPosition),
+                static_cast<int>(i)};
+        }
+        std::sort(order.begin(), order.end(), std::greater<>());
+
+        auto& indices = *job.indices;
+        indices.resize(layout.offsets.back());
+        int* dst = indices.data();
+        for (const auto& [_, entry] : order) {
+            int end = layout.offsets[entry + 1];
+            for (int vertex = layout.offsets[entry]; vertex < end; vertex++) {
+                *(dst++) = vertex;
+            }
+        }
+        return SortingResult {
+            job.key, job.version, job.cameraPosition, job.indices};
+    }
+};
+
 ChunksRenderer::ChunksRenderer(
     const Level* level, 
     const Assets& assets,
@@ -52,86 +186,323 @@ ChunksRenderer::ChunksRenderer(
 ) : level(*level),
     assets(assets),
     frustum(frustum),
+    cache(cache),
     settings(settings),
     threadPool(
         "chunks-render-pool",
         [&](){return std::make_shared<RendererWorker>(*level, cache, settings);}, 
         [&](RendererResult& result){
-            if (!result.cancelled) {
-                auto meshData = std::move(result.meshData);
-                meshes[result.key] = ChunkMesh {
-                    std::make_unique<Mesh>(meshData.mesh),
-                    std::move(meshData.sortingMesh)
-                };
+            auto found = inwork.find(result.key);
+            if (found == inwork.end()) {
+                return;
+            }
+            if (!result.cancelled && found->second) {
+                setMesh(result.key, std::move(result.meshData));
             }
-            inwork.erase(result.key);
-        }, settings.graphics.chunkMaxRenderers.get())
+            inwork.erase(found);
+        }, settings.graphics.chunkMaxRenderers.get()),
+    sortingPool(
+        "chunks-sorting-pool",
+        []() { return std::make_shared<SortingWorker>(); },
+        [this](SortingResult& result) { applySorted(result); },
+        util::ThreadPool<SortingJob, SortingResult>::QUARTER
+    ),
+    meshBudget(
+        MESH_UPLOAD_BUDGET, MIN_MESH_UPLOAD_BUDGET, MAX_MESH_UPLOAD_BUDGET
+    ),
+    memorySource([this](debug::MemoryBreakdown& breakdown) {
+        if (arena) {
+            size_t used = arena->getUsed();
+            breakdown["render.chunk-meshes"] += used;
+            breakdown["render.mesh-arena-free"] += arena->getCapacity() - used;
+        }
+    })
 {
     threadPool.setStopOnFail(false);
+    threadPool.setPriority(util::TaskScheduler::Priority::HIGH);
+    threadPool.setJobsPriority([this](const RendererJob& job) {
+        return getJobPriority(job);
+    });
+    sortingPool.setStopOnFail(false);
+    sortingPool.setPriority(util::TaskScheduler::Priority::HIGH);
     renderer = std::make_unique<BlocksRenderer>(
         settings.graphics.chunkMaxVertices.get(), 
         *level->content, cache, settings
     );
+    occlusion = std::make_unique<ChunksOcclusion>();
+    arena = std::make_unique<MeshArena>(
+        CHUNK_VATTRS,
+        ARENA_VERTEX_CAPACITY,
+        ARENA_INDEX_CAPACITY,
+        CHUNK_DRAW_ATTRS
+    );
     logger.info() << "created " << threadPool.getWorkersCount() << " workers";
 }
 
 ChunksRenderer::~ChunksRenderer() {
 }
 
-const Mesh* ChunksRenderer::render(
-    const std::shared_ptr<Chunk>& chunk, bool important
+const ArenaMesh* ChunksRenderer::setMesh(
+    const glm::ivec2& key, ChunkMeshData data
 ) {
-    chunk->flags.modified = false;
-    if (important) {
-        auto mesh = renderer->render(chunk.get(), level.chunks.get());
-        meshes[glm::ivec2(chunk->x, chunk->z)] = ChunkMesh {
-            std::move(mesh.mesh), std::move(mesh.sortingMeshData)
-        };
-        return meshes[glm::ivec2(chunk->x, chunk->z)].mesh.get();
+    auto& chunkMesh = meshes[key];
+    arena->free(chunkMesh.mesh);
+    chunkMesh.mesh = arena->allocate(data.mesh);
+    setSortingMesh(chunkMesh, std::move(data.sortingMesh));
+    chunkMesh.sections = std::move(data.sections);
+    chunkMesh.lod = data.lod;
+    updatedMeshes.push_back(key);
+    return &chunkMesh.mesh;
+}
+
+void ChunksRenderer::setSortingMesh(
+    ChunkMesh& chunkMesh, SortingMeshData data
+) {
+    chunkMesh.version++;
+    chunkMesh.sorting = false;
+    chunkMesh.sortedMesh = nullptr;
+    chunkMesh.sortingLayout = nullptr;
+    const auto& entries = data.entries;
+    if (entries.empty()) {
+        return;
+    }
+    auto layout = std::make_shared<SortingMeshLayout>();
+    size_t size = 0;
+    layout->offsets.push_back(0);
+    for (const auto& entry : entries) {
+        size += entry.vertexData.size();
+        layout->positions.push_back(entry.position);
+        layout->offsets.push_back(size / CHUNK_VERTEX_SIZE);
+    }
+    util::Buffer<float> buffer(size);
+    float* dst = buffer.data();
+    for (const auto& entry : entries) {
+        const auto& vertexData = entry.vertexData;
+        std::memcpy(dst, vertexData.data(), vertexData.size() * sizeof(float));
+        dst += vertexData.size();
+    }
+    chunkMesh.sortedMesh = std::make_unique<Mesh>(
+        buffer.data(), size / CHUNK_VERTEX_SIZE, CHUNK_VATTRS
+    );
+    if (entries.size() == 1) {
+        // single entry needs no sorting
+        return;
+    }
+    chunkMesh.sortingLayout = std::move(layout);
+    if (chunkMesh.sortingIndices == nullptr) {
+        chunkMesh.sortingIndices = std::make_shared<std::vector<int>>();
     }
+    // first drawn in the build order until sorted
+    chunkMesh.sortedFor = glm::vec3(INFINITY);
+}
+
+void ChunksRenderer::applySorted(SortingResult& result) {
+    auto found = meshes.find(result.key);
+    if (found == meshes.end()) {
+        return;
+    }
+    auto& chunkMesh = found->second;
+    if (chunkMesh.version != result.version ||
+        chunkMesh.sortedMesh == nullptr) {
+        return;
+    }
+    const auto& indices = *result.indices;
+    chunkMesh.sortedMesh->reloadIndices(indices.data(), indices.size());
+    chunkMesh.sortedFor = result.cameraPosition;
+    chunkMesh.sorting = false;
+    // uploaded buffer becomes the back buffer of the next sorting
+    chunkMesh.sortingIndices = std::move(result.indices);
+}
+
+float ChunksRenderer::getJobPriority(const RendererJob& job) {
+    const auto& chunk = *job.chunk;
+    glm::vec3 min(chunk.x * CHUNK_W, chunk.bottom, chunk.z * CHUNK_D);
+    glm::vec3 max(min.x + CHUNK_W, chunk.top, min.z + CHUNK_D);
+
+    std::lock_guard lock(view.mutex);
+    glm::vec3 center = (min + max) * 0.5f;
+    float priority = -glm::distance(
+        glm::vec2(center.x, center.z),
+        glm::vec2(view.position.x, view.position.z)
+    );
+    if (view.frustum.isBoxVisible(min, max)) {
+        priority += FRUSTUM_PRIORITY;
+    }
+    if (job.edited) {
+        priority += EDITED_PRIORITY;
+    }
+    return priority;
+}
+
+void ChunksRenderer::cancelStaleJobs() {
+    util::FrameVector<glm::ivec2> cancelled;
+    const auto& chunks = *level.chunks;
+    threadPool.cancelJobs([&cancelled, &chunks](const RendererJob& job) {
+        const auto& chunk = *job.chunk;
+        if (chunks.getChunk(chunk.x, chunk.z) == &chunk) {
+            return false;
+        }
+        cancelled.emplace_back(chunk.x, chunk.z);
+        return true;
+    });
+    for (const auto& key : cancelled) {
+        inwork.erase(key);
+    }
+}
+
+const ArenaMesh* ChunksRenderer::render(
+    const std::shared_ptr<Chunk>& chunk,
+    bool important,
+    bool keepSections,
+    int lod
+) {
     glm::ivec2 key(chunk->x, chunk->z);
-    if (inwork.find(key) != inwork.end()) {
+    auto inworkFound = inwork.find(key);
+    if (!important && inworkFound != inwork.end()) {
+        // keep the chunk modified to be rebuilt when the job is done
         return nullptr;
     }
+    chunk->flags.modified = false;
+    uint32_t dirtySections = chunk->dirtySections.exchange(0);
+
+    auto found = meshes.find(key);
+    bool edited = found != meshes.end() && found->second.lod == lod;
+    std::shared_ptr<const ChunkSections> sections;
+    if (keepSections) {
+        if (found != meshes.end() && found->second.sections) {
+            sections = found->second.sections;
+        } else {
+            sections = std::make_shared<ChunkSections>();
+        }
+    }
+    if (important) {
+        if (inworkFound != inwork.end()) {
+            // sections being rebuilt by the discarded job are unknown
+            dirtySections = Chunk::ALL_SECTIONS;
+            size_t cancelled = threadPool.cancelJobs(
+                [&chunk](const RendererJob& job) {
+                    return job.chunk == chunk;
+                }
+            );
+            if (cancelled) {
+                inwork.erase(inworkFound);
+            } else {
+                inworkFound->second = false;
+            }
+        }
+        build_chunk_mesh(
+            *renderer,
+            chunk.get(),
+            ChunksSnapshot(*level.chunks, chunk->x, chunk->z, 1),
+            sections.get(),
+            dirtySections,
+            lod
+        );
+        if (renderer->isCancelled()) {
+            return nullptr;
+        }
+        auto meshData = renderer->createMesh();
+        meshData.lod = lod;
+        return setMesh(key, std::move(meshData));
+    }
+    static auto& queuedCounter =
+        debug::Metrics::getInstance().counter("chunks.meshes-queued");
+    queuedCounter.add();
     inwork[key] = true;
-    threadPool.enqueueJob(chunk);
+    threadPool.enqueueJob(
+        RendererJob {
+            chunk,
+            ChunksSnapshot(*level.chunks, chunk->x, chunk->z, 1),
+            dirtySections,
+            std::move(sections),
+            lod,
+            edited,
+        }
+    );
     return nullptr;
 }
 
 void ChunksRenderer::unload(const Chunk* chunk) {
     auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
     if (found != meshes.end()) {
+        arena->free(found->second.mesh);
         meshes.erase(found);
+        updatedMeshes.emplace_back(chunk->x, chunk->z);
     }
+    occlusion->unload(glm::ivec2(chunk->x, chunk->z));
+    if (lightTextures) {
+        lightTextures->unload(chunk->x, chunk->z);
+    }
+    threadPool.cancelJobs([chunk](const RendererJob& job) {
+        return job.chunk.get() == chunk;
+    });
+    // result of the job being built is discarded
+    inwork.erase(glm::ivec2(chunk->x, chunk->z));
 }
 
 void ChunksRenderer::clear() {
+    for (const auto& [_, chunkMesh] : meshes) {
+        arena->free(chunkMesh.mesh);
+    }
     meshes.clear();
+    occlusion->clear();
     inwork.clear();
     threadPool.clearQueue();
+    sortingPool.clearQueue();
 }
 
-const Mesh* ChunksRenderer::getOrRender(
-    const std::shared_ptr<Chunk>& chunk, bool important
+const ArenaMesh* ChunksRenderer::getOrRender(
+    const std::shared_ptr<Chunk>& chunk,
+    bool important,
+    bool keepSections,
+    int lod
 ) {
+    if (uint32_t lights = chunk->lightSections.exchange(0)) {
+        if (lightTextures == nullptr ||
+            !lightTextures->updateLights(*chunk, lights)) {
+            chunk->dirtySections |= lights;
+            chunk->flags.modified = true;
+        }
+    }
     auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
     if (found == meshes.end()) {
-        return render(chunk, important);
+        return render(chunk, important, false, lod);
     }
-    if (chunk->flags.modified) {
-        render(chunk, important);
+    if (chunk->flags.modified || found->second.lod != lod) {
+        render(chunk, important, keepSections && lod == 1, lod);
     }
-    return found->second.mesh.get();
+    return &found->second.mesh;
+}
+
+void ChunksRenderer::setFrameTime(
+    int64_t frameTime, int64_t targetFrameTime
+) {
+    static auto& metrics = debug::Metrics::getInstance();
+    static auto& budgetGauge = metrics.gauge("chunks.budget.mesh");
+    static auto& spentGauge = metrics.gauge("chunks.spent.mesh");
+    meshBudget.update(frameTime, targetFrameTime);
+    budgetGauge.set(meshBudget.get());
+    spentGauge.set(meshBudget.getLastSpent());
 }
 
 void ChunksRenderer::update() {
+    cancelStaleJobs();
+    // at least one mesh is uploaded even if the budget is spent
+    threadPool.setUpdateBudget(std::max<int64_t>(meshBudget.getLeft(), 1));
+    timeutil::Timer timer;
     threadPool.update();
+    meshBudget.spend(timer.stop());
+    sortingPool.update();
 }
 
-const Mesh* ChunksRenderer::retrieveChunk(
-    size_t index, const Camera& camera, Shader& shader, bool culling
+const ArenaMesh* ChunksRenderer::retrieveChunk(
+    size_t index,
+    const Camera& camera,
+    Shader& shader,
+    bool visible,
+    bool occlusionCulling
 ) {
-    auto chunk = level.chunks->getChunks()[index];
+    const auto& chunk = level.chunks->getChunks()[index];
     if (chunk == nullptr || !chunk->flags.lighted) {
         return nullptr;
     }
@@ -143,37 +514,87 @@ const Mesh* ChunksRenderer::retrieveChunk(
             (chunk->z + 0.5f) * CHUNK_D
         )
     );
-    auto mesh = getOrRender(chunk, distance < CHUNK_W * 1.5f);
+    int lod = 1;
+    if (int lodDistance = settings.graphics.lodDistance.get()) {
+        auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
+        int current = found == meshes.end() ? 1 : found->second.lod;
+        lod = pick_lod(distance, current, lodDistance * CHUNK_W);
+    }
+    auto mesh = getOrRender(
+        chunk,
+        distance < CHUNK_W * 1.5f,
+        distance < KEEP_SECTIONS_DISTANCE,
+        lod
+    );
     if (mesh == nullptr) {
         return nullptr;
     }
-    if (culling) {
-        glm::vec3 min(chunk->x * CHUNK_W, chunk->bottom, chunk->z * CHUNK_D);
-        glm::vec3 max(
-            chunk->x * CHUNK_W + CHUNK_W,
-            chunk->top,
-            chunk->z * CHUNK_D + CHUNK_D
-        );
-
-        if (!frustum.isBoxVisible(min, max)) return nullptr;
+    if (!visible) {
+        return nullptr;
+    }
+    if (occlusionCulling && !occlusion->isVisible(*chunk)) {
+        occludedChunks++;
+        return nullptr;
     }
     return mesh;
 }
 
-void ChunksRenderer::drawChunks(
-    const Camera& camera, Shader& shader
-) {
-    const auto& chunks = *level.chunks;
+void ChunksRenderer::bindTextures(Shader& shader) const {
     const auto& atlas = assets.require<Atlas>("blocks");
-
     atlas.getTexture()->bind();
-    update();
 
-    // [warning] this whole method is not thread-safe for chunks
+    glActiveTexture(GL_TEXTURE2);
+    cache.getRegionsTexture()->bind();
+    const auto textureArray = cache.getTextureArray();
+    glActiveTexture(GL_TEXTURE3);
+    if (textureArray) {
+        textureArray->bind();
+    } else {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    if (lightTextures) {
+        lightTextures->bind(shader);
+    } else {
+        LightTextures::disable(shader);
+    }
+    cache.getAnimationsBuffer()->bind(Shader::ANIMATION_UNIFORMS_BINDING);
+    shader.uniform1i("u_regions", 2);
+    shader.uniform1i("u_blocks", 3);
+    shader.uniform1i("u_textureArray", textureArray != nullptr);
+}
 
+void ChunksRenderer::updateLightTextures(const Camera& camera) {
+    if (!settings.graphics.lightTextures.get()) {
+        if (lightTextures) {
+            lightTextures->release(*level.chunks);
+            lightTextures.reset();
+        }
+        return;
+    }
+    if (lightTextures == nullptr) {
+        lightTextures = std::make_unique<LightTextures>();
+    }
+    lightTextures->update(*level.chunks, camera.position);
+}
+
+void ChunksRenderer::sortChunks(const Camera& camera) {
+    const auto& chunks = *level.chunks;
     int chunksWidth = chunks.getWidth();
-    int chunksOffsetX = chunks.getOffsetX();
-    int chunksOffsetY = chunks.getOffsetY();
+    glm::ivec2 offset(chunks.getOffsetX(), chunks.getOffsetY());
+    glm::ivec2 cameraChunk(
+        std::floor(camera.position.x / CHUNK_W),
+        std::floor(camera.position.z / CHUNK_D)
+    );
+    // order inside of a chunk does not matter much for opaque meshes
+    if (indices.size() == chunks.getVolume() &&
+        sorted.width == chunksWidth && sorted.offset == offset &&
+        sorted.cameraChunk == cameraChunk) {
+        return;
+    }
+    sorted.width = chunksWidth;
+    sorted.offset = offset;
+    sorted.cameraChunk = cameraChunk;
 
     if (indices.size() != chunks.getVolume()) {
         indices.clear();
@@ -184,61 +605,268 @@ void ChunksRenderer::drawChunks(
     float px = camera.position.x / static_cast<float>(CHUNK_W) - 0.5f;
     float pz = camera.position.z / static_cast<float>(CHUNK_D) - 0.5f;
     for (auto& index : indices) {
-        float x = index.index % chunksWidth + chunksOffsetX - px;
-        float z = index.index / chunksWidth + chunksOffsetY - pz;
+        auto position = chunks.getPosition(index.index);
+        float x = position.x - px;
+        float z = position.y - pz;
         index.d = (x * x + z * z) * 1024;
     }
     util::insertion_sort(indices.begin(), indices.end());
+}
+
+void ChunksRenderer::cullChunks() {
+    const auto& chunks = *level.chunks;
+    const auto& chunksList = chunks.getChunks();
+    int groupsW = (chunks.getWidth() + CULLING_GROUP_SIZE - 1) /
+                  CULLING_GROUP_SIZE;
+    int groupsH = (chunks.getHeight() + CULLING_GROUP_SIZE - 1) /
+                  CULLING_GROUP_SIZE;
+    size_t groupsCount = groupsW * groupsH;
+
+    // group box encloses boxes of its chunks, so chunks of a group
+    // outside of the frustum are outside too
+    glm::vec3 inf(std::numeric_limits<float>::infinity());
+    util::FrameVector<std::pair<glm::vec3, glm::vec3>> bounds(
+        groupsCount, {inf, -inf}
+    );
+    chunksGroups.resize(indices.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        const auto& chunk = chunksList[indices[i].index];
+        if (chunk == nullptr) {
+            continue;
+        }
+        int lx = chunk->x - chunks.getOffsetX();
+        int lz = chunk->z - chunks.getOffsetY();
+        uint group = lz / CULLING_GROUP_SIZE * groupsW +
+                     lx / CULLING_GROUP_SIZE;
+        chunksGroups[i] = group;
+        glm::vec3 min(chunk->x * CHUNK_W, chunk->bottom, chunk->z * CHUNK_D);
+        glm::vec3 max(min.x + CHUNK_W, chunk->top, min.z + CHUNK_D);
+        bounds[group].first = glm::min(bounds[group].first, min);
+        bounds[group].second = glm::max(bounds[group].second, max);
+    }
+    groupsBoxes.clear();
+    for (const auto& [min, max] : bounds) {
+        if (min.x > max.x) {
+            groupsBoxes.push({}, {});
+        } else {
+            groupsBoxes.push(min, max);
+        }
+    }
+    frustum.areBoxesVisible(groupsBoxes, groupsVisible);
+
+    boxes.clear();
+    boxesIndices.clear();
+    for (size_t i = 0; i < indices.size(); i++) {
+        const auto& chunk = chunksList[indices[i].index];
+        if (chunk == nullptr || !groupsVisible[chunksGroups[i]]) {
+            continue;
+        }
+        glm::vec3 min(chunk->x * CHUNK_W, chunk->bottom, chunk->z * CHUNK_D);
+        boxes.push(min, {min.x + CHUNK_W, chunk->top, min.z + CHUNK_D});
+        boxesIndices.push_back(i);
+    }
+    frustum.areBoxesVisible(boxes, chunksVisible);
+    boxesVisible.assign(indices.size(), 0);
+    for (size_t i = 0; i < boxesIndices.size(); i++) {
+        boxesVisible[boxesIndices[i]] = chunksVisible[i];
+    }
+}
+
+void ChunksRenderer::drawChunks(
+    const Camera& camera, Shader& shader
+) {
+    const auto& chunks = *level.chunks;
+
+    updateLightTextures(camera);
+    bindTextures(shader);
+    {
+        std::lock_guard lock(view.mutex);
+        view.position = camera.position;
+        view.frustum = frustum;
+    }
+    update();
+
+    // [warning] this whole method is not thread-safe for chunks
+
+    sortChunks(camera);
 
     bool culling = settings.graphics.frustumCulling.get();
+    const auto& chunksList = chunks.getChunks();
+    if (culling) {
+        cullChunks();
+    }
+    bool occlusionCulling = settings.graphics.occlusionCulling.get();
+    if (occlusionCulling) {
+        occlusion->update();
+    }
+    bool multiDraw = settings.graphics.multiDrawIndirect.get() &&
+                     arena->isMultiDrawSupported();
 
     visibleChunks = 0;
+    occludedChunks = 0;
+    visibleVertices = 0;
+    meshesMemory = arena->getUsed();
     shader.uniform1i("u_alphaClip", true);
+    if (multiDraw) {
+        // chunk offsets are passed as per-draw attributes
+        shader.uniformMatrix(U_MODEL, glm::mat4(1.0f));
+        drawMeshes.clear();
+        drawOffsets.clear();
+    }
 
-    // TODO: minimize draw calls number
     for (int i = indices.size()-1; i >= 0; i--) {
-        auto& chunk = chunks.getChunks()[indices[i].index];
-        auto mesh = retrieveChunk(indices[i].index, camera, shader, culling);
+        auto& chunk = chunksList[indices[i].index];
+        bool visible = !culling || boxesVisible[i];
+        if (visible && chunk && impostors.distance > 0.0f) {
+            visible = is_near(
+                chunk->x, chunk->z, impostors.center, impostors.distance
+            );
+        }
+        auto mesh = retrieveChunk(
+            indices[i].index, camera, shader, visible, occlusionCulling
+        );
 
         if (mesh) {
             glm::vec3 coord(
                 chunk->x * CHUNK_W + 0.5f, 0.5f, chunk->z * CHUNK_D + 0.5f
             );
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
-            shader.uniformMatrix("u_model", model);
-            mesh->draw();
+            if (multiDraw) {
+                drawMeshes.push_back(*mesh);
+                drawOffsets.insert(
+                    drawOffsets.end(), {coord.x, coord.y, coord.z}
+                );
+            } else {
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
+                shader.uniformMatrix(U_MODEL, model);
+                arena->draw(*mesh);
+            }
             visibleChunks++;
+            visibleVertices += mesh->vertexCount;
+        }
+    }
+    if (multiDraw) {
+        arena->drawMulti(drawMeshes, drawOffsets);
+    }
+    arena->unbind();
+    arena->update();
+
+    if (occlusionCulling) {
+        occlusion->test(camera, assets.require<Shader>("occlusion"));
+    }
+    static auto& metrics = debug::Metrics::getInstance();
+    static auto& visibleGauge = metrics.gauge("chunks.visible");
+    static auto& occludedGauge = metrics.gauge("chunks.occluded");
+    static auto& memoryGauge = metrics.gauge("chunks.meshes-memory");
+    visibleGauge.set(visibleChunks);
+    occludedGauge.set(occludedChunks);
+    memoryGauge.set(meshesMemory);
+}
+
+void ChunksRenderer::drawShadowCasters(const Frustum& frustum, Shader& shader) {
+    const auto& chunks = *level.chunks;
+    casters.clear();
+    castersBoxes.clear();
+    for (const auto& [key, chunkMesh] : meshes) {
+        const Chunk* chunk = chunks.getChunk(key.x, key.y);
+        if (chunk == nullptr || chunkMesh.mesh.empty()) {
+            continue;
         }
+        glm::vec3 min(key.x * CHUNK_W, chunk->bottom, key.y * CHUNK_D);
+        castersBoxes.push(min, {min.x + CHUNK_W, chunk->top, min.z + CHUNK_D});
+        casters.emplace_back(key, chunkMesh.mesh);
     }
+    frustum.areBoxesVisible(castersBoxes, castersVisible);
+    drawCasters(shader);
 }
 
-static inline void write_sorting_mesh_entries(
-    float* buffer, const std::vector<SortingMeshEntry>& chunkEntries
+void ChunksRenderer::drawCasters(Shader& shader) {
+    bool multiDraw = settings.graphics.multiDrawIndirect.get() &&
+                     arena->isMultiDrawSupported();
+    if (multiDraw) {
+        shader.uniformMatrix(U_MODEL, glm::mat4(1.0f));
+        drawMeshes.clear();
+        drawOffsets.clear();
+    }
+    for (size_t i = 0; i < casters.size(); i++) {
+        if (!castersVisible[i] || casters[i].second.empty()) {
+            continue;
+        }
+        const auto& [key, mesh] = casters[i];
+        glm::vec3 coord(key.x * CHUNK_W + 0.5f, 0.5f, key.y * CHUNK_D + 0.5f);
+        if (multiDraw) {
+            drawMeshes.push_back(mesh);
+            drawOffsets.insert(drawOffsets.end(), {coord.x, coord.y, coord.z});
+        } else {
+            shader.uniformMatrix(
+                U_MODEL, glm::translate(glm::mat4(1.0f), coord)
+            );
+            arena->draw(mesh);
+        }
+    }
+    if (multiDraw) {
+        arena->drawMulti(drawMeshes, drawOffsets);
+    }
+    arena->unbind();
+}
+
+void ChunksRenderer::setImpostorsArea(
+    const glm::vec3& center, float distance
 ) {
-    for (const auto& entry : chunkEntries) {
-        const auto& vertexData = entry.vertexData;
-        std::memcpy(
-            buffer,
-            vertexData.data(),
-            vertexData.size() * sizeof(float)
-        );
-        buffer += vertexData.size();
+    impostors.center = center;
+    impostors.distance = distance;
+}
+
+void ChunksRenderer::drawImpostorMeshes(
+    const Camera& camera, Shader& shader, float distance
+) {
+    const auto& chunks = *level.chunks;
+    casters.clear();
+    castersBoxes.clear();
+    for (const auto& [key, chunkMesh] : meshes) {
+        const Chunk* chunk = chunks.getChunk(key.x, key.y);
+        if (chunk == nullptr ||
+            is_near(key.x, key.y, camera.position, distance) ||
+            (chunkMesh.mesh.empty() && chunkMesh.sortedMesh == nullptr)) {
+            continue;
+        }
+        glm::vec3 min(key.x * CHUNK_W, chunk->bottom, key.y * CHUNK_D);
+        castersBoxes.push(min, {min.x + CHUNK_W, chunk->top, min.z + CHUNK_D});
+        casters.emplace_back(key, chunkMesh.mesh);
+    }
+    Frustum cameraFrustum;
+    cameraFrustum.update(camera.getProjView());
+    cameraFrustum.areBoxesVisible(castersBoxes, castersVisible);
+
+    bindTextures(shader);
+    shader.uniform1i("u_alphaClip", true);
+    drawCasters(shader);
+
+    // translucent faces of far chunks are drawn in the build order
+    shader.uniform1i("u_alphaClip", false);
+    for (size_t i = 0; i < casters.size(); i++) {
+        const auto& key = casters[i].first;
+        const auto& chunkMesh = meshes.find(key)->second;
+        if (!castersVisible[i] || chunkMesh.sortedMesh == nullptr) {
+            continue;
+        }
+        glm::vec3 coord(key.x * CHUNK_W + 0.5f, 0.5f, key.y * CHUNK_D + 0.5f);
+        shader.uniformMatrix(U_MODEL, glm::translate(glm::mat4(1.0f), coord));
+        chunkMesh.sortedMesh->draw();
     }
 }
 
-void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
-    const int sortInterval = TRANSLUCENT_BLOCKS_SORT_INTERVAL;
-    static int frameid = 0;
-    frameid++;
+void ChunksRenderer::takeUpdatedMeshes(std::vector<glm::ivec2>& dst) {
+    dst.clear();
+    std::swap(dst, updatedMeshes);
+}
 
+void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
     bool culling = settings.graphics.frustumCulling.get();
     const auto& chunks = level.chunks->getChunks();
     const auto& cameraPos = camera.position;
-    const auto& atlas = assets.require<Atlas>("blocks");
 
     shader.use();
-    atlas.getTexture()->bind();
-    shader.uniformMatrix("u_model", glm::mat4(1.0f));
+    bindTextures(shader);
     shader.uniform1i("u_alphaClip", false);
     
     for (const auto& index : indices) {
@@ -246,10 +874,37 @@ void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
         if (chunk == nullptr || !chunk->flags.lighted) {
             continue;
         }
+        if (impostors.distance > 0.0f &&
+            !is_near(
+                chunk->x, chunk->z, impostors.center, impostors.distance
+            )) {
+            continue;
+        }
         const auto& found = meshes.find(glm::ivec2(chunk->x, chunk->z));
-        if (found == meshes.end() || found->second.sortingMeshData.entries.empty()) {
+        if (found == meshes.end() || found->second.sortedMesh == nullptr) {
             continue;
         }
+        auto& chunkMesh = found->second;
+
+        glm::vec3 coord(
+            chunk->x * CHUNK_W + 0.5f, 0.5f, chunk->z * CHUNK_D + 0.5f
+        );
+        if (chunkMesh.sortingLayout && !chunkMesh.sorting) {
+            float threshold = std::max(
+                TRANSLUCENT_BLOCKS_SORT_DISTANCE,
+                glm::distance(cameraPos, coord) * SORT_DISTANCE_FACTOR
+            );
+            if (glm::distance2(cameraPos, chunkMesh.sortedFor) >
+                threshold * threshold) {
+                chunkMesh.sorting = true;
+                sortingPool.enqueueJob(SortingJob {
+                    found->first,
+                    chunkMesh.version,
+                    cameraPos,
+                    chunkMesh.sortingLayout,
+                    std::move(chunkMesh.sortingIndices)});
+            }
+        }
 
         if (culling) {
             glm::vec3 min(chunk->x * CHUNK_W, chunk->bottom, chunk->z * CHUNK_D);
@@ -261,43 +916,7 @@ void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
 
             if (!frustum.isBoxVisible(min, max)) continue;
         }
-
-        auto& chunkEntries = found->second.sortingMeshData.entries;
-
-        if (chunkEntries.size() == 1) {
-            auto& entry = chunkEntries.at(0);
-            if (found->second.sortedMesh == nullptr) {
-                found->second.sortedMesh = std::make_unique<Mesh>(
-                    entry.vertexData.data(),
-                    entry.vertexData.size() / CHUNK_VERTEX_SIZE,
-                    CHUNK_VATTRS
-                );
-            }
-            found->second.sortedMesh->draw();
-            continue;
-        }
-        for (auto& entry : chunkEntries) {
-            entry.distance = static_cast<long long>(
-                glm::distance2(entry.position, cameraPos)
-            );
-        }
-        if (found->second.sortedMesh == nullptr ||
-            (frameid + chunk->x) % sortInterval == 0) {
-            std::sort(chunkEntries.begin(), chunkEntries.end());
-            size_t size = 0;
-            for (const auto& entry : chunkEntries) {
-                size += entry.vertexData.size();
-            }
-
-            static util::Buffer<float> buffer;
-            if (buffer.size() < size) {
-                buffer = util::Buffer<float>(size);
-            }
-            write_sorting_mesh_entries(buffer.data(), chunkEntries);
-            found->second.sortedMesh = std::make_unique<Mesh>(
-                buffer.data(), size / CHUNK_VERTEX_SIZE, CHUNK_VATTRS
-            );
-        }
-        found->second.sortedMesh->draw();
+        shader.uniformMatrix(U_MODEL, glm::translate(glm::mat4(1.0f), coord));
+        chunkMesh.sortedMesh->draw();
     }
 }
@@ -1,20 +1,26 @@
 #pragma once
 
 #include <queue>
+#include <mutex>
 #include <memory>
 #include <vector>
-#include <unordered_map>
 
 #include <glm/glm.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+#include "debug/MemoryUsage.hpp"
 #include "voxels/Block.hpp"
+#include "voxels/ChunksSnapshot.hpp"
+#include "util/AdaptiveBudget.hpp"
 #include "util/ThreadPool.hpp"
+#include "util/FlatHashMap.hpp"
 #include "graphics/core/MeshData.hpp"
+#include "maths/FrustumCulling.hpp"
 #include "commons.hpp"
 
 class Mesh;
+class MeshArena;
 class Chunk;
 class Level;
 class Camera;
@@ -22,6 +28,8 @@ class Shader;
 class Assets;
 class Frustum;
 class BlocksRenderer;
+class ChunksOcclusion;
+class LightTextures;
 class ContentGfxCache;
 struct EngineSettings;
 
@@ -34,26 +42,138 @@ struct ChunksSortEntry {
     }
 };
 
+struct RendererJob {
+    std::shared_ptr<Chunk> chunk;
+    /// @brief Chunk and its neighbours captured at the job creation
+    ChunksSnapshot neighbours;
+    /// @brief Bit mask of sections to be rebuilt
+    uint32_t dirtySections;
+    /// @brief Previous sections meshes or nullptr if not kept
+    std::shared_ptr<const ChunkSections> sections;
+    /// @brief Mesh level of detail, see ChunkMesh::lod
+    int lod;
+    /// @brief Rebuild of the chunk modified since the last build
+    /// (freshly loaded chunks and level of detail changes are false)
+    bool edited;
+};
+
 struct RendererResult {
     glm::ivec2 key;
     bool cancelled;
     ChunkMeshData meshData;
 };
 
+struct SortingJob {
+    glm::ivec2 key;
+    /// @brief Chunk mesh version, see ChunkMesh::version
+    uint32_t version;
+    glm::vec3 cameraPosition;
+    std::shared_ptr<const SortingMeshLayout> layout;
+    /// @brief Back buffer to be filled with sorted indices
+    std::shared_ptr<std::vector<int>> indices;
+};
+
+struct SortingResult {
+    glm::ivec2 key;
+    uint32_t version;
+    glm::vec3 cameraPosition;
+    std::shared_ptr<std::vector<int>> indices;
+};
+
 class ChunksRenderer {
     const Level& level;
     const Assets& assets;
     const Frustum& frustum;
+    const ContentGfxCache& cache;
     const EngineSettings& settings;
 
     std::unique_ptr<BlocksRenderer> renderer;
-    std::unordered_map<glm::ivec2, ChunkMesh> meshes;
-    std::unordered_map<glm::ivec2, bool> inwork;
+    /// @brief Shared GPU buffers of all chunks opaque meshes
+    std::unique_ptr<MeshArena> arena;
+    std::unique_ptr<ChunksOcclusion> occlusion;
+    /// @brief Lights of chunks around the camera sampled by the shader,
+    /// nullptr if lights are baked into vertices only
+    std::unique_ptr<LightTextures> lightTextures;
+    util::FlatHashMap<glm::ivec2, ChunkMesh> meshes;
+    /// @brief Chunks being built by workers. False value means the result
+    /// is outdated and will be discarded
+    util::FlatHashMap<glm::ivec2, bool> inwork;
+    /// @brief Camera state of the last frame used to prioritize jobs
+    struct {
+        std::mutex mutex;
+        glm::vec3 position {};
+        Frustum frustum;
+    } view;
+    /// @brief Chunks matrix indices sorted by distance to the camera
     std::vector<ChunksSortEntry> indices;
-    util::ThreadPool<std::shared_ptr<Chunk>, RendererResult> threadPool;
-    const Mesh* retrieveChunk(
-        size_t index, const Camera& camera, Shader& shader, bool culling
+    /// @brief Camera chunk and matrix placement the indices are sorted for
+    struct {
+        glm::ivec2 cameraChunk {};
+        glm::ivec2 offset {};
+        int width = 0;
+    } sorted;
+    /// @brief Sorted chunks boxes and their frustum culling results
+    PackedBoxes boxes;
+    std::vector<uint8_t> boxesVisible;
+    /// @brief Boxes of chunks groups (CULLING_GROUP_SIZE x CULLING_GROUP_SIZE
+    /// chunks of the matrix) tested before the chunks
+    PackedBoxes groupsBoxes;
+    std::vector<uint8_t> groupsVisible;
+    /// @brief Sorted chunks group indices and indices of the chunks
+    /// of visible groups tested by boxes
+    std::vector<uint> chunksGroups;
+    std::vector<uint> boxesIndices;
+    std::vector<uint8_t> chunksVisible;
+    /// @brief Shadow casters or impostors meshes and boxes
+    std::vector<std::pair<glm::ivec2, ArenaMesh>> casters;
+    PackedBoxes castersBoxes;
+    std::vector<uint8_t> castersVisible;
+    /// @brief Area around the center where chunks are drawn, farther
+    /// chunks are drawn by the impostors ring (zero distance - disabled)
+    struct {
+        glm::vec3 center {};
+        float distance = 0.0f;
+    } impostors;
+    /// @brief Chunks with meshes changed or removed since the last
+    /// takeUpdatedMeshes call
+    std::vector<glm::ivec2> updatedMeshes;
+    /// @brief Visible meshes and their offsets for multi-draw
+    std::vector<ArenaMesh> drawMeshes;
+    std::vector<float> drawOffsets;
+    util::ThreadPool<RendererJob, RendererResult> threadPool;
+    /// @brief Translucent faces sorting workers
+    util::ThreadPool<SortingJob, SortingResult> sortingPool;
+    /// @brief Time budget of built meshes uploading
+    util::AdaptiveBudget meshBudget;
+    debug::MemorySource memorySource;
+    const ArenaMesh* retrieveChunk(
+        size_t index,
+        const Camera& camera,
+        Shader& shader,
+        bool visible,
+        bool occlusionCulling
     );
+    /// @brief Sort chunks by distance if the camera moved to another
+    /// chunk or the chunks matrix changed
+    void sortChunks(const Camera& camera);
+    /// @brief Test sorted chunks visibility (fills boxesVisible), rejecting
+    /// chunks of invisible groups without testing them
+    void cullChunks();
+    const ArenaMesh* setMesh(const glm::ivec2& key, ChunkMeshData data);
+    /// @brief Upload translucent entries vertices of the chunk mesh
+    void setSortingMesh(ChunkMesh& chunkMesh, SortingMeshData data);
+    /// @brief Swap sorted indices to the chunk mesh if still actual
+    void applySorted(SortingResult& result);
+    /// @brief Mesh job priority, called from worker threads
+    float getJobPriority(const RendererJob& job);
+    /// @brief Remove queued jobs of chunks not loaded anymore
+    void cancelStaleJobs();
+    /// @brief Create, move or release lights texture according to settings
+    void updateLightTextures(const Camera& camera);
+    /// @brief Bind blocks atlas and its regions table used by chunk vertices
+    void bindTextures(Shader& shader) const;
+    /// @brief Draw opaque meshes of casters visible in castersVisible
+    void drawCasters(Shader& shader);
 public:
     ChunksRenderer(
         const Level* level,
@@ -64,20 +184,65 @@ public:
     );
     virtual ~ChunksRenderer();
 
-    const Mesh* render(
-        const std::shared_ptr<Chunk>& chunk, bool important
+    /// @brief Build chunk mesh
+    /// @param important build the mesh immediately in the current thread
+    /// @param keepSections keep sections meshes, so the next rebuild
+    /// will process modified sections only
+    /// @param lod surface cell size for simplified mesh, 1 is full detail
+    const ArenaMesh* render(
+        const std::shared_ptr<Chunk>& chunk,
+        bool important,
+        bool keepSections = false,
+        int lod = 1
     );
     void unload(const Chunk* chunk);
     void clear();
 
-    const Mesh* getOrRender(
-        const std::shared_ptr<Chunk>& chunk, bool important
+    /// @brief Get chunk mesh, rebuild it if the chunk is modified or
+    /// level of detail is changed
+    const ArenaMesh* getOrRender(
+        const std::shared_ptr<Chunk>& chunk,
+        bool important,
+        bool keepSections = false,
+        int lod = 1
     );
     void drawChunks(const Camera& camera, Shader& shader);
 
     void drawSortedMeshes(const Camera& camera, Shader& shader);
 
+    /// @brief Draw built opaque meshes of the chunks visible in the frustum
+    /// without textures and meshes updates (shadow maps)
+    /// @param shader depth-only shader in use
+    void drawShadowCasters(const Frustum& frustum, Shader& shader);
+
+    /// @brief Set area drawn by drawChunks and drawSortedMeshes, meshes of
+    /// farther chunks are still built
+    /// @param distance area radius (blocks), 0 - no limit
+    void setImpostorsArea(const glm::vec3& center, float distance);
+
+    /// @brief Draw built meshes of the chunks not nearer than the distance
+    /// to the camera without meshes updates (impostors baking)
+    /// @param shader world shader in use
+    void drawImpostorMeshes(
+        const Camera& camera, Shader& shader, float distance
+    );
+
+    /// @brief Move positions of chunks with meshes changed or removed since
+    /// the previous call to the destination
+    void takeUpdatedMeshes(std::vector<glm::ivec2>& dst);
+
     void update();
 
+    /// @brief Adapt meshes uploading time budget to the last frame time
+    /// @param frameTime last frame main thread work time (microseconds)
+    /// @param targetFrameTime target frame time (microseconds)
+    void setFrameTime(int64_t frameTime, int64_t targetFrameTime);
+
     static size_t visibleChunks;
+    /// @brief Chunks skipped by occlusion culling in the last frame
+    static size_t occludedChunks;
+    /// @brief Vertices count of chunk meshes drawn in the last frame
+    static size_t visibleVertices;
+    /// @brief Size of chunk meshes stored in the mesh arena in bytes
+    static size_t meshesMemory;
 };
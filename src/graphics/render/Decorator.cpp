@@ -6,6 +6,8 @@
 #include "TextNote.hpp"
 #include "assets/assets_util.hpp"
 #include "content/Content.hpp"
+#include "maths/voxmaths.hpp"
+#include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
 #include "voxels/Block.hpp"
 #include "world/Level.hpp"
@@ -18,15 +20,8 @@
 
 namespace fs = std::filesystem;
 
-/// @brief Not greather than 64 for this BIG_PRIME value
+/// @brief Size of the area around the camera where decorations are added
 inline constexpr int UPDATE_AREA_DIAMETER = 32;
-/// @brief Number of blocks in the volume
-inline constexpr int UPDATE_BLOCKS =
-    UPDATE_AREA_DIAMETER * UPDATE_AREA_DIAMETER * UPDATE_AREA_DIAMETER;
-/// @brief Number of update iterations
-inline constexpr int ITERATIONS = 512;
-/// @brief Big prime number used for pseudo-random 3d array iteration
-inline constexpr int BIG_PRIME = 666667;
 
 Decorator::Decorator(
     Engine& engine, LevelController& controller, WorldRenderer& renderer, const Assets& assets
@@ -46,11 +41,12 @@ Decorator::Decorator(
         if (id == controller.getPlayer()->getId()) {
             continue;
         }
-        playerTexts[id] = renderer.texts->add(std::make_unique<TextNote>(
+        auto note = renderer.texts->add(std::make_unique<TextNote>(
             util::str2wstr_utf8(player->getName()),
             playerNamePreset,
             player->getPosition()
         ));
+        playerTexts[id] = {note, player->getName()};
     }
     playerNamePreset.deserialize(engine.getResPaths()->readCombinedObject(
         "presets/text3d/player_name.toml"
@@ -74,34 +70,46 @@ void Decorator::addParticles(const Block& def, const glm::ivec3& pos) {
     }
 }
 
-void Decorator::update(
-    float delta, const glm::ivec3& areaStart, const glm::ivec3& areaCenter
-) {
-    int index = currentIndex;
-    currentIndex = (currentIndex + BIG_PRIME) % UPDATE_BLOCKS;
-
+void Decorator::update(const glm::ivec3& areaStart) {
     const auto& chunks = *level.chunks;
     const auto& indices = *level.content->getIndices();
+    glm::ivec3 areaEnd = areaStart + glm::ivec3(UPDATE_AREA_DIAMETER);
 
-    int lx = index % UPDATE_AREA_DIAMETER;
-    int lz = (index / UPDATE_AREA_DIAMETER) % UPDATE_AREA_DIAMETER;
-    int ly = (index / UPDATE_AREA_DIAMETER / UPDATE_AREA_DIAMETER);
-    
-    auto pos = areaStart + glm::ivec3(lx, ly, lz);
-
-    if (auto vox = chunks.get(pos)) {
-        const auto& def = indices.blocks.require(vox->id);
-        if (def.particles) {
-            addParticles(def, pos);
+    int cx1 = floordiv(areaStart.x, CHUNK_W);
+    int cz1 = floordiv(areaStart.z, CHUNK_D);
+    int cx2 = floordiv(areaEnd.x - 1, CHUNK_W);
+    int cz2 = floordiv(areaEnd.z - 1, CHUNK_D);
+    for (int cz = cz1; cz <= cz2; cz++) {
+        for (int cx = cx1; cx <= cx2; cx++) {
+            auto chunk = chunks.getChunk(cx, cz);
+            if (chunk == nullptr) {
+                continue;
+            }
+            glm::ivec3 origin(cx * CHUNK_W, 0, cz * CHUNK_D);
+            for (uint index : chunks.getDecorations(*chunk)) {
+                glm::ivec3 pos = origin + glm::ivec3(
+                    index % CHUNK_W,
+                    index / (CHUNK_W * CHUNK_D),
+                    index / CHUNK_W % CHUNK_D
+                );
+                if (glm::any(glm::lessThan(pos, areaStart)) ||
+                    glm::any(glm::greaterThan(pos, areaEnd - 1))) {
+                    continue;
+                }
+                const auto& def =
+                    indices.blocks.require(chunk->voxels.get(index).id);
+                if (def.particles) {
+                    addParticles(def, pos);
+                }
+            }
         }
     }
 }
 
 void Decorator::update(float delta, const Camera& camera) {
     glm::ivec3 pos = camera.position;
-    for (int i = 0; i < ITERATIONS; i++) {
-        update(delta, pos - glm::ivec3(UPDATE_AREA_DIAMETER / 2), pos);
-    }
+    update(pos - glm::ivec3(UPDATE_AREA_DIAMETER / 2));
+
     const auto& chunks = *level.chunks;
     const auto& indices = *level.content->getIndices();
     auto iter = blockEmitters.begin();
@@ -139,20 +147,27 @@ void Decorator::update(float delta, const Camera& camera) {
             playerTexts.find(id) != playerTexts.end()) {
             continue;
         }
-        playerTexts[id] = renderer.texts->add(std::make_unique<TextNote>(
+        auto note = renderer.texts->add(std::make_unique<TextNote>(
             util::str2wstr_utf8(player->getName()),
             playerNamePreset,
             player->getPosition()
         ));
+        playerTexts[id] = {note, player->getName()};
     }
 
     auto textsIter = playerTexts.begin();
     while (textsIter != playerTexts.end()) {
-        auto note = renderer.texts->get(textsIter->second);
+        auto& text = textsIter->second;
+        auto note = renderer.texts->get(text.note);
         auto player = level.players->get(textsIter->first);
         if (player == nullptr) {
             textsIter = playerTexts.erase(textsIter);
         } else {
+            // names are rarely changed, so converted only if differ
+            if (text.name != player->getName()) {
+                text.name = player->getName();
+                note->setText(util::str2wstr_utf8(text.name));
+            }
             note->setPosition(player->getPosition() + glm::vec3(0, 1, 0));
             ++textsIter;
         }
@@ -4,6 +4,7 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+#include <string>
 #include <unordered_map>
 
 #include "typedefs.hpp"
@@ -26,13 +27,16 @@ class Decorator {
     Player& player;
     WorldRenderer& renderer;
     std::unordered_map<glm::ivec3, uint64_t> blockEmitters;
-    std::unordered_map<int64_t, u64id_t> playerTexts;
-    int currentIndex = 0;
+    struct PlayerText {
+        u64id_t note;
+        /// @brief Player name the note text is converted from
+        std::string name;
+    };
+    std::unordered_map<int64_t, PlayerText> playerTexts;
     NotePreset playerNamePreset {};
 
-    void update(
-        float delta, const glm::ivec3& areaStart, const glm::ivec3& areaCenter
-    );
+    /// @brief Add emitters of decorative blocks in the area
+    void update(const glm::ivec3& areaStart);
     void addParticles(const Block& def, const glm::ivec3& pos);
 public:
     Decorator(
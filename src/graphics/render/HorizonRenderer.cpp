@@ -0,0 +1,328 @@
+#include "HorizonRenderer.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "assets/Assets.hpp"
+#include "content/Content.hpp"
+#include "debug/Profiler.hpp"
+#include "files/WorldFiles.hpp"
+#include "files/WorldRegions.hpp"
+#include "frontend/ContentGfxCache.hpp"
+#include "graphics/core/Atlas.hpp"
+#include "graphics/core/DrawContext.hpp"
+#include "graphics/core/ImageData.hpp"
+#include "graphics/core/Mesh.hpp"
+#include "graphics/core/Shader.hpp"
+#include "maths/voxmaths.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/ChunkSummary.hpp"
+#include "window/Camera.hpp"
+#include "world/Level.hpp"
+#include "world/World.hpp"
+
+/// @brief Tile samples per side: region cells and the first cells row
+/// of the next region closing the gap between tiles
+static constexpr int TILE_SAMPLES = REGION_SIZE * ChunkSummary::CELLS_W + 1;
+/// @brief Tiles older than this are rebuilt (seconds)
+static constexpr float TILE_REFRESH_TIME = 60.0f;
+/// @brief Max tiles built at once
+static constexpr size_t MAX_TILES_IN_WORK = 4;
+/// @brief Horizon is lowered to be covered by loaded chunks surfaces
+static constexpr float HORIZON_OFFSET_Y = -1.0f;
+/// @brief Slopes shading direction, see BlocksRenderer::SUN_VECTOR
+static const glm::vec3 SUN_VECTOR {0.411934f, 0.863868f, -0.279161f};
+/// @brief Faces colors fallback used when atlas image is not available
+static constexpr glm::vec4 DEFAULT_COLOR {0.5f, 0.5f, 0.5f, 1.0f};
+
+/// @brief Position and packed RGB color, see horizon.glslv
+static const VertexAttribute HORIZON_ATTRS[] = {{3}, {1}, {0}};
+static constexpr int HORIZON_VERTEX_SIZE = 4;
+
+union packed_float {
+    float floating;
+    uint32_t integer;
+};
+
+/// @brief Pack color to 8 bits per RGB channel
+static inline float pack_color(const glm::vec3& color) {
+    auto channel = [](float value) {
+        return std::min(static_cast<uint32_t>(std::round(value * 255)), 255U);
+    };
+    packed_float packed;
+    packed.integer = (channel(color.r) << 16) | (channel(color.g) << 8) |
+                     channel(color.b);
+    return packed.floating;
+}
+
+/// @brief Average color of the atlas region
+static glm::vec4 average_color(const ImageData& image, const UVRegion& uv) {
+    uint width = image.getWidth();
+    uint height = image.getHeight();
+    uint x1 = std::min<uint>(uv.u1 * width, width - 1);
+    uint y1 = std::min<uint>(uv.v1 * height, height - 1);
+    uint x2 = std::clamp<uint>(uv.u2 * width, x1 + 1, width);
+    uint y2 = std::clamp<uint>(uv.v2 * height, y1 + 1, height);
+    const ubyte* data = image.getData();
+    glm::vec4 sum {};
+    for (uint y = y1; y < y2; y++) {
+        for (uint x = x1; x < x2; x++) {
+            const ubyte* pixel = data + (y * width + x) * 4;
+            float alpha = pixel[3] / 255.0f;
+            sum += glm::vec4(
+                pixel[0] / 255.0f * alpha,
+                pixel[1] / 255.0f * alpha,
+                pixel[2] / 255.0f * alpha,
+                alpha
+            );
+        }
+    }
+    if (sum.a <= 0.0f) {
+        return glm::vec4(0.0f);
+    }
+    return glm::vec4(glm::vec3(sum) / sum.a, 1.0f);
+}
+
+static std::vector<glm::vec4> make_colors(
+    const Content& content, const Assets& assets, const ContentGfxCache& cache
+) {
+    const auto& blocks = content.getIndices()->blocks;
+    auto atlas = assets.get<Atlas>("blocks");
+    auto image = atlas ? atlas->getImage() : nullptr;
+    if (image && image->getFormat() != ImageFormat::rgba8888) {
+        image = nullptr;
+    }
+    std::vector<glm::vec4> colors(blocks.count());
+    for (blockid_t id = 0; id < blocks.count(); id++) {
+        const auto& def = blocks.require(id);
+        if (def.model == BlockModel::none) {
+            continue;
+        }
+        colors[id] = image ? average_color(*image, cache.getRegion(id, 3))
+                           : DEFAULT_COLOR;
+    }
+    return colors;
+}
+
+class HorizonRenderer::Worker : public util::Worker<Job, Result> {
+    WorldRegions& regions;
+    std::shared_ptr<const std::vector<glm::vec4>> colors;
+    /// @brief Samples heights (negative if empty) and colors
+    std::vector<float> heights;
+    std::vector<glm::vec4> samples;
+    std::vector<int> vertexIndices;
+
+    void readSamples(const glm::ivec2& region) {
+        constexpr int cells = ChunkSummary::CELLS_W;
+        std::fill(heights.begin(), heights.end(), -1.0f);
+        for (int cz = 0; cz * cells < TILE_SAMPLES; cz++) {
+            for (int cx = 0; cx * cells < TILE_SAMPLES; cx++) {
+                auto summary = regions.fetchSummary(
+                    region.x * REGION_SIZE + cx, region.y * REGION_SIZE + cz
+                );
+                if (!summary) {
+                    continue;
+                }
+                for (int z = 0; z < ChunkSummary::CELLS_D; z++) {
+                    int sz = cz * ChunkSummary::CELLS_D + z;
+                    for (int x = 0; x < cells && sz < TILE_SAMPLES; x++) {
+                        int sx = cx * cells + x;
+                        if (sx >= TILE_SAMPLES) {
+                            break;
+                        }
+                        const auto& cell = summary->at(x, z);
+                        if (cell.height == 0 || cell.id >= colors->size() ||
+                            (*colors)[cell.id].a <= 0.0f) {
+                            continue;
+                        }
+                        size_t index = sz * TILE_SAMPLES + sx;
+                        heights[index] = cell.height;
+                        samples[index] = (*colors)[cell.id];
+                    }
+                }
+            }
+        }
+    }
+
+    float heightAt(int x, int z, float fallback) const {
+        if (x < 0 || z < 0 || x >= TILE_SAMPLES || z >= TILE_SAMPLES) {
+            return fallback;
+        }
+        float height = heights[z * TILE_SAMPLES + x];
+        return height < 0.0f ? fallback : height;
+    }
+public:
+    Worker(
+        WorldRegions& regions,
+        std::shared_ptr<const std::vector<glm::vec4>> colors
+    )
+        : regions(regions),
+          colors(std::move(colors)),
+          heights(TILE_SAMPLES * TILE_SAMPLES),
+          samples(TILE_SAMPLES * TILE_SAMPLES),
+          vertexIndices(TILE_SAMPLES * TILE_SAMPLES) {
+    }
+
+    Result operator()(const Job& job) override {
+        readSamples(job.region);
+
+        Result result {job.region, {}, {}};
+        auto& vertices = result.vertices;
+        constexpr float step = ChunkSummary::CELL_SIZE;
+        for (int z = 0; z < TILE_SAMPLES; z++) {
+            for (int x = 0; x < TILE_SAMPLES; x++) {
+                size_t index = z * TILE_SAMPLES + x;
+                float height = heights[index];
+                if (height < 0.0f) {
+                    vertexIndices[index] = -1;
+                    continue;
+                }
+                // slopes are shaded like blocks faces, see BlocksRenderer
+                glm::vec3 normal = glm::normalize(glm::vec3(
+                    heightAt(x - 1, z, height) - heightAt(x + 1, z, height),
+                    step * 2.0f,
+                    heightAt(x, z - 1, height) - heightAt(x, z + 1, height)
+                ));
+                float shading =
+                    0.8f + glm::dot(normal, SUN_VECTOR) * 0.2f;
+                glm::vec3 color = glm::vec3(samples[index]) * shading;
+                vertexIndices[index] = vertices.size() / HORIZON_VERTEX_SIZE;
+                vertices.push_back((x + 0.5f) * step);
+                vertices.push_back(height + HORIZON_OFFSET_Y);
+                vertices.push_back((z + 0.5f) * step);
+                vertices.push_back(pack_color(color));
+            }
+        }
+        auto& indices = result.indices;
+        for (int z = 0; z + 1 < TILE_SAMPLES; z++) {
+            for (int x = 0; x + 1 < TILE_SAMPLES; x++) {
+                int a = vertexIndices[z * TILE_SAMPLES + x];
+                int b = vertexIndices[z * TILE_SAMPLES + x + 1];
+                int c = vertexIndices[(z + 1) * TILE_SAMPLES + x + 1];
+                int d = vertexIndices[(z + 1) * TILE_SAMPLES + x];
+                if (a < 0 || b < 0 || c < 0 || d < 0) {
+                    continue;
+                }
+                indices.insert(indices.end(), {a, d, c, a, c, b});
+            }
+        }
+        return result;
+    }
+};
+
+HorizonRenderer::HorizonRenderer(
+    const Level& level, const Assets& assets, const ContentGfxCache& cache
+)
+    : colors(std::make_shared<std::vector<glm::vec4>>(
+          make_colors(*level.content, assets, cache)
+      )),
+      pool(
+          "horizon",
+          [this, &level]() {
+              return std::make_shared<Worker>(
+                  level.getWorld()->wfile->getRegions(), colors
+              );
+          },
+          [this](Result& result) {
+              inwork.erase(result.region);
+              auto& tile = tiles[result.region];
+              tile.builtTime = timer;
+              if (result.indices.empty()) {
+                  tile.mesh = nullptr;
+                  return;
+              }
+              tile.mesh = std::make_unique<Mesh>(
+                  result.vertices.data(),
+                  result.vertices.size() / HORIZON_VERTEX_SIZE,
+                  result.indices.data(),
+                  result.indices.size(),
+                  HORIZON_ATTRS
+              );
+          },
+          util::ThreadPool<Job, Result>::QUARTER
+      ) {
+    pool.setStopOnFail(false);
+}
+
+HorizonRenderer::~HorizonRenderer() = default;
+
+void HorizonRenderer::update(const Camera& camera, int distance, float delta) {
+    timer += delta;
+    pool.update();
+
+    int regionBlocks = REGION_SIZE * CHUNK_W;
+    glm::ivec2 center(
+        floordiv(static_cast<int>(std::floor(camera.position.x)), regionBlocks),
+        floordiv(static_cast<int>(std::floor(camera.position.z)), regionBlocks)
+    );
+    int radius = ceildiv(distance, REGION_SIZE);
+    for (auto it = tiles.begin(); it != tiles.end();) {
+        auto offset = glm::abs(it->first - center);
+        if (std::max(offset.x, offset.y) > radius + 1) {
+            it = tiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // nearest tiles first, outdated tiles are rebuilt when nothing is missing
+    const glm::ivec2* outdated = nullptr;
+    for (int ring = 0; ring <= radius; ring++) {
+        for (int z = -ring; z <= ring; z++) {
+            for (int x = -ring; x <= ring; x++) {
+                if (std::max(std::abs(x), std::abs(z)) != ring) {
+                    continue;
+                }
+                if (inwork.size() >= MAX_TILES_IN_WORK) {
+                    return;
+                }
+                glm::ivec2 region = center + glm::ivec2(x, z);
+                if (inwork.find(region) != inwork.end()) {
+                    continue;
+                }
+                const auto& found = tiles.find(region);
+                if (found == tiles.end()) {
+                    inwork.insert(region);
+                    pool.enqueueJob(Job {region});
+                } else if (outdated == nullptr &&
+                           timer - found->second.builtTime >
+                               TILE_REFRESH_TIME) {
+                    outdated = &found->first;
+                }
+            }
+        }
+    }
+    if (outdated) {
+        inwork.insert(*outdated);
+        pool.enqueueJob(Job {*outdated});
+    }
+}
+
+void HorizonRenderer::draw(
+    const DrawContext& pctx,
+    const Camera& camera,
+    Shader& shader,
+    float nearDistance
+) {
+    if (tiles.empty()) {
+        return;
+    }
+    auto ctx = pctx.sub();
+    ctx.setCullFace(false);
+    shader.use();
+    shader.uniform1f("u_nearDistance", nearDistance);
+    int regionBlocks = REGION_SIZE * CHUNK_W;
+    for (const auto& [region, tile] : tiles) {
+        if (tile.mesh == nullptr) {
+            continue;
+        }
+        glm::vec3 origin(
+            region.x * regionBlocks, 0.0f, region.y * regionBlocks
+        );
+        shader.uniformMatrix(
+            "u_model", glm::translate(glm::mat4(1.0f), origin)
+        );
+        tile.mesh->draw(GL_TRIANGLES);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include "typedefs.hpp"
+#include "util/ThreadPool.hpp"
+
+class Mesh;
+class Level;
+class Assets;
+class Camera;
+class Shader;
+class DrawContext;
+class WorldRegions;
+class ContentGfxCache;
+
+/// @brief Far terrain beyond loaded chunks drawn as heightmap tiles made
+/// of the chunks summaries (see ChunkSummary) without loading voxels,
+/// lights or meshes. A tile covers a region, tiles are built by workers
+/// reading the summaries layer and are rebuilt from time to time to show
+/// chunks saved since
+class HorizonRenderer {
+    struct Job {
+        glm::ivec2 region;
+    };
+    struct Result {
+        glm::ivec2 region;
+        std::vector<float> vertices;
+        std::vector<int> indices;
+    };
+    class Worker;
+    struct Tile {
+        /// @brief nullptr if the region has no summaries
+        std::unique_ptr<Mesh> mesh;
+        /// @brief Renderer timer value when the tile was built
+        float builtTime;
+    };
+    /// @brief Blocks top faces colors by id, zero alpha for invisible ones
+    std::shared_ptr<const std::vector<glm::vec4>> colors;
+    std::unordered_map<glm::ivec2, Tile> tiles;
+    std::unordered_set<glm::ivec2> inwork;
+    util::ThreadPool<Job, Result> pool;
+    float timer = 0.0f;
+public:
+    HorizonRenderer(
+        const Level& level, const Assets& assets, const ContentGfxCache& cache
+    );
+    ~HorizonRenderer();
+
+    /// @brief Queue tiles in the distance building, remove farther tiles
+    /// @param distance horizon distance (chunks)
+    void update(const Camera& camera, int distance, float delta);
+
+    /// @param shader horizon shader
+    /// @param nearDistance distance (blocks) of the area covered by loaded
+    /// chunks where the horizon is not drawn
+    void draw(
+        const DrawContext& pctx,
+        const Camera& camera,
+        Shader& shader,
+        float nearDistance
+    );
+};
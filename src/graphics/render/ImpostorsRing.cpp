@@ -0,0 +1,180 @@
+#include "ImpostorsRing.hpp"
+
+#include <GL/glew.h>
+#include <glm/gtc/constants.hpp>
+
+#include "constants.hpp"
+#include "graphics/core/Cubemap.hpp"
+#include "graphics/core/DrawContext.hpp"
+#include "graphics/core/Framebuffer.hpp"
+#include "graphics/core/Mesh.hpp"
+#include "graphics/core/Shader.hpp"
+#include "window/Camera.hpp"
+
+static constexpr uint CUBEMAP_FACES = 6;
+/// @brief Camera distance from the ring center starting a new bake,
+/// relative to the ring distance
+static constexpr float REBAKE_DISTANCE = 1.0f / 16.0f;
+/// @brief Camera distance from the ring center making it baked at once
+/// instead of one face per frame, relative to the ring distance
+static constexpr float FULL_REBAKE_DISTANCE = 0.25f;
+/// @brief Texture unit of the cubemap used by the impostors shader
+static constexpr int IMPOSTORS_UNIT = 6;
+
+/// @brief Cubemap faces view directions and up vectors
+static const glm::vec3 FACES_FRONT[CUBEMAP_FACES] {
+    {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+};
+static const glm::vec3 FACES_UP[CUBEMAP_FACES] {
+    {0, -1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, -1, 0}, {0, -1, 0}
+};
+
+ImpostorsRing::ImpostorsRing(uint resolution) : resolution(resolution) {
+    for (auto& cubemap : cubemaps) {
+        cubemap = std::make_unique<Cubemap>(
+            resolution, resolution, ImageFormat::rgba8888
+        );
+    }
+    uint fboId;
+    uint depth;
+    glGenFramebuffers(1, &fboId);
+    glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(
+        GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, resolution, resolution
+    );
+    glFramebufferRenderbuffer(
+        GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth
+    );
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    fbo = std::make_unique<Framebuffer>(fboId, depth, nullptr);
+
+    float vertices[] {
+        -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
+        -1.0f, -1.0f,  1.0f, 1.0f, 1.0f, -1.0f
+    };
+    VertexAttribute attrs[] {{2}, {0}};
+    mesh = std::make_unique<Mesh>(vertices, 6, attrs);
+}
+
+ImpostorsRing::~ImpostorsRing() = default;
+
+bool ImpostorsRing::update(
+    const DrawContext& pctx,
+    const Camera& camera,
+    float distance,
+    const std::function<void(const Camera&)>& drawChunks
+) {
+    float moved = glm::distance(camera.position, center);
+    bool fullRefresh = !ready || this->distance != distance ||
+                       moved >= distance * FULL_REBAKE_DISTANCE;
+    if (bakingFace >= CUBEMAP_FACES && !fullRefresh) {
+        if (!outdated && moved < distance * REBAKE_DISTANCE) {
+            return false;
+        }
+        bakingCenter = camera.position;
+        bakingFace = 0;
+        outdated = false;
+    }
+
+    DrawContext ctx = pctx.sub();
+    ctx.setFramebuffer(fbo.get());
+    ctx.setViewport(Viewport(resolution, resolution));
+    ctx.setDepthTest(true);
+    ctx.setDepthMask(true);
+    ctx.setCullFace(true);
+    ctx.setBlendMode(BlendMode::normal);
+
+    Camera faceCamera(camera.position, glm::half_pi<float>());
+    faceCamera.aspect = 1.0f;
+    faceCamera.far = camera.far;
+    // nearer chunks are not baked
+    faceCamera.near = glm::max(1.0f, (distance - CHUNK_W * 2) * 0.5f);
+
+    if (fullRefresh) {
+        center = camera.position;
+        faceCamera.position = center;
+        for (uint face = 0; face < CUBEMAP_FACES; face++) {
+            renderFace(face, *cubemaps[frontCubemap], faceCamera, drawChunks);
+        }
+        this->distance = distance;
+        bakingFace = CUBEMAP_FACES;
+        ready = true;
+        outdated = false;
+    } else {
+        faceCamera.position = bakingCenter;
+        renderFace(
+            bakingFace++, *cubemaps[!frontCubemap], faceCamera, drawChunks
+        );
+        if (bakingFace == CUBEMAP_FACES) {
+            frontCubemap = !frontCubemap;
+            center = bakingCenter;
+        }
+    }
+    return true;
+}
+
+void ImpostorsRing::renderFace(
+    uint face,
+    const Cubemap& cubemap,
+    const Camera& camera,
+    const std::function<void(const Camera&)>& drawChunks
+) {
+    glFramebufferTexture2D(
+        GL_FRAMEBUFFER,
+        GL_COLOR_ATTACHMENT0,
+        GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+        cubemap.getId(),
+        0
+    );
+    // pixels without chunks stay transparent
+    const float transparent[] {0.0f, 0.0f, 0.0f, 0.0f};
+    glClearBufferfv(GL_COLOR, 0, transparent);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    Camera faceCamera = camera;
+    faceCamera.front = FACES_FRONT[face];
+    faceCamera.up = FACES_UP[face];
+    drawChunks(faceCamera);
+}
+
+void ImpostorsRing::invalidate(int chunkX, int chunkZ) {
+    if (!ready) {
+        return;
+    }
+    glm::vec2 offset(
+        (chunkX + 0.5f) * CHUNK_W - center.x,
+        (chunkZ + 0.5f) * CHUNK_D - center.z
+    );
+    if (glm::length(offset) >= distance - CHUNK_W) {
+        outdated = true;
+    }
+}
+
+void ImpostorsRing::draw(
+    const DrawContext& pctx, const Camera& camera, Shader& shader
+) {
+    if (!ready) {
+        return;
+    }
+    auto ctx = pctx.sub();
+    ctx.setDepthMask(false);
+    ctx.setCullFace(false);
+    shader.use();
+    shader.uniformMatrix(
+        "u_invProjView", glm::inverse(camera.getProjView(false))
+    );
+    shader.uniform3f("u_center", center - camera.position);
+    // depth of the nearest baked chunks, so the closer objects stay in front
+    shader.uniform1f("u_distance", distance - CHUNK_W);
+    shader.uniform1i("u_impostors", IMPOSTORS_UNIT);
+    glActiveTexture(GL_TEXTURE0 + IMPOSTORS_UNIT);
+    cubemaps[frontCubemap]->bind();
+    glActiveTexture(GL_TEXTURE0);
+    mesh->draw();
+    glActiveTexture(GL_TEXTURE0 + IMPOSTORS_UNIT);
+    cubemaps[frontCubemap]->unbind();
+    glActiveTexture(GL_TEXTURE0);
+}
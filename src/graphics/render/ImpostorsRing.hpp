@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <functional>
+
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+
+class Mesh;
+class Camera;
+class Shader;
+class Cubemap;
+class DrawContext;
+class Framebuffer;
+
+/// @brief Loaded chunks beyond a distance drawn from a cubemap baked
+/// around the camera position instead of their meshes. The cubemap is
+/// composited behind nearer chunks every frame, it is rebaked when the
+/// camera moves away from its center or a chunk mesh in the baked area
+/// is changed. Small changes are baked into the back cubemap one face per
+/// frame, large camera moves are baked at once
+class ImpostorsRing {
+    uint resolution;
+    std::unique_ptr<Framebuffer> fbo;
+    /// @brief Displayed and baking cubemaps
+    std::unique_ptr<Cubemap> cubemaps[2];
+    int frontCubemap = 0;
+    std::unique_ptr<Mesh> mesh;
+    /// @brief Positions the front and the back cubemaps are baked from
+    glm::vec3 center {};
+    glm::vec3 bakingCenter {};
+    /// @brief Distance (blocks) the front cubemap is baked for
+    float distance = 0.0f;
+    uint bakingFace = 6;
+    bool ready = false;
+    /// @brief A chunk mesh in the baked area is changed since the bake
+    bool outdated = false;
+
+    void renderFace(
+        uint face,
+        const Cubemap& cubemap,
+        const Camera& camera,
+        const std::function<void(const Camera&)>& drawChunks
+    );
+public:
+    /// @param resolution cubemap face width and height
+    ImpostorsRing(uint resolution);
+    ~ImpostorsRing();
+
+    /// @brief Bake cubemap faces if needed
+    /// @param distance distance (blocks) where chunks are baked
+    /// @param drawChunks draws chunks meshes in the baked area around
+    /// the camera position, see ChunksRenderer::drawImpostorMeshes
+    /// @return true if faces were rendered and world uniforms are
+    /// changed
+    bool update(
+        const DrawContext& pctx,
+        const Camera& camera,
+        float distance,
+        const std::function<void(const Camera&)>& drawChunks
+    );
+
+    /// @brief Mark the ring outdated if the chunk is in the baked area
+    void invalidate(int chunkX, int chunkZ);
+
+    /// @brief Composite the front cubemap behind the nearer chunks
+    /// @param shader impostors shader
+    void draw(const DrawContext& pctx, const Camera& camera, Shader& shader);
+
+    /// @brief Get position the displayed chunks are baked from
+    const glm::vec3& getCenter() const {
+        return center;
+    }
+
+    bool isReady() const {
+        return ready;
+    }
+};
@@ -0,0 +1,181 @@
+#include "LightTextures.hpp"
+
+#include <GL/glew.h>
+#include <cmath>
+
+#include "constants.hpp"
+#include "graphics/core/Shader.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+
+/// @brief Texture unit of the lights used by the chunks shader
+static constexpr int LIGHTS_MAP_UNIT = 5;
+
+static inline int floor_mod(int value, int divisor) {
+    int rem = value % divisor;
+    return rem < 0 ? rem + divisor : rem;
+}
+
+LightTextures::LightTextures() {
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    // lightmap x, z, y order with red channel in the lowest bits
+    glTexImage3D(
+        GL_TEXTURE_3D,
+        0,
+        GL_RGBA4,
+        SIZE * CHUNK_W,
+        SIZE * CHUNK_D,
+        CHUNK_H,
+        0,
+        GL_RGBA,
+        GL_UNSIGNED_SHORT_4_4_4_4_REV,
+        nullptr
+    );
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // the ring is repeated, so world coordinates are used as is
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+LightTextures::~LightTextures() {
+    glDeleteTextures(1, &texture);
+}
+
+LightTextures::Slot& LightTextures::getSlot(int x, int z) {
+    return slots[floor_mod(z, SIZE) * SIZE + floor_mod(x, SIZE)];
+}
+
+const LightTextures::Slot& LightTextures::getSlot(int x, int z) const {
+    return slots[floor_mod(z, SIZE) * SIZE + floor_mod(x, SIZE)];
+}
+
+void LightTextures::upload(
+    const glm::ivec2& key, const light_t* lights, int begin, int end
+) {
+    static const light_t zeros[CHUNK_VOL] {};
+    if (lights == nullptr) {
+        lights = zeros;
+    }
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glTexSubImage3D(
+        GL_TEXTURE_3D,
+        0,
+        floor_mod(key.x, SIZE) * CHUNK_W,
+        floor_mod(key.y, SIZE) * CHUNK_D,
+        begin * CHUNK_SECTION_H,
+        CHUNK_W,
+        CHUNK_D,
+        (end - begin) * CHUNK_SECTION_H,
+        GL_RGBA,
+        GL_UNSIGNED_SHORT_4_4_4_4_REV,
+        lights + begin * CHUNK_SECTION_VOL
+    );
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void LightTextures::release(Slot& slot, Chunks& chunks) {
+    if (slot.used && slot.staleSections) {
+        if (auto chunk = chunks.getChunk(slot.key.x, slot.key.y)) {
+            chunk->dirtySections |= slot.staleSections;
+            chunk->flags.modified = true;
+        }
+    }
+    slot.staleSections = 0;
+}
+
+void LightTextures::update(Chunks& chunks, const glm::vec3& cameraPosition) {
+    origin = glm::ivec2(
+        std::floor(cameraPosition.x / CHUNK_W) - SIZE / 2,
+        std::floor(cameraPosition.z / CHUNK_D) - SIZE / 2
+    );
+    for (int z = origin.y; z < origin.y + SIZE; z++) {
+        for (int x = origin.x; x < origin.x + SIZE; x++) {
+            glm::ivec2 key(x, z);
+            auto& slot = getSlot(x, z);
+            const Chunk* chunk = chunks.getChunk(x, z);
+            if (chunk && !chunk->flags.lighted) {
+                chunk = nullptr;
+            }
+            if (slot.used && slot.key == key && slot.chunk == chunk) {
+                continue;
+            }
+            if (slot.key != key) {
+                release(slot, chunks);
+            }
+            if (chunk) {
+                upload(key, chunk->lightmap.read().get(), 0, CHUNK_SECTIONS);
+            } else {
+                upload(key, nullptr, 0, CHUNK_SECTIONS);
+            }
+            slot.key = key;
+            slot.chunk = chunk;
+            slot.used = true;
+        }
+    }
+}
+
+bool LightTextures::updateLights(const Chunk& chunk, uint32_t sections) {
+    auto& slot = getSlot(chunk.x, chunk.z);
+    if (!slot.used || slot.chunk != &chunk) {
+        return false;
+    }
+    auto lights = chunk.lightmap.read();
+    for (int i = 0; i < CHUNK_SECTIONS;) {
+        if (!(sections & (1U << i))) {
+            i++;
+            continue;
+        }
+        int begin = i;
+        while (i < CHUNK_SECTIONS && (sections & (1U << i))) {
+            i++;
+        }
+        upload(slot.key, lights.get(), begin, i);
+    }
+    slot.staleSections |= sections;
+    return true;
+}
+
+void LightTextures::unload(int x, int z) {
+    auto& slot = getSlot(x, z);
+    if (slot.used && slot.key == glm::ivec2(x, z)) {
+        // stale data must not be taken as lights of the chunk loaded again
+        slot.chunk = nullptr;
+        slot.used = false;
+        slot.staleSections = 0;
+    }
+}
+
+void LightTextures::release(Chunks& chunks) {
+    for (auto& slot : slots) {
+        release(slot, chunks);
+    }
+}
+
+void LightTextures::disable(Shader& shader) {
+    // samplers of different types must not share a texture unit
+    // even if not used
+    shader.uniform1i("u_lightsMap", LIGHTS_MAP_UNIT);
+    shader.uniform1i("u_lightTextures", false);
+}
+
+void LightTextures::bind(Shader& shader) const {
+    glActiveTexture(GL_TEXTURE0 + LIGHTS_MAP_UNIT);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glActiveTexture(GL_TEXTURE0);
+    shader.uniform1i("u_lightsMap", LIGHTS_MAP_UNIT);
+    shader.uniform1i("u_lightTextures", true);
+    // the outer half texel is filtered with the opposite side of the ring
+    shader.uniform4f(
+        "u_lightsArea",
+        glm::vec4(
+            origin.x * CHUNK_W + 0.5f,
+            origin.y * CHUNK_D + 0.5f,
+            (origin.x + SIZE) * CHUNK_W - 0.5f,
+            (origin.y + SIZE) * CHUNK_D - 0.5f
+        )
+    );
+}
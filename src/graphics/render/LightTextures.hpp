@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+
+class Chunk;
+class Chunks;
+class Shader;
+
+/// @brief Lights of chunks around the camera stored in a 3D texture sampled
+/// by the chunks shader instead of lights baked into vertices, so lights
+/// changes are texture uploads instead of meshes rebuilds.
+/// The texture is a ring of SIZE x SIZE chunks: chunk lights are stored
+/// at the chunk coordinates modulo SIZE, so moving the area to the next
+/// chunk uploads a single row of chunks. Meshes keep baked lights used out
+/// of the area, the ones outdated are rebuilt when leaving it
+class LightTextures {
+public:
+    /// @brief Area width and depth (chunks)
+    static constexpr int SIZE = 16;
+private:
+    struct Slot {
+        glm::ivec2 key {};
+        /// @brief Chunk lights are uploaded from, nullptr if the slot
+        /// is filled with zeros
+        const Chunk* chunk = nullptr;
+        bool used = false;
+        /// @brief Sections of the chunk mesh with outdated baked lights
+        uint32_t staleSections = 0;
+    };
+    uint texture = 0;
+    /// @brief Area first chunk
+    glm::ivec2 origin {};
+    Slot slots[SIZE * SIZE];
+
+    Slot& getSlot(int x, int z);
+    const Slot& getSlot(int x, int z) const;
+    /// @brief Upload lights of sections range, zeros if lights is nullptr
+    void upload(
+        const glm::ivec2& key, const light_t* lights, int begin, int end
+    );
+    /// @brief Mark the slot chunk mesh modified if has outdated lights
+    void release(Slot& slot, Chunks& chunks);
+public:
+    LightTextures();
+    ~LightTextures();
+
+    /// @brief Move the area to the camera and upload lights of chunks
+    /// entering it, loaded or unloaded since the last update
+    void update(Chunks& chunks, const glm::vec3& cameraPosition);
+
+    /// @brief Upload changed sections lights of the chunk
+    /// @param sections bit mask of sections with lights changed
+    /// @return false if the chunk is out of the area, so the mesh
+    /// is to be rebuilt instead
+    bool updateLights(const Chunk& chunk, uint32_t sections);
+
+    /// @brief Forget the unloaded chunk lights
+    void unload(int x, int z);
+
+    /// @brief Mark meshes with outdated baked lights modified.
+    /// Called before the lights texture is disabled
+    void release(Chunks& chunks);
+
+    /// @brief Bind the texture and set lights uniforms of the chunks shader
+    void bind(Shader& shader) const;
+
+    /// @brief Set uniforms of the chunks shader using baked lights only
+    static void disable(Shader& shader);
+};
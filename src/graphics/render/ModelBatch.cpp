@@ -3,6 +3,8 @@
 #include "assets/assets_util.hpp"
 #include "graphics/commons/Model.hpp"
 #include "graphics/core/Mesh.hpp"
+#include "graphics/core/InstancedMesh.hpp"
+#include "graphics/core/Shader.hpp"
 #include "graphics/core/Atlas.hpp"
 #include "graphics/core/Texture.hpp"
 #include "assets/Assets.hpp"
@@ -18,11 +20,27 @@
 #include <glm/gtx/quaternion.hpp>
 
 #include <algorithm>
+#include <tuple>
 
 inline constexpr glm::vec3 X(1, 0, 0);
 inline constexpr glm::vec3 Y(0, 1, 0);
 inline constexpr glm::vec3 Z(0, 0, 1);
 
+static_assert(
+    sizeof(model::Vertex) == sizeof(float) * 8,
+    "model vertices are uploaded to instanced mesh as is"
+);
+
+/// @brief Instanced model mesh vertex: xyz, uv, normal
+static const VertexAttribute INSTANCED_ATTRS[] = {{3}, {2}, {3}, {0}};
+/// @brief Per-instance attributes: matrix columns, rotation columns,
+/// tint and lights
+static const VertexAttribute INSTANCE_ATTRS[] = {
+    {4}, {4}, {4}, {4}, {3}, {3}, {3}, {3}, {4}, {0}
+};
+/// @brief Location of the first instance attribute in the entity shader
+static constexpr uint INSTANCE_LOCATION = 4;
+
 struct DecomposedMat4 {
     glm::vec3 scale;
     glm::mat3 rotation;
@@ -51,21 +69,22 @@ ModelBatch::ModelBatch(
     const Chunks& chunks,
     const EngineSettings& settings
 )
-    : batch(std::make_unique<MainBatch>(capacity)),
-      assets(assets),
+    : assets(assets),
       chunks(chunks),
-      settings(settings) {
+      settings(settings),
+      batch(std::make_unique<MainBatch>(capacity)),
+      instancedMesh(std::make_unique<InstancedMesh>(
+          INSTANCED_ATTRS, INSTANCE_ATTRS, INSTANCE_LOCATION
+      )) {
 }
 
 ModelBatch::~ModelBatch() = default;
 
 void ModelBatch::draw(const model::Mesh& mesh, const glm::mat4& matrix, 
                       const glm::mat3& rotation, glm::vec3 tint,
-                      const texture_names_map* varTextures,
+                      const util::TextureRegion& texture,
                       bool backlight) {
-
-
-    setTexture(mesh.texture, varTextures);
+    batch->setTexture(texture.texture, texture.region);
     size_t vcount = mesh.vertices.size();
     const auto& vertexData = mesh.vertices.data();
 
@@ -96,27 +115,96 @@ void ModelBatch::draw(glm::mat4 matrix,
                       const texture_names_map* varTextures) {
     for (const auto& mesh : model->meshes) {
         entries.push_back({
-            matrix, extract_rotation(matrix), tint, &mesh, varTextures
+            matrix,
+            extract_rotation(matrix),
+            tint,
+            &mesh,
+            getTexture(mesh.texture, varTextures)
         });
     }
 }
 
+void ModelBatch::drawInstanced(
+    const DrawEntry* entries, size_t count, bool backlight
+) {
+    const auto& mesh = *entries[0].mesh;
+    const auto& texture = entries[0].texture;
+    instances.resize(count * instancedMesh->getInstanceSize());
+    float* dst = instances.data();
+    for (size_t i = 0; i < count; i++) {
+        const auto& entry = entries[i];
+        glm::vec4 lights(1, 1, 1, 0);
+        if (mesh.lighting) {
+            glm::vec3 gpos = entry.matrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            gpos += lightsOffset;
+            lights = MainBatch::sampleLight(gpos, chunks, backlight);
+        }
+        const float* matrix = &entry.matrix[0][0];
+        dst = std::copy(matrix, matrix + 16, dst);
+        const float* rotation = &entry.rotation[0][0];
+        dst = std::copy(rotation, rotation + 9, dst);
+        dst = std::copy(&entry.tint[0], &entry.tint[0] + 3, dst);
+        dst = std::copy(&lights[0], &lights[0] + 4, dst);
+    }
+    instancedMesh->reload(
+        reinterpret_cast<const float*>(mesh.vertices.data()),
+        mesh.vertices.size()
+    );
+    instancedMesh->reloadInstances(instances.data(), count);
+
+    auto& shader = assets.require<Shader>("entity");
+    shader.uniform1i("u_instanced", true);
+    shader.uniform1i("u_shading", mesh.lighting);
+    shader.uniform2f("u_regionOffset", texture.region.u1, texture.region.v1);
+    shader.uniform2f(
+        "u_regionSize", texture.region.getWidth(), texture.region.getHeight()
+    );
+    texture.texture->bind();
+    instancedMesh->draw();
+    shader.uniform1i("u_instanced", false);
+}
+
 void ModelBatch::render() {
+    auto key = [](const DrawEntry& entry) {
+        const auto& region = entry.texture.region;
+        return std::make_tuple(
+            entry.texture.texture,
+            entry.mesh,
+            region.u1,
+            region.v1,
+            region.u2,
+            region.v2
+        );
+    };
     std::sort(entries.begin(), entries.end(), 
-        [](const DrawEntry& a, const DrawEntry& b) {
-            return a.mesh->texture < b.mesh->texture;
+        [key](const DrawEntry& a, const DrawEntry& b) {
+            return key(a) < key(b);
         }
     );
     bool backlight = settings.graphics.backlight.get();
-    for (auto& entry : entries) {
-        draw(
-            *entry.mesh,
-            entry.matrix,
-            entry.rotation,
-            entry.tint,
-            entry.varTextures,
-            backlight
-        );
+    for (size_t i = 0; i < entries.size();) {
+        size_t end = i + 1;
+        while (end < entries.size() && key(entries[end]) == key(entries[i])) {
+            end++;
+        }
+        // entities sharing a model are drawn with a single draw call
+        if (end - i >= INSTANCING_THRESHOLD && entries[i].texture.texture) {
+            batch->flush();
+            drawInstanced(entries.data() + i, end - i, backlight);
+            i = end;
+            continue;
+        }
+        for (; i < end; i++) {
+            const auto& entry = entries[i];
+            draw(
+                *entry.mesh,
+                entry.matrix,
+                entry.rotation,
+                entry.tint,
+                entry.texture,
+                backlight
+            );
+        }
     }
     batch->flush();
     entries.clear();
@@ -126,16 +214,16 @@ void ModelBatch::setLightsOffset(const glm::vec3& offset) {
     lightsOffset = offset;
 }
 
-void ModelBatch::setTexture(const std::string& name,
-                            const texture_names_map* varTextures) {
+util::TextureRegion ModelBatch::getTexture(
+    const std::string& name, const texture_names_map* varTextures
+) const {
     if (varTextures && name.at(0) == '$') {
         const auto& found = varTextures->find(name);
         if (found == varTextures->end()) {
-            return batch->setTexture(nullptr);
+            return {nullptr, UVRegion {0.0f, 0.0f, 1.0f, 1.0f}};
         } else {
-            return setTexture(found->second, varTextures);
+            return getTexture(found->second, varTextures);
         }
     }
-    auto region = util::get_texture_region(assets, name, "blocks:notfound");
-    batch->setTexture(region.texture, region.region);
+    return util::get_texture_region(assets, name, "blocks:notfound");
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "maths/UVRegion.hpp"
+#include "assets/assets_util.hpp"
 
 #include <memory>
 #include <vector>
@@ -14,6 +15,7 @@ class Chunks;
 class Assets;
 struct EngineSettings;
 class MainBatch;
+class InstancedMesh;
 
 namespace model {
     struct Mesh;
@@ -31,25 +33,39 @@ class ModelBatch {
 
     static inline glm::vec3 SUN_VECTOR {0.411934f, 0.863868f, -0.279161f};
 
+    /// @brief Min number of same mesh draws rendered as instances
+    static inline constexpr size_t INSTANCING_THRESHOLD = 4;
+
     std::unique_ptr<MainBatch> batch;
+    std::unique_ptr<InstancedMesh> instancedMesh;
+    /// @brief Per-instance attributes buffer reused between frames
+    std::vector<float> instances;
 
     void draw(const model::Mesh& mesh, 
               const glm::mat4& matrix, 
               const glm::mat3& rotation, 
               glm::vec3 tint,
-              const texture_names_map* varTextures,
+              const util::TextureRegion& texture,
               bool backlight);
 
-    void setTexture(const std::string& name,
-                    const texture_names_map* varTextures);
+    /// @return texture region, nullptr texture if variable texture is
+    /// not defined
+    util::TextureRegion getTexture(
+        const std::string& name, const texture_names_map* varTextures
+    ) const;
 
     struct DrawEntry {
         glm::mat4 matrix;
         glm::mat3 rotation;
         glm::vec3 tint;
         const model::Mesh* mesh;
-        const texture_names_map* varTextures;
+        util::TextureRegion texture;
     };
+
+    /// @brief Draw same mesh and texture entries as instances
+    void drawInstanced(
+        const DrawEntry* entries, size_t count, bool backlight
+    );
     std::vector<DrawEntry> entries;
 public:
     ModelBatch(
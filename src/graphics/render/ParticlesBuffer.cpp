@@ -0,0 +1,99 @@
+#include "ParticlesBuffer.hpp"
+
+#include "Emitter.hpp"
+#include "maths/simd.hpp"
+
+void ParticlesBuffer::push(const Particle& particle) {
+    const auto& acceleration = particle.emitter->preset.acceleration;
+    emitters.push_back(particle.emitter);
+    randoms.push_back(particle.random);
+    x.push_back(particle.position.x);
+    y.push_back(particle.position.y);
+    z.push_back(particle.position.z);
+    vx.push_back(particle.velocity.x);
+    vy.push_back(particle.velocity.y);
+    vz.push_back(particle.velocity.z);
+    ax.push_back(acceleration.x);
+    ay.push_back(acceleration.y);
+    az.push_back(acceleration.z);
+    lifetimes.push_back(particle.lifetime);
+    angles.push_back(particle.angle);
+    angularVelocities.push_back(particle.angularVelocity);
+    regions.push_back(particle.region);
+}
+
+template <class T>
+static inline void swap_remove(std::vector<T>& vec, size_t index) {
+    vec[index] = vec.back();
+    vec.pop_back();
+}
+
+void ParticlesBuffer::swapRemove(size_t index) {
+    swap_remove(emitters, index);
+    swap_remove(randoms, index);
+    for (auto values : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az,
+                        &lifetimes, &angles, &angularVelocities}) {
+        swap_remove(*values, index);
+    }
+    swap_remove(regions, index);
+}
+
+void ParticlesBuffer::clear() {
+    emitters.clear();
+    randoms.clear();
+    for (auto values : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az,
+                        &lifetimes, &angles, &angularVelocities}) {
+        values->clear();
+    }
+    regions.clear();
+}
+
+size_t ParticlesBuffer::getMemoryUsage() const {
+    size_t size = emitters.capacity() * sizeof(Emitter*) +
+                  randoms.capacity() * sizeof(int) +
+                  regions.capacity() * sizeof(UVRegion);
+    for (auto values : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az,
+                        &lifetimes, &angles, &angularVelocities}) {
+        size += values->capacity() * sizeof(float);
+    }
+    return size;
+}
+
+/// @brief dst[i] += src[i] * delta
+static void madd(float* dst, const float* src, float delta, size_t count) {
+    size_t i = 0;
+    auto factor = simd::set1(delta);
+    for (; i + simd::LANES <= count; i += simd::LANES) {
+        simd::store(
+            dst + i, simd::load(dst + i) + simd::load(src + i) * factor
+        );
+    }
+    for (; i < count; i++) {
+        dst[i] += src[i] * delta;
+    }
+}
+
+void ParticlesBuffer::accelerate(float delta) {
+    size_t count = size();
+    madd(vx.data(), ax.data(), delta, count);
+    madd(vy.data(), ay.data(), delta, count);
+    madd(vz.data(), az.data(), delta, count);
+}
+
+void ParticlesBuffer::move(float delta) {
+    size_t count = size();
+    madd(x.data(), vx.data(), delta, count);
+    madd(y.data(), vy.data(), delta, count);
+    madd(z.data(), vz.data(), delta, count);
+    madd(angles.data(), angularVelocities.data(), delta, count);
+
+    size_t i = 0;
+    auto step = simd::set1(delta);
+    float* lifetimes = this->lifetimes.data();
+    for (; i + simd::LANES <= count; i += simd::LANES) {
+        simd::store(lifetimes + i, simd::load(lifetimes + i) - step);
+    }
+    for (; i < count; i++) {
+        lifetimes[i] -= delta;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "maths/UVRegion.hpp"
+
+class Emitter;
+struct Particle;
+
+/// @brief Structure of arrays storage of CPU simulated particles sharing
+/// a texture. Integration kernels process four particles at once.
+/// Particles are removed with swap-remove, so the order is not kept
+struct ParticlesBuffer {
+    std::vector<Emitter*> emitters;
+    std::vector<int> randoms;
+    std::vector<float> x, y, z;
+    std::vector<float> vx, vy, vz;
+    /// @brief Acceleration copied from the emitter preset
+    std::vector<float> ax, ay, az;
+    /// @brief Remaining life time
+    std::vector<float> lifetimes;
+    std::vector<float> angles;
+    std::vector<float> angularVelocities;
+    std::vector<UVRegion> regions;
+
+    void push(const Particle& particle);
+
+    /// @brief Replace the particle with the last one
+    void swapRemove(size_t index);
+
+    void clear();
+
+    /// @brief Apply acceleration to velocities
+    void accelerate(float delta);
+
+    /// @brief Apply velocities to positions and angles, decrease life time
+    void move(float delta);
+
+    glm::vec3 getPosition(size_t index) const {
+        return {x[index], y[index], z[index]};
+    }
+
+    glm::vec3 getVelocity(size_t index) const {
+        return {vx[index], vy[index], vz[index]};
+    }
+
+    void setVelocity(size_t index, const glm::vec3& velocity) {
+        vx[index] = velocity.x;
+        vy[index] = velocity.y;
+        vz[index] = velocity.z;
+    }
+
+    size_t size() const {
+        return emitters.size();
+    }
+
+    bool empty() const {
+        return emitters.empty();
+    }
+
+    /// @brief Get allocated arrays size in bytes
+    size_t getMemoryUsage() const;
+};
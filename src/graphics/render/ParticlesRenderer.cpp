@@ -4,9 +4,11 @@
 
 #include "assets/Assets.hpp"
 #include "assets/assets_util.hpp"
+#include "graphics/core/InstancedMesh.hpp"
 #include "graphics/core/Shader.hpp"
 #include "graphics/core/Texture.hpp"
 #include "graphics/render/MainBatch.hpp"
+#include "util/LinearAllocator.hpp"
 #include "window/Camera.hpp"
 #include "world/Level.hpp"
 #include "voxels/Chunks.hpp"
@@ -21,25 +23,93 @@ ParticlesRenderer::ParticlesRenderer(
     : batch(std::make_unique<MainBatch>(4096)),
       level(level),
       assets(assets),
-      settings(settings) {}
+      settings(settings),
+      memorySource([this](debug::MemoryBreakdown& breakdown) {
+          size_t size = spawned.capacity() * sizeof(Particle) +
+                        emitters.size() * sizeof(Emitter);
+          for (const auto& [_, buffer] : particles) {
+              size += buffer.getMemoryUsage();
+          }
+          for (const auto& [_, group] : gpuParticles) {
+              // instances are kept on both sides
+              size += group.instances.capacity() * sizeof(float) * 2 +
+                      group.alive.capacity() * sizeof(group.alive[0]);
+          }
+          breakdown["render.particles"] += size;
+      }) {
+}
 
 ParticlesRenderer::~ParticlesRenderer() = default;
 
-static inline void update_particle(
-    Particle& particle, float delta, const Chunks& chunks
+/// @brief Billboard corners of GPU particles
+static const VertexAttribute CORNER_ATTRS[] = {{2}, {0}};
+/// @brief GPU particle attributes: position, velocity, acceleration,
+/// (spawn time, lifetime, angle, angular velocity), UV region, light,
+/// (width, height, global up vector flag)
+static const VertexAttribute PARTICLE_ATTRS[] = {
+    {3}, {3}, {3}, {4}, {4}, {4}, {3}, {0}
+};
+static constexpr int PARTICLE_SIZE = 24;
+
+static const float CORNERS[] = {
+    -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f,
+    -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f,
+};
+
+static inline bool is_gpu_simulated(const ParticlesPreset& preset) {
+    return !preset.collision && preset.frames.empty();
+}
+
+static inline float particle_scale(
+    int random, const ParticlesPreset& preset
+) {
+    return 1.0f + ((random ^ 2628172) % 1000) * 0.001f * preset.sizeSpread;
+}
+
+static glm::vec4 sample_particle_light(
+    const glm::vec3& position,
+    int random,
+    const ParticlesPreset& preset,
+    float scale,
+    const Chunks& chunks,
+    bool backlight
+) {
+    glm::vec4 light(1, 1, 1, 0);
+    if (!preset.lighting) {
+        return light;
+    }
+    light = MainBatch::sampleLight(position, chunks, backlight);
+    auto size = glm::max(glm::vec3(0.5f), preset.size * scale);
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            for (int z = -1; z <= 1; z++) {
+                light = glm::max(
+                    light,
+                    MainBatch::sampleLight(
+                        position - size * glm::vec3(x, y, z),
+                        chunks,
+                        backlight
+                    )
+                );
+            }
+        }
+    }
+    return light * (0.9f + (random % 100) * 0.001f);
+}
+
+/// @brief Stop colliding particles moving into obstacles
+static void check_collisions(
+    ParticlesBuffer& buffer, float delta, const Chunks& chunks
 ) {
-    const auto& preset = particle.emitter->preset;
-    auto& pos = particle.position;
-    auto& vel = particle.velocity;
-    auto& angle = particle.angle;
-
-    vel += delta * preset.acceleration;
-    if (preset.collision && chunks.isObstacleAt(pos + vel * delta)) {
-        vel *= 0.0f;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        if (!buffer.emitters[i]->preset.collision) {
+            continue;
+        }
+        auto vel = buffer.getVelocity(i);
+        if (chunks.isObstacleAt(buffer.getPosition(i) + vel * delta)) {
+            buffer.setVelocity(i, glm::vec3(0.0f));
+        }
     }
-    pos += vel * delta;
-    angle += particle.angularVelocity * delta;
-    particle.lifetime -= delta;
 }
 
 void ParticlesRenderer::renderParticles(const Camera& camera, float delta) {
@@ -49,75 +119,56 @@ void ParticlesRenderer::renderParticles(const Camera& camera, float delta) {
     const auto& chunks = *level.chunks;
     bool backlight = settings->backlight.get();
 
-    std::vector<const Texture*> unusedTextures;
+    util::FrameVector<const Texture*> unusedTextures;
 
-    for (auto& [texture, vec] : particles) {
-        if (vec.empty()) {
+    for (auto& [texture, buffer] : particles) {
+        if (buffer.empty()) {
             unusedTextures.push_back(texture);
             continue;
         }
         batch->setTexture(texture);
 
-        visibleParticles += vec.size();
-
-        auto iter = vec.begin();
-        while (iter != vec.end()) {
-            auto& particle = *iter;
-            auto& emitter = *particle.emitter;
-            auto& preset = emitter.preset;
-
-            if (!preset.frames.empty()) {
-                float time = preset.lifetime - particle.lifetime;
-                int framesCount = preset.frames.size();
-                int frameid = time / preset.lifetime * framesCount;
-                int frameid2 = glm::min(
-                    (time + delta) / preset.lifetime * framesCount,
-                    framesCount - 1.0f
-                );
-                if (frameid2 != frameid) {
-                    auto tregion = util::get_texture_region(
-                        assets, preset.frames.at(frameid2), ""
-                    );
-                    if (tregion.texture == texture) {
-                        particle.region = tregion.region;
-                    }
-                }
-            }
-            update_particle(particle, delta, chunks);
-
-            float scale = 1.0f + ((particle.random ^ 2628172) % 1000) *
-                0.001f * preset.sizeSpread;
+        visibleParticles += buffer.size();
 
-            glm::vec4 light(1, 1, 1, 0);
-            if (preset.lighting) {
-                light = MainBatch::sampleLight(
-                    particle.position,
-                    chunks,
-                    backlight
+        for (size_t i = 0; i < buffer.size(); i++) {
+            const auto& preset = buffer.emitters[i]->preset;
+            if (preset.frames.empty()) {
+                continue;
+            }
+            float time = preset.lifetime - buffer.lifetimes[i];
+            int framesCount = preset.frames.size();
+            int frameid = time / preset.lifetime * framesCount;
+            int frameid2 = glm::min(
+                (time + delta) / preset.lifetime * framesCount,
+                framesCount - 1.0f
+            );
+            if (frameid2 != frameid) {
+                auto tregion = util::get_texture_region(
+                    assets, preset.frames.at(frameid2), ""
                 );
-                auto size = glm::max(glm::vec3(0.5f), preset.size * scale);
-                for (int x = -1; x <= 1; x++) {
-                    for (int y = -1; y <= 1; y++) {
-                        for (int z = -1; z <= 1; z++) {
-                            light = glm::max(
-                                light,
-                                MainBatch::sampleLight(
-                                    particle.position -
-                                        size * glm::vec3(x, y, z),
-                                    chunks,
-                                    backlight
-                                )
-                            );
-                        }
-                    }
+                if (tregion.texture == texture) {
+                    buffer.regions[i] = tregion.region;
                 }
-                light *= 0.9f + (particle.random % 100) * 0.001f;
             }
+        }
+        buffer.accelerate(delta);
+        check_collisions(buffer, delta, chunks);
+        buffer.move(delta);
 
+        for (size_t i = 0; i < buffer.size();) {
+            auto& emitter = *buffer.emitters[i];
+            const auto& preset = emitter.preset;
+            auto position = buffer.getPosition(i);
+            int random = buffer.randoms[i];
+
+            float scale = particle_scale(random, preset);
+            glm::vec4 light = sample_particle_light(
+                position, random, preset, scale, chunks, backlight
+            );
 
             glm::vec3 localRight = right;
             glm::vec3 localUp = preset.globalUpVector ? glm::vec3(0, 1, 0) : up;
-            float angle = particle.angle;
+            float angle = buffer.angles[i];
             if (glm::abs(angle) >= 0.005f) {
                 glm::vec3 rotatedRight(glm::cos(angle), -glm::sin(angle), 0.0f);
                 glm::vec3 rotatedUp(glm::sin(angle), glm::cos(angle), 0.0f);
@@ -128,19 +179,19 @@ void ParticlesRenderer::renderParticles(const Camera& camera, float delta) {
                         camera.front * rotatedUp.z;
             }
             batch->quad(
-                particle.position,
+                position,
                 localRight,
                 localUp,
                 preset.size * scale,
                 light,
                 glm::vec3(1.0f),
-                particle.region
+                buffer.regions[i]
             );
-            if (particle.lifetime <= 0.0f) {
-                iter = vec.erase(iter);
+            if (buffer.lifetimes[i] <= 0.0f) {
+                buffer.swapRemove(i);
                 emitter.refCount--;
             } else {
-                iter++;
+                i++;
             }
         }
     }
@@ -150,13 +201,109 @@ void ParticlesRenderer::renderParticles(const Camera& camera, float delta) {
     }
 }
 
+void ParticlesRenderer::addGPUParticles(const Texture* texture) {
+    if (spawned.empty()) {
+        return;
+    }
+    auto& group = gpuParticles[texture];
+    if (group.mesh == nullptr) {
+        group.mesh = std::make_unique<InstancedMesh>(
+            CORNER_ATTRS, PARTICLE_ATTRS, 1
+        );
+        group.mesh->reload(CORNERS, 6);
+    }
+    const auto& chunks = *level.chunks;
+    bool backlight = settings->backlight.get();
+    for (const auto& particle : spawned) {
+        const auto& preset = particle.emitter->preset;
+        float scale = particle_scale(particle.random, preset);
+        // light is sampled once as particles are not updated on CPU
+        glm::vec4 light = sample_particle_light(
+            particle.position,
+            particle.random,
+            preset,
+            scale,
+            chunks,
+            backlight
+        );
+        const auto& pos = particle.position;
+        const auto& vel = particle.velocity;
+        const auto& acc = preset.acceleration;
+        const auto& region = particle.region;
+        glm::vec3 size = preset.size * scale;
+        group.instances.insert(group.instances.end(), {
+            pos.x, pos.y, pos.z,
+            vel.x, vel.y, vel.z,
+            acc.x, acc.y, acc.z,
+            time, particle.lifetime, particle.angle, particle.angularVelocity,
+            region.u1, region.v1, region.u2, region.v2,
+            light.r, light.g, light.b, light.a,
+            size.x, size.y, preset.globalUpVector ? 1.0f : 0.0f,
+        });
+        group.alive.emplace_back(particle.emitter, time + particle.lifetime);
+    }
+    group.modified = true;
+    spawned.clear();
+}
+
+void ParticlesRenderer::renderGPUParticles(const Camera& camera) {
+    if (gpuParticles.empty()) {
+        return;
+    }
+    auto& shader = assets.require<Shader>("particles");
+    shader.use();
+    shader.uniform1f("u_time", time);
+    shader.uniform3f("u_cameraRight", camera.right);
+    shader.uniform3f("u_cameraUp", camera.up);
+    shader.uniform3f("u_cameraFront", camera.front);
+    shader.uniform1i("u_alphaClip", true);
+
+    auto iter = gpuParticles.begin();
+    while (iter != gpuParticles.end()) {
+        auto& [texture, group] = *iter;
+        auto& alive = group.alive;
+        auto& instances = group.instances;
+        // dead particles are replaced with the last ones
+        for (size_t i = 0; i < alive.size();) {
+            if (alive[i].second > time) {
+                i++;
+                continue;
+            }
+            alive[i].first->refCount--;
+            alive[i] = alive.back();
+            alive.pop_back();
+            std::copy(
+                instances.end() - PARTICLE_SIZE,
+                instances.end(),
+                instances.begin() + i * PARTICLE_SIZE
+            );
+            instances.resize(instances.size() - PARTICLE_SIZE);
+            group.modified = true;
+        }
+        if (alive.empty()) {
+            iter = gpuParticles.erase(iter);
+            continue;
+        }
+        if (group.modified) {
+            group.mesh->reloadInstances(instances.data(), alive.size());
+            group.modified = false;
+        }
+        texture->bind();
+        group.mesh->draw();
+        visibleParticles += alive.size();
+        iter++;
+    }
+}
+
 void ParticlesRenderer::render(const Camera& camera, float delta) {
     batch->begin();
     
     aliveEmitters = emitters.size();
     visibleParticles = 0;
+    time += delta;
 
     renderParticles(camera, delta);
+    renderGPUParticles(camera);
 
     auto iter = emitters.begin();
     while (iter != emitters.end()) {
@@ -167,19 +314,29 @@ void ParticlesRenderer::render(const Camera& camera, float delta) {
             continue;
         }
         auto texture = emitter.getTexture();
-        const auto& found = particles.find(texture);
-        std::vector<Particle>* vec;
-        vec = &particles[texture];
-        emitter.update(delta, camera.position, *vec);
+        if (is_gpu_simulated(emitter.preset)) {
+            emitter.update(delta, camera.position, spawned);
+            addGPUParticles(texture);
+        } else {
+            emitter.update(delta, camera.position, spawned);
+            auto& buffer = particles[texture];
+            for (const auto& particle : spawned) {
+                buffer.push(particle);
+            }
+            spawned.clear();
+        }
         iter++;
     }
 }
 
 void ParticlesRenderer::gc() {
     std::set<Emitter*> usedEmitters;
-    for (const auto& [_, vec] : particles) {
-        for (const auto& particle : vec) {
-            usedEmitters.insert(particle.emitter);
+    for (const auto& [_, buffer] : particles) {
+        usedEmitters.insert(buffer.emitters.begin(), buffer.emitters.end());
+    }
+    for (const auto& [_, group] : gpuParticles) {
+        for (const auto& [emitter, _] : group.alive) {
+            usedEmitters.insert(emitter);
         }
     }
     auto iter = emitters.begin();
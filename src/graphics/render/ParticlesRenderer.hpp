@@ -4,27 +4,53 @@
 #include <memory>
 #include <unordered_map>
 
+#include "debug/MemoryUsage.hpp"
 #include "Emitter.hpp"
+#include "ParticlesBuffer.hpp"
 #include "typedefs.hpp"
 
 class Texture;
+class InstancedMesh;
 class Assets;
 class Camera;
 class MainBatch;
 class Level;
 struct GraphicsSettings;
 
+/// @brief Particles moved by the particles shader along their ballistic
+/// trajectories. Used for presets without collision and animation, so
+/// a particle state is uploaded once when spawned
+struct GPUParticles {
+    /// @brief Per-instance attributes of particles being drawn
+    std::vector<float> instances;
+    /// @brief Particles emitters and their death time
+    std::vector<std::pair<Emitter*, float>> alive;
+    std::unique_ptr<InstancedMesh> mesh;
+    /// @brief Instances must be uploaded again
+    bool modified = false;
+};
+
 class ParticlesRenderer {
     const Level& level;
     const Assets& assets;
     const GraphicsSettings* settings;
-    std::unordered_map<const Texture*, std::vector<Particle>> particles;
+    /// @brief Particles updated on CPU (colliding or animated)
+    std::unordered_map<const Texture*, ParticlesBuffer> particles;
+    std::unordered_map<const Texture*, GPUParticles> gpuParticles;
     std::unique_ptr<MainBatch> batch;
+    /// @brief Simulation time of GPU particles
+    float time = 0.0f;
+    /// @brief Particles spawned by an emitter in this frame
+    std::vector<Particle> spawned;
 
     std::unordered_map<u64id_t, std::unique_ptr<Emitter>> emitters;
     u64id_t nextEmitter = 1;
+    debug::MemorySource memorySource;
 
     void renderParticles(const Camera& camera, float delta);
+    void renderGPUParticles(const Camera& camera);
+    /// @brief Move spawned particles to GPU particles of the texture 
+    void addGPUParticles(const Texture* texture);
 public:
     ParticlesRenderer(
         const Assets& assets,
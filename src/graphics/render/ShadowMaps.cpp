@@ -0,0 +1,207 @@
+#include "ShadowMaps.hpp"
+
+#include <GL/glew.h>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "constants.hpp"
+#include "graphics/core/DrawContext.hpp"
+#include "graphics/core/Framebuffer.hpp"
+#include "graphics/core/Mesh.hpp"
+#include "graphics/core/Shader.hpp"
+#include "graphics/core/Texture.hpp"
+#include "window/Camera.hpp"
+#include "ChunksRenderer.hpp"
+
+/// @brief Half sizes of the cascades areas (blocks)
+static constexpr float CASCADES_RADIUS[ShadowMaps::CASCADES] {
+    24.0f, 64.0f, 160.0f
+};
+/// @brief Sun angle change making cached cascades outdated (radians)
+static constexpr float SUN_ANGLE_THRESHOLD = 0.01f;
+/// @brief Camera distance from a cached cascade center making it outdated,
+/// relative to the cascade radius
+static constexpr float RECENTER_DISTANCE = 0.25f;
+/// @brief Sun height (light direction y) where shadows start to appear
+/// and where they get the full strength
+static constexpr float MIN_SUN_HEIGHT = 0.05f;
+static constexpr float FULL_SUN_HEIGHT = 0.25f;
+/// @brief Texture unit of the maps used by the world shader
+static constexpr int SHADOW_MAP_UNIT = 4;
+
+static const Shader::Uniform U_SHADOW_MATRICES[ShadowMaps::CASCADES] {
+    Shader::Uniform("u_shadowMatrices[0]"),
+    Shader::Uniform("u_shadowMatrices[1]"),
+    Shader::Uniform("u_shadowMatrices[2]"),
+};
+
+ShadowMaps::ShadowMaps(uint resolution) : resolution(resolution) {
+    for (int i = 0; i < CASCADES; i++) {
+        cascades[i].radius = CASCADES_RADIUS[i];
+        cascades[i].cached = i > 0;
+    }
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(
+        GL_TEXTURE_2D_ARRAY,
+        0,
+        GL_DEPTH_COMPONENT24,
+        resolution,
+        resolution,
+        CASCADES,
+        0,
+        GL_DEPTH_COMPONENT,
+        GL_FLOAT,
+        nullptr
+    );
+    // linear filtering of a comparison sampler gives 2x2 PCF
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(
+        GL_TEXTURE_2D_ARRAY,
+        GL_TEXTURE_COMPARE_MODE,
+        GL_COMPARE_REF_TO_TEXTURE
+    );
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    uint fboId;
+    glGenFramebuffers(1, &fboId);
+    glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    fbo = std::make_unique<Framebuffer>(fboId, 0, nullptr);
+}
+
+ShadowMaps::~ShadowMaps() {
+    glDeleteTextures(1, &texture);
+}
+
+void ShadowMaps::update(
+    const DrawContext& pctx,
+    const Camera& camera,
+    const glm::vec3& lightDir,
+    ChunksRenderer& chunks,
+    Shader& shader
+) {
+    strength = glm::clamp(
+        (lightDir.y - MIN_SUN_HEIGHT) / (FULL_SUN_HEIGHT - MIN_SUN_HEIGHT),
+        0.0f,
+        1.0f
+    );
+    if (strength <= 0.0f) {
+        return;
+    }
+    DrawContext ctx = pctx.sub();
+    bool bound = false;
+    for (int i = 0; i < CASCADES; i++) {
+        auto& cascade = cascades[i];
+        if (cascade.cached && cascade.valid &&
+            glm::dot(cascade.lightDir, lightDir) >
+                std::cos(SUN_ANGLE_THRESHOLD) &&
+            glm::distance(cascade.center, camera.position) <
+                cascade.radius * RECENTER_DISTANCE) {
+            continue;
+        }
+        if (!bound) {
+            ctx.setFramebuffer(fbo.get());
+            ctx.setViewport(Viewport(resolution, resolution));
+            ctx.setDepthTest(true);
+            ctx.setDepthMask(true);
+            // both sides cast shadows
+            ctx.setCullFace(false);
+            glEnable(GL_POLYGON_OFFSET_FILL);
+            glPolygonOffset(2.0f, 4.0f);
+            shader.use();
+            bound = true;
+        }
+        cascade.center = camera.position;
+        cascade.lightDir = lightDir;
+        render(cascade, i, chunks, shader);
+    }
+    if (bound) {
+        glDisable(GL_POLYGON_OFFSET_FILL);
+    }
+}
+
+void ShadowMaps::render(
+    Cascade& cascade, int layer, ChunksRenderer& chunks, Shader& shader
+) {
+    glFramebufferTextureLayer(
+        GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, layer
+    );
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    const auto& lightDir = cascade.lightDir;
+    glm::vec3 up = std::abs(lightDir.z) < 0.99f ? glm::vec3(0, 0, 1)
+                                                : glm::vec3(1, 0, 0);
+    // center aligned to the map texels keeps shadows edges still
+    // while the camera moves
+    glm::mat4 rotation = glm::lookAt(glm::vec3(0.0f), -lightDir, up);
+    float texel = cascade.radius * 2.0f / resolution;
+    glm::vec4 center = rotation * glm::vec4(cascade.center, 1.0f);
+    center.x = std::floor(center.x / texel) * texel;
+    center.y = std::floor(center.y / texel) * texel;
+    glm::vec3 aligned = glm::inverse(rotation) * center;
+
+    // casters above the area up to the world height are included
+    float depth = cascade.radius + CHUNK_H;
+    glm::mat4 view = glm::lookAt(aligned + lightDir * depth, aligned, up);
+    glm::mat4 proj = glm::ortho(
+        -cascade.radius,
+        cascade.radius,
+        -cascade.radius,
+        cascade.radius,
+        0.0f,
+        depth * 2.0f
+    );
+    cascade.projView = proj * view;
+    cascade.frustum.update(cascade.projView);
+    cascade.valid = true;
+
+    shader.uniformMatrix("u_projview", cascade.projView);
+    chunks.drawShadowCasters(cascade.frustum, shader);
+}
+
+void ShadowMaps::invalidate(int chunkX, int chunkZ) {
+    glm::vec3 min(chunkX * CHUNK_W, 0.0f, chunkZ * CHUNK_D);
+    glm::vec3 max(min.x + CHUNK_W, CHUNK_H, min.z + CHUNK_D);
+    for (auto& cascade : cascades) {
+        if (cascade.valid && cascade.frustum.isBoxVisible(min, max)) {
+            cascade.valid = false;
+        }
+    }
+}
+
+void ShadowMaps::invalidate() {
+    for (auto& cascade : cascades) {
+        cascade.valid = false;
+    }
+}
+
+void ShadowMaps::disable(Shader& shader) {
+    // samplers of different types must not share a texture unit
+    // even if not used
+    shader.uniform1i("u_shadowMap", SHADOW_MAP_UNIT);
+    shader.uniform1i("u_shadows", false);
+}
+
+void ShadowMaps::bind(Shader& shader) const {
+    if (strength <= 0.0f) {
+        disable(shader);
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glActiveTexture(GL_TEXTURE0);
+    shader.uniform1i("u_shadowMap", SHADOW_MAP_UNIT);
+    shader.uniform1i("u_shadows", true);
+    shader.uniform1f("u_shadowsStrength", strength);
+    shader.uniform1f("u_shadowTexel", 1.0f / resolution);
+    for (int i = 0; i < CASCADES; i++) {
+        shader.uniformMatrix(U_SHADOW_MATRICES[i], cascades[i].projView);
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+#include "maths/FrustumCulling.hpp"
+
+class Camera;
+class Shader;
+class DrawContext;
+class Framebuffer;
+class ChunksRenderer;
+
+/// @brief Cascaded sun shadow maps stored as depth texture array layers.
+/// Cascades are orthographic light views of growing areas around
+/// the camera. The nearest cascade is rendered every frame, farther ones
+/// are cached and rendered again only when the sun angle or the camera
+/// position change past thresholds, or a chunk mesh in the cascade view
+/// is changed. Casters are chunk meshes drawn by ChunksRenderer
+class ShadowMaps {
+public:
+    static constexpr int CASCADES = 3;
+private:
+    struct Cascade {
+        /// @brief Half size of the covered area (blocks)
+        float radius;
+        /// @brief Cached cascades are not rendered every frame
+        bool cached;
+        bool valid = false;
+        /// @brief Camera position and sun direction the map is rendered for
+        glm::vec3 center {};
+        glm::vec3 lightDir {};
+        glm::mat4 projView {1.0f};
+        Frustum frustum;
+    };
+    uint resolution;
+    uint texture = 0;
+    std::unique_ptr<Framebuffer> fbo;
+    Cascade cascades[CASCADES];
+    /// @brief Shadows strength fading at sunrise and sunset, 0 - disabled
+    float strength = 0.0f;
+
+    void render(
+        Cascade& cascade, int layer, ChunksRenderer& chunks, Shader& shader
+    );
+public:
+    /// @param resolution cascade map width and height
+    ShadowMaps(uint resolution);
+    ~ShadowMaps();
+
+    /// @brief Render cascades needing an update
+    /// @param lightDir direction to the sun, see Skybox::getLightDir
+    /// @param chunks casters renderer
+    /// @param shader depth-only chunks shader
+    void update(
+        const DrawContext& pctx,
+        const Camera& camera,
+        const glm::vec3& lightDir,
+        ChunksRenderer& chunks,
+        Shader& shader
+    );
+
+    /// @brief Mark cached cascades the chunk is visible in outdated
+    void invalidate(int chunkX, int chunkZ);
+
+    /// @brief Mark all cascades outdated
+    void invalidate();
+
+    /// @brief Bind the maps and set shadows uniforms of the world shader
+    void bind(Shader& shader) const;
+
+    /// @brief Set uniforms of the world shader drawing without shadows
+    static void disable(Shader& shader);
+
+    uint getResolution() const {
+        return resolution;
+    }
+};
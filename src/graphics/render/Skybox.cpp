@@ -24,16 +24,35 @@
 const int STARS_COUNT = 3000;
 const int STARS_SEED = 632;
 
+static constexpr uint CUBEMAP_FACES = 6;
+/// @brief Sky change below the value is not perceptible and does not
+/// start a new bake
+static constexpr float BAKE_THRESHOLD = 0.002f;
+/// @brief Sky change above the value (day time set, weather switch)
+/// is baked at once instead of one face per frame
+static constexpr float FULL_REFRESH_THRESHOLD = 0.1f;
+
+float SkyParams::difference(const SkyParams& other) const {
+    if (quality != other.quality) {
+        return FULL_REFRESH_THRESHOLD;
+    }
+    float timeDiff = glm::abs(dayTime - other.dayTime);
+    timeDiff = glm::min(timeDiff, 1.0f - timeDiff);
+    return timeDiff * glm::pi<float>() * 2.0f + glm::abs(mie - other.mie);
+}
+
 Skybox::Skybox(uint size, Shader& shader) 
   : size(size), 
     shader(shader), 
     batch3d(std::make_unique<Batch3D>(4096)) 
 {
-    auto cubemap = std::make_unique<Cubemap>(size, size, ImageFormat::rgb888);
+    for (auto& cubemap : cubemaps) {
+        cubemap = std::make_unique<Cubemap>(size, size, ImageFormat::rgb888);
+    }
 
     uint fboid;
     glGenFramebuffers(1, &fboid);
-    fbo = std::make_unique<Framebuffer>(fboid, 0, std::move(cubemap));
+    fbo = std::make_unique<Framebuffer>(fboid, 0, nullptr);
 
     float vertices[] {
         -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
@@ -138,43 +157,64 @@ void Skybox::draw(
     drawStars(angle, opacity);
 }
 
+static glm::vec3 calc_light_dir(float dayTime) {
+    float angle = dayTime * glm::pi<float>() * 2.0f;
+    return glm::normalize(glm::vec3(sin(angle), -cos(angle), 0.0f));
+}
+
+void Skybox::setupShader(const SkyParams& params) {
+    shader.use();
+    shader.uniform1i("u_quality", params.quality);
+    shader.uniform1f("u_mie", params.mie);
+    shader.uniform1f("u_fog", params.mie - 1.0f);
+    shader.uniform3f("u_lightDir", calc_light_dir(params.dayTime));
+    shader.uniform1f("u_dayTime", params.dayTime);
+}
+
 void Skybox::refresh(const DrawContext& pctx, float t, float mie, uint quality) {
     frameid++;
-    float dayTime = t;
+    lightDir = calc_light_dir(t);
+
+    SkyParams params {t, mie, quality};
+    float change = params.difference(baked);
+    bool fullRefresh = !ready || change >= FULL_REFRESH_THRESHOLD;
+    if (bakingFace >= CUBEMAP_FACES && !fullRefresh) {
+        if (change < BAKE_THRESHOLD) {
+            return;
+        }
+        baking = params;
+        bakingFace = 0;
+    }
+
     DrawContext ctx = pctx.sub();
     ctx.setDepthMask(false);
     ctx.setDepthTest(false);
     ctx.setFramebuffer(fbo.get());
     ctx.setViewport(Viewport(size, size));
-
-    auto cubemap = dynamic_cast<Cubemap*>(fbo->getTexture());
-    assert(cubemap != nullptr);
-
-    ready = true;
     glActiveTexture(GL_TEXTURE1);
-    cubemap->bind();
-    shader.use();
-    t *= glm::pi<float>()*2.0f;
-    
-    lightDir = glm::normalize(glm::vec3(sin(t), -cos(t), 0.0f));
-    shader.uniform1i("u_quality", quality);
-    shader.uniform1f("u_mie", mie);
-    shader.uniform1f("u_fog", mie - 1.0f);
-    shader.uniform3f("u_lightDir", lightDir);
-    shader.uniform1f("u_dayTime", dayTime);
-
-    if (glm::abs(mie-prevMie) + glm::abs(t-prevT) >= 0.01) {
-        for (uint face = 0; face < 6; face++) {
-            refreshFace(face, cubemap);
+
+    if (fullRefresh) {
+        auto& cubemap = *cubemaps[frontCubemap];
+        cubemap.bind();
+        setupShader(params);
+        for (uint face = 0; face < CUBEMAP_FACES; face++) {
+            refreshFace(face, &cubemap);
         }
+        cubemap.unbind();
+        baked = params;
+        bakingFace = CUBEMAP_FACES;
+        ready = true;
     } else {
-        uint face = frameid % 6;
-        refreshFace(face, cubemap);
+        auto& cubemap = *cubemaps[!frontCubemap];
+        cubemap.bind();
+        setupShader(baking);
+        refreshFace(bakingFace++, &cubemap);
+        cubemap.unbind();
+        if (bakingFace == CUBEMAP_FACES) {
+            frontCubemap = !frontCubemap;
+            baked = baking;
+        }
     }
-    prevMie = mie;
-    prevT = t;
-    
-    cubemap->unbind();
     glActiveTexture(GL_TEXTURE0);
 }
 
@@ -222,12 +262,12 @@ void Skybox::refreshFace(uint face, Cubemap* cubemap) {
 
 void Skybox::bind() const {
     glActiveTexture(GL_TEXTURE1);
-    fbo->getTexture()->bind();
+    cubemaps[frontCubemap]->bind();
     glActiveTexture(GL_TEXTURE0);
 }
 
 void Skybox::unbind() const {
     glActiveTexture(GL_TEXTURE1);
-    fbo->getTexture()->unbind();
+    cubemaps[frontCubemap]->unbind();
     glActiveTexture(GL_TEXTURE0);
 }
@@ -24,8 +24,22 @@ struct skysprite {
     bool emissive;
 };
 
+/// @brief Sky baking parameters
+struct SkyParams {
+    float dayTime;
+    float mie;
+    uint quality;
+
+    /// @brief Estimate of the sky colour change between parameters
+    /// (sun angle difference in radians plus mie difference)
+    float difference(const SkyParams& other) const;
+};
+
 class Skybox {
     std::unique_ptr<Framebuffer> fbo;
+    /// @brief Displayed and baking cubemaps
+    std::unique_ptr<Cubemap> cubemaps[2];
+    int frontCubemap = 0;
     uint size;
     Shader& shader;
     bool ready = false;
@@ -37,9 +51,14 @@ class Skybox {
     std::vector<skysprite> sprites;
     int frameid = 0;
 
-    float prevMie = -1.0f;
-    float prevT = -1.0f;
+    /// @brief Parameters the front cubemap is baked with
+    SkyParams baked {};
+    /// @brief Parameters of the back cubemap bake in progress
+    SkyParams baking {};
+    /// @brief Next face of the back cubemap to bake, 6 if not baking
+    uint bakingFace = 6;
 
+    void setupShader(const SkyParams& params);
     void drawStars(float angle, float opacity);
     void drawBackground(
         const Camera& camera, const Assets& assets, int width, int height
@@ -57,6 +76,9 @@ public:
         float fog
     );
 
+    /// @brief Update sky cubemap. Changes are baked to the back cubemap
+    /// by one face per frame and shown when all faces are ready.
+    /// Imperceptible changes are skipped, large ones are baked at once
     void refresh(const DrawContext& pctx, float t, float mie, uint quality);
     void bind() const;
     void unbind() const;
@@ -7,7 +7,11 @@ TextNote::TextNote(std::wstring text, NotePreset preset, glm::vec3 position)
 }
 
 void TextNote::setText(std::wstring_view text) {
+    if (this->text == text) {
+        return;
+    }
     this->text = text;
+    version++;
 }
 
 const std::wstring& TextNote::getText() const {
@@ -20,6 +24,7 @@ const NotePreset& TextNote::getPreset() const {
 
 void TextNote::updatePreset(const dv::value& data) {
     preset.deserialize(data);
+    version++;
 }
 
 void TextNote::setPosition(const glm::vec3& position) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "typedefs.hpp"
 #include "presets/NotePreset.hpp"
 
 /// @brief 3D text instance
@@ -10,6 +11,8 @@ class TextNote {
 
     glm::vec3 xAxis {1, 0, 0};
     glm::vec3 yAxis {0, 1, 0};
+    /// @brief Incremented on text or preset change
+    uint version = 0;
 public:
     TextNote(std::wstring text, NotePreset preset, glm::vec3 position);
 
@@ -29,4 +32,9 @@ public:
 
     void setAxisX(const glm::vec3& vec);
     void setAxisY(const glm::vec3& vec);
+
+    /// @brief Get text and preset version used to invalidate cached meshes
+    uint getVersion() const {
+        return version;
+    }
 };
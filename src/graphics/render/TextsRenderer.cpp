@@ -7,18 +7,72 @@
 #include "window/Window.hpp"
 #include "maths/FrustumCulling.hpp"
 #include "graphics/core/Font.hpp"
-#include "graphics/core/Batch3D.hpp"
+#include "graphics/core/GlyphAtlas.hpp"
+#include "graphics/core/Mesh.hpp"
 #include "graphics/core/Shader.hpp"
+#include "graphics/core/Texture.hpp"
 #include "presets/NotePreset.hpp"
 
-TextsRenderer::TextsRenderer(
-    Batch3D& batch, const Assets& assets, const Frustum& frustum
-)
-    : batch(batch), assets(assets), frustum(frustum) {
+/// @brief Notes with glyphs smaller than the value on screen (pixels)
+/// are skipped as unreadable
+static constexpr float MIN_GLYPH_PIXELS = 1.5f;
+
+/// @brief Font mesh vertex size: xyz, uv, rgba
+static constexpr size_t VERTEX_SIZE = 9;
+
+static const Shader::Uniform U_PROJVIEW("u_projview");
+
+TextsRenderer::TextsRenderer(const Assets& assets, const Frustum& frustum)
+    : assets(assets), frustum(frustum) {
+}
+
+TextsRenderer::~TextsRenderer() = default;
+
+const NoteMesh::Layer& TextsRenderer::getMesh(
+    u64id_t id,
+    const TextNote& note,
+    const Font& font,
+    bool frontLayer,
+    float opacity
+) {
+    auto& cache = meshes[id];
+    size_t glyphEvictions = GlyphAtlas::getEvictionsCount();
+    if (cache.font != &font || cache.version != note.getVersion() ||
+        cache.glyphEvictions != glyphEvictions) {
+        cache.font = &font;
+        cache.version = note.getVersion();
+        cache.glyphEvictions = glyphEvictions;
+        for (auto& layer : cache.layers) {
+            layer.valid = false;
+            layer.pages.clear();
+        }
+    }
+    auto& layer = cache.layers[frontLayer];
+    if (layer.valid) {
+        return layer;
+    }
+    const VertexAttribute attrs[] {{3}, {2}, {4}, {0}};
+    auto color = note.getPreset().color;
+    color.a *= opacity;
+
+    FontMeshData data;
+    font.build(data, note.getText(), nullptr, 0, color, glm::vec3(0.0f));
+    for (const auto& page : data.pages) {
+        layer.pages.emplace_back(
+            page.texture,
+            std::make_unique<Mesh>(
+                page.vertices.data(), page.vertices.size() / VERTEX_SIZE, attrs
+            )
+        );
+    }
+    layer.valid = true;
+    return layer;
 }
 
 void TextsRenderer::renderNote(
+    u64id_t id,
     const TextNote& note,
+    Shader& shader,
     const DrawContext& context,
     const Camera& camera,
     const EngineSettings& settings,
@@ -94,21 +148,40 @@ void TextsRenderer::renderNote(
 
             pos = screenPos / screenPos.w;
         }
-    } else if (!frustum.isBoxVisible(pos - xvec * (width * 0.5f * preset.scale), 
-                                     pos + xvec * (width * 0.5f * preset.scale))) {
-        return;
+    } else {
+        float distance = glm::distance(camera.position, pos);
+        float glyphHeight =
+            glm::length(yvec) * preset.scale * font.getLineHeight();
+        float pixels = glyphHeight * Window::height /
+                       (2.0f * distance *
+                        glm::tan(camera.getFov() * camera.zoom * 0.5f));
+        if (pixels < MIN_GLYPH_PIXELS) {
+            return;
+        }
+        if (!frustum.isBoxVisible(
+                pos - xvec * (width * 0.5f * preset.scale),
+                pos + xvec * (width * 0.5f * preset.scale)
+            )) {
+            return;
+        }
     }
-    auto color = preset.color;
-    batch.setColor(glm::vec4(color.r, color.g, color.b, color.a * opacity));
-    font.draw(
-        batch,
-        text,
-        nullptr,
-        0,
-        pos - xvec * (width * 0.5f) * preset.scale,
-        xvec * preset.scale,
-        yvec * preset.scale
+    const auto& mesh = getMesh(id, note, font, frontLayer, opacity);
+
+    glm::vec3 origin = pos - xvec * (width * 0.5f) * preset.scale;
+    glm::mat4 model(
+        glm::vec4(xvec * preset.scale, 0.0f),
+        glm::vec4(yvec * preset.scale, 0.0f),
+        glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+        glm::vec4(origin, 1.0f)
     );
+    if (!projected) {
+        model = camera.getProjView() * model;
+    }
+    shader.uniformMatrix(U_PROJVIEW, model);
+    for (const auto& [texture, pageMesh] : mesh.pages) {
+        texture->bind();
+        pageMesh->draw();
+    }
 }
 
 void TextsRenderer::render(
@@ -121,18 +194,33 @@ void TextsRenderer::render(
     auto& shader = assets.require<Shader>("ui3d");
     
     shader.use();
-    shader.uniformMatrix("u_projview", camera.getProjView());
     shader.uniformMatrix("u_apply", glm::mat4(1.0f));
-    batch.begin();
-    for (const auto& [_, note] : notes) {
-        renderNote(*note, context, camera, settings, hudVisible, frontLayer, false);
+    for (const auto& [id, note] : notes) {
+        renderNote(
+            id,
+            *note,
+            shader,
+            context,
+            camera,
+            settings,
+            hudVisible,
+            frontLayer,
+            false
+        );
     }
-    batch.flush();
-    shader.uniformMatrix("u_projview", glm::mat4(1.0f));
-    for (const auto& [_, note] : notes) {
-        renderNote(*note, context, camera, settings, hudVisible, frontLayer, true);
+    for (const auto& [id, note] : notes) {
+        renderNote(
+            id,
+            *note,
+            shader,
+            context,
+            camera,
+            settings,
+            hudVisible,
+            frontLayer,
+            true
+        );
     }
-    batch.flush();
 }
 
 u64id_t TextsRenderer::add(std::unique_ptr<TextNote> note) {
@@ -151,4 +239,5 @@ TextNote* TextsRenderer::get(u64id_t id) const {
 
 void TextsRenderer::remove(u64id_t id) {
     notes.erase(id);
+    meshes.erase(id);
 }
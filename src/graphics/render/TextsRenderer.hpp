@@ -2,27 +2,57 @@
 
 #include <unordered_map>
 #include <memory>
+#include <vector>
 
 #include "typedefs.hpp"
 
 class DrawContext;
 class Camera;
 class Assets;
-class Batch3D;
 class Frustum;
 class TextNote;
+class Font;
+class Mesh;
+class Shader;
+class Texture;
 struct EngineSettings;
 
+/// @brief Cached glyphs meshes of a text note built in the text space
+/// (x axis - glyph width units, y axis - line height units)
+struct NoteMesh {
+    struct Layer {
+        bool valid = false;
+        /// @brief Glyphs meshes by font pages
+        std::vector<std::pair<const Texture*, std::unique_ptr<Mesh>>> pages;
+    };
+    const Font* font = nullptr;
+    uint version = 0;
+    /// @brief Glyph atlases evictions count the mesh is built with
+    size_t glyphEvictions = 0;
+    /// @brief Normal and x-ray layers meshes (with different opacity)
+    Layer layers[2];
+};
+
 class TextsRenderer {
-    Batch3D& batch;
     const Assets& assets;
     const Frustum& frustum;
 
     std::unordered_map<u64id_t, std::unique_ptr<TextNote>> notes;
+    std::unordered_map<u64id_t, NoteMesh> meshes;
     u64id_t nextNote = 1;
 
+    const NoteMesh::Layer& getMesh(
+        u64id_t id,
+        const TextNote& note,
+        const Font& font,
+        bool frontLayer,
+        float opacity
+    );
+
     void renderNote(
+        u64id_t id,
         const TextNote& note,
+        Shader& shader,
         const DrawContext& context,
         const Camera& camera,
         const EngineSettings& settings,
@@ -31,7 +61,8 @@ class TextsRenderer {
         bool projected
     );
 public:
-    TextsRenderer(Batch3D& batch, const Assets& assets, const Frustum& frustum);
+    TextsRenderer(const Assets& assets, const Frustum& frustum);
+    ~TextsRenderer();
 
     void render(
         const DrawContext& context,
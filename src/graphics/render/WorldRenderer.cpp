@@ -11,6 +11,7 @@
 #include "assets/Assets.hpp"
 #include "assets/assets_util.hpp"
 #include "content/Content.hpp"
+#include "debug/Profiler.hpp"
 #include "engine.hpp"
 #include "frontend/LevelFrontend.hpp"
 #include "items/Inventory.hpp"
@@ -40,6 +41,7 @@
 #include "graphics/core/PostProcessing.hpp"
 #include "graphics/core/Shader.hpp"
 #include "graphics/core/Texture.hpp"
+#include "graphics/core/UniformBuffer.hpp"
 #include "graphics/core/Font.hpp"
 #include "BlockWrapsRenderer.hpp"
 #include "ParticlesRenderer.hpp"
@@ -47,12 +49,35 @@
 #include "ChunksRenderer.hpp"
 #include "GuidesRenderer.hpp"
 #include "ModelBatch.hpp"
+#include "ShadowMaps.hpp"
+#include "HorizonRenderer.hpp"
+#include "ImpostorsRing.hpp"
 #include "Skybox.hpp"
 #include "Emitter.hpp"
 #include "TextNote.hpp"
 
 inline constexpr size_t BATCH3D_CAPACITY = 4096;
 inline constexpr size_t MODEL_BATCH_CAPACITY = 20'000;
+/// @brief Impostors ring cubemap face resolution
+inline constexpr uint IMPOSTORS_RESOLUTION = 1024;
+
+/// @brief WorldUniforms block data, see shaders/lib/world.glsl
+struct WorldUniforms {
+    glm::mat4 proj;
+    glm::mat4 view;
+    glm::vec3 cameraPos;
+    float gamma;
+    glm::vec3 torchlightColor;
+    float torchlightDistance;
+    float fogFactor;
+    float fogCurve;
+    float timer;
+    float dayTime;
+};
+static_assert(sizeof(WorldUniforms) == 176, "std140 layout expected");
+
+static const Shader::Uniform U_MODEL("u_model");
+static const Shader::Uniform U_CUBEMAP("u_cubemap");
 
 bool WorldRenderer::showChunkBorders = false;
 bool WorldRenderer::showEntitiesDebug = false;
@@ -64,24 +89,26 @@ WorldRenderer::WorldRenderer(
       level(frontend.getLevel()),
       player(player),
       assets(*engine->getAssets()),
+      gfxCache(frontend.getContentGfxCache()),
       frustumCulling(std::make_unique<Frustum>()),
       lineBatch(std::make_unique<LineBatch>()),
       batch3d(std::make_unique<Batch3D>(BATCH3D_CAPACITY)),
-      modelBatch(std::make_unique<ModelBatch>(
-          MODEL_BATCH_CAPACITY, assets, *level.chunks, engine->getSettings()
-      )),
-      particles(std::make_unique<ParticlesRenderer>(
-          assets, level, &engine->getSettings().graphics
-      )),
-      texts(std::make_unique<TextsRenderer>(*batch3d, assets, *frustumCulling)),
-      guides(std::make_unique<GuidesRenderer>()),
       chunks(std::make_unique<ChunksRenderer>(
           &level,
           assets,
           *frustumCulling,
-          frontend.getContentGfxCache(),
+          gfxCache,
           engine->getSettings()
       )),
+      guides(std::make_unique<GuidesRenderer>()),
+      modelBatch(std::make_unique<ModelBatch>(
+          MODEL_BATCH_CAPACITY, assets, *level.chunks, engine->getSettings()
+      )),
+      worldUniforms(std::make_unique<UniformBuffer>(sizeof(WorldUniforms))),
+      texts(std::make_unique<TextsRenderer>(assets, *frustumCulling)),
+      particles(std::make_unique<ParticlesRenderer>(
+          assets, level, &engine->getSettings().graphics
+      )),
       blockWraps(std::make_unique<BlockWrapsRenderer>(assets, level)) {
     auto& settings = engine->getSettings();
     level.events->listen(
@@ -97,24 +124,18 @@ WorldRenderer::WorldRenderer(
 
 WorldRenderer::~WorldRenderer() = default;
 
-void WorldRenderer::setupWorldShader(
-    Shader& shader,
-    const Camera& camera,
-    const EngineSettings& settings,
-    float fogFactor
+void WorldRenderer::updateWorldUniforms(
+    const Camera& camera, const EngineSettings& settings, float fogFactor
 ) {
-    shader.use();
-    shader.uniformMatrix("u_model", glm::mat4(1.0f));
-    shader.uniformMatrix("u_proj", camera.getProjection());
-    shader.uniformMatrix("u_view", camera.getView());
-    shader.uniform1f("u_timer", timer);
-    shader.uniform1f("u_gamma", settings.graphics.gamma.get());
-    shader.uniform1f("u_fogFactor", fogFactor);
-    shader.uniform1f("u_fogCurve", settings.graphics.fogCurve.get());
-    shader.uniform1f("u_dayTime", level.getWorld()->getInfo().daytime);
-    shader.uniform2f("u_lightDir", skybox->getLightDir());
-    shader.uniform3f("u_cameraPos", camera.position);
-    shader.uniform1i("u_cubemap", 1);
+    WorldUniforms data {};
+    data.proj = camera.getProjection();
+    data.view = camera.getView();
+    data.cameraPos = camera.position;
+    data.gamma = settings.graphics.gamma.get();
+    data.fogFactor = fogFactor;
+    data.fogCurve = settings.graphics.fogCurve.get();
+    data.timer = timer;
+    data.dayTime = level.getWorld()->getInfo().daytime;
 
     auto indices = level.content->getIndices();
     // Light emission when an emissive item is chosen
@@ -123,14 +144,96 @@ void WorldRenderer::setupWorldShader(
         ItemStack& stack = inventory->getSlot(player->getChosenSlot());
         auto& item = indices->items.require(stack.getItemId());
         float multiplier = 0.5f;
-        shader.uniform3f(
-            "u_torchlightColor",
+        data.torchlightColor = glm::vec3(
             item.emission[0] / 15.0f * multiplier,
             item.emission[1] / 15.0f * multiplier,
             item.emission[2] / 15.0f * multiplier
         );
-        shader.uniform1f("u_torchlightDistance", 6.0f);
+        data.torchlightDistance = 6.0f;
+    }
+    worldUniforms->update(&data);
+    worldUniforms->bind(Shader::WORLD_UNIFORMS_BINDING);
+}
+
+void WorldRenderer::updateShadows(
+    const DrawContext& pctx,
+    const Camera& camera,
+    const EngineSettings& settings
+) {
+    chunks->takeUpdatedMeshes(updatedMeshes);
+    if (!settings.graphics.shadows.get()) {
+        shadows.reset();
+        return;
+    }
+    uint resolution = settings.graphics.shadowsResolution.get();
+    if (shadows == nullptr || shadows->getResolution() != resolution) {
+        shadows = std::make_unique<ShadowMaps>(resolution);
     }
+    for (const auto& key : updatedMeshes) {
+        shadows->invalidate(key.x, key.y);
+    }
+    shadows->update(
+        pctx,
+        camera,
+        skybox->getLightDir(),
+        *chunks,
+        assets.require<Shader>("shadows")
+    );
+}
+
+void WorldRenderer::updateHorizon(
+    const Camera& camera, const EngineSettings& settings, float delta
+) {
+    int distance = settings.graphics.horizonDistance.get();
+    if (distance <= settings.chunks.loadDistance.get()) {
+        horizon.reset();
+        return;
+    }
+    if (horizon == nullptr) {
+        horizon = std::make_unique<HorizonRenderer>(level, assets, gfxCache);
+    }
+    horizon->update(camera, distance, delta);
+}
+
+void WorldRenderer::updateImpostors(
+    const DrawContext& pctx,
+    const Camera& camera,
+    const EngineSettings& settings,
+    float fogFactor,
+    Shader& shader
+) {
+    int distance = settings.graphics.impostorsDistance.get();
+    if (distance == 0 || distance >= settings.chunks.loadDistance.get()) {
+        impostors.reset();
+        chunks->setImpostorsArea({}, 0.0f);
+        return;
+    }
+    if (impostors == nullptr) {
+        impostors = std::make_unique<ImpostorsRing>(IMPOSTORS_RESOLUTION);
+    }
+    for (const auto& key : updatedMeshes) {
+        impostors->invalidate(key.x, key.y);
+    }
+    float blocks = distance * CHUNK_W;
+    bool baked = impostors->update(
+        pctx,
+        camera,
+        blocks,
+        [&](const Camera& faceCamera) {
+            updateWorldUniforms(faceCamera, settings, fogFactor);
+            chunks->drawImpostorMeshes(faceCamera, shader, blocks);
+        }
+    );
+    if (baked) {
+        updateWorldUniforms(camera, settings, fogFactor);
+    }
+    chunks->setImpostorsArea(impostors->getCenter(), blocks);
+}
+
+void WorldRenderer::setupWorldShader(Shader& shader) {
+    shader.use();
+    shader.uniformMatrix(U_MODEL, glm::mat4(1.0f));
+    shader.uniform1i(U_CUBEMAP, 1);
 }
 
 void WorldRenderer::renderLevel(
@@ -141,14 +244,22 @@ void WorldRenderer::renderLevel(
     bool pause,
     bool hudVisible
 ) {
-    texts->render(ctx, camera, settings, hudVisible, false);
+    {
+        debug::ProfileScope scope("texts");
+        texts->render(ctx, camera, settings, hudVisible, false);
+    }
 
     bool culling = engine->getSettings().graphics.frustumCulling.get();
-    float fogFactor =
-        15.0f / static_cast<float>(settings.chunks.loadDistance.get() - 2);
+    int fogDistance = settings.chunks.loadDistance.get();
+    if (horizon) {
+        fogDistance = settings.graphics.horizonDistance.get();
+    }
+    float fogFactor = 15.0f / static_cast<float>(fogDistance - 2);
+
+    updateWorldUniforms(camera, settings, fogFactor);
 
     auto& entityShader = assets.require<Shader>("entity");
-    setupWorldShader(entityShader, camera, settings, fogFactor);
+    setupWorldShader(entityShader);
     skybox->bind();
 
     if (culling) {
@@ -156,29 +267,70 @@ void WorldRenderer::renderLevel(
     }
 
     entityShader.uniform1i("u_alphaClip", true);
-    level.entities->render(
-        assets,
-        *modelBatch,
-        culling ? frustumCulling.get() : nullptr,
-        delta,
-        pause
-    );
-    modelBatch->render();
-    particles->render(camera, delta * !pause);
+    {
+        debug::ProfileScope scope("entities");
+        level.entities->render(
+            assets,
+            *modelBatch,
+            culling ? frustumCulling.get() : nullptr,
+            delta,
+            pause
+        );
+        modelBatch->render();
+    }
+    {
+        debug::ProfileScope scope("particles");
+        auto& particlesShader = assets.require<Shader>("particles");
+        setupWorldShader(particlesShader);
+        entityShader.use();
+        particles->render(camera, delta * !pause);
+    }
 
     auto& shader = assets.require<Shader>("main");
     auto& linesShader = assets.require<Shader>("lines");
 
-    setupWorldShader(shader, camera, settings, fogFactor);
+    setupWorldShader(shader);
+    if (shadows) {
+        shadows->bind(shader);
+    } else {
+        ShadowMaps::disable(shader);
+    }
+    {
+        debug::ProfileScope scope("impostors-update");
+        updateImpostors(ctx, camera, settings, fogFactor, shader);
+    }
 
-    chunks->drawChunks(camera, shader);
+    if (horizon) {
+        debug::ProfileScope scope("horizon");
+        auto& horizonShader = assets.require<Shader>("horizon");
+        setupWorldShader(horizonShader);
+        horizon->draw(
+            ctx,
+            camera,
+            horizonShader,
+            (settings.chunks.loadDistance.get() - 1) * CHUNK_W
+        );
+        shader.use();
+    }
+    if (impostors) {
+        debug::ProfileScope scope("impostors");
+        impostors->draw(ctx, camera, assets.require<Shader>("impostors"));
+        shader.use();
+    }
+    {
+        debug::ProfileScope scope("chunks");
+        chunks->drawChunks(camera, shader);
+    }
     blockWraps->draw(ctx, *player);
 
     if (hudVisible) {
         renderLines(camera, linesShader, ctx);
     }
-    shader.use();
-    chunks->drawSortedMeshes(camera, shader);
+    {
+        debug::ProfileScope scope("translucent");
+        shader.use();
+        chunks->drawSortedMeshes(camera, shader);
+    }
 
     if (!pause) {
         scripting::on_frontend_render();
@@ -289,7 +441,8 @@ void WorldRenderer::renderHands(
         nullptr
     );
     Window::clearDepth();
-    setupWorldShader(entityShader, hudcam, engine->getSettings(), 0.0f);
+    updateWorldUniforms(hudcam, engine->getSettings(), 0.0f);
+    setupWorldShader(entityShader);
     skybox->bind();
     modelBatch->render();
     modelBatch->setLightsOffset(glm::vec3());
@@ -312,21 +465,46 @@ void WorldRenderer::draw(
     const auto& settings = engine->getSettings();
     const auto& worldInfo = world->getInfo();
 
-    skybox->refresh(pctx, worldInfo.daytime, 1.0f + worldInfo.fog * 2.0f, 4);
+    debug::ProfileScope worldScope("world");
+    {
+        debug::ProfileScope scope("sky-refresh");
+        skybox->refresh(
+            pctx, worldInfo.daytime, 1.0f + worldInfo.fog * 2.0f, 4
+        );
+    }
 
     const auto& assets = *engine->getAssets();
     auto& linesShader = assets.require<Shader>("lines");
+    chunks->setFrameTime(engine->getWorkTime(), engine->getTargetFrameTime());
+    {
+        debug::ProfileScope scope("shadows");
+        updateShadows(pctx, camera, settings);
+    }
+    {
+        debug::ProfileScope scope("horizon-update");
+        updateHorizon(camera, settings, delta);
+    }
 
     /* World render scope with diegetic HUD included */ {
         DrawContext wctx = pctx.sub();
+        postProcessing->setDynamicResolution(
+            settings.graphics.dynamicResolution.get(),
+            1000.0f / settings.graphics.dynamicResolutionFps.get()
+        );
         postProcessing->use(wctx);
 
         Window::clearDepth();
 
         // Drawing background sky plane
-        skybox->draw(pctx, camera, assets, worldInfo.daytime, worldInfo.fog);
+        {
+            debug::ProfileScope scope("skybox");
+            skybox->draw(
+                wctx, camera, assets, worldInfo.daytime, worldInfo.fog
+            );
+        }
         
         /* Actually world render with depth buffer on */ {
+            debug::ProfileScope scope("level");
             DrawContext ctx = wctx.sub();
             ctx.setDepthTest(true);
             ctx.setCullFace(true);
@@ -351,6 +529,7 @@ void WorldRenderer::draw(
     }
 
     // Rendering fullscreen quad with
+    debug::ProfileScope scope("post-processing");
     auto screenShader = assets.get<Shader>("screen");
     screenShader->use();
     screenShader->uniform1f("u_timer", timer);
@@ -405,4 +584,9 @@ void WorldRenderer::renderBlockOverlay(const DrawContext& wctx) {
 
 void WorldRenderer::clear() {
     chunks->clear();
+    if (shadows) {
+        shadows->invalidate();
+    }
+    // baked again with the next frame
+    impostors.reset();
 }
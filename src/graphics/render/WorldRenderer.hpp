@@ -26,9 +26,14 @@ class Engine;
 class LevelFrontend;
 class Skybox;
 class PostProcessing;
+class ShadowMaps;
+class HorizonRenderer;
+class ImpostorsRing;
+class ContentGfxCache;
 class DrawContext;
 class ModelBatch;
 class Assets;
+class UniformBuffer;
 struct EngineSettings;
 
 class WorldRenderer {
@@ -36,6 +41,7 @@ class WorldRenderer {
     const Level& level;
     Player* player;
     const Assets& assets;
+    const ContentGfxCache& gfxCache;
     std::unique_ptr<Frustum> frustumCulling;
     std::unique_ptr<LineBatch> lineBatch;
     std::unique_ptr<Batch3D> batch3d;
@@ -43,6 +49,16 @@ class WorldRenderer {
     std::unique_ptr<GuidesRenderer> guides;
     std::unique_ptr<Skybox> skybox;
     std::unique_ptr<ModelBatch> modelBatch;
+    /// @brief Sun shadow maps, null if disabled
+    std::unique_ptr<ShadowMaps> shadows;
+    /// @brief Chunks with changed meshes invalidating shadow maps
+    std::vector<glm::ivec2> updatedMeshes;
+    /// @brief Far terrain beyond loaded chunks, null if disabled
+    std::unique_ptr<HorizonRenderer> horizon;
+    /// @brief Far loaded chunks baked around the camera, null if disabled
+    std::unique_ptr<ImpostorsRing> impostors;
+    /// @brief WorldUniforms block buffer
+    std::unique_ptr<UniformBuffer> worldUniforms;
     
     float timer = 0.0f;
 
@@ -60,12 +76,37 @@ class WorldRenderer {
 
     void renderBlockOverlay(const DrawContext& context);
 
-    void setupWorldShader(
-        Shader& shader,
+    /// @brief Upload camera, fog, time and torchlight state shared by
+    /// world shaders through the WorldUniforms block
+    void updateWorldUniforms(
+        const Camera& camera, const EngineSettings& settings, float fogFactor
+    );
+
+    /// @brief Create, remove or update shadow maps following the settings
+    void updateShadows(
+        const DrawContext& pctx,
+        const Camera& camera,
+        const EngineSettings& settings
+    );
+
+    /// @brief Create, remove or update the horizon following the settings
+    void updateHorizon(
+        const Camera& camera, const EngineSettings& settings, float delta
+    );
+
+    /// @brief Create, remove or bake the impostors ring following
+    /// the settings
+    /// @param shader world shader
+    void updateImpostors(
+        const DrawContext& pctx,
         const Camera& camera,
         const EngineSettings& settings,
-        float fogFactor
+        float fogFactor,
+        Shader& shader
     );
+
+    /// @brief Use the world shader resetting its own uniforms
+    void setupWorldShader(Shader& shader);
 public:
     std::unique_ptr<TextsRenderer> texts;
     std::unique_ptr<ParticlesRenderer> particles;
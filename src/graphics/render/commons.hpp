@@ -1,40 +1,102 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <memory>
 #include <glm/vec3.hpp>
 
+#include "constants.hpp"
 #include "graphics/core/MeshData.hpp"
+#include "graphics/core/MeshArena.hpp"
 #include "util/Buffer.hpp"
 
-/// @brief Chunk mesh vertex attributes
-inline const VertexAttribute CHUNK_VATTRS[]{ {3}, {2}, {1}, {0} };
+/// @brief Chunk mesh vertex attributes: three 32 bit words stored as floats
+/// - x | z << 16
+/// - light (4 bits per channel) | y << 16
+/// - v | u << 10 | atlas region index << 20
+/// Coordinates are chunk-local 16 bit fixed point values, u, v are 10 bit
+/// fixed point texture coordinates inside of the atlas region (tiled)
+inline const VertexAttribute CHUNK_VATTRS[]{ {3}, {0} };
 /// @brief Chunk mesh vertex size divided by sizeof(float)
-inline constexpr int CHUNK_VERTEX_SIZE = 6;
+inline constexpr int CHUNK_VERTEX_SIZE = 3;
+
+/// @brief Chunk mesh per-draw attributes: chunk offset
+inline const VertexAttribute CHUNK_DRAW_ATTRS[]{ {3}, {0} };
+
+/// @brief Chunk vertex coordinates offset making them non-negative
+inline constexpr float CHUNK_VERTEX_POS_OFFSET = 16.0f;
+/// @brief Chunk vertex coordinates fixed point scale, lower precision
+/// of taller chunks keeps y in 16 bits. Passed to shaders as
+/// CHUNK_POS_SCALE define
+inline constexpr float CHUNK_VERTEX_POS_SCALE = CHUNK_H <= 448 ? 128.0f : 64.0f;
+static_assert(
+    (CHUNK_H + CHUNK_VERTEX_POS_OFFSET * 2) * CHUNK_VERTEX_POS_SCALE <= 65536,
+    "chunk vertex y does not fit 16 bits"
+);
+/// @brief Chunk vertex texture coordinates fixed point scale
+inline constexpr float CHUNK_VERTEX_UV_SCALE = 32.0f;
+/// @brief Max number of texture tiles along a merged chunk mesh face
+inline constexpr int CHUNK_MAX_TILES = 31;
 
 class Mesh;
 
 struct SortingMeshEntry {
     glm::vec3 position;
     util::Buffer<float> vertexData;
-    long long distance;
-
-    inline bool operator<(const SortingMeshEntry& o) const noexcept {
-        return distance > o.distance;
-    }
 };
 
 struct SortingMeshData {
     std::vector<SortingMeshEntry> entries;
 };
 
+/// @brief Mesh data of a single chunk section kept to rebuild modified
+/// sections only
+struct ChunkSectionMesh {
+    util::Buffer<float> vertices;
+    /// @brief Indices relative to the section vertices
+    util::Buffer<int> indices;
+    std::vector<SortingMeshEntry> sortingEntries;
+};
+
+/// @brief Chunk sections meshes. Unchanged sections are shared between
+/// chunk mesh rebuilds
+using ChunkSections =
+    std::array<std::shared_ptr<const ChunkSectionMesh>, CHUNK_SECTIONS>;
+
 struct ChunkMeshData {
     MeshData mesh;
     SortingMeshData sortingMesh;
+    std::shared_ptr<const ChunkSections> sections = nullptr;
+    /// @brief Surface cell size of simplified mesh, 1 is full detail
+    int lod = 1;
+};
+
+/// @brief Translucent entries placement in the chunk sorted mesh vertices.
+/// Immutable after creation, shared with sorting jobs
+struct SortingMeshLayout {
+    std::vector<glm::vec3> positions;
+    /// @brief First vertex of each entry, the last value is vertices count
+    std::vector<int> offsets;
 };
 
 struct ChunkMesh {
-    std::unique_ptr<Mesh> mesh;
-    SortingMeshData sortingMeshData;
+    /// @brief Opaque mesh stored in the chunks mesh arena
+    ArenaMesh mesh;
+    /// @brief Translucent entries vertices uploaded once, drawn in order of
+    /// indices sorted by workers
     std::unique_ptr<Mesh> sortedMesh = nullptr;
+    std::shared_ptr<const SortingMeshLayout> sortingLayout = nullptr;
+    /// @brief Back indices buffer filled by the next sorting job while
+    /// the current order is drawn
+    std::shared_ptr<std::vector<int>> sortingIndices = nullptr;
+    /// @brief Camera position the drawn indices are sorted for
+    glm::vec3 sortedFor {};
+    /// @brief Sorting job of the current mesh version is in work
+    bool sorting = false;
+    /// @brief Incremented on mesh change to discard outdated sort results
+    uint32_t version = 0;
+    /// @brief Sections meshes kept for chunks near to the camera
+    std::shared_ptr<const ChunkSections> sections = nullptr;
+    /// @brief Surface cell size of simplified mesh, 1 is full detail
+    int lod = 1;
 };
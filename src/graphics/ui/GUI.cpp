@@ -31,6 +31,7 @@ GUI::GUI() {
 
     menu = std::make_shared<Menu>();
     menu->setId("menu");
+    menu->setCached(true);
     container->add(menu);
     container->setScrollable(false);
 
@@ -56,6 +56,12 @@ void Button::setText(std::wstring text) {
     }
 }
 
+void Button::setText(std::string_view text) {
+    if (label) {
+        label->setText(text);
+    }
+}
+
 std::wstring Button::getText() const {
     if (label) {
         return label->getText();
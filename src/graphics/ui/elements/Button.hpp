@@ -25,6 +25,8 @@ namespace gui {
         virtual void setTextAlign(Align align);
 
         virtual void setText(std::wstring text);
+        /// @brief Set UTF-8 text, see Label::setText(std::string_view)
+        void setText(std::string_view text);
         virtual std::wstring getText() const;
 
         virtual Button* textSupplier(wstringsupplier supplier);
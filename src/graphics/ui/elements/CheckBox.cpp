@@ -26,6 +26,7 @@ void CheckBox::draw(const DrawContext& pctx, const Assets&) {
 
 void CheckBox::mouseRelease(GUI*, int, int) {
     checked = !checked;
+    invalidate();
     if (consumer) {
         consumer(checked);
     }
@@ -33,6 +34,7 @@ void CheckBox::mouseRelease(GUI*, int, int) {
 
 void CheckBox::setSupplier(boolsupplier supplier) {
     this->supplier = std::move(supplier);
+    invalidate();
 }
 
 void CheckBox::setConsumer(boolconsumer consumer) {
@@ -41,6 +43,7 @@ void CheckBox::setConsumer(boolconsumer consumer) {
 
 CheckBox* CheckBox::setChecked(bool flag) {
     checked = flag;
+    invalidate();
     return this;
 }
 
@@ -16,6 +16,9 @@ namespace gui {
         CheckBox(bool checked=false);
 
         virtual void draw(const DrawContext& pctx, const Assets& assets) override;
+        virtual bool isCacheable() const override {
+            return supplier == nullptr;
+        }
 
         virtual void mouseRelease(GUI*, int x, int y) override;
 
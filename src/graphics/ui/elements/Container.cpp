@@ -2,6 +2,8 @@
 
 #include "graphics/core/DrawContext.hpp"
 #include "graphics/core/Batch2D.hpp"
+#include "assets/Assets.hpp"
+#include "graphics/core/GlyphAtlas.hpp"
 
 #include <algorithm>
 #include <utility>
@@ -63,6 +65,7 @@ void Container::mouseMove(GUI* gui, int x, int y) {
         scroll = -glm::min(
             glm::max(static_cast<float>(-scroll), 0.0f), actualLength - size.y
         );
+        invalidate();
     }
     prevScrollY = y;
 }
@@ -100,6 +103,7 @@ void Container::scrolled(int value) {
     int diff = (actualLength-getSize().y);
     if (scroll < 0 && diff <= 0) {
         scroll = 0;
+        invalidate();
     }
     if (diff > 0 && scrollable) {
         scroll += value * scrollStep;
@@ -108,6 +112,7 @@ void Container::scrolled(int value) {
         if (-scroll > diff) {
             scroll = -diff;
         }
+        invalidate();
     } else if (parent) {
         parent->scrolled(value);
     }
@@ -115,9 +120,65 @@ void Container::scrolled(int value) {
 
 void Container::setScrollable(bool flag) {
     scrollable = flag;
+    invalidate();
+}
+
+void Container::invalidate() {
+    dirty = true;
+    UINode::invalidate();
+}
+
+bool Container::isCacheable() const {
+    for (const auto& node : nodes) {
+        if (node->isVisible() && !node->isCacheable()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Container::setCached(bool flag) {
+    cached = flag;
+    cache.reset();
+    invalidate();
+}
+
+bool Container::isCached() const {
+    return cached;
 }
 
 void Container::draw(const DrawContext& pctx, const Assets& assets) {
+    if (!cached) {
+        drawContent(pctx, assets);
+        return;
+    }
+    auto batch = pctx.getBatch2D();
+    glm::vec2 pos = calcPos();
+    if (!dirty && cache && cachePos == pos && cacheAssets == &assets &&
+        cacheAssetsVersion == assets.getVersion() &&
+        cacheGlyphEvictions == GlyphAtlas::getEvictionsCount() &&
+        batch->replay(*cache)) {
+        return;
+    }
+    if (dirty) {
+        dirty = false;
+        cacheable = isCacheable();
+    }
+    if (!cacheable) {
+        cache.reset();
+        drawContent(pctx, assets);
+        return;
+    }
+    batch->beginRecording();
+    drawContent(pctx, assets);
+    cache = batch->endRecording();
+    cachePos = pos;
+    cacheAssets = &assets;
+    cacheAssetsVersion = assets.getVersion();
+    cacheGlyphEvictions = GlyphAtlas::getEvictionsCount();
+}
+
+void Container::drawContent(const DrawContext& pctx, const Assets& assets) {
     glm::vec2 pos = calcPos();
     glm::vec2 size = getSize();
     drawBackground(pctx, assets);
@@ -125,7 +186,6 @@ void Container::draw(const DrawContext& pctx, const Assets& assets) {
     auto batch = pctx.getBatch2D();
     batch->texture(nullptr);
     if (!nodes.empty()) {
-        batch->flush();
         DrawContext ctx = pctx.sub();
         ctx.setScissors(glm::vec4(pos.x, pos.y, glm::ceil(size.x), glm::ceil(size.y)));
         for (const auto& node : nodes) {
@@ -144,7 +204,6 @@ void Container::draw(const DrawContext& pctx, const Assets& assets) {
                 scrollBarWidth, h
             );
         }
-        batch->flush();
     }
 }
 
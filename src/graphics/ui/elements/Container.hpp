@@ -2,12 +2,31 @@
 
 #include "UINode.hpp"
 #include "commons.hpp"
+#include "graphics/core/Batch2D.hpp"
 
 #include <vector>
 
 namespace gui {
     class Container : public UINode {
         int prevScrollY = -1;
+        /// @brief Draws of the container are recorded and replayed while
+        /// the container is not invalidated
+        bool cached = false;
+        /// @brief Appearance changed since the last recording
+        bool dirty = true;
+        /// @brief All sub-elements are cacheable (checked on change)
+        bool cacheable = false;
+        /// @brief Screen position the cache is recorded at
+        glm::vec2 cachePos {};
+        /// @brief Assets the cache is recorded with (textures are
+        /// referenced by pointers)
+        const Assets* cacheAssets = nullptr;
+        size_t cacheAssetsVersion = 0;
+        /// @brief Glyph atlases evictions count the cache is recorded with
+        size_t cacheGlyphEvictions = 0;
+        std::unique_ptr<Batch2D::Recording> cache;
+
+        void drawContent(const DrawContext& pctx, const Assets& assets);
     protected:
         std::vector<std::shared_ptr<UINode>> nodes;
         std::vector<IntervalEvent> intervalEvents;
@@ -41,6 +60,13 @@ namespace gui {
         virtual int getScrollStep() const;
         virtual void setScrollStep(int step);
         virtual void refresh() override;
+        virtual void invalidate() override;
+        virtual bool isCacheable() const override;
+
+        /// @brief Enable caching of the container draws, so unchanged
+        /// content is not rebuilt every frame
+        void setCached(bool flag);
+        bool isCached() const;
 
         virtual void mouseMove(GUI*, int x, int y) override;
         virtual void mouseRelease(GUI*, int x, int y) override;
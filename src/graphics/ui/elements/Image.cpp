@@ -52,6 +52,7 @@ void Image::draw(const DrawContext& pctx, const Assets& assets) {
 
 void Image::setAutoResize(bool flag) {
     autoresize = flag;
+    invalidate();
 }
 bool Image::isAutoResize() const {
     return autoresize;
@@ -63,4 +64,5 @@ const std::string& Image::getTexture() const {
 
 void Image::setTexture(const std::string& name) {
     texture = name;
+    invalidate();
 }
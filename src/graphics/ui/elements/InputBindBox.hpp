@@ -21,5 +21,6 @@ namespace gui {
         virtual void clicked(GUI*, mousecode button) override;
         virtual void keyPressed(keycode key) override;
         virtual bool isFocuskeeper() const override {return true;}
+        virtual bool isCacheable() const override {return false;}
     };
 }
@@ -16,6 +16,7 @@
 #include "voxels/Block.hpp"
 #include "window/Events.hpp"
 #include "window/input.hpp"
+#include "window/Window.hpp"
 #include "world/Level.hpp"
 #include "graphics/core/Atlas.hpp"
 #include "graphics/core/Batch2D.hpp"
@@ -27,6 +28,7 @@
 #include "graphics/ui/GUI.hpp"
 
 #include <glm/glm.hpp>
+#include <algorithm>
 #include <utility>
 
 using namespace gui;
@@ -56,7 +58,8 @@ void InventoryBuilder::addGrid(
     glm::vec2 pos, 
     glm::vec4 padding,
     bool addpanel,
-    const SlotLayout& slotLayout
+    const SlotLayout& slotLayout,
+    bool virtualized
 ) {
     const int slotSize = InventoryView::SLOT_SIZE;
     const int interval = InventoryView::SLOT_INTERVAL;
@@ -81,6 +84,15 @@ void InventoryBuilder::addGrid(
         view->add(panel, pos);
     }
 
+    if (virtualized) {
+        auto gridLayout = slotLayout;
+        gridLayout.index = 0;
+        gridLayout.position = glm::vec2(padding.x, padding.y);
+        view->addVirtualGrid(
+            gridLayout, cols, count, glm::vec2(slotSize + interval)
+        );
+        return;
+    }
     for (int row = 0; row < rows; row++) {
         for (int col = 0; col < cols; col++) {
             if (row * cols + col >= count) {
@@ -120,15 +132,17 @@ void SlotView::draw(const DrawContext& pctx, const Assets& assets) {
         return;
     }
     itemid_t itemid = bound->getItemId();
-    if (itemid != prevItem) {
+    if (itemid != prevItem || iconOutdated) {
+        auto& def = content->getIndices()->items.require(itemid);
         if (itemid) {
-            auto& def = content->getIndices()->items.require(itemid);
             tooltip = util::pascal_case(
                 langs::get(util::str2wstr_utf8(def.caption))
             );
         } else {
             tooltip.clear();
         }
+        icon = resolveIcon(def, assets);
+        iconOutdated = false;
     }
     prevItem = itemid;
 
@@ -157,49 +171,50 @@ void SlotView::draw(const DrawContext& pctx, const Assets& assets) {
     
     batch->setColor(glm::vec4(1.0f));
 
-    auto previews = assets.get<Atlas>("block-previews");
-    auto indices = content->getIndices();
-
-    auto& item = indices->items.require(stack.getItemId());
-    switch (item.iconType) {
-        case ItemIconType::NONE:
-            break;
-        case ItemIconType::BLOCK: {
-            const Block& cblock = content->blocks.require(item.icon);
-            batch->texture(previews->getTexture());
-
-            UVRegion region = previews->get(cblock.name);
-            batch->rect(
-                pos.x, pos.y, slotSize, slotSize, 
-                0, 0, 0, region, false, true, tint);
-            break;
-        }
-        case ItemIconType::SPRITE: {
-            auto textureRegion =
-                util::get_texture_region(assets, item.icon, "blocks:notfound");
-            
-            batch->texture(textureRegion.texture);
-            batch->rect(
-                pos.x, pos.y, slotSize, slotSize, 
-                0, 0, 0, textureRegion.region, false, true, tint);
-            break;
-        }
+    if (icon.texture) {
+        batch->texture(icon.texture);
+        batch->rect(
+            pos.x, pos.y, slotSize, slotSize, 
+            0, 0, 0, icon.region, false, true, tint);
     }
 
-    if (stack.getCount() > 1) {
+    itemcount_t count = stack.getCount();
+    if (count != prevCount) {
+        countText = count > 1 ? std::to_wstring(count) : L"";
+        prevCount = count;
+    }
+    if (!countText.empty()) {
         auto font = assets.get<Font>("normal");
-        std::wstring text = std::to_wstring(stack.getCount());
 
-        int x = pos.x+slotSize-text.length()*8;
+        int x = pos.x+slotSize-countText.length()*8;
         int y = pos.y+slotSize-16;
 
         batch->setColor({0, 0, 0, 1.0f});
-        font->draw(*batch, text, x+1, y+1, nullptr, 0);
+        font->draw(*batch, countText, x+1, y+1, nullptr, 0);
         batch->setColor(glm::vec4(1.0f));
-        font->draw(*batch, text, x, y, nullptr, 0);
+        font->draw(*batch, countText, x, y, nullptr, 0);
     }
 }
 
+util::TextureRegion SlotView::resolveIcon(
+    const ItemDef& item, const Assets& assets
+) const {
+    switch (item.iconType) {
+        case ItemIconType::NONE:
+            break;
+        case ItemIconType::BLOCK: {
+            const Block& cblock = content->blocks.require(item.icon);
+            auto previews = assets.get<Atlas>("block-previews");
+            return {previews->getTexture(), previews->get(cblock.name)};
+        }
+        case ItemIconType::SPRITE:
+            return util::get_texture_region(
+                assets, item.icon, "blocks:notfound"
+            );
+    }
+    return {nullptr, UVRegion()};
+}
+
 void SlotView::setHighlighted(bool flag) {
     highlighted = flag;
 }
@@ -321,6 +336,10 @@ ItemStack& SlotView::getStack() {
     return *bound;
 }
 
+void SlotView::setIndex(int index) {
+    layout.index = index;
+}
+
 InventoryView::InventoryView() : Container(glm::vec2()) {
     setColor(glm::vec4(0, 0, 0, 0.0f));
 }
@@ -328,11 +347,10 @@ InventoryView::InventoryView() : Container(glm::vec2()) {
 InventoryView::~InventoryView() {}
 
 
-std::shared_ptr<SlotView> InventoryView::addSlot(const SlotLayout& layout) {
-    uint width =  InventoryView::SLOT_SIZE + layout.padding;
-    uint height = InventoryView::SLOT_SIZE + layout.padding;
+void InventoryView::fitSlot(glm::vec2 pos, int padding) {
+    uint width =  InventoryView::SLOT_SIZE + padding;
+    uint height = InventoryView::SLOT_SIZE + padding;
 
-    auto pos = layout.position;
     auto vsize = getSize();
     if (pos.x + width > vsize.x) {
         vsize.x = pos.x + width;
@@ -341,6 +359,10 @@ std::shared_ptr<SlotView> InventoryView::addSlot(const SlotLayout& layout) {
         vsize.y = pos.y + height;
     }
     setSize(vsize);
+}
+
+std::shared_ptr<SlotView> InventoryView::addSlot(const SlotLayout& layout) {
+    fitSlot(layout.position, layout.padding);
 
     auto slot = std::make_shared<SlotView>(layout);
     if (!layout.background) {
@@ -350,13 +372,87 @@ std::shared_ptr<SlotView> InventoryView::addSlot(const SlotLayout& layout) {
     return slot;
 }
 
+void InventoryView::addVirtualGrid(
+    const SlotLayout& layout, int cols, int count, glm::vec2 step
+) {
+    if (cols <= 0 || count <= 0) {
+        return;
+    }
+    int rows = ceildiv(count, cols);
+    glm::vec2 last = glm::vec2(cols - 1, rows - 1) * step;
+    fitSlot(layout.position + glm::max(last, glm::vec2()), layout.padding);
+    fitSlot(layout.position + glm::min(last, glm::vec2()), layout.padding);
+    grids.push_back(VirtualGrid {layout, cols, count, step, {}});
+}
+
+void InventoryView::updateGrid(VirtualGrid& grid) {
+    int rows = ceildiv(grid.count, grid.cols);
+    int first = 0;
+    int last = rows - 1;
+    if (Window::isScissorEnabled() && grid.step.y != 0.0f) {
+        const auto& area = Window::getScissorArea();
+        float top = calcPos().y + grid.layout.position.y;
+        float a = (area.y - top - SLOT_SIZE) / grid.step.y;
+        float b = (area.w - top) / grid.step.y;
+        if (a > b) {
+            std::swap(a, b);
+        }
+        first = std::max(first, static_cast<int>(glm::floor(a)));
+        last = std::min(last, static_cast<int>(glm::ceil(b)));
+    }
+    size_t used = 0;
+    for (int row = first; row <= last; row++) {
+        for (int col = 0; col < grid.cols; col++) {
+            int index = row * grid.cols + col;
+            if (index >= grid.count) {
+                break;
+            }
+            if (used == grid.views.size()) {
+                auto view = std::make_shared<SlotView>(grid.layout);
+                if (!grid.layout.background) {
+                    view->setColor(glm::vec4());
+                }
+                grid.views.push_back(view);
+                add(view);
+            }
+            auto& view = *grid.views[used++];
+            index += grid.layout.index;
+            view.setIndex(index);
+            view.setPos(
+                grid.layout.position + glm::vec2(col, row) * grid.step
+            );
+            view.setVisible(true);
+            if (inventory) {
+                view.bind(
+                    inventory->getId(), inventory->getSlot(index), content
+                );
+            }
+        }
+    }
+    for (; used < grid.views.size(); used++) {
+        grid.views[used]->setVisible(false);
+    }
+}
+
+void InventoryView::draw(const DrawContext& pctx, const Assets& assets) {
+    // uses scissor of the parent container as the visible area
+    for (auto& grid : grids) {
+        updateGrid(grid);
+    }
+    Container::draw(pctx, assets);
+}
+
 std::shared_ptr<Inventory> InventoryView::getInventory() const {
     return inventory;
 }
 
 
 size_t InventoryView::getSlotsCount() const {
-    return slots.size();
+    size_t count = slots.size();
+    for (const auto& grid : grids) {
+        count += grid.count;
+    }
+    return count;
 }
 
 void InventoryView::bind(
@@ -4,6 +4,7 @@
 #include "Container.hpp"
 #include "typedefs.hpp"
 #include "constants.hpp"
+#include "assets/assets_util.hpp"
 
 #include <vector>
 #include <functional>
@@ -13,6 +14,7 @@ class Assets;
 class DrawContext;
 class Content;
 class ItemStack;
+struct ItemDef;
 class ContentIndices;
 class LevelFrontend;
 class Inventory;
@@ -58,13 +60,23 @@ namespace gui {
 
         std::wstring tooltip;
         itemid_t prevItem = 0;
-
+        /// @brief Item icon and count text kept while the slot item and
+        /// count are unchanged instead of being resolved every frame
+        util::TextureRegion icon {};
+        bool iconOutdated = true;
+        itemcount_t prevCount = 0;
+        std::wstring countText;
+
+        util::TextureRegion resolveIcon(
+            const ItemDef& item, const Assets& assets
+        ) const;
         void performLeftClick(ItemStack& stack, ItemStack& grabbed);
         void performRightClick(ItemStack& stack, ItemStack& grabbed);
     public:
         SlotView(SlotLayout layout);
 
         virtual void draw(const DrawContext& pctx, const Assets& assets) override;
+        virtual bool isCacheable() const override {return false;}
 
         void setHighlighted(bool flag);
         bool isHighlighted() const;
@@ -82,20 +94,42 @@ namespace gui {
         ItemStack& getStack();
         const SlotLayout& getLayout() const;
 
+        /// @brief Change inventory slot index of the view.
+        /// Used to reuse slot views of a virtual grid, see
+        /// InventoryView::addVirtualGrid
+        void setIndex(int index);
+
         static inline std::string EXCHANGE_SLOT_NAME = "exchange-slot";
     };
 
     class InventoryView : public gui::Container {
+        /// @brief Slots grid having slot views for visible rows only
+        struct VirtualGrid {
+            /// @brief Layout of the first slot
+            SlotLayout layout;
+            int cols;
+            int count;
+            /// @brief Offset between neighbour columns and rows
+            glm::vec2 step;
+            /// @brief Reused slot views
+            std::vector<std::shared_ptr<SlotView>> views;
+        };
         const Content* content = nullptr;
         
         std::shared_ptr<Inventory> inventory;
 
         std::vector<SlotView*> slots;
+        std::vector<VirtualGrid> grids;
         glm::vec2 origin {};
+
+        void fitSlot(glm::vec2 pos, int padding);
+        void updateGrid(VirtualGrid& grid);
     public:
         InventoryView();
         virtual ~InventoryView();
 
+        virtual void draw(const DrawContext& pctx, const Assets& assets) override;
+
         virtual void setPos(glm::vec2 pos) override;
 
         void setOrigin(glm::vec2 origin);
@@ -112,6 +146,17 @@ namespace gui {
 
         std::shared_ptr<SlotView> addSlot(const SlotLayout& layout);
 
+        /// @brief Add slots grid creating slot views only for rows visible
+        /// in the current scissor area (scrolled container).
+        /// Views are reused when the view is scrolled
+        /// @param layout layout of the first slot of the grid
+        /// @param cols grid columns
+        /// @param count total number of grid slots
+        /// @param step offset between neighbour columns (x) and rows (y)
+        void addVirtualGrid(
+            const SlotLayout& layout, int cols, int count, glm::vec2 step
+        );
+
         std::shared_ptr<Inventory> getInventory() const;
 
         size_t getSlotsCount() const;
@@ -133,12 +178,15 @@ namespace gui {
         /// @param addpanel automatically create panel behind the grid
         /// with size including padding
         /// @param slotLayout slot settings (index and position are ignored)
+        /// @param virtualized create slot views for visible rows only,
+        /// see InventoryView::addVirtualGrid
         void addGrid(
             int cols, int count, 
             glm::vec2 pos, 
             glm::vec4 padding,
             bool addpanel,
-            const SlotLayout& slotLayout
+            const SlotLayout& slotLayout,
+            bool virtualized = false
         );
         
         void add(const SlotLayout& slotLayout);
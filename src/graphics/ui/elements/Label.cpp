@@ -6,6 +6,7 @@
 #include "graphics/core/Font.hpp"
 #include "assets/Assets.hpp"
 #include "util/stringutil.hpp"
+#include "window/Window.hpp"
 #include "../markdown.hpp"
 
 using namespace gui;
@@ -91,19 +92,30 @@ void Label::setText(std::wstring text) {
         return;
     }
     this->text = std::move(text);
+    utf8Text.clear();
     cache.update(this->text, multiline, textWrap);
+    invalidate();
 
     if (cache.font && autoresize) {
         setSize(calcSize());
     }
 }
 
+void Label::setText(std::string_view text) {
+    if (!utf8Text.empty() && text == utf8Text) {
+        return;
+    }
+    setText(util::str2wstr_utf8(std::string(text)));
+    utf8Text = text;
+}
+
 const std::wstring& Label::getText() const {
     return text;
 }
 
 void Label::setFontName(std::string name) {
     this->fontName = std::move(name);
+    invalidate();
 }
 
 const std::string& Label::getFontName() const {
@@ -112,6 +124,7 @@ const std::string& Label::getFontName() const {
 
 void Label::setVerticalAlign(Align align) {
     this->valign = align;
+    invalidate();
 }
 
 Align Label::getVerticalAlign() const {
@@ -124,6 +137,7 @@ float Label::getLineInterval() const {
 
 void Label::setLineInterval(float interval) {
     lineInterval = interval;
+    invalidate();
 }
 
 int Label::getTextYOffset() const {
@@ -202,7 +216,21 @@ void Label::draw(const DrawContext& pctx, const Assets& assets) {
     totalLineHeight = lineHeight;
 
     if (multiline) {
-        for (size_t i = 0; i < cache.lines.size(); i++) {
+        size_t first = 0;
+        size_t last = cache.lines.size();
+        // long texts (like code in a scrolled textbox) are clipped mostly
+        if (Window::isScissorEnabled() && totalLineHeight > 0) {
+            const auto& area = Window::getScissorArea();
+            float top = (area.y - pos.y) / totalLineHeight;
+            float bottom = (area.w - pos.y) / totalLineHeight;
+            first = static_cast<size_t>(glm::clamp(
+                glm::floor(top) - 1.0f, 0.0f, static_cast<float>(last)
+            ));
+            last = static_cast<size_t>(glm::clamp(
+                glm::ceil(bottom) + 1.0f, 0.0f, static_cast<float>(last)
+            ));
+        }
+        for (size_t i = first; i < last; i++) {
             auto& line = cache.lines[i];
             size_t offset = line.offset;
             std::wstring_view view(text.c_str()+offset, text.length()-offset);
@@ -218,10 +246,16 @@ void Label::draw(const DrawContext& pctx, const Assets& assets) {
 
 void Label::textSupplier(wstringsupplier supplier) {
     this->supplier = std::move(supplier);
+    invalidate();
+}
+
+bool Label::isCacheable() const {
+    return supplier == nullptr;
 }
 
 void Label::setAutoResize(bool flag) {
     this->autoresize = flag;
+    invalidate();
 }
 
 bool Label::isAutoResize() const {
@@ -232,6 +266,7 @@ void Label::setMultiline(bool multiline) {
     if (multiline != this->multiline) {
         this->multiline = multiline;
         cache.resetFlag = true;
+        invalidate();
     }
 }
 
@@ -242,6 +277,7 @@ bool Label::isMultiline() const {
 void Label::setTextWrapping(bool flag) {
     this->textWrap = flag;
     cache.resetFlag = true;
+    invalidate();
 }
 
 bool Label::isTextWrapping() const {
@@ -259,4 +295,5 @@ const std::string& Label::getMarkup() const {
 
 void Label::setStyles(std::unique_ptr<FontStylesScheme> styles) {
     this->styles = std::move(styles);
+    invalidate();
 }
@@ -28,6 +28,9 @@ namespace gui {
         glm::vec2 calcSize();
     protected:
         std::wstring text;
+        /// @brief UTF-8 text set last time, unchanged text is not converted
+        /// again. Empty if text is set otherwise
+        std::string utf8Text;
         std::string fontName;
         wstringsupplier supplier = nullptr;
         
@@ -64,6 +67,8 @@ namespace gui {
         virtual ~Label();
 
         virtual void setText(std::wstring text);
+        /// @brief Set UTF-8 text, skipped if equals to the last set one
+        void setText(std::string_view text);
         const std::wstring& getText() const;
 
         virtual void setFontName(std::string name);
@@ -107,6 +112,8 @@ namespace gui {
 
         virtual void textSupplier(wstringsupplier supplier);
 
+        virtual bool isCacheable() const override;
+
         virtual void setAutoResize(bool flag);
         virtual bool isAutoResize() const;
 
@@ -17,6 +17,7 @@ Panel::~Panel() {
 
 void Panel::setMaxLength(int value) {
     maxLength = value;
+    invalidate();
 }
 
 int Panel::getMaxLength() const {
@@ -98,6 +99,7 @@ void Panel::refresh() {
 
 void Panel::setOrientation(Orientation orientation) {
     this->orientation = orientation;
+    invalidate();
 }
 
 Orientation Panel::getOrientation() const {
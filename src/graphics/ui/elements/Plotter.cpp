@@ -10,7 +10,8 @@ using namespace gui;
 
 void Plotter::act(float delta) {
     index = index + 1 % dmwidth;
-    int value = static_cast<int>(delta * multiplier);
+    float plotted = valueSupplier ? valueSupplier() : delta;
+    int value = static_cast<int>(plotted * multiplier);
     points[index % dmwidth] = std::min(value, dmheight);
 }
 
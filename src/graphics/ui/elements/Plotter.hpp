@@ -1,6 +1,7 @@
 #pragma once
 
 #include "UINode.hpp"
+#include "delegates.hpp"
 #include "typedefs.hpp"
 
 #include <memory>
@@ -17,6 +18,7 @@ namespace gui {
         int dmwidth;
         int dmheight;
         int labelsInterval;
+        supplier<float> valueSupplier;
     public:
         Plotter(uint width, uint height, float multiplier, int labelsInterval) 
         : gui::UINode(glm::vec2(width, height)), 
@@ -28,7 +30,13 @@ namespace gui {
             points = std::make_unique<int[]>(dmwidth);
         }
 
+        /// @brief Plot supplied value instead of the frame delta
+        void setSupplier(supplier<float> supplier) {
+            valueSupplier = std::move(supplier);
+        }
+
         void act(float delta) override;
         void draw(const DrawContext& pctx, const Assets& assets) override;
+        bool isCacheable() const override {return false;}
     };
 }
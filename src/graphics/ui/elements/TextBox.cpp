@@ -48,6 +48,8 @@ TextBox::TextBox(std::wstring placeholder, glm::vec4 padding)
     scrollStep = 0;
 }
 
+TextBox::~TextBox() = default;
+
 void TextBox::draw(const DrawContext& pctx, const Assets& assets) {
     Container::draw(pctx, assets);
 
@@ -195,9 +197,14 @@ void TextBox::refreshLabel() {
 
     const auto& displayText = input.empty() && !hint.empty() ? hint : getText();
     if (markup == "md") {
-        auto [processedText, styles] = markdown::process(displayText, !focused);
-        label->setText(std::move(processedText));
-        label->setStyles(std::move(styles));
+        // called every frame, so processing only changed text
+        if (displayText != processedText || focused != processedFocused) {
+            auto [text, styles] = markdown::process(displayText, !focused);
+            label->setText(std::move(text));
+            label->setStyles(std::move(styles));
+            processedText = displayText;
+            processedFocused = focused;
+        }
     } else {
         label->setText(displayText);
         if (syntax.empty()) {
@@ -576,10 +583,8 @@ void TextBox::stepDefaultUp(bool shiftPressed, bool breakSelection) {
 }
 
 void TextBox::refreshSyntax() {
-    if (!syntax.empty()) {
-        if (auto styles = devtools::syntax_highlight(
-                syntax, util::wstr2str_utf8(input)
-            )) {
+    if (highlighter) {
+        if (auto styles = highlighter->update(util::wstr2str_utf8(input))) {
             label->setStyles(std::move(styles));
         }
     }
@@ -853,8 +858,10 @@ bool TextBox::isShowLineNumbers() const {
 void TextBox::setSyntax(std::string_view lang) {
     syntax = lang;
     if (syntax.empty()) {
+        highlighter.reset();
         label->setStyles(nullptr);
     } else {
+        highlighter = std::make_unique<devtools::SyntaxHighlighter>(syntax);
         refreshSyntax();
     }
 }
@@ -865,6 +872,7 @@ const std::string& TextBox::getSyntax() const {
 
 void TextBox::setMarkup(std::string_view lang) {
     markup = lang;
+    processedText.reset();
 }
 
 const std::string& TextBox::getMarkup() const {
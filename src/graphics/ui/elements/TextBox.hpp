@@ -3,8 +3,14 @@
 #include "Panel.hpp"
 #include "Label.hpp"
 
+#include <optional>
+
 class Font;
 
+namespace devtools {
+    class SyntaxHighlighter;
+}
+
 namespace gui {
     class Label;
     
@@ -58,6 +64,11 @@ namespace gui {
         bool showLineNumbers = false;
         std::string markup;
         std::string syntax;
+        /// @brief Keeps tokens of the input to re-highlight edited lines only
+        std::unique_ptr<devtools::SyntaxHighlighter> highlighter;
+        /// @brief Last text passed to markdown processing
+        std::optional<std::wstring> processedText;
+        bool processedFocused = false;
 
         void stepLeft(bool shiftPressed, bool breakSelection);
         void stepRight(bool shiftPressed, bool breakSelection);
@@ -93,6 +104,7 @@ namespace gui {
             std::wstring placeholder, 
             glm::vec4 padding=glm::vec4(4.0f)
         );
+        ~TextBox();
         
         void paste(const std::wstring& text);
             
@@ -218,6 +230,7 @@ namespace gui {
         virtual bool isFocuskeeper() const override {return true;}
         virtual void draw(const DrawContext& pctx, const Assets& assets) override;
         virtual void drawBackground(const DrawContext& pctx, const Assets& assets) override;
+        virtual bool isCacheable() const override {return false;}
         virtual void typed(unsigned int codepoint) override; 
         virtual void keyPressed(keycode key) override;
         virtual std::shared_ptr<UINode> getAt(
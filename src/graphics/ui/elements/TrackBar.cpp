@@ -44,6 +44,7 @@ void TrackBar::draw(const DrawContext& pctx, const Assets&) {
 
 void TrackBar::setSupplier(doublesupplier supplier) {
     this->supplier = std::move(supplier);
+    invalidate();
 }
 
 void TrackBar::setConsumer(doubleconsumer consumer) {
@@ -63,6 +64,7 @@ void TrackBar::mouseMove(GUI*, int x, int) {
     value = (value > max) ? max : value;
     value = (value < min) ? min : value;
     value = (int64_t)round(value / step) * step;
+    invalidate();
 
     if (consumer && !changeOnRelease) {
         consumer(value);
@@ -108,26 +110,32 @@ bool TrackBar::isChangeOnRelease() const {
 
 void TrackBar::setValue(double x) {
     value = x;
+    invalidate();
 }
 
 void TrackBar::setMin(double x) {
     min = x;
+    invalidate();
 }
 
 void TrackBar::setMax(double x) {
     max = x;
+    invalidate();
 }
 
 void TrackBar::setStep(double x) {
     step = x;
+    invalidate();
 }
 
 void TrackBar::setTrackWidth(int width) {
     trackWidth = width;
+    invalidate();
 }
 
 void TrackBar::setTrackColor(glm::vec4 color) {
     trackColor = color;
+    invalidate();
 }
 
 void TrackBar::setChangeOnRelease(bool flag) {
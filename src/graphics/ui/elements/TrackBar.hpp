@@ -22,6 +22,9 @@ namespace gui {
                  double step=1.0, 
                  int trackWidth=12);
         virtual void draw(const DrawContext& pctx, const Assets& assets) override;
+        virtual bool isCacheable() const override {
+            return supplier == nullptr;
+        }
 
         virtual void setSupplier(doublesupplier);
         virtual void setConsumer(doubleconsumer);
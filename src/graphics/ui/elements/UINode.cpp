@@ -22,11 +22,15 @@ bool UINode::isVisible() const {
 }
 
 void UINode::setVisible(bool flag) {
-    visible = flag;
+    if (visible != flag) {
+        visible = flag;
+        invalidate();
+    }
 }
 
 void UINode::setEnabled(bool flag) {
     enabled = flag;
+    invalidate();
     if (!flag) {
         defocus();
         hover = false;
@@ -46,10 +50,14 @@ Align UINode::getAlign() const {
 
 void UINode::setAlign(Align align) {
     this->align = align;
+    invalidate();
 }
 
 void UINode::setHover(bool flag) {
-    hover = flag;
+    if (hover != flag) {
+        hover = flag;
+        invalidate();
+    }
 }
 
 bool UINode::isHover() const {
@@ -57,7 +65,15 @@ bool UINode::isHover() const {
 }
 
 void UINode::setParent(UINode* node) {
+    invalidate();
     parent = node;
+    invalidate();
+}
+
+void UINode::invalidate() {
+    if (parent) {
+        parent->invalidate();
+    }
 }
 
 UINode* UINode::getParent() const {
@@ -76,10 +92,12 @@ UINode* UINode::listenDoubleClick(const onaction& action) {
 
 void UINode::click(GUI*, int, int) {
     pressed = true;
+    invalidate();
 }
 
 void UINode::doubleClick(GUI* gui, int x, int y) {
     pressed = true;
+    invalidate();
     if (isInside(glm::vec2(x, y))) {
         doubleClickCallbacks.notify(gui);
     }
@@ -87,6 +105,7 @@ void UINode::doubleClick(GUI* gui, int x, int y) {
 
 void UINode::mouseRelease(GUI* gui, int x, int y) {
     pressed = false;
+    invalidate();
     if (isInside(glm::vec2(x, y))) {
         actions.notify(gui);
     }
@@ -97,7 +116,10 @@ bool UINode::isPressed() const {
 }
 
 void UINode::defocus() {
-    focused = false;
+    if (focused) {
+        focused = false;
+        invalidate();
+    }
 }
 
 bool UINode::isFocused() const {
@@ -174,7 +196,10 @@ glm::vec4 UINode::calcColor() const {
 }
 
 void UINode::setPos(glm::vec2 pos) {
-    this->pos = pos;
+    if (this->pos != pos) {
+        this->pos = pos;
+        invalidate();
+    }
 }
 
 glm::vec2 UINode::getPos() const {
@@ -186,9 +211,13 @@ glm::vec2 UINode::getSize() const {
 }
 
 void UINode::setSize(glm::vec2 size) {
-    this->size = glm::vec2(
+    size = glm::vec2(
         glm::max(minSize.x, size.x), glm::max(minSize.y, size.y)
     );
+    if (this->size != size) {
+        this->size = size;
+        invalidate();
+    }
 }
 
 glm::vec2 UINode::getMinSize() const {
@@ -204,10 +233,12 @@ void UINode::setColor(glm::vec4 color) {
     this->color = color;
     this->hoverColor = color;
     this->pressedColor = color;
+    invalidate();
 }
 
 void UINode::setHoverColor(glm::vec4 newColor) {
     this->hoverColor = newColor;
+    invalidate();
 }
 
 glm::vec4 UINode::getHoverColor() const {
@@ -224,10 +255,12 @@ glm::vec4 UINode::getPressedColor() const {
 
 void UINode::setPressedColor(glm::vec4 color) {
     pressedColor = color;
+    invalidate();
 }
 
 void UINode::setMargin(glm::vec4 margin) {
     this->margin = margin;
+    invalidate();
 }
 
 glm::vec4 UINode::getMargin() const {
@@ -236,6 +269,7 @@ glm::vec4 UINode::getMargin() const {
 
 void UINode::setZIndex(int zindex) {
     this->zindex = zindex;
+    invalidate();
 }
 
 int UINode::getZIndex() const {
@@ -164,7 +164,10 @@ namespace gui {
         virtual UINode* listenAction(const onaction &action);
         virtual UINode* listenDoubleClick(const onaction &action);
 
-        virtual void onFocus(GUI*) {focused = true;}
+        virtual void onFocus(GUI*) {
+            focused = true;
+            invalidate();
+        }
         virtual void doubleClick(GUI*, int x, int y);
         virtual void click(GUI*, int x, int y);
         virtual void clicked(GUI*, mousecode button) {}
@@ -220,6 +223,18 @@ namespace gui {
         virtual void setMinSize(glm::vec2 size);
         /// @brief Called in containers when new element added
         virtual void refresh() {};
+
+        /// @brief Notify containers caching their draws that the element
+        /// appearance is changed
+        virtual void invalidate();
+
+        /// @brief Check if the element appearance depends on its
+        /// properties only, so it may be drawn from a cache until
+        /// invalidate() call. Elements pulling values from suppliers or
+        /// other external state are not cacheable
+        virtual bool isCacheable() const {
+            return true;
+        }
         virtual void fullRefresh() {
             if (parent) {
                 parent->fullRefresh();
@@ -18,6 +18,7 @@
 #include "util/stringutil.hpp"
 #include "window/Events.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <utility>
 
@@ -175,6 +176,9 @@ static void _readContainer(UiXmlReader& reader, const xml::xmlelement& element,
     if (element.has("scroll-step")) {
         container.setScrollStep(element.attr("scroll-step").asInt());
     }
+    if (element.has("cache")) {
+        container.setCached(element.attr("cache").asBool());
+    }
     for (auto& sub : element.getElements()) {
         if (sub->isText())
             continue;
@@ -574,6 +578,19 @@ static void readSlotsGrid(
     layout.taking = taking;
     layout.placing = placing;
 
+    if (element.attr("virtual", "false").asBool()) {
+        layout.index = startIndex;
+        layout.position += glm::vec2(
+            padding, padding + (rows - 1) * (slotSize + interval)
+        );
+        view->addVirtualGrid(
+            layout,
+            cols,
+            std::min(count, rows * cols),
+            glm::vec2(slotSize + interval, -(slotSize + interval))
+        );
+        return;
+    }
     int idx = 0;
     for (int row = 0; row < rows; row++) {
         for (int col = 0; col < cols; col++, idx++) {
@@ -618,19 +635,34 @@ static std::shared_ptr<UINode> readPageBox(UiXmlReader& reader, const xml::xmlel
     return menu;
 }
 
+/// @brief Built-in elements readers shared by all UiXmlReader instances,
+/// so creating a reader allocates nothing
+static const std::unordered_map<std::string, uinode_reader>& default_readers(
+) {
+    static const std::unordered_map<std::string, uinode_reader> readers {
+        {"image", readImage},
+        {"label", readLabel},
+        {"panel", readPanel},
+        {"button", readButton},
+        {"textbox", readTextBox},
+        {"pagebox", readPageBox},
+        {"checkbox", readCheckBox},
+        {"trackbar", readTrackBar},
+        {"container", readContainer},
+        {"bindbox", readInputBindBox},
+        {"inventory", readInventory},
+    };
+    return readers;
+}
+
+/// @brief Max number of parsed layouts sources kept by UiXmlReader::parse
+static constexpr size_t MAX_CACHED_LAYOUTS = 256;
+
+static std::unordered_map<std::string, std::shared_ptr<const xml::Document>>
+    parsed_layouts;
+
 UiXmlReader::UiXmlReader(const scriptenv& env) : env(env) {
     contextStack.emplace("");
-    add("image", readImage);
-    add("label", readLabel);
-    add("panel", readPanel);
-    add("button", readButton);
-    add("textbox", readTextBox);
-    add("pagebox", readPageBox);
-    add("checkbox", readCheckBox);
-    add("trackbar", readTrackBar);
-    add("container", readContainer);
-    add("bindbox", readInputBindBox);
-    add("inventory", readInventory);
 }
 
 void UiXmlReader::add(const std::string& tag, uinode_reader reader) {
@@ -638,7 +670,8 @@ void UiXmlReader::add(const std::string& tag, uinode_reader reader) {
 }
 
 bool UiXmlReader::hasReader(const std::string& tag) const {
-    return readers.find(tag) != readers.end();
+    return readers.find(tag) != readers.end() ||
+           default_readers().find(tag) != default_readers().end();
 }
 
 void UiXmlReader::addIgnore(const std::string& tag) {
@@ -658,8 +691,18 @@ std::shared_ptr<UINode> UiXmlReader::readUINode(const xml::xmlelement& element)
     }
 
     const std::string& tag = element.getTag();
+    const uinode_reader* reader = nullptr;
     auto found = readers.find(tag);
-    if (found == readers.end()) {
+    if (found != readers.end()) {
+        reader = &found->second;
+    } else {
+        const auto& defaults = default_readers();
+        auto def = defaults.find(tag);
+        if (def != defaults.end()) {
+            reader = &def->second;
+        }
+    }
+    if (reader == nullptr) {
         if (ignored.find(tag) != ignored.end()) {
             return nullptr;
         }
@@ -670,7 +713,7 @@ std::shared_ptr<UINode> UiXmlReader::readUINode(const xml::xmlelement& element)
     if (hascontext) {
         contextStack.push(element.attr("context").getText());
     }
-    auto node = found->second(*this, element);
+    auto node = (*reader)(*this, element);
     if (hascontext) {
         contextStack.pop();
     }
@@ -682,7 +725,7 @@ std::shared_ptr<UINode> UiXmlReader::readXML(
     const std::string& source
 ) {
     this->filename = filename;
-    auto document = xml::parse(filename, source);
+    auto document = parse(filename, source);
     return readUINode(*document->getRoot());
 }
 
@@ -694,6 +737,31 @@ std::shared_ptr<UINode> UiXmlReader::readXML(
     return readUINode(root);
 }
 
+std::shared_ptr<const xml::Document> UiXmlReader::parse(
+    const std::string& filename, const std::string& source
+) {
+    // file name is a part of the key as it is shown in errors
+    std::string key;
+    key.reserve(filename.length() + 1 + source.length());
+    key.append(filename).append(1, '\0').append(source);
+
+    auto found = parsed_layouts.find(key);
+    if (found != parsed_layouts.end()) {
+        return found->second;
+    }
+    std::shared_ptr<const xml::Document> document =
+        xml::parse(filename, source);
+    if (parsed_layouts.size() >= MAX_CACHED_LAYOUTS) {
+        parsed_layouts.clear();
+    }
+    parsed_layouts[std::move(key)] = document;
+    return document;
+}
+
+void UiXmlReader::clearCache() {
+    parsed_layouts.clear();
+}
+
 const std::string& UiXmlReader::getContext() const {
     return contextStack.top();
 }
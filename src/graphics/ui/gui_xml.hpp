@@ -51,6 +51,16 @@ namespace gui {
             const xml::xmlelement& root
         );
 
+        /// @brief Parse layout source. Documents are cached by the source
+        /// text, so frequently opened layouts and strings added with
+        /// container:add are parsed once (main thread only)
+        static std::shared_ptr<const xml::Document> parse(
+            const std::string& filename, const std::string& source
+        );
+
+        /// @brief Release cached parsed layouts
+        static void clearCache();
+
         const std::string& getContext() const;
         const scriptenv& getEnvironment() const;
         const std::string& getFilename() const;
@@ -1,5 +1,6 @@
 #include "Inventory.hpp"
 
+#include "coders/binary_json.hpp"
 #include "content/ContentReport.hpp"
 
 Inventory::Inventory(int64_t id, size_t size) : id(id), slots(size) {
@@ -93,6 +94,36 @@ dv::value Inventory::serialize() const {
     return map;
 }
 
+uint64_t Inventory::calculateHash() const {
+    // FNV-1a over id and slots
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    auto mix = [&hash](uint64_t value) {
+        hash = (hash ^ value) * 0x100000001B3ULL;
+    };
+    mix(static_cast<uint64_t>(id));
+    mix(slots.size());
+    for (const auto& slot : slots) {
+        mix(slot.getItemId());
+        mix(slot.getCount());
+    }
+    return hash;
+}
+
+const std::vector<ubyte>& Inventory::encode() {
+    uint64_t hash = calculateHash();
+    if (encoded.empty() || hash != encodedHash) {
+        encoded = json::to_binary(serialize(), true);
+        encodedHash = hash;
+    }
+    return encoded;
+}
+
+void Inventory::decode(const ubyte* data, size_t size) {
+    deserialize(json::from_binary(data, size));
+    encoded.assign(data, data + size);
+    encodedHash = calculateHash();
+}
+
 void Inventory::convert(const ContentReport* report) {
     for (auto& slot : slots) {
         itemid_t id = slot.getItemId();
@@ -13,6 +13,12 @@ class ContentIndices;
 class Inventory : public Serializable {
     int64_t id;
     std::vector<ItemStack> slots;
+    /// @brief Compressed binary JSON of the inventory, see encode()
+    std::vector<ubyte> encoded;
+    /// @brief Slots hash the encoded data matches
+    uint64_t encodedHash = 0;
+
+    uint64_t calculateHash() const;
 public:
     Inventory() = default;
 
@@ -41,6 +47,15 @@ public:
 
     dv::value serialize() const override;
 
+    /// @brief Get compressed binary JSON of the inventory.
+    /// Slots are modified via references, so changes are detected by
+    /// slots hash: unchanged inventory is not encoded again
+    const std::vector<ubyte>& encode();
+
+    /// @brief Deserialize compressed binary JSON keeping it as the
+    /// encoded data
+    void decode(const ubyte* data, size_t size);
+
     void convert(const ContentReport* report);
     static void convert(dv::value& data, const ContentReport* report);
 
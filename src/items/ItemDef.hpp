@@ -13,6 +13,14 @@ struct item_funcs_set {
     bool on_block_break_by : 1;
 };
 
+/// @brief Item events handles resolved on content load
+/// (see lua::create_event_handle)
+struct item_events_set {
+    int use = 0;
+    int useon = 0;
+    int blockbreakby = 0;
+};
+
 enum class ItemIconType {
     NONE,    // invisible (core:empty) must not be rendered
     SPRITE,  // textured quad: icon is `atlas_name:texture_name`
@@ -44,6 +52,7 @@ struct ItemDef {
         itemid_t id;
         blockid_t placingBlock;
         item_funcs_set funcsset {};
+        item_events_set events {};
         bool emissive = false;
     } rt {};
 
@@ -10,7 +10,7 @@
 #include "voxels/Block.hpp"
 
 LightSolver::LightSolver(const ContentIndices* contentIds, Chunks* chunks, int channel) 
-    : blockDefs(contentIds->blocks.getDefs()),
+    : indices(*contentIds),
       chunks(chunks), 
       channel(channel) {
 }
@@ -26,7 +26,7 @@ void LightSolver::add(int x, int y, int z, int emission) {
 
     addqueue.push(lightentry {x, y, z, ubyte(emission)});
 
-    chunk->flags.modified = true;
+    chunk->setLightsModified(y);
     chunk->lightmap.set(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel, emission);
 }
 
@@ -72,14 +72,15 @@ void LightSolver::solve(){
             if (chunk) {
                 int lx = x - chunk->x * CHUNK_W;
                 int lz = z - chunk->z * CHUNK_D;
-                chunk->flags.modified = true;
+                chunk->setLightsModified(y);
 
                 ubyte light = chunk->lightmap.get(lx,y,lz, channel);
                 if (light != 0 && light == entry.light-1){
                     voxel* vox = chunks->get(x, y, z);
                     if (vox && vox->id != 0) {
-                        const Block* block = blockDefs[vox->id];
-                        if (uint8_t emission = block->emission[channel]) {
+                        const auto& emissions =
+                            indices.blocksProps.emission[vox->id];
+                        if (uint8_t emission = emissions[channel]) {
                             addqueue.push(lightentry {x, y, z, emission});
                             chunk->lightmap.set(lx, y, lz, channel, emission);
                         }
@@ -109,12 +110,11 @@ void LightSolver::solve(){
             if (chunk) {
                 int lx = x - chunk->x * CHUNK_W;
                 int lz = z - chunk->z * CHUNK_D;
-                chunk->flags.modified = true;
+                chunk->setLightsModified(y);
 
                 ubyte light = chunk->lightmap.get(lx, y, lz, channel);
                 voxel& v = chunk->voxels[vox_index(lx, y, lz)];
-                const Block* block = blockDefs[v.id];
-                if (block->lightPassing && light+2 <= entry.light){
+                if (indices.lightPassing[v.id] && light+2 <= entry.light){
                     chunk->lightmap.set(
                         x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, 
                         channel, 
@@ -125,3 +125,147 @@ void LightSolver::solve(){
         }
     }
 }
+
+static inline constexpr int RGB_CHANNELS = 3;
+
+RGBLightSolver::RGBLightSolver(
+    const ContentIndices* contentIds, Chunks* chunks
+)
+    : indices(*contentIds), chunks(chunks) {
+}
+
+void RGBLightSolver::add(int x, int y, int z, int r, int g, int b) {
+    if (r <= 1 && g <= 1 && b <= 1)
+        return;
+    Chunk* chunk = chunks->getChunkByVoxel(x, y, z);
+    if (chunk == nullptr)
+        return;
+    int lx = x - chunk->x * CHUNK_W;
+    int lz = z - chunk->z * CHUNK_D;
+    light_t current = chunk->lightmap.get(lx, y, lz);
+    const int emissions[RGB_CHANNELS] {r, g, b};
+    light_t light = 0;
+    for (int c = 0; c < RGB_CHANNELS; c++) {
+        int emission = emissions[c];
+        if (emission <= 1 || emission < Lightmap::extract(current, c))
+            continue;
+        light |= emission << (c << 2);
+        chunk->lightmap.set(lx, y, lz, c, emission);
+    }
+    if (light == 0)
+        return;
+    addqueue.push(rgblightentry {x, y, z, light});
+    chunk->setLightsModified(y);
+}
+
+void RGBLightSolver::add(int x, int y, int z) {
+    assert (chunks != nullptr);
+    light_t light = chunks->getLight(x, y, z);
+    add(x, y, z,
+        Lightmap::extract(light, 0),
+        Lightmap::extract(light, 1),
+        Lightmap::extract(light, 2));
+}
+
+void RGBLightSolver::remove(int x, int y, int z) {
+    Chunk* chunk = chunks->getChunkByVoxel(x, y, z);
+    if (chunk == nullptr)
+        return;
+    int lx = x - chunk->x * CHUNK_W;
+    int lz = z - chunk->z * CHUNK_D;
+    light_t light = chunk->lightmap.get(lx, y, lz) & 0xFFF;
+    if (light == 0)
+        return;
+    remqueue.push(rgblightentry {x, y, z, light});
+    for (int c = 0; c < RGB_CHANNELS; c++) {
+        chunk->lightmap.set(lx, y, lz, c, 0);
+    }
+}
+
+void RGBLightSolver::solve() {
+    const int coords[] = {
+            0, 0, 1,
+            0, 0,-1,
+            0, 1, 0,
+            0,-1, 0,
+            1, 0, 0,
+           -1, 0, 0
+    };
+
+    while (!remqueue.empty()) {
+        const rgblightentry entry = remqueue.front();
+        remqueue.pop();
+
+        for (int i = 0; i < 6; i++) {
+            int imul3 = i*3;
+            int x = entry.x+coords[imul3];
+            int y = entry.y+coords[imul3+1];
+            int z = entry.z+coords[imul3+2];
+
+            Chunk* chunk = chunks->getChunkByVoxel(x, y, z);
+            if (chunk == nullptr)
+                continue;
+            int lx = x - chunk->x * CHUNK_W;
+            int lz = z - chunk->z * CHUNK_D;
+            chunk->setLightsModified(y);
+
+            light_t current = chunk->lightmap.get(lx, y, lz);
+            const voxel& vox = chunk->voxels[vox_index(lx, y, lz)];
+            const auto& emissions = indices.blocksProps.emission[vox.id];
+            light_t removed = 0;
+            light_t added = 0;
+            for (int c = 0; c < RGB_CHANNELS; c++) {
+                int entryLight = Lightmap::extract(entry.light, c);
+                if (entryLight == 0)
+                    continue;
+                int light = Lightmap::extract(current, c);
+                if (light != 0 && light == entryLight-1) {
+                    int emission = emissions[c];
+                    chunk->lightmap.set(lx, y, lz, c, emission);
+                    added |= emission << (c << 2);
+                    removed |= light << (c << 2);
+                } else if (light >= entryLight) {
+                    added |= light << (c << 2);
+                }
+            }
+            if (added)
+                addqueue.push(rgblightentry {x, y, z, added});
+            if (removed)
+                remqueue.push(rgblightentry {x, y, z, removed});
+        }
+    }
+
+    while (!addqueue.empty()) {
+        const rgblightentry entry = addqueue.front();
+        addqueue.pop();
+
+        for (int i = 0; i < 6; i++) {
+            int imul3 = i*3;
+            int x = entry.x+coords[imul3];
+            int y = entry.y+coords[imul3+1];
+            int z = entry.z+coords[imul3+2];
+
+            Chunk* chunk = chunks->getChunkByVoxel(x, y, z);
+            if (chunk == nullptr)
+                continue;
+            int lx = x - chunk->x * CHUNK_W;
+            int lz = z - chunk->z * CHUNK_D;
+            chunk->setLightsModified(y);
+
+            const voxel& vox = chunk->voxels[vox_index(lx, y, lz)];
+            if (!indices.lightPassing[vox.id])
+                continue;
+            light_t current = chunk->lightmap.get(lx, y, lz);
+            light_t next = 0;
+            for (int c = 0; c < RGB_CHANNELS; c++) {
+                int entryLight = Lightmap::extract(entry.light, c);
+                if (Lightmap::extract(current, c) + 2 <= entryLight) {
+                    chunk->lightmap.set(lx, y, lz, c, entryLight-1);
+                    next |= (entryLight-1) << (c << 2);
+                }
+            }
+            if (next)
+                addqueue.push(rgblightentry {x, y, z, next});
+        }
+    }
+}
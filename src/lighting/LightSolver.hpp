@@ -2,9 +2,10 @@
 
 #include <queue>
 
+#include "typedefs.hpp"
+
 class Chunks;
 class ContentIndices;
-class Block;
 
 struct lightentry {
     int x;
@@ -16,7 +17,7 @@ struct lightentry {
 class LightSolver {
     std::queue<lightentry> addqueue;
     std::queue<lightentry> remqueue;
-    const Block* const* blockDefs;
+    const ContentIndices& indices;
     Chunks* chunks;
     int channel;
 public:
@@ -27,3 +28,29 @@ public:
     void remove(int x, int y, int z);
     void solve();
 };
+
+/// @brief R, G and B light levels packed as in Lightmap (blue in bits 8-11)
+struct rgblightentry {
+    int x;
+    int y;
+    int z;
+    light_t light;
+};
+
+/// @brief Light solver carrying R, G and B channels through a single BFS.
+/// Chunk and voxel lookups are shared by channels, channels with zero
+/// light in a queue entry are skipped. The result is equal to separate
+/// LightSolvers of the channels
+class RGBLightSolver {
+    std::queue<rgblightentry> addqueue;
+    std::queue<rgblightentry> remqueue;
+    const ContentIndices& indices;
+    Chunks* chunks;
+public:
+    RGBLightSolver(const ContentIndices* contentIds, Chunks* chunks);
+
+    void add(int x, int y, int z);
+    void add(int x, int y, int z, int r, int g, int b);
+    void remove(int x, int y, int z);
+    void solve();
+};
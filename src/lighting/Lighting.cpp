@@ -1,7 +1,9 @@
 #include "Lighting.hpp"
 #include "LightSolver.hpp"
+#include "LocalLightSolver.hpp"
 #include "Lightmap.hpp"
 #include "content/Content.hpp"
+#include "debug/Metrics.hpp"
 #include "voxels/Chunks.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/voxel.hpp"
@@ -9,103 +11,72 @@
 #include "constants.hpp"
 #include "util/timeutil.hpp"
 
+#include <algorithm>
 #include <memory>
 
-Lighting::Lighting(const Content* content, Chunks* chunks) 
-  : content(content), chunks(chunks) {
-    auto indices = content->getIndices();
-    solverR = std::make_unique<LightSolver>(indices, chunks, 0);
-    solverG = std::make_unique<LightSolver>(indices, chunks, 1);
-    solverB = std::make_unique<LightSolver>(indices, chunks, 2);
-    solverS = std::make_unique<LightSolver>(indices, chunks, 3);
-}
-
-Lighting::~Lighting() = default;
-
-void Lighting::clear(){
-    const auto& chunks = this->chunks->getChunks();
-    for (size_t index = 0; index < chunks.size(); index++){
-        auto chunk = chunks[index];
-        if (chunk == nullptr)
-            continue;
-        Lightmap& lightmap = chunk->lightmap;
-        for (int i = 0; i < CHUNK_VOL; i++){
-            lightmap.map[i] = 0;
-        }
-    }
-}
-
-void Lighting::prebuildSkyLight(Chunk* chunk, const ContentIndices* indices){
-    const auto* blockDefs = indices->blocks.getDefs();
-
-    int highestPoint = 0;
-    for (int z = 0; z < CHUNK_D; z++){
-        for (int x = 0; x < CHUNK_W; x++){
-            for (int y = CHUNK_H-1; y >= 0; y--){
-                int index = (y * CHUNK_D + z) * CHUNK_W + x;
-                voxel& vox = chunk->voxels[index];
-                const Block* block = blockDefs[vox.id];
-                if (!block->skyLightPassing) {
-                    if (highestPoint < y)
-                        highestPoint = y;
-                    break;
-                }
-                chunk->lightmap.setS(x,y,z, 15);
-            }
-        }
-    }
-    if (highestPoint < CHUNK_H-1)
-        highestPoint++;
-    chunk->lightmap.highestPoint = highestPoint;
-}
-
-void Lighting::buildSkyLight(int cx, int cz){
-    const auto blockDefs = content->getIndices()->blocks.getDefs();
-
-    Chunk* chunk = chunks->getChunk(cx, cz);
+template <class Solver>
+static void build_sky_light(
+    const ContentIndices& indices, Chunk* chunk, Solver& solverS
+) {
+    const ubyte* lightPassing = indices.lightPassing.data();
+    const voxel* voxels = chunk->voxels.data();
+    int cx = chunk->x;
+    int cz = chunk->z;
     for (int z = 0; z < CHUNK_D; z++){
         for (int x = 0; x < CHUNK_W; x++){
             int gx = x + cx * CHUNK_W;
             int gz = z + cz * CHUNK_D;
             for (int y = chunk->lightmap.highestPoint; y >= 0; y--){
-                while (y > 0 && !blockDefs[chunk->voxels[vox_index(x, y, z)].id]->lightPassing) {
+                while (y > 0 && !lightPassing[voxels[vox_index(x, y, z)].id]) {
                     y--;
                 }
                 if (chunk->lightmap.getS(x, y, z) != 15) {
-                    solverS->add(gx,y+1,gz);
+                    solverS.add(gx,y+1,gz);
                     for (; y >= 0; y--){
-                        solverS->add(gx+1,y,gz);
-                        solverS->add(gx-1,y,gz);
-                        solverS->add(gx,y,gz+1);
-                        solverS->add(gx,y,gz-1);
+                        solverS.add(gx+1,y,gz);
+                        solverS.add(gx-1,y,gz);
+                        solverS.add(gx,y,gz+1);
+                        solverS.add(gx,y,gz-1);
                     }
                 }
             }
         }
     }
-    solverS->solve();
+    solverS.solve();
 }
 
-void Lighting::onChunkLoaded(int cx, int cz, bool expand){
-    LightSolver* solverR = this->solverR.get();
-    LightSolver* solverG = this->solverG.get();
-    LightSolver* solverB = this->solverB.get();
-    LightSolver* solverS = this->solverS.get();
-
-    auto blockDefs = content->getIndices()->blocks.getDefs();
-    auto chunk = chunks->getChunk(cx, cz);
-
+template <class SolverRGB, class SolverS>
+static void on_chunk_loaded(
+    const ContentIndices& indices,
+    Chunk* chunk,
+    bool expand,
+    SolverRGB& solverRGB,
+    SolverS& solverS
+) {
+    const auto& emissive = indices.blocksProps.emissive;
+    const auto& emissions = indices.blocksProps.emission;
+    int cx = chunk->x;
+    int cz = chunk->z;
     for (uint y = 0; y < CHUNK_H; y++){
+        uint section = y / CHUNK_SECTION_H;
+        if (y % CHUNK_SECTION_H == 0 && chunk->isUniformSection(section)) {
+            // uniform section has no light sources or is filled with them
+            const voxel& vox = chunk->voxels[section * CHUNK_SECTION_VOL];
+            if (!emissive[vox.id]) {
+                y += CHUNK_SECTION_H - 1;
+                continue;
+            }
+        }
         for (uint z = 0; z < CHUNK_D; z++){
             for (uint x = 0; x < CHUNK_W; x++){
                 const voxel& vox = chunk->voxels[(y * CHUNK_D + z) * CHUNK_W + x];
-                const Block* block = blockDefs[vox.id];
                 int gx = x + cx * CHUNK_W;
                 int gz = z + cz * CHUNK_D;
-                if (block->rt.emissive){
-                    solverR->add(gx,y,gz,block->emission[0]);
-                    solverG->add(gx,y,gz,block->emission[1]);
-                    solverB->add(gx,y,gz,block->emission[2]);
+                if (emissive[vox.id]){
+                    const auto& emission = emissions[vox.id];
+                    solverRGB.add(
+                        gx, y, gz, emission[0], emission[1], emission[2]
+                    );
                 }
             }
         }
@@ -119,10 +90,13 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand){
                     int gz = z + cz * CHUNK_D;
                     int rgbs = chunk->lightmap.get(x, y, z);
                     if (rgbs){
-                        solverR->add(gx,y,gz, Lightmap::extract(rgbs, 0));
-                        solverG->add(gx,y,gz, Lightmap::extract(rgbs, 1));
-                        solverB->add(gx,y,gz, Lightmap::extract(rgbs, 2));
-                        solverS->add(gx,y,gz, Lightmap::extract(rgbs, 3));
+                        solverRGB.add(
+                            gx, y, gz,
+                            Lightmap::extract(rgbs, 0),
+                            Lightmap::extract(rgbs, 1),
+                            Lightmap::extract(rgbs, 2)
+                        );
+                        solverS.add(gx,y,gz, Lightmap::extract(rgbs, 3));
                     }
                 }
             }
@@ -134,71 +108,335 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand){
                     int gz = z + cz * CHUNK_D;
                     int rgbs = chunk->lightmap.get(x, y, z);
                     if (rgbs){
-                        solverR->add(gx,y,gz, Lightmap::extract(rgbs, 0));
-                        solverG->add(gx,y,gz, Lightmap::extract(rgbs, 1));
-                        solverB->add(gx,y,gz, Lightmap::extract(rgbs, 2));
-                        solverS->add(gx,y,gz, Lightmap::extract(rgbs, 3));
+                        solverRGB.add(
+                            gx, y, gz,
+                            Lightmap::extract(rgbs, 0),
+                            Lightmap::extract(rgbs, 1),
+                            Lightmap::extract(rgbs, 2)
+                        );
+                        solverS.add(gx,y,gz, Lightmap::extract(rgbs, 3));
                     }
                 }
             }
         }
     }
-    solverR->solve();
-    solverG->solve();
-    solverB->solve();
-    solverS->solve();
+    solverRGB.solve();
+    solverS.solve();
+}
+
+/// @brief Local solvers of R, G and B channels with the RGBLightSolver
+/// interface
+struct LocalRGBLightSolver {
+    LocalLightSolver solverR;
+    LocalLightSolver solverG;
+    LocalLightSolver solverB;
+
+    LocalRGBLightSolver(const ContentIndices* indices)
+        : solverR(indices, 0), solverG(indices, 1), solverB(indices, 2) {
+    }
+
+    void setCenter(
+        int cx, int cz, const LocalLightSolver::ChunkGetter& getChunk
+    ) {
+        solverR.setCenter(cx, cz, getChunk);
+        solverG.setCenter(cx, cz, getChunk);
+        solverB.setCenter(cx, cz, getChunk);
+    }
+
+    void add(int x, int y, int z, int r, int g, int b) {
+        solverR.add(x, y, z, r);
+        solverG.add(x, y, z, g);
+        solverB.add(x, y, z, b);
+    }
+
+    void solve() {
+        solverR.solve();
+        solverG.solve();
+        solverB.solve();
+    }
+};
+
+/// @brief Chunk lights are built by solvers working in the chunk
+/// neighbourhood resolved once per job
+class LightingWorker : public util::Worker<ChunkLightsJob, Chunk*> {
+    const ContentIndices& indices;
+    Chunks* chunks;
+    LocalRGBLightSolver solverRGB;
+    LocalLightSolver solverS;
+public:
+    LightingWorker(const ContentIndices* indices, Chunks* chunks)
+        : indices(*indices),
+          chunks(chunks),
+          solverRGB(indices),
+          solverS(indices, 3) {
+    }
+
+    Chunk* operator()(const ChunkLightsJob& job) override {
+        int cx = job.chunk->x;
+        int cz = job.chunk->z;
+        auto getChunk = [this](int32_t x, int32_t z) {
+            return chunks->getChunk(x, z);
+        };
+        solverRGB.setCenter(cx, cz, getChunk);
+        solverS.setCenter(cx, cz, getChunk);
+        if (job.expand) {
+            build_sky_light(indices, job.chunk, solverS);
+        }
+        on_chunk_loaded(
+            indices,
+            job.chunk,
+            job.expand,
+            solverRGB,
+            solverS
+        );
+        return job.chunk;
+    }
+};
+
+Lighting::Lighting(const Content* content, Chunks* chunks) 
+  : content(content), chunks(chunks) {
+    auto indices = content->getIndices();
+    solverRGB = std::make_unique<RGBLightSolver>(indices, chunks);
+    solverS = std::make_unique<LightSolver>(indices, chunks, 3);
+    threadPool = std::make_unique<util::ThreadPool<ChunkLightsJob, Chunk*>>(
+        "lighting-pool",
+        [indices, chunks]() {
+            return std::make_shared<LightingWorker>(indices, chunks);
+        },
+        [](Chunk*& chunk) { chunk->flags.lighted = true; }
+    );
+}
+
+Lighting::~Lighting() = default;
+
+void Lighting::clear(){
+    const auto& chunks = this->chunks->getChunks();
+    for (size_t index = 0; index < chunks.size(); index++){
+        auto chunk = chunks[index];
+        if (chunk == nullptr)
+            continue;
+        chunk->lightmap.reset();
+    }
 }
 
-void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
-    const auto& block = content->getIndices()->blocks.require(id);
-    solverR->remove(x,y,z);
-    solverG->remove(x,y,z);
-    solverB->remove(x,y,z);
-
-    if (id == 0){
-        solverR->solve();
-        solverG->solve();
-        solverB->solve();
-        if (chunks->getLight(x,y+1,z, 3) == 0xF){
-            for (int i = y; i >= 0; i--){
-                voxel* vox = chunks->get(x,i,z);
-                if ((vox == nullptr || vox->id != 0) && block.skyLightPassing)
-                    break;
-                solverS->add(x,i,z, 0xF);
+void Lighting::prebuildSkyLight(Chunk* chunk, const ContentIndices* indices){
+    constexpr int SLICE_VOL = CHUNK_W * CHUNK_D;
+    const ubyte* passing = indices->skyLightPassing.data();
+    const voxel* voxels = chunk->voxels.data();
+    light_t* lights = chunk->lightmap.getLightsWriteable();
+
+    // 0xFF for columns open to the sky, filled top-down by whole slices
+    ubyte open[SLICE_VOL];
+    std::fill(std::begin(open), std::end(open), 0xFF);
+
+    int highestPoint = 0;
+    for (int y = CHUNK_H-1; y >= 0; y--){
+        const voxel* sliceVoxels = voxels + y * SLICE_VOL;
+        light_t* sliceLights = lights + y * SLICE_VOL;
+        ubyte blocked = 0;
+        ubyte opened = 0;
+        for (int i = 0; i < SLICE_VOL; i++) {
+            ubyte mask = open[i] & passing[sliceVoxels[i].id];
+            blocked |= open[i] & ~mask;
+            opened |= mask;
+            open[i] = mask;
+            // S channel is 4 high bits
+            sliceLights[i] |= static_cast<light_t>(mask & 0xF0) << 8;
+        }
+        if (blocked && highestPoint < y)
+            highestPoint = y;
+        if (!opened)
+            break;
+    }
+    if (highestPoint < CHUNK_H-1)
+        highestPoint++;
+    chunk->lightmap.highestPoint = highestPoint;
+}
+
+void Lighting::buildSkyLight(int cx, int cz){
+    build_sky_light(
+        *content->getIndices(), chunks->getChunk(cx, cz), *solverS
+    );
+}
+
+void Lighting::onChunkDataChanged(int cx, int cz) {
+    auto chunk = chunks->getChunk(cx, cz);
+    if (chunk == nullptr) {
+        return;
+    }
+    chunk->updateHeights();
+    buildSkyLight(cx, cz);
+    chunk->setModified();
+    chunk->setLightsModified();
+    onChunkLoaded(cx, cz, true);
+
+    static const glm::ivec2 sides[] {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    for (const auto& side : sides) {
+        if (auto neighbour = chunks->getChunk(cx + side.x, cz + side.y)) {
+            neighbour->setModified();
+            neighbour->setLightsModified();
+            onChunkLoaded(cx + side.x, cz + side.y, true);
+        }
+    }
+}
+
+void Lighting::onChunkLoaded(int cx, int cz, bool expand){
+    on_chunk_loaded(
+        *content->getIndices(),
+        chunks->getChunk(cx, cz),
+        expand,
+        *solverRGB,
+        *solverS
+    );
+}
+
+/// @brief Expand compact voxels and lights of the chunk and its neighbours
+/// reached by the lights solvers. Expansion replaces arrays, so it is done
+/// by the main thread before the chunk is passed to workers
+static void expand_neighbourhood(const Chunks& chunks, const Chunk& chunk) {
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            auto neighbour = chunks.getChunk(chunk.x + dx, chunk.z + dz);
+            if (neighbour == nullptr) {
+                continue;
+            }
+            if (neighbour->voxels.isCompact()) {
+                neighbour->voxels.data();
+            }
+            if (neighbour->lightmap.isCompact()) {
+                neighbour->lightmap.getLightsWriteable();
             }
         }
-        solverR->add(x,y+1,z); solverG->add(x,y+1,z); solverB->add(x,y+1,z); solverS->add(x,y+1,z);
-        solverR->add(x,y-1,z); solverG->add(x,y-1,z); solverB->add(x,y-1,z); solverS->add(x,y-1,z);
-        solverR->add(x+1,y,z); solverG->add(x+1,y,z); solverB->add(x+1,y,z); solverS->add(x+1,y,z);
-        solverR->add(x-1,y,z); solverG->add(x-1,y,z); solverB->add(x-1,y,z); solverS->add(x-1,y,z);
-        solverR->add(x,y,z+1); solverG->add(x,y,z+1); solverB->add(x,y,z+1); solverS->add(x,y,z+1);
-        solverR->add(x,y,z-1); solverG->add(x,y,z-1); solverB->add(x,y,z-1); solverS->add(x,y,z-1);
-        solverR->solve();
-        solverG->solve();
-        solverB->solve();
-        solverS->solve();
-    } else {
-        if (!block.skyLightPassing){
-            solverS->remove(x,y,z);
-            for (int i = y-1; i >= 0; i--){
-                solverS->remove(x,i,z);
-                if (i == 0 || chunks->get(x,i-1,z)->id != 0){
-                    break;
-                }
+    }
+}
+
+void Lighting::buildChunksLights(const std::vector<Chunk*>& batch) {
+    static auto& buildTime =
+        debug::Metrics::getInstance().histogram("lighting.chunks-build");
+    debug::MetricTimer timer(buildTime);
+    for (auto chunk : batch) {
+        expand_neighbourhood(*chunks, *chunk);
+    }
+    // chunks with equal (x mod 3, z mod 3) have non-intersecting
+    // neighbourhoods
+    std::vector<ChunkLightsJob> phases[9];
+    for (auto chunk : batch) {
+        int phase = (chunk->x % 3 + 3) % 3 * 3 + (chunk->z % 3 + 3) % 3;
+        phases[phase].push_back(
+            ChunkLightsJob {chunk, !chunk->flags.loadedLights}
+        );
+    }
+    for (const auto& jobs : phases) {
+        for (const auto& job : jobs) {
+            threadPool->enqueueJob(job);
+        }
+        threadPool->waitForJobs();
+    }
+}
+
+void Lighting::onBlocksSet(const std::vector<glm::ivec3>& positions) {
+    const auto& blocks = content->getIndices()->blocks;
+    for (const auto& pos : positions) {
+        const voxel* vox = chunks->get(pos.x, pos.y, pos.z);
+        if (vox == nullptr) {
+            continue;
+        }
+        solverRGB->remove(pos.x, pos.y, pos.z);
+        if (vox->id == 0 || blocks.require(vox->id).skyLightPassing) {
+            continue;
+        }
+        solverS->remove(pos.x, pos.y, pos.z);
+        for (int y = pos.y - 1; y >= 0; y--) {
+            solverS->remove(pos.x, y, pos.z);
+            const voxel* below = chunks->get(pos.x, y - 1, pos.z);
+            if (y == 0 || below == nullptr || below->id != 0) {
+                break;
             }
-            solverS->solve();
         }
-        solverR->solve();
-        solverG->solve();
-        solverB->solve();
+    }
+    solverRGB->solve();
+    solverS->solve();
 
-        if (block.emission[0] || block.emission[1] || block.emission[2]){
-            solverR->add(x,y,z,block.emission[0]);
-            solverG->add(x,y,z,block.emission[1]);
-            solverB->add(x,y,z,block.emission[2]);
-            solverR->solve();
-            solverG->solve();
-            solverB->solve();
+    // top to bottom to let sky light fall through opened columns
+    std::vector<glm::ivec3> sorted(positions);
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.y > b.y;
+    });
+    for (const auto& pos : sorted) {
+        int x = pos.x;
+        int y = pos.y;
+        int z = pos.z;
+        const voxel* vox = chunks->get(x, y, z);
+        if (vox == nullptr) {
+            continue;
+        }
+        const auto& block = blocks.require(vox->id);
+        if (vox->id == 0) {
+            if (chunks->getLight(x, y + 1, z, 3) == 0xF) {
+                // down to the first block of the column stopping sky light
+                for (int i = y; i >= 0; i--) {
+                    const voxel* column = chunks->get(x, i, z);
+                    if (column == nullptr ||
+                        !blocks.require(column->id).skyLightPassing) {
+                        break;
+                    }
+                    solverS->add(x, i, z, 0xF);
+                }
+            }
+            const glm::ivec3 neighbours[] {
+                {x, y + 1, z}, {x, y - 1, z},
+                {x + 1, y, z}, {x - 1, y, z},
+                {x, y, z + 1}, {x, y, z - 1},
+            };
+            for (const auto& n : neighbours) {
+                solverRGB->add(n.x, n.y, n.z);
+                solverS->add(n.x, n.y, n.z);
+            }
+        } else if (block.emission[0] || block.emission[1] ||
+                   block.emission[2]) {
+            solverRGB->add(
+                x, y, z,
+                block.emission[0],
+                block.emission[1],
+                block.emission[2]
+            );
         }
     }
+    solverRGB->solve();
+    solverS->solve();
+}
+
+void Lighting::queueBlockSet(const glm::ivec3& pos) {
+    pendingUpdates.push_back(pos);
+}
+
+void Lighting::queueBlocksSet(const std::vector<glm::ivec3>& positions) {
+    pendingUpdates.insert(
+        pendingUpdates.end(), positions.begin(), positions.end()
+    );
+}
+
+void Lighting::flushUpdates() {
+    if (pendingUpdates.empty()) {
+        return;
+    }
+    // the same block may be set many times during a tick
+    std::sort(
+        pendingUpdates.begin(),
+        pendingUpdates.end(),
+        [](const auto& a, const auto& b) {
+            if (a.y != b.y) return a.y < b.y;
+            if (a.z != b.z) return a.z < b.z;
+            return a.x < b.x;
+        }
+    );
+    pendingUpdates.erase(
+        std::unique(pendingUpdates.begin(), pendingUpdates.end()),
+        pendingUpdates.end()
+    );
+    static auto& updatesTime =
+        debug::Metrics::getInstance().histogram("lighting.updates");
+    debug::MetricTimer timer(updatesTime);
+    onBlocksSet(pendingUpdates);
+    pendingUpdates.clear();
 }
@@ -1,20 +1,34 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
 #include "typedefs.hpp"
+#include "util/ThreadPool.hpp"
 
 class Content;
 class ContentIndices;
 class Chunk;
 class Chunks;
 class LightSolver;
+class RGBLightSolver;
+
+/// @brief Chunk lights building job: sky light (if not loaded from cache)
+/// and propagation of chunk light sources
+struct ChunkLightsJob {
+    Chunk* chunk = nullptr;
+    bool expand = false;
+};
 
 class Lighting {
     const Content* const content;
     Chunks* chunks;
-    std::unique_ptr<LightSolver> solverR;
-    std::unique_ptr<LightSolver> solverG;
-    std::unique_ptr<LightSolver> solverB;
+    std::unique_ptr<RGBLightSolver> solverRGB;
     std::unique_ptr<LightSolver> solverS;
+    std::unique_ptr<util::ThreadPool<ChunkLightsJob, Chunk*>> threadPool;
+    /// @brief Positions of set blocks waiting for lights update
+    std::vector<glm::ivec3> pendingUpdates;
 public:
     Lighting(const Content* content, Chunks* chunks);
     ~Lighting();
@@ -22,7 +36,33 @@ public:
     void clear();
     void buildSkyLight(int cx, int cz);
     void onChunkLoaded(int cx, int cz, bool expand);
-    void onBlockSet(int x, int y, int z, blockid_t id);
+
+    /// @brief Rebuild lights and meshes of the chunk which voxels were
+    /// replaced directly (not by block setting) and of its neighbours
+    void onChunkDataChanged(int cx, int cz);
+
+    /// @brief Update lights after a batch of blocks were set.
+    /// Light removal and propagation are solved once for the whole batch
+    /// @param positions positions of the set blocks
+    void onBlocksSet(const std::vector<glm::ivec3>& positions);
+
+    /// @brief Defer lights update of a set block until flushUpdates().
+    /// Lights read before the flush are not updated yet
+    void queueBlockSet(const glm::ivec3& pos);
+
+    /// @brief Defer lights update of set blocks until flushUpdates()
+    void queueBlocksSet(const std::vector<glm::ivec3>& positions);
+
+    /// @brief Update lights of all queued block changes at once
+    /// (see onBlocksSet). Called every tick before chunks meshing
+    void flushUpdates();
+
+    /// @brief Build lights for a batch of loaded chunks on worker threads.
+    /// All chunks must have their neighbours loaded. Light spreads
+    /// less than a chunk size, so chunks which 3x3 neighbourhoods do not
+    /// intersect are processed at the same time. Blocks until done, then
+    /// marks chunks as lighted.
+    void buildChunksLights(const std::vector<Chunk*>& batch);
 
     static void prebuildSkyLight(Chunk* chunk, const ContentIndices* indices);
 };
@@ -3,20 +3,154 @@
 #include "util/data_io.hpp"
 
 #include <assert.h>
+#include <algorithm>
+#include <array>
+
+/// @brief Lights of uniform sections are kept as single values
+class PackedLights {
+    struct Section {
+        light_t value = 0;
+        /// @brief Section lights or nullptr if uniform
+        std::unique_ptr<light_t[]> lights;
+    };
+    std::array<Section, CHUNK_SECTIONS> sections;
+public:
+    PackedLights(const light_t* lights) {
+        for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+            const light_t* src = lights + s * CHUNK_SECTION_VOL;
+            auto& section = sections[s];
+            section.value = src[0];
+            if (std::all_of(src, src + CHUNK_SECTION_VOL, [src](light_t l) {
+                    return l == src[0];
+                })) {
+                continue;
+            }
+            section.lights = std::make_unique<light_t[]>(CHUNK_SECTION_VOL);
+            std::copy_n(src, CHUNK_SECTION_VOL, section.lights.get());
+        }
+    }
+
+    void unpack(light_t* dst) const {
+        for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+            const auto& section = sections[s];
+            light_t* dstSection = dst + s * CHUNK_SECTION_VOL;
+            if (section.lights) {
+                std::copy_n(
+                    section.lights.get(), CHUNK_SECTION_VOL, dstSection
+                );
+            } else {
+                std::fill_n(dstSection, CHUNK_SECTION_VOL, section.value);
+            }
+        }
+    }
+
+    light_t get(uint index) const {
+        const auto& section = sections[index / CHUNK_SECTION_VOL];
+        if (section.lights) {
+            return section.lights[index % CHUNK_SECTION_VOL];
+        }
+        return section.value;
+    }
+
+    size_t countUniform() const {
+        return std::count_if(
+            sections.begin(), sections.end(), [](const auto& section) {
+                return section.lights == nullptr;
+            }
+        );
+    }
+
+    size_t getMemoryUsage() const {
+        size_t size = sizeof(PackedLights);
+        for (const auto& section : sections) {
+            if (section.lights) {
+                size += CHUNK_SECTION_VOL * sizeof(light_t);
+            }
+        }
+        return size;
+    }
+};
+
+Lightmap::Lightmap() : expanded(new light_t[CHUNK_VOL] {}) {
+}
+
+Lightmap::~Lightmap() = default;
+
+light_t* Lightmap::expand() {
+    std::shared_ptr<light_t[]> lights(new light_t[CHUNK_VOL]);
+    packed->unpack(lights.get());
+
+    std::lock_guard lock(mutex);
+    expanded = std::move(lights);
+    packed = nullptr;
+    return expanded.get();
+}
+
+light_t Lightmap::getPacked(uint index) const {
+    return packed->get(index);
+}
+
+std::shared_ptr<const light_t[]> Lightmap::read() const {
+    std::shared_ptr<const PackedLights> source;
+    {
+        std::lock_guard lock(mutex);
+        if (expanded) {
+            return expanded;
+        }
+        source = packed;
+    }
+    std::shared_ptr<light_t[]> lights(new light_t[CHUNK_VOL]);
+    source->unpack(lights.get());
+    return lights;
+}
+
+bool Lightmap::compact() {
+    if (expanded == nullptr) {
+        return false;
+    }
+    auto lights = std::make_shared<const PackedLights>(expanded.get());
+    if (lights->countUniform() == 0) {
+        return false;
+    }
+    std::lock_guard lock(mutex);
+    packed = std::move(lights);
+    expanded = nullptr;
+    return true;
+}
+
+void Lightmap::reset() {
+    if (expanded) {
+        std::fill(expanded.get(), expanded.get() + CHUNK_VOL, 0);
+        return;
+    }
+    std::shared_ptr<light_t[]> lights(new light_t[CHUNK_VOL] {});
+
+    std::lock_guard lock(mutex);
+    expanded = std::move(lights);
+    packed = nullptr;
+}
+
+size_t Lightmap::getMemoryUsage() const {
+    std::lock_guard lock(mutex);
+    if (expanded) {
+        return CHUNK_VOL * sizeof(light_t);
+    }
+    return packed->getMemoryUsage();
+}
 
 void Lightmap::set(const Lightmap* lightmap) {
-    set(lightmap->map);
+    set(lightmap->read().get());
 }
 
 void Lightmap::set(const light_t* map) {
-    for (size_t i = 0; i < CHUNK_VOL; i++) {
-        this->map[i] = map[i];
-    }
+    std::copy_n(map, CHUNK_VOL, getLightsWriteable());
 }
 
 static_assert(sizeof(light_t) == 2, "replace dataio calls to new light_t");
 
 std::unique_ptr<ubyte[]> Lightmap::encode() const {
+    auto lights = read();
+    const light_t* map = lights.get();
     auto buffer = std::make_unique<ubyte[]>(LIGHTMAP_DATA_LEN);
     for (uint i = 0; i < CHUNK_VOL; i+=2) {
         buffer[i/2] = ((map[i] >> 12) & 0xF) | ((map[i+1] >> 8) & 0xF0);
@@ -4,76 +4,119 @@
 #include "typedefs.hpp"
 
 #include <memory>
+#include <mutex>
 
 inline constexpr int LIGHTMAP_DATA_LEN = CHUNK_VOL/2;
 
+class PackedLights;
+
 // Lichtkarte
+/// @brief Chunk lights. May be compacted keeping uniform sections as
+/// single values (see compact()). Compact lightmap is read without
+/// expansion, writing expands it back. Writing, compact() and reset()
+/// must be performed by the chunk owner (main) thread or while it waits
+/// for the lighting workers. Other threads use read()
 class Lightmap {
+    std::shared_ptr<light_t[]> expanded;
+    std::shared_ptr<const PackedLights> packed;
+    /// @brief Guards the pointers replacement from read() in other threads
+    mutable std::mutex mutex;
+
+    light_t* expand();
+    light_t getPacked(uint index) const;
 public:
-    light_t map[CHUNK_VOL] {};
     int highestPoint = 0;
 
+    Lightmap();
+    Lightmap(const Lightmap&) = delete;
+    ~Lightmap();
+
     void set(const Lightmap* lightmap);
 
     void set(const light_t* map);
 
+    inline light_t get(uint index) const {
+        return expanded ? expanded[index] : getPacked(index);
+    }
+
     inline unsigned short get(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x]);
+        return get(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x);
     }
 
     inline unsigned char get(int x, int y, int z, int channel) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> (channel << 2)) & 0xF;
+        return (get(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x) >> (channel << 2)) & 0xF;
     }
 
     inline unsigned char getR(int x, int y, int z) const {
-        return map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] & 0xF;
+        return get(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x) & 0xF;
     }
 
     inline unsigned char getG(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> 4) & 0xF;
+        return (get(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x) >> 4) & 0xF;
     }
 
     inline unsigned char getB(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> 8) & 0xF;
+        return (get(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x) >> 8) & 0xF;
     }
 
     inline unsigned char getS(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> 12) & 0xF;
+        return (get(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x) >> 12) & 0xF;
     }
 
     inline void setR(int x, int y, int z, int value){
+        light_t* map = getLightsWriteable();
         const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
         map[index] = (map[index] & 0xFFF0) | value;
     }
 
     inline void setG(int x, int y, int z, int value){
+        light_t* map = getLightsWriteable();
         const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
         map[index] = (map[index] & 0xFF0F) | (value << 4);
     }
 
     inline void setB(int x, int y, int z, int value){
+        light_t* map = getLightsWriteable();
         const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
         map[index] = (map[index] & 0xF0FF) | (value << 8);
     }
 
     inline void setS(int x, int y, int z, int value){
+        light_t* map = getLightsWriteable();
         const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
         map[index] = (map[index] & 0x0FFF) | (value << 12);
     }
 
     inline void set(int x, int y, int z, int channel, int value){
+        light_t* map = getLightsWriteable();
         const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
         map[index] = (map[index] & (0xFFFF & (~(0xF << (channel*4))))) | (value << (channel << 2));
     }
 
-    inline const light_t* getLights() const {
-        return map;
+    /// @brief Get lights array expanding compact lightmap
+    inline light_t* getLightsWriteable() {
+        return expanded ? expanded.get() : expand();
     }
 
-    inline light_t* getLightsWriteable() {
-        return map;
+    /// @brief Get lights without expanding. Thread-safe
+    /// @return lights array or its unpacked copy if compacted
+    std::shared_ptr<const light_t[]> read() const;
+
+    /// @brief Pack lightmap keeping uniform sections as single values.
+    /// Pointers to lights get invalid
+    /// @return false if compacted already or has no uniform sections
+    bool compact();
+
+    bool isCompact() const {
+        return expanded == nullptr;
     }
 
+    /// @brief Fill lights with zeros keeping the array if expanded
+    void reset();
+
+    /// @brief Get approximate heap memory used by lights in bytes
+    size_t getMemoryUsage() const;
+
     static constexpr light_t combine(int r, int g, int b, int s) {
         return r | (g << 4) | (b << 8) | (s << 12);
     }
@@ -0,0 +1,141 @@
+#include "LocalLightSolver.hpp"
+
+#include "Lightmap.hpp"
+#include "content/Content.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/voxel.hpp"
+#include "voxels/Block.hpp"
+
+/// @brief Initial queue capacity, must be a power of two
+static inline constexpr size_t QUEUE_CAPACITY = 4096;
+
+LocalLightSolver::LocalLightSolver(
+    const ContentIndices* contentIds, int channel
+)
+    : lightPassing(contentIds->lightPassing.data()),
+      channel(channel),
+      queue(QUEUE_CAPACITY) {
+}
+
+void LocalLightSolver::setCenter(
+    int cx, int cz, const ChunkGetter& getChunk
+) {
+    originX = (cx - 1) * CHUNK_W;
+    originZ = (cz - 1) * CHUNK_D;
+    for (int z = 0; z < 3; z++) {
+        for (int x = 0; x < 3; x++) {
+            auto& neighbour = neighbours[z * 3 + x];
+            neighbour.chunk = getChunk(cx + x - 1, cz + z - 1);
+            if (neighbour.chunk) {
+                neighbour.voxels = neighbour.chunk->voxels.data();
+                neighbour.lightmap = &neighbour.chunk->lightmap;
+            } else {
+                neighbour.voxels = nullptr;
+                neighbour.lightmap = nullptr;
+            }
+        }
+    }
+}
+
+void LocalLightSolver::grow() {
+    std::vector<uint32_t> extended(queue.size() * 2);
+    size_t mask = queue.size() - 1;
+    for (size_t i = 0; i < count; i++) {
+        extended[i] = queue[(head + i) & mask];
+    }
+    queue = std::move(extended);
+    head = 0;
+}
+
+inline void LocalLightSolver::push(uint32_t entry) {
+    if (count == queue.size()) {
+        grow();
+    }
+    queue[(head + count) & (queue.size() - 1)] = entry;
+    count++;
+}
+
+void LocalLightSolver::add(int x, int y, int z, int emission) {
+    if (emission <= 1 || y < 0 || y >= CHUNK_H) {
+        return;
+    }
+    int lx = x - originX;
+    int lz = z - originZ;
+    if (lx < 0 || lx >= LOCAL_W || lz < 0 || lz >= LOCAL_D) {
+        return;
+    }
+    auto& neighbour = neighbours[lz / CHUNK_D * 3 + lx / CHUNK_W];
+    if (neighbour.chunk == nullptr) {
+        return;
+    }
+    int cx = lx % CHUNK_W;
+    int cz = lz % CHUNK_D;
+    if (emission < neighbour.lightmap->get(cx, y, cz, channel)) {
+        return;
+    }
+    push(pack(lx, y, lz, emission));
+
+    neighbour.chunk->setLightsModified(y);
+    neighbour.lightmap->set(cx, y, cz, channel, emission);
+}
+
+void LocalLightSolver::add(int x, int y, int z) {
+    if (y < 0 || y >= CHUNK_H) {
+        return;
+    }
+    int lx = x - originX;
+    int lz = z - originZ;
+    if (lx < 0 || lx >= LOCAL_W || lz < 0 || lz >= LOCAL_D) {
+        return;
+    }
+    const auto& neighbour = neighbours[lz / CHUNK_D * 3 + lx / CHUNK_W];
+    if (neighbour.chunk == nullptr) {
+        return;
+    }
+    add(x, y, z,
+        neighbour.lightmap->get(lx % CHUNK_W, y, lz % CHUNK_D, channel));
+}
+
+void LocalLightSolver::solve() {
+    size_t mask = queue.size() - 1;
+    while (count) {
+        uint32_t entry = queue[head];
+        head = (head + 1) & mask;
+        count--;
+
+        int light = entry >> LIGHT_SHIFT;
+        int ex = entry & ((1 << X_BITS) - 1);
+        int ez = (entry >> Z_SHIFT) & ((1 << Z_BITS) - 1);
+        int ey = (entry >> Y_SHIFT) & ((1 << Y_BITS) - 1);
+
+        for (int i = 0; i < 6; i++) {
+            int lx = ex;
+            int y = ey;
+            int lz = ez;
+            switch (i) {
+                case 0: if (++lz >= LOCAL_D) continue; break;
+                case 1: if (--lz < 0) continue; break;
+                case 2: if (++y >= CHUNK_H) continue; break;
+                case 3: if (--y < 0) continue; break;
+                case 4: if (++lx >= LOCAL_W) continue; break;
+                case 5: if (--lx < 0) continue; break;
+            }
+            auto& neighbour = neighbours[lz / CHUNK_D * 3 + lx / CHUNK_W];
+            if (neighbour.chunk == nullptr) {
+                continue;
+            }
+            int cx = lx % CHUNK_W;
+            int cz = lz % CHUNK_D;
+            neighbour.chunk->setLightsModified(y);
+
+            int current = neighbour.lightmap->get(cx, y, cz, channel);
+            const voxel& vox = neighbour.voxels[vox_index(cx, y, cz)];
+            if (lightPassing[vox.id] && current + 2 <= light) {
+                neighbour.lightmap->set(cx, y, cz, channel, light - 1);
+                push(pack(lx, y, lz, light - 1));
+                mask = queue.size() - 1;
+            }
+        }
+    }
+    head = 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <vector>
+
+#include "constants.hpp"
+#include "typedefs.hpp"
+
+class Chunk;
+class ContentIndices;
+class Lightmap;
+struct voxel;
+
+/// @brief Light solver working in a 3x3 chunks neighbourhood.
+/// Chunks voxels and lightmaps are resolved once per center chunk, queue
+/// entries are packed into 32 bits (local position and light level) and
+/// stored in a ring buffer reused between solves.
+/// Light spreading out of the neighbourhood is dropped, so the solver is
+/// suitable for center chunk light sources and border lights only
+/// (light spreads less than a chunk size)
+class LocalLightSolver {
+public:
+    using ChunkGetter = std::function<Chunk*(int32_t, int32_t)>;
+private:
+    static inline constexpr int LOCAL_W = CHUNK_W * 3;
+    static inline constexpr int LOCAL_D = CHUNK_D * 3;
+
+    /// @brief Bits used for each local coordinate in packed entry
+    static inline constexpr int X_BITS = 6;
+    static inline constexpr int Z_BITS = 6;
+    static inline constexpr int Y_BITS = CHUNK_H <= 256 ? 8 : 9;
+    static inline constexpr int Z_SHIFT = X_BITS;
+    static inline constexpr int Y_SHIFT = X_BITS + Z_BITS;
+    static inline constexpr int LIGHT_SHIFT = X_BITS + Z_BITS + Y_BITS;
+    static inline constexpr uint32_t POSITION_MASK = (1U << LIGHT_SHIFT) - 1;
+
+    static_assert(LOCAL_W <= (1 << X_BITS) && LOCAL_D <= (1 << Z_BITS));
+    static_assert(CHUNK_H <= (1 << Y_BITS));
+
+    struct Neighbour {
+        Chunk* chunk = nullptr;
+        const voxel* voxels = nullptr;
+        Lightmap* lightmap = nullptr;
+    };
+
+    const ubyte* lightPassing;
+    int channel;
+    std::array<Neighbour, 9> neighbours {};
+    /// @brief Global position of the neighbourhood corner block
+    int originX = 0;
+    int originZ = 0;
+
+    std::vector<uint32_t> queue;
+    size_t head = 0;
+    size_t count = 0;
+
+    void push(uint32_t entry);
+    void grow();
+
+    static constexpr uint32_t pack(int lx, int y, int lz, int light) {
+        return lx | (lz << Z_SHIFT) | (y << Y_SHIFT) | (light << LIGHT_SHIFT);
+    }
+public:
+    LocalLightSolver(const ContentIndices* contentIds, int channel);
+
+    /// @brief Resolve the center chunk and its neighbours
+    /// @param getChunk provides loaded chunk or nullptr
+    void setCenter(int cx, int cz, const ChunkGetter& getChunk);
+
+    /// @brief Add light source with the current light level
+    /// @param x, y, z global block position
+    void add(int x, int y, int z);
+
+    /// @brief Add light source
+    /// @param x, y, z global block position
+    void add(int x, int y, int z, int emission);
+
+    void solve();
+};
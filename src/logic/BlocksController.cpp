@@ -1,6 +1,13 @@
 #include "BlocksController.hpp"
 
+#include <algorithm>
+#include <unordered_set>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
 #include "content/Content.hpp"
+#include "debug/Profiler.hpp"
 #include "items/Inventories.hpp"
 #include "items/Inventory.hpp"
 #include "lighting/Lighting.hpp"
@@ -12,16 +19,30 @@
 #include "voxels/Chunks.hpp"
 #include "voxels/voxel.hpp"
 #include "world/Level.hpp"
+#include "world/LevelEvents.hpp"
 #include "world/World.hpp"
 
-BlocksController::BlocksController(const Level& level, uint padding)
+/// @brief Random positions sampled in each chunk segment per random tick
+static constexpr uint RANDOM_TICK_SAMPLES = 4;
+/// @brief Scheduled block updates timer wheel size (ticks)
+static constexpr size_t SCHEDULED_UPDATES_WHEEL_SIZE = 256;
+
+BlocksController::BlocksController(Level& level, uint padding)
     : level(level),
+      worldInfo(level.getWorld()->getInfo()),
       chunks(*level.chunks),
       lighting(*level.lighting),
       randTickClock(20, 3),
       blocksTickClock(20, 1),
       worldTickClock(20, 1),
-      padding(padding) {
+      padding(padding),
+      scheduledUpdates(
+          SCHEDULED_UPDATES_WHEEL_SIZE, worldInfo.blocksTick + 1
+      ) {
+    level.events->listen(
+        EVT_CHUNK_SHOWN,
+        [this](lvl_event_type, Chunk* chunk) { onChunkShown(*chunk); }
+    );
 }
 
 void BlocksController::updateSides(int x, int y, int z) {
@@ -56,6 +77,39 @@ void BlocksController::updateSides(int x, int y, int z, int w, int h, int d) {
     }
 }
 
+void BlocksController::setBlocks(
+    const std::vector<BlockEdit>& edits, bool noupdate
+) {
+    const auto& indices = *level.content->getIndices();
+    std::vector<glm::ivec3> positions;
+    positions.reserve(edits.size());
+    for (const auto& edit : edits) {
+        const auto& pos = edit.pos;
+        if (edit.id >= indices.blocks.count() ||
+            chunks.get(pos.x, pos.y, pos.z) == nullptr) {
+            continue;
+        }
+        chunks.set(pos.x, pos.y, pos.z, edit.id, edit.state);
+        positions.push_back(pos);
+    }
+    lighting.queueBlocksSet(positions);
+    if (noupdate) {
+        return;
+    }
+    static const glm::ivec3 sides[] {
+        {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+    };
+    std::unordered_set<glm::ivec3> updated;
+    for (const auto& pos : positions) {
+        for (const auto& side : sides) {
+            auto neighbour = pos + side;
+            if (updated.insert(neighbour).second) {
+                updateBlock(neighbour.x, neighbour.y, neighbour.z);
+            }
+        }
+    }
+}
+
 void BlocksController::breakBlock(
     Player* player, const Block& def, int x, int y, int z
 ) {
@@ -63,7 +117,7 @@ void BlocksController::breakBlock(
         player, glm::ivec3(x, y, z), def, BlockInteraction::destruction
     );
     chunks.set(x, y, z, 0, {});
-    lighting.onBlockSet(x, y, z, 0);
+    lighting.queueBlockSet({x, y, z});
     scripting::on_block_broken(player, def, glm::ivec3(x, y, z));
     if (def.rt.extended) {
         updateSides(x, y, z , def.size.x, def.size.y, def.size.z);
@@ -86,7 +140,7 @@ void BlocksController::placeBlock(
         player, glm::ivec3(x, y, z), def, BlockInteraction::placing
     );
     chunks.set(x, y, z, def.rt.id, state);
-    lighting.onBlockSet(x, y, z, def.rt.id);
+    lighting.queueBlockSet({x, y, z});
     scripting::on_block_placed(player, def, glm::ivec3(x, y, z));
     if (def.rt.extended) {
         updateSides(x, y, z , def.size.x, def.size.y, def.size.z);
@@ -112,6 +166,7 @@ void BlocksController::updateBlock(int x, int y, int z) {
 }
 
 void BlocksController::update(float delta) {
+    debug::ProfileZone zone("blocks-update");
     if (randTickClock.update(delta)) {
         randomTick(randTickClock.getPart(), randTickClock.getParts());
     }
@@ -120,42 +175,173 @@ void BlocksController::update(float delta) {
     }
     if (worldTickClock.update(delta)) {
         scripting::on_world_tick();
+        runScheduledUpdates();
     }
 }
 
+bool BlocksController::scheduleUpdate(int x, int y, int z, uint delay) {
+    Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+    if (chunk == nullptr) {
+        return false;
+    }
+    int lx = x - chunk->x * CHUNK_W;
+    int lz = z - chunk->z * CHUNK_D;
+    uint index = vox_index(lx, y, lz);
+    uint64_t tick = worldInfo.blocksTick + std::max(delay, 1U);
+    auto& updates = chunk->scheduledUpdates;
+    for (const auto& update : updates) {
+        if (update.index == index && update.tick == tick) {
+            return true;
+        }
+    }
+    updates.push_back({index, tick});
+    chunk->flags.scheduledUpdates = true;
+    chunk->flags.unsaved = true;
+    scheduledUpdates.schedule(tick, {x, y, z});
+    return true;
+}
+
+void BlocksController::onChunkShown(Chunk& chunk) {
+    for (const auto& update : chunk.scheduledUpdates) {
+        uint lx = update.index % CHUNK_W;
+        uint lz = update.index / CHUNK_W % CHUNK_D;
+        int y = update.index / (CHUNK_W * CHUNK_D);
+        // overdue updates of loaded chunks are run with the next tick
+        scheduledUpdates.schedule(
+            update.tick,
+            {chunk.x * CHUNK_W + lx, y, chunk.z * CHUNK_D + lz}
+        );
+    }
+}
+
+void BlocksController::runScheduledUpdates() {
+    uint64_t now = ++worldInfo.blocksTick;
+    scheduledUpdates.advance(now, [this](uint64_t tick, glm::ivec3 pos) {
+        Chunk* chunk = chunks.getChunkByVoxel(pos.x, pos.y, pos.z);
+        if (chunk == nullptr) {
+            return;
+        }
+        uint index = vox_index(
+            pos.x - chunk->x * CHUNK_W, pos.y, pos.z - chunk->z * CHUNK_D
+        );
+        auto& updates = chunk->scheduledUpdates;
+        auto found = std::find_if(
+            updates.begin(), updates.end(), [=](const auto& update) {
+                return update.index == index && update.tick <= tick;
+            }
+        );
+        if (found == updates.end()) {
+            return;
+        }
+        *found = updates.back();
+        updates.pop_back();
+        chunk->flags.scheduledUpdates = true;
+        chunk->flags.unsaved = true;
+        updateBlock(pos.x, pos.y, pos.z);
+    });
+}
+
 void BlocksController::onBlocksTick(int tickid, int parts) {
-    const auto& indices = level.content->getIndices()->blocks;
+    const auto* indices = level.content->getIndices();
     int tickRate = blocksTickClock.getTickRate();
-    for (size_t id = 0; id < indices.count(); id++) {
+    for (blockid_t id : indices->tickedBlocks) {
         if ((id + tickid) % parts != 0) continue;
-        auto& def = indices.require(id);
+        auto& def = indices->blocks.require(id);
         auto interval = def.tickInterval;
-        if (def.rt.funcsset.onblockstick && tickid / parts % interval == 0) {
+        if (tickid / parts % interval == 0) {
             scripting::on_blocks_tick(def, tickRate / interval);
         }
     }
 }
 
 void BlocksController::randomTick(
-    const Chunk& chunk, int segments, const ContentIndices* indices
+    const ContentIndices* indices, blockid_t id, const glm::ivec3& pos
+) {
+    auto& block = indices->blocks.require(id);
+    if (block.rt.funcsset.randupdatebatch) {
+        auto& batch = randomBatches[id];
+        if (batch.empty()) {
+            batchedBlocks.push_back(id);
+        }
+        batch.push_back(pos);
+    } else if (block.rt.funcsset.randupdate) {
+        scripting::random_update_block(block, pos);
+    }
+}
+
+void BlocksController::randomTick(
+    Chunk& chunk, int segments, const ContentIndices* indices
 ) {
     const int segheight = CHUNK_H / segments;
 
+    const auto& randomUpdate = indices->blocksProps.randomUpdate;
+    chunks.indexRandomTickables(chunk);
+    if (chunk.randomTickablesCount == 0) {
+        return;
+    }
+    if (chunk.randomTickablesSparse) {
+        // every block is ticked with the probability of being sampled.
+        // Positions are copied as handlers may change the chunk blocks
+        uint volume = CHUNK_W * segheight * CHUNK_D;
+        uint picked[CHUNK_MAX_SPARSE_TICKABLES];
+        uint count = 0;
+        for (uint index : chunk.randomTickables) {
+            uint sample = (static_cast<uint>(random.rand()) << 15) |
+                          static_cast<uint>(random.rand());
+            if (sample % volume < RANDOM_TICK_SAMPLES) {
+                picked[count++] = index;
+            }
+        }
+        for (uint i = 0; i < count; i++) {
+            uint index = picked[i];
+            const voxel vox = chunk.voxels.get(index);
+            if (!randomUpdate[vox.id]) {
+                continue;
+            }
+            int lx = index % CHUNK_W;
+            int lz = index / CHUNK_W % CHUNK_D;
+            int y = index / (CHUNK_W * CHUNK_D);
+            randomTick(
+                indices,
+                vox.id,
+                {chunk.x * CHUNK_W + lx, y, chunk.z * CHUNK_D + lz}
+            );
+        }
+        return;
+    }
+
+    // uniform sections of blocks having no random update are skipped
+    uint32_t inertSections = 0;
+    for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        if (!chunk.isUniformSection(s)) {
+            continue;
+        }
+        auto id = chunk.voxels.get(s * CHUNK_SECTION_VOL).id;
+        if (!randomUpdate[id]) {
+            inertSections |= 1U << s;
+        }
+    }
+    if (inertSections == (1ULL << CHUNK_SECTIONS) - 1) {
+        return;
+    }
     for (int s = 0; s < segments; s++) {
-        for (int i = 0; i < 4; i++) {
+        for (uint i = 0; i < RANDOM_TICK_SAMPLES; i++) {
             int bx = random.rand() % CHUNK_W;
             int by = random.rand() % segheight + s * segheight;
             int bz = random.rand() % CHUNK_D;
-            const voxel& vox = chunk.voxels[vox_index(bx, by, bz)];
-            auto& block = indices->blocks.require(vox.id);
-            if (block.rt.funcsset.randupdate) {
-                scripting::random_update_block(
-                    block,
-                    glm::ivec3(
-                        chunk.x * CHUNK_W + bx, by, chunk.z * CHUNK_D + bz
-                    )
-                );
+            if (inertSections & (1U << (by / CHUNK_SECTION_H))) {
+                continue;
             }
+            // compacted chunks are not expanded by sampling
+            const voxel vox = chunk.voxels.get(vox_index(bx, by, bz));
+            if (!randomUpdate[vox.id]) {
+                continue;
+            }
+            randomTick(
+                indices,
+                vox.id,
+                {chunk.x * CHUNK_W + bx, by, chunk.z * CHUNK_D + bz}
+            );
         }
     }
 }
@@ -165,6 +351,7 @@ void BlocksController::randomTick(int tickid, int parts) {
     int width = chunks.getWidth();
     int height = chunks.getHeight();
     int segments = 4;
+    randomBatches.resize(indices->blocks.count());
 
     for (uint z = padding; z < height - padding; z++) {
         for (uint x = padding; x < width - padding; x++) {
@@ -172,13 +359,20 @@ void BlocksController::randomTick(int tickid, int parts) {
             if ((index + tickid) % parts != 0) {
                 continue;
             }
-            auto& chunk = chunks.getChunks()[index];
+            auto& chunk = chunks.getChunks()[chunks.getIndex(x, z)];
             if (chunk == nullptr || !chunk->flags.lighted) {
                 continue;
             }
             randomTick(*chunk, segments, indices);
         }
     }
+    // vectors capacity is kept for the next ticks
+    for (blockid_t id : batchedBlocks) {
+        auto& batch = randomBatches[id];
+        scripting::random_update_blocks(indices->blocks.require(id), batch);
+        batch.clear();
+    }
+    batchedBlocks.clear();
 }
 
 int64_t BlocksController::createBlockInventory(int x, int y, int z) {
@@ -6,6 +6,7 @@
 #include "maths/fastmaths.hpp"
 #include "typedefs.hpp"
 #include "util/Clock.hpp"
+#include "util/TimerWheel.hpp"
 #include "voxels/voxel.hpp"
 
 class Player;
@@ -15,9 +16,17 @@ class Chunk;
 class Chunks;
 class Lighting;
 class ContentIndices;
+struct WorldInfo;
 
 enum class BlockInteraction { step, destruction, placing };
 
+/// @brief Single block change of a batched edit
+struct BlockEdit {
+    glm::ivec3 pos;
+    blockid_t id;
+    blockstate state {};
+};
+
 /// @brief Player argument is nullable
 using on_block_interaction = std::function<
     void(Player*, const glm::ivec3&, const Block&, BlockInteraction type)>;
@@ -25,6 +34,7 @@ using on_block_interaction = std::function<
 /// BlocksController manages block updates and data (inventories, metadata)
 class BlocksController {
     const Level& level;
+    WorldInfo& worldInfo;
     Chunks& chunks;
     Lighting& lighting;
     util::Clock randTickClock;
@@ -33,22 +43,57 @@ class BlocksController {
     uint padding;
     FastRandom random {};
     std::vector<on_block_interaction> blockInteractionCallbacks;
+    /// @brief Random tick positions by block id of blocks having batch
+    /// random update handler
+    std::vector<std::vector<glm::ivec3>> randomBatches;
+    /// @brief Ids of blocks having non-empty randomBatches
+    std::vector<blockid_t> batchedBlocks;
+    /// @brief Positions of scheduled block updates by target tick. Updates
+    /// are kept by chunks (see Chunk::scheduledUpdates), events not found
+    /// there (chunk is unloaded or the update is already done) are skipped
+    util::TimerWheel<glm::ivec3> scheduledUpdates;
+
+    /// @brief Queue scheduled updates of the chunk added to the matrix
+    void onChunkShown(Chunk& chunk);
+    /// @brief Advance blocks tick running due scheduled updates
+    void runScheduledUpdates();
 public:
-    BlocksController(const Level& level, uint padding);
+    BlocksController(Level& level, uint padding);
 
     void updateSides(int x, int y, int z);
     void updateSides(int x, int y, int z, int w, int h, int d);
     void updateBlock(int x, int y, int z);
 
+    /// @brief Set blocks in a batch. Every neighbour block is updated once.
+    /// Lights update is queued with other changes of the tick (see
+    /// Lighting::flushUpdates).
+    /// Changes at positions of not loaded chunks are skipped
+    /// @param noupdate do not update neighbour blocks
+    void setBlocks(const std::vector<BlockEdit>& edits, bool noupdate = false);
+
     void breakBlock(Player* player, const Block& def, int x, int y, int z);
     void placeBlock(
         Player* player, const Block& def, blockstate state, int x, int y, int z
     );
 
     void update(float delta);
+
+    /// @brief Schedule block update (calls updateBlock) after the given
+    /// number of world ticks. Scheduled updates are saved with chunks.
+    /// Update of the same block at the same tick is scheduled once
+    /// @param delay number of ticks (at least 1)
+    /// @return false if the chunk is not loaded
+    bool scheduleUpdate(int x, int y, int z, uint delay);
+
+    /// @brief Call random update handler of the block (or add it to the
+    /// batch)
     void randomTick(
-        const Chunk& chunk, int segments, const ContentIndices* indices
+        const ContentIndices* indices, blockid_t id, const glm::ivec3& pos
     );
+    /// @brief Random tick chunk blocks. Random positions are sampled in
+    /// every segment if the chunk has many blocks having random update
+    /// events, few such blocks are ticked with the same probability
+    void randomTick(Chunk& chunk, int segments, const ContentIndices* indices);
     void randomTick(int tickid, int parts);
     void onBlocksTick(int tickid, int parts);
     int64_t createBlockInventory(int x, int y, int z);
@@ -2,14 +2,22 @@
 
 #include <limits.h>
 
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <memory>
 
 #include "content/Content.hpp"
+#include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
+#include "debug/Profiler.hpp"
 #include "files/WorldFiles.hpp"
 #include "graphics/core/Mesh.hpp"
 #include "lighting/Lighting.hpp"
 #include "maths/voxmaths.hpp"
+#include "objects/Player.hpp"
+#include "objects/Players.hpp"
+#include "physics/Hitbox.hpp"
 #include "util/timeutil.hpp"
 #include "voxels/Block.hpp"
 #include "voxels/Chunk.hpp"
@@ -18,9 +26,74 @@
 #include "world/Level.hpp"
 #include "world/World.hpp"
 #include "world/generator/WorldGenerator.hpp"
+#include "ChunksInterest.hpp"
 
 const uint MAX_WORK_PER_FRAME = 128;
+/// @brief Budget limits relative to the base (loadSpeed) budget
+const float MIN_BUDGET_SCALE = 0.25f;
+const float MAX_BUDGET_SCALE = 4.0f;
+/// @brief Lights budget relative to the loading one
+const float LIGHTS_BUDGET_SHARE = 0.5f;
 const uint MIN_SURROUNDING = 9;
+/// @brief Max number of chunks lighted in one batch
+const uint MAX_LIGHTS_BATCH = 32;
+/// @brief Max number of queued generation jobs per worker. Keeps the queue
+/// short, so jobs are scheduled by actual distance to the player
+const uint MAX_JOBS_PER_WORKER = 2;
+/// @brief Max number of queued chunk prefetch jobs
+const uint MAX_PREFETCH_JOBS = 32;
+/// @brief Player position is predicted for the given time (seconds)
+const float PREFETCH_PREDICTION_TIME = 4.0f;
+/// @brief Min player horizontal speed to enable prefetch (blocks per second)
+const float PREFETCH_MIN_SPEED = 2.0f;
+/// @brief Prefetched positions set gets cleared when exceeds the limit
+const size_t MAX_PREFETCHED_POSITIONS = 65536;
+/// @brief Max number of chunks checked for compaction per update
+const uint MAX_COMPACT_CHECKS = 64;
+/// @brief Number of updates between memory budget checks
+const uint BUDGET_CHECK_INTERVAL = 30;
+
+static debug::Logger logger("chunks-control");
+
+class GeneratorWorker : public util::Worker<ChunkGenJob, std::shared_ptr<Chunk>> {
+    const WorldGenerator& generator;
+    const ContentIndices* indices;
+public:
+    GeneratorWorker(const WorldGenerator& generator, const Content& content)
+        : generator(generator), indices(content.getIndices()) {
+    }
+
+    std::shared_ptr<Chunk> operator()(const ChunkGenJob& job) override {
+        static auto& generateTime =
+            debug::Metrics::getInstance().histogram("chunks.generate");
+        debug::MetricTimer timer(generateTime);
+        auto& chunk = *job.chunk;
+        generator.generate(chunk.voxels.data(), chunk.x, chunk.z, *job.prototype);
+        chunk.updateHeights();
+        if (!chunk.flags.loadedLights) {
+            Lighting::prebuildSkyLight(&chunk, indices);
+        }
+        return job.chunk;
+    }
+};
+
+class PrefetchWorker : public util::Worker<glm::ivec2, glm::ivec2> {
+    WorldRegions& regions;
+public:
+    PrefetchWorker(WorldRegions& regions) : regions(regions) {
+    }
+
+    glm::ivec2 operator()(const glm::ivec2& pos) override {
+        // failed prefetch is not critical: the chunk will be read on load
+        try {
+            regions.prefetch(pos.x, pos.y);
+        } catch (const std::exception& err) {
+            logger.warning() << "could not prefetch chunk " << pos.x << ", "
+                             << pos.y << ": " << err.what();
+        }
+        return pos;
+    }
+};
 
 ChunksController::ChunksController(Level& level, uint padding)
     : level(level),
@@ -31,54 +104,222 @@ ChunksController::ChunksController(Level& level, uint padding)
           level.content->generators.require(level.getWorld()->getGenerator()),
           level.content,
           level.getWorld()->getSeed()
-      )) {}
+      )),
+      threadPool(
+          "chunks-gen-pool",
+          [this]() {
+              return std::make_shared<GeneratorWorker>(
+                  *generator, *this->level.content
+              );
+          },
+          [this](auto& chunk) { commitChunk(chunk); },
+          util::ThreadPool<ChunkGenJob, std::shared_ptr<Chunk>>::QUARTER
+      ),
+      prefetchPool(
+          "chunks-prefetch-pool",
+          [this]() {
+              return std::make_shared<PrefetchWorker>(
+                  this->level.getWorld()->wfile->getRegions()
+              );
+          },
+          [this](auto& pos) {
+              prefetching.erase(pos);
+              prefetched.insert(pos);
+          },
+          1
+      ),
+      generateBudget(0, 0, 0),
+      lightsBudget(0, 0, 0) {
+    prefetchPool.setPriority(util::TaskScheduler::Priority::LOW);
+    generator->setPrototypesStorage(&level.getWorld()->wfile->getRegions());
+    logger.info() << "created " << threadPool.getWorkersCount()
+                  << " generator workers";
+}
 
 ChunksController::~ChunksController() = default;
 
+void ChunksController::setFrameTime(
+    int64_t frameTime, int64_t targetFrameTime
+) {
+    generateBudget.update(frameTime, targetFrameTime);
+    lightsBudget.update(frameTime, targetFrameTime);
+}
+
 void ChunksController::update(
-    int64_t maxDuration, int loadDistance, int centerX, int centerY
+    int64_t maxDuration,
+    int loadDistance,
+    int compactDistance,
+    size_t memoryBudget,
+    const ChunksInterest& interest
 ) {
-    generator->update(centerX, centerY, loadDistance);
+    static auto& metrics = debug::Metrics::getInstance();
+    static auto& generatingGauge = metrics.gauge("chunks.generating");
+    static auto& generateBudgetGauge = metrics.gauge("chunks.budget.generate");
+    static auto& generateSpentGauge = metrics.gauge("chunks.spent.generate");
+    static auto& lightsBudgetGauge = metrics.gauge("chunks.budget.lights");
+    static auto& lightsSpentGauge = metrics.gauge("chunks.spent.lights");
+    debug::ProfileZone zone("chunks-update");
+    chunks.updateSaving();
+    threadPool.update();
+    prefetchPool.update();
+    // the whole matrix except padding may be loaded
+    int centerX = chunks.getOffsetX() + chunks.getWidth() / 2;
+    int centerY = chunks.getOffsetY() + chunks.getHeight() / 2;
+    generator->update(centerX, centerY, chunks.getWidth() / 2 - padding);
+    prefetch(loadDistance);
+    compactChunks(compactDistance, interest);
+    applyMemoryBudget(memoryBudget);
 
-    int64_t mcstotal = 0;
+    int64_t base = maxDuration * 1000;
+    generateBudget.setLimits(base * MIN_BUDGET_SCALE, base * MAX_BUDGET_SCALE);
+    lightsBudget.setLimits(
+        base * LIGHTS_BUDGET_SHARE * MIN_BUDGET_SCALE,
+        base * LIGHTS_BUDGET_SHARE * MAX_BUDGET_SCALE
+    );
+    // the first batch is always processed, so lighting never stalls
+    do {
+        timeutil::Timer timer;
+        size_t lighted = buildLights();
+        lightsBudget.spend(timer.stop());
+        if (lighted == 0) {
+            break;
+        }
+    } while (lightsBudget.getLeft() > 0);
 
     for (uint i = 0; i < MAX_WORK_PER_FRAME; i++) {
         timeutil::Timer timer;
-        if (loadVisible()) {
-            int64_t mcs = timer.stop();
-            if (mcstotal + mcs < maxDuration * 1000) {
-                mcstotal += mcs;
-                continue;
+        bool loaded = loadVisible(interest);
+        generateBudget.spend(timer.stop());
+        if (!loaded || generateBudget.getLeft() <= 0) {
+            break;
+        }
+    }
+    generatingGauge.set(inwork.size());
+    generateBudgetGauge.set(generateBudget.get());
+    generateSpentGauge.set(generateBudget.getSpent());
+    lightsBudgetGauge.set(lightsBudget.get());
+    lightsSpentGauge.set(lightsBudget.getSpent());
+}
+
+void ChunksController::applyMemoryBudget(size_t memoryBudget) {
+    if (memoryBudget == 0 || budgetCheckTimer--) {
+        return;
+    }
+    budgetCheckTimer = BUDGET_CHECK_INTERVAL;
+
+    auto& regions = level.getWorld()->wfile->getRegions();
+    size_t used = level.chunksStorage->getMemoryStats().total() +
+                  regions.getMemoryUsage();
+    if (used <= memoryBudget) {
+        return;
+    }
+    level.chunksStorage->trimPool();
+    // one region per check to avoid long stalls
+    int centerX = chunks.getOffsetX() + chunks.getWidth() / 2;
+    int centerY = chunks.getOffsetY() + chunks.getHeight() / 2;
+    int keepDistance = chunks.getWidth() / 2 + padding;
+    size_t freed = regions.evictRegion(centerX, centerY, keepDistance);
+    if (freed) {
+        logger.info() << "chunks memory budget exceeded (" << (used >> 20)
+                      << " MiB), evicted region of " << (freed >> 10)
+                      << " KiB";
+    }
+}
+
+void ChunksController::compactChunks(
+    int compactDistance, const ChunksInterest& interest
+) {
+    const auto& chunksList = chunks.getChunks();
+    if (compactDistance <= 0 || chunksList.empty()) {
+        return;
+    }
+    int minDistanceSq = compactDistance * compactDistance;
+    for (uint i = 0; i < MAX_COMPACT_CHECKS; i++) {
+        compactIndex = (compactIndex + 1) % chunksList.size();
+        const auto& chunk = chunksList[compactIndex];
+        // chunks lights calculation accesses voxels a lot
+        if (chunk == nullptr || !chunk->flags.lighted) {
+            continue;
+        }
+        if (interest.getNearestDistance2(chunk->x, chunk->z) >
+            minDistanceSq) {
+            chunk->voxels.compact();
+            chunk->lightmap.compact();
+        }
+    }
+}
+
+void ChunksController::prefetch(int loadDistance) {
+    if (prefetched.size() > MAX_PREFETCHED_POSITIONS) {
+        prefetched.clear();
+    }
+    int radius = loadDistance / 2;
+    for (const auto& [_, player] : *level.players) {
+        auto hitbox = player->getHitbox();
+        if (hitbox == nullptr) {
+            continue;
+        }
+        glm::vec2 velocity(hitbox->velocity.x, hitbox->velocity.z);
+        if (glm::length(velocity) < PREFETCH_MIN_SPEED) {
+            continue;
+        }
+        // predicted position is limited to the loading area border
+        glm::vec2 offset = velocity * PREFETCH_PREDICTION_TIME;
+        float maxOffset = static_cast<float>(radius * CHUNK_W);
+        if (glm::length(offset) > maxOffset) {
+            offset = glm::normalize(offset) * maxOffset;
+        }
+        const auto& position = player->getPosition();
+        int centerX = floordiv(
+            static_cast<int>(std::floor(position.x + offset.x)), CHUNK_W
+        );
+        int centerZ = floordiv(
+            static_cast<int>(std::floor(position.z + offset.y)), CHUNK_D
+        );
+        for (int z = centerZ - radius; z <= centerZ + radius; z++) {
+            for (int x = centerX - radius; x <= centerX + radius; x++) {
+                if (prefetching.size() >= MAX_PREFETCH_JOBS) {
+                    return;
+                }
+                glm::ivec2 pos(x, z);
+                if (chunks.getChunk(x, z) || prefetched.count(pos) ||
+                    prefetching.count(pos)) {
+                    continue;
+                }
+                prefetching.insert(pos);
+                prefetchPool.enqueueJob(pos);
             }
         }
-        break;
     }
 }
 
-bool ChunksController::loadVisible() {
+bool ChunksController::loadVisible(const ChunksInterest& interest) {
     int sizeX = chunks.getWidth();
     int sizeY = chunks.getHeight();
 
+    int offsetX = chunks.getOffsetX();
+    int offsetY = chunks.getOffsetY();
+    bool canEnqueue =
+        inwork.size() < threadPool.getWorkersCount() * MAX_JOBS_PER_WORKER;
+
     int nearX = 0;
     int nearZ = 0;
     bool assigned = false;
-    int minDistance = ((sizeX - padding * 2) / 2) * ((sizeY - padding * 2) / 2);
+    float minDistance = std::numeric_limits<float>::max();
     for (uint z = padding; z < sizeY - padding; z++) {
         for (uint x = padding; x < sizeX - padding; x++) {
-            int index = z * sizeX + x;
-            auto& chunk = chunks.getChunks()[index];
+            auto& chunk = chunks.getChunks()[chunks.getIndex(x, z)];
             if (chunk != nullptr) {
-                if (chunk->flags.loaded && !chunk->flags.lighted) {
-                    if (buildLights(chunk)) {
-                        return true;
-                    }
-                }
                 continue;
             }
-            int lx = x - sizeX / 2;
-            int lz = z - sizeY / 2;
-            int distance = (lx * lx + lz * lz);
-            if (distance < minDistance) {
+            if (!canEnqueue ||
+                inwork.find({x + offsetX, z + offsetY}) != inwork.end()) {
+                continue;
+            }
+            // chunks out of all viewers areas are not loaded
+            float distance =
+                interest.getLoadDistance2(x + offsetX, z + offsetY);
+            if (distance >= 0.0f && distance < minDistance) {
                 minDistance = distance;
                 nearX = x;
                 nearZ = z;
@@ -87,49 +328,86 @@ bool ChunksController::loadVisible() {
         }
     }
 
-    const auto& chunk = chunks.getChunks()[nearZ * sizeX + nearX];
+    const auto& chunk = chunks.getChunks()[chunks.getIndex(nearX, nearZ)];
     if (chunk != nullptr || !assigned) {
         return false;
     }
-    int offsetX = chunks.getOffsetX();
-    int offsetY = chunks.getOffsetY();
     createChunk(nearX + offsetX, nearZ + offsetY);
     return true;
 }
 
-bool ChunksController::buildLights(const std::shared_ptr<Chunk>& chunk) {
+bool ChunksController::isSurrounded(const Chunk& chunk) const {
     int surrounding = 0;
     for (int oz = -1; oz <= 1; oz++) {
         for (int ox = -1; ox <= 1; ox++) {
-            if (chunks.getChunk(chunk->x + ox, chunk->z + oz)) surrounding++;
+            if (chunks.getChunk(chunk.x + ox, chunk.z + oz)) surrounding++;
         }
     }
-    if (surrounding == MIN_SURROUNDING) {
-        bool lightsCache = chunk->flags.loadedLights;
-        if (!lightsCache) {
-            lighting.buildSkyLight(chunk->x, chunk->z);
+    return surrounding == MIN_SURROUNDING;
+}
+
+size_t ChunksController::buildLights() {
+    int sizeX = chunks.getWidth();
+    int sizeY = chunks.getHeight();
+
+    std::vector<Chunk*> batch;
+    for (uint z = padding; z < sizeY - padding; z++) {
+        for (uint x = padding; x < sizeX - padding; x++) {
+            const auto& chunk = chunks.getChunks()[chunks.getIndex(x, z)];
+            if (chunk == nullptr || !chunk->flags.loaded ||
+                chunk->flags.lighted || !isSurrounded(*chunk)) {
+                continue;
+            }
+            batch.push_back(chunk.get());
+            if (batch.size() == MAX_LIGHTS_BATCH) {
+                break;
+            }
         }
-        lighting.onChunkLoaded(chunk->x, chunk->z, !lightsCache);
-        chunk->flags.lighted = true;
-        return true;
+        if (batch.size() == MAX_LIGHTS_BATCH) {
+            break;
+        }
+    }
+    if (!batch.empty()) {
+        lighting.buildChunksLights(batch);
     }
-    return false;
+    return batch.size();
 }
 
 void ChunksController::createChunk(int x, int z) {
-    auto chunk = level.chunksStorage->create(x, z);
-    chunks.putChunk(chunk);
+    static auto& loadTime =
+        debug::Metrics::getInstance().histogram("chunks.load");
+    std::shared_ptr<Chunk> chunk;
+    {
+        debug::MetricTimer timer(loadTime);
+        chunk = level.chunksStorage->create(x, z);
+    }
     auto& chunkFlags = chunk->flags;
 
     if (!chunkFlags.loaded) {
-        generator->generate(chunk->voxels, x, z);
-        chunkFlags.unsaved = true;
+        // chunk is not visible via Chunks until generated
+        inwork.insert({x, z});
+        threadPool.enqueueJob(ChunkGenJob {chunk, generator->prepare(x, z)});
+        return;
     }
+    chunks.putChunk(chunk);
     chunk->updateHeights();
 
     if (!chunkFlags.loadedLights) {
         Lighting::prebuildSkyLight(chunk.get(), level.content->getIndices());
     }
+    chunkFlags.ready = true;
+}
+
+void ChunksController::commitChunk(const std::shared_ptr<Chunk>& chunk) {
+    inwork.erase({chunk->x, chunk->z});
+    if (!chunks.putChunk(chunk)) {
+        // chunk moved out of the loading area while being generated
+        level.chunksStorage->remove(chunk->x, chunk->z);
+        return;
+    }
+    auto& chunkFlags = chunk->flags;
+    chunkFlags.unsaved = true;
+    chunkFlags.generated = true;
     chunkFlags.loaded = true;
     chunkFlags.ready = true;
 }
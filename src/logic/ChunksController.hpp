@@ -1,14 +1,30 @@
 #pragma once
 
 #include <memory>
+#include <unordered_set>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
 
 #include "typedefs.hpp"
+#include "util/AdaptiveBudget.hpp"
+#include "util/ThreadPool.hpp"
 
 class Level;
 class Chunk;
+class ChunksInterest;
+class WorldRegions;
 class Chunks;
 class Lighting;
 class WorldGenerator;
+struct ChunkPrototype;
+
+/// @brief Chunk voxels generation job performed by a worker thread
+struct ChunkGenJob {
+    std::shared_ptr<Chunk> chunk;
+    /// @brief complete chunk prototype prepared on the main thread
+    std::shared_ptr<const ChunkPrototype> prototype;
+};
 
 /// @brief ChunksController manages chunks dynamic loading/unloading
 class ChunksController {
@@ -18,21 +34,61 @@ private:
     Lighting& lighting;
     uint padding;
     std::unique_ptr<WorldGenerator> generator;
+    /// @brief Positions of chunks being generated by workers
+    std::unordered_set<glm::ivec2> inwork;
+    util::ThreadPool<ChunkGenJob, std::shared_ptr<Chunk>> threadPool;
+    /// @brief Positions of chunks being prefetched by the worker
+    std::unordered_set<glm::ivec2> prefetching;
+    /// @brief Positions of chunks already prefetched
+    std::unordered_set<glm::ivec2> prefetched;
+    util::ThreadPool<glm::ivec2, glm::ivec2> prefetchPool;
+    /// @brief Next chunks matrix index checked by compactChunks
+    size_t compactIndex = 0;
+    /// @brief Updates left until the next memory budget check
+    uint budgetCheckTimer = 0;
+    /// @brief Time budget of chunks loading and generation jobs scheduling
+    util::AdaptiveBudget generateBudget;
+    /// @brief Time budget of loaded chunks lights calculation
+    util::AdaptiveBudget lightsBudget;
 
-    /// @brief Process one chunk: load it or calculate lights for it
-    bool loadVisible();
-    bool buildLights(const std::shared_ptr<Chunk>& chunk);
+    /// @brief Process one chunk: load it or start its generation
+    bool loadVisible(const ChunksInterest& interest);
+    /// @brief Calculate lights for a batch of loaded chunks
+    /// @return number of lighted chunks
+    size_t buildLights();
+    bool isSurrounded(const Chunk& chunk) const;
     void createChunk(int x, int y);
+    /// @brief Put generated chunk into the chunks matrix (main thread)
+    void commitChunk(const std::shared_ptr<Chunk>& chunk);
+    /// @brief Request reading of saved chunks ahead of moving players
+    void prefetch(int loadDistance);
+    /// @brief Palette-compress voxels of a few chunks far from viewers
+    void compactChunks(int compactDistance, const ChunksInterest& interest);
+    /// @brief Free chunks memory exceeding the budget: delete pooled chunks,
+    /// then move in-memory regions far from the matrix center to files
+    void applyMemoryBudget(size_t memoryBudget);
 public:
     ChunksController(Level& level, uint padding);
     ~ChunksController();
 
-    /// @param maxDuration milliseconds reserved for chunks loading
+    /// @brief Adapt stages time budgets to the last frame time
+    /// @param frameTime last frame main thread work time (microseconds)
+    /// @param targetFrameTime target frame time (microseconds)
+    void setFrameTime(int64_t frameTime, int64_t targetFrameTime);
+
+    /// @param maxDuration base milliseconds reserved for chunks loading,
+    /// the actual budget adapts to the frame time headroom
+    /// @param compactDistance distance to the chunks to be compacted
+    /// (0 - disabled)
+    /// @param memoryBudget chunks data memory budget in bytes (0 - unlimited)
+    /// @param interest viewers loading areas covered by the chunks matrix
     void update(
         int64_t maxDuration,
         int loadDistance,
-        int centerX,
-        int centerY);
+        int compactDistance,
+        size_t memoryBudget,
+        const ChunksInterest& interest
+    );
 
     const WorldGenerator* getGenerator() const {
         return generator.get();
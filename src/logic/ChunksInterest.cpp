@@ -0,0 +1,105 @@
+#include "ChunksInterest.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "maths/voxmaths.hpp"
+
+/// @brief Loading distance multiplier of chunks right behind viewers,
+/// chunks aside get a half of it
+static constexpr float BEHIND_DISTANCE_WEIGHT = 3.0f;
+
+ChunksInterest::ChunksInterest(int maxSpan) : maxSpan(maxSpan) {
+}
+
+void ChunksInterest::clear() {
+    viewers.clear();
+    min = max = {};
+}
+
+bool ChunksInterest::addViewer(
+    int x, int z, int radius, glm::vec2 direction
+) {
+    glm::ivec2 center(x, z);
+    glm::ivec2 areaMin = center - radius;
+    glm::ivec2 areaMax = center + radius;
+    if (viewers.empty()) {
+        min = areaMin;
+        max = areaMax;
+    } else {
+        auto newMin = glm::min(min, areaMin);
+        auto newMax = glm::max(max, areaMax);
+        auto span = newMax - newMin;
+        if (span.x > maxSpan || span.y > maxSpan) {
+            return false;
+        }
+        min = newMin;
+        max = newMax;
+    }
+    if (glm::length(direction) > 0.0f) {
+        direction = glm::normalize(direction);
+    }
+    viewers.push_back(Viewer {center, radius, direction});
+    return true;
+}
+
+int ChunksInterest::getRefs(int x, int z) const {
+    int refs = 0;
+    for (const auto& viewer : viewers) {
+        refs += viewer.contains(x, z);
+    }
+    return refs;
+}
+
+int ChunksInterest::getDistance2(int x, int z) const {
+    int nearest = -1;
+    for (const auto& viewer : viewers) {
+        int distance = viewer.distance2(x, z);
+        if (distance >= viewer.radius * viewer.radius) {
+            continue;
+        }
+        if (nearest == -1 || distance < nearest) {
+            nearest = distance;
+        }
+    }
+    return nearest;
+}
+
+float ChunksInterest::getLoadDistance2(int x, int z) const {
+    float nearest = -1.0f;
+    for (const auto& viewer : viewers) {
+        int distance = viewer.distance2(x, z);
+        if (distance >= viewer.radius * viewer.radius) {
+            continue;
+        }
+        float weighted = distance;
+        if (distance > 0 && viewer.direction != glm::vec2()) {
+            glm::vec2 offset(x - viewer.center.x, z - viewer.center.y);
+            float cos = glm::dot(offset, viewer.direction) /
+                        std::sqrt(static_cast<float>(distance));
+            weighted *= 1.0f + BEHIND_DISTANCE_WEIGHT * (1.0f - cos) * 0.5f;
+        }
+        if (nearest < 0.0f || weighted < nearest) {
+            nearest = weighted;
+        }
+    }
+    return nearest;
+}
+
+int ChunksInterest::getNearestDistance2(int x, int z) const {
+    int nearest = std::numeric_limits<int>::max();
+    for (const auto& viewer : viewers) {
+        nearest = std::min(nearest, viewer.distance2(x, z));
+    }
+    return nearest;
+}
+
+int ChunksInterest::getMatrix(int padding, glm::ivec2& center) const {
+    auto span = max - min;
+    int size = std::max(span.x, span.y) + padding * 2;
+    // matrix offset is center - size / 2
+    size += size % 2;
+    center = glm::ivec2(floordiv(min.x + max.x, 2), floordiv(min.y + max.y, 2));
+    return size;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+
+/// @brief Chunks loading areas of all viewers (players). Chunks are loaded
+/// once for all viewers they are visible to, the chunks matrix covers
+/// the union of the areas
+class ChunksInterest {
+    struct Viewer {
+        /// @brief Area center chunk
+        glm::ivec2 center;
+        /// @brief Area is a circle, its bounding box is
+        /// [center - radius, center + radius) on both axes
+        int radius;
+        /// @brief Normalized horizontal view direction, zero if unknown
+        glm::vec2 direction;
+
+        int distance2(int x, int z) const {
+            int dx = x - center.x;
+            int dz = z - center.y;
+            return dx * dx + dz * dz;
+        }
+
+        bool contains(int x, int z) const {
+            return distance2(x, z) < radius * radius;
+        }
+    };
+    std::vector<Viewer> viewers;
+    /// @brief Max size of the areas union bounding box (chunks)
+    int maxSpan;
+    /// @brief Areas union bounding box (max is exclusive)
+    glm::ivec2 min {};
+    glm::ivec2 max {};
+public:
+    /// @param maxSpan max size of the areas union bounding box (chunks)
+    ChunksInterest(int maxSpan);
+
+    void clear();
+
+    /// @brief Add viewer loading area. The first viewer is the main one:
+    /// viewers not fitting maxSpan together with others are ignored
+    /// @param x area center chunk x
+    /// @param z area center chunk z
+    /// @param radius area radius (chunks)
+    /// @param direction horizontal view direction, chunks in front of
+    /// the viewer are loaded first
+    /// @return false if the viewer is ignored
+    bool addViewer(int x, int z, int radius, glm::vec2 direction = {});
+
+    /// @return number of viewers the chunk is loaded for
+    int getRefs(int x, int z) const;
+
+    /// @return squared distance to the nearest viewer the chunk is loaded
+    /// for or -1 if there is no such viewer
+    int getDistance2(int x, int z) const;
+
+    /// @return loading priority distance: squared distance to the nearest
+    /// viewer the chunk is loaded for scaled up for chunks out of the viewer
+    /// view direction or -1 if there is no such viewer
+    float getLoadDistance2(int x, int z) const;
+
+    /// @return squared distance to the nearest viewer center
+    int getNearestDistance2(int x, int z) const;
+
+    /// @brief Get chunks matrix covering all areas with the padding
+    /// @param padding chunks matrix padding
+    /// @param center[out] matrix center chunk
+    /// @return matrix size (even)
+    int getMatrix(int padding, glm::ivec2& center) const;
+
+    size_t size() const {
+        return viewers.size();
+    }
+};
@@ -0,0 +1,307 @@
+#include "ChunksStreamer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "coders/byte_utils.hpp"
+#include "coders/compression.hpp"
+#include "coders/delta.hpp"
+#include "content/Content.hpp"
+#include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
+#include "debug/Profiler.hpp"
+#include "lighting/Lighting.hpp"
+#include "network/Network.hpp"
+#include "objects/Player.hpp"
+#include "objects/Players.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "window/Camera.hpp"
+#include "world/Level.hpp"
+#include "maths/voxmaths.hpp"
+#include "ChunksInterest.hpp"
+
+static debug::Logger logger("chunks-streamer");
+
+/// @brief Max chunks encoded per update for all clients, the rest is
+/// sent by the next updates
+static constexpr int MAX_CHUNKS_PER_UPDATE = 16;
+/// @brief Sent chunks farther than the radius plus this padding are
+/// forgotten, so moving along the area border does not resend them
+static constexpr int FORGET_PADDING = 2;
+/// @brief Max unused bandwidth accumulated for bursts (seconds)
+static constexpr double MAX_BUDGET_TIME = 1.0;
+/// @brief Message header: type, x, z
+static constexpr size_t HEADER_SIZE = 9;
+
+/// @brief FNV-1a hash
+static uint32_t hash_bytes(const ubyte* data, size_t size) {
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619U;
+    }
+    return hash;
+}
+
+/// @brief Reject received chunk data with unknown blocks ids, so they are
+/// never used as blocks indices
+static void check_block_ids(const ubyte* data, const Level& level) {
+    size_t count = level.content->getIndices()->blocks.count();
+    auto ids = reinterpret_cast<const uint16_t*>(data);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        if (ids[i] >= count) {
+            throw std::runtime_error(
+                "invalid block id " + std::to_string(ids[i])
+            );
+        }
+    }
+}
+
+ChunksStreamer::ChunksStreamer(const Level& level, network::Network& network)
+    : level(level), network(network) {
+}
+
+ChunksStreamer::~ChunksStreamer() = default;
+
+void ChunksStreamer::setClient(
+    u64id_t connection, int64_t player, int radius, size_t bandwidth
+) {
+    auto& client = clients[connection];
+    if (client.connection != connection) {
+        client.connection = connection;
+        client.budget = 0.0;
+    }
+    client.player = player;
+    client.radius = std::max(radius, 1);
+    client.bandwidth = bandwidth;
+}
+
+void ChunksStreamer::removeClient(u64id_t connection) {
+    clients.erase(connection);
+}
+
+void ChunksStreamer::forget(u64id_t connection, int x, int z) {
+    const auto& found = clients.find(connection);
+    if (found != clients.end()) {
+        found->second.sent.erase({x, z});
+    }
+}
+
+size_t ChunksStreamer::send(
+    Client& client, const glm::ivec2& pos, const Chunk& chunk
+) {
+    static auto& fullCounter =
+        debug::Metrics::getInstance().counter("network.chunks-full");
+    static auto& deltaCounter =
+        debug::Metrics::getInstance().counter("network.chunks-delta");
+    static auto& bytesCounter =
+        debug::Metrics::getInstance().counter("network.chunks-bytes");
+
+    auto connection = network.getConnection(client.connection);
+    auto data = chunk.encodeTemporary();
+    uint32_t hash = hash_bytes(data.get(), CHUNK_DATA_LEN);
+    uint32_t revision = chunk.revision;
+
+    auto found = client.sent.find(pos);
+    if (found != client.sent.end() && found->second.hash == hash) {
+        found->second.revision = revision;
+        found->second.unknown = false;
+        return 0;
+    }
+    size_t compressedSize;
+    auto compressed = compression::compress(
+        data.get(),
+        CHUNK_DATA_LEN,
+        compressedSize,
+        compression::Method::EXTRLE16
+    );
+    ByteBuilder builder;
+    builder.put(MESSAGE_FULL);
+    builder.putInt32(pos.x);
+    builder.putInt32(pos.y);
+    if (found != client.sent.end()) {
+        const auto& prev = found->second;
+        auto base = compression::decompress(
+            prev.data.data(),
+            prev.data.size(),
+            CHUNK_DATA_LEN,
+            compression::Method::EXTRLE16
+        );
+        auto diff = delta::encode(base.get(), data.get(), CHUNK_DATA_LEN);
+        if (diff.size() + sizeof(uint32_t) < compressedSize) {
+            builder.set(0, MESSAGE_DELTA);
+            builder.putInt32(static_cast<int32_t>(prev.hash));
+            builder.put(diff.data(), diff.size());
+        }
+    }
+    bool full = builder.size() == HEADER_SIZE;
+    if (full) {
+        builder.put(compressed.get(), compressedSize);
+    }
+    size_t size = connection->sendMessage(builder.data(), builder.size(), true);
+    (full ? fullCounter : deltaCounter).add();
+    bytesCounter.add(size);
+
+    auto& sent = client.sent[pos];
+    sent.data.assign(compressed.get(), compressed.get() + compressedSize);
+    sent.hash = hash;
+    sent.revision = revision;
+    sent.unknown = false;
+    return size;
+}
+
+bool ChunksStreamer::update(Client& client, float delta) {
+    auto connection = network.getConnection(client.connection);
+    if (connection == nullptr ||
+        connection->getState() == network::ConnectionState::CLOSED) {
+        return false;
+    }
+    auto player = level.players->get(client.player);
+    if (player == nullptr) {
+        return true;
+    }
+    if (client.bandwidth) {
+        client.budget = std::min(
+            client.budget + client.bandwidth * static_cast<double>(delta),
+            client.bandwidth * MAX_BUDGET_TIME
+        );
+        if (client.budget <= 0.0) {
+            return true;
+        }
+    }
+    const auto& position = player->getPosition();
+    glm::vec2 direction {};
+    if (player->currentCamera) {
+        const auto& front = player->currentCamera->front;
+        direction = {front.x, front.z};
+    }
+    glm::ivec2 center(
+        floordiv(position.x, CHUNK_W), floordiv(position.z, CHUNK_D)
+    );
+    // single viewer interest gives the same order as chunks loading
+    ChunksInterest interest(client.radius * 2);
+    interest.addViewer(center.x, center.y, client.radius, direction);
+
+    int forgetRadius = client.radius + FORGET_PADDING;
+    for (auto it = client.sent.begin(); it != client.sent.end();) {
+        auto offset = it->first - center;
+        if (offset.x * offset.x + offset.y * offset.y >
+            forgetRadius * forgetRadius) {
+            it = client.sent.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    const auto& chunks = *level.chunks;
+    candidates.clear();
+    for (int z = center.y - client.radius; z < center.y + client.radius; z++) {
+        for (int x = center.x - client.radius; x < center.x + client.radius;
+             x++) {
+            float priority = interest.getLoadDistance2(x, z);
+            if (priority < 0.0f) {
+                continue;
+            }
+            glm::ivec2 pos(x, z);
+            auto chunk = chunks.getChunk(x, z);
+            const auto& found = client.sent.find(pos);
+            if (chunk == nullptr || !chunk->flags.loaded) {
+                if (found != client.sent.end()) {
+                    found->second.unknown = true;
+                }
+                continue;
+            }
+            if (found != client.sent.end() && !found->second.unknown &&
+                found->second.revision == chunk->revision) {
+                continue;
+            }
+            candidates.push_back({priority, pos, chunk});
+        }
+    }
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [](const Candidate& a, const Candidate& b) {
+            return a.priority < b.priority;
+        }
+    );
+    int encoded = 0;
+    for (const auto& candidate : candidates) {
+        if (encoded++ >= MAX_CHUNKS_PER_UPDATE ||
+            (client.bandwidth && client.budget <= 0.0)) {
+            break;
+        }
+        client.budget -= send(client, candidate.pos, *candidate.chunk);
+    }
+    if (!client.bandwidth) {
+        client.budget = 0.0;
+    }
+    return true;
+}
+
+void ChunksStreamer::update(float delta) {
+    if (clients.empty()) {
+        return;
+    }
+    debug::ProfileZone zone("chunks-streaming");
+    for (auto it = clients.begin(); it != clients.end();) {
+        if (!update(it->second, delta)) {
+            logger.info() << "connection " << it->first
+                          << " closed, streaming stopped";
+            it = clients.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool ChunksStreamer::apply(
+    Level& level, const ubyte* data, size_t size, int& x, int& z
+) {
+    ByteReader reader(data, size);
+    ubyte type = reader.get();
+    x = reader.getInt32();
+    z = reader.getInt32();
+    if (type != MESSAGE_FULL && type != MESSAGE_DELTA) {
+        throw std::runtime_error(
+            "invalid chunk message type " + std::to_string(type)
+        );
+    }
+    auto chunk = level.chunks->getChunk(x, z);
+    if (chunk == nullptr) {
+        return false;
+    }
+    switch (type) {
+        case MESSAGE_FULL: {
+            auto decompressed = compression::decompress(
+                reader.pointer(),
+                reader.remaining(),
+                CHUNK_DATA_LEN,
+                compression::Method::EXTRLE16
+            );
+            check_block_ids(decompressed.get(), level);
+            chunk->decode(decompressed.get());
+            break;
+        }
+        case MESSAGE_DELTA: {
+            uint32_t baseHash = static_cast<uint32_t>(reader.getInt32());
+            auto current = chunk->encodeTemporary();
+            if (hash_bytes(current.get(), CHUNK_DATA_LEN) != baseHash) {
+                return false;
+            }
+            delta::apply(
+                current.get(),
+                CHUNK_DATA_LEN,
+                reader.pointer(),
+                reader.remaining()
+            );
+            check_block_ids(current.get(), level);
+            chunk->decode(current.get());
+            break;
+        }
+    }
+    chunk->flags.changed = true;
+    level.chunks->onChunkDataChanged(x, z);
+    level.lighting->onChunkDataChanged(x, z);
+    return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+
+#include "typedefs.hpp"
+
+class Level;
+class Chunk;
+
+namespace network {
+    class Network;
+}
+
+/// @brief Server side replication of chunks to remote players over
+/// network connections messages. Every client has the chunks around its
+/// player sent nearest and in view first within the connection bandwidth
+/// limit, chunks changed after sending are sent again as deltas
+/// of the previously sent version.
+///
+/// Message format (gzip compressed, see Connection::sendMessage):
+/// - byte type (MESSAGE_FULL or MESSAGE_DELTA)
+/// - int32 chunk x, int32 chunk z
+/// - full: EXTRLE16 compressed chunk data (region voxels layer encoding)
+/// - delta: uint32 FNV-1a hash of the previously sent chunk data
+/// (the delta base) followed by delta::encode of the versions
+class ChunksStreamer {
+public:
+    static constexpr ubyte MESSAGE_FULL = 1;
+    static constexpr ubyte MESSAGE_DELTA = 2;
+private:
+    struct SentChunk {
+        /// @brief EXTRLE16 compressed version the client has
+        std::vector<ubyte> data;
+        /// @brief Hash of the sent version data
+        uint32_t hash;
+        /// @brief Revision of the sent version, see Chunk::revision
+        uint32_t revision;
+        /// @brief Revision may belong to another chunk instance (the chunk
+        /// was not loaded), versions must be compared
+        bool unknown;
+    };
+    struct Client {
+        u64id_t connection;
+        int64_t player;
+        int radius;
+        /// @brief Bytes per second, 0 - unlimited
+        size_t bandwidth;
+        /// @brief Bytes allowed to be sent now
+        double budget;
+        std::unordered_map<glm::ivec2, SentChunk> sent;
+    };
+    struct Candidate {
+        float priority;
+        glm::ivec2 pos;
+        Chunk* chunk;
+    };
+    const Level& level;
+    network::Network& network;
+    std::unordered_map<u64id_t, Client> clients;
+    std::vector<Candidate> candidates;
+
+    /// @brief Send chunk not sent yet or changed since sending
+    /// @return sent message size, 0 if the client has the same version
+    size_t send(Client& client, const glm::ivec2& pos, const Chunk& chunk);
+
+    /// @return false if the client connection is closed
+    bool update(Client& client, float delta);
+public:
+    ChunksStreamer(const Level& level, network::Network& network);
+    ~ChunksStreamer();
+
+    /// @brief Start or update streaming to the connection
+    /// @param connection network connection id
+    /// @param player remote player id chunks are streamed around
+    /// @param radius streaming area radius (chunks)
+    /// @param bandwidth bytes per second, 0 - unlimited
+    void setClient(
+        u64id_t connection, int64_t player, int radius, size_t bandwidth
+    );
+
+    void removeClient(u64id_t connection);
+
+    /// @brief Send the chunk to the client without delta next time
+    /// (the client has lost or failed to apply it)
+    void forget(u64id_t connection, int x, int z);
+
+    /// @brief Send queued chunks for the elapsed time
+    void update(float delta);
+
+    size_t size() const {
+        return clients.size();
+    }
+
+    /// @brief Apply received chunk message to the loaded chunk
+    /// @param level client level
+    /// @param x[out] chunk x
+    /// @param z[out] chunk z
+    /// @return false if the chunk is not loaded or the delta can not be
+    /// applied (the chunk must be forgotten by the server)
+    /// @throws std::runtime_error - invalid message
+    static bool apply(
+        Level& level, const ubyte* data, size_t size, int& x, int& z
+    );
+};
@@ -42,7 +42,7 @@ void EngineController::deleteWorld(const std::string& name) {
     );
 }
 
-std::shared_ptr<Task> create_converter(
+static void show_converter(
     Engine* engine,
     const std::shared_ptr<WorldFiles>& worldFiles,
     const Content* content,
@@ -57,19 +57,32 @@ std::shared_ptr<Task> create_converter(
     } else {
         mode = ConvertMode::BLOCK_FIELDS;
     }
-    return WorldConverter::startTask(
-        worldFiles,
-        content,
-        report,
+    auto converter = std::make_shared<WorldConverter>(
+        worldFiles, content, report, mode
+    );
+    auto task = WorldConverter::startTask(
+        converter,
         [=]() {
             auto menu = engine->getGUI()->getMenu();
             menu->reset();
             menu->setPage("main", false);
             engine->getGUI()->postRunnable([=]() { postRunnable(); });
         },
-        mode,
         true
     );
+    menus::show_process_panel(
+        engine, task, L"Converting world...", [converter]() {
+            auto stats = converter->getStats();
+            return util::str2wstr_utf8(
+                       util::format_data_size(
+                           static_cast<size_t>(stats.bytesPerSecond())
+                       )
+                   ) +
+                   L"/s " +
+                   std::to_wstring(static_cast<int>(stats.chunksPerSecond())) +
+                   L" chunks/s";
+        }
+    );
 }
 
 void show_convert_request(
@@ -80,11 +93,7 @@ void show_convert_request(
     const runnable& postRunnable
 ) {
     auto on_confirm = [=]() {
-            auto converter =
-                create_converter(engine, worldFiles, content, report, postRunnable);
-            menus::show_process_panel(
-                engine, converter, L"Converting world..."
-            );
+            show_converter(engine, worldFiles, content, report, postRunnable);
         };
 
     std::wstring message = L"world.convert-block-layouts";
@@ -173,16 +182,12 @@ void EngineController::openWorld(const std::string& name, bool confirmConvert) {
             show_content_missing(engine, report);
         } else {
             if (confirmConvert) {
-                menus::show_process_panel(
+                show_converter(
                     engine,
-                    create_converter(
-                        engine,
-                        worldFiles,
-                        content,
-                        report,
-                        [=]() { openWorld(name, false); }
-                    ),
-                    L"Converting world..."
+                    worldFiles,
+                    content,
+                    report,
+                    [=]() { openWorld(name, false); }
                 );
             } else {
                 show_convert_request(engine, content, report, std::move(worldFiles), [=]() {
@@ -0,0 +1,297 @@
+#include "FluidsController.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+#include "content/Content.hpp"
+#include "debug/Profiler.hpp"
+#include "maths/voxmaths.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "voxels/voxel.hpp"
+#include "world/Level.hpp"
+
+/// @brief Simulation steps per second
+static constexpr int FLUIDS_TICK_RATE = 5;
+/// @brief Max active cells processed by a step, the rest of them are
+/// taken by the next steps
+static constexpr size_t MAX_STEP_CELLS = 32768;
+/// @brief Active cells per worker job
+static constexpr size_t FLUIDS_BATCH_SIZE = 4096;
+
+static const glm::ivec3 HORIZONTAL_SIDES[] {
+    {-1, 0, 0}, {1, 0, 0}, {0, 0, -1}, {0, 0, 1}
+};
+
+struct FluidsController::Job {
+    size_t index;
+    const glm::ivec3* cells;
+    size_t count;
+};
+
+struct FluidsController::Result {
+    size_t index;
+    std::vector<BlockEdit> edits;
+};
+
+/// @brief Get voxel without expanding chunk voxels (safe for workers),
+/// BLOCK_VOID if chunk is not loaded
+static voxel get_voxel(
+    const FluidsController::ChunkGetter& getChunk, const glm::ivec3& pos
+) {
+    if (pos.y < 0 || pos.y >= CHUNK_H) {
+        return {BLOCK_VOID, {}};
+    }
+    const Chunk* chunk =
+        getChunk(floordiv(pos.x, CHUNK_W), floordiv(pos.z, CHUNK_D));
+    if (chunk == nullptr) {
+        return {BLOCK_VOID, {}};
+    }
+    return chunk->voxels.get(vox_index(
+        pos.x - chunk->x * CHUNK_W, pos.y, pos.z - chunk->z * CHUNK_D
+    ));
+}
+
+/// @brief Fluid may flow into the block: replaceable non-fluid block or
+/// the same fluid farther from source than the distance
+static bool is_open(
+    const ContentIndices& indices, voxel vox, blockid_t id, uint distance
+) {
+    if (vox.id == BLOCK_VOID) {
+        return false;
+    }
+    if (vox.id == id) {
+        return vox.state.userbits > distance;
+    }
+    return !indices.blocksProps.fluid[vox.id] &&
+           indices.blocks.require(vox.id).replaceable;
+}
+
+/// @brief Fluid cell spreads horizontally if block below is neither
+/// replaceable nor the same fluid
+static bool is_spreading(
+    const FluidsController::ChunkGetter& getChunk,
+    const ContentIndices& indices,
+    const glm::ivec3& pos,
+    blockid_t id
+) {
+    voxel below = get_voxel(getChunk, pos + glm::ivec3(0, -1, 0));
+    return below.id != BLOCK_VOID && below.id != id &&
+           !is_open(indices, below, id, 0);
+}
+
+void FluidsController::solve(
+    const ContentIndices& indices,
+    const ChunkGetter& getChunk,
+    const glm::ivec3* cells,
+    size_t count,
+    std::vector<BlockEdit>& edits
+) {
+    auto get = [&getChunk](const glm::ivec3& pos) {
+        return get_voxel(getChunk, pos);
+    };
+    for (size_t i = 0; i < count; i++) {
+        const auto& pos = cells[i];
+        voxel vox = get(pos);
+        if (vox.id == BLOCK_VOID || !indices.blocksProps.fluid[vox.id]) {
+            continue;
+        }
+        blockid_t id = vox.id;
+        uint spread = indices.blocks.require(id).fluidSpread;
+        uint distance = vox.state.userbits;
+        if (distance > 0) {
+            uint supplied = spread + 1;
+            if (get(pos + glm::ivec3(0, 1, 0)).id == id) {
+                supplied = 1;
+            }
+            for (const auto& side : HORIZONTAL_SIDES) {
+                auto npos = pos + side;
+                voxel neighbour = get(npos);
+                if (neighbour.id == id &&
+                    neighbour.state.userbits + 1u < supplied &&
+                    is_spreading(getChunk, indices, npos, id)) {
+                    supplied = neighbour.state.userbits + 1;
+                }
+            }
+            if (supplied > spread) {
+                edits.push_back({pos, BLOCK_AIR, {}});
+                continue;
+            }
+            if (supplied != distance) {
+                blockstate state = vox.state;
+                state.userbits = supplied;
+                edits.push_back({pos, id, state});
+                distance = supplied;
+            }
+        }
+        auto below = pos + glm::ivec3(0, -1, 0);
+        voxel belowVox = get(below);
+        if (is_open(indices, belowVox, id, 1)) {
+            blockstate state {};
+            state.userbits = 1;
+            edits.push_back({below, id, state});
+            continue;
+        }
+        if (belowVox.id == id || belowVox.id == BLOCK_VOID ||
+            distance >= spread) {
+            continue;
+        }
+        for (const auto& side : HORIZONTAL_SIDES) {
+            auto npos = pos + side;
+            if (is_open(indices, get(npos), id, distance + 1)) {
+                blockstate state {};
+                state.userbits = distance + 1;
+                edits.push_back({npos, id, state});
+            }
+        }
+    }
+}
+
+/// @brief Chunks reading getter of the level
+static FluidsController::ChunkGetter chunks_getter(const Level& level) {
+    return [&chunks = *level.chunks](int32_t x, int32_t z) -> const Chunk* {
+        return chunks.getChunk(x, z);
+    };
+}
+
+class FluidsController::Worker
+    : public util::Worker<FluidsController::Job, FluidsController::Result> {
+    const ContentIndices& indices;
+    ChunkGetter getChunk;
+public:
+    Worker(const Level& level)
+        : indices(*level.content->getIndices()),
+          getChunk(chunks_getter(level)) {
+    }
+
+    Result operator()(const Job& job) override {
+        Result result {job.index, {}};
+        solve(indices, getChunk, job.cells, job.count, result.edits);
+        return result;
+    }
+};
+
+FluidsController::FluidsController(const Level& level, BlocksController& blocks)
+    : level(level), blocks(blocks), clock(FLUIDS_TICK_RATE, 1) {
+    if (util::TaskScheduler::getDefault().getThreadsCount() > 1) {
+        pool = std::make_unique<util::ThreadPool<Job, Result>>(
+            "fluids",
+            [this]() { return std::make_shared<Worker>(this->level); },
+            [this](Result& result) {
+                results.at(result.index) = std::move(result.edits);
+            },
+            util::ThreadPool<Job, Result>::HALF
+        );
+    }
+}
+
+FluidsController::~FluidsController() = default;
+
+void FluidsController::update(float delta) {
+    if (!level.content->getIndices()->blocksProps.fluids) {
+        return;
+    }
+    if (clock.update(delta)) {
+        step();
+    }
+}
+
+void FluidsController::collectCells() {
+    cells.clear();
+    const auto& matrix = level.chunks->getChunks();
+    size_t volume = matrix.size();
+    if (chunksOffset >= volume) {
+        chunksOffset = 0;
+    }
+    for (size_t i = 0; i < volume; i++) {
+        size_t index = (chunksOffset + i) % volume;
+        const auto& chunk = matrix[index];
+        if (chunk == nullptr || chunk->fluidCells.empty()) {
+            continue;
+        }
+        auto& active = chunk->fluidCells;
+        if (!cells.empty() && cells.size() + active.size() > MAX_STEP_CELLS) {
+            chunksOffset = index;
+            return;
+        }
+        std::sort(active.begin(), active.end());
+        active.erase(std::unique(active.begin(), active.end()), active.end());
+        for (uint vindex : active) {
+            int lx = vindex % CHUNK_W;
+            int lz = vindex / CHUNK_W % CHUNK_D;
+            int y = vindex / (CHUNK_W * CHUNK_D);
+            cells.emplace_back(
+                chunk->x * CHUNK_W + lx, y, chunk->z * CHUNK_D + lz
+            );
+        }
+        active.clear();
+    }
+}
+
+size_t FluidsController::step() {
+    debug::ProfileZone zone("fluids-step");
+    collectCells();
+    if (cells.empty()) {
+        return 0;
+    }
+    size_t batches = (cells.size() + FLUIDS_BATCH_SIZE - 1) / FLUIDS_BATCH_SIZE;
+    results.resize(batches);
+    for (auto& result : results) {
+        result.clear();
+    }
+    if (pool == nullptr || batches <= 1) {
+        solve(
+            *level.content->getIndices(),
+            chunks_getter(level),
+            cells.data(),
+            cells.size(),
+            results[0]
+        );
+    } else {
+        for (size_t i = 0; i < batches; i++) {
+            size_t offset = i * FLUIDS_BATCH_SIZE;
+            pool->enqueueJob(Job {
+                i,
+                cells.data() + offset,
+                std::min(FLUIDS_BATCH_SIZE, cells.size() - offset)});
+        }
+        pool->waitForJobs();
+    }
+
+    edits.clear();
+    for (const auto& result : results) {
+        edits.insert(edits.end(), result.begin(), result.end());
+    }
+    // conflicting changes of a block: fluid wins over air, then the nearest
+    // to source, then the lowest id, so results do not depend on order
+    auto rank = [](const BlockEdit& edit) {
+        return std::make_tuple(
+            edit.id == BLOCK_AIR,
+            static_cast<uint>(edit.state.userbits),
+            edit.id
+        );
+    };
+    std::sort(
+        edits.begin(),
+        edits.end(),
+        [&rank](const BlockEdit& a, const BlockEdit& b) {
+            if (a.pos.x != b.pos.x) return a.pos.x < b.pos.x;
+            if (a.pos.y != b.pos.y) return a.pos.y < b.pos.y;
+            if (a.pos.z != b.pos.z) return a.pos.z < b.pos.z;
+            return rank(a) < rank(b);
+        }
+    );
+    edits.erase(
+        std::unique(
+            edits.begin(),
+            edits.end(),
+            [](const BlockEdit& a, const BlockEdit& b) {
+                return a.pos == b.pos;
+            }
+        ),
+        edits.end()
+    );
+    blocks.setBlocks(edits);
+    return edits.size();
+}
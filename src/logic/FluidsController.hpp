@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "util/Clock.hpp"
+#include "util/ThreadPool.hpp"
+#include "BlocksController.hpp"
+
+class Level;
+class Chunk;
+class ContentIndices;
+
+/// @brief Cellular fluids simulation. Fluid blocks (see Block::fluidSpread)
+/// changed or having changed neighbours are collected by chunks as active
+/// cells (see Chunk::fluidCells). Every step takes the active cells,
+/// calculates fluid changes from the world state of the step start in
+/// batches (on worker threads for large flows) and applies all of them
+/// with a single BlocksController::setBlocks call, so lighting and meshes
+/// are updated in bulk. Applied changes activate cells of the next step.
+///
+/// Distance to the source is stored in the fluid state user bits:
+/// - a source (0) never changes;
+/// - a flowing cell takes the distance from its suppliers: falling (1)
+///   under any fluid cell of the same fluid, or the nearest horizontal
+///   neighbour distance + 1, and disappears without suppliers;
+/// - a cell falls into the replaceable block below, or spreads to
+///   the horizontal neighbours if the block below is not replaceable
+///   and its distance is less than the fluid spread distance.
+class FluidsController {
+    struct Job;
+    struct Result;
+    class Worker;
+
+    const Level& level;
+    BlocksController& blocks;
+    util::Clock clock;
+    std::unique_ptr<util::ThreadPool<Job, Result>> pool;
+    /// @brief Active cells of the step
+    std::vector<glm::ivec3> cells;
+    /// @brief Fluid changes by jobs
+    std::vector<std::vector<BlockEdit>> results;
+    std::vector<BlockEdit> edits;
+    /// @brief Chunks matrix index to start taking active cells from,
+    /// rotated when a step does not take all of them
+    size_t chunksOffset = 0;
+
+    void collectCells();
+public:
+    using ChunkGetter = std::function<const Chunk*(int32_t, int32_t)>;
+
+    FluidsController(const Level& level, BlocksController& blocks);
+    ~FluidsController();
+
+    void update(float delta);
+
+    /// @brief Perform simulation step
+    /// @return number of changed blocks
+    size_t step();
+
+    /// @brief Calculate fluid changes made by the active cells from the
+    /// world state. Only reads chunks, so it is safe for worker threads
+    /// @param getChunk chunk by its position, null if not loaded
+    /// @param edits destination changes, a block may be changed more
+    /// than once
+    static void solve(
+        const ContentIndices& indices,
+        const ChunkGetter& getChunk,
+        const glm::ivec3* cells,
+        size_t count,
+        std::vector<BlockEdit>& edits
+    );
+};
@@ -3,11 +3,17 @@
 #include <algorithm>
 
 #include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
+#include "debug/Profiler.hpp"
 #include "engine.hpp"
 #include "files/WorldFiles.hpp"
+#include "lighting/Lighting.hpp"
 #include "objects/Entities.hpp"
+#include "objects/Player.hpp"
+#include "objects/Players.hpp"
 #include "physics/Hitbox.hpp"
 #include "settings.hpp"
+#include "window/Camera.hpp"
 #include "world/Level.hpp"
 #include "world/World.hpp"
 #include "maths/voxmaths.hpp"
@@ -15,8 +21,25 @@
 
 static debug::Logger logger("level-control");
 
+/// @brief Milliseconds per update reserved for chunks loading while
+/// pre-generating an area
+inline constexpr int PREGENERATION_LOAD_SPEED = 40;
+/// @brief Min target frame time while pre-generating an area
+/// (microseconds): simulation is paused, so loading goes before framerate
+inline constexpr int64_t PREGENERATION_FRAME_TIME = 100'000;
+/// @brief Max chunks matrix span in load distances: players farther from
+/// the main one do not load chunks
+inline constexpr int MAX_INTEREST_SPAN = 4;
+/// @brief Max simulation ticks per update. Time of ticks beyond
+/// the limit is dropped, so slow frames slow the simulation down instead
+/// of piling up ticks
+inline constexpr int MAX_TICKS_PER_UPDATE = 4;
+/// @brief Tolerance of the accumulated time rounding errors (ticks)
+inline constexpr float TICK_EPSILON = 1e-3f;
+
 LevelController::LevelController(Engine* engine, std::unique_ptr<Level> levelPtr)
-    : settings(engine->getSettings()),
+    : engine(engine),
+      settings(engine->getSettings()),
       level(std::move(levelPtr)),
       blocks(std::make_unique<BlocksController>(
           *level, settings.chunks.padding.get()
@@ -24,41 +47,148 @@ LevelController::LevelController(Engine* engine, std::unique_ptr<Level> levelPtr
       chunks(std::make_unique<ChunksController>(
           *level, settings.chunks.padding.get()
       )),
+      fluids(std::make_unique<FluidsController>(*level, *blocks)),
       player(std::make_unique<PlayerController>(
         settings, level.get(), blocks.get()
+      )),
+      streamer(std::make_unique<ChunksStreamer>(
+          *level, engine->getNetwork()
       )) {
     scripting::on_world_load(this);
 }
 
 void LevelController::update(float delta, bool input, bool pause) {
-    glm::vec3 position = player->getPlayer()->getPosition();
-    level->loadMatrix(
-        position.x,
-        position.z,
-        settings.chunks.loadDistance.get() + settings.chunks.padding.get() * 2
-    );
+    debug::ProfileZone zone("level-update");
+    static auto& viewersGauge =
+        debug::Metrics::getInstance().gauge("chunks.viewers");
+    int loadDistance = settings.chunks.loadDistance.get();
+    int loadSpeed = settings.chunks.loadSpeed.get();
+    int64_t targetFrameTime = engine->getTargetFrameTime();
+    ChunksInterest interest(loadDistance * 2 * MAX_INTEREST_SPAN);
+    if (pregenerator) {
+        auto center = pregenerator->getLoadingCenter();
+        interest.addViewer(center.x, center.y, loadDistance);
+        loadSpeed = std::max(loadSpeed, PREGENERATION_LOAD_SPEED);
+        targetFrameTime = std::max(targetFrameTime, PREGENERATION_FRAME_TIME);
+        // player must not fall into not loaded area
+        pause = true;
+    } else {
+        auto addViewer = [&interest, loadDistance](const Player& viewer) {
+            const auto& position = viewer.getPosition();
+            const auto& front = viewer.currentCamera->front;
+            interest.addViewer(
+                floordiv(position.x, CHUNK_W),
+                floordiv(position.z, CHUNK_D),
+                loadDistance,
+                glm::vec2(front.x, front.z)
+            );
+        };
+        // the main player goes first
+        auto mainPlayer = player->getPlayer();
+        addViewer(*mainPlayer);
+        for (const auto& [_, viewer] : *level->players) {
+            if (viewer.get() != mainPlayer) {
+                addViewer(*viewer);
+            }
+        }
+    }
+    viewersGauge.set(interest.size());
+    glm::ivec2 center;
+    int size = interest.getMatrix(settings.chunks.padding.get(), center);
+    level->loadMatrix(center.x * CHUNK_W, center.y * CHUNK_D, size / 2);
+    chunks->setFrameTime(engine->getWorkTime(), targetFrameTime);
     chunks->update(
-        settings.chunks.loadSpeed.get(), settings.chunks.loadDistance.get(),
-        floordiv(position.x, CHUNK_W), floordiv(position.z, CHUNK_D)
+        loadSpeed,
+        loadDistance,
+        settings.chunks.compactDistance.get(),
+        static_cast<size_t>(settings.chunks.memoryBudget.get()) << 20,
+        interest
     );
+    streamer->update(delta);
+    if (pregenerator && pregenerator->update()) {
+        pregenerator.reset();
+        saveWorld(true);
+    }
 
+    player->readInput(input, pause);
     if (!pause) {
-        // update all objects that needed
-        blocks->update(delta);
-        player->update(delta, input, pause);
-        level->entities->updatePhysics(delta);
-        level->entities->update(delta);
+        uint rate = tickRate ? tickRate : settings.simulation.tickRate.get();
+        tickTimer += delta * rate;
+        int ticks = std::min(
+            static_cast<int>(tickTimer + TICK_EPSILON), MAX_TICKS_PER_UPDATE
+        );
+        tickTimer = std::clamp(tickTimer - ticks, 0.0f, 1.0f);
+        for (int i = 0; i < ticks; i++) {
+            tick(1.0f / rate);
+        }
+        level->entities->setInterpolation(tickTimer);
     }
     level->entities->clean();
     player->postUpdate(delta, input, pause);
+    level->lighting->flushUpdates();
+    updateAutosave(delta);
+}
+
+void LevelController::tick(float delta) {
+    blocks->update(delta);
+    fluids->update(delta);
+    player->update(delta);
+    level->entities->updatePhysics(delta);
+    level->entities->update(delta);
+}
+
+void LevelController::setTickRate(uint tickRate) {
+    this->tickRate = tickRate;
 }
 
-void LevelController::saveWorld() {
+void LevelController::updateAutosave(float delta) {
+    int interval = settings.chunks.autosaveInterval.get();
+    auto& regions = level->getWorld()->wfile->getRegions();
+    regions.setBackgroundWriting(interval > 0);
+    if (interval <= 0) {
+        autosaveTimer = 0.0f;
+        return;
+    }
+    autosaveTimer += delta;
+    if (autosaveTimer < interval || regions.isWriting()) {
+        return;
+    }
+    autosaveTimer = 0.0f;
+    saveWorld(true);
+}
+
+void LevelController::saveWorld(bool background) {
     level->getWorld()->wfile->createDirectories();
-    logger.info() << "writing world";
+    logger.info() << (background ? "writing world in background"
+                                 : "writing world");
     scripting::on_world_save();
+    level->lighting->flushUpdates();
     level->onSave();
-    level->getWorld()->write(level.get());
+    level->getWorld()->write(level.get(), background);
+}
+
+void LevelController::startPregeneration(
+    int centerX, int centerZ, int radius, bool circle
+) {
+    pregenerator = std::make_unique<WorldPregenerator>(
+        *level,
+        glm::ivec2(centerX, centerZ),
+        radius,
+        circle,
+        settings.chunks.loadDistance.get(),
+        settings.chunks.padding.get()
+    );
+}
+
+void LevelController::stopPregeneration() {
+    if (pregenerator) {
+        logger.info() << "pre-generation stopped";
+        pregenerator.reset();
+    }
+}
+
+const WorldPregenerator* LevelController::getPregenerator() const {
+    return pregenerator.get();
 }
 
 void LevelController::onWorldQuit() {
@@ -84,3 +214,7 @@ ChunksController* LevelController::getChunksController() {
 PlayerController* LevelController::getPlayerController() {
     return player.get();
 }
+
+ChunksStreamer* LevelController::getChunksStreamer() {
+    return streamer.get();
+}
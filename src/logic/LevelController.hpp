@@ -4,7 +4,11 @@
 
 #include "BlocksController.hpp"
 #include "ChunksController.hpp"
+#include "ChunksInterest.hpp"
+#include "ChunksStreamer.hpp"
+#include "FluidsController.hpp"
 #include "PlayerController.hpp"
+#include "WorldPregenerator.hpp"
 
 class Engine;
 class Level;
@@ -13,21 +17,60 @@ struct EngineSettings;
 
 /// @brief LevelController manages other controllers
 class LevelController {
+    Engine* engine;
     EngineSettings& settings;
     std::unique_ptr<Level> level;
     // Sub-controllers
     std::unique_ptr<BlocksController> blocks;
     std::unique_ptr<ChunksController> chunks;
+    std::unique_ptr<FluidsController> fluids;
     std::unique_ptr<PlayerController> player;
+    /// @brief Chunks replication to remote players
+    std::unique_ptr<ChunksStreamer> streamer;
+    /// @brief Active area pre-generation, null if not running
+    std::unique_ptr<WorldPregenerator> pregenerator;
+
+    /// @brief Time since the last autosave (seconds)
+    float autosaveTimer = 0.0f;
+    /// @brief Time elapsed since the last simulation tick (ticks)
+    float tickTimer = 0.0f;
+    /// @brief Simulation ticks per second, 0 - simulation.tick-rate setting
+    uint tickRate = 0;
+
+    void updateAutosave(float delta);
+    void tick(float delta);
 public:
     LevelController(Engine* engine, std::unique_ptr<Level> level);
 
+    /// @brief Update the level running simulation ticks of fixed duration
+    /// for the elapsed time. Rendered transforms are interpolated between
+    /// the last ticks by the remaining time
     /// @param delta time elapsed since the last update
     /// @param input is user input allowed to be handled
     /// @param pause is world and player simulation paused
     void update(float delta, bool input, bool pause);
 
-    void saveWorld();
+    /// @brief Override simulation ticks per second
+    /// @param tickRate ticks per second, 0 - use simulation.tick-rate setting
+    void setTickRate(uint tickRate);
+
+    /// @param background write world regions in the regions writer thread
+    void saveWorld(bool background = false);
+
+    /// @brief Start generating and saving an area. Chunks are loaded
+    /// around the area windows instead of the player and the world
+    /// simulation is paused until the area is complete. Replaces the
+    /// running pre-generation
+    /// @param centerX area center X in chunks
+    /// @param centerZ area center Z in chunks
+    /// @param radius area radius in chunks
+    /// @param circle generate circle area instead of square
+    void startPregeneration(int centerX, int centerZ, int radius, bool circle);
+
+    void stopPregeneration();
+
+    /// @return running pre-generation or nullptr
+    const WorldPregenerator* getPregenerator() const;
 
     void onWorldQuit();
 
@@ -37,4 +80,5 @@ public:
     BlocksController* getBlocksController();
     ChunksController* getChunksController();
     PlayerController* getPlayerController();
+    ChunksStreamer* getChunksStreamer();
 };
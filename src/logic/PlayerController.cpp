@@ -50,7 +50,7 @@ CameraControl::CameraControl(
 }
 
 void CameraControl::refresh() {
-    camera->position = player->getPosition() + offset;
+    camera->position = player->getInterpolatedPosition() + offset;
 }
 
 void CameraControl::updateMouse(PlayerInput& input) {
@@ -242,21 +242,28 @@ void PlayerController::updateFootsteps(float delta) {
     }
 }
 
-void PlayerController::update(float delta, bool input, bool pause) {
-    if (!pause) {
-        if (input) {
-            updateKeyboard();
-            player->updateSelectedEntity();
-        } else {
-            resetKeyboard();
-        }
-        updatePlayer(delta);
+void PlayerController::readInput(bool input, bool pause) {
+    if (pause) {
+        return;
+    }
+    if (input) {
+        updateKeyboard();
+        player->updateSelectedEntity();
+    } else {
+        resetKeyboard();
+    }
+}
 
-        if (playerTickClock.update(delta)) {
-            if (player->getId() % playerTickClock.getParts() ==
-                playerTickClock.getPart()) {
-                scripting::on_player_tick(player, playerTickClock.getTickRate());
-            }
+void PlayerController::update(float delta) {
+    updatePlayer(delta);
+    // toggles are applied by the first tick after the key press
+    input.noclip = false;
+    input.flight = false;
+
+    if (playerTickClock.update(delta)) {
+        if (player->getId() % playerTickClock.getParts() ==
+            playerTickClock.getPart()) {
+            scripting::on_player_tick(player, playerTickClock.getTickRate());
         }
     }
 }
@@ -289,8 +296,9 @@ void PlayerController::updateKeyboard() {
     input.jump = Events::active(BIND_MOVE_JUMP);
     input.zoom = Events::active(BIND_CAM_ZOOM);
     input.cameraMode = Events::jactive(BIND_CAM_MODE);
-    input.noclip = Events::jactive(BIND_PLAYER_NOCLIP);
-    input.flight = Events::jactive(BIND_PLAYER_FLIGHT);
+    // kept until handled by a simulation tick
+    input.noclip |= Events::jactive(BIND_PLAYER_NOCLIP);
+    input.flight |= Events::jactive(BIND_PLAYER_FLIGHT);
 }
 
 void PlayerController::resetKeyboard() {
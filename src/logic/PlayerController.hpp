@@ -73,7 +73,11 @@ public:
     PlayerController(
         const EngineSettings& settings, Level* level, BlocksController* blocksController
     );
-    void update(float delta, bool input, bool pause);
+    /// @brief Read player input, called every frame before simulation ticks
+    /// @param input is user input allowed to be handled
+    void readInput(bool input, bool pause);
+    /// @brief Simulate the player for a tick
+    void update(float delta);
     void postUpdate(float delta, bool input, bool pause);
     Player* getPlayer();
 };
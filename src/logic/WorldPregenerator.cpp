@@ -0,0 +1,147 @@
+#include "WorldPregenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "debug/Logger.hpp"
+#include "files/WorldFiles.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "world/Level.hpp"
+#include "world/World.hpp"
+
+static debug::Logger logger("world-pregen");
+
+/// @brief Progress is logged every REPORT_PERCENTS percents
+inline constexpr int REPORT_PERCENTS = 5;
+
+/// @brief Get side of the square window fitting the lighted area.
+/// Chunks are loaded in a circle of the load distance radius, chunks at
+/// the loaded area border (2 chunks) are not lighted and window corners
+/// must be inside with a chunk margin
+static int calc_window_size(int loadDistance) {
+    int lightedRadius = loadDistance - 3;
+    return std::max(1, static_cast<int>(lightedRadius * std::sqrt(2.0f)));
+}
+
+WorldPregenerator::WorldPregenerator(
+    Level& level,
+    glm::ivec2 center,
+    int radius,
+    bool circle,
+    int loadDistance,
+    int padding
+)
+    : level(level),
+      center(center),
+      radius(std::max(0, radius)),
+      circle(circle),
+      windowSize(calc_window_size(loadDistance)),
+      keepDistance(loadDistance + padding * 2),
+      startTime(std::chrono::steady_clock::now()) {
+    int diameter = this->radius * 2 + 1;
+    int count = (diameter + windowSize - 1) / windowSize;
+    glm::ivec2 start = center - this->radius + windowSize / 2;
+    for (int wz = 0; wz < count; wz++) {
+        for (int i = 0; i < count; i++) {
+            // snake order: the next window is always a neighbour
+            int wx = wz % 2 ? count - i - 1 : i;
+            glm::ivec2 window = start + glm::ivec2(wx, wz) * windowSize;
+            // window point nearest to the center must be inside
+            glm::ivec2 min = window - windowSize / 2;
+            glm::ivec2 nearest =
+                glm::clamp(center, min, min + windowSize - 1);
+            if (isInside(nearest.x, nearest.y)) {
+                windows.push_back(window);
+            }
+        }
+    }
+    for (int z = -this->radius; z <= this->radius; z++) {
+        for (int x = -this->radius; x <= this->radius; x++) {
+            total += isInside(center.x + x, center.y + z);
+        }
+    }
+    logger.info() << "pre-generating " << total << " chunks around "
+                  << center.x << ", " << center.y << " in "
+                  << windows.size() << " windows";
+}
+
+bool WorldPregenerator::isInside(int x, int z) const {
+    int dx = x - center.x;
+    int dz = z - center.y;
+    if (std::abs(dx) > radius || std::abs(dz) > radius) {
+        return false;
+    }
+    return !circle || dx * dx + dz * dz <= radius * radius;
+}
+
+uint WorldPregenerator::countWindowChunks(bool lighted) const {
+    const auto& window = windows[windowIndex];
+    int half = windowSize / 2;
+    uint count = 0;
+    for (int z = window.y - half; z < window.y - half + windowSize; z++) {
+        for (int x = window.x - half; x < window.x - half + windowSize; x++) {
+            if (!isInside(x, z)) {
+                continue;
+            }
+            if (!lighted) {
+                count++;
+                continue;
+            }
+            auto chunk = level.chunks->getChunk(x, z);
+            if (chunk && chunk->flags.lighted) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+bool WorldPregenerator::update() {
+    if (windowIndex >= windows.size()) {
+        return true;
+    }
+    auto& regions = level.getWorld()->wfile->getRegions();
+    const auto& window = windows[windowIndex];
+    // write-behind: regions left behind are written and unloaded
+    regions.evictRegion(window.x, window.y, keepDistance);
+
+    windowDone = countWindowChunks(true);
+    if (windowDone < countWindowChunks(false)) {
+        return false;
+    }
+    done += windowDone;
+    windowDone = 0;
+    windowIndex++;
+
+    int percent = total ? done * 100 / total : 100;
+    if (percent / REPORT_PERCENTS > reportedPercent / REPORT_PERCENTS ||
+        windowIndex == windows.size()) {
+        reportedPercent = percent;
+        auto progress = getProgress();
+        logger.info() << "pre-generated " << progress.done << "/"
+                      << progress.total << " chunks (" << percent
+                      << "%), " << progress.elapsed / 1000 << " s elapsed, "
+                      << progress.eta / 1000 << " s left";
+    }
+    return windowIndex >= windows.size();
+}
+
+glm::ivec2 WorldPregenerator::getLoadingCenter() const {
+    if (windows.empty()) {
+        return center;
+    }
+    return windows[std::min(windowIndex, windows.size() - 1)];
+}
+
+WorldPregenerator::Progress WorldPregenerator::getProgress() const {
+    using namespace std::chrono;
+    int64_t elapsed =
+        duration_cast<milliseconds>(steady_clock::now() - startTime).count();
+    uint complete = std::min(total, done + windowDone);
+    int64_t eta = -1;
+    if (complete > 0) {
+        eta = elapsed * (total - complete) / complete;
+    }
+    return Progress {complete, total, elapsed, eta};
+}
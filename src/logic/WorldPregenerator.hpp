@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+
+class Level;
+
+/// @brief Generates and lights a world area before players visit it.
+/// The chunks loading center is moved over the area window by window,
+/// chunks leaving the loading area are saved to regions and far regions
+/// are written and unloaded, so memory usage is bounded by the loading
+/// area size
+class WorldPregenerator {
+public:
+    struct Progress {
+        /// @brief Number of completed chunks
+        uint done;
+        /// @brief Number of area chunks
+        uint total;
+        /// @brief Time elapsed since the start in milliseconds
+        int64_t elapsed;
+        /// @brief Estimated time left in milliseconds (-1 if unknown)
+        int64_t eta;
+    };
+private:
+    Level& level;
+    glm::ivec2 center;
+    int radius;
+    bool circle;
+    /// @brief Windows centers in chunks, neighbour windows follow each
+    /// other so chunks at the windows border stay loaded
+    std::vector<glm::ivec2> windows;
+    size_t windowIndex = 0;
+    int windowSize;
+    int keepDistance;
+    uint total = 0;
+    /// @brief Chunks of completed windows
+    uint done = 0;
+    /// @brief Lighted chunks of the current window
+    uint windowDone = 0;
+    int reportedPercent = 0;
+    std::chrono::steady_clock::time_point startTime;
+
+    bool isInside(int x, int z) const;
+    /// @brief Count area chunks of the current window
+    /// @param lighted count lighted chunks only
+    uint countWindowChunks(bool lighted) const;
+public:
+    /// @param level target level
+    /// @param center area center in chunks
+    /// @param radius area radius in chunks
+    /// @param circle generate circle area instead of square
+    /// @param loadDistance chunks loading distance used while generating
+    /// @param padding chunks matrix padding
+    WorldPregenerator(
+        Level& level,
+        glm::ivec2 center,
+        int radius,
+        bool circle,
+        int loadDistance,
+        int padding
+    );
+
+    /// @brief Check the current window and move to the next one if it
+    /// is complete. Call after chunks update
+    /// @return true if the whole area is complete
+    bool update();
+
+    /// @return chunks loading center in chunks
+    glm::ivec2 getLoadingCenter() const;
+
+    Progress getProgress() const;
+};
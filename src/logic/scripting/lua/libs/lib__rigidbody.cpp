@@ -39,6 +39,7 @@ static int l_get_size(lua::State* L) {
 static int l_set_size(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
         entity->getRigidbody().hitbox.halfsize = lua::tovec3(L, 2) * 0.5f;
+        entity->getRigidbody().wakeUp();
     }
     return 0;
 }
@@ -53,6 +54,7 @@ static int l_get_gravity_scale(lua::State* L) {
 static int l_set_gravity_scale(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
         entity->getRigidbody().hitbox.gravityScale = lua::tonumber(L, 2);
+        entity->getRigidbody().wakeUp();
     }
     return 0;
 }
@@ -107,6 +109,7 @@ static int l_set_body_type(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
         if (auto type = BodyType_from(lua::tostring(L, 2))) {
             entity->getRigidbody().hitbox.type = *type;
+            entity->getRigidbody().wakeUp();
         } else {
             throw std::runtime_error(
                 "unknown body type " + util::quote(lua::tostring(L, 2))
@@ -55,6 +55,7 @@ static int l_set_matrix(lua::State* L) {
         auto& skeleton = entity->getSkeleton();
         auto index = index_range_check(skeleton, lua::tointeger(L, 2));
         skeleton.pose.matrices[index] = lua::tomat4(L, 3);
+        skeleton.poseDirty = true;
     }
     return 0;
 }
@@ -98,13 +98,51 @@ static int l_set(lua::State* L) {
         return 0;
     }
     level->chunks->set(x, y, z, id, int2blockstate(state));
-    level->lighting->onBlockSet(x, y, z, id);
+    level->lighting->queueBlockSet({x, y, z});
     if (!noupdate) {
         blocks->updateSides(x, y, z);
     }
     return 0;
 }
 
+static int l_set_many(lua::State* L) {
+    if (!lua::istable(L, 1)) {
+        throw std::runtime_error("table expected");
+    }
+    bool noupdate = lua::toboolean(L, 2);
+    size_t count = lua::objlen(L, 1);
+    std::vector<BlockEdit> edits;
+    edits.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        lua::rawgeti(L, i + 1, 1);
+        if (!lua::istable(L, -1) || lua::objlen(L, -1) < 4) {
+            throw std::runtime_error(
+                "expected {x, y, z, id, [states]} at index " +
+                std::to_string(i + 1)
+            );
+        }
+        lua::Integer values[5] {};
+        for (int j = 0; j < 5; j++) {
+            lua::rawgeti(L, j + 1);
+            if (!lua::isnil(L, -1)) {
+                values[j] = lua::tointeger(L, -1);
+            }
+            lua::pop(L);
+        }
+        lua::pop(L);
+        if (static_cast<size_t>(values[3]) >= indices->blocks.count()) {
+            continue;
+        }
+        edits.push_back(BlockEdit {
+            glm::ivec3(values[0], values[1], values[2]),
+            static_cast<blockid_t>(values[3]),
+            int2blockstate(values[4])
+        });
+    }
+    blocks->setBlocks(edits, noupdate);
+    return 0;
+}
+
 static int l_get(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
@@ -204,7 +242,9 @@ static int l_set_states(lua::State* L) {
     }
     auto vox = level->chunks->get(x, y, z);
     vox->state = int2blockstate(states);
-    chunk->setModifiedAndUnsaved();
+    chunk->resetUniformSection(y);
+    chunk->setModifiedAndUnsaved(y);
+    level->chunks->onBlockChanged(x, y, z);
     return 0;
 }
 
@@ -258,9 +298,15 @@ static int l_set_user_bits(lua::State* L) {
         if (vox == nullptr) {
             return 0;
         }
+        chunk = level->chunks->getChunkByVoxel(origin.x, origin.y, origin.z);
+        x = origin.x;
+        y = origin.y;
+        z = origin.z;
     }
     vox->state.userbits = (vox->state.userbits & (~mask)) | value;
-    chunk->setModifiedAndUnsaved();
+    chunk->resetUniformSection(y);
+    chunk->setModifiedAndUnsaved(y);
+    level->chunks->onBlockChanged(x, y, z);
     return 0;
 }
 
@@ -373,16 +419,27 @@ static int l_destruct(lua::State* L) {
     return 0;
 }
 
-static int l_raycast(lua::State* L) {
-    auto start = lua::tovec<3>(L, 1);
-    auto dir = lua::tovec<3>(L, 2);
-    auto maxDistance = lua::tonumber(L, 3);
+static int l_schedule_update(lua::State* L) {
+    auto x = lua::tointeger(L, 1);
+    auto y = lua::tointeger(L, 2);
+    auto z = lua::tointeger(L, 3);
+    auto delay = lua::tointeger(L, 4);
+    if (delay < 1) {
+        throw std::runtime_error("delay must be positive");
+    }
+    return lua::pushboolean(
+        L, controller->getBlocksController()->scheduleUpdate(x, y, z, delay)
+    );
+}
+
+/// @brief Read raycast filter (table of block names) if present
+static std::set<blockid_t> read_raycast_filter(lua::State* L, int idx) {
     std::set<blockid_t> filteredBlocks {};
-    if (lua::gettop(L) >= 5) {
-        if (lua::istable(L, 5)) {
-            int addLen = lua::objlen(L, 5);
+    if (lua::gettop(L) >= idx && !lua::isnil(L, idx)) {
+        if (lua::istable(L, idx)) {
+            int addLen = lua::objlen(L, idx);
             for (int i = 0; i < addLen; i++) {
-                lua::rawgeti(L, i + 1, 5);
+                lua::rawgeti(L, i + 1, idx);
                 auto blockName = std::string(lua::tostring(L, -1));
                 const Block* block = content->blocks.find(blockName);
                 if (block != nullptr) {
@@ -394,6 +451,14 @@ static int l_raycast(lua::State* L) {
             throw std::runtime_error("table expected for filter");
         }
     }
+    return filteredBlocks;
+}
+
+static int l_raycast(lua::State* L) {
+    auto start = lua::tovec<3>(L, 1);
+    auto dir = lua::tovec<3>(L, 2);
+    auto maxDistance = lua::tonumber(L, 3);
+    auto filteredBlocks = read_raycast_filter(L, 5);
     glm::vec3 end;
     glm::ivec3 normal;
     glm::ivec3 iend;
@@ -425,6 +490,68 @@ static int l_raycast(lua::State* L) {
     return 0;
 }
 
+/// @brief Number of values per ray in raycast_batch results
+static constexpr int RAYCAST_HIT_STRIDE = 11;
+
+static int l_raycast_batch(lua::State* L) {
+    if (!lua::istable(L, 1)) {
+        throw std::runtime_error("table expected for rays");
+    }
+    auto maxDistance = lua::tonumber(L, 2);
+    auto filteredBlocks = read_raycast_filter(L, 4);
+
+    static std::vector<RayCastQuery> rays;
+    static std::vector<RayCastHit> hits;
+    size_t count = lua::objlen(L, 1) / 6;
+    rays.resize(count);
+    hits.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        float values[6];
+        for (int j = 0; j < 6; j++) {
+            lua::rawgeti(L, i * 6 + j + 1, 1);
+            values[j] = lua::tonumber(L, -1);
+            lua::pop(L);
+        }
+        rays[i] = RayCastQuery {
+            {values[0], values[1], values[2]},
+            {values[3], values[4], values[5]},
+            static_cast<float>(maxDistance)};
+    }
+    level->chunks->rayCast(rays.data(), hits.data(), count, filteredBlocks);
+
+    size_t size = count * RAYCAST_HIT_STRIDE;
+    if (lua::istable(L, 3)) {
+        lua::pushvalue(L, 3);
+        size_t prevSize = lua::objlen(L, -1);
+        for (size_t i = size; i < prevSize; i++) {
+            lua::pushnil(L);
+            lua::rawseti(L, i + 1);
+        }
+    } else {
+        lua::createtable(L, size, 0);
+    }
+    for (size_t i = 0; i < count; i++) {
+        const auto& hit = hits[i];
+        // missed ray: block is -1, the other values are 0
+        double values[RAYCAST_HIT_STRIDE] {};
+        values[0] = -1;
+        if (hit.hit) {
+            values[0] = hit.block;
+            values[1] = glm::distance(rays[i].start, hit.end);
+            for (int j = 0; j < 3; j++) {
+                values[2 + j] = hit.end[j];
+                values[5 + j] = hit.norm[j];
+                values[8 + j] = hit.iend[j];
+            }
+        }
+        for (int j = 0; j < RAYCAST_HIT_STRIDE; j++) {
+            lua::pushnumber(L, values[j]);
+            lua::rawseti(L, i * RAYCAST_HIT_STRIDE + j + 1);
+        }
+    }
+    return 1;
+}
+
 static int l_compose_state(lua::State* L) {
     if (!lua::istable(L, 1) || lua::objlen(L, 1) < 3) {
         throw std::runtime_error("expected array of 3 integers");
@@ -597,6 +724,7 @@ const luaL_Reg blocklib[] = {
     {"is_solid_at", lua::wrap<l_is_solid_at>},
     {"is_replaceable_at", lua::wrap<l_is_replaceable_at>},
     {"set", lua::wrap<l_set>},
+    {"set_many", lua::wrap<l_set_many>},
     {"get", lua::wrap<l_get>},
     {"get_X", lua::wrap<l_get_x>},
     {"get_Y", lua::wrap<l_get_y>},
@@ -618,7 +746,9 @@ const luaL_Reg blocklib[] = {
     {"get_picking_item", lua::wrap<l_get_picking_item>},
     {"place", lua::wrap<l_place>},
     {"destruct", lua::wrap<l_destruct>},
+    {"schedule_update", lua::wrap<l_schedule_update>},
     {"raycast", lua::wrap<l_raycast>},
+    {"raycast_batch", lua::wrap<l_raycast_batch>},
     {"compose_state", lua::wrap<l_compose_state>},
     {"decompose_state", lua::wrap<l_decompose_state>},
     {"get_field", lua::wrap<l_get_field>},
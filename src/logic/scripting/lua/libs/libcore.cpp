@@ -6,6 +6,8 @@
 #include "constants.hpp"
 #include "content/Content.hpp"
 #include "debug/Logger.hpp"
+#include "debug/MemoryUsage.hpp"
+#include "debug/Metrics.hpp"
 #include "engine.hpp"
 #include "files/engine_paths.hpp"
 #include "files/files.hpp"
@@ -15,9 +17,9 @@
 #include "graphics/core/Texture.hpp"
 #include "logic/EngineController.hpp"
 #include "logic/LevelController.hpp"
+#include "logic/scripting/lua/lua_timings.hpp"
 #include "util/listutil.hpp"
 #include "window/Events.hpp"
-#include "window/Window.hpp"
 #include "world/Level.hpp"
 #include "world/generator/WorldGenerator.hpp"
 
@@ -233,7 +235,78 @@ static int l_open_folder(lua::State* L) {
 
 /// @brief Quit the game
 static int l_quit(lua::State*) {
-    Window::setShouldClose(true);
+    engine->quit();
+    return 0;
+}
+
+/// @brief Save screenshot of the next frame. The optional callback gets
+/// the screenshot path or nil and error message in the main thread
+static int l_screenshot(lua::State* L) {
+    if (engine->isHeadless()) {
+        throw std::runtime_error(
+            "screenshots are not available in headless mode"
+        );
+    }
+    if (lua::isnoneornil(L, 1)) {
+        engine->saveScreenshot();
+        return 0;
+    }
+    lua::pushvalue(L, 1);
+    auto callback = lua::create_lambda_nothrow(L);
+    engine->saveScreenshot(
+        [callback](const fs::path& file, const std::string& error) mutable {
+            if (error.empty()) {
+                callback({"user:screenshots/" + file.filename().u8string()});
+            } else {
+                callback({nullptr, error});
+            }
+        }
+    );
+    return 0;
+}
+
+/// @brief Get engine metrics snapshot
+/// @return A table with 'counters', 'gauges' and 'histograms' tables
+static int l_get_metrics(lua::State* L) {
+    return lua::pushvalue(L, debug::Metrics::getInstance().toValue());
+}
+
+/// @brief Get memory usage of the engine subsystems
+/// @return A table of bytes by tag ('chunks.voxels', 'lua.heap', etc.)
+static int l_get_memory_usage(lua::State* L) {
+    return lua::pushvalue(L, debug::MemoryUsage::getInstance().toValue());
+}
+
+/// @brief Get timings of the slowest event handlers
+/// @param count max number of handlers (10 by default)
+/// @return array of tables: {name, calls, total, max, slow_calls, skipped},
+/// time in milliseconds
+static int l_get_handler_timings(lua::State* L) {
+    auto count = lua::isnoneornil(L, 1) ? 10 : lua::tointeger(L, 1);
+    auto timings = lua::get_slowest_handlers(std::max<int64_t>(count, 0));
+    lua::createtable(L, timings.size(), 0);
+    for (size_t i = 0; i < timings.size(); i++) {
+        const auto& timing = timings[i];
+        lua::createtable(L, 0, 6);
+        lua::pushstring(L, timing.name);
+        lua::setfield(L, "name");
+        lua::pushinteger(L, timing.calls);
+        lua::setfield(L, "calls");
+        lua::pushnumber(L, timing.total / 1000.0);
+        lua::setfield(L, "total");
+        lua::pushnumber(L, timing.max / 1000.0);
+        lua::setfield(L, "max");
+        lua::pushinteger(L, timing.slowCalls);
+        lua::setfield(L, "slow_calls");
+        lua::pushinteger(L, timing.skipped);
+        lua::setfield(L, "skipped");
+        lua::rawseti(L, i + 1);
+    }
+    return 1;
+}
+
+static int l_reset_handler_timings(lua::State*) {
+    lua::reset_handler_timings();
     return 0;
 }
 
@@ -251,6 +324,11 @@ const luaL_Reg corelib[] = {
     {"get_setting_info", lua::wrap<l_get_setting_info>},
     {"open_folder", lua::wrap<l_open_folder>},
     {"quit", lua::wrap<l_quit>},
+    {"screenshot", lua::wrap<l_screenshot>},
+    {"get_metrics", lua::wrap<l_get_metrics>},
+    {"get_memory_usage", lua::wrap<l_get_memory_usage>},
+    {"get_handler_timings", lua::wrap<l_get_handler_timings>},
+    {"reset_handler_timings", lua::wrap<l_reset_handler_timings>},
     {"__load_texture", lua::wrap<l_load_texture>},
     {NULL, NULL}
 };
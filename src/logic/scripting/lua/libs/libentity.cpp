@@ -94,30 +94,44 @@ static int l_set_skeleton(lua::State* L) {
     return 0;
 }
 
-static int l_get_all_in_box(lua::State* L) {
-    auto pos = lua::tovec<3>(L, 1);
-    auto size = lua::tovec<3>(L, 2);
-    auto found = level->entities->getAllInside(AABB(pos, pos + size));
-    lua::createtable(L, found.size(), 0);
-    for (size_t i = 0; i < found.size(); i++) {
-        const auto& entity = found[i];
-        lua::pushinteger(L, entity.getUID());
+/// @brief Push UIDs list as a new table or write it to the table at dstIdx
+/// (if present) clearing the rest of its array part
+static int push_uids(
+    lua::State* L, const std::vector<entityid_t>& uids, int dstIdx
+) {
+    if (lua::istable(L, dstIdx)) {
+        lua::pushvalue(L, dstIdx);
+        size_t prevSize = lua::objlen(L, -1);
+        for (size_t i = uids.size(); i < prevSize; i++) {
+            lua::pushnil(L);
+            lua::rawseti(L, i + 1);
+        }
+    } else {
+        lua::createtable(L, uids.size(), 0);
+    }
+    for (size_t i = 0; i < uids.size(); i++) {
+        lua::pushinteger(L, uids[i]);
         lua::rawseti(L, i + 1);
     }
     return 1;
 }
 
+static int l_get_all_in_box(lua::State* L) {
+    static std::vector<entityid_t> found;
+    auto pos = lua::tovec<3>(L, 1);
+    auto size = lua::tovec<3>(L, 2);
+    found.clear();
+    level->entities->getAllInside(AABB(pos, pos + size), found);
+    return push_uids(L, found, 3);
+}
+
 static int l_get_all_in_radius(lua::State* L) {
+    static std::vector<entityid_t> found;
     auto pos = lua::tovec<3>(L, 1);
     auto radius = lua::tonumber(L, 2);
-    auto found = level->entities->getAllInRadius(pos, radius);
-    lua::createtable(L, found.size(), 0);
-    for (size_t i = 0; i < found.size(); i++) {
-        const auto& entity = found[i];
-        lua::pushinteger(L, entity.getUID());
-        lua::rawseti(L, i + 1);
-    }
-    return 1;
+    found.clear();
+    level->entities->getAllInRadius(pos, radius, found);
+    return push_uids(L, found, 3);
 }
 
 static int l_raycast(lua::State* L) {
@@ -7,6 +7,7 @@
 #include "files/engine_paths.hpp"
 #include "files/files.hpp"
 #include "util/stringutil.hpp"
+#include "util/TaskScheduler.hpp"
 #include "api_lua.hpp"
 #include "../lua_engine.hpp"
 
@@ -128,6 +129,51 @@ static int l_mkdirs(lua::State* L) {
     return lua::pushboolean(L, fs::create_directories(path));
 }
 
+/// @brief Read file in a worker thread passing the content or nil and
+/// error message to the callback in the main thread
+/// @param binary pass Bytearray instead of string
+static int read_async(lua::State* L, bool binary) {
+    fs::path path = resolve_path(lua::require_string(L, 1));
+    lua::pushvalue(L, 2);
+    auto callback = lua::create_lambda_nothrow(L);
+    util::TaskScheduler::getDefault().submit(
+        [path, callback, binary]() mutable {
+            std::vector<dv::value> args;
+            try {
+                auto bytes = files::read_bytes(path);
+                if (binary) {
+                    args.emplace_back(std::make_shared<util::Buffer<ubyte>>(
+                        bytes.data(), bytes.size()
+                    ));
+                } else {
+                    args.emplace_back(std::string(
+                        reinterpret_cast<const char*>(bytes.data()),
+                        bytes.size()
+                    ));
+                }
+            } catch (const std::exception& err) {
+                args = {nullptr, std::string(err.what())};
+            }
+            // the callback must be released in the main thread
+            engine->postRunnable(
+                [callback = std::move(callback), args = std::move(args)]() {
+                    callback(args);
+                }
+            );
+        },
+        util::TaskScheduler::Priority::NORMAL
+    );
+    return 0;
+}
+
+static int l_read_async(lua::State* L) {
+    return read_async(L, false);
+}
+
+static int l_read_bytes_async(lua::State* L) {
+    return read_async(L, true);
+}
+
 static int l_read_bytes(lua::State* L) {
     fs::path path = resolve_path(lua::require_string(L, 1));
     if (fs::is_regular_file(path)) {
@@ -254,6 +300,8 @@ const luaL_Reg filelib[] = {
     {"mkdirs", lua::wrap<l_mkdirs>},
     {"read_bytes", lua::wrap<l_read_bytes>},
     {"read", lua::wrap<l_read>},
+    {"__read_async", lua::wrap<l_read_async>},
+    {"__read_bytes_async", lua::wrap<l_read_bytes_async>},
     {"remove", lua::wrap<l_remove>},
     {"remove_tree", lua::wrap<l_remove_tree>},
     {"resolve", lua::wrap<l_resolve>},
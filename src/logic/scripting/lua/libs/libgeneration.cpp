@@ -5,7 +5,11 @@
 #include "coders/binary_json.hpp"
 #include "world/Level.hpp"
 #include "world/generator/VoxelFragment.hpp"
+#include "world/generator/GeneratorBenchmark.hpp"
+#include "world/generator/GeneratorDef.hpp"
+#include "content/Content.hpp"
 #include "content/ContentLoader.hpp"
+#include "util/stringutil.hpp"
 #include "engine.hpp"
 #include "../lua_custom_types.hpp"
 
@@ -77,10 +81,58 @@ static int l_get_default_generator(lua::State* L) {
     return lua::pushstring(L, combined["generator"].asString());
 }
 
+/// @brief Benchmark a world generator of the current content
+/// @param name generator name
+/// @param seed world seed
+/// @param size area size in chunks
+/// @return A table with timings in milliseconds, output hash and
+/// number of chunks generated differently in the second pass
+static int l_benchmark(lua::State* L) {
+    auto name = lua::require_string(L, 1);
+    auto seed = lua::tointeger(L, 2);
+    auto size = lua::tointeger(L, 3);
+    if (content == nullptr) {
+        throw std::runtime_error("content is not loaded");
+    }
+    const auto& def = content->generators.require(name);
+    auto result = benchmark_generator(def, *content, seed, size);
+
+    static const char* stageNames[] {
+        nullptr, "wide_structs", "biomes", "heightmap", "structures"};
+
+    lua::createtable(L, 0, 10);
+    lua::pushinteger(L, result.chunks);
+    lua::setfield(L, "chunks");
+    lua::pushnumber(L, result.time / 1000.0);
+    lua::setfield(L, "time");
+    lua::pushnumber(L, result.chunks / (result.time / 1e6));
+    lua::setfield(L, "chunks_per_second");
+
+    lua::createtable(L, 0, 4);
+    for (size_t i = 1; i < result.stages.size(); i++) {
+        lua::pushnumber(L, result.stages[i] / 1000.0);
+        lua::setfield(L, stageNames[i]);
+    }
+    lua::setfield(L, "stages");
+
+    lua::pushnumber(L, result.land / 1000.0);
+    lua::setfield(L, "land");
+    lua::pushnumber(L, result.placements / 1000.0);
+    lua::setfield(L, "placements");
+    lua::pushnumber(L, result.plants / 1000.0);
+    lua::setfield(L, "plants");
+    lua::pushstring(L, util::tohex(result.hash));
+    lua::setfield(L, "hash");
+    lua::pushinteger(L, result.mismatches);
+    lua::setfield(L, "mismatches");
+    return 1;
+}
+
 const luaL_Reg generationlib[] = {
     {"create_fragment", lua::wrap<l_create_fragment>},
     {"save_fragment", lua::wrap<l_save_fragment>},
     {"load_fragment", lua::wrap<l_load_fragment>},
     {"get_generators", lua::wrap<l_get_generators>},
     {"get_default_generator", lua::wrap<l_get_default_generator>},
+    {"benchmark", lua::wrap<l_benchmark>},
     {NULL, NULL}};
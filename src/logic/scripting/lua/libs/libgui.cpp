@@ -510,9 +510,9 @@ static void p_set_hint(UINode* node, lua::State* L, int idx) {
 }
 static void p_set_text(UINode* node, lua::State* L, int idx) {
     if (auto label = dynamic_cast<Label*>(node)) {
-        label->setText(lua::require_wstring(L, idx));
+        label->setText(lua::require_lstring(L, idx));
     } else if (auto button = dynamic_cast<Button*>(node)) {
-        button->setText(lua::require_wstring(L, idx));
+        button->setText(lua::require_lstring(L, idx));
     } else if (auto box = dynamic_cast<TextBox*>(node)) {
         box->setText(lua::require_wstring(L, idx));
     }
@@ -23,6 +23,17 @@ static int l_idt(lua::State* L) {
     return 0;
 }
 
+/// Overloads:
+/// mat4.new() -> Mat4 - creates identity matrix userdata
+/// mat4.new(matrix: float[16]) -> Mat4 - creates copy of the matrix
+static int l_new(lua::State* L) {
+    uint argc = lua::check_argc(L, 0, 1);
+    if (argc == 0) {
+        return lua::newuserdata<lua::LuaMat4>(L, glm::mat4(1.0f));
+    }
+    return lua::newuserdata<lua::LuaMat4>(L, lua::tomat4(L, 1));
+}
+
 /// mat4.determinant(matrix: float[16]) - calculates matrix determinant
 static int l_determinant(lua::State* L) {
     if (lua::gettop(L) != 1) {
@@ -42,7 +53,7 @@ static int l_determinant(lua::State* L) {
 static int l_mul(lua::State* L) {
     uint argc = lua::check_argc(L, 2, 3);
     auto matrix1 = lua::tomat4(L, 1);
-    uint len2 = lua::objlen(L, 2);
+    uint len2 = lua::arraylen(L, 2);
     if (len2 < 3) {
         throw std::runtime_error("argument #2: vec3 or vec4 expected");
     }
@@ -270,6 +281,7 @@ static int l_tostring(lua::State* L) {
 }
 
 const luaL_Reg mat4lib[] = {
+    {"new", lua::wrap<l_new>},
     {"idt", lua::wrap<l_idt>},
     {"mul", lua::wrap<l_mul>},
     {"scale", lua::wrap<l_binop_func<glm::scale>>},
@@ -66,15 +66,13 @@ static int l_closeserver(lua::State* L) {
     return 0;
 }
 
-static int l_send(lua::State* L) {
-    u64id_t id = lua::tointeger(L, 1);
-    auto connection = engine->getNetwork().getConnection(id);
-    if (connection == nullptr) {
-        return 0;
-    }
-    if (lua::istable(L, 2)) {
-        lua::pushvalue(L, 2);
-        size_t size = lua::objlen(L, 2);
+/// @brief Call func(const char* data, size_t size) with bytes of a table,
+/// Bytearray or string argument
+template <class Func>
+static void with_bytes(lua::State* L, int idx, const Func& func) {
+    if (lua::istable(L, idx)) {
+        lua::pushvalue(L, idx);
+        size_t size = lua::objlen(L, idx);
         util::Buffer<char> buffer(size);
         for (size_t i = 0; i < size; i++) {
             lua::rawgeti(L, i + 1);
@@ -82,18 +80,65 @@ static int l_send(lua::State* L) {
             lua::pop(L);
         }
         lua::pop(L);
-        connection->send(buffer.data(), size);
-    } else if (auto bytes = lua::touserdata<lua::LuaBytearray>(L, 2)) {
-        connection->send(
+        func(buffer.data(), size);
+    } else if (auto bytes = lua::touserdata<lua::LuaBytearray>(L, idx)) {
+        func(
             reinterpret_cast<char*>(bytes->data().data()), bytes->data().size()
         );
-    } else if (lua::isstring(L, 2)) {
-        auto string = lua::tolstring(L, 2);
-        connection->send(string.data(), string.length());
+    } else if (lua::isstring(L, idx)) {
+        auto string = lua::tolstring(L, idx);
+        func(string.data(), string.length());
+    }
+}
+
+static int l_send(lua::State* L) {
+    u64id_t id = lua::tointeger(L, 1);
+    auto connection = engine->getNetwork().getConnection(id);
+    if (connection == nullptr) {
+        return 0;
+    }
+    with_bytes(L, 2, [connection](const char* data, size_t size) {
+        connection->send(data, size);
+    });
+    return 0;
+}
+
+static int l_send_message(lua::State* L) {
+    u64id_t id = lua::tointeger(L, 1);
+    auto connection = engine->getNetwork().getConnection(id);
+    if (connection == nullptr) {
+        return 0;
     }
+    bool compress = lua::toboolean(L, 3);
+    with_bytes(L, 2, [connection, compress](const char* data, size_t size) {
+        connection->sendMessage(
+            reinterpret_cast<const ubyte*>(data), size, compress
+        );
+    });
     return 0;
 }
 
+static int l_recv_message(lua::State* L) {
+    u64id_t id = lua::tointeger(L, 1);
+    auto connection = engine->getNetwork().getConnection(id);
+    if (connection == nullptr) {
+        return 0;
+    }
+    std::vector<ubyte> bytes;
+    if (!connection->recvMessage(bytes)) {
+        return 0;
+    }
+    if (lua::toboolean(L, 2)) {
+        lua::createtable(L, bytes.size(), 0);
+        for (size_t i = 0; i < bytes.size(); i++) {
+            lua::pushinteger(L, bytes[i]);
+            lua::rawseti(L, i+1);
+        }
+        return 1;
+    }
+    return lua::newuserdata<lua::LuaBytearray>(L, std::move(bytes));
+}
+
 static int l_recv(lua::State* L) {
     u64id_t id = lua::tointeger(L, 1);
     int length = lua::tointeger(L, 2);
@@ -102,23 +147,30 @@ static int l_recv(lua::State* L) {
         return 0;
     }
     length = glm::min(length, connection->available());
+    if (!lua::toboolean(L, 3)) {
+        // receiving directly into the bytearray
+        lua::newuserdata<lua::LuaBytearray>(L, length);
+        auto& bytes = lua::touserdata<lua::LuaBytearray>(L, -1)->data();
+        int size = connection->recv(
+            reinterpret_cast<char*>(bytes.data()), length
+        );
+        if (size == -1) {
+            lua::pop(L);
+            return 0;
+        }
+        bytes.resize(size);
+        return 1;
+    }
     util::Buffer<char> buffer(length);
     
     int size = connection->recv(buffer.data(), length);
     if (size == -1) {
         return 0;
     }
-    if (lua::toboolean(L, 3)) {
-        lua::createtable(L, size, 0);
-        for (size_t i = 0; i < size; i++) {
-            lua::pushinteger(L, buffer[i] & 0xFF);
-            lua::rawseti(L, i+1);
-        }
-    } else {
-        lua::newuserdata<lua::LuaBytearray>(L, size);
-        auto bytearray = lua::touserdata<lua::LuaBytearray>(L, -1);   
-        bytearray->data().reserve(size);
-        std::memcpy(bytearray->data().data(), buffer.data(), size);
+    lua::createtable(L, size, 0);
+    for (size_t i = 0; i < size; i++) {
+        lua::pushinteger(L, buffer[i] & 0xFF);
+        lua::rawseti(L, i+1);
     }
     return 1;
 }
@@ -200,6 +252,8 @@ const luaL_Reg networklib[] = {
     {"__close", lua::wrap<l_close>},
     {"__send", lua::wrap<l_send>},
     {"__recv", lua::wrap<l_recv>},
+    {"__send_message", lua::wrap<l_send_message>},
+    {"__recv_message", lua::wrap<l_recv_message>},
     {"__is_alive", lua::wrap<l_is_alive>},
     {"__is_connected", lua::wrap<l_is_connected>},
     {"__get_address", lua::wrap<l_get_address>},
@@ -177,7 +177,31 @@ static int l_tostring(lua::State* L) {
     return lua::pushstring(L, ss.str());
 }
 
+/// Overloads:
+/// vec<n>.new() -> Vec<n> - creates zero vector userdata
+/// vec<n>.new(vec: float[n]) -> Vec<n> - creates copy of the vector
+/// vec<n>.new(x, y, ...) -> Vec<n> - creates vector of n components
+template <int n>
+static int l_new(lua::State* L) {
+    uint argc = lua::gettop(L);
+    glm::vec<n, float> vec(0.0f);
+    if (argc == 1) {
+        vec = lua::tovec<n>(L, 1);
+    } else if (argc == n) {
+        for (int i = 0; i < n; i++) {
+            vec[i] = lua::tonumber(L, i + 1);
+        }
+    } else if (argc) {
+        throw std::runtime_error(
+            "invalid arguments number (0, 1 or " + std::to_string(n) +
+            " expected)"
+        );
+    }
+    return lua::newuserdata<lua::LuaVector<n>>(L, vec);
+}
+
 const luaL_Reg vec2lib[] = {
+    {"new", lua::wrap<l_new<2>>},
     {"add", lua::wrap<l_binop<2, std::plus>>},
     {"sub", lua::wrap<l_binop<2, std::minus>>},
     {"mul", lua::wrap<l_binop<2, std::multiplies>>},
@@ -194,6 +218,7 @@ const luaL_Reg vec2lib[] = {
     {NULL, NULL}};
 
 const luaL_Reg vec3lib[] = {
+    {"new", lua::wrap<l_new<3>>},
     {"add", lua::wrap<l_binop<3, std::plus>>},
     {"sub", lua::wrap<l_binop<3, std::minus>>},
     {"mul", lua::wrap<l_binop<3, std::multiplies>>},
@@ -210,6 +235,7 @@ const luaL_Reg vec3lib[] = {
     {NULL, NULL}};
 
 const luaL_Reg vec4lib[] = {
+    {"new", lua::wrap<l_new<4>>},
     {"add", lua::wrap<l_binop<4, std::plus>>},
     {"sub", lua::wrap<l_binop<4, std::minus>>},
     {"mul", lua::wrap<l_binop<4, std::multiplies>>},
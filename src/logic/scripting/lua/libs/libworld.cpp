@@ -1,16 +1,26 @@
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 
 #include "api_lua.hpp"
 #include "assets/AssetsLoader.hpp"
 #include "coders/compression.hpp"
+#include "coders/delta.hpp"
 #include "coders/gzip.hpp"
 #include "coders/json.hpp"
 #include "engine.hpp"
 #include "files/engine_paths.hpp"
 #include "files/files.hpp"
+#include "files/WorldFiles.hpp"
 #include "lighting/Lighting.hpp"
+#include "logic/LevelController.hpp"
+#include "maths/voxmaths.hpp"
+#include "util/stringutil.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
 #include "world/Level.hpp"
@@ -99,6 +109,10 @@ static int l_get_seed(lua::State* L) {
     return lua::pushinteger(L, require_world_info().seed);
 }
 
+static int l_get_chunk_height(lua::State* L) {
+    return lua::pushinteger(L, CHUNK_H);
+}
+
 static int l_exists(lua::State* L) {
     auto name = lua::require_string(L, 1);
     auto worldsDir = engine->getPaths()->getWorldFolderByName(name);
@@ -119,6 +133,60 @@ static int l_get_generator(lua::State* L) {
     return lua::pushstring(L, require_world_info().generator);
 }
 
+static LevelController& require_controller() {
+    if (controller == nullptr) {
+        throw std::runtime_error("no world open");
+    }
+    return *controller;
+}
+
+/// @brief Start area pre-generation
+/// @param x area center X in blocks
+/// @param z area center Z in blocks
+/// @param radius area radius in chunks
+/// @param shape "square" (default) or "circle"
+static int l_pregenerate(lua::State* L) {
+    int x = lua::tointeger(L, 1);
+    int z = lua::tointeger(L, 2);
+    int radius = lua::tointeger(L, 3);
+    std::string shape = "square";
+    if (lua::isstring(L, 4)) {
+        shape = lua::require_string(L, 4);
+    }
+    if (shape != "square" && shape != "circle") {
+        throw std::runtime_error("invalid area shape " + util::quote(shape));
+    }
+    require_controller().startPregeneration(
+        floordiv(x, CHUNK_W), floordiv(z, CHUNK_D), radius, shape == "circle"
+    );
+    return 0;
+}
+
+static int l_stop_pregeneration(lua::State* L) {
+    require_controller().stopPregeneration();
+    return 0;
+}
+
+/// @return nil if not running or table with done and total chunks
+/// numbers, elapsed and eta time in seconds (eta is -1 if unknown)
+static int l_get_pregeneration(lua::State* L) {
+    auto pregenerator = require_controller().getPregenerator();
+    if (pregenerator == nullptr) {
+        return 0;
+    }
+    auto progress = pregenerator->getProgress();
+    lua::createtable(L, 0, 4);
+    lua::pushinteger(L, progress.done);
+    lua::setfield(L, "done");
+    lua::pushinteger(L, progress.total);
+    lua::setfield(L, "total");
+    lua::pushnumber(L, progress.elapsed / 1000.0);
+    lua::setfield(L, "elapsed");
+    lua::pushnumber(L, progress.eta < 0 ? -1.0 : progress.eta / 1000.0);
+    lua::setfield(L, "eta");
+    return 1;
+}
+
 static int l_get_chunk_data(lua::State* L) {
     int x = (int)lua::tointeger(L, 1);
     int y = (int)lua::tointeger(L, 2);
@@ -136,7 +204,7 @@ static int l_get_chunk_data(lua::State* L) {
     if (compress) {
         size_t rle_compressed_size;
         size_t gzip_compressed_size;
-        const auto& data_ptr = chunk->encode();
+        const auto& data_ptr = chunk->encodeTemporary();
         ubyte* data = data_ptr.get();
         const auto& rle_compressed_data_ptr = compression::compress(
             data,
@@ -161,11 +229,8 @@ static int l_get_chunk_data(lua::State* L) {
             gzip_compressed_data.get() + gzip_compressed_size
         );
     } else {
-        const auto& data = chunk->encode();
-        chunk_data.reserve(CHUNK_DATA_LEN);
-        chunk_data.insert(
-            chunk_data.begin(), data.get(), data.get() + CHUNK_DATA_LEN
-        );
+        chunk_data.resize(CHUNK_DATA_LEN);
+        chunk->encode(chunk_data.data());
     }
     return lua::newuserdata<lua::LuaBytearray>(L, chunk_data);
 }
@@ -202,35 +267,230 @@ static int l_set_chunk_data(lua::State* L) {
     } else {
         chunk->decode(buffer->data().data());
     }
-    chunk->updateHeights();
-    level->lighting->buildSkyLight(x, y);
-    chunk->flags.modified = true;
-    level->lighting->onChunkLoaded(x, y, true);
+    chunk->flags.changed = true;
+    level->chunks->onChunkDataChanged(x, y);
+    level->lighting->onChunkDataChanged(x, y);
+    return 1;
+}
+
+static int l_get_chunk_delta(lua::State* L) {
+    int x = static_cast<int>(lua::tointeger(L, 1));
+    int z = static_cast<int>(lua::tointeger(L, 2));
+    auto base = lua::touserdata<lua::LuaBytearray>(L, 3);
+    if (base == nullptr) {
+        throw std::runtime_error("Bytearray expected");
+    }
+    if (base->data().size() != CHUNK_DATA_LEN) {
+        throw std::runtime_error("invalid chunk data size");
+    }
+    auto chunk = level->chunks->getChunk(x, z);
+    if (chunk == nullptr) {
+        return 0;
+    }
+    auto data = chunk->encodeTemporary();
+    return lua::newuserdata<lua::LuaBytearray>(
+        L, delta::encode(base->data().data(), data.get(), CHUNK_DATA_LEN)
+    );
+}
+
+static int l_apply_chunk_delta(lua::State* L) {
+    int x = static_cast<int>(lua::tointeger(L, 1));
+    int z = static_cast<int>(lua::tointeger(L, 2));
+    auto bytes = lua::touserdata<lua::LuaBytearray>(L, 3);
+    if (bytes == nullptr) {
+        throw std::runtime_error("Bytearray expected");
+    }
+    auto chunk = level->chunks->getChunk(x, z);
+    if (chunk == nullptr) {
+        return lua::pushboolean(L, false);
+    }
+    auto data = chunk->encodeTemporary();
+    const auto& diff = bytes->data();
+    delta::apply(data.get(), CHUNK_DATA_LEN, diff.data(), diff.size());
+    chunk->decode(data.get());
+    chunk->flags.changed = true;
+    level->chunks->onChunkDataChanged(x, z);
+    level->lighting->onChunkDataChanged(x, z);
+    return lua::pushboolean(L, true);
+}
 
-    chunk = level->chunks->getChunk(x - 1, y);
-    if (chunk != nullptr) {
-        chunk->flags.modified = true;
-        level->lighting->onChunkLoaded(x - 1, y, true);
+/// @brief Start or update native chunks streaming to the connection
+/// @param connection network connection id
+/// @param player remote player id
+/// @param radius streaming area radius in chunks
+/// @param bandwidth optional bytes per second limit
+static int l_stream_chunks(lua::State* L) {
+    u64id_t connection = lua::tointeger(L, 1);
+    int64_t player = lua::tointeger(L, 2);
+    int radius = lua::tointeger(L, 3);
+    size_t bandwidth = 0;
+    if (lua::isnumber(L, 4)) {
+        bandwidth = std::max<lua::Integer>(0, lua::tointeger(L, 4));
     }
-    chunk = level->chunks->getChunk(x + 1, y);
-    if (chunk != nullptr) {
-        chunk->flags.modified = true;
-        level->lighting->onChunkLoaded(x + 1, y, true);
+    require_controller().getChunksStreamer()->setClient(
+        connection, player, radius, bandwidth
+    );
+    return 0;
+}
+
+static int l_stop_streaming(lua::State* L) {
+    require_controller().getChunksStreamer()->removeClient(
+        lua::tointeger(L, 1)
+    );
+    return 0;
+}
+
+static int l_forget_streamed_chunk(lua::State* L) {
+    require_controller().getChunksStreamer()->forget(
+        lua::tointeger(L, 1), lua::tointeger(L, 2), lua::tointeger(L, 3)
+    );
+    return 0;
+}
+
+/// @brief Apply chunks streaming message received by the client
+/// @return chunk x, z and false if the chunk is not loaded or the delta
+/// is made for another version of the chunk
+static int l_apply_chunk_message(lua::State* L) {
+    auto bytes = lua::touserdata<lua::LuaBytearray>(L, 1);
+    if (bytes == nullptr) {
+        throw std::runtime_error("Bytearray expected");
     }
-    chunk = level->chunks->getChunk(x, y - 1);
-    if (chunk != nullptr) {
-        chunk->flags.modified = true;
-        level->lighting->onChunkLoaded(x, y - 1, true);
+    const auto& data = bytes->data();
+    int x, z;
+    bool applied = ChunksStreamer::apply(
+        *level, data.data(), data.size(), x, z
+    );
+    lua::pushinteger(L, x);
+    lua::pushinteger(L, z);
+    lua::pushboolean(L, applied);
+    return 3;
+}
+
+/// @brief Max decoded chunks waiting for the scan callback
+static constexpr size_t MAX_SCAN_QUEUE = 64;
+
+/// @brief Iterate saved chunks of the open world decoded by the scan
+/// threads, the callback gets read-only ChunkView in the calling thread
+/// @param layers array of layer names ("voxels", "lights")
+/// @param callback function(view) returning false to stop the scan
+/// @return stats table
+static int l_scan_regions(lua::State* L) {
+    if (level == nullptr) {
+        throw std::runtime_error("no world open");
+    }
+    if (!lua::istable(L, 1)) {
+        throw std::runtime_error("layers table expected");
+    }
+    if (!lua::isfunction(L, 2)) {
+        throw std::runtime_error("callback function expected");
     }
-    chunk = level->chunks->getChunk(x, y + 1);
-    if (chunk != nullptr) {
-        chunk->flags.modified = true;
-        level->lighting->onChunkLoaded(x, y + 1, true);
+    uint layers = 0;
+    lua::pushvalue(L, 1);
+    for (int i = 1, n = lua::objlen(L, -1); i <= n; i++) {
+        lua::rawgeti(L, i);
+        std::string name = lua::require_string(L, -1);
+        lua::pop(L);
+        if (name == "voxels") {
+            layers |= 1U << REGION_LAYER_VOXELS;
+        } else if (name == "lights") {
+            layers |= 1U << REGION_LAYER_LIGHTS;
+        } else {
+            throw std::runtime_error("unknown layer " + util::quote(name));
+        }
     }
+    lua::pop(L);
+    const auto& regions = level->getWorld()->wfile->getRegions();
+    uint threads = std::max(2U, std::thread::hardware_concurrency()) - 1;
 
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<Chunk>> queue;
+    bool done = false;
+    bool stop = false;
+    RegionsScanStats stats {};
+    std::exception_ptr error;
+    std::thread scanner([&]() {
+        try {
+            stats = regions.scan(layers, threads, [&](const Chunk& chunk) {
+                std::shared_ptr<Chunk> copy = chunk.clone();
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [&]() {
+                    return queue.size() < MAX_SCAN_QUEUE || stop;
+                });
+                if (stop) {
+                    return false;
+                }
+                queue.push_back(std::move(copy));
+                cv.notify_all();
+                return true;
+            });
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard lock(mutex);
+        done = true;
+        cv.notify_all();
+    });
+    auto finish = [&]() {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        scanner.join();
+    };
+    try {
+        while (true) {
+            std::shared_ptr<Chunk> chunk;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [&]() { return !queue.empty() || done; });
+                if (queue.empty()) {
+                    break;
+                }
+                chunk = std::move(queue.front());
+                queue.pop_front();
+                cv.notify_all();
+            }
+            lua::pushvalue(L, 2);
+            lua::newuserdata<lua::LuaChunkView>(L, chunk, true);
+            lua::call(L, 1, 1);
+            bool proceed = !lua::isboolean(L, -1) || lua::toboolean(L, -1);
+            lua::pop(L);
+            if (!proceed) {
+                break;
+            }
+        }
+    } catch (...) {
+        finish();
+        throw;
+    }
+    finish();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    lua::createtable(L, 0, 4);
+    lua::pushinteger(L, stats.regions);
+    lua::setfield(L, "regions");
+    lua::pushinteger(L, stats.chunks);
+    lua::setfield(L, "chunks");
+    lua::pushnumber(L, stats.seconds);
+    lua::setfield(L, "elapsed");
+    lua::pushnumber(L, stats.chunksPerSecond());
+    lua::setfield(L, "chunks_per_second");
     return 1;
 }
 
+static int l_get_chunk_view(lua::State* L) {
+    int x = static_cast<int>(lua::tointeger(L, 1));
+    int z = static_cast<int>(lua::tointeger(L, 2));
+    auto chunk = level->chunks->getChunkHandle(x, z);
+    if (chunk == nullptr) {
+        return 0;
+    }
+    return lua::newuserdata<lua::LuaChunkView>(L, chunk);
+}
+
 const luaL_Reg worldlib[] = {
     {"is_open", lua::wrap<l_is_open>},
     {"get_list", lua::wrap<l_get_list>},
@@ -241,10 +501,22 @@ const luaL_Reg worldlib[] = {
     {"get_day_time_speed", lua::wrap<l_get_day_time_speed>},
     {"get_seed", lua::wrap<l_get_seed>},
     {"get_generator", lua::wrap<l_get_generator>},
+    {"get_chunk_height", lua::wrap<l_get_chunk_height>},
     {"is_day", lua::wrap<l_is_day>},
     {"is_night", lua::wrap<l_is_night>},
     {"exists", lua::wrap<l_exists>},
     {"get_chunk_data", lua::wrap<l_get_chunk_data>},
+    {"pregenerate", lua::wrap<l_pregenerate>},
+    {"stop_pregeneration", lua::wrap<l_stop_pregeneration>},
+    {"get_pregeneration", lua::wrap<l_get_pregeneration>},
     {"set_chunk_data", lua::wrap<l_set_chunk_data>},
+    {"get_chunk_view", lua::wrap<l_get_chunk_view>},
+    {"get_chunk_delta", lua::wrap<l_get_chunk_delta>},
+    {"apply_chunk_delta", lua::wrap<l_apply_chunk_delta>},
+    {"stream_chunks", lua::wrap<l_stream_chunks>},
+    {"stop_streaming", lua::wrap<l_stop_streaming>},
+    {"forget_streamed_chunk", lua::wrap<l_forget_streamed_chunk>},
+    {"apply_chunk_message", lua::wrap<l_apply_chunk_message>},
+    {"scan_regions", lua::wrap<l_scan_regions>},
     {NULL, NULL}
 };
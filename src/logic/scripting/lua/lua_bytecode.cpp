@@ -0,0 +1,138 @@
+#include "lua_bytecode.hpp"
+
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "coders/byte_utils.hpp"
+#include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
+#include "files/files.hpp"
+#include "lua_util.hpp"
+
+namespace fs = std::filesystem;
+
+static debug::Logger logger("lua-bytecode");
+
+/// @brief Bytecode cache file format version
+static constexpr int BYTECODE_CACHE_VERSION = 1;
+static const char BYTECODE_CACHE_MAGIC[] = "VELUAC";
+
+static fs::path cache_folder;
+
+void lua::set_bytecode_cache(const fs::path& folder) {
+    cache_folder = folder;
+}
+
+/// @brief FNV-1a hash
+static uint64_t hash_bytes(
+    const void* data, size_t size, uint64_t hash = 14695981039346656037ULL
+) {
+    auto bytes = static_cast<const ubyte*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/// @brief Cache key of the source: bytecode depends on the LuaJIT version
+/// and build (GC64 mode changes the format)
+static uint64_t source_key(const std::string& src, const std::string& file) {
+    static const std::string build =
+        std::string(LUAJIT_VERSION) + std::to_string(sizeof(void*));
+    uint64_t hash = hash_bytes(build.data(), build.size());
+    hash = hash_bytes(file.data(), file.size(), hash);
+    return hash_bytes(src.data(), src.size(), hash);
+}
+
+static fs::path cache_file(const std::string& file) {
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0')
+       << hash_bytes(file.data(), file.size()) << ".luac";
+    return cache_folder / fs::u8path(ss.str());
+}
+
+/// @brief Try to load cached chunk
+/// @return true if the chunk is pushed
+static bool load_cached(
+    lua::State* L, const fs::path& file, uint64_t key, const std::string& name
+) {
+    if (!fs::is_regular_file(file)) {
+        return false;
+    }
+    try {
+        auto bytes = files::read_bytes(file);
+        ByteReader reader(bytes.data(), bytes.size());
+        reader.checkMagic(BYTECODE_CACHE_MAGIC, sizeof(BYTECODE_CACHE_MAGIC));
+        if (reader.getInt32() != BYTECODE_CACHE_VERSION ||
+            static_cast<uint64_t>(reader.getInt64()) != key) {
+            return false;
+        }
+        auto data = reinterpret_cast<const char*>(reader.pointer());
+        if (luaL_loadbuffer(L, data, reader.remaining(), name.c_str())) {
+            logger.warning() << "invalid bytecode of " << name << ": "
+                             << lua::tostring(L, -1);
+            lua::pop(L);
+            return false;
+        }
+        return true;
+    } catch (const std::runtime_error& err) {
+        logger.error() << "invalid bytecode cache " << file.u8string()
+                       << ": " << err.what();
+        return false;
+    }
+}
+
+static int write_bytecode(
+    lua::State*, const void* data, size_t size, void* ud
+) {
+    static_cast<ByteBuilder*>(ud)->put(static_cast<const ubyte*>(data), size);
+    return 0;
+}
+
+/// @brief Write bytecode of the function on the stack top
+static void write_cache(lua::State* L, const fs::path& file, uint64_t key) {
+    ByteBuilder builder;
+    builder.put(
+        reinterpret_cast<const ubyte*>(BYTECODE_CACHE_MAGIC),
+        sizeof(BYTECODE_CACHE_MAGIC)
+    );
+    builder.putInt32(BYTECODE_CACHE_VERSION);
+    builder.putInt64(key);
+    if (lua_dump(L, write_bytecode, &builder)) {
+        return;
+    }
+    try {
+        fs::create_directories(file.parent_path());
+        files::write_bytes(file, builder.data(), builder.size());
+    } catch (const std::exception& err) {
+        logger.error() << "could not write bytecode cache: " << err.what();
+    }
+}
+
+void lua::loadbuffer_cached(
+    State* L, int env, const std::string& src, const std::string& file
+) {
+    if (cache_folder.empty()) {
+        loadbuffer(L, env, src, file);
+        return;
+    }
+    auto& metrics = debug::Metrics::getInstance();
+    static auto& hits = metrics.counter("lua.bytecode-cache-hits");
+    static auto& misses = metrics.counter("lua.bytecode-cache-misses");
+
+    uint64_t key = source_key(src, file);
+    auto cacheFile = cache_file(file);
+    if (load_cached(L, cacheFile, key, file)) {
+        hits.add();
+    } else {
+        if (luaL_loadbuffer(L, src.c_str(), src.length(), file.c_str())) {
+            throw luaerror(tostring(L, -1));
+        }
+        misses.add();
+        write_cache(L, cacheFile, key);
+    }
+    if (env && getglobal(L, env_name(env))) {
+        lua_setfenv(L, -2);
+    }
+}
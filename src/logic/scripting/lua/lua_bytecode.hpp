@@ -0,0 +1,19 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+#include "lua_commons.hpp"
+
+namespace lua {
+    /// @brief Set folder of compiled scripts cache
+    /// @param folder cache folder, empty path disables the cache
+    void set_bytecode_cache(const std::filesystem::path& folder);
+
+    /// @brief Load chunk like loadbuffer using the bytecode cache: chunks
+    /// are compiled only if the source or LuaJIT version is changed since
+    /// the previous load. Main thread only
+    void loadbuffer_cached(
+        State* L, int env, const std::string& src, const std::string& file
+    );
+}
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include <glm/glm.hpp>
+
 #include "lua_commons.hpp"
 
 struct fnl_state;
+class Chunk;
 class Heightmap;
 class VoxelFragment;
 
@@ -17,7 +21,8 @@ namespace lua {
     };
 
     class LuaBytearray : public Userdata {
-        std::vector<ubyte> buffer;
+        /// @brief Shared with views created by view()
+        std::shared_ptr<std::vector<ubyte>> buffer;
     public:
         LuaBytearray(size_t capacity);
         LuaBytearray(std::vector<ubyte> buffer);
@@ -27,6 +32,10 @@ namespace lua {
             return TYPENAME;
         }
         inline std::vector<ubyte>& data() {
+            return *buffer;
+        }
+
+        const std::shared_ptr<std::vector<ubyte>>& getBuffer() const {
             return buffer;
         }
 
@@ -35,6 +44,48 @@ namespace lua {
     };
     static_assert(!std::is_abstract<LuaBytearray>());
 
+    /// @brief Typed elements view of a bytearray buffer (bytearray:view).
+    /// Elements are packed without alignment, the view length follows
+    /// the buffer size changes
+    class LuaBytearrayView : public Userdata {
+    public:
+        enum class ElementType { U8, I8, U16, I16, U32, I32, F32, F64 };
+    private:
+        std::shared_ptr<std::vector<ubyte>> buffer;
+        ElementType type;
+        bool bigEndian;
+        /// @brief Offset of the first element (bytes)
+        size_t offset;
+    public:
+        LuaBytearrayView(
+            std::shared_ptr<std::vector<ubyte>> buffer,
+            ElementType type,
+            bool bigEndian,
+            size_t offset
+        );
+        virtual ~LuaBytearrayView();
+
+        /// @brief Get number of whole elements in the buffer
+        size_t size() const;
+
+        /// @brief Get element size (bytes)
+        size_t getElementSize() const;
+
+        /// @param index zero based element index less than size()
+        double get(size_t index) const;
+
+        /// @param index zero based element index less than size()
+        void set(size_t index, double value);
+
+        const std::string& getTypeName() const override {
+            return TYPENAME;
+        }
+
+        static int createMetatable(lua::State*);
+        inline static std::string TYPENAME = "BytearrayView";
+    };
+    static_assert(!std::is_abstract<LuaBytearrayView>());
+
     class LuaHeightmap : public Userdata {
         std::shared_ptr<Heightmap> map;
         std::unique_ptr<fnl_state> noise;
@@ -90,4 +141,92 @@ namespace lua {
         inline static std::string TYPENAME = "VoxelFragment";
     };
     static_assert(!std::is_abstract<LuaVoxelFragment>());
+
+    /// @brief Direct access to voxels and lights of a loaded chunk without
+    /// copying. The view does not keep the chunk loaded and gets invalid
+    /// when the chunk is unloaded. Changes are applied on commit()
+    /// rebuilding the chunk lights
+    class LuaChunkView : public Userdata {
+        std::weak_ptr<Chunk> chunk;
+        bool modified = false;
+        /// @brief View of a chunk not in the level (see world.scan_regions)
+        bool readonly;
+    public:
+        LuaChunkView(
+            const std::shared_ptr<Chunk>& chunk, bool readonly = false
+        );
+
+        virtual ~LuaChunkView();
+
+        /// @return chunk or nullptr if unloaded
+        std::shared_ptr<Chunk> getChunk() const {
+            return chunk.lock();
+        }
+
+        bool isModified() const {
+            return modified;
+        }
+
+        void setModified(bool flag) {
+            modified = flag;
+        }
+
+        bool isReadonly() const {
+            return readonly;
+        }
+
+        const std::string& getTypeName() const override {
+            return TYPENAME;
+        }
+
+        static int createMetatable(lua::State*);
+        inline static std::string TYPENAME = "ChunkView";
+    };
+    static_assert(!std::is_abstract<LuaChunkView>());
+
+    /// @brief Vector stored in userdata: arithmetic operators without
+    /// tables creation, accepted by all functions taking vector tables
+    /// (including destination arguments)
+    template <int n>
+    class LuaVector : public Userdata {
+        glm::vec<n, float> vector;
+    public:
+        LuaVector(const glm::vec<n, float>& vector) : vector(vector) {
+        }
+
+        glm::vec<n, float>& vec() {
+            return vector;
+        }
+
+        const std::string& getTypeName() const override {
+            return TYPENAME;
+        }
+
+        static int createMetatable(lua::State*);
+        inline static std::string TYPENAME = "Vec" + std::to_string(n);
+    };
+    using LuaVec2 = LuaVector<2>;
+    using LuaVec3 = LuaVector<3>;
+    using LuaVec4 = LuaVector<4>;
+    static_assert(!std::is_abstract<LuaVec3>());
+
+    /// @brief 4x4 matrix stored in userdata, see LuaVector
+    class LuaMat4 : public Userdata {
+        glm::mat4 matrix;
+    public:
+        LuaMat4(const glm::mat4& matrix) : matrix(matrix) {
+        }
+
+        glm::mat4& mat() {
+            return matrix;
+        }
+
+        const std::string& getTypeName() const override {
+            return TYPENAME;
+        }
+
+        static int createMetatable(lua::State*);
+        inline static std::string TYPENAME = "Mat4";
+    };
+    static_assert(!std::is_abstract<LuaMat4>());
 }
@@ -1,17 +1,24 @@
 #include "lua_engine.hpp"
 
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 
 #include "files/files.hpp"
 #include "files/engine_paths.hpp"
 #include "debug/Logger.hpp"
+#include "debug/MemoryUsage.hpp"
+#include "debug/Metrics.hpp"
+#include "debug/Profiler.hpp"
 #include "util/stringutil.hpp"
 #include "libs/api_lua.hpp"
 #include "lua_custom_types.hpp"
 
 static debug::Logger logger("lua-state");
 static lua::State* main_thread = nullptr;
+/// @brief Reports the main state heap as "lua.heap"
+static std::unique_ptr<debug::MemorySource> heap_source;
 
 using namespace lua;
 
@@ -106,8 +113,100 @@ void lua::init_state(State* L, StateType stateType) {
     initialize_libs_extends(L);
 
     newusertype<LuaBytearray>(L);
+    newusertype<LuaBytearrayView>(L);
     newusertype<LuaHeightmap>(L);
     newusertype<LuaVoxelFragment>(L);
+    newusertype<LuaChunkView>(L);
+    newusertype<LuaVec2>(L);
+    newusertype<LuaVec3>(L);
+    newusertype<LuaVec4>(L);
+    newusertype<LuaMat4>(L);
+}
+
+/// @brief Registry references of events.emit function and event names
+static int emit_ref = LUA_NOREF;
+static std::unordered_map<std::string, int> event_refs;
+namespace {
+    struct EventInfo {
+        size_t owner;
+        size_t timing;
+    };
+}
+/// @brief Memory owners and timings of events indexed by handle
+static std::vector<EventInfo> event_infos;
+
+/// @brief Allocation counters indexed by memory owner id, the main state
+/// allocator is the only user (main thread)
+static std::vector<debug::Counter*> owner_counters;
+static std::unordered_map<std::string, size_t> owner_ids;
+static size_t current_owner = 0;
+/// @brief Owner of allocations made outside of any MemoryScope
+static const std::string DEFAULT_OWNER = "core";
+
+/// @brief Collector settings applied to the main state
+static GCSettings gc_settings {};
+static int64_t gc_allocated = 0;
+
+size_t lua::get_memory_owner(const std::string& name) {
+    const auto& found = owner_ids.find(name);
+    if (found != owner_ids.end()) {
+        return found->second;
+    }
+    size_t id = owner_counters.size();
+    owner_counters.push_back(
+        &debug::Metrics::getInstance().counter("lua.allocated." + name)
+    );
+    owner_ids[name] = id;
+    return id;
+}
+
+MemoryScope::MemoryScope(size_t owner) : previous(current_owner) {
+    current_owner = owner;
+}
+
+MemoryScope::~MemoryScope() {
+    current_owner = previous;
+}
+
+static size_t owner_of_event(const std::string& name) {
+    size_t separator = name.find(':');
+    if (separator == std::string::npos) {
+        return get_memory_owner(DEFAULT_OWNER);
+    }
+    return get_memory_owner(name.substr(0, separator));
+}
+
+/// @brief Main state allocator counting allocated bytes by current owner
+static void* allocate(void*, void* ptr, size_t osize, size_t nsize) {
+    if (nsize == 0) {
+        std::free(ptr);
+        return nullptr;
+    }
+    size_t previous = ptr ? osize : 0;
+    if (nsize > previous) {
+        owner_counters[current_owner]->add(nsize - previous);
+    }
+    return std::realloc(ptr, nsize);
+}
+
+static int panic(State* L) {
+    logger.error() << "unprotected error: " << lua_tostring(L, -1);
+    return 0;
+}
+
+/// @brief Create main state with the tracking allocator if supported by
+/// the LuaJIT build (GC64), other states use the default allocator
+static State* new_state(StateType stateType) {
+    if (stateType == StateType::BASE) {
+        get_memory_owner(DEFAULT_OWNER);
+        if (auto L = lua_newstate(allocate, nullptr)) {
+            lua_atpanic(L, panic);
+            return L;
+        }
+        logger.warning() << "custom allocator is not supported, "
+                            "allocations will not be tracked";
+    }
+    return luaL_newstate();
 }
 
 void lua::initialize(const EnginePaths& paths) {
@@ -115,15 +214,68 @@ void lua::initialize(const EnginePaths& paths) {
     logger.info() << LUAJIT_VERSION;
 
     main_thread = create_state(paths, StateType::BASE);
+    gc_settings = {};
+    heap_source = std::make_unique<debug::MemorySource>(
+        [](debug::MemoryBreakdown& breakdown) {
+            size_t kbytes = lua_gc(main_thread, LUA_GCCOUNT, 0);
+            size_t bytes = lua_gc(main_thread, LUA_GCCOUNTB, 0);
+            breakdown["lua.heap"] += kbytes * 1024 + bytes;
+        }
+    );
 }
 
 void lua::finalize() {
+    heap_source.reset();
     lua::close(main_thread);
+    emit_ref = LUA_NOREF;
+    event_refs.clear();
+    event_infos.clear();
+}
+
+void lua::update_gc(const GCSettings& settings) {
+    auto L = main_thread;
+    if (settings.pause != gc_settings.pause) {
+        lua_gc(L, LUA_GCSETPAUSE, settings.pause);
+    }
+    if (settings.stepMul != gc_settings.stepMul) {
+        lua_gc(L, LUA_GCSETSTEPMUL, settings.stepMul);
+    }
+    if (settings.frameSteps != gc_settings.frameSteps) {
+        lua_gc(L, settings.frameSteps ? LUA_GCSTOP : LUA_GCRESTART, 0);
+    }
+    gc_settings = settings;
+
+    auto& metrics = debug::Metrics::getInstance();
+    static auto& memory = metrics.gauge("lua.memory");
+    auto used = [L]() {
+        return int64_t(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 +
+               lua_gc(L, LUA_GCCOUNTB, 0);
+    };
+    if (settings.frameSteps) {
+        static auto& stepTime = metrics.histogram("lua.gc-step");
+        // collector work equal to the automatic collector one for memory
+        // allocated since the previous step
+        int64_t allocated = std::max<int64_t>(used() - gc_allocated, 0);
+        {
+            debug::ProfileZone zone("lua-gc");
+            debug::MetricTimer timer(stepTime);
+            lua_gc(L, LUA_GCSTEP, static_cast<int>(allocated / 1024) + 1);
+        }
+        // the step restarts the collector
+        lua_gc(L, LUA_GCSTOP, 0);
+    }
+    gc_allocated = used();
+    memory.set(gc_allocated);
 }
 
 bool lua::emit_event(
     State* L, const std::string& name, std::function<int(State*)> args
 ) {
+    static auto& eventsTime =
+        debug::Metrics::getInstance().histogram("lua.events");
+    debug::MetricTimer timer(eventsTime);
+    MemoryScope scope(owner_of_event(name));
+    HandlerTimer handlerTimer(get_handler_timing(name));
     getglobal(L, "events");
     getfield(L, "emit");
     pushstring(L, name);
@@ -133,12 +285,58 @@ bool lua::emit_event(
     return result;
 }
 
+int lua::create_event_handle(State* L, const std::string& name) {
+    if (emit_ref == LUA_NOREF) {
+        requireglobal(L, "events");
+        getfield(L, "emit");
+        emit_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        pop(L);
+    }
+    const auto& found = event_refs.find(name);
+    if (found != event_refs.end()) {
+        return found->second;
+    }
+    pushstring(L, name);
+    int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    event_refs[name] = ref;
+    if (event_infos.size() <= static_cast<size_t>(ref)) {
+        event_infos.resize(ref + 1);
+    }
+    event_infos[ref] = {owner_of_event(name), get_handler_timing(name)};
+    return ref;
+}
+
+size_t lua::get_event_owner(int handle) {
+    return event_infos[handle].owner;
+}
+
+size_t lua::get_event_timing(int handle) {
+    return event_infos[handle].timing;
+}
+
+void lua::push_event(State* L, int handle) {
+    lua_rawgeti(L, LUA_REGISTRYINDEX, emit_ref);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, handle);
+}
+
+bool lua::call_event(State* L, int argc) {
+    static auto& eventsTime =
+        debug::Metrics::getInstance().histogram("lua.events");
+    debug::MetricTimer timer(eventsTime);
+    if (!call_nothrow(L, argc + 1)) {
+        return false;
+    }
+    bool result = toboolean(L, -1);
+    pop(L);
+    return result;
+}
+
 State* lua::get_main_state() {
     return main_thread;
 }
 
 State* lua::create_state(const EnginePaths& paths, StateType stateType) {
-    auto L = luaL_newstate();
+    auto L = new_state(stateType);
     if (L == nullptr) {
         throw luaerror("could not initialize Lua state");
     }
@@ -5,6 +5,7 @@
 
 #include "delegates.hpp"
 #include "logic/scripting/scripting_functional.hpp"
+#include "lua_timings.hpp"
 #include "lua_util.hpp"
 
 class EnginePaths;
@@ -18,11 +19,79 @@ namespace lua {
     void initialize(const EnginePaths& paths);
     void finalize();
 
+    /// @brief Get id of a memory owner (content pack id) main state
+    /// allocations may be attributed to. Allocated bytes are counted in
+    /// 'lua.allocated.<name>' metrics counter
+    size_t get_memory_owner(const std::string& name);
+
+    /// @brief Attributes main state allocations made while the scope
+    /// exists to the owner
+    class MemoryScope {
+        size_t previous;
+    public:
+        MemoryScope(size_t owner);
+        ~MemoryScope();
+    };
+
     bool emit_event(
         State*,
         const std::string& name,
         std::function<int(State*)> args = [](auto*) { return 0; }
     );
+
+    /// @brief Get handle of the event name to be emitted without the name
+    /// string creation and hashing. Handles of the same name are equal
+    /// and stay valid until the main state is finalized
+    /// @return positive integer handle
+    int create_event_handle(State* L, const std::string& name);
+
+    /// @brief Get memory owner of the event (pack id prefix of the name)
+    size_t get_event_owner(int handle);
+
+    /// @brief Get handler timing id of the event
+    size_t get_event_timing(int handle);
+
+    /// @brief Push events.emit function and the event name
+    /// @param handle handle created with create_event_handle
+    void push_event(State* L, int handle);
+
+    /// @brief Call events.emit pushed with push_event
+    /// @param argc number of event arguments
+    /// @return event handlers result
+    bool call_event(State* L, int argc);
+
+    /// @brief Emit event by handle. Allocates nothing unlike the name
+    /// based emit_event
+    /// @param args function pushing event arguments, returns their number
+    template <class F>
+    inline bool emit_event(State* L, int handle, const F& args) {
+        if (handle == 0) {
+            return false;
+        }
+        MemoryScope scope(get_event_owner(handle));
+        HandlerTimer timer(get_event_timing(handle));
+        push_event(L, handle);
+        return call_event(L, args(L));
+    }
+
+    /// @brief Main state garbage collector parameters (LuaJIT collector
+    /// is incremental only)
+    struct GCSettings {
+        /// @brief Percents of memory use after a cycle reached to start
+        /// the next cycle
+        int pause;
+        /// @brief Collector speed relative to allocation in percents
+        int stepMul;
+        /// @brief Stop automatic collection and perform collector work
+        /// once a frame in update_gc
+        bool frameSteps;
+    };
+
+    /// @brief Apply changed collector settings, update memory metrics and
+    /// perform the collector step when frame steps are enabled (step time
+    /// is recorded to 'lua-gc' profiler zone and 'lua.gc-step' histogram)
+    void update_gc(const GCSettings& settings);
+
     State* get_main_state();
     State* create_state(const EnginePaths& paths, StateType stateType);
     [[nodiscard]] scriptenv create_environment(State* L);
@@ -0,0 +1,114 @@
+#include "lua_timings.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+#include "debug/Logger.hpp"
+
+using namespace lua;
+
+static debug::Logger logger("lua-timings");
+
+/// @brief Max number of calls skipped after a slow call
+static constexpr int MAX_SKIPPED_CALLS = 20;
+/// @brief Min interval between slow call reports of a handler
+static constexpr auto REPORT_INTERVAL = std::chrono::seconds(5);
+
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+    struct TimingEntry {
+        HandlerTiming timing;
+        /// @brief Number of next calls to skip
+        int skip = 0;
+        clock_type::time_point lastReport {};
+    };
+}
+
+static std::vector<TimingEntry> entries;
+static std::unordered_map<std::string, size_t> ids;
+static int64_t budget = 0;
+static bool throttling = false;
+
+size_t lua::get_handler_timing(const std::string& name) {
+    const auto& found = ids.find(name);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    size_t id = entries.size();
+    entries.push_back({});
+    entries[id].timing.name = name;
+    ids[name] = id;
+    return id;
+}
+
+void lua::set_handler_budget(int64_t micros, bool throttle) {
+    budget = micros;
+    throttling = throttle;
+    if (!throttle) {
+        for (auto& entry : entries) {
+            entry.skip = 0;
+        }
+    }
+}
+
+bool lua::is_handler_throttled(size_t id) {
+    auto& entry = entries[id];
+    if (entry.skip <= 0) {
+        return false;
+    }
+    entry.skip--;
+    entry.timing.skipped++;
+    return true;
+}
+
+std::vector<HandlerTiming> lua::get_slowest_handlers(size_t count) {
+    std::vector<HandlerTiming> timings;
+    for (const auto& entry : entries) {
+        if (entry.timing.calls) {
+            timings.push_back(entry.timing);
+        }
+    }
+    std::sort(timings.begin(), timings.end(), [](const auto& a, const auto& b) {
+        return a.total > b.total;
+    });
+    if (timings.size() > count) {
+        timings.resize(count);
+    }
+    return timings;
+}
+
+void lua::reset_handler_timings() {
+    for (auto& entry : entries) {
+        auto name = std::move(entry.timing.name);
+        entry = {};
+        entry.timing.name = std::move(name);
+    }
+}
+
+HandlerTimer::~HandlerTimer() {
+    int64_t time = timer.stop();
+    auto& entry = entries[id];
+    auto& timing = entry.timing;
+    timing.calls++;
+    timing.total += time;
+    timing.max = std::max(timing.max, time);
+    if (budget <= 0 || time <= budget) {
+        return;
+    }
+    timing.slowCalls++;
+    if (throttling) {
+        entry.skip = static_cast<int>(
+            std::min<int64_t>(time / budget, MAX_SKIPPED_CALLS)
+        );
+    }
+    auto now = clock_type::now();
+    if (now - entry.lastReport >= REPORT_INTERVAL) {
+        entry.lastReport = now;
+        logger.warning() << "slow handler " << timing.name << ": "
+                         << time / 1000.0 << " ms (budget "
+                         << budget / 1000.0 << " ms, " << timing.slowCalls
+                         << " slow calls)";
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "util/timeutil.hpp"
+
+namespace lua {
+    /// @brief Accumulated execution time of a script handler (event or
+    /// entity component callback). Main thread only
+    struct HandlerTiming {
+        /// @brief Handler name: event name or 'component.callback'
+        std::string name;
+        int64_t calls = 0;
+        /// @brief Total execution time (microseconds)
+        int64_t total = 0;
+        /// @brief Max execution time (microseconds)
+        int64_t max = 0;
+        /// @brief Number of calls exceeded the budget
+        int64_t slowCalls = 0;
+        /// @brief Number of calls skipped by throttling
+        int64_t skipped = 0;
+    };
+
+    /// @brief Get id of the handler timing, created on the first request
+    size_t get_handler_timing(const std::string& name);
+
+    /// @brief Set time budget of a handler call. Slow calls are reported,
+    /// slow throttled handlers are skipped for the number of calls
+    /// proportional to the budget excess (see is_handler_throttled)
+    /// @param micros budget in microseconds, 0 - disabled
+    /// @param throttle enable throttling
+    void set_handler_budget(int64_t micros, bool throttle);
+
+    /// @brief Check if the handler call must be skipped. Used by tick
+    /// events only: others are never skipped
+    bool is_handler_throttled(size_t id);
+
+    /// @brief Get timings of the handlers with greatest total time
+    std::vector<HandlerTiming> get_slowest_handlers(size_t count);
+
+    void reset_handler_timings();
+
+    /// @brief Records execution time of the scope to the handler timing
+    class HandlerTimer {
+        size_t id;
+        timeutil::Timer timer;
+    public:
+        HandlerTimer(size_t id) : id(id) {
+        }
+
+        ~HandlerTimer();
+    };
+}
@@ -1,5 +1,6 @@
 #include "lua_util.hpp"
 
+#include <atomic>
 #include <iomanip>
 #include <iostream>
 
@@ -7,7 +8,9 @@
 
 using namespace lua;
 
-static int nextEnvironment = 1;
+/// @brief Environments of states in different threads are created
+/// concurrently
+static std::atomic<int> nextEnvironment = 1;
 
 std::unordered_map<std::type_index, std::string> lua::usertypeNames;
 
@@ -18,6 +18,37 @@ namespace lua {
     extern std::unordered_map<std::type_index, std::string> usertypeNames;
     int userdata_destructor(lua::State* L);
 
+    /// @brief Get userdata of the exact type
+    /// @return nullptr if the value is not a T userdata
+    template <class T>
+    inline T* tousertype(lua::State* L, int idx) {
+        if (lua_type(L, idx) != LUA_TUSERDATA) {
+            return nullptr;
+        }
+        auto data = static_cast<Userdata*>(lua_touserdata(L, idx));
+        if (&data->getTypeName() != &T::TYPENAME) {
+            return nullptr;
+        }
+        return static_cast<T*>(data);
+    }
+
+    /// @brief Get length of an array or a vector/matrix userdata
+    inline size_t arraylen(lua::State* L, int idx) {
+        if (lua_type(L, idx) != LUA_TUSERDATA) {
+            return objlen(L, idx);
+        }
+        if (tousertype<LuaVec2>(L, idx)) {
+            return 2;
+        } else if (tousertype<LuaVec3>(L, idx)) {
+            return 3;
+        } else if (tousertype<LuaVec4>(L, idx)) {
+            return 4;
+        } else if (tousertype<LuaMat4>(L, idx)) {
+            return 16;
+        }
+        return objlen(L, idx);
+    }
+
     std::string env_name(int env);
 
     inline bool getglobal(lua::State* L, const std::string& name) {
@@ -122,6 +153,11 @@ namespace lua {
         return 1;
     }
     inline int setquat(lua::State* L, int idx, glm::quat quat) {
+        if (auto vec = tousertype<LuaVec4>(L, idx)) {
+            vec->vec() = glm::vec4(quat.w, quat.x, quat.y, quat.z);
+            pushvalue(L, idx);
+            return 1;
+        }
         pushvalue(L, idx);
 
         pushnumber(L, quat.w);
@@ -150,6 +186,11 @@ namespace lua {
     }
     /// @brief pushes matrix table to the stack and updates it with glm matrix
     inline int setmat4(lua::State* L, int idx, glm::mat4 matrix) {
+        if (auto mat = tousertype<LuaMat4>(L, idx)) {
+            mat->mat() = matrix;
+            pushvalue(L, idx);
+            return 1;
+        }
         pushvalue(L, idx);
         for (uint y = 0; y < 4; y++) {
             for (uint x = 0; x < 4; x++) {
@@ -162,6 +203,11 @@ namespace lua {
     }
     template <int n>
     inline int setvec(lua::State* L, int idx, glm::vec<n, float> vec) {
+        if (auto dst = tousertype<LuaVector<n>>(L, idx)) {
+            dst->vec() = vec;
+            pushvalue(L, idx);
+            return 1;
+        }
         pushvalue(L, idx);
         for (int i = 0; i < n; i++) {
             pushnumber(L, vec[i]);
@@ -279,7 +325,9 @@ namespace lua {
     inline std::enable_if_t<std::is_base_of_v<Userdata, T>> 
     newusertype(lua::State* L) {
         const std::string& name = T::TYPENAME;
-        usertypeNames[typeid(T)] = name;
+        // states of other threads read names concurrently, so registered
+        // entries are not overwritten
+        usertypeNames.try_emplace(typeid(T), name);
         T::createMetatable(L);
 
         pushcfunction(L, userdata_destructor);
@@ -290,6 +338,9 @@ namespace lua {
 
     template <int n>
     inline glm::vec<n, float> tovec(lua::State* L, int idx) {
+        if (auto vec = tousertype<LuaVector<n>>(L, idx)) {
+            return vec->vec();
+        }
         pushvalue(L, idx);
         if (!istable(L, idx) || objlen(L, idx) < n) {
             throw std::runtime_error(
@@ -307,6 +358,9 @@ namespace lua {
     }
 
     inline glm::vec2 tovec2(lua::State* L, int idx) {
+        if (auto vec = tousertype<LuaVec2>(L, idx)) {
+            return vec->vec();
+        }
         pushvalue(L, idx);
         if (!istable(L, idx) || objlen(L, idx) < 2) {
             throw std::runtime_error("value must be an array of two numbers");
@@ -321,6 +375,9 @@ namespace lua {
         return glm::vec2(x, y);
     }
     inline glm::vec3 tovec3(lua::State* L, int idx) {
+        if (auto vec = tousertype<LuaVec3>(L, idx)) {
+            return vec->vec();
+        }
         pushvalue(L, idx);
         if (!istable(L, idx) || objlen(L, idx) < 3) {
             throw std::runtime_error("value must be an array of three numbers");
@@ -338,6 +395,9 @@ namespace lua {
         return glm::vec3(x, y, z);
     }
     inline glm::vec4 tovec4(lua::State* L, int idx) {
+        if (auto vec = tousertype<LuaVec4>(L, idx)) {
+            return vec->vec();
+        }
         pushvalue(L, idx);
         if (!istable(L, idx) || objlen(L, idx) < 4) {
             throw std::runtime_error("value must be an array of four numbers");
@@ -359,6 +419,11 @@ namespace lua {
     }
 
     inline glm::quat toquat(lua::State* L, int idx) {
+        if (auto vec = tousertype<LuaVec4>(L, idx)) {
+            // same components order as in the table: w, x, y, z
+            const auto& v = vec->vec();
+            return glm::quat(v[1], v[2], v[3], v[0]);
+        }
         pushvalue(L, idx);
         if (!istable(L, idx) || objlen(L, idx) < 4) {
             throw std::runtime_error("value must be an array of four numbers");
@@ -394,6 +459,9 @@ namespace lua {
         );
     }
     inline glm::mat4 tomat4(lua::State* L, int idx) {
+        if (auto mat = tousertype<LuaMat4>(L, idx)) {
+            return mat->mat();
+        }
         pushvalue(L, idx);
         if (!istable(L, idx) || objlen(L, idx) < 16) {
             throw std::runtime_error("value must be an array of 16 numbers");
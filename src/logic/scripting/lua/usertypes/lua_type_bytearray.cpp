@@ -1,17 +1,21 @@
 #include "../lua_custom_types.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
+#include "util/data_io.hpp"
 #include "util/listutil.hpp"
 #include "../lua_util.hpp"
 
 using namespace lua;
 
-LuaBytearray::LuaBytearray(size_t capacity) : buffer(capacity) {
-    buffer.resize(capacity);
+LuaBytearray::LuaBytearray(size_t capacity)
+    : buffer(std::make_shared<std::vector<ubyte>>(capacity)) {
 }
 
-LuaBytearray::LuaBytearray(std::vector<ubyte> buffer) : buffer(std::move(buffer)) {
+LuaBytearray::LuaBytearray(std::vector<ubyte> buffer)
+    : buffer(std::make_shared<std::vector<ubyte>>(std::move(buffer))) {
 }
 
 LuaBytearray::~LuaBytearray() {
@@ -73,10 +77,153 @@ static int l_remove(lua::State* L) {
     return 0;
 }
 
+static LuaBytearray& require_bytearray(lua::State* L, int idx) {
+    if (auto buffer = touserdata<LuaBytearray>(L, idx)) {
+        return *buffer;
+    }
+    throw std::runtime_error("Bytearray expected");
+}
+
+/// @brief Get zero based [begin, end) range of the size from optional
+/// inclusive one based arguments
+static std::pair<size_t, size_t> get_range(
+    lua::State* L, int idx, size_t size
+) {
+    lua::Integer from = isnoneornil(L, idx) ? 1 : tointeger(L, idx);
+    lua::Integer to = isnoneornil(L, idx + 1)
+                          ? static_cast<lua::Integer>(size)
+                          : tointeger(L, idx + 1);
+    if (from < 1 || to > static_cast<lua::Integer>(size) || from > to + 1) {
+        throw std::runtime_error("range out of bounds");
+    }
+    return {static_cast<size_t>(from - 1), static_cast<size_t>(to)};
+}
+
+static int l_fill(lua::State* L) {
+    auto& data = require_bytearray(L, 1).data();
+    auto value = static_cast<ubyte>(tointeger(L, 2));
+    auto [begin, end] = get_range(L, 3, data.size());
+    std::fill(data.begin() + begin, data.begin() + end, value);
+    return 0;
+}
+
+/// @brief Copy source bytes range to the index (overlapping is allowed)
+static int l_copy(lua::State* L) {
+    auto& data = require_bytearray(L, 1).data();
+    auto& src = require_bytearray(L, 2).data();
+    auto index = isnoneornil(L, 3) ? 1 : tointeger(L, 3);
+    auto [begin, end] = get_range(L, 4, src.size());
+    if (index < 1 || index - 1 + end - begin > data.size()) {
+        throw std::runtime_error("destination out of bounds");
+    }
+    std::memmove(data.data() + index - 1, src.data() + begin, end - begin);
+    return 0;
+}
+
+/// @brief Find a byte or a bytes sequence
+/// @return one based index or nil
+static int l_find(lua::State* L) {
+    auto& data = require_bytearray(L, 1).data();
+    auto from = isnoneornil(L, 3) ? 1 : tointeger(L, 3);
+    if (from < 1 || static_cast<size_t>(from) > data.size() + 1) {
+        throw std::runtime_error("index out of bounds");
+    }
+    auto begin = data.begin() + from - 1;
+    std::vector<ubyte>::iterator found;
+    if (isnumber(L, 2)) {
+        auto value = static_cast<ubyte>(tointeger(L, 2));
+        found = std::find(begin, data.end(), value);
+    } else {
+        auto& pattern = require_bytearray(L, 2).data();
+        found = std::search(begin, data.end(), pattern.begin(), pattern.end());
+    }
+    if (found == data.end()) {
+        return 0;
+    }
+    return pushinteger(L, found - data.begin() + 1);
+}
+
+/// @brief Compare bytes lexicographically
+/// @return -1, 0 or 1
+static int l_compare(lua::State* L) {
+    auto& a = require_bytearray(L, 1).data();
+    auto& b = require_bytearray(L, 2).data();
+    size_t common = std::min(a.size(), b.size());
+    int result = common ? std::memcmp(a.data(), b.data(), common) : 0;
+    if (result == 0) {
+        result = a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+    }
+    return pushinteger(L, result < 0 ? -1 : (result > 0 ? 1 : 0));
+}
+
+/// @brief Combine other array bytes with the bytes starting from the index
+template <class Op>
+static int combine(lua::State* L, Op op) {
+    auto& data = require_bytearray(L, 1).data();
+    auto& other = require_bytearray(L, 2).data();
+    auto index = isnoneornil(L, 3) ? 1 : tointeger(L, 3);
+    if (index < 1 || index - 1 + other.size() > data.size()) {
+        throw std::runtime_error("range out of bounds");
+    }
+    ubyte* dst = data.data() + index - 1;
+    for (size_t i = 0; i < other.size(); i++) {
+        dst[i] = op(dst[i], other[i]);
+    }
+    return 0;
+}
+
+static int l_xor(lua::State* L) {
+    return combine(L, [](ubyte a, ubyte b) { return a ^ b; });
+}
+
+/// @brief Add other array bytes (modulo 256)
+static int l_add(lua::State* L) {
+    return combine(L, [](ubyte a, ubyte b) {
+        return static_cast<ubyte>(a + b);
+    });
+}
+
+static const std::unordered_map<std::string, LuaBytearrayView::ElementType>
+    element_types {
+        {"u8", LuaBytearrayView::ElementType::U8},
+        {"i8", LuaBytearrayView::ElementType::I8},
+        {"u16", LuaBytearrayView::ElementType::U16},
+        {"i16", LuaBytearrayView::ElementType::I16},
+        {"u32", LuaBytearrayView::ElementType::U32},
+        {"i32", LuaBytearrayView::ElementType::I32},
+        {"f32", LuaBytearrayView::ElementType::F32},
+        {"f64", LuaBytearrayView::ElementType::F64},
+    };
+
+/// @brief Create typed view: view(type, [bigendian=false], [offset=0])
+static int l_view(lua::State* L) {
+    auto& buffer = require_bytearray(L, 1);
+    std::string name = require_string(L, 2);
+    auto found = element_types.find(name);
+    if (found == element_types.end()) {
+        throw std::runtime_error("unknown element type '" + name + "'");
+    }
+    bool bigEndian = toboolean(L, 3);
+    auto offset = isnoneornil(L, 4) ? 0 : tointeger(L, 4);
+    if (offset < 0) {
+        throw std::runtime_error("negative offset");
+    }
+    return newuserdata<LuaBytearrayView>(
+        L, buffer.getBuffer(), found->second, bigEndian, offset
+    );
+}
+
 static std::unordered_map<std::string, lua_CFunction> methods {
     {"append", lua::wrap<l_append>},
     {"insert", lua::wrap<l_insert>},
     {"remove", lua::wrap<l_remove>},
+    {"fill", lua::wrap<l_fill>},
+    {"copy", lua::wrap<l_copy>},
+    {"find", lua::wrap<l_find>},
+    {"compare", lua::wrap<l_compare>},
+    {"xor", lua::wrap<l_xor>},
+    {"add", lua::wrap<l_add>},
+    {"view", lua::wrap<l_view>},
 };
 
 static int l_meta_meta_call(lua::State* L) {
@@ -201,3 +348,153 @@ int LuaBytearray::createMetatable(lua::State* L) {
     setmetatable(L);
     return 1;
 }
+
+LuaBytearrayView::LuaBytearrayView(
+    std::shared_ptr<std::vector<ubyte>> buffer,
+    ElementType type,
+    bool bigEndian,
+    size_t offset
+)
+    : buffer(std::move(buffer)),
+      type(type),
+      bigEndian(bigEndian),
+      offset(offset) {
+}
+
+LuaBytearrayView::~LuaBytearrayView() {
+}
+
+size_t LuaBytearrayView::getElementSize() const {
+    switch (type) {
+        case ElementType::U8:
+        case ElementType::I8:
+            return 1;
+        case ElementType::U16:
+        case ElementType::I16:
+            return 2;
+        case ElementType::U32:
+        case ElementType::I32:
+        case ElementType::F32:
+            return 4;
+        case ElementType::F64:
+            return 8;
+    }
+    return 1;
+}
+
+size_t LuaBytearrayView::size() const {
+    if (buffer->size() <= offset) {
+        return 0;
+    }
+    return (buffer->size() - offset) / getElementSize();
+}
+
+template <typename T>
+static T read_element(const ubyte* src, bool bigEndian) {
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    if (bigEndian != dataio::is_big_endian()) {
+        value = dataio::swap(value);
+    }
+    return value;
+}
+
+template <typename T>
+static void write_element(ubyte* dst, T value, bool bigEndian) {
+    if (bigEndian != dataio::is_big_endian()) {
+        value = dataio::swap(value);
+    }
+    std::memcpy(dst, &value, sizeof(T));
+}
+
+double LuaBytearrayView::get(size_t index) const {
+    const ubyte* src = buffer->data() + offset + index * getElementSize();
+    switch (type) {
+        case ElementType::U8:
+            return *src;
+        case ElementType::I8:
+            return static_cast<int8_t>(*src);
+        case ElementType::U16:
+            return read_element<uint16_t>(src, bigEndian);
+        case ElementType::I16:
+            return read_element<int16_t>(src, bigEndian);
+        case ElementType::U32:
+            return read_element<uint32_t>(src, bigEndian);
+        case ElementType::I32:
+            return read_element<int32_t>(src, bigEndian);
+        case ElementType::F32:
+            return read_element<float>(src, bigEndian);
+        case ElementType::F64:
+            return read_element<double>(src, bigEndian);
+    }
+    return 0.0;
+}
+
+void LuaBytearrayView::set(size_t index, double value) {
+    ubyte* dst = buffer->data() + offset + index * getElementSize();
+    // integers are wrapped like in C
+    auto integer = static_cast<int64_t>(value);
+    switch (type) {
+        case ElementType::U8:
+        case ElementType::I8:
+            *dst = static_cast<ubyte>(integer);
+            break;
+        case ElementType::U16:
+        case ElementType::I16:
+            write_element(dst, static_cast<uint16_t>(integer), bigEndian);
+            break;
+        case ElementType::U32:
+        case ElementType::I32:
+            write_element(dst, static_cast<uint32_t>(integer), bigEndian);
+            break;
+        case ElementType::F32:
+            write_element(dst, static_cast<float>(value), bigEndian);
+            break;
+        case ElementType::F64:
+            write_element(dst, value, bigEndian);
+            break;
+    }
+}
+
+static int l_view_meta_index(lua::State* L) {
+    auto view = touserdata<LuaBytearrayView>(L, 1);
+    if (view == nullptr || !isnumber(L, 2)) {
+        return 0;
+    }
+    auto index = tointeger(L, 2) - 1;
+    if (index < 0 || static_cast<size_t>(index) >= view->size()) {
+        return 0;
+    }
+    return pushnumber(L, view->get(index));
+}
+
+static int l_view_meta_newindex(lua::State* L) {
+    auto view = touserdata<LuaBytearrayView>(L, 1);
+    if (view == nullptr) {
+        return 0;
+    }
+    auto index = tointeger(L, 2) - 1;
+    if (index < 0 || static_cast<size_t>(index) >= view->size()) {
+        throw std::runtime_error("index out of bounds");
+    }
+    view->set(index, tonumber(L, 3));
+    return 0;
+}
+
+static int l_view_meta_len(lua::State* L) {
+    if (auto view = touserdata<LuaBytearrayView>(L, 1)) {
+        return pushinteger(L, view->size());
+    }
+    return 0;
+}
+
+int LuaBytearrayView::createMetatable(lua::State* L) {
+    createtable(L, 0, 3);
+    pushcfunction(L, lua::wrap<l_view_meta_index>);
+    setfield(L, "__index");
+    pushcfunction(L, lua::wrap<l_view_meta_newindex>);
+    setfield(L, "__newindex");
+    pushcfunction(L, lua::wrap<l_view_meta_len>);
+    setfield(L, "__len");
+    return 1;
+}
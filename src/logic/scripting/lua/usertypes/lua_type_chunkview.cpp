@@ -0,0 +1,178 @@
+#include "../lua_custom_types.hpp"
+
+#include "../lua_util.hpp"
+
+#include "content/Content.hpp"
+#include "lighting/Lighting.hpp"
+#include "logic/scripting/scripting.hpp"
+#include "util/stringutil.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "world/Level.hpp"
+
+using namespace lua;
+
+LuaChunkView::LuaChunkView(const std::shared_ptr<Chunk>& chunk, bool readonly)
+    : chunk(chunk), readonly(readonly) {
+}
+
+LuaChunkView::~LuaChunkView() {
+}
+
+static std::shared_ptr<Chunk> require_chunk(LuaChunkView& view) {
+    if (auto chunk = view.getChunk()) {
+        return chunk;
+    }
+    throw std::runtime_error("chunk is unloaded");
+}
+
+static std::shared_ptr<Chunk> require_writeable_chunk(LuaChunkView& view) {
+    if (view.isReadonly()) {
+        throw std::runtime_error("chunk view is read-only");
+    }
+    return require_chunk(view);
+}
+
+/// @brief Read local voxel coordinates at the stack position
+/// @return voxel index
+static uint require_index(lua::State* L, int idx) {
+    auto x = tointeger(L, idx);
+    auto y = tointeger(L, idx + 1);
+    auto z = tointeger(L, idx + 2);
+    if (x < 0 || y < 0 || z < 0 || x >= CHUNK_W || y >= CHUNK_H ||
+        z >= CHUNK_D) {
+        throw std::runtime_error("local position is out of chunk");
+    }
+    return vox_index(x, y, z);
+}
+
+static int l_is_valid(lua::State* L) {
+    if (auto view = touserdata<LuaChunkView>(L, 1)) {
+        return pushboolean(L, view->getChunk() != nullptr);
+    }
+    return 0;
+}
+
+static int l_is_modified(lua::State* L) {
+    if (auto view = touserdata<LuaChunkView>(L, 1)) {
+        return pushboolean(L, view->isModified());
+    }
+    return 0;
+}
+
+static int l_get(lua::State* L) {
+    if (auto view = touserdata<LuaChunkView>(L, 1)) {
+        auto chunk = require_chunk(*view);
+        return pushinteger(L, chunk->voxels[require_index(L, 2)].id);
+    }
+    return 0;
+}
+
+static int l_get_states(lua::State* L) {
+    if (auto view = touserdata<LuaChunkView>(L, 1)) {
+        auto chunk = require_chunk(*view);
+        const auto& vox = chunk->voxels[require_index(L, 2)];
+        return pushinteger(L, blockstate2int(vox.state));
+    }
+    return 0;
+}
+
+static int l_set(lua::State* L) {
+    if (auto view = touserdata<LuaChunkView>(L, 1)) {
+        auto chunk = require_writeable_chunk(*view);
+        uint index = require_index(L, 2);
+        auto id = tointeger(L, 5);
+        if (id < 0 ||
+            static_cast<size_t>(id) >=
+                scripting::content->getIndices()->blocks.count()) {
+            throw std::runtime_error("invalid block id");
+        }
+        auto& chunks = *scripting::level->chunks;
+        if (chunks.getChunk(chunk->x, chunk->z) != chunk.get()) {
+            throw std::runtime_error("chunk is unloaded");
+        }
+        // lights are updated by commit for the whole chunk
+        chunks.set(
+            chunk->x * CHUNK_W + index % CHUNK_W,
+            index / (CHUNK_W * CHUNK_D),
+            chunk->z * CHUNK_D + index / CHUNK_W % CHUNK_D,
+            static_cast<blockid_t>(id),
+            int2blockstate(gettop(L) >= 6 ? tointeger(L, 6) : 0)
+        );
+        view->setModified(true);
+    }
+    return 0;
+}
+
+static int l_get_light(lua::State* L) {
+    if (auto view = touserdata<LuaChunkView>(L, 1)) {
+        auto chunk = require_chunk(*view);
+        uint index = require_index(L, 2);
+        auto channel = tointeger(L, 5);
+        if (channel < 0 || channel > 3) {
+            throw std::runtime_error("invalid light channel");
+        }
+        auto light = chunk->lightmap.get(index);
+        return pushinteger(L, (light >> (channel << 2)) & 0xF);
+    }
+    return 0;
+}
+
+static int l_commit(lua::State* L) {
+    if (auto view = touserdata<LuaChunkView>(L, 1)) {
+        auto chunk = require_writeable_chunk(*view);
+        // blocks are set by Chunks::set, so changes are tracked already
+        if (view->isModified()) {
+            scripting::level->lighting->onChunkDataChanged(
+                chunk->x, chunk->z
+            );
+            view->setModified(false);
+        }
+    }
+    return 0;
+}
+
+static std::unordered_map<std::string, lua_CFunction> methods {
+    {"is_valid", lua::wrap<l_is_valid>},
+    {"is_modified", lua::wrap<l_is_modified>},
+    {"get", lua::wrap<l_get>},
+    {"get_states", lua::wrap<l_get_states>},
+    {"set", lua::wrap<l_set>},
+    {"get_light", lua::wrap<l_get_light>},
+    {"commit", lua::wrap<l_commit>},
+};
+
+static int l_meta_tostring(lua::State* L) {
+    return pushstring(L, "ChunkView(0x" + util::tohex(
+        reinterpret_cast<uint64_t>(topointer(L, 1)))+")");
+}
+
+static int l_meta_index(lua::State* L) {
+    auto view = touserdata<LuaChunkView>(L, 1);
+    if (view == nullptr) {
+        return 0;
+    }
+    if (isstring(L, 2)) {
+        auto fieldname = tostring(L, 2);
+        if (!std::strcmp(fieldname, "x")) {
+            return pushinteger(L, require_chunk(*view)->x);
+        } else if (!std::strcmp(fieldname, "z")) {
+            return pushinteger(L, require_chunk(*view)->z);
+        } else {
+            auto found = methods.find(fieldname);
+            if (found != methods.end()) {
+                return pushcfunction(L, found->second);
+            }
+        }
+    }
+    return 0;
+}
+
+int LuaChunkView::createMetatable(lua::State* L) {
+    createtable(L, 0, 2);
+    pushcfunction(L, lua::wrap<l_meta_tostring>);
+    setfield(L, "__tostring");
+    pushcfunction(L, lua::wrap<l_meta_index>);
+    setfield(L, "__index");
+    return 1;
+}
@@ -4,10 +4,12 @@
 #include <sstream>
 #include <iomanip>
 #include <filesystem>
+#include <type_traits>
 
-#include "util/functional_util.hpp"
-#define FNL_IMPL
 #include "maths/FastNoiseLite.h"
+#include "maths/noise.hpp"
+#include "maths/simd.hpp"
+#include "maths/HeightmapExpression.hpp"
 #include "coders/imageio.hpp"
 #include "files/util.hpp"
 #include "graphics/core/ImageData.hpp"
@@ -82,7 +84,7 @@ static int l_at(lua::State* L) {
     return 0;
 }
 
-template<fnl_noise_type noise_type>
+template<noise::NoiseType noise_type>
 static int l_noise(lua::State* L) {
     if (auto heightmap = touserdata<LuaHeightmap>(L, 1)) {
         uint w = heightmap->getWidth();
@@ -109,116 +111,187 @@ static int l_noise(lua::State* L) {
         if (gettop(L) > 6) {
             shiftMapY = touserdata<LuaHeightmap>(L, 7);
         }
-        noise->noise_type = noise_type;
-        for (uint y = 0; y < h; y++) {
-            for (uint x = 0; x < w; x++) {
-                uint i = y * w + x;
-                for (uint c = 0; c < octaves; c++) {
-                    float m = s * (1 << c);
-                    float value = heights[i];
-                    float u = (x + offset.x) * m;
-                    float v = (y + offset.y) * m;
-                    if (shiftMapX) {
-                        u += shiftMapX->getValues()[i];
-                    }
-                    if (shiftMapY) {
-                        v += shiftMapY->getValues()[i];
-                    }
-
-                    value += fnlGetNoise2D(noise, u, v) /
-                            static_cast<float>(1 << c) * multiplier;
-                    heights[i] = value;
-                }
-            }
-        }
+        noise::add_fractal(
+            noise_type,
+            noise->seed,
+            noise->frequency,
+            heights,
+            w,
+            h,
+            offset,
+            s,
+            octaves,
+            multiplier,
+            shiftMapX ? shiftMapX->getValues() : nullptr,
+            shiftMapY ? shiftMapY->getValues() : nullptr
+        );
     }
     return 0;
 }
 
-template<template<class> class Op>
-static int l_binop_func(lua::State* L) {
-    Op<float> op;
-    if (auto heightmap = touserdata<LuaHeightmap>(L, 1)) {
-        uint w = heightmap->getWidth();
-        uint h = heightmap->getHeight();
-        auto heights = heightmap->getValues();
+/// @brief Heightmap values or a number operand of elementwise operations
+struct Operand {
+    const float* values;
+    float scalar;
 
-        if (isnumber(L, 2)) {
-            float scalar = tonumber(L, 2);
-            for (uint y = 0; y < h; y++) {
-                for (uint x = 0; x < w; x++) {
-                    uint i = y * w + x;
-                    heights[i] = op(heights[i], scalar);
-                }
-            }
-        } else {
-            auto map = touserdata<LuaHeightmap>(L, 2);
-            for (uint y = 0; y < h; y++) {
-                for (uint x = 0; x < w; x++) {
-                    uint i = y * w + x;
-                    heights[i] = op(heights[i], map->getValues()[i]);
-                }
-            }
+    simd::float4 load(uint i) const {
+        return values ? simd::load(values + i) : simd::set1(scalar);
+    }
+
+    float get(uint i) const {
+        return values ? values[i] : scalar;
+    }
+};
+
+static Operand to_operand(
+    lua::State* L, int idx, const LuaHeightmap& heightmap
+) {
+    if (isnumber(L, idx)) {
+        return Operand {nullptr, static_cast<float>(tonumber(L, idx))};
+    }
+    auto map = touserdata<LuaHeightmap>(L, idx);
+    if (map == nullptr) {
+        throw std::runtime_error("heightmap or number expected");
+    }
+    if (map->getWidth() != heightmap.getWidth() ||
+        map->getHeight() != heightmap.getHeight()) {
+        throw std::runtime_error("heightmaps sizes mismatch");
+    }
+    return Operand {map->getValues(), 0.0f};
+}
+
+// Elementwise operations for floats and simd::float4 (if invocable)
+namespace ops {
+    struct add {
+        template <class T>
+        T operator()(T a, T b) const { return a + b; }
+    };
+    struct sub {
+        template <class T>
+        T operator()(T a, T b) const { return a - b; }
+    };
+    struct mul {
+        template <class T>
+        T operator()(T a, T b) const { return a * b; }
+    };
+    struct min {
+        template <class T>
+        T operator()(T a, T b) const { return simd::min(a, b); }
+    };
+    struct max {
+        template <class T>
+        T operator()(T a, T b) const { return simd::max(a, b); }
+    };
+    struct abs {
+        template <class T>
+        T operator()(T a) const { return simd::abs(a); }
+    };
+    struct pow {
+        float operator()(float a, float b) const { return glm::pow(a, b); }
+    };
+    struct mix {
+        float operator()(float a, float b, float t) const {
+            return a * (1.0f - t) + b * t;
+        }
+        simd::float4 operator()(
+            simd::float4 a, simd::float4 b, simd::float4 t
+        ) const {
+            return a * (simd::set1(1.0f) - t) + b * t;
+        }
+    };
+}
+
+/// @brief Apply operation to every value: values[i] = op(values[i], ...)
+template <class Op, class... Operands>
+static void apply_op(float* values, uint count, const Operands&... args) {
+    Op op;
+    uint i = 0;
+    if constexpr (std::is_invocable_v<
+                      Op,
+                      simd::float4,
+                      decltype(args.load(0))...>) {
+        for (; i + simd::LANES <= count; i += simd::LANES) {
+            simd::store(
+                values + i, op(simd::load(values + i), args.load(i)...)
+            );
         }
     }
+    for (; i < count; i++) {
+        values[i] = op(values[i], args.get(i)...);
+    }
+}
+
+template<class Op>
+static int l_binop_func(lua::State* L) {
+    if (auto heightmap = touserdata<LuaHeightmap>(L, 1)) {
+        uint count = heightmap->getWidth() * heightmap->getHeight();
+        apply_op<Op>(
+            heightmap->getValues(), count, to_operand(L, 2, *heightmap)
+        );
+    }
     return 0;
 }
 
 static int l_mixin(lua::State* L) {
     if (auto heightmap = touserdata<LuaHeightmap>(L, 1)) {
-        uint w = heightmap->getWidth();
-        uint h = heightmap->getHeight();
-        auto heights = heightmap->getValues();
-
-        if (isnumber(L, 2)) {
-            float scalar = tonumber(L, 2);
-            if (isnumber(L, 3)) {
-                float t = tonumber(L, 3);
-                for (uint i = 0; i < w * h; i++) {
-                    heights[i] = heights[i] * (1.0f - t) + scalar * t;
-                }
-            } else {
-                auto tmap = touserdata<LuaHeightmap>(L, 3);
-                auto tmapvalues = tmap->getValues();
-                for (uint i = 0; i < w * h; i++) {
-                    float t = tmapvalues[i];
-                    heights[i] = heights[i] * (1.0f - t) + scalar * t;
-                }
-            }
-        } else {
-            auto map = touserdata<LuaHeightmap>(L, 2);
-            auto mapvalues = map->getValues();
-            if (isnumber(L, 3)) {
-                float t = tonumber(L, 3);
-                for (uint i = 0; i < w * h; i++) {
-                    heights[i] = heights[i] * (1.0f - t) + mapvalues[i] * t;
-                }
-            } else {
-                auto tmap = touserdata<LuaHeightmap>(L, 3);
-                auto tmapvalues = tmap->getValues();
-                for (uint i = 0; i < w * h; i++) {
-                    float t = tmapvalues[i];
-                    heights[i] = heights[i] * (1.0f - t) + mapvalues[i] * t;
-                }
-            }
-        }
+        uint count = heightmap->getWidth() * heightmap->getHeight();
+        apply_op<ops::mix>(
+            heightmap->getValues(),
+            count,
+            to_operand(L, 2, *heightmap),
+            to_operand(L, 3, *heightmap)
+        );
     }
     return 0;
 }
 
-template<template<class> class Op>
+template<class Op>
 static int l_unaryop_func(lua::State* L) {
-    Op<float> op;
     if (auto heightmap = touserdata<LuaHeightmap>(L, 1)) {
-        uint w = heightmap->getWidth();
-        uint h = heightmap->getHeight();
-        auto heights = heightmap->getValues();
-        for (uint y = 0; y < h; y++) {
-            for (uint x = 0; x < w; x++) {
-                uint i = y * w + x;
-                heights[i] = op(heights[i]);
+        uint count = heightmap->getWidth() * heightmap->getHeight();
+        apply_op<Op>(heightmap->getValues(), count);
+    }
+    return 0;
+}
+
+static int l_clamp(lua::State* L) {
+    if (auto heightmap = touserdata<LuaHeightmap>(L, 1)) {
+        uint count = heightmap->getWidth() * heightmap->getHeight();
+        auto values = heightmap->getValues();
+        apply_op<ops::max>(values, count, to_operand(L, 2, *heightmap));
+        apply_op<ops::min>(values, count, to_operand(L, 3, *heightmap));
+    }
+    return 0;
+}
+
+static int l_compute(lua::State* L) {
+    if (auto heightmap = touserdata<LuaHeightmap>(L, 1)) {
+        auto source = require_lstring(L, 2);
+        std::unordered_map<std::string, HeightmapExpression::Variable>
+            variables;
+        if (istable(L, 3)) {
+            pushvalue(L, 3);
+            pushnil(L);
+            while (next(L, -2)) {
+                pushvalue(L, -2);
+                std::string name = tostring(L, -1);
+                pop(L);
+                auto operand = to_operand(L, -1, *heightmap);
+                if (operand.values) {
+                    variables[name] = operand.values;
+                } else {
+                    variables[name] = operand.scalar;
+                }
+                pop(L);
             }
+            pop(L);
         }
+        variables.try_emplace("value", heightmap->getValues());
+        HeightmapExpression expression(source, variables);
+        expression.evaluate(
+            heightmap->getValues(),
+            heightmap->getWidth() * heightmap->getHeight()
+        );
     }
     return 0;
 }
@@ -254,15 +327,18 @@ static int l_crop(lua::State* L) {
 
 static std::unordered_map<std::string, lua_CFunction> methods {
     {"dump", lua::wrap<l_dump>},
-    {"noise", lua::wrap<l_noise<FNL_NOISE_OPENSIMPLEX2>>},
-    {"cellnoise", lua::wrap<l_noise<FNL_NOISE_CELLULAR>>},
-    {"pow", lua::wrap<l_binop_func<util::pow>>},
-    {"add", lua::wrap<l_binop_func<std::plus>>},
-    {"sub", lua::wrap<l_binop_func<std::minus>>},
-    {"mul", lua::wrap<l_binop_func<std::multiplies>>},
-    {"min", lua::wrap<l_binop_func<util::min>>},
-    {"max", lua::wrap<l_binop_func<util::max>>},
-    {"abs", lua::wrap<l_unaryop_func<util::abs>>},
+    {"noise", lua::wrap<l_noise<noise::NoiseType::SIMPLEX>>},
+    {"perlinnoise", lua::wrap<l_noise<noise::NoiseType::PERLIN>>},
+    {"cellnoise", lua::wrap<l_noise<noise::NoiseType::CELLULAR>>},
+    {"pow", lua::wrap<l_binop_func<ops::pow>>},
+    {"add", lua::wrap<l_binop_func<ops::add>>},
+    {"sub", lua::wrap<l_binop_func<ops::sub>>},
+    {"mul", lua::wrap<l_binop_func<ops::mul>>},
+    {"min", lua::wrap<l_binop_func<ops::min>>},
+    {"max", lua::wrap<l_binop_func<ops::max>>},
+    {"abs", lua::wrap<l_unaryop_func<ops::abs>>},
+    {"clamp", lua::wrap<l_clamp>},
+    {"compute", lua::wrap<l_compute>},
     {"resize", lua::wrap<l_resize>},
     {"crop", lua::wrap<l_crop>},
     {"at", lua::wrap<l_at>},
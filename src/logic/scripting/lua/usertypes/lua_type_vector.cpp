@@ -0,0 +1,240 @@
+#include "../lua_custom_types.hpp"
+
+#include <cstring>
+#include <functional>
+#include <sstream>
+
+#include "../lua_util.hpp"
+
+using namespace lua;
+
+static const char COMPONENTS[] = "xyzw";
+
+/// @return vector component index of the key at the stack position or -1
+template <int n>
+static int component_index(lua::State* L, int idx) {
+    if (lua_type(L, idx) == LUA_TNUMBER) {
+        auto index = tointeger(L, idx) - 1;
+        return index >= 0 && index < n ? index : -1;
+    }
+    if (isstring(L, idx)) {
+        auto name = tostring(L, idx);
+        if (name[0] && !name[1]) {
+            if (auto found = std::strchr(COMPONENTS, name[0])) {
+                int index = found - COMPONENTS;
+                return index < n ? index : -1;
+            }
+        }
+    }
+    return -1;
+}
+
+/// @brief Push method of the library table as a field of the userdata
+static int push_method(lua::State* L, const std::string& libname) {
+    if (isstring(L, 2) && getglobal(L, libname)) {
+        if (getfield(L, tostring(L, 2))) {
+            return 1;
+        }
+        pop(L);
+    }
+    return 0;
+}
+
+template <int n>
+static glm::vec<n, float> tooperand(lua::State* L, int idx) {
+    if (lua_type(L, idx) == LUA_TNUMBER) {
+        return glm::vec<n, float>(tonumber(L, idx));
+    }
+    return tovec<n>(L, idx);
+}
+
+template <int n>
+static int l_vec_index(lua::State* L) {
+    auto vec = tousertype<LuaVector<n>>(L, 1);
+    if (vec == nullptr) {
+        return 0;
+    }
+    int index = component_index<n>(L, 2);
+    if (index >= 0) {
+        return pushnumber(L, vec->vec()[index]);
+    }
+    return push_method(L, "vec" + std::to_string(n));
+}
+
+template <int n>
+static int l_vec_newindex(lua::State* L) {
+    auto vec = tousertype<LuaVector<n>>(L, 1);
+    if (vec == nullptr) {
+        return 0;
+    }
+    int index = component_index<n>(L, 2);
+    if (index < 0) {
+        throw std::runtime_error("invalid vector component");
+    }
+    vec->vec()[index] = tonumber(L, 3);
+    return 0;
+}
+
+template <int n, template <class> class Op>
+static int l_vec_binop(lua::State* L) {
+    Op<glm::vec<n, float>> op;
+    return newuserdata<LuaVector<n>>(
+        L, op(tooperand<n>(L, 1), tooperand<n>(L, 2))
+    );
+}
+
+template <int n>
+static int l_vec_unm(lua::State* L) {
+    return newuserdata<LuaVector<n>>(L, -tovec<n>(L, 1));
+}
+
+template <int n>
+static int l_vec_eq(lua::State* L) {
+    return pushboolean(L, tovec<n>(L, 1) == tovec<n>(L, 2));
+}
+
+template <int n>
+static int l_vec_len(lua::State* L) {
+    return pushinteger(L, n);
+}
+
+template <int n>
+static int l_vec_tostring(lua::State* L) {
+    auto vec = tovec<n>(L, 1);
+    std::stringstream ss;
+    ss << "vec" << n << "{";
+    for (int i = 0; i < n; i++) {
+        if (i > 0) {
+            ss << ", ";
+        }
+        ss << vec[i];
+    }
+    ss << "}";
+    return pushstring(L, ss.str());
+}
+
+template <int n>
+int LuaVector<n>::createMetatable(lua::State* L) {
+    createtable(L, 0, 10);
+    pushcfunction(L, lua::wrap<l_vec_index<n>>);
+    setfield(L, "__index");
+    pushcfunction(L, lua::wrap<l_vec_newindex<n>>);
+    setfield(L, "__newindex");
+    pushcfunction(L, lua::wrap<l_vec_binop<n, std::plus>>);
+    setfield(L, "__add");
+    pushcfunction(L, lua::wrap<l_vec_binop<n, std::minus>>);
+    setfield(L, "__sub");
+    pushcfunction(L, lua::wrap<l_vec_binop<n, std::multiplies>>);
+    setfield(L, "__mul");
+    pushcfunction(L, lua::wrap<l_vec_binop<n, std::divides>>);
+    setfield(L, "__div");
+    pushcfunction(L, lua::wrap<l_vec_unm<n>>);
+    setfield(L, "__unm");
+    pushcfunction(L, lua::wrap<l_vec_eq<n>>);
+    setfield(L, "__eq");
+    pushcfunction(L, lua::wrap<l_vec_len<n>>);
+    setfield(L, "__len");
+    pushcfunction(L, lua::wrap<l_vec_tostring<n>>);
+    setfield(L, "__tostring");
+    return 1;
+}
+
+template class lua::LuaVector<2>;
+template class lua::LuaVector<3>;
+template class lua::LuaVector<4>;
+
+static int l_mat_index(lua::State* L) {
+    auto mat = tousertype<LuaMat4>(L, 1);
+    if (mat == nullptr) {
+        return 0;
+    }
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        auto index = tointeger(L, 2) - 1;
+        if (index >= 0 && index < 16) {
+            return pushnumber(L, mat->mat()[index / 4][index % 4]);
+        }
+        return 0;
+    }
+    return push_method(L, "mat4");
+}
+
+static int l_mat_newindex(lua::State* L) {
+    auto mat = tousertype<LuaMat4>(L, 1);
+    if (mat == nullptr) {
+        return 0;
+    }
+    auto index = tointeger(L, 2) - 1;
+    if (lua_type(L, 2) != LUA_TNUMBER || index < 0 || index >= 16) {
+        throw std::runtime_error("invalid matrix element index");
+    }
+    mat->mat()[index / 4][index % 4] = tonumber(L, 3);
+    return 0;
+}
+
+/// @brief mat * mat -> Mat4, mat * vec4 -> Vec4, mat * vec3 -> Vec3
+/// (w = 1), mat * number -> Mat4
+static int l_mat_mul(lua::State* L) {
+    if (lua_type(L, 1) == LUA_TNUMBER) {
+        return newuserdata<LuaMat4>(
+            L, tomat4(L, 2) * static_cast<float>(tonumber(L, 1))
+        );
+    }
+    auto matrix = tomat4(L, 1);
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        return newuserdata<LuaMat4>(
+            L, matrix * static_cast<float>(tonumber(L, 2))
+        );
+    }
+    switch (arraylen(L, 2)) {
+        case 3:
+            return newuserdata<LuaVec3>(
+                L, glm::vec3(matrix * glm::vec4(tovec3(L, 2), 1.0f))
+            );
+        case 4:
+            return newuserdata<LuaVec4>(L, matrix * tovec4(L, 2));
+        default:
+            return newuserdata<LuaMat4>(L, matrix * tomat4(L, 2));
+    }
+}
+
+static int l_mat_eq(lua::State* L) {
+    return pushboolean(L, tomat4(L, 1) == tomat4(L, 2));
+}
+
+static int l_mat_len(lua::State* L) {
+    return pushinteger(L, 16);
+}
+
+static int l_mat_tostring(lua::State* L) {
+    auto matrix = tomat4(L, 1);
+    std::stringstream ss;
+    ss << "mat4 {";
+    for (uint y = 0; y < 4; y++) {
+        for (uint x = 0; x < 4; x++) {
+            if (x > 0) {
+                ss << " ";
+            }
+            ss << matrix[y][x];
+        }
+        ss << "; ";
+    }
+    ss << "}";
+    return pushstring(L, ss.str());
+}
+
+int LuaMat4::createMetatable(lua::State* L) {
+    createtable(L, 0, 6);
+    pushcfunction(L, lua::wrap<l_mat_index>);
+    setfield(L, "__index");
+    pushcfunction(L, lua::wrap<l_mat_newindex>);
+    setfield(L, "__newindex");
+    pushcfunction(L, lua::wrap<l_mat_mul>);
+    setfield(L, "__mul");
+    pushcfunction(L, lua::wrap<l_mat_eq>);
+    setfield(L, "__eq");
+    pushcfunction(L, lua::wrap<l_mat_len>);
+    setfield(L, "__len");
+    pushcfunction(L, lua::wrap<l_mat_tostring>);
+    setfield(L, "__tostring");
+    return 1;
+}
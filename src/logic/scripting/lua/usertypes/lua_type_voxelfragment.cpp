@@ -3,6 +3,7 @@
 #include "../lua_util.hpp"
 
 #include "world/generator/VoxelFragment.hpp"
+#include "content/Content.hpp"
 #include "util/stringutil.hpp"
 #include "world/Level.hpp"
 
@@ -16,7 +17,10 @@ LuaVoxelFragment::~LuaVoxelFragment() {
 
 static int l_crop(lua::State* L) {
     if (auto fragment = touserdata<LuaVoxelFragment>(L, 1)) {
-        fragment->getFragment()->crop();
+        auto& voxelFragment = *fragment->getFragment();
+        voxelFragment.crop();
+        // crop invalidates runtime voxels used by place
+        voxelFragment.prepare(*scripting::content);
     }
     return 0;
 }
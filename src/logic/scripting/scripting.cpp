@@ -2,11 +2,15 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <unordered_set>
+
+#include <glm/gtx/hash.hpp>
 
 #include "scripting_commons.hpp"
 #include "content/Content.hpp"
 #include "content/ContentPack.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
 #include "engine.hpp"
 #include "files/engine_paths.hpp"
 #include "files/files.hpp"
@@ -15,6 +19,7 @@
 #include "items/ItemDef.hpp"
 #include "logic/BlocksController.hpp"
 #include "logic/LevelController.hpp"
+#include "lua/lua_bytecode.hpp"
 #include "lua/lua_engine.hpp"
 #include "lua/lua_custom_types.hpp"
 #include "maths/Heightmap.hpp"
@@ -24,7 +29,10 @@
 #include "util/stringutil.hpp"
 #include "util/timeutil.hpp"
 #include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
 #include "world/Level.hpp"
+#include "world/LevelEvents.hpp"
 
 using namespace scripting;
 
@@ -39,12 +47,17 @@ const ContentIndices* scripting::indices = nullptr;
 BlocksController* scripting::blocks = nullptr;
 LevelController* scripting::controller = nullptr;
 
+/// @brief Chunks shown and hidden since the last world tick, dispatched
+/// to world scripts as batches once a tick
+static std::unordered_set<glm::ivec2> loaded_chunks;
+static std::unordered_set<glm::ivec2> unloaded_chunks;
+
 void scripting::load_script(const fs::path& name, bool throwable) {
     auto paths = scripting::engine->getPaths();
     fs::path file = paths->getResourcesFolder() / fs::path("scripts") / name;
     std::string src = files::read_string(file);
     auto L = lua::get_main_state();
-    lua::loadbuffer(L, 0, src, "core:scripts/"+name.u8string());
+    lua::loadbuffer_cached(L, 0, src, "core:scripts/"+name.u8string());
     if (throwable) {
         lua::call(L, 0, 0);
     } else {
@@ -60,11 +73,20 @@ int scripting::load_script(
 ) {
     std::string src = files::read_string(file);
     logger.info() << "script (" << type << ") " << file.u8string();
-    return lua::execute(lua::get_main_state(), env, src, fileName);
+    auto L = lua::get_main_state();
+    lua::loadbuffer_cached(L, env, src, fileName);
+    return lua::call_nothrow(L, 0);
 }
 
 void scripting::initialize(Engine* engine) {
     scripting::engine = engine;
+    if (engine->getSettings().scripting.bytecodeCache.get()) {
+        lua::set_bytecode_cache(
+            engine->getPaths()->getUserFilesFolder() / "cache" / "scripts"
+        );
+    } else {
+        lua::set_bytecode_cache(fs::path());
+    }
     lua::initialize(*engine->getPaths());
 
     load_script(fs::path("stdlib.lua"), true);
@@ -150,12 +172,24 @@ void scripting::initialize(Engine* engine) {
 }
 
 void scripting::process_post_runnables() {
+    debug::ProfileZone zone("lua-post-runnables");
     auto L = lua::get_main_state();
     if (lua::getglobal(L, "__process_post_runnables")) {
         lua::call_nothrow(L, 0, 0);
     }
 }
 
+void scripting::update() {
+    const auto& settings = engine->getSettings().scripting;
+    lua::set_handler_budget(
+        settings.handlerBudget.get() * 1000, settings.throttleHandlers.get()
+    );
+    lua::update_gc(lua::GCSettings {
+        static_cast<int>(settings.gcPause.get()),
+        static_cast<int>(settings.gcStepMul.get()),
+        settings.gcFrameSteps.get()});
+}
+
 template <class T>
 static int push_properties_tables(
     lua::State* L, const ContentUnitIndices<T>& indices
@@ -204,6 +238,21 @@ void scripting::on_world_load(LevelController* controller) {
     scripting::blocks = controller->getBlocksController();
     scripting::controller = controller;
 
+    loaded_chunks.clear();
+    unloaded_chunks.clear();
+    level->events->listen(EVT_CHUNK_SHOWN, [](lvl_event_type, Chunk* chunk) {
+        glm::ivec2 pos(chunk->x, chunk->z);
+        unloaded_chunks.erase(pos);
+        loaded_chunks.insert(pos);
+    });
+    level->events->listen(EVT_CHUNK_HIDDEN, [](lvl_event_type, Chunk* chunk) {
+        glm::ivec2 pos(chunk->x, chunk->z);
+        // not reported loaded yet
+        if (loaded_chunks.erase(pos) == 0) {
+            unloaded_chunks.insert(pos);
+        }
+    });
+
     auto L = lua::get_main_state();
     if (lua::getglobal(L, "__vc_on_world_open")) {
         lua::call_nothrow(L, 0, 0);
@@ -214,10 +263,76 @@ void scripting::on_world_load(LevelController* controller) {
     }
 }
 
+/// @brief Emit chunks event with flat array {x1, z1, x2, z2, ...}
+/// and the chunks count to the packs having the handler
+template <class Container, class Predicate>
+static void emit_chunks_event(
+    const std::string& event, const Container& chunks, const Predicate& has
+) {
+    if (chunks.empty()) {
+        return;
+    }
+    auto args = [&chunks](lua::State* L) {
+        lua::createtable(L, chunks.size() * 2, 0);
+        int index = 1;
+        for (const auto& pos : chunks) {
+            lua::pushinteger(L, pos.x);
+            lua::rawseti(L, index++);
+            lua::pushinteger(L, pos.y);
+            lua::rawseti(L, index++);
+        }
+        lua::pushinteger(L, chunks.size());
+        return 2;
+    };
+    for (auto& [packid, pack] : content->getPacks()) {
+        if (has(pack->worldfuncsset)) {
+            lua::emit_event(lua::get_main_state(), packid + event, args);
+        }
+    }
+}
+
+static void emit_chunks_events() {
+    debug::ProfileZone zone("lua-chunksevents");
+    bool modifiedListened = false;
+    for (const auto& [_, pack] : content->getPacks()) {
+        modifiedListened |= pack->worldfuncsset.onchunksmodified;
+    }
+    std::vector<glm::ivec2> modified;
+    if (modifiedListened) {
+        for (const auto& chunk : level->chunks->getChunks()) {
+            if (chunk && chunk->flags.changed) {
+                chunk->flags.changed = false;
+                modified.emplace_back(chunk->x, chunk->z);
+            }
+        }
+    }
+    // handlers may load or unload chunks
+    auto loaded = std::move(loaded_chunks);
+    auto unloaded = std::move(unloaded_chunks);
+    loaded_chunks.clear();
+    unloaded_chunks.clear();
+
+    emit_chunks_event(":.chunksunloaded", unloaded, [](const auto& funcs) {
+        return funcs.onchunksunloaded;
+    });
+    emit_chunks_event(":.chunksloaded", loaded, [](const auto& funcs) {
+        return funcs.onchunksloaded;
+    });
+    emit_chunks_event(":.chunksmodified", modified, [](const auto& funcs) {
+        return funcs.onchunksmodified;
+    });
+}
+
 void scripting::on_world_tick() {
+    emit_chunks_events();
+
+    debug::ProfileZone zone("lua-worldtick");
     auto L = lua::get_main_state();
     for (auto& pack : scripting::engine->getAllContentPacks()) {
-        lua::emit_event(L, pack.id + ":.worldtick");
+        auto name = pack.id + ":.worldtick";
+        if (!lua::is_handler_throttled(lua::get_handler_timing(name))) {
+            lua::emit_event(L, name);
+        }
     }
 }
 
@@ -239,6 +354,8 @@ void scripting::on_world_quit() {
     if (lua::getglobal(L, "__vc_on_world_quit")) {
         lua::call_nothrow(L, 0, 0);
     }
+    loaded_chunks.clear();
+    unloaded_chunks.clear();
     scripting::level = nullptr;
     scripting::content = nullptr;
     scripting::indices = nullptr;
@@ -262,32 +379,55 @@ void scripting::cleanup() {
 }
 
 void scripting::on_blocks_tick(const Block& block, int tps) {
-    std::string name = block.name + ".blockstick";
-    lua::emit_event(lua::get_main_state(), name, [tps](auto L) {
+    debug::ProfileZone zone("lua-blockstick");
+    auto handle = block.rt.events.blockstick;
+    if (handle && lua::is_handler_throttled(lua::get_event_timing(handle))) {
+        return;
+    }
+    lua::emit_event(lua::get_main_state(), handle, [tps](auto L) {
         return lua::pushinteger(L, tps);
     });
 }
 
 void scripting::update_block(const Block& block, const glm::ivec3& pos) {
-    std::string name = block.name + ".update";
-    lua::emit_event(lua::get_main_state(), name, [pos](auto L) {
+    auto handle = block.rt.events.update;
+    lua::emit_event(lua::get_main_state(), handle, [pos](auto L) {
         return lua::pushivec_stack(L, pos);
     });
 }
 
 void scripting::random_update_block(const Block& block, const glm::ivec3& pos) {
-    std::string name = block.name + ".randupdate";
-    lua::emit_event(lua::get_main_state(), name, [pos](auto L) {
+    auto handle = block.rt.events.randupdate;
+    lua::emit_event(lua::get_main_state(), handle, [pos](auto L) {
         return lua::pushivec_stack(L, pos);
     });
 }
 
+void scripting::random_update_blocks(
+    const Block& block, const std::vector<glm::ivec3>& positions
+) {
+    auto handle = block.rt.events.randupdatebatch;
+    lua::emit_event(lua::get_main_state(), handle, [&positions](auto L) {
+        // flat array {x1, y1, z1, x2, y2, z2, ...}
+        lua::createtable(L, positions.size() * 3, 0);
+        int index = 1;
+        for (const auto& pos : positions) {
+            for (int i = 0; i < 3; i++) {
+                lua::pushinteger(L, pos[i]);
+                lua::rawseti(L, index++);
+            }
+        }
+        lua::pushinteger(L, positions.size());
+        return 2;
+    });
+}
+
 void scripting::on_block_placed(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
     if (block.rt.funcsset.onplaced) {
-        std::string name = block.name + ".placed";
-        lua::emit_event(lua::get_main_state(), name, [pos, player](auto L) {
+        auto handle = block.rt.events.placed;
+        lua::emit_event(lua::get_main_state(), handle, [pos, player](auto L) {
             lua::pushivec_stack(L, pos);
             lua::pushinteger(L, player ? player->getId() : -1);
             return 4;
@@ -312,8 +452,8 @@ void scripting::on_block_replaced(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
     if (block.rt.funcsset.onreplaced) {
-        std::string name = block.name + ".replaced";
-        lua::emit_event(lua::get_main_state(), name, [pos, player](auto L) {
+        auto handle = block.rt.events.replaced;
+        lua::emit_event(lua::get_main_state(), handle, [pos, player](auto L) {
             lua::pushivec_stack(L, pos);
             lua::pushinteger(L, player ? player->getId() : -1);
             return 4;
@@ -338,10 +478,9 @@ void scripting::on_block_broken(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
     if (block.rt.funcsset.onbroken) {
-        std::string name = block.name + ".broken";
         lua::emit_event(
             lua::get_main_state(),
-            name,
+            block.rt.events.broken,
             [pos, player](auto L) {
                 lua::pushivec_stack(L, pos);
                 lua::pushinteger(L, player ? player->getId() : -1);
@@ -367,8 +506,9 @@ void scripting::on_block_broken(
 bool scripting::on_block_interact(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    std::string name = block.name + ".interact";
-    return lua::emit_event(lua::get_main_state(), name, [pos, player](auto L) {
+    auto handle = block.rt.events.interact;
+    auto L = lua::get_main_state();
+    return lua::emit_event(L, handle, [pos, player](auto L) {
         lua::pushivec_stack(L, pos);
         lua::pushinteger(L, player->getId());
         return 4;
@@ -389,25 +529,27 @@ bool scripting::on_block_interact(
 }
 
 void scripting::on_player_tick(Player* player, int tps) {
+    debug::ProfileZone zone("lua-playertick");
     auto args = [=](lua::State* L) {
         lua::pushinteger(L, player ? player->getId() : -1);
         lua::pushinteger(L, tps);
         return 2;
     };
     for (auto& [packid, pack] : content->getPacks()) {
-        if (pack->worldfuncsset.onplayertick) {
-            lua::emit_event(
-                lua::get_main_state(), packid + ":.playertick", args
-            );
+        if (!pack->worldfuncsset.onplayertick) {
+            continue;
+        }
+        auto name = packid + ":.playertick";
+        if (!lua::is_handler_throttled(lua::get_handler_timing(name))) {
+            lua::emit_event(lua::get_main_state(), name, args);
         }
     }
 }
 
 bool scripting::on_item_use(Player* player, const ItemDef& item) {
-    std::string name = item.name + ".use";
     return lua::emit_event(
         lua::get_main_state(),
-        name,
+        item.rt.events.use,
         [player](lua::State* L) { return lua::pushinteger(L, player->getId()); }
     );
 }
@@ -415,10 +557,9 @@ bool scripting::on_item_use(Player* player, const ItemDef& item) {
 bool scripting::on_item_use_on_block(
     Player* player, const ItemDef& item, glm::ivec3 ipos, glm::ivec3 normal
 ) {
-    std::string name = item.name + ".useon";
     return lua::emit_event(
         lua::get_main_state(),
-        name,
+        item.rt.events.useon,
         [ipos, normal, player](auto L) {
             lua::pushivec_stack(L, ipos);
             lua::pushinteger(L, player->getId());
@@ -431,10 +572,9 @@ bool scripting::on_item_use_on_block(
 bool scripting::on_item_break_block(
     Player* player, const ItemDef& item, int x, int y, int z
 ) {
-    std::string name = item.name + ".blockbreakby";
     return lua::emit_event(
         lua::get_main_state(),
-        name,
+        item.rt.events.blockbreakby,
         [x, y, z, player](auto L) {
             lua::pushivec_stack(L, glm::ivec3(x, y, z));
             lua::pushinteger(L, player->getId());
@@ -454,6 +594,26 @@ dv::value scripting::get_component_value(
     return nullptr;
 }
 
+/// @brief Create registry reference of the function field of the table on
+/// the stack top
+/// @return nullptr if the field is not a function
+static std::shared_ptr<int> create_function_ref(
+    lua::State* L, const std::string& name
+) {
+    if (!lua::getfield(L, name)) {
+        return nullptr;
+    }
+    if (!lua::isfunction(L, -1)) {
+        lua::pop(L);
+        return nullptr;
+    }
+    int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    return std::shared_ptr<int>(new int(ref), [=](int* ref) { //-V508
+        luaL_unref(L, LUA_REGISTRYINDEX, *ref);
+        delete ref;
+    });
+}
+
 void scripting::on_entity_spawn(
     const EntityDef&,
     entityid_t eid,
@@ -518,6 +678,8 @@ void scripting::on_entity_spawn(
         funcsset.on_aim_off = lua::hasfield(L, "on_aim_off");
         funcsset.on_attacked = lua::hasfield(L, "on_attacked");
         funcsset.on_used = lua::hasfield(L, "on_used");
+        component->onUpdate = create_function_ref(L, "on_update");
+        component->onRender = create_function_ref(L, "on_render");
         lua::pop(L, 2);
 
         component->env = compenv;
@@ -550,6 +712,11 @@ static void process_entity_callback(
     const auto& script = entity.getScripting();
     for (auto& component : script.components) {
         if (component->funcsset.*flag) {
+            const auto& id = component->name;
+            lua::MemoryScope scope(
+                lua::get_memory_owner(id.substr(0, id.find(':')))
+            );
+            lua::HandlerTimer timer(lua::get_handler_timing(id + "." + name));
             process_entity_callback(component->env, name, args);
         }
     }
@@ -559,6 +726,10 @@ void scripting::on_entity_despawn(const Entity& entity) {
     process_entity_callback(
         entity, "on_despawn", &entity_funcs_set::on_despawn, nullptr
     );
+    for (auto& component : entity.getScripting().components) {
+        component->onUpdate = nullptr;
+        component->onRender = nullptr;
+    }
     auto L = lua::get_main_state();
     lua::get_from(L, "stdcomp", "remove_Entity", true);
     lua::pushinteger(L, entity.getUID());
@@ -658,22 +829,63 @@ void scripting::on_entity_used(const Entity& entity, Player* player) {
     );
 }
 
-void scripting::on_entities_update(int tps, int parts, int part) {
+/// @brief Call the callback of components. Every group of same type
+/// components is timed as a handler 'component.callback'
+template <class F>
+static void call_components(
+    const std::vector<UserComponent*>& components,
+    std::shared_ptr<int> UserComponent::*callback,
+    const std::string& callbackName,
+    const F& args
+) {
     auto L = lua::get_main_state();
-    lua::get_from(L, STDCOMP, "update", true);
-    lua::pushinteger(L, tps);
-    lua::pushinteger(L, parts);
-    lua::pushinteger(L, part);
-    lua::call_nothrow(L, 3, 0);
-    lua::pop(L);
+    int top = lua::gettop(L);
+    size_t count = components.size();
+    for (size_t start = 0, end = 0; start < count; start = end) {
+        const auto& name = components[start]->name;
+        end = start + 1;
+        while (end < count && components[end]->name == name) {
+            end++;
+        }
+        lua::MemoryScope scope(
+            lua::get_memory_owner(name.substr(0, name.find(':')))
+        );
+        lua::HandlerTimer timer(
+            lua::get_handler_timing(name + "." + callbackName)
+        );
+        for (size_t i = start; i < end; i++) {
+            // reset if the entity is despawned by a previous call
+            const auto& ref = components[i]->*callback;
+            if (ref == nullptr) {
+                continue;
+            }
+            lua::rawgeti(L, *ref, LUA_REGISTRYINDEX);
+            lua::call_nothrow(L, args(L), 0);
+            lua_settop(L, top);
+        }
+    }
 }
 
-void scripting::on_entities_render(float delta) {
-    auto L = lua::get_main_state();
-    lua::get_from(L, STDCOMP, "render", true);
-    lua::pushnumber(L, delta);
-    lua::call_nothrow(L, 1, 0);
-    lua::pop(L);
+void scripting::on_components_update(
+    int tps, const std::vector<UserComponent*>& components
+) {
+    debug::ProfileZone zone("lua-entities-update");
+    call_components(
+        components, &UserComponent::onUpdate, "on_update", [tps](auto L) {
+            return lua::pushinteger(L, tps);
+        }
+    );
+}
+
+void scripting::on_components_render(
+    float delta, const std::vector<UserComponent*>& components
+) {
+    debug::ProfileZone zone("lua-entities-render");
+    call_components(
+        components, &UserComponent::onRender, "on_render", [delta](auto L) {
+            return lua::pushnumber(L, delta);
+        }
+    );
 }
 
 void scripting::on_ui_open(
@@ -691,13 +903,14 @@ void scripting::on_ui_open(
 }
 
 void scripting::on_ui_progress(
-    UiDocument* layout, int workDone, int workTotal
+    UiDocument* layout, int workDone, int workTotal, const std::wstring& status
 ) {
     std::string name = layout->getId() + ".progress";
     lua::emit_event(lua::get_main_state(), name, [=](auto L) {
         lua::pushinteger(L, workDone);
         lua::pushinteger(L, workTotal);
-        return 2;
+        lua::pushwstring(L, status);
+        return 3;
     });
 }
 
@@ -736,6 +949,31 @@ int scripting::get_values_on_stack() {
     return lua::gettop(lua::get_main_state());
 }
 
+void scripting::load_content_events(
+    const std::string& name, block_events_set& events
+) {
+    auto L = lua::get_main_state();
+    events.update = lua::create_event_handle(L, name + ".update");
+    events.randupdate = lua::create_event_handle(L, name + ".randupdate");
+    events.randupdatebatch =
+        lua::create_event_handle(L, name + ".randupdatebatch");
+    events.placed = lua::create_event_handle(L, name + ".placed");
+    events.replaced = lua::create_event_handle(L, name + ".replaced");
+    events.broken = lua::create_event_handle(L, name + ".broken");
+    events.interact = lua::create_event_handle(L, name + ".interact");
+    events.blockstick = lua::create_event_handle(L, name + ".blockstick");
+}
+
+void scripting::load_content_events(
+    const std::string& name, item_events_set& events
+) {
+    auto L = lua::get_main_state();
+    events.use = lua::create_event_handle(L, name + ".use");
+    events.useon = lua::create_event_handle(L, name + ".useon");
+    events.blockbreakby =
+        lua::create_event_handle(L, name + ".blockbreakby");
+}
+
 void scripting::load_content_script(
     const scriptenv& senv,
     const std::string& prefix,
@@ -749,6 +987,9 @@ void scripting::load_content_script(
     funcsset.update = register_event(env, "on_update", prefix + ".update");
     funcsset.randupdate =
         register_event(env, "on_random_update", prefix + ".randupdate");
+    funcsset.randupdatebatch = register_event(
+        env, "on_random_update_batch", prefix + ".randupdatebatch"
+    );
     funcsset.onbroken = register_event(env, "on_broken", prefix + ".broken");
     funcsset.onplaced = register_event(env, "on_placed", prefix + ".placed");
     funcsset.onreplaced =
@@ -782,7 +1023,7 @@ void scripting::load_entity_component(
     auto L = lua::get_main_state();
     std::string src = files::read_string(file);
     logger.info() << "script (component) " << file.u8string();
-    lua::loadbuffer(L, 0, src, fileName);
+    lua::loadbuffer_cached(L, 0, src, fileName);
     lua::store_in(L, lua::CHUNKS_TABLE, name);
 }
 
@@ -810,6 +1051,12 @@ void scripting::load_world_script(
         register_event(env, "on_block_interact", prefix + ":.blockinteract");
     funcsset.onplayertick =
         register_event(env, "on_player_tick", prefix + ":.playertick");
+    funcsset.onchunksloaded =
+        register_event(env, "on_chunks_loaded", prefix + ":.chunksloaded");
+    funcsset.onchunksunloaded =
+        register_event(env, "on_chunks_unloaded", prefix + ":.chunksunloaded");
+    funcsset.onchunksmodified =
+        register_event(env, "on_chunks_modified", prefix + ":.chunksmodified");
 }
 
 void scripting::load_layout_script(
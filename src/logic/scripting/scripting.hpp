@@ -25,6 +25,8 @@ class Inventory;
 class UiDocument;
 struct block_funcs_set;
 struct item_funcs_set;
+struct block_events_set;
+struct item_events_set;
 struct world_funcs_set;
 struct UserComponent;
 struct uidocscript;
@@ -60,6 +62,10 @@ namespace scripting {
 
     void process_post_runnables();
 
+    /// @brief Apply scripting settings (garbage collector, handlers budget)
+    /// and perform the frame collector step if enabled. Called once a frame
+    void update();
+
     void on_world_load(LevelController* controller);
     void on_world_tick();
     void on_world_save();
@@ -68,6 +74,12 @@ namespace scripting {
     void on_blocks_tick(const Block& block, int tps);
     void update_block(const Block& block, const glm::ivec3& pos);
     void random_update_block(const Block& block, const glm::ivec3& pos);
+
+    /// @brief Call block batch random update handler with all positions
+    /// selected by the random tick
+    void random_update_blocks(
+        const Block& block, const std::vector<glm::ivec3>& positions
+    );
     void on_block_placed(
         Player* player, const Block& block, const glm::ivec3& pos
     );
@@ -110,8 +122,14 @@ namespace scripting {
     void on_entity_grounded(const Entity& entity, float force);
     void on_entity_fall(const Entity& entity);
     void on_entity_save(const Entity& entity);
-    void on_entities_update(int tps, int parts, int part);
-    void on_entities_render(float delta);
+    /// @brief Call on_update of components grouped by type
+    void on_components_update(
+        int tps, const std::vector<UserComponent*>& components
+    );
+    /// @brief Call on_render of components grouped by type
+    void on_components_render(
+        float delta, const std::vector<UserComponent*>& components
+    );
     void on_sensor_enter(const Entity& entity, size_t index, entityid_t oid);
     void on_sensor_exit(const Entity& entity, size_t index, entityid_t oid);
     void on_aim_on(const Entity& entity, Player* player);
@@ -122,7 +140,12 @@ namespace scripting {
     /// @brief Called on UI view show
     void on_ui_open(UiDocument* layout, std::vector<dv::value> args);
 
-    void on_ui_progress(UiDocument* layout, int workDone, int totalWork);
+    void on_ui_progress(
+        UiDocument* layout,
+        int workDone,
+        int totalWork,
+        const std::wstring& status = L""
+    );
 
     /// @brief Called on UI view close
     void on_ui_close(UiDocument* layout, Inventory* inventory);
@@ -141,6 +164,16 @@ namespace scripting {
         block_funcs_set& funcsset
     );
 
+    /// @brief Resolve block events handles
+    /// @param name block name
+    /// @param events block events handles set
+    void load_content_events(const std::string& name, block_events_set& events);
+
+    /// @brief Resolve item events handles
+    /// @param name item name
+    /// @param events item events handles set
+    void load_content_events(const std::string& name, item_events_set& events);
+
     /// @brief Load script associated with an Item
     /// @param env environment
     /// @param prefix pack id
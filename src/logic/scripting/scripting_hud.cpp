@@ -7,6 +7,7 @@
 #include "graphics/render/WorldRenderer.hpp"
 #include "objects/Player.hpp"
 #include "lua/libs/api_lua.hpp"
+#include "lua/lua_bytecode.hpp"
 #include "lua/lua_engine.hpp"
 #include "scripting.hpp"
 
@@ -22,7 +23,9 @@ static void load_script(const std::string& name) {
     std::string src = files::read_string(file);
     logger.info() << "loading script " << file.u8string();
 
-    lua::execute(lua::get_main_state(), 0, src, file.u8string());
+    auto L = lua::get_main_state();
+    lua::loadbuffer_cached(L, 0, src, file.u8string());
+    lua::pop(L, lua::call_nothrow(L, 0));
 }
 
 void scripting::on_frontend_init(Hud* hud, WorldRenderer* renderer) {
@@ -86,7 +89,9 @@ void scripting::load_hud_script(
     std::string src = files::read_string(file);
     logger.info() << "loading script " << file.u8string();
 
-    lua::execute(lua::get_main_state(), env, src, fileName);
+    auto L = lua::get_main_state();
+    lua::loadbuffer_cached(L, env, src, fileName);
+    lua::pop(L, lua::call_nothrow(L, 0));
 
     register_event(env, "init", packid + ":.init");
     register_event(env, "on_hud_open", packid + ":.hudopen");
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <optional>
 
 #include "scripting_commons.hpp"
 #include "typedefs.hpp"
@@ -25,6 +26,7 @@ class LuaGeneratorScript : public GeneratorScript {
     State* L;
     const GeneratorDef& def;
     scriptenv env = nullptr;
+    std::optional<uint64_t> seed;
 
     fs::path file;
     std::string dirPath;
@@ -40,7 +42,20 @@ public:
         }
     }
 
+    std::unique_ptr<GeneratorScript> fork() const override {
+        auto state = create_state(
+            *scripting::engine->getPaths(), StateType::GENERATOR
+        );
+        auto script =
+            std::make_unique<LuaGeneratorScript>(state, def, file, dirPath);
+        if (seed) {
+            script->initialize(*seed);
+        }
+        return script;
+    }
+
     void initialize(uint64_t seed) override {
+        this->seed = seed;
         env = create_environment(L);
         stackguard _(L);
 
@@ -64,14 +79,16 @@ public:
         }
     }
 
-    std::shared_ptr<Heightmap> generateHeightmap(
+    /// @return nullptr if the function is not defined or failed
+    std::shared_ptr<Heightmap> callHeightmapFunc(
+        const std::string& name,
         const glm::ivec2& offset,
         const glm::ivec2& size,
         uint bpd,
         const std::vector<std::shared_ptr<Heightmap>>& inputs
-    ) override {
+    ) {
         pushenv(L, *env);
-        if (getfield(L, "generate_heightmap")) {
+        if (getfield(L, name)) {
             pushivec_stack(L, offset);
             pushivec_stack(L, size);
             pushinteger(L, bpd);
@@ -90,9 +107,40 @@ public:
             }
         }
         pop(L);
+        return nullptr;
+    }
+
+    std::shared_ptr<Heightmap> generateHeightmap(
+        const glm::ivec2& offset,
+        const glm::ivec2& size,
+        uint bpd,
+        const std::vector<std::shared_ptr<Heightmap>>& inputs
+    ) override {
+        if (auto map = callHeightmapFunc(
+                "generate_heightmap", offset, size, bpd, inputs
+            )) {
+            return map;
+        }
         return std::make_shared<Heightmap>(size.x, size.y);
     }
 
+    std::shared_ptr<Heightmap> generateHeightmapTile(
+        const glm::ivec2& offset,
+        const glm::ivec2& size,
+        uint bpd,
+        const std::vector<std::shared_ptr<Heightmap>>& inputs
+    ) override {
+        return callHeightmapFunc(
+            "generate_heightmap_tile", offset, size, bpd, inputs
+        );
+    }
+
+    bool hasHeightmapTile() override {
+        stackguard _(L);
+        pushenv(L, *env);
+        return getfield(L, "generate_heightmap_tile") && isfunction(L, -1);
+    }
+
     std::vector<std::shared_ptr<Heightmap>> generateParameterMaps(
         const glm::ivec2& offset, const glm::ivec2& size, uint bpd
     ) override {
@@ -1,13 +1,48 @@
 #pragma once
 
+#include <vector>
 #include <glm/matrix.hpp>
 
+#include "simd.hpp"
+
+/// @brief Axis-aligned boxes stored as coordinates arrays for bulk culling
+struct PackedBoxes {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    void clear() {
+        for (auto coords : {&minX, &minY, &minZ, &maxX, &maxY, &maxZ}) {
+            coords->clear();
+        }
+    }
+
+    void push(const glm::vec3& minp, const glm::vec3& maxp) {
+        minX.push_back(minp.x);
+        minY.push_back(minp.y);
+        minZ.push_back(minp.z);
+        maxX.push_back(maxp.x);
+        maxY.push_back(maxp.y);
+        maxZ.push_back(maxp.z);
+    }
+
+    size_t size() const {
+        return minX.size();
+    }
+};
+
 class Frustum {
 public:
     Frustum() = default;
 
     void update(glm::mat4 projview);
     bool isBoxVisible(const glm::vec3& minp, const glm::vec3& maxp) const;
+
+    /// @brief Test visibility of all boxes in one pass, processing
+    /// simd::LANES boxes at a time. Performs the same tests as isBoxVisible
+    /// @param visible destination resized to boxes count (1 if visible)
+    void areBoxesVisible(
+        const PackedBoxes& boxes, std::vector<uint8_t>& visible
+    ) const;
 private:
     enum Planes {
         Left = 0,
@@ -116,6 +151,66 @@ inline bool Frustum::isBoxVisible(const glm::vec3& minp, const glm::vec3& maxp)
     return true;
 }
 
+inline void Frustum::areBoxesVisible(
+    const PackedBoxes& boxes, std::vector<uint8_t>& visible
+) const {
+    using namespace simd;
+
+    size_t count = boxes.size();
+    visible.resize(count);
+
+    // frustum is outside of the box if all its points are on one side
+    glm::vec3 pointsMin = m_points[0];
+    glm::vec3 pointsMax = m_points[0];
+    for (int i = 1; i < 8; i++) {
+        pointsMin = glm::min(pointsMin, m_points[i]);
+        pointsMax = glm::max(pointsMax, m_points[i]);
+    }
+    const float4 zero = set1(0.0f);
+    const float4 one = set1(1.0f);
+
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        float4 minx = load(boxes.minX.data() + i);
+        float4 miny = load(boxes.minY.data() + i);
+        float4 minz = load(boxes.minZ.data() + i);
+        float4 maxx = load(boxes.maxX.data() + i);
+        float4 maxy = load(boxes.maxY.data() + i);
+        float4 maxz = load(boxes.maxZ.data() + i);
+
+        float4 result = one;
+        for (int p = 0; p < Count; p++) {
+            // all box corners are outside if the farthest one along
+            // the plane normal is outside
+            const glm::vec4& plane = m_planes[p];
+            float4 dot =
+                (set1(plane.x) * (plane.x >= 0.0f ? maxx : minx) +
+                 set1(plane.y) * (plane.y >= 0.0f ? maxy : miny)) +
+                (set1(plane.z) * (plane.z >= 0.0f ? maxz : minz) +
+                 set1(plane.w));
+            result = select(dot < zero, zero, result);
+        }
+        result = select(set1(pointsMin.x) > maxx, zero, result);
+        result = select(set1(pointsMax.x) < minx, zero, result);
+        result = select(set1(pointsMin.y) > maxy, zero, result);
+        result = select(set1(pointsMax.y) < miny, zero, result);
+        result = select(set1(pointsMin.z) > maxz, zero, result);
+        result = select(set1(pointsMax.z) < minz, zero, result);
+
+        alignas(16) float values[LANES];
+        store(values, result);
+        for (int lane = 0; lane < LANES; lane++) {
+            visible[i + lane] = values[lane] != 0.0f;
+        }
+    }
+    for (; i < count; i++) {
+        visible[i] = isBoxVisible(
+            {boxes.minX[i], boxes.minY[i], boxes.minZ[i]},
+            {boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]}
+        );
+    }
+}
+
 template <Frustum::Planes a, Frustum::Planes b, Frustum::Planes c>
 inline glm::vec3 Frustum::intersection(const glm::vec3* crosses) const {
     float D = glm::dot(glm::vec3(m_planes[a]), crosses[ij2k<b, c>::k]);
@@ -5,6 +5,8 @@
 #include <stdexcept>
 #include <glm/glm.hpp>
 
+#include "simd.hpp"
+
 std::optional<InterpolationType> InterpolationType_from(std::string_view str) {
     if (str == "nearest") {
         return InterpolationType::NEAREST;
@@ -16,22 +18,6 @@ std::optional<InterpolationType> InterpolationType_from(std::string_view str) {
     return std::nullopt;
 }
 
-static inline float sample_at(
-    const float* buffer,
-    uint width,
-    uint x, uint y
-) {
-    return buffer[y*width+x];
-}
-
-static inline float sample_at(
-    const float* buffer,
-    uint width, uint height,
-    uint x, uint y
-) {
-    return buffer[(y >= height ? height-1 : y)*width+(x >= width ? width-1 : x)];
-}
-
 static inline float interpolate_cubic(float p[4], float x) {
     return p[1] + 0.5 * x*(p[2] - p[0] + x*(2.0*p[0] - 5.0*p[1] + 4.0*p[2] - 
            p[3] + x*(3.0*(p[1] - p[2]) + p[3] - p[0])));
@@ -45,54 +31,118 @@ static inline float interpolate_bicubic(float p[4][4], float x, float y) {
     return interpolate_cubic(q, x);
 }
 
-static inline float sample_at(
-    const float* buffer,
-    uint width, uint height,
-    float x, float y,
-    InterpolationType interp
+/// @brief Source sampling positions of destination rows or columns
+struct SampleAxis {
+    /// @brief Source index (floor of the sampling position)
+    std::vector<int32_t> index;
+    /// @brief Next source index clamped to the source size
+    std::vector<int32_t> next;
+    /// @brief Sampling position fraction
+    std::vector<float> t;
+
+    SampleAxis(uint srcSize, uint dstSize)
+        : index(dstSize), next(dstSize), t(dstSize) {
+        for (uint i = 0; i < dstSize; i++) {
+            float pos = static_cast<float>(i) / dstSize * srcSize;
+            // std::floor is redundant here because positions are positive
+            uint ipos = static_cast<uint>(pos);
+            index[i] = ipos;
+            next[i] = ipos + 1 < srcSize ? ipos + 1 : ipos;
+            t[i] = pos - ipos;
+        }
+    }
+
+    /// @brief Get clamped index of a cubic interpolation sample
+    /// @param offset sample offset from -1 to 2
+    uint cubicIndex(uint i, int offset, uint srcSize) const {
+        uint pos = index[i] + offset;
+        return pos >= srcSize ? srcSize - 1 : pos;
+    }
+};
+
+template <class T>
+static inline T interpolate_bilinear(
+    T s00, T s10, T s01, T s11, T tx, T ty
+) {
+    T a00 = s00;
+    T a10 = s10 - s00;
+    T a01 = s01 - s00;
+    T a11 = s11 - s10 - s01 + s00;
+    return a00 + a10*tx + a01*ty + a11*tx*ty;
+}
+
+static void resize_nearest(
+    const float* src, uint width, float* dst,
+    const SampleAxis& xs, const SampleAxis& ys
 ) {
-    // std::floor is redundant here because x and y are positive values
-    uint ix = static_cast<uint>(x);
-    uint iy = static_cast<uint>(y);
-    float val = buffer[iy*width+ix];
-    if (interp == InterpolationType::NEAREST) {
-        return val;
+    uint dstwidth = xs.index.size();
+    for (uint y = 0; y < ys.index.size(); y++, dst += dstwidth) {
+        const float* row = src + ys.index[y] * width;
+        for (uint x = 0; x < dstwidth; x++) {
+            dst[x] = row[xs.index[x]];
+        }
     }
-    float tx = x - ix;
-    float ty = y - iy;
+}
 
-    switch (interp) {
-        case InterpolationType::LINEAR: {
-            float s00 = val;
-            float s10 = sample_at(buffer, width, 
-                ix + 1 < width ? ix + 1 : ix, iy);
-            float s01 = sample_at(buffer, width, ix, 
-                iy + 1 < height ? iy + 1 : iy);
-            float s11 = sample_at(buffer, width, 
-                ix + 1 < width ? ix + 1 : ix, iy + 1 < height ? iy + 1 : iy);
-
-            float a00 = s00;
-            float a10 = s10 - s00;
-            float a01 = s01 - s00;
-            float a11 = s11 - s10 - s01 + s00;
-
-            return a00 + a10*tx + a01*ty + a11*tx*ty;
+static void resize_linear(
+    const float* src, uint width, float* dst,
+    const SampleAxis& xs, const SampleAxis& ys
+) {
+    using namespace simd;
+
+    uint dstwidth = xs.index.size();
+    for (uint y = 0; y < ys.index.size(); y++, dst += dstwidth) {
+        const float* row0 = src + ys.index[y] * width;
+        const float* row1 = src + ys.next[y] * width;
+        float ty = ys.t[y];
+        uint x = 0;
+        for (; x + LANES <= dstwidth; x += LANES) {
+            int4 ix0 = load(xs.index.data() + x);
+            int4 ix1 = load(xs.next.data() + x);
+            store(dst + x, interpolate_bilinear(
+                gather(row0, ix0), gather(row0, ix1),
+                gather(row1, ix0), gather(row1, ix1),
+                load(xs.t.data() + x), set1(ty)
+            ));
+        }
+        for (; x < dstwidth; x++) {
+            int ix0 = xs.index[x];
+            int ix1 = xs.next[x];
+            dst[x] = interpolate_bilinear(
+                row0[ix0], row0[ix1], row1[ix0], row1[ix1], xs.t[x], ty
+            );
+        }
+    }
+}
+
+static void resize_cubic(
+    const float* src, uint width, uint height, float* dst,
+    const SampleAxis& xs, const SampleAxis& ys
+) {
+    uint dstwidth = xs.index.size();
+    std::vector<uint> columns(dstwidth * 4);
+    for (uint x = 0; x < dstwidth; x++) {
+        for (int j = 0; j < 4; j++) {
+            columns[x * 4 + j] = xs.cubicIndex(x, j - 1, width);
+        }
+    }
+    for (uint y = 0; y < ys.index.size(); y++, dst += dstwidth) {
+        const float* rows[4];
+        for (int i = 0; i < 4; i++) {
+            rows[i] = src + ys.cubicIndex(y, i - 1, height) * width;
         }
-        case InterpolationType::CUBIC: {
+        float ty = ys.t[y];
+        for (uint x = 0; x < dstwidth; x++) {
+            const uint* column = columns.data() + x * 4;
             float p[4][4];
             for (int i = 0; i < 4; i++) {
                 for (int j = 0; j < 4; j++) {
-                    p[i][j] = sample_at(
-                        buffer, width, height, ix + j - 1, iy + i - 1
-                    );
+                    p[i][j] = rows[i][column[j]];
                 }
             }
-            return interpolate_bicubic(p, ty, tx);
+            dst[x] = interpolate_bicubic(p, ty, xs.t[x]);
         }
-        default:
-            throw std::runtime_error("interpolation type is not implemented");
     }
-    return val;
 }
 
 void Heightmap::resize(
@@ -104,13 +154,20 @@ void Heightmap::resize(
     std::vector<float> dst;
     dst.resize(dstwidth*dstheight);
 
-    uint index = 0;
-    for (uint y = 0; y < dstheight; y++) {
-        for (uint x = 0; x < dstwidth; x++, index++) {
-            float sx = static_cast<float>(x) / dstwidth * width;
-            float sy = static_cast<float>(y) / dstheight * height;
-            dst[index] = sample_at(buffer.data(), width, height, sx, sy, interp);
-        }
+    SampleAxis xs(width, dstwidth);
+    SampleAxis ys(height, dstheight);
+    switch (interp) {
+        case InterpolationType::NEAREST:
+            resize_nearest(buffer.data(), width, dst.data(), xs, ys);
+            break;
+        case InterpolationType::LINEAR:
+            resize_linear(buffer.data(), width, dst.data(), xs, ys);
+            break;
+        case InterpolationType::CUBIC:
+            resize_cubic(buffer.data(), width, height, dst.data(), xs, ys);
+            break;
+        default:
+            throw std::runtime_error("interpolation type is not implemented");
     }
 
     width = dstwidth;
@@ -145,7 +202,15 @@ void Heightmap::crop(
 }
 
 void Heightmap::clamp() {
-    for (uint i = 0; i < width * height; i++) {
-        buffer[i] = std::min(1.0f, std::max(0.0f, buffer[i]));
+    using namespace simd;
+
+    uint count = width * height;
+    float* values = buffer.data();
+    uint i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        store(values + i, min(set1(1.0f), max(set1(0.0f), load(values + i))));
+    }
+    for (; i < count; i++) {
+        values[i] = std::min(1.0f, std::max(0.0f, values[i]));
     }
 }
@@ -0,0 +1,277 @@
+#include "HeightmapExpression.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "coders/commons.hpp"
+#include "simd.hpp"
+
+/// @brief Number of values processed at once, multiple of simd::LANES
+static constexpr size_t BLOCK_SIZE = 64;
+
+class ExpressionParser : BasicParser {
+    using Opcode = HeightmapExpression::Opcode;
+
+    const std::unordered_map<std::string, HeightmapExpression::Variable>&
+        variables;
+    HeightmapExpression& expression;
+    size_t depth = 0;
+
+    void emit(HeightmapExpression::Instruction instruction, int stackDelta) {
+        expression.program.push_back(instruction);
+        depth += stackDelta;
+        expression.stackSize = std::max(expression.stackSize, depth);
+    }
+
+    bool isNextOperator(char c) {
+        skipWhitespace();
+        return hasNext() && source[pos] == c;
+    }
+
+    std::string parseIdentifier() {
+        std::string name;
+        while (hasNext() && (is_identifier_start(source[pos]) ||
+                             is_digit(source[pos]))) {
+            name += source[pos++];
+        }
+        return name;
+    }
+
+    void parseFunction(const std::string& name) {
+        static const std::unordered_map<std::string, std::pair<Opcode, int>>
+            functions {
+                {"abs", {Opcode::ABS, 1}},
+                {"min", {Opcode::MIN, 2}},
+                {"max", {Opcode::MAX, 2}},
+                {"pow", {Opcode::POW, 2}},
+                {"mix", {Opcode::MIX, 3}},
+                {"clamp", {Opcode::CLAMP, 3}},
+            };
+        const auto& found = functions.find(name);
+        if (found == functions.end()) {
+            throw error("unknown function '" + name + "'");
+        }
+        const auto& [opcode, argc] = found->second;
+        expect('(');
+        for (int i = 0; i < argc; i++) {
+            if (i > 0) {
+                expect(',');
+            }
+            parseExpression();
+        }
+        expect(')');
+        emit({opcode}, 1 - argc);
+    }
+
+    void parsePrimary() {
+        char c = peek();
+        if (c == '(') {
+            skip(1);
+            parseExpression();
+            expect(')');
+        } else if (is_digit(c) || c == '.') {
+            emit(
+                {Opcode::CONSTANT,
+                 static_cast<float>(parseNumber(1).asNumber())},
+                1
+            );
+        } else if (is_identifier_start(c)) {
+            auto name = parseIdentifier();
+            if (isNextOperator('(')) {
+                parseFunction(name);
+                return;
+            }
+            const auto& found = variables.find(name);
+            if (found == variables.end()) {
+                throw error("unknown variable '" + name + "'");
+            }
+            if (auto number = std::get_if<float>(&found->second)) {
+                emit({Opcode::CONSTANT, *number}, 1);
+            } else {
+                const auto& input = std::get<const float*>(found->second);
+                emit({Opcode::INPUT, 0.0f, input}, 1);
+            }
+        } else {
+            throw error("unexpected character '" + std::string(1, c) + "'");
+        }
+    }
+
+    void parseUnary() {
+        if (peek() == '-') {
+            skip(1);
+            parseUnary();
+            emit({Opcode::NEG}, 0);
+            return;
+        }
+        parsePrimary();
+        // right-associative, binds stronger than unary minus like in Lua
+        if (isNextOperator('^')) {
+            skip(1);
+            parseUnary();
+            emit({Opcode::POW}, -1);
+        }
+    }
+
+    void parseTerm() {
+        parseUnary();
+        while (isNextOperator('*') || isNextOperator('/')) {
+            auto opcode = source[pos] == '*' ? Opcode::MUL : Opcode::DIV;
+            skip(1);
+            parseUnary();
+            emit({opcode}, -1);
+        }
+    }
+
+    void parseExpression() {
+        parseTerm();
+        while (isNextOperator('+') || isNextOperator('-')) {
+            auto opcode = source[pos] == '+' ? Opcode::ADD : Opcode::SUB;
+            skip(1);
+            parseTerm();
+            emit({opcode}, -1);
+        }
+    }
+public:
+    ExpressionParser(
+        std::string_view source,
+        const std::unordered_map<std::string, HeightmapExpression::Variable>&
+            variables,
+        HeightmapExpression& expression
+    )
+        : BasicParser("<expression>", source),
+          variables(variables),
+          expression(expression) {
+    }
+
+    void parse() {
+        parseExpression();
+        skipWhitespace();
+        if (hasNext()) {
+            throw error(
+                "unexpected character '" + std::string(1, source[pos]) + "'"
+            );
+        }
+    }
+};
+
+HeightmapExpression::HeightmapExpression(
+    std::string_view source,
+    const std::unordered_map<std::string, Variable>& variables
+) {
+    ExpressionParser(source, variables, *this).parse();
+}
+
+template <class Op>
+static inline void apply_unary(float* a, Op op) {
+    for (size_t i = 0; i < BLOCK_SIZE; i += simd::LANES) {
+        simd::store(a + i, op(simd::load(a + i)));
+    }
+}
+
+template <class Op>
+static inline void apply_binary(float* a, const float* b, Op op) {
+    for (size_t i = 0; i < BLOCK_SIZE; i += simd::LANES) {
+        simd::store(a + i, op(simd::load(a + i), simd::load(b + i)));
+    }
+}
+
+template <class Op>
+static inline void apply_ternary(
+    float* a, const float* b, const float* c, Op op
+) {
+    for (size_t i = 0; i < BLOCK_SIZE; i += simd::LANES) {
+        simd::store(
+            a + i,
+            op(simd::load(a + i), simd::load(b + i), simd::load(c + i))
+        );
+    }
+}
+
+void HeightmapExpression::evaluate(float* dst, size_t count) const {
+    using namespace simd;
+
+    auto add = [](float4 x, float4 y) { return x + y; };
+    auto sub = [](float4 x, float4 y) { return x - y; };
+    auto mul = [](float4 x, float4 y) { return x * y; };
+    auto div = [](float4 x, float4 y) { return x / y; };
+    auto minimum = [](float4 x, float4 y) { return min(x, y); };
+    auto maximum = [](float4 x, float4 y) { return max(x, y); };
+    auto mix = [](float4 x, float4 y, float4 t) {
+        return x * (set1(1.0f) - t) + y * t;
+    };
+    auto clamp = [](float4 x, float4 low, float4 high) {
+        return min(max(x, low), high);
+    };
+
+    std::vector<float> stack(stackSize * BLOCK_SIZE);
+    for (size_t offset = 0; offset < count; offset += BLOCK_SIZE) {
+        size_t n = std::min(BLOCK_SIZE, count - offset);
+        // number of used blocks
+        size_t sp = 0;
+        // block at the given depth from the top
+        auto at = [&stack, &sp](size_t depth) {
+            return stack.data() + (sp - depth) * BLOCK_SIZE;
+        };
+        for (const auto& instruction : program) {
+            switch (instruction.opcode) {
+                case Opcode::CONSTANT:
+                    sp++;
+                    std::fill_n(at(1), BLOCK_SIZE, instruction.constant);
+                    break;
+                case Opcode::INPUT:
+                    sp++;
+                    std::copy_n(instruction.input + offset, n, at(1));
+                    std::fill(at(1) + n, at(1) + BLOCK_SIZE, 0.0f);
+                    break;
+                case Opcode::NEG:
+                    apply_unary(at(1), [](float4 x) { return set1(0.0f) - x; });
+                    break;
+                case Opcode::ABS:
+                    apply_unary(at(1), [](float4 x) { return abs(x); });
+                    break;
+                case Opcode::ADD:
+                    apply_binary(at(2), at(1), add);
+                    sp--;
+                    break;
+                case Opcode::SUB:
+                    apply_binary(at(2), at(1), sub);
+                    sp--;
+                    break;
+                case Opcode::MUL:
+                    apply_binary(at(2), at(1), mul);
+                    sp--;
+                    break;
+                case Opcode::DIV:
+                    apply_binary(at(2), at(1), div);
+                    sp--;
+                    break;
+                case Opcode::MIN:
+                    apply_binary(at(2), at(1), minimum);
+                    sp--;
+                    break;
+                case Opcode::MAX:
+                    apply_binary(at(2), at(1), maximum);
+                    sp--;
+                    break;
+                case Opcode::POW: {
+                    float* a = at(2);
+                    const float* b = at(1);
+                    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+                        a[i] = std::pow(a[i], b[i]);
+                    }
+                    sp--;
+                    break;
+                }
+                case Opcode::MIX:
+                    apply_ternary(at(3), at(2), at(1), mix);
+                    sp -= 2;
+                    break;
+                case Opcode::CLAMP:
+                    apply_ternary(at(3), at(2), at(1), clamp);
+                    sp -= 2;
+                    break;
+            }
+        }
+        std::copy_n(stack.data(), n, dst + offset);
+    }
+}
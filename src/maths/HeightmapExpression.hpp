@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "typedefs.hpp"
+
+/// @brief Arithmetic expression evaluated elementwise over heightmaps
+/// values. Values are processed by small blocks, so no intermediate maps
+/// are allocated.
+///
+/// Supported: numbers, variables, + - * / ^ (power) operators, unary minus,
+/// parentheses and functions abs(x), min(a, b), max(a, b), pow(a, b),
+/// mix(a, b, t), clamp(x, low, high)
+class HeightmapExpression {
+public:
+    /// @brief Variable values array (one value per element) or a number
+    using Variable = std::variant<const float*, float>;
+
+    /// @throws parsing_error on invalid expression or unknown variable
+    HeightmapExpression(
+        std::string_view source,
+        const std::unordered_map<std::string, Variable>& variables
+    );
+
+    /// @brief Evaluate the expression for elements.
+    /// @param dst destination values, may be one of variables arrays
+    /// @param count number of elements
+    void evaluate(float* dst, size_t count) const;
+private:
+    enum class Opcode {
+        CONSTANT, INPUT, NEG, ADD, SUB, MUL, DIV, POW,
+        ABS, MIN, MAX, MIX, CLAMP
+    };
+    struct Instruction {
+        Opcode opcode;
+        float constant = 0.0f;
+        const float* input = nullptr;
+    };
+    std::vector<Instruction> program;
+    /// @brief Max number of values blocks used at once
+    size_t stackSize = 0;
+
+    friend class ExpressionParser;
+};
@@ -0,0 +1,251 @@
+#include "noise.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+#define FNL_IMPL
+#include "FastNoiseLite.h"
+#include "simd.hpp"
+
+using namespace simd;
+
+// Vector versions of FastNoiseLite 2D noise functions. Operations order
+// is kept to get the same results
+
+static inline int4 fast_floor(float4 f) {
+    int4 i = to_int(f);
+    return select(f >= set1(0.0f), i, i - set1(1));
+}
+
+static inline int4 fast_round(float4 f) {
+    return to_int(f + select(f >= set1(0.0f), set1(0.5f), set1(-0.5f)));
+}
+
+static inline float4 lerp(float4 a, float4 b, float4 t) {
+    return a + t * (b - a);
+}
+
+static inline float4 interp_quintic(float4 t) {
+    return t * t * t * (t * (t * set1(6.0f) - set1(15.0f)) + set1(10.0f));
+}
+
+static inline int4 hash2d(int4 seed, int4 xPrimed, int4 yPrimed) {
+    return (seed ^ xPrimed ^ yPrimed) * set1(0x27d4eb2d);
+}
+
+static inline float4 grad_coord2d(
+    int4 seed, int4 xPrimed, int4 yPrimed, float4 xd, float4 yd
+) {
+    int4 hash = hash2d(seed, xPrimed, yPrimed);
+    hash = hash ^ shift_right<15>(hash);
+    hash = hash & set1(127 << 1);
+    return xd * gather(GRADIENTS_2D, hash) +
+           yd * gather(GRADIENTS_2D, hash + set1(1));
+}
+
+static float4 simplex2d(int4 seed, float4 x, float4 y) {
+    const float SQRT3 = 1.7320508075688772935274463415059f;
+    const float G2 = (3 - SQRT3) / 6;
+
+    int4 i = fast_floor(x);
+    int4 j = fast_floor(y);
+    float4 xi = x - to_float(i);
+    float4 yi = y - to_float(j);
+
+    float4 t = (xi + yi) * set1(G2);
+    float4 x0 = xi - t;
+    float4 y0 = yi - t;
+
+    i = i * set1(PRIME_X);
+    j = j * set1(PRIME_Y);
+
+    float4 zero = set1(0.0f);
+    float4 a = set1(0.5f) - x0 * x0 - y0 * y0;
+    float4 n0 = select(
+        a > zero, (a * a) * (a * a) * grad_coord2d(seed, i, j, x0, y0), zero
+    );
+
+    float4 c = set1((float)(2 * (1 - 2 * G2) * (1 / G2 - 2))) * t +
+               (set1((float)(-2 * (1 - 2 * G2) * (1 - 2 * G2))) + a);
+    float4 x2 = x0 + set1(2 * (float)G2 - 1);
+    float4 y2 = y0 + set1(2 * (float)G2 - 1);
+    float4 n2 = select(
+        c > zero,
+        (c * c) * (c * c) *
+            grad_coord2d(
+                seed, i + set1(PRIME_X), j + set1(PRIME_Y), x2, y2
+            ),
+        zero
+    );
+
+    // both cases of the second vertex
+    mask4 upper = y0 > x0;
+    float4 x1 = x0 + select(upper, set1((float)G2), set1((float)G2 - 1));
+    float4 y1 = y0 + select(upper, set1((float)G2 - 1), set1((float)G2));
+    int4 i1 = i + select(upper, set1(0), set1(PRIME_X));
+    int4 j1 = j + select(upper, set1(PRIME_Y), set1(0));
+    float4 b = set1(0.5f) - x1 * x1 - y1 * y1;
+    float4 n1 = select(
+        b > zero, (b * b) * (b * b) * grad_coord2d(seed, i1, j1, x1, y1), zero
+    );
+    return (n0 + n1 + n2) * set1(99.83685446303647f);
+}
+
+static float4 perlin2d(int4 seed, float4 x, float4 y) {
+    int4 x0 = fast_floor(x);
+    int4 y0 = fast_floor(y);
+
+    float4 xd0 = x - to_float(x0);
+    float4 yd0 = y - to_float(y0);
+    float4 xd1 = xd0 - set1(1.0f);
+    float4 yd1 = yd0 - set1(1.0f);
+
+    float4 xs = interp_quintic(xd0);
+    float4 ys = interp_quintic(yd0);
+
+    x0 = x0 * set1(PRIME_X);
+    y0 = y0 * set1(PRIME_Y);
+    int4 x1 = x0 + set1(PRIME_X);
+    int4 y1 = y0 + set1(PRIME_Y);
+
+    float4 xf0 = lerp(
+        grad_coord2d(seed, x0, y0, xd0, yd0),
+        grad_coord2d(seed, x1, y0, xd1, yd0),
+        xs
+    );
+    float4 xf1 = lerp(
+        grad_coord2d(seed, x0, y1, xd0, yd1),
+        grad_coord2d(seed, x1, y1, xd1, yd1),
+        xs
+    );
+    return lerp(xf0, xf1, ys) * set1(1.4247691104677813f);
+}
+
+static float4 cellular2d(int4 seed, float4 x, float4 y) {
+    int4 xr = fast_round(x);
+    int4 yr = fast_round(y);
+
+    float4 distance0 = set1(FLT_MAX);
+    float4 distance1 = set1(FLT_MAX);
+    // default jitter modifier is 1.0
+    float4 cellularJitter = set1(0.5f);
+
+    int4 xPrimed = (xr - set1(1)) * set1(PRIME_X);
+    int4 yPrimedBase = (yr - set1(1)) * set1(PRIME_Y);
+
+    for (int xi = -1; xi <= 1; xi++) {
+        int4 yPrimed = yPrimedBase;
+        float4 cellX = to_float(xr + set1(xi)) - x;
+        for (int yi = -1; yi <= 1; yi++) {
+            int4 hash = hash2d(seed, xPrimed, yPrimed);
+            int4 idx = hash & set1(255 << 1);
+
+            float4 vecX = cellX + gather(RAND_VECS_2D, idx) * cellularJitter;
+            float4 vecY = (to_float(yr + set1(yi)) - y) +
+                          gather(RAND_VECS_2D, idx + set1(1)) * cellularJitter;
+
+            float4 newDistance = vecX * vecX + vecY * vecY;
+            distance1 = max(min(distance1, newDistance), distance0);
+            distance0 = select(newDistance < distance0, newDistance, distance0);
+            yPrimed = yPrimed + set1(PRIME_Y);
+        }
+        xPrimed = xPrimed + set1(PRIME_X);
+    }
+    return distance0 - set1(1.0f);
+}
+
+using kernel_func = float4 (*)(int4 seed, float4 x, float4 y);
+
+void noise::generate(
+    NoiseType type,
+    int seed,
+    float frequency,
+    const float* xs,
+    const float* ys,
+    float* dst,
+    size_t count
+) {
+    kernel_func kernel;
+    switch (type) {
+        case NoiseType::SIMPLEX: kernel = simplex2d; break;
+        case NoiseType::PERLIN: kernel = perlin2d; break;
+        case NoiseType::CELLULAR: kernel = cellular2d; break;
+        default:
+            std::fill_n(dst, count, 0.0f);
+            return;
+    }
+    const FNLfloat SQRT3 = (FNLfloat)1.7320508075688772935274463415059;
+    const FNLfloat F2 = 0.5f * (SQRT3 - 1);
+    bool skew = type == NoiseType::SIMPLEX;
+
+    int4 seedv = set1(seed);
+    float4 freq = set1(frequency);
+    auto process = [=](const float* xs, const float* ys, float* dst) {
+        float4 x = load(xs) * freq;
+        float4 y = load(ys) * freq;
+        if (skew) {
+            float4 t = (x + y) * set1(F2);
+            x = x + t;
+            y = y + t;
+        }
+        store(dst, kernel(seedv, x, y));
+    };
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        process(xs + i, ys + i, dst + i);
+    }
+    if (i < count) {
+        // padded tail
+        float tailX[LANES] {};
+        float tailY[LANES] {};
+        float tailDst[LANES];
+        std::copy(xs + i, xs + count, tailX);
+        std::copy(ys + i, ys + count, tailY);
+        process(tailX, tailY, tailDst);
+        std::copy_n(tailDst, count - i, dst + i);
+    }
+}
+
+void noise::add_fractal(
+    NoiseType type,
+    int seed,
+    float frequency,
+    float* values,
+    uint width,
+    uint height,
+    const glm::vec2& offset,
+    float scale,
+    int octaves,
+    float multiplier,
+    const float* shiftX,
+    const float* shiftY
+) {
+    std::vector<float> xs(width);
+    std::vector<float> ys(width);
+    std::vector<float> row(width);
+    for (uint y = 0; y < height; y++) {
+        float* dst = values + y * width;
+        for (int c = 0; c < octaves; c++) {
+            float m = scale * (1 << c);
+            for (uint x = 0; x < width; x++) {
+                uint i = y * width + x;
+                xs[x] = (x + offset.x) * m;
+                ys[x] = (y + offset.y) * m;
+                if (shiftX) {
+                    xs[x] += shiftX[i];
+                }
+                if (shiftY) {
+                    ys[x] += shiftY[i];
+                }
+            }
+            generate(
+                type, seed, frequency, xs.data(), ys.data(), row.data(), width
+            );
+            float amplitude = static_cast<float>(1 << c);
+            for (uint x = 0; x < width; x++) {
+                dst[x] += row[x] / amplitude * multiplier;
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+
+#include "typedefs.hpp"
+
+namespace noise {
+    enum class NoiseType { SIMPLEX, PERLIN, CELLULAR };
+
+    /// @brief Generate noise for an array of points 4 points at once
+    /// (SSE2/NEON if available). Gives the same values as fnlGetNoise2D
+    /// with the default state of the same noise type, seed and frequency
+    /// (OpenSimplex2 for SIMPLEX; Euclidean squared distance for CELLULAR)
+    /// @param xs points X coordinates
+    /// @param ys points Y coordinates
+    /// @param dst destination values array
+    /// @param count number of points
+    void generate(
+        NoiseType type,
+        int seed,
+        float frequency,
+        const float* xs,
+        const float* ys,
+        float* dst,
+        size_t count
+    );
+
+    /// @brief Add fractal noise to the map values. Every next octave has
+    /// doubled frequency and halved amplitude
+    /// @param values destination map values (width * height)
+    /// @param offset map coordinates offset
+    /// @param scale coordinates scale
+    /// @param multiplier noise amplitude multiplier
+    /// @param shiftX X coordinates offset map or nullptr
+    /// @param shiftY Y coordinates offset map or nullptr
+    void add_fractal(
+        NoiseType type,
+        int seed,
+        float frequency,
+        float* values,
+        uint width,
+        uint height,
+        const glm::vec2& offset,
+        float scale,
+        int octaves,
+        float multiplier,
+        const float* shiftX,
+        const float* shiftY
+    );
+}
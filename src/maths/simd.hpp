@@ -0,0 +1,264 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/// @brief Minimal 4-lane vectors used by bulk math kernels.
+/// Maps to SSE2 or NEON registers, falls back to plain arrays.
+/// Lane operations are the same as scalar float/int32 operations, so
+/// kernels give the same results as their scalar versions
+namespace simd {
+    static constexpr int LANES = 4;
+
+#if defined(SIMD_SSE2)
+    struct float4 { __m128 v; };
+    struct int4 { __m128i v; };
+    /// @brief Lanes comparison result (all bits set for true)
+    struct mask4 { __m128 v; };
+
+    inline float4 set1(float x) { return {_mm_set1_ps(x)}; }
+    inline int4 set1(int32_t x) { return {_mm_set1_epi32(x)}; }
+    inline float4 load(const float* src) { return {_mm_loadu_ps(src)}; }
+    inline int4 load(const int32_t* src) {
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))};
+    }
+    inline void store(float* dst, float4 a) { _mm_storeu_ps(dst, a.v); }
+    inline void store(int32_t* dst, int4 a) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), a.v);
+    }
+
+    inline float4 operator+(float4 a, float4 b) {
+        return {_mm_add_ps(a.v, b.v)};
+    }
+    inline float4 operator-(float4 a, float4 b) {
+        return {_mm_sub_ps(a.v, b.v)};
+    }
+    inline float4 operator*(float4 a, float4 b) {
+        return {_mm_mul_ps(a.v, b.v)};
+    }
+    inline float4 operator/(float4 a, float4 b) {
+        return {_mm_div_ps(a.v, b.v)};
+    }
+    inline float4 min(float4 a, float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+    inline float4 max(float4 a, float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+    inline float4 abs(float4 a) {
+        return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)};
+    }
+    inline mask4 operator<(float4 a, float4 b) {
+        return {_mm_cmplt_ps(a.v, b.v)};
+    }
+    inline mask4 operator>(float4 a, float4 b) {
+        return {_mm_cmpgt_ps(a.v, b.v)};
+    }
+    inline mask4 operator>=(float4 a, float4 b) {
+        return {_mm_cmpge_ps(a.v, b.v)};
+    }
+    inline float4 select(mask4 m, float4 a, float4 b) {
+        return {_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))};
+    }
+    inline int4 select(mask4 m, int4 a, int4 b) {
+        __m128i mi = _mm_castps_si128(m.v);
+        return {
+            _mm_or_si128(_mm_and_si128(mi, a.v), _mm_andnot_si128(mi, b.v))};
+    }
+    /// @brief Convert with truncation like static_cast<int>
+    inline int4 to_int(float4 a) { return {_mm_cvttps_epi32(a.v)}; }
+    inline float4 to_float(int4 a) { return {_mm_cvtepi32_ps(a.v)}; }
+
+    inline int4 operator+(int4 a, int4 b) { return {_mm_add_epi32(a.v, b.v)}; }
+    inline int4 operator-(int4 a, int4 b) { return {_mm_sub_epi32(a.v, b.v)}; }
+    inline int4 operator^(int4 a, int4 b) { return {_mm_xor_si128(a.v, b.v)}; }
+    inline int4 operator&(int4 a, int4 b) { return {_mm_and_si128(a.v, b.v)}; }
+    /// @brief Lanes multiplication keeping low 32 bits
+    inline int4 operator*(int4 a, int4 b) {
+#if defined(__SSE4_1__)
+        return {_mm_mullo_epi32(a.v, b.v)};
+#else
+        __m128i even = _mm_mul_epu32(a.v, b.v);
+        __m128i odd = _mm_mul_epu32(
+            _mm_srli_si128(a.v, 4), _mm_srli_si128(b.v, 4)
+        );
+        return {_mm_unpacklo_epi32(
+            _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))
+        )};
+#endif
+    }
+    /// @brief Arithmetic shift right
+    template <int N>
+    inline int4 shift_right(int4 a) { return {_mm_srai_epi32(a.v, N)}; }
+#elif defined(SIMD_NEON)
+    struct float4 { float32x4_t v; };
+    struct int4 { int32x4_t v; };
+    /// @brief Lanes comparison result (all bits set for true)
+    struct mask4 { uint32x4_t v; };
+
+    inline float4 set1(float x) { return {vdupq_n_f32(x)}; }
+    inline int4 set1(int32_t x) { return {vdupq_n_s32(x)}; }
+    inline float4 load(const float* src) { return {vld1q_f32(src)}; }
+    inline int4 load(const int32_t* src) { return {vld1q_s32(src)}; }
+    inline void store(float* dst, float4 a) { vst1q_f32(dst, a.v); }
+    inline void store(int32_t* dst, int4 a) { vst1q_s32(dst, a.v); }
+
+    inline float4 operator+(float4 a, float4 b) {
+        return {vaddq_f32(a.v, b.v)};
+    }
+    inline float4 operator-(float4 a, float4 b) {
+        return {vsubq_f32(a.v, b.v)};
+    }
+    inline float4 operator*(float4 a, float4 b) {
+        return {vmulq_f32(a.v, b.v)};
+    }
+    inline float4 operator/(float4 a, float4 b) {
+        return {vdivq_f32(a.v, b.v)};
+    }
+    inline float4 min(float4 a, float4 b) { return {vminq_f32(a.v, b.v)}; }
+    inline float4 max(float4 a, float4 b) { return {vmaxq_f32(a.v, b.v)}; }
+    inline float4 abs(float4 a) { return {vabsq_f32(a.v)}; }
+    inline mask4 operator<(float4 a, float4 b) { return {vcltq_f32(a.v, b.v)}; }
+    inline mask4 operator>(float4 a, float4 b) { return {vcgtq_f32(a.v, b.v)}; }
+    inline mask4 operator>=(float4 a, float4 b) {
+        return {vcgeq_f32(a.v, b.v)};
+    }
+    inline float4 select(mask4 m, float4 a, float4 b) {
+        return {vbslq_f32(m.v, a.v, b.v)};
+    }
+    inline int4 select(mask4 m, int4 a, int4 b) {
+        return {vbslq_s32(m.v, a.v, b.v)};
+    }
+    /// @brief Convert with truncation like static_cast<int>
+    inline int4 to_int(float4 a) { return {vcvtq_s32_f32(a.v)}; }
+    inline float4 to_float(int4 a) { return {vcvtq_f32_s32(a.v)}; }
+
+    inline int4 operator+(int4 a, int4 b) { return {vaddq_s32(a.v, b.v)}; }
+    inline int4 operator-(int4 a, int4 b) { return {vsubq_s32(a.v, b.v)}; }
+    inline int4 operator^(int4 a, int4 b) { return {veorq_s32(a.v, b.v)}; }
+    inline int4 operator&(int4 a, int4 b) { return {vandq_s32(a.v, b.v)}; }
+    /// @brief Lanes multiplication keeping low 32 bits
+    inline int4 operator*(int4 a, int4 b) { return {vmulq_s32(a.v, b.v)}; }
+    /// @brief Arithmetic shift right
+    template <int N>
+    inline int4 shift_right(int4 a) { return {vshrq_n_s32(a.v, N)}; }
+#else
+    struct float4 { float v[LANES]; };
+    struct int4 { int32_t v[LANES]; };
+    /// @brief Lanes comparison result
+    struct mask4 { bool v[LANES]; };
+
+#define SIMD_LANES_OP(TYPE, EXPR) \
+    TYPE r;                       \
+    for (int i = 0; i < LANES; i++) r.v[i] = EXPR; \
+    return r;
+
+    inline float4 set1(float x) { SIMD_LANES_OP(float4, x) }
+    inline int4 set1(int32_t x) { SIMD_LANES_OP(int4, x) }
+    inline float4 load(const float* src) { SIMD_LANES_OP(float4, src[i]) }
+    inline int4 load(const int32_t* src) { SIMD_LANES_OP(int4, src[i]) }
+    inline void store(float* dst, float4 a) {
+        for (int i = 0; i < LANES; i++) dst[i] = a.v[i];
+    }
+    inline void store(int32_t* dst, int4 a) {
+        for (int i = 0; i < LANES; i++) dst[i] = a.v[i];
+    }
+
+    inline float4 operator+(float4 a, float4 b) {
+        SIMD_LANES_OP(float4, a.v[i] + b.v[i])
+    }
+    inline float4 operator-(float4 a, float4 b) {
+        SIMD_LANES_OP(float4, a.v[i] - b.v[i])
+    }
+    inline float4 operator*(float4 a, float4 b) {
+        SIMD_LANES_OP(float4, a.v[i] * b.v[i])
+    }
+    inline float4 operator/(float4 a, float4 b) {
+        SIMD_LANES_OP(float4, a.v[i] / b.v[i])
+    }
+    inline float4 min(float4 a, float4 b) {
+        SIMD_LANES_OP(float4, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+    }
+    inline float4 max(float4 a, float4 b) {
+        SIMD_LANES_OP(float4, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+    }
+    inline float4 abs(float4 a) {
+        SIMD_LANES_OP(float4, a.v[i] < 0.0f ? -a.v[i] : a.v[i])
+    }
+    inline mask4 operator<(float4 a, float4 b) {
+        SIMD_LANES_OP(mask4, a.v[i] < b.v[i])
+    }
+    inline mask4 operator>(float4 a, float4 b) {
+        SIMD_LANES_OP(mask4, a.v[i] > b.v[i])
+    }
+    inline mask4 operator>=(float4 a, float4 b) {
+        SIMD_LANES_OP(mask4, a.v[i] >= b.v[i])
+    }
+    inline float4 select(mask4 m, float4 a, float4 b) {
+        SIMD_LANES_OP(float4, m.v[i] ? a.v[i] : b.v[i])
+    }
+    inline int4 select(mask4 m, int4 a, int4 b) {
+        SIMD_LANES_OP(int4, m.v[i] ? a.v[i] : b.v[i])
+    }
+    /// @brief Convert with truncation like static_cast<int>
+    inline int4 to_int(float4 a) {
+        SIMD_LANES_OP(int4, static_cast<int32_t>(a.v[i]))
+    }
+    inline float4 to_float(int4 a) {
+        SIMD_LANES_OP(float4, static_cast<float>(a.v[i]))
+    }
+
+    inline int4 operator+(int4 a, int4 b) {
+        SIMD_LANES_OP(int4, static_cast<int32_t>(
+            static_cast<uint32_t>(a.v[i]) + static_cast<uint32_t>(b.v[i])
+        ))
+    }
+    inline int4 operator-(int4 a, int4 b) {
+        SIMD_LANES_OP(int4, static_cast<int32_t>(
+            static_cast<uint32_t>(a.v[i]) - static_cast<uint32_t>(b.v[i])
+        ))
+    }
+    inline int4 operator^(int4 a, int4 b) {
+        SIMD_LANES_OP(int4, a.v[i] ^ b.v[i])
+    }
+    inline int4 operator&(int4 a, int4 b) {
+        SIMD_LANES_OP(int4, a.v[i] & b.v[i])
+    }
+    /// @brief Lanes multiplication keeping low 32 bits
+    inline int4 operator*(int4 a, int4 b) {
+        SIMD_LANES_OP(int4, static_cast<int32_t>(
+            static_cast<uint32_t>(a.v[i]) * static_cast<uint32_t>(b.v[i])
+        ))
+    }
+    /// @brief Arithmetic shift right
+    template <int N>
+    inline int4 shift_right(int4 a) { SIMD_LANES_OP(int4, a.v[i] >> N) }
+
+#undef SIMD_LANES_OP
+#endif
+
+    // Scalar versions allowing to write kernels once for floats and vectors
+
+    inline float min(float a, float b) { return a < b ? a : b; }
+    inline float max(float a, float b) { return a > b ? a : b; }
+    inline float abs(float a) { return a < 0.0f ? -a : a; }
+
+    /// @brief Load 4 values from the table at lanes indices
+    inline float4 gather(const float* table, int4 indices) {
+        alignas(16) int32_t idx[LANES];
+        alignas(16) float values[LANES];
+        store(idx, indices);
+        for (int i = 0; i < LANES; i++) {
+            values[i] = table[idx[i]];
+        }
+        return load(values);
+    }
+}
@@ -4,8 +4,13 @@
 
 #define NOMINMAX
 #include <curl/curl.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <stdexcept>
 #include <limits>
+#include <optional>
 #include <queue>
 #include <thread>
 
@@ -21,17 +26,40 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <poll.h>
 
 using SOCKET = int;
 #endif // _WIN32
 
+#include "coders/gzip.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
+#include "util/SPSCByteRing.hpp"
+#include "util/data_io.hpp"
 #include "util/stringutil.hpp"
 
 using namespace network;
 
 static debug::Logger logger("network");
 
+/// @brief I/O thread checks for closed and added sockets at least with
+/// this interval
+static constexpr int POLL_TIMEOUT_MS = 20;
+/// @brief Max number of received bytes waiting to be read by a script.
+/// Socket is not read while the buffer is full
+static constexpr size_t RECEIVE_BUFFER_CAPACITY = 256 * 1024;
+/// @brief Message header is a little-endian uint32: data length with
+/// the compression flag in the highest bit
+static constexpr uint32_t MESSAGE_COMPRESSED_FLAG = 0x80000000;
+static constexpr size_t MAX_MESSAGE_SIZE = 64 * 1024 * 1024;
+/// @brief Queued messages are sent before the next update when their
+/// total size reaches this limit
+static constexpr size_t MAX_MESSAGES_BATCH = 64 * 1024;
+/// @brief Max number of HTTP requests performed at the same time,
+/// the rest are queued
+static constexpr size_t MAX_CONCURRENT_REQUESTS = 8;
+static constexpr long MAX_HOST_CONNECTIONS = 4;
+
 static size_t write_callback(
     char* ptr, size_t size, size_t nmemb, void* userdata
 ) {
@@ -50,122 +78,193 @@ struct Request {
     bool followLocation = false;
 };
 
+/// @brief Request being performed with an easy handle
+struct Transfer {
+    CURL* curl;
+    Request request;
+    std::vector<char> buffer;
+};
+
 class CurlRequests : public Requests {
     CURLM* multiHandle;
-    CURL* curl;
 
     size_t totalUpload = 0;
     size_t totalDownload = 0;
 
-    OnResponse onResponse;
-    OnReject onReject;
-    std::vector<char> buffer;
-    std::string url;
+    /// @brief Idle easy handles (keeping their connections alive)
+    std::vector<CURL*> freeHandles;
+    size_t handlesCount = 0;
+    std::vector<std::unique_ptr<Transfer>> transfers;
 
     std::queue<Request> requests;
-public:
-    CurlRequests(CURLM* multiHandle, CURL* curl)
-        : multiHandle(multiHandle), curl(curl) {
+
+    bool hasFreeHandle() const {
+        return !freeHandles.empty() || handlesCount < MAX_CONCURRENT_REQUESTS;
     }
 
-    virtual ~CurlRequests() {
-        curl_multi_remove_handle(multiHandle, curl);
-        curl_easy_cleanup(curl);
-        curl_multi_cleanup(multiHandle);
+    CURL* acquireHandle() {
+        if (!freeHandles.empty()) {
+            CURL* curl = freeHandles.back();
+            freeHandles.pop_back();
+            return curl;
+        }
+        CURL* curl = curl_easy_init();
+        if (curl) {
+            handlesCount++;
+        }
+        return curl;
     }
 
-    void get(
-        const std::string& url,
-        OnResponse onResponse,
-        OnReject onReject,
-        long maxSize
-    ) override {
-        Request request {url, onResponse, onReject, maxSize};
-        if (url.empty()) {
-            processRequest(request);
+    void finish(Transfer* transfer, CURLcode result) {
+        CURL* curl = transfer->curl;
+        curl_multi_remove_handle(multiHandle, curl);
+
+        const auto& request = transfer->request;
+        long response = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response);
+        if (result != CURLE_OK) {
+            auto message = curl_easy_strerror(result);
+            logger.error() << message << " (" << request.url << ")";
+            if (request.onReject) {
+                request.onReject(message);
+            }
+        } else if (response == 200) {
+            long size;
+            if (!curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &size)) {
+                totalUpload += size;
+            }
+            if (!curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &size)) {
+                totalDownload += size;
+            }
+            totalDownload += transfer->buffer.size();
+            if (request.onResponse) {
+                request.onResponse(std::move(transfer->buffer));
+            }
         } else {
-            requests.push(request);
+            logger.error() << "response code " << response << " ("
+                           << request.url << ")";
+            if (request.onReject) {
+                request.onReject(std::to_string(response).c_str());
+            }
         }
-    }
+        curl_easy_reset(curl);
+        freeHandles.push_back(curl);
 
-    void processRequest(const Request& request) {
-        onResponse = request.onResponse;
-        onReject = request.onReject;
-        url = request.url;
+        auto found = std::find_if(
+            transfers.begin(),
+            transfers.end(),
+            [transfer](const auto& ptr) { return ptr.get() == transfer; }
+        );
+        transfers.erase(found);
+    }
 
-        buffer.clear();
+    void processRequest(Request&& request) {
+        CURL* curl = acquireHandle();
+        if (curl == nullptr) {
+            logger.error() << "could not initialize cURL (" << request.url
+                           << ")";
+            if (request.onReject) {
+                request.onReject("could not initialize cURL");
+            }
+            return;
+        }
+        auto transfer = std::make_unique<Transfer>(
+            Transfer {curl, std::move(request), {}});
+        const auto& url = transfer->request.url;
 
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer.get());
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, request.followLocation);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->buffer);
+        curl_easy_setopt(
+            curl, CURLOPT_FOLLOWLOCATION, transfer->request.followLocation
+        );
         curl_easy_setopt(curl, CURLOPT_USERAGENT, "curl/7.81.0");
-        if (request.maxSize == 0) {
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        // HTTP/2 is used if supported, requests to the same host are
+        // multiplexed over one connection
+        curl_easy_setopt(
+            curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS
+        );
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+        if (transfer->request.maxSize == 0) {
             curl_easy_setopt(
                 curl, CURLOPT_MAXFILESIZE, std::numeric_limits<long>::max()
             );
         } else {
-            curl_easy_setopt(curl, CURLOPT_MAXFILESIZE, request.maxSize);
+            curl_easy_setopt(
+                curl, CURLOPT_MAXFILESIZE, transfer->request.maxSize
+            );
         }
-        curl_multi_add_handle(multiHandle, curl);
-        int running;
-        CURLMcode res = curl_multi_perform(multiHandle, &running);
+        CURLMcode res = curl_multi_add_handle(multiHandle, curl);
         if (res != CURLM_OK) {
             auto message = curl_multi_strerror(res);
             logger.error() << message << " (" << url << ")";
-            if (onReject) {
-                onReject(message);
+            if (transfer->request.onReject) {
+                transfer->request.onReject(message);
             }
-            url = "";
+            curl_easy_reset(curl);
+            freeHandles.push_back(curl);
+            return;
+        }
+        transfers.push_back(std::move(transfer));
+    }
+
+    void processQueue() {
+        while (!requests.empty() && hasFreeHandle()) {
+            auto request = std::move(requests.front());
+            requests.pop();
+            processRequest(std::move(request));
+        }
+    }
+public:
+    CurlRequests(CURLM* multiHandle) : multiHandle(multiHandle) {
+        curl_multi_setopt(multiHandle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(
+            multiHandle, CURLMOPT_MAX_HOST_CONNECTIONS, MAX_HOST_CONNECTIONS
+        );
+    }
+
+    virtual ~CurlRequests() {
+        for (const auto& transfer : transfers) {
+            curl_multi_remove_handle(multiHandle, transfer->curl);
+            curl_easy_cleanup(transfer->curl);
         }
+        for (CURL* curl : freeHandles) {
+            curl_easy_cleanup(curl);
+        }
+        curl_multi_cleanup(multiHandle);
+    }
+
+    void get(
+        const std::string& url,
+        OnResponse onResponse,
+        OnReject onReject,
+        long maxSize
+    ) override {
+        requests.push(Request {url, onResponse, onReject, maxSize});
+        processQueue();
     }
 
     void update() override {
-        int messagesLeft;
         int running;
-        CURLMsg* msg;
         CURLMcode res = curl_multi_perform(multiHandle, &running);
         if (res != CURLM_OK) {
             auto message = curl_multi_strerror(res);
-            logger.error() << message << " (" << url << ")";
-            if (onReject) {
-                onReject(message);
-            }
-            curl_multi_remove_handle(multiHandle, curl);
-            url = "";
+            logger.error() << message;
             return;
         }
-        if ((msg = curl_multi_info_read(multiHandle, &messagesLeft)) != NULL) {
-            if(msg->msg == CURLMSG_DONE) {
-                curl_multi_remove_handle(multiHandle, curl);
-            }
-            int response;
-            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &response);
-            if (response == 200) {
-                long size;
-                if (!curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &size)) {
-                    totalUpload += size;
-                }
-                if (!curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &size)) {
-                    totalDownload += size;
-                }
-                totalDownload += buffer.size();
-                if (onResponse) {
-                    onResponse(std::move(buffer));
-                }
-            } else {
-                logger.error() << "response code " << response << " (" << url << ")";
-                if (onReject) {
-                    onReject(std::to_string(response).c_str());
-                }
+        int messagesLeft;
+        CURLMsg* msg;
+        while ((msg = curl_multi_info_read(multiHandle, &messagesLeft))) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
             }
-            url = "";
-        }
-        if (url.empty() && !requests.empty()) {
-            auto request = std::move(requests.front());
-            requests.pop();
-            processRequest(request);
+            Transfer* transfer;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+            finish(transfer, msg->data.result);
         }
+        processQueue();
     }
 
     size_t getTotalUpload() const override {
@@ -177,16 +276,11 @@ public:
     }
 
     static std::unique_ptr<CurlRequests> create() {
-        auto curl = curl_easy_init();
-        if (curl == nullptr) {
-            throw std::runtime_error("could not initialzie cURL");
-        }
         auto multiHandle = curl_multi_init();
         if (multiHandle == nullptr) {
-            curl_easy_cleanup(curl);
             throw std::runtime_error("could not initialzie cURL-multi");
         }
-        return std::make_unique<CurlRequests>(multiHandle, curl);
+        return std::make_unique<CurlRequests>(multiHandle);
     }
 };
 
@@ -253,105 +347,393 @@ static std::string to_string(const sockaddr_in& addr, bool port=true) {
     return "";
 }
 
-class SocketConnection : public Connection {
-    SOCKET descriptor;
-    bool open = true;
-    sockaddr_in addr;
-    size_t totalUpload = 0;
-    size_t totalDownload = 0;
-    ConnectionState state = ConnectionState::INITIAL;
-    std::unique_ptr<std::thread> thread = nullptr;
-    std::vector<char> readBatch;
-    util::Buffer<char> buffer;
+static inline int pollsockets(pollfd* fds, size_t count, int timeout) {
+#ifdef _WIN32
+    return WSAPoll(fds, static_cast<ULONG>(count), timeout);
+#else
+    return poll(fds, count, timeout);
+#endif
+}
+
+static bool set_nonblocking(SOCKET descriptor, bool flag) {
+#ifdef _WIN32
+    u_long mode = flag;
+    return ioctlsocket(descriptor, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(descriptor, F_GETFL, 0);
+    if (flags == -1) {
+        return false;
+    }
+    flags = flag ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(descriptor, F_SETFL, flags) == 0;
+#endif
+}
+
+static inline bool is_connect_in_progress() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS;
+#endif
+}
+
+static inline void set_socket_error(int error) {
+#ifdef _WIN32
+    WSASetLastError(error);
+#else
+    errno = error;
+#endif
+}
+
+/// @brief Socket registered in the SocketPoller
+class PollTarget {
+public:
+    virtual ~PollTarget() {}
+
+    virtual SOCKET getDescriptor() const = 0;
+
+    /// @return poll events the target is waiting for, 0 to skip polling
+    /// the target for now
+    virtual short getEvents() const = 0;
+
+    /// @brief Called from the I/O thread when some of the events occurred
+    virtual void onEvents(short revents) = 0;
+
+    /// @return true if the target must be removed
+    virtual bool isClosed() const = 0;
+};
+
+/// @brief Single I/O thread multiplexing all sockets of a Network
+class network::SocketPoller {
+    std::vector<std::shared_ptr<PollTarget>> targets;
+    std::vector<std::shared_ptr<PollTarget>> added;
     std::mutex mutex;
+    std::condition_variable condition;
+    std::atomic<bool> running = true;
+    std::thread thread;
+
+    void takeAdded() {
+        std::unique_lock lock(mutex);
+        if (targets.empty()) {
+            // nothing to poll: sleeping until a socket is added
+            condition.wait(lock, [this]() {
+                return !added.empty() || !running;
+            });
+        }
+        for (auto& target : added) {
+            targets.push_back(std::move(target));
+        }
+        added.clear();
+    }
 
-    void connectSocket() {
-        state = ConnectionState::CONNECTING;
-        logger.info() << "connecting to " << to_string(addr);
-        int res = connectsocket(descriptor, (const sockaddr*)&addr, sizeof(sockaddr_in));
-        if (res < 0) {
+    void loop() {
+        std::vector<pollfd> fds;
+        std::vector<PollTarget*> polled;
+        while (running) {
+            takeAdded();
+            targets.erase(
+                std::remove_if(
+                    targets.begin(),
+                    targets.end(),
+                    [](const auto& target) { return target->isClosed(); }
+                ),
+                targets.end()
+            );
+
+            fds.clear();
+            polled.clear();
+            for (const auto& target : targets) {
+                if (short events = target->getEvents()) {
+                    fds.push_back(pollfd {target->getDescriptor(), events, 0});
+                    polled.push_back(target.get());
+                }
+            }
+            if (fds.empty()) {
+                if (!targets.empty()) {
+                    // targets are waiting for buffers space
+                    std::this_thread::sleep_for(
+                        std::chrono::milliseconds(POLL_TIMEOUT_MS)
+                    );
+                }
+                continue;
+            }
+            int count = pollsockets(fds.data(), fds.size(), POLL_TIMEOUT_MS);
+            if (count < 0) {
+                auto error = handle_socket_error("poll(...) error");
+                logger.error() << error.what();
+                std::this_thread::sleep_for(
+                    std::chrono::milliseconds(POLL_TIMEOUT_MS)
+                );
+                continue;
+            }
+            for (size_t i = 0; i < fds.size(); i++) {
+                if (fds[i].revents) {
+                    polled[i]->onEvents(fds[i].revents);
+                }
+            }
+        }
+    }
+public:
+    SocketPoller() : thread([this]() { loop(); }) {
+    }
+
+    ~SocketPoller() {
+        {
+            std::lock_guard lock(mutex);
+            running = false;
+        }
+        condition.notify_one();
+        thread.join();
+    }
+
+    /// @brief Start polling the target. The target is kept alive
+    /// until removed
+    void add(std::shared_ptr<PollTarget> target) {
+        {
+            std::lock_guard lock(mutex);
+            added.push_back(std::move(target));
+        }
+        condition.notify_one();
+    }
+};
+
+class SocketConnection : public Connection,
+                         public PollTarget,
+                         public std::enable_shared_from_this<SocketConnection> {
+    SOCKET descriptor;
+    sockaddr_in addr;
+    SocketPoller& poller;
+    std::atomic<size_t> totalUpload = 0;
+    std::atomic<size_t> totalDownload = 0;
+    std::atomic<ConnectionState> state = ConnectionState::INITIAL;
+    runnable onConnected;
+    /// @brief Received bytes (written by the I/O thread)
+    util::SPSCByteRing received;
+    /// @brief Queued messages waiting for flush
+    std::vector<char> outgoing;
+    /// @brief Header of the message being received
+    std::optional<uint32_t> incomingHeader;
+    std::vector<ubyte> incoming;
+    size_t incomingSize = 0;
+
+    void finishConnect() {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(
+                descriptor, SOL_SOCKET, SO_ERROR, (char*)&error, &len
+            ) < 0) {
+            error = -1;
+        } else if (error) {
+            set_socket_error(error);
+        }
+        if (error || !set_nonblocking(descriptor, false)) {
             auto error = handle_socket_error("Connect failed");
-            closesocket(descriptor);
             state = ConnectionState::CLOSED;
             logger.error() << error.what();
             return;
         }
         logger.info() << "connected to " << to_string(addr);
         state = ConnectionState::CONNECTED;
+        if (onConnected) {
+            onConnected();
+        }
+    }
+
+    void receive() {
+        auto span = received.writeSpan();
+        int size = recvsocket(descriptor, span.data, span.size);
+        if (size == 0) {
+            logger.info() << "closed connection with " << to_string(addr);
+            state = ConnectionState::CLOSED;
+            return;
+        } else if (size < 0) {
+            logger.warning() << "an error ocurred while receiving from "
+                        << to_string(addr);
+            auto error = handle_socket_error("recv(...) error");
+            state = ConnectionState::CLOSED;
+            logger.error() << error.what();
+            return;
+        }
+        received.commitWrite(size);
+        totalDownload += size;
+        logger.debug() << "read " << size << " bytes from " << to_string(addr);
     }
 public:
-    SocketConnection(SOCKET descriptor, sockaddr_in addr)
-        : descriptor(descriptor), addr(std::move(addr)), buffer(16'384) {}
+    SocketConnection(SOCKET descriptor, sockaddr_in addr, SocketPoller& poller)
+        : descriptor(descriptor),
+          addr(std::move(addr)),
+          poller(poller),
+          received(RECEIVE_BUFFER_CAPACITY) {
+    }
 
     ~SocketConnection() {
         if (state != ConnectionState::CLOSED) {
             shutdown(descriptor, 2);
-            closesocket(descriptor);
         }
-        if (thread) {
-            thread->join();
-        }
-    }
-
-    void startListen() {
-        while (state == ConnectionState::CONNECTED) {
-            int size = recvsocket(descriptor, buffer.data(), buffer.size());
-            if (size == 0) {
-                logger.info() << "closed connection with " << to_string(addr);
-                closesocket(descriptor);
-                state = ConnectionState::CLOSED;
-                break;
-            } else if (size < 0) {
-                logger.warning() << "an error ocurred while receiving from "
-                            << to_string(addr);
-                auto error = handle_socket_error("recv(...) error");
-                closesocket(descriptor);
-                state = ConnectionState::CLOSED;
-                logger.error() << error.what();
-                break;
-            }
-            {
-                std::lock_guard lock(mutex);
-                for (size_t i = 0; i < size; i++) {
-                    readBatch.emplace_back(buffer[i]);
-                }
-                totalDownload += size;
-            }
-            logger.debug() << "read " << size << " bytes from " << to_string(addr);
+        // the poller does not use the descriptor anymore
+        closesocket(descriptor);
+    }
+
+    SOCKET getDescriptor() const override {
+        return descriptor;
+    }
+
+    short getEvents() const override {
+        switch (state) {
+            case ConnectionState::CONNECTING:
+                return POLLOUT;
+            case ConnectionState::CONNECTED:
+                // not reading until the script takes received bytes
+                return received.full() ? 0 : POLLIN;
+            default:
+                return 0;
         }
     }
 
+    void onEvents(short revents) override {
+        if (state == ConnectionState::CONNECTING) {
+            finishConnect();
+        } else if (state == ConnectionState::CONNECTED) {
+            receive();
+        }
+    }
+
+    bool isClosed() const override {
+        return state == ConnectionState::CLOSED;
+    }
+
     void startClient() {
         state = ConnectionState::CONNECTED;
-        thread = std::make_unique<std::thread>([this]() { startListen();});
+        poller.add(shared_from_this());
     }
 
     void connect(runnable callback) override {
-        thread = std::make_unique<std::thread>([this, callback]() {
-            connectSocket();
-            if (state == ConnectionState::CONNECTED) {
-                callback();
-            }
-            startListen();
-        });
+        onConnected = std::move(callback);
+        state = ConnectionState::CONNECTING;
+        logger.info() << "connecting to " << to_string(addr);
+        if (!set_nonblocking(descriptor, true)) {
+            auto error = handle_socket_error("Connect failed");
+            state = ConnectionState::CLOSED;
+            logger.error() << error.what();
+            return;
+        }
+        int res = connectsocket(
+            descriptor, (const sockaddr*)&addr, sizeof(sockaddr_in)
+        );
+        if (res < 0 && !is_connect_in_progress()) {
+            auto error = handle_socket_error("Connect failed");
+            state = ConnectionState::CLOSED;
+            logger.error() << error.what();
+            return;
+        }
+        // connection result is checked when socket becomes writable
+        poller.add(shared_from_this());
     }
 
     int recv(char* buffer, size_t length) override {
-        std::lock_guard lock(mutex);
-
-        if (state != ConnectionState::CONNECTED && readBatch.empty()) {
+        if (state != ConnectionState::CONNECTED && received.empty()) {
             return -1;
         }
-        int size = std::min(readBatch.size(), length);
-        std::memcpy(buffer, readBatch.data(), size);
-        readBatch.erase(readBatch.begin(), readBatch.begin() + size);
-        return size;
+        return received.read(buffer, length);
     }
 
     int send(const char* buffer, size_t length) override {
+        // keeping order with queued messages
+        flush();
+        return sendBytes(buffer, length);
+    }
+
+    size_t sendMessage(
+        const ubyte* data, size_t length, bool compress
+    ) override {
+        std::vector<ubyte> compressed;
+        if (compress) {
+            compressed = gzip::compress(data, length);
+            data = compressed.data();
+            length = compressed.size();
+        }
+        if (length > MAX_MESSAGE_SIZE) {
+            throw std::runtime_error(
+                "message is too large (" + std::to_string(length) + " bytes)"
+            );
+        }
+        uint32_t header = dataio::h2le(
+            static_cast<uint32_t>(length) |
+            (compress ? MESSAGE_COMPRESSED_FLAG : 0)
+        );
+        auto headerBytes = reinterpret_cast<const char*>(&header);
+        outgoing.insert(outgoing.end(), headerBytes, headerBytes + 4);
+        outgoing.insert(outgoing.end(), data, data + length);
+        if (outgoing.size() >= MAX_MESSAGES_BATCH) {
+            flush();
+        }
+        return length + sizeof(header);
+    }
+
+    bool recvMessage(std::vector<ubyte>& dst) override {
+        if (!incomingHeader) {
+            if (received.size() < sizeof(uint32_t)) {
+                return false;
+            }
+            uint32_t header;
+            received.read(reinterpret_cast<char*>(&header), sizeof(uint32_t));
+            header = dataio::le2h(header);
+            size_t length = header & ~MESSAGE_COMPRESSED_FLAG;
+            if (length > MAX_MESSAGE_SIZE) {
+                close();
+                throw std::runtime_error(
+                    "received message is too large (" +
+                    std::to_string(length) + " bytes)"
+                );
+            }
+            incomingHeader = header;
+            incoming.resize(length);
+            incomingSize = 0;
+        }
+        incomingSize += received.read(
+            reinterpret_cast<char*>(incoming.data()) + incomingSize,
+            incoming.size() - incomingSize
+        );
+        if (incomingSize < incoming.size()) {
+            return false;
+        }
+        if (*incomingHeader & MESSAGE_COMPRESSED_FLAG) {
+            try {
+                dst = gzip::decompress(
+                    incoming.data(), incoming.size(), MAX_MESSAGE_SIZE
+                );
+            } catch (const std::runtime_error& err) {
+                incomingHeader.reset();
+                close();
+                throw std::runtime_error(
+                    "invalid compressed message: " + std::string(err.what())
+                );
+            }
+        } else {
+            dst.assign(incoming.begin(), incoming.end());
+        }
+        incomingHeader.reset();
+        return true;
+    }
+
+    void flush() override {
+        if (outgoing.empty()) {
+            return;
+        }
+        size_t offset = 0;
+        while (offset < outgoing.size()) {
+            offset += sendBytes(
+                outgoing.data() + offset, outgoing.size() - offset
+            );
+        }
+        outgoing.clear();
+    }
+
+    int sendBytes(const char* buffer, size_t length) {
         int len = sendsocket(descriptor, buffer, length, 0);
         if (len == -1) {
             int err = errno;
+            outgoing.clear();
             close();
             throw std::runtime_error(
                 "Send failed [errno=" + std::to_string(err) + "]: "
@@ -363,31 +745,22 @@ public:
     }
 
     int available() override {
-        std::lock_guard lock(mutex);
-        return readBatch.size();
+        return received.size();
     }
 
     void close() override {
-        if (state != ConnectionState::CLOSED) {
+        if (state.exchange(ConnectionState::CLOSED) != ConnectionState::CLOSED) {
+            // descriptor is closed when the poller releases the connection
             shutdown(descriptor, 2);
-            closesocket(descriptor);
-        }
-        if (thread) {
-            thread->join();
-            thread = nullptr;
         }
     }
 
     size_t pullUpload() override {
-        size_t size = totalUpload;
-        totalUpload = 0;
-        return size;
+        return totalUpload.exchange(0);
     }
 
     size_t pullDownload() override {
-        size_t size = totalDownload;
-        totalDownload = 0;
-        return size;
+        return totalDownload.exchange(0);
     }
 
     int getPort() const override {
@@ -399,7 +772,10 @@ public:
     }
 
     static std::shared_ptr<SocketConnection> connect(
-        const std::string& address, int port, runnable callback
+        const std::string& address,
+        int port,
+        runnable callback,
+        SocketPoller& poller
     ) {
         addrinfo hints {};
 
@@ -419,10 +795,11 @@ public:
 
         SOCKET descriptor = socket(AF_INET, SOCK_STREAM, 0);
         if (descriptor == -1) {
-            freeaddrinfo(addrinfo);
             throw std::runtime_error("Could not create socket");
         }
-        auto socket = std::make_shared<SocketConnection>(descriptor, std::move(serverAddress));
+        auto socket = std::make_shared<SocketConnection>(
+            descriptor, std::move(serverAddress), poller
+        );
         socket->connect(std::move(callback));
         return socket;
     }
@@ -432,59 +809,77 @@ public:
     }
 };
 
-class SocketTcpSServer : public TcpServer {
+class SocketTcpSServer : public TcpServer,
+                         public PollTarget,
+                         public std::enable_shared_from_this<SocketTcpSServer> {
     Network* network;
+    SocketPoller& poller;
     SOCKET descriptor;
     std::vector<u64id_t> clients;
     std::mutex clientsMutex;
-    bool open = true;
-    std::unique_ptr<std::thread> thread = nullptr;
+    std::atomic<bool> open = true;
+    consumer<u64id_t> handler;
     int port;
 public:
-    SocketTcpSServer(Network* network, SOCKET descriptor, int port)
-    : network(network), descriptor(descriptor), port(port) {}
+    SocketTcpSServer(
+        Network* network, SocketPoller& poller, SOCKET descriptor, int port
+    )
+        : network(network), poller(poller), descriptor(descriptor), port(port) {
+    }
 
     ~SocketTcpSServer() {
         closeSocket();
+        closesocket(descriptor);
+    }
+
+    SOCKET getDescriptor() const override {
+        return descriptor;
+    }
+
+    short getEvents() const override {
+        return POLLIN;
+    }
+
+    bool isClosed() const override {
+        return !open;
+    }
+
+    void onEvents(short revents) override {
+        socklen_t addrlen = sizeof(sockaddr_in);
+        SOCKET clientDescriptor;
+        sockaddr_in address;
+        if ((clientDescriptor = accept(descriptor, (sockaddr*)&address, &addrlen)) == -1) {
+            close();
+            return;
+        }
+        logger.info() << "client connected: " << to_string(address);
+        auto socket = std::make_shared<SocketConnection>(
+            clientDescriptor, address, poller
+        );
+        socket->startClient();
+        u64id_t id = network->addConnection(socket);
+        {
+            std::lock_guard lock(clientsMutex);
+            clients.push_back(id);
+        }
+        handler(id);
     }
 
     void startListen(consumer<u64id_t> handler) override {
-        thread = std::make_unique<std::thread>([this, handler]() {
-            while (open) {
-                logger.info() << "listening for connections";
-                if (listen(descriptor, 2) < 0) {
-                    close();
-                    break;
-                }
-                socklen_t addrlen = sizeof(sockaddr_in);
-                SOCKET clientDescriptor;
-                sockaddr_in address;
-                logger.info() << "accepting clients";
-                if ((clientDescriptor = accept(descriptor, (sockaddr*)&address, &addrlen)) == -1) {
-                    close();
-                    break;
-                }
-                logger.info() << "client connected: " << to_string(address);
-                auto socket = std::make_shared<SocketConnection>(
-                    clientDescriptor, address
-                );
-                socket->startClient();
-                u64id_t id = network->addConnection(socket);
-                {
-                    std::lock_guard lock(clientsMutex);
-                    clients.push_back(id);
-                }
-                handler(id);
-            }
-        });
+        this->handler = std::move(handler);
+        logger.info() << "listening for connections";
+        if (listen(descriptor, SOMAXCONN) < 0) {
+            close();
+            return;
+        }
+        poller.add(shared_from_this());
     }
     
     void closeSocket() {
-        if (!open) {
+        if (!open.exchange(false)) {
             return;
         }
         logger.info() << "closing server";
-        open = false;
 
         {
             std::lock_guard lock(clientsMutex);
@@ -497,8 +892,6 @@ public:
         clients.clear();
 
         shutdown(descriptor, 2);
-        closesocket(descriptor);
-        thread->join();
     }
 
     void close() override {
@@ -514,7 +907,10 @@ public:
     }
 
     static std::shared_ptr<SocketTcpSServer> openServer(
-        Network* network, int port, consumer<u64id_t> handler
+        Network* network,
+        SocketPoller& poller,
+        int port,
+        consumer<u64id_t> handler
     ) {
         SOCKET descriptor = socket(
             AF_INET, SOCK_STREAM, 0
@@ -540,15 +936,16 @@ public:
             throw std::runtime_error("could not bind port "+std::to_string(port));
         }
         logger.info() << "opened server at port " << port;
-        auto server =
-            std::make_shared<SocketTcpSServer>(network, descriptor, port);
+        auto server = std::make_shared<SocketTcpSServer>(
+            network, poller, descriptor, port
+        );
         server->startListen(std::move(handler));
         return server;
     }
 };
 
 Network::Network(std::unique_ptr<Requests> requests)
-: requests(std::move(requests)) {
+: requests(std::move(requests)), poller(std::make_unique<SocketPoller>()) {
 }
 
 Network::~Network() = default;
@@ -586,14 +983,14 @@ u64id_t Network::connect(const std::string& address, int port, consumer<u64id_t>
     u64id_t id = nextConnection++;
     auto socket = SocketConnection::connect(address, port, [id, callback]() {
         callback(id);
-    });
+    }, *poller);
     connections[id] = std::move(socket);
     return id;
 }
 
 u64id_t Network::openServer(int port, consumer<u64id_t> handler) {
     u64id_t id = nextServer++;
-    auto server = SocketTcpSServer::openServer(this, port, handler);
+    auto server = SocketTcpSServer::openServer(this, *poller, port, handler);
     servers[id] = std::move(server);
     return id;
 }
@@ -615,6 +1012,10 @@ size_t Network::getTotalDownload() const {
 }
 
 void Network::update() {
+    static auto& metrics = debug::Metrics::getInstance();
+    static auto& connectionsGauge = metrics.gauge("network.connections");
+    static auto& uploadGauge = metrics.gauge("network.upload-bytes");
+    static auto& downloadGauge = metrics.gauge("network.download-bytes");
     requests->update();
 
     {
@@ -622,6 +1023,13 @@ void Network::update() {
         auto socketiter = connections.begin();
         while (socketiter != connections.end()) {
             auto socket = socketiter->second.get();
+            if (socket->getState() == ConnectionState::CONNECTED) {
+                try {
+                    socket->flush();
+                } catch (const std::runtime_error& err) {
+                    logger.error() << err.what();
+                }
+            }
             totalDownload += socket->pullDownload();
             totalUpload += socket->pullUpload();
             if (socket->available() == 0 && 
@@ -640,7 +1048,10 @@ void Network::update() {
             }
             ++serveriter;
         }
+        connectionsGauge.set(connections.size());
     }
+    uploadGauge.set(getTotalUpload());
+    downloadGauge.set(getTotalDownload());
 }
 
 std::unique_ptr<Network> Network::create(const NetworkSettings& settings) {
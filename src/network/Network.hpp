@@ -43,6 +43,20 @@ namespace network {
         virtual void close() = 0;
         virtual int available() = 0;
 
+        /// @brief Queue a length-prefixed message. Queued messages are
+        /// written with a single send on flush
+        /// @param compress compress message data with gzip
+        /// @return number of queued bytes including the message header
+        virtual size_t sendMessage(
+            const ubyte* data, size_t length, bool compress
+        ) = 0;
+        /// @brief Take the next completely received message.
+        /// Must not be mixed with raw recv of the connection
+        /// @return false if there is no complete message yet
+        virtual bool recvMessage(std::vector<ubyte>& dst) = 0;
+        /// @brief Send queued messages (called on Network::update)
+        virtual void flush() = 0;
+
         virtual size_t pullUpload() = 0;
         virtual size_t pullDownload() = 0;
 
@@ -61,6 +75,8 @@ namespace network {
         virtual int getPort() const = 0;
     };
 
+    class SocketPoller;
+
     class Network {
         std::unique_ptr<Requests> requests;
 
@@ -73,6 +89,9 @@ namespace network {
 
         size_t totalDownload = 0;
         size_t totalUpload = 0;
+
+        /// @brief I/O thread of all sockets (destroyed first)
+        std::unique_ptr<SocketPoller> poller;
     public:
         Network(std::unique_ptr<Requests> requests);
         ~Network();
@@ -1,12 +1,16 @@
 #include "Entities.hpp"
 
+#include <algorithm>
 #include <glm/ext/matrix_transform.hpp>
+#include <limits>
 #include <sstream>
 
 #include "assets/Assets.hpp"
 #include "content/Content.hpp"
 #include "data/dv_util.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Metrics.hpp"
+#include "debug/Profiler.hpp"
 #include "engine.hpp"
 #include "graphics/core/DrawContext.hpp"
 #include "graphics/core/LineBatch.hpp"
@@ -15,11 +19,20 @@
 #include "logic/scripting/scripting.hpp"
 #include "maths/FrustumCulling.hpp"
 #include "maths/rays.hpp"
+#include "Player.hpp"
+#include "Players.hpp"
 #include "EntityDef.hpp"
 #include "rigging.hpp"
 #include "physics/Hitbox.hpp"
 #include "physics/PhysicsSolver.hpp"
+#include "files/WorldFiles.hpp"
+#include "files/WorldRegions.hpp"
+#include "util/ThreadPool.hpp"
+#include "util/timeutil.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
 #include "world/Level.hpp"
+#include "world/World.hpp"
 
 static debug::Logger logger("entities");
 
@@ -28,12 +41,115 @@ static inline std::string COMP_RIGIDBODY = "rigidbody";
 static inline std::string COMP_SKELETON = "skeleton";
 static inline std::string SAVED_DATA_VARNAME = "SAVED_DATA";
 
+/// @brief Entities spatial index cell size in blocks
+static constexpr float GRID_CELL_SIZE = 16.0f;
+/// @brief Number of bodies integrated by a physics job
+static constexpr size_t PHYSICS_BATCH_SIZE = 32;
+/// @brief Saved entities of chunks farther from players are not spawned
+static constexpr float FROZEN_DISTANCE = 96.0f;
+/// @brief Max duration of frozen entities spawning per update
+/// (microseconds)
+static constexpr int64_t FROZEN_SPAWN_BUDGET = 2000;
+/// @brief Number of skeletons prepared by a render job
+static constexpr size_t SKELETONS_BATCH_SIZE = 64;
+/// @brief Bodies farther from players than the distance are simulated
+/// every second step, farther than the far distance - every fourth step
+static constexpr float PHYSICS_LOD_NEAR = 48.0f;
+static constexpr float PHYSICS_LOD_FAR = 96.0f;
+/// @brief Grounded body slower than this velocity for SLEEP_DELAY seconds
+/// falls asleep
+static constexpr float SLEEP_VELOCITY = 0.05f;
+static constexpr float SLEEP_DELAY = 1.0f;
+
+struct Entities::PhysicsJob {
+    size_t index;
+    PhysicsBody* bodies;
+    size_t count;
+};
+
+struct Entities::PhysicsResult {
+    size_t index;
+    std::vector<SensorContact> contacts;
+};
+
+class Entities::PhysicsWorker
+    : public util::Worker<Entities::PhysicsJob, Entities::PhysicsResult> {
+    const Level& level;
+public:
+    PhysicsWorker(const Level& level) : level(level) {
+    }
+
+    /// @brief Integrate hitboxes and collect sensor contacts.
+    /// Only reads chunks
+    static void stepBodies(
+        const PhysicsSolver& solver,
+        Chunks* chunks,
+        PhysicsBody* bodies,
+        size_t count,
+        std::vector<SensorContact>& contacts
+    ) {
+        for (size_t i = 0; i < count; i++) {
+            auto& body = bodies[i];
+            auto& hitbox = *body.hitbox;
+            if (body.delta > 0.0f) {
+                solver.step(chunks, &hitbox, body.delta, body.substeps);
+                hitbox.linearDamping = hitbox.grounded * 24;
+            }
+            solver.collectContacts(hitbox, body.uid, contacts);
+        }
+    }
+
+    PhysicsResult operator()(const PhysicsJob& job) override {
+        PhysicsResult result {job.index, {}};
+        stepBodies(
+            *level.physics,
+            level.chunks.get(),
+            job.bodies,
+            job.count,
+            result.contacts
+        );
+        return result;
+    }
+};
+
+/// @brief Expand compact voxels of chunks the body step may read.
+/// Expansion replaces voxel arrays, so it is done by the main thread
+/// before bodies are passed to workers
+static void expand_reached_chunks(
+    const Chunks& chunks,
+    const PhysicsSolver& solver,
+    const Hitbox& hitbox,
+    float delta
+) {
+    if (delta <= 0.0f) {
+        return;
+    }
+    glm::vec3 extent = hitbox.halfsize + solver.getReach(hitbox, delta);
+    glm::ivec3 min(glm::floor(hitbox.position - extent));
+    glm::ivec3 max(glm::floor(hitbox.position + extent));
+    for (int cz = floordiv(min.z, CHUNK_D); cz <= floordiv(max.z, CHUNK_D);
+         cz++) {
+        for (int cx = floordiv(min.x, CHUNK_W);
+             cx <= floordiv(max.x, CHUNK_W);
+             cx++) {
+            auto chunk = chunks.getChunk(cx, cz);
+            if (chunk && chunk->voxels.isCompact()) {
+                chunk->voxels.data();
+            }
+        }
+    }
+}
+
 void Transform::refresh() {
+    refresh(pos);
+}
+
+void Transform::refresh(const glm::vec3& position) {
     combined = glm::mat4(1.0f);
-    combined = glm::translate(combined, pos);
+    combined = glm::translate(combined, position);
     combined = glm::scale(combined, size);
     combined = combined * glm::mat4(rot);
-    displayPos = pos;
+    displayPos = position;
     displaySize = size;
     dirty = false;
 }
@@ -57,10 +173,132 @@ void Entity::setRig(const rigging::SkeletonConfig* rigConfig) {
     skeleton.calculated.matrices.resize(
         rigConfig->getBones().size(), glm::mat4(1.0f)
     );
+    skeleton.poseDirty = true;
 }
 
+void Entity::setPosition(glm::vec3 position) {
+    auto& body = registry.get<Rigidbody>(entity);
+    auto& transform = registry.get<Transform>(entity);
+    transform.setPos(position);
+    // moved instantly, not interpolated from the previous position
+    transform.prevPos = position;
+    body.hitbox.position = position;
+    body.wakeUp();
+    entities.updateIndex(entity);
+}
+
+struct Entities::SkeletonsJob {
+    RenderedSkeleton* skeletons;
+    size_t count;
+};
+
+struct Entities::SkeletonsResult {};
+
+class Entities::SkeletonsWorker
+    : public util::Worker<Entities::SkeletonsJob, Entities::SkeletonsResult> {
+public:
+    static void prepare(RenderedSkeleton* skeletons, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            auto& skeleton = *skeletons[i].skeleton;
+            skeleton.config->prepare(skeleton, *skeletons[i].matrix);
+        }
+    }
+
+    SkeletonsResult operator()(const SkeletonsJob& job) override {
+        prepare(job.skeletons, job.count);
+        return {};
+    }
+};
+
+struct Entities::ChunkEntitiesJob {
+    glm::ivec2 pos;
+    uint64_t id;
+};
+
+struct Entities::ChunkEntitiesResult {
+    glm::ivec2 pos;
+    uint64_t id;
+    dv::value entities;
+};
+
+class Entities::ChunkEntitiesWorker
+    : public util::Worker<ChunkEntitiesJob, ChunkEntitiesResult> {
+    WorldRegions& regions;
+public:
+    ChunkEntitiesWorker(WorldRegions& regions) : regions(regions) {
+    }
+
+    ChunkEntitiesResult operator()(const ChunkEntitiesJob& job) override {
+        dv::value entities = nullptr;
+        try {
+            auto root = regions.fetchEntities(job.pos.x, job.pos.y);
+            if (root.getType() == dv::value_type::object) {
+                entities = root["data"];
+            }
+        } catch (const std::exception& err) {
+            logger.error() << "could not read entities of chunk " << job.pos.x
+                           << ", " << job.pos.y << ": " << err.what();
+        }
+        return ChunkEntitiesResult {job.pos, job.id, std::move(entities)};
+    }
+};
+
 Entities::Entities(Level* level)
-    : level(level), sensorsTickClock(20, 3), updateTickClock(20, 3) {
+    : level(level),
+      sensorsTickClock(20, 3),
+      updateTickClock(20, 3),
+      grid(GRID_CELL_SIZE),
+      memorySource([this](debug::MemoryBreakdown& breakdown) {
+          constexpr size_t componentsSize =
+              sizeof(EntityId) + sizeof(Transform) + sizeof(Rigidbody) +
+              sizeof(ScriptComponents) + sizeof(rigging::Skeleton);
+          breakdown["entities"] +=
+              entities.size() * componentsSize +
+              physicsBodies.capacity() * sizeof(PhysicsBody);
+      }) {
+    if (util::TaskScheduler::getDefault().getThreadsCount() > 1) {
+        physicsPool = std::make_unique<
+            util::ThreadPool<PhysicsJob, PhysicsResult>>(
+            "entities-physics",
+            [level]() { return std::make_shared<PhysicsWorker>(*level); },
+            [this](PhysicsResult& result) {
+                physicsContacts.at(result.index) = std::move(result.contacts);
+            },
+            util::ThreadPool<PhysicsJob, PhysicsResult>::HALF
+        );
+        physicsPool->setPriority(util::TaskScheduler::Priority::HIGH);
+
+        skeletonsPool = std::make_unique<
+            util::ThreadPool<SkeletonsJob, SkeletonsResult>>(
+            "entities-skeletons",
+            []() { return std::make_shared<SkeletonsWorker>(); },
+            [](SkeletonsResult&) {},
+            util::ThreadPool<SkeletonsJob, SkeletonsResult>::HALF
+        );
+        skeletonsPool->setPriority(util::TaskScheduler::Priority::HIGH);
+    }
+    chunkEntitiesPool = std::make_unique<
+        util::ThreadPool<ChunkEntitiesJob, ChunkEntitiesResult>>(
+        "entities-loading",
+        [level]() {
+            return std::make_shared<ChunkEntitiesWorker>(
+                level->getWorld()->wfile->getRegions()
+            );
+        },
+        [this](ChunkEntitiesResult& result) {
+            onChunkEntitiesDecoded(result);
+        },
+        1
+    );
+    chunkEntitiesPool->setPriority(util::TaskScheduler::Priority::NORMAL);
+}
+
+Entities::~Entities() = default;
+
+void Entities::updateIndex(entt::entity entity) {
+    const auto& transform = registry.get<Transform>(entity);
+    const auto& body = registry.get<Rigidbody>(entity);
+    grid.update(entity, transform.pos, body.hitbox.halfsize);
 }
 
 template <void (*callback)(const Entity&, size_t, entityid_t)>
@@ -141,7 +379,7 @@ entityid_t Entities::spawn(
     uids[entity] = id;
 
     registry.emplace<EntityId>(entity, static_cast<entityid_t>(id), def);
-    const auto& tsf = registry.emplace<Transform>(
+    auto& tsf = registry.emplace<Transform>(
         entity,
         position,
         glm::vec3(1.0f),
@@ -172,6 +410,8 @@ entityid_t Entities::spawn(
         loadEntity(saved, get(id).value());
     }
     body.hitbox.position = tsf.pos;
+    tsf.prevPos = tsf.pos;
+    updateIndex(entity);
     scripting::on_entity_spawn(
         def, id, scripting.components, args, componentsMap);
     return id;
@@ -187,6 +427,101 @@ void Entities::despawn(entityid_t id) {
     }
 }
 
+void Entities::loadChunkEntities(int cx, int cz) {
+    uint64_t id = nextFrozenJob++;
+    frozenChunks[{cx, cz}] = FrozenChunk {id};
+    chunkEntitiesPool->enqueueJob(ChunkEntitiesJob {{cx, cz}, id});
+}
+
+void Entities::onChunkEntitiesDecoded(ChunkEntitiesResult& result) {
+    const auto& found = frozenChunks.find(result.pos);
+    if (found == frozenChunks.end() || found->second.job != result.id) {
+        // chunk is unloaded or the job is outdated
+        return;
+    }
+    if (result.entities == nullptr || result.entities.empty()) {
+        frozenChunks.erase(found);
+        return;
+    }
+    auto& frozen = found->second;
+    frozen.decoded = true;
+    frozen.entities = std::move(result.entities);
+    // saved entities must be written on unload even if all of them
+    // are despawned
+    if (auto chunk = level->chunks->getChunk(result.pos.x, result.pos.y)) {
+        chunk->flags.entities = true;
+    }
+}
+
+bool Entities::takeFrozenEntities(int cx, int cz, dv::value& list) {
+    const auto& found = frozenChunks.find({cx, cz});
+    if (found == frozenChunks.end()) {
+        return false;
+    }
+    auto& frozen = found->second;
+    if (!frozen.decoded) {
+        // the worker have not finished yet
+        auto root = level->getWorld()->wfile->getRegions().fetchEntities(cx, cz);
+        if (root.getType() == dv::value_type::object) {
+            frozen.entities = root["data"];
+        }
+    }
+    bool hadEntities = frozen.entities != nullptr;
+    if (hadEntities) {
+        for (size_t i = frozen.next; i < frozen.entities.size(); i++) {
+            list.add(std::move(frozen.entities[i]));
+        }
+    }
+    frozenChunks.erase(found);
+    return hadEntities;
+}
+
+void Entities::spawnFrozen() {
+    if (frozenChunks.empty()) {
+        return;
+    }
+    std::vector<glm::vec2> playersPositions;
+    for (const auto& [_, player] : *level->players) {
+        const auto& pos = player->getPosition();
+        playersPositions.emplace_back(pos.x, pos.z);
+    }
+    timeutil::Timer timer;
+    bool cleaned = false;
+    for (auto it = frozenChunks.begin(); it != frozenChunks.end();) {
+        auto& [pos, frozen] = *it;
+        glm::vec2 center =
+            (glm::vec2(pos) + 0.5f) * glm::vec2(CHUNK_W, CHUNK_D);
+        bool near = false;
+        for (const auto& playerPos : playersPositions) {
+            if (glm::distance2(center, playerPos) <=
+                FROZEN_DISTANCE * FROZEN_DISTANCE) {
+                near = true;
+                break;
+            }
+        }
+        if (!frozen.decoded || !near) {
+            ++it;
+            continue;
+        }
+        if (!cleaned) {
+            // despawned entities may have the same UIDs
+            clean();
+            cleaned = true;
+        }
+        while (frozen.next < frozen.entities.size()) {
+            try {
+                loadEntity(frozen.entities[frozen.next++]);
+            } catch (const std::runtime_error& err) {
+                logger.error() << "could not read entity: " << err.what();
+            }
+            if (timer.stop() >= FROZEN_SPAWN_BUDGET) {
+                return;
+            }
+        }
+        it = frozenChunks.erase(it);
+    }
+}
+
 void Entities::loadEntity(const dv::value& map) {
     entityid_t uid = map["uid"].asInteger();
     std::string defname = map["def"].asString();
@@ -244,26 +579,32 @@ std::optional<Entities::RaycastResult> Entities::rayCast(
     glm::vec3 start, glm::vec3 dir, float maxDistance, entityid_t ignore
 ) {
     Ray ray(start, dir);
-    auto view = registry.view<EntityId, Transform, Rigidbody>();
 
     entityid_t foundUID = 0;
     glm::ivec3 foundNormal;
 
-    for (auto [entity, eid, transform, body] : view.each()) {
-        if (eid.uid == ignore) {
-            continue;
-        }
-        auto& hitbox = body.hitbox;
-        glm::ivec3 normal;
-        double distance;
-        if (ray.intersectAABB(
-                glm::vec3(), hitbox.getAABB(), maxDistance, normal, distance
-            ) > RayRelation::None) {
-            foundUID = eid.uid;
-            foundNormal = normal;
-            maxDistance = static_cast<float>(distance);
+    glm::vec3 end = start + dir * maxDistance;
+    grid.query(
+        glm::min(start, end),
+        glm::max(start, end),
+        true,
+        [&](entt::entity entity) {
+            const auto& eid = registry.get<EntityId>(entity);
+            if (eid.uid == ignore) {
+                return;
+            }
+            const auto& hitbox = registry.get<Rigidbody>(entity).hitbox;
+            glm::ivec3 normal;
+            double distance;
+            if (ray.intersectAABB(
+                    glm::vec3(), hitbox.getAABB(), maxDistance, normal, distance
+                ) > RayRelation::None) {
+                foundUID = eid.uid;
+                foundNormal = normal;
+                maxDistance = static_cast<float>(distance);
+            }
         }
-    }
+    );
     if (foundUID) {
         return Entities::RaycastResult {foundUID, foundNormal, maxDistance};
     } else {
@@ -385,6 +726,7 @@ void Entities::clean() {
                 physics->removeSensor(&sensor);
             }
             uids.erase(it->second);
+            grid.remove(it->second);
             registry.destroy(it->second);
             it = entities.erase(it);
         }
@@ -397,11 +739,13 @@ void Entities::updateSensors(
     for (size_t i = 0; i < body.sensors.size(); i++) {
         auto& sensor = body.sensors[i];
         for (auto oid : sensor.prevEntered) {
-            if (sensor.nextEntered.find(oid) == sensor.nextEntered.end()) {
+            if (!std::binary_search(
+                    sensor.nextEntered.begin(), sensor.nextEntered.end(), oid
+                )) {
                 sensor.exitCallback(sensor.entity, i, oid);
             }
         }
-        sensor.prevEntered = sensor.nextEntered;
+        std::swap(sensor.prevEntered, sensor.nextEntered);
         sensor.nextEntered.clear();
 
         switch (sensor.type) {
@@ -444,42 +788,238 @@ void Entities::preparePhysics(float delta) {
 }
 
 void Entities::updatePhysics(float delta) {
+    debug::ProfileZone zone("entities-physics");
     preparePhysics(delta);
 
-    auto view = registry.view<EntityId, Transform, Rigidbody>();
-    auto physics = level->physics.get();
-    for (auto [entity, eid, transform, rigidbody] : view.each()) {
+    for (auto [entity, transform] : registry.view<Transform>().each()) {
+        transform.prevPos = transform.pos;
+    }
+    wakeUpBodies();
+    physicsStep++;
+    physicsStats = {};
+
+    std::vector<glm::vec3> playersPositions;
+    std::vector<entityid_t> playersEntities;
+    for (const auto& [_, player] : *level->players) {
+        playersPositions.push_back(player->getPosition());
+        playersEntities.push_back(player->getEntity());
+    }
+
+    physicsBodies.clear();
+    auto view = registry.view<EntityId, Rigidbody>();
+    for (auto [entity, eid, rigidbody] : view.each()) {
         if (!rigidbody.enabled || rigidbody.hitbox.type == BodyType::STATIC) {
             continue;
         }
         auto& hitbox = rigidbody.hitbox;
-        auto prevVel = hitbox.velocity;
-        bool grounded = hitbox.grounded;
-
-        float vel = glm::length(prevVel);
-        int substeps = static_cast<int>(delta * vel * 20);
+        if (rigidbody.sleeping && glm::length2(hitbox.velocity) > 0.0f) {
+            // impulse applied
+            rigidbody.wakeUp();
+        }
+        float bodyDelta = 0.0f;
+        if (rigidbody.sleeping) {
+            physicsStats.sleeping++;
+        } else {
+            float distance2 = std::numeric_limits<float>::max();
+            for (const auto& pos : playersPositions) {
+                distance2 = std::min(
+                    distance2, glm::distance2(pos, hitbox.position)
+                );
+            }
+            int interval = 1;
+            if (distance2 > PHYSICS_LOD_FAR * PHYSICS_LOD_FAR) {
+                interval = 4;
+            } else if (distance2 > PHYSICS_LOD_NEAR * PHYSICS_LOD_NEAR) {
+                interval = 2;
+            }
+            rigidbody.skippedTime += delta;
+            if ((physicsStep + eid.uid) % interval == 0) {
+                bodyDelta = rigidbody.skippedTime;
+                rigidbody.skippedTime = 0.0f;
+                physicsStats.simulated++;
+            } else {
+                physicsStats.skipped++;
+            }
+        }
+        float vel = glm::length(hitbox.velocity);
+        int substeps = static_cast<int>(bodyDelta * vel * 20);
         substeps = std::min(100, std::max(2, substeps));
-        physics->step(level->chunks.get(), &hitbox, delta, substeps, eid.uid);
-        hitbox.linearDamping = hitbox.grounded * 24;
-        transform.setPos(hitbox.position);
-        if (hitbox.grounded && !grounded) {
+        physicsBodies.push_back(PhysicsBody {
+            entity,
+            eid.uid,
+            &hitbox,
+            bodyDelta,
+            static_cast<uint>(substeps),
+            hitbox.velocity,
+            hitbox.grounded});
+    }
+
+    // bodies are integrated in parallel, events are dispatched after it
+    // in the bodies order, so results do not depend on threads timings
+    size_t batches =
+        (physicsBodies.size() + PHYSICS_BATCH_SIZE - 1) / PHYSICS_BATCH_SIZE;
+    physicsContacts.resize(std::max<size_t>(1, batches));
+    for (auto& contacts : physicsContacts) {
+        contacts.clear();
+    }
+    if (physicsPool == nullptr || batches <= 1) {
+        PhysicsWorker::stepBodies(
+            *level->physics,
+            level->chunks.get(),
+            physicsBodies.data(),
+            physicsBodies.size(),
+            physicsContacts[0]
+        );
+    } else {
+        for (const auto& body : physicsBodies) {
+            expand_reached_chunks(
+                *level->chunks, *level->physics, *body.hitbox, body.delta
+            );
+        }
+        for (size_t i = 0; i < batches; i++) {
+            size_t offset = i * PHYSICS_BATCH_SIZE;
+            physicsPool->enqueueJob(PhysicsJob {
+                i,
+                physicsBodies.data() + offset,
+                std::min(PHYSICS_BATCH_SIZE, physicsBodies.size() - offset)});
+        }
+        physicsPool->waitForJobs();
+    }
+
+    for (const auto& body : physicsBodies) {
+        if (body.delta > 0.0f) {
+            registry.get<Transform>(body.entity).setPos(body.hitbox->position);
+        }
+    }
+    for (const auto& contacts : physicsContacts) {
+        for (const auto& contact : contacts) {
+            PhysicsSolver::dispatchContact(contact);
+        }
+    }
+    for (const auto& body : physicsBodies) {
+        if (body.delta == 0.0f) {
+            continue;
+        }
+        // scripts may spawn entities, so components are requested again
+        const auto& hitbox = registry.get<Rigidbody>(body.entity).hitbox;
+        if (hitbox.grounded && !body.grounded) {
             scripting::on_entity_grounded(
-                *get(eid.uid), glm::length(prevVel - hitbox.velocity)
+                *get(body.uid), glm::length(body.prevVelocity - hitbox.velocity)
             );
         }
-        if (!hitbox.grounded && grounded) {
-            scripting::on_entity_fall(*get(eid.uid));
+        if (!hitbox.grounded && body.grounded) {
+            scripting::on_entity_fall(*get(body.uid));
         }
+        // players bodies are controlled every frame, so never fall asleep
+        if (std::find(
+                playersEntities.begin(), playersEntities.end(), body.uid
+            ) == playersEntities.end()) {
+            updateSleeping(registry.get<Rigidbody>(body.entity), body.delta);
+        }
+    }
+    for (auto [entity, transform, rigidbody] :
+         registry.view<Transform, Rigidbody>().each()) {
+        grid.update(entity, transform.pos, rigidbody.hitbox.halfsize);
+    }
+
+    auto& metrics = debug::Metrics::getInstance();
+    static auto& simulatedGauge = metrics.gauge("entities.physics-simulated");
+    static auto& sleepingGauge = metrics.gauge("entities.physics-sleeping");
+    static auto& skippedGauge = metrics.gauge("entities.physics-skipped");
+    simulatedGauge.set(physicsStats.simulated);
+    sleepingGauge.set(physicsStats.sleeping);
+    skippedGauge.set(physicsStats.skipped);
+}
+
+void Entities::updateSleeping(Rigidbody& body, float delta) {
+    const auto& hitbox = body.hitbox;
+    if (!hitbox.grounded ||
+        glm::length2(hitbox.velocity) > SLEEP_VELOCITY * SLEEP_VELOCITY) {
+        body.restTime = 0.0f;
+        return;
+    }
+    body.restTime += delta;
+    if (body.restTime >= SLEEP_DELAY) {
+        body.sleeping = true;
+        body.hitbox.velocity = glm::vec3(0.0f);
+    }
+}
+
+void Entities::wakeUpBodies() {
+    if (!level->chunks->takeChangedBlocks(changedBlocks)) {
+        for (auto [entity, rigidbody] : registry.view<Rigidbody>().each()) {
+            rigidbody.wakeUp();
+        }
+        return;
+    }
+    for (const auto& pos : changedBlocks) {
+        // blocks touching the hitbox or right below it
+        glm::vec3 min = glm::vec3(pos) - 1.0f;
+        glm::vec3 max = glm::vec3(pos) + 2.0f;
+        grid.query(min, max, true, [&](entt::entity entity) {
+            auto& rigidbody = registry.get<Rigidbody>(entity);
+            if (rigidbody.sleeping &&
+                rigidbody.hitbox.getAABB().intersect(AABB(min, max))) {
+                rigidbody.wakeUp();
+            }
+        });
     }
 }
 
 void Entities::update(float delta) {
+    static auto& entitiesGauge =
+        debug::Metrics::getInstance().gauge("entities.count");
+    static auto& frozenGauge =
+        debug::Metrics::getInstance().gauge("entities.frozen-chunks");
+    debug::ProfileZone zone("entities-update");
+    chunkEntitiesPool->update();
+    spawnFrozen();
+    entitiesGauge.set(entities.size());
+    frozenGauge.set(frozenChunks.size());
     if (updateTickClock.update(delta)) {
-        scripting::on_entities_update(
-            updateTickClock.getTickRate(),
+        collectComponents(
+            &UserComponent::onUpdate,
             updateTickClock.getParts(),
             updateTickClock.getPart()
         );
+        scripting::on_components_update(
+            updateTickClock.getTickRate(), collectedComponents
+        );
+    }
+}
+
+void Entities::collectComponents(
+    std::shared_ptr<int> UserComponent::*callback, int parts, int part
+) {
+    for (auto& scripts : scriptsByDef) {
+        scripts.clear();
+    }
+    auto view = registry.view<EntityId, ScriptComponents>();
+    for (auto [entity, eid, scripting] : view.each()) {
+        if (eid.uid % parts != static_cast<entityid_t>(part)) {
+            continue;
+        }
+        size_t index = eid.def.rt.id;
+        if (index >= scriptsByDef.size()) {
+            scriptsByDef.resize(index + 1);
+        }
+        scriptsByDef[index].push_back(&scripting);
+    }
+    collectedComponents.clear();
+    for (const auto& scripts : scriptsByDef) {
+        if (scripts.empty()) {
+            continue;
+        }
+        // entities of a definition have the same components list
+        size_t count = scripts[0]->components.size();
+        for (size_t i = 0; i < count; i++) {
+            for (auto scripting : scripts) {
+                auto component = scripting->components[i].get();
+                if (component->*callback) {
+                    collectedComponents.push_back(component);
+                }
+            }
+        }
     }
 }
 
@@ -504,6 +1044,10 @@ static void debug_render_skeleton(
     }
 }
 
+void Entities::setInterpolation(float interpolation) {
+    this->interpolation = glm::clamp(interpolation, 0.0f, 1.0f);
+}
+
 void Entities::renderDebug(
     LineBatch& batch, const Frustum* frustum, const DrawContext& pctx
 ) {
@@ -557,20 +1101,58 @@ void Entities::render(
     bool pause
 ) {
     if (!pause) {
-        scripting::on_entities_render(delta);
+        collectComponents(&UserComponent::onRender, 1, 0);
+        scripting::on_components_render(delta, collectedComponents);
     }
 
+    renderedSkeletons.clear();
+    skeletonsBoxes.clear();
     auto view = registry.view<Transform, rigging::Skeleton>();
     for (auto [entity, transform, skeleton] : view.each()) {
-        if (transform.dirty) {
-            transform.refresh();
-        }
         const auto& pos = transform.pos;
+        auto displayPos = glm::mix(transform.prevPos, pos, interpolation);
+        if (transform.dirty ||
+            glm::distance2(transform.displayPos, displayPos) >=
+                Transform::EPSILON) {
+            transform.refresh(displayPos);
+        }
         const auto& size = transform.size;
-        if (!frustum || frustum->isBoxVisible(pos - size, pos + size)) {
-            const auto* rigConfig = skeleton.config;
-            rigConfig->render(assets, batch, skeleton, transform.combined);
+        renderedSkeletons.push_back({&skeleton, &transform.combined});
+        skeletonsBoxes.push(pos - size, pos + size);
+    }
+    // culled skeletons bones matrices are not calculated
+    if (frustum) {
+        frustum->areBoxesVisible(skeletonsBoxes, skeletonsVisible);
+        size_t visible = 0;
+        for (size_t i = 0; i < renderedSkeletons.size(); i++) {
+            if (skeletonsVisible[i]) {
+                renderedSkeletons[visible++] = renderedSkeletons[i];
+            }
         }
+        renderedSkeletons.resize(visible);
+    }
+
+    // bones matrices of unchanged skeletons are kept from previous frames
+    size_t batches = (renderedSkeletons.size() + SKELETONS_BATCH_SIZE - 1) /
+                     SKELETONS_BATCH_SIZE;
+    if (skeletonsPool == nullptr || batches <= 1) {
+        SkeletonsWorker::prepare(
+            renderedSkeletons.data(), renderedSkeletons.size()
+        );
+    } else {
+        for (size_t i = 0; i < batches; i++) {
+            size_t offset = i * SKELETONS_BATCH_SIZE;
+            skeletonsPool->enqueueJob(SkeletonsJob {
+                renderedSkeletons.data() + offset,
+                std::min(
+                    SKELETONS_BATCH_SIZE, renderedSkeletons.size() - offset
+                )});
+        }
+        skeletonsPool->waitForJobs();
+    }
+    for (const auto& rendered : renderedSkeletons) {
+        auto& skeleton = *rendered.skeleton;
+        skeleton.config->render(assets, batch, skeleton, *rendered.matrix);
     }
 }
 
@@ -584,35 +1166,46 @@ bool Entities::hasBlockingInside(AABB aabb) {
     return false;
 }
 
+void Entities::getAllInside(AABB aabb, std::vector<entityid_t>& dst) {
+    grid.query(aabb.min(), aabb.max(), false, [&](entt::entity entity) {
+        if (aabb.contains(registry.get<Transform>(entity).pos)) {
+            dst.push_back(registry.get<EntityId>(entity).uid);
+        }
+    });
+}
+
+void Entities::getAllInRadius(
+    glm::vec3 center, float radius, std::vector<entityid_t>& dst
+) {
+    glm::vec3 extent(radius);
+    auto callback = [&](entt::entity entity) {
+        const auto& pos = registry.get<Transform>(entity).pos;
+        if (glm::distance2(pos, center) <= radius * radius) {
+            dst.push_back(registry.get<EntityId>(entity).uid);
+        }
+    };
+    grid.query(center - extent, center + extent, false, callback);
+}
+
 std::vector<Entity> Entities::getAllInside(AABB aabb) {
+    std::vector<entityid_t> found;
+    getAllInside(aabb, found);
     std::vector<Entity> collected;
-    auto view = registry.view<Transform>();
-    for (auto [entity, transform] : view.each()) {
-        if (aabb.contains(transform.pos)) {
-            const auto& found = uids.find(entity);
-            if (found == uids.end()) {
-                continue;
-            }
-            if (auto wrapper = get(found->second)) {
-                collected.push_back(*wrapper);
-            }
+    for (auto uid : found) {
+        if (auto wrapper = get(uid)) {
+            collected.push_back(*wrapper);
         }
     }
     return collected;
 }
 
 std::vector<Entity> Entities::getAllInRadius(glm::vec3 center, float radius) {
+    std::vector<entityid_t> found;
+    getAllInRadius(center, radius, found);
     std::vector<Entity> collected;
-    auto view = registry.view<Transform>();
-    for (auto [entity, transform] : view.each()) {
-        if (glm::distance2(transform.pos, center) <= radius * radius) {
-            const auto& found = uids.find(entity);
-            if (found == uids.end()) {
-                continue;
-            }
-            if (auto wrapper = get(found->second)) {
-                collected.push_back(*wrapper);
-            }
+    for (auto uid : found) {
+        if (auto wrapper = get(uid)) {
+            collected.push_back(*wrapper);
         }
     }
     return collected;
@@ -6,11 +6,15 @@
 #include <vector>
 
 #include "data/dv.hpp"
+#include "debug/MemoryUsage.hpp"
+#include "maths/FrustumCulling.hpp"
 #include "physics/Hitbox.hpp"
 #include "typedefs.hpp"
 #include "util/Clock.hpp"
+#include "util/SpatialGrid.hpp"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <entt/entity/registry.hpp>
+#include <glm/gtx/hash.hpp>
 #include <glm/gtx/norm.hpp>
 #include <unordered_map>
 
@@ -46,9 +50,15 @@ struct Transform {
 
     glm::vec3 displayPos;
     glm::vec3 displaySize;
+    /// @brief Position at the start of the last simulation tick,
+    /// rendered position is interpolated from it to pos
+    glm::vec3 prevPos;
 
     void refresh();
 
+    /// @brief Refresh the matrix placing the transform at the position
+    void refresh(const glm::vec3& position);
+
     inline void setRot(glm::mat3 m) {
         rot = m;
         dirty = true;
@@ -73,12 +83,28 @@ struct Rigidbody {
     bool enabled = true;
     Hitbox hitbox;
     std::vector<Sensor> sensors;
+    /// @brief Body is not simulated until woken up by an impulse,
+    /// nearby block change or Entity::setPosition
+    bool sleeping = false;
+    /// @brief Time the body is at rest (seconds)
+    float restTime = 0.0f;
+    /// @brief Time not simulated yet because of distance LOD
+    float skippedTime = 0.0f;
+
+    void wakeUp() {
+        sleeping = false;
+        restTime = 0.0f;
+    }
 };
 
 struct UserComponent {
     std::string name;
     entity_funcs_set funcsset;
     scriptenv env;
+    /// @brief Registry references of on_update and on_render functions
+    /// (nullptr if not defined), called by the engine in batches
+    std::shared_ptr<int> onUpdate;
+    std::shared_ptr<int> onRender;
 
     UserComponent(
         const std::string& name, entity_funcs_set funcsset, scriptenv env
@@ -104,6 +130,12 @@ class ModelBatch;
 class Frustum;
 class Entities;
 class DrawContext;
+struct SensorContact;
+
+namespace util {
+    template <class T, class R>
+    class ThreadPool;
+}
 
 namespace rigging {
     struct Skeleton;
@@ -153,6 +185,10 @@ public:
 
     void setRig(const rigging::SkeletonConfig* rigConfig);
 
+    /// @brief Move transform and hitbox keeping the spatial index updated.
+    /// The move is instant (not interpolated between ticks)
+    void setPosition(glm::vec3 position);
+
     entityid_t getUID() const {
         return registry.get<EntityId>(entity).uid;
     }
@@ -164,6 +200,14 @@ public:
     void destroy();
 };
 
+struct EntitiesPhysicsStats {
+    /// @brief Bodies simulated at the last step
+    size_t simulated = 0;
+    size_t sleeping = 0;
+    /// @brief Bodies skipped at the last step because of distance
+    size_t skipped = 0;
+};
+
 class Entities {
     entt::registry registry;
     Level* level;
@@ -173,10 +217,98 @@ class Entities {
     util::Clock sensorsTickClock;
     util::Clock updateTickClock;
 
+    /// @brief Script components of entities by definition index
+    std::vector<std::vector<ScriptComponents*>> scriptsByDef;
+    std::vector<UserComponent*> collectedComponents;
+    /// @brief Entities by position used by area queries and raycasts.
+    /// Updated on spawn, physics step and Entity::setPosition
+    util::SpatialGrid<entt::entity> grid;
+
+    /// @brief Body integrated in the physics step
+    struct PhysicsBody {
+        entt::entity entity;
+        entityid_t uid;
+        Hitbox* hitbox;
+        /// @brief Body time step, zero if the body is not simulated
+        /// (sleeping or skipped by LOD) but still checked by sensors
+        float delta;
+        uint substeps;
+        glm::vec3 prevVelocity;
+        bool grounded;
+    };
+    struct PhysicsJob;
+    struct PhysicsResult;
+    class PhysicsWorker;
+    std::vector<PhysicsBody> physicsBodies;
+    /// @brief Sensor contacts collected by physics jobs in bodies order
+    std::vector<std::vector<SensorContact>> physicsContacts;
+    std::unique_ptr<util::ThreadPool<PhysicsJob, PhysicsResult>> physicsPool;
+    uint64_t physicsStep = 0;
+    /// @brief Part of the simulation tick elapsed since the last tick
+    /// [0, 1], used to interpolate rendered transforms
+    float interpolation = 1.0f;
+
+    /// @brief Visible skeleton with its entity transform matrix
+    struct RenderedSkeleton {
+        rigging::Skeleton* skeleton;
+        const glm::mat4* matrix;
+    };
+    struct SkeletonsJob;
+    struct SkeletonsResult;
+    class SkeletonsWorker;
+    std::vector<RenderedSkeleton> renderedSkeletons;
+    /// @brief Skeletons boxes culled in one pass and their results
+    PackedBoxes skeletonsBoxes;
+    std::vector<uint8_t> skeletonsVisible;
+    std::unique_ptr<util::ThreadPool<SkeletonsJob, SkeletonsResult>>
+        skeletonsPool;
+
+    /// @brief Saved entities of a loaded chunk not spawned yet. Entities
+    /// are read and decoded by a worker, then spawned under a time budget
+    /// when a player is close enough to the chunk
+    struct FrozenChunk {
+        /// @brief Id of the last read job, results of previous jobs of
+        /// the same chunk are ignored
+        uint64_t job;
+        bool decoded = false;
+        /// @brief List of serialized entities
+        dv::value entities = nullptr;
+        /// @brief Index of the next entity to spawn
+        size_t next = 0;
+    };
+    struct ChunkEntitiesJob;
+    struct ChunkEntitiesResult;
+    class ChunkEntitiesWorker;
+    std::unordered_map<glm::ivec2, FrozenChunk> frozenChunks;
+    uint64_t nextFrozenJob = 1;
+    std::unique_ptr<util::ThreadPool<ChunkEntitiesJob, ChunkEntitiesResult>>
+        chunkEntitiesPool;
+
+    void onChunkEntitiesDecoded(ChunkEntitiesResult& result);
+    /// @brief Spawn entities of frozen chunks near players
+    void spawnFrozen();
+    EntitiesPhysicsStats physicsStats;
+    std::vector<glm::ivec3> changedBlocks;
+    /// @brief Reports components of entities as "entities", components
+    /// heap data (hitboxes, poses, script environments) is not included
+    debug::MemorySource memorySource;
+
+    /// @brief Wake up sleeping bodies touching changed blocks
+    void wakeUpBodies();
+    /// @brief Put the body to sleep if it is at rest long enough
+    void updateSleeping(Rigidbody& body, float delta);
+
     void updateSensors(
         Rigidbody& body, const Transform& tsf, std::vector<Sensor*>& sensors
     );
     void preparePhysics(float delta);
+
+    /// @brief Collect components defining the callback to
+    /// collectedComponents grouped by type (entity definition and
+    /// component index) for the entities with uid % parts == part
+    void collectComponents(
+        std::shared_ptr<int> UserComponent::*callback, int parts, int part
+    );
 public:
     struct RaycastResult {
         entityid_t entity;
@@ -185,11 +317,23 @@ public:
     };
 
     Entities(Level* level);
+    ~Entities();
 
     void clean();
     void updatePhysics(float delta);
     void update(float delta);
 
+    /// @brief Set part of the simulation tick elapsed since the last tick
+    /// @param interpolation [0, 1], 1 renders transforms as is
+    void setInterpolation(float interpolation);
+
+    float getInterpolation() const {
+        return interpolation;
+    }
+
+    /// @brief Update spatial index position of the entity
+    void updateIndex(entt::entity entity);
+
     void renderDebug(
         LineBatch& batch, const Frustum* frustum, const DrawContext& ctx
     );
@@ -232,12 +376,25 @@ public:
     );
 
     void loadEntities(dv::value map);
+    /// @brief Start reading saved entities of the loaded chunk. Entities
+    /// are spawned later, see FrozenChunk
+    void loadChunkEntities(int cx, int cz);
+    /// @brief Move serialized entities of the chunk not spawned yet to
+    /// the list. Used on chunk unload
+    /// @return true if the chunk had saved entities
+    bool takeFrozenEntities(int cx, int cz, dv::value& list);
     void loadEntity(const dv::value& map);
     void loadEntity(const dv::value& map, Entity entity);
     void onSave(const Entity& entity);
     bool hasBlockingInside(AABB aabb);
     std::vector<Entity> getAllInside(AABB aabb);
     std::vector<Entity> getAllInRadius(glm::vec3 center, float radius);
+    /// @brief Write UIDs of entities with position inside the box to dst
+    void getAllInside(AABB aabb, std::vector<entityid_t>& dst);
+    /// @brief Write UIDs of entities with position in the radius to dst
+    void getAllInRadius(
+        glm::vec3 center, float radius, std::vector<entityid_t>& dst
+    );
     void despawn(entityid_t id);
     void despawn(std::vector<Entity> entities);
     dv::value serialize(const Entity& entity);
@@ -254,4 +411,8 @@ public:
     inline entityid_t peekNextID() const {
         return nextID;
     }
+
+    const EntitiesPhysicsStats& getPhysicsStats() const {
+        return physicsStats;
+    }
 };
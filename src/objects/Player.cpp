@@ -66,6 +66,17 @@ void Player::updateEntity() {
     }
 }
 
+glm::vec3 Player::getInterpolatedPosition() const {
+    auto entity = level->entities->get(eid);
+    if (!entity.has_value()) {
+        return position;
+    }
+    const auto& transform = entity->getTransform();
+    return glm::mix(
+        transform.prevPos, transform.pos, level->entities->getInterpolation()
+    );
+}
+
 Hitbox* Player::getHitbox() {
     if (auto entity = level->entities->get(eid)) {
         return &entity->getRigidbody().hitbox;
@@ -184,14 +195,14 @@ void Player::postUpdate() {
             glm::mat4(1.0f), glm::radians(cam.y), glm::vec3(1, 0, 0)
         );
     }
+    skeleton.poseDirty = true;
 }
 
 void Player::teleport(glm::vec3 position) {
     this->position = position;
 
     if (auto entity = level->entities->get(eid)) {
-        entity->getRigidbody().hitbox.position = position;
-        entity->getTransform().setPos(position);
+        entity->setPosition(position);
     }
 }
 
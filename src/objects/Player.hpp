@@ -111,6 +111,10 @@ public:
         return position;
     }
 
+    /// @brief Get position interpolated between the last simulation ticks
+    /// (see Entities::getInterpolation) to be rendered
+    glm::vec3 getInterpolatedPosition() const;
+
     Hitbox* getHitbox();
 
     void setSpawnPoint(glm::vec3 point);
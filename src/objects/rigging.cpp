@@ -94,13 +94,24 @@ void SkeletonConfig::update(Skeleton& skeleton, glm::mat4 matrix) const {
     update(0, skeleton, root.get(), matrix);
 }
 
+void SkeletonConfig::prepare(
+    Skeleton& skeleton, const glm::mat4& matrix
+) const {
+    if (!skeleton.poseDirty && skeleton.calculatedMatrix == matrix) {
+        return;
+    }
+    update(skeleton, matrix);
+    skeleton.calculatedMatrix = matrix;
+    skeleton.poseDirty = false;
+}
+
 void SkeletonConfig::render(
     const Assets& assets,
     ModelBatch& batch,
     Skeleton& skeleton,
     const glm::mat4& matrix
 ) const {
-    update(skeleton, matrix);
+    prepare(skeleton, matrix);
 
     if (!skeleton.visible) {
         return;
@@ -75,8 +75,13 @@ namespace rigging {
 
     struct Skeleton {
         const SkeletonConfig* config;
+        /// @brief Bones local matrices. Set poseDirty after modification
         Pose pose;
+        /// @brief Bones matrices calculated for calculatedMatrix
         Pose calculated;
+        /// @brief Pose or config changed since calculation
+        bool poseDirty = true;
+        glm::mat4 calculatedMatrix {1.0f};
         std::vector<BoneFlags> flags;
         std::unordered_map<std::string, std::string> textures;
         std::vector<ModelReference> modelOverrides;
@@ -110,6 +115,13 @@ namespace rigging {
         );
 
         void update(Skeleton& skeleton, glm::mat4 matrix) const;
+
+        /// @brief Calculate bones matrices if the pose or the matrix
+        /// changed since last calculation. Only modifies the skeleton,
+        /// so different skeletons may be prepared in parallel
+        void prepare(Skeleton& skeleton, const glm::mat4& matrix) const;
+
+        /// @brief Prepare and draw the skeleton
         void render(
             const Assets& assets,
             ModelBatch& batch,
@@ -3,8 +3,8 @@
 #include "maths/aabb.hpp"
 #include "typedefs.hpp"
 
-#include <set>
 #include <string>
+#include <vector>
 #include <optional>
 #include <functional>
 #include <glm/glm.hpp>
@@ -31,8 +31,10 @@ struct Sensor {
     entityid_t entity;
     SensorParams params;
     SensorParams calculated;
-    std::set<entityid_t> prevEntered;
-    std::set<entityid_t> nextEntered;
+    /// @brief Sorted UIDs of entities inside at the previous update
+    std::vector<entityid_t> prevEntered;
+    /// @brief Sorted UIDs of entities entered since the previous update
+    std::vector<entityid_t> nextEntered;
     sensorcallback enterCallback;
     sensorcallback exitCallback;
 };
@@ -0,0 +1,83 @@
+#include "ObstaclesCache.hpp"
+
+#include "content/Content.hpp"
+#include "constants.hpp"
+#include "maths/aabb.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunks.hpp"
+
+/// @brief Returned for full cube obstacles, same as the single block hitbox
+static const AABB FULL_CUBE;
+
+static bool is_full_cube(const Block& def, const voxel& vox) {
+    if (def.rt.extended || vox.state.segment) {
+        return false;
+    }
+    const auto& boxes =
+        def.rotatable ? def.rt.hitboxes[vox.state.rotation] : def.hitboxes;
+    return boxes.size() == 1 && boxes[0].min() == FULL_CUBE.min() &&
+           boxes[0].max() == FULL_CUBE.max();
+}
+
+void ObstaclesCache::build(
+    const Chunks& chunks, glm::vec3 min, glm::vec3 max
+) {
+    this->chunks = &chunks;
+    origin = glm::floor(min);
+    size = glm::ivec3(glm::floor(max)) - origin + 1;
+    size_t volume = static_cast<size_t>(size.x) * size.y * size.z;
+    if (volume > MAX_VOLUME) {
+        size = {};
+        return;
+    }
+    size_t words = (volume + 63) / 64;
+    solid.assign(words, 0);
+    complex.assign(words, 0);
+
+    const auto* indices = chunks.getContentIndices();
+    const auto& blocks = indices->blocks;
+    const auto& obstacles = indices->blocksProps.obstacle;
+    for (int y = 0; y < size.y; y++) {
+        for (int z = 0; z < size.z; z++) {
+            for (int x = 0; x < size.x; x++) {
+                glm::ivec3 pos = origin + glm::ivec3(x, y, z);
+                size_t i = index({x, y, z});
+                uint64_t bit = uint64_t(1) << (i % 64);
+                const voxel* vox = chunks.get(pos.x, pos.y, pos.z);
+                if (vox == nullptr) {
+                    // missing chunks and the area below the world are
+                    // obstacles, above the world is empty
+                    if (pos.y < CHUNK_H) {
+                        solid[i / 64] |= bit;
+                    }
+                    continue;
+                }
+                if (!obstacles[vox->id]) {
+                    continue;
+                }
+                if (is_full_cube(blocks.require(vox->id), *vox)) {
+                    solid[i / 64] |= bit;
+                } else {
+                    complex[i / 64] |= bit;
+                }
+            }
+        }
+    }
+}
+
+const AABB* ObstaclesCache::isObstacleAt(float x, float y, float z) const {
+    glm::ivec3 pos = glm::ivec3(glm::floor(glm::vec3(x, y, z))) - origin;
+    if (pos.x < 0 || pos.y < 0 || pos.z < 0 || pos.x >= size.x ||
+        pos.y >= size.y || pos.z >= size.z) {
+        return chunks->isObstacleAt(x, y, z);
+    }
+    size_t i = index(pos);
+    uint64_t bit = uint64_t(1) << (i % 64);
+    if (solid[i / 64] & bit) {
+        return &FULL_CUBE;
+    }
+    if (complex[i / 64] & bit) {
+        return chunks->isObstacleAt(x, y, z);
+    }
+    return nullptr;
+}
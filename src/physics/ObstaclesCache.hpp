@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class Chunks;
+struct AABB;
+
+/// @brief Voxel obstacles of an area around a body cached for a physics
+/// step. Full cube obstacles are stored as a bit mask, other obstacles
+/// (custom hitboxes, extended blocks) are checked with Chunks::isObstacleAt.
+/// Points outside of the area are checked with Chunks::isObstacleAt too,
+/// so results always match it
+class ObstaclesCache {
+    const Chunks* chunks = nullptr;
+    glm::ivec3 origin {};
+    glm::ivec3 size {};
+    /// @brief Full cube obstacles bit mask
+    std::vector<uint64_t> solid;
+    /// @brief Obstacles requiring hitboxes check bit mask
+    std::vector<uint64_t> complex;
+
+    inline size_t index(const glm::ivec3& pos) const {
+        return (pos.y * size.z + pos.z) * size.x + pos.x;
+    }
+public:
+    /// @brief Max cached area volume, larger areas are not cached
+    static constexpr int MAX_VOLUME = 16 * 16 * 16;
+
+    /// @brief Cache obstacles of blocks intersecting the area
+    /// @param min area minimum point
+    /// @param max area maximum point
+    void build(const Chunks& chunks, glm::vec3 min, glm::vec3 max);
+
+    /// @brief Same as Chunks::isObstacleAt
+    const AABB* isObstacleAt(float x, float y, float z) const;
+};
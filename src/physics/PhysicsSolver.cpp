@@ -1,5 +1,6 @@
 #include "PhysicsSolver.hpp"
 #include "Hitbox.hpp"
+#include "ObstaclesCache.hpp"
 
 #include "maths/aabb.hpp"
 #include "voxels/Block.hpp"
@@ -13,17 +14,16 @@
 
 const float E = 0.03f;
 const float MAX_FIX = 0.1f;
+/// @brief Sensors broadphase grid cell size in blocks
+static constexpr float SENSORS_CELL_SIZE = 8.0f;
 
-PhysicsSolver::PhysicsSolver(glm::vec3 gravity) : gravity(gravity) {
+PhysicsSolver::PhysicsSolver(glm::vec3 gravity)
+    : gravity(gravity), sensorsGrid(SENSORS_CELL_SIZE) {
 }
 
 void PhysicsSolver::step(
-    Chunks* chunks, 
-    Hitbox* hitbox, 
-    float delta, 
-    uint substeps, 
-    entityid_t entity
-) {
+    Chunks* chunks, Hitbox* hitbox, float delta, uint substeps
+) const {
     float dt = delta / static_cast<float>(substeps);
     float linearDamping = hitbox->linearDamping;
     float s = 2.0f/BLOCK_AABB_GRID;
@@ -35,6 +35,13 @@ void PhysicsSolver::step(
     
     bool prevGrounded = hitbox->grounded;
     hitbox->grounded = false;
+
+    // area the hitbox may reach during the step (with probes offsets),
+    // probes outside of it are checked without the cache
+    float reach = getReach(*hitbox, delta);
+    thread_local ObstaclesCache obstacles;
+    obstacles.build(*chunks, pos - half - reach, pos + half + reach);
+
     for (uint i = 0; i < substeps; i++) {
         float px = pos.x;
         float py = pos.y;
@@ -42,7 +49,7 @@ void PhysicsSolver::step(
         
         vel += gravity * dt * gravityScale;
         if (hitbox->type == BodyType::DYNAMIC) {
-            colisionCalc(chunks, hitbox, vel, pos, half, 
+            colisionCalc(obstacles, hitbox, vel, pos, half, 
                          (prevGrounded && gravityScale > 0.0f) ? 0.5f : 0.0f);
         }
         vel.x *= glm::max(0.0f, 1.0f - dt * linearDamping);
@@ -63,7 +70,7 @@ void PhysicsSolver::step(
                 float x = (px-half.x+E) + ix * s;
                 for (int iz = 0; iz <= (half.z-E)*2/s; iz++){
                     float z = (pos.z-half.z+E) + iz * s;
-                    if (chunks->isObstacleAt(x,y,z)){
+                    if (obstacles.isObstacleAt(x,y,z)){
                         hitbox->grounded = true;
                         break;
                     }
@@ -77,7 +84,7 @@ void PhysicsSolver::step(
                 float x = (pos.x-half.x+E) + ix * s;
                 for (int iz = 0; iz <= (half.z-E)*2/s; iz++){
                     float z = (pz-half.z+E) + iz * s;
-                    if (chunks->isObstacleAt(x,y,z)){
+                    if (obstacles.isObstacleAt(x,y,z)){
                         hitbox->grounded = true;
                         break;
                     }
@@ -89,11 +96,31 @@ void PhysicsSolver::step(
             hitbox->grounded = true;
         }
     }
-    AABB aabb;
-    aabb.a = hitbox->position - hitbox->halfsize;
-    aabb.b = hitbox->position + hitbox->halfsize;
-    for (size_t i = 0; i < sensors.size(); i++) {
-        auto& sensor = *sensors[i];
+}
+
+void PhysicsSolver::collectContacts(
+    const Hitbox& hitbox,
+    entityid_t entity,
+    std::vector<SensorContact>& contacts
+) const {
+    AABB aabb = hitbox.getAABB();
+    // sorted to make contacts order independent of the grid state
+    thread_local std::vector<Sensor*> candidates;
+    candidates.clear();
+    sensorsGrid.query(aabb.min(), aabb.max(), true, [](Sensor* sensor) {
+        candidates.push_back(sensor);
+    });
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [](const Sensor* a, const Sensor* b) {
+            return a->entity < b->entity ||
+                   (a->entity == b->entity && a->index < b->index);
+        }
+    );
+
+    for (auto sensorPtr : candidates) {
+        auto& sensor = *sensorPtr;
         if (sensor.entity == entity) {
             continue;
         }
@@ -105,21 +132,31 @@ void PhysicsSolver::step(
                 break;
             case SensorType::RADIUS:
                 triggered = glm::distance2(
-                    hitbox->position, glm::vec3(sensor.calculated.radial))
+                    hitbox.position, glm::vec3(sensor.calculated.radial))
                      < sensor.calculated.radial.w;
                 break;
         }
         if (triggered) {
-            if (sensor.prevEntered.find(entity) == sensor.prevEntered.end()) {
-                sensor.enterCallback(sensor.entity, sensor.index, entity);
-            }
-            sensor.nextEntered.insert(entity);
+            contacts.push_back(SensorContact {&sensor, entity});
         }
     }
 }
 
+void PhysicsSolver::dispatchContact(const SensorContact& contact) {
+    auto& sensor = *contact.sensor;
+    const auto& prev = sensor.prevEntered;
+    if (!std::binary_search(prev.begin(), prev.end(), contact.entity)) {
+        sensor.enterCallback(sensor.entity, sensor.index, contact.entity);
+    }
+    auto& next = sensor.nextEntered;
+    auto it = std::lower_bound(next.begin(), next.end(), contact.entity);
+    if (it == next.end() || *it != contact.entity) {
+        next.insert(it, contact.entity);
+    }
+}
+
 static float calc_step_height(
-    Chunks* chunks, 
+    const ObstaclesCache& obstacles,
     glm::vec3& pos, 
     const glm::vec3& half,
     float stepHeight,
@@ -130,7 +167,7 @@ static float calc_step_height(
             float x = (pos.x-half.x+E) + ix * s;
             for (int iz = 0; iz <= (half.z-E)*2/s; iz++) {
                 float z = (pos.z-half.z+E) + iz * s;
-                if (chunks->isObstacleAt(x, pos.y+half.y+stepHeight, z)) {
+                if (obstacles.isObstacleAt(x, pos.y+half.y+stepHeight, z)) {
                     return 0.0f;
                 }
             }
@@ -141,7 +178,7 @@ static float calc_step_height(
 
 template <int nx, int ny, int nz>
 static bool calc_collision_neg(
-    Chunks* chunks,
+    const ObstaclesCache& obstacles,
     glm::vec3& pos,
     glm::vec3& vel,
     const glm::vec3& half,
@@ -159,7 +196,7 @@ static bool calc_collision_neg(
             coord[nz] = (pos[nz]-half[nz]+E) + iz * s;
             coord[nx] = (pos[nx]-half[nx]-E);
 
-            if (const auto aabb = chunks->isObstacleAt(coord.x, coord.y, coord.z)) {
+            if (const auto aabb = obstacles.isObstacleAt(coord.x, coord.y, coord.z)) {
                 vel[nx] = 0.0f;
                 float newx = std::floor(coord[nx]) + aabb->max()[nx] + half[nx] + E;
                 if (std::abs(newx-pos[nx]) <= MAX_FIX) {
@@ -174,7 +211,7 @@ static bool calc_collision_neg(
 
 template <int nx, int ny, int nz>
 static void calc_collision_pos(
-    Chunks* chunks,
+    const ObstaclesCache& obstacles,
     glm::vec3& pos,
     glm::vec3& vel,
     const glm::vec3& half,
@@ -191,7 +228,7 @@ static void calc_collision_pos(
         for (int iz = 0; iz <= (half[nz]-E)*2/s; iz++) {
             coord[nz] = (pos[nz]-half[nz]+E) + iz * s;
             coord[nx] = (pos[nx]+half[nx]+E);
-            if (const auto aabb = chunks->isObstacleAt(coord.x, coord.y, coord.z)) {
+            if (const auto aabb = obstacles.isObstacleAt(coord.x, coord.y, coord.z)) {
                 vel[nx] = 0.0f;
                 float newx = std::floor(coord[nx]) - half[nx] + aabb->min()[nx] - E;
                 if (std::abs(newx-pos[nx]) <= MAX_FIX) {
@@ -203,28 +240,35 @@ static void calc_collision_pos(
     }
 }
 
+float PhysicsSolver::getReach(const Hitbox& hitbox, float delta) const {
+    return (glm::length(hitbox.velocity) +
+            glm::length(gravity) * hitbox.gravityScale * delta) *
+               delta +
+           1.0f;
+}
+
 void PhysicsSolver::colisionCalc(
-    Chunks* chunks, 
+    const ObstaclesCache& obstacles,
     Hitbox* hitbox, 
     glm::vec3& vel, 
     glm::vec3& pos, 
     const glm::vec3 half,
     float stepHeight
-) {
+) const {
     // step size (smaller - more accurate, but slower)
     float s = 2.0f/BLOCK_AABB_GRID;
 
-    stepHeight = calc_step_height(chunks, pos, half, stepHeight, s);
+    stepHeight = calc_step_height(obstacles, pos, half, stepHeight, s);
 
     const AABB* aabb;
     
-    calc_collision_neg<0, 1, 2>(chunks, pos, vel, half, stepHeight, s);
-    calc_collision_pos<0, 1, 2>(chunks, pos, vel, half, stepHeight, s);
+    calc_collision_neg<0, 1, 2>(obstacles, pos, vel, half, stepHeight, s);
+    calc_collision_pos<0, 1, 2>(obstacles, pos, vel, half, stepHeight, s);
 
-    calc_collision_neg<2, 1, 0>(chunks, pos, vel, half, stepHeight, s);
-    calc_collision_pos<2, 1, 0>(chunks, pos, vel, half, stepHeight, s);
+    calc_collision_neg<2, 1, 0>(obstacles, pos, vel, half, stepHeight, s);
+    calc_collision_pos<2, 1, 0>(obstacles, pos, vel, half, stepHeight, s);
 
-    if (calc_collision_neg<1, 0, 2>(chunks, pos, vel, half, stepHeight, s)) {
+    if (calc_collision_neg<1, 0, 2>(obstacles, pos, vel, half, stepHeight, s)) {
         hitbox->grounded = true;
     }
 
@@ -234,7 +278,7 @@ void PhysicsSolver::colisionCalc(
             for (int iz = 0; iz <= (half.z-E)*2/s; iz++) {
                 float z = (pos.z-half.z+E) + iz * s;
                 float y = (pos.y-half.y+E);
-                if ((aabb = chunks->isObstacleAt(x,y,z))){
+                if ((aabb = obstacles.isObstacleAt(x,y,z))){
                     vel.y = 0.0f;
                     float newy = std::floor(y) + aabb->max().y + half.y;
                     if (std::abs(newy-pos.y) <= MAX_FIX+stepHeight) {
@@ -251,7 +295,7 @@ void PhysicsSolver::colisionCalc(
             for (int iz = 0; iz <= (half.z-E)*2/s; iz++) {
                 float z = (pos.z-half.z+E) + iz * s;
                 float y = (pos.y+half.y+E);
-                if ((aabb = chunks->isObstacleAt(x,y,z))){
+                if ((aabb = obstacles.isObstacleAt(x,y,z))){
                     vel.y = 0.0f;
                     float newy = std::floor(y) - half.y + aabb->min().y - E;
                     if (std::abs(newy-pos.y) <= MAX_FIX) {
@@ -290,6 +334,29 @@ bool PhysicsSolver::isBlockInside(int x, int y, int z, Block* def, blockstate st
     return false;
 }
 
+void PhysicsSolver::setSensors(std::vector<Sensor*> sensors) {
+    this->sensors = std::move(sensors);
+    sensorsGrid.clear();
+    for (auto sensor : this->sensors) {
+        switch (sensor->type) {
+            case SensorType::AABB: {
+                const auto& aabb = sensor->calculated.aabb;
+                sensorsGrid.update(sensor, aabb.center(), aabb.size() * 0.5f);
+                break;
+            }
+            case SensorType::RADIUS: {
+                const auto& radial = sensor->calculated.radial;
+                // w is the squared radius
+                sensorsGrid.update(
+                    sensor, glm::vec3(radial), glm::vec3(std::sqrt(radial.w))
+                );
+                break;
+            }
+        }
+    }
+}
+
 void PhysicsSolver::removeSensor(Sensor* sensor) {
     sensors.erase(std::remove(sensors.begin(), sensors.end(), sensor), sensors.end());
+    sensorsGrid.remove(sensor);
 }
@@ -3,6 +3,7 @@
 #include "Hitbox.hpp"
 
 #include "typedefs.hpp"
+#include "util/SpatialGrid.hpp"
 #include "voxels/voxel.hpp"
 
 #include <vector>
@@ -10,34 +11,59 @@
 
 class Block;
 class Chunks;
+class ObstaclesCache;
 struct Sensor;
 
+/// @brief Entity hitbox touching a sensor
+struct SensorContact {
+    Sensor* sensor;
+    entityid_t entity;
+};
+
+/// @brief Hitboxes integration and voxel collision. Const methods and
+/// step only read Chunks, so may be called from multiple threads while
+/// chunks and sensors are not modified. Compact chunks voxels are expanded
+/// on access, so chunks in the step reach (see getReach) must be expanded
+/// by the main thread before
 class PhysicsSolver {
     glm::vec3 gravity;
     std::vector<Sensor*> sensors;
+    /// @brief Broadphase: sensors by calculated bounds
+    util::SpatialGrid<Sensor*> sensorsGrid;
 public:
     PhysicsSolver(glm::vec3 gravity);
     void step(
-        Chunks* chunks,
-        Hitbox* hitbox,
-        float delta,
-        uint substeps,
-        entityid_t entity
-    );
+        Chunks* chunks, Hitbox* hitbox, float delta, uint substeps
+    ) const;
+
+    /// @brief Get distance from the hitbox bounds voxels may be read at
+    /// during the step (with probes offsets)
+    float getReach(const Hitbox& hitbox, float delta) const;
+
+    /// @brief Collect contacts of the hitbox with sensors of other entities.
+    /// Callbacks are not called, see dispatchContact
+    void collectContacts(
+        const Hitbox& hitbox,
+        entityid_t entity,
+        std::vector<SensorContact>& contacts
+    ) const;
+
+    /// @brief Mark the sensor entered calling enter callback if the entity
+    /// was not inside at the previous sensors update
+    static void dispatchContact(const SensorContact& contact);
+
     void colisionCalc(
-        Chunks* chunks,
+        const ObstaclesCache& obstacles,
         Hitbox* hitbox,
         glm::vec3& vel,
         glm::vec3& pos,
         const glm::vec3 half,
         float stepHeight
-    );
+    ) const;
     bool isBlockInside(int x, int y, int z, Hitbox* hitbox);
     bool isBlockInside(int x, int y, int z, Block* def, blockstate state, Hitbox* hitbox);
 
-    void setSensors(std::vector<Sensor*> sensors) {
-        this->sensors = std::move(sensors);
-    }
+    void setSensors(std::vector<Sensor*> sensors);
 
     void removeSensor(Sensor* sensor);
 };
@@ -40,6 +40,22 @@ struct ChunksSettings {
     IntegerSetting loadDistance {22, 3, 80};
     /// @brief Buffer zone where chunks are not unloading (chunk is unit)
     IntegerSetting padding {2, 1, 8};
+    /// @brief Background world autosave interval in seconds (0 - disabled)
+    IntegerSetting autosaveInterval {0, 0, 3600};
+    /// @brief Distance from player beyond which voxels of idle chunks are
+    /// kept palette-compressed (chunk is unit, 0 - disabled)
+    IntegerSetting compactDistance {8, 0, 80};
+    /// @brief Memory budget of chunks data kept in memory in megabytes:
+    /// loaded chunks and in-memory regions (0 - unlimited)
+    IntegerSetting memoryBudget {0, 0, 65536};
+    /// @brief Size of compressed unloaded chunks cache in megabytes
+    IntegerSetting cacheSize {64, 0, 4096};
+};
+
+struct SimulationSettings {
+    /// @brief World simulation ticks per second. Ticks have fixed duration
+    /// independent of the framerate, rendering is interpolated between them
+    IntegerSetting tickRate {60, 10, 240};
 };
 
 struct CameraSettings {
@@ -65,11 +81,49 @@ struct GraphicsSettings {
     FlagSetting backlight {true};
     /// @brief Disable culling with 'optional' mode
     FlagSetting denseRender {true};
+    /// @brief Merge same plain cube faces into larger quads
+    FlagSetting greedyMeshing {false};
     /// @brief Enable chunks frustum culling
     FlagSetting frustumCulling {true};
+    /// @brief Skip chunks occluded in the previous frames
+    FlagSetting occlusionCulling {true};
+    /// @brief Draw chunks with a single multi-draw indirect call
+    /// if supported by the driver
+    FlagSetting multiDrawIndirect {true};
+    /// @brief Distance where chunks get simplified surface meshes, coarser
+    /// at the doubled distance (chunk is unit, 0 - disabled)
+    IntegerSetting lodDistance {12, 0, 80};
+    /// @brief Distance of far terrain drawn from saved chunks summaries
+    /// beyond loaded chunks (chunk is unit, 0 - disabled)
+    IntegerSetting horizonDistance {0, 0, 96};
+    /// @brief Distance where loaded chunks are drawn from a cubemap baked
+    /// around the camera instead of their meshes (chunk is unit,
+    /// 0 - disabled)
+    IntegerSetting impostorsDistance {0, 0, 64};
+    /// @brief Cascaded sun shadow maps
+    FlagSetting shadows {false};
+    /// @brief Shadow map cascade resolution
+    IntegerSetting shadowsResolution {2048, 512, 4096};
+    /// @brief Sample lights of chunks around the camera from a 3D texture,
+    /// lights changes do not rebuild their meshes
+    FlagSetting lightTextures {false};
+    /// @brief Draw blocks from a texture array (a layer per atlas region)
+    /// instead of the atlas: no bleeding and per-layer mipmaps
+    FlagSetting textureArrays {false};
+    /// @brief Decode and upload standalone textures on the first use
+    /// instead of at assets loading
+    FlagSetting textureStreaming {false};
+    /// @brief Compress atlases textures (BC7 or DXT5) caching the result
+    FlagSetting compressedAtlases {false};
+    /// @brief Scale world framebuffer resolution to keep the world
+    /// render GPU time within the target framerate
+    FlagSetting dynamicResolution {false};
+    /// @brief Dynamic resolution target framerate
+    IntegerSetting dynamicResolutionFps {60, 15, 240};
     /// @brief Skybox texture face resolution
     IntegerSetting skyboxResolution {64 + 32, 64, 128};
-    /// @brief Chunk renderer vertices buffer capacity
+    /// @brief Max number of vertices of a chunk mesh. Renderers buffers grow
+    /// on demand up to this limit
     IntegerSetting chunkMaxVertices {200'000, 0, 4'000'000};
     /// @brief Limit of chunk renderers count
     IntegerSetting chunkMaxRenderers {6, -4, 32};
@@ -80,6 +134,28 @@ struct DebugSettings {
     FlagSetting generatorTestMode {false};
     /// @brief Write lights cache
     FlagSetting doWriteLights {true};
+    /// @brief Store generator prototypes of not saved chunks
+    FlagSetting doWritePrototypes {true};
+    /// @brief Apply content packs files changes while playing
+    /// (see HotReloader)
+    FlagSetting hotReload {false};
+};
+
+struct ScriptingSettings {
+    /// @brief Lua collector pause (percents): the next cycle starts when
+    /// memory use reaches the percentage of use after the previous cycle
+    IntegerSetting gcPause {200, 100, 1000};
+    /// @brief Lua collector speed relative to allocation (percents)
+    IntegerSetting gcStepMul {200, 100, 1000};
+    /// @brief Run the Lua collector once a frame instead of on allocations
+    FlagSetting gcFrameSteps {false};
+    /// @brief Event handler call time budget (milliseconds, 0 - disabled):
+    /// slower calls are reported
+    IntegerSetting handlerBudget {20, 0, 1000};
+    /// @brief Skip next calls of tick handlers exceeded the budget
+    FlagSetting throttleHandlers {false};
+    /// @brief Cache compiled scripts to skip parsing on the next launch
+    FlagSetting bytecodeCache {true};
 };
 
 struct UiSettings {
@@ -94,9 +170,11 @@ struct EngineSettings {
     AudioSettings audio;
     DisplaySettings display;
     ChunksSettings chunks;
+    SimulationSettings simulation;
     CameraSettings camera;
     GraphicsSettings graphics;
     DebugSettings debug;
+    ScriptingSettings scripting;
     UiSettings ui;
     NetworkSettings network;
 };
@@ -0,0 +1,51 @@
+#include "AdaptiveBudget.hpp"
+
+#include <algorithm>
+
+using namespace util;
+
+/// @brief Share of the target frame time frames are kept within, the rest
+/// is a margin for spikes
+static constexpr float TARGET_LOAD = 0.75f;
+/// @brief Part of the frame time headroom added to the budget per frame
+static constexpr float GROW_FACTOR = 0.1f;
+/// @brief Budget multiplier applied to frames over the target load
+static constexpr float SHRINK_FACTOR = 0.75f;
+/// @brief Budget grows only if the frame used at least this part of it,
+/// so idle stages do not accumulate budget causing a spike on new work
+static constexpr float SATURATION = 0.5f;
+/// @brief Measured time is smoothed as average of ~1/k last samples
+static constexpr float FRAME_TIME_SMOOTHING = 0.25f;
+
+AdaptiveBudget::AdaptiveBudget(int64_t initial, int64_t min, int64_t max)
+    : minBudget(min), maxBudget(max), budget(initial) {
+    setLimits(min, max);
+}
+
+void AdaptiveBudget::setLimits(int64_t min, int64_t max) {
+    minBudget = min;
+    maxBudget = std::max(min, max);
+    budget = std::clamp(
+        budget, static_cast<float>(minBudget), static_cast<float>(maxBudget)
+    );
+}
+
+void AdaptiveBudget::update(int64_t frameTime, int64_t targetFrameTime) {
+    if (this->frameTime < 0.0f) {
+        this->frameTime = frameTime;
+    } else {
+        this->frameTime += (frameTime - this->frameTime) * FRAME_TIME_SMOOTHING;
+    }
+    float headroom = targetFrameTime * TARGET_LOAD - this->frameTime;
+    // frame time spikes shrink the budget without waiting for the average
+    if (headroom < 0.0f || frameTime > targetFrameTime) {
+        budget *= SHRINK_FACTOR;
+    } else if (spent >= budget * SATURATION) {
+        budget += headroom * GROW_FACTOR;
+    }
+    budget = std::clamp(
+        budget, static_cast<float>(minBudget), static_cast<float>(maxBudget)
+    );
+    lastSpent = spent;
+    spent = 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+namespace util {
+    /// @brief Per-frame work time budget adapting to the frame time headroom:
+    /// grows while frames leave slack and the budget is used up, shrinks
+    /// when frames take longer than the target share of the frame time
+    class AdaptiveBudget {
+        int64_t minBudget;
+        int64_t maxBudget;
+        float budget;
+        /// @brief Smoothed frame work time (microseconds), negative if
+        /// there were no samples
+        float frameTime = -1.0f;
+        /// @brief Work time spent in the current frame (microseconds)
+        int64_t spent = 0;
+        /// @brief Work time spent in the last finished frame (microseconds)
+        int64_t lastSpent = 0;
+    public:
+        /// @param initial initial budget (microseconds)
+        /// @param min min budget (microseconds)
+        /// @param max max budget (microseconds)
+        AdaptiveBudget(int64_t initial, int64_t min, int64_t max);
+
+        /// @brief Change budget limits clamping the current budget
+        void setLimits(int64_t min, int64_t max);
+
+        /// @brief Finish the frame and adjust the budget
+        /// @param frameTime last frame main thread work time (microseconds)
+        /// @param targetFrameTime target frame time (microseconds)
+        void update(int64_t frameTime, int64_t targetFrameTime);
+
+        /// @brief Register work time spent in the current frame
+        void spend(int64_t mcs) {
+            spent += mcs;
+        }
+
+        /// @brief Get budget left in the current frame (microseconds)
+        int64_t getLeft() const {
+            return static_cast<int64_t>(budget) - spent;
+        }
+
+        /// @brief Get current budget (microseconds)
+        int64_t get() const {
+            return static_cast<int64_t>(budget);
+        }
+
+        /// @brief Get work time spent in the current frame (microseconds)
+        int64_t getSpent() const {
+            return spent;
+        }
+
+        /// @brief Get work time spent in the last frame (microseconds)
+        int64_t getLastSpent() const {
+            return lastSpent;
+        }
+    };
+}
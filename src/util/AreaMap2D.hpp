@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <stdexcept>
 #include <functional>
@@ -7,6 +8,9 @@
 
 namespace util {
 
+    /// @brief Window of values over an unbounded 2D grid. Values are
+    /// stored in a ring buffer addressed toroidally: moving the window
+    /// touches entering and leaving rows and columns only
     template<class T, typename TCoord=int>
     class AreaMap2D {
     public:
@@ -14,43 +18,60 @@ namespace util {
     private:
         TCoord offsetX = 0, offsetY = 0;
         TCoord sizeX, sizeY;
-        std::vector<T> firstBuffer;
-        std::vector<T> secondBuffer;
+        /// @brief Buffer position of the window offset
+        TCoord startX = 0, startY = 0;
+        std::vector<T> buffer;
         OutCallback outCallback;
 
         size_t valuesCount = 0;
-    
+
+        static TCoord wrap(TCoord x, TCoord size) {
+            x %= size;
+            return x < 0 ? x + size : x;
+        }
+
+        /// @brief Remove value at the window local position
+        void release(TCoord lx, TCoord ly) {
+            auto& value = buffer[getIndex(lx, ly)];
+            if (value == T{}) {
+                return;
+            }
+            T removed = std::move(value);
+            value = T{};
+            valuesCount--;
+            if (outCallback) {
+                outCallback(lx + offsetX, ly + offsetY, removed);
+            }
+        }
+
         void translate(TCoord dx, TCoord dy) {
             if (dx == 0 && dy == 0) {
                 return;
             }
-            std::fill(secondBuffer.begin(), secondBuffer.end(), T{});
-            for (TCoord y = 0; y < sizeY; y++) {
-                for (TCoord x = 0; x < sizeX; x++) {
-                    auto& value = firstBuffer[y * sizeX + x];
-                    auto nx = x - dx;
-                    auto ny = y - dy;
-                    if (value == T{}) {
-                        continue;
-                    }
-                    if (nx < 0 || ny < 0 || nx >= sizeX || ny >= sizeY) {
-                        if (outCallback) {
-                            outCallback(x + offsetX, y + offsetY, value);
-                        }
-                        valuesCount--;
+            // local ranges of columns and rows staying in the window
+            TCoord keepMinX = std::clamp<TCoord>(dx, 0, sizeX);
+            TCoord keepMaxX = std::clamp<TCoord>(sizeX + dx, 0, sizeX);
+            TCoord keepMinY = std::clamp<TCoord>(dy, 0, sizeY);
+            TCoord keepMaxY = std::clamp<TCoord>(sizeY + dy, 0, sizeY);
+            for (TCoord ly = 0; ly < sizeY; ly++) {
+                bool rowLeaves = ly < keepMinY || ly >= keepMaxY;
+                for (TCoord lx = 0; lx < sizeX; lx++) {
+                    if (!rowLeaves && lx == keepMinX && keepMinX < keepMaxX) {
+                        // skip staying values
+                        lx = keepMaxX - 1;
                         continue;
                     }
-                    secondBuffer[ny * sizeX + nx] = value;
+                    release(lx, ly);
                 }
             }
-            std::swap(firstBuffer, secondBuffer);
             offsetX += dx;
             offsetY += dy;
+            startX = wrap(startX + dx, sizeX);
+            startY = wrap(startY + dy, sizeY);
         }
     public:
         AreaMap2D(TCoord width, TCoord height)
-            : sizeX(width), sizeY(height), 
-              firstBuffer(width * height), secondBuffer(width * height) {
+            : sizeX(width), sizeY(height), buffer(width * height) {
         }
 
         const T* getIf(TCoord x, TCoord y) const {
@@ -59,16 +80,14 @@ namespace util {
             if (lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY) {
                 return nullptr;
             }
-            return &firstBuffer[ly * sizeX + lx];
+            return &buffer[getIndex(lx, ly)];
         }
 
         T get(TCoord x, TCoord y) const {
-            auto lx = x - offsetX;
-            auto ly = y - offsetY;
-            if (lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY) {
-                return T{};
+            if (auto ptr = getIf(x, y)) {
+                return *ptr;
             }
-            return firstBuffer[ly * sizeX + lx];
+            return T{};
         }
 
         T get(TCoord x, TCoord y, const T& def) const {
@@ -82,6 +101,11 @@ namespace util {
             return def;
         }
 
+        /// @brief Get value at the window local position
+        const T& getLocal(TCoord lx, TCoord ly) const {
+            return buffer[getIndex(lx, ly)];
+        }
+
         bool isInside(TCoord x, TCoord y) const {
             auto lx = x - offsetX;
             auto ly = y - offsetY;
@@ -89,12 +113,10 @@ namespace util {
         }
 
         const T& require(TCoord x, TCoord y) const {
-            auto lx = x - offsetX;
-            auto ly = y - offsetY;
-            if (lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY) {
-                throw std::invalid_argument("position is out of window");
+            if (auto ptr = getIf(x, y)) {
+                return *ptr;
             }
-            return firstBuffer[ly * sizeX + lx];
+            throw std::invalid_argument("position is out of window");
         }
 
         bool set(TCoord x, TCoord y, T value) {
@@ -103,7 +125,7 @@ namespace util {
             if (lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY) {
                 return false;
             }
-            auto& element = firstBuffer[ly * sizeX + lx];
+            auto& element = buffer[getIndex(lx, ly)];
             if (value && !element) {
                 valuesCount++;
             }
@@ -118,31 +140,37 @@ namespace util {
             outCallback = callback;
         }
 
+        /// @brief Resize the window. Shrinking keeps the window center,
+        /// values out of the new window are removed
         void resize(TCoord newSizeX, TCoord newSizeY) {
-            if (newSizeX < sizeX) {
-                TCoord delta = sizeX - newSizeX;
-                translate(delta / 2, 0);
-                translate(-delta, 0);
-                translate(delta, 0);
-            }
-            if (newSizeY < sizeY) {
-                TCoord delta = sizeY - newSizeY;
-                translate(0, delta / 2);
-                translate(0, -delta);
-                translate(0, delta);
-            }
-            const TCoord newVolume = newSizeX * newSizeY;
-            std::vector<T> newFirstBuffer(newVolume);
-            std::vector<T> newSecondBuffer(newVolume);
-            for (TCoord y = 0; y < sizeY && y < newSizeY; y++) {
-                for (TCoord x = 0; x < sizeX && x < newSizeX; x++) {
-                    newFirstBuffer[y * newSizeX + x] = firstBuffer[y * sizeX + x];
+            TCoord newOffsetX =
+                offsetX + std::max<TCoord>(sizeX - newSizeX, 0) / 2;
+            TCoord newOffsetY =
+                offsetY + std::max<TCoord>(sizeY - newSizeY, 0) / 2;
+            TCoord newStartX = wrap(newOffsetX, newSizeX);
+            TCoord newStartY = wrap(newOffsetY, newSizeY);
+            std::vector<T> newBuffer(newSizeX * newSizeY);
+            for (TCoord ly = 0; ly < sizeY; ly++) {
+                for (TCoord lx = 0; lx < sizeX; lx++) {
+                    TCoord nx = lx + offsetX - newOffsetX;
+                    TCoord ny = ly + offsetY - newOffsetY;
+                    if (nx < 0 || ny < 0 || nx >= newSizeX || ny >= newSizeY) {
+                        release(lx, ly);
+                        continue;
+                    }
+                    nx = wrap(nx + newStartX, newSizeX);
+                    ny = wrap(ny + newStartY, newSizeY);
+                    newBuffer[ny * newSizeX + nx] =
+                        std::move(buffer[getIndex(lx, ly)]);
                 }
             }
             sizeX = newSizeX;
             sizeY = newSizeY;
-            firstBuffer = std::move(newFirstBuffer);
-            secondBuffer = std::move(newSecondBuffer);
+            offsetX = newOffsetX;
+            offsetY = newOffsetY;
+            startX = newStartX;
+            startY = newStartY;
+            buffer = std::move(newBuffer);
         }
 
         void setCenter(TCoord centerX, TCoord centerY) {
@@ -156,9 +184,9 @@ namespace util {
         void clear() {
             for (TCoord y = 0; y < sizeY; y++) {
                 for (TCoord x = 0; x < sizeX; x++) {
-                    auto i = y * sizeX + x;
-                    auto value = firstBuffer[i];
-                    firstBuffer[i] = {};
+                    auto i = getIndex(x, y);
+                    auto value = std::move(buffer[i]);
+                    buffer[i] = {};
                     if (outCallback && value != T {}) {
                         outCallback(x + offsetX, y + offsetY, value);
                     }
@@ -183,8 +211,27 @@ namespace util {
             return sizeY;
         }
 
+        /// @brief Get values in the ring buffer order,
+        /// see getIndex for the window local positions
         const std::vector<T>& getBuffer() const {
-            return firstBuffer;
+            return buffer;
+        }
+
+        /// @brief Get buffer index of the window local position
+        /// @param lx local x in range [0, width)
+        /// @param ly local y in range [0, height)
+        size_t getIndex(TCoord lx, TCoord ly) const {
+            TCoord bx = lx + startX;
+            TCoord by = ly + startY;
+            bx -= bx >= sizeX ? sizeX : 0;
+            by -= by >= sizeY ? sizeY : 0;
+            return static_cast<size_t>(by) * sizeX + bx;
+        }
+
+        /// @brief Get window local position of the buffer index
+        void getLocalPosition(size_t index, TCoord& lx, TCoord& ly) const {
+            lx = wrap(static_cast<TCoord>(index % sizeX) - startX, sizeX);
+            ly = wrap(static_cast<TCoord>(index / sizeX) - startY, sizeY);
         }
 
         size_t count() const {
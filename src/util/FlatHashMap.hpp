@@ -0,0 +1,309 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace util {
+    /// @brief Open addressing hash map with linear probing.
+    /// Entries are stored in a single array, so lookups and iteration do
+    /// not jump over separately allocated nodes like std::unordered_map.
+    /// Erased entries are marked as deleted keeping other entries in place,
+    /// so erase(iterator) may be used while iterating.
+    /// @attention unlike std::unordered_map, pointers and references to
+    /// entries become invalid on rehash (inserting new keys)
+    template <
+        class K,
+        class V,
+        class Hash = std::hash<K>,
+        class KeyEqual = std::equal_to<K>>
+    class FlatHashMap {
+    public:
+        using key_type = K;
+        using mapped_type = V;
+        using value_type = std::pair<const K, V>;
+    private:
+        /// @brief Max load factor including deleted entries is 3/4
+        static constexpr size_t LOAD_NUMERATOR = 3;
+        static constexpr size_t LOAD_DENOMINATOR = 4;
+        static constexpr size_t MIN_CAPACITY = 16;
+
+        struct Slot {
+            std::optional<value_type> entry;
+            bool deleted = false;
+        };
+
+        std::vector<Slot> slots;
+        size_t entriesCount = 0;
+        size_t deletedCount = 0;
+        Hash hasher;
+        KeyEqual equal;
+
+        size_t indexOf(const K& key) const {
+            // fibonacci hashing spreads weak hashes (like glm vectors)
+            uint64_t hash = static_cast<uint64_t>(hasher(key));
+            hash *= 0x9E3779B97F4A7C15ULL;
+            return static_cast<size_t>(hash ^ (hash >> 32)) &
+                   (slots.size() - 1);
+        }
+
+        /// @return slot index of the key or slots.size() if not found
+        size_t findSlot(const K& key) const {
+            if (slots.empty()) {
+                return 0;
+            }
+            size_t mask = slots.size() - 1;
+            for (size_t i = indexOf(key);; i = (i + 1) & mask) {
+                const auto& slot = slots[i];
+                if (slot.entry) {
+                    if (equal(slot.entry->first, key)) {
+                        return i;
+                    }
+                } else if (!slot.deleted) {
+                    return slots.size();
+                }
+            }
+        }
+
+        void rehash(size_t capacity) {
+            std::vector<Slot> old(capacity);
+            std::swap(old, slots);
+            deletedCount = 0;
+            size_t mask = slots.size() - 1;
+            for (auto& slot : old) {
+                if (!slot.entry) {
+                    continue;
+                }
+                size_t i = indexOf(slot.entry->first);
+                while (slots[i].entry) {
+                    i = (i + 1) & mask;
+                }
+                slots[i].entry.emplace(std::move(*slot.entry));
+            }
+        }
+
+        /// @brief Make room for one more entry
+        void grow() {
+            size_t used = entriesCount + deletedCount + 1;
+            if (used * LOAD_DENOMINATOR <= slots.size() * LOAD_NUMERATOR) {
+                return;
+            }
+            size_t capacity = MIN_CAPACITY;
+            while ((entriesCount + 1) * 2 * LOAD_DENOMINATOR >
+                   capacity * LOAD_NUMERATOR) {
+                capacity *= 2;
+            }
+            rehash(capacity);
+        }
+
+        /// @return slot index and true if new entry created
+        template <class... Args>
+        std::pair<size_t, bool> emplaceSlot(const K& key, Args&&... args) {
+            size_t index = findSlot(key);
+            if (index < slots.size()) {
+                return {index, false};
+            }
+            grow();
+            size_t mask = slots.size() - 1;
+            index = indexOf(key);
+            while (slots[index].entry) {
+                index = (index + 1) & mask;
+            }
+            auto& slot = slots[index];
+            if (slot.deleted) {
+                slot.deleted = false;
+                deletedCount--;
+            }
+            slot.entry.emplace(
+                std::piecewise_construct,
+                std::forward_as_tuple(key),
+                std::forward_as_tuple(std::forward<Args>(args)...)
+            );
+            entriesCount++;
+            return {index, true};
+        }
+
+        template <class TMap, class TValue>
+        class basic_iterator {
+            friend class FlatHashMap;
+            template <class, class>
+            friend class basic_iterator;
+            TMap* map;
+            size_t index;
+
+            void skipEmpty() {
+                while (index < map->slots.size() &&
+                       !map->slots[index].entry) {
+                    index++;
+                }
+            }
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = FlatHashMap::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = TValue*;
+            using reference = TValue&;
+
+            basic_iterator(TMap* map, size_t index) : map(map), index(index) {
+                skipEmpty();
+            }
+
+            template <class OMap, class OValue>
+            basic_iterator(const basic_iterator<OMap, OValue>& o)
+                : map(o.map), index(o.index) {
+            }
+
+            reference operator*() const {
+                return *map->slots[index].entry;
+            }
+
+            pointer operator->() const {
+                return &*map->slots[index].entry;
+            }
+
+            basic_iterator& operator++() {
+                index++;
+                skipEmpty();
+                return *this;
+            }
+
+            basic_iterator operator++(int) {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            template <class OMap, class OValue>
+            bool operator==(const basic_iterator<OMap, OValue>& o) const {
+                return index == o.index;
+            }
+
+            template <class OMap, class OValue>
+            bool operator!=(const basic_iterator<OMap, OValue>& o) const {
+                return index != o.index;
+            }
+        };
+    public:
+        using iterator = basic_iterator<FlatHashMap, value_type>;
+        using const_iterator =
+            basic_iterator<const FlatHashMap, const value_type>;
+
+        FlatHashMap() = default;
+
+        iterator begin() {
+            return iterator(this, 0);
+        }
+
+        iterator end() {
+            return iterator(this, slots.size());
+        }
+
+        const_iterator begin() const {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator end() const {
+            return const_iterator(this, slots.size());
+        }
+
+        iterator find(const K& key) {
+            return iterator(this, findSlot(key));
+        }
+
+        const_iterator find(const K& key) const {
+            return const_iterator(this, findSlot(key));
+        }
+
+        size_t count(const K& key) const {
+            return findSlot(key) < slots.size();
+        }
+
+        V& at(const K& key) {
+            size_t index = findSlot(key);
+            if (index == slots.size()) {
+                throw std::out_of_range("key not found");
+            }
+            return slots[index].entry->second;
+        }
+
+        const V& at(const K& key) const {
+            size_t index = findSlot(key);
+            if (index == slots.size()) {
+                throw std::out_of_range("key not found");
+            }
+            return slots[index].entry->second;
+        }
+
+        V& operator[](const K& key) {
+            return slots[emplaceSlot(key).first].entry->second;
+        }
+
+        template <class... Args>
+        std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+            auto [index, created] =
+                emplaceSlot(key, std::forward<Args>(args)...);
+            return {iterator(this, index), created};
+        }
+
+        template <class TValue>
+        std::pair<iterator, bool> emplace(const K& key, TValue&& value) {
+            return try_emplace(key, std::forward<TValue>(value));
+        }
+
+        std::pair<iterator, bool> insert(value_type value) {
+            return try_emplace(value.first, std::move(value.second));
+        }
+
+        /// @return iterator following the erased entry
+        iterator erase(const_iterator position) {
+            auto& slot = slots[position.index];
+            slot.entry.reset();
+            slot.deleted = true;
+            entriesCount--;
+            deletedCount++;
+            return iterator(this, position.index + 1);
+        }
+
+        iterator erase(iterator position) {
+            return erase(const_iterator(position));
+        }
+
+        size_t erase(const K& key) {
+            size_t index = findSlot(key);
+            if (index == slots.size()) {
+                return 0;
+            }
+            erase(const_iterator(this, index));
+            return 1;
+        }
+
+        void clear() {
+            slots.clear();
+            entriesCount = 0;
+            deletedCount = 0;
+        }
+
+        /// @brief Allocate space for the number of entries without rehash
+        void reserve(size_t count) {
+            size_t capacity = MIN_CAPACITY;
+            while (count * LOAD_DENOMINATOR > capacity * LOAD_NUMERATOR) {
+                capacity *= 2;
+            }
+            if (capacity > slots.size()) {
+                rehash(capacity);
+            }
+        }
+
+        size_t size() const {
+            return entriesCount;
+        }
+
+        bool empty() const {
+            return entriesCount == 0;
+        }
+    };
+}
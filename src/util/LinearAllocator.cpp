@@ -0,0 +1,62 @@
+#include "LinearAllocator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace util;
+
+LinearAllocator::LinearAllocator(size_t blockSize) : blockSize(blockSize) {
+}
+
+void LinearAllocator::addBlock(size_t minSize) {
+    size_t size = std::max(blockSize, minSize);
+    blocks.push_back({std::make_unique<std::byte[]>(size), size});
+}
+
+void* LinearAllocator::allocate(size_t size, size_t alignment) {
+    if (blocks.empty()) {
+        addBlock(size + alignment);
+    }
+    while (true) {
+        auto& block = blocks[current];
+        auto address = reinterpret_cast<uintptr_t>(block.data.get());
+        size_t aligned =
+            (address + offset + alignment - 1) / alignment * alignment -
+            address;
+        if (aligned + size <= block.size) {
+            offset = aligned + size;
+            used += size;
+            return block.data.get() + aligned;
+        }
+        current++;
+        offset = 0;
+        if (current == blocks.size()) {
+            addBlock(size + alignment);
+        }
+    }
+}
+
+void LinearAllocator::reset() {
+    if (blocks.size() > 1) {
+        // the next cycle of the same workload fits into a single block
+        size_t capacity = getCapacity();
+        blocks.clear();
+        addBlock(capacity);
+    }
+    current = 0;
+    offset = 0;
+    used = 0;
+}
+
+size_t LinearAllocator::getCapacity() const {
+    size_t capacity = 0;
+    for (const auto& block : blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+LinearAllocator& LinearAllocator::getFrame() {
+    static LinearAllocator allocator;
+    return allocator;
+}
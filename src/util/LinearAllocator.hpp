@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace util {
+    /// @brief Bump allocator of scratch memory released all at once by
+    /// reset(). Grows by blocks when runs out of space, after reset
+    /// the blocks are merged into one, so a steady workload is served
+    /// without heap allocations. Not thread-safe
+    class LinearAllocator {
+        struct Block {
+            std::unique_ptr<std::byte[]> data;
+            size_t size;
+        };
+        std::vector<Block> blocks;
+        /// @brief Block allocations are taken from
+        size_t current = 0;
+        size_t offset = 0;
+        /// @brief Bytes allocated since the last reset
+        size_t used = 0;
+        size_t blockSize;
+
+        void addBlock(size_t minSize);
+    public:
+        /// @param blockSize initial block size (bytes)
+        LinearAllocator(size_t blockSize = 256 * 1024);
+
+        /// @brief Allocate memory valid until the next reset
+        void* allocate(
+            size_t size, size_t alignment = alignof(std::max_align_t)
+        );
+
+        template <typename T>
+        T* allocate(size_t count) {
+            return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        /// @brief Release all allocations
+        void reset();
+
+        /// @brief Get bytes allocated since the last reset
+        size_t getUsed() const {
+            return used;
+        }
+
+        /// @brief Get total size of the blocks
+        size_t getCapacity() const;
+
+        /// @brief Scratch memory of the render thread released at start of
+        /// every frame (see Engine::renderFrame). Allocations must not be
+        /// kept between frames
+        static LinearAllocator& getFrame();
+    };
+
+    /// @brief Standard allocator over LinearAllocator. Deallocation is
+    /// a no-op: memory is released by LinearAllocator::reset
+    template <typename T>
+    class ScratchAllocator {
+        LinearAllocator* allocator;
+
+        template <typename>
+        friend class ScratchAllocator;
+    public:
+        using value_type = T;
+
+        ScratchAllocator(
+            LinearAllocator& allocator = LinearAllocator::getFrame()
+        )
+            : allocator(&allocator) {
+        }
+
+        template <typename U>
+        ScratchAllocator(const ScratchAllocator<U>& other)
+            : allocator(other.allocator) {
+        }
+
+        T* allocate(size_t count) {
+            return allocator->allocate<T>(count);
+        }
+
+        void deallocate(T*, size_t) noexcept {
+        }
+
+        template <typename U>
+        bool operator==(const ScratchAllocator<U>& other) const {
+            return allocator == other.allocator;
+        }
+
+        template <typename U>
+        bool operator!=(const ScratchAllocator<U>& other) const {
+            return allocator != other.allocator;
+        }
+    };
+
+    /// @brief Vector of the render thread frame scratch memory
+    template <typename T>
+    using FrameVector = std::vector<T, ScratchAllocator<T>>;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+namespace util {
+    /// @brief Bounded lock-free multi-producer single-consumer queue
+    /// (ring buffer of cells with sequence numbers).
+    /// push may be called from any thread, pop and empty from one consumer
+    /// thread only
+    template <class T>
+    class MPSCRing {
+        struct Cell {
+            std::atomic<size_t> sequence;
+            std::optional<T> value;
+        };
+        std::unique_ptr<Cell[]> cells;
+        size_t mask;
+        alignas(64) std::atomic<size_t> pushPos = 0;
+        alignas(64) size_t popPos = 0;
+    public:
+        /// @param capacity ring capacity, must be a power of two
+        MPSCRing(size_t capacity)
+            : cells(std::make_unique<Cell[]>(capacity)), mask(capacity - 1) {
+            if (capacity == 0 || (capacity & mask)) {
+                throw std::invalid_argument("capacity must be a power of two");
+            }
+            for (size_t i = 0; i < capacity; i++) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MPSCRing(const MPSCRing&) = delete;
+
+        /// @return false if the ring is full
+        bool push(T&& value) {
+            size_t pos = pushPos.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true) {
+                cell = &cells[pos & mask];
+                auto sequence = cell->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+                if (diff == 0) {
+                    if (pushPos.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed
+                        )) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = pushPos.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = std::move(value);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @return false if the ring is empty
+        bool pop(T& dst) {
+            Cell& cell = cells[popPos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence != popPos + 1) {
+                return false;
+            }
+            dst = std::move(*cell.value);
+            cell.value.reset();
+            cell.sequence.store(popPos + mask + 1, std::memory_order_release);
+            popPos++;
+            return true;
+        }
+
+        bool empty() const {
+            const Cell& cell = cells[popPos & mask];
+            return cell.sequence.load(std::memory_order_acquire) != popPos + 1;
+        }
+
+        size_t capacity() const {
+            return mask + 1;
+        }
+    };
+}
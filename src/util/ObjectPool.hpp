@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace util {
+    /// @brief Thread-safe pool of reusable objects
+    /// @tparam T object type, reused objects are reinitialized with
+    /// T::reset called with the same arguments as the constructor
+    template <class T>
+    class ObjectPool {
+        struct State {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<T>> freeObjects;
+            size_t maxFree;
+            std::atomic<size_t> hits = 0;
+            std::atomic<size_t> misses = 0;
+
+            State(size_t maxFree) : maxFree(maxFree) {
+            }
+        };
+        /// @brief Shared with the objects deleters, so objects may outlive
+        /// the pool
+        std::shared_ptr<State> state;
+    public:
+        struct Stats {
+            /// @brief Number of objects reused
+            size_t hits;
+            /// @brief Number of objects allocated
+            size_t misses;
+            /// @brief Number of objects in the pool
+            size_t free;
+        };
+
+        /// @param maxFree max number of unused objects kept in the pool,
+        /// the rest are deleted
+        ObjectPool(size_t maxFree) : state(std::make_shared<State>(maxFree)) {
+        }
+
+        /// @brief Get unused object or create a new one
+        /// @return pointer that brings the object back to the pool when
+        /// destroyed
+        template <typename... Args>
+        std::shared_ptr<T> get(Args&&... args) {
+            std::unique_ptr<T> object;
+            {
+                std::lock_guard lock(state->mutex);
+                if (!state->freeObjects.empty()) {
+                    object = std::move(state->freeObjects.back());
+                    state->freeObjects.pop_back();
+                }
+            }
+            if (object) {
+                state->hits++;
+                object->reset(std::forward<Args>(args)...);
+            } else {
+                state->misses++;
+                object = std::make_unique<T>(std::forward<Args>(args)...);
+            }
+            return std::shared_ptr<T>(
+                object.release(), [state = state](T* ptr) {
+                    std::unique_ptr<T> object(ptr);
+                    std::lock_guard lock(state->mutex);
+                    if (state->freeObjects.size() < state->maxFree) {
+                        state->freeObjects.push_back(std::move(object));
+                    }
+                }
+            );
+        }
+
+        /// @brief Delete unused objects
+        /// @param keep number of unused objects to keep
+        void trim(size_t keep = 0) {
+            std::vector<std::unique_ptr<T>> removed;
+            std::lock_guard lock(state->mutex);
+            auto& objects = state->freeObjects;
+            while (objects.size() > keep) {
+                removed.push_back(std::move(objects.back()));
+                objects.pop_back();
+            }
+        }
+
+        Stats getStats() const {
+            std::lock_guard lock(state->mutex);
+            return Stats {
+                state->hits, state->misses, state->freeObjects.size()};
+        }
+    };
+}
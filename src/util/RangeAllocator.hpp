@@ -0,0 +1,95 @@
+#pragma once
+
+#include <iterator>
+#include <map>
+#include <optional>
+#include <stdexcept>
+
+namespace util {
+    /// @brief First-fit allocator of ranges inside of a linear space
+    /// (e.g. GPU buffer) with adjacent free ranges merging
+    class RangeAllocator {
+        /// @brief Free ranges: offset -> size
+        std::map<size_t, size_t> freeRanges;
+        size_t capacity;
+        size_t used = 0;
+    public:
+        RangeAllocator(size_t capacity) : capacity(capacity) {
+            if (capacity) {
+                freeRanges[0] = capacity;
+            }
+        }
+
+        /// @brief Allocate range of the given size
+        /// @return range offset or std::nullopt if there is no free range
+        /// large enough
+        std::optional<size_t> allocate(size_t size) {
+            if (size == 0) {
+                return 0;
+            }
+            for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+                auto [offset, freeSize] = *it;
+                if (freeSize < size) {
+                    continue;
+                }
+                freeRanges.erase(it);
+                if (freeSize > size) {
+                    freeRanges[offset + size] = freeSize - size;
+                }
+                used += size;
+                return offset;
+            }
+            return std::nullopt;
+        }
+
+        /// @brief Release previously allocated range
+        void free(size_t offset, size_t size) {
+            if (size == 0) {
+                return;
+            }
+            if (offset + size > capacity) {
+                throw std::invalid_argument("range is out of bounds");
+            }
+            used -= size;
+            auto next = freeRanges.lower_bound(offset);
+            if (next != freeRanges.end() && next->first == offset + size) {
+                size += next->second;
+                next = freeRanges.erase(next);
+            }
+            if (next != freeRanges.begin()) {
+                auto prev = std::prev(next);
+                if (prev->first + prev->second == offset) {
+                    prev->second += size;
+                    return;
+                }
+            }
+            freeRanges[offset] = size;
+        }
+
+        /// @brief Extend the space. Allocated ranges stay unchanged
+        void grow(size_t newCapacity) {
+            if (newCapacity <= capacity) {
+                return;
+            }
+            size_t oldCapacity = capacity;
+            capacity = newCapacity;
+            // counted back by free
+            used += newCapacity - oldCapacity;
+            free(oldCapacity, newCapacity - oldCapacity);
+        }
+
+        size_t getCapacity() const {
+            return capacity;
+        }
+
+        /// @return total size of allocated ranges
+        size_t getUsed() const {
+            return used;
+        }
+
+        /// @return number of free ranges (fragmentation measure)
+        size_t getFreeRangesCount() const {
+            return freeRanges.size();
+        }
+    };
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace util {
+    /// @brief Bounded lock-free single-producer single-consumer byte queue.
+    /// Producer writes directly into writable spans (e.g. passing them to
+    /// recv), consumer reads with bulk copies.
+    /// write methods may be called from the producer thread only,
+    /// read methods - from the consumer thread only
+    class SPSCByteRing {
+    public:
+        struct Span {
+            char* data;
+            size_t size;
+        };
+    private:
+        std::unique_ptr<char[]> bytes;
+        size_t mask;
+        alignas(64) std::atomic<size_t> writePos = 0;
+        alignas(64) std::atomic<size_t> readPos = 0;
+    public:
+        /// @param capacity ring capacity, must be a power of two
+        SPSCByteRing(size_t capacity)
+            : bytes(std::make_unique<char[]>(capacity)), mask(capacity - 1) {
+            if (capacity == 0 || (capacity & mask)) {
+                throw std::invalid_argument("capacity must be a power of two");
+            }
+        }
+
+        SPSCByteRing(const SPSCByteRing&) = delete;
+
+        /// @brief Get contiguous writable region (may be smaller than the
+        /// free space if the region wraps around the ring end)
+        /// @return empty span if the ring is full
+        Span writeSpan() {
+            size_t write = writePos.load(std::memory_order_relaxed);
+            size_t read = readPos.load(std::memory_order_acquire);
+            size_t free = capacity() - (write - read);
+            size_t offset = write & mask;
+            return {bytes.get() + offset, std::min(free, capacity() - offset)};
+        }
+
+        /// @brief Publish bytes written to the span
+        void commitWrite(size_t size) {
+            writePos.store(
+                writePos.load(std::memory_order_relaxed) + size,
+                std::memory_order_release
+            );
+        }
+
+        /// @return number of bytes written (less than size if ring is full)
+        size_t write(const char* src, size_t size) {
+            size_t written = 0;
+            while (written < size) {
+                auto span = writeSpan();
+                if (span.size == 0) {
+                    break;
+                }
+                size_t n = std::min(span.size, size - written);
+                std::memcpy(span.data, src + written, n);
+                commitWrite(n);
+                written += n;
+            }
+            return written;
+        }
+
+        /// @return number of bytes read
+        size_t read(char* dst, size_t size) {
+            size_t read = readPos.load(std::memory_order_relaxed);
+            size_t write = writePos.load(std::memory_order_acquire);
+            size = std::min(size, write - read);
+            size_t offset = read & mask;
+            size_t first = std::min(size, capacity() - offset);
+            std::memcpy(dst, bytes.get() + offset, first);
+            std::memcpy(dst + first, bytes.get(), size - first);
+            readPos.store(read + size, std::memory_order_release);
+            return size;
+        }
+
+        /// @brief Number of readable bytes
+        size_t size() const {
+            return writePos.load(std::memory_order_acquire) -
+                   readPos.load(std::memory_order_acquire);
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        bool full() const {
+            return size() == capacity();
+        }
+
+        size_t capacity() const {
+            return mask + 1;
+        }
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <vector>
@@ -19,12 +20,52 @@ namespace util {
     /// small different structures
     /// @note alignment is not impemented 
     /// (impractical in the context of scripting and memory consumption)
+    /// @note entries are found by binary search in the offsets table, which
+    /// is not a part of the serialized data
     /// @tparam Tindex entry index type
     /// @tparam Tsize entry size type
     template <typename Tindex, typename Tsize>
     class SmallHeap {
+        static constexpr size_t HEADER_SIZE = sizeof(Tindex) + sizeof(Tsize);
+
         std::vector<uint8_t> buffer;
+        /// @brief Entries headers offsets in buffer sorted by entry index
+        std::vector<size_t> offsets;
         Tindex entriesCount;
+
+        /// @return position in offsets table of the first entry with
+        /// index not less than the given one
+        size_t lowerBound(Tindex index) const {
+            auto found = std::lower_bound(
+                offsets.begin(),
+                offsets.end(),
+                index,
+                [this](size_t offset, Tindex index) {
+                    return read_int_le<Tindex>(buffer.data() + offset) < index;
+                }
+            );
+            return found - offsets.begin();
+        }
+
+        /// @brief Shift entries offsets after the position
+        void shiftOffsets(size_t position, ptrdiff_t delta) {
+            for (size_t i = position; i < offsets.size(); i++) {
+                offsets[i] += delta;
+            }
+        }
+
+        void rebuildOffsets() {
+            offsets.clear();
+            offsets.reserve(entriesCount);
+            size_t offset = 0;
+            for (size_t i = 0; i < entriesCount; i++) {
+                offsets.push_back(offset);
+                auto size = read_int_le<Tsize>(
+                    buffer.data() + offset + sizeof(Tindex)
+                );
+                offset += HEADER_SIZE + size;
+            }
+        }
     public:
         SmallHeap() : entriesCount(0) {}
 
@@ -33,20 +74,15 @@ namespace util {
         /// @return temporary raw pointer or nullptr if entry does not exists
         /// @attention pointer becomes invalid after allocate(...) or free(...)
         uint8_t* find(Tindex index) {
-            auto data = buffer.data();
-            for (size_t i = 0; i < entriesCount; i++) {
-                auto nextIndex = read_int_le<Tindex>(data);
-                data += sizeof(Tindex);
-                auto nextSize = read_int_le<Tsize>(data);
-                data += sizeof(Tsize);
-                if (nextIndex == index) {
-                    return data;
-                } else if (nextIndex > index) {
-                    return nullptr;
-                }
-                data += nextSize;
+            size_t position = lowerBound(index);
+            if (position == offsets.size()) {
+                return nullptr;
+            }
+            auto data = buffer.data() + offsets[position];
+            if (read_int_le<Tindex>(data) != index) {
+                return nullptr;
             }
-            return nullptr;
+            return data + HEADER_SIZE;
         }
 
         /// @brief Erase entry from the heap
@@ -56,12 +92,14 @@ namespace util {
                 return;
             }
             auto entrySize = sizeOf(ptr);
-            auto begin =
-                buffer.begin() +
-                ((ptr - sizeof(Tsize) - sizeof(Tindex)) - buffer.data());
-            buffer.erase(
-                begin, begin + entrySize + sizeof(Tsize) + sizeof(Tindex)
-            );
+            auto header = ptr - HEADER_SIZE;
+            size_t position = lowerBound(read_int_le<Tindex>(header));
+            auto begin = buffer.begin() + (header - buffer.data());
+            buffer.erase(begin, begin + entrySize + HEADER_SIZE);
+            offsets.erase(offsets.begin() + position);
+            shiftOffsets(position, -static_cast<ptrdiff_t>(
+                entrySize + HEADER_SIZE
+            ));
             entriesCount--;
         }
 
@@ -80,7 +118,6 @@ namespace util {
             if (size == 0) {
                 throw std::invalid_argument("zero size");
             }
-            ptrdiff_t offset = 0;
             if (auto found = find(index)) {
                 auto entrySize = sizeOf(found);
                 if (size == entrySize) {
@@ -90,23 +127,12 @@ namespace util {
                 this->free(found);
                 return allocate(index, size);
             }
-            for (size_t i = 0; i < entriesCount; i++) {
-                auto data = buffer.data() + offset;
-                auto nextIndex = read_int_le<Tindex>(data);
-                data += sizeof(Tindex);
-                auto nextSize = read_int_le<Tsize>(data);
-                data += sizeof(Tsize);
-                if (nextIndex > index) {
-                    break;
-                }
-                data += nextSize;
-                offset = data - buffer.data();
-            }
-            buffer.insert(
-                buffer.begin() + offset,
-                size + sizeof(Tindex) + sizeof(Tsize),
-                0
-            );
+            size_t position = lowerBound(index);
+            size_t offset = position < offsets.size() ? offsets[position]
+                                                      : buffer.size();
+            buffer.insert(buffer.begin() + offset, size + HEADER_SIZE, 0);
+            shiftOffsets(position, size + HEADER_SIZE);
+            offsets.insert(offsets.begin() + position, offset);
             entriesCount++;
 
             auto data = buffer.data() + offset;
@@ -158,6 +184,7 @@ namespace util {
             entriesCount = read_int_le<Tindex>(src);
             buffer.resize(size - sizeof(Tindex));
             std::memcpy(buffer.data(), src + sizeof(Tindex), buffer.size());
+            rebuildOffsets();
         }
 
         struct const_iterator {
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include "FlatHashMap.hpp"
+
+namespace util {
+    /// @brief Loose uniform grid of sized objects. Object is stored
+    /// in the single cell containing its position, queries are expanded by
+    /// the max half-size of inserted objects, so objects crossing cells
+    /// borders are found too.
+    /// @tparam T object identifier (hashable, cheap to copy)
+    template <class T>
+    class SpatialGrid {
+        util::FlatHashMap<glm::ivec3, std::vector<T>> cells;
+        util::FlatHashMap<T, glm::ivec3> objects;
+        float cellSize;
+        /// @brief Max half-size of objects inserted since the last clear
+        glm::vec3 maxExtent {0.0f};
+
+        glm::ivec3 cellOf(const glm::vec3& pos) const {
+            return glm::ivec3(glm::floor(pos / cellSize));
+        }
+
+        void removeFromCell(const glm::ivec3& cell, const T& object) {
+            auto found = cells.find(cell);
+            if (found == cells.end()) {
+                return;
+            }
+            auto& list = found->second;
+            auto it = std::find(list.begin(), list.end(), object);
+            if (it != list.end()) {
+                *it = list.back();
+                list.pop_back();
+            }
+            if (list.empty()) {
+                cells.erase(found);
+            }
+        }
+    public:
+        SpatialGrid(float cellSize) : cellSize(cellSize) {
+        }
+
+        /// @brief Insert object or move it to the new position
+        void update(const T& object, glm::vec3 pos, glm::vec3 halfsize) {
+            maxExtent = glm::max(maxExtent, glm::abs(halfsize));
+            auto cell = cellOf(pos);
+            auto [it, inserted] = objects.try_emplace(object, cell);
+            if (!inserted) {
+                if (it->second == cell) {
+                    return;
+                }
+                auto prev = it->second;
+                it->second = cell;
+                removeFromCell(prev, object);
+            }
+            cells[cell].push_back(object);
+        }
+
+        void remove(const T& object) {
+            auto found = objects.find(object);
+            if (found == objects.end()) {
+                return;
+            }
+            auto cell = found->second;
+            objects.erase(found);
+            removeFromCell(cell, object);
+        }
+
+        void clear() {
+            cells.clear();
+            objects.clear();
+            maxExtent = glm::vec3(0.0f);
+        }
+
+        /// @brief Call the callback for each object which may intersect
+        /// the box. Callback must check the object bounds itself
+        /// @param min box minimum point
+        /// @param max box maximum point
+        /// @param sized true if objects sizes should be taken into account,
+        /// false if only positions are checked
+        template <class Callback>
+        void query(
+            glm::vec3 min, glm::vec3 max, bool sized, const Callback& callback
+        ) const {
+            if (sized) {
+                min -= maxExtent;
+                max += maxExtent;
+            }
+            auto from = cellOf(min);
+            auto to = cellOf(max);
+            auto span = glm::dvec3(to - from) + 1.0;
+            if (span.x * span.y * span.z > cells.size()) {
+                // box is large: checking occupied cells is cheaper
+                for (const auto& [cell, list] : cells) {
+                    if (cell.x >= from.x && cell.y >= from.y &&
+                        cell.z >= from.z && cell.x <= to.x &&
+                        cell.y <= to.y && cell.z <= to.z) {
+                        for (const auto& object : list) {
+                            callback(object);
+                        }
+                    }
+                }
+                return;
+            }
+            for (int y = from.y; y <= to.y; y++) {
+                for (int z = from.z; z <= to.z; z++) {
+                    for (int x = from.x; x <= to.x; x++) {
+                        auto found = cells.find({x, y, z});
+                        if (found == cells.end()) {
+                            continue;
+                        }
+                        for (const auto& object : found->second) {
+                            callback(object);
+                        }
+                    }
+                }
+            }
+        }
+
+        size_t size() const {
+            return objects.size();
+        }
+    };
+}
@@ -0,0 +1,139 @@
+#include "TaskScheduler.hpp"
+
+#include <algorithm>
+
+#include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
+
+using namespace util;
+
+static debug::Logger logger("task-scheduler");
+
+/// @brief Scheduler of the current worker thread
+static thread_local const TaskScheduler* currentScheduler = nullptr;
+/// @brief Queue index of the current worker thread
+static thread_local size_t currentQueue = 0;
+
+TaskScheduler::TaskScheduler(uint threadsCount) {
+    threadsCount = std::max(1U, threadsCount);
+    for (uint i = 0; i < threadsCount; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (uint i = 0; i < threadsCount; i++) {
+        threads.emplace_back(&TaskScheduler::threadLoop, this, i);
+    }
+    logger.info() << "started " << threadsCount << " threads";
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard lock(mutex);
+        working = false;
+    }
+    condition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void TaskScheduler::submit(
+    runnable func, Priority priority, const void* owner
+) {
+    size_t index;
+    if (currentScheduler == this) {
+        index = currentQueue;
+    } else {
+        index = nextQueue++ % queues.size();
+    }
+    auto& queue = *queues[index];
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.tasks[static_cast<int>(priority)].push_back(
+            Task {std::move(func), owner}
+        );
+    }
+    {
+        std::lock_guard lock(mutex);
+        pending++;
+    }
+    condition.notify_one();
+}
+
+size_t TaskScheduler::cancel(const void* owner) {
+    size_t count = 0;
+    for (auto& queue : queues) {
+        std::lock_guard lock(queue->mutex);
+        for (auto& tasks : queue->tasks) {
+            size_t size = tasks.size();
+            tasks.erase(
+                std::remove_if(
+                    tasks.begin(),
+                    tasks.end(),
+                    [owner](const auto& task) { return task.owner == owner; }
+                ),
+                tasks.end()
+            );
+            count += size - tasks.size();
+        }
+    }
+    pending -= count;
+    return count;
+}
+
+bool TaskScheduler::runNext(size_t index) {
+    Task task;
+    bool found = false;
+    for (int priority = PRIORITIES - 1; priority >= 0 && !found; priority--) {
+        // own queue back first, then steal from front of others
+        for (size_t i = 0; i < queues.size(); i++) {
+            bool own = i == 0;
+            auto& queue = *queues[(index + i) % queues.size()];
+            std::lock_guard lock(queue.mutex);
+            auto& tasks = queue.tasks[priority];
+            if (tasks.empty()) {
+                continue;
+            }
+            if (own) {
+                task = std::move(tasks.back());
+                tasks.pop_back();
+            } else {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    pending--;
+    debug::ProfileZone zone("task");
+    try {
+        task.func();
+    } catch (const std::exception& err) {
+        logger.error() << "uncaught exception: " << err.what();
+    }
+    return true;
+}
+
+void TaskScheduler::threadLoop(size_t index) {
+    currentScheduler = this;
+    currentQueue = index;
+    while (working) {
+        if (runNext(index)) {
+            continue;
+        }
+        std::unique_lock lock(mutex);
+        condition.wait(lock, [this] {
+            return pending > 0 || !working;
+        });
+    }
+}
+
+TaskScheduler& TaskScheduler::getDefault() {
+    static TaskScheduler scheduler(
+        std::max(2U, std::thread::hardware_concurrency()) - 1
+    );
+    return scheduler;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "delegates.hpp"
+#include "typedefs.hpp"
+
+namespace util {
+    /// @brief Engine-wide work-stealing tasks scheduler.
+    /// Every worker thread has its own tasks deque: tasks submitted from
+    /// a worker thread are pushed to its deque, other tasks are distributed
+    /// between deques. Idle workers steal tasks from other deques.
+    /// Higher priority tasks are always taken first.
+    class TaskScheduler {
+    public:
+        enum class Priority {
+            LOW, NORMAL, HIGH
+        };
+        static constexpr int PRIORITIES = 3;
+    private:
+        struct Task {
+            runnable func;
+            /// @brief Tasks owner used to cancel them
+            const void* owner;
+        };
+        struct Queue {
+            std::mutex mutex;
+            std::array<std::deque<Task>, PRIORITIES> tasks;
+        };
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable condition;
+        /// @brief Number of queued tasks
+        std::atomic<int> pending = 0;
+        std::atomic<size_t> nextQueue = 0;
+        std::atomic<bool> working = true;
+
+        void threadLoop(size_t index);
+        bool runNext(size_t index);
+    public:
+        /// @param threadsCount number of worker threads (at least 1)
+        TaskScheduler(uint threadsCount);
+        ~TaskScheduler();
+
+        TaskScheduler(const TaskScheduler&) = delete;
+
+        /// @brief Queue task for execution in a worker thread
+        /// @param func task function. Exceptions are logged and ignored
+        /// @param owner tasks owner, see cancel()
+        void submit(
+            runnable func, Priority priority, const void* owner = nullptr
+        );
+
+        /// @brief Remove queued tasks of the owner. Running tasks are
+        /// not affected
+        /// @return number of removed tasks
+        size_t cancel(const void* owner);
+
+        uint getThreadsCount() const {
+            return threads.size();
+        }
+
+        /// @brief Get the scheduler shared by engine subsystems.
+        /// Uses all hardware threads except one left for the main thread
+        static TaskScheduler& getDefault();
+    };
+}
@@ -1,26 +1,30 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <queue>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <utility>
 
 #include "debug/Logger.hpp"
 #include "delegates.hpp"
 #include "interfaces/Task.hpp"
+#include "util/timeutil.hpp"
+#include "MPSCRing.hpp"
+#include "TaskScheduler.hpp"
 
 namespace util {
 
     template <class J, class T>
     struct ThreadPoolResult {
         J job;
-        std::condition_variable& variable;
-        int workerIndex;
-        bool& locked;
         T entry;
     };
 
@@ -32,100 +36,210 @@ namespace util {
         virtual R operator()(const T&) = 0;
     };
 
+    /// @brief Jobs queue executed by the engine-wide TaskScheduler.
+    /// The number of concurrently executed jobs is limited by the number of
+    /// pool workers (the pool lane limit). Results are consumed in update().
+    /// Jobs and results are only moved through the pool, so T and R are
+    /// required to be default constructible and movable only
     template <class T, class R>
     class ThreadPool : public Task {
         debug::Logger logger;
-        std::queue<T> jobs;
-        std::queue<ThreadPoolResult<T, R>> results;
+        TaskScheduler& scheduler;
+        TaskScheduler::Priority priority = TaskScheduler::Priority::NORMAL;
+        std::deque<T> jobs;
+        /// @brief Jobs priority function, FIFO order if not set
+        std::function<float(const T&)> jobsPriority = nullptr;
+        MPSCRing<ThreadPoolResult<T, R>> results;
+        /// @brief Results not fitting the ring, guarded by resultsMutex
+        std::queue<ThreadPoolResult<T, R>> overflow;
         std::mutex resultsMutex;
-        std::vector<std::thread> threads;
-        std::condition_variable jobsMutexCondition;
+        std::condition_variable resultsCondition;
+        /// @brief True while waitForJobs waits for results
+        std::atomic<bool> waiting = false;
+        /// @brief Max results consuming duration in update() (microseconds)
+        int64_t updateBudget = 0;
         std::mutex jobsMutex;
-        std::vector<std::unique_lock<std::mutex>> workersBlocked;
+        std::condition_variable tasksCondition;
+        std::vector<std::shared_ptr<Worker<T, R>>> workers;
+        /// @brief Workers not used by running tasks
+        std::vector<Worker<T, R>*> freeWorkers;
         consumer<R&> resultConsumer;
         consumer<T&> onJobFailed = nullptr;
         runnable onComplete = nullptr;
+        /// @brief Number of scheduler tasks submitted or running,
+        /// modified with jobsMutex locked
+        std::atomic<int> activeTasks = 0;
         std::atomic<int> busyWorkers = 0;
         std::atomic<uint> jobsDone = 0;
         std::atomic<bool> working = true;
         bool failed = false;
-        bool standaloneResults = true;
+        /// @brief Message of the job failure, guarded by jobsMutex
+        std::string failure;
         bool stopOnFail = true;
 
-        void threadLoop(int index, std::shared_ptr<Worker<T, R>> worker) {
-            std::condition_variable variable;
-            std::mutex mutex;
-            bool locked = false;
-            while (working) {
-                T job;
-                {
-                    std::unique_lock<std::mutex> lock(jobsMutex);
-                    jobsMutexCondition.wait(lock, [this] {
-                        return !jobs.empty() || !working;
-                    });
-                    if (!working || failed) {
-                        break;
-                    }
-                    job = std::move(jobs.front());
-                    jobs.pop();
+        /// @brief Requires jobsMutex locked
+        void setFailed(const std::string& message) {
+            if (!failed) {
+                failure = message;
+            }
+            failed = true;
+        }
 
-                    busyWorkers++;
+        [[noreturn]] void throwFailure() {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            throw std::runtime_error("some job failed: " + failure);
+        }
+
+        /// @brief Submit scheduler task if the lane limit is not reached.
+        /// Requires jobsMutex locked
+        void submitTask() {
+            if (activeTasks >= static_cast<int>(workers.size())) {
+                return;
+            }
+            activeTasks++;
+            scheduler.submit([this]() { runJob(); }, priority, this);
+        }
+
+        /// @brief Scheduler task: execute one job, then resubmit itself
+        /// if there are jobs left, letting other subsystems tasks in
+        void runJob() {
+            T job;
+            Worker<T, R>* worker;
+            {
+                std::lock_guard<std::mutex> lock(jobsMutex);
+                if (!working || failed || jobs.empty()) {
+                    finishTask();
+                    return;
                 }
-                try {
-                    R result = (*worker)(job);
-                    {
-                        std::lock_guard<std::mutex> lock(resultsMutex);
-                        results.push(ThreadPoolResult<T, R> {
-                            job, variable, index, locked, result});
-                        if (!standaloneResults) {
-                            locked = true;
+                auto next = jobs.begin();
+                if (jobsPriority) {
+                    float maxPriority = jobsPriority(*next);
+                    for (auto it = next + 1; it != jobs.end(); ++it) {
+                        float priority = jobsPriority(*it);
+                        if (priority > maxPriority) {
+                            maxPriority = priority;
+                            next = it;
                         }
-                        busyWorkers--;
                     }
-                    if (!standaloneResults) {
-                        std::unique_lock<std::mutex> lock(mutex);
-                        variable.wait(lock, [&] {
-                            return !working || !locked;
-                        });
-                    }
-                } catch (std::exception& err) {
-                    busyWorkers--;
-                    if (onJobFailed) {
-                        onJobFailed(job);
-                    }
-                    if (stopOnFail) {
-                        std::lock_guard<std::mutex> lock(jobsMutex);
-                        failed = true;
-                    }
-                    logger.error() << "uncaught exception: " << err.what();
                 }
-                jobsDone++;
+                job = std::move(*next);
+                jobs.erase(next);
+
+                worker = freeWorkers.back();
+                freeWorkers.pop_back();
+                busyWorkers++;
+            }
+            try {
+                R result = (*worker)(job);
+                pushResult(
+                    ThreadPoolResult<T, R> {std::move(job), std::move(result)}
+                );
+            } catch (std::exception& err) {
+                busyWorkers--;
+                if (onJobFailed) {
+                    onJobFailed(job);
+                }
+                if (stopOnFail) {
+                    std::lock_guard<std::mutex> lock(jobsMutex);
+                    setFailed(err.what());
+                }
+                logger.error() << "uncaught exception: " << err.what();
+                {
+                    std::lock_guard<std::mutex> lock(resultsMutex);
+                }
+                resultsCondition.notify_all();
+            }
+            jobsDone++;
+
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            freeWorkers.push_back(worker);
+            if (working && !failed && !jobs.empty()) {
+                activeTasks--;
+                submitTask();
+            } else {
+                finishTask();
             }
         }
+
+        void pushResult(ThreadPoolResult<T, R>&& result) {
+            if (!results.push(std::move(result))) {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                overflow.push(std::move(result));
+            }
+            busyWorkers--;
+            // pairs with the waiting flag store in waitForJobs
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiting) {
+                {
+                    std::lock_guard<std::mutex> lock(resultsMutex);
+                }
+                resultsCondition.notify_all();
+            }
+        }
+
+        /// @brief Get next result. Consumer thread only
+        bool popResult(ThreadPoolResult<T, R>& dst) {
+            if (results.pop(dst)) {
+                return true;
+            }
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            if (overflow.empty()) {
+                return false;
+            }
+            dst = std::move(overflow.front());
+            overflow.pop();
+            return true;
+        }
+
+        bool hasResults() {
+            if (!results.empty()) {
+                return true;
+            }
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            return !overflow.empty();
+        }
+
+        /// @brief Requires jobsMutex locked
+        void finishTask() {
+            activeTasks--;
+            tasksCondition.notify_all();
+            {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+            }
+            resultsCondition.notify_all();
+        }
     public:
         static constexpr int UNLIMITED = 0;
         static constexpr int HALF = -2;
         static constexpr int QUARTER = -4;
+        /// @brief Capacity of the lock-free results ring
+        static constexpr size_t RESULTS_CAPACITY = 1024;
 
         /// @brief Main thread pool constructor
         /// @param name thread pool name (used in logger)
         /// @param workersSupplier workers factory function
         /// @param resultConsumer workers results consumer function
-        /// @param maxWorkers max number of workers. Special values: 0 is 
-        /// unlimited, -2 is half of auto count, -4 is quarter.
+        /// @param maxWorkers max number of concurrently executed jobs.
+        /// Special values: 0 is all scheduler threads, -2 is half of them,
+        /// -4 is quarter.
+        /// @param scheduler tasks scheduler executing jobs
         ThreadPool(
             std::string name,
             supplier<std::shared_ptr<Worker<T, R>>> workersSupplier,
             consumer<R&> resultConsumer,
-            int maxWorkers=UNLIMITED
+            int maxWorkers=UNLIMITED,
+            TaskScheduler& scheduler=TaskScheduler::getDefault()
         )
-            : logger(std::move(name)), resultConsumer(resultConsumer) {
-            uint numThreads = std::thread::hardware_concurrency();
+            : logger(std::move(name)),
+              scheduler(scheduler),
+              results(RESULTS_CAPACITY),
+              resultConsumer(resultConsumer) {
+            uint numThreads = scheduler.getThreadsCount();
             switch (maxWorkers) {
                 case UNLIMITED:
                     break;
                 case HALF:
-                    numThreads = std::max(1U, numThreads);
+                    numThreads = std::max(1U, numThreads / 2);
                     break;
                 case QUARTER:
                     numThreads = std::max(1U, numThreads / 4);
@@ -137,10 +251,8 @@ namespace util {
                     break;
             }
             for (uint i = 0; i < numThreads; i++) {
-                threads.emplace_back(
-                    &ThreadPool<T, R>::threadLoop, this, i, workersSupplier()
-                );
-                workersBlocked.emplace_back();
+                workers.push_back(workersSupplier());
+                freeWorkers.push_back(workers.back().get());
             }
         }
         ~ThreadPool() {
@@ -151,30 +263,24 @@ namespace util {
             return working;
         }
 
+        /// @brief Stop executing jobs. Blocks until running jobs are done
         void terminate() override {
+            std::unique_lock<std::mutex> lock(jobsMutex);
             if (!working) {
                 return;
             }
+            working = false;
+            activeTasks -= scheduler.cancel(this);
+            tasksCondition.wait(lock, [this] {
+                return activeTasks == 0;
+            });
+            lock.unlock();
+            ThreadPoolResult<T, R> entry {};
+            while (popResult(entry)) {}
             {
-                std::lock_guard<std::mutex> lock(jobsMutex);
-                working = false;
-            }
-            {
-                std::lock_guard<std::mutex> lock(resultsMutex);
-                while (!results.empty()) {
-                    ThreadPoolResult<T, R> entry = results.front();
-                    results.pop();
-                    if (!standaloneResults) {
-                        entry.locked = false;
-                        entry.variable.notify_all();
-                    }
-                }
-            }
-
-            jobsMutexCondition.notify_all();
-            for (auto& thread : threads) {
-                thread.join();
+                std::lock_guard<std::mutex> resultsLock(resultsMutex);
             }
+            resultsCondition.notify_all();
         }
 
         void update() override {
@@ -182,69 +288,141 @@ namespace util {
                 return;
             }
             if (failed) {
-                throw std::runtime_error("some job failed");
+                throwFailure();
             }
 
             bool complete = false;
-            {
-                std::lock_guard<std::mutex> lock(resultsMutex);
-                while (!results.empty()) {
-                    ThreadPoolResult<T, R> entry = results.front();
-                    results.pop();
-
-                    try {
-                        resultConsumer(entry.entry);
-                    } catch (std::exception& err) {
-                        logger.error() << err.what();
-                        if (onJobFailed) {
-                            onJobFailed(entry.job);
-                        }
-                        if (stopOnFail) {
-                            std::lock_guard<std::mutex> jobsLock(jobsMutex);
-                            failed = true;
-                            complete = false;
-                        }
-                        break;
+            timeutil::Timer timer;
+            ThreadPoolResult<T, R> entry {};
+            while (popResult(entry)) {
+                try {
+                    resultConsumer(entry.entry);
+                } catch (std::exception& err) {
+                    logger.error() << err.what();
+                    if (onJobFailed) {
+                        onJobFailed(entry.job);
                     }
-
-                    if (!standaloneResults) {
-                        entry.locked = false;
-                        entry.variable.notify_all();
+                    if (stopOnFail) {
+                        std::lock_guard<std::mutex> jobsLock(jobsMutex);
+                        setFailed(err.what());
                     }
+                    break;
+                }
+                // the rest is consumed in the next updates
+                if (updateBudget > 0 && timer.stop() >= updateBudget) {
+                    break;
                 }
+            }
 
-                if (onComplete && busyWorkers == 0) {
-                    std::lock_guard<std::mutex> jobsLock(jobsMutex);
-                    if (jobs.empty()) {
-                        onComplete();
-                        complete = true;
-                    }
+            if (onComplete && !failed && activeTasks == 0 && !hasResults()) {
+                std::lock_guard<std::mutex> jobsLock(jobsMutex);
+                if (jobs.empty() && activeTasks == 0) {
+                    onComplete();
+                    complete = true;
                 }
             }
             if (failed) {
-                throw std::runtime_error("some job failed");
+                throwFailure();
             }
             if (complete) {
                 terminate();
             }
         }
 
+        /// @brief Block until all queued jobs are done. Results are consumed
+        /// in the calling thread, as in update()
+        void waitForJobs() {
+            while (working) {
+                update();
+
+                bool finished;
+                {
+                    // resubmitting task decrements and increments the
+                    // counter under the lock
+                    std::lock_guard<std::mutex> jobsLock(jobsMutex);
+                    finished = activeTasks == 0;
+                }
+                // results are pushed before the tasks finish, so checked
+                // after the counter to not miss the last ones
+                if (hasResults()) {
+                    continue;
+                }
+                if (finished) {
+                    return;
+                }
+                std::unique_lock<std::mutex> lock(resultsMutex);
+                waiting = true;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                resultsCondition.wait(lock, [this] {
+                    return !results.empty() || !overflow.empty() ||
+                           activeTasks == 0 || failed || !working;
+                });
+                waiting = false;
+            }
+        }
+
+        /// @brief Clear the failed state, so the pool is usable for the
+        /// next jobs. Queued jobs and not consumed results of the failed
+        /// ones are dropped. Blocks until running jobs are done
+        void resetFailure() {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobs.clear();
+            activeTasks -= scheduler.cancel(this);
+            tasksCondition.wait(lock, [this] {
+                return activeTasks == 0;
+            });
+            ThreadPoolResult<T, R> entry {};
+            while (popResult(entry));
+            failed = false;
+            failure.clear();
+        }
+
         void enqueueJob(T job) {
-            {
-                std::lock_guard<std::mutex> lock(jobsMutex);
-                jobs.push(std::move(job));
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            if (!working) {
+                return;
             }
-            jobsMutexCondition.notify_one();
+            jobs.push_back(std::move(job));
+            submitTask();
         }
 
         void clearQueue() {
             std::lock_guard<std::mutex> lock(jobsMutex);
-            jobs = {};
+            jobs.clear();
+        }
+
+        /// @brief Remove queued jobs matching the predicate
+        /// @return number of removed jobs
+        size_t cancelJobs(const std::function<bool(const T&)>& predicate) {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            size_t count = jobs.size();
+            jobs.erase(
+                std::remove_if(jobs.begin(), jobs.end(), predicate), jobs.end()
+            );
+            return count - jobs.size();
+        }
+
+        /// @brief Set jobs priority function. Workers take the queued job
+        /// with the greatest priority instead of the oldest one.
+        /// @attention The function is called from worker threads with the
+        /// jobs queue locked, so it must be thread-safe and fast
+        void setJobsPriority(std::function<float(const T&)> priority) {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            jobsPriority = std::move(priority);
+        }
+
+        /// @brief Set scheduler priority of the pool tasks relative to
+        /// other subsystems
+        void setPriority(TaskScheduler::Priority priority) {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            this->priority = priority;
         }
 
-        /// @brief If false: worker will be blocked until it's result performed
-        void setStandaloneResults(bool flag) {
-            standaloneResults = flag;
+        /// @brief Limit time spent on results consuming in update(),
+        /// so bursts of results are spread over multiple frames
+        /// @param mcs max duration in microseconds, 0 is unlimited
+        void setUpdateBudget(int64_t mcs) {
+            updateBudget = mcs;
         }
 
         void setStopOnFail(bool flag) {
@@ -279,8 +457,9 @@ namespace util {
             }
         }
 
+        /// @return max number of concurrently executed jobs
         uint getWorkersCount() const {
-            return threads.size();
+            return workers.size();
         }
     };
 
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace util {
+    /// @brief Hashed timer wheel of events scheduled to ticks. Events are
+    /// placed into slots by target tick modulo the wheel size and a tick
+    /// checks its own slot only, so cost of a tick depends on number of
+    /// events in the slot, not on the total number of events. Events
+    /// scheduled further than the wheel size stay in their slots for
+    /// extra turns
+    template <typename T>
+    class TimerWheel {
+        struct Event {
+            uint64_t tick;
+            T value;
+        };
+        std::vector<std::vector<Event>> slots;
+        /// @brief Due events of the slot being processed
+        std::vector<Event> due;
+        /// @brief The next tick to process
+        uint64_t current;
+        size_t count = 0;
+    public:
+        /// @param size number of slots
+        /// @param tick the first tick to process
+        TimerWheel(size_t size, uint64_t tick = 0)
+            : slots(std::max<size_t>(size, 1)), current(tick) {
+        }
+
+        /// @brief Schedule event. Events scheduled to already processed
+        /// ticks are due at the next processed tick
+        void schedule(uint64_t tick, T value) {
+            tick = std::max(tick, current);
+            slots[tick % slots.size()].push_back({tick, std::move(value)});
+            count++;
+        }
+
+        /// @brief Process ticks up to the given tick (inclusive) calling
+        /// func(tick, value) for every due event. Events may be scheduled
+        /// by func, the ones scheduled to processed ticks are due at the
+        /// next call
+        template <typename Func>
+        void advance(uint64_t tick, const Func& func) {
+            if (tick < current) {
+                return;
+            }
+            // a full turn visits every slot
+            uint64_t ticks = std::min<uint64_t>(
+                tick - current + 1, slots.size()
+            );
+            uint64_t first = current;
+            current = tick + 1;
+            for (uint64_t t = first; t < first + ticks && count; t++) {
+                auto& slot = slots[t % slots.size()];
+                auto end = std::partition(
+                    slot.begin(), slot.end(), [tick](const Event& event) {
+                        return event.tick > tick;
+                    }
+                );
+                due.insert(
+                    due.end(),
+                    std::make_move_iterator(end),
+                    std::make_move_iterator(slot.end())
+                );
+                slot.erase(end, slot.end());
+                count -= due.size();
+                for (auto& event : due) {
+                    func(event.tick, event.value);
+                }
+                due.clear();
+            }
+        }
+
+        /// @brief Remove all events and set the next tick to process
+        void reset(uint64_t tick) {
+            for (auto& slot : slots) {
+                slot.clear();
+            }
+            current = tick;
+            count = 0;
+        }
+
+        /// @brief Get the next tick to process
+        uint64_t getTick() const {
+            return current;
+        }
+
+        /// @brief Get number of scheduled events
+        size_t size() const {
+            return count;
+        }
+    };
+}
@@ -6,6 +6,7 @@
 #include <stdexcept>
 #include <string>
 
+#include "engine.hpp"
 #include "files/engine_paths.hpp"
 
 namespace fs = std::filesystem;
@@ -40,8 +41,20 @@ public:
     }
 };
 
+static uint64_t next_integer(ArgsReader& reader) {
+    auto token = reader.next();
+    try {
+        return std::stoull(token);
+    } catch (const std::logic_error&) {
+        throw std::runtime_error(token + " is not a non-negative integer");
+    }
+}
+
 bool perform_keyword(
-    ArgsReader& reader, const std::string& keyword, EnginePaths& paths
+    ArgsReader& reader,
+    const std::string& keyword,
+    EnginePaths& paths,
+    CoreParameters& params
 ) {
     if (keyword == "--res") {
         auto token = reader.next();
@@ -57,10 +70,51 @@ bool perform_keyword(
         }
         paths.setUserFilesFolder(fs::path(token));
         std::cout << "userfiles folder: " << token << std::endl;
+    } else if (keyword == "--headless") {
+        params.headless = true;
+    } else if (keyword == "--world") {
+        params.world = reader.next();
+    } else if (keyword == "--seed") {
+        params.seed = next_integer(reader);
+    } else if (keyword == "--generator") {
+        params.generator = reader.next();
+    } else if (keyword == "--ticks") {
+        params.ticks = next_integer(reader);
+    } else if (keyword == "--tps") {
+        params.tps = next_integer(reader);
+    } else if (keyword == "--benchmark") {
+        params.benchmark = true;
+    } else if (keyword == "--verify") {
+        params.verifyWorld = reader.next();
+    } else if (keyword == "--export") {
+        params.exportWorld = reader.next();
+        params.archiveFile = reader.next();
+    } else if (keyword == "--import") {
+        params.archiveFile = reader.next();
+        params.importWorld = reader.next();
     } else if (keyword == "--help" || keyword == "-h") {
         std::cout << "VoxelEngine command-line arguments:" << std::endl;
         std::cout << " --res [path] - set resources directory" << std::endl;
         std::cout << " --dir [path] - set userfiles directory" << std::endl;
+        std::cout << " --headless - simulate world without window"
+                  << std::endl;
+        std::cout << " --world [name] - world simulated in headless mode "
+                     "(created if not exists)" << std::endl;
+        std::cout << " --seed [number] - seed of created world" << std::endl;
+        std::cout << " --generator [name] - generator of created world"
+                  << std::endl;
+        std::cout << " --ticks [number] - quit after number of ticks"
+                  << std::endl;
+        std::cout << " --tps [number] - world ticks per second (20)"
+                  << std::endl;
+        std::cout << " --benchmark - run ticks without waiting and print "
+                     "ticks timing" << std::endl;
+        std::cout << " --verify [name] - check world region files for "
+                     "corrupted chunks and quit" << std::endl;
+        std::cout << " --export [name] [file] - pack world into archive "
+                     "file and quit" << std::endl;
+        std::cout << " --import [file] [name] - unpack archive file into "
+                     "new world and quit" << std::endl;
         return false;
     } else {
         std::cerr << "unknown argument " << keyword << std::endl;
@@ -69,13 +123,15 @@ bool perform_keyword(
     return true;
 }
 
-bool parse_cmdline(int argc, char** argv, EnginePaths& paths) {
+bool parse_cmdline(
+    int argc, char** argv, EnginePaths& paths, CoreParameters& params
+) {
     ArgsReader reader(argc, argv);
     reader.skip();
     while (reader.hasNext()) {
         std::string token = reader.next();
         if (reader.isKeywordArg()) {
-            if (!perform_keyword(reader, token, paths)) {
+            if (!perform_keyword(reader, token, paths, params)) {
                 return false;
             }
         } else {
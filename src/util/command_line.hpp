@@ -1,6 +1,9 @@
 #pragma once
 
 class EnginePaths;
+struct CoreParameters;
 
 /// @return false if engine start can
-bool parse_cmdline(int argc, char** argv, EnginePaths& paths);
+bool parse_cmdline(
+    int argc, char** argv, EnginePaths& paths, CoreParameters& params
+);
@@ -2,11 +2,14 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <iomanip>
 #include <locale>
 #include <sstream>
 #include <stdexcept>
 
+#include "maths/simd.hpp"
+
 std::string util::escape(std::string_view s, bool escapeUnicode) {
     std::stringstream ss;
     ss << '"';
@@ -179,18 +182,56 @@ size_t util::length_utf8(std::string_view s) {
     return length;
 }
 
+/// @brief Get length of the ASCII-only prefix of the bytes.
+/// Checks 16 bytes per step with SSE2/NEON or 8 bytes as a word
+static size_t ascii_prefix(const char* bytes, size_t length) {
+    size_t pos = 0;
+#if defined(SIMD_SSE2)
+    for (; pos + 16 <= length; pos += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + pos));
+        if (_mm_movemask_epi8(chunk)) {
+            break;
+        }
+    }
+#elif defined(SIMD_NEON)
+    for (; pos + 16 <= length; pos += 16) {
+        uint8x16_t chunk =
+            vld1q_u8(reinterpret_cast<const uint8_t*>(bytes + pos));
+        if (vmaxvq_u8(chunk) & 0x80) {
+            break;
+        }
+    }
+#else
+    for (; pos + 8 <= length; pos += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + pos, sizeof(word));
+        if (word & 0x8080808080808080ULL) {
+            break;
+        }
+    }
+#endif
+    while (pos < length && (static_cast<ubyte>(bytes[pos]) & 0x80) == 0) {
+        pos++;
+    }
+    return pos;
+}
+
 template<class C>
 std::string xstr2str_utf8(const std::basic_string<C>& xs) {
-    std::vector<char> chars;
+    std::string str;
+    str.reserve(xs.length());
     ubyte buffer[4];
     for (C xc : xs) {
-        uint size = util::encode_utf8(
-            static_cast<uint>(xc), buffer);
-        for (uint i = 0; i < size; i++) {
-            chars.push_back(buffer[i]);
+        auto code = static_cast<uint>(xc);
+        if (code < 0x80) {
+            str.push_back(static_cast<char>(code));
+            continue;
         }
+        uint size = util::encode_utf8(code, buffer);
+        str.append(reinterpret_cast<const char*>(buffer), size);
     }
-    return std::string(chars.data(), chars.size());
+    return str;
 }
 
 std::string util::wstr2str_utf8(const std::wstring& ws) {
@@ -203,14 +244,35 @@ std::string util::u32str2str_utf8(const std::u32string& ws) {
 
 template<class C>
 std::basic_string<C> str2xstr_utf8(const std::string& s) {
-    std::vector<C> chars;
+    // code points count is never greater than the bytes count
+    std::basic_string<C> xs(s.length(), 0);
+    const char* src = s.data();
+    size_t length = s.length();
+    size_t count = 0;
     size_t pos = 0;
-    uint size = 0;
-    while (pos < s.length()) {
-        chars.push_back(util::decode_utf8(size, &s.at(pos)));
+    while (pos < length) {
+        size_t ascii = ascii_prefix(src + pos, length - pos);
+        for (size_t i = 0; i < ascii; i++) {
+            xs[count++] = static_cast<C>(src[pos + i]);
+        }
+        pos += ascii;
+        if (pos == length) {
+            break;
+        }
+        uint size = utf8_len(src[pos]);
+        if (pos + size > length) {
+            throw std::runtime_error("utf8 decode error");
+        }
+        for (uint i = 1; i < size; i++) {
+            if ((static_cast<ubyte>(src[pos + i]) & 0xC0) != 0x80) {
+                throw std::runtime_error("utf8 decode error");
+            }
+        }
+        xs[count++] = static_cast<C>(util::decode_utf8(size, src + pos));
         pos += size;
     }
-    return std::basic_string<C>(chars.data(), chars.size());
+    xs.resize(count);
+    return xs;
 }
 
 std::wstring util::str2wstr_utf8(const std::string& s) {
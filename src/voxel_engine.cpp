@@ -2,27 +2,85 @@
 #include "settings.hpp"
 #include "files/settings_io.hpp"
 #include "files/engine_paths.hpp"
+#include "files/WorldArchive.hpp"
+#include "files/WorldRegions.hpp"
 #include "util/platform.hpp"
 #include "util/command_line.hpp"
 #include "debug/Logger.hpp"
 
+#include <iostream>
 #include <stdexcept>
+#include <thread>
 
 static debug::Logger logger("main");
 
+static int verify_world(const fs::path& folder) {
+    if (!fs::is_directory(folder)) {
+        std::cerr << "world " << folder.u8string() << " not found" << std::endl;
+        return EXIT_FAILURE;
+    }
+    WorldRegions regions(folder);
+    auto report = regions.verify(std::thread::hardware_concurrency());
+    for (const auto& chunk : report.corruptedChunks) {
+        std::cout << "corrupted chunk " << chunk.x << ", " << chunk.z
+                  << " in " << regions.getRegionsFolder(chunk.layer).u8string()
+                  << std::endl;
+    }
+    for (const auto& file : report.invalidFiles) {
+        std::cout << "invalid region file " << file.u8string() << std::endl;
+    }
+    std::cout << "checked " << report.files << " region files: "
+              << report.validChunks << " valid, " << report.uncheckedChunks
+              << " without checksums, " << report.corruptedChunks.size()
+              << " corrupted chunks" << std::endl;
+    return report.isOk() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int run_archive_command(
+    EnginePaths& paths, const CoreParameters& params
+) {
+    uint threads = std::thread::hardware_concurrency();
+    try {
+        if (!params.exportWorld.empty()) {
+            world_archive::export_world(
+                paths.getWorldFolderByName(params.exportWorld),
+                fs::u8path(params.archiveFile),
+                threads
+            );
+        } else {
+            world_archive::import_world(
+                fs::u8path(params.archiveFile),
+                paths.getWorldFolderByName(params.importWorld),
+                threads
+            );
+        }
+    } catch (const std::runtime_error& err) {
+        logger.error() << err.what();
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char** argv) {
     debug::Logger::init("latest.log");
 
     EnginePaths paths;
-    if (!parse_cmdline(argc, argv, paths))
+    CoreParameters params;
+    if (!parse_cmdline(argc, argv, paths, params))
         return EXIT_SUCCESS;
+    if (!params.verifyWorld.empty()) {
+        return verify_world(paths.getWorldFolderByName(params.verifyWorld));
+    }
+    if (!params.exportWorld.empty() || !params.importWorld.empty()) {
+        return run_archive_command(paths, params);
+    }
 
     platform::configure_encoding();
     try {
         EngineSettings settings;
         SettingsHandler handler(settings);
         
-        Engine engine(settings, handler, &paths);
+        Engine engine(settings, handler, &paths, params);
 
         engine.mainloop();
     }
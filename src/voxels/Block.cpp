@@ -144,7 +144,7 @@ Block::Block(std::string name, const std::string& texture)
     : name(std::move(name)),
       textureFaces {texture, texture, texture, texture, texture, texture} {
 }
-void Block::cloneTo(Block& dst) {
+void Block::cloneTo(Block& dst) const {
     dst.caption = caption;
     for (int i = 0; i < 6; i++) {
         dst.textureFaces[i] = textureFaces[i];
@@ -172,6 +172,7 @@ void Block::cloneTo(Block& dst) {
     dst.uiLayout = uiLayout;
     dst.inventorySize = inventorySize;
     dst.tickInterval = tickInterval;
+    dst.fluidSpread = fluidSpread;
     dst.overlayTexture = overlayTexture;
     dst.translucent = translucent;
     if (particles) {
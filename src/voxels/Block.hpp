@@ -43,6 +43,20 @@ struct block_funcs_set {
     bool oninteract : 1;
     bool randupdate : 1;
     bool onblockstick : 1;
+    bool randupdatebatch : 1;
+};
+
+/// @brief Block events handles resolved on content load
+/// (see lua::create_event_handle)
+struct block_events_set {
+    int update = 0;
+    int randupdate = 0;
+    int randupdatebatch = 0;
+    int placed = 0;
+    int replaced = 0;
+    int broken = 0;
+    int interact = 0;
+    int blockstick = 0;
 };
 
 struct CoordSystem {
@@ -219,6 +233,11 @@ public:
     // @brief Block tick interval (1 - 20tps, 2 - 10tps)
     uint tickInterval = 1;
 
+    /// @brief Fluid spread distance, 0 - the block is not a fluid.
+    /// Distance to the source is stored in the state user bits: 0 - fluid
+    /// source, 1 - falling fluid (see FluidsController)
+    uint8_t fluidSpread = 0;
+
     std::unique_ptr<data::StructLayout> dataStruct;
 
     std::unique_ptr<ParticlesPreset> particles;
@@ -237,12 +256,19 @@ public:
         // @brief block size is greather than 1x1x1
         bool extended = false;
 
+        /// @brief block has decorations spawned around the player
+        /// (particles)
+        bool decorative = false;
+
         /// @brief set of hitboxes sets with all coord-systems precalculated
         std::vector<AABB> hitboxes[BlockRotProfile::MAX_COUNT];
 
         /// @brief set of block callbacks flags
         block_funcs_set funcsset {};
 
+        /// @brief script events handles
+        block_events_set events {};
+
         /// @brief picking item integer id
         itemid_t pickingItem = 0;
 
@@ -254,7 +280,7 @@ public:
     Block(const Block&) = delete;
     ~Block();
 
-    void cloneTo(Block& dst);
+    void cloneTo(Block& dst) const;
 
     static bool isReservedBlockField(std::string_view view);
 };
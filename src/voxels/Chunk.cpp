@@ -1,46 +1,177 @@
 #include "Chunk.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include "content/ContentReport.hpp"
 #include "items/Inventory.hpp"
 #include "lighting/Lightmap.hpp"
+#include "util/BufferPool.hpp"
 #include "util/data_io.hpp"
 #include "voxel.hpp"
 
+// vectorized paths rely on little-endian layout of a voxel: id | state << 16
+// (blockstate bit-fields are allocated from the lowest bit)
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHUNK_SSE2
+#include <emmintrin.h>
+#elif (defined(__aarch64__) || defined(_M_ARM64)) && \
+    !defined(__ARM_BIG_ENDIAN)
+#define CHUNK_NEON
+#include <arm_neon.h>
+#endif
+
+/// @brief Voxels processed by a vectorized step
+static constexpr uint VOXELS_STEP = 8;
+static_assert(CHUNK_VOL % VOXELS_STEP == 0);
+
+/// @brief Buffers of transient encoded chunks
+static util::BufferPool<ubyte> data_buffers(CHUNK_DATA_LEN);
+
 Chunk::Chunk(int xpos, int zpos) : x(xpos), z(zpos) {
     bottom = 0;
     top = CHUNK_H;
 }
 
+void Chunk::reset(int xpos, int zpos) {
+    x = xpos;
+    z = zpos;
+    bottom = 0;
+    top = CHUNK_H;
+    uniformSections = 0;
+    dirtySections = 0;
+    lightSections = 0;
+    revision++;
+    std::fill(std::begin(emptyBricks), std::end(emptyBricks), 0);
+    std::fill(std::begin(sectionBlocks), std::end(sectionBlocks), 0);
+    voxels.reset();
+    lightmap.reset();
+    lightmap.highestPoint = 0;
+    flags = {};
+    inventories.clear();
+    blocksMetadata = {};
+    scheduledUpdates.clear();
+    fluidCells.clear();
+    decorations.clear();
+    decorationsIndexed = false;
+    randomTickables.clear();
+    randomTickablesCount = 0;
+    randomTickablesSparse = false;
+    randomTickablesIndexed = false;
+}
+
 bool Chunk::isEmpty() const {
-    int id = -1;
-    for (uint i = 0; i < CHUNK_VOL; i++) {
-        if (voxels[i].id != id) {
-            if (id != -1)
-                return false;
-            else
-                id = voxels[i].id;
+    for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        if (sectionBlocks[s]) {
+            return false;
         }
     }
     return true;
 }
 
 void Chunk::updateHeights() {
-    for (uint i = 0; i < CHUNK_VOL; i++) {
-        if (voxels[i].id != 0) {
+    decorationsIndexed = false;
+    randomTickablesIndexed = false;
+    uint32_t uniform = 0;
+    for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        const voxel* section = voxels.data() + s * CHUNK_SECTION_VOL;
+        blockid_t id = section[0].id;
+        blockstate_t state = blockstate2int(section[0].state);
+        uint i = 1;
+        for (; i < CHUNK_SECTION_VOL; i++) {
+            if (section[i].id != id ||
+                blockstate2int(section[i].state) != state) {
+                break;
+            }
+        }
+        if (i == CHUNK_SECTION_VOL) {
+            uniform |= 1U << s;
+        }
+    }
+    uniformSections = uniform;
+
+    for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        const voxel* section = voxels.data() + s * CHUNK_SECTION_VOL;
+        uint64_t empty = ~0ULL;
+        uint count = 0;
+        if (uniform & (1U << s)) {
+            bool air = section[0].id == BLOCK_AIR;
+            empty = air ? ~0ULL : 0;
+            count = air ? 0 : CHUNK_SECTION_VOL;
+        } else {
+            for (uint i = 0; i < CHUNK_SECTION_VOL; i++) {
+                if (section[i].id != BLOCK_AIR) {
+                    uint x = i % CHUNK_W;
+                    uint y = i / (CHUNK_W * CHUNK_D);
+                    uint z = i / CHUNK_W % CHUNK_D;
+                    empty &= ~brickBit(x, y, z);
+                    count++;
+                }
+            }
+        }
+        emptyBricks[s] = empty;
+        sectionBlocks[s] = count;
+    }
+    updateBounds();
+}
+
+void Chunk::updateBounds() {
+    int first = 0;
+    while (first < CHUNK_SECTIONS && sectionBlocks[first] == 0) {
+        first++;
+    }
+    if (first == CHUNK_SECTIONS) {
+        // same as for the reset chunk
+        bottom = 0;
+        top = CHUNK_H;
+        return;
+    }
+    int last = CHUNK_SECTIONS - 1;
+    while (sectionBlocks[last] == 0) {
+        last--;
+    }
+    // the boundary sections are known to contain non-air voxels
+    const voxel* data = voxels.data();
+    for (uint i = first * CHUNK_SECTION_VOL;; i++) {
+        if (data[i].id != BLOCK_AIR) {
             bottom = i / (CHUNK_D * CHUNK_W);
             break;
         }
     }
-    for (int i = CHUNK_VOL - 1; i >= 0; i--) {
-        if (voxels[i].id != 0) {
+    for (uint i = (last + 1) * CHUNK_SECTION_VOL; i-- > 0;) {
+        if (data[i].id != BLOCK_AIR) {
             top = i / (CHUNK_D * CHUNK_W) + 1;
             break;
         }
     }
 }
 
+void Chunk::onVoxelIdChanged(int y, blockid_t prevId, blockid_t id) {
+    bool wasAir = prevId == BLOCK_AIR;
+    bool air = id == BLOCK_AIR;
+    if (wasAir == air) {
+        return;
+    }
+    uint section = y / CHUNK_SECTION_H;
+    if (air) {
+        sectionBlocks[section]--;
+        if (y == bottom || y + 1 == top) {
+            updateBounds();
+        }
+        return;
+    }
+    if (isEmpty()) {
+        bottom = y;
+        top = y + 1;
+    } else {
+        bottom = std::min(bottom, y);
+        top = std::max(top, y + 1);
+    }
+    sectionBlocks[section]++;
+}
+
 void Chunk::addBlockInventory(
     std::shared_ptr<Inventory> inventory, uint x, uint y, uint z
 ) {
@@ -88,32 +219,132 @@ std::unique_ptr<Chunk> Chunk::clone() const {
 
     Total size: (CHUNK_VOL * 4) bytes
 */
-std::unique_ptr<ubyte[]> Chunk::encode() const {
-    auto buffer = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
-    auto dst = reinterpret_cast<uint16_t*>(buffer.get());
+/// @brief Split voxels into ids and states arrays
+static void deinterleave(
+    const voxel* voxels, uint16_t* ids, uint16_t* states
+) {
+#if defined(CHUNK_SSE2)
+    auto src = reinterpret_cast<const __m128i*>(voxels);
+    for (uint i = 0; i < CHUNK_VOL; i += VOXELS_STEP, src += 2) {
+        __m128i a = _mm_loadu_si128(src);
+        __m128i b = _mm_loadu_si128(src + 1);
+        // sign extension keeps signed saturating pack lossless
+        __m128i idsA = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+        __m128i idsB = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+        __m128i statesA = _mm_srai_epi32(a, 16);
+        __m128i statesB = _mm_srai_epi32(b, 16);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(ids + i), _mm_packs_epi32(idsA, idsB)
+        );
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(states + i),
+            _mm_packs_epi32(statesA, statesB)
+        );
+    }
+#elif defined(CHUNK_NEON)
+    auto src = reinterpret_cast<const uint16_t*>(voxels);
+    for (uint i = 0; i < CHUNK_VOL; i += VOXELS_STEP) {
+        uint16x8x2_t pair = vld2q_u16(src + i * 2);
+        vst1q_u16(ids + i, pair.val[0]);
+        vst1q_u16(states + i, pair.val[1]);
+    }
+#else
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        dst[i] = dataio::h2le(voxels[i].id);
-        dst[CHUNK_VOL + i] = dataio::h2le(blockstate2int(voxels[i].state));
+        ids[i] = dataio::h2le(voxels[i].id);
+        states[i] = dataio::h2le(blockstate2int(voxels[i].state));
     }
-    return buffer;
+#endif
 }
 
-bool Chunk::decode(const ubyte* data) {
-    auto src = reinterpret_cast<const uint16_t*>(data);
+/// @brief Merge ids and states arrays into voxels
+static void interleave(
+    const uint16_t* ids, const uint16_t* states, voxel* voxels
+) {
+#if defined(CHUNK_SSE2)
+    auto dst = reinterpret_cast<__m128i*>(voxels);
+    for (uint i = 0; i < CHUNK_VOL; i += VOXELS_STEP, dst += 2) {
+        __m128i id = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ids + i));
+        __m128i state =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(states + i));
+        _mm_storeu_si128(dst, _mm_unpacklo_epi16(id, state));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(id, state));
+    }
+#elif defined(CHUNK_NEON)
+    auto dst = reinterpret_cast<uint16_t*>(voxels);
+    for (uint i = 0; i < CHUNK_VOL; i += VOXELS_STEP) {
+        uint16x8x2_t pair {{vld1q_u16(ids + i), vld1q_u16(states + i)}};
+        vst2q_u16(dst + i * 2, pair);
+    }
+#else
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        voxel& vox = voxels[i];
-
-        vox.id = dataio::le2h(src[i]);
-        vox.state = int2blockstate(dataio::le2h(src[CHUNK_VOL + i]));
+        voxels[i].id = dataio::le2h(ids[i]);
+        voxels[i].state = int2blockstate(dataio::le2h(states[i]));
     }
+#endif
+}
+
+void Chunk::encode(ubyte* dst) const {
+    // compacted chunk is not expanded to be saved
+    auto voxels = this->voxels.read();
+    auto ids = reinterpret_cast<uint16_t*>(dst);
+    deinterleave(voxels.get(), ids, ids + CHUNK_VOL);
+}
+
+std::unique_ptr<ubyte[]> Chunk::encode() const {
+    auto buffer = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+    encode(buffer.get());
+    return buffer;
+}
+
+std::shared_ptr<ubyte[]> Chunk::encodeTemporary() const {
+    auto buffer = data_buffers.get();
+    encode(buffer.get());
+    return buffer;
+}
+
+bool Chunk::decode(const ubyte* data) {
+    auto ids = reinterpret_cast<const uint16_t*>(data);
+    interleave(ids, ids + CHUNK_VOL, voxels.data());
+    revision++;
+    // unknown until updateHeights
+    std::fill(std::begin(emptyBricks), std::end(emptyBricks), 0);
     return true;
 }
 
 void Chunk::convert(ubyte* data, const ContentReport* report) {
+    const auto& blocks = report->blocks;
     auto buffer = reinterpret_cast<uint16_t*>(data);
-    for (uint i = 0; i < CHUNK_VOL; i++) {
+    uint i = 0;
+#if defined(CHUNK_SSE2) || defined(CHUNK_NEON)
+    // no 16-bit gather in SSE2/NEON: runs of the same id (the most of
+    // chunk voxels) are remapped with a single lookup
+    for (; i < CHUNK_VOL; i += VOXELS_STEP) {
+        uint16_t first = buffer[i];
+#if defined(CHUNK_SSE2)
+        auto ptr = reinterpret_cast<__m128i*>(buffer + i);
+        __m128i ids = _mm_loadu_si128(ptr);
+        __m128i same =
+            _mm_cmpeq_epi16(ids, _mm_set1_epi16(static_cast<short>(first)));
+        if (_mm_movemask_epi8(same) == 0xFFFF) {
+            short replacement = static_cast<short>(blocks.getId(first));
+            _mm_storeu_si128(ptr, _mm_set1_epi16(replacement));
+            continue;
+        }
+#else
+        uint16x8_t ids = vld1q_u16(buffer + i);
+        uint16x8_t same = vceqq_u16(ids, vdupq_n_u16(first));
+        if (vminvq_u16(same) == 0xFFFF) {
+            vst1q_u16(buffer + i, vdupq_n_u16(blocks.getId(first)));
+            continue;
+        }
+#endif
+        for (uint j = i; j < i + VOXELS_STEP; j++) {
+            buffer[j] = blocks.getId(buffer[j]);
+        }
+    }
+#endif
+    for (; i < CHUNK_VOL; i++) {
         blockid_t id = dataio::le2h(buffer[i]);
-        blockid_t replacement = report->blocks.getId(id);
-        buffer[i] = dataio::h2le(replacement);
+        buffer[i] = dataio::h2le(blocks.getId(id));
     }
 }
@@ -2,12 +2,15 @@
 
 #include <stdlib.h>
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "constants.hpp"
 #include "lighting/Lightmap.hpp"
 #include "util/SmallHeap.hpp"
+#include "ChunkVoxels.hpp"
 #include "voxel.hpp"
 
 inline constexpr int CHUNK_DATA_LEN = CHUNK_VOL * 4;
@@ -20,11 +23,55 @@ using ChunkInventoriesMap =
 
 using BlocksMetadata = util::SmallHeap<uint16_t, uint8_t>;
 
+/// @brief Block update scheduled by BlocksController::scheduleUpdate
+struct ScheduledBlockUpdate {
+    /// @brief Voxel index
+    uint index;
+    /// @brief Target tick (see WorldInfo::blocksTick)
+    uint64_t tick;
+};
+
+static_assert(CHUNK_SECTIONS <= 32, "chunk sections masks are 32 bit");
+
+/// @brief Max number of random tickable blocks positions stored by chunk,
+/// chunks having more of them are sampled randomly
+inline constexpr uint CHUNK_MAX_SPARSE_TICKABLES = 64;
+
+/// @brief Size of a chunk brick (bricks are used to skip empty space)
+inline constexpr int CHUNK_BRICK_SIZE = 4;
+
+static_assert(
+    (CHUNK_W / CHUNK_BRICK_SIZE) * (CHUNK_SECTION_H / CHUNK_BRICK_SIZE) *
+            (CHUNK_D / CHUNK_BRICK_SIZE) ==
+        64,
+    "section bricks mask is 64 bit"
+);
+
 class Chunk {
 public:
     int x, z;
     int bottom, top;
-    voxel voxels[CHUNK_VOL] {};
+    /// @brief Bit mask of sections containing same voxels only.
+    /// Calculated by updateHeights, bits are reset on voxels change
+    std::atomic<uint32_t> uniformSections = 0;
+    /// @brief Bit mask of sections mesh to be rebuilt.
+    /// Set with flags.modified, reset by chunks renderer
+    std::atomic<uint32_t> dirtySections = 0;
+    /// @brief Bit mask of sections with lights changed. Set by lights
+    /// solvers, reset by chunks renderer updating lights texture or
+    /// marking the sections mesh to be rebuilt
+    std::atomic<uint32_t> lightSections = 0;
+    /// @brief Voxels change counter incremented by setModified, decode
+    /// and reset. Lets observers (see ChunksStreamer) find changed chunks
+    /// without comparing voxels
+    std::atomic<uint32_t> revision = 0;
+    /// @brief Bit masks of bricks containing air only, one per section.
+    /// Calculated by updateHeights, bits are reset on voxels id change
+    uint64_t emptyBricks[CHUNK_SECTIONS] {};
+    /// @brief Numbers of non-air voxels, one per section.
+    /// Calculated by updateHeights, maintained by onVoxelIdChanged
+    uint16_t sectionBlocks[CHUNK_SECTIONS] {};
+    ChunkVoxels voxels;
     Lightmap lightmap;
     struct {
         bool modified : 1;
@@ -35,19 +82,97 @@ public:
         bool loadedLights : 1;
         bool entities : 1;
         bool blocksData : 1;
+        bool scheduledUpdates : 1;
+        /// @brief Voxels changed since the last scripts chunks events
+        /// dispatch (see scripting::on_world_tick)
+        bool changed : 1;
+        /// @brief Voxels are generated and not saved yet, a generator
+        /// prototype may be stored for the chunk
+        bool generated : 1;
     } flags {};
 
     /// @brief Block inventories map where key is index of block in voxels array
     ChunkInventoriesMap inventories;
     /// @brief Blocks metadata heap
     BlocksMetadata blocksMetadata;
+    /// @brief Pending scheduled block updates of the chunk. Kept in the
+    /// chunk to be saved with it, BlocksController timer wheel refers them
+    std::vector<ScheduledBlockUpdate> scheduledUpdates;
+    /// @brief Voxel indices of fluid cells to be updated by
+    /// FluidsController (may repeat). Filled by Chunks::set
+    std::vector<uint> fluidCells;
+    /// @brief Voxel indices of decorative blocks, see Chunks::getDecorations
+    std::vector<uint> decorations;
+    /// @brief Decorations are indexed. Reset by updateHeights (called on
+    /// voxels bulk change)
+    bool decorationsIndexed = false;
+    /// @brief Number of blocks having random update events,
+    /// see Chunks::indexRandomTickables
+    uint randomTickablesCount = 0;
+    /// @brief Voxel indices of blocks having random update events while
+    /// there are at most CHUNK_MAX_SPARSE_TICKABLES of them
+    std::vector<uint> randomTickables;
+    /// @brief randomTickables contains all random tickable blocks
+    bool randomTickablesSparse = false;
+    /// @brief Random tickables are indexed. Reset by updateHeights
+    bool randomTickablesIndexed = false;
 
     Chunk(int x, int z);
 
+    /// @brief Reinitialize chunk for reuse at the given position.
+    /// Keeps allocated voxels and containers memory
+    void reset(int x, int z);
+
+    /// @return true if chunk contains air only (see sectionBlocks)
     bool isEmpty() const;
 
+    /// @brief Update sections info, bottom and top after voxels bulk change
     void updateHeights();
 
+    /// @brief Update non-air voxels counts, bottom and top after a single
+    /// voxel id change
+    /// @param y voxel y
+    /// @param prevId previous voxel id
+    /// @param id new voxel id
+    void onVoxelIdChanged(int y, blockid_t prevId, blockid_t id);
+
+    /// @brief Find bottom and top using non-air voxels counts, scanning
+    /// the boundary sections only
+    void updateBounds();
+
+    inline bool isUniformSection(uint section) const {
+        return uniformSections & (1U << section);
+    }
+
+    /// @brief Mark section containing the given voxel y as not uniform
+    inline void resetUniformSection(int y) {
+        uniformSections &= ~(1U << (y / CHUNK_SECTION_H));
+    }
+
+    static inline uint64_t brickBit(uint x, uint y, uint z) {
+        constexpr uint bw = CHUNK_W / CHUNK_BRICK_SIZE;
+        constexpr uint bd = CHUNK_D / CHUNK_BRICK_SIZE;
+        uint bx = x / CHUNK_BRICK_SIZE;
+        uint by = y % CHUNK_SECTION_H / CHUNK_BRICK_SIZE;
+        uint bz = z / CHUNK_BRICK_SIZE;
+        return 1ULL << ((by * bd + bz) * bw + bx);
+    }
+
+    inline bool isEmptySection(uint section) const {
+        return emptyBricks[section] == ~0ULL;
+    }
+
+    /// @return true if brick containing the local voxel is known to
+    /// contain air only
+    inline bool isEmptyBrick(uint x, uint y, uint z) const {
+        return emptyBricks[y / CHUNK_SECTION_H] & brickBit(x, y, z);
+    }
+
+    /// @brief Mark brick containing the local voxel as not empty
+    inline void resetEmptyBrick(uint x, uint y, uint z) {
+        emptyBricks[y / CHUNK_SECTION_H] &= ~brickBit(x, y, z);
+    }
+
     // unused
     std::unique_ptr<Chunk> clone() const;
 
@@ -62,17 +187,76 @@ public:
     /// @return inventory bound to the given block or nullptr
     std::shared_ptr<Inventory> getBlockInventory(uint x, uint y, uint z) const;
 
-    inline void setModifiedAndUnsaved() {
+    /// @brief Bit mask of all chunk sections
+    static constexpr uint32_t ALL_SECTIONS =
+        CHUNK_SECTIONS == 32 ? ~0U : (1U << CHUNK_SECTIONS) - 1;
+
+    /// @brief Mark the whole chunk mesh to be rebuilt
+    inline void setModified() {
+        flags.modified = true;
+        revision++;
+        dirtySections = ALL_SECTIONS;
+    }
+
+    /// @brief Get bit mask of sections affected by change of voxel
+    /// at the given y (including sections with neighbour voxels)
+    static inline uint32_t getAffectedSections(int y) {
+        uint32_t mask = 1U << (y / CHUNK_SECTION_H);
+        if (y % CHUNK_SECTION_H == 0 && y > 0) {
+            mask |= mask >> 1;
+        } else if (y % CHUNK_SECTION_H == CHUNK_SECTION_H - 1 &&
+                   y < CHUNK_H - 1) {
+            mask |= mask << 1;
+        }
+        return mask;
+    }
+
+    /// @brief Mark sections mesh affected by change of voxel at the given y
+    /// to be rebuilt
+    inline void setModified(int y) {
         flags.modified = true;
+        revision++;
+        dirtySections |= getAffectedSections(y);
+    }
+
+    /// @brief Mark lights of all sections changed
+    inline void setLightsModified() {
+        lightSections = ALL_SECTIONS;
+    }
+
+    /// @brief Mark lights of sections affected by change of light at
+    /// the given y changed
+    inline void setLightsModified(int y) {
+        lightSections |= getAffectedSections(y);
+    }
+
+    inline void setModifiedAndUnsaved() {
+        setModified();
         flags.unsaved = true;
+        flags.changed = true;
+    }
+
+    inline void setModifiedAndUnsaved(int y) {
+        setModified(y);
+        flags.unsaved = true;
+        flags.changed = true;
     }
 
     /// @brief Encode chunk to bytes array of size CHUNK_DATA_LEN
     /// @see /doc/specs/region_voxels_chunk_spec.md
     std::unique_ptr<ubyte[]> encode() const;
 
+    /// @brief Encode chunk into the caller buffer of size CHUNK_DATA_LEN
+    void encode(ubyte* dst) const;
+
+    /// @brief Encode chunk into a pooled buffer of size CHUNK_DATA_LEN.
+    /// For transient data: the buffer returns to the pool when released
+    std::shared_ptr<ubyte[]> encodeTemporary() const;
+
+    /// @param data encoded chunk of size CHUNK_DATA_LEN, not retained
     /// @return true if all is fine
     bool decode(const ubyte* data);
 
+    /// @brief Remap blocks ids of encoded chunk in-place
     static void convert(ubyte* data, const ContentReport* report);
 };
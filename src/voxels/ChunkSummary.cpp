@@ -0,0 +1,38 @@
+#include "ChunkSummary.hpp"
+
+#include "util/data_io.hpp"
+
+ChunkSummary ChunkSummary::build(const voxel* voxels) {
+    ChunkSummary summary;
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            auto& cell = summary.at(x / CELL_SIZE, z / CELL_SIZE);
+            // only heights above the cell top are interesting
+            for (int y = CHUNK_H - 1; y >= cell.height; y--) {
+                blockid_t id = voxels[vox_index(x, y, z)].id;
+                if (id != BLOCK_AIR) {
+                    cell.id = id;
+                    cell.height = y + 1;
+                    break;
+                }
+            }
+        }
+    }
+    return summary;
+}
+
+std::unique_ptr<ubyte[]> ChunkSummary::encode() const {
+    auto data = std::make_unique<ubyte[]>(DATA_LEN);
+    for (int i = 0; i < CELLS_COUNT; i++) {
+        dataio::write_int16_big(cells[i].id, data.get(), i * 4);
+        dataio::write_int16_big(cells[i].height, data.get(), i * 4 + 2);
+    }
+    return data;
+}
+
+void ChunkSummary::decode(const ubyte* data) {
+    for (int i = 0; i < CELLS_COUNT; i++) {
+        cells[i].id = dataio::read_int16_big(data, i * 4);
+        cells[i].height = dataio::read_int16_big(data, i * 4 + 2);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+
+#include "constants.hpp"
+#include "typedefs.hpp"
+#include "voxel.hpp"
+
+/// @brief Low resolution chunk surface drawn as far terrain beyond loaded
+/// chunks (see HorizonRenderer). Chunk is divided into square columns
+/// (cells), a cell keeps its highest non-air block and the block height
+struct ChunkSummary {
+    /// @brief Cell width and depth in blocks
+    static constexpr int CELL_SIZE = 4;
+    static constexpr int CELLS_W = CHUNK_W / CELL_SIZE;
+    static constexpr int CELLS_D = CHUNK_D / CELL_SIZE;
+    static constexpr int CELLS_COUNT = CELLS_W * CELLS_D;
+    /// @brief Encoded summary length in bytes
+    static constexpr uint DATA_LEN = CELLS_COUNT * 4;
+
+    struct Cell {
+        blockid_t id = BLOCK_AIR;
+        /// @brief Top block y + 1, 0 if the cell is empty
+        uint16_t height = 0;
+    };
+    Cell cells[CELLS_COUNT] {};
+
+    Cell& at(int x, int z) {
+        return cells[z * CELLS_W + x];
+    }
+
+    const Cell& at(int x, int z) const {
+        return cells[z * CELLS_W + x];
+    }
+
+    /// @brief Make summary of the chunk voxels array
+    static ChunkSummary build(const voxel* voxels);
+
+    std::unique_ptr<ubyte[]> encode() const;
+
+    /// @param data DATA_LEN bytes
+    void decode(const ubyte* data);
+};
@@ -0,0 +1,73 @@
+#include "ChunkVoxels.hpp"
+
+#include <algorithm>
+
+#include "PackedVoxels.hpp"
+
+ChunkVoxels::ChunkVoxels() : expanded(new voxel[CHUNK_VOL] {}) {
+}
+
+ChunkVoxels::~ChunkVoxels() = default;
+
+voxel* ChunkVoxels::expand() const {
+    std::shared_ptr<voxel[]> voxels(new voxel[CHUNK_VOL]);
+    packed->unpack(voxels.get());
+
+    std::lock_guard lock(mutex);
+    expanded = std::move(voxels);
+    packed = nullptr;
+    return expanded.get();
+}
+
+voxel ChunkVoxels::get(uint index) const {
+    if (expanded) {
+        return expanded[index];
+    }
+    return packed->get(index);
+}
+
+std::shared_ptr<const voxel[]> ChunkVoxels::read() const {
+    std::shared_ptr<const PackedVoxels> source;
+    {
+        std::lock_guard lock(mutex);
+        if (expanded) {
+            return expanded;
+        }
+        source = packed;
+    }
+    std::shared_ptr<voxel[]> voxels(new voxel[CHUNK_VOL]);
+    source->unpack(voxels.get());
+    return voxels;
+}
+
+bool ChunkVoxels::compact() {
+    if (expanded == nullptr) {
+        return false;
+    }
+    auto voxels = std::make_shared<const PackedVoxels>(expanded.get());
+
+    std::lock_guard lock(mutex);
+    packed = std::move(voxels);
+    expanded = nullptr;
+    return true;
+}
+
+void ChunkVoxels::reset() {
+    if (expanded) {
+        std::fill(expanded.get(), expanded.get() + CHUNK_VOL, voxel {});
+        return;
+    }
+    std::shared_ptr<voxel[]> voxels(new voxel[CHUNK_VOL] {});
+
+    std::lock_guard lock(mutex);
+    expanded = std::move(voxels);
+    packed = nullptr;
+}
+
+size_t ChunkVoxels::getMemoryUsage() const {
+    std::lock_guard lock(mutex);
+    if (expanded) {
+        return CHUNK_VOL * sizeof(voxel);
+    }
+    return packed->getMemoryUsage();
+}
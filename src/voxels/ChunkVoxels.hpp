@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include "constants.hpp"
+#include "voxel.hpp"
+
+class PackedVoxels;
+
+/// @brief Chunk voxels array which may be kept palette-compressed while
+/// not accessed directly. Direct access, const data() and operator[]
+/// included, expands voxels back, so it must be performed by the chunk
+/// owner (main) thread only. Other threads use read() or get chunks
+/// expanded by the main thread before the work is dispatched
+class ChunkVoxels {
+    mutable std::shared_ptr<voxel[]> expanded;
+    mutable std::shared_ptr<const PackedVoxels> packed;
+    /// @brief Guards the pointers replacement from read() in other threads
+    mutable std::mutex mutex;
+
+    voxel* expand() const;
+public:
+    ChunkVoxels();
+    ChunkVoxels(const ChunkVoxels&) = delete;
+    ~ChunkVoxels();
+
+    inline voxel* data() {
+        return expanded ? expanded.get() : expand();
+    }
+
+    inline const voxel* data() const {
+        return expanded ? expanded.get() : expand();
+    }
+
+    inline voxel& operator[](uint index) {
+        return data()[index];
+    }
+
+    inline const voxel& operator[](uint index) const {
+        return data()[index];
+    }
+
+    /// @brief Get voxel without expanding. Owner thread only
+    voxel get(uint index) const;
+
+    /// @brief Get voxels without expanding. Thread-safe
+    /// @return voxels array or its unpacked copy if compacted
+    std::shared_ptr<const voxel[]> read() const;
+
+    /// @brief Palette-compress voxels. Pointers to voxels get invalid
+    /// @return false if compacted already
+    bool compact();
+
+    bool isCompact() const {
+        return expanded == nullptr;
+    }
+
+    /// @brief Fill voxels with zeros (air) keeping the array if expanded
+    void reset();
+
+    /// @brief Get approximate heap memory used by voxels in bytes
+    size_t getMemoryUsage() const;
+};
@@ -11,6 +11,7 @@
 #include "coders/byte_utils.hpp"
 #include "coders/json.hpp"
 #include "content/Content.hpp"
+#include "debug/Profiler.hpp"
 #include "files/WorldFiles.hpp"
 #include "graphics/core/Mesh.hpp"
 #include "lighting/Lightmap.hpp"
@@ -18,6 +19,7 @@
 #include "maths/rays.hpp"
 #include "maths/voxmaths.hpp"
 #include "objects/Entities.hpp"
+#include "util/ThreadPool.hpp"
 #include "world/Level.hpp"
 #include "world/LevelEvents.hpp"
 #include "VoxelsVolume.hpp"
@@ -25,6 +27,85 @@
 #include "Chunk.hpp"
 #include "voxel.hpp"
 
+/// @brief Number of rays cast by a batch raycast job
+static constexpr size_t RAYCAST_BATCH_SIZE = 64;
+
+struct Chunks::RayCastJob {
+    const RayCastQuery* rays;
+    RayCastHit* hits;
+    size_t count;
+    const std::set<blockid_t>* filter;
+};
+
+struct Chunks::RayCastResult {};
+
+class Chunks::RayCastWorker
+    : public util::Worker<Chunks::RayCastJob, Chunks::RayCastResult> {
+    const Chunks& chunks;
+public:
+    RayCastWorker(const Chunks& chunks) : chunks(chunks) {
+    }
+
+    static void cast(
+        const Chunks& chunks,
+        const RayCastQuery* rays,
+        RayCastHit* hits,
+        size_t count,
+        const std::set<blockid_t>& filter
+    ) {
+        for (size_t i = 0; i < count; i++) {
+            const auto& ray = rays[i];
+            auto& hit = hits[i];
+            auto voxel = chunks.rayCast(
+                ray.start,
+                ray.dir,
+                ray.maxDist,
+                hit.end,
+                hit.norm,
+                hit.iend,
+                filter
+            );
+            hit.hit = voxel != nullptr;
+            hit.block = voxel ? voxel->id : BLOCK_VOID;
+        }
+    }
+
+    RayCastResult operator()(const RayCastJob& job) override {
+        cast(chunks, job.rays, job.hits, job.count, *job.filter);
+        return {};
+    }
+};
+
+/// @brief Max number of unloaded chunks being saved by workers. Unloading
+/// more chunks waits for the workers
+static constexpr size_t MAX_SAVING_CHUNKS = 128;
+
+struct Chunks::SaveJob {
+    glm::ivec2 key;
+    /// @brief Chunk kept by Chunks::saving until the result is consumed
+    const Chunk* chunk;
+    /// @brief Serialized entities encoded by the worker
+    dv::value entities;
+};
+
+struct Chunks::SaveResult {
+    glm::ivec2 key;
+    const Chunk* chunk;
+};
+
+class Chunks::SaveWorker
+    : public util::Worker<Chunks::SaveJob, Chunks::SaveResult> {
+    WorldRegions& regions;
+public:
+    SaveWorker(WorldRegions& regions) : regions(regions) {
+    }
+
+    SaveResult operator()(const SaveJob& job) override {
+        regions.encode(*job.chunk, encodeEntities(job.entities));
+        return {job.key, job.chunk};
+    }
+};
+
 Chunks::Chunks(
     int32_t w,
     int32_t d,
@@ -39,9 +120,42 @@ Chunks::Chunks(
       worldFiles(wfile) {
     areaMap.setCenter(ox-w/2, oz-d/2);
     areaMap.setOutCallback([this](int, int, const auto& chunk) {
-        save(chunk.get());
+        saveAsync(chunk);
         this->level->events->trigger(EVT_CHUNK_HIDDEN, chunk.get());
     });
+    if (util::TaskScheduler::getDefault().getThreadsCount() > 1) {
+        rayCastPool =
+            std::make_unique<util::ThreadPool<RayCastJob, RayCastResult>>(
+                "chunks-raycast",
+                [this]() { return std::make_shared<RayCastWorker>(*this); },
+                [](RayCastResult&) {},
+                util::ThreadPool<RayCastJob, RayCastResult>::HALF
+            );
+        rayCastPool->setPriority(util::TaskScheduler::Priority::HIGH);
+
+        savePool = std::make_unique<util::ThreadPool<SaveJob, SaveResult>>(
+            "chunks-save",
+            [this]() {
+                return std::make_shared<SaveWorker>(worldFiles->getRegions());
+            },
+            [this](SaveResult& result) {
+                auto found = saving.find(result.key);
+                if (found != saving.end() &&
+                    found->second.get() == result.chunk) {
+                    // released in the main thread returning to the pool
+                    saving.erase(found);
+                }
+            },
+            util::ThreadPool<SaveJob, SaveResult>::HALF
+        );
+        savePool->setPriority(util::TaskScheduler::Priority::LOW);
+    }
+}
+
+Chunks::~Chunks() {
+    if (savePool) {
+        savePool->waitForJobs();
+    }
 }
 
 voxel* Chunks::get(int32_t x, int32_t y, int32_t z) const {
@@ -107,7 +221,7 @@ const AABB* Chunks::isObstacleAt(float x, float y, float z) const {
 bool Chunks::isSolidBlock(int32_t x, int32_t y, int32_t z) {
     voxel* v = get(x, y, z);
     if (v == nullptr) return false;
-    return indices->blocks.get(v->id)->rt.solid;  //-V522
+    return indices->blocksProps.solid[v->id];
 }
 
 bool Chunks::isReplaceableBlock(int32_t x, int32_t y, int32_t z) {
@@ -119,7 +233,7 @@ bool Chunks::isReplaceableBlock(int32_t x, int32_t y, int32_t z) {
 bool Chunks::isObstacleBlock(int32_t x, int32_t y, int32_t z) {
     voxel* v = get(x, y, z);
     if (v == nullptr) return false;
-    return indices->blocks.get(v->id)->obstacle;  //-V522
+    return indices->blocksProps.obstacle[v->id];
 }
 
 ubyte Chunks::getLight(int32_t x, int32_t y, int32_t z, int channel) const {
@@ -181,6 +295,10 @@ Chunk* Chunks::getChunk(int x, int z) const {
     return nullptr;
 }
 
+std::shared_ptr<Chunk> Chunks::getChunkHandle(int32_t x, int32_t z) const {
+    return areaMap.get(x, z);
+}
+
 glm::ivec3 Chunks::seekOrigin(
     const glm::ivec3& srcpos, const Block& def, blockstate state
 ) const {
@@ -315,7 +433,8 @@ void Chunks::setRotationExtended(
                     vox->state = segState;
                     auto chunk = getChunkByVoxel(pos.x, pos.y, pos.z);
                     assert(chunk != nullptr);
-                    chunk->setModifiedAndUnsaved();
+                    chunk->resetUniformSection(pos.y);
+                    chunk->setModifiedAndUnsaved(pos.y);
                     segmentBlocks.emplace_back(pos);
                 }
             }
@@ -339,6 +458,19 @@ void Chunks::setRotationExtended(
     }
 }
 
+void Chunks::onBlockChanged(int32_t x, int32_t y, int32_t z) {
+    if (changedBlocks.size() < MAX_CHANGED_BLOCKS) {
+        changedBlocks.emplace_back(x, y, z);
+    } else {
+        changedBlocksOverflow = true;
+    }
+}
+
+void Chunks::onChunkDataChanged(int32_t, int32_t) {
+    changedBlocks.clear();
+    changedBlocksOverflow = true;
+}
+
 void Chunks::setRotation(int32_t x, int32_t y, int32_t z, uint8_t index) {
     if (index >= BlockRotProfile::MAX_COUNT) {
         return;
@@ -359,7 +491,9 @@ void Chunks::setRotation(int32_t x, int32_t y, int32_t z, uint8_t index) {
         vox->state.rotation = index;
         auto chunk = getChunkByVoxel(x, y, z);
         assert(chunk != nullptr);
-        chunk->setModifiedAndUnsaved();
+        chunk->resetUniformSection(y);
+        chunk->setModifiedAndUnsaved(y);
+        onBlockChanged(x, y, z);
     }
 }
 
@@ -404,32 +538,178 @@ void Chunks::set(
     const auto& newdef = indices->blocks.require(id);
     vox.id = id;
     vox.state = state;
-    chunk->setModifiedAndUnsaved();
+    chunk->resetUniformSection(y);
+    chunk->resetEmptyBrick(lx, y, lz);
+    chunk->setModifiedAndUnsaved(y);
+    onBlockChanged(x, y, z);
     if (!state.segment && newdef.rt.extended) {
         repairSegments(newdef, state, x, y, z);
     }
 
-    if (y < chunk->bottom)
-        chunk->bottom = y;
-    else if (y + 1 > chunk->top)
-        chunk->top = y + 1;
-    else if (id == 0)
-        chunk->updateHeights();
+    chunk->onVoxelIdChanged(y, prevdef.rt.id, id);
+
+    if (chunk->decorationsIndexed) {
+        auto& decorations = chunk->decorations;
+        if (prevdef.rt.decorative) {
+            decorations.erase(
+                std::remove(decorations.begin(), decorations.end(), index),
+                decorations.end()
+            );
+        }
+        if (newdef.rt.decorative) {
+            decorations.push_back(index);
+        }
+    }
+    const auto& randomUpdate = indices->blocksProps.randomUpdate;
+    if (chunk->randomTickablesIndexed &&
+        randomUpdate[prevdef.rt.id] != randomUpdate[id]) {
+        auto& tickables = chunk->randomTickables;
+        if (randomUpdate[id]) {
+            chunk->randomTickablesCount++;
+            if (chunk->randomTickablesCount > CHUNK_MAX_SPARSE_TICKABLES) {
+                chunk->randomTickablesSparse = false;
+                tickables.clear();
+            } else if (chunk->randomTickablesSparse) {
+                tickables.push_back(index);
+            }
+        } else {
+            chunk->randomTickablesCount--;
+            tickables.erase(
+                std::remove(tickables.begin(), tickables.end(), index),
+                tickables.end()
+            );
+        }
+    }
 
     if (lx == 0 && (chunk = getChunk(cx - 1, cz))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lz == 0 && (chunk = getChunk(cx, cz - 1))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lx == CHUNK_W - 1 && (chunk = getChunk(cx + 1, cz))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lz == CHUNK_D - 1 && (chunk = getChunk(cx, cz + 1))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
+    }
+    if (indices->blocksProps.fluids) {
+        activateFluids(x, y, z);
     }
 }
 
+void Chunks::activateFluids(int32_t x, int32_t y, int32_t z) {
+    static const glm::ivec3 cells[] {
+        {0, 0, 0}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0},
+        {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+    };
+    const auto& fluid = indices->blocksProps.fluid;
+    for (const auto& offset : cells) {
+        glm::ivec3 pos = glm::ivec3(x, y, z) + offset;
+        Chunk* chunk = getChunkByVoxel(pos.x, pos.y, pos.z);
+        if (chunk == nullptr) {
+            continue;
+        }
+        uint index = vox_index(
+            pos.x - chunk->x * CHUNK_W, pos.y, pos.z - chunk->z * CHUNK_D
+        );
+        if (fluid[chunk->voxels[index].id]) {
+            chunk->fluidCells.push_back(index);
+        }
+    }
+}
+
+const std::vector<uint>& Chunks::getDecorations(Chunk& chunk) const {
+    if (chunk.decorationsIndexed) {
+        return chunk.decorations;
+    }
+    auto& decorations = chunk.decorations;
+    decorations.clear();
+    const auto& blocks = indices->blocks;
+    auto voxels = chunk.voxels.read();
+    for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        if (chunk.isEmptySection(s)) {
+            continue;
+        }
+        for (uint i = s * CHUNK_SECTION_VOL; i < (s + 1) * CHUNK_SECTION_VOL;
+             i++) {
+            if (blocks.require(voxels[i].id).rt.decorative) {
+                decorations.push_back(i);
+            }
+        }
+    }
+    chunk.decorationsIndexed = true;
+    return decorations;
+}
+
+void Chunks::indexRandomTickables(Chunk& chunk) const {
+    if (chunk.randomTickablesIndexed) {
+        return;
+    }
+    const auto& randomUpdate = indices->blocksProps.randomUpdate;
+    auto& tickables = chunk.randomTickables;
+    tickables.clear();
+    uint count = 0;
+    auto voxels = chunk.voxels.read();
+    for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        if (chunk.isEmptySection(s)) {
+            continue;
+        }
+        uint begin = s * CHUNK_SECTION_VOL;
+        if (chunk.isUniformSection(s)) {
+            if (randomUpdate[voxels[begin].id]) {
+                count += CHUNK_SECTION_VOL;
+            }
+            continue;
+        }
+        for (uint i = begin; i < begin + CHUNK_SECTION_VOL; i++) {
+            if (randomUpdate[voxels[i].id]) {
+                if (++count <= CHUNK_MAX_SPARSE_TICKABLES) {
+                    tickables.push_back(i);
+                }
+            }
+        }
+    }
+    chunk.randomTickablesCount = count;
+    chunk.randomTickablesSparse = count <= CHUNK_MAX_SPARSE_TICKABLES;
+    if (!chunk.randomTickablesSparse) {
+        tickables.clear();
+    }
+    chunk.randomTickablesIndexed = true;
+}
+
+/// @brief Get bounds of the air only area containing the voxel:
+/// the whole section or the brick
+/// @return false if the voxel is not known to be in an empty area
+static bool get_empty_area(
+    const Chunk& chunk, int x, int y, int z, glm::ivec3& min, glm::ivec3& max
+) {
+    int lx = x - chunk.x * CHUNK_W;
+    int lz = z - chunk.z * CHUNK_D;
+    if (chunk.isEmptySection(y / CHUNK_SECTION_H)) {
+        min = glm::ivec3(x - lx, y - y % CHUNK_SECTION_H, z - lz);
+        max = min + glm::ivec3(CHUNK_W, CHUNK_SECTION_H, CHUNK_D) - 1;
+        return true;
+    }
+    if (!chunk.isEmptyBrick(lx, y, lz)) {
+        return false;
+    }
+    min = glm::ivec3(
+        x - lx % CHUNK_BRICK_SIZE,
+        y - y % CHUNK_BRICK_SIZE,
+        z - lz % CHUNK_BRICK_SIZE
+    );
+    max = min + (CHUNK_BRICK_SIZE - 1);
+    return true;
+}
+
+static inline bool is_inside(
+    int x, int y, int z, const glm::ivec3& min, const glm::ivec3& max
+) {
+    return x >= min.x && y >= min.y && z >= min.z && x <= max.x &&
+           y <= max.y && z <= max.z;
+}
+
 voxel* Chunks::rayCast(
     const glm::vec3& start,
     const glm::vec3& dir,
@@ -437,7 +717,7 @@ voxel* Chunks::rayCast(
     glm::vec3& end,
     glm::ivec3& norm,
     glm::ivec3& iend,
-    std::set<blockid_t> filter
+    const std::set<blockid_t>& filter
 ) const {
     float px = start.x;
     float py = start.y;
@@ -472,11 +752,59 @@ voxel* Chunks::rayCast(
 
     int steppedIndex = -1;
 
+    auto step = [&]() {
+        if (txMax < tyMax) {
+            if (txMax < tzMax) {
+                ix += stepx;
+                t = txMax;
+                txMax += txDelta;
+                steppedIndex = 0;
+            } else {
+                iz += stepz;
+                t = tzMax;
+                tzMax += tzDelta;
+                steppedIndex = 2;
+            }
+        } else {
+            if (tyMax < tzMax) {
+                iy += stepy;
+                t = tyMax;
+                tyMax += tyDelta;
+                steppedIndex = 1;
+            } else {
+                iz += stepz;
+                t = tzMax;
+                tzMax += tzDelta;
+                steppedIndex = 2;
+            }
+        }
+    };
+
+    // air is skipped by empty bricks and sections if it can't be hit
+    bool skipAir = filter.empty()
+                       ? !indices->blocks.require(BLOCK_AIR).selectable
+                       : filter.find(BLOCK_AIR) != filter.end();
+    // bounds of the empty area the ray is passing through
+    glm::ivec3 emptyMin {1};
+    glm::ivec3 emptyMax {0};
+
     while (t <= maxDist) {
-        voxel* voxel = get(ix, iy, iz);
-        if (voxel == nullptr) {
+        if (is_inside(ix, iy, iz, emptyMin, emptyMax)) {
+            step();
+            continue;
+        }
+        auto chunk = getChunkByVoxel(ix, iy, iz);
+        if (chunk == nullptr) {
             return nullptr;
         }
+        if (skipAir &&
+            get_empty_area(*chunk, ix, iy, iz, emptyMin, emptyMax)) {
+            step();
+            continue;
+        }
+        voxel* voxel = &chunk->voxels[vox_index(
+            ix - chunk->x * CHUNK_W, iy, iz - chunk->z * CHUNK_D
+        )];
 
         const auto& def = indices->blocks.require(voxel->id);
         if ((filter.empty() && def.selectable) ||
@@ -532,31 +860,7 @@ voxel* Chunks::rayCast(
                 return voxel;
             }
         }
-        if (txMax < tyMax) {
-            if (txMax < tzMax) {
-                ix += stepx;
-                t = txMax;
-                txMax += txDelta;
-                steppedIndex = 0;
-            } else {
-                iz += stepz;
-                t = tzMax;
-                tzMax += tzDelta;
-                steppedIndex = 2;
-            }
-        } else {
-            if (tyMax < tzMax) {
-                iy += stepy;
-                t = tyMax;
-                tyMax += tyDelta;
-                steppedIndex = 1;
-            } else {
-                iz += stepz;
-                t = tzMax;
-                tzMax += tzDelta;
-                steppedIndex = 2;
-            }
-        }
+        step();
     }
     iend.x = ix;
     iend.y = iy;
@@ -569,6 +873,71 @@ voxel* Chunks::rayCast(
     return nullptr;
 }
 
+/// @brief Chunks along the ray sampling step, relative to the chunk size
+static constexpr float RAY_CHUNKS_STEP = 0.5f;
+
+/// @brief Expand compact voxels of chunks along the ray and their
+/// neighbours (reached by segmented blocks origins). Expansion replaces
+/// voxel arrays, so it is done by the main thread before the rays are
+/// passed to workers
+static void expand_along_ray(const Chunks& chunks, const RayCastQuery& ray) {
+    glm::vec2 start(ray.start.x / CHUNK_W, ray.start.z / CHUNK_D);
+    glm::vec2 offset(
+        ray.dir.x * ray.maxDist / CHUNK_W, ray.dir.z * ray.maxDist / CHUNK_D
+    );
+    float length = glm::length(offset);
+    glm::ivec2 prev(std::numeric_limits<int>::max());
+    // consecutive samples are in the same or adjacent chunks
+    for (float distance = 0.0f;; distance += RAY_CHUNKS_STEP) {
+        bool last = distance >= length;
+        glm::vec2 pos =
+            last ? start + offset : start + offset * (distance / length);
+        glm::ivec2 cell(glm::floor(pos));
+        if (cell != prev) {
+            // the ray stops at the first missing chunk
+            if (chunks.getChunk(cell.x, cell.y) == nullptr) {
+                break;
+            }
+            prev = cell;
+            for (int dz = -1; dz <= 1; dz++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    auto chunk = chunks.getChunk(cell.x + dx, cell.y + dz);
+                    if (chunk && chunk->voxels.isCompact()) {
+                        chunk->voxels.data();
+                    }
+                }
+            }
+        }
+        if (last) {
+            break;
+        }
+    }
+}
+
+void Chunks::rayCast(
+    const RayCastQuery* rays,
+    RayCastHit* hits,
+    size_t count,
+    const std::set<blockid_t>& filter
+) {
+    if (rayCastPool == nullptr || count <= RAYCAST_BATCH_SIZE) {
+        RayCastWorker::cast(*this, rays, hits, count, filter);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        expand_along_ray(*this, rays[i]);
+    }
+    // chunks along the rays are expanded, so workers only read them
+    for (size_t offset = 0; offset < count; offset += RAYCAST_BATCH_SIZE) {
+        rayCastPool->enqueueJob(RayCastJob {
+            rays + offset,
+            hits + offset,
+            std::min(RAYCAST_BATCH_SIZE, count - offset),
+            &filter});
+    }
+    rayCastPool->waitForJobs();
+}
+
 glm::vec3 Chunks::rayCastToObstacle(
     const glm::vec3& start, const glm::vec3& dir, float maxDist
 ) const {
@@ -603,8 +972,52 @@ glm::vec3 Chunks::rayCastToObstacle(
     float tyMax = (tyDelta < infinity) ? tyDelta * ydist : infinity;
     float tzMax = (tzDelta < infinity) ? tzDelta * zdist : infinity;
 
+    auto step = [&]() {
+        if (txMax < tyMax) {
+            if (txMax < tzMax) {
+                ix += stepx;
+                t = txMax;
+                txMax += txDelta;
+            } else {
+                iz += stepz;
+                t = tzMax;
+                tzMax += tzDelta;
+            }
+        } else {
+            if (tyMax < tzMax) {
+                iy += stepy;
+                t = tyMax;
+                tyMax += tyDelta;
+            } else {
+                iz += stepz;
+                t = tzMax;
+                tzMax += tzDelta;
+            }
+        }
+    };
+
+    bool skipAir = !indices->blocks.require(BLOCK_AIR).obstacle;
+    // bounds of the empty area the ray is passing through
+    glm::ivec3 emptyMin {1};
+    glm::ivec3 emptyMax {0};
+
     while (t <= maxDist) {
-        voxel* voxel = get(ix, iy, iz);
+        if (is_inside(ix, iy, iz, emptyMin, emptyMax)) {
+            step();
+            continue;
+        }
+        auto chunk = getChunkByVoxel(ix, iy, iz);
+        if (skipAir && chunk &&
+            get_empty_area(*chunk, ix, iy, iz, emptyMin, emptyMax)) {
+            step();
+            continue;
+        }
+        voxel* voxel = chunk ? &chunk->voxels[vox_index(
+                                   ix - chunk->x * CHUNK_W,
+                                   iy,
+                                   iz - chunk->z * CHUNK_D
+                               )]
+                             : nullptr;
         if (voxel) {
             const auto& def = indices->blocks.require(voxel->id);
             if (def.obstacle) {
@@ -639,27 +1052,7 @@ glm::vec3 Chunks::rayCastToObstacle(
                 }
             }
         }
-        if (txMax < tyMax) {
-            if (txMax < tzMax) {
-                ix += stepx;
-                t = txMax;
-                txMax += txDelta;
-            } else {
-                iz += stepz;
-                t = tzMax;
-                tzMax += tzDelta;
-            }
-        } else {
-            if (tyMax < tzMax) {
-                iy += stepy;
-                t = tyMax;
-                tyMax += tyDelta;
-            } else {
-                iz += stepz;
-                t = tzMax;
-                tzMax += tzDelta;
-            }
-        }
+        step();
     }
     return glm::vec3(px + maxDist * dx, py + maxDist * dy, pz + maxDist * dz);
 }
@@ -673,15 +1066,43 @@ void Chunks::resize(uint32_t newW, uint32_t newD) {
 }
 
 bool Chunks::putChunk(const std::shared_ptr<Chunk>& chunk) {
-    return areaMap.set(chunk->x, chunk->z, chunk);
+    if (!areaMap.set(chunk->x, chunk->z, chunk)) {
+        return false;
+    }
+    level->events->trigger(EVT_CHUNK_SHOWN, chunk.get());
+    return true;
 }
 
 // reduce nesting on next modification
 // 25.06.2024: not now
 // 11.11.2024: not now
 void Chunks::getVoxels(VoxelsVolume* volume, bool backlight) const {
-    const Content* content = level->content;
-    auto indices = content->getIndices();
+    getVoxels(
+        volume,
+        backlight,
+        *indices,
+        [this](int32_t x, int32_t z) -> const Chunk* {
+            return getChunk(x, z);
+        }
+    );
+}
+
+/// @brief Brighten light of a light passing voxel for backlight mode
+static inline light_t apply_backlight(light_t light) {
+    return Lightmap::combine(
+        std::min(15, Lightmap::extract(light, 0) + 1),
+        std::min(15, Lightmap::extract(light, 1) + 1),
+        std::min(15, Lightmap::extract(light, 2) + 1),
+        Lightmap::extract(light, 3)
+    );
+}
+
+void Chunks::getVoxels(
+    VoxelsVolume* volume,
+    bool backlight,
+    const ContentIndices& indices,
+    const ChunkGetter& getChunk
+) {
     voxel* voxels = volume->getVoxels();
     light_t* lights = volume->getLights();
     int x = volume->getX();
@@ -695,68 +1116,68 @@ void Chunks::getVoxels(VoxelsVolume* volume, bool backlight) const {
     int scx = floordiv(x, CHUNK_W);
     int scz = floordiv(z, CHUNK_D);
 
-    int ecx = floordiv(x + w, CHUNK_W);
-    int ecz = floordiv(z + d, CHUNK_D);
+    int ecx = floordiv(x + w - 1, CHUNK_W);
+    int ecz = floordiv(z + d - 1, CHUNK_D);
 
-    int cw = ecx - scx + 1;
-    int cd = ecz - scz + 1;
+    const voxel voidVoxel {BLOCK_VOID, {}};
+    const auto& lightPassing = indices.lightPassing;
+    bool airPassing = BLOCK_AIR < lightPassing.size() &&
+                      lightPassing[BLOCK_AIR];
+
+    // every chunk fills its part of the volume with contiguous x-runs
+    for (int cz = scz; cz <= ecz; cz++) {
+        int z0 = std::max(z, cz * CHUNK_D);
+        int z1 = std::min(z + d, (cz + 1) * CHUNK_D);
+        for (int cx = scx; cx <= ecx; cx++) {
+            int x0 = std::max(x, cx * CHUNK_W);
+            int length = std::min(x + w, (cx + 1) * CHUNK_W) - x0;
 
-    // cw*cd chunks will be scanned
-    for (int cz = scz; cz < scz + cd; cz++) {
-        for (int cx = scx; cx < scx + cw; cx++) {
             const auto chunk = getChunk(cx, cz);
-            if (chunk == nullptr) {
-                // no chunk loaded -> filling with BLOCK_VOID
-                for (int ly = y; ly < y + h; ly++) {
-                    for (int lz = std::max(z, cz * CHUNK_D);
-                             lz < std::min(z + d, (cz + 1) * CHUNK_D);
-                             lz++) {
-                        for (int lx = std::max(x, cx * CHUNK_W);
-                                 lx < std::min(x + w, (cx + 1) * CHUNK_W);
-                                 lx++) {
-                            uint idx = vox_index(lx - x, ly - y, lz - z, w, d);
-                            voxels[idx].id = BLOCK_VOID;
-                            lights[idx] = 0;
-                        }
+            std::shared_ptr<const voxel[]> cvoxels;
+            std::shared_ptr<const light_t[]> clights;
+            int bottom = 0;
+            int top = 0;
+            if (chunk) {
+                cvoxels = chunk->voxels.read();
+                clights = chunk->lightmap.read();
+                bottom = chunk->bottom;
+                top = chunk->top;
+            }
+            for (int ly = y; ly < y + h; ly++) {
+                bool inside = chunk && ly >= 0 && ly < CHUNK_H;
+                // voxels out of bottom..top range are air
+                bool airRow = ly < bottom || ly >= top;
+                for (int lz = z0; lz < z1; lz++) {
+                    uint vidx = vox_index(x0 - x, ly - y, lz - z, w, d);
+                    voxel* dstVoxels = voxels + vidx;
+                    light_t* dstLights = lights + vidx;
+                    if (!inside) {
+                        // no chunk loaded -> filling with BLOCK_VOID
+                        std::fill_n(dstVoxels, length, voidVoxel);
+                        std::fill_n(dstLights, length, 0);
+                        continue;
                     }
-                }
-            } else {
-                const voxel* cvoxels = chunk->voxels;
-                const light_t* clights = chunk->lightmap.getLights();
-                for (int ly = y; ly < y + h; ly++) {
-                    for (int lz = std::max(z, cz * CHUNK_D);
-                             lz < std::min(z + d, (cz + 1) * CHUNK_D);
-                             lz++) {
-                        for (int lx = std::max(x, cx * CHUNK_W);
-                                 lx < std::min(x + w, (cx + 1) * CHUNK_W);
-                                 lx++) {
-                            uint vidx = vox_index(lx - x, ly - y, lz - z, w, d);
-                            uint cidx = vox_index(
-                                lx - cx * CHUNK_W,
-                                ly,
-                                lz - cz * CHUNK_D,
-                                CHUNK_W,
-                                CHUNK_D
-                            );
-                            voxels[vidx] = cvoxels[cidx];
-                            light_t light = clights[cidx];
-                            if (backlight) {
-                                const auto block =
-                                    indices->blocks.get(voxels[vidx].id);
-                                if (block && block->lightPassing) {
-                                    light = Lightmap::combine(
-                                        std::min(15,
-                                            Lightmap::extract(light, 0) + 1),
-                                        std::min(15,
-                                            Lightmap::extract(light, 1) + 1),
-                                        std::min(15,
-                                            Lightmap::extract(light, 2) + 1),
-                                        std::min(15, 
-                                            static_cast<int>(Lightmap::extract(light, 3)))
-                                    );
-                                }
+                    uint cidx = vox_index(
+                        x0 - cx * CHUNK_W, ly, lz - cz * CHUNK_D
+                    );
+                    std::copy_n(cvoxels.get() + cidx, length, dstVoxels);
+                    std::copy_n(clights.get() + cidx, length, dstLights);
+                    if (!backlight) {
+                        continue;
+                    }
+                    if (airRow) {
+                        if (airPassing) {
+                            for (int i = 0; i < length; i++) {
+                                dstLights[i] = apply_backlight(dstLights[i]);
                             }
-                            lights[vidx] = light;
+                        }
+                        continue;
+                    }
+                    for (int i = 0; i < length; i++) {
+                        blockid_t id = dstVoxels[i].id;
+                        // void voxels are out of the table
+                        if (id < lightPassing.size() && lightPassing[id]) {
+                            dstLights[i] = apply_backlight(dstLights[i]);
                         }
                     }
                 }
@@ -767,36 +1188,92 @@ void Chunks::getVoxels(VoxelsVolume* volume, bool backlight) const {
 
 void Chunks::saveAndClear() {
     areaMap.clear();
+    if (savePool) {
+        savePool->waitForJobs();
+    }
+}
+
+dv::value Chunks::takeEntities(Chunk& chunk) {
+    AABB aabb(
+        glm::vec3(chunk.x * CHUNK_W, -INFINITY, chunk.z * CHUNK_D),
+        glm::vec3((chunk.x + 1) * CHUNK_W, INFINITY, (chunk.z + 1) * CHUNK_D)
+    );
+    auto entities = level->entities->getAllInside(aabb);
+    // the document keeps the arena alive until encoded
+    dv::ArenaScope arena;
+    auto root = dv::object();
+    root["data"] = level->entities->serialize(entities);
+    bool frozen = level->entities->takeFrozenEntities(
+        chunk.x, chunk.z, root["data"]
+    );
+    if (!entities.empty() || frozen) {
+        chunk.flags.entities = true;
+    }
+    if (!entities.empty()) {
+        level->entities->despawn(std::move(entities));
+    }
+    return chunk.flags.entities ? std::move(root) : dv::value();
+}
+
+std::vector<ubyte> Chunks::encodeEntities(const dv::value& entities) {
+    if (entities == nullptr) {
+        return {};
+    }
+    return json::to_binary(entities, true);
 }
 
 void Chunks::save(Chunk* chunk) {
     if (chunk != nullptr) {
-        AABB aabb(
-            glm::vec3(chunk->x * CHUNK_W, -INFINITY, chunk->z * CHUNK_D),
-            glm::vec3(
-                (chunk->x + 1) * CHUNK_W, INFINITY, (chunk->z + 1) * CHUNK_D
-            )
-        );
-        auto entities = level->entities->getAllInside(aabb);
-        auto root = dv::object();
-        root["data"] = level->entities->serialize(entities);
-        if (!entities.empty()) {
-            level->entities->despawn(std::move(entities));
-            chunk->flags.entities = true;
-        }
-        worldFiles->getRegions().put(
-            chunk,
-            chunk->flags.entities ? json::to_binary(root, true)
-                                  : std::vector<ubyte>()
-        );
+        auto entitiesData = encodeEntities(takeEntities(*chunk));
+        worldFiles->getRegions().put(chunk, std::move(entitiesData));
+    }
+}
+
+void Chunks::saveAsync(const std::shared_ptr<Chunk>& chunk) {
+    if (chunk == nullptr) {
+        return;
+    }
+    auto& regions = worldFiles->getRegions();
+    auto entities = takeEntities(*chunk);
+    if (savePool == nullptr || !regions.isPutNeeded(*chunk)) {
+        regions.put(chunk.get(), encodeEntities(entities));
+        return;
     }
+    if (saving.size() >= MAX_SAVING_CHUNKS) {
+        debug::ProfileZone zone("chunks-save-wait");
+        savePool->waitForJobs();
+    }
+    glm::ivec2 key(chunk->x, chunk->z);
+    chunk->flags.unsaved = false;
+    saving[key] = chunk;
+    savePool->enqueueJob(SaveJob {key, chunk.get(), std::move(entities)});
 }
 
 void Chunks::saveAll() {
     const auto& chunks = areaMap.getBuffer();
     for (size_t i = 0; i < areaMap.area(); i++) {
         if (auto& chunk = chunks[i]) {
-            save(chunk.get());
+            saveAsync(chunk);
         }
     }
+    // chunks are not modified while encoded
+    if (savePool) {
+        savePool->waitForJobs();
+    }
+}
+
+void Chunks::updateSaving() {
+    if (savePool) {
+        savePool->update();
+    }
+}
+
+bool Chunks::isSaving(int32_t x, int32_t z) const {
+    return saving.find(glm::ivec2(x, z)) != saving.end();
+}
+
+void Chunks::waitForSave(int32_t x, int32_t z) {
+    if (isSaving(x, z)) {
+        savePool->waitForJobs();
+    }
 }
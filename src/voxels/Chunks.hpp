@@ -3,10 +3,17 @@
 #include <stdlib.h>
 
 #include <glm/glm.hpp>
+#include <functional>
 #include <memory>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include "constants.hpp"
+#include "data/dv.hpp"
 #include "typedefs.hpp"
 #include "voxel.hpp"
 #include "util/AreaMap2D.hpp"
@@ -23,6 +30,27 @@ class Block;
 class Level;
 class VoxelsVolume;
 
+namespace util {
+    template <class T, class R>
+    class ThreadPool;
+}
+
+/// @brief Ray of a batch raycast
+struct RayCastQuery {
+    glm::vec3 start;
+    glm::vec3 dir;
+    float maxDist;
+};
+
+/// @brief Batch raycast result of a ray
+struct RayCastHit {
+    bool hit = false;
+    blockid_t block = BLOCK_VOID;
+    glm::vec3 end {};
+    glm::ivec3 norm {};
+    glm::ivec3 iend {};
+};
+
 /// Player-centred chunks matrix
 class Chunks {
     Level* level;
@@ -41,7 +69,41 @@ class Chunks {
 
     util::AreaMap2D<std::shared_ptr<Chunk>, int32_t> areaMap;
     WorldFiles* worldFiles;
+
+    /// @brief Positions of blocks changed since the last takeChangedBlocks
+    std::vector<glm::ivec3> changedBlocks;
+    /// @brief More than MAX_CHANGED_BLOCKS blocks changed
+    bool changedBlocksOverflow = false;
+
+    struct RayCastJob;
+    struct RayCastResult;
+    class RayCastWorker;
+    /// @brief Batch raycasts workers (nullptr if single-threaded)
+    std::unique_ptr<util::ThreadPool<RayCastJob, RayCastResult>> rayCastPool;
+
+    struct SaveJob;
+    struct SaveResult;
+    class SaveWorker;
+    /// @brief Unloaded chunks encoding workers (nullptr if single-threaded)
+    std::unique_ptr<util::ThreadPool<SaveJob, SaveResult>> savePool;
+    /// @brief Chunks being encoded by the workers, kept alive until done
+    std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> saving;
+
+    /// @brief Despawn and serialize entities of the chunk (components
+    /// on_save hooks are called here, in the main thread)
+    /// @return entities document or none if the chunk has none.
+    /// Encoded to binary json by encodeEntities, possibly by the workers
+    dv::value takeEntities(Chunk& chunk);
+
+    static std::vector<ubyte> encodeEntities(const dv::value& entities);
+
+    /// @brief Save the chunk by the workers if available. Entities are
+    /// serialized in the calling thread and encoded by the workers
+    void saveAsync(const std::shared_ptr<Chunk>& chunk);
 public:
+    /// @brief Max number of tracked changed blocks positions
+    static constexpr size_t MAX_CHANGED_BLOCKS = 4096;
+
     Chunks(
         int32_t w,
         int32_t d,
@@ -50,11 +112,13 @@ public:
         WorldFiles* worldFiles,
         Level* level
     );
-    ~Chunks() = default;
+    ~Chunks();
 
     bool putChunk(const std::shared_ptr<Chunk>& chunk);
 
     Chunk* getChunk(int32_t x, int32_t z) const;
+    /// @return shared chunk handle or nullptr if chunk is not loaded
+    std::shared_ptr<Chunk> getChunkHandle(int32_t x, int32_t z) const;
     Chunk* getChunkByVoxel(int32_t x, int32_t y, int32_t z) const;
     voxel* get(int32_t x, int32_t y, int32_t z) const;
     voxel& require(int32_t x, int32_t y, int32_t z) const;
@@ -71,6 +135,30 @@ public:
     ubyte getLight(int32_t x, int32_t y, int32_t z, int channel) const;
     void set(int32_t x, int32_t y, int32_t z, uint32_t id, blockstate state);
 
+    /// @brief Track the block change for takeChangedBlocks. Called by
+    /// set and setRotation, other voxels writers must call it themselves
+    void onBlockChanged(int32_t x, int32_t y, int32_t z);
+
+    /// @brief Track replacement of the chunk voxels data. Any block may
+    /// be changed, so changed blocks are not tracked until the next
+    /// takeChangedBlocks
+    void onChunkDataChanged(int32_t cx, int32_t cz);
+
+    /// @brief Add fluid cells of the voxel and its neighbours to the
+    /// chunks fluid cells (see Chunk::fluidCells). Called by set()
+    void activateFluids(int32_t x, int32_t y, int32_t z);
+
+    /// @brief Get voxel indices of the chunk decorative blocks
+    /// (see Block::rt.decorative). Indexed on the first call after the chunk
+    /// voxels bulk change, kept up to date by set()
+    const std::vector<uint>& getDecorations(Chunk& chunk) const;
+
+    /// @brief Count blocks having random update events in the chunk
+    /// (see BlocksProperties::randomUpdate) keeping their voxel indices
+    /// if there are few of them. Indexed if the chunk voxels are changed
+    /// in bulk since the last call, kept up to date by set()
+    void indexRandomTickables(Chunk& chunk) const;
+
     /// @brief Seek for the extended block origin position
     /// @param pos segment block position
     /// @param def segment block definition
@@ -101,9 +189,22 @@ public:
         glm::vec3& end,
         glm::ivec3& norm,
         glm::ivec3& iend,
-        std::set<blockid_t> filter = {}
+        const std::set<blockid_t>& filter = {}
     ) const;
 
+    /// @brief Cast rays batch. Large batches are split between
+    /// worker threads
+    /// @param rays rays array
+    /// @param hits results array of the same size
+    /// @param count number of rays
+    /// @param filter same as rayCast filter
+    void rayCast(
+        const RayCastQuery* rays,
+        RayCastHit* hits,
+        size_t count,
+        const std::set<blockid_t>& filter = {}
+    );
+
     glm::vec3 rayCastToObstacle(
         const glm::vec3& start, const glm::vec3& dir, float maxDist
     ) const;
@@ -120,17 +221,58 @@ public:
 
     void getVoxels(VoxelsVolume* volume, bool backlight = false) const;
 
+    using ChunkGetter = std::function<const Chunk*(int32_t, int32_t)>;
+
+    /// @brief Copy voxels and lights of chunks provided by the getter
+    /// into the volume. Missing chunks are filled with BLOCK_VOID
+    static void getVoxels(
+        VoxelsVolume* volume,
+        bool backlight,
+        const ContentIndices& indices,
+        const ChunkGetter& getChunk
+    );
+
     void setCenter(int32_t x, int32_t z);
     void resize(uint32_t newW, uint32_t newD);
 
+    /// @brief Save all chunks and remove them from the matrix.
+    /// Waits for the chunks encoding to finish
     void saveAndClear();
     void save(Chunk* chunk);
+    /// @brief Save all chunks keeping them loaded.
+    /// Waits for the chunks encoding to finish
     void saveAll();
 
+    /// @brief Release unloaded chunks saved by the workers
+    void updateSaving();
+
+    /// @brief Check if the unloaded chunk is being saved by the workers,
+    /// so its data is not in regions yet
+    bool isSaving(int32_t x, int32_t z) const;
+
+    /// @brief Wait for the unloaded chunk to be saved by the workers
+    void waitForSave(int32_t x, int32_t z);
+
+    /// @brief Get chunks matrix buffer. The matrix is a ring buffer,
+    /// use getIndex and getPosition to map indices to positions
     const std::vector<std::shared_ptr<Chunk>>& getChunks() const {
         return areaMap.getBuffer();
     }
 
+    /// @brief Get getChunks() index of the matrix local position
+    /// @param lx local x in range [0, width)
+    /// @param lz local z in range [0, height)
+    size_t getIndex(int32_t lx, int32_t lz) const {
+        return areaMap.getIndex(lx, lz);
+    }
+
+    /// @brief Get chunk position of the getChunks() index
+    glm::ivec2 getPosition(size_t index) const {
+        int32_t lx, lz;
+        areaMap.getLocalPosition(index, lx, lz);
+        return {lx + areaMap.getOffsetX(), lz + areaMap.getOffsetY()};
+    }
+
     int getWidth() const {
         return areaMap.getWidth();
     }
@@ -154,4 +296,19 @@ public:
     size_t getVolume() const {
         return areaMap.area();
     }
+
+    const ContentIndices* getContentIndices() const {
+        return indices;
+    }
+
+    /// @brief Move positions of blocks changed (set or rotated) since the
+    /// previous call to dst. Used to wake up sleeping physics bodies
+    /// @return false if too many blocks changed to track them all
+    bool takeChangedBlocks(std::vector<glm::ivec3>& dst) {
+        bool overflow = changedBlocksOverflow;
+        dst.clear();
+        std::swap(dst, changedBlocks);
+        changedBlocksOverflow = false;
+        return !overflow;
+    }
 };
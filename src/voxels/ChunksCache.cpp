@@ -0,0 +1,98 @@
+#include "ChunksCache.hpp"
+
+#include "coders/compression.hpp"
+#include "lighting/Lightmap.hpp"
+#include "Chunk.hpp"
+
+static constexpr auto VOXELS_COMPRESSION = compression::Method::EXTRLE16;
+static constexpr auto LIGHTS_COMPRESSION = compression::Method::EXTRLE8;
+
+ChunksCache::ChunksCache(size_t capacity) : capacity(capacity) {
+}
+
+ChunksCache::~ChunksCache() = default;
+
+void ChunksCache::evict(size_t capacity) {
+    while (size > capacity && !entries.empty()) {
+        const auto& entry = entries.back();
+        size -= entry.voxelsSize + entry.lightsSize;
+        map.erase(entry.pos);
+        entries.pop_back();
+    }
+}
+
+void ChunksCache::put(const Chunk& chunk) {
+    remove(chunk.x, chunk.z);
+    if (capacity == 0) {
+        return;
+    }
+    Entry entry {
+        glm::ivec2(chunk.x, chunk.z), nullptr, 0, nullptr, 0, false, false
+    };
+    auto voxels = chunk.encodeTemporary();
+    entry.voxels = compression::compress(
+        voxels.get(), CHUNK_DATA_LEN, entry.voxelsSize, VOXELS_COMPRESSION
+    );
+    if (chunk.flags.lighted) {
+        auto lights = chunk.lightmap.encode();
+        entry.lights = compression::compress(
+            lights.get(), LIGHTMAP_DATA_LEN, entry.lightsSize,
+            LIGHTS_COMPRESSION
+        );
+    }
+    entry.unsaved = chunk.flags.unsaved;
+    entry.generated = chunk.flags.generated;
+
+    size += entry.voxelsSize + entry.lightsSize;
+    entries.push_front(std::move(entry));
+    map[entries.front().pos] = entries.begin();
+    evict(capacity);
+}
+
+bool ChunksCache::restore(Chunk& chunk) {
+    auto found = map.find(glm::ivec2(chunk.x, chunk.z));
+    if (found == map.end()) {
+        misses++;
+        return false;
+    }
+    hits++;
+    const auto& entry = *found->second;
+    auto voxels = compression::decompress(
+        entry.voxels.get(), entry.voxelsSize, CHUNK_DATA_LEN,
+        VOXELS_COMPRESSION
+    );
+    chunk.decode(voxels.get());
+    chunk.flags.loaded = true;
+    chunk.flags.unsaved = entry.unsaved;
+    chunk.flags.generated = entry.generated;
+    if (entry.lights) {
+        auto data = compression::decompress(
+            entry.lights.get(), entry.lightsSize, LIGHTMAP_DATA_LEN,
+            LIGHTS_COMPRESSION
+        );
+        auto lights = Lightmap::decode(data.get());
+        chunk.lightmap.set(lights.get());
+        chunk.flags.loadedLights = true;
+    }
+    remove(chunk.x, chunk.z);
+    return true;
+}
+
+void ChunksCache::remove(int x, int z) {
+    auto found = map.find(glm::ivec2(x, z));
+    if (found == map.end()) {
+        return;
+    }
+    size -= found->second->voxelsSize + found->second->lightsSize;
+    entries.erase(found->second);
+    map.erase(found);
+}
+
+void ChunksCache::setCapacity(size_t capacity) {
+    this->capacity = capacity;
+    evict(capacity);
+}
+
+ChunksCache::Stats ChunksCache::getStats() const {
+    return Stats {entries.size(), size, hits, misses};
+}
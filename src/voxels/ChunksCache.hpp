@@ -0,0 +1,63 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include "typedefs.hpp"
+
+class Chunk;
+
+/// @brief LRU cache of compressed voxels and lights of unloaded chunks.
+/// Lets chunks coming back into the loading area skip region files reading
+/// or generation
+class ChunksCache {
+    struct Entry {
+        glm::ivec2 pos;
+        std::unique_ptr<ubyte[]> voxels;
+        size_t voxelsSize;
+        /// @brief Compressed lightmap or nullptr if the chunk was not lighted
+        std::unique_ptr<ubyte[]> lights;
+        size_t lightsSize;
+        bool unsaved;
+        bool generated;
+    };
+    /// @brief Entries from the most recently used
+    std::list<Entry> entries;
+    std::unordered_map<glm::ivec2, std::list<Entry>::iterator> map;
+    /// @brief Max total size of compressed data in bytes
+    size_t capacity;
+    size_t size = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+
+    void evict(size_t capacity);
+public:
+    struct Stats {
+        size_t entries;
+        size_t bytes;
+        size_t hits;
+        size_t misses;
+    };
+
+    /// @param capacity max total size of compressed data in bytes
+    ChunksCache(size_t capacity);
+    ~ChunksCache();
+
+    /// @brief Compress and store chunk data replacing the previous entry
+    void put(const Chunk& chunk);
+
+    /// @brief Decompress cached data into the chunk and remove the entry
+    /// @return false if the chunk is not cached
+    bool restore(Chunk& chunk);
+
+    void remove(int x, int z);
+
+    /// @brief Set max total size of compressed data in bytes
+    void setCapacity(size_t capacity);
+
+    Stats getStats() const;
+};
@@ -0,0 +1,41 @@
+#include "ChunksSnapshot.hpp"
+
+#include "Chunk.hpp"
+#include "Chunks.hpp"
+#include "VoxelsVolume.hpp"
+
+ChunksSnapshot::ChunksSnapshot() : indices(nullptr), x(0), z(0), size(0) {
+}
+
+ChunksSnapshot::ChunksSnapshot(
+    const Chunks& chunks, int32_t centerX, int32_t centerZ, int radius
+)
+    : indices(chunks.getContentIndices()),
+      x(centerX - radius),
+      z(centerZ - radius),
+      size(radius * 2 + 1) {
+    this->chunks.reserve(size * size);
+    for (int32_t lz = 0; lz < size; lz++) {
+        for (int32_t lx = 0; lx < size; lx++) {
+            this->chunks.push_back(chunks.getChunkHandle(x + lx, z + lz));
+        }
+    }
+}
+
+const Chunk* ChunksSnapshot::getChunk(int32_t x, int32_t z) const {
+    int32_t lx = x - this->x;
+    int32_t lz = z - this->z;
+    if (lx < 0 || lz < 0 || lx >= size || lz >= size) {
+        return nullptr;
+    }
+    return chunks[lz * size + lx].get();
+}
+
+void ChunksSnapshot::getVoxels(VoxelsVolume* volume, bool backlight) const {
+    Chunks::getVoxels(
+        volume,
+        backlight,
+        *indices,
+        [this](int32_t x, int32_t z) { return getChunk(x, z); }
+    );
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "typedefs.hpp"
+
+class Chunk;
+class Chunks;
+class ContentIndices;
+class VoxelsVolume;
+
+/// @brief Handles of chunks in a square area captured from the Chunks
+/// matrix on the main thread. Captured chunks are kept alive, so worker
+/// threads may read neighbour voxels while the matrix is being modified
+/// (setCenter, putChunk, resize)
+class ChunksSnapshot {
+    const ContentIndices* indices;
+    int32_t x;
+    int32_t z;
+    int32_t size;
+    std::vector<std::shared_ptr<const Chunk>> chunks;
+public:
+    ChunksSnapshot();
+
+    /// @brief Capture chunks around the center chunk. Main thread only
+    /// @param radius area radius in chunks (0 - center chunk only)
+    ChunksSnapshot(
+        const Chunks& chunks, int32_t centerX, int32_t centerZ, int radius
+    );
+
+    /// @return captured chunk or nullptr if the chunk was not loaded or is
+    /// out of the area
+    const Chunk* getChunk(int32_t x, int32_t z) const;
+
+    /// @brief Same as Chunks::getVoxels using captured chunks only
+    void getVoxels(VoxelsVolume* volume, bool backlight = false) const;
+};
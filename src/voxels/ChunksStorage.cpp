@@ -9,15 +9,30 @@
 #include "lighting/Lightmap.hpp"
 #include "maths/voxmaths.hpp"
 #include "objects/Entities.hpp"
+#include "settings.hpp"
 #include "typedefs.hpp"
 #include "world/Level.hpp"
 #include "world/World.hpp"
 #include "Block.hpp"
 #include "Chunk.hpp"
+#include "Chunks.hpp"
 
 static debug::Logger logger("chunks-storage");
 
-ChunksStorage::ChunksStorage(Level* level) : level(level) {
+/// @brief Max number of unloaded chunks kept for reuse
+static constexpr size_t MAX_POOLED_CHUNKS = 64;
+
+ChunksStorage::ChunksStorage(Level* level)
+    : level(level),
+      pool(MAX_POOLED_CHUNKS),
+      cache(0),
+      memorySource([this](debug::MemoryBreakdown& breakdown) {
+          auto stats = getMemoryStats();
+          breakdown["chunks.voxels"] += stats.voxels;
+          breakdown["chunks.lightmaps"] += stats.lightmaps;
+          breakdown["chunks.pool"] += stats.pooled;
+          breakdown["chunks.cache"] += stats.cached;
+      }) {
 }
 
 void ChunksStorage::store(const std::shared_ptr<Chunk>& chunk) {
@@ -34,9 +49,37 @@ std::shared_ptr<Chunk> ChunksStorage::get(int x, int z) const {
 
 void ChunksStorage::remove(int x, int z) {
     auto found = chunksMap.find(glm::ivec2(x, z));
-    if (found != chunksMap.end()) {
-        chunksMap.erase(found->first);
+    if (found == chunksMap.end()) {
+        return;
     }
+    const auto& chunk = *found->second;
+    auto& regions = level->getWorld()->wfile->getRegions();
+    // saved chunks data is kept by in-memory regions already
+    if (chunk.flags.loaded && !level->chunks->isSaving(x, z) &&
+        !regions.isChunkInMemory(x, z)) {
+        cache.setCapacity(
+            static_cast<size_t>(level->settings.chunks.cacheSize.get()) << 20
+        );
+        cache.put(chunk);
+    }
+    chunksMap.erase(found);
+}
+
+ChunksMemoryStats ChunksStorage::getMemoryStats() const {
+    ChunksMemoryStats stats {};
+    for (const auto& [_, chunk] : chunksMap) {
+        stats.voxels += chunk->voxels.getMemoryUsage();
+        stats.lightmaps += chunk->lightmap.getMemoryUsage();
+    }
+    stats.pooled =
+        pool.getStats().free *
+        (sizeof(Chunk) + CHUNK_VOL * (sizeof(voxel) + sizeof(light_t)));
+    stats.cached = cache.getStats().bytes;
+    return stats;
+}
+
+void ChunksStorage::trimPool() {
+    pool.trim();
 }
 
 static void check_voxels(const ContentIndices& indices, Chunk* chunk) {
@@ -55,15 +98,21 @@ static void check_voxels(const ContentIndices& indices, Chunk* chunk) {
 std::shared_ptr<Chunk> ChunksStorage::create(int x, int z) {
     World* world = level->getWorld();
     auto& regions = world->wfile.get()->getRegions();
+    // previous data of the chunk unloaded recently may be not written yet
+    level->chunks->waitForSave(x, z);
 
-    auto chunk = std::make_shared<Chunk>(x, z);
+    auto chunk = pool.get(x, z);
     store(chunk);
-    if (auto data = regions.getVoxels(chunk->x, chunk->z)) {
-        const auto& indices = *level->content->getIndices();
-
-        chunk->decode(data.get());
-        check_voxels(indices, chunk.get());
-
+    const auto& indices = *level->content->getIndices();
+    bool cached = cache.restore(*chunk);
+    if (!cached) {
+        if (auto data = regions.getVoxels(chunk->x, chunk->z)) {
+            chunk->decode(data.get());
+            check_voxels(indices, chunk.get());
+            chunk->flags.loaded = true;
+        }
+    }
+    if (chunk->flags.loaded) {
         auto invs = regions.fetchInventories(chunk->x, chunk->z);
         auto iterator = invs.begin();
         while (iterator != invs.end()) {
@@ -81,21 +130,22 @@ std::shared_ptr<Chunk> ChunksStorage::create(int x, int z) {
         }
         chunk->setBlockInventories(std::move(invs));
 
-        auto entitiesData = regions.fetchEntities(chunk->x, chunk->z);
-        if (entitiesData.getType() == dv::value_type::object) {
-            level->entities->loadEntities(std::move(entitiesData));
-            chunk->flags.entities = true;
-        }
+        // entities are decoded in background and spawned when players
+        // are near
+        level->entities->loadChunkEntities(chunk->x, chunk->z);
 
-        chunk->flags.loaded = true;
         for (auto& entry : chunk->inventories) {
             level->inventories->store(entry.second);
         }
     }
-    if (auto lights = regions.getLights(chunk->x, chunk->z)) {
-        chunk->lightmap.set(lights.get());
-        chunk->flags.loadedLights = true;
+    if (!cached) {
+        if (auto lights = regions.getLights(*chunk)) {
+            chunk->lightmap.set(lights.get());
+            chunk->flags.loadedLights = true;
+        }
     }
     chunk->blocksMetadata = regions.getBlocksData(chunk->x, chunk->z);
+    chunk->scheduledUpdates =
+        regions.getScheduledUpdates(chunk->x, chunk->z);
     return chunk;
 }
@@ -4,6 +4,9 @@
 #include <unordered_map>
 
 #include "typedefs.hpp"
+#include "debug/MemoryUsage.hpp"
+#include "util/ObjectPool.hpp"
+#include "ChunksCache.hpp"
 #include "voxel.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -12,9 +15,29 @@
 class Chunk;
 class Level;
 
+struct ChunksMemoryStats {
+    /// @brief Voxels of loaded chunks in bytes
+    size_t voxels = 0;
+    /// @brief Lightmaps of loaded chunks in bytes
+    size_t lightmaps = 0;
+    /// @brief Unused chunks kept in the pool in bytes
+    size_t pooled = 0;
+    /// @brief Compressed chunks cache in bytes
+    size_t cached = 0;
+
+    size_t total() const {
+        return voxels + lightmaps + pooled + cached;
+    }
+};
+
 class ChunksStorage {
     Level* level;
     std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> chunksMap;
+    /// @brief Unloaded chunks kept for reuse
+    util::ObjectPool<Chunk> pool;
+    /// @brief Compressed data of unloaded chunks not kept by regions
+    ChunksCache cache;
+    debug::MemorySource memorySource;
 public:
     ChunksStorage(Level* level);
     ~ChunksStorage() = default;
@@ -23,4 +46,22 @@ public:
     void store(const std::shared_ptr<Chunk>& chunk);
     void remove(int x, int y);
     std::shared_ptr<Chunk> create(int x, int z);
+
+    util::ObjectPool<Chunk>::Stats getPoolStats() const {
+        return pool.getStats();
+    }
+
+    ChunksCache& getCache() {
+        return cache;
+    }
+
+    const ChunksCache& getCache() const {
+        return cache;
+    }
+
+    /// @brief Delete unused chunks kept in the pool
+    void trimPool();
+
+    /// @brief Calculate memory used by stored and pooled chunks
+    ChunksMemoryStats getMemoryStats() const;
 };
@@ -0,0 +1,106 @@
+#include "PackedVoxels.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+static inline uint32_t voxel2int(const voxel& vox) {
+    return static_cast<uint32_t>(vox.id) |
+           static_cast<uint32_t>(blockstate2int(vox.state)) << 16;
+}
+
+/// @brief Get bits per index required for the palette size.
+/// Indices never cross 64 bit words boundaries, so power of two is used
+static uint8_t calc_index_bits(size_t paletteSize) {
+    if (paletteSize <= 1) {
+        return 0;
+    }
+    uint8_t bits = 1;
+    while ((1ULL << bits) < paletteSize) {
+        bits <<= 1;
+    }
+    return bits;
+}
+
+PackedVoxels::PackedVoxels(const voxel* voxels) {
+    std::vector<uint16_t> indices(CHUNK_SECTION_VOL);
+    std::unordered_map<uint32_t, uint16_t> paletteMap;
+    for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        auto& section = sections[s];
+        const voxel* src = voxels + s * CHUNK_SECTION_VOL;
+        paletteMap.clear();
+
+        uint32_t prevKey = voxel2int(src[0]);
+        uint16_t prevIndex = 0;
+        section.palette.push_back(src[0]);
+        paletteMap[prevKey] = 0;
+        for (uint i = 0; i < CHUNK_SECTION_VOL; i++) {
+            uint32_t key = voxel2int(src[i]);
+            // neighbour voxels are the same in most cases
+            if (key != prevKey) {
+                auto found = paletteMap.find(key);
+                if (found == paletteMap.end()) {
+                    prevIndex = section.palette.size();
+                    paletteMap[key] = prevIndex;
+                    section.palette.push_back(src[i]);
+                } else {
+                    prevIndex = found->second;
+                }
+                prevKey = key;
+            }
+            indices[i] = prevIndex;
+        }
+        section.bits = calc_index_bits(section.palette.size());
+        section.palette.shrink_to_fit();
+        if (section.bits == 0) {
+            continue;
+        }
+        uint perWord = 64 / section.bits;
+        section.indices.resize((CHUNK_SECTION_VOL + perWord - 1) / perWord);
+        for (uint i = 0; i < CHUNK_SECTION_VOL; i++) {
+            section.indices[i / perWord] |= static_cast<uint64_t>(indices[i])
+                                            << ((i % perWord) * section.bits);
+        }
+    }
+}
+
+void PackedVoxels::unpack(voxel* dst) const {
+    for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        const auto& section = sections[s];
+        voxel* out = dst + s * CHUNK_SECTION_VOL;
+        if (section.bits == 0) {
+            std::fill_n(out, CHUNK_SECTION_VOL, section.palette[0]);
+            continue;
+        }
+        uint bits = section.bits;
+        uint perWord = 64 / bits;
+        uint64_t mask = (1ULL << bits) - 1;
+        uint i = 0;
+        for (uint64_t word : section.indices) {
+            for (uint j = 0; j < perWord && i < CHUNK_SECTION_VOL; j++, i++) {
+                out[i] = section.palette[word & mask];
+                word >>= bits;
+            }
+        }
+    }
+}
+
+voxel PackedVoxels::get(uint index) const {
+    const auto& section = sections[index / CHUNK_SECTION_VOL];
+    if (section.bits == 0) {
+        return section.palette[0];
+    }
+    index %= CHUNK_SECTION_VOL;
+    uint perWord = 64 / section.bits;
+    uint64_t word = section.indices[index / perWord];
+    uint64_t mask = (1ULL << section.bits) - 1;
+    return section.palette[(word >> ((index % perWord) * section.bits)) & mask];
+}
+
+size_t PackedVoxels::getMemoryUsage() const {
+    size_t size = sizeof(PackedVoxels);
+    for (const auto& section : sections) {
+        size += section.palette.capacity() * sizeof(voxel);
+        size += section.indices.capacity() * sizeof(uint64_t);
+    }
+    return size;
+}
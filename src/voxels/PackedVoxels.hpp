@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "constants.hpp"
+#include "voxel.hpp"
+
+/// @brief Chunk voxels stored as bit-packed indices into per-section
+/// palettes. Uniform sections take no space besides the palette
+class PackedVoxels {
+    struct Section {
+        std::vector<voxel> palette;
+        /// @brief Bits per palette index (0 if section is uniform)
+        uint8_t bits = 0;
+        std::vector<uint64_t> indices;
+    };
+    std::array<Section, CHUNK_SECTIONS> sections;
+public:
+    /// @param voxels source voxels array of CHUNK_VOL length
+    PackedVoxels(const voxel* voxels);
+
+    /// @brief Write voxels to array of CHUNK_VOL length
+    void unpack(voxel* dst) const;
+
+    /// @param index voxel index in chunk
+    voxel get(uint index) const;
+
+    /// @brief Check if section contains same voxels only
+    bool isUniform(uint section) const {
+        return sections[section].bits == 0;
+    }
+
+    /// @brief Get approximate heap memory used in bytes
+    size_t getMemoryUsage() const;
+};
@@ -10,6 +10,7 @@
 #include "debug/Logger.hpp"
 #include "graphics/core/ImageData.hpp"
 #include "graphics/core/Texture.hpp"
+#include "graphics/core/TextureArray.hpp"
 #include "settings.hpp"
 #include "util/ObjectsKeeper.hpp"
 #include "Events.hpp"
@@ -189,6 +190,11 @@ int Window::initialize(DisplaySettings* settings) {
         Texture::MAX_RESOLUTION = maxTextureSize[0];
         logger.info() << "max texture size is " << Texture::MAX_RESOLUTION;
     }
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (maxLayers > 0) {
+        TextureArray::MAX_LAYERS = maxLayers;
+    }
 
     glfwSetKeyCallback(window, key_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
@@ -252,6 +258,19 @@ void Window::resetScissor() {
     glDisable(GL_SCISSOR_TEST);
 }
 
+static void set_gl_scissor(const glm::vec4& area, uint height) {
+    if (area.z < 0.0f || area.w < 0.0f) {
+        glScissor(0, 0, 0, 0);
+    } else {
+        glScissor(
+            area.x,
+            height - area.w,
+            std::max(0, static_cast<int>(glm::ceil(area.z - area.x))),
+            std::max(0, static_cast<int>(glm::ceil(area.w - area.y)))
+        );
+    }
+}
+
 void Window::pushScissor(glm::vec4 area) {
     if (scissorStack.empty()) {
         glEnable(GL_SCISSOR_TEST);
@@ -267,16 +286,7 @@ void Window::pushScissor(glm::vec4 area) {
     area.z = glm::min(area.z, scissorArea.z);
     area.w = glm::min(area.w, scissorArea.w);
 
-    if (area.z < 0.0f || area.w < 0.0f) {
-        glScissor(0, 0, 0, 0);
-    } else {
-        glScissor(
-            area.x,
-            Window::height - area.w,
-            std::max(0, static_cast<int>(glm::ceil(area.z - area.x))),
-            std::max(0, static_cast<int>(glm::ceil(area.w - area.y)))
-        );
-    }
+    set_gl_scissor(area, Window::height);
     scissorArea = area;
 }
 
@@ -287,22 +297,22 @@ void Window::popScissor() {
     }
     glm::vec4 area = scissorStack.top();
     scissorStack.pop();
-    if (area.z < 0.0f || area.w < 0.0f) {
-        glScissor(0, 0, 0, 0);
-    } else {
-        glScissor(
-            area.x,
-            Window::height - area.w,
-            std::max(0, int(area.z - area.x)),
-            std::max(0, int(area.w - area.y))
-        );
-    }
+    set_gl_scissor(area, Window::height);
     if (scissorStack.empty()) {
         glDisable(GL_SCISSOR_TEST);
     }
     scissorArea = area;
 }
 
+void Window::applyScissor(bool enabled, const glm::vec4& area) {
+    if (!enabled) {
+        glDisable(GL_SCISSOR_TEST);
+        return;
+    }
+    glEnable(GL_SCISSOR_TEST);
+    set_gl_scissor(area, Window::height);
+}
+
 void Window::terminate() {
     observers_keeper = util::ObjectsKeeper();
     glfwTerminate();
@@ -46,6 +46,21 @@ public:
     static void popScissor();
     static void resetScissor();
 
+    /// @brief Set GL scissor state without modifying the scissors stack.
+    /// Used by batches deferring draws to restore scissor of recorded
+    /// commands
+    /// @param enabled is scissor test enabled
+    /// @param area scissor area in the scissors stack format
+    static void applyScissor(bool enabled, const glm::vec4& area);
+
+    static bool isScissorEnabled() {
+        return !scissorStack.empty();
+    }
+
+    static const glm::vec4& getScissorArea() {
+        return scissorArea;
+    }
+
     static void clear();
     static void clearDepth();
     static void setBgColor(glm::vec3 color);
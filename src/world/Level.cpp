@@ -2,6 +2,7 @@
 
 #include "content/Content.hpp"
 #include "data/dv_util.hpp"
+#include "files/WorldFiles.hpp"
 #include "items/Inventories.hpp"
 #include "items/Inventory.hpp"
 #include "lighting/Lighting.hpp"
@@ -61,6 +62,9 @@ Level::Level(
         matrixSize, matrixSize, 0, 0, world->wfile.get(), this
     );
     lighting = std::make_unique<Lighting>(content, chunks.get());
+    // cached lights are invalid if blocks light passing changed
+    world->wfile->getRegions().lightsFingerprint =
+        content->getIndices()->lightsFingerprint;
 
     events->listen(EVT_CHUNK_HIDDEN, [this](lvl_event_type, Chunk* chunk) {
         this->chunksStorage->remove(chunk->x, chunk->z);
@@ -73,11 +77,7 @@ Level::~Level() = default;
 
 void Level::loadMatrix(int32_t x, int32_t z, uint32_t radius) {
     chunks->setCenter(x, z);
-    uint32_t diameter = std::min(
-        radius * 2LL,
-        (settings.chunks.loadDistance.get() + settings.chunks.padding.get()) *
-            2LL
-    );
+    uint32_t diameter = radius * 2;
     if (chunks->getWidth() != diameter) {
         chunks->resize(diameter, diameter);
     }
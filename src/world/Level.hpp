@@ -46,6 +46,10 @@ public:
     );
     ~Level();
 
+    /// @brief Move and resize the chunks matrix
+    /// @param x matrix center x (blocks)
+    /// @param z matrix center z (blocks)
+    /// @param radius matrix half size (chunks)
     void loadMatrix(int32_t x, int32_t z, uint32_t radius);
 
     World* getWorld();
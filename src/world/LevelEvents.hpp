@@ -7,6 +7,7 @@
 class Chunk;
 
 enum lvl_event_type {
+    EVT_CHUNK_SHOWN,
     EVT_CHUNK_HIDDEN,
 };
 
@@ -64,11 +64,11 @@ void World::writeResources(const Content* content) {
     files::write_json(wfile->getResourcesFile(), root);
 }
 
-void World::write(Level* level) {
+void World::write(Level* level, bool background) {
     const Content* content = level->content;
     level->chunks->saveAll();
     info.nextEntityId = level->entities->peekNextID();
-    wfile->write(this, content);
+    wfile->write(this, content, background);
 
     auto playerFile = level->players->serialize();
     files::write_json(wfile->getPlayerFile(), playerFile);
@@ -116,6 +116,13 @@ std::unique_ptr<Level> World::load(
     logger.info() << "world version: " << info->major << "." << info->minor
                   << " seed: " << info->seed
                   << " generator: " << info->generator;
+    if (info->chunkHeight != CHUNK_H) {
+        throw world_load_error(
+            "world chunk height " + std::to_string(info->chunkHeight) +
+            " does not match the engine chunk height " +
+            std::to_string(CHUNK_H)
+        );
+    }
 
     auto world = std::make_unique<World>(
         info.value(), std::move(worldFilesPtr), content, packs
@@ -200,6 +207,7 @@ void WorldInfo::deserialize(const dv::value& root) {
         daytime = timeobj["day-time"].asNumber();
         daytimeSpeed = timeobj["day-time-speed"].asNumber();
         totalTime = timeobj["total-time"].asNumber();
+        blocksTick = timeobj["blocks-tick"].asInteger(0);
     }
     if (root.has("weather")) {
         fog = root["weather"]["fog"].asNumber();
@@ -207,6 +215,7 @@ void WorldInfo::deserialize(const dv::value& root) {
     nextInventoryId = root["next-inventory-id"].asInteger(2);
     nextEntityId = root["next-entity-id"].asInteger(1);
     root.at("next-player-id").get(nextPlayerId);
+    chunkHeight = root["chunk-height"].asInteger(256);
 }
 
 dv::value WorldInfo::serialize() const {
@@ -224,6 +233,7 @@ dv::value WorldInfo::serialize() const {
     timeobj["day-time"] = daytime;
     timeobj["day-time-speed"] = daytimeSpeed;
     timeobj["total-time"] = totalTime;
+    timeobj["blocks-tick"] = static_cast<int64_t>(blocksTick);
 
     auto& weatherobj = root.object("weather");
     weatherobj["fog"] = fog;
@@ -231,5 +241,6 @@ dv::value WorldInfo::serialize() const {
     root["next-inventory-id"] = nextInventoryId;
     root["next-entity-id"] = nextEntityId;
     root["next-player-id"] = nextPlayerId;
+    root["chunk-height"] = chunkHeight;
     return root;
 }
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "constants.hpp"
 #include "content/ContentPack.hpp"
 #include "interfaces/Serializable.hpp"
 #include "typedefs.hpp"
@@ -41,11 +42,19 @@ struct WorldInfo : public Serializable {
     /// @brief total time passed in the world (not depending on daytimeSpeed)
     double totalTime = 0.0;
 
+    /// @brief Number of world ticks passed, time base of scheduled block
+    /// updates (see BlocksController::scheduleUpdate)
+    uint64_t blocksTick = 0;
+
     /// @brief will be replaced with weather in future
     float fog = 0.0f;
 
     entityid_t nextEntityId = 0;
 
+    /// @brief Chunk height the world is created with. Must match
+    /// the build CHUNK_H (worlds created before the option are 256)
+    int chunkHeight = CHUNK_H;
+
     int major = 0, minor = -1;
 
     dv::value serialize() const override;
@@ -77,7 +86,8 @@ public:
     void updateTimers(float delta);
 
     /// @brief Write all unsaved level data to the world directory
-    void write(Level* level);
+    /// @param background write regions in the regions writer thread
+    void write(Level* level, bool background = false);
 
     /// @brief Check world indices and generate ContentReport if convert required
     /// @param directory world directory
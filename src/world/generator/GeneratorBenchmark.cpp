@@ -0,0 +1,88 @@
+#include "GeneratorBenchmark.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+#include "GeneratorDef.hpp"
+#include "WorldGenerator.hpp"
+#include "constants.hpp"
+#include "debug/Logger.hpp"
+#include "util/timeutil.hpp"
+
+static debug::Logger logger("generator-benchmark");
+
+static uint64_t hash_voxels(const voxel* voxels) {
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    const auto bytes = reinterpret_cast<const ubyte*>(voxels);
+    for (size_t i = 0; i < CHUNK_VOL * sizeof(voxel); i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/// @brief Generate the area chunks
+/// @param reverse generate chunks in reverse order
+/// @param hashes chunks hashes in row-major order
+static void generate_area(
+    WorldGenerator& generator,
+    int size,
+    bool reverse,
+    std::vector<uint64_t>& hashes
+) {
+    int offset = -size / 2;
+    // generator area covers the square with prototype levels padding
+    generator.update(0, 0, size);
+
+    std::vector<voxel> voxels(CHUNK_VOL);
+    hashes.resize(size * size);
+    for (int i = 0; i < size * size; i++) {
+        int index = reverse ? size * size - i - 1 : i;
+        int x = offset + index % size;
+        int z = offset + index / size;
+        auto prototype = generator.prepare(x, z);
+        generator.generate(voxels.data(), x, z, *prototype);
+        hashes[index] = hash_voxels(voxels.data());
+    }
+}
+
+GeneratorBenchmarkResult benchmark_generator(
+    const GeneratorDef& def, const Content& content, uint64_t seed, int size
+) {
+    if (size <= 0) {
+        throw std::invalid_argument("area size must be positive");
+    }
+    GeneratorBenchmarkResult result {};
+    std::vector<uint64_t> hashes;
+    {
+        timeutil::Timer timer;
+        WorldGenerator generator(def, &content, seed);
+        generate_area(generator, size, false, hashes);
+        result.time = timer.stop();
+
+        const auto& stats = generator.getStats();
+        for (size_t i = 0; i < result.stages.size(); i++) {
+            result.stages[i] = stats.stages[i];
+        }
+        result.land = stats.land;
+        result.placements = stats.placements;
+        result.plants = stats.plants;
+        result.chunks = stats.chunks;
+    }
+    std::vector<uint64_t> reverseHashes;
+    {
+        WorldGenerator generator(def, &content, seed);
+        generate_area(generator, size, true, reverseHashes);
+    }
+    result.hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < hashes.size(); i++) {
+        result.hash = (result.hash ^ hashes[i]) * 0x100000001B3ULL;
+        if (hashes[i] != reverseHashes[i]) {
+            result.mismatches++;
+        }
+    }
+    logger.info() << "generated " << result.chunks << " chunks of "
+                  << def.name << " in " << result.time / 1000 << " ms, "
+                  << result.mismatches << " mismatches";
+    return result;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+
+#include "typedefs.hpp"
+
+class Content;
+struct GeneratorDef;
+
+/// @brief World generator benchmark results. Times are in microseconds
+struct GeneratorBenchmarkResult {
+    /// @brief Number of chunks generated in each pass
+    uint chunks = 0;
+    /// @brief Total time of the first pass
+    int64_t time = 0;
+    /// @brief Prototype stages time indexed by ChunkPrototypeLevel
+    std::array<int64_t, 5> stages {};
+    int64_t land = 0;
+    int64_t placements = 0;
+    int64_t plants = 0;
+    /// @brief Hash of all generated chunks voxels
+    uint64_t hash = 0;
+    /// @brief Number of chunks generated differently by the second pass
+    uint mismatches = 0;
+};
+
+/// @brief Generate a square area of chunks twice with new generator
+/// instances: row by row and in reverse order. Chunks generated
+/// differently mean the generator depends on the generation order or
+/// on something but the seed and coordinates.
+/// Does not affect generators of the open world.
+/// @param def generator definition
+/// @param content content the generator is prepared for
+/// @param seed world seed
+/// @param size area width and depth in chunks
+/// @return first pass timings, output hash and second pass mismatches
+GeneratorBenchmarkResult benchmark_generator(
+    const GeneratorDef& def, const Content& content, uint64_t seed, int size
+);
@@ -10,11 +10,21 @@ VoxelStructure::VoxelStructure(
     std::unique_ptr<VoxelFragment> structure
 ) : fragments({std::move(structure)}), meta(std::move(meta)) {}
 
+void VoxelStructure::prepare(const Content& content) {
+    fragments[0]->prepare(content);
+    for (size_t i = 1; i < fragments.size(); i++) {
+        fragments[i] = fragments[i - 1]->rotated(content);
+    }
+}
+
 GeneratorDef::GeneratorDef(std::string name)
     : name(std::move(name)), caption(util::id_to_caption(name)) {
 }
 
 void GeneratorDef::prepare(const Content* content) {
+    for (auto& structure : structures) {
+        structure->prepare(*content);
+    }
     for (auto& biome : biomes) {
         for (auto& layer : biome.groundLayers.layers) {
             layer.rt.id = content->blocks.require(layer.block).rt.id;
@@ -141,6 +141,21 @@ public:
         const std::vector<std::shared_ptr<Heightmap>>& inputs
     ) = 0;
 
+    /// @brief Generate a heightmap covering an area of multiple chunks
+    /// (tile) at once. Arguments are the same as in generateHeightmap
+    /// @return generated heightmap or nullptr if not supported by the
+    /// script, then heightmaps are generated per chunk
+    virtual std::shared_ptr<Heightmap> generateHeightmapTile(
+        const glm::ivec2& offset,
+        const glm::ivec2& size,
+        uint bpd,
+        const std::vector<std::shared_ptr<Heightmap>>& inputs
+    ) = 0;
+
+    /// @brief Check if the script generates heightmap tiles, tiled jobs
+    /// are not created otherwise
+    virtual bool hasHeightmapTile() = 0;
+
     /// @brief Generate a biomes parameters maps
     /// @param offset position of maps in the world
     /// @param size maps size
@@ -177,6 +192,12 @@ public:
         const std::shared_ptr<Heightmap>& heightmap,
         uint chunkHeight
     ) = 0;
+
+    /// @brief Create an independent instance of the script with its own
+    /// interpreter state to be used from another thread. The instance is
+    /// loaded from the same file and initialized with the same seed if
+    /// this script is initialized. May be called from any thread
+    virtual std::unique_ptr<GeneratorScript> fork() const = 0;
 };
 
 /// @brief Structure voxel fragments and metadata
@@ -189,6 +210,9 @@ struct VoxelStructure {
         VoxelStructureMeta meta,
         std::unique_ptr<VoxelFragment> structure
     );
+
+    /// @brief Build runtime voxels of the fragment and its rotated versions
+    void prepare(const Content& content);
 };
 
 /// @brief Generator information
@@ -14,6 +14,16 @@ SurroundMap::SurroundMap(int maxLevelRadius, int8_t maxLevel)
 void SurroundMap::setLevelCallback(int8_t level, LevelCallback callback) {
     auto& wrapper = levelCallbacks.at(level - 1);
     wrapper.callback = callback;
+    wrapper.batchCallback = nullptr;
+    wrapper.active = callback != nullptr;
+}
+
+void SurroundMap::setLevelBatchCallback(
+    int8_t level, LevelBatchCallback callback
+) {
+    auto& wrapper = levelCallbacks.at(level - 1);
+    wrapper.callback = nullptr;
+    wrapper.batchCallback = callback;
     wrapper.active = callback != nullptr;
 }
 
@@ -21,7 +31,9 @@ void SurroundMap::setOutCallback(util::AreaMap2D<int8_t>::OutCallback callback)
     areaMap.setOutCallback(callback);
 }
 
-void SurroundMap::upgrade(int x, int y, int8_t level) {
+void SurroundMap::upgrade(
+    int x, int y, int8_t level, std::vector<glm::ivec2>& upgraded
+) {
     auto& callback = levelCallbacks[level - 1];
     int size = maxLevel - level + 1;
     for (int ly = -size+1; ly < size; ly++) {
@@ -36,8 +48,10 @@ void SurroundMap::upgrade(int x, int y, int8_t level) {
                 continue;
             }
             areaMap.set(posX, posY, level);
-            if (callback.active) {
+            if (callback.callback) {
                 callback.callback(posX, posY);
+            } else if (callback.batchCallback) {
+                upgraded.emplace_back(posX, posY);
             }
         }
     }
@@ -54,8 +68,13 @@ void SurroundMap::completeAt(int x, int y) {
         throw std::invalid_argument(
             "upgrade square is not fully inside of area");
     }
+    std::vector<glm::ivec2> upgraded;
     for (int8_t level = 1; level <= maxLevel; level++) {
-        upgrade(x, y, level);
+        upgrade(x, y, level, upgraded);
+        if (!upgraded.empty()) {
+            levelCallbacks[level - 1].batchCallback(upgraded);
+            upgraded.clear();
+        }
     }
 }
 
@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <functional>
+#include <vector>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
@@ -12,8 +13,11 @@
 class SurroundMap {
 public:
     using LevelCallback = std::function<void(int, int)>;
+    using LevelBatchCallback =
+        std::function<void(const std::vector<glm::ivec2>&)>;
     struct LevelCallbackWrapper {
         LevelCallback callback;
+        LevelBatchCallback batchCallback;
         bool active = false;
     };
 private:
@@ -21,13 +25,20 @@ private:
     std::vector<LevelCallbackWrapper> levelCallbacks;
     int8_t maxLevel;
 
-    void upgrade(int x, int y, int8_t level);
+    void upgrade(
+        int x, int y, int8_t level, std::vector<glm::ivec2>& upgraded
+    );
 public:
     SurroundMap(int maxLevelRadius, int8_t maxLevel);
 
     /// @brief Callback called on point level increments
     void setLevelCallback(int8_t level, LevelCallback callback);
 
+    /// @brief Callback called once per level for all points upgraded
+    /// to the level by a completeAt call. Points of a batch depend on
+    /// lower levels only, so they may be processed independently
+    void setLevelBatchCallback(int8_t level, LevelBatchCallback callback);
+
     /// @brief Callback called when non-zero value moves out of area
     void setOutCallback(util::AreaMap2D<int8_t>::OutCallback callback);   
     
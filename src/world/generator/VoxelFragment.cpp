@@ -32,11 +32,13 @@ std::unique_ptr<VoxelFragment> VoxelFragment::create(
 
         auto min = end;
         auto max = start;
-        
+
+        const voxel* volVoxels = volume.getVoxels();
+        size_t index = 0;
         for (int y = start.y; y < end.y; y++) {
             for (int z = start.z; z < end.z; z++) {
-                for (int x = start.x; x < end.x; x++) {
-                    if (volume.pickBlockId(x, y, z)) {
+                for (int x = start.x; x < end.x; x++, index++) {
+                    if (volVoxels[index].id) {
                         min = glm::min(min, {x, y, z});
                         max = glm::max(max, {x+1, y+1, z+1});
                     }
@@ -156,6 +158,10 @@ void VoxelFragment::crop() {
         }
         voxels = std::move(newVoxels);
         size = newSize;
+        // runtime data of the previous size is not valid anymore
+        voxelsRuntime.clear();
+        runs.clear();
+        rowRuns.clear();
     }
 }
 
@@ -167,6 +173,26 @@ void VoxelFragment::prepare(const Content& content) {
         voxelsRuntime[i].id = content.blocks.require(name).rt.id;
         voxelsRuntime[i].state = voxels[i].state;
     }
+    runs.clear();
+    rowRuns.resize(size.y * size.z + 1);
+    for (int row = 0; row < size.y * size.z; row++) {
+        rowRuns[row] = runs.size();
+        const voxel* rowVoxels = voxelsRuntime.data() + row * size.x;
+        int x = 0;
+        while (x < size.x) {
+            while (x < size.x && rowVoxels[x].id == BLOCK_AIR) {
+                x++;
+            }
+            int start = x;
+            while (x < size.x && rowVoxels[x].id != BLOCK_AIR) {
+                x++;
+            }
+            if (x > start) {
+                runs.push_back(VoxelsRun {start, x - start});
+            }
+        }
+    }
+    rowRuns[size.y * size.z] = runs.size();
 }
 
 void VoxelFragment::place(
@@ -180,12 +206,51 @@ void VoxelFragment::place(
         }
         for (int z = 0; z < size.z; z++) {
             int sz = z + offset.z;
-            for (int x = 0; x < size.x; x++) {
-                int sx = x + offset.x;
-                const auto& structVoxel = 
-                    structVoxels[vox_index(x, y, z, size.x, size.z)];
-                if (structVoxel.id) {
-                    chunks.set(sx, sy, sz, structVoxel.id, structVoxel.state);
+            int row = y * size.z + z;
+            for (uint i = rowRuns[row]; i < rowRuns[row + 1]; i++) {
+                const auto& run = runs[i];
+                for (int x = run.x; x < run.x + run.length; x++) {
+                    const auto& structVoxel = structVoxels[row * size.x + x];
+                    chunks.set(
+                        x + offset.x,
+                        sy,
+                        sz,
+                        structVoxel.id,
+                        structVoxel.state
+                    );
+                }
+            }
+        }
+    }
+}
+
+void VoxelFragment::placeToChunk(
+    voxel* chunkVoxels, const glm::ivec3& offset
+) const {
+    const auto& structVoxels = getRuntimeVoxels();
+    int minY = std::max(0, -offset.y);
+    int maxY = std::min(size.y, CHUNK_H - offset.y);
+    int minZ = std::max(0, -offset.z);
+    int maxZ = std::min(size.z, CHUNK_D - offset.z);
+    int minX = std::max(0, -offset.x);
+    int maxX = std::min(size.x, CHUNK_W - offset.x);
+    if (minX >= maxX) {
+        return;
+    }
+    for (int y = minY; y < maxY; y++) {
+        for (int z = minZ; z < maxZ; z++) {
+            int row = y * size.z + z;
+            const voxel* src = structVoxels.data() + row * size.x;
+            voxel* dst = chunkVoxels + vox_index(0, y + offset.y, z + offset.z);
+            for (uint i = rowRuns[row]; i < rowRuns[row + 1]; i++) {
+                int start = std::max(runs[i].x, minX);
+                int end = std::min(runs[i].x + runs[i].length, maxX);
+                if (start < end) {
+                    std::memcpy(
+                        dst + offset.x + start,
+                        src + start,
+                        (end - start) * sizeof(voxel)
+                    );
                 }
             }
         }
@@ -22,6 +22,17 @@ class VoxelFragment : public Serializable {
 
     /// @brief Structure voxels built on prepare(...) call
     std::vector<voxel> voxelsRuntime;
+
+    /// @brief Run of non-air voxels in a fragment row
+    struct VoxelsRun {
+        int x;
+        int length;
+    };
+    /// @brief Non-air voxels runs of all rows (Z, Y order) built on
+    /// prepare(...) call, so placement skips air without checking voxels
+    std::vector<VoxelsRun> runs;
+    /// @brief Index of the first run of each row and total runs count
+    std::vector<uint> rowRuns;
 public:
     VoxelFragment() : size() {}
 
@@ -36,6 +47,9 @@ public:
 
     dv::value serialize() const override;
     void deserialize(const dv::value& src) override;
+
+    /// @brief Remove air margins. Runtime voxels are cleared if the size
+    /// is changed, so prepare(...) must be called again before placing
     void crop();
 
     /// @brief Build runtime voxel indices
@@ -47,6 +61,12 @@ public:
     /// @param rotation rotation index
     void place(Chunks& chunks, const glm::ivec3& offset, ubyte rotation);
 
+    /// @brief Copy prepared fragment voxels to the chunk voxels clipping
+    /// the part out of the chunk. Air voxels are skipped
+    /// @param chunkVoxels target chunk voxels
+    /// @param offset fragment position relative to the chunk
+    void placeToChunk(voxel* chunkVoxels, const glm::ivec3& offset) const;
+
     /// @brief Create structure copy rotated 90 deg. clockwise
     std::unique_ptr<VoxelFragment> rotated(const Content& content) const;
 
@@ -63,7 +83,7 @@ public:
     }
 
     /// @return Voxels with indices valid to current world content
-    const std::vector<voxel>& getRuntimeVoxels() {
+    const std::vector<voxel>& getRuntimeVoxels() const {
         assert(!voxelsRuntime.empty());
         return voxelsRuntime;
     }
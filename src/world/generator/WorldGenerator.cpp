@@ -4,7 +4,9 @@
 #include <algorithm>
 
 #include "maths/util.hpp"
+#include "coders/byte_utils.hpp"
 #include "content/Content.hpp"
+#include "files/WorldRegions.hpp"
 #include "voxels/Block.hpp"
 #include "voxels/Chunk.hpp"
 #include "GeneratorDef.hpp"
@@ -23,6 +25,66 @@ static inline constexpr uint MAX_PARAMETERS = 4;
 /// @brief Initial + wide_structs + biomes + heightmaps + complete
 static inline constexpr uint BASIC_PROTOTYPE_LAYERS = 5;
 
+/// @brief Heightmap tiles size in chunks. Tiles are aligned to the size
+static inline constexpr int HEIGHTMAP_TILE_SIZE = 4;
+
+/// @brief Stored prototypes format version
+static inline constexpr ubyte PROTOTYPE_FORMAT_VERSION = 1;
+
+enum PrototypePlacementType : ubyte {
+    PLACEMENT_STRUCTURE = 0, PLACEMENT_LINE
+};
+
+/// @brief FNV-1a hash, stable between platforms unlike std::hash
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const auto bytes = static_cast<const ubyte*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static uint64_t fnv1a(uint64_t hash, const std::string& str) {
+    // names are separated with the terminating zero
+    return fnv1a(hash, str.c_str(), str.length() + 1);
+}
+
+static uint64_t calc_prototypes_fingerprint(
+    const GeneratorDef& def, const Content& content, uint64_t seed
+) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    hash = fnv1a(hash, &PROTOTYPE_FORMAT_VERSION, 1);
+    hash = fnv1a(hash, def.name);
+    hash = fnv1a(hash, &seed, sizeof(seed));
+    // blocks indices are stored in line placements
+    for (const auto& block : content.getIndices()->blocks.getIterable()) {
+        hash = fnv1a(hash, block->name);
+    }
+    for (const auto& biome : def.biomes) {
+        hash = fnv1a(hash, biome.name);
+    }
+    for (const auto& structure : def.structures) {
+        hash = fnv1a(hash, structure->meta.name);
+    }
+    return hash;
+}
+
+class PrototypeWorker : public util::Worker<PrototypeJob, PrototypeResult> {
+    const WorldGenerator& generator;
+    std::unique_ptr<GeneratorScript> script;
+public:
+    PrototypeWorker(
+        const WorldGenerator& generator, std::unique_ptr<GeneratorScript> script
+    )
+        : generator(generator), script(std::move(script)) {
+    }
+
+    PrototypeResult operator()(const PrototypeJob& job) override {
+        return PrototypeResult {
+            job.index, generator.generateStage(*script, job)};
+    }
+};
+
 WorldGenerator::WorldGenerator(
     const GeneratorDef& def, const Content* content, uint64_t seed
 )
@@ -31,7 +93,10 @@ WorldGenerator::WorldGenerator(
       seed(seed),
       surroundMap(0, BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2)
 {
-    def.script->initialize(seed);
+    script = def.script->fork();
+    script->initialize(seed);
+    heightmapTiles = script->hasHeightmapTile();
+    prototypesFingerprint = calc_prototypes_fingerprint(def, *content, seed);
 
     uint levels = BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2;
 
@@ -51,31 +116,168 @@ WorldGenerator::WorldGenerator(
         }
         prototypes[{x, z}] = generatePrototype(x, z);
     });
-    surroundMap.setLevelCallback(def.wideStructsChunksRadius + 1, 
-    [this](int const x, int const z) {
-        generateStructuresWide(requirePrototype(x, z), x, z);
-    });
-    surroundMap.setLevelCallback(levels-3, [this](int const x, int const z) {
-        generateBiomes(requirePrototype(x, z), x, z);
-    });
-    surroundMap.setLevelCallback(levels-2, [this](int const x, int const z) {
-        generateHeightmap(requirePrototype(x, z), x, z);
-    });
-    surroundMap.setLevelCallback(levels-1, [this](int const x, int const z) {
-        generateStructures(requirePrototype(x, z), x, z);
-    });
-    for (int i = 0; i < def.structures.size(); i++) {
-        // pre-calculate rotated structure variants
-        def.structures[i]->fragments[0]->prepare(*content);
-        for (int j = 1; j < 4; j++) {
-            def.structures[i]->fragments[j] = 
-                def.structures[i]->fragments[j-1]->rotated(*content);
-        }
+    std::pair<int, ChunkPrototypeLevel> stages[] {
+        {def.wideStructsChunksRadius + 1, ChunkPrototypeLevel::WIDE_STRUCTS},
+        {levels - 3, ChunkPrototypeLevel::BIOMES},
+        {levels - 2, ChunkPrototypeLevel::HEIGHTMAP},
+        {levels - 1, ChunkPrototypeLevel::STRUCTURES},
+    };
+    for (const auto& [mapLevel, level] : stages) {
+        surroundMap.setLevelBatchCallback(
+            mapLevel,
+            [this, level = level](const std::vector<glm::ivec2>& batch) {
+                generateBatch(batch, level);
+            }
+        );
+    }
+    if (util::TaskScheduler::getDefault().getThreadsCount() > 1) {
+        prototypesPool = std::make_unique<
+            util::ThreadPool<PrototypeJob, PrototypeResult>>(
+            "prototypes-pool",
+            [this]() {
+                return std::make_shared<PrototypeWorker>(
+                    *this, script->fork()
+                );
+            },
+            [this](PrototypeResult& result) {
+                batchPlacements.at(result.index) =
+                    std::move(result.placements);
+            },
+            util::ThreadPool<PrototypeJob, PrototypeResult>::HALF
+        );
+        prototypesPool->setPriority(util::TaskScheduler::Priority::HIGH);
     }
 }
 
 WorldGenerator::~WorldGenerator() {}
 
+void WorldGenerator::generateBatch(
+    const std::vector<glm::ivec2>& batch, ChunkPrototypeLevel level
+) {
+    timeutil::Timer timer;
+    batchPlacements.clear();
+    batchPlacements.resize(batch.size());
+    auto jobs = createBatchJobs(batch, level);
+    if (prototypesPool == nullptr || jobs.size() == 1) {
+        for (const auto& job : jobs) {
+            batchPlacements[job.index] = generateStage(*script, job);
+        }
+    } else {
+        for (auto& job : jobs) {
+            prototypesPool->enqueueJob(std::move(job));
+        }
+        try {
+            prototypesPool->waitForJobs();
+        } catch (const std::runtime_error&) {
+            // the batch is failed, the pool is reused by the next ones
+            prototypesPool->resetFailure();
+            batchPlacements.clear();
+            throw;
+        }
+    }
+    for (size_t i = 0; i < batch.size(); i++) {
+        placeStructures(batchPlacements[i], batch[i].x, batch[i].y);
+    }
+    batchPlacements.clear();
+    stats.stages[static_cast<int>(level)] += timer.stop();
+}
+
+std::vector<PrototypeJob> WorldGenerator::createBatchJobs(
+    const std::vector<glm::ivec2>& batch, ChunkPrototypeLevel level
+) const {
+    auto prototypeAt = [this](const glm::ivec2& pos) {
+        const auto& found = prototypes.find(pos);
+        if (found == prototypes.end()) {
+            throw std::runtime_error("prototype not found");
+        }
+        return found->second;
+    };
+    std::vector<PrototypeJob> jobs;
+    uint bpd = def.heightsBPD;
+    // tile heightmap matches chunk heightmaps only if both have
+    // the same points grid
+    if (!heightmapTiles || level != ChunkPrototypeLevel::HEIGHTMAP ||
+        CHUNK_W % bpd || CHUNK_D % bpd) {
+        for (size_t i = 0; i < batch.size(); i++) {
+            const auto& pos = batch[i];
+            jobs.push_back(
+                PrototypeJob {{prototypeAt(pos)}, pos.x, pos.y, 1, 1, level, i}
+            );
+        }
+        return jobs;
+    }
+    util::FlatHashMap<glm::ivec2, std::vector<size_t>> tiles;
+    for (size_t i = 0; i < batch.size(); i++) {
+        const auto& pos = batch[i];
+        tiles[{floordiv(pos.x, HEIGHTMAP_TILE_SIZE),
+               floordiv(pos.y, HEIGHTMAP_TILE_SIZE)}]
+            .push_back(i);
+    }
+    for (const auto& [_, indices] : tiles) {
+        glm::ivec2 min = batch[indices[0]];
+        glm::ivec2 max = min;
+        bool generated = false;
+        for (size_t index : indices) {
+            min = glm::min(min, batch[index]);
+            max = glm::max(max, batch[index]);
+            generated |= prototypeAt(batch[index])->level >=
+                         ChunkPrototypeLevel::HEIGHTMAP;
+        }
+        glm::ivec2 size = max - min + 1;
+        if (indices.size() == 1 || generated || size.x <= 0 || size.y <= 0 ||
+            indices.size() != static_cast<size_t>(size.x * size.y)) {
+            for (size_t index : indices) {
+                const auto& pos = batch[index];
+                jobs.push_back(PrototypeJob {
+                    {prototypeAt(pos)}, pos.x, pos.y, 1, 1, level, index});
+            }
+            continue;
+        }
+        PrototypeJob job {
+            std::vector<std::shared_ptr<ChunkPrototype>>(indices.size()),
+            min.x,
+            min.y,
+            size.x,
+            size.y,
+            level,
+            *std::min_element(indices.begin(), indices.end())};
+        for (size_t index : indices) {
+            auto local = batch[index] - min;
+            job.prototypes[local.y * size.x + local.x] =
+                prototypeAt(batch[index]);
+        }
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+std::vector<Placement> WorldGenerator::generateStage(
+    GeneratorScript& script, const PrototypeJob& job
+) const {
+    if (job.prototypes.size() > 1) {
+        generateHeightmapTile(script, job);
+        return {};
+    }
+    auto& prototype = *job.prototypes[0];
+    int x = job.x;
+    int z = job.z;
+    switch (job.level) {
+        case ChunkPrototypeLevel::WIDE_STRUCTS:
+            return generateStructuresWide(script, prototype, x, z);
+        case ChunkPrototypeLevel::BIOMES:
+            generateBiomes(script, prototype, x, z);
+            break;
+        case ChunkPrototypeLevel::HEIGHTMAP:
+            generateHeightmap(script, prototype, x, z);
+            break;
+        case ChunkPrototypeLevel::STRUCTURES:
+            return generateStructures(script, prototype, x, z);
+        default:
+            break;
+    }
+    return {};
+}
+
 ChunkPrototype& WorldGenerator::requirePrototype(int x, int z) {
     const auto& found = prototypes.find({x, z});
     if (found == prototypes.end()) {
@@ -147,11 +349,6 @@ std::unique_ptr<ChunkPrototype> WorldGenerator::generatePrototype(
     return std::make_unique<ChunkPrototype>();
 }
 
-inline AABB gen_chunk_aabb(int chunkX, int chunkZ) {
-    return AABB({chunkX * CHUNK_W, 0, chunkZ * CHUNK_D}, 
-                {(chunkX + 1)*CHUNK_W, 256, (chunkZ + 1) * CHUNK_D});
-}
-
 void WorldGenerator::placeStructure(
     const StructurePlacement& placement, int priority,
     int chunkX, int chunkZ
@@ -160,26 +357,32 @@ void WorldGenerator::placeStructure(
         *def.structures[placement.structure]->fragments[placement.rotation];
     auto position =
         glm::ivec3(chunkX * CHUNK_W, 0, chunkZ * CHUNK_D) + placement.position;
-    auto size = structure.getSize() + glm::ivec3(0, CHUNK_H, 0);
-    AABB aabb(position, position + size);
-    for (int lcz = -1; lcz <= 1; lcz++) {
-        for (int lcx = -1; lcx <= 1; lcx++) {
-            const auto& found = prototypes.find({chunkX + lcx, chunkZ + lcz});
+    const auto& size = structure.getSize();
+    if (size.x <= 0 || size.z <= 0) {
+        return;
+    }
+    // prototypes map is the chunks grid: visit only the chunks overlapped
+    // by the structure, wide structures may cover many of them
+    int cza = floordiv(position.z, CHUNK_D);
+    int czb = floordiv(position.z + size.z - 1, CHUNK_D);
+    int cxa = floordiv(position.x, CHUNK_W);
+    int cxb = floordiv(position.x + size.x - 1, CHUNK_W);
+    for (int cz = cza; cz <= czb; cz++) {
+        for (int cx = cxa; cx <= cxb; cx++) {
+            const auto& found = prototypes.find({cx, cz});
             if (found == prototypes.end()) {
                 continue;
             }
-            auto& otherPrototype = *found->second;
-            auto chunkAABB = gen_chunk_aabb(chunkX + lcx, chunkZ + lcz);
-            if (chunkAABB.intersect(aabb)) {
-                otherPrototype.placements.emplace_back(
-                    priority,
-                    StructurePlacement {
-                        placement.structure,
-                        placement.position -
-                            glm::ivec3(lcx * CHUNK_W, 0, lcz * CHUNK_D),
-                        placement.rotation}
-                );
-            }
+            int lcx = cx - chunkX;
+            int lcz = cz - chunkZ;
+            found->second->placements.emplace_back(
+                priority,
+                StructurePlacement {
+                    placement.structure,
+                    placement.position -
+                        glm::ivec3(lcx * CHUNK_W, 0, lcz * CHUNK_D),
+                    placement.rotation}
+            );
         }
     }
 }
@@ -204,10 +407,7 @@ void WorldGenerator::placeLine(const LinePlacement& line, int priority) {
 }
 
 void WorldGenerator::placeStructures(
-    const std::vector<Placement>& placements, 
-    ChunkPrototype& prototype, 
-    int chunkX, 
-    int chunkZ
+    const std::vector<Placement>& placements, int chunkX, int chunkZ
 ) {
     for (const auto& placement : placements) {
         if (auto sp = std::get_if<StructurePlacement>(&placement.placement)) {
@@ -223,34 +423,32 @@ void WorldGenerator::placeStructures(
     }
 }
 
-void WorldGenerator::generateStructuresWide(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
-) {
+std::vector<Placement> WorldGenerator::generateStructuresWide(
+    GeneratorScript& script, ChunkPrototype& prototype, int chunkX, int chunkZ
+) const {
     if (prototype.level >= ChunkPrototypeLevel::WIDE_STRUCTS) {
-        return;
+        return {};
     }
-    auto placements = def.script->placeStructuresWide(
+    auto placements = script.placeStructuresWide(
         {chunkX * CHUNK_W, chunkZ * CHUNK_D}, {CHUNK_W, CHUNK_D}, CHUNK_H
     );
-    placeStructures(placements, prototype, chunkX, chunkZ);
-
     prototype.level = ChunkPrototypeLevel::WIDE_STRUCTS;
+    return placements;
 }
 
-void WorldGenerator::generateStructures(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
-) {
+std::vector<Placement> WorldGenerator::generateStructures(
+    GeneratorScript& script, ChunkPrototype& prototype, int chunkX, int chunkZ
+) const {
     if (prototype.level >= ChunkPrototypeLevel::STRUCTURES) {
-        return;
+        return {};
     }
     const auto& biomes = prototype.biomes;
     const auto& heightmap = prototype.heightmap;
 
-    auto placements = def.script->placeStructures(
+    auto placements = script.placeStructures(
         {chunkX * CHUNK_W, chunkZ * CHUNK_D}, {CHUNK_W, CHUNK_D},
         heightmap, CHUNK_H
     );
-    placeStructures(placements, prototype, chunkX, chunkZ);
 
     util::PseudoRandom structsRand;
     structsRand.setSeed(chunkX, chunkZ);
@@ -275,29 +473,23 @@ void WorldGenerator::generateStructures(
             glm::ivec3 position {x, height-structure.meta.lowering, z};
             position.x -= fragment.getSize().x / 2;
             position.z -= fragment.getSize().z / 2;
-            placeStructure(
-                StructurePlacement {
-                    structureId,
-                    position,
-                    rotation
-                },
-                1,
-                chunkX, 
-                chunkZ
+            placements.emplace_back(
+                1, StructurePlacement {structureId, position, rotation}
             );
         }
     }
     prototype.level = ChunkPrototypeLevel::STRUCTURES;
+    return placements;
 }
 
 void WorldGenerator::generateBiomes(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
-) {
+    GeneratorScript& script, ChunkPrototype& prototype, int chunkX, int chunkZ
+) const {
     if (prototype.level >= ChunkPrototypeLevel::BIOMES) {
         return;
     }
     uint bpd = def.biomesBPD;
-    auto biomeParams = def.script->generateParameterMaps(
+    auto biomeParams = script.generateParameterMaps(
         {floordiv(chunkX * CHUNK_W, bpd), floordiv(chunkZ * CHUNK_D, bpd)},
         {floordiv(CHUNK_W, bpd)+1, floordiv(CHUNK_D, bpd)+1},
         bpd
@@ -332,18 +524,101 @@ void WorldGenerator::generateBiomes(
 }
 
 void WorldGenerator::generateHeightmap(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
-) {
+    GeneratorScript& script, ChunkPrototype& prototype, int chunkX, int chunkZ
+) const {
     if (prototype.level >= ChunkPrototypeLevel::HEIGHTMAP) {
         return;
     }
     uint bpd = def.heightsBPD;
-    prototype.heightmap = def.script->generateHeightmap(
-        {floordiv(chunkX * CHUNK_W, bpd), floordiv(chunkZ * CHUNK_D, bpd)},
-        {floordiv(CHUNK_W, bpd)+1, floordiv(CHUNK_D, bpd)+1},
+    finishHeightmap(
+        prototype,
+        script.generateHeightmap(
+            {floordiv(chunkX * CHUNK_W, bpd), floordiv(chunkZ * CHUNK_D, bpd)},
+            {floordiv(CHUNK_W, bpd) + 1, floordiv(CHUNK_D, bpd) + 1},
+            bpd,
+            prototype.heightmapInputs
+        )
+    );
+}
+
+static void copy_heightmap_area(
+    const Heightmap& src,
+    uint srcX,
+    uint srcY,
+    Heightmap& dst,
+    uint dstX,
+    uint dstY,
+    uint width,
+    uint height
+) {
+    for (uint y = 0; y < height; y++) {
+        std::copy_n(
+            src.getValues() + (srcY + y) * src.getWidth() + srcX,
+            width,
+            dst.getValues() + (dstY + y) * dst.getWidth() + dstX
+        );
+    }
+}
+
+void WorldGenerator::generateHeightmapTile(
+    GeneratorScript& script, const PrototypeJob& job
+) const {
+    uint bpd = def.heightsBPD;
+    uint dotsW = CHUNK_W / bpd;
+    uint dotsD = CHUNK_D / bpd;
+    uint tileW = job.width * dotsW + 1;
+    uint tileD = job.depth * dotsD + 1;
+
+    // chunk maps share edge points, so the tile input is composed of them
+    std::vector<std::shared_ptr<Heightmap>> inputs;
+    for (size_t i = 0; i < def.heightmapInputs.size(); i++) {
+        auto input = std::make_shared<Heightmap>(tileW, tileD);
+        for (int j = 0; j < job.depth; j++) {
+            for (int k = 0; k < job.width; k++) {
+                const auto& prototype = *job.prototypes[j * job.width + k];
+                copy_heightmap_area(
+                    *prototype.heightmapInputs.at(i), 0, 0,
+                    *input, k * dotsW, j * dotsD,
+                    dotsW + 1, dotsD + 1
+                );
+            }
+        }
+        inputs.push_back(std::move(input));
+    }
+    auto tile = script.generateHeightmapTile(
+        {floordiv(job.x * CHUNK_W, bpd), floordiv(job.z * CHUNK_D, bpd)},
+        {tileW, tileD},
         bpd,
-        prototype.heightmapInputs
+        inputs
     );
+    if (tile && (tile->getWidth() != tileW || tile->getHeight() != tileD)) {
+        logger.error() << "invalid heightmap tile size " << tile->getWidth()
+                       << "x" << tile->getHeight();
+        tile = nullptr;
+    }
+    for (int j = 0; j < job.depth; j++) {
+        for (int k = 0; k < job.width; k++) {
+            auto& prototype = *job.prototypes[j * job.width + k];
+            if (tile == nullptr) {
+                generateHeightmap(script, prototype, job.x + k, job.z + j);
+                continue;
+            }
+            auto heightmap = std::make_shared<Heightmap>(dotsW + 1, dotsD + 1);
+            copy_heightmap_area(
+                *tile, k * dotsW, j * dotsD,
+                *heightmap, 0, 0,
+                dotsW + 1, dotsD + 1
+            );
+            finishHeightmap(prototype, std::move(heightmap));
+        }
+    }
+}
+
+void WorldGenerator::finishHeightmap(
+    ChunkPrototype& prototype, std::shared_ptr<Heightmap> heightmap
+) const {
+    uint bpd = def.heightsBPD;
+    prototype.heightmap = std::move(heightmap);
     prototype.heightmap->clamp();
     prototype.heightmap->resize(
         CHUNK_W + bpd, CHUNK_D + bpd, def.heightsInterpolation
@@ -366,7 +641,7 @@ void WorldGenerator::generatePlants(
     int chunkX,
     int chunkZ,
     const Biome** biomes
-) {
+) const {
     const auto& indices = content->getIndices()->blocks;
     util::PseudoRandom plantsRand;
     plantsRand.setSeed(chunkX, chunkZ);
@@ -403,7 +678,7 @@ void WorldGenerator::generateLand(
     int chunkX,
     int chunkZ,
     const Biome** biomes
-) {
+) const {
     uint seaLevel = def.seaLevel;
     for (uint z = 0; z < CHUNK_D; z++) {
         for (uint x = 0; x < CHUNK_W; x++) {
@@ -422,13 +697,165 @@ void WorldGenerator::generateLand(
 }
 
 void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
+    generate(voxels, chunkX, chunkZ, *prepare(chunkX, chunkZ));
+}
+
+std::shared_ptr<const ChunkPrototype> WorldGenerator::prepare(
+    int chunkX, int chunkZ
+) {
+    const auto& existing = prototypes.find({chunkX, chunkZ});
+    bool complete = existing != prototypes.end() &&
+                    existing->second->level == ChunkPrototypeLevel::STRUCTURES;
+    if (!complete && prototypesStorage) {
+        auto data = prototypesStorage->fetchPrototype(chunkX, chunkZ);
+        if (!data.empty()) {
+            if (auto prototype = decodePrototype(data)) {
+                return prototype;
+            }
+        }
+    }
     surroundMap.completeAt(chunkX, chunkZ);
 
-    const auto& prototype = requirePrototype(chunkX, chunkZ);
+    const auto& found = prototypes.find({chunkX, chunkZ});
+    if (found == prototypes.end()) {
+        throw std::runtime_error("prototype not found");
+    }
+    if (!complete && prototypesStorage) {
+        prototypesStorage->putPrototype(
+            chunkX, chunkZ, encodePrototype(*found->second)
+        );
+    }
+    return found->second;
+}
+
+void WorldGenerator::setPrototypesStorage(WorldRegions* regions) {
+    prototypesStorage = regions;
+}
+
+std::vector<ubyte> WorldGenerator::encodePrototype(
+    const ChunkPrototype& prototype
+) const {
+    ByteBuilder builder;
+    builder.put(PROTOTYPE_FORMAT_VERSION);
+    builder.putInt64(prototypesFingerprint);
+
+    const auto biomes = prototype.biomes.get();
+    for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+        builder.putInt16(biomes[i] - def.biomes.data());
+    }
+    const auto heights = prototype.heightmap->getValues();
+    for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+        builder.putFloat32(heights[i]);
+    }
+    builder.putInt32(prototype.placements.size());
+    for (const auto& placement : prototype.placements) {
+        builder.putInt32(placement.priority);
+        if (auto sp = std::get_if<StructurePlacement>(&placement.placement)) {
+            builder.put(PLACEMENT_STRUCTURE);
+            builder.putInt32(sp->structure);
+            builder.putInt32(sp->position.x);
+            builder.putInt32(sp->position.y);
+            builder.putInt32(sp->position.z);
+            builder.put(sp->rotation);
+        } else {
+            const auto& line = std::get<LinePlacement>(placement.placement);
+            builder.put(PLACEMENT_LINE);
+            builder.putInt16(line.block);
+            builder.putInt32(line.a.x);
+            builder.putInt32(line.a.y);
+            builder.putInt32(line.a.z);
+            builder.putInt32(line.b.x);
+            builder.putInt32(line.b.y);
+            builder.putInt32(line.b.z);
+            builder.putInt32(line.radius);
+        }
+    }
+    return builder.build();
+}
+
+static glm::ivec3 read_ivec3(ByteReader& reader) {
+    int x = reader.getInt32();
+    int y = reader.getInt32();
+    int z = reader.getInt32();
+    return {x, y, z};
+}
+
+std::shared_ptr<ChunkPrototype> WorldGenerator::decodePrototype(
+    const std::vector<ubyte>& data
+) const {
+    ByteReader reader(data.data(), data.size());
+    try {
+        if (reader.get() != PROTOTYPE_FORMAT_VERSION ||
+            static_cast<uint64_t>(reader.getInt64()) != prototypesFingerprint) {
+            return nullptr;
+        }
+        auto prototype = std::make_shared<ChunkPrototype>();
+        auto biomes = std::make_unique<const Biome*[]>(CHUNK_W * CHUNK_D);
+        for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+            uint index = static_cast<uint16_t>(reader.getInt16());
+            if (index >= def.biomes.size()) {
+                throw std::runtime_error("invalid biome index");
+            }
+            biomes[i] = &def.biomes[index];
+        }
+        prototype->biomes = std::move(biomes);
+
+        prototype->heightmap = std::make_shared<Heightmap>(CHUNK_W, CHUNK_D);
+        auto heights = prototype->heightmap->getValues();
+        for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+            heights[i] = reader.getFloat32();
+        }
+        int count = reader.getInt32();
+        if (count < 0) {
+            throw std::runtime_error("invalid placements count");
+        }
+        for (int i = 0; i < count; i++) {
+            int priority = reader.getInt32();
+            switch (reader.get()) {
+                case PLACEMENT_STRUCTURE: {
+                    int structure = reader.getInt32();
+                    auto position = read_ivec3(reader);
+                    uint8_t rotation = reader.get();
+                    if (structure < 0 || structure >= def.structures.size() ||
+                        rotation >= 4) {
+                        throw std::runtime_error("invalid structure placement");
+                    }
+                    prototype->placements.emplace_back(
+                        priority,
+                        StructurePlacement {structure, position, rotation}
+                    );
+                    break;
+                }
+                case PLACEMENT_LINE: {
+                    blockid_t block = reader.getInt16();
+                    auto a = read_ivec3(reader);
+                    auto b = read_ivec3(reader);
+                    int radius = reader.getInt32();
+                    prototype->placements.emplace_back(
+                        priority, LinePlacement {block, a, b, radius}
+                    );
+                    break;
+                }
+                default:
+                    throw std::runtime_error("invalid placement type");
+            }
+        }
+        prototype->level = ChunkPrototypeLevel::STRUCTURES;
+        return prototype;
+    } catch (const std::runtime_error& err) {
+        logger.warning() << "could not load chunk prototype: " << err.what();
+        return nullptr;
+    }
+}
+
+void WorldGenerator::generate(
+    voxel* voxels, int chunkX, int chunkZ, const ChunkPrototype& prototype
+) const {
     const auto values = prototype.heightmap->getValues();
 
     uint seaLevel = def.seaLevel;
 
+    timeutil::Timer timer;
     std::memset(voxels, 0, sizeof(voxel) * CHUNK_VOL);
 
     const auto& indices = content->getIndices()->blocks;
@@ -447,8 +874,16 @@ void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
             generate_pole(groundLayers, height, 0, seaLevel, voxels, x, z);
         }
     }
+    stats.land += timer.stop();
+
+    timer = {};
     generatePlacements(prototype, voxels, chunkX, chunkZ);
+    stats.placements += timer.stop();
+
+    timer = {};
     generatePlants(prototype, values, voxels, chunkX, chunkZ, biomes);
+    stats.plants += timer.stop();
+    stats.chunks++;
 
     for (uint i = 0; i < CHUNK_VOL; i++) {
         blockid_t& id = voxels[i].id;
@@ -465,16 +900,22 @@ void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
 
 void WorldGenerator::generatePlacements(
     const ChunkPrototype& prototype, voxel* voxels, int chunkX, int chunkZ
-) {
-    auto placements = prototype.placements;
+) const {
+    // sort pointers to not copy placements of every generated chunk
+    std::vector<const Placement*> placements;
+    placements.reserve(prototype.placements.size());
+    for (const auto& placement : prototype.placements) {
+        placements.push_back(&placement);
+    }
     std::stable_sort(
         placements.begin(),
         placements.end(), 
         [](const auto& a, const auto& b) {
-            return a.priority < b.priority;
+            return a->priority < b->priority;
         }
     );
-    for (const auto& placement : placements) {
+    for (const auto placementPtr : placements) {
+        const auto& placement = *placementPtr;
         if (auto structure = std::get_if<StructurePlacement>(&placement.placement)) {
             generateStructure(prototype, *structure, voxels, chunkX, chunkZ);
         } else {
@@ -489,40 +930,14 @@ void WorldGenerator::generateStructure(
     const StructurePlacement& placement,
     voxel* voxels, 
     int chunkX, int chunkZ
-) {
+) const {
     if (placement.structure < 0 || placement.structure >= def.structures.size()) {
         logger.error() << "invalid structure index " << placement.structure;
         return;
     }
     auto& generatingStructure = def.structures[placement.structure];
     auto& structure = *generatingStructure->fragments[placement.rotation];
-    auto& structVoxels = structure.getRuntimeVoxels();
-    const auto& offset = placement.position;
-    const auto& size = structure.getSize();
-
-    for (int y = 0; y < size.y; y++) {
-        int sy = y + offset.y;
-        if (sy < 0 || sy >= CHUNK_H) {
-            continue;
-        }
-        for (int z = 0; z < size.z; z++) {
-            int sz = z + offset.z;
-            if (sz < 0 || sz >= CHUNK_D) {
-                continue;
-            }
-            for (int x = 0; x < size.x; x++) {
-                int sx = x + offset.x;
-                if (sx < 0 || sx >= CHUNK_W) {
-                    continue;
-                }
-                const auto& structVoxel = 
-                    structVoxels[vox_index(x, y, z, size.x, size.z)];
-                if (structVoxel.id) {
-                    voxels[vox_index(sx, sy, sz)] = structVoxel;
-                }
-            }
-        }
-    }
+    structure.placeToChunk(voxels, placement.position);
 }
 
 void WorldGenerator::generateLine(
@@ -530,7 +945,7 @@ void WorldGenerator::generateLine(
     const LinePlacement& line,
     voxel* voxels, 
     int chunkX, int chunkZ
-) {
+) const {
     const auto& indices = content->getIndices()->blocks;
 
     int cgx = chunkX * CHUNK_W;
@@ -588,11 +1003,14 @@ void WorldGenerator::generateLine(
 
 WorldGenDebugInfo WorldGenerator::createDebugInfo() const {
     const auto& area = surroundMap.getArea();
-    const auto& levels = area.getBuffer();
-    auto values = std::make_unique<ubyte[]>(area.getWidth()*area.getHeight());
+    int width = area.getWidth();
+    int height = area.getHeight();
+    auto values = std::make_unique<ubyte[]>(width * height);
 
-    for (uint i = 0; i < levels.size(); i++) {
-        values[i] = levels[i];
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            values[y * width + x] = area.getLocal(x, y);
+        }
     }
 
     return WorldGenDebugInfo {
@@ -1,22 +1,26 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <string>
 #include <memory>
 #include <vector>
-#include <unordered_map>
 
 #include "constants.hpp"
 #include "typedefs.hpp"
 #include "voxels/voxel.hpp"
+#include "util/FlatHashMap.hpp"
+#include "util/ThreadPool.hpp"
 #include "SurroundMap.hpp"
 #include "StructurePlacement.hpp"
 
 class Content;
 struct GeneratorDef;
+class GeneratorScript;
 class Heightmap;
 struct Biome;
 class VoxelFragment;
+class WorldRegions;
 
 enum class ChunkPrototypeLevel {
     VOID=0, WIDE_STRUCTS, BIOMES, HEIGHTMAP, STRUCTURES
@@ -37,6 +41,43 @@ struct ChunkPrototype {
     std::vector<std::shared_ptr<Heightmap>> heightmapInputs {};
 };
 
+/// @brief Prototype stage of a chunks area from a batch of one SurroundMap
+/// level. Area is a single chunk except heightmap tiles
+struct PrototypeJob {
+    /// @brief Area prototypes in row-major order
+    std::vector<std::shared_ptr<ChunkPrototype>> prototypes;
+    /// @brief Area position in chunks
+    int x;
+    int z;
+    /// @brief Area size in chunks
+    int width;
+    int depth;
+    ChunkPrototypeLevel level;
+    /// @brief Index of the first area chunk in the batch
+    size_t index;
+};
+
+struct PrototypeResult {
+    size_t index;
+    /// @brief Placements to be distributed between prototypes
+    std::vector<Placement> placements;
+};
+
+/// @brief Accumulated world generation time in microseconds
+struct WorldGenStats {
+    /// @brief Prototype stages time (including placements distribution)
+    /// indexed by ChunkPrototypeLevel
+    std::array<std::atomic<int64_t>, 5> stages {};
+    /// @brief Ground and sea layers filling time
+    std::atomic<int64_t> land = 0;
+    /// @brief Structures and lines placement time
+    std::atomic<int64_t> placements = 0;
+    /// @brief Plants placement time
+    std::atomic<int64_t> plants = 0;
+    /// @brief Number of generated chunks
+    std::atomic<uint> chunks = 0;
+};
+
 struct WorldGenDebugInfo {
     int areaOffsetX;
     int areaOffsetY;
@@ -53,10 +94,33 @@ class WorldGenerator {
     const Content* content;
     /// @param seed world seed
     uint64_t seed;
-    /// @brief Chunk prototypes main storage
-    std::unordered_map<glm::ivec2, std::unique_ptr<ChunkPrototype>> prototypes;
+    /// @brief Generator script instance initialized with the seed.
+    /// Forked from the definition script, so generators do not share
+    /// the script state
+    std::unique_ptr<GeneratorScript> script;
+    /// @brief The script generates heightmaps of tiles
+    bool heightmapTiles;
+    /// @brief Chunk prototypes main storage. Prototypes are shared with
+    /// generation jobs, so they may outlive removal from the map
+    util::FlatHashMap<glm::ivec2, std::shared_ptr<ChunkPrototype>> prototypes;
     /// @brief Chunk prototypes loading surround map
     SurroundMap surroundMap;
+    /// @brief Prototype stages executor. Every worker has its own
+    /// generator script instance. Null if single-threaded
+    std::unique_ptr<util::ThreadPool<PrototypeJob, PrototypeResult>>
+        prototypesPool;
+    /// @brief Placements produced by the current batch jobs
+    std::vector<std::vector<Placement>> batchPlacements;
+    /// @brief Complete prototypes storage. Null if prototypes are not
+    /// stored
+    WorldRegions* prototypesStorage = nullptr;
+    /// @brief Hash of the generator, seed and content indices stored with
+    /// prototypes. Prototypes with other fingerprint are ignored
+    uint64_t prototypesFingerprint;
+    /// @brief Generation time counters, updated by worker threads too
+    mutable WorldGenStats stats;
+
+    friend class PrototypeWorker;
 
     /// @brief Generate chunk prototype (see ChunkPrototype)
     /// @param x chunk position X divided by CHUNK_W
@@ -65,13 +129,55 @@ class WorldGenerator {
 
     ChunkPrototype& requirePrototype(int x, int z);
 
-    void generateStructuresWide(ChunkPrototype& prototype, int x, int z);
+    /// @brief Bring prototypes of a SurroundMap level batch to the level.
+    /// Stages of the batch chunks run in parallel, then produced
+    /// placements are distributed in the batch order
+    void generateBatch(
+        const std::vector<glm::ivec2>& batch, ChunkPrototypeLevel level
+    );
+
+    /// @brief Split the batch into stage jobs. Heightmap stage chunks
+    /// filling aligned tiles are joined into single jobs if the script
+    /// generates heightmap tiles
+    std::vector<PrototypeJob> createBatchJobs(
+        const std::vector<glm::ivec2>& batch, ChunkPrototypeLevel level
+    ) const;
+
+    /// @brief Run prototype stage. Modifies the job prototypes only,
+    /// so may be called from worker threads with own script instances
+    /// @return placements to be distributed between prototypes
+    std::vector<Placement> generateStage(
+        GeneratorScript& script, const PrototypeJob& job
+    ) const;
+
+    std::vector<Placement> generateStructuresWide(
+        GeneratorScript& script, ChunkPrototype& prototype, int x, int z
+    ) const;
 
-    void generateStructures(ChunkPrototype& prototype, int x, int z);
+    std::vector<Placement> generateStructures(
+        GeneratorScript& script, ChunkPrototype& prototype, int x, int z
+    ) const;
 
-    void generateBiomes(ChunkPrototype& prototype, int x, int z);
+    void generateBiomes(
+        GeneratorScript& script, ChunkPrototype& prototype, int x, int z
+    ) const;
 
-    void generateHeightmap(ChunkPrototype& prototype, int x, int z);
+    void generateHeightmap(
+        GeneratorScript& script, ChunkPrototype& prototype, int x, int z
+    ) const;
+
+    /// @brief Generate heightmaps of the job area with a single script call.
+    /// Falls back to per-chunk generation if the script does not support
+    /// heightmap tiles
+    void generateHeightmapTile(
+        GeneratorScript& script, const PrototypeJob& job
+    ) const;
+
+    /// @brief Scale chunk heightmap generated with heightsBPD to the chunk
+    /// size
+    void finishHeightmap(
+        ChunkPrototype& prototype, std::shared_ptr<Heightmap> heightmap
+    ) const;
 
     void placeStructure(
         const StructurePlacement& placement, int priority, 
@@ -82,19 +188,19 @@ class WorldGenerator {
 
     void generatePlacements(
         const ChunkPrototype& prototype, voxel* voxels, int x, int z
-    );
+    ) const;
     void generateLine(
         const ChunkPrototype& prototype, 
         const LinePlacement& placement,
         voxel* voxels, 
         int x, int z
-    );
+    ) const;
     void generateStructure(
         const ChunkPrototype& prototype, 
         const StructurePlacement& placement,
         voxel* voxels, 
         int x, int z
-    );
+    ) const;
     void generatePlants(
         const ChunkPrototype& prototype,
         float* values,
@@ -102,7 +208,7 @@ class WorldGenerator {
         int x,
         int z,
         const Biome** biomes
-    );
+    ) const;
     void generateLand(
         const ChunkPrototype& prototype,
         float* values,
@@ -110,13 +216,21 @@ class WorldGenerator {
         int x,
         int z,
         const Biome** biomes
-    );
+    ) const;
 
     void placeStructures(
-        const std::vector<Placement>& placements,
-        ChunkPrototype& prototype,
-        int x, int z
+        const std::vector<Placement>& placements, int x, int z
     );
+
+    /// @brief Serialize complete prototype biomes, heightmap and placements
+    std::vector<ubyte> encodePrototype(const ChunkPrototype& prototype) const;
+
+    /// @brief Deserialize prototype encoded with encodePrototype
+    /// @return complete prototype or nullptr if data is invalid or
+    /// created with other generator, seed or content
+    std::shared_ptr<ChunkPrototype> decodePrototype(
+        const std::vector<ubyte>& data
+    ) const;
 public:
     WorldGenerator(
         const GeneratorDef& def,
@@ -127,11 +241,42 @@ public:
 
     void update(int centerX, int centerY, int loadDistance);
 
+    /// @brief Set storage of complete prototypes. Prepared prototypes are
+    /// put to the storage, so revisited not saved chunks skip the
+    /// prototype stages
+    /// @param regions world regions or nullptr to disable the storage
+    void setPrototypesStorage(WorldRegions* regions);
+
     /// @brief Generate complete chunk voxels
-    /// @param voxels destinatiopn chunk voxels buffer
+    /// @param voxels destination chunk voxels buffer
     /// @param x chunk position X divided by CHUNK_W
     /// @param z chunk position Y divided by CHUNK_D
     void generate(voxel* voxels, int x, int z);
 
+    /// @brief Bring chunk prototype to the complete level or load it
+    /// from the prototypes storage.
+    /// Must be called from the main thread: prototype stages run the
+    /// generator script.
+    /// @param x chunk position X divided by CHUNK_W
+    /// @param z chunk position Y divided by CHUNK_D
+    /// @return complete prototype, stays valid after the generator
+    /// forgets it
+    std::shared_ptr<const ChunkPrototype> prepare(int x, int z);
+
+    /// @brief Generate chunk voxels from a complete prototype.
+    /// Does not use the generator script, so may be called from
+    /// worker threads.
+    /// @param voxels destination chunk voxels buffer
+    /// @param x chunk position X divided by CHUNK_W
+    /// @param z chunk position Y divided by CHUNK_D
+    /// @param prototype prototype returned by prepare(x, z)
+    void generate(
+        voxel* voxels, int x, int z, const ChunkPrototype& prototype
+    ) const;
+
     WorldGenDebugInfo createDebugInfo() const;
+
+    const WorldGenStats& getStats() const {
+        return stats;
+    }
 };
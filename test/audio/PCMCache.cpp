@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+
+#include "audio/PCMCache.hpp"
+
+static std::shared_ptr<audio::PCM> create_pcm(size_t size) {
+    return std::make_shared<audio::PCM>(
+        std::vector<char>(size), size, 1, 8, 44100, true
+    );
+}
+
+TEST(PCMCache, SharedAndEvicted) {
+    audio::PCMCache cache(1000, 600);
+    int loads = 0;
+    auto loader = [&loads]() {
+        loads++;
+        return create_pcm(400);
+    };
+    auto a = cache.get("a", 1, loader);
+    EXPECT_EQ(cache.get("a", 1, loader), a);
+    EXPECT_EQ(loads, 1);
+
+    // changed version is reloaded
+    auto a2 = cache.get("a", 2, loader);
+    EXPECT_NE(a2, a);
+    EXPECT_EQ(loads, 2);
+    EXPECT_EQ(cache.getUsedMemory(), 400);
+
+    cache.get("b", 1, loader);
+    cache.get("a", 2, loader);
+    // exceeds the budget: least recently used 'b' is evicted
+    cache.get("c", 1, loader);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.getUsedMemory(), 800);
+    EXPECT_EQ(cache.get("a", 2, loader), a2);
+    EXPECT_EQ(loads, 4);
+
+    // too large entries are not cached
+    cache.get("d", 1, [] { return create_pcm(700); });
+    EXPECT_EQ(cache.size(), 2);
+}
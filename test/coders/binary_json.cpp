@@ -2,6 +2,7 @@
 
 #include "util/Buffer.hpp"
 #include "coders/binary_json.hpp"
+#include "coders/byte_utils.hpp"
 
 TEST(BJSON, EncodeDecode) {
     const std::string name = "JSON-encoder";
@@ -36,3 +37,41 @@ TEST(BJSON, EncodeDecode) {
         }
     }
 }
+
+TEST(BJSON, NestedDocumentsAndView) {
+    auto object = dv::object();
+    object["name"] = "root";
+    auto& nested = object.object("nested");
+    nested["value"] = 42;
+    nested.object("deeper")["flag"] = true;
+    auto& list = object.list("list");
+    list.add(1);
+    list.add("two");
+    list.add(dv::object());
+    object["last"] = 0.5;
+
+    ByteBuilder builder;
+    builder.put(0xFF);
+    json::to_binary(object, builder);
+    auto appended = builder.release();
+    auto bytes = json::to_binary(object, false);
+    ASSERT_EQ(appended.size(), bytes.size() + 1);
+    EXPECT_TRUE(std::equal(bytes.begin(), bytes.end(), appended.begin() + 1));
+
+    auto decoded = json::from_binary(bytes.data(), bytes.size());
+    EXPECT_EQ(decoded["nested"]["value"].asInteger(), 42);
+    EXPECT_TRUE(decoded["nested"]["deeper"]["flag"].asBoolean());
+
+    json::BinaryView view(bytes.data(), bytes.size());
+    EXPECT_EQ(view.getType(), json::BJSON_TYPE_DOCUMENT);
+    EXPECT_EQ(view.length(), 4);
+    EXPECT_FLOAT_EQ(view.find("last")->asNumber(), 0.5);
+    EXPECT_EQ(view.find("nested")->find("value")->asInteger(), 42);
+    EXPECT_FALSE(view.find("missing").has_value());
+
+    auto listView = *view.find("list");
+    EXPECT_EQ(listView.length(), 3);
+    EXPECT_EQ(listView.at(1)->asString(), "two");
+    EXPECT_EQ(listView.at(2)->getType(), json::BJSON_TYPE_DOCUMENT);
+    EXPECT_FALSE(listView.at(3).has_value());
+}
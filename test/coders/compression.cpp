@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "typedefs.hpp"
+#include "coders/compression.hpp"
+
+using namespace compression;
+
+static std::vector<ubyte> generate_data(size_t size) {
+    std::vector<ubyte> data(size);
+    ubyte next = rand();
+    for (size_t i = 0; i < size; i++) {
+        data[i] = next;
+        if (rand() % 20 == 0) {
+            next = rand();
+        }
+    }
+    return data;
+}
+
+TEST(compression, EncodeDecode) {
+    auto data = generate_data(100'000);
+    for (auto method : {Method::EXTRLE8, Method::EXTRLE16, Method::GZIP,
+                        Method::LZ4, Method::ZSTD}) {
+        size_t len;
+        auto compressed = compress(data.data(), data.size(), len, method);
+        EXPECT_LT(len, data.size());
+        auto decompressed = decompress(
+            compressed.get(), len, data.size(), method
+        );
+        EXPECT_EQ(
+            std::vector<ubyte>(
+                decompressed.get(), decompressed.get() + data.size()
+            ),
+            data
+        );
+    }
+}
+
+TEST(compression, DecodeInvalid) {
+    auto data = generate_data(10'000);
+    for (auto method : {Method::LZ4, Method::ZSTD}) {
+        size_t len;
+        auto compressed = compress(data.data(), data.size(), len, method);
+        // unexpected decompressed size
+        EXPECT_THROW(
+            decompress(compressed.get(), len, data.size() / 2, method),
+            std::runtime_error
+        );
+        // truncated data
+        EXPECT_THROW(
+            decompress(compressed.get(), len / 2, data.size(), method),
+            std::runtime_error
+        );
+    }
+}
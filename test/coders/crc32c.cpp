@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "coders/crc32c.hpp"
+
+TEST(crc32c, KnownValues) {
+    std::string check = "123456789";
+    EXPECT_EQ(
+        crc32c::compute(reinterpret_cast<const ubyte*>(check.data()), 9),
+        0xE3069283
+    );
+    std::vector<ubyte> zeros(32);
+    EXPECT_EQ(crc32c::compute(zeros.data(), zeros.size()), 0x8A9136AA);
+    EXPECT_EQ(crc32c::compute(nullptr, 0), 0);
+}
+
+TEST(crc32c, Incremental) {
+    std::vector<ubyte> data(1000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = i * 7 + 3;
+    }
+    uint32_t whole = crc32c::compute(data.data(), data.size());
+    uint32_t crc = crc32c::update(0, data.data(), 13);
+    crc = crc32c::update(crc, data.data() + 13, data.size() - 13);
+    EXPECT_EQ(crc, whole);
+}
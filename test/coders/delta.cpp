@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "coders/delta.hpp"
+
+TEST(delta, EncodeApply) {
+    const size_t length = 100'000;
+    std::vector<ubyte> prev(length);
+    for (size_t i = 0; i < length; i++) {
+        prev[i] = rand();
+    }
+    auto next = prev;
+    next[10] ^= 0xFF;
+    next[50'000] = ~prev[50'000];
+    for (size_t i = 70'000; i < 70'300; i++) {
+        next[i] = 7;
+    }
+    auto diff = delta::encode(prev.data(), next.data(), length);
+    EXPECT_LT(diff.size(), 1000);
+
+    auto data = prev;
+    delta::apply(data.data(), length, diff.data(), diff.size());
+    EXPECT_EQ(data, next);
+
+    // unchanged data
+    diff = delta::encode(prev.data(), prev.data(), length);
+    EXPECT_LT(diff.size(), 32);
+    data = prev;
+    delta::apply(data.data(), length, diff.data(), diff.size());
+    EXPECT_EQ(data, prev);
+}
+
+TEST(delta, InvalidDelta) {
+    std::vector<ubyte> data(64);
+    auto diff = delta::encode(data.data(), data.data(), data.size());
+    EXPECT_THROW(
+        delta::apply(data.data(), 32, diff.data(), diff.size()),
+        std::runtime_error
+    );
+    diff.pop_back();
+    EXPECT_THROW(
+        delta::apply(data.data(), data.size(), diff.data(), diff.size()),
+        std::runtime_error
+    );
+}
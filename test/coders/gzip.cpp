@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <zlib.h>
+
+#include "typedefs.hpp"
+#include "coders/gzip.hpp"
+
+static std::vector<ubyte> generate(size_t size) {
+    std::vector<ubyte> data(size);
+    ubyte next = rand();
+    for (size_t i = 0; i < size; i++) {
+        data[i] = next;
+        if (rand() % 5 == 0) {
+            next = rand() % 16;
+        }
+    }
+    return data;
+}
+
+/// @brief Inflate gzip data checking the stream end and the trailer
+static bool inflate_checked(
+    const std::vector<ubyte>& src, std::vector<ubyte>& dst
+) {
+    z_stream stream {};
+    inflateInit2(&stream, 16 + MAX_WBITS);
+    stream.next_in = const_cast<ubyte*>(src.data());
+    stream.avail_in = src.size();
+    stream.next_out = dst.data();
+    stream.avail_out = dst.size();
+    int status = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    return status == Z_STREAM_END && stream.avail_out == 0;
+}
+
+TEST(gzip, CompressDecompressSmall) {
+    auto data = generate(10'000);
+    auto compressed = gzip::compress(data.data(), data.size());
+    EXPECT_EQ(gzip::decompress(compressed.data(), compressed.size()), data);
+}
+
+TEST(gzip, CompressParallel) {
+    // not a multiple of the block size
+    auto data = generate(3'000'017);
+    auto compressed = gzip::compress(data.data(), data.size());
+    EXPECT_LT(compressed.size(), data.size() / 2);
+
+    std::vector<ubyte> inflated(data.size());
+    EXPECT_TRUE(inflate_checked(compressed, inflated));
+    EXPECT_EQ(inflated, data);
+    EXPECT_EQ(gzip::decompress(compressed.data(), compressed.size()), data);
+}
+
+TEST(gzip, DecompressInvalid) {
+    auto data = generate(10'000);
+    auto compressed = gzip::compress(data.data(), data.size());
+    EXPECT_THROW(gzip::decompress(compressed.data(), 3), std::runtime_error);
+    EXPECT_THROW(
+        gzip::decompress(compressed.data(), compressed.size(), 1000),
+        std::runtime_error
+    );
+    // footer claims larger output than the stream has
+    compressed[compressed.size() - 2] = 0x7F;
+    EXPECT_THROW(
+        gzip::decompress(compressed.data(), compressed.size()),
+        std::runtime_error
+    );
+}
@@ -40,3 +40,12 @@ TEST(JSON, EncodeDecode) {
         }
     }
 }
+
+TEST(JSON, ParseStrings) {
+    auto object = json::parse(
+        R"({"plain": "text", "escaped": "a\n\t\"b\"\\/A", "empty": ""})"
+    );
+    EXPECT_EQ(object["plain"].asString(), "text");
+    EXPECT_EQ(object["escaped"].asString(), "a\n\t\"b\"\\/A");
+    EXPECT_EQ(object["empty"].asString(), "");
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "coders/png.hpp"
+#include "graphics/core/ImageData.hpp"
+
+static std::unique_ptr<ImageData> make_image(
+    ImageFormat format, uint width, uint height
+) {
+    auto image = std::make_unique<ImageData>(format, width, height);
+    uint pixsize = format == ImageFormat::rgba8888 ? 4 : 3;
+    ubyte* data = image->getData();
+    for (uint i = 0; i < width * height * pixsize; i++) {
+        // smooth gradients mixed with noise to use different filters
+        data[i] = (i % 7 == 0) ? rand() : (i / pixsize) % width + i % pixsize;
+    }
+    return image;
+}
+
+static void test_round_trip(ImageFormat format, uint threads) {
+    auto image = make_image(format, 301, 1200);
+    auto bytes = png::encode_image(*image, threads);
+    auto decoded = png::load_image(bytes.data(), bytes.size());
+    ASSERT_EQ(decoded->getWidth(), image->getWidth());
+    ASSERT_EQ(decoded->getHeight(), image->getHeight());
+
+    // load_image flips rows and always adds alpha channel
+    uint width = image->getWidth();
+    uint height = image->getHeight();
+    uint pixsize = format == ImageFormat::rgba8888 ? 4 : 3;
+    for (uint y = 0; y < height; y++) {
+        for (uint x = 0; x < width; x++) {
+            const ubyte* src = image->getData() + (y * width + x) * pixsize;
+            const ubyte* dst =
+                decoded->getData() + ((height - y - 1) * width + x) * 4;
+            ASSERT_EQ(std::memcmp(src, dst, pixsize), 0);
+        }
+    }
+}
+
+TEST(png, EncodeRGBA) {
+    test_round_trip(ImageFormat::rgba8888, 1);
+}
+
+TEST(png, EncodeRGB) {
+    test_round_trip(ImageFormat::rgb888, 1);
+}
+
+TEST(png, EncodeParallel) {
+    test_round_trip(ImageFormat::rgba8888, 4);
+    test_round_trip(ImageFormat::rgb888, 3);
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "typedefs.hpp"
 #include "coders/rle.hpp"
 
@@ -48,3 +50,49 @@ TEST(ExtRLE16, EncodeDecode) {
     test_encode_decode(extrle::encode16, extrle::decode16, 13);
     test_encode_decode(extrle::encode16, extrle::decode16, 90123);
 }
+
+TEST(ExtRLE, LongSequences) {
+    const size_t size = extrle::max_sequence * 2 + 300;
+    std::vector<ubyte> initial(size, 7);
+    std::vector<ubyte> encoded(size * 2);
+    size_t encoded_size = extrle::encode(initial.data(), size, encoded.data());
+    // two max-length sequences and a short tail
+    const ubyte expected[] {0xFF, 0xFF, 7, 0xFF, 0xFF, 7, 0xA9, 0x02, 7};
+    ASSERT_EQ(encoded_size, sizeof(expected));
+    for (size_t i = 0; i < encoded_size; i++) {
+        EXPECT_EQ(encoded[i], expected[i]);
+    }
+    std::vector<ubyte> decoded(size);
+    EXPECT_EQ(extrle::decode(encoded.data(), encoded_size, decoded.data()), size);
+    EXPECT_EQ(decoded, initial);
+}
+
+TEST(ExtRLE16, DecodeChecked) {
+    std::vector<ubyte> initial(1000, 3);
+    initial[500] = 0x12;
+    std::vector<ubyte> encoded(initial.size() * 2);
+    size_t encoded_size =
+        extrle::encode16(initial.data(), initial.size(), encoded.data());
+    std::vector<ubyte> decoded(initial.size());
+    EXPECT_EQ(
+        extrle::decode16_checked(
+            encoded.data(), encoded_size, decoded.data(), decoded.size()
+        ),
+        initial.size()
+    );
+    EXPECT_EQ(decoded, initial);
+    // output does not fit
+    EXPECT_THROW(
+        extrle::decode16_checked(
+            encoded.data(), encoded_size, decoded.data(), decoded.size() - 2
+        ),
+        std::runtime_error
+    );
+    // truncated run
+    EXPECT_THROW(
+        extrle::decode16_checked(
+            encoded.data(), encoded_size - 1, decoded.data(), decoded.size()
+        ),
+        std::runtime_error
+    );
+}
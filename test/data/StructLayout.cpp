@@ -131,3 +131,38 @@ TEST(StructLayout, Serialization) {
 
     EXPECT_EQ(layout1, layout2);
 }
+
+TEST(StructLayout, Converter) {
+    std::vector<Field> srcFields {
+        Field {FieldType::I32, "a", 1},
+        Field {FieldType::I32, "b", 1},
+        Field {FieldType::F32, "f", 2},
+        Field {FieldType::I64, "big", 1},
+    };
+    auto srcLayout = StructLayout::create(srcFields);
+    std::vector<Field> dstFields {
+        Field {FieldType::I32, "a", 1},
+        Field {FieldType::I32, "b", 1},
+        Field {FieldType::I16, "f", 2, FieldConvertStrategy::CLAMP},
+        Field {FieldType::I64, "big", 1},
+    };
+    auto dstLayout = StructLayout::create(dstFields);
+
+    std::vector<ubyte> src(srcLayout.size());
+    std::vector<ubyte> dst(dstLayout.size());
+    StructConverter converter(dstLayout, srcLayout);
+    for (int i = 0; i < 100; i++) {
+        srcLayout.setInteger(src.data(), i, "a");
+        srcLayout.setInteger(src.data(), -i, "b");
+        srcLayout.setNumber(src.data(), i * 0.5, "f", 0);
+        srcLayout.setNumber(src.data(), 1e6, "f", 1);
+        srcLayout.setInteger(src.data(), INT64_MAX - i, "big");
+        converter.convert(src.data(), dst.data());
+
+        EXPECT_EQ(dstLayout.getInteger(dst.data(), "a"), i);
+        EXPECT_EQ(dstLayout.getInteger(dst.data(), "b"), -i);
+        EXPECT_EQ(dstLayout.getInteger(dst.data(), "f", 0), i / 2);
+        EXPECT_EQ(dstLayout.getInteger(dst.data(), "f", 1), INT16_MAX);
+        EXPECT_EQ(dstLayout.getInteger(dst.data(), "big"), INT64_MAX - i);
+    }
+}
@@ -27,3 +27,30 @@ TEST(dv, dv) {
         }
     }
 }
+
+TEST(dv, Arena) {
+    dv::value outer;
+    std::weak_ptr<dv::Arena> weak;
+    {
+        auto arena = std::make_shared<dv::Arena>();
+        weak = arena;
+        dv::ArenaScope scope(arena);
+        auto list = dv::list();
+        for (int i = 0; i < 1000; i++) {
+            auto& object = list.object();
+            object["index"] = i;
+            object["name"] = "entity";
+            object.list("position").add(i * 0.5);
+        }
+        EXPECT_GT(arena->getAllocated(), 0);
+        outer = list;
+    }
+    EXPECT_EQ(dv::current_arena(), nullptr);
+    // containers keep the arena alive
+    EXPECT_FALSE(weak.expired());
+    EXPECT_EQ(outer.size(), 1000);
+    EXPECT_EQ(outer[999]["index"].asInteger(), 999);
+    EXPECT_EQ(outer[10]["position"][0].asNumber(), 5.0);
+    outer = nullptr;
+    EXPECT_TRUE(weak.expired());
+}
@@ -0,0 +1,23 @@
+#include <gtest/gtest.h>
+
+#include "debug/MemoryUsage.hpp"
+
+using namespace debug;
+
+TEST(MemoryUsage, Sources) {
+    auto& usage = MemoryUsage::getInstance();
+    {
+        MemorySource first([](MemoryBreakdown& breakdown) {
+            breakdown["test.shared"] += 100;
+        });
+        MemorySource second([](MemoryBreakdown& breakdown) {
+            breakdown["test.shared"] += 20;
+            breakdown["test.own"] += 3;
+        });
+        auto breakdown = usage.collect();
+        EXPECT_EQ(breakdown["test.shared"], 120);
+        EXPECT_EQ(breakdown["test.own"], 3);
+    }
+    auto breakdown = usage.collect();
+    EXPECT_EQ(breakdown.find("test.shared"), breakdown.end());
+}
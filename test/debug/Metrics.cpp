@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include "debug/Metrics.hpp"
+
+using namespace debug;
+
+TEST(Metrics, Histogram) {
+    Histogram histogram;
+    for (int i = 1; i <= 100; i++) {
+        histogram.record(i);
+    }
+    EXPECT_EQ(histogram.getCount(), 100);
+    EXPECT_EQ(histogram.getSum(), 5050);
+    EXPECT_EQ(histogram.getMax(), 100);
+    // quantiles are upper bounds of power of two buckets
+    EXPECT_EQ(histogram.quantile(0.5), 63);
+    EXPECT_EQ(histogram.quantile(0.99), 100);
+    EXPECT_EQ(Histogram().quantile(0.5), 0);
+}
+
+TEST(Metrics, Registry) {
+    Metrics metrics;
+    metrics.counter("reads").add(3);
+    metrics.counter("reads").add();
+    metrics.gauge("entities").set(42);
+    metrics.histogram("load").record(10);
+
+    auto value = metrics.toValue();
+    EXPECT_EQ(value["counters"]["reads"].asInteger(), 4);
+    EXPECT_EQ(value["gauges"]["entities"].asInteger(), 42);
+    EXPECT_EQ(value["histograms"]["load"]["count"].asInteger(), 1);
+    EXPECT_EQ(value["histograms"]["load"]["max"].asInteger(), 10);
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "debug/Profiler.hpp"
+
+using namespace debug;
+
+TEST(Profiler, NestedPasses) {
+    Profiler profiler;
+    profiler.setEnabled(true, false);
+    const int frames = Profiler::FRAMES_LATENCY + 2;
+    for (int i = 0; i < frames; i++) {
+        profiler.beginFrame();
+        {
+            ProfileScope world("world", profiler);
+            ProfileScope chunks("chunks", profiler);
+        }
+        ProfileScope ui("ui", profiler);
+        profiler.endFrame();
+    }
+    const auto& passes = profiler.getPasses();
+    ASSERT_EQ(passes.size(), 4);
+    EXPECT_EQ(passes[0].path, "frame");
+    EXPECT_EQ(passes[0].depth, 0);
+    EXPECT_EQ(passes[2].path, "frame/world/chunks");
+    EXPECT_EQ(passes[2].depth, 2);
+    EXPECT_EQ(passes[3].path, "frame/ui");
+    EXPECT_NE(profiler.getPass("frame/world"), nullptr);
+    EXPECT_EQ(profiler.getPass("world"), nullptr);
+
+    // frames are read back with latency and not measured on GPU
+    auto trace = profiler.toChromeTrace();
+    const auto& events = trace["traceEvents"];
+    size_t resolved = frames - Profiler::FRAMES_LATENCY;
+    EXPECT_EQ(events.size(), resolved * passes.size());
+    for (const auto& event : events) {
+        EXPECT_EQ(event["tid"].asInteger(), 0);
+        EXPECT_GE(event["dur"].asInteger(), 0);
+    }
+}
+
+TEST(Profiler, Disabled) {
+    Profiler profiler;
+    profiler.beginFrame();
+    {
+        ProfileScope scope("pass", profiler);
+    }
+    profiler.endFrame();
+    EXPECT_TRUE(profiler.getPasses().empty());
+}
+
+TEST(Profiler, ThreadZones) {
+    Profiler profiler;
+    profiler.setEnabled(true, false);
+    profiler.beginFrame();
+    {
+        ProfileZone update("update", profiler);
+        std::thread([&profiler]() {
+            ProfileZone task("task", profiler);
+        }).join();
+    }
+    profiler.endFrame();
+
+    // main thread zones are passes, other thread zones go to the trace
+    EXPECT_NE(profiler.getPass("frame/update"), nullptr);
+    EXPECT_EQ(profiler.getPasses().size(), 2);
+    auto trace = profiler.toChromeTrace();
+    const auto& events = trace["traceEvents"];
+    ASSERT_EQ(events.size(), 1);
+    EXPECT_EQ(events[0]["name"].asString(), "task");
+    EXPECT_GE(events[0]["tid"].asInteger(), 2);
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include "devtools/syntax_highlighting.hpp"
+#include "graphics/core/Font.hpp"
+
+static void expect_same_styles(
+    const std::string& source, const FontStylesScheme& styles
+) {
+    auto expected = devtools::syntax_highlight("lua", source);
+    ASSERT_NE(expected, nullptr);
+    for (size_t i = 0; i < source.length(); i++) {
+        auto expectedStyle = expected->map.at(
+            std::min(expected->map.size() - 1, i)
+        );
+        ASSERT_EQ(styles.map.at(i), expectedStyle) << "at " << i;
+    }
+}
+
+TEST(SyntaxHighlighter, IncrementalEdits) {
+    std::string source =
+        "local x = 10 -- comment\n"
+        "function f(a, b)\n"
+        "    return a .. \"text\"\n"
+        "end\n"
+        "local s = [[long\n"
+        "string]]\n"
+        "print(f(x, 'y'))\n";
+    devtools::SyntaxHighlighter highlighter("lua");
+    auto styles = highlighter.update(source);
+    ASSERT_NE(styles, nullptr);
+    expect_same_styles(source, *styles);
+
+    const std::pair<size_t, std::string> inserts[] {
+        {source.find("return"), "if a then end\n    "},
+        {source.find("10"), "5 + "},
+        {0, "-- header\n"},
+        // opens a long string swallowing next lines
+        {source.find("print"), "local t = [["},
+        {source.find("print"), "]] "},
+    };
+    for (const auto& [pos, text] : inserts) {
+        source.insert(pos, text);
+        styles = highlighter.update(source);
+        ASSERT_NE(styles, nullptr);
+        expect_same_styles(source, *styles);
+    }
+    // erase lines
+    size_t start = source.find("function");
+    source.erase(start, source.find("end\n") + 4 - start);
+    styles = highlighter.update(source);
+    ASSERT_NE(styles, nullptr);
+    expect_same_styles(source, *styles);
+}
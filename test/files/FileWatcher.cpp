@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include "files/FileWatcher.hpp"
+
+static void write_file(const fs::path& file, const std::string& text) {
+    std::ofstream stream(file, std::ios::binary);
+    stream << text;
+}
+
+TEST(FileWatcher, ChangedAndAddedFiles) {
+    fs::path folder = fs::temp_directory_path() / "vc_file_watcher_test";
+    fs::remove_all(folder);
+    fs::create_directories(folder / "textures");
+    write_file(folder / "a.json", "{}");
+    write_file(folder / "textures" / "b.png", "b");
+
+    FileWatcher watcher({folder, folder / "missing"});
+    EXPECT_TRUE(watcher.poll().empty());
+
+    write_file(folder / "textures" / "b.png", "bb");
+    write_file(folder / "c.lua", "");
+    auto changed = watcher.poll();
+    std::sort(changed.begin(), changed.end());
+    ASSERT_EQ(changed.size(), 2);
+    EXPECT_EQ(changed[0], folder / "c.lua");
+    EXPECT_EQ(changed[1], folder / "textures" / "b.png");
+
+    fs::remove(folder / "a.json");
+    std::vector<fs::path> removed;
+    EXPECT_TRUE(watcher.poll(&removed).empty());
+    ASSERT_EQ(removed.size(), 1);
+    EXPECT_EQ(removed[0], folder / "a.json");
+    fs::remove_all(folder);
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+
+#include "files/WorldRegions.hpp"
+
+static std::unique_ptr<ubyte[]> create_data(uint32_t size, ubyte value) {
+    auto data = std::make_unique<ubyte[]>(size);
+    std::memset(data.get(), value, size);
+    return data;
+}
+
+static void expect_data(
+    RegionsLayer& layer, int x, int z, uint32_t size, ubyte value
+) {
+    bool found = layer.readData(
+        x, z, [=](const ubyte* data, uint32_t dataSize, uint32_t srcSize) {
+            ASSERT_EQ(dataSize, size);
+            EXPECT_EQ(srcSize, size);
+            for (uint32_t i = 0; i < size; i++) {
+                ASSERT_EQ(data[i], value);
+            }
+        }
+    );
+    EXPECT_TRUE(found);
+}
+
+TEST(RegionsLayer, AppendInPlace) {
+    auto folder = fs::temp_directory_path() / "regions_layer_test";
+    fs::remove_all(folder);
+    auto filename = folder / "0_0.bin";
+    {
+        RegionsLayer layer {};
+        layer.folder = folder;
+        layer.put(0, 0, create_data(20'000, 1), 20'000);
+        layer.writeAll();
+        size_t written = fs::file_size(filename);
+
+        layer.put(1, 0, create_data(20'000, 2), 20'000);
+        layer.put(0, 0, create_data(20'000, 3), 20'000);
+        layer.writeAll();
+        // entries and the new table are appended after the previous table
+        EXPECT_EQ(
+            fs::file_size(filename),
+            written + 2 * (20'000 + 8) + REGION_CHUNKS_COUNT * 8
+        );
+    }
+    {
+        // bytes left by an interrupted append are ignored
+        std::ofstream file(filename, std::ios::binary | std::ios::app);
+        file << std::string(1000, 'x');
+    }
+    RegionsLayer layer {};
+    layer.folder = folder;
+    expect_data(layer, 0, 0, 20'000, 3);
+    expect_data(layer, 1, 0, 20'000, 2);
+    fs::remove_all(folder);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "files/WorldArchive.hpp"
+#include "files/files.hpp"
+
+static fs::path create_world(const fs::path& folder) {
+    fs::remove_all(folder);
+    fs::create_directories(folder / "regions");
+    fs::create_directories(folder / "lights");
+    files::write_string(folder / "world.json", "{\"name\": \"test\"}");
+    for (int x = -2; x < 2; x++) {
+        for (int z = -2; z < 2; z++) {
+            std::vector<ubyte> data(1000 + x * 10 + z);
+            for (size_t i = 0; i < data.size(); i++) {
+                data[i] = (i * 31 + x * 7 + z) % 13;
+            }
+            auto name = std::to_string(x) + "_" + std::to_string(z) + ".bin";
+            files::write_bytes(
+                folder / "regions" / name, data.data(), data.size()
+            );
+            files::write_bytes(
+                folder / "lights" / name, data.data(), data.size() / 2
+            );
+        }
+    }
+    return folder;
+}
+
+TEST(WorldArchive, ExportImport) {
+    auto temp = fs::temp_directory_path() / "world_archive_test";
+    auto source = create_world(temp / "source");
+    auto archive = temp / "world.varc";
+    auto target = temp / "target";
+
+    auto exported = world_archive::export_world(source, archive, 3);
+    EXPECT_EQ(exported.files, 33);
+
+    auto index = world_archive::read_index(archive);
+    ASSERT_EQ(index.size(), 33);
+    EXPECT_EQ(index[0].path, "world.json");
+    // layers of the same region are placed together
+    EXPECT_EQ(index[1].path, "lights/-2_-2.bin");
+    EXPECT_EQ(index[2].path, "regions/-2_-2.bin");
+
+    auto imported = world_archive::import_world(archive, target, 2);
+    EXPECT_EQ(imported.bytes, exported.bytes);
+    for (const auto& entry : fs::recursive_directory_iterator(source)) {
+        if (entry.is_regular_file()) {
+            auto path = target / fs::relative(entry.path(), source);
+            EXPECT_EQ(
+                files::read_bytes(entry.path()), files::read_bytes(path)
+            );
+        }
+    }
+    // target folder is not empty
+    EXPECT_THROW(
+        world_archive::import_world(archive, target, 2), std::runtime_error
+    );
+
+    {
+        std::fstream file(
+            archive, std::ios::in | std::ios::out | std::ios::binary
+        );
+        file.seekp(index[5].offset + 12);
+        file.put(0x5A);
+    }
+    fs::remove_all(target);
+    EXPECT_THROW(
+        world_archive::import_world(archive, target, 2), std::runtime_error
+    );
+    fs::remove_all(temp);
+}
+
+TEST(WorldArchive, ImportOversizedEntry) {
+    auto temp = fs::temp_directory_path() / "world_archive_oversized_test";
+    auto source = create_world(temp / "source");
+    auto archive = temp / "world.varc";
+    auto target = temp / "target";
+
+    world_archive::export_world(source, archive, 1);
+    auto index = world_archive::read_index(archive);
+    {
+        // gzip footer declaring a much larger decompressed size
+        std::fstream file(
+            archive, std::ios::in | std::ios::out | std::ios::binary
+        );
+        file.seekp(index[1].offset + index[1].size - 4);
+        const char size[] {0, 0, 0, 0x7F};
+        file.write(size, sizeof(size));
+    }
+    EXPECT_THROW(
+        world_archive::import_world(archive, target, 1), std::runtime_error
+    );
+    fs::remove_all(temp);
+}
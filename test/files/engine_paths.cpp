@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "files/engine_paths.hpp"
+#include "files/files.hpp"
+
+TEST(ResPaths, IndexedLookups) {
+    fs::path folder = fs::temp_directory_path() / "vc_res_paths_test";
+    fs::remove_all(folder);
+    fs::create_directories(folder / "core" / "textures");
+    fs::create_directories(folder / "pack" / "textures");
+    files::write_string(folder / "core" / "textures" / "a.png", "");
+    files::write_string(folder / "core" / "textures" / "b.png", "");
+    files::write_string(folder / "pack" / "textures" / "b.png", "");
+
+    ResPaths paths(
+        folder / "core",
+        {{"core", folder / "core"}, {"pack", folder / "pack"}}
+    );
+    EXPECT_EQ(paths.find("textures/a.png"), folder / "core/textures/a.png");
+    EXPECT_EQ(paths.find("textures/b.png"), folder / "pack/textures/b.png");
+    EXPECT_EQ(paths.find("./textures/b.png"), folder / "pack/./textures/b.png");
+    EXPECT_EQ(paths.findRaw("textures/a.png"), "core:textures/a.png");
+    EXPECT_THROW(paths.findRaw("textures/c.png"), std::runtime_error);
+
+    auto entries = paths.listdirRaw("textures");
+    std::sort(entries.begin(), entries.end());
+    ASSERT_EQ(entries.size(), 3);
+    EXPECT_EQ(entries[0], "core:textures/a.png");
+    EXPECT_EQ(entries[2], "pack:textures/b.png");
+
+    files::write_string(folder / "pack" / "textures" / "c.png", "");
+    EXPECT_EQ(paths.listdir("textures").size(), 3);
+    paths.refresh();
+    EXPECT_EQ(paths.listdir("textures").size(), 4);
+    EXPECT_EQ(paths.findRaw("textures/c.png"), "pack:textures/c.png");
+    fs::remove_all(folder);
+}
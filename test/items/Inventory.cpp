@@ -0,0 +1,24 @@
+#include <gtest/gtest.h>
+
+#include "items/Inventory.hpp"
+
+TEST(Inventory, EncodeDecode) {
+    Inventory inventory(5, 3);
+    inventory.getSlot(1).set(ItemStack(2, 10));
+    auto bytes = inventory.encode();
+    EXPECT_EQ(inventory.encode(), bytes);
+
+    // slot is modified via reference
+    inventory.getSlot(2).set(ItemStack(3, 1));
+    EXPECT_NE(inventory.encode(), bytes);
+
+    Inventory decoded;
+    const auto& encoded = inventory.encode();
+    decoded.decode(encoded.data(), encoded.size());
+    EXPECT_EQ(decoded.getId(), 5);
+    EXPECT_EQ(decoded.size(), 3);
+    EXPECT_EQ(decoded.getSlot(1).getItemId(), 2);
+    EXPECT_EQ(decoded.getSlot(1).getCount(), 10);
+    EXPECT_EQ(decoded.getSlot(2).getItemId(), 3);
+    EXPECT_EQ(decoded.encode(), encoded);
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include "content/Content.hpp"
+#include "lighting/Lighting.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+
+TEST(Lighting, PrebuildSkyLight) {
+    Block air("core:air");
+    air.skyLightPassing = true;
+    Block stone("base:stone");
+    Block glass("base:glass");
+    glass.skyLightPassing = true;
+    ContentIndices indices(
+        std::vector<Block*> {&air, &stone, &glass},
+        std::vector<ItemDef*> {},
+        std::vector<EntityDef*> {}
+    );
+    Chunk chunk(0, 0);
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            int height = (x * 7 + z * 3) % 40;
+            for (int y = 0; y < height; y++) {
+                chunk.voxels[vox_index(x, y, z)].id = y % 3 ? 1 : 2;
+            }
+        }
+    }
+    Lighting::prebuildSkyLight(&chunk, &indices);
+
+    int highestPoint = 0;
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            bool open = true;
+            for (int y = CHUNK_H - 1; y >= 0; y--) {
+                auto id = chunk.voxels[vox_index(x, y, z)].id;
+                if (open && id == 1) {
+                    open = false;
+                    highestPoint = std::max(highestPoint, y);
+                }
+                EXPECT_EQ(chunk.lightmap.getS(x, y, z), open ? 15 : 0);
+            }
+        }
+    }
+    EXPECT_EQ(chunk.lightmap.highestPoint, highestPoint + 1);
+}
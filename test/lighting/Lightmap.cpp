@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+
+#include "lighting/Lightmap.hpp"
+
+TEST(Lightmap, Compact) {
+    Lightmap lightmap;
+    light_t* lights = lightmap.getLightsWriteable();
+    // sky above, darkness below and a varying section between
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        uint section = i / CHUNK_SECTION_VOL;
+        if (section > 4) {
+            lights[i] = Lightmap::combine(0, 0, 0, 15);
+        } else if (section == 4) {
+            lights[i] = i % 17;
+        }
+    }
+    EXPECT_TRUE(lightmap.compact());
+    EXPECT_TRUE(lightmap.isCompact());
+    EXPECT_LT(lightmap.getMemoryUsage(), CHUNK_VOL * sizeof(light_t) / 4);
+
+    auto copy = lightmap.read();
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        uint section = i / CHUNK_SECTION_VOL;
+        light_t expected = 0;
+        if (section > 4) {
+            expected = Lightmap::combine(0, 0, 0, 15);
+        } else if (section == 4) {
+            expected = i % 17;
+        }
+        EXPECT_EQ(lightmap.get(i), expected);
+        EXPECT_EQ(copy[i], expected);
+    }
+    EXPECT_TRUE(lightmap.isCompact());
+
+    lightmap.set(1, 2, 3, 0, 7);
+    EXPECT_FALSE(lightmap.isCompact());
+    EXPECT_EQ(lightmap.get(1, 2, 3, 0), 7);
+    EXPECT_EQ(lightmap.getS(0, CHUNK_H - 1, 0), 15);
+}
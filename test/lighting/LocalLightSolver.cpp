@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "content/Content.hpp"
+#include "lighting/LocalLightSolver.hpp"
+#include "maths/voxmaths.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+
+TEST(LocalLightSolver, SpreadsOverNeighbours) {
+    Block air("core:air");
+    air.lightPassing = true;
+    ContentIndices indices(
+        std::vector<Block*> {&air},
+        std::vector<ItemDef*> {},
+        std::vector<EntityDef*> {}
+    );
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    for (int z = -1; z <= 1; z++) {
+        for (int x = -1; x <= 1; x++) {
+            chunks.push_back(std::make_unique<Chunk>(x, z));
+        }
+    }
+    LocalLightSolver solver(&indices, 0);
+    solver.setCenter(0, 0, [&chunks](int32_t x, int32_t z) -> Chunk* {
+        if (x < -1 || x > 1 || z < -1 || z > 1) {
+            return nullptr;
+        }
+        return chunks[(z + 1) * 3 + x + 1].get();
+    });
+    const int sx = CHUNK_W - 2;
+    const int sy = 10;
+    const int sz = 1;
+    solver.add(sx, sy, sz, 15);
+    solver.solve();
+
+    for (int z = -CHUNK_D; z < CHUNK_D * 2; z++) {
+        for (int x = -CHUNK_W; x < CHUNK_W * 2; x++) {
+            int distance = std::abs(x - sx) + std::abs(z - sz) + 1;
+            int expected = std::max(0, 15 - distance);
+            const auto& chunk = chunks[
+                (floordiv(z, CHUNK_D) + 1) * 3 + floordiv(x, CHUNK_W) + 1
+            ];
+            int light = chunk->lightmap.get(
+                x - chunk->x * CHUNK_W, sy + 1, z - chunk->z * CHUNK_D, 0
+            );
+            EXPECT_EQ(light, expected);
+        }
+    }
+}
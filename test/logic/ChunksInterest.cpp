@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include "logic/ChunksInterest.hpp"
+
+TEST(ChunksInterest, SingleViewerMatrix) {
+    ChunksInterest interest(64);
+    EXPECT_TRUE(interest.addViewer(10, -3, 8));
+
+    glm::ivec2 center;
+    EXPECT_EQ(interest.getMatrix(2, center), 20);
+    EXPECT_EQ(center, glm::ivec2(10, -3));
+
+    EXPECT_EQ(interest.getDistance2(10, -3), 0);
+    EXPECT_EQ(interest.getDistance2(12, -2), 5);
+    // area is a circle
+    EXPECT_EQ(interest.getDistance2(17, 4), -1);
+    EXPECT_EQ(interest.getRefs(17, 4), 0);
+}
+
+TEST(ChunksInterest, SharedAreas) {
+    ChunksInterest interest(40);
+    EXPECT_TRUE(interest.addViewer(0, 0, 8));
+    EXPECT_TRUE(interest.addViewer(11, 0, 8));
+    // does not fit the max span with the main viewer
+    EXPECT_FALSE(interest.addViewer(100, 0, 8));
+    EXPECT_EQ(interest.size(), 2);
+
+    EXPECT_EQ(interest.getRefs(5, 0), 2);
+    EXPECT_EQ(interest.getRefs(-5, 0), 1);
+    EXPECT_EQ(interest.getDistance2(7, 0), 16);
+
+    glm::ivec2 center;
+    int size = interest.getMatrix(2, center);
+    // matrix covers [-8 - 2, 19 + 2) on the x axis
+    EXPECT_LE(center.x - size / 2, -10);
+    EXPECT_GE(center.x + size / 2, 21);
+    EXPECT_EQ(size % 2, 0);
+}
+
+TEST(ChunksInterest, ViewDirectionPriority) {
+    ChunksInterest interest(64);
+    EXPECT_TRUE(interest.addViewer(0, 0, 8, glm::vec2(1.0f, 0.0f)));
+
+    EXPECT_FLOAT_EQ(interest.getLoadDistance2(0, 0), 0.0f);
+    EXPECT_FLOAT_EQ(interest.getLoadDistance2(3, 0), 9.0f);
+    // chunks behind the viewer are loaded after farther ones in front
+    EXPECT_GT(interest.getLoadDistance2(-2, 0), 9.0f);
+    EXPECT_GT(interest.getLoadDistance2(0, 2), 4.0f);
+    EXPECT_LT(
+        interest.getLoadDistance2(0, 2), interest.getLoadDistance2(-2, 0)
+    );
+    EXPECT_FLOAT_EQ(interest.getLoadDistance2(20, 0), -1.0f);
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "content/Content.hpp"
+#include "logic/FluidsController.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+
+class FluidsControllerTest : public ::testing::Test {
+protected:
+    static constexpr blockid_t AIR = 0;
+    static constexpr blockid_t STONE = 1;
+    static constexpr blockid_t WATER = 2;
+
+    Block air {"core:air"};
+    Block stone {"base:stone"};
+    Block water {"base:water"};
+    std::unique_ptr<ContentIndices> indices;
+    Chunk chunk {0, 0};
+    FluidsController::ChunkGetter getChunk =
+        [this](int32_t x, int32_t z) -> const Chunk* {
+        return x == 0 && z == 0 ? &chunk : nullptr;
+    };
+
+    void SetUp() override {
+        stone.rt.id = STONE;
+        water.rt.id = WATER;
+        air.replaceable = true;
+        water.replaceable = true;
+        water.fluidSpread = 3;
+        indices = std::make_unique<ContentIndices>(
+            std::vector<Block*> {&air, &stone, &water},
+            std::vector<ItemDef*> {},
+            std::vector<EntityDef*> {}
+        );
+        // stone floor
+        for (int z = 0; z < CHUNK_D; z++) {
+            for (int x = 0; x < CHUNK_W; x++) {
+                chunk.voxels[vox_index(x, 0, z)].id = STONE;
+            }
+        }
+    }
+
+    void setFluid(const glm::ivec3& pos, uint distance) {
+        auto& vox = chunk.voxels[vox_index(pos.x, pos.y, pos.z)];
+        vox.id = WATER;
+        vox.state.userbits = distance;
+    }
+
+    std::vector<BlockEdit> solve(const std::vector<glm::ivec3>& cells) {
+        std::vector<BlockEdit> edits;
+        FluidsController::solve(
+            *indices, getChunk, cells.data(), cells.size(), edits
+        );
+        return edits;
+    }
+
+    static const BlockEdit* find(
+        const std::vector<BlockEdit>& edits, const glm::ivec3& pos
+    ) {
+        auto found = std::find_if(
+            edits.begin(), edits.end(), [&pos](const BlockEdit& edit) {
+                return edit.pos == pos;
+            }
+        );
+        return found == edits.end() ? nullptr : &*found;
+    }
+};
+
+TEST_F(FluidsControllerTest, SourceFalls) {
+    setFluid({5, 10, 5}, 0);
+    auto edits = solve({{5, 10, 5}});
+    // falling fluid does not spread horizontally
+    ASSERT_EQ(edits.size(), 1);
+    EXPECT_EQ(edits[0].pos, glm::ivec3(5, 9, 5));
+    EXPECT_EQ(edits[0].id, WATER);
+    EXPECT_EQ(edits[0].state.userbits, 1);
+}
+
+TEST_F(FluidsControllerTest, SourceSpreadsOnFloor) {
+    setFluid({5, 1, 5}, 0);
+    auto edits = solve({{5, 1, 5}});
+    ASSERT_EQ(edits.size(), 4);
+    for (const auto& pos : {glm::ivec3(4, 1, 5),
+                            glm::ivec3(6, 1, 5),
+                            glm::ivec3(5, 1, 4),
+                            glm::ivec3(5, 1, 6)}) {
+        auto edit = find(edits, pos);
+        ASSERT_NE(edit, nullptr);
+        EXPECT_EQ(edit->id, WATER);
+        EXPECT_EQ(edit->state.userbits, 1);
+    }
+}
+
+TEST_F(FluidsControllerTest, SpreadDistanceLimit) {
+    setFluid({5, 1, 5}, 2);
+    setFluid({6, 1, 5}, 3);
+    // supplied by the source side neighbour
+    setFluid({4, 1, 5}, 1);
+    auto edits = solve({{5, 1, 5}, {6, 1, 5}});
+    // distance 2 cell spreads to the free sides only
+    EXPECT_NE(find(edits, {5, 1, 4}), nullptr);
+    EXPECT_NE(find(edits, {5, 1, 6}), nullptr);
+    EXPECT_EQ(find(edits, {5, 1, 4})->state.userbits, 3);
+    // cell at the spread distance does not spread
+    EXPECT_EQ(find(edits, {7, 1, 5}), nullptr);
+    EXPECT_EQ(find(edits, {6, 1, 5}), nullptr);
+    EXPECT_EQ(find(edits, {5, 1, 5}), nullptr);
+}
+
+TEST_F(FluidsControllerTest, FlowWithoutSupplierDisappears) {
+    setFluid({5, 1, 5}, 2);
+    auto edits = solve({{5, 1, 5}});
+    ASSERT_EQ(edits.size(), 1);
+    EXPECT_EQ(edits[0].pos, glm::ivec3(5, 1, 5));
+    EXPECT_EQ(edits[0].id, AIR);
+}
+
+TEST_F(FluidsControllerTest, DistanceTakenFromNearestSupplier) {
+    setFluid({5, 1, 5}, 3);
+    setFluid({4, 1, 5}, 1);
+    setFluid({6, 1, 5}, 2);
+    auto edits = solve({{5, 1, 5}});
+    auto edit = find(edits, {5, 1, 5});
+    ASSERT_NE(edit, nullptr);
+    EXPECT_EQ(edit->id, WATER);
+    EXPECT_EQ(edit->state.userbits, 2);
+}
+
+TEST_F(FluidsControllerTest, FallingCellSuppliedFromAbove) {
+    setFluid({5, 5, 5}, 0);
+    setFluid({5, 4, 5}, 1);
+    auto edits = solve({{5, 4, 5}});
+    // keeps falling distance and falls further
+    EXPECT_EQ(find(edits, {5, 4, 5}), nullptr);
+    auto edit = find(edits, {5, 3, 5});
+    ASSERT_NE(edit, nullptr);
+    EXPECT_EQ(edit->state.userbits, 1);
+
+    // supplier is removed
+    chunk.voxels[vox_index(5, 5, 5)].id = AIR;
+    edits = solve({{5, 4, 5}});
+    edit = find(edits, {5, 4, 5});
+    ASSERT_NE(edit, nullptr);
+    EXPECT_EQ(edit->id, AIR);
+}
+
+TEST_F(FluidsControllerTest, NotLoadedChunks) {
+    setFluid({0, 1, 5}, 0);
+    auto edits = solve({{0, 1, 5}});
+    // no edits outside of the loaded chunk
+    EXPECT_EQ(edits.size(), 3);
+    EXPECT_EQ(find(edits, {-1, 1, 5}), nullptr);
+}
@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "maths/FrustumCulling.hpp"
+
+TEST(FrustumCulling, BoxesVisibility) {
+    glm::mat4 proj = glm::perspective(glm::radians(70.0f), 1.5f, 0.1f, 500.0f);
+    glm::mat4 view = glm::lookAt(
+        glm::vec3(3.0f, 80.0f, -5.0f),
+        glm::vec3(40.0f, 60.0f, 30.0f),
+        glm::vec3(0.0f, 1.0f, 0.0f)
+    );
+    Frustum frustum;
+    frustum.update(proj * view);
+
+    PackedBoxes boxes;
+    for (int z = -20; z < 20; z++) {
+        for (int x = -20; x < 21; x++) {
+            glm::vec3 min(x * 16, (x * 7 + z * 3) % 50, z * 16);
+            boxes.push(min, min + glm::vec3(16, 100, 16));
+        }
+    }
+    std::vector<uint8_t> visible;
+    frustum.areBoxesVisible(boxes, visible);
+    ASSERT_EQ(visible.size(), boxes.size());
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        glm::vec3 min(boxes.minX[i], boxes.minY[i], boxes.minZ[i]);
+        glm::vec3 max(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]);
+        EXPECT_EQ(visible[i] != 0, frustum.isBoxVisible(min, max));
+        visibleCount += visible[i];
+    }
+    EXPECT_GT(visibleCount, 0);
+    EXPECT_LT(visibleCount, boxes.size());
+}
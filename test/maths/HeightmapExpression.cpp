@@ -0,0 +1,44 @@
+#include "maths/HeightmapExpression.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "coders/commons.hpp"
+
+TEST(HeightmapExpression, Evaluate) {
+    const size_t count = 150;
+    std::vector<float> a(count);
+    std::vector<float> b(count);
+    for (size_t i = 0; i < count; i++) {
+        a[i] = i * 0.01f - 0.5f;
+        b[i] = 1.0f - i * 0.005f;
+    }
+    std::vector<float> dst = a;
+    HeightmapExpression expression(
+        "mix(value, b, 0.25) * 2 - abs(-a) / k + clamp(a, 0, 0.5)"
+        " + max(b^2, min(a, 0.1)) - 2^-1",
+        {{"a", a.data()}, {"b", b.data()}, {"k", 4.0f}, {"value", dst.data()}}
+    );
+    expression.evaluate(dst.data(), count);
+    for (size_t i = 0; i < count; i++) {
+        float x = a[i];
+        float y = b[i];
+        float expected = (x * 0.75f + y * 0.25f) * 2 - std::abs(x) / 4.0f +
+                         std::min(std::max(x, 0.0f), 0.5f) +
+                         std::max(std::pow(y, 2.0f), std::min(x, 0.1f)) - 0.5f;
+        EXPECT_NEAR(dst[i], expected, 1e-5f) << i;
+    }
+}
+
+TEST(HeightmapExpression, Errors) {
+    float value = 0.0f;
+    std::unordered_map<std::string, HeightmapExpression::Variable> variables {
+        {"value", &value}};
+    EXPECT_THROW(HeightmapExpression("value +", variables), parsing_error);
+    EXPECT_THROW(HeightmapExpression("value + x", variables), parsing_error);
+    EXPECT_THROW(HeightmapExpression("sin(value)", variables), parsing_error);
+    EXPECT_THROW(HeightmapExpression("min(value)", variables), parsing_error);
+    EXPECT_THROW(HeightmapExpression("(value", variables), parsing_error);
+    EXPECT_THROW(HeightmapExpression("value value", variables), parsing_error);
+}
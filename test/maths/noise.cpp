@@ -0,0 +1,54 @@
+#include "maths/noise.hpp"
+
+#include <gtest/gtest.h>
+
+#include "maths/FastNoiseLite.h"
+
+static void check_noise(noise::NoiseType type, fnl_noise_type fnlType) {
+    const uint width = 37;
+    const uint height = 23;
+    const glm::vec2 offset(-543.0f, 71.0f);
+    const float scale = 0.35f;
+    const int octaves = 4;
+    const float multiplier = 0.7f;
+
+    std::vector<float> shift(width * height);
+    for (uint i = 0; i < shift.size(); i++) {
+        shift[i] = (i % 7) * 0.3f - 1.0f;
+    }
+    std::vector<float> values(width * height, 0.25f);
+    noise::add_fractal(
+        type, 1234, 0.01f, values.data(), width, height, offset,
+        scale, octaves, multiplier, shift.data(), nullptr
+    );
+
+    fnl_state state = fnlCreateState();
+    state.seed = 1234;
+    state.noise_type = fnlType;
+    for (uint y = 0; y < height; y++) {
+        for (uint x = 0; x < width; x++) {
+            uint i = y * width + x;
+            float expected = 0.25f;
+            for (int c = 0; c < octaves; c++) {
+                float m = scale * (1 << c);
+                float u = (x + offset.x) * m + shift[i];
+                float v = (y + offset.y) * m;
+                expected += fnlGetNoise2D(&state, u, v) /
+                            static_cast<float>(1 << c) * multiplier;
+            }
+            EXPECT_NEAR(values[i], expected, 1e-5f) << x << ", " << y;
+        }
+    }
+}
+
+TEST(noise, Simplex) {
+    check_noise(noise::NoiseType::SIMPLEX, FNL_NOISE_OPENSIMPLEX2);
+}
+
+TEST(noise, Perlin) {
+    check_noise(noise::NoiseType::PERLIN, FNL_NOISE_PERLIN);
+}
+
+TEST(noise, Cellular) {
+    check_noise(noise::NoiseType::CELLULAR, FNL_NOISE_CELLULAR);
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include "util/AdaptiveBudget.hpp"
+
+TEST(AdaptiveBudget, GrowsWithSlack) {
+    util::AdaptiveBudget budget(1000, 500, 8000);
+    for (int i = 0; i < 100; i++) {
+        budget.spend(budget.get());
+        budget.update(4000, 16000);
+    }
+    EXPECT_EQ(budget.get(), 8000);
+    EXPECT_EQ(budget.getLeft(), 8000);
+}
+
+TEST(AdaptiveBudget, ShrinksUnderLoad) {
+    util::AdaptiveBudget budget(4000, 500, 8000);
+    budget.spend(4000);
+    budget.update(20000, 16000);
+    EXPECT_LT(budget.get(), 4000);
+    EXPECT_EQ(budget.getLastSpent(), 4000);
+    for (int i = 0; i < 100; i++) {
+        budget.update(20000, 16000);
+    }
+    EXPECT_EQ(budget.get(), 500);
+}
+
+TEST(AdaptiveBudget, IdleDoesNotGrow) {
+    util::AdaptiveBudget budget(1000, 500, 8000);
+    for (int i = 0; i < 100; i++) {
+        budget.spend(100);
+        budget.update(4000, 16000);
+    }
+    EXPECT_EQ(budget.get(), 1000);
+
+    budget.setLimits(2000, 8000);
+    EXPECT_EQ(budget.get(), 2000);
+}
@@ -76,3 +76,39 @@ TEST(AreaMap2D, TranslateWithOut) {
     EXPECT_EQ(outside, 15);
     EXPECT_EQ(window.count(), 20);
 }
+
+TEST(AreaMap2D, RingTranslate) {
+    util::AreaMap2D<int> window(4, 3);
+    window.setCenter(0, 0);
+    int outside = 0;
+    window.setOutCallback([&outside](int x, int y, int value) {
+        EXPECT_EQ(value, x * 100 + y + 1000);
+        outside++;
+    });
+    // moving back and forth keeps values mapped to their positions
+    for (int step = 0; step < 20; step++) {
+        int cx = (step % 7) - 3;
+        int cy = (step % 5) - 2;
+        window.setCenter(cx, cy);
+        int ox = window.getOffsetX();
+        int oy = window.getOffsetY();
+        for (int y = oy; y < oy + 3; y++) {
+            for (int x = ox; x < ox + 4; x++) {
+                int value = window.get(x, y);
+                if (value) {
+                    EXPECT_EQ(value, x * 100 + y + 1000);
+                } else {
+                    window.set(x, y, x * 100 + y + 1000);
+                }
+                EXPECT_EQ(window.getLocal(x - ox, y - oy), x * 100 + y + 1000);
+            }
+        }
+        EXPECT_EQ(window.count(), 12);
+    }
+    EXPECT_GT(outside, 0);
+    // far jump releases everything
+    outside = 0;
+    window.setCenter(1000, 1000);
+    EXPECT_EQ(outside, 12);
+    EXPECT_EQ(window.count(), 0);
+}
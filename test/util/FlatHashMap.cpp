@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <unordered_map>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include "util/FlatHashMap.hpp"
+
+using namespace util;
+
+TEST(FlatHashMap, InsertFindErase) {
+    FlatHashMap<glm::ivec2, std::unique_ptr<int>> map;
+    std::unordered_map<glm::ivec2, int> expected;
+    for (int i = 0; i < 20'000; i++) {
+        glm::ivec2 key(rand() % 64 - 32, rand() % 64 - 32);
+        if (rand() % 3 == 0) {
+            EXPECT_EQ(map.erase(key), expected.erase(key));
+        } else {
+            map[key] = std::make_unique<int>(i);
+            expected[key] = i;
+        }
+    }
+    EXPECT_EQ(map.size(), expected.size());
+    for (const auto& [key, value] : expected) {
+        auto found = map.find(key);
+        ASSERT_NE(found, map.end());
+        EXPECT_EQ(*found->second, value);
+    }
+    size_t count = 0;
+    for (const auto& [key, value] : map) {
+        EXPECT_EQ(expected.at(key), *value);
+        count++;
+    }
+    EXPECT_EQ(count, expected.size());
+}
+
+TEST(FlatHashMap, EraseWhileIterating) {
+    FlatHashMap<int, int> map;
+    for (int i = 0; i < 1000; i++) {
+        map[i] = i;
+    }
+    for (auto it = map.begin(); it != map.end();) {
+        if (it->first % 2) {
+            it = map.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    EXPECT_EQ(map.size(), 500);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(map.count(i), i % 2 == 0);
+    }
+}
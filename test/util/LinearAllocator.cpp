@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "util/LinearAllocator.hpp"
+
+using namespace util;
+
+TEST(LinearAllocator, Alignment) {
+    LinearAllocator allocator(64);
+    allocator.allocate(1, 1);
+    auto doubles = allocator.allocate<double>(3);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(doubles) % alignof(double), 0);
+    auto bytes = static_cast<char*>(allocator.allocate(1, 1));
+    EXPECT_GE(bytes, reinterpret_cast<char*>(doubles + 3));
+    EXPECT_EQ(allocator.getUsed(), 2 + sizeof(double) * 3);
+}
+
+TEST(LinearAllocator, MergesBlocksOnReset) {
+    LinearAllocator allocator(64);
+    for (int i = 0; i < 10; i++) {
+        allocator.allocate(48);
+    }
+    size_t capacity = allocator.getCapacity();
+    EXPECT_GE(capacity, 480);
+    allocator.reset();
+    EXPECT_EQ(allocator.getUsed(), 0);
+    EXPECT_EQ(allocator.getCapacity(), capacity);
+
+    // the same workload is served by the merged block
+    auto first = static_cast<char*>(allocator.allocate(48));
+    for (int i = 1; i < 10; i++) {
+        allocator.allocate(48);
+    }
+    EXPECT_EQ(allocator.getCapacity(), capacity);
+    auto last = static_cast<char*>(allocator.allocate(1, 1));
+    EXPECT_LT(last - first, static_cast<ptrdiff_t>(capacity));
+}
+
+TEST(LinearAllocator, Vector) {
+    LinearAllocator allocator(256);
+    std::vector<int, ScratchAllocator<int>> values {
+        ScratchAllocator<int>(allocator)
+    };
+    for (int i = 0; i < 1000; i++) {
+        values.push_back(i);
+    }
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(values[i], i);
+    }
+    EXPECT_GE(allocator.getUsed(), sizeof(int) * 1000);
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "util/MPSCRing.hpp"
+
+using namespace util;
+
+TEST(MPSCRing, PushPop) {
+    MPSCRing<int> ring(4);
+    EXPECT_TRUE(ring.empty());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(ring.push(int(i)));
+    }
+    EXPECT_FALSE(ring.push(4));
+    int value;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(ring.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(ring.pop(value));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(MPSCRing, MultipleProducers) {
+    MPSCRing<int> ring(64);
+    const int producers = 4;
+    const int count = 1000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&ring]() {
+            for (int i = 1; i <= count; i++) {
+                while (!ring.push(int(i))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    long long sum = 0;
+    int received = 0;
+    while (received < producers * count) {
+        int value;
+        if (ring.pop(value)) {
+            sum += value;
+            received++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(sum, producers * (count * (count + 1LL) / 2));
+}
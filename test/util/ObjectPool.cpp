@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include "util/ObjectPool.hpp"
+
+using namespace util;
+
+struct PooledObject {
+    int value;
+
+    PooledObject(int value) : value(value) {
+    }
+
+    void reset(int value) {
+        this->value = value;
+    }
+};
+
+TEST(ObjectPool, Reuse) {
+    ObjectPool<PooledObject> pool(1);
+    PooledObject* address;
+    {
+        auto object = pool.get(1);
+        address = object.get();
+        EXPECT_EQ(object->value, 1);
+    }
+    auto object = pool.get(2);
+    EXPECT_EQ(object.get(), address);
+    EXPECT_EQ(object->value, 2);
+
+    auto other = pool.get(3);
+    EXPECT_NE(other.get(), address);
+
+    auto stats = pool.getStats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 2);
+    EXPECT_EQ(stats.free, 0);
+}
+
+TEST(ObjectPool, MaxFree) {
+    ObjectPool<PooledObject> pool(1);
+    {
+        auto a = pool.get(1);
+        auto b = pool.get(2);
+    }
+    EXPECT_EQ(pool.getStats().free, 1);
+}
+
+TEST(ObjectPool, OutlivePool) {
+    std::shared_ptr<PooledObject> object;
+    {
+        ObjectPool<PooledObject> pool(4);
+        object = pool.get(5);
+    }
+    EXPECT_EQ(object->value, 5);
+}
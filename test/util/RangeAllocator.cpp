@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include "util/RangeAllocator.hpp"
+
+TEST(RangeAllocator, AllocateFree) {
+    util::RangeAllocator allocator(100);
+    auto a = allocator.allocate(30);
+    auto b = allocator.allocate(30);
+    auto c = allocator.allocate(30);
+    ASSERT_TRUE(a && b && c);
+    EXPECT_EQ(*a, 0);
+    EXPECT_EQ(*b, 30);
+    EXPECT_EQ(*c, 60);
+    EXPECT_FALSE(allocator.allocate(20));
+    EXPECT_EQ(allocator.getUsed(), 90);
+
+    allocator.free(*b, 30);
+    auto d = allocator.allocate(20);
+    ASSERT_TRUE(d);
+    EXPECT_EQ(*d, 30);
+
+    allocator.free(*a, 30);
+    allocator.free(*d, 20);
+    allocator.free(*c, 30);
+    EXPECT_EQ(allocator.getUsed(), 0);
+    EXPECT_EQ(allocator.getFreeRangesCount(), 1);
+    auto e = allocator.allocate(100);
+    ASSERT_TRUE(e);
+    EXPECT_EQ(*e, 0);
+}
+
+TEST(RangeAllocator, Grow) {
+    util::RangeAllocator allocator(10);
+    auto a = allocator.allocate(8);
+    ASSERT_TRUE(a);
+    EXPECT_FALSE(allocator.allocate(4));
+    allocator.grow(20);
+    auto b = allocator.allocate(12);
+    ASSERT_TRUE(b);
+    EXPECT_EQ(*b, 8);
+    EXPECT_EQ(allocator.getUsed(), 20);
+    EXPECT_EQ(allocator.getCapacity(), 20);
+}
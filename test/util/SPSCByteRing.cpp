@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "util/SPSCByteRing.hpp"
+
+using namespace util;
+
+TEST(SPSCByteRing, WrapAround) {
+    SPSCByteRing ring(8);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.write("abcdef", 6), 6);
+    char dst[8] {};
+    EXPECT_EQ(ring.read(dst, 4), 4);
+    EXPECT_EQ(std::string(dst, 4), "abcd");
+
+    // wraps around the ring end
+    EXPECT_EQ(ring.write("ghijklmn", 8), 6);
+    EXPECT_TRUE(ring.full());
+    EXPECT_EQ(ring.writeSpan().size, 0);
+    EXPECT_EQ(ring.read(dst, 8), 8);
+    EXPECT_EQ(std::string(dst, 8), "efghijkl");
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SPSCByteRing, ProducerConsumer) {
+    SPSCByteRing ring(1024);
+    const int count = 20'000;
+    std::thread producer([&ring]() {
+        for (int i = 0; i < count;) {
+            auto span = ring.writeSpan();
+            size_t n = std::min(span.size, static_cast<size_t>(count - i));
+            for (size_t j = 0; j < n; j++) {
+                span.data[j] = static_cast<char>(i + j);
+            }
+            ring.commitWrite(n);
+            i += n;
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::vector<char> received;
+    char buffer[48];
+    while (received.size() < count) {
+        size_t n = ring.read(buffer, sizeof(buffer));
+        received.insert(received.end(), buffer, buffer + n);
+    }
+    producer.join();
+    for (int i = 0; i < count; i++) {
+        ASSERT_EQ(received[i], static_cast<char>(i));
+    }
+}
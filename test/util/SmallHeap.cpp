@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <map>
+
 #include "util/SmallHeap.hpp"
 
 using namespace util;
@@ -82,3 +84,37 @@ TEST(SmallHeap, Iterator) {
     }
     EXPECT_EQ(sum, 44);
 }
+
+TEST(SmallHeap, RandomOperations) {
+    SmallHeap<uint16_t, uint8_t> map;
+    std::map<int, int> sizes;
+    for (int i = 0; i < 10'000; i++) {
+        int index = rand() % 500;
+        if (rand() % 3 == 0) {
+            map.free(map.find(index));
+            sizes.erase(index);
+        } else {
+            int size = rand() % 254 + 1;
+            *map.allocate(index, size) = index % 256;
+            sizes[index] = size;
+        }
+    }
+    auto bytes = map.serialize();
+    SmallHeap<uint16_t, uint8_t> out;
+    out.deserialize(bytes.data(), bytes.size());
+
+    EXPECT_EQ(map.count(), sizes.size());
+    for (int index = 0; index < 500; index++) {
+        auto found = sizes.find(index);
+        for (auto heap : {&map, &out}) {
+            auto ptr = heap->find(index);
+            if (found == sizes.end()) {
+                EXPECT_EQ(ptr, nullptr);
+                continue;
+            }
+            ASSERT_NE(ptr, nullptr);
+            EXPECT_EQ(heap->sizeOf(ptr), found->second);
+            EXPECT_EQ(*ptr, index % 256);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <set>
+
+#include "util/SpatialGrid.hpp"
+
+static std::set<int> query(
+    const util::SpatialGrid<int>& grid, glm::vec3 min, glm::vec3 max, bool sized
+) {
+    std::set<int> found;
+    grid.query(min, max, sized, [&](int object) { found.insert(object); });
+    return found;
+}
+
+TEST(SpatialGrid, QueryAndMove) {
+    util::SpatialGrid<int> grid(16.0f);
+    grid.update(1, {1, 1, 1}, glm::vec3(0.5f));
+    grid.update(2, {40, 1, 1}, glm::vec3(0.5f));
+    grid.update(3, {-5, 1, -5}, glm::vec3(0.5f));
+    EXPECT_EQ(grid.size(), 3);
+
+    EXPECT_EQ(query(grid, {0, 0, 0}, {2, 2, 2}, false), std::set<int>({1}));
+    EXPECT_EQ(
+        query(grid, {-10, 0, -10}, {50, 2, 2}, false),
+        std::set<int>({1, 2, 3})
+    );
+
+    grid.update(1, {41, 1, 1}, glm::vec3(0.5f));
+    EXPECT_EQ(grid.size(), 3);
+    EXPECT_TRUE(query(grid, {0, 0, 0}, {2, 2, 2}, false).empty());
+    EXPECT_EQ(
+        query(grid, {39, 0, 0}, {42, 2, 2}, false), std::set<int>({1, 2})
+    );
+
+    grid.remove(2);
+    EXPECT_EQ(grid.size(), 2);
+    EXPECT_EQ(query(grid, {39, 0, 0}, {42, 2, 2}, false), std::set<int>({1}));
+}
+
+TEST(SpatialGrid, SizedObjectsCrossingCells) {
+    util::SpatialGrid<int> grid(16.0f);
+    // stored in the cell (0, 0, 0) but extends to the cell (-1, 0, 0)
+    grid.update(1, {1, 1, 1}, glm::vec3(4.0f));
+    EXPECT_TRUE(query(grid, {-8, 0, 0}, {-2, 2, 2}, false).empty());
+    EXPECT_EQ(query(grid, {-8, 0, 0}, {-2, 2, 2}, true), std::set<int>({1}));
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include "util/ThreadPool.hpp"
+
+using namespace util;
+
+class SquareWorker : public Worker<int, int> {
+public:
+    int operator()(const int& value) override {
+        return value * value;
+    }
+};
+
+TEST(TaskScheduler, SharedPools) {
+    TaskScheduler scheduler(4);
+    int sumA = 0;
+    int sumB = 0;
+    ThreadPool<int, int> poolA(
+        "pool-a",
+        []() { return std::make_shared<SquareWorker>(); },
+        [&sumA](int& result) { sumA += result; },
+        1,
+        scheduler
+    );
+    ThreadPool<int, int> poolB(
+        "pool-b",
+        []() { return std::make_shared<SquareWorker>(); },
+        [&sumB](int& result) { sumB += result; },
+        ThreadPool<int, int>::UNLIMITED,
+        scheduler
+    );
+    EXPECT_EQ(poolA.getWorkersCount(), 1);
+    EXPECT_EQ(poolB.getWorkersCount(), 4);
+    for (int i = 1; i <= 100; i++) {
+        poolA.enqueueJob(i);
+        poolB.enqueueJob(-i);
+    }
+    poolA.waitForJobs();
+    poolB.waitForJobs();
+    EXPECT_EQ(sumA, 338350);
+    EXPECT_EQ(sumB, 338350);
+}
+
+TEST(TaskScheduler, Cancel) {
+    TaskScheduler scheduler(1);
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool started = false;
+    bool released = false;
+    std::atomic<int> executed = 0;
+    // keep the only thread busy
+    scheduler.submit([&]() {
+        std::unique_lock lock(mutex);
+        started = true;
+        condition.notify_all();
+        condition.wait(lock, [&] { return released; });
+    }, TaskScheduler::Priority::NORMAL);
+    {
+        std::unique_lock lock(mutex);
+        condition.wait(lock, [&] { return started; });
+    }
+    int owner;
+    for (int i = 0; i < 10; i++) {
+        scheduler.submit(
+            [&]() { executed++; }, TaskScheduler::Priority::LOW, &owner
+        );
+    }
+    EXPECT_EQ(scheduler.cancel(&owner), 10);
+    {
+        std::lock_guard lock(mutex);
+        released = true;
+    }
+    condition.notify_all();
+    EXPECT_EQ(executed, 0);
+}
+
+TEST(TaskScheduler, ResultsOverflow) {
+    TaskScheduler scheduler(2);
+    int count = 0;
+    ThreadPool<int, int> pool(
+        "pool",
+        []() { return std::make_shared<SquareWorker>(); },
+        [&count](int&) { count++; },
+        ThreadPool<int, int>::UNLIMITED,
+        scheduler
+    );
+    int total = ThreadPool<int, int>::RESULTS_CAPACITY * 3;
+    for (int i = 0; i < total; i++) {
+        pool.enqueueJob(i);
+    }
+    pool.waitForJobs();
+    EXPECT_EQ(count, total);
+}
+
+class MoveOnlyWorker
+    : public Worker<std::unique_ptr<int>, std::unique_ptr<int>> {
+public:
+    std::unique_ptr<int> operator()(const std::unique_ptr<int>& job) override {
+        return std::make_unique<int>(*job * 2);
+    }
+};
+
+TEST(TaskScheduler, MoveOnlyJobs) {
+    using Pool = ThreadPool<std::unique_ptr<int>, std::unique_ptr<int>>;
+    TaskScheduler scheduler(2);
+    int sum = 0;
+    Pool pool(
+        "pool",
+        []() { return std::make_shared<MoveOnlyWorker>(); },
+        [&sum](std::unique_ptr<int>& result) { sum += *result; },
+        Pool::UNLIMITED,
+        scheduler
+    );
+    for (int i = 1; i <= 100; i++) {
+        pool.enqueueJob(std::make_unique<int>(i));
+    }
+    pool.waitForJobs();
+    EXPECT_EQ(sum, 10100);
+}
+
+class FailingWorker : public Worker<int, int> {
+public:
+    int operator()(const int& value) override {
+        if (value < 0) {
+            throw std::runtime_error("negative value");
+        }
+        return value;
+    }
+};
+
+TEST(TaskScheduler, ResetFailure) {
+    TaskScheduler scheduler(2);
+    int sum = 0;
+    ThreadPool<int, int> pool(
+        "pool",
+        []() { return std::make_shared<FailingWorker>(); },
+        [&sum](int& result) { sum += result; },
+        ThreadPool<int, int>::UNLIMITED,
+        scheduler
+    );
+    for (int i = 1; i <= 10; i++) {
+        pool.enqueueJob(i == 5 ? -1 : i);
+    }
+    EXPECT_THROW(pool.waitForJobs(), std::runtime_error);
+    pool.resetFailure();
+
+    sum = 0;
+    for (int i = 1; i <= 10; i++) {
+        pool.enqueueJob(i);
+    }
+    pool.waitForJobs();
+    EXPECT_EQ(sum, 55);
+}
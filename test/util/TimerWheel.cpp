@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "util/TimerWheel.hpp"
+
+TEST(TimerWheel, FiresAtScheduledTicks) {
+    util::TimerWheel<int> wheel(8);
+    wheel.schedule(3, 1);
+    wheel.schedule(20, 2);
+    wheel.schedule(3, 3);
+    EXPECT_EQ(wheel.size(), 3);
+
+    std::vector<std::pair<uint64_t, int>> fired;
+    auto collect = [&fired](uint64_t tick, int value) {
+        fired.emplace_back(tick, value);
+    };
+    for (uint64_t tick = 0; tick <= 25; tick++) {
+        size_t before = fired.size();
+        wheel.advance(tick, collect);
+        for (size_t i = before; i < fired.size(); i++) {
+            EXPECT_EQ(fired[i].first, tick);
+        }
+    }
+    ASSERT_EQ(fired.size(), 3);
+    EXPECT_EQ(fired[2].second, 2);
+    EXPECT_EQ(wheel.size(), 0);
+    EXPECT_EQ(wheel.getTick(), 26);
+}
+
+TEST(TimerWheel, CatchesUpSkippedTicks) {
+    util::TimerWheel<int> wheel(4);
+    for (int i = 0; i < 10; i++) {
+        wheel.schedule(i * 3, i);
+    }
+    int count = 0;
+    wheel.advance(14, [&count](uint64_t tick, int value) {
+        EXPECT_LE(tick, 14);
+        count++;
+    });
+    EXPECT_EQ(count, 5);
+    EXPECT_EQ(wheel.size(), 5);
+}
+
+TEST(TimerWheel, RescheduleFromHandler) {
+    util::TimerWheel<int> wheel(16);
+    wheel.schedule(0, 0);
+    int fired = 0;
+    for (uint64_t tick = 0; tick < 10; tick++) {
+        wheel.advance(tick, [&](uint64_t tick, int value) {
+            fired++;
+            // scheduled to the processed tick, so due at the next one
+            wheel.schedule(tick, value + 1);
+        });
+    }
+    EXPECT_EQ(fired, 10);
+    EXPECT_EQ(wheel.size(), 1);
+}
@@ -16,6 +16,20 @@ TEST(stringutil, utf8) {
     EXPECT_EQ(str, str2);
 }
 
+TEST(stringutil, utf8_mixed) {
+    // ASCII runs longer than a vector step around multibyte characters
+    std::string str = u8"player name is long enough: Игрок, テキスト and more";
+    auto wstr = util::str2wstr_utf8(str);
+    EXPECT_EQ(wstr.length(), util::length_utf8(str));
+    EXPECT_EQ(wstr[28], L'И');
+    EXPECT_EQ(util::wstr2str_utf8(wstr), str);
+
+    std::string truncated = str.substr(0, 29);
+    EXPECT_THROW(util::str2wstr_utf8(truncated), std::runtime_error);
+    std::string broken = u8"abc\xD0" "d";
+    EXPECT_THROW(util::str2wstr_utf8(broken), std::runtime_error);
+}
+
 TEST(stringutil, base64) {
     srand(2019);
     for (size_t size = 0; size < 30; size++) {
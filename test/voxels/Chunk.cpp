@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "voxels/Chunk.hpp"
 
 TEST(Chunk, EncodeDecode) {
@@ -23,3 +27,156 @@ TEST(Chunk, EncodeDecode) {
         );
     }
 }
+
+TEST(Chunk, UniformSections) {
+    Chunk chunk(0, 0);
+    for (uint i = 0; i < CHUNK_SECTION_VOL * 2; i++) {
+        chunk.voxels[i].id = 1;
+    }
+    chunk.voxels[CHUNK_SECTION_VOL * 2 + 5].id = 2;
+    chunk.updateHeights();
+
+    EXPECT_TRUE(chunk.isUniformSection(0));
+    EXPECT_TRUE(chunk.isUniformSection(1));
+    EXPECT_FALSE(chunk.isUniformSection(2));
+    EXPECT_TRUE(chunk.isUniformSection(CHUNK_SECTIONS - 1));
+
+    chunk.resetUniformSection(CHUNK_SECTION_H);
+    EXPECT_TRUE(chunk.isUniformSection(0));
+    EXPECT_FALSE(chunk.isUniformSection(1));
+}
+
+TEST(Chunk, DirtySections) {
+    Chunk chunk(0, 0);
+    chunk.setModified(CHUNK_SECTION_H + 5);
+    EXPECT_TRUE(chunk.flags.modified);
+    EXPECT_EQ(chunk.dirtySections, 1U << 1);
+
+    chunk.dirtySections = 0;
+    chunk.setModified(CHUNK_SECTION_H);
+    EXPECT_EQ(chunk.dirtySections, 0b11U);
+
+    chunk.dirtySections = 0;
+    chunk.setModified(CHUNK_SECTION_H - 1);
+    EXPECT_EQ(chunk.dirtySections, 0b11U);
+
+    chunk.dirtySections = 0;
+    chunk.setModified(0);
+    chunk.setModified(CHUNK_H - 1);
+    EXPECT_EQ(chunk.dirtySections, 1U | (1U << (CHUNK_SECTIONS - 1)));
+
+    chunk.setModified();
+    EXPECT_EQ(chunk.dirtySections, Chunk::ALL_SECTIONS);
+}
+
+TEST(Chunk, Reset) {
+    Chunk chunk(3, 4);
+    chunk.voxels[10].id = 5;
+    chunk.lightmap.getLightsWriteable()[10] = 0xF;
+    chunk.flags.loaded = true;
+    chunk.setModified();
+    chunk.setLightsModified();
+    chunk.randomTickablesCount = 3;
+    chunk.randomTickablesSparse = true;
+    chunk.voxels.compact();
+
+    chunk.reset(-1, 2);
+    EXPECT_EQ(chunk.x, -1);
+    EXPECT_EQ(chunk.z, 2);
+    EXPECT_FALSE(chunk.flags.loaded);
+    EXPECT_FALSE(chunk.flags.modified);
+    EXPECT_EQ(chunk.dirtySections, 0);
+    EXPECT_EQ(chunk.lightSections, 0);
+    EXPECT_EQ(chunk.randomTickablesCount, 0);
+    EXPECT_FALSE(chunk.randomTickablesSparse);
+    EXPECT_FALSE(chunk.voxels.isCompact());
+    EXPECT_EQ(chunk.voxels[10].id, 0);
+    EXPECT_EQ(chunk.lightmap.get(10), 0);
+}
+
+TEST(Chunk, EmptyBricks) {
+    Chunk chunk(0, 0);
+    EXPECT_FALSE(chunk.isEmptyBrick(0, 0, 0));
+
+    chunk.voxels[vox_index(5, CHUNK_SECTION_H + 2, 9)].id = 1;
+    chunk.updateHeights();
+
+    EXPECT_TRUE(chunk.isEmptySection(0));
+    EXPECT_FALSE(chunk.isEmptySection(1));
+    EXPECT_FALSE(chunk.isEmptyBrick(4, CHUNK_SECTION_H, 8));
+    EXPECT_FALSE(chunk.isEmptyBrick(7, CHUNK_SECTION_H + 3, 11));
+    EXPECT_TRUE(chunk.isEmptyBrick(8, CHUNK_SECTION_H, 8));
+    EXPECT_TRUE(chunk.isEmptyBrick(4, CHUNK_SECTION_H + 4, 8));
+
+    chunk.resetEmptyBrick(0, 0, 0);
+    EXPECT_FALSE(chunk.isEmptySection(0));
+    EXPECT_FALSE(chunk.isEmptyBrick(3, 3, 3));
+    EXPECT_TRUE(chunk.isEmptyBrick(4, 0, 0));
+}
+
+TEST(Chunk, EncodeLayout) {
+    Chunk chunk(0, 0);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        chunk.voxels[i].id = i;
+        chunk.voxels[i].state = int2blockstate(0xFFFF - i);
+    }
+    std::vector<ubyte> bytes(CHUNK_DATA_LEN);
+    chunk.encode(bytes.data());
+    auto pooled = chunk.encodeTemporary();
+    EXPECT_EQ(std::memcmp(bytes.data(), pooled.get(), CHUNK_DATA_LEN), 0);
+
+    // little-endian ids array, then states array
+    for (uint i : {0U, 1U, 7U, 8U, 300U, CHUNK_VOL - 1U}) {
+        uint16_t id = bytes[i * 2] | bytes[i * 2 + 1] << 8;
+        size_t offset = (CHUNK_VOL + i) * 2;
+        uint16_t state = bytes[offset] | bytes[offset + 1] << 8;
+        EXPECT_EQ(id, static_cast<uint16_t>(i));
+        EXPECT_EQ(state, static_cast<uint16_t>(0xFFFF - i));
+    }
+}
+
+TEST(Chunk, IncrementalHeights) {
+    Chunk chunk(0, 0);
+    chunk.updateHeights();
+    EXPECT_TRUE(chunk.isEmpty());
+
+    auto set = [&chunk](uint x, uint y, uint z, blockid_t id) {
+        auto& vox = chunk.voxels[vox_index(x, y, z)];
+        blockid_t prevId = vox.id;
+        vox.id = id;
+        chunk.onVoxelIdChanged(y, prevId, id);
+    };
+    set(3, 40, 5, 1);
+    EXPECT_FALSE(chunk.isEmpty());
+    EXPECT_EQ(chunk.bottom, 40);
+    EXPECT_EQ(chunk.top, 41);
+
+    set(0, 100, 0, 2);
+    set(1, 100, 0, 2);
+    set(2, 7, 9, 1);
+    EXPECT_EQ(chunk.bottom, 7);
+    EXPECT_EQ(chunk.top, 101);
+
+    set(0, 100, 0, BLOCK_AIR);
+    EXPECT_EQ(chunk.top, 101);
+    set(1, 100, 0, BLOCK_AIR);
+    EXPECT_EQ(chunk.top, 41);
+    set(2, 7, 9, BLOCK_AIR);
+    EXPECT_EQ(chunk.bottom, 40);
+
+    int bottom = chunk.bottom;
+    int top = chunk.top;
+    uint16_t counts[CHUNK_SECTIONS];
+    std::copy(
+        std::begin(chunk.sectionBlocks), std::end(chunk.sectionBlocks), counts
+    );
+    chunk.updateHeights();
+    EXPECT_EQ(chunk.bottom, bottom);
+    EXPECT_EQ(chunk.top, top);
+    for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        EXPECT_EQ(chunk.sectionBlocks[s], counts[s]);
+    }
+
+    set(3, 40, 5, BLOCK_AIR);
+    EXPECT_TRUE(chunk.isEmpty());
+}
@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "voxels/ChunkSummary.hpp"
+
+TEST(ChunkSummary, BuildEncodeDecode) {
+    std::vector<voxel> voxels(CHUNK_VOL, voxel {BLOCK_AIR, {}});
+    voxels[vox_index(0, 10, 0)] = {7, {}};
+    voxels[vox_index(1, 3, 2)] = {5, {}};
+    voxels[vox_index(CHUNK_W - 1, 0, CHUNK_D - 1)] = {9, {}};
+
+    auto summary = ChunkSummary::build(voxels.data());
+    EXPECT_EQ(summary.at(0, 0).id, 7);
+    EXPECT_EQ(summary.at(0, 0).height, 11);
+    EXPECT_EQ(summary.at(1, 0).height, 0);
+    const auto& last = summary.at(
+        ChunkSummary::CELLS_W - 1, ChunkSummary::CELLS_D - 1
+    );
+    EXPECT_EQ(last.id, 9);
+    EXPECT_EQ(last.height, 1);
+
+    auto bytes = summary.encode();
+    ChunkSummary decoded;
+    decoded.decode(bytes.get());
+    for (int i = 0; i < ChunkSummary::CELLS_COUNT; i++) {
+        EXPECT_EQ(decoded.cells[i].id, summary.cells[i].id);
+        EXPECT_EQ(decoded.cells[i].height, summary.cells[i].height);
+    }
+}
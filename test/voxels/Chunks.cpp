@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include "content/Content.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "voxels/VoxelsVolume.hpp"
+
+TEST(Chunks, GetVoxels) {
+    ContentIndices indices(
+        std::vector<Block*> {},
+        std::vector<ItemDef*> {},
+        std::vector<EntityDef*> {}
+    );
+    Chunk chunk(0, 0);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        chunk.voxels[i].id = i % 7;
+        chunk.lightmap.getLightsWriteable()[i] = i % 13;
+    }
+    chunk.updateHeights();
+
+    // volume crosses the chunk border and the world bottom
+    VoxelsVolume volume(-2, -1, 3, CHUNK_W, 4, 5);
+    Chunks::getVoxels(
+        &volume, false, indices, [&chunk](int32_t x, int32_t z) {
+            return x == 0 && z == 0 ? &chunk : nullptr;
+        }
+    );
+    for (int y = -1; y < 3; y++) {
+        for (int z = 3; z < 8; z++) {
+            for (int x = -2; x < CHUNK_W - 2; x++) {
+                if (x < 0 || y < 0) {
+                    EXPECT_EQ(volume.pickBlockId(x, y, z), BLOCK_VOID);
+                    continue;
+                }
+                uint index = vox_index(x, y, z);
+                EXPECT_EQ(volume.pickBlockId(x, y, z), index % 7);
+                EXPECT_EQ(volume.pickLight(x, y, z), index % 13);
+            }
+        }
+    }
+}
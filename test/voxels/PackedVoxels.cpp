@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "voxels/ChunkVoxels.hpp"
+#include "voxels/PackedVoxels.hpp"
+
+static bool voxels_equal(const voxel& a, const voxel& b) {
+    return a.id == b.id && blockstate2int(a.state) == blockstate2int(b.state);
+}
+
+TEST(PackedVoxels, PackUnpack) {
+    auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        uint y = i / (CHUNK_W * CHUNK_D);
+        if (y < 64) {
+            // random section
+            voxels[i].id = rand();
+            voxels[i].state = int2blockstate(rand());
+        } else if (y < 128) {
+            voxels[i].id = rand() % 5;
+        }
+    }
+    PackedVoxels packed(voxels.get());
+    EXPECT_FALSE(packed.isUniform(0));
+    EXPECT_TRUE(packed.isUniform(CHUNK_SECTIONS - 1));
+
+    auto unpacked = std::make_unique<voxel[]>(CHUNK_VOL);
+    packed.unpack(unpacked.get());
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        EXPECT_TRUE(voxels_equal(voxels[i], unpacked[i]));
+        EXPECT_TRUE(voxels_equal(voxels[i], packed.get(i)));
+    }
+}
+
+TEST(ChunkVoxels, Compact) {
+    ChunkVoxels voxels;
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        voxels[i].id = i / CHUNK_SECTION_VOL % 3;
+    }
+    size_t expandedSize = voxels.getMemoryUsage();
+    EXPECT_TRUE(voxels.compact());
+    EXPECT_TRUE(voxels.isCompact());
+    EXPECT_LT(voxels.getMemoryUsage() * 10, expandedSize);
+
+    auto copy = voxels.read();
+    EXPECT_TRUE(voxels.isCompact());
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        EXPECT_EQ(copy[i].id, i / CHUNK_SECTION_VOL % 3);
+        EXPECT_EQ(voxels.get(i).id, copy[i].id);
+    }
+    voxels[0].id = 7;
+    EXPECT_FALSE(voxels.isCompact());
+    EXPECT_EQ(voxels[1].id, 0);
+    EXPECT_EQ(voxels[CHUNK_SECTION_VOL].id, 1);
+}
@@ -31,6 +31,27 @@ TEST(SurroundMap, InitTest) {
     EXPECT_EQ(affected, maxLevel * 2 - 1);
 }
 
+TEST(SurroundMap, BatchCallback) {
+    int8_t maxLevel = 4;
+    SurroundMap map(10, maxLevel);
+    std::vector<size_t> batches;
+    map.setLevelBatchCallback(2, [&](const std::vector<glm::ivec2>& batch) {
+        for (const auto& pos : batch) {
+            // points of lower level are already upgraded
+            EXPECT_GE(map.at(pos.x, pos.y), 2);
+        }
+        batches.push_back(batch.size());
+    });
+    map.setCenter(0, 0);
+    map.completeAt(0, 0);
+    map.completeAt(1, 0);
+    map.completeAt(1, 0);
+
+    ASSERT_EQ(batches.size(), 2);
+    EXPECT_EQ(batches[0], (maxLevel * 2 - 3) * (maxLevel * 2 - 3));
+    EXPECT_EQ(batches[1], maxLevel * 2 - 3);
+}
+
 #define VISUAL_TEST
 #ifdef VISUAL_TEST
 